@@ -5,6 +5,7 @@ function(drishti_symbol_list drishti_library)
     drishti_eye_segmenter_create_from_stream
     drishti_eye_segmenter_destroy
     drishti_eye_segmenter_segment
+    drishti_eye_segmenter_segment_batch
     )
 
   if(DRISHTI_BUILD_HCI)
@@ -13,6 +14,9 @@ function(drishti_symbol_list drishti_library)
       drishti_face_tracker_destroy
       drishti_face_tracker_track
       drishti_face_tracker_callback
+      drishti_face_tracker_start
+      drishti_face_tracker_submit
+      drishti_face_tracker_release
       )
   endif()
 
@@ -45,13 +45,27 @@ public:
 
     using streambuf_handler = std::function<int(beast::streambuf&)>;
 
+    /** Asynchronous replies.
+
+        The handler is done with the streambuf when it calls reply (from any thread),
+        the text reply is written and the next message of the connection is read.
+    */
+    using reply_handler = std::function<void(std::string const&)>;
+    using message_handler = std::function<void(beast::streambuf&, reply_handler)>;
+
     void add(streambuf_handler handler)
     {
         handler_ = handler;
     }
 
+    void add(message_handler handler)
+    {
+        message_handler_ = handler;
+    }
+
 private:
     streambuf_handler handler_;
+    message_handler message_handler_;
 
     struct identity
     {
@@ -242,6 +256,7 @@ private:
             boost::asio::io_service::strand strand;
             beast::websocket::opcode op;
             beast::streambuf db;
+            std::string reply; // pending text reply
             std::size_t id;
 
             data(async_server& server_, endpoint_type const& ep_, socket_type&& sock_)
@@ -320,6 +335,18 @@ private:
                         return fail("async_read", ec);
                     }
 
+                    if ((d.op == beast::websocket::opcode::binary) && d.server.message_handler_)
+                    {
+                        // wait for the reply
+                        d.state = 3;
+                        peer self{ *this };
+                        d.server.message_handler_(d.db, [self](std::string const& text) {
+                            auto& d = *self.d_;
+                            d.strand.post([self, text]() mutable { self.write(text); });
+                        });
+                        return;
+                    }
+
                     if (d.op == beast::websocket::opcode::binary)
                     {
                         if (d.server.handler_)
@@ -337,6 +364,15 @@ private:
         }
 
     private:
+        void write(std::string const& text)
+        {
+            auto& d = *d_;
+            d.reply = text;
+            d.state = 1;
+            d.ws.set_option(beast::websocket::message_type(beast::websocket::opcode::text));
+            d.ws.async_write(boost::asio::buffer(d.reply), d.strand.wrap(std::move(*this)));
+        }
+
         void fail(std::string what, error_code ec)
         {
             auto& d = *d_;
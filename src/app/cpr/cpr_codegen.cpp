@@ -0,0 +1,507 @@
+/*! -*-c++-*-
+  @file   cpr_codegen.cpp
+  @author David Hirvonen
+  @brief  Generate C++ source for fixed (serialized) CPR models.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Each XGBoost regressor is converted to a function with an unrolled walk of
+  every tree (split thresholds become immediate values) and the feature data
+  is written as constexpr tables.  The output is compiled into the SDK with
+  DRISHTI_BUILD_CPR_COMPILED=ON and DRISHTI_CPR_COMPILED_SOURCE=<output>, and
+  models are then created with drishti::rcpr::createCompiledCPR(name).
+
+*/
+
+#include "drishti/core/drishti_stdlib_string.h" // android workaround
+#include "drishti/core/Logger.h"
+#include "drishti/core/drishti_cv_cereal.h"
+#include "drishti/core/drishti_cereal_pba.h"
+#include "drishti/core/ThrowAssert.h"
+#include "drishti/rcpr/CPR.h"
+#include "drishti/rcpr/CPRIO.h"
+#include "drishti/ml/TreeEnsemble.h"
+#include "drishti/testlib/drishti_cli.h"
+
+#include "cxxopts.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+using drishti::rcpr::CPR;
+using drishti::ml::TreeEnsemble;
+
+static std::string literal(float value);
+static bool isIdentifier(const std::string& name);
+static void generate(std::ostream& os, const std::string& name, const std::string& source, const CPR& cpr);
+
+int gauze_main(int argc, char** argv)
+{
+    const auto argumentCount = argc;
+
+    auto logger = drishti::core::Logger::create("drishti-cpr-codegen");
+
+    std::vector<std::string> sInputs, sNames;
+    std::string sOutput;
+
+    cxxopts::Options options("drishti-cpr-codegen", "Generate C++ source for serialized CPR models");
+
+    // clang-format off
+    options.add_options()
+        ("i,input", "Input CPR model (.cpb), repeat for multiple models", cxxopts::value<std::vector<std::string>>(sInputs))
+        ("n,name", "Model name (C++ identifier) for each input", cxxopts::value<std::vector<std::string>>(sNames))
+        ("o,output", "Output source file (.cpp)", cxxopts::value<std::string>(sOutput))
+        ("h,help", "Print help message");
+    // clang-format on
+
+    options.parse(argc, argv);
+
+    if ((argumentCount <= 1) || options.count("help"))
+    {
+        std::cout << options.help({ "" }) << std::endl;
+        return 0;
+    }
+
+    if (sInputs.empty())
+    {
+        logger->error("Must specify at least one input model");
+        return 1;
+    }
+
+    if (sNames.size() != sInputs.size())
+    {
+        logger->error("Must specify one name for each input model");
+        return 1;
+    }
+
+    for (int i = 0; i < sNames.size(); i++)
+    {
+        if (!isIdentifier(sNames[i]) || (std::find(sNames.begin(), sNames.begin() + i, sNames[i]) != sNames.begin() + i))
+        {
+            logger->error("Model name {} must be a unique C++ identifier", sNames[i]);
+            return 1;
+        }
+    }
+
+    if (sOutput.empty())
+    {
+        logger->error("Must specify output source file");
+        return 1;
+    }
+
+    std::stringstream ss;
+    ss << "// Generated by drishti_cpr_codegen, do not edit.\n\n";
+    ss << "#include \"drishti/rcpr/CPRCompiled.h\"\n";
+    ss << "#include \"drishti/ml/TreeEnsemble.h\"\n";
+    ss << "#include \"drishti/core/make_unique.h\"\n\n";
+    ss << "#include <cmath>\n";
+    ss << "#include <iterator>\n\n";
+    ss << "DRISHTI_RCPR_NAMESPACE_BEGIN\n\n";
+    ss << "static PointVec toPoints(const float* xy, std::size_t size)\n";
+    ss << "{\n";
+    ss << "    PointVec points(size / 2);\n";
+    ss << "    for (std::size_t i = 0; i < points.size(); i++)\n";
+    ss << "    {\n";
+    ss << "        points[i] = { xy[i * 2 + 0], xy[i * 2 + 1] };\n";
+    ss << "    }\n";
+    ss << "    return points;\n";
+    ss << "}\n\n";
+
+    for (int i = 0; i < sInputs.size(); i++)
+    {
+        if (!drishti::cli::file::exists(sInputs[i]))
+        {
+            logger->error("Specified file {} does not exist or is not readable", sInputs[i]);
+            return 1;
+        }
+
+        CPR cpr;
+        load_cpb(sInputs[i], cpr);
+        generate(ss, sNames[i], sInputs[i], cpr);
+        logger->info("Generated {} from {}", sNames[i], sInputs[i]);
+    }
+
+    ss << "std::vector<std::string> getCompiledCPRNames()\n";
+    ss << "{\n";
+    ss << "    return {";
+    for (int i = 0; i < sNames.size(); i++)
+    {
+        ss << (i ? ", " : " ") << "\"" << sNames[i] << "\"";
+    }
+    ss << " };\n";
+    ss << "}\n\n";
+
+    ss << "std::unique_ptr<CPR> createCompiledCPR(const std::string& name)\n";
+    ss << "{\n";
+    for (const auto& name : sNames)
+    {
+        ss << "    if (name == \"" << name << "\")\n";
+        ss << "    {\n";
+        ss << "        return " << name << "_create();\n";
+        ss << "    }\n";
+    }
+    ss << "    return nullptr;\n";
+    ss << "}\n\n";
+    ss << "DRISHTI_RCPR_NAMESPACE_END\n";
+
+    std::ofstream ofs(sOutput);
+    if (!ofs)
+    {
+        logger->error("Unable to open {} for writing", sOutput);
+        return 1;
+    }
+    ofs << ss.str();
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception";
+    }
+
+    return 0;
+}
+
+// utility:
+
+// Round trip float literal (e.g., "0.5f", "1.0f", "-2.50000003e-05f"):
+static std::string literal(float value)
+{
+    drishti_throw_assert(std::isfinite(value), "drishti_cpr_codegen: non finite model parameter");
+
+    std::stringstream ss;
+    ss << std::setprecision(std::numeric_limits<float>::max_digits10) << value;
+
+    std::string text = ss.str();
+    if (text.find_first_of(".e") == std::string::npos)
+    {
+        text += ".0";
+    }
+    return text + "f";
+}
+
+static bool isIdentifier(const std::string& name)
+{
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name.front())))
+    {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || (c == '_'); });
+}
+
+static std::string vector1d(const drishti::rcpr::Vector1d& values)
+{
+    std::stringstream ss;
+    ss << "Vector1d{";
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        ss << (i ? ", " : " ") << literal(values[i]);
+    }
+    ss << (values.empty() ? "}" : " }");
+    return ss.str();
+}
+
+// Emit a constexpr table and return its name:
+static std::string table(std::ostream& os, const std::string& name, const std::vector<float>& values)
+{
+    if (values.empty())
+    {
+        return "{}";
+    }
+
+    os << "static constexpr float " << name << "[] = {";
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        os << ((i % 8) ? " " : "\n    ") << literal(values[i]) << ",";
+    }
+    os << "\n};\n\n";
+    return name;
+}
+
+// Nodes are emitted as nested conditionals, the comparison is chosen so that
+// missing (NaN) features follow the same branch as in TreeEnsemble:
+static void tree(std::ostream& os, const std::vector<TreeEnsemble::Node>& nodes, int index)
+{
+    const auto& node = nodes[index];
+    if (node.isLeaf())
+    {
+        os << literal(node.value);
+        return;
+    }
+
+    const std::string f = "f[" + std::to_string(node.feature) + "]";
+    if (node.missing == node.yes)
+    {
+        os << "(!(" << f << " >= " << literal(node.value) << ") ? ";
+    }
+    else
+    {
+        os << "((" << f << " < " << literal(node.value) << ") ? ";
+    }
+    tree(os, nodes, node.yes);
+    os << " : ";
+    tree(os, nodes, node.no);
+    os << ")";
+}
+
+static void function(std::ostream& os, const std::string& name, const TreeEnsemble& forest)
+{
+    drishti_throw_assert(!forest.empty() && forest.size(), "drishti_cpr_codegen: regressors must be gbtree models");
+
+    // Trees are summed in order before the bias is added to match TreeEnsemble results exactly:
+    os << "static float " << name << "(const float* f)\n";
+    os << "{\n";
+    os << "    float sum = 0.f;\n";
+    for (const auto& root : forest.getRoots())
+    {
+        os << "    sum += ";
+        tree(os, forest.getNodes(), root);
+        os << ";\n";
+    }
+    os << "    sum += " << literal(forest.getBias()) << ";\n";
+    switch (forest.getTransform())
+    {
+        case TreeEnsemble::kIdentity:
+            os << "    return sum;\n";
+            break;
+        case TreeEnsemble::kLogistic:
+            os << "    return 1.f / (1.f + std::exp(-sum));\n";
+            break;
+    }
+    os << "}\n\n";
+}
+
+static void model(std::ostream& os, const std::string& indent, const std::string& var, const CPR::Model& model)
+{
+    if (!model.parts.has)
+    {
+        return;
+    }
+
+    const auto& parts = *model.parts;
+    os << indent << "{\n";
+    os << indent << "    CPR::Model::Parts parts;\n";
+    if (parts.prn.has)
+    {
+        os << indent << "    parts.prn = " << literal(*parts.prn) << ";\n";
+    }
+    if (parts.lks.has)
+    {
+        os << indent << "    parts.lks = " << vector1d(*parts.lks) << ";\n";
+    }
+    if (parts.joint.has)
+    {
+        os << indent << "    parts.joint = " << literal(*parts.joint) << ";\n";
+    }
+    if (parts.mus.has)
+    {
+        os << indent << "    parts.mus = " << vector1d(*parts.mus) << ";\n";
+    }
+    if (parts.sigs.has)
+    {
+        os << indent << "    parts.sigs = " << vector1d(*parts.sigs) << ";\n";
+    }
+    if (parts.wts.has)
+    {
+        os << indent << "    parts.wts = " << vector1d(*parts.wts) << ";\n";
+    }
+    os << indent << "    CPR::Model model;\n";
+    os << indent << "    model.parts = parts;\n";
+    os << indent << "    " << var << " = model;\n";
+    os << indent << "}\n";
+}
+
+static void cprPrm(std::ostream& os, const CPR::CprPrm& prm)
+{
+    os << "    {\n";
+    os << "        CPR::CprPrm cprPrm;\n";
+    if (prm.model.has)
+    {
+        model(os, "        ", "cprPrm.model", *prm.model);
+    }
+    if (prm.T.has)
+    {
+        os << "        cprPrm.T = " << literal(*prm.T) << ";\n";
+    }
+    if (prm.L.has)
+    {
+        os << "        cprPrm.L = " << literal(*prm.L) << ";\n";
+    }
+    if (prm.ftrPrm.has)
+    {
+        const auto& ftrPrm = *prm.ftrPrm;
+        os << "        {\n";
+        os << "            CPR::CprPrm::FtrPrm ftrPrm;\n";
+        if (ftrPrm.type.has)
+        {
+            os << "            ftrPrm.type = " << literal(*ftrPrm.type) << ";\n";
+        }
+        if (ftrPrm.F.has)
+        {
+            os << "            ftrPrm.F = " << literal(*ftrPrm.F) << ";\n";
+        }
+        if (ftrPrm.radius.has)
+        {
+            os << "            ftrPrm.radius = " << literal(*ftrPrm.radius) << ";\n";
+        }
+        if (ftrPrm.nChn.has)
+        {
+            os << "            ftrPrm.nChn = " << *ftrPrm.nChn << ";\n";
+        }
+        os << "            cprPrm.ftrPrm = ftrPrm;\n";
+        os << "        }\n";
+    }
+    if (prm.verbose.has)
+    {
+        os << "        cprPrm.verbose = " << literal(*prm.verbose) << ";\n";
+    }
+    os << "        cprPrm.cascadeRecipes.resize(" << prm.cascadeRecipes.size() << ");\n";
+    for (std::size_t i = 0; i < prm.cascadeRecipes.size(); i++)
+    {
+        const auto& r = prm.cascadeRecipes[i];
+        os << "        {\n";
+        os << "            auto& recipe = cprPrm.cascadeRecipes[" << i << "];\n";
+        os << "            recipe.maxLeafNodes = " << r.maxLeafNodes << ";\n";
+        os << "            recipe.maxDepth = " << r.maxDepth << ";\n";
+        os << "            recipe.treesPerLevel = " << r.treesPerLevel << ";\n";
+        os << "            recipe.featurePoolSize = " << r.featurePoolSize << ";\n";
+        os << "            recipe.featureSampleSize = " << r.featureSampleSize << ";\n";
+        os << "            recipe.learningRate = " << std::setprecision(17) << r.learningRate << ";\n";
+        os << "            recipe.dataSampleRatio = " << std::setprecision(17) << r.dataSampleRatio << ";\n";
+        os << "            recipe.doMask = " << (r.doMask ? "true" : "false") << ";\n";
+        os << "            recipe.featureRadius = " << std::setprecision(17) << r.featureRadius << ";\n";
+        os << "            recipe.lambda = " << std::setprecision(17) << r.lambda << ";\n";
+        os << "            recipe.useNPD = " << (r.useNPD ? "true" : "false") << ";\n";
+        os << "            recipe.paramIndex = {";
+        for (std::size_t j = 0; j < r.paramIndex.size(); j++)
+        {
+            os << (j ? ", " : " ") << r.paramIndex[j];
+        }
+        os << (r.paramIndex.empty() ? "};\n" : " };\n");
+        os << "        }\n";
+    }
+    os << "        cpr->cprPrm = cprPrm;\n";
+    os << "    }\n";
+}
+
+static void generate(std::ostream& os, const std::string& name, const std::string& source, const CPR& cpr)
+{
+    drishti_throw_assert(cpr.regModel.has && cpr.regModel->regs.has, "drishti_cpr_codegen: missing regression model");
+
+    const auto& regModel = *cpr.regModel;
+    const auto& regs = *regModel.regs;
+
+    os << "// ### " << name << " (" << source << ") ###\n\n";
+
+    // Stage tables and regressors:
+    std::vector<std::string> xs(regs.size()), pids(regs.size());
+    for (std::size_t t = 0; t < regs.size(); t++)
+    {
+        const auto& reg = *regs[t];
+        const std::string prefix = name + "_" + std::to_string(t);
+
+        std::vector<float> xy;
+        for (const auto& p : *reg.ftrData->xs)
+        {
+            xy.push_back(p.x);
+            xy.push_back(p.y);
+        }
+        xs[t] = table(os, prefix + "_xs", xy);
+        pids[t] = table(os, prefix + "_pids", *reg.ftrData->pids);
+
+        for (const auto& booster : reg.xgbdt)
+        {
+            function(os, prefix + "_" + std::to_string(booster.first), booster.second->getTreeEnsemble());
+        }
+    }
+
+    os << "static std::unique_ptr<CPR> " << name << "_create()\n";
+    os << "{\n";
+    os << "    auto cpr = drishti::core::make_unique<CPR>();\n";
+
+    if (cpr.cprPrm.has)
+    {
+        cprPrm(os, *cpr.cprPrm);
+    }
+
+    // The training only distribution pDstr is not needed at runtime:
+    os << "    {\n";
+    os << "        CPR::RegModel regModel;\n";
+    if (regModel.model.has)
+    {
+        model(os, "        ", "regModel.model", *regModel.model);
+    }
+    if (regModel.pStar.has)
+    {
+        os << "        regModel.pStar = " << vector1d(*regModel.pStar) << ";\n";
+    }
+    if (regModel.T.has)
+    {
+        os << "        regModel.T = " << literal(*regModel.T) << ";\n";
+    }
+    if (regModel.pStar_.has)
+    {
+        os << "        regModel.pStar_ = " << vector1d(*regModel.pStar_) << ";\n";
+    }
+    os << "        std::vector<core::Field<CPR::RegModel::Regs>> regs(" << regs.size() << ");\n";
+    for (std::size_t t = 0; t < regs.size(); t++)
+    {
+        const auto& reg = *regs[t];
+        const auto& ftrData = *reg.ftrData;
+        const std::string prefix = name + "_" + std::to_string(t);
+
+        os << "        {\n";
+        os << "            CPR::RegModel::Regs::FtrData ftrData;\n";
+        if (ftrData.type.has)
+        {
+            os << "            ftrData.type = " << literal(*ftrData.type) << ";\n";
+        }
+        if (ftrData.F.has)
+        {
+            os << "            ftrData.F = " << literal(*ftrData.F) << ";\n";
+        }
+        if (ftrData.nChn.has)
+        {
+            os << "            ftrData.nChn = " << literal(*ftrData.nChn) << ";\n";
+        }
+        os << "            ftrData.xs = " << (ftrData.xs->empty() ? "PointVec()" : "toPoints(" + xs[t] + ", std::end(" + xs[t] + ") - std::begin(" + xs[t] + "))") << ";\n";
+        os << "            ftrData.pids = " << (ftrData.pids->empty() ? "Vector1d()" : "Vector1d(std::begin(" + pids[t] + "), std::end(" + pids[t] + "))") << ";\n";
+        os << "            CPR::RegModel::Regs reg;\n";
+        os << "            reg.ftrData = ftrData;\n";
+        if (reg.r.has)
+        {
+            os << "            reg.r = " << literal(*reg.r) << ";\n";
+        }
+        for (const auto& booster : reg.xgbdt)
+        {
+            const auto& forest = booster.second->getTreeEnsemble();
+            os << "            reg.xgbdt.emplace_back(" << booster.first << ", std::make_shared<ml::XGBooster>(ml::TreeEnsemble(&"
+               << prefix << "_" << booster.first << ", " << forest.getFeatureDim() << ")));\n";
+        }
+        os << "            regs[" << t << "] = reg;\n";
+        os << "        }\n";
+    }
+    os << "        regModel.regs = regs;\n";
+    os << "        cpr->regModel = regModel;\n";
+    os << "    }\n";
+    os << "    return cpr;\n";
+    os << "}\n\n";
+}
@@ -31,7 +31,10 @@
 #include "drishti/core/drishti_cv_cereal.h"
 #include "drishti/core/drishti_cereal_pba.h"
 #include "drishti/core/drishti_serialize.h"
+#include "drishti/core/FlatArchive.h"
 #include "drishti/core/Parallel.h"
+#include "drishti/core/ResultsCache.h"
+#include "drishti/core/TrainingReport.h"
 #include "drishti/geometry/Ellipse.h"
 #include "drishti/geometry/Primitives.h"
 #include "drishti/testlib/drishti_cli.h"
@@ -77,15 +80,28 @@ struct PoseData
 using drishti::geometry::operator*;
 using StringVec = std::vector<std::string>;
 
+/*
+ * Decoded samples (normalization, ellipses and the resized red channel crops and masks) can
+ * be cached in a core::FlatArchive, which is memory mapped on the next run with the same
+ * files (path, size and modification time) and settings, so the crops are used in place.
+ */
+
 struct EllipseSamples
 {
+    static const std::uint32_t kCacheVersion = 1;
+
     EllipseSamples(std::shared_ptr<spdlog::logger>& logger);
-    void load(const std::string& filename, int width, const std::string& sExt, bool doIris);
+    void load(const std::string& filename, int width, const std::string& sExt, bool doIris, const std::string& sCache = {});
+
+    bool loadCache(const std::string& filename, std::uint64_t key, std::size_t count);
+    void saveCache(const std::string& filename, std::uint64_t key) const;
 
     std::shared_ptr<spdlog::logger> logger;
     PoseData samples;
     drishti::rcpr::Vector1d mu;
     drishti::rcpr::Vector1d sigma;
+
+    std::shared_ptr<drishti::core::FlatArchive> cache; // backs the images of a cached load
 };
 
 #if defined(DRISHTI_USE_IMSHOW) && TRAIN_CPR_DEBUG_LOAD
@@ -122,6 +138,11 @@ int gauze_main(int argc, char** argv)
     std::string sTemplate;
     std::string sTestLog;
     std::string sLoggingDir;
+    std::string sCheckpoint;
+    std::string sResume;
+    std::string sReport;
+    std::string sTrainCache;
+    std::string sTestCache;
 
     bool doWindow = false;
 
@@ -129,6 +150,7 @@ int gauze_main(int argc, char** argv)
     int T = 0; // # of stages
     int L = 4; // oversampling
     int F = 200;
+    int memoryLimit = 0; // MB (0 : unlimited)
 
     // TODO: support generic ellipse regression (no iris assumption)
     const bool doIris = true;
@@ -154,6 +176,12 @@ int gauze_main(int argc, char** argv)
         ( "verbose", "Print verbose diagnostics", cxxopts::value<bool>(doVerbose) )
         ( "silent", "Disable logging entirely.", cxxopts::value<bool>(doSilent) )
         ( "pupil", "Train on pupil (else iris)", cxxopts::value<bool>(doPupil))
+        ( "memory", "Training memory limit for feature matrices (MB)", cxxopts::value<int>(memoryLimit))
+        ( "checkpoint", "Write the training state after each stage to this file", cxxopts::value<std::string>(sCheckpoint))
+        ( "resume", "Resume training from a checkpoint (same data and leading recipes)", cxxopts::value<std::string>(sResume))
+        ( "report", "Write per stage timing and memory reports (JSON lines) to this file", cxxopts::value<std::string>(sReport))
+        ( "train-cache", "Decoded train sample cache (created or refreshed when stale)", cxxopts::value<std::string>(sTrainCache))
+        ( "test-cache", "Decoded test sample cache (created or refreshed when stale)", cxxopts::value<std::string>(sTestCache))
     
 #if defined(DRISHTI_USE_IMSHOW)        
         ( "window", "Do window", cxxopts::value<bool>(doWindow) )
@@ -223,7 +251,7 @@ int gauze_main(int argc, char** argv)
     }
 
     EllipseSamples train(logger);
-    train.load(sTrain, targetWidth, sExtension, doIris);
+    train.load(sTrain, targetWidth, sExtension, doIris, sTrainCache);
 
     drishti::rcpr::CPR::Model model;
     drishti::rcpr::createModel(0, model);
@@ -275,9 +303,28 @@ int gauze_main(int argc, char** argv)
 
     cprPrm.model->parts->wts = wts;
 
+    std::ofstream reportStream;
+    drishti::core::TrainingReport report("cpr", &reportStream);
+    if (!sReport.empty())
+    {
+        reportStream.open(sReport);
+        if (!reportStream)
+        {
+            logger->error("Cannot create specified report {}", sReport);
+            return 1;
+        }
+    }
+
     { // Train the model:
         drishti::rcpr::CPR cpr;
         cpr.setStreamLogger(logger);
+        cpr.setTrainingMemoryLimit(std::size_t(std::max(memoryLimit, 0)) << 20);
+        cpr.setCheckpoint(sCheckpoint);
+        cpr.setResume(sResume);
+        if (reportStream.is_open())
+        {
+            cpr.setReport(&report);
+        }
 
         if (doWindow || !sLoggingDir.empty())
         {
@@ -311,7 +358,11 @@ int gauze_main(int argc, char** argv)
             // clang-on
             cpr.setViewer(viewer);
         }
-        cpr.cprTrain(train.samples.images, train.samples.ellipses[int(doPupil)], train.samples.H, cprPrm, true);
+        if (cpr.cprTrain(train.samples.images, train.samples.ellipses[int(doPupil)], train.samples.H, cprPrm, true) != 0)
+        {
+            logger->error("Training failed");
+            return 1;
+        }
 
         // Dump the model:
         save_cpb(sModel, cpr);
@@ -325,7 +376,7 @@ int gauze_main(int argc, char** argv)
         cpr.setStreamLogger(logger);
 
         EllipseSamples test(logger);
-        test.load(sTest, targetWidth, sExtension, doIris);
+        test.load(sTest, targetWidth, sExtension, doIris, sTestCache);
 
         std::vector<double> errors(T, 0.0); // accumulate per stage errors
         for (int i = 0; i < test.samples.images.size(); i++)
@@ -386,10 +437,41 @@ EllipseSamples::EllipseSamples(std::shared_ptr<spdlog::logger>& logger)
 {
 }
 
-void EllipseSamples::load(const std::string& filename, int targetWidth, const std::string& sExt, bool doIris)
+// Image and annotation file stats and the load settings:
+static std::uint64_t hashSamples(const StringVec& filenames, int targetWidth, const std::string& sExt, bool doIris)
+{
+    using namespace drishti::core;
+
+    std::uint64_t h = hashCombine(hashString(sExt, EllipseSamples::kCacheVersion), std::uint64_t(targetWidth));
+    h = hashCombine(h, std::uint64_t(doIris));
+    for (const auto& sImage : filenames)
+    {
+        bfs::path sEye(sImage);
+        sEye.replace_extension(sExt);
+        for (const auto& path : { bfs::path(sImage), sEye })
+        {
+            boost::system::error_code ec;
+            h = hashString(path.string(), h);
+            const auto size = bfs::file_size(path, ec);
+            h = hashCombine(h, ec ? 0 : std::uint64_t(size));
+            const auto time = bfs::last_write_time(path, ec);
+            h = hashCombine(h, ec ? 0 : std::uint64_t(time));
+        }
+    }
+    return hashFinalize(h);
+}
+
+void EllipseSamples::load(const std::string& filename, int targetWidth, const std::string& sExt, bool doIris, const std::string& sCache)
 {
     const auto filenames = drishti::cli::expand(filename);
 
+    const std::uint64_t key = sCache.empty() ? 0 : hashSamples(filenames, targetWidth, sExt, doIris);
+    if (!sCache.empty() && loadCache(sCache, key, filenames.size()))
+    {
+        logger->info("Loaded {} samples from cache {}", filenames.size(), sCache);
+        return;
+    }
+
     cv::Mat features(filenames.size(), 5, CV_64F);
 
     samples.images.resize(filenames.size());
@@ -486,6 +568,139 @@ void EllipseSamples::load(const std::string& filename, int targetWidth, const st
         mu[i] = stats.mu[0];
         sigma[i] = stats.sigma[0];
     }
+
+    if (!sCache.empty())
+    {
+        saveCache(sCache, key);
+        logger->info("Saved {} samples to cache {}", filenames.size(), sCache);
+    }
+}
+
+/*
+ * Arrays, one entry per sample (skipped samples have empty crops and ellipses):
+ *
+ *   sample.size    : crop rows, cols
+ *   sample.offset  : crop offset in pixels (the image, then the mask)
+ *   sample.H       : normalization (row major 3x3)
+ *   sample.ellipse : iris and pupil phi (5 + 5)
+ */
+
+void EllipseSamples::saveCache(const std::string& filename, std::uint64_t key) const
+{
+    const std::size_t count = samples.images.size();
+
+    std::vector<std::int32_t> sizes(count * 2, 0);
+    std::vector<std::uint64_t> offsets(count, 0);
+    std::vector<float> H(count * 9), ellipses(count * 10, 0.f);
+    std::vector<std::uint8_t> pixels;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::copy(samples.H[i].val, samples.H[i].val + 9, H.begin() + (i * 9));
+
+        const cv::Mat& I = samples.images[i].getImage();
+        if (!I.empty())
+        {
+            const cv::Mat& M = samples.images[i].getMask();
+            CV_Assert(I.type() == CV_8UC1 && M.type() == CV_8UC1 && I.size() == M.size());
+            CV_Assert(I.isContinuous() && M.isContinuous());
+
+            sizes[i * 2 + 0] = I.rows;
+            sizes[i * 2 + 1] = I.cols;
+            offsets[i] = pixels.size();
+            pixels.insert(pixels.end(), I.datastart, I.dataend);
+            pixels.insert(pixels.end(), M.datastart, M.dataend);
+
+            for (int j = 0; j < 2; j++)
+            {
+                const auto& phi = samples.ellipses[j][i];
+                CV_Assert(phi.size() == 5);
+                std::copy(phi.begin(), phi.end(), ellipses.begin() + (i * 10) + (j * 5));
+            }
+        }
+    }
+
+    drishti::core::FlatArchiveWriter writer;
+    writer.addScalar("version", kCacheVersion);
+    writer.addScalar("key", key);
+    writer.add("sample.size", sizes);
+    writer.add("sample.offset", offsets);
+    writer.add("sample.H", H);
+    writer.add("sample.ellipse", ellipses);
+    writer.add("pixels", pixels);
+    writer.add("mu", mu);
+    writer.add("sigma", sigma);
+    writer.save(filename);
+}
+
+bool EllipseSamples::loadCache(const std::string& filename, std::uint64_t key, std::size_t count)
+{
+    if (!drishti::core::FlatArchive::isFlat(filename))
+    {
+        return false;
+    }
+
+    try
+    {
+        auto archive = drishti::core::FlatArchive::map(filename);
+        if ((archive->getScalar<std::uint32_t>("version") != kCacheVersion) || (archive->getScalar<std::uint64_t>("key") != key))
+        {
+            logger->info("Cache {} is stale", filename);
+            return false;
+        }
+
+        std::size_t n[7];
+        const auto* sizes = archive->get<std::int32_t>("sample.size", n[0]);
+        const auto* offsets = archive->get<std::uint64_t>("sample.offset", n[1]);
+        const auto* H = archive->get<float>("sample.H", n[2]);
+        const auto* ellipses = archive->get<float>("sample.ellipse", n[3]);
+        const auto* pixels = archive->get<std::uint8_t>("pixels", n[4]);
+        const auto* mu_ = archive->get<float>("mu", n[5]);
+        const auto* sigma_ = archive->get<float>("sigma", n[6]);
+        if ((n[0] != count * 2) || (n[1] != count) || (n[2] != count * 9) || (n[3] != count * 10) || (n[5] != 5) || (n[6] != 5))
+        {
+            logger->warn("Cache {} has unexpected sizes", filename);
+            return false;
+        }
+
+        PoseData data;
+        data.images.resize(count);
+        data.ellipses[0].resize(count);
+        data.ellipses[1].resize(count);
+        data.H.resize(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            std::copy(H + (i * 9), H + (i * 9) + 9, data.H[i].val);
+
+            const int rows = sizes[i * 2 + 0], cols = sizes[i * 2 + 1];
+            if (rows && cols)
+            {
+                const std::size_t area = std::size_t(rows) * std::size_t(cols);
+                if ((offsets[i] + (area * 2)) > n[4])
+                {
+                    logger->warn("Cache {} has truncated pixels", filename);
+                    return false;
+                }
+
+                // In place (read only) crops:
+                auto* crop = const_cast<std::uint8_t*>(pixels + offsets[i]);
+                data.images[i] = { cv::Mat(rows, cols, CV_8UC1, crop), cv::Mat(rows, cols, CV_8UC1, crop + area) };
+                data.ellipses[0][i].assign(ellipses + (i * 10), ellipses + (i * 10) + 5);
+                data.ellipses[1][i].assign(ellipses + (i * 10) + 5, ellipses + (i * 10) + 10);
+            }
+        }
+
+        samples = std::move(data);
+        mu.assign(mu_, mu_ + 5);
+        sigma.assign(sigma_, sigma_ + 5);
+        cache = archive;
+    }
+    catch (const std::exception& e)
+    {
+        logger->warn("Unable to load cache {}: {}", filename, e.what());
+        return false;
+    }
+
+    return true;
 }
 
 DRISHTI_BEGIN_NAMESPACE(cpr)
@@ -0,0 +1,317 @@
+/*! -*-c++-*-
+  @file   PackedDataset.cpp
+  @author David Hirvonen
+  @brief  Memory mapped dataset of grayscale crops and landmarks for shape_predictor training.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "PackedDataset.h"
+
+#include "drishti/core/make_unique.h"
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <dlib/data_io/image_dataset_metadata.h>
+#include <dlib/dir_nav.h>
+#include <dlib/image_io.h>
+#include <dlib/misc_api.h>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <set>
+
+namespace bip = boost::interprocess;
+
+DRISHTI_BEGIN_NAMESPACE(drishti)
+DRISHTI_BEGIN_NAMESPACE(dlib)
+
+static const char kMagic[8] = { 'D', 'R', 'P', 'A', 'C', 'K', '\0', '\0' };
+static const std::uint32_t kVersion = 1;
+
+// All sections are 8 byte aligned: header, pixels, entries, points
+struct PackedHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t parts;   // parts per object
+    std::uint64_t count;   // entries
+    std::uint64_t entries; // offset of the entry table (followed by the points)
+};
+
+struct PackedEntry
+{
+    std::uint64_t offset; // pixels (rows x cols, no padding)
+    std::int32_t rows;
+    std::int32_t cols;
+    std::int32_t rect[4]; // left, top, right, bottom
+};
+
+struct PackedPoint
+{
+    std::int32_t x; // INT32_MAX: OBJECT_PART_NOT_PRESENT
+    std::int32_t y;
+};
+
+struct PackedDataset::Impl
+{
+    bip::file_mapping file;
+    bip::mapped_region region;
+    const char* data = nullptr;
+    std::vector<PackedEntry> entries;
+    ObjectSet objects;
+};
+
+PackedDataset::PackedDataset() = default;
+PackedDataset::~PackedDataset() = default;
+
+bool PackedDataset::open(const std::string& filename)
+{
+    m_impl.reset();
+
+    try
+    {
+        auto impl = drishti::core::make_unique<Impl>();
+        impl->file = bip::file_mapping(filename.c_str(), bip::read_only);
+        impl->region = bip::mapped_region(impl->file, bip::read_only);
+        impl->data = static_cast<const char*>(impl->region.get_address());
+
+        const std::size_t bytes = impl->region.get_size();
+        if (bytes < sizeof(PackedHeader))
+        {
+            return false;
+        }
+
+        PackedHeader header;
+        std::memcpy(&header, impl->data, sizeof(header));
+        if (!std::equal(kMagic, kMagic + 8, header.magic) || (header.version != kVersion))
+        {
+            return false;
+        }
+
+        const std::size_t points = header.entries + header.count * sizeof(PackedEntry);
+        if ((header.entries < sizeof(PackedHeader)) || (bytes != (points + header.count * header.parts * sizeof(PackedPoint))))
+        {
+            return false;
+        }
+
+        // The entry and point tables are small, the object table is built once:
+        impl->entries.resize(header.count);
+        std::memcpy(impl->entries.data(), impl->data + header.entries, header.count * sizeof(PackedEntry));
+
+        std::vector<PackedPoint> parts(header.parts);
+        std::vector<::dlib::point> partlist(header.parts);
+        impl->objects.resize(header.count);
+        for (std::size_t i = 0; i < impl->entries.size(); i++)
+        {
+            const auto& e = impl->entries[i];
+            if ((e.rows <= 0) || (e.cols <= 0) || ((e.offset + std::uint64_t(e.rows) * e.cols) > header.entries))
+            {
+                return false;
+            }
+
+            std::memcpy(parts.data(), impl->data + points + i * header.parts * sizeof(PackedPoint), header.parts * sizeof(PackedPoint));
+            for (std::size_t j = 0; j < parts.size(); j++)
+            {
+                const bool present = (parts[j].x != std::numeric_limits<std::int32_t>::max());
+                partlist[j] = present ? ::dlib::point(parts[j].x, parts[j].y) : ::dlib::OBJECT_PART_NOT_PRESENT;
+            }
+
+            const ::dlib::rectangle rect(e.rect[0], e.rect[1], e.rect[2], e.rect[3]);
+            impl->objects[i] = { ::dlib::full_object_detection(rect, partlist) };
+        }
+
+        m_impl = std::move(impl);
+    }
+    catch (const bip::interprocess_exception&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+std::size_t PackedDataset::size() const
+{
+    return m_impl ? m_impl->entries.size() : 0;
+}
+
+auto PackedDataset::operator[](std::size_t i) const -> value_type
+{
+    const auto& e = m_impl->entries[i];
+    cv::Mat image(e.rows, e.cols, CV_8UC1, const_cast<char*>(m_impl->data + e.offset)); // read only mapping
+    return value_type(image);
+}
+
+auto PackedDataset::getObjects() const -> const ObjectSet&
+{
+    static const ObjectSet empty;
+    return m_impl ? m_impl->objects : empty;
+}
+
+static std::int32_t round32(double value)
+{
+    return static_cast<std::int32_t>(std::floor(value + 0.5));
+}
+
+std::size_t PackedDataset::pack(const std::string& xml, const std::string& filename, const Options& options)
+{
+    ::dlib::image_dataset_metadata::dataset data;
+    ::dlib::image_dataset_metadata::load_image_dataset_metadata(data, xml);
+
+    // Same part order as dlib::load_image_dataset() (sorted by name):
+    std::map<std::string, int> index;
+    {
+        std::set<std::string> names;
+        for (const auto& image : data.images)
+        {
+            for (const auto& box : image.boxes)
+            {
+                for (const auto& part : box.parts)
+                {
+                    names.insert(part.first);
+                }
+            }
+        }
+        for (const auto& name : names)
+        {
+            index.emplace(name, static_cast<int>(index.size()));
+        }
+    }
+
+    std::ofstream os(filename, std::ios::binary);
+    if (!os)
+    {
+        throw std::runtime_error("Unable to open " + filename);
+    }
+
+    PackedHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::copy(kMagic, kMagic + 8, header.magic);
+    header.version = kVersion;
+    header.parts = static_cast<std::uint32_t>(index.size());
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::uint64_t offset = sizeof(header);
+    std::vector<PackedEntry> entries;
+    std::vector<PackedPoint> points;
+
+    const int end = static_cast<int>(index.size()) - (options.ellipseCount * 5);
+
+    // Image paths are relative to the XML file:
+    ::dlib::locally_change_current_dir chdir(::dlib::get_parent_directory(::dlib::file(xml)));
+
+    for (const auto& image : data.images)
+    {
+        std::vector<const ::dlib::image_dataset_metadata::box*> boxes;
+        for (const auto& box : image.boxes)
+        {
+            if (!box.ignore)
+            {
+                boxes.push_back(&box);
+            }
+        }
+        if (boxes.empty())
+        {
+            continue; // skip_empty_images()
+        }
+
+        // Only the current image is held in memory:
+        ::dlib::array2d<std::uint8_t> pixels;
+        ::dlib::load_image(pixels, image.filename);
+        const cv::Mat gray(pixels.nr(), pixels.nc(), CV_8UC1, image_data(pixels), width_step(pixels));
+
+        for (const auto* box : boxes)
+        {
+            const auto& r = box->rect;
+            const double margin = options.padding * std::max(r.width(), r.height());
+            const cv::Rect bounds(cv::Point(round32(r.left() - margin), round32(r.top() - margin)), cv::Point(round32(r.right() + margin), round32(r.bottom() + margin)));
+            const cv::Rect roi = bounds & cv::Rect({ 0, 0 }, gray.size());
+            if (roi.area() == 0)
+            {
+                continue;
+            }
+
+            cv::Mat crop = gray(roi);
+            const double scale = (options.width > 0) ? (double(options.width) / crop.cols) : 1.0;
+            if (scale != 1.0)
+            {
+                cv::resize(crop, crop, {}, scale, scale, cv::INTER_LANCZOS4);
+            }
+            crop = crop.clone(); // continuous
+
+            const auto map = [&](long x, double origin) { return round32((x - origin) * scale); };
+
+            PackedEntry entry;
+            entry.offset = offset;
+            entry.rows = crop.rows;
+            entry.cols = crop.cols;
+            entry.rect[0] = map(r.left(), roi.x);
+            entry.rect[1] = map(r.top(), roi.y);
+            entry.rect[2] = map(r.right(), roi.x);
+            entry.rect[3] = map(r.bottom(), roi.y);
+            entries.push_back(entry);
+
+            std::vector<::dlib::point> parts(index.size(), ::dlib::OBJECT_PART_NOT_PRESENT);
+            for (const auto& part : box->parts)
+            {
+                parts[index[part.first]] = part.second;
+            }
+
+            for (int j = 0; j < static_cast<int>(parts.size()); j++)
+            {
+                PackedPoint point{ std::numeric_limits<std::int32_t>::max(), std::numeric_limits<std::int32_t>::max() };
+                if (parts[j] != ::dlib::OBJECT_PART_NOT_PRESENT)
+                {
+                    if (j < end)
+                    {
+                        point = { map(parts[j].x(), roi.x), map(parts[j].y(), roi.y) };
+                    }
+                    else
+                    {
+                        // ellipse: center x, center y, width, height, angle (see reduce_images())
+                        const int k = (j - end) % 5;
+                        const double origin = (k == 0) ? roi.x : ((k == 1) ? roi.y : 0.0);
+                        point = { (k < 4) ? map(parts[j].x(), origin) : static_cast<std::int32_t>(parts[j].x()), static_cast<std::int32_t>(parts[j].y()) };
+                    }
+                }
+                points.push_back(point);
+            }
+
+            const std::size_t bytes = crop.total();
+            os.write(reinterpret_cast<const char*>(crop.ptr()), bytes);
+            offset += bytes;
+        }
+    }
+
+    const std::size_t alignment = (8 - (offset % 8)) % 8;
+    static const char zeros[8] = { 0 };
+    os.write(zeros, alignment);
+    header.entries = offset + alignment;
+    header.count = entries.size();
+
+    os.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PackedEntry));
+    os.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(PackedPoint));
+    os.seekp(0);
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (!os)
+    {
+        throw std::runtime_error("Failed to write " + filename);
+    }
+
+    return entries.size();
+}
+
+DRISHTI_END_NAMESPACE(dlib)
+DRISHTI_END_NAMESPACE(drishti)
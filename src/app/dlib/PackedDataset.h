@@ -0,0 +1,72 @@
+/*! -*-c++-*-
+  @file   PackedDataset.h
+  @author David Hirvonen
+  @brief  Memory mapped dataset of grayscale crops and landmarks for shape_predictor training.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_dlib_PackedDataset_h__
+#define __drishti_dlib_PackedDataset_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <dlib/image_processing/full_object_detection.h>
+#include <dlib/opencv/cv_image.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+DRISHTI_BEGIN_NAMESPACE(drishti)
+DRISHTI_BEGIN_NAMESPACE(dlib)
+
+/*
+ * A packed dataset holds one 8-bit grayscale crop per object, with the object rectangle and
+ * parts in crop coordinates: a header, the pixel blobs, then the entry and point tables.  It
+ * is written one image at a time from a dlib XML dataset and read through a read only file
+ * mapping, so the pixels are paged in by the OS on demand and never copied.  Only the object
+ * table (a rectangle and the parts per crop) is held in memory, so the training set size is
+ * limited by the disk rather than RAM.  The entries follow the image_array interface used by
+ * shape_predictor_trainer::train(): size() and operator[] (a dlib::cv_image over the mapping).
+ */
+
+class PackedDataset
+{
+public:
+    using ObjectSet = std::vector<std::vector<::dlib::full_object_detection>>;
+    using value_type = ::dlib::cv_image<unsigned char>;
+
+    struct Options
+    {
+        float padding = 0.5f;  // crop margin as a fraction of the object size on each side
+        int width = 0;         // resize crops to this width (0 : native resolution)
+        int ellipseCount = 0;  // trailing 5 parameter ellipses stored in the part x coordinates
+    };
+
+    PackedDataset();
+    ~PackedDataset();
+
+    bool open(const std::string& filename);
+
+    std::size_t size() const;
+    value_type operator[](std::size_t i) const;
+
+    const ObjectSet& getObjects() const;
+
+    // Crop every (non ignored) object of a dlib XML dataset to a packed file, returns the crop count:
+    static std::size_t pack(const std::string& xml, const std::string& filename, const Options& options);
+
+protected:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+DRISHTI_END_NAMESPACE(dlib)
+DRISHTI_END_NAMESPACE(drishti)
+
+#endif // __drishti_dlib_PackedDataset_h__
@@ -29,6 +29,10 @@ void loadJSON(const std::string& filename, drishti::dlib::Recipe& recipe)
         recipe.features = json["features"].get<int>();
         recipe.oversampling = json["oversampling"].get<int>();
         recipe.splits = json["splits"].get<int>();
+        if (json.count("histogram_bins")) // optional
+        {
+            recipe.histogram_bins = json["histogram_bins"].get<int>();
+        }
         recipe.trees_per_level = json["trees_per_level"].get<int>();
         recipe.width = json["width"].get<int>();
         recipe.dimensions = json["dimensions"].get<std::vector<int>>();
@@ -62,6 +66,7 @@ void saveJSON(const std::string& filename, const drishti::dlib::Recipe& recipe)
         json["features"] = recipe.features;
         json["oversampling"] = recipe.oversampling;
         json["splits"] = recipe.splits;
+        json["histogram_bins"] = recipe.histogram_bins;
         json["trees_per_level"] = recipe.trees_per_level;
         json["width"] = recipe.width;
         json["dimensions"] = recipe.dimensions;
@@ -34,6 +34,7 @@ struct Recipe
     int features = 2048;
     int oversampling = 8;
     int splits = 512;
+    int histogram_bins = 0; // histogram split search (0 : exact)
     int trees_per_level = 512;
     int width = 0;
     bool do_pca = true;
@@ -52,6 +53,7 @@ struct Recipe
         os << "feature_pool_size: " << features << std::endl;
         os << "lambda: " << lambda << std::endl;
         os << "num_test_splits: " << splits << std::endl;
+        os << "num_histogram_bins: " << histogram_bins << std::endl;
         os << "feature_pool_region_padding: " << padding << std::endl;
         os << "use npd: " << npd << std::endl;
         os << "affine: " << do_affine << std::endl;
@@ -0,0 +1,138 @@
+// Compile a trained shape_predictor for a subset of its landmarks (i.e., eye corners, nose
+// tip and mouth corners of a face model), see shape_predictor::compile_landmarks().  Only the
+// requested landmarks are estimated, so full shape models store and accumulate smaller leaves
+// and PCA models back project onto fewer coordinates.
+//
+// Example (ibug68 eye corners, nose tip and mouth corners):
+//
+//   drishti_compile_shape_predictor --model=face.cpb --landmarks=36,39,42,45,30,48,54 --output=face_points.cpb
+
+#include "drishti/core/Logger.h"
+#include "drishti/core/infix_iterator.h"
+#include "drishti/ml/shape_predictor_archive.h"
+
+#include "drishti/core/drishti_stdlib_string.h"
+#include "drishti/core/drishti_cereal_pba.h"
+#include "drishti/core/drishti_cv_cereal.h"
+
+#include "cxxopts.hpp"
+
+#include <iostream>
+#include <sstream>
+
+static std::vector<int> parse_landmarks(const std::string& list)
+{
+    std::vector<int> landmarks;
+    std::stringstream ss(list);
+    for (std::string token; std::getline(ss, token, ',');)
+    {
+        landmarks.push_back(std::stoi(token));
+    }
+    return landmarks;
+}
+
+static std::string to_string(const std::vector<int>& landmarks)
+{
+    std::stringstream ss;
+    std::copy(landmarks.begin(), landmarks.end(), infix_ostream_iterator<int>(ss, ","));
+    return ss.str();
+}
+
+static std::string to_string(const drishti::core::MemoryUsage& usage)
+{
+    std::stringstream ss;
+    ss << usage;
+    return ss.str();
+}
+
+int gauze_main(int argc, char* argv[])
+{
+    auto logger = drishti::core::Logger::create("compile_shape_predictor");
+
+    const auto argumentCount = argc;
+
+    bool do_help = false;
+    bool do_silent = false;
+    bool do_reanchor = false;
+    int quantize_bits = 32;
+
+    std::string sLandmarks;
+    std::string sModel;
+    std::string sOutput;
+
+    cxxopts::Options options("compile_shape_predictor", "Command line interface for shape_predictor landmark subsets");
+
+    // clang-format off
+    options.add_options()
+        ( "model", "Input model file", cxxopts::value<std::string>(sModel))
+        ( "output", "Output model file", cxxopts::value<std::string>(sOutput))
+        ( "landmarks", "Comma separated landmark indices, in output order", cxxopts::value<std::string>(sLandmarks))
+        ( "reanchor", "Move the features of dropped landmarks to the nearest retained landmark", cxxopts::value<bool>(do_reanchor))
+        ( "quantize", "Leaf storage bits of the output (32 float, 16 fixed point, 8 with per tree scale)", cxxopts::value<int>(quantize_bits))
+        ( "silent", "Disable logging entirely", cxxopts::value<bool>(do_silent))
+        ( "help", "Print the help message", cxxopts::value<bool>(do_help));
+    // clang-format on
+
+    options.parse(argc, argv);
+
+    if (do_silent)
+    {
+        logger->set_level(spdlog::level::off);
+    }
+
+    if ((argumentCount <= 1) || options.count("help"))
+    {
+        logger->info(options.help({ "" }));
+        return 0;
+    }
+
+    if (sModel.empty() || sOutput.empty())
+    {
+        logger->error("Must specify input and output *.cpb model files.");
+        return 1;
+    }
+
+    const std::vector<int> landmarks = parse_landmarks(sLandmarks);
+    if (landmarks.empty())
+    {
+        logger->error("Must specify landmark indices.");
+        return 1;
+    }
+
+    drishti::ml::shape_predictor sp;
+    load_cpb(sModel, sp);
+    sp.pack();
+
+    const auto usage = sp.memory_usage();
+    if (!sp.compile_landmarks(landmarks, do_reanchor))
+    {
+        logger->error("Unable to compile landmarks {} (requires valid indices, float leaves for full shape models and no ellipses)", to_string(landmarks));
+        return 1;
+    }
+
+    logger->info("Landmarks: {} -> {} (estimated {}, retained {})", sp.num_parts(), landmarks.size(), to_string(sp.output_landmarks()), to_string(sp.m_landmarks));
+    logger->info("Memory: {} -> {}", to_string(usage), to_string(sp.memory_usage()));
+
+    if ((quantize_bits != 32) && !sp.quantize(quantize_bits))
+    {
+        logger->error("Unable to quantize leaves to {} bits", quantize_bits);
+        return 1;
+    }
+
+    save_cpb(sOutput, sp);
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception thrown:" << e.what();
+    }
+    return 1;
+}
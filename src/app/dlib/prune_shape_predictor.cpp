@@ -0,0 +1,181 @@
+// Reduce a trained shape_predictor for faster inference: trees and trailing cascades are
+// removed greedily while the validation error stays within a budget (see
+// drishti/ml/shape_predictor_pruning.h), then the remaining leaves are optionally refit.
+//
+// Example:
+//
+//   drishti_prune_shape_predictor --model=face.cpb --input=validation.xml --budget=0.05 --output=face_small.cpb
+
+typedef unsigned char boolean;
+#define TRUE 1
+#define FALSE 0
+#define HAVE_BOOLEAN
+#include "jpeglib.h"
+
+#include <dlib/data_io.h>
+#include <dlib/image_processing/shape_predictor.h>
+#include <dlib/data_io/load_image_dataset.h>
+
+#include "drishti/core/Logger.h"
+#include "drishti/core/infix_iterator.h"
+#include "drishti/ml/shape_predictor_archive.h"
+#include "drishti/ml/shape_predictor_pruning.h"
+
+#include "drishti/core/drishti_stdlib_string.h"
+#include "drishti/core/drishti_cereal_pba.h"
+#include "drishti/core/drishti_cv_cereal.h"
+
+#include "cxxopts.hpp"
+
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+using DlibObjectSet = std::vector<std::vector<dlib::full_object_detection>>;
+
+static std::vector<std::vector<double>> get_interocular_distances(const DlibObjectSet& objects);
+
+static std::string to_string(const std::vector<int>& trees)
+{
+    std::stringstream ss;
+    std::copy(trees.begin(), trees.end(), infix_ostream_iterator<int>(ss, ","));
+    return ss.str();
+}
+
+int gauze_main(int argc, char* argv[])
+{
+    auto logger = drishti::core::Logger::create("prune_shape_predictor");
+
+    const auto argumentCount = argc;
+
+    bool do_help = false;
+    bool do_silent = false;
+    bool do_no_refit = false;
+    int quantize_bits = 32;
+
+    drishti::ml::shape_predictor_pruning_options pruning;
+
+    std::string sInput;
+    std::string sModel;
+    std::string sOutput;
+
+    cxxopts::Options options("prune_shape_predictor", "Command line interface for shape_predictor pruning");
+
+    // clang-format off
+    options.add_options()
+        ( "input", "Validation set (dlib XML)", cxxopts::value<std::string>(sInput))
+        ( "model", "Input model file", cxxopts::value<std::string>(sModel))
+        ( "output", "Output model file", cxxopts::value<std::string>(sOutput))
+        ( "budget", "Allowed relative increase of the validation error", cxxopts::value<double>(pruning.budget))
+        ( "step", "Fraction of the trees of a cascade removed per greedy step", cxxopts::value<double>(pruning.step))
+        ( "no-refit", "Keep the leaves of the pruned cascades unchanged", cxxopts::value<bool>(do_no_refit))
+        ( "quantize", "Leaf storage bits of the output (32 float, 16 fixed point, 8 with per tree scale)", cxxopts::value<int>(quantize_bits))
+        ( "silent", "Disable logging entirely", cxxopts::value<bool>(do_silent))
+        ( "help", "Print the help message", cxxopts::value<bool>(do_help));
+    // clang-format on
+
+    options.parse(argc, argv);
+
+    if (do_silent)
+    {
+        logger->set_level(spdlog::level::off);
+    }
+
+    if ((argumentCount <= 1) || options.count("help"))
+    {
+        logger->info(options.help({ "" }));
+        return 0;
+    }
+
+    if (sModel.empty() || sOutput.empty())
+    {
+        logger->error("Must specify input and output *.cpb model files.");
+        return 1;
+    }
+
+    if (sInput.empty())
+    {
+        logger->error("Must specify valid XML validation file.");
+        return 1;
+    }
+
+    drishti::ml::shape_predictor sp;
+    load_cpb(sModel, sp);
+    if ((sp.m_leaf_bits != 32) || sp.forests.empty() || sp.forests.front().front().leaf_values.empty())
+    {
+        logger->error("Pruning requires a model with float leaves (not quantized).");
+        return 1;
+    }
+
+    DlibObjectSet faces;
+    dlib::array<dlib::array2d<uint8_t>> images;
+    dlib::image_dataset_file source(sInput);
+    source.skip_empty_images();
+    load_image_dataset(images, faces, source);
+
+    pruning.refit = !do_no_refit;
+
+    const std::size_t cascades = sp.forests.size();
+    const auto iod = get_interocular_distances(faces);
+    auto progress = [&](const drishti::ml::shape_predictor_pruning_result& step) {
+        logger->info("trees: {} error: {}", to_string(step.trees), step.error);
+    };
+    const auto result = drishti::ml::prune_shape_predictor(sp, images, faces, iod, pruning, progress);
+
+    const int trees = std::accumulate(result.trees.begin(), result.trees.end(), 0);
+    logger->info("Cascades: {} -> {}", cascades, result.trees.size());
+    logger->info("Trees: {} -> {} ({})", result.trees_full, trees, to_string(result.trees));
+    logger->info("Mean validation error: {} -> {}", result.error_full, result.error);
+
+    if ((quantize_bits != 32) && !sp.quantize(quantize_bits))
+    {
+        logger->error("Unable to quantize leaves to {} bits", quantize_bits);
+        return 1;
+    }
+
+    save_cpb(sOutput, sp);
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception thrown:" << e.what();
+    }
+    return 1;
+}
+
+// ----------------------------------------------------------------------------------------
+
+// Same normalization as train_shape_predictor (largest distance between landmarks):
+static double interocular_distance(const dlib::full_object_detection& det)
+{
+    double length = 0;
+    for (int i = 0; i < det.num_parts(); i++)
+    {
+        for (int j = i + 1; j < det.num_parts(); j++)
+        {
+            length = std::max(double(dlib::length(det.part(i) - det.part(j))), length);
+        }
+    }
+    return length;
+}
+
+static std::vector<std::vector<double>> get_interocular_distances(const DlibObjectSet& objects)
+{
+    std::vector<std::vector<double>> temp(objects.size());
+    for (unsigned long i = 0; i < objects.size(); ++i)
+    {
+        for (unsigned long j = 0; j < objects[i].size(); ++j)
+        {
+            temp[i].push_back(interocular_distance(objects[i][j]));
+        }
+    }
+    return temp;
+}
@@ -32,6 +32,7 @@ typedef unsigned char boolean;
 
 #include "drishti/core/string_utils.h"
 #include "drishti/core/Line.h"
+#include "drishti/core/TrainingReport.h"
 #include "drishti/ml/shape_predictor_archive.h"
 #include "drishti/ml/shape_predictor_trainer.h"
 #include "drishti/geometry/Ellipse.h"
@@ -39,10 +40,12 @@ typedef unsigned char boolean;
 #include "drishti/core/drishti_cereal_pba.h"
 #include "drishti/core/drishti_cv_cereal.h"
 
+#include "PackedDataset.h"
 #include "RecipeIO.h"
 
 #include "cxxopts.hpp"
 
+#include <fstream>
 #include <iostream>
 
 //#define _SP dlib
@@ -103,6 +106,9 @@ int gauze_main(int argc, char* argv[])
     bool do_thumbs = false;
     bool do_verbose = false;
     bool do_silent = false;
+    bool do_packed = false;
+    int quantize_bits = 32;
+    float pack_padding = 0.5f;
 
     drishti::dlib::Recipe recipe;
 
@@ -113,6 +119,10 @@ int gauze_main(int argc, char* argv[])
     std::string sRecipe;
     std::string sRecipeOut;
     std::string sOutput;
+    std::string sPack;
+    std::string sCheckpoint;
+    std::string sResume;
+    std::string sReport;
     
     cxxopts::Options options("train_shape_predictor", "Command line interface for dlib shape_predictor training");
 
@@ -128,6 +138,19 @@ int gauze_main(int argc, char* argv[])
         // Regression parameters:
         ( "recipe", "Cascaded pose regression training recipe", cxxopts::value<std::string>(sRecipe))
         ( "boilerplate", "Output boilerplate recipe file", cxxopts::value<std::string>(sRecipeOut))        
+        ( "quantize", "Leaf storage bits (32 float, 16 fixed point, 8 with per tree scale)", cxxopts::value<int>(quantize_bits))
+
+        // Out of core training:
+        ( "pack", "Write the training set as a packed dataset of crops and exit", cxxopts::value<std::string>(sPack))
+        ( "pack-padding", "Packed crop margin (fraction of the object size)", cxxopts::value<float>(pack_padding))
+        ( "packed", "The training file is a packed dataset (memory mapped)", cxxopts::value<bool>(do_packed))
+
+        // Resumable training:
+        ( "checkpoint", "Write the training state after each cascade to this file", cxxopts::value<std::string>(sCheckpoint))
+        ( "resume", "Resume training from a checkpoint (same data, seed and leading cascades)", cxxopts::value<std::string>(sResume))
+
+        // Profiling:
+        ( "report", "Write per cascade timing and memory reports (JSON lines) to this file", cxxopts::value<std::string>(sReport))
         
         ( "threads", "Use worker threads when possible", cxxopts::value<bool>(do_threads))
         ( "verbose", "Print verbose diagnostics", cxxopts::value<bool>(do_verbose))
@@ -169,6 +192,19 @@ int gauze_main(int argc, char* argv[])
         return 1;
     }
 
+    if(!sPack.empty())
+    {
+        // Crops are written one image at a time, the dataset is never fully loaded:
+        drishti::dlib::PackedDataset::Options pack_options;
+        pack_options.padding = pack_padding;
+        pack_options.width = recipe.width;
+        pack_options.ellipseCount = recipe.ellipse_count;
+
+        const auto count = drishti::dlib::PackedDataset::pack(sTrain, sPack, pack_options);
+        logger->info("Packed {} crops to {}", count, sPack);
+        return 0;
+    }
+
     if(sModel.empty())
     {
         logger->error("Must specify output *.dat model file.");
@@ -185,6 +221,7 @@ int gauze_main(int argc, char* argv[])
         logger->info("feature_pool_size: {}", recipe.features);
         logger->info("lambda: {}", recipe.lambda);
         logger->info("num_test_splits: {}", recipe.splits);
+        logger->info("num_histogram_bins: {}", recipe.histogram_bins);
         logger->info("feature_pool_region_padding: {}", recipe.padding);
         logger->info("use npd: {}", recipe.npd);
         logger->info("affine: {}", recipe.do_affine);
@@ -194,11 +231,31 @@ int gauze_main(int argc, char* argv[])
     dlib::array<dlib::array2d<uint8_t>> images_train, images_test;
     std::vector<std::vector<dlib::full_object_detection> > faces_train, faces_test;
 
-    dlib::image_dataset_file source(sTrain);
-    source.skip_empty_images();
-    load_image_dataset(images_train, faces_train, source);
-    
-    if(faces_train.empty())
+    // Packed datasets are memory mapped (the crops were reduced to recipe.width by --pack):
+    drishti::dlib::PackedDataset packed;
+    if(do_packed)
+    {
+        if(!packed.open(sTrain))
+        {
+            logger->error("Unable to open packed dataset {}", sTrain);
+            return 1;
+        }
+
+        if(do_thumbs)
+        {
+            logger->error("Thumbnails are not supported for packed datasets");
+            return 1;
+        }
+    }
+    else
+    {
+        dlib::image_dataset_file source(sTrain);
+        source.skip_empty_images();
+        load_image_dataset(images_train, faces_train, source);
+    }
+
+    const DlibObjectSet& objects_train = do_packed ? packed.getObjects() : faces_train;
+    if(objects_train.empty())
     {
         logger->error("No shapes specified for training");
         return 1;
@@ -211,7 +268,7 @@ int gauze_main(int argc, char* argv[])
     }
 
     // Here we optionally downsample:
-    if(recipe.width > 0)
+    if((recipe.width > 0) && !do_packed)
     {
         reduce_images(images_train, faces_train, recipe.ellipse_count, recipe.width);
     }
@@ -232,6 +289,7 @@ int gauze_main(int argc, char* argv[])
     trainer.set_feature_pool_size(recipe.features);
     trainer.set_lambda(recipe.lambda);                    // feature separation (not learning rate)
     trainer.set_num_test_splits(recipe.splits);
+    trainer.set_num_histogram_bins(recipe.histogram_bins);
     trainer.set_feature_pool_region_padding(recipe.padding);
 
     // new parameters
@@ -247,13 +305,28 @@ int gauze_main(int argc, char* argv[])
     trainer.set_do_line_indexed(recipe.do_interpolate);
     
     trainer.set_num_threads(8);
+    trainer.set_checkpoint(sCheckpoint);
+    trainer.set_resume(sResume);
+
+    std::ofstream reportStream;
+    drishti::core::TrainingReport report("shape_predictor", &reportStream);
+    if(!sReport.empty())
+    {
+        reportStream.open(sReport);
+        if(!reportStream)
+        {
+            logger->error("Unable to create report {}", sReport);
+            return 1;
+        }
+        trainer.set_report(&report);
+    }
     
     if(do_verbose)
     {
         trainer.be_verbose();
     }
 
-    int max_dim = faces_train[0][0].num_parts() * 2;
+    int max_dim = objects_train[0][0].num_parts() * 2;
     for(const auto &dim : recipe.dimensions)
     {
         CV_Assert(0 < dim && dim <= max_dim);
@@ -271,7 +344,7 @@ int gauze_main(int argc, char* argv[])
     }
     
     //_SP::shape_predictor sp;
-    _SP::shape_predictor sp = trainer.train(images_train, faces_train, weights);
+    _SP::shape_predictor sp = do_packed ? trainer.train(packed, objects_train, weights) : trainer.train(images_train, faces_train, weights);
     if(do_verbose)
     {
         logger->info("Done training...");
@@ -280,6 +353,12 @@ int gauze_main(int argc, char* argv[])
     // Finally, we save the model to disk so we can use it later.
     //dlib::serialize( sModel.c_str() ) << sp;
 
+    if((quantize_bits != 32) && !sp.quantize(quantize_bits))
+    {
+        logger->error("Unable to quantize leaves to {} bits", quantize_bits);
+        return 1;
+    }
+
     if(do_verbose)
     {
         logger->info("Saving to ...{}", sModel);
@@ -293,8 +372,8 @@ int gauze_main(int argc, char* argv[])
         logger->info("Done saving ...{}", sModel);
     }
 
-    auto train_iod = get_interocular_distances(faces_train);
-    double training_error = test_shape_predictor(sp, images_train, faces_train, train_iod);
+    auto train_iod = get_interocular_distances(objects_train);
+    double training_error = do_packed ? test_shape_predictor(sp, packed, objects_train, train_iod) : test_shape_predictor(sp, images_train, faces_train, train_iod);
     
     if(do_verbose)
     {
@@ -11,14 +11,14 @@
 // Local includes:
 #include "drishti/core/drishti_stdlib_string.h" // android workaround
 #include "drishti/eye/EyeModelEstimator.h"
-#include "drishti/core/LazyParallelResource.h"
+#include "drishti/eye/EyeJson.h"
 #include "drishti/core/Line.h"
 #include "drishti/core/Logger.h"
-#include "drishti/core/Parallel.h"
 #include "drishti/core/make_unique.h"
 #include "drishti/core/padding.h"
+#include "drishti/core/ResultsCache.h"
+#include "drishti/core/RingQueue.h"
 #include "drishti/core/string_utils.h"
-#include "drishti/core/drishti_cv_cereal.h"
 #include "drishti/testlib/drishti_cli.h"
 
 // Package includes:
@@ -29,10 +29,10 @@
 
 #include <spdlog/fmt/ostr.h>
 
-#include <cereal/archives/json.hpp>
-
 // System includes:
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 DRISHTI_BEGIN_NAMESPACE(drishti)
 DRISHTI_BEGIN_NAMESPACE(eye)
@@ -46,9 +46,9 @@ static bool writeAsJson(const std::string& filename, drishti::eye::EyeModel& eye
     std::ofstream ofs(filename);
     if (ofs)
     {
-        cereal::JSONOutputArchive oa(ofs);
-        typedef decltype(oa) Archive; // needed by macro
-        oa << GENERIC_NVP("eye", eye);
+        std::string json;
+        drishti::eye::toJson(eye, json);
+        ofs.write(json.data(), json.size());
     }
     return ofs.good();
 }
@@ -77,7 +77,7 @@ struct Padder : public Transform
     {
         if (!isGoodAspectRatio(input.size(), aspectRatio))
         {
-            tl = drishti::core::padToAspectRatio(input, image, aspectRatio, false);
+            tl = drishti::core::padToAspectRatio(input, image, aspectRatio, drishti::core::kPaddingFast);
         }
         else
         {
@@ -165,6 +165,114 @@ static void fitEyeModel(eye::EyeModelEstimator& fitter, cv::Mat& image, eye::Eye
     }
 }
 
+/*
+ * Blocking FIFO with a fixed capacity between two pipeline stages, the last producer closes it:
+ */
+
+template <typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(std::size_t capacity, int producers)
+        : m_queue(std::max(capacity, std::size_t(1)))
+        , m_producers(producers)
+    {
+    }
+
+    void push(T&& value)
+    {
+        m_queue.push(std::move(value));
+    }
+
+    // Pop up to count values (at least one), returns false once the queue is closed and drained:
+    bool pop(std::vector<T>& values, std::size_t count = 1)
+    {
+        values.clear();
+
+        drishti::core::Backoff backoff;
+        while (true)
+        {
+            T value;
+            while ((values.size() < count) && m_queue.tryPop(value))
+            {
+                values.push_back(std::move(value));
+            }
+
+            if (!values.empty())
+            {
+                return true;
+            }
+
+            // The last push happens before close(), so check the queue once more:
+            if (m_producers.load() == 0)
+            {
+                if (m_queue.tryPop(value))
+                {
+                    values.push_back(std::move(value));
+                    continue;
+                }
+                return false;
+            }
+
+            backoff();
+        }
+    }
+
+    void close() // called once by each producer
+    {
+        m_producers--;
+    }
+
+protected:
+    drishti::core::MPMCQueue<T> m_queue;
+    std::atomic<int> m_producers;
+};
+
+/*
+ * Per stage item count and busy time (summed over the stage threads):
+ */
+
+struct Throughput
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    struct Scope
+    {
+        Scope(Throughput& stage, std::size_t count = 1)
+            : stage(stage)
+            , count(count)
+            , tic(Clock::now())
+        {
+        }
+        ~Scope()
+        {
+            stage.items += count;
+            stage.busy += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - tic).count();
+        }
+        Throughput& stage;
+        std::size_t count;
+        Clock::time_point tic;
+    };
+
+    void report(spdlog::logger& logger, const std::string& name, int threads, double seconds) const
+    {
+        const double busy = double(this->busy) * 1e-6;
+        const double utilization = (seconds > 0.0) ? (busy / (seconds * threads)) : 0.0;
+        logger.info("{}: {} items {:.1f}/s ({} threads, {:.0f}% busy)", name, items.load(), double(items) / std::max(seconds, 1e-6), threads, utilization * 100.0);
+    }
+
+    std::atomic<std::size_t> items{ 0 };
+    std::atomic<std::int64_t> busy{ 0 }; // microseconds
+};
+
+struct EyeJob
+{
+    int index = -1;
+    cv::Mat image;
+    drishti::eye::EyeModel eye;
+    std::uint64_t key = 0; // content hash (see --cache)
+};
+
 DRISHTI_END_NAMESPACE(eye)
 DRISHTI_END_NAMESPACE(drishti)
 
@@ -182,12 +290,17 @@ int gauze_main(int argc, char** argv)
 
     std::string sInput, sOutput, sModel, sPrewarp;
     int threads = -1;
+    int decoders = 2;
+    int writers = 1;
+    int capacity = 64;
+    int batch = 16;
     int stages = std::numeric_limits<int>::max();
     bool doJson = true;
     bool doAnnotation = false;
     bool isRight = false;
     bool isLeft = false;
     bool doLabels = false;
+    bool doCache = false;
 
     cv::Matx33f prewarp = cv::Matx33f::eye();
 
@@ -200,12 +313,17 @@ int gauze_main(int argc, char** argv)
         ("m,model", "Eye model file", cxxopts::value<std::string>(sModel))
         ("s,stages", "Restrict cascade to <s> stages", cxxopts::value<int>(stages))
         ("t,threads", "Thread count", cxxopts::value<int>(threads))
+        ("decoders", "Image decoder thread count", cxxopts::value<int>(decoders))
+        ("writers", "Output writer thread count", cxxopts::value<int>(writers))
+        ("queue", "Queue capacity between pipeline stages", cxxopts::value<int>(capacity))
+        ("batch", "Results written per writer wakeup", cxxopts::value<int>(batch))
         ("j,json", "JSON model output", cxxopts::value<bool>(doJson))
         ("a,annotate", "Create annotated images", cxxopts::value<bool>(doAnnotation))
         ("r,right", "Right eye inputs", cxxopts::value<bool>(isRight))
         ("l,left", "Left eye inputs", cxxopts::value<bool>(isLeft))
         ("p,prewarp", "Prewarp", cxxopts::value<std::string>(sPrewarp))
         ("L,labels", "Generate label image", cxxopts::value<bool>(doLabels))
+        ("cache", "Reuse the results of duplicate images (content hash)", cxxopts::value<bool>(doCache))
         ("h,help", "Print help message");
     // clang-format on    
     
@@ -304,44 +422,120 @@ int gauze_main(int argc, char** argv)
     }
 
     const auto filenames = drishti::cli::expand(sInput);
-    
-    // Allocate resource manager:
-    using EyeModelEstimatorPtr = std::unique_ptr<drishti::eye::EyeModelEstimator>;
-    drishti::core::LazyParallelResource<std::thread::id, EyeModelEstimatorPtr> manager = [&]()
+
+    if((threads == -1) || (threads == 0))
+    {
+        threads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    }
+    decoders = std::max(decoders, 1);
+    writers = std::max(writers, 1);
+    batch = std::max(batch, 1);
+
+    // Threads share the models of a single estimator:
+    const auto estimator = drishti::core::make_unique<drishti::eye::EyeModelEstimator>(sModel);
+
+    // Duplicate images cost one hash, keys include the model and the fitting settings (eye
+    // models aren't stored in the face results log, so the cache lasts for the run):
+    std::unique_ptr<drishti::core::ResultsCache<drishti::eye::EyeModel>> cache;
+    std::uint64_t settings = 0;
+    if(doCache)
     {
-        return drishti::core::make_unique<drishti::eye::EyeModelEstimator>(sModel);
+        cache = drishti::core::make_unique<drishti::core::ResultsCache<drishti::eye::EyeModel>>();
+        settings = drishti::core::hashFile(sModel);
+        settings = drishti::core::hashCombine(settings, isRight);
+        settings = drishti::core::hashCombine(settings, std::uint64_t(stages));
+        settings = drishti::core::hashBytes(prewarp.val, hasPrewarp ? sizeof(prewarp.val) : 0, settings);
+    }
+
+    // #############################################################
+    // ### Pipeline: decode -> segment -> write (bounded queues) ###
+    // #############################################################
+
+    using drishti::eye::EyeJob;
+    using drishti::eye::Throughput;
+    const auto queueSize = static_cast<std::size_t>(std::max(capacity, 1));
+    drishti::eye::BoundedQueue<EyeJob> decoded(queueSize, decoders), segmented(queueSize, threads);
+    Throughput decoding, segmenting, writing;
+    std::atomic<std::size_t> next{ 0 }, total{ 0 };
+
+    // Prefetch images ahead of the segmenters:
+    auto decoder = [&]()
+    {
+        std::size_t index = 0;
+        while((index = next++) < filenames.size())
+        {
+            EyeJob job;
+            job.index = static_cast<int>(index);
+            {
+                Throughput::Scope scope(decoding);
+                job.image = cv::imread(filenames[index], cv::IMREAD_COLOR);
+            }
+            if(job.image.empty())
+            {
+                logger->error("Failed to read: {}", filenames[index]);
+                continue;
+            }
+            if(cache)
+            {
+                job.key = drishti::core::hashImage(job.image, settings);
+            }
+            decoded.push(std::move(job));
+        }
+        decoded.close();
     };
-    
-    std::size_t total = 0;
-    
-    // Parallel loop:
-    drishti::core::ParallelHomogeneousLambda harness = [&](int i)
-    {
-        // Get thread specific segmenter lazily:
-        auto &segmenter = manager[std::this_thread::get_id()];
-        segmenter->setEyelidStagesHint(stages);
-        assert(segmenter);
-        
-        // Load current image
-        cv::Mat image = cv::imread(filenames[i], cv::IMREAD_COLOR);
-        if(!image.empty())
+
+    // Each segmenter owns a lightweight clone of the estimator:
+    auto segmenter = [&]()
+    {
+        const auto fitter = estimator->clone();
+        fitter->setEyelidStagesHint(stages);
+
+        std::vector<EyeJob> jobs;
+        while(decoded.pop(jobs))
         {
-            drishti::eye::EyeModel eye;
-            drishti::eye::fitEyeModel(*segmenter, image, eye, isRight, hasPrewarp ? &prewarp : nullptr);
-            eye.refine();
+            for(auto &job : jobs)
+            {
+                Throughput::Scope scope(segmenting);
+                if(cache && cache->find(job.key, job.eye))
+                {
+                    continue;
+                }
 
-            if(!sOutput.empty())
+                drishti::eye::fitEyeModel(*fitter, job.image, job.eye, isRight, hasPrewarp ? &prewarp : nullptr);
+                job.eye.refine();
+                if(cache)
+                {
+                    cache->insert(job.key, job.eye);
+                }
+            }
+            for(auto &job : jobs)
+            {
+                segmented.push(std::move(job));
+            }
+        }
+        segmented.close();
+    };
+
+    // Write batches of results, so disk access overlaps with segmentation:
+    auto writer = [&]()
+    {
+        std::vector<EyeJob> jobs;
+        while(segmented.pop(jobs, batch))
+        {
+            Throughput::Scope scope(writing, jobs.size());
+            for(auto &job : jobs)
             {
                 // Construct valid filename with no extension:
-                std::string base = drishti::core::basename(filenames[i]);
+                const auto &eye = job.eye;
+                std::string base = drishti::core::basename(filenames[job.index]);
                 std::string filename = sOutput + "/" + base;
-                
+
                 logger->info("{}/{} {}", ++total, filenames.size(), filename);
 
                 // Write the annotated image
                 if(doAnnotation)
                 {
-                    cv::Mat canvas = image.clone();
+                    cv::Mat canvas = job.image.clone();
                     eye.draw(canvas);
                     cv::imwrite(filename + "_contours.png", canvas);
                 }
@@ -349,14 +543,14 @@ int gauze_main(int argc, char** argv)
                 // Save part labels
                 if(doLabels)
                 {
-                    cv::Mat labels = eye.labels(image.size());
+                    cv::Mat labels = eye.labels(job.image.size());
                     cv::imwrite(filename + "_labels.png", labels);
                 }
 
                 // Save eye model results as xml:
                 if(doJson)
                 {
-                    if(!drishti::eye::writeAsJson(filename + ".json", eye))
+                    if(!drishti::eye::writeAsJson(filename + ".json", job.eye))
                     {
                         logger->error("Failed to write: {}.json", filename);
                     }
@@ -364,14 +558,34 @@ int gauze_main(int argc, char** argv)
             }
         }
     };
-    
-    if(threads == 1 || threads == 0)
+
+    const auto tic = Throughput::Clock::now();
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < decoders; i++)
     {
-        harness({0,static_cast<int>(filenames.size())});
+        workers.emplace_back(decoder);
     }
-    else
+    for(int i = 0; i < threads; i++)
+    {
+        workers.emplace_back(segmenter);
+    }
+    for(int i = 0; i < writers; i++)
+    {
+        workers.emplace_back(writer);
+    }
+    for(auto &w : workers)
+    {
+        w.join();
+    }
+
+    const double seconds = std::chrono::duration<double>(Throughput::Clock::now() - tic).count();
+    decoding.report(*logger, "decode", decoders, seconds);
+    segmenting.report(*logger, "segment", threads, seconds);
+    writing.report(*logger, "write", writers, seconds);
+    if(cache)
     {
-        cv::parallel_for_({0,static_cast<int>(filenames.size())}, harness, std::max(threads, -1));
+        logger->info("cache: {} hits, {} results", cache->hits(), cache->size());
     }
 
     return 0;
@@ -14,13 +14,17 @@
 #include "drishti/core/Line.h"
 #include "drishti/core/Logger.h"
 #include "drishti/core/Parallel.h"
+#include "drishti/core/ResultsCache.h"
+#include "drishti/core/RingQueue.h"
 #include "drishti/core/make_unique.h"
 #include "drishti/core/string_utils.h"
-#include "drishti/core/drishti_cv_cereal.h"
 #include "drishti/core/scope_guard.h"
 #include "drishti/testlib/drishti_cli.h"
+#include "drishti/face/EyeCropper.h"
 #include "drishti/face/FaceDetector.h"
 #include "drishti/face/FaceDetectorFactoryJson.h"
+#include "drishti/face/FaceJson.h"
+#include "drishti/face/FaceResultsLog.h"
 #include "drishti/face/gpu/FaceStabilizer.h"
 #include "drishti/geometry/motion.h"
 #include "drishti/ml/ObjectDetector.h"
@@ -35,11 +39,15 @@
 // clang-format on
 
 #include "videoio/VideoSourceCV.h"
+#include "videoio/VideoSourcePrefetch.h"
 
 // Package includes:
 #include "cxxopts.hpp"
 #include <opencv2/highgui.hpp>
-#include <cereal/archives/json.hpp>
+
+#include <atomic>
+#include <functional>
+#include <thread>
 
 using drishti::face::FaceSpecification;
 using LoggerPtr = std::shared_ptr<spdlog::logger>;
@@ -65,10 +73,10 @@ class Resizer
 public:
     using PaddedImage = drishti::face::FaceDetector::PaddedImage;
 
-    // Create:
+    // Create from the BGR frame:
     // 1) reduced+RGB+float+transposed low resolution image
     // 2) single channel padded grayscale image (higher resolution)
-    Resizer(cv::Mat& image, const cv::Size& winSize, int width = -1)
+    Resizer(const cv::Mat& image, const cv::Size& winSize, int width = -1)
     {
         if ((width >= 0) && !image.empty())
         {
@@ -87,10 +95,8 @@ public:
             padded = PaddedImage(green, { { 0, 0 }, green.size() });
         }
 
-        { // Create the lower resolution image for detection:
-            cv::Mat It = reduced.t(), Itf;
-            It.convertTo(Itf, CV_32FC3, 1.0f / 255.f);
-            planar = MatP(Itf);
+        { // Create the lower resolution image for detection (uint8 until the planar unpack):
+            drishti::ml::ObjectDetectorACF::getPlanar(reduced, planar, true);
             Sdr = 1.f / Sfd;
         }
 
@@ -137,6 +143,126 @@ protected:
     PaddedImage padded;
 };
 
+struct FaceJob
+{
+    drishti::videoio::VideoSourceCV::Frame frame;
+    std::unique_ptr<Resizer> resizer;
+    std::vector<drishti::face::FaceModel> faces;
+    std::uint64_t key = 0; // content hash (see --cache)
+    bool cached = false;
+};
+
+/*
+ * Frames are decoded on the calling thread in stream order (so sequential videos work too)
+ * and handed through bounded queues to the preprocess, detect and output stages, each with
+ * its own worker count.  A full queue blocks the stage that feeds it, which bounds the number
+ * of frames in flight.  A null job ends the stream: each worker consumes one, and the last
+ * worker of a stage to finish forwards one per worker to the next stage.
+ */
+
+class FacePipeline
+{
+public:
+    using JobPtr = std::shared_ptr<FaceJob>;
+    using Queue = drishti::core::MPMCQueue<JobPtr>;
+    using Stage = std::function<void(FaceJob& job)>;
+
+    enum StageIndex
+    {
+        kPreprocess, // BGR to RGB, resize, planar
+        kDetect,     // detection and regression
+        kOutput,     // json, eye crops and annotations
+        kStageCount
+    };
+
+    struct Config
+    {
+        int workers[kStageCount] = { 1, 1, 1 };
+        int capacity = 16; // jobs per queue
+    };
+
+    FacePipeline(const Config& config)
+        : m_config(config)
+    {
+        for (int stage = 0; stage < kStageCount; stage++)
+        {
+            m_queues[stage] = drishti::core::make_unique<Queue>(config.capacity);
+        }
+    }
+
+    Stage& operator[](int stage) { return m_stages[stage]; }
+
+    void run(drishti::videoio::VideoSourceCV& video)
+    {
+        std::vector<std::thread> threads;
+        for (int stage = 0; stage < kStageCount; stage++)
+        {
+            m_remaining[stage] = m_config.workers[stage];
+            for (int i = 0; i < m_config.workers[stage]; i++)
+            {
+                threads.emplace_back([this, stage]() { work(stage); });
+            }
+        }
+
+        for (int i = 0; i < static_cast<int>(video.count()); i++)
+        {
+            auto job = std::make_shared<FaceJob>();
+            job->frame = video(i);
+            if (job->frame.image.empty())
+            {
+                break;
+            }
+            m_queues[kPreprocess]->push(std::move(job));
+        }
+        finish(kPreprocess);
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+protected:
+    void work(int stage)
+    {
+        JobPtr job;
+        while (true)
+        {
+            m_queues[stage]->pop(job);
+            if (!job)
+            {
+                break;
+            }
+
+            m_stages[stage](*job);
+            if ((stage + 1) < kStageCount)
+            {
+                m_queues[stage + 1]->push(std::move(job));
+            }
+            job.reset();
+        }
+
+        if ((--m_remaining[stage] == 0) && ((stage + 1) < kStageCount))
+        {
+            finish(stage + 1);
+        }
+    }
+
+    // End of stream for each worker of the stage:
+    void finish(int stage)
+    {
+        for (int i = 0; i < m_config.workers[stage]; i++)
+        {
+            m_queues[stage]->push(JobPtr());
+        }
+    }
+
+    Config m_config;
+    Stage m_stages[kStageCount];
+    std::unique_ptr<Queue> m_queues[kStageCount];
+    std::atomic<int> m_remaining[kStageCount];
+};
+
 int gauze_main(int argc, char** argv)
 {
     const auto argumentCount = argc;
@@ -148,13 +274,20 @@ int gauze_main(int argc, char** argv)
     // ### Command line parsing ###
     // ############################
 
-    std::string sInput, sOutput;
+    std::string sInput, sOutput, sResults, sCacheLog;
     int threads = -1;
+    int prefetch = 0;
+    bool doPipeline = false;
+    int preprocessThreads = 1;
+    int detectThreads = 0;
+    int outputThreads = 1;
+    int queueSize = 16;
     bool doEyes = false;
     bool doPause = false;
     bool doDisplay = false;
     bool doAnnotation = false;
     bool doPositiveOnly = false;
+    bool doCache = false;
     float scale = 1.0;
     double cascCal = 0.0;
     int minWidth = -1; // minimum object width
@@ -173,6 +306,9 @@ int gauze_main(int argc, char** argv)
     options.add_options()
         ("i,input", "Input file", cxxopts::value<std::string>(sInput))
         ("o,output", "Output directory", cxxopts::value<std::string>(sOutput))
+        ("results", "Binary columnar results log (instead of one JSON file per image)", cxxopts::value<std::string>(sResults))
+        ("cache", "Reuse the results of duplicate images (content hash)", cxxopts::value<bool>(doCache))
+        ("cache-log", "Results log of a previous run to seed the cache", cxxopts::value<std::string>(sCacheLog))
     
         // Detection parameters:
         ("l,min", "Minimum object width (lower bound)", cxxopts::value<int>(minWidth))
@@ -196,6 +332,14 @@ int gauze_main(int argc, char** argv)
         ("0,pause", "Pause display window", cxxopts::value<bool>(doPause))
         ("p,positive", "Limit output to positve examples", cxxopts::value<bool>(doPositiveOnly))
         ("t,threads", "Thread count", cxxopts::value<int>(threads))
+        ("prefetch", "Frames decoded ahead of processing (0 : synchronous)", cxxopts::value<int>(prefetch))
+
+        // Staged pipeline (any video, not only random access):
+        ("pipeline", "Run decode, preprocess, detect and output stages concurrently", cxxopts::value<bool>(doPipeline))
+        ("preprocess-threads", "Pipeline preprocess workers", cxxopts::value<int>(preprocessThreads))
+        ("detect-threads", "Pipeline detection workers (0 : one per core)", cxxopts::value<int>(detectThreads))
+        ("output-threads", "Pipeline output workers", cxxopts::value<int>(outputThreads))
+        ("queue", "Pipeline queue size", cxxopts::value<int>(queueSize))
         ("h,help", "Print help message");
     // clang-format on
 
@@ -271,10 +415,14 @@ int gauze_main(int argc, char** argv)
 #endif
 
     auto video = drishti::videoio::VideoSourceCV::create(sInput);
+    if (prefetch > 0)
+    {
+        video = std::make_shared<drishti::videoio::VideoSourcePrefetch>(video, prefetch);
+    }
 
     // Allocate resource manager:
     using FaceDetectorPtr = std::unique_ptr<drishti::face::FaceDetector>;
-    drishti::core::LazyParallelResource<std::thread::id, FaceDetectorPtr> manager = [&]() {
+    drishti::core::ThreadLocalParallelResource<FaceDetectorPtr> manager = [&]() {
 
         FaceDetectorPtr detector = drishti::core::make_unique<drishti::face::FaceDetector>(*factory);
 
@@ -308,90 +456,198 @@ int gauze_main(int argc, char** argv)
         return detector;
     };
 
-    std::size_t total = 0;
+    // Batch runs append all results to one file (see drishti::face::FaceResultsReader):
+    std::unique_ptr<drishti::face::FaceResultsWriter> results;
+    if (!sResults.empty())
+    {
+        results = drishti::core::make_unique<drishti::face::FaceResultsWriter>(sResults);
+    }
 
-    // Parallel loop:
-    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
-        // Get thread specific segmenter lazily:
-        auto& detector = manager[std::this_thread::get_id()];
-        assert(detector);
+    // Duplicate images cost one hash: keys include the models and the detection settings, so
+    // the records (with keys) of a previous results log can seed the cache:
+    using FaceModelVec = std::vector<drishti::face::FaceModel>;
+    std::unique_ptr<drishti::core::ResultsCache<FaceModelVec>> cache;
+    std::uint64_t settings = 0;
+    if (doCache || !sCacheLog.empty())
+    {
+        cache = drishti::core::make_unique<drishti::core::ResultsCache<FaceModelVec>>();
 
-        // Load current image:
-        auto frame = (*video)(i);
-        const auto& image = frame.image;
+        std::stringstream ss;
+        ss << scale << " " << cascCal << " " << minWidth << " " << factory->inner;
+        for (const auto& c : config)
+        {
+            settings = drishti::core::hashFile(c.first, settings);
+        }
+        settings = drishti::core::hashString(ss.str(), settings);
+
+        if (!sCacheLog.empty())
+        {
+            const drishti::face::FaceResultsReader reader(sCacheLog);
+            for (std::size_t i = 0; i < reader.size(); i++)
+            {
+                if (const std::uint64_t key = reader.getKey(i))
+                {
+                    cache->insert(key, reader.getFaces(i));
+                }
+            }
+            logger->info("Cache: {} results from {}", cache->size(), sCacheLog);
+        }
+    }
 
-        if (!image.empty())
+    std::atomic<std::size_t> total{ 0 };
+
+    // Stages of the per frame work (the job is handed between threads in pipeline mode):
+    auto preprocess = [&](FaceJob& job, const cv::Size& winSize) {
+        if (cache)
         {
-            cv::Mat Irgb;
-            cv::cvtColor(image, Irgb, cv::COLOR_BGR2RGB);
+            job.key = drishti::core::hashImage(job.frame.image, settings);
+            job.cached = cache->find(job.key, job.faces);
+            if (job.cached)
+            {
+                return;
+            }
+        }
 
-            Resizer resizer(Irgb, detector->getWindowSize(), minWidth);
+        job.resizer = drishti::core::make_unique<Resizer>(job.frame.image, winSize, minWidth);
+    };
 
-            std::vector<drishti::face::FaceModel> faces;
-            const auto& Hdr = resizer.getDetectorToRegressor();
-            (*detector)(resizer.getPlanar(), resizer.getPadded(), faces, Hdr);
+    auto detect = [&](FaceJob& job, drishti::face::FaceDetector& detector) {
+        if (job.cached)
+        {
+            return;
+        }
 
-            resizer(faces);
+        const auto& Hdr = job.resizer->getDetectorToRegressor();
+        detector(job.resizer->getPlanar(), job.resizer->getPadded(), job.faces, Hdr);
+        (*job.resizer)(job.faces);
+        job.resizer.reset(); // release the detection images before the output stage
 
-            if (!doPositiveOnly || (faces.size() > 0))
-            {
-                // Construct valid filename with no extension:
-                std::string base = drishti::core::basename(frame.name);
-                std::string filename = sOutput + "/" + base;
+        if (cache)
+        {
+            cache->insert(job.key, job.faces);
+        }
+    };
 
-                logger->info("{}/{} {} = {}", ++total, video->count(), filename, faces.size());
+    auto report = [&]() {
+        if (cache)
+        {
+            logger->info("Cache: {} hits, {} results", cache->hits(), cache->size());
+        }
+    };
 
-                // Save detection results in JSON:
-                if (!writeAsJson(filename + ".json", faces))
-                {
-                    logger->error("Failed to write: {}.json", filename);
-                }
+    auto output = [&](FaceJob& job) {
+        const auto& image = job.frame.image;
+        const auto& faces = job.faces;
 
-#if defined(DRISHTI_USE_IMSHOW)
-                int windowCount = 0;
-                drishti::core::scope_guard waiter = [&]() {
-                    if (windowCount > 0)
-                    {
-                        glfw::waitKey(doPause ? 0 : 1);
-                    }
-                };
-#endif
+        if (!doPositiveOnly || (faces.size() > 0))
+        {
+            // Construct valid filename with no extension (sequential videos have no frame names):
+            std::string base = drishti::core::basename(job.frame.name);
+            if (base.empty())
+            {
+                std::stringstream ss;
+                ss << "frame_" << std::setfill('0') << std::setw(6) << job.frame.index;
+                base = ss.str();
+            }
+            std::string filename = sOutput + "/" + base;
 
-                if (doEyes)
-                {
-                    for (int i = 0; i < faces.size(); i++)
-                    {
-                        cv::Mat eyes = cropEyes(image, faces[i], { 640, 240 }, 0.666f, doAnnotation);
+            logger->info("{}/{} {} = {}", ++total, video->count(), filename, faces.size());
 
-                        std::stringstream ss;
-                        ss << std::setfill('0') << std::setw(2) << i;
-                        cv::imwrite(filename + ss.str() + "_eyes.png", eyes);
+            // Save detection results in the results log or in JSON:
+            if (results)
+            {
+                (*results)(base, faces, job.key);
+            }
+            else if (!writeAsJson(filename + ".json", faces))
+            {
+                logger->error("Failed to write: {}.json", filename);
+            }
 
 #if defined(DRISHTI_USE_IMSHOW)
-                        if (doDisplay)
-                        {
-                            windowCount++;
-                            glfw::imshow("eyes", eyes);
-                        }
-#endif
-                    }
+            int windowCount = 0;
+            drishti::core::scope_guard waiter = [&]() {
+                if (windowCount > 0)
+                {
+                    glfw::waitKey(doPause ? 0 : 1);
                 }
+            };
+#endif
 
-                if (doAnnotation)
+            if (doEyes)
+            {
+                for (int i = 0; i < faces.size(); i++)
                 {
-                    cv::Mat canvas = image.clone();
-                    drawObjects(canvas, faces);
-                    cv::imwrite(filename + "_faces.png", canvas);
+                    cv::Mat eyes = cropEyes(image, faces[i], { 640, 240 }, 0.666f, doAnnotation);
+
+                    std::stringstream ss;
+                    ss << std::setfill('0') << std::setw(2) << i;
+                    cv::imwrite(filename + ss.str() + "_eyes.png", eyes);
 
 #if defined(DRISHTI_USE_IMSHOW)
                     if (doDisplay)
                     {
                         windowCount++;
-                        glfw::imshow("face", canvas);
+                        glfw::imshow("eyes", eyes);
                     }
 #endif
                 }
             }
+
+            if (doAnnotation)
+            {
+                cv::Mat canvas = image.clone();
+                drawObjects(canvas, faces);
+                cv::imwrite(filename + "_faces.png", canvas);
+
+#if defined(DRISHTI_USE_IMSHOW)
+                if (doDisplay)
+                {
+                    windowCount++;
+                    glfw::imshow("face", canvas);
+                }
+#endif
+            }
+        }
+    };
+
+    if (doPipeline && !doDisplay)
+    {
+        // Decode -> preprocess -> detect -> output, the window size is the same for all detectors:
+        const cv::Size winSize = manager.get()->getWindowSize();
+
+        FacePipeline::Config config;
+        config.workers[FacePipeline::kPreprocess] = std::max(preprocessThreads, 1);
+        config.workers[FacePipeline::kDetect] = (detectThreads > 0) ? detectThreads : std::max(int(std::thread::hardware_concurrency()), 1);
+        config.workers[FacePipeline::kOutput] = std::max(outputThreads, 1);
+        config.capacity = std::max(queueSize, 1);
+
+        FacePipeline pipeline(config);
+        pipeline[FacePipeline::kPreprocess] = [&](FaceJob& job) { preprocess(job, winSize); };
+        pipeline[FacePipeline::kDetect] = [&](FaceJob& job) { detect(job, *manager.get()); };
+        pipeline[FacePipeline::kOutput] = output;
+        pipeline.run(*video);
+        if (results)
+        {
+            results->close();
+        }
+        report();
+        return 0;
+    }
+
+    // Parallel loop:
+    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+        // Get thread specific segmenter lazily:
+        auto& detector = manager.get();
+        assert(detector);
+
+        // Load current image:
+        FaceJob job;
+        job.frame = (*video)(i);
+        if (!job.frame.image.empty())
+        {
+            preprocess(job, detector->getWindowSize());
+            detect(job, *detector);
+            output(job);
         }
     };
 
@@ -404,6 +660,12 @@ int gauze_main(int argc, char** argv)
         cv::parallel_for_({ 0, static_cast<int>(video->count()) }, harness, std::max(threads, -1));
     }
 
+    if (results)
+    {
+        results->close(); // write errors are reported here (the destructor can't throw)
+    }
+    report();
+
     return 0;
 }
 
@@ -447,10 +709,11 @@ checkModel(LoggerPtr& logger, const std::string& sModel, const std::string& desc
 static cv::Mat
 cropEyes(const cv::Mat& image, const drishti::face::FaceModel& face, const cv::Size& size, float scale, bool annotate)
 {
-    const cv::Matx33f H = drishti::face::FaceStabilizer::stabilize(face, size, scale);
+    // Tracked eyes reuse the fixed point tables of a few quantized transformations:
+    static const drishti::face::EyeCropper cropper;
 
     cv::Mat eyes;
-    cv::warpAffine(image, eyes, H.get_minor<2, 3>(0, 0), size);
+    const cv::Matx33f H = cropper(image, drishti::face::FaceStabilizer::stabilize(face, size, scale), size, eyes);
 
     if (annotate)
     {
@@ -468,9 +731,9 @@ writeAsJson(const std::string& filename, const std::vector<drishti::face::FaceMo
     std::ofstream ofs(filename);
     if (ofs)
     {
-        cereal::JSONOutputArchive oa(ofs);
-        typedef decltype(oa) Archive; // needed by macro
-        oa << GENERIC_NVP("faces", faces);
+        std::string json;
+        drishti::face::toJson(faces, json);
+        ofs.write(json.data(), json.size());
     }
     return ofs.good();
 }
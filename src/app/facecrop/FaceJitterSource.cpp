@@ -0,0 +1,220 @@
+/*! -*-c++-*-
+  @file   FaceJitterSource.cpp
+  @author David Hirvonen
+  @brief  Parallel on the fly face jitter (augmentation) source for training.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "FaceJitterSource.h"
+
+#include "drishti/core/LazyParallelResource.h"
+#include "drishti/core/Parallel.h"
+#include "drishti/core/make_unique.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
+// splitmix64 finalizer: decorrelates the seeds of neighboring samples
+static std::uint64_t mix(std::uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+using FaceJittererPtr = std::unique_ptr<FaceJitterer>;
+using Batch = std::vector<FaceWithLandmarks>;
+
+struct FaceJitterSource::Impl
+{
+    Impl(const FACE::Table& table, const FaceSpecification& face, const JitterParams& params, const Options& options, Loader loader)
+        : table(table)
+        , face(face)
+        , params(params)
+        , options(options)
+        , loader(loader)
+        , jitterers([this]() { return drishti::core::make_unique<FaceJitterer>(this->table, this->face, this->params); })
+    {
+        if (!this->loader)
+        {
+            this->loader = [this](int line) {
+                const auto& record = this->table.lines[line];
+                return record.image.empty() ? cv::imread(record.filename, cv::IMREAD_COLOR) : record.image;
+            };
+        }
+    }
+
+    ~Impl()
+    {
+        stop();
+    }
+
+    int getSamplesPerLine() const
+    {
+        return 1 + int(options.doMirror) + std::max(options.jitterCount, 0);
+    }
+
+    void start(int epoch)
+    {
+        stop();
+
+        queue.clear();
+        error = nullptr;
+        done = false;
+        stopping = false;
+        thread = std::thread([this, epoch]() { produce(epoch); });
+    }
+
+    void stop()
+    {
+        if (thread.joinable())
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            condition.notify_all();
+            thread.join();
+        }
+    }
+
+    void produce(int epoch)
+    {
+        try
+        {
+            const int lines = int(table.lines.size());
+            const int step = std::max(options.batchLines, 1);
+            for (int begin = 0; (begin < lines) && !stopping; begin += step)
+            {
+                Batch batch = generate(epoch, begin, std::min(begin + step, lines));
+
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&]() { return stopping || (int(queue.size()) < std::max(options.prefetch, 1)); });
+                if (stopping)
+                {
+                    break;
+                }
+                queue.push_back(std::move(batch));
+                condition.notify_all();
+            }
+        }
+        catch (...)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            error = std::current_exception();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done = true;
+        condition.notify_all();
+    }
+
+    Batch generate(int epoch, int begin, int end)
+    {
+        const int perLine = getSamplesPerLine();
+        const std::uint64_t seed = mix(options.seed ^ mix(std::uint64_t(epoch)));
+
+        std::vector<Batch> faces(end - begin);
+        drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+            const int line = begin + i;
+            const cv::Mat image = loader(line);
+            if (image.empty())
+            {
+                return;
+            }
+
+            auto& jitterer = jitterers.get();
+            const auto& points = table.lines[line].points;
+            for (int j = 0; j < perLine; j++)
+            {
+                const auto mode = (j == 0) ? FaceJitterer::kCrop : ((options.doMirror && (j == 1)) ? FaceJitterer::kMirror : FaceJitterer::kJitter);
+                jitterer->setSeed(mix(seed ^ std::uint64_t(line * perLine + j)));
+                faces[i].push_back((*jitterer)(image, points, mode, options.doNoise));
+                faces[i].back().filename = table.lines[line].filename;
+            }
+        };
+
+        const cv::Range range(0, end - begin);
+        if ((options.threads == 0) || (options.threads == 1))
+        {
+            harness(range);
+        }
+        else
+        {
+            cv::parallel_for_(range, harness, std::max(options.threads, -1));
+        }
+
+        Batch batch;
+        batch.reserve((end - begin) * perLine);
+        for (auto& f : faces)
+        {
+            std::move(f.begin(), f.end(), std::back_inserter(batch));
+        }
+        return batch;
+    }
+
+    const FACE::Table& table;
+    FaceSpecification face;
+    JitterParams params;
+    Options options;
+    Loader loader;
+
+    drishti::core::ThreadLocalParallelResource<FaceJittererPtr> jitterers;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Batch> queue;
+    std::exception_ptr error;
+    bool done = false;
+    std::atomic<bool> stopping{ false };
+    std::thread thread;
+};
+
+FaceJitterSource::FaceJitterSource(const FACE::Table& table, const FaceSpecification& face, const JitterParams& params, const Options& options, Loader loader)
+{
+    m_impl = drishti::core::make_unique<Impl>(table, face, params, options, loader);
+    m_impl->start(0);
+}
+
+FaceJitterSource::~FaceJitterSource() = default;
+
+int FaceJitterSource::getSamplesPerLine() const
+{
+    return m_impl->getSamplesPerLine();
+}
+
+bool FaceJitterSource::next(std::vector<FaceWithLandmarks>& batch)
+{
+    std::unique_lock<std::mutex> lock(m_impl->mutex);
+    m_impl->condition.wait(lock, [&]() { return !m_impl->queue.empty() || m_impl->done; });
+    if (m_impl->queue.empty())
+    {
+        if (m_impl->error)
+        {
+            std::rethrow_exception(m_impl->error);
+        }
+        return false;
+    }
+
+    batch = std::move(m_impl->queue.front());
+    m_impl->queue.pop_front();
+    m_impl->condition.notify_all();
+    return true;
+}
+
+void FaceJitterSource::reset(int epoch)
+{
+    m_impl->start(epoch);
+}
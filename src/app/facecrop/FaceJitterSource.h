@@ -0,0 +1,68 @@
+/*! -*-c++-*-
+  @file   FaceJitterSource.h
+  @author David Hirvonen
+  @brief  Parallel on the fly face jitter (augmentation) source for training.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_facecrop_FaceJitterSource_h__
+#define __drishti_facecrop_FaceJitterSource_h__
+
+#include "FaceJitterer.h"
+#include "FaceSpecification.h"
+#include "JitterParams.h"
+#include "landmarks/FACE.h"
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/*
+ * Generates jittered crops of a FACE::Table in memory, so augmented training sets never have
+ * to be written to disk.  Batches of table lines are jittered in parallel on a background
+ * thread (with one FaceJitterer per worker) and queued, up to prefetch batches ahead of the
+ * consumer, which pulls them with next().  Each line yields its crop (and mirror) followed by
+ * jittered copies, and the RNG is reseeded per sample from (seed, epoch, sample), so the
+ * samples of an epoch don't depend on the thread count or scheduling.
+ */
+
+class FaceJitterSource
+{
+public:
+    using Loader = std::function<cv::Mat(int line)>; // image for a table line (empty : skip)
+
+    struct Options
+    {
+        int threads = -1;       // 0 or 1 : serial, otherwise the cv::parallel_for_ stripe count
+        int batchLines = 64;    // table lines per batch
+        int prefetch = 2;       // batches generated ahead of the consumer
+        int jitterCount = 0;    // jittered copies per line
+        bool doMirror = false;  // add the mirrored crop
+        bool doNoise = false;   // photometric jitter
+        std::uint64_t seed = 0;
+    };
+
+    FaceJitterSource(const FACE::Table& table, const FaceSpecification& face, const JitterParams& params, const Options& options, Loader loader = {});
+    ~FaceJitterSource();
+
+    // Samples per line (crop, mirror and jittered copies):
+    int getSamplesPerLine() const;
+
+    // The next batch of the current epoch (in table order), false at the end of the epoch:
+    bool next(std::vector<FaceWithLandmarks>& batch);
+
+    // Stop the current epoch and start generating the given one:
+    void reset(int epoch);
+
+protected:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+#endif // __drishti_facecrop_FaceJitterSource_h__
@@ -19,6 +19,7 @@
 #include <opencv2/core.hpp>
 
 #include <array>
+#include <cstdint>
 
 using Landmarks = std::vector<cv::Point2f>;
 
@@ -207,6 +208,9 @@ public:
     void setDoPreview(bool value) { m_doPreview = value; }
     bool getDoPreview() const { return m_doPreview; }
 
+    // Restart the random sequence, i.e., for deterministic per sample jitter:
+    void setSeed(std::uint64_t seed) { m_rng = cv::RNG(seed); }
+
 protected:
     static cv::Point2f mean(const Landmarks& landmarks, const std::vector<int>& index);
 
@@ -0,0 +1,114 @@
+/*! -*-c++-*-
+  @file   ImageWriter.cpp
+  @author David Hirvonen
+  @brief  Asynchronous image writer with a bound on the memory held by queued images.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "ImageWriter.h"
+
+#include <opencv2/highgui/highgui.hpp>
+
+#include <algorithm>
+
+ImageWriter::ImageWriter(int threads, std::size_t capacity)
+    : m_capacity(capacity)
+{
+    for (int i = 0; i < std::max(threads, 1); i++)
+    {
+        m_threads.emplace_back([this]() { write(); });
+    }
+}
+
+ImageWriter::~ImageWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_ready.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void ImageWriter::operator()(const std::string& filename, const cv::Mat& image)
+{
+    const std::size_t bytes = image.total() * image.elemSize();
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if ((m_bytes > 0) && (m_bytes + bytes > m_capacity))
+        {
+            m_statistics.blocked++;
+            m_space.wait(lock, [&]() { return (m_bytes == 0) || (m_bytes + bytes <= m_capacity); });
+        }
+
+        m_queue.push_back({ filename, image, bytes });
+        m_bytes += bytes;
+        m_statistics.maxBytes = std::max(m_statistics.maxBytes, m_bytes);
+    }
+    m_ready.notify_one();
+}
+
+void ImageWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_space.wait(lock, [&]() { return m_queue.empty() && (m_active == 0); });
+}
+
+auto ImageWriter::getStatistics() const -> Statistics
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+
+void ImageWriter::write()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_ready.wait(lock, [&]() { return !m_queue.empty() || m_stop; });
+            if (m_queue.empty())
+            {
+                break; // drained
+            }
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_active++;
+        }
+
+        bool status = false;
+        try
+        {
+            status = cv::imwrite(job.filename, job.image);
+        }
+        catch (const cv::Exception&)
+        {
+            status = false;
+        }
+        job.image.release();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_active--;
+            m_bytes -= job.bytes;
+            if (status)
+            {
+                m_statistics.written++;
+            }
+            else
+            {
+                m_statistics.failed++;
+            }
+        }
+        m_space.notify_all();
+    }
+}
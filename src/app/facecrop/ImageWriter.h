@@ -0,0 +1,75 @@
+/*! -*-c++-*-
+  @file   ImageWriter.h
+  @author David Hirvonen
+  @brief  Asynchronous image writer with a bound on the memory held by queued images.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_facecrop_ImageWriter_h__
+#define __drishti_facecrop_ImageWriter_h__
+
+#include <opencv2/core.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Images are encoded and written by a small pool of threads so that the crop workers don't
+ * wait on PNG compression and disk I/O.  The queue holds references to the images (no copy),
+ * so the caller must not modify an image after it is submitted.  A submission blocks while
+ * the queued pixel data exceeds the capacity, a single image larger than the capacity is
+ * still accepted when the queue is empty.  The destructor writes the queued images.
+ */
+
+class ImageWriter
+{
+public:
+    struct Statistics
+    {
+        std::size_t written = 0;  // images written
+        std::size_t failed = 0;   // cv::imwrite() errors
+        std::size_t blocked = 0;  // submissions that waited for the queue to drain
+        std::size_t maxBytes = 0; // queued bytes high water mark
+    };
+
+    ImageWriter(int threads = 2, std::size_t capacity = std::size_t(512) << 20);
+    ~ImageWriter();
+
+    void operator()(const std::string& filename, const cv::Mat& image);
+    void flush(); // wait until the queue is empty
+
+    Statistics getStatistics() const;
+
+protected:
+    struct Job
+    {
+        std::string filename;
+        cv::Mat image;
+        std::size_t bytes;
+    };
+
+    void write();
+
+    std::size_t m_capacity = 0;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready; // queued images or shutdown (writers)
+    std::condition_variable m_space; // released bytes (producers, flush)
+    std::deque<Job> m_queue;
+    std::size_t m_bytes = 0;  // queued + being written
+    std::size_t m_active = 0; // images being written
+    bool m_stop = false;
+    Statistics m_statistics;
+
+    std::vector<std::thread> m_threads;
+};
+
+#endif // __drishti_facecrop_ImageWriter_h__
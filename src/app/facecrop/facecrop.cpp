@@ -64,8 +64,11 @@
 
 #include "FaceSpecification.h"
 #include "FaceJitterer.h"
+#include "ImageWriter.h"
 #include "Pyramid.h"
 
+#include "videoio/ImageHeader.h"
+
 // clang-format off
 #if defined(DRISHTI_USE_IMSHOW)
 #  include "imshow/imshow.h"
@@ -165,24 +168,27 @@ struct FaceJittererMean : public FaceJitterer
 // -----------------------------------------------
 
 using ImageVec = std::vector<cv::Mat>;
+using ImageSizes = std::map<std::string, cv::Size>;
 using FaceJittererMeanPtr = std::unique_ptr<FaceJittererMean>;
-using FaceResourceManager = drishti::core::LazyParallelResource<std::thread::id, FaceJittererMeanPtr>;
-static int saveNegatives(const FACE::Table& table, const std::string& sOutput, int sampleCount, int winSize, int threads, spdlog::logger& logger);
-static int saveInpaintedSamples(const FACE::Table& table, const std::string sBackground, const std::string& sOutput, spdlog::logger& logger);
+using FaceResourceManager = drishti::core::ThreadLocalParallelResource<FaceJittererMeanPtr>;
+static ImageSizes indexImages(FACE::Table& table, int threads, spdlog::logger& logger);
+static int saveNegatives(const FACE::Table& table, const ImageSizes& sizes, const std::string& sOutput, int sampleCount, int winSize, int threads, ImageWriter& writer, spdlog::logger& logger);
+static int saveInpaintedSamples(const FACE::Table& table, const std::string sBackground, const std::string& sOutput, int threads, ImageWriter& writer, spdlog::logger& logger);
 static FaceWithLandmarks computeMeanFace(FaceResourceManager& manager);
 static void saveMeanFace(FaceResourceManager& manager, const FaceSpecification& faceSpec, const std::string& sImage, const std::string& sPoints, spdlog::logger& logger);
 static int saveDefaultConfigs(const std::string& sOutput, spdlog::logger& logger);
-static void save(std::vector<FaceWithLandmarks>& faces, const cv::Rect& roi, const std::string& dir, const std::string& filename, int index);
+static void save(std::vector<FaceWithLandmarks>& faces, const cv::Rect& roi, const std::string& dir, const std::string& filename, int index, ImageWriter& writer);
+static void run(const drishti::core::ParallelHomogeneousLambda& harness, int count, int threads);
 static void previewFaceWithLandmarks(cv::Mat& image, const std::vector<cv::Point2f>& landmarks);
-static GroundTruth parseInput(const std::string& sInput, const std::string& sFormat, const std::string& sDirectoryIn, const std::string& sExtension);
+static GroundTruth parseInput(const std::string& sInput, const std::string& sFormat, const std::string& sDirectoryIn, const std::string& sExtension, const FACE::ParserOptions& options);
 static FACE::Table parseRAW(const std::string& sInput);
 static int standardizeFaceData(const FACE::Table& table, const std::string& sOutput);
 
 #if defined(DRISHTI_BUILD_EOS)
 // Face pose estimation...
 using FaceMeshMapperPtr = std::unique_ptr<drishti::face::FaceMeshMapperEOSLandmark>;
-using FaceMeshMapperResourceManager = drishti::core::LazyParallelResource<std::thread::id, FaceMeshMapperPtr>;
-static void computePose(FACE::Table& table, const std::string& sModel, const std::string& sMapping, std::shared_ptr<spdlog::logger>& logger);
+using FaceMeshMapperResourceManager = drishti::core::ThreadLocalParallelResource<FaceMeshMapperPtr>;
+static void computePose(FACE::Table& table, const ImageSizes& sizes, const std::string& sModel, const std::string& sMapping, int threads, std::shared_ptr<spdlog::logger>& logger);
 #endif // DRISHTI_BUILD_POSE
 
 int gauze_main(int argc, char* argv[])
@@ -207,6 +213,7 @@ int gauze_main(int argc, char* argv[])
     std::string sFaceSpec;
     std::string sJitterIn;
     std::string sLandmarks;
+    std::string sCache;
 
 #if defined(DRISHTI_BUILD_EOS)
     std::string sEosModel;
@@ -216,6 +223,8 @@ int gauze_main(int argc, char* argv[])
     int sampleCount = 0;
     int winSize = 48; // min crop width
     int threads = -1;
+    int writers = 2;
+    int writerMemory = 512; // MB
 
     bool doInpaint = false;
     bool doPreview = false;
@@ -245,6 +254,7 @@ int gauze_main(int argc, char* argv[])
         ("w,window", "Do preview window", cxxopts::value<bool>(doPreview))
         ("0,zero", "Zero jitter model (photometric jitter only)", cxxopts::value<bool>(doPhotometricJitter))
         ("l,landmarks", "Master landmark file (xml format)", cxxopts::value<std::string>(sLandmarks))
+        ("cache", "Parsed landmark cache directory", cxxopts::value<std::string>(sCache))
         ("m,mirror", "Perform jittering", cxxopts::value<bool>(doMirror))
     
 #if defined(DRISHTI_BUILD_EOS)
@@ -261,6 +271,8 @@ int gauze_main(int argc, char* argv[])
     
         // Output parameters:
         ("t,threads", "Thread count", cxxopts::value<int>(threads))
+        ("writers", "Image writer thread count", cxxopts::value<int>(writers))
+        ("writer-memory", "Image writer queue limit (MB)", cxxopts::value<int>(writerMemory))
         ("h,help", "Print help message");
     // clang-format on    
     
@@ -327,6 +339,21 @@ int gauze_main(int argc, char* argv[])
         }
     }
     
+    // ... landmark cache ...
+    if(!sCache.empty())
+    {
+        if(drishti::cli::directory::exists(sCache, ".drishti-facecrop"))
+        {
+            std::string filename = sCache + "/.drishti-facecrop";
+            remove(filename.c_str());
+        }
+        else
+        {
+            logger->error("Specified cache directory {} does not exist or is not writeable", sCache);
+            return 1;
+        }
+    }
+    
     // ### Input
     if(sInput.empty())
     {
@@ -382,7 +409,11 @@ int gauze_main(int argc, char* argv[])
     //:::::::::::::::::::::::::::::::
     //::: Parse input + landmarks :::
     //:::::::::::::::::::::::::::::::
-    GroundTruth gt = parseInput(sInput, sFormat, sDirectory, sExtension);
+    FACE::ParserOptions parserOptions;
+    parserOptions.threads = threads;
+    parserOptions.cache = sCache;
+    
+    GroundTruth gt = parseInput(sInput, sFormat, sDirectory, sExtension, parserOptions);
     auto &table = gt.table;
     
     if(table.lines.empty())
@@ -390,14 +421,13 @@ int gauze_main(int argc, char* argv[])
         logger->error("Error: no images were found, please check input file and (optionally) base directory");
         return -1;
     }
-    else
+    
+    // Read the image headers up front (no decoding), records with unreadable images are dropped:
+    const ImageSizes sizes = indexImages(table, threads, *logger);
+    if(table.lines.empty())
     {
-        // Try simple image read sanity test for user feedback:
-        if(cv::imread(table.lines.front().filename).empty())
-        {
-            logger->error("Error: unable to read input image, please check input file and (optionally) base directory");
-            return -1;
-        }
+        logger->error("Error: unable to read input images, please check input file and (optionally) base directory");
+        return -1;
     }
     
     if(!sStandardize.empty())
@@ -413,12 +443,15 @@ int gauze_main(int argc, char* argv[])
         }
     }
     
+    // Crops are written asynchronously, the queue holds at most writerMemory MB of pixels:
+    ImageWriter writer(writers, static_cast<std::size_t>(std::max(writerMemory, 1)) << 20);
+    
     if(sPositives.empty() && !sNegatives.empty() && !doInpaint)
     {
         // ##########################
         // ### 3) NEGATIVES ONLY  ### >>> Sample random negative windows and quit <<<
         // ##########################
-        return saveNegatives(table, sNegatives, sampleCount, winSize, threads, *logger);
+        return saveNegatives(table, sizes, sNegatives, sampleCount, winSize, threads, writer, *logger);
     }
 
     if(doInpaint && !sBackground.empty() && !sNegatives.empty())
@@ -426,7 +459,7 @@ int gauze_main(int argc, char* argv[])
         // ###################################
         // ### 4) NEGATIVES w/ INPAINTING  ###
         // ###################################
-        return saveInpaintedSamples(table, sBackground, sNegatives, *logger);
+        return saveInpaintedSamples(table, sBackground, sNegatives, threads, writer, *logger);
     }
     
     // ... ELSE STANDARD POSITIVES AND/OR NEGATIVES ...
@@ -434,7 +467,7 @@ int gauze_main(int argc, char* argv[])
 #if defined(DRISHTI_BUILD_EOS)
     if(!(sEosModel.empty() || sEosMapping.empty()))
     {
-        computePose(table, sEosModel, sEosMapping, logger);
+        computePose(table, sizes, sEosModel, sEosMapping, threads, logger);
         
         { // Write name + angle:
             std::string filename;
@@ -512,7 +545,7 @@ int gauze_main(int argc, char* argv[])
                 }
                 else
                 {
-                    for(int i = 1; i < repeat[i]; i++)
+                    for(int j = 1; j < repeat[i]; j++)
                     {
                         faces.push_back((*jitterer)(image, table.lines[i].points, FaceJitterer::kJitter, doPhotometricJitter)); // no mirror
                     }
@@ -521,7 +554,7 @@ int gauze_main(int argc, char* argv[])
                 if(!sPositives.empty())
                 {
                     cv::Rect roi(cv::Point(faceSpec.border, faceSpec.border), faceSpec.size);
-                    save(faces, roi, sPositives, table.lines[i].filename, i);
+                    save(faces, roi, sPositives, table.lines[i].filename, i, writer);
                 }
                 
                 jitterer->updateMean(faces);
@@ -552,16 +585,8 @@ int gauze_main(int argc, char* argv[])
         }
     };
 
-    //harness({0,static_cast<int>(table.lines.size())});
-    
-    if(threads == 1 || threads == 0 || doPreview)
-    {
-        harness({0,static_cast<int>(table.lines.size())});
-    }
-    else
-    {
-        cv::parallel_for_({0,static_cast<int>(table.lines.size())}, harness, std::max(threads, -1));
-    }
+    run(harness, static_cast<int>(table.lines.size()), doPreview ? 1 : threads);
+    writer.flush();
     
     saveMeanFace(manager, faceSpec, sPositives + "/mean.png", sPositives + "/mean", *logger);
     
@@ -594,38 +619,38 @@ int main(int argc, char **argv)
 // ### utility ###
 
 using string_hash::operator "" _hash;
-static GroundTruth parseInput(const std::string &sInput, const std::string &sFormat, const std::string &sDirectoryIn, const std::string &sExtension)
+static GroundTruth parseInput(const std::string &sInput, const std::string &sFormat, const std::string &sDirectoryIn, const std::string &sExtension, const FACE::ParserOptions &options)
 {
     GroundTruth gt;
     switch(string_hash::hash(sFormat))
     {
         case "two"_hash:
             gt.format = TWOFormat;
-            gt.table = parseTWO(sInput);
+            gt.table = parseTWO(sInput, options);
             break;
         case "drishti"_hash:
             gt.format = DRISHTIFormat;
-            gt.table = parseDRISHTI(sInput);
+            gt.table = parseDRISHTI(sInput, options);
             break;
         case "lfw"_hash :
             gt.format = LFWFormat;
-            gt.table = parseLFW(sInput);
+            gt.table = parseLFW(sInput, options);
             break;
         case "muct"_hash  :
             gt.format = MUCTFormat;
-            gt.table = parseMUCT(sInput);
+            gt.table = parseMUCT(sInput, options);
             break;
         case "helen"_hash :
             gt.format = HELENFormat;
-            gt.table = parseHELEN(sInput);
+            gt.table = parseHELEN(sInput, options);
             break;
         case "bioid"_hash :
             gt.format = BIOIDFormat;
-            gt.table = parseBIOID(sInput);
+            gt.table = parseBIOID(sInput, options);
             break;
         case "lfpw"_hash :
             gt.format = LFPWFormat;
-            gt.table = parseLFPW(sInput);
+            gt.table = parseLFPW(sInput, options);
             break;
         case "raw"_hash :
             gt.table = parseRAW(sInput);
@@ -661,6 +686,36 @@ static GroundTruth parseInput(const std::string &sInput, const std::string &sFor
     return gt;
 }
 
+static ImageSizes indexImages(FACE::Table &table, int threads, spdlog::logger &logger)
+{
+    std::vector<std::string> filenames;
+    filenames.reserve(table.lines.size());
+    for(const auto &r : table.lines)
+    {
+        filenames.push_back(r.filename);
+    }
+    std::sort(begin(filenames), end(filenames));
+    filenames.erase(std::unique(begin(filenames), end(filenames)), end(filenames));
+    
+    ImageSizes sizes;
+    for(const auto &h : drishti::videoio::readImageHeaders(filenames, threads, true))
+    {
+        if(h.good())
+        {
+            sizes[h.filename] = h.size;
+        }
+        else
+        {
+            logger.warn("Skipping unreadable image: {}", h.filename);
+        }
+    }
+    
+    auto &lines = table.lines;
+    lines.erase(std::remove_if(begin(lines), end(lines), [&](const FACE::record &r) { return !sizes.count(r.filename); }), end(lines));
+    
+    return sizes;
+}
+
 static FACE::Table parseRAW(const std::string &sInput)
 {
     const auto filenames = drishti::cli::expand(sInput);
@@ -720,7 +775,7 @@ static int standardizeFaceData(const FACE::Table &table, const std::string &sOut
 #include <fstream>
 #include <iostream>
 
-static void computePose(FACE::Table &table, const std::string &sModel, const std::string &sMapping, std::shared_ptr<spdlog::logger> &logger)
+static void computePose(FACE::Table &table, const ImageSizes &sizes, const std::string &sModel, const std::string &sMapping, int threads, std::shared_ptr<spdlog::logger> &logger)
 {
     FaceMeshMapperResourceManager manager = [&]()
     {
@@ -736,16 +791,7 @@ static void computePose(FACE::Table &table, const std::string &sModel, const std
         auto &record = table.lines[i];
         if(record.points.size() == 68)
         {
-            cv::Size size;
-
-            if((record.filename.find(".png") != std::string::npos) || (record.filename.find(".PNG") != std::string::npos))
-            {
-                size = read_png_size(record.filename);
-            }
-            if(size.area() == 0)
-            {
-                size = cv::imread(record.filename).size();
-            }
+            const cv::Size size = sizes.at(record.filename);
             
             cv::Mat dummy;
             dummy.cols = size.width;
@@ -763,7 +809,7 @@ static void computePose(FACE::Table &table, const std::string &sModel, const std
         }
     };
     
-    cv::parallel_for_({0,static_cast<int>(table.lines.size())}, harness, 8);
+    run(harness, static_cast<int>(table.lines.size()), threads);
 }
 #endif 
 
@@ -932,7 +978,7 @@ static void save_bbGtv3(const std::string &sOutput, const std::vector<cv::Rect>
     }
 }
 
-static void save(std::vector<FaceWithLandmarks> &faces, const cv::Rect &roi, const std::string &dir, const std::string &filename, int index)
+static void save(std::vector<FaceWithLandmarks> &faces, const cv::Rect &roi, const std::string &dir, const std::string &filename, int index, ImageWriter &writer)
 {
     for(int i = 0; i < faces.size(); i++)
     {
@@ -942,7 +988,7 @@ static void save(std::vector<FaceWithLandmarks> &faces, const cv::Rect &roi, con
 
         { // save the image file
             std::string sOutput = dir + "/" + ss.str() + "_" + base + ".png";
-            cv::imwrite(sOutput, faces[i].image);
+            writer(sOutput, faces[i].image); // faces are only read after this point
             faces[i].filename = sOutput;
         }
         
@@ -966,6 +1012,19 @@ static void save(std::vector<FaceWithLandmarks> &faces, const cv::Rect &roi, con
     }
 }
 
+// threads: 0 or 1 runs serially, otherwise the cv::parallel_for_ stripe count (-1 == OpenCV default)
+static void run(const drishti::core::ParallelHomogeneousLambda &harness, int count, int threads)
+{
+    if(threads == 1 || threads == 0)
+    {
+        harness({0, count});
+    }
+    else
+    {
+        cv::parallel_for_({0, count}, harness, std::max(threads, -1));
+    }
+}
+
 static void previewFaceWithLandmarks(cv::Mat &image, const std::vector<cv::Point2f> &landmarks)
 {
     for(const auto &p : landmarks)
@@ -974,7 +1033,7 @@ static void previewFaceWithLandmarks(cv::Mat &image, const std::vector<cv::Point
     }
 }
 
-static int saveNegatives(const FACE::Table &table, const std::string &sOutput, int sampleCount, int winSize, int threads, spdlog::logger &logger)
+static int saveNegatives(const FACE::Table &table, const ImageSizes &sizes, const std::string &sOutput, int sampleCount, int winSize, int threads, ImageWriter &writer, spdlog::logger &logger)
 {
     std::vector<int> repeat(table.lines.size(), 1);
     if(sampleCount > 0)
@@ -990,9 +1049,22 @@ static int saveNegatives(const FACE::Table &table, const std::string &sOutput, i
 
     drishti::core::ParallelHomogeneousLambda harness = [&](int i)
     {
-        cv::RNG rng;
+        if(repeat[i] == 0)
+        {
+            return;
+        }
+
+        cv::RNG rng(static_cast<uint64>(i) + 1); // per image: independent of the thread count
         
         const auto &f = table.lines[i].filename;
+        
+        // Skip small images without decoding them:
+        const cv::Size size = sizes.at(f);
+        if(std::min(size.width, size.height) < winSize)
+        {
+            return;
+        }
+        
         cv::Mat negative = cv::imread(f, cv::IMREAD_COLOR);
         
         int minDim = std::min(negative.cols, negative.rows);
@@ -1007,20 +1079,21 @@ static int saveNegatives(const FACE::Table &table, const std::string &sOutput, i
                 logger.info("roi:{},{},{},{}({})", x, y, width, width, winSize);
                 cv::Mat crop = negative(cv::Rect(x, y, width, width));
                 
-                cv::resize(crop, crop, {winSize, winSize}, 0, 0, cv::INTER_AREA);
-                std::string sha1 = get_sha1(crop.ptr<void>(), crop.total());
-                cv::imwrite(sOutput + "/" + sha1 + ".png", crop);
+                cv::Mat sample;
+                cv::resize(crop, sample, {winSize, winSize}, 0, 0, cv::INTER_AREA);
+                std::string sha1 = get_sha1(sample.ptr<void>(), sample.total());
+                writer(sOutput + "/" + sha1 + ".png", sample);
             }
         }
     };
     
-    //cv::parallel_for_({0,static_cast<int>(sInput.size())}, harness, std::max(threads, -1));
-    harness({0,static_cast<int>(repeat.size())});
+    run(harness, static_cast<int>(repeat.size()), threads);
+    writer.flush();
     
     return 0;
 }
 
-static int saveInpaintedSamples(const FACE::Table &table, const std::string sBackground, const std::string &sOutput, spdlog::logger &logger)
+static int saveInpaintedSamples(const FACE::Table &table, const std::string sBackground, const std::string &sOutput, int threads, ImageWriter &writer, spdlog::logger &logger)
 {
     cv::RNG rng;
     
@@ -1036,15 +1109,30 @@ static int saveInpaintedSamples(const FACE::Table &table, const std::string sBac
         }
     }
     
+    if(negatives.empty())
+    {
+        logger.error("Error: unable to read background images");
+        return -1;
+    }
+    
+    // Blend each image once (the table has one line per face):
     std::map< std::string, std::vector<const std::vector<cv::Point2f>*> > landmarks;
+    std::vector<const FACE::record*> images;
     for(const auto &r : table.lines)
     {
-        landmarks[r.filename].push_back(&r.points);
+        auto &faces = landmarks[r.filename];
+        if(faces.empty())
+        {
+            images.push_back(&r);
+        }
+        faces.push_back(&r.points);
     }
     
     drishti::core::ParallelHomogeneousLambda harness = [&](int i)
     {
-        const auto &r = table.lines[i];
+        cv::RNG rng(static_cast<uint64>(i) + 1); // per image: independent of the thread count
+        
+        const auto &r = *images[i];
         cv::Mat image = cv::imread(r.filename, cv::IMREAD_COLOR);
         if(!image.empty())
         {
@@ -1073,13 +1161,13 @@ static int saveInpaintedSamples(const FACE::Table &table, const std::string sBac
             if(!blended.empty())
             {
                 std::string base = drishti::core::basename(r.filename);
-                cv::imwrite(sOutput + "/" + base + "_faceless.png", blended);
+                writer(sOutput + "/" + base + "_faceless.png", blended);
             }
         }
     };
     
-    //cv::parallel_for_({0,static_cast<int>(table.lines.size()}, harness, std::max(threads, -1));
-    harness({0,static_cast<int>(table.lines.size())});
+    run(harness, static_cast<int>(images.size()), threads);
+    writer.flush();
     
     return 0;
 }
@@ -65,7 +65,7 @@ struct record_parser : qi::grammar<Iterator, std::vector<record>(), Skipper>
 };
 }
 
-std::vector<FDDB::record> parseFDDB(const std::string& filename)
+std::vector<FDDB::record> parseFDDB(const std::string& filename, bool verbose)
 {
     std::vector<FDDB::record> result;
 
@@ -79,7 +79,7 @@ std::vector<FDDB::record> parseFDDB(const std::string& filename)
         FDDB::record_parser<decltype(begin)> parser;
 
         bool success = qi::phrase_parse(begin, end, parser, qi::blank, result);
-        if (success)
+        if (success && verbose)
             for (const auto& r : result)
                 std::cout << r << " " << std::endl;
     }
@@ -40,6 +40,6 @@ struct record
 std::ostream& operator<<(std::ostream& os, const record& r);
 }
 
-std::vector<FDDB::record> parseFDDB(const std::string& filename);
+std::vector<FDDB::record> parseFDDB(const std::string& filename, bool verbose = true);
 
 #endif // FDDB_H
@@ -0,0 +1,422 @@
+/*! -*-c++-*-
+  @file   fddbeval.cpp
+  @author David Hirvonen
+  @brief  Parallel face detection speed and accuracy evaluation on FDDB folds.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/LazyParallelResource.h"
+#include "drishti/core/Logger.h"
+#include "drishti/core/Metrics.h"
+#include "drishti/core/Parallel.h"
+#include "drishti/core/make_unique.h"
+#include "drishti/ml/ObjectDetectorACF.h"
+#include "drishti/testlib/drishti_cli.h"
+
+#include <acf/ACF.h>
+
+#include "FDDB.h"
+#include "cxxopts.hpp"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+
+namespace bfs = boost::filesystem;
+
+using LoggerPtr = std::shared_ptr<spdlog::logger>;
+using Clock = std::chrono::high_resolution_clock;
+
+// Detections of one image, each flagged as a true or false positive:
+struct ImageResult
+{
+    bool good = false;
+    std::vector<cv::Rect> objects;
+    std::vector<double> scores;
+    std::vector<bool> matched;
+};
+
+// An annotated face ellipse, rasterized once per image for the overlap tests:
+struct Ellipse
+{
+    Ellipse(const FDDB::record::Ellipse& e)
+    {
+        // major radius, minor radius, angle (radians), center x, center y
+        const cv::RotatedRect ellipse(cv::Point2d(e[3], e[4]), cv::Size2d(e[0] * 2.0, e[1] * 2.0), e[2] * 180.0 / M_PI);
+        bounds = ellipse.boundingRect();
+        if (bounds.area() > 0)
+        {
+            mask = cv::Mat1b::zeros(bounds.size());
+            const cv::RotatedRect local(ellipse.center - cv::Point2f(bounds.tl()), ellipse.size, ellipse.angle);
+            cv::ellipse(mask, local, 255, -1);
+            area = cv::countNonZero(mask);
+        }
+    }
+
+    // Intersection over union of the ellipse and rectangle regions:
+    double overlap(const cv::Rect& rect) const
+    {
+        const cv::Rect roi = rect & bounds;
+        if ((area == 0) || (roi.area() == 0))
+        {
+            return 0.0;
+        }
+
+        const double intersection = cv::countNonZero(mask(roi - bounds.tl()));
+        return intersection / (area + rect.area() - intersection);
+    }
+
+    cv::Rect bounds;
+    cv::Mat1b mask;
+    int area = 0;
+};
+
+/*
+ * Detections are matched to the annotations greedily in decreasing score order, each ellipse
+ * matching at most one detection with an overlap of at least minOverlap.  This is the
+ * "discrete" criterion of the FDDB benchmark, with greedy instead of bipartite matching, so
+ * scores can differ slightly from the official evaluation tool (see writeDetections()).
+ */
+
+static void match(const std::vector<Ellipse>& ellipses, ImageResult& result, double minOverlap)
+{
+    std::vector<int> order(result.objects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return result.scores[a] > result.scores[b]; });
+
+    std::vector<bool> used(ellipses.size(), false);
+    result.matched.assign(result.objects.size(), false);
+    for (auto i : order)
+    {
+        int best = -1;
+        double bestOverlap = minOverlap;
+        for (int j = 0; j < static_cast<int>(ellipses.size()); j++)
+        {
+            if (!used[j])
+            {
+                const double overlap = ellipses[j].overlap(result.objects[i]);
+                if (overlap >= bestOverlap)
+                {
+                    best = j;
+                    bestOverlap = overlap;
+                }
+            }
+        }
+
+        if (best >= 0)
+        {
+            used[best] = true;
+            result.matched[i] = true;
+        }
+    }
+}
+
+// Full resolution BGR image to the transposed, planar, floating point RGB detector input:
+static MatP getDetectionImage(const cv::Mat& image, float scale)
+{
+    cv::Mat Irgb;
+    cv::cvtColor(image, Irgb, cv::COLOR_BGR2RGB);
+    if (scale != 1.f)
+    {
+        cv::resize(Irgb, Irgb, {}, scale, scale, (scale < 1.f) ? cv::INTER_AREA : cv::INTER_LINEAR);
+    }
+
+    cv::Mat It = Irgb.t(), Itf;
+    It.convertTo(Itf, CV_32FC3, 1.0f / 255.f);
+    return MatP(Itf);
+}
+
+static std::vector<FDDB::record> parseFolds(const std::string& sInput);
+static void writeDetections(const std::string& filename, const std::vector<FDDB::record>& records, const std::vector<ImageResult>& results);
+static void report(LoggerPtr& logger, const std::string& name, const drishti::core::Histogram& histogram);
+
+int gauze_main(int argc, char** argv)
+{
+    const auto argumentCount = argc;
+
+    auto logger = drishti::core::Logger::create("drishti-fddb-eval");
+
+    std::string sInput;
+    std::string sImages;
+    std::string sOutput;
+    std::string sDetector;
+    std::string sExtension = ".jpg";
+    int threads = -1;
+    int minWidth = -1; // minimum object width
+    double cascCal = 0.0;
+    double minOverlap = 0.5;
+
+    cxxopts::Options options("drishti-fddb-eval", "Parallel face detector evaluation on FDDB folds");
+
+    // clang-format off
+    options.add_options()
+        ("i,input", "Ellipse list or directory of *ellipseList.txt folds", cxxopts::value<std::string>(sInput))
+        ("d,images", "Image directory (originalPics)", cxxopts::value<std::string>(sImages))
+        ("o,output", "Output directory", cxxopts::value<std::string>(sOutput))
+        ("e,extension", "Image extension", cxxopts::value<std::string>(sExtension))
+        ("D,detector", "Face detector model", cxxopts::value<std::string>(sDetector))
+        ("l,min", "Minimum object width (lower bound)", cxxopts::value<int>(minWidth))
+        ("c,calibration", "Cascade calibration", cxxopts::value<double>(cascCal))
+        ("overlap", "Minimum overlap for a true positive", cxxopts::value<double>(minOverlap))
+        ("t,threads", "Thread count", cxxopts::value<int>(threads))
+        ("h,help", "Print help message");
+    // clang-format on
+
+    options.parse(argc, argv);
+
+    if ((argumentCount <= 1) || options.count("help"))
+    {
+        std::cout << options.help({ "" }) << std::endl;
+        return 0;
+    }
+
+    if (sOutput.empty() || !drishti::cli::directory::exists(sOutput, ".drishti-fddb-eval"))
+    {
+        logger->error("Specified directory {} does not exist or is not writeable", sOutput);
+        return 1;
+    }
+    remove((sOutput + "/.drishti-fddb-eval").c_str());
+
+    if (sDetector.empty() || !drishti::cli::file::exists(sDetector))
+    {
+        logger->error("Specified detector {} does not exist or is not readable", sDetector);
+        return 1;
+    }
+
+    const auto records = parseFolds(sInput);
+    if (records.empty())
+    {
+        logger->error("No FDDB records found in {}", sInput);
+        return 1;
+    }
+
+    // Load the model once, each thread deserializes its own detector (with its own pyramid
+    // and channel buffers) from memory:
+    std::string model;
+    {
+        std::ifstream is(sDetector, std::ios::binary);
+        model.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+
+    using ObjectDetectorPtr = std::unique_ptr<drishti::ml::ObjectDetectorACF>;
+    drishti::core::ThreadLocalParallelResource<ObjectDetectorPtr> manager = [&]() {
+        std::istringstream is(model);
+        auto detector = drishti::core::make_unique<drishti::ml::ObjectDetectorACF>(is, sDetector);
+        if (detector->good())
+        {
+            detector->setDoNonMaximaSuppression(true);
+            if (cascCal != 0.0)
+            {
+                acf::Detector::Modify dflt;
+                dflt.cascThr = { "cascThr", -1.0 };
+                dflt.cascCal = { "cascCal", cascCal };
+                detector->getDetector()->acfModify(dflt);
+            }
+        }
+        return detector;
+    };
+
+    if (!manager.get()->good())
+    {
+        logger->error("Failed to load detector {}", sDetector);
+        return 1;
+    }
+
+    const cv::Size winSize = manager.get()->getWindowSize();
+    const float scale = (minWidth > 0) ? (static_cast<float>(winSize.width) / static_cast<float>(minWidth)) : 1.f;
+
+    drishti::core::Histogram decodeTime, detectionTime;
+    std::vector<ImageResult> results(records.size());
+
+    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+        auto& detector = manager.get();
+        auto& result = results[i];
+
+        const auto tic = Clock::now();
+        cv::Mat image = cv::imread((bfs::path(sImages) / (records[i].filename + sExtension)).string(), cv::IMREAD_COLOR);
+        if (image.empty())
+        {
+            return;
+        }
+
+        const auto toc = Clock::now();
+        (*detector)(getDetectionImage(image, scale), result.objects, &result.scores);
+        for (auto& r : result.objects)
+        {
+            r = cv::Rect(cv::Rect2f(r.x / scale, r.y / scale, r.width / scale, r.height / scale));
+        }
+        detectionTime.record(std::chrono::duration<double>(Clock::now() - toc).count());
+        decodeTime.record(std::chrono::duration<double>(toc - tic).count());
+
+        std::vector<Ellipse> ellipses;
+        for (const auto& e : records[i].ellipses)
+        {
+            ellipses.emplace_back(e.first);
+        }
+        match(ellipses, result, minOverlap);
+        result.good = true;
+    };
+
+    const auto start = Clock::now();
+    const cv::Range range(0, static_cast<int>(records.size()));
+    if ((threads == 0) || (threads == 1))
+    {
+        harness(range);
+    }
+    else
+    {
+        cv::parallel_for_(range, harness, std::max(threads, -1));
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Discrete ROC: true positive rate vs. false positive count over decreasing thresholds
+    std::size_t images = 0, faces = 0;
+    std::vector<std::pair<double, bool>> detections;
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        if (results[i].good)
+        {
+            images++;
+            faces += records[i].ellipses.size();
+            for (std::size_t j = 0; j < results[i].objects.size(); j++)
+            {
+                detections.emplace_back(results[i].scores[j], results[i].matched[j]);
+            }
+        }
+        else
+        {
+            logger->warn("Failed to read {}", records[i].filename);
+        }
+    }
+
+    if (faces == 0)
+    {
+        logger->error("No annotated images could be read from {}", sImages);
+        return 1;
+    }
+
+    std::sort(detections.begin(), detections.end(), [](const std::pair<double, bool>& a, const std::pair<double, bool>& b) {
+        return a.first > b.first;
+    });
+
+    std::ofstream roc(sOutput + "/roc.txt"); // false positives, true positive rate, threshold
+    std::vector<std::size_t> checkpoints{ 50, 100, 500, 1000, 2000 };
+    std::vector<double> rates(checkpoints.size(), 0.0);
+    std::size_t tp = 0, fp = 0;
+    for (std::size_t i = 0; i < detections.size(); i++)
+    {
+        (detections[i].second ? tp : fp)++;
+
+        const double rate = static_cast<double>(tp) / faces;
+        for (std::size_t j = 0; j < checkpoints.size(); j++)
+        {
+            if (fp <= checkpoints[j])
+            {
+                rates[j] = rate;
+            }
+        }
+
+        if (((i + 1) == detections.size()) || (detections[i + 1].first != detections[i].first))
+        {
+            roc << fp << " " << rate << " " << detections[i].first << "\n";
+        }
+    }
+
+    writeDetections(sOutput + "/detections.txt", records, results);
+
+    logger->info("{} images, {} faces, {} detections ({} true positives, {} false positives)", images, faces, detections.size(), tp, fp);
+    for (std::size_t j = 0; j < checkpoints.size(); j++)
+    {
+        logger->info("TPR @ {} FP: {:.4f}", checkpoints[j], rates[j]);
+    }
+    logger->info("{:.3f}s with {} threads: {:.1f} images/sec", seconds, cv::getNumThreads(), images / seconds);
+    report(logger, "decode", decodeTime);
+    report(logger, "detection", detectionTime);
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception";
+    }
+
+    return 0;
+}
+
+// utility:
+
+static std::vector<FDDB::record> parseFolds(const std::string& sInput)
+{
+    std::vector<std::string> filenames;
+    if (bfs::is_directory(sInput))
+    {
+        for (bfs::directory_iterator iter(sInput), end; iter != end; ++iter)
+        {
+            const std::string filename = iter->path().filename().string();
+            if (filename.size() >= 15 && filename.compare(filename.size() - 15, 15, "ellipseList.txt") == 0)
+            {
+                filenames.push_back(iter->path().string());
+            }
+        }
+        std::sort(filenames.begin(), filenames.end());
+    }
+    else if (drishti::cli::file::exists(sInput))
+    {
+        filenames.push_back(sInput);
+    }
+
+    std::vector<FDDB::record> records;
+    for (const auto& filename : filenames)
+    {
+        const auto fold = parseFDDB(filename, false);
+        records.insert(records.end(), fold.begin(), fold.end());
+    }
+    return records;
+}
+
+// Detections in the FDDB submission format (filename, count, "left top width height score"):
+static void writeDetections(const std::string& filename, const std::vector<FDDB::record>& records, const std::vector<ImageResult>& results)
+{
+    std::ofstream os(filename);
+    for (std::size_t i = 0; i < records.size(); i++)
+    {
+        const auto& result = results[i];
+        os << records[i].filename << "\n"
+           << result.objects.size() << "\n";
+        for (std::size_t j = 0; j < result.objects.size(); j++)
+        {
+            const auto& r = result.objects[j];
+            os << r.x << " " << r.y << " " << r.width << " " << r.height << " " << result.scores[j] << "\n";
+        }
+    }
+}
+
+static void report(LoggerPtr& logger, const std::string& name, const drishti::core::Histogram& histogram)
+{
+    const auto s = histogram.getSummary();
+    logger->info("{} (ms): mean {:.3f} p50 {:.3f} p95 {:.3f} p99 {:.3f} max {:.3f}", name, s.mean * 1e3, s.p50 * 1e3, s.p95 * 1e3, s.p99 * 1e3, s.max * 1e3);
+}
@@ -0,0 +1,376 @@
+/*! -*-c++-*-
+  @file   hci-batch.cpp
+  @author David Hirvonen
+  @brief  Headless batch FaceFinder processing with independent offscreen OpenGL contexts.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+// Local includes:
+#include "drishti/core/drishti_stdlib_string.h" // android workaround
+#include "drishti/core/Logger.h"
+#include "drishti/core/ThreadPool.h"
+#include "drishti/hci/FaceFinder.h"
+#include "drishti/hci/FaceMonitor.h"
+#include "drishti/testlib/drishti_cli.h"
+#include "drishti/face/FaceDetectorFactoryJson.h"
+
+#include "videoio/VideoSourceCV.h"
+
+#include "aglet/GLContext.h"
+
+// Package includes:
+#include "cxxopts.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+#include <spdlog/fmt/ostr.h>
+
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+// clang-format off
+#ifdef ANDROID
+#  define TEXTURE_FORMAT GL_RGBA
+#else
+#  define TEXTURE_FORMAT GL_BGRA
+#endif
+// clang-format on
+
+using LoggerPtr = std::shared_ptr<spdlog::logger>;
+
+static bool checkModel(LoggerPtr& logger, const std::string& sModel, const std::string& description);
+
+// Collect the face positions reported for each processed frame.  Results are reported with the
+// capture time of their frame, pipelineDepth + readback frames after it was submitted, so rows
+// are labelled from the capture times registered by submit():
+struct FaceMonitorRecorder : public drishti::hci::FaceMonitor
+{
+    virtual Request request(const Faces& faces, const TimePoint& timeStamp)
+    {
+        const auto iter = frames.find(timeStamp);
+        if (iter == frames.end())
+        {
+            return {}; // flush frame
+        }
+
+        for (const auto& f : faces)
+        {
+            const cv::Point3f xyz = f.eyesCenter.has ? (*f.eyesCenter) : cv::Point3f();
+            ss << video << "," << iter->second << "," << f.roi.x << "," << f.roi.y << "," << f.roi.width << "," << f.roi.height
+               << "," << xyz.x << "," << xyz.y << "," << xyz.z << "\n";
+        }
+        frames.erase(frames.begin(), std::next(iter));
+        return {};
+    }
+
+    virtual void grab(const std::vector<FaceImage>& frames, bool isInitialized) {}
+
+    // Capture time of a submitted frame:
+    TimePoint submit(std::size_t frame)
+    {
+        const TimePoint time = HighResolutionClock::now();
+        frames[time] = frame;
+        return time;
+    }
+
+    std::string video;
+    std::map<TimePoint, std::size_t> frames; // capture time -> frame index (not yet reported)
+    std::stringstream ss;
+};
+
+// Process a single video with a FaceFinder bound to the current (offscreen) context:
+static std::size_t process(const std::string& sInput, drishti::hci::FaceFinder::Settings settings, std::shared_ptr<drishti::face::FaceDetectorFactory>& factory, float fx, std::ostream& os, LoggerPtr& logger)
+{
+    auto video = drishti::videoio::VideoSourceCV::create(sInput);
+    if (!video)
+    {
+        logger->error("Unable to open {}", sInput);
+        return 0;
+    }
+    video->setOutputFormat(drishti::videoio::VideoSourceCV::BGRA);
+
+    std::size_t counter = 0;
+    auto frame = (*video)(counter);
+    if (frame.image.empty())
+    {
+        logger->info("No frames available in video {}", sInput);
+        return 0;
+    }
+
+    { // Create a sensor specification
+        const float f = (fx == 0.f) ? frame.image.cols : fx; // use a sensible default guess
+        const cv::Point2f p(frame.image.cols / 2, frame.image.rows / 2);
+        drishti::sensor::SensorModel::Intrinsic params(p, f, frame.image.size());
+        settings.sensor = std::make_shared<drishti::sensor::SensorModel>(params);
+    }
+
+    std::unique_ptr<drishti::hci::FaceFinder> detector;
+    {
+        // Model loading through the shared factory is serialized:
+        static std::mutex mutex;
+        std::lock_guard<std::mutex> lock(mutex);
+        detector = drishti::hci::FaceFinder::create(factory, settings, nullptr);
+    }
+
+    FaceMonitorRecorder monitor;
+    monitor.video = sInput;
+    detector->registerFaceMonitorCallback(&monitor);
+
+    const cv::Size frameSize = frame.image.size();
+    cv::Mat last;
+    for (; !frame.image.empty() && (frame.image.size() == frameSize); frame = (*video)(++counter))
+    {
+        if (frame.image.channels() == 3)
+        {
+            cv::cvtColor(frame.image, frame.image, cv::COLOR_BGR2BGRA);
+        }
+        CV_Assert(frame.image.channels() == 4);
+
+        const auto captureTime = monitor.submit(counter);
+        (*detector)({ { frame.cols(), frame.rows() }, frame.image.ptr(), true, 0, TEXTURE_FORMAT }, captureTime);
+        last = frame.image;
+    }
+
+    // Drain the pipeline with copies of the last frame (which aren't recorded) until the frames
+    // in flight have been reported:
+    const int latency = settings.pipelineDepth + settings.readbackBuffers + settings.frameDelay;
+    for (int i = 0; !last.empty() && !monitor.frames.empty() && (i < latency); i++)
+    {
+        (*detector)({ { last.cols, last.rows }, last.ptr(), true, 0, TEXTURE_FORMAT }, drishti::hci::FaceMonitor::HighResolutionClock::now());
+    }
+
+    os << monitor.ss.str();
+    return counter;
+}
+
+int gauze_main(int argc, char** argv)
+{
+    const auto argumentCount = argc;
+
+    // Instantiate line logger:
+    auto logger = drishti::core::Logger::create("drishti-hci-batch");
+
+    // ############################
+    // ### Command line parsing ###
+    // ############################
+
+    std::string sInput, sOutput, sFactory;
+    int contexts = 1;
+    float cascCal = 0.f;
+    float scale = 1.f;
+    float fx = 0.f;
+    float minZ = 0.1f, maxZ = 2.f;
+    bool doInner = false;
+
+    // Create FaceDetectorFactory (default file based):
+    auto factory = std::make_shared<drishti::face::FaceDetectorFactory>();
+
+    cxxopts::Options options("drishti-hci-batch", "Headless batch FaceFinder processing of video sequences.");
+
+    // clang-format off
+    options.add_options()
+        ("i,input", "Input video or list of videos (.txt)", cxxopts::value<std::string>(sInput))
+        ("o,output", "Output directory", cxxopts::value<std::string>(sOutput))
+        ("t,threads", "Number of independent offscreen contexts", cxxopts::value<int>(contexts))
+
+        // Detection and regression parameters:
+        ("c,calibration", "Cascade calibration", cxxopts::value<float>(cascCal))
+        ("s,scale", "Scale term for detection->regression mapping", cxxopts::value<float>(scale))
+        ("f,focal-length", "Focal length in pixels",cxxopts::value<float>(fx))
+        ("min", "Nearest distance in meters", cxxopts::value<float>(minZ))
+        ("max", "Farthest distance in meters", cxxopts::value<float>(maxZ))
+
+        // Clasifier and regressor models:
+        ("D,detector", "Face detector model", cxxopts::value<std::string>(factory->sFaceDetector))
+        ("M,mean", "Face detector mean", cxxopts::value<std::string>(factory->sFaceDetectorMean))
+        ("R,regressor", "Face regressor", cxxopts::value<std::string>(factory->sFaceRegressor))
+        ("E,eye", "Eye model", cxxopts::value<std::string>(factory->sEyeRegressor))
+
+        // ... factory can be used instead of D,M,R,E
+        ("F,factory", "Factory (json model zoo)", cxxopts::value<std::string>(sFactory))
+        ("inner", "Inner face landmakrs", cxxopts::value<bool>(doInner))
+
+        ("h,help", "Print help message");
+    // clang-format on
+
+    options.parse(argc, argv);
+
+    if ((argumentCount <= 1) || options.count("help"))
+    {
+        std::cout << options.help({ "" }) << std::endl;
+        return 0;
+    }
+
+    // ############################################
+    // ### Command line argument error checking ###
+    // ############################################
+
+    // ### Directory
+    if (sOutput.empty())
+    {
+        logger->error("Must specify output directory");
+        return 1;
+    }
+
+    if (drishti::cli::directory::exists(sOutput, ".drishti-hci-batch"))
+    {
+        std::string filename = sOutput + "/.drishti-hci-batch";
+        remove(filename.c_str());
+    }
+    else
+    {
+        logger->error("Specified directory {} does not exist or is not writeable", sOutput);
+        return 1;
+    }
+
+    // ### Input
+    if (sInput.empty())
+    {
+        logger->error("Must specify input video or list of videos");
+        return 1;
+    }
+
+    const auto filenames = drishti::cli::expand(sInput);
+    if (filenames.empty())
+    {
+        logger->error("No input videos specified");
+        return 1;
+    }
+
+    if (maxZ < minZ)
+    {
+        logger->error("max distance must be > min distance");
+        return 1;
+    }
+
+    if (!sFactory.empty())
+    {
+        factory = std::make_shared<drishti::face::FaceDetectorFactoryJson>(sFactory);
+    }
+    factory->inner = doInner;
+
+    // Check for valid models
+    std::vector<std::pair<std::string, std::string>> config{
+        { factory->sFaceDetector, "face-detector" },
+        { factory->sFaceDetectorMean, "face-detector-mean" },
+        { factory->sFaceRegressor, "face-regressor" },
+        { factory->sEyeRegressor, "eye-regressor" }
+    };
+
+    for (const auto& c : config)
+    {
+        if (checkModel(logger, c.first, c.second))
+        {
+            return 1;
+        }
+    }
+
+    // Create configuration (no rendering):
+    drishti::hci::FaceFinder::Settings settings;
+    settings.logger = drishti::core::Logger::create("drishti-hci-batch-finder");
+    settings.logger->set_level(spdlog::level::err);
+    settings.outputOrientation = 0;
+    settings.frameDelay = 2;
+    settings.doLandmarks = true;
+    settings.doFlow = false;
+    settings.doBlobs = false;
+    settings.threads = drishti::core::Executor::getInstance(); // shared by all contexts
+    settings.faceFinderInterval = 0.f;
+    settings.regressorCropScale = scale;
+    settings.acfCalibration = cascCal;
+    settings.renderFaces = false;
+    settings.renderPupils = false;
+    settings.renderCorners = false;
+    settings.minDetectionDistance = minZ;
+    settings.maxDetectionDistance = maxZ;
+    settings.doSingleFace = true;
+
+    std::ofstream ofs(sOutput + "/faces.csv");
+    if (!ofs)
+    {
+        logger->error("Unable to open {}/faces.csv for writing", sOutput);
+        return 1;
+    }
+    ofs << "video,frame,x,y,width,height,X,Y,Z\n";
+
+    // Each worker owns an offscreen OpenGL context (created without a window title)
+    // and processes the next available video from the list:
+    std::mutex mutex;
+    std::atomic<std::size_t> next{ 0 };
+    auto worker = [&]() {
+        auto opengl = aglet::GLContext::create(aglet::GLContext::kAuto, "", 640, 480);
+#if defined(_WIN32) || defined(_WIN64)
+        CV_Assert(!glewInit());
+#endif
+        (*opengl)(); // activate context
+
+        std::size_t index = 0;
+        while ((index = next++) < filenames.size())
+        {
+            std::stringstream ss;
+            const auto frames = process(filenames[index], settings, factory, fx, ss, logger);
+            logger->info("{}: {} frames", filenames[index], frames);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            ofs << ss.str();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < std::max(contexts, 1); i++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception";
+    }
+
+    return 0;
+}
+
+// utility:
+
+static bool checkModel(LoggerPtr& logger, const std::string& sModel, const std::string& description)
+{
+    if (sModel.empty())
+    {
+        logger->error("Must specify valid model {}", sModel);
+        return 1;
+    }
+    if (!drishti::cli::file::exists(sModel))
+    {
+        logger->error("Specified file {} does not exist or is not readable", sModel);
+        return 1;
+    }
+    return 0;
+}
@@ -12,6 +12,7 @@
 #include "drishti/core/drishti_stdlib_string.h" // android workaround
 #include "drishti/core/Semaphore.h"
 #include "drishti/core/Logger.h"
+#include "drishti/core/Metrics.h"
 #include "drishti/hci/FaceFinderPainter.h"
 #include "drishti/hci/FaceMonitor.h"
 #include "drishti/testlib/drishti_cli.h"
@@ -21,6 +22,8 @@
 #include "ogles_gpgpu/common/proc/swizzle.h"
 
 #include "videoio/VideoSourceCV.h"
+#include "videoio/VideoSourcePrefetch.h"
+#include "videoio/VideoSinkAsync.h"
 #include "videoio/VideoSinkCV.h"
 
 #include "aglet/GLContext.h"
@@ -47,6 +50,10 @@ using string_hash::operator"" _hash;
 
 #include <opencv2/highgui.hpp>
 
+#include <fstream>
+#include <sstream>
+#include <thread>
+
 using LoggerPtr = std::shared_ptr<spdlog::logger>;
 
 static void* void_ptr(const cv::Mat& image)
@@ -57,6 +64,34 @@ static void* void_ptr(const cv::Mat& image)
 static bool checkModel(LoggerPtr& logger, const std::string& sModel, const std::string& description);
 static ogles_gpgpu::SwizzleProc::SwizzleKind getSwizzleKind(const std::string &sSwizzle);
 
+// Headless throughput measurement (see --benchmark):
+struct BenchmarkOptions
+{
+    int frames = 300;  // measured frames per pipeline
+    int warmup = 30;   // frames processed before the metrics are reset
+    int cache = 100;   // decoded frames held in memory and replayed
+    float fps = 0.f;   // replay rate (0 : as fast as possible)
+    std::string swizzle;
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    std::size_t frames = 0;
+    double seconds = 0.0;
+    drishti::hci::FaceFinder::BackpressureCounters backpressure;
+    drishti::core::Metrics::Snapshot snapshot;
+    std::string metrics; // JSON
+};
+
+static int benchmark(
+    LoggerPtr& logger,
+    std::shared_ptr<drishti::face::FaceDetectorFactory>& factory,
+    const drishti::hci::FaceFinder::Settings& settings,
+    drishti::videoio::VideoSourceCV& video,
+    const BenchmarkOptions& config,
+    const std::string& sOutput);
+
 // Simple FaceMonitor class to report face detection results over time.
 struct FaceMonitorLogger : public drishti::hci::FaceMonitor
 {
@@ -140,7 +175,9 @@ int gauze_main(int argc, char** argv)
     bool doWindow = false;
     bool doMovie = false;
     bool doDebug = false;
+    bool doBenchmark = false;
     int loops = 0;
+    int prefetch = 0;
 
     std::string sInput, sOutput, sSwizzle = "rgba";
 
@@ -159,6 +196,8 @@ int gauze_main(int argc, char** argv)
 
     float minZ = 0.1f, maxZ = 2.f;
 
+    BenchmarkOptions benchmarkOptions;
+
     // clang-format off
     options.add_options()
         ("i,input", "Input file", cxxopts::value<std::string>(sInput))
@@ -172,6 +211,7 @@ int gauze_main(int argc, char** argv)
         ("debug", "Provide debugging annotations", cxxopts::value<bool>(doDebug))
 #endif
         ("l,loops", "Loop the input video", cxxopts::value<int>(loops))
+        ("prefetch", "Frames decoded ahead of processing (0 : synchronous)", cxxopts::value<int>(prefetch))
     
         // Generate a quicktime movie:
         ("m,movie", "Output quicktime movie", cxxopts::value<bool>(doMovie))
@@ -192,6 +232,13 @@ int gauze_main(int argc, char** argv)
         // ... factory can be used instead of D,M,R,E
         ("F,factory", "Factory (json model zoo)", cxxopts::value<std::string>(sFactory))
         ("inner", "Inner face landmakrs", cxxopts::value<bool>(doInner))
+
+        // Headless throughput measurement (optimized vs simple pipeline):
+        ("benchmark", "Replay the input offscreen and report throughput", cxxopts::value<bool>(doBenchmark))
+        ("benchmark-frames", "Measured frames per pipeline", cxxopts::value<int>(benchmarkOptions.frames))
+        ("benchmark-warmup", "Frames processed before measurement", cxxopts::value<int>(benchmarkOptions.warmup))
+        ("benchmark-cache", "Decoded frames replayed from memory", cxxopts::value<int>(benchmarkOptions.cache))
+        ("benchmark-fps", "Replay rate (0 : as fast as possible)", cxxopts::value<float>(benchmarkOptions.fps))
     
         ("h,help", "Print help message");
     // clang-format on
@@ -244,6 +291,21 @@ int gauze_main(int argc, char** argv)
     }
     factory->inner = doInner;
 
+    if (doBenchmark)
+    {
+        if ((benchmarkOptions.frames <= 0) || (benchmarkOptions.warmup < 0) || (benchmarkOptions.cache <= 0) || (benchmarkOptions.fps < 0.f))
+        {
+            logger->error("Invalid benchmark parameters");
+            return 1;
+        }
+
+        // Rendering and encoding would be part of the measurement:
+        doWindow = false;
+        doMovie = false;
+        prefetch = 0;
+        benchmarkOptions.swizzle = sSwizzle;
+    }
+
     // Check for valid models
     std::vector<std::pair<std::string, std::string>> config{
         { factory->sFaceDetector, "face-detector" },
@@ -275,6 +337,10 @@ int gauze_main(int argc, char** argv)
 
     auto video = drishti::videoio::VideoSourceCV::create(sInput);
     video->setOutputFormat(drishti::videoio::VideoSourceCV::ARGB); // be explicit, fail on error
+    if (prefetch > 0)
+    {
+        video = std::make_shared<drishti::videoio::VideoSourcePrefetch>(video, prefetch);
+    }
 
     // Retrieve first frame to configure sensor parameters:
     std::size_t counter = 0;
@@ -304,7 +370,7 @@ int gauze_main(int argc, char** argv)
     settings.doLandmarks = true;
     settings.doFlow = false;
     settings.doBlobs = false;
-    settings.threads = std::make_shared<tp::ThreadPool<>>();
+    settings.threads = drishti::core::Executor::getInstance();
     settings.outputOrientation = 0;
     settings.faceFinderInterval = 0.f;
     settings.regressorCropScale = scale;
@@ -332,6 +398,11 @@ int gauze_main(int argc, char** argv)
 
     (*opengl)(); // activate context
 
+    if (doBenchmark)
+    {
+        return benchmark(logger, factory, settings, *video, benchmarkOptions, sOutput);
+    }
+
     // Allocate the detector and configure the display properties
     auto detector = drishti::hci::FaceFinderPainter::create(factory, settings, nullptr);
     detector->setLetterboxHeight(1.0);         // *** rendering ***
@@ -356,12 +427,14 @@ int gauze_main(int argc, char** argv)
         remove(filename.c_str());
     }
 
-    std::shared_ptr<drishti::videoio::VideoSinkCV> sink;
+    std::shared_ptr<drishti::videoio::VideoSinkAsync> sink;
     if (doMovie)
     {
-        sink = drishti::videoio::VideoSinkCV::create(filename, ".mov");
-        if (sink)
+        auto movie = drishti::videoio::VideoSinkCV::create(filename, ".mov");
+        if (movie)
         {
+            // Encode on a dedicated thread so the render loop only pays for a copy:
+            sink = std::make_shared<drishti::videoio::VideoSinkAsync>(movie);
             sink->setProperties({ frame.cols(), frame.rows() });
             sink->begin();
         }
@@ -470,10 +543,172 @@ int gauze_main(int argc, char** argv)
         drishti::core::Semaphore s(0);
         sink->end([&] { s.signal(); });
         s.wait();
+
+        const auto stats = sink->getStatistics();
+        logger->info("movie: {} frames encoded, {} dropped, {} blocked ({}s)", stats.encoded, stats.dropped, stats.blocked, stats.blockedTime);
     }
     return 0;
 }
 
+// benchmark:
+
+static std::vector<cv::Mat> loadFrames(drishti::videoio::VideoSourceCV& video, int count)
+{
+    std::vector<cv::Mat> frames;
+    for (int i = 0; i < count; i++)
+    {
+        auto frame = video(i);
+        if (frame.image.empty())
+        {
+            break;
+        }
+
+        if (frame.image.channels() == 3)
+        {
+            cv::cvtColor(frame.image, frame.image, cv::COLOR_BGR2BGRA);
+        }
+
+        CV_Assert(frame.image.channels() == 4);
+        if (!frames.empty() && (frame.image.size() != frames.front().size()))
+        {
+            break;
+        }
+
+        frames.push_back(frame.image.clone()); // detach from the decoder buffer
+    }
+    return frames;
+}
+
+static BenchmarkResult benchmark(
+    std::shared_ptr<drishti::face::FaceDetectorFactory>& factory,
+    drishti::hci::FaceFinder::Settings settings,
+    const std::vector<cv::Mat>& frames,
+    const BenchmarkOptions& config)
+{
+    using Clock = drishti::hci::FaceFinder::HighResolutionClock;
+
+    auto& metrics = drishti::core::Metrics::getInstance();
+
+    // Each pipeline gets its own detector and input textures, so no GL state is shared between runs:
+    auto detector = drishti::hci::FaceFinderPainter::create(factory, settings, nullptr);
+
+    ogles_gpgpu::VideoSource source;
+    ogles_gpgpu::SwizzleProc swizzle(getSwizzleKind(config.swizzle));
+    source.set(&swizzle);
+
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config.fps > 0.f ? (1.0 / config.fps) : 0.0));
+
+    const auto process = [&](int i, const Clock::time_point& captureTime) {
+        const cv::Mat& image = frames[i % frames.size()];
+        source({ { image.cols, image.rows }, void_ptr(image), true, 0, TEXTURE_FORMAT });
+        (*detector)({ { image.cols, image.rows }, nullptr, false, swizzle.getOutputTexId(), TEXTURE_FORMAT }, captureTime);
+    };
+
+    for (int i = 0; i < config.warmup; i++)
+    {
+        process(i, Clock::now());
+    }
+    glFinish();
+
+    metrics.reset(); // exclude model loading, shader compilation and warmup
+
+    const auto start = Clock::now();
+    for (int i = 0; i < config.frames; i++)
+    {
+        // At a fixed rate the capture time is the scheduled time, so latency includes any lag:
+        auto captureTime = Clock::now();
+        if (config.fps > 0.f)
+        {
+            captureTime = start + period * i;
+            std::this_thread::sleep_until(captureTime);
+        }
+        process(config.warmup + i, captureTime);
+    }
+    glFinish();
+    const auto stop = Clock::now();
+
+    BenchmarkResult result;
+    result.name = settings.doOptimizedPipeline ? "optimized" : "simple";
+    result.frames = static_cast<std::size_t>(config.frames);
+    result.seconds = std::chrono::duration<double>(stop - start).count();
+    result.backpressure = detector->getBackpressureCounters();
+    result.snapshot = metrics.getSnapshot();
+
+    std::stringstream ss;
+    metrics.dump(ss);
+    result.metrics = ss.str();
+
+    return result;
+}
+
+static void report(LoggerPtr& logger, const BenchmarkResult& result)
+{
+    const double fps = (result.seconds > 0.0) ? (result.frames / result.seconds) : 0.0;
+    logger->info("{}: {} frames in {:.3f}s = {:.1f} fps ({})", result.name, result.frames, result.seconds, fps, result.backpressure);
+    logger->info("  {:<16} {:>8} {:>10} {:>10} {:>10}", "stage (ms)", "count", "p50", "p95", "p99");
+    for (const auto& h : result.snapshot.histograms)
+    {
+        if (h.count > 0)
+        {
+            logger->info("  {:<16} {:>8} {:>10.3f} {:>10.3f} {:>10.3f}", h.name, h.count, h.p50 * 1e3, h.p95 * 1e3, h.p99 * 1e3);
+        }
+    }
+}
+
+static int benchmark(
+    LoggerPtr& logger,
+    std::shared_ptr<drishti::face::FaceDetectorFactory>& factory,
+    const drishti::hci::FaceFinder::Settings& settings,
+    drishti::videoio::VideoSourceCV& video,
+    const BenchmarkOptions& config,
+    const std::string& sOutput)
+{
+    // Decode up front so the measurement isn't bound by the video decoder:
+    const auto frames = loadFrames(video, config.cache);
+    if (frames.empty())
+    {
+        logger->error("No frames available for benchmark");
+        return 1;
+    }
+    logger->info("benchmark: {} frames ({}x{}) replayed at {}", frames.size(), frames.front().cols, frames.front().rows, (config.fps > 0.f) ? fmt::format("{} fps", config.fps) : "full rate");
+
+    std::vector<BenchmarkResult> results;
+    for (bool doOptimizedPipeline : { true, false })
+    {
+        auto copy = settings;
+        copy.doOptimizedPipeline = doOptimizedPipeline;
+        copy.doGpuTimers = true; // populate the gpu_* stages
+        results.push_back(benchmark(factory, copy, frames, config));
+        report(logger, results.back());
+    }
+
+    const std::string filename = sOutput + "/benchmark.json";
+    std::ofstream os(filename);
+    if (!os)
+    {
+        logger->error("Unable to write {}", filename);
+        return 1;
+    }
+
+    os << "{\n";
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        const auto& r = results[i];
+        const auto& b = r.backpressure;
+        os << "\"" << r.name << "\": { ";
+        os << "\"frames\": " << r.frames << ", ";
+        os << "\"seconds\": " << r.seconds << ", ";
+        os << "\"fps\": " << (r.seconds > 0.0 ? (r.frames / r.seconds) : 0.0) << ", ";
+        os << "\"backpressure\": { \"on_time\": " << b.onTime << ", \"blocked\": " << b.blocked << ", \"dropped\": " << b.dropped;
+        os << ", \"skipped\": " << b.skipped << ", \"degraded\": " << b.degraded << " }, ";
+        os << "\"metrics\": " << r.metrics << " }" << ((i + 1) < results.size() ? "," : "") << "\n";
+    }
+    os << "}\n";
+
+    logger->info("benchmark: wrote {}", filename);
+    return 0;
+}
+
 // utility:
 
 static bool checkModel(LoggerPtr& logger, const std::string& sModel, const std::string& description)
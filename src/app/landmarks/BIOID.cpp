@@ -9,6 +9,7 @@
  */
 
 #include "landmarks/BIOID.h"
+#include "landmarks/TableCache.h"
 
 #include "drishti/core/Line.h"
 #include "drishti/core/string_utils.h"
@@ -93,17 +94,16 @@ DRISHTI_END_NAMESPACE(BIOID)
 
 void parseBIOID(const std::string& filename, BIOID::record& output)
 {
-    std::ifstream is(filename);
-    if (is.is_open())
+    const std::string buffer = FACE::readFile(filename);
+    if (!buffer.empty())
     {
-        is.unsetf(std::ios::skipws);
-        boost::spirit::istream_iterator begin(is), end;
-        FACE::bioid_parser<decltype(begin)> parser;
+        const char *begin = buffer.data(), *end = begin + buffer.size();
+        FACE::bioid_parser<const char*> parser;
         bool success = qi::phrase_parse(begin, end, parser, qi::blank, output);
     }
 }
 
-FACE::Table parseBIOID(const std::string& filename)
+FACE::Table parseBIOID(const std::string& filename, const FACE::ParserOptions& options)
 {
     using drishti::core::Line;
 
@@ -113,39 +113,40 @@ FACE::Table parseBIOID(const std::string& filename)
     table.nose = { 15, 16, 14 };
     table.brow = { 5, 6 };
 
-    std::vector<std::pair<std::string, std::string>> filenames;
+    FACE::parseCached(filename, "bioid", options, table, [&](const std::string& source, FACE::Table& result) {
+        std::ifstream file(source.c_str());
+        if (!file.is_open())
+        {
+            return false;
+        }
 
-    std::vector<std::string> lines;
-    std::ifstream file(filename.c_str());
-    if (file.is_open())
-    {
+        std::vector<std::pair<std::string, std::string>> filenames;
+
+        std::vector<std::string> lines;
         std::copy(std::istream_iterator<Line>(file), std::istream_iterator<Line>(), std::back_inserter(lines));
         for (auto& l : lines)
         {
             std::stringstream iss(l);
             std::vector<std::string> tokens;
             std::copy(std::istream_iterator<std::string>(iss), std::istream_iterator<std::string>(), std::back_inserter(tokens));
-
-            //for(auto &t : tokens) std::cout << t << " "; std::cout << std::endl;
-
             if (tokens.size() == 2)
             {
-                BIOID::record record;
-
-                //std::cout << tokens[1] << std::endl;
-                parseBIOID(tokens[1], record);
-
-                //for(auto &p : record.points) std::cout << p << std::endl;
-
-                FACE::record record_;
-                record_.filename = tokens[0];
-                record_.points = record.points;
-                table.lines.push_back(record_);
+                filenames.emplace_back(tokens[0], tokens[1]);
             }
         }
-    }
 
-    if (table.lines.front().points.size() == 68)
+        // One annotation file per image, these are read in parallel:
+        result.lines.resize(filenames.size());
+        FACE::parallelize(static_cast<int>(filenames.size()), options, [&](int i) {
+            BIOID::record record;
+            parseBIOID(filenames[i].second, record);
+            result.lines[i].filename = filenames[i].first;
+            result.lines[i].points = record.points;
+        });
+        return true;
+    });
+
+    if (!table.lines.empty() && (table.lines.front().points.size() == 68))
     {
         table.browR = { 17, 18, 19, 20, 21 };
         table.browL = { 22, 23, 24, 25, 26 };
@@ -15,6 +15,6 @@
 
 #include <fstream>
 
-FACE::Table parseBIOID(const std::string& filename);
+FACE::Table parseBIOID(const std::string& filename, const FACE::ParserOptions& options = {});
 
 #endif // __drishti_landmarks_BIOID_h__
@@ -9,6 +9,7 @@
 */
 
 #include "landmarks/DRISHTI.h"
+#include "landmarks/TableCache.h"
 #include "drishti/core/Line.h"
 
 // ====== DRISHTI =======
@@ -52,7 +53,7 @@ void parseDRISHTI(const std::string& filename, FACE::record& output)
     }
 }
 
-FACE::Table parseDRISHTI(const std::string& filename)
+FACE::Table parseDRISHTI(const std::string& filename, const FACE::ParserOptions& options)
 {
     using drishti::core::Line;
 
@@ -64,40 +65,37 @@ FACE::Table parseDRISHTI(const std::string& filename)
     table.nose = { 2 };
     table.mouth = { 3, 4 };
 
-    std::vector<std::pair<std::string, std::string>> filenames;
+    FACE::parseCached(filename, "drishti", options, table, [&](const std::string& source, FACE::Table& result) {
+        std::ifstream file(source.c_str());
+        if (!file.is_open())
+        {
+            return false;
+        }
 
-    std::vector<std::string> lines;
-    std::ifstream file(filename.c_str());
-    if (file.is_open())
-    {
+        std::vector<std::pair<std::string, std::string>> filenames;
+
+        std::vector<std::string> lines;
         std::copy(std::istream_iterator<Line>(file), std::istream_iterator<Line>(), std::back_inserter(lines));
         for (auto& l : lines)
         {
             std::stringstream iss(l);
             std::vector<std::string> tokens;
             std::copy(std::istream_iterator<std::string>(iss), std::istream_iterator<std::string>(), std::back_inserter(tokens));
-
-            //for(auto &t : tokens) std::cout << t << " "; std::cout << std::endl;
-
             if (tokens.size() == 2)
             {
-                FACE::record record;
-                parseDRISHTI(tokens[1], record);
-
-                record.filename = tokens[0];
-#if 0
-                FACE::record record_;
-                record_.filename = tokens[0];
-                record_.roi = record.roi;
-                record_.points = record.points;
-                record_.glasses = record.glasses;
-                table.lines.push_back(record_);
-#else
-                table.lines.push_back(record);
-#endif
+                filenames.emplace_back(tokens[0], tokens[1]);
             }
         }
-    }
+
+        // One cv::FileStorage annotation per image, these are read in parallel:
+        result.lines.resize(filenames.size());
+        FACE::parallelize(static_cast<int>(filenames.size()), options, [&](int i) {
+            FACE::record& record = result.lines[i];
+            parseDRISHTI(filenames[i].second, record);
+            record.filename = filenames[i].first;
+        });
+        return true;
+    });
 
     return table;
 }
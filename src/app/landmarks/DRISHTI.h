@@ -15,6 +15,6 @@
 #include <fstream>
 
 void parseDRISHTI(const std::string& filename, FACE::record& output);
-FACE::Table parseDRISHTI(const std::string& filename);
+FACE::Table parseDRISHTI(const std::string& filename, const FACE::ParserOptions& options = {});
 
 #endif // __drishti_landmarks_DRISHTI_h__
@@ -38,7 +38,7 @@ DRISHTI_BEGIN_NAMESPACE(FACE)
 struct record
 {
     std::string filename;
-    int index;
+    int index = 0;
 
     float angle = 0.f;                             // angle from frontal
     cv::Vec4f quaternion = { 0.f, 0.f, 0.f, 1.f }; // quaternion
@@ -75,6 +75,13 @@ struct Table
     std::vector<int> getInnerLandmarks(bool withMouth = false, bool withBrows = false, bool withSides = false) const;
 };
 
+// Parsers shard large files and read per image annotation files on threads (optionally cached):
+struct ParserOptions
+{
+    int threads = -1;  // 0 or 1 == serial, -1 == OpenCV default
+    std::string cache; // cache directory (empty == disabled)
+};
+
 inline std::ostream& operator<<(std::ostream& os, const record& r)
 {
     os << r.filename << ' ';
@@ -113,7 +120,7 @@ BOOST_FUSION_ADAPT_STRUCT(
 )
 // clang-format on
 
-FACE::Table parseDRISHTI(const std::string& filename);
+FACE::Table parseDRISHTI(const std::string& filename, const FACE::ParserOptions& options);
 
 std::vector<cv::Vec3b> getRainbow();
 
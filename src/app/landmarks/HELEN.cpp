@@ -9,6 +9,7 @@
  */
 
 #include "landmarks/HELEN.h"
+#include "landmarks/TableCache.h"
 
 #include <fstream>
 
@@ -78,7 +79,7 @@ struct helen_parser : qi::grammar<Iterator, HELEN::Table(), Skipper>
 
 DRISHTI_END_NAMESPACE(FACE)
 
-FACE::Table parseHELEN(const std::string& filename)
+FACE::Table parseHELEN(const std::string& filename, const FACE::ParserOptions& options)
 {
     FACE::Table table;
 
@@ -120,23 +121,29 @@ FACE::Table parseHELEN(const std::string& filename)
     //table.eyeL = {114, 120, 125, 129 }; // clockwise
     //table.eyeR = {134, 140, 145, 149 }; // conouter clockwise
 
-    std::ifstream is(filename);
-    if (is.is_open())
-    {
-        HELEN::Table output;
+    FACE::parseCached(filename, "helen", options, table, [&](const std::string& source, FACE::Table& result) {
+        const std::string buffer = FACE::readFile(source);
+        if (buffer.empty())
+        {
+            return false;
+        }
 
-        is.unsetf(std::ios::skipws);
-        boost::spirit::istream_iterator begin(is), end;
-        FACE::helen_parser<decltype(begin)> parser;
-        bool success = qi::phrase_parse(begin, end, parser, qi::blank, output);
+        const auto shards = FACE::parseShards<HELEN::Table>(buffer, options, 1, [](int shard, const char* begin, const char* end, HELEN::Table& output) {
+            FACE::helen_parser<const char*> parser;
+            bool success = qi::phrase_parse(begin, end, parser, qi::blank, output);
+        });
 
-        table.lines.resize(output.lines.size());
-        for (int i = 0; i < table.lines.size(); i++)
+        for (const auto& output : shards)
         {
-            table.lines[i].filename = output.lines[i].filename;
-            table.lines[i].points = output.lines[i].points;
+            for (const auto& line : output.lines)
+            {
+                result.lines.emplace_back();
+                result.lines.back().filename = line.filename;
+                result.lines.back().points = line.points;
+            }
         }
-    }
+        return true;
+    });
 
     return table;
 }
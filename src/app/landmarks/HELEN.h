@@ -14,6 +14,6 @@
 #include "landmarks/FACE.h"
 #include <fstream>
 
-FACE::Table parseHELEN(const std::string& filename);
+FACE::Table parseHELEN(const std::string& filename, const FACE::ParserOptions& options = {});
 
 #endif // __drishti_landmarks_HELEN_h__
@@ -10,9 +10,9 @@
 
 #include "landmarks/BIOID.h"
 
-FACE::Table parseLFPW(const std::string& filename)
+FACE::Table parseLFPW(const std::string& filename, const FACE::ParserOptions& options)
 {
-    FACE::Table table = parseBIOID(filename);
+    FACE::Table table = parseBIOID(filename, options);
 
     table.browR = { 17, 18, 19, 20, 21 };
     table.browL = { 22, 23, 24, 25, 26 };
@@ -30,6 +30,6 @@
 // ...
 // image_filenamen.png landmark_filenamen.pts
 
-FACE::Table parseLFPW(const std::string& filename);
+FACE::Table parseLFPW(const std::string& filename, const FACE::ParserOptions& options = {});
 
 #endif // __drishti_landmarks_LFPW_h__
@@ -11,6 +11,7 @@
 //#define BOOST_SPIRIT_DEBUG
 
 #include "landmarks/LFW.h"
+#include "landmarks/TableCache.h"
 
 #include <fstream>
 
@@ -90,7 +91,7 @@ struct lfw_parser : qi::grammar<Iterator, LFW::Table(), Skipper>
 
 DRISHTI_END_NAMESPACE(LFW)
 
-FACE::Table parseLFW(const std::string& filename)
+FACE::Table parseLFW(const std::string& filename, const FACE::ParserOptions& options)
 {
     FACE::Table table;
     table.eyeR = { 0 };
@@ -100,26 +101,30 @@ FACE::Table parseLFW(const std::string& filename)
     table.mouthR = { 3 };
     table.mouthL = { 4 };
 
-    // open file, disable skipping of whitespace
-    std::ifstream file(filename);
-
-    if (file)
-    {
-        file.unsetf(std::ios::skipws);
-        boost::spirit::istream_iterator begin(file), end;
-        LFW::lfw_parser<decltype(begin)> parser;
+    FACE::parseCached(filename, "lfw", options, table, [&](const std::string& source, FACE::Table& result) {
+        const std::string buffer = FACE::readFile(source);
+        if (buffer.empty())
+        {
+            return false;
+        }
 
-        LFW::Table result;
-        bool success = qi::phrase_parse(begin, end, parser, qi::blank, result);
+        const auto shards = FACE::parseShards<LFW::Table>(buffer, options, 1, [](int shard, const char* begin, const char* end, LFW::Table& output) {
+            LFW::lfw_parser<const char*> parser;
+            bool success = qi::phrase_parse(begin, end, parser, qi::blank, output);
+        });
 
-        table.lines.resize(result.lines.size());
-        for (int i = 0; i < result.lines.size(); i++)
+        for (const auto& output : shards)
         {
-            table.lines[i].roi = result.lines[i].roi;
-            table.lines[i].filename = result.lines[i].filename;
-            table.lines[i].points = result.lines[i].points;
+            for (const auto& line : output.lines)
+            {
+                result.lines.emplace_back();
+                result.lines.back().roi = line.roi;
+                result.lines.back().filename = line.filename;
+                result.lines.back().points = line.points;
+            }
         }
-    }
+        return true;
+    });
 
     return table;
 }
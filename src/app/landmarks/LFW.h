@@ -14,6 +14,6 @@
 #include "landmarks/FACE.h"
 #include <fstream>
 
-FACE::Table parseLFW(const std::string& filename);
+FACE::Table parseLFW(const std::string& filename, const FACE::ParserOptions& options = {});
 
 #endif // __drishti_landmarks_LFW_h__
@@ -11,6 +11,7 @@
 //#define BOOST_SPIRIT_DEBUG
 
 #include "landmarks/MUCT.h"
+#include "landmarks/TableCache.h"
 
 #include <fstream>
 
@@ -25,7 +26,7 @@ DRISHTI_BEGIN_NAMESPACE(FACE)
 template <typename Iterator, typename Skipper = qi::blank_type>
 struct muct_parser : qi::grammar<Iterator, FACE::Table(), Skipper>
 {
-    muct_parser()
+    muct_parser(bool withHeader = true)
         : muct_parser::base_type(start)
     {
         static const char colsep = ',';
@@ -34,7 +35,14 @@ struct muct_parser : qi::grammar<Iterator, FACE::Table(), Skipper>
         point = (qi::float_ >> colsep >> qi::float_);
         line = key >> colsep >> qi::int_ >> colsep >> (point % colsep) >> qi::eol;
         header = (key % colsep) >> qi::eol;
-        start = header >> +line >> qi::eoi;
+        if (withHeader)
+        {
+            start = header >> +line >> qi::eoi;
+        }
+        else
+        {
+            start = qi::attr(std::vector<std::string>()) >> +line >> qi::eoi; // shards after the first
+        }
 
         BOOST_SPIRIT_DEBUG_NODES((start)(header)(key)(line));
     }
@@ -56,7 +64,7 @@ DRISHTI_END_NAMESPACE(FACE)
 // 36        => right eye
 // 37-45     => nose
 
-FACE::Table parseMUCT(const std::string& filename)
+FACE::Table parseMUCT(const std::string& filename, const FACE::ParserOptions& options)
 {
     FACE::Table table;
     table.eyeR = { 27, 29 };
@@ -69,13 +77,25 @@ FACE::Table parseMUCT(const std::string& filename)
     //table.eyeR = { 27, 28, 29, 30 };
     //table.nose = { 37, 38, 39, 40, 41, 42, 43, 44, 45 };
 
-    std::ifstream is(filename);
-    if (is.is_open())
-    {
-        is.unsetf(std::ios::skipws);
-        boost::spirit::istream_iterator begin(is), end;
-        FACE::muct_parser<decltype(begin)> parser;
-        bool success = qi::phrase_parse(begin, end, parser, qi::blank, table);
-    }
+    FACE::parseCached(filename, "muct", options, table, [&](const std::string& source, FACE::Table& result) {
+        const std::string buffer = FACE::readFile(source);
+        if (buffer.empty())
+        {
+            return false;
+        }
+
+        // The first shard starts with the CSV header:
+        auto shards = FACE::parseShards<FACE::Table>(buffer, options, 1, [](int shard, const char* begin, const char* end, FACE::Table& output) {
+            FACE::muct_parser<const char*> parser(shard == 0);
+            bool success = qi::phrase_parse(begin, end, parser, qi::blank, output);
+        });
+
+        result.header = shards.front().header;
+        for (auto& output : shards)
+        {
+            std::move(output.lines.begin(), output.lines.end(), std::back_inserter(result.lines));
+        }
+        return true;
+    });
     return table;
 }
@@ -13,6 +13,6 @@
 
 #include "landmarks/FACE.h"
 
-FACE::Table parseMUCT(const std::string& filename);
+FACE::Table parseMUCT(const std::string& filename, const FACE::ParserOptions& options = {});
 
 #endif // __drishti_landmarks_MUCT_h__
@@ -11,6 +11,7 @@
 //#define BOOST_SPIRIT_DEBUG
 
 #include "landmarks/TWO.h"
+#include "landmarks/TableCache.h"
 
 #include "drishti/core/drishti_core.h"
 
@@ -83,7 +84,7 @@ struct two_parser : qi::grammar<Iterator, TWO::Table(), Skipper>
 
 DRISHTI_END_NAMESPACE(TWO)
 
-FACE::Table parseTWO(const std::string& filename)
+FACE::Table parseTWO(const std::string& filename, const FACE::ParserOptions& options)
 {
     FACE::Table table;
 
@@ -97,26 +98,35 @@ FACE::Table parseTWO(const std::string& filename)
     table.mouthL = { 54 };
     table.brow = {};
 
-    // open file, disable skipping of whitespace
-    std::ifstream ifs(filename);
-
-    if (ifs)
+    if (filename.empty())
     {
-        ifs.unsetf(std::ios::skipws);
-        boost::spirit::istream_iterator f(ifs), l;
+        return table; // landmark format only
+    }
 
-        TWO::two_parser<decltype(f)> parser;
+    FACE::parseCached(filename, "two", options, table, [&](const std::string& source, FACE::Table& result) {
+        const std::string buffer = FACE::readFile(source);
+        if (buffer.empty())
+        {
+            return false;
+        }
 
-        TWO::Table result;
-        bool success = qi::phrase_parse(f, l, parser, qi::blank, result);
+        // Each record is a filename line followed by a line of points:
+        const auto shards = FACE::parseShards<TWO::Table>(buffer, options, 2, [](int shard, const char* begin, const char* end, TWO::Table& output) {
+            TWO::two_parser<const char*> parser;
+            bool success = qi::phrase_parse(begin, end, parser, qi::blank, output);
+        });
 
-        table.lines.resize(result.lines.size());
-        for (int i = 0; i < result.lines.size(); i++)
+        for (const auto& output : shards)
         {
-            table.lines[i].filename = result.lines[i].filename;
-            table.lines[i].points = result.lines[i].points;
+            for (const auto& line : output.lines)
+            {
+                result.lines.emplace_back();
+                result.lines.back().filename = line.filename;
+                result.lines.back().points = line.points;
+            }
         }
-    }
+        return true;
+    });
 
     return table;
 }
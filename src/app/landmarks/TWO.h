@@ -15,6 +15,6 @@
 
 #include <fstream>
 
-FACE::Table parseTWO(const std::string& filename);
+FACE::Table parseTWO(const std::string& filename, const FACE::ParserOptions& options = {});
 
 #endif // __drishti_landmarks_TWO_h__
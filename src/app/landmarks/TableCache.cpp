@@ -0,0 +1,350 @@
+/*! -*-c++-*-
+  @file   TableCache.cpp
+  @author David Hirvonen
+  @brief  Sharded parsing and a binary cache for FACE::Table records.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "landmarks/TableCache.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace bfs = boost::filesystem;
+namespace bip = boost::interprocess;
+
+DRISHTI_BEGIN_NAMESPACE(FACE)
+
+static const char kMagic[8] = { 'D', 'R', 'F', 'A', 'C', 'E', '\0', '\0' };
+static const std::uint32_t kVersion = 1;
+
+// All sections are 8 byte aligned: header, strings (table header), records, points, string blob
+struct CacheString
+{
+    std::uint64_t offset;
+    std::uint64_t length;
+};
+
+struct CacheHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize; // sizeof(CacheRecord), detects incompatible builds
+    std::int64_t mtime;
+    std::uint64_t size;
+    CacheString source;
+    std::uint64_t headerCount;
+    std::uint64_t recordCount;
+    std::uint64_t pointCount;
+    std::uint64_t stringBytes;
+};
+
+struct CacheRecord
+{
+    CacheString filename;
+    std::uint64_t points;  // first point
+    std::uint64_t glasses; // first glasses point
+    std::uint32_t pointCount;
+    std::uint32_t glassesCount;
+    std::int32_t index;
+    float angle;
+    float quaternion[4];
+    std::int32_t roi[4];
+};
+
+static bool getSourceStatus(const std::string& source, std::int64_t& mtime, std::uint64_t& size)
+{
+    boost::system::error_code error;
+    mtime = static_cast<std::int64_t>(bfs::last_write_time(source, error));
+    if (!error)
+    {
+        size = static_cast<std::uint64_t>(bfs::file_size(source, error));
+    }
+    return !error;
+}
+
+static std::string getCacheFilename(const std::string& directory, const std::string& source, const std::string& format)
+{
+    const std::string path = bfs::absolute(source).lexically_normal().string();
+
+    std::stringstream ss;
+    ss << directory << "/" << bfs::path(source).filename().string() << "-" << format << "-";
+    ss << std::hex << std::setw(16) << std::setfill('0') << static_cast<std::uint64_t>(std::hash<std::string>()(path + ":" + format)) << ".table";
+    return ss.str();
+}
+
+bool parseCached(const std::string& filename, const std::string& format, const ParserOptions& options, Table& table, const TableParser& parser)
+{
+    std::string cache;
+    if (!options.cache.empty())
+    {
+        cache = getCacheFilename(options.cache, filename, format);
+        if (readTableCache(cache, filename, table))
+        {
+            return true;
+        }
+    }
+
+    table.header.clear(); // discard a partial cache read
+    table.lines.clear();
+
+    if (!parser(filename, table))
+    {
+        return false;
+    }
+
+    if (!cache.empty())
+    {
+        writeTableCache(cache, filename, table); // best effort
+    }
+
+    return true;
+}
+
+bool readTableCache(const std::string& cache, const std::string& source, Table& table)
+{
+    std::int64_t mtime = 0;
+    std::uint64_t size = 0;
+    if (!getSourceStatus(source, mtime, size) || !bfs::exists(cache))
+    {
+        return false;
+    }
+
+    try
+    {
+        bip::file_mapping file(cache.c_str(), bip::read_only);
+        bip::mapped_region region(file, bip::read_only);
+
+        const char* data = static_cast<const char*>(region.get_address());
+        const std::size_t bytes = region.get_size();
+        if (bytes < sizeof(CacheHeader))
+        {
+            return false;
+        }
+
+        CacheHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (!std::equal(kMagic, kMagic + 8, header.magic) || (header.version != kVersion) || (header.recordSize != sizeof(CacheRecord)))
+        {
+            return false;
+        }
+        if ((header.mtime != mtime) || (header.size != size))
+        {
+            return false; // stale
+        }
+
+        const std::size_t headerOffset = sizeof(CacheHeader);
+        const std::size_t recordOffset = headerOffset + header.headerCount * sizeof(CacheString);
+        const std::size_t pointOffset = recordOffset + header.recordCount * sizeof(CacheRecord);
+        const std::size_t stringOffset = pointOffset + header.pointCount * sizeof(cv::Point2f);
+        if (bytes != (stringOffset + header.stringBytes))
+        {
+            return false;
+        }
+
+        const auto* headers = reinterpret_cast<const CacheString*>(data + headerOffset);
+        const auto* records = reinterpret_cast<const CacheRecord*>(data + recordOffset);
+        const auto* points = reinterpret_cast<const cv::Point2f*>(data + pointOffset);
+        const char* strings = data + stringOffset;
+
+        const auto valid = [&](const CacheString& s) { return (s.offset + s.length) <= header.stringBytes; };
+        const auto string = [&](const CacheString& s) { return std::string(strings + s.offset, s.length); };
+
+        if (!valid(header.source) || (string(header.source) != bfs::absolute(source).lexically_normal().string()))
+        {
+            return false; // hash collision
+        }
+
+        table.header.resize(header.headerCount);
+        for (std::size_t i = 0; i < table.header.size(); i++)
+        {
+            if (!valid(headers[i]))
+            {
+                return false;
+            }
+            table.header[i] = string(headers[i]);
+        }
+
+        table.lines.resize(header.recordCount);
+        for (std::size_t i = 0; i < table.lines.size(); i++)
+        {
+            const CacheRecord& src = records[i];
+            if (!valid(src.filename) || ((src.points + src.pointCount) > header.pointCount) || ((src.glasses + src.glassesCount) > header.pointCount))
+            {
+                return false;
+            }
+
+            record& dst = table.lines[i];
+            dst.filename = string(src.filename);
+            dst.index = src.index;
+            dst.angle = src.angle;
+            dst.quaternion = { src.quaternion[0], src.quaternion[1], src.quaternion[2], src.quaternion[3] };
+            dst.points.assign(points + src.points, points + src.points + src.pointCount);
+            dst.glasses.assign(points + src.glasses, points + src.glasses + src.glassesCount);
+            dst.roi = { src.roi[0], src.roi[1], src.roi[2], src.roi[3] };
+        }
+    }
+    catch (const bip::interprocess_exception&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool writeTableCache(const std::string& cache, const std::string& source, const Table& table)
+{
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::copy(kMagic, kMagic + 8, header.magic);
+    header.version = kVersion;
+    header.recordSize = sizeof(CacheRecord);
+    if (!getSourceStatus(source, header.mtime, header.size))
+    {
+        return false;
+    }
+
+    std::string strings;
+    const auto add = [&](const std::string& s) {
+        const CacheString entry{ strings.size(), s.size() };
+        strings += s;
+        return entry;
+    };
+
+    header.source = add(bfs::absolute(source).lexically_normal().string());
+
+    std::vector<CacheString> headers;
+    for (const auto& h : table.header)
+    {
+        headers.push_back(add(h));
+    }
+
+    std::vector<CacheRecord> records(table.lines.size());
+    std::vector<cv::Point2f> points;
+    for (std::size_t i = 0; i < records.size(); i++)
+    {
+        const record& src = table.lines[i];
+        CacheRecord& dst = records[i];
+        std::memset(&dst, 0, sizeof(dst));
+        dst.filename = add(src.filename);
+        dst.points = points.size();
+        dst.pointCount = static_cast<std::uint32_t>(src.points.size());
+        points.insert(points.end(), src.points.begin(), src.points.end());
+        dst.glasses = points.size();
+        dst.glassesCount = static_cast<std::uint32_t>(src.glasses.size());
+        points.insert(points.end(), src.glasses.begin(), src.glasses.end());
+        dst.index = src.index;
+        dst.angle = src.angle;
+        std::copy(src.quaternion.val, src.quaternion.val + 4, dst.quaternion);
+        dst.roi[0] = src.roi.x;
+        dst.roi[1] = src.roi.y;
+        dst.roi[2] = src.roi.width;
+        dst.roi[3] = src.roi.height;
+    }
+
+    header.headerCount = headers.size();
+    header.recordCount = records.size();
+    header.pointCount = points.size();
+    header.stringBytes = strings.size();
+
+    // Write to a temporary file and rename, so concurrent runs never see a partial cache:
+    const std::string tmp = cache + "." + bfs::unique_path().string();
+    {
+        std::ofstream os(tmp, std::ios::binary);
+        if (!os)
+        {
+            return false;
+        }
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        os.write(reinterpret_cast<const char*>(headers.data()), headers.size() * sizeof(CacheString));
+        os.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(CacheRecord));
+        os.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(cv::Point2f));
+        os.write(strings.data(), strings.size());
+        if (!os)
+        {
+            os.close();
+            bfs::remove(tmp);
+            return false;
+        }
+    }
+
+    boost::system::error_code error;
+    bfs::rename(tmp, cache, error);
+    if (error)
+    {
+        bfs::remove(tmp, error);
+        return false;
+    }
+    return true;
+}
+
+std::string readFile(const std::string& filename)
+{
+    std::string buffer;
+    std::ifstream is(filename, std::ios::binary);
+    if (is)
+    {
+        is.seekg(0, std::ios::end);
+        buffer.resize(static_cast<std::size_t>(is.tellg()));
+        is.seekg(0, std::ios::beg);
+        is.read(&buffer[0], buffer.size());
+        if (!is)
+        {
+            buffer.clear();
+        }
+    }
+    return buffer;
+}
+
+std::vector<Shard> splitLines(const std::string& buffer, int shards, int linesPerRecord)
+{
+    const char* begin = buffer.data();
+    const char* end = begin + buffer.size();
+
+    std::vector<const char*> starts; // first character of each record
+    for (const char* line = begin; line < end;)
+    {
+        starts.push_back(line);
+        for (int i = 0; (i < linesPerRecord) && (line < end); i++)
+        {
+            const char* eol = static_cast<const char*>(std::memchr(line, '\n', end - line));
+            line = eol ? (eol + 1) : end;
+        }
+    }
+
+    const std::size_t count = std::max(std::min(static_cast<std::size_t>(std::max(shards, 1)), starts.size()), std::size_t(1));
+
+    std::vector<Shard> result;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const std::size_t first = (starts.size() * i) / count;
+        const std::size_t last = (starts.size() * (i + 1)) / count;
+        result.emplace_back((i == 0) ? begin : starts[first], (last < starts.size()) ? starts[last] : end);
+    }
+    return result;
+}
+
+int getShardCount(const ParserOptions& options)
+{
+    if ((options.threads == 0) || (options.threads == 1))
+    {
+        return 1;
+    }
+
+    // A few shards per thread balance uneven line lengths:
+    const int threads = (options.threads < 0) ? cv::getNumThreads() : options.threads;
+    return std::max(threads, 1) * 4;
+}
+
+DRISHTI_END_NAMESPACE(FACE)
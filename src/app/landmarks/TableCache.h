@@ -0,0 +1,82 @@
+/*! -*-c++-*-
+  @file   TableCache.h
+  @author David Hirvonen
+  @brief  Sharded parsing and a binary cache for FACE::Table records.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_landmarks_TableCache_h__
+#define __drishti_landmarks_TableCache_h__
+
+#include "landmarks/FACE.h"
+
+#include "drishti/core/Parallel.h"
+
+#include <opencv2/core.hpp>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+DRISHTI_BEGIN_NAMESPACE(FACE)
+
+/*
+ * The header and records of a table are cached in one flat binary file per source file and
+ * format: a fixed header, then arrays of string, record and point entries with offsets into a
+ * trailing string blob, so a cache hit is a single mapped read.  The entry is keyed by the
+ * absolute source path and is valid while the source size and mtime don't change.  Formats
+ * that reference one annotation file per image (DRISHTI, BIOID) are only validated against the
+ * list file.  The landmark indices and the flopper are set in code by each parser.
+ */
+
+using TableParser = std::function<bool(const std::string& filename, Table& table)>; // header + lines
+bool parseCached(const std::string& filename, const std::string& format, const ParserOptions& options, Table& table, const TableParser& parser);
+
+bool readTableCache(const std::string& cache, const std::string& source, Table& table);
+bool writeTableCache(const std::string& cache, const std::string& source, const Table& table);
+
+// Read the whole file at once (empty on error):
+std::string readFile(const std::string& filename);
+
+// Split a buffer at line boundaries into up to shards ranges of whole records:
+using Shard = std::pair<const char*, const char*>;
+std::vector<Shard> splitLines(const std::string& buffer, int shards, int linesPerRecord = 1);
+
+int getShardCount(const ParserOptions& options);
+
+template <typename Function>
+void parallelize(int count, const ParserOptions& options, Function&& function)
+{
+    drishti::core::ParallelHomogeneousLambda harness = [&](int i) { function(i); };
+
+    const cv::Range range(0, count);
+    if ((options.threads == 0) || (options.threads == 1))
+    {
+        harness(range);
+    }
+    else
+    {
+        cv::parallel_for_(range, harness, std::max(options.threads, -1));
+    }
+}
+
+// Parse line oriented files on parallel shards, function(shard, begin, end, result) fills one result per shard:
+template <typename Result, typename Function>
+std::vector<Result> parseShards(const std::string& buffer, const ParserOptions& options, int linesPerRecord, Function&& function)
+{
+    const auto shards = splitLines(buffer, getShardCount(options), linesPerRecord);
+
+    std::vector<Result> results(shards.size());
+    parallelize(static_cast<int>(shards.size()), options, [&](int i) {
+        function(i, shards[i].first, shards[i].second, results[i]);
+    });
+    return results;
+}
+
+DRISHTI_END_NAMESPACE(FACE)
+
+#endif // __drishti_landmarks_TableCache_h__
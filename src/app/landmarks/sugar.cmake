@@ -18,6 +18,7 @@ sugar_files(DRISHTI_LANDMARKS_LIB_SRCS
   LFW.cpp
   LFPW.cpp
   MUCT.cpp
+  TableCache.cpp
   TWO.cpp
   )
 
@@ -29,6 +30,7 @@ sugar_files(DRISHTI_LANDMARKS_LIB_HDRS
   LFW.h   
   LFPW.h   
   MUCT.h
+  TableCache.h
   TWO.h
   )
 
@@ -26,6 +26,8 @@
 #include <QTextStream>
 #include <QFile>
 
+#include <mutex>
+
 // Sample:
 //
 //"sensor": {
@@ -75,7 +77,11 @@ FrameHandlerManager::FrameHandlerManager(const std::string& name, const std::str
 
             float frequency = address["frequency"];
             m_imageLogger = std::make_shared<drishti::core::ImageLogger>(host, port);
-            m_imageLogger->setMaxFramesPerSecond(frequency); // throttle network traffic
+            m_imageLogger->setLogger(m_logger);
+            setMaxFramesPerSecond(frequency); // throttle network traffic (and frame copies)
+
+            auto imageLogger = m_imageLogger;
+            add([imageLogger](const Frame& frame) { (*imageLogger)(frame); });
         }
     }
 #endif
@@ -117,7 +123,7 @@ FrameHandlerManager::FrameHandlerManager(const std::string& name, const std::str
     drishti::sensor::SensorModel::Intrinsic params(p, fx, size);
     m_sensor = std::make_shared<drishti::sensor::SensorModel>(params);
 
-    m_threads = std::unique_ptr<tp::ThreadPool<>>(new tp::ThreadPool<>);
+    m_threads = drishti::core::Executor::getInstance();
 
 #if DRISHTI_STACK_LOGGING_DEMO
     m_faceMonitor = drishti::core::make_unique<QtFaceMonitor>(cv::Vec2d(0.12, 0.16), m_threads);
@@ -138,41 +144,95 @@ bool FrameHandlerManager::good() const
     return (m_sensor.get() != nullptr && m_threads.get() != nullptr);
 }
 
-auto FrameHandlerManager::createAsynchronousImageLogger() -> FrameHandler
+/*
+ * Frame storage is returned to the pool when the last handler releases it (the pool may be
+ * destroyed first, the deleter holds a weak reference).
+ */
+
+struct FrameHandlerManager::FramePool : public std::enable_shared_from_this<FramePool>
 {
-#if DRISHTI_USE_BEAST
-    if (!m_imageLogger)
+    Frame acquire(const cv::Mat& image)
     {
-        return nullptr;
+        std::unique_ptr<cv::Mat> storage;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!frames.empty())
+            {
+                storage = std::move(frames.back());
+                frames.pop_back();
+            }
+            else if (count < kMaxFrames)
+            {
+                storage = drishti::core::make_unique<cv::Mat>();
+                count++;
+            }
+        }
+
+        if (!storage)
+        {
+            return nullptr; // all frames are in flight
+        }
+
+        image.copyTo(*storage); // reallocates only when the format changes
+
+        std::weak_ptr<FramePool> pool = shared_from_this();
+        return Frame(storage.release(), [pool](const cv::Mat* frame) {
+            if (auto owner = pool.lock())
+            {
+                std::lock_guard<std::mutex> lock(owner->mutex);
+                owner->frames.emplace_back(const_cast<cv::Mat*>(frame));
+            }
+            else
+            {
+                delete frame;
+            }
+        });
+    }
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<cv::Mat>> frames; // free storage
+    std::size_t count = 0;                        // allocated frames
+};
+
+void FrameHandlerManager::dispatch(const cv::Mat& image)
+{
+    if (m_handlers.empty() || image.empty())
+    {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const float elapsed = std::chrono::duration_cast<std::chrono::duration<float>>(now - m_lastFrame).count();
+    if ((1.f / (elapsed + 1e-6f)) >= m_maxFramesPerSecond)
+    {
+        return;
+    }
+
+    if (!m_framePool)
+    {
+        m_framePool = std::make_shared<FramePool>();
     }
 
-    // clang-format off
-    std::function<void(const cv::Mat&)> logger = [this](const cv::Mat& image)
+    // One copy for all handlers (the caller's image is only valid during the call):
+    const Frame frame = m_framePool->acquire(image);
+    if (frame)
     {
-        if (m_imageLogger && !image.empty())
+        m_lastFrame = now;
+        for (auto& handler : m_handlers)
         {
-            cv::Mat payload = image; // need to make a handle in this lambda
-            std::function<void()> worker = [this,payload]()
-            {
-                try
-                {
-                    m_logger->info("Logging: {} : {} [{}x{}]", m_imageLogger->host(), m_imageLogger->port(), payload.cols, payload.rows);
-                    (*m_imageLogger)(payload);
-                }
-                catch(std::exception &e)
-                {
-                    m_logger->error("facefilter: network error {}", e.what());
-                }
-            };
-            m_threads->post(worker);
+            handler(frame);
         }
-    };
-    // clang-format on
+    }
+}
 
-    return logger;
-#else
-    return nullptr;
-#endif
+auto FrameHandlerManager::createAsynchronousImageLogger() -> ImageLogger
+{
+    if (m_handlers.empty())
+    {
+        return nullptr;
+    }
+
+    return [this](const cv::Mat& image) { dispatch(image); };
 }
 
 void FrameHandlerManager::setSize(const cv::Size& size)
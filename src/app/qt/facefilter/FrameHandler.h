@@ -15,13 +15,15 @@
 
 #include <opencv2/core/core.hpp>
 
-#include "thread_pool/thread_pool.hpp"
+#include "drishti/core/Executor.h"
 
 #include "nlohmann_json.hpp" // nlohman-json
 
 #include "GLVersion.h"
 
+#include <chrono>
 #include <functional>
+#include <limits>
 #include <vector>
 #include <memory>
 
@@ -49,7 +51,12 @@ public:
     };
 
     using Settings = nlohmann::json;
-    using FrameHandler = std::function<void(const cv::Mat&)>;
+
+    // Frames are copied once into recycled storage and shared (read only) by all handlers:
+    using Frame = std::shared_ptr<const cv::Mat>;
+    using FrameHandler = std::function<void(const Frame&)>;
+    using ImageLogger = std::function<void(const cv::Mat&)>; // see hci::FaceFinder::setImageLogger()
+    static const std::size_t kMaxFrames = 4;                // frames in flight, others are dropped
 
     FrameHandlerManager(const std::string& name, const std::string& description, const GLVersion& glVersion);
 
@@ -89,11 +96,20 @@ public:
 
     cv::Size getSize() const;
 
-    void add(FrameHandler& handler)
+    void add(const FrameHandler& handler)
     {
         m_handlers.push_back(handler);
     }
 
+    // Pass a frame to the handlers on the calling thread (handlers queue work and return):
+    void dispatch(const cv::Mat& image);
+
+    // Limit the dispatch rate (i.e., network logging):
+    void setMaxFramesPerSecond(float value)
+    {
+        m_maxFramesPerSecond = value;
+    }
+
     std::vector<FrameHandler>& getHandlers()
     {
         return m_handlers;
@@ -109,12 +125,13 @@ public:
         return m_logger;
     }
 
-    std::shared_ptr<tp::ThreadPool<>>& getThreadPool()
+    std::shared_ptr<drishti::core::Executor>& getThreadPool()
     {
         return m_threads;
     }
 
-    FrameHandler createAsynchronousImageLogger();
+    // Dispatch frames to the handlers, or nullptr if there are none:
+    ImageLogger createAsynchronousImageLogger();
 #if DRISHTI_USE_BEAST
     std::shared_ptr<drishti::core::ImageLogger>& getImageLogger()
     {
@@ -152,9 +169,14 @@ protected:
     std::string m_deviceName;
     std::string m_deviceDescription;
     std::shared_ptr<spdlog::logger> m_logger;
-    std::shared_ptr<tp::ThreadPool<>> m_threads;
+    std::shared_ptr<drishti::core::Executor> m_threads;
     std::shared_ptr<drishti::sensor::SensorModel> m_sensor;
     std::vector<FrameHandler> m_handlers;
+
+    struct FramePool;
+    std::shared_ptr<FramePool> m_framePool;
+    float m_maxFramesPerSecond = std::numeric_limits<float>::max();
+    std::chrono::steady_clock::time_point m_lastFrame;
     std::unique_ptr<drishti::hci::FaceMonitor> m_faceMonitor;
 
 #if DRISHTI_USE_BEAST
@@ -12,6 +12,7 @@
 
 #include "drishti/core/make_unique.h"
 #include "drishti/core/drishti_stdlib_string.h"
+#include "drishti/core/Logger.h"
 
 #include <beast/websocket.hpp>
 #include <beast/core.hpp>
@@ -23,11 +24,36 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
+// Persistent websocket connection (beast), reopened after a network error:
+struct Connection
+{
+    Connection(const std::string& host, const std::string& port)
+        : resolver(ios)
+        , socket(ios)
+        , ws(socket)
+    {
+        boost::asio::connect(socket, resolver.resolve(boost::asio::ip::tcp::resolver::query{ host, port }));
+        ws.handshake(host, "/");
+        ws.set_option(beast::websocket::message_type{ beast::websocket::opcode::binary });
+    }
+
+    boost::asio::io_service ios;
+    boost::asio::ip::tcp::resolver resolver;
+    boost::asio::ip::tcp::socket socket;
+    beast::websocket::stream<boost::asio::ip::tcp::socket&> ws;
+};
+
 struct ImageLogger::Impl
 {
 public:
@@ -39,9 +65,18 @@ public:
         : host(host)
         , port(port)
     {
+        thread = std::thread([this]() { run(); });
     }
 
-    ~Impl() = default;
+    ~Impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        thread.join();
+    }
 
     float getElapsed(const TimePoint& now) const
     {
@@ -62,10 +97,168 @@ public:
         }
     }
 
+    using Frame = std::shared_ptr<const cv::Mat>;
+
+    // Caller thread: copy the frame into recycled storage (no allocation in the steady state):
+    void push(const cv::Mat& image)
+    {
+        std::shared_ptr<cv::Mat> frame;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!spare.empty())
+            {
+                frame = spare.back();
+                spare.pop_back();
+            }
+        }
+
+        if (!frame)
+        {
+            frame = std::make_shared<cv::Mat>();
+        }
+        image.copyTo(*frame); // the caller may reuse its buffer after the call
+        push(Frame(frame), true);
+    }
+
+    void push(const Frame& frame, bool isOwned)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.size() >= maxQueueSize)
+            {
+                recycle(queue.front()); // drop the oldest frame
+                queue.pop_front();
+                dropped++;
+            }
+            queue.push_back({ frame, isOwned });
+        }
+        condition.notify_one();
+    }
+
+    // Keep our own storage for the next copy (mutex):
+    void recycle(const std::pair<Frame, bool>& entry)
+    {
+        if (entry.second)
+        {
+            spare.push_back(std::const_pointer_cast<cv::Mat>(entry.first));
+        }
+    }
+
+    // Worker thread:
+    void run()
+    {
+        std::vector<std::uint8_t> buffer; // encoded frame (capacity is retained)
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            condition.wait(lock, [&]() { return stop || !queue.empty(); });
+            if (stop)
+            {
+                break; // queued frames are discarded
+            }
+
+            const auto entry = queue.front();
+            queue.pop_front();
+            const Encoder encoder = this->encoder;
+            const Format format = this->format;
+            const int quality = this->quality;
+            const auto logger = this->logger;
+            lock.unlock();
+
+            if (encode(*entry.first, buffer, encoder, format, quality))
+            {
+                send(buffer, logger);
+            }
+
+            lock.lock();
+            recycle(entry);
+        }
+
+        if (connection)
+        {
+            try
+            {
+                connection->ws.close(beast::websocket::close_code::normal);
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
+    static bool encode(const cv::Mat& image, std::vector<std::uint8_t>& buffer, const Encoder& encoder, Format format, int quality)
+    {
+        if (encoder && encoder(image, buffer))
+        {
+            return true;
+        }
+
+        switch (format)
+        {
+            case kJPEG:
+                return cv::imencode(".jpg", image, buffer, { cv::IMWRITE_JPEG_QUALITY, quality });
+            default:
+                return cv::imencode(".png", image, buffer);
+        }
+    }
+
+    void send(const std::vector<std::uint8_t>& buffer, const std::shared_ptr<spdlog::logger>& logger)
+    {
+        try
+        {
+            if (!connection)
+            {
+                connection = drishti::core::make_unique<Connection>(host, port);
+            }
+            connection->ws.write(boost::asio::buffer(buffer));
+
+            // The server replies to each image:
+            beast::websocket::opcode op;
+            reply.consume(reply.size());
+            connection->ws.read(op, reply);
+            sent++;
+
+            if (logger)
+            {
+                logger->debug("ImageLogger: {}", beast::to_string(reply.data()));
+            }
+        }
+        catch (const std::exception& e)
+        {
+            connection.reset(); // reconnect with the next frame
+            if (logger)
+            {
+                logger->error("ImageLogger: network error {} : {} {}", host, port, e.what());
+            }
+        }
+    }
+
     std::string host;
     std::string port;
     float maxFramesPerSecond = std::numeric_limits<float>::max();
     TimePoint timeOfLastImage;
+
+    // Shared with the worker (mutex):
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::pair<Frame, bool>> queue; // oldest first (frame, copied by push())
+    std::vector<std::shared_ptr<cv::Mat>> spare;
+    std::size_t maxQueueSize = 2;
+    Format format = kPNG;
+    int quality = 90;
+    Encoder encoder;
+    std::shared_ptr<spdlog::logger> logger;
+    bool stop = false;
+
+    std::atomic<std::size_t> sent{ 0 };
+    std::atomic<std::size_t> dropped{ 0 };
+
+    // Worker only:
+    std::unique_ptr<Connection> connection;
+    beast::streambuf reply;
+
+    std::thread thread; // last (uses the members above)
 };
 
 ImageLogger::ImageLogger(const std::string& host, const std::string& port)
@@ -85,39 +278,65 @@ float ImageLogger::getMaxFramesPerSecond() const
     return impl->maxFramesPerSecond;
 }
 
-static std::vector<std::uint8_t> create(const cv::Mat& image)
+void ImageLogger::setMaxQueueSize(std::size_t size)
 {
-    std::vector<uint8_t> buffer;
-    cv::imencode(".png", image, buffer);
-    return buffer;
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    impl->maxQueueSize = std::max(size, std::size_t(1));
+}
+
+std::size_t ImageLogger::getMaxQueueSize() const
+{
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    return impl->maxQueueSize;
+}
+
+void ImageLogger::setFormat(Format format, int quality)
+{
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    impl->format = format;
+    impl->quality = quality;
+}
+
+void ImageLogger::setEncoder(const Encoder& encoder)
+{
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    impl->encoder = encoder;
+}
+
+void ImageLogger::setLogger(const std::shared_ptr<spdlog::logger>& logger)
+{
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    impl->logger = logger;
+}
+
+std::size_t ImageLogger::getSentFrames() const
+{
+    return impl->sent;
+}
+
+std::size_t ImageLogger::getDroppedFrames() const
+{
+    return impl->dropped;
 }
 
 void ImageLogger::operator()(const cv::Mat& image)
 {
-    if (impl->isTooSoon(Impl::Clock::now()))
+    if (image.empty() || impl->isTooSoon(Impl::Clock::now()))
     {
         return;
     }
 
-    // Normal boost::asio setup
-    boost::asio::io_service ios;
-    boost::asio::ip::tcp::resolver r{ ios };
-    boost::asio::ip::tcp::socket sock{ ios };
-    boost::asio::connect(sock, r.resolve(boost::asio::ip::tcp::resolver::query{ impl->host, impl->port }));
-
-    // WebSocket connect and send message using beast
-    beast::websocket::stream<boost::asio::ip::tcp::socket&> ws{ sock };
-    ws.handshake(impl->host, "/");
-    ws.set_option(beast::websocket::message_type{ beast::websocket::opcode::binary });
-    ws.write(boost::asio::buffer(create(image)));
-
-    // Receive WebSocket message, print and close using beast
-    beast::streambuf sb;
-    beast::websocket::opcode op;
-    ws.read(op, sb);
-    ws.close(beast::websocket::close_code::normal);
-
-    std::cout << beast::to_string(sb.data()) << "\n";
+    impl->push(image);
+}
+
+void ImageLogger::operator()(const std::shared_ptr<const cv::Mat>& image)
+{
+    if (!image || image->empty() || impl->isTooSoon(Impl::Clock::now()))
+    {
+        return;
+    }
+
+    impl->push(image, false);
 }
 
 const std::string& ImageLogger::port() const
@@ -15,21 +15,65 @@
 
 #include <opencv2/core.hpp>
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <vector>
+
+namespace spdlog
+{
+class logger;
+}
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
+/*
+ * The call operator only copies the frame into a recycled buffer of a bounded queue (the
+ * oldest frame is dropped when it is full), shared frames are queued as is.  Encoding and
+ * the websocket send run on a dedicated thread over a persistent connection, so logging
+ * never blocks the camera thread.
+ */
+
 class ImageLogger
 {
 public:
+    enum Format
+    {
+        kPNG,
+        kJPEG
+    };
+
+    // Encode image in buffer (reuse its capacity), i.e., a platform hardware JPEG encoder:
+    using Encoder = std::function<bool(const cv::Mat& image, std::vector<std::uint8_t>& buffer)>;
+
     ImageLogger(const std::string& host, const std::string& port);
     ~ImageLogger();
     const std::string& port() const;
     const std::string& host() const;
     void setMaxFramesPerSecond(float value);
     float getMaxFramesPerSecond() const;
+
+    // Queue length (frames waiting for the worker), the oldest frame is dropped when full:
+    void setMaxQueueSize(std::size_t size);
+    std::size_t getMaxQueueSize() const;
+
+    // Software encoding with OpenCV (quality is the JPEG quality 0..100):
+    void setFormat(Format format, int quality = 90);
+
+    // Replace the software encoder (an empty encoder restores it), falls back to it on failure:
+    void setEncoder(const Encoder& encoder);
+
+    // Connection errors are reported here (optional):
+    void setLogger(const std::shared_ptr<spdlog::logger>& logger);
+
+    std::size_t getSentFrames() const;
+    std::size_t getDroppedFrames() const;
+
     void operator()(const cv::Mat& image);
 
+    // Queue a shared read only frame without a copy:
+    void operator()(const std::shared_ptr<const cv::Mat>& image);
+
 protected:
     struct Impl;
     std::unique_ptr<Impl> impl;
@@ -33,7 +33,7 @@ double QtFaceMonitor::PositionAndTime::estimateVelocity(const PositionAndTime& c
     return translation / (interval + std::numeric_limits<double>::epsilon());
 }
 
-QtFaceMonitor::QtFaceMonitor(const cv::Vec2d& range, std::shared_ptr<tp::ThreadPool<>>& threads)
+QtFaceMonitor::QtFaceMonitor(const cv::Vec2d& range, std::shared_ptr<drishti::core::Executor>& threads)
     : m_range(range)
     , m_frameCounter(0)
     , m_stackCounter(0)
@@ -130,7 +130,7 @@ void QtFaceMonitor::grab(const std::vector<FaceImage>& frames, bool isInitialize
 
     if (m_threads)
     {
-        m_threads->process(logger);
+        m_threads->process(logger, drishti::core::Executor::kBackground);
     }
     else
     {
@@ -15,7 +15,7 @@
 #include "drishti/hci/FaceMonitor.h"
 #include "drishti/core/Field.h"
 
-#include "thread_pool/thread_pool.hpp"
+#include "drishti/core/Executor.h"
 
 #include <opencv2/core/core.hpp>
 
@@ -41,7 +41,7 @@ public:
         TimePoint time;
     };
 
-    QtFaceMonitor(const cv::Vec2d& range, std::shared_ptr<tp::ThreadPool<>>& threads);
+    QtFaceMonitor(const cv::Vec2d& range, std::shared_ptr<drishti::core::Executor>& threads);
     virtual bool isValid(const cv::Point3f& position, const TimePoint& timestamp);
     virtual void grab(const std::vector<FaceImage>& frames, bool isInitialized);
 
@@ -55,7 +55,7 @@ protected:
     uint64_t m_frameCounter = 0;
     uint64_t m_stackCounter = 0;
 
-    std::shared_ptr<tp::ThreadPool<>> m_threads;
+    std::shared_ptr<drishti::core::Executor> m_threads;
 };
 
 #endif // __drishti_qt_facefilter_QtFaceMonitor_h__
@@ -38,9 +38,11 @@
 #include <cassert> // assert
 
 #include "drishti/graphics/drishti_graphics.h"
+#include "drishti/graphics/ExternalTextureProc.h"
 
 #include "drishti/hci/FaceFinder.h"
 #include "drishti/hci/FaceFinderPainter.h"
+#include "drishti/core/make_unique.h"
 
 #include "FrameHandler.h"
 #include "VideoFilter.hpp"
@@ -152,6 +154,18 @@ struct VideoFilterRunnable::Impl
         return (*m_detector)(frame);
     }
 
+    // Render an EGLImage to an RGBA texture for the detector (no CPU mapping or upload):
+    GLuint importImage(void* image, const ogles_gpgpu::Size2d& size)
+    {
+        if (!m_external || (m_external->getInFrameW() != size.width) || (m_external->getInFrameH() != size.height))
+        {
+            m_external = drishti::core::make_unique<ogles_gpgpu::ExternalTextureProc>();
+            m_external->init(size.width, size.height, 0, false);
+            m_external->createFBOTex(false);
+        }
+        return m_external->importImage(image);
+    }
+
     void setBrightness(float value)
     {
         if (m_detector)
@@ -165,6 +179,7 @@ struct VideoFilterRunnable::Impl
     std::chrono::high_resolution_clock::time_point m_tic;
 
     std::unique_ptr<drishti::hci::FaceFinder> m_detector;
+    std::unique_ptr<ogles_gpgpu::ExternalTextureProc> m_external;
 };
 
 VideoFilterRunnable::VideoFilterRunnable(VideoFilter* filter)
@@ -236,6 +251,12 @@ bool VideoFilterRunnable::isFrameValid(const QVideoFrame& frame)
     {
         return true;
     }
+#if defined(Q_OS_ANDROID)
+    if (frame.handleType() == QAbstractVideoBuffer::EGLImageHandle)
+    {
+        return ogles_gpgpu::ExternalTextureProc::isSupported();
+    }
+#endif
 
     return false;
 }
@@ -294,6 +315,18 @@ int VideoFilterRunnable::detectFaces(QVideoFrame* input)
         FrameInput frame(size, pixelBuffer, useRawPixels, inputTexture, GL_RGBA);
         m_outTexture = (*m_pImpl)(frame);
     }
+#if defined(Q_OS_ANDROID)
+    else if (input->handleType() == QAbstractVideoBuffer::EGLImageHandle)
+    {
+        // Camera frames stay on the GPU: the EGLImage is sampled through GL_TEXTURE_EXTERNAL_OES
+        inputTexture = m_pImpl->importImage(input->handle().value<void*>(), size);
+        if (inputTexture != 0)
+        {
+            FrameInput frame(size, pixelBuffer, useRawPixels, inputTexture, GL_RGBA);
+            m_outTexture = (*m_pImpl)(frame);
+        }
+    }
+#endif
     else
     {
         static const bool isIOS = detail::isIOS();
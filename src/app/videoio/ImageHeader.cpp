@@ -0,0 +1,237 @@
+/*! -*-c++-*-
+ @file   videoio/ImageHeader.cpp
+ @author David Hirvonen
+ @brief  Read image dimensions from file headers without decoding the pixels.
+
+ \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+ \license{This project is released under the 3 Clause BSD License.}
+
+ */
+
+#include "videoio/ImageHeader.h"
+
+#include "drishti/core/Parallel.h"
+
+#include <opencv2/highgui.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+
+namespace bfs = boost::filesystem;
+
+DRISHTI_VIDEOIO_NAMESPACE_BEGIN
+
+static std::uint32_t readBE(const unsigned char* data, int n)
+{
+    std::uint32_t value = 0;
+    for (int i = 0; i < n; i++)
+    {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+static std::uint32_t readLE(const unsigned char* data, int n)
+{
+    std::uint32_t value = 0;
+    for (int i = n - 1; i >= 0; i--)
+    {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+// The IHDR chunk is always first: 8 byte signature, 4 byte length, "IHDR", width, height, depth, color type
+static bool readPngHeader(const unsigned char* data, ImageHeader& header)
+{
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    if (!std::equal(signature, signature + 8, data) || !std::equal(data + 12, data + 16, "IHDR"))
+    {
+        return false;
+    }
+
+    static const int channels[7] = { 1, 0, 3, 3, 2, 0, 4 }; // gray, -, rgb, palette, gray + alpha, -, rgba
+    header.format = ImageHeader::kPNG;
+    header.size = { static_cast<int>(readBE(data + 16, 4)), static_cast<int>(readBE(data + 20, 4)) };
+    header.channels = (data[25] < 7) ? channels[data[25]] : 0;
+    return true;
+}
+
+// The dimensions are stored in the first start of frame segment (SOF0..SOF15, excluding DHT, JPG and DAC):
+static bool readJpegHeader(std::istream& is, ImageHeader& header)
+{
+    is.seekg(2);
+
+    unsigned char marker[4];
+    while (is.read(reinterpret_cast<char*>(marker), 2))
+    {
+        if (marker[0] != 0xff)
+        {
+            break;
+        }
+
+        const unsigned char type = marker[1];
+        if ((type == 0xff) || (type == 0x01) || ((0xd0 <= type) && (type <= 0xd7)))
+        {
+            is.seekg(-1, std::ios::cur); // fill byte or standalone marker
+            continue;
+        }
+
+        if (!is.read(reinterpret_cast<char*>(marker + 2), 2))
+        {
+            break;
+        }
+
+        const std::uint32_t length = readBE(marker + 2, 2);
+        if (length < 2)
+        {
+            break;
+        }
+
+        if ((0xc0 <= type) && (type <= 0xcf) && (type != 0xc4) && (type != 0xc8) && (type != 0xcc))
+        {
+            unsigned char sof[6]; // precision, height, width, components
+            if (!is.read(reinterpret_cast<char*>(sof), 6))
+            {
+                break;
+            }
+
+            header.format = ImageHeader::kJPEG;
+            header.size = { static_cast<int>(readBE(sof + 3, 2)), static_cast<int>(readBE(sof + 1, 2)) };
+            header.channels = sof[5];
+            return true;
+        }
+
+        is.seekg(length - 2, std::ios::cur);
+    }
+
+    return false;
+}
+
+// BITMAPINFOHEADER: signed width and height at offsets 18 and 22 (negative height == top down), bit count at 28
+static bool readBmpHeader(const unsigned char* data, ImageHeader& header)
+{
+    const auto width = static_cast<std::int32_t>(readLE(data + 18, 4));
+    const auto height = static_cast<std::int32_t>(readLE(data + 22, 4));
+    const int bits = static_cast<int>(readLE(data + 28, 2));
+
+    header.format = ImageHeader::kBMP;
+    header.size = { static_cast<int>(width), static_cast<int>(height < 0 ? -height : height) };
+    header.channels = (bits == 32) ? 4 : 3; // palette and 16 bit images are decoded as color
+    return true;
+}
+
+bool readImageHeader(const std::string& filename, ImageHeader& header, bool decode)
+{
+    header = {};
+    header.filename = filename;
+
+    std::ifstream is(filename, std::ios::binary);
+    if (!is)
+    {
+        return false;
+    }
+
+    unsigned char data[30] = { 0 };
+    if (is.read(reinterpret_cast<char*>(data), sizeof(data)))
+    {
+        bool status = false;
+        if (data[0] == 0x89)
+        {
+            status = readPngHeader(data, header);
+        }
+        else if ((data[0] == 0xff) && (data[1] == 0xd8))
+        {
+            status = readJpegHeader(is, header);
+        }
+        else if ((data[0] == 'B') && (data[1] == 'M'))
+        {
+            status = readBmpHeader(data, header);
+        }
+
+        if (status && header.good())
+        {
+            return true;
+        }
+    }
+
+    header = {};
+    header.filename = filename;
+
+    if (decode)
+    {
+        cv::Mat image = cv::imread(filename, cv::IMREAD_UNCHANGED);
+        if (!image.empty())
+        {
+            header.format = ImageHeader::kDecoded;
+            header.size = image.size();
+            header.channels = image.channels();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<ImageHeader> readImageHeaders(const std::vector<std::string>& filenames, int threads, bool decode)
+{
+    std::vector<ImageHeader> headers(filenames.size());
+
+    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+        readImageHeader(filenames[i], headers[i], decode);
+    };
+
+    const cv::Range range(0, static_cast<int>(filenames.size()));
+    if ((threads == 0) || (threads == 1))
+    {
+        harness(range);
+    }
+    else
+    {
+        cv::parallel_for_(range, harness, std::max(threads, -1));
+    }
+
+    return headers;
+}
+
+template <typename Iterator>
+static void collect(const bfs::path& directory, std::vector<std::string>& filenames)
+{
+    static const char* extensions[] = { ".png", ".jpg", ".jpeg", ".bmp" };
+
+    boost::system::error_code error;
+    for (Iterator iter(directory, error), end; !error && (iter != end); iter.increment(error))
+    {
+        if (bfs::is_regular_file(iter->status()))
+        {
+            const std::string extension = boost::algorithm::to_lower_copy(iter->path().extension().string());
+            if (std::find(std::begin(extensions), std::end(extensions), extension) != std::end(extensions))
+            {
+                filenames.push_back(iter->path().string());
+            }
+        }
+    }
+}
+
+std::vector<ImageHeader> scanImageDirectory(const std::string& directory, int threads, bool recursive, bool decode)
+{
+    std::vector<std::string> filenames;
+    if (recursive)
+    {
+        collect<bfs::recursive_directory_iterator>(directory, filenames);
+    }
+    else
+    {
+        collect<bfs::directory_iterator>(directory, filenames);
+    }
+    std::sort(filenames.begin(), filenames.end());
+
+    return readImageHeaders(filenames, threads, decode);
+}
+
+DRISHTI_VIDEOIO_NAMESPACE_END
@@ -0,0 +1,58 @@
+/*! -*-c++-*-
+ @file   videoio/ImageHeader.h
+ @author David Hirvonen
+ @brief  Read image dimensions from file headers without decoding the pixels.
+
+ \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+ \license{This project is released under the 3 Clause BSD License.}
+
+ */
+
+#ifndef __videoio_ImageHeader_h__
+#define __videoio_ImageHeader_h__
+
+#include "videoio/drishti_videoio.h"
+
+#include <opencv2/core.hpp>
+
+#include <string>
+#include <vector>
+
+DRISHTI_VIDEOIO_NAMESPACE_BEGIN
+
+/*
+ * PNG, JPEG and BMP headers are parsed directly, which costs a few small reads per file
+ * instead of a full decode, so indexing a dataset is bound by file system latency.  The
+ * batch functions read headers on cv::parallel_for_ (threads: 0 or 1 == serial, -1 ==
+ * OpenCV default) and return one entry per file in input order.  With decode set, files
+ * in other formats (or with malformed headers) are decoded with cv::imread() instead.
+ */
+
+struct ImageHeader
+{
+    enum Format
+    {
+        kUnknown,
+        kPNG,
+        kJPEG,
+        kBMP,
+        kDecoded // read with cv::imread()
+    };
+
+    bool good() const { return size.area() > 0; }
+
+    std::string filename;
+    Format format = kUnknown;
+    cv::Size size;
+    int channels = 0; // as stored: 1 (gray), 2 (gray + alpha), 3 (color, palette) or 4 (color + alpha)
+};
+
+bool readImageHeader(const std::string& filename, ImageHeader& header, bool decode = false);
+std::vector<ImageHeader> readImageHeaders(const std::vector<std::string>& filenames, int threads = -1, bool decode = false);
+
+// Headers for the *.png, *.jpg, *.jpeg and *.bmp files in a directory (optionally recursive), sorted by filename:
+std::vector<ImageHeader> scanImageDirectory(const std::string& directory, int threads = -1, bool recursive = true, bool decode = false);
+
+DRISHTI_VIDEOIO_NAMESPACE_END
+
+#endif // __videoio_ImageHeader_h__
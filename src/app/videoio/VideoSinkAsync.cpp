@@ -0,0 +1,242 @@
+/*! -*-c++-*-
+ @file   videoio/VideoSinkAsync.cpp
+ @author David Hirvonen
+ @brief  Implementation of a VideoSink decorator that encodes on a dedicated thread.
+
+ \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+ \license{This project is released under the 3 Clause BSD License.}
+
+ */
+
+#include "videoio/VideoSinkAsync.h"
+
+#include "drishti/core/make_unique.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+DRISHTI_VIDEOIO_NAMESPACE_BEGIN
+
+class VideoSinkAsync::Impl
+{
+public:
+    using Clock = std::chrono::high_resolution_clock;
+
+    Impl(const std::shared_ptr<VideoSinkCV>& sink, std::size_t capacity, Policy policy)
+        : m_sink(sink)
+        , m_capacity(std::max(capacity, std::size_t(1)))
+        , m_policy(policy)
+    {
+    }
+
+    ~Impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_ready.notify_all();
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    bool begin()
+    {
+        if (m_thread.joinable() || !m_sink->begin())
+        {
+            return false;
+        }
+
+        m_thread = std::thread([this]() { encode(); });
+        return true;
+    }
+
+    bool push(const cv::Mat& image)
+    {
+        cv::Mat buffer;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_thread.joinable() || m_ending || m_stop)
+            {
+                return false;
+            }
+
+            m_statistics.submitted++;
+            if (m_reserved >= m_capacity)
+            {
+                if (m_policy == kDrop)
+                {
+                    m_statistics.dropped++;
+                    return false;
+                }
+
+                const auto tic = Clock::now();
+                m_space.wait(lock, [&]() { return m_reserved < m_capacity; });
+                m_statistics.blocked++;
+                m_statistics.blockedTime += std::chrono::duration<double>(Clock::now() - tic).count();
+            }
+
+            m_reserved++;
+            m_statistics.maxQueued = std::max(m_statistics.maxQueued, m_reserved);
+
+            if (!m_free.empty())
+            {
+                buffer = m_free.back();
+                m_free.pop_back();
+            }
+        }
+
+        // The copy reuses the recycled allocation when the size and type don't change:
+        image.copyTo(buffer);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(buffer);
+        }
+        m_ready.notify_one();
+        return true;
+    }
+
+    bool end(const CompletionHandler& handler)
+    {
+        if (!m_thread.joinable())
+        {
+            return m_sink->end(handler);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_ending)
+            {
+                return false;
+            }
+            m_ending = true;
+            m_handler = handler;
+        }
+        m_ready.notify_all();
+        return true;
+    }
+
+    Statistics getStatistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    std::shared_ptr<VideoSinkCV> m_sink;
+
+protected:
+    void encode()
+    {
+        while (true)
+        {
+            cv::Mat buffer;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_ready.wait(lock, [&]() { return !m_queue.empty() || m_ending || m_stop; });
+                if (m_queue.empty())
+                {
+                    break; // drained
+                }
+                buffer = m_queue.front();
+                m_queue.pop_front();
+            }
+
+            // The wrapped sink must not retain the image, the buffer is recycled:
+            const bool status = (*m_sink)(buffer);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (status)
+                {
+                    m_statistics.encoded++;
+                }
+                else
+                {
+                    m_statistics.dropped++;
+                }
+                m_free.push_back(buffer);
+                m_reserved--;
+            }
+            m_space.notify_one();
+        }
+
+        CompletionHandler handler;
+        bool ending = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ending = m_ending;
+            handler = m_handler;
+        }
+
+        if (ending)
+        {
+            m_sink->end(handler);
+        }
+    }
+
+    std::size_t m_capacity = 8;
+    Policy m_policy = kBlock;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready; // queued frames or end of stream (encoder)
+    std::condition_variable m_space; // free slots (producer)
+    std::deque<cv::Mat> m_queue;
+    std::vector<cv::Mat> m_free;     // recycled buffers
+    std::size_t m_reserved = 0;      // queued + being copied + being encoded
+    bool m_ending = false;           // end() was called
+    bool m_stop = false;             // destruction
+    CompletionHandler m_handler;
+    Statistics m_statistics;
+
+    std::thread m_thread;
+};
+
+VideoSinkAsync::VideoSinkAsync(const std::shared_ptr<VideoSinkCV>& sink, std::size_t capacity, Policy policy)
+{
+    m_impl = drishti::core::make_unique<Impl>(sink, capacity, policy);
+}
+
+VideoSinkAsync::~VideoSinkAsync()
+{
+}
+
+bool VideoSinkAsync::good()
+{
+    return m_impl->m_sink->good();
+}
+
+bool VideoSinkAsync::begin()
+{
+    return m_impl->begin();
+}
+
+bool VideoSinkAsync::operator()(const cv::Mat& image)
+{
+    return m_impl->push(image);
+}
+
+bool VideoSinkAsync::end(const CompletionHandler& handler)
+{
+    return m_impl->end(handler);
+}
+
+void VideoSinkAsync::setProperties(const Properties& properties)
+{
+    m_impl->m_sink->setProperties(properties);
+}
+
+auto VideoSinkAsync::getStatistics() const -> Statistics
+{
+    return m_impl->getStatistics();
+}
+
+DRISHTI_VIDEOIO_NAMESPACE_END
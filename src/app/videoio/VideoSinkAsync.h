@@ -0,0 +1,68 @@
+/*! -*-c++-*-
+ @file   videoio/VideoSinkAsync.h
+ @author David Hirvonen
+ @brief  Declaration of a VideoSink decorator that encodes on a dedicated thread.
+
+ \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+ \license{This project is released under the 3 Clause BSD License.}
+
+ */
+
+#ifndef __videoio_VideoSinkAsync_h__
+#define __videoio_VideoSinkAsync_h__
+
+#include "videoio/VideoSinkCV.h"
+#include "videoio/drishti_videoio.h"
+
+#include <cstddef>
+#include <memory>
+
+DRISHTI_VIDEOIO_NAMESPACE_BEGIN
+
+/*
+ * Frames are copied into recycled buffers and queued for an encoder thread, which owns the
+ * wrapped sink after begin() (i.e., VideoSinkApple, which uses the hardware encoder through
+ * AVFoundation), so the processing loop only pays for the copy.  A full queue either blocks
+ * the producer (kBlock, backpressure) or drops the frame (kDrop).  end() returns right away,
+ * the handler is called from the encoder thread after the queued frames are written.
+ */
+
+class VideoSinkAsync : public VideoSinkCV
+{
+public:
+    enum Policy
+    {
+        kBlock, // wait for a free slot
+        kDrop   // drop frames while the queue is full
+    };
+
+    struct Statistics
+    {
+        std::size_t submitted = 0; // frames passed to operator()
+        std::size_t encoded = 0;   // frames passed to the wrapped sink
+        std::size_t dropped = 0;   // frames dropped (kDrop) or rejected by the wrapped sink
+        std::size_t blocked = 0;   // submissions that waited for a free slot (kBlock)
+        double blockedTime = 0.0;  // total wait in seconds
+        std::size_t maxQueued = 0; // queue high water mark
+    };
+
+    class Impl;
+
+    VideoSinkAsync(const std::shared_ptr<VideoSinkCV>& sink, std::size_t capacity = 8, Policy policy = kBlock);
+    ~VideoSinkAsync(); // writes the queued frames
+
+    virtual bool good();
+    virtual bool begin();
+    virtual bool operator()(const cv::Mat& image);
+    virtual bool end(const CompletionHandler& handler);
+    virtual void setProperties(const Properties& properties);
+
+    Statistics getStatistics() const;
+
+protected:
+    std::unique_ptr<Impl> m_impl;
+};
+
+DRISHTI_VIDEOIO_NAMESPACE_END
+
+#endif // __videoio_VideoSinkAsync_h__
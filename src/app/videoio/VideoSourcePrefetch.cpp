@@ -0,0 +1,251 @@
+/*! -*-c++-*-
+ @file   videoio/VideoSourcePrefetch.cpp
+ @author David Hirvonen
+ @brief  Implementation of a VideoSource decorator that decodes frames ahead on a thread pool.
+
+ \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+ \license{This project is released under the 3 Clause BSD License.}
+
+ */
+
+#include "videoio/VideoSourcePrefetch.h"
+
+#include "drishti/core/Executor.h"
+#include "drishti/core/make_unique.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+DRISHTI_VIDEOIO_NAMESPACE_BEGIN
+
+class VideoSourcePrefetch::Impl
+{
+public:
+    struct Slot
+    {
+        enum State
+        {
+            kFree,
+            kPending, // queued or decoding
+            kReady
+        };
+
+        State state = kFree;
+        std::size_t index = 0; // frame index (random access) or stream position (sequential)
+        VideoSourceCV::Frame frame;
+    };
+
+    Impl(const std::shared_ptr<VideoSourceCV>& source, std::size_t depth, int threads)
+        : m_source(source)
+        , m_random(source->isRandomAccess())
+        , m_slots(std::max(depth, std::size_t(1)))
+    {
+        // Sequential sources can't be decoded concurrently, so one thread is enough:
+        drishti::core::Executor::Options options;
+        options.threads = m_random ? std::max(threads, 1) : 1;
+        m_executor = drishti::core::make_unique<drishti::core::Executor>(options);
+    }
+
+    ~Impl()
+    {
+        m_stop = true;
+        m_executor.reset(); // the pending decodes return right away
+    }
+
+    VideoSourceCV::Frame operator()(int i)
+    {
+        if (!m_random)
+        {
+            return next();
+        }
+
+        if (!((0 <= i) && (static_cast<std::size_t>(i) < m_source->count())))
+        {
+            return (*m_source)(i);
+        }
+
+        return get(static_cast<std::size_t>(i));
+    }
+
+    std::shared_ptr<VideoSourceCV> m_source;
+
+protected:
+    // Random access: take frame i if it was prefetched and queue the frames that follow it.
+    VideoSourceCV::Frame get(std::size_t i)
+    {
+        VideoSourceCV::Frame frame;
+        bool hit = false;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            Slot& slot = m_slots[i % m_slots.size()];
+            if ((slot.state != Slot::kFree) && (slot.index == i))
+            {
+                m_condition.wait(lock, [&]() { return slot.state != Slot::kPending; });
+                if ((slot.state == Slot::kReady) && (slot.index == i))
+                {
+                    frame = std::move(slot.frame);
+                    slot.state = Slot::kFree;
+                    hit = true;
+                }
+            }
+
+            const std::size_t end = std::min(i + m_slots.size(), m_source->count());
+            for (std::size_t j = i + 1; j < end; j++)
+            {
+                Slot& ahead = m_slots[j % m_slots.size()];
+                if ((ahead.state == Slot::kPending) || ((ahead.state == Slot::kReady) && (ahead.index == j)))
+                {
+                    continue; // in flight, or waiting for its consumer
+                }
+
+                // Free slots and stale frames (skipped by the consumer) are reused:
+                ahead.state = Slot::kPending;
+                ahead.index = j;
+                ahead.frame = {};
+                m_executor->post([this, j]() { decode(j); });
+            }
+        }
+
+        // A miss is decoded on the calling thread, concurrently with the prefetch:
+        return hit ? frame : (*m_source)(static_cast<int>(i));
+    }
+
+    // Sequential: take the next frame in stream order and keep the ring full.
+    VideoSourceCV::Frame next()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        const std::size_t position = m_consumed++;
+        schedule();
+
+        Slot& slot = m_slots[position % m_slots.size()];
+        m_condition.wait(lock, [&]() {
+            return ((slot.state == Slot::kReady) && (slot.index == position)) || (m_eos && (position > m_end));
+        });
+
+        if ((slot.state != Slot::kReady) || (slot.index != position))
+        {
+            return {}; // past the end of the stream
+        }
+
+        VideoSourceCV::Frame frame = std::move(slot.frame);
+        slot.state = Slot::kFree;
+
+        schedule();
+
+        return frame;
+    }
+
+    // Queue stream positions while their slots are free (requires m_mutex):
+    void schedule()
+    {
+        while (!m_eos)
+        {
+            Slot& slot = m_slots[m_scheduled % m_slots.size()];
+            if (slot.state != Slot::kFree)
+            {
+                break;
+            }
+
+            slot.state = Slot::kPending;
+            slot.index = m_scheduled++;
+            m_executor->post([this]() { decodeNext(); });
+        }
+    }
+
+    void decode(std::size_t i)
+    {
+        VideoSourceCV::Frame frame;
+        if (!m_stop)
+        {
+            frame = (*m_source)(static_cast<int>(i));
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Slot& slot = m_slots[i % m_slots.size()];
+        slot.frame = std::move(frame);
+        slot.state = Slot::kReady;
+        m_condition.notify_all();
+    }
+
+    void decodeNext()
+    {
+        // Tasks may start in any order, the stream position is assigned when the frame is decoded:
+        std::lock_guard<std::mutex> decoding(m_decodeMutex);
+
+        VideoSourceCV::Frame frame;
+        if (!m_stop)
+        {
+            frame = (*m_source)(-1);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::size_t position = m_decoded++;
+        Slot& slot = m_slots[position % m_slots.size()];
+        if (frame.image.empty() && !m_eos)
+        {
+            m_eos = true; // stop queueing, the consumer sees the empty frame at m_end
+            m_end = position;
+        }
+        slot.frame = std::move(frame);
+        slot.state = Slot::kReady;
+        m_condition.notify_all();
+    }
+
+    bool m_random = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<Slot> m_slots;
+
+    // Sequential stream positions (m_decoded is guarded by m_decodeMutex):
+    std::mutex m_decodeMutex;
+    std::size_t m_consumed = 0;
+    std::size_t m_scheduled = 0;
+    std::size_t m_decoded = 0;
+    std::size_t m_end = 0; // position of the first empty frame
+    bool m_eos = false;
+
+    std::atomic<bool> m_stop{ false };
+    std::unique_ptr<drishti::core::Executor> m_executor;
+};
+
+VideoSourcePrefetch::VideoSourcePrefetch(const std::shared_ptr<VideoSourceCV>& source, std::size_t depth, int threads)
+{
+    m_impl = drishti::core::make_unique<Impl>(source, depth, threads);
+}
+
+VideoSourcePrefetch::~VideoSourcePrefetch()
+{
+}
+
+VideoSourceCV::Frame VideoSourcePrefetch::operator()(int i)
+{
+    return (*m_impl)(i);
+}
+
+bool VideoSourcePrefetch::good() const
+{
+    return m_impl->m_source->good();
+}
+
+std::size_t VideoSourcePrefetch::count() const
+{
+    return m_impl->m_source->count();
+}
+
+bool VideoSourcePrefetch::isRandomAccess() const
+{
+    return m_impl->m_source->isRandomAccess();
+}
+
+void VideoSourcePrefetch::setOutputFormat(PixelFormat value)
+{
+    m_impl->m_source->setOutputFormat(value);
+}
+
+DRISHTI_VIDEOIO_NAMESPACE_END
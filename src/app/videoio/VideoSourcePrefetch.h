@@ -0,0 +1,51 @@
+/*! -*-c++-*-
+ @file   videoio/VideoSourcePrefetch.h
+ @author David Hirvonen
+ @brief  Declaration of a VideoSource decorator that decodes frames ahead on a thread pool.
+
+ \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+ \license{This project is released under the 3 Clause BSD License.}
+
+ */
+
+#ifndef __videoio_VideoSourcePrefetch_h__
+#define __videoio_VideoSourcePrefetch_h__
+
+#include "videoio/VideoSourceCV.h"
+#include "videoio/drishti_videoio.h"
+
+#include <memory>
+
+DRISHTI_VIDEOIO_NAMESPACE_BEGIN
+
+/*
+ * Frames are decoded up to depth frames ahead of the consumer into a bounded ring of slots,
+ * so that decoding overlaps with the processing of the current frame.  Sequential sources
+ * are decoded one frame at a time in stream order (the index argument is ignored as usual).
+ * Random access sources decode the frames following the last request in parallel and finish
+ * in any order, a request outside the prefetched window is decoded on the calling thread.
+ * The decorator is thread safe (i.e., cv::parallel_for_ over frame indices), the wrapped
+ * source is only called from one thread at a time unless it is random access.  The output
+ * format must be set before the first frame is requested.
+ */
+
+class VideoSourcePrefetch : public VideoSourceCV
+{
+public:
+    class Impl;
+
+    VideoSourcePrefetch(const std::shared_ptr<VideoSourceCV>& source, std::size_t depth = 4, int threads = 2);
+    ~VideoSourcePrefetch();
+    virtual Frame operator()(int i = -1);
+    virtual bool good() const;
+    virtual std::size_t count() const;
+    virtual bool isRandomAccess() const;
+    virtual void setOutputFormat(PixelFormat value);
+
+protected:
+    std::unique_ptr<Impl> m_impl;
+};
+
+DRISHTI_VIDEOIO_NAMESPACE_END
+
+#endif // __videoio_VideoSourcePrefetch_h__
@@ -0,0 +1,381 @@
+/*! -*-c++-*-
+  @file   drishti_benchmark.h
+  @author David Hirvonen
+  @brief  Latency benchmark suite with baseline comparison (performance regression gate).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Each benchmark is run in `repeats` batches of `iterations` calls after a short warm up.
+  The table reports the per call percentiles over all calls.  The gate uses the per call
+  median of each batch: a benchmark regresses when the median of the batch medians is more
+  than `tolerance` slower than the baseline AND a one sided Mann-Whitney U test rejects
+  "not slower than baseline * (1 + tolerance)" at level `alpha`.  A single noisy batch can't
+  fail the gate, and a real slowdown fails it on the run where it is introduced.
+
+  Results and baselines are JSON (cv::FileStorage):
+
+    {
+        "benchmarks": [
+            { "name": "...", "calls": 1000, "p50": 1.0, "p90": 1.2, "p99": 1.5, "max": 3.0,
+              "tolerance": 0.1, "samples": [ 1.0, 1.01, ... ] }
+        ]
+    }
+
+  Benchmarks without baseline samples are reported but not gated, so the output of --json
+  on a reference machine can be committed as the new baseline (tolerances are kept).
+
+*/
+
+#ifndef __drishti_benchmarks_drishti_benchmark_h__
+#define __drishti_benchmarks_drishti_benchmark_h__
+
+#include "cxxopts.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace drishti
+{
+namespace benchmark
+{
+
+using HighResolutionClock = std::chrono::high_resolution_clock;
+using Microseconds = std::chrono::duration<double, std::micro>;
+
+struct Options
+{
+    int iterations = 1000;  // calls per batch
+    int repeats = 1;        // batches per benchmark
+    int cpu = -1;           // pin the calling thread to this cpu (Linux, Android)
+    float tolerance = 0.1f; // default allowed slowdown (baseline entries can override it)
+    float alpha = 0.01f;    // significance level of the slowdown test
+    std::string baseline;   // baseline JSON (no gate if empty)
+    std::string json;       // output JSON
+};
+
+// Command line options shared by the benchmark executables:
+inline void addOptions(cxxopts::Options& options, Options& opts)
+{
+    // clang-format off
+    options.add_options("benchmark")
+        ("n,iterations", "Calls per batch", cxxopts::value<int>(opts.iterations))
+        ("repeats", "Batches per benchmark", cxxopts::value<int>(opts.repeats))
+        ("cpu", "Pin the benchmark thread to this cpu", cxxopts::value<int>(opts.cpu))
+        ("baseline", "Baseline JSON (exit code is the number of regressions)", cxxopts::value<std::string>(opts.baseline))
+        ("tolerance", "Allowed slowdown vs. the baseline median", cxxopts::value<float>(opts.tolerance))
+        ("alpha", "Significance level of the slowdown test", cxxopts::value<float>(opts.alpha))
+        ("json", "Output JSON (new baseline)", cxxopts::value<std::string>(opts.json));
+    // clang-format on
+}
+
+struct Result
+{
+    std::string name;
+    int calls = 0;
+    double p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0;
+    double tolerance = 0.0;
+    std::vector<double> samples; // per call median of each batch
+};
+
+inline double median(std::vector<double> values)
+{
+    if (values.empty())
+    {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const std::size_t n = values.size();
+    return (n % 2) ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+// One sided Mann-Whitney U test (normal approximation, midranks for ties): the p value of
+// "x is not stochastically greater than y".  Returns 0 (significant) for samples too small
+// for a test, so the gate falls back to the median ratio.
+inline double mannWhitneyGreater(const std::vector<double>& x, const std::vector<double>& y)
+{
+    const std::size_t n1 = x.size(), n2 = y.size();
+    if ((n1 < 5) || (n2 < 5))
+    {
+        return 0.0;
+    }
+
+    std::vector<std::pair<double, int>> all;
+    for (auto v : x)
+    {
+        all.emplace_back(v, 0);
+    }
+    for (auto v : y)
+    {
+        all.emplace_back(v, 1);
+    }
+    std::sort(all.begin(), all.end());
+
+    double r1 = 0.0, ties = 0.0;
+    for (std::size_t i = 0; i < all.size();)
+    {
+        std::size_t j = i;
+        while ((j < all.size()) && (all[j].first == all[i].first))
+        {
+            j++;
+        }
+        const double rank = 0.5 * double(i + j + 1); // midrank of [i, j) (1 based)
+        const double t = double(j - i);
+        ties += (t * t * t - t);
+        for (std::size_t k = i; k < j; k++)
+        {
+            r1 += (all[k].second == 0) ? rank : 0.0;
+        }
+        i = j;
+    }
+
+    const double N = double(n1 + n2);
+    const double u = r1 - double(n1 * (n1 + 1)) / 2.0;
+    const double mu = double(n1 * n2) / 2.0;
+    const double sigma = std::sqrt(double(n1 * n2) / 12.0 * ((N + 1.0) - ties / (N * (N - 1.0))));
+    if (sigma <= 0.0)
+    {
+        return (u > mu) ? 0.0 : 1.0;
+    }
+    const double z = (u - mu - 0.5) / sigma; // continuity correction
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+// Pin the calling thread (the benchmarks are single threaded):
+inline bool pinThread(int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return (sched_setaffinity(0, sizeof(set), &set) == 0);
+#else
+    return false; // affinity is a hint at best (macOS, iOS)
+#endif
+}
+
+// The frequency can't be fixed from user space, the governor shows whether it is:
+inline std::string getGovernor(int cpu)
+{
+    std::ifstream is("/sys/devices/system/cpu/cpu" + std::to_string(std::max(cpu, 0)) + "/cpufreq/scaling_governor");
+    std::string governor;
+    if (is)
+    {
+        is >> governor;
+    }
+    return governor;
+}
+
+class Suite
+{
+public:
+    Suite(const Options& options, std::ostream& os = std::cout)
+        : m_options(options)
+        , m_os(os)
+    {
+        if (m_options.cpu >= 0 && !pinThread(m_options.cpu))
+        {
+            m_os << "warning: unable to pin the benchmark thread to cpu " << m_options.cpu << std::endl;
+        }
+
+        const std::string governor = getGovernor(m_options.cpu);
+        if (!governor.empty() && (governor != "performance"))
+        {
+            m_os << "warning: cpufreq governor is '" << governor << "' (use 'performance' for a fixed frequency)" << std::endl;
+        }
+
+        if (!m_options.baseline.empty())
+        {
+            readBaseline(m_options.baseline);
+        }
+
+        // clang-format off
+        m_os << std::left << std::setw(48) << "benchmark"
+             << std::right << std::setw(8) << "calls"
+             << std::setw(12) << "p50(us)"
+             << std::setw(12) << "p90(us)"
+             << std::setw(12) << "p99(us)"
+             << std::setw(12) << "max(us)"
+             << std::setw(12) << "baseline" << std::endl;
+        // clang-format on
+    }
+
+    // Run func after a short warm up and report the per call latency percentiles:
+    template <typename Func>
+    void operator()(const std::string& name, Func&& func)
+    {
+        const int iterations = std::max(1, m_options.iterations);
+        const int repeats = std::max(1, m_options.repeats);
+
+        for (int i = 0; i < std::max(1, iterations / 10); i++)
+        {
+            func();
+        }
+
+        Result result;
+        result.name = name;
+
+        std::vector<double> elapsed(iterations), all;
+        all.reserve(iterations * repeats);
+        for (int r = 0; r < repeats; r++)
+        {
+            for (auto& e : elapsed)
+            {
+                const auto tic = HighResolutionClock::now();
+                func();
+                e = Microseconds(HighResolutionClock::now() - tic).count();
+            }
+            result.samples.push_back(median(elapsed));
+            all.insert(all.end(), elapsed.begin(), elapsed.end());
+        }
+        std::sort(all.begin(), all.end());
+
+        auto percentile = [&](double p) {
+            return all[std::min(all.size() - 1, static_cast<std::size_t>(p * all.size()))];
+        };
+
+        result.calls = int(all.size());
+        result.p50 = percentile(0.50);
+        result.p90 = percentile(0.90);
+        result.p99 = percentile(0.99);
+        result.max = all.back();
+
+        const auto iter = m_baseline.find(name);
+        result.tolerance = (iter != m_baseline.end() && iter->second.tolerance > 0.0) ? iter->second.tolerance : m_options.tolerance;
+
+        // clang-format off
+        m_os << std::left << std::setw(48) << name
+             << std::right << std::setw(8) << result.calls << std::fixed << std::setprecision(2)
+             << std::setw(12) << result.p50
+             << std::setw(12) << result.p90
+             << std::setw(12) << result.p99
+             << std::setw(12) << result.max
+             << std::setw(12) << compare(result) << std::endl;
+        // clang-format on
+
+        m_results.push_back(result);
+    }
+
+    // Write the results and return the number of regressions:
+    int finish()
+    {
+        if (!m_options.json.empty())
+        {
+            writeResults(m_options.json);
+        }
+
+        for (const auto& name : m_regressions)
+        {
+            m_os << "regression: " << name << std::endl;
+        }
+        return int(m_regressions.size());
+    }
+
+    const std::vector<Result>& getResults() const { return m_results; }
+
+protected:
+    // Ratio of the medians vs. the baseline ("-" for ungated benchmarks):
+    std::string compare(const Result& result)
+    {
+        const auto iter = m_baseline.find(result.name);
+        if (iter == m_baseline.end() || iter->second.samples.empty())
+        {
+            return "-";
+        }
+
+        const auto& baseline = iter->second;
+        const double ratio = median(result.samples) / std::max(median(baseline.samples), 1e-9);
+
+        std::vector<double> limit(baseline.samples);
+        for (auto& v : limit)
+        {
+            v *= (1.0 + result.tolerance);
+        }
+
+        const bool slower = (ratio > (1.0 + result.tolerance));
+        const bool significant = (mannWhitneyGreater(result.samples, limit) < m_options.alpha);
+        if (slower && significant)
+        {
+            m_regressions.push_back(result.name);
+        }
+
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(2) << ratio << "x" << ((slower && significant) ? "!" : "");
+        return ss.str();
+    }
+
+    void readBaseline(const std::string& filename)
+    {
+        cv::FileStorage fs(filename, cv::FileStorage::READ);
+        if (!fs.isOpened())
+        {
+            m_os << "warning: unable to read baseline " << filename << std::endl;
+            return;
+        }
+
+        cv::FileNode benchmarks = fs["benchmarks"];
+        for (auto iter = benchmarks.begin(); iter != benchmarks.end(); ++iter)
+        {
+            const cv::FileNode& node = *iter;
+
+            Result result;
+            node["name"] >> result.name;
+            node["tolerance"] >> result.tolerance;
+            if (!node["samples"].empty())
+            {
+                node["samples"] >> result.samples;
+            }
+            m_baseline[result.name] = result;
+        }
+    }
+
+    void writeResults(const std::string& filename)
+    {
+        cv::FileStorage fs(filename, cv::FileStorage::WRITE | cv::FileStorage::FORMAT_JSON);
+        fs << "benchmarks"
+           << "[";
+        for (const auto& result : m_results)
+        {
+            // clang-format off
+            fs << "{"
+               << "name" << result.name
+               << "calls" << result.calls
+               << "p50" << result.p50
+               << "p90" << result.p90
+               << "p99" << result.p99
+               << "max" << result.max
+               << "tolerance" << result.tolerance
+               << "samples" << result.samples
+               << "}";
+            // clang-format on
+        }
+        fs << "]";
+    }
+
+    Options m_options;
+    std::ostream& m_os;
+
+    std::map<std::string, Result> m_baseline;
+    std::vector<Result> m_results;
+    std::vector<std::string> m_regressions;
+};
+
+} // namespace benchmark
+} // namespace drishti
+
+#endif // __drishti_benchmarks_drishti_benchmark_h__
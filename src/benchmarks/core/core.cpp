@@ -0,0 +1,222 @@
+/*! -*-c++-*-
+  @file   core.cpp
+  @author David Hirvonen
+  @brief  Latency benchmarks for the drishti_core hot paths (assignment, format conversion, conics).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  All inputs are generated with fixed seeds, so a run only depends on the machine.
+
+*/
+
+#include "drishti/core/drishti_stdlib_string.h" // android workaround
+#include "drishti/core/Logger.h"
+#include "drishti/core/LinearAssignment.h"
+#include "drishti/core/convert.h"
+#include "drishti/geometry/Ellipse.h"
+#include "drishti/geometry/intersectConicLine.h"
+#include "drishti/geometry/intersectConicRays.h"
+
+#include "common/drishti_benchmark.h"
+
+#include "cxxopts.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static volatile float sSink = 0.f; // keep benchmarked results alive
+
+// Tracker style costs: distances between two jittered point sets (fixed seed):
+static cv::Mat1f createCosts(int rows, int cols)
+{
+    cv::RNG rng(0);
+    std::vector<cv::Point2f> a(rows), b(cols);
+    for (auto& p : a)
+    {
+        p = { rng.uniform(0.f, 640.f), rng.uniform(0.f, 480.f) };
+    }
+    for (int i = 0; i < cols; i++)
+    {
+        b[i] = a[i % rows] + cv::Point2f(rng.gaussian(8.0), rng.gaussian(8.0));
+    }
+
+    cv::Mat1f cost(rows, cols);
+    for (int y = 0; y < rows; y++)
+    {
+        for (int x = 0; x < cols; x++)
+        {
+            cost(y, x) = float(cv::norm(a[y] - b[x]));
+        }
+    }
+    return cost;
+}
+
+static void benchmarkAssignment(drishti::benchmark::Suite& benchmark)
+{
+    for (const auto& size : std::vector<cv::Size>{ { 8, 8 }, { 50, 50 }, { 200, 200 }, { 150, 200 } })
+    {
+        const cv::Mat1f cost = createCosts(size.height, size.width);
+        const cv::Mat1d costd = cost;
+        const std::string dims = std::to_string(size.height) + "x" + std::to_string(size.width);
+
+        std::vector<int> assignment;
+
+        // clang-format off
+        benchmark("MinimizeLinearAssignment float " + dims, [&]()
+        {
+            sSink = sSink + drishti::core::MinimizeLinearAssignment(cost, assignment);
+        });
+
+        benchmark("MinimizeLinearAssignment double " + dims, [&]()
+        {
+            sSink = sSink + float(drishti::core::MinimizeLinearAssignment(costd, assignment));
+        });
+        // clang-format on
+    }
+}
+
+static void benchmarkConversion(const cv::Size& size, drishti::benchmark::Suite& benchmark)
+{
+    cv::RNG rng(1);
+    const std::string dims = std::to_string(size.width) + "x" + std::to_string(size.height);
+
+    cv::Mat4b rgba(size);
+    rng.fill(rgba, cv::RNG::UNIFORM, 0, 256);
+
+    cv::Mat1b y(size);
+    cv::Mat2b uv((size.height + 1) / 2, (size.width + 1) / 2);
+    rng.fill(y, cv::RNG::UNIFORM, 16, 236);
+    rng.fill(uv, cv::RNG::UNIFORM, 16, 241);
+    const auto nv21 = drishti::core::YUV420::nv21(y, uv);
+
+    // RGB planes in [0,1] (ACF input) and a gray plane (face tracker input):
+    cv::Mat1f r(size), g(size), b(size);
+    cv::Mat1b gray(size);
+
+    std::vector<drishti::core::PlaneInfo> rgb{ { r, 0, 1.f / 255.f }, { g, 1, 1.f / 255.f }, { b, 2, 1.f / 255.f } };
+    std::vector<drishti::core::PlaneInfo> rgb420{ { r, drishti::core::YUV420::kRed, 1.f / 255.f }, { g, drishti::core::YUV420::kGreen, 1.f / 255.f }, { b, drishti::core::YUV420::kBlue, 1.f / 255.f } };
+    std::vector<drishti::core::PlaneInfo> luminance{ { gray, 0 } };
+    std::vector<drishti::core::PlaneInfo> luminance420{ { gray, drishti::core::YUV420::kGray } };
+
+    // clang-format off
+    benchmark("convertU8ToF32 rgba->rgb " + dims, [&]()
+    {
+        drishti::core::convertU8ToF32(rgba, rgb);
+        sSink = sSink + r(0, 0);
+    });
+
+    benchmark("unpack rgba->gray " + dims, [&]()
+    {
+        drishti::core::unpack(rgba, luminance);
+        sSink = sSink + float(gray(0, 0));
+    });
+
+    benchmark("convertU8ToF32 nv21->rgb " + dims, [&]()
+    {
+        drishti::core::convertU8ToF32(nv21, rgb420);
+        sSink = sSink + r(0, 0);
+    });
+
+    benchmark("unpack nv21->gray " + dims, [&]()
+    {
+        drishti::core::unpack(nv21, luminance420);
+        sSink = sSink + float(gray(0, 0));
+    });
+    // clang-format on
+}
+
+// Iris style ray fan from a point inside an ellipse: the batch call vs. one line intersection
+// (and a choice of the root in the ray direction) per ray:
+static void benchmarkConicRays(int count, drishti::benchmark::Suite& benchmark)
+{
+    const cv::RotatedRect E({ 3.f, 2.f }, { 8.f, 5.f }, 30.f);
+    const cv::Matx33f C = drishti::geometry::ConicSection_<float>(E).getMatrix();
+    const cv::Point3f c(3.2f, 2.1f, 1.f);
+
+    std::vector<float> ox(count, c.x), oy(count, c.y), dx(count), dy(count), t0(count), t1(count);
+    std::vector<std::uint8_t> hits(count);
+    for (int i = 0; i < count; i++)
+    {
+        const float theta = float(i) / count * float(2.0 * M_PI);
+        dx[i] = std::cos(theta);
+        dy[i] = std::sin(theta);
+    }
+
+    const std::string dims = std::to_string(count);
+
+    // clang-format off
+    benchmark("intersectConicRays batch " + dims, [&]()
+    {
+        sSink = sSink + float(drishti::geometry::intersectConicRays(C, count, ox.data(), oy.data(), dx.data(), dy.data(), t0.data(), t1.data(), hits.data()));
+    });
+
+    benchmark("intersectConicRays scalar " + dims, [&]()
+    {
+        cv::Vec3f P[2];
+        for (int i = 0; i < count; i++)
+        {
+            const cv::Point3f v(dx[i], dy[i], 0.f);
+            drishti::geometry::intersectConicLine(C, c.cross(c + v), P);
+            const cv::Point2f p[2] = { { P[0][0] / P[0][2], P[0][1] / P[0][2] }, { P[1][0] / P[1][2], P[1][1] / P[1][2] } };
+            sSink = sSink + p[cv::Point2f(v.x, v.y).dot(p[0] - cv::Point2f(c.x, c.y)) > 0].x;
+        }
+    });
+    // clang-format on
+}
+
+int gauze_main(int argc, char** argv)
+{
+    auto logger = drishti::core::Logger::create("drishti-benchmark-core");
+
+    drishti::benchmark::Options opts;
+    cxxopts::Options options("drishti-benchmark-core", "Latency benchmarks for assignment, format conversion and conics");
+
+    // clang-format off
+    options.add_options()
+        ("h,help", "Print help message");
+    // clang-format on
+
+    drishti::benchmark::addOptions(options, opts);
+
+    options.parse(argc, argv);
+
+    if (options.count("help"))
+    {
+        std::cout << options.help({ "", "benchmark" }) << std::endl;
+        return 0;
+    }
+
+    drishti::benchmark::Suite benchmark(opts, std::cout);
+
+    benchmarkAssignment(benchmark);
+    benchmarkConversion({ 640, 480 }, benchmark);
+    benchmarkConversion({ 1280, 720 }, benchmark);
+    benchmarkConicRays(4096, benchmark);
+
+    return benchmark.finish();
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception";
+    }
+
+    return 0;
+}
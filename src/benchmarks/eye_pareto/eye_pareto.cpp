@@ -0,0 +1,323 @@
+/*! -*-c++-*-
+  @file   eye_pareto.cpp
+  @author David Hirvonen
+  @brief  Accuracy vs. latency sweep of the EyeModelEstimator settings.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The eye image and ground truth model from the eye unit tests are resized to each of the
+  requested widths. Every combination of the swept settings is timed per call and scored
+  with the sclera mask overlap used by test-drishti-eye.  The settings that are not
+  dominated by any other (lower latency and higher score) are printed as the Pareto
+  frontier.
+
+*/
+
+#include "drishti/core/drishti_stdlib_string.h" // android workaround
+#include "drishti/core/drishti_cv_cereal.h"
+#include "drishti/core/drishti_serialize.h"
+#include "drishti/core/Logger.h"
+#include "drishti/core/padding.h"
+#include "drishti/core/string_utils.h"
+#include "drishti/eye/EyeModelEstimator.h"
+
+#include "cxxopts.hpp"
+
+#include <cereal/archives/json.hpp>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using HighResolutionClock = std::chrono::high_resolution_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+static const float kAspectRatio = 4.f / 3.f;
+
+struct Settings
+{
+    int eyelidInits = 1;
+    int irisInits = 1;
+    int stages = std::numeric_limits<int>::max(); // eyelid and iris stage hints
+    bool doPupil = false;
+    bool doIndependentIrisAndPupil = true;
+    int optimizationLevel = 0;
+};
+
+struct Result
+{
+    Settings settings;
+    double latency = 0.0; // median per call (milliseconds) over all widths
+    double score = 0.0;   // mean sclera mask overlap over all widths
+};
+
+static std::ostream& operator<<(std::ostream& os, const Settings& s)
+{
+    const bool all = (s.stages == std::numeric_limits<int>::max());
+    // clang-format off
+    os << std::setw(8) << s.eyelidInits
+       << std::setw(8) << s.irisInits
+       << std::setw(8) << (all ? std::string("all") : std::to_string(s.stages))
+       << std::setw(8) << s.doPupil
+       << std::setw(8) << s.doIndependentIrisAndPupil
+       << std::setw(8) << s.optimizationLevel;
+    // clang-format on
+    return os;
+}
+
+static void printHeader(std::ostream& os)
+{
+    // clang-format off
+    os << std::setw(8) << "eyelid"
+       << std::setw(8) << "iris"
+       << std::setw(8) << "stages"
+       << std::setw(8) << "pupil"
+       << std::setw(8) << "indep"
+       << std::setw(8) << "level"
+       << std::setw(12) << "p50(ms)"
+       << std::setw(10) << "score" << std::endl;
+    // clang-format on
+}
+
+static void print(std::ostream& os, const Result& result)
+{
+    os << result.settings << std::fixed << std::setprecision(3) << std::setw(12) << result.latency << std::setw(10) << result.score << std::endl;
+}
+
+// Comma separated integers, "all" maps to the maximum value:
+static std::vector<int> parseList(const std::string& input)
+{
+    std::vector<std::string> tokens;
+    drishti::core::tokenize(input, tokens);
+
+    std::vector<int> values;
+    for (const auto& token : tokens)
+    {
+        values.push_back((token == "all") ? std::numeric_limits<int>::max() : std::stoi(token));
+    }
+    return values;
+}
+
+static void configure(drishti::eye::EyeModelEstimator& estimator, const Settings& s)
+{
+    estimator.setEyelidInits(s.eyelidInits);
+    estimator.setIrisInits(s.irisInits);
+    estimator.setEyelidStagesHint(s.stages);
+    estimator.setIrisStagesHint(s.stages);
+    estimator.setDoPupil(s.doPupil);
+    estimator.setDoIndependentIrisAndPupil(s.doIndependentIrisAndPupil);
+    estimator.setOptimizationLevel(s.optimizationLevel);
+}
+
+// Intersection over union of the sclera masks (see test-drishti-eye.cpp):
+static float detectionScore(const drishti::eye::EyeModel& truth, const drishti::eye::EyeModel& eye, const cv::Size& size)
+{
+    const cv::Mat maskA = truth.mask(size), maskB = eye.mask(size);
+    const int numerator = (maskA.empty() || maskB.empty()) ? 0 : cv::countNonZero(maskA & maskB);
+    const int denominator = (maskA.empty() || maskB.empty()) ? 0 : cv::countNonZero(maskA | maskB);
+    return denominator ? float(numerator) / float(denominator) : 0.f;
+}
+
+// Results that no other result beats in both latency and score, by increasing latency:
+static std::vector<Result> getParetoFrontier(std::vector<Result> results)
+{
+    std::sort(results.begin(), results.end(), [](const Result& a, const Result& b) {
+        return (a.latency < b.latency) || ((a.latency == b.latency) && (a.score > b.score));
+    });
+
+    std::vector<Result> frontier;
+    for (const auto& result : results)
+    {
+        if (frontier.empty() || (result.score > frontier.back().score))
+        {
+            frontier.push_back(result);
+        }
+    }
+    return frontier;
+}
+
+// Use gauze_main to support cross platform interface:
+int gauze_main(int argc, char** argv)
+{
+    auto logger = drishti::core::Logger::create("drishti-benchmark-eye-pareto");
+
+    std::string sEyeRegressor, sEyeImage, sEyeTruth;
+    std::string sWidths = "64,96,128,192,256";
+    std::string sEyelidInits = "1,2,3", sIrisInits = "1,3,5", sStages = "4,8,all";
+    std::string sPupil = "0,1", sIndependent = "0,1", sLevels = "0";
+    int iterations = 10;
+    int truthWidth = 128;
+
+    cxxopts::Options options("drishti-benchmark-eye-pareto", "Accuracy vs. latency sweep of eye model settings");
+
+    // clang-format off
+    options.add_options()
+        ("n,iterations", "Calls per setting and width", cxxopts::value<int>(iterations))
+        ("E,eye", "Eye model regressor", cxxopts::value<std::string>(sEyeRegressor))
+        ("eye-image", "Eye crop (4:3 after padding)", cxxopts::value<std::string>(sEyeImage))
+        ("eye-truth", "Ground truth eye model (JSON)", cxxopts::value<std::string>(sEyeTruth))
+        ("truth-width", "Image width of the ground truth model", cxxopts::value<int>(truthWidth))
+        ("widths", "Eye image widths", cxxopts::value<std::string>(sWidths))
+        ("eyelid-inits", "Eyelid initializations", cxxopts::value<std::string>(sEyelidInits))
+        ("iris-inits", "Iris initializations", cxxopts::value<std::string>(sIrisInits))
+        ("stages", "Eyelid and iris stage hints", cxxopts::value<std::string>(sStages))
+        ("pupil", "Pupil estimation", cxxopts::value<std::string>(sPupil))
+        ("independent", "Independent iris and pupil", cxxopts::value<std::string>(sIndependent))
+        ("levels", "Optimization levels", cxxopts::value<std::string>(sLevels))
+        ("h,help", "Print help message");
+    // clang-format on
+
+    options.parse(argc, argv);
+
+    if ((argc <= 1) || options.count("help"))
+    {
+        std::cout << options.help({ "" }) << std::endl;
+        return 0;
+    }
+
+    drishti::eye::EyeModelEstimator estimator(sEyeRegressor);
+    if (!estimator.good())
+    {
+        logger->error("Unable to load eye model {}", sEyeRegressor);
+        return 1;
+    }
+
+    cv::Mat image = cv::imread(sEyeImage, cv::IMREAD_COLOR);
+    if (image.empty())
+    {
+        logger->error("Unable to read eye image {}", sEyeImage);
+        return 1;
+    }
+
+    drishti::eye::EyeModel truth;
+    {
+        std::ifstream is(sEyeTruth);
+        if (!is)
+        {
+            logger->error("Unable to read ground truth {}", sEyeTruth);
+            return 1;
+        }
+        cereal::JSONInputArchive ia(is);
+        typedef decltype(ia) Archive; // needed by macro
+        ia(GENERIC_NVP("eye", truth));
+        truth.refine();
+    }
+
+    // Test images: the padded eye at each width:
+    cv::Mat padded;
+    drishti::core::padToAspectRatio(image, padded, kAspectRatio, drishti::core::kPaddingFast);
+
+    std::vector<cv::Mat> images;
+    for (const auto& width : parseList(sWidths))
+    {
+        const int height = static_cast<int>(static_cast<float>(width) / kAspectRatio + 0.5f);
+        cv::Mat resized;
+        cv::resize(padded, resized, { width, height }, 0, 0, cv::INTER_AREA);
+        images.push_back(resized);
+    }
+
+    // Cartesian product of the swept values:
+    std::vector<Settings> sweep(1);
+    auto expand = [&](const std::string& values, void (*apply)(Settings&, int)) {
+        std::vector<Settings> product;
+        for (const auto& s : sweep)
+        {
+            for (const auto& value : parseList(values))
+            {
+                product.push_back(s);
+                apply(product.back(), value);
+            }
+        }
+        sweep.swap(product);
+    };
+
+    // clang-format off
+    expand(sEyelidInits, [](Settings& s, int value) { s.eyelidInits = value; });
+    expand(sIrisInits, [](Settings& s, int value) { s.irisInits = value; });
+    expand(sStages, [](Settings& s, int value) { s.stages = value; });
+    expand(sPupil, [](Settings& s, int value) { s.doPupil = (value != 0); });
+    expand(sIndependent, [](Settings& s, int value) { s.doIndependentIrisAndPupil = (value != 0); });
+    expand(sLevels, [](Settings& s, int value) { s.optimizationLevel = value; });
+    // clang-format on
+
+    // The pupil is only estimated along with the independent iris:
+    sweep.erase(std::remove_if(sweep.begin(), sweep.end(), [](const Settings& s) {
+        return s.doPupil && !s.doIndependentIrisAndPupil;
+    }), sweep.end());
+
+    logger->info("{} settings x {} widths x {} calls", sweep.size(), images.size(), iterations);
+
+    printHeader(std::cout);
+
+    std::vector<Result> results;
+    for (const auto& settings : sweep)
+    {
+        configure(estimator, settings);
+
+        std::vector<double> elapsed;
+        double score = 0.0;
+        for (const auto& crop : images)
+        {
+            drishti::eye::EyeModel eye;
+            estimator(crop, eye); // warm up (and score, the estimator is deterministic)
+            eye.refine();
+            score += detectionScore(truth * (float(crop.cols) / float(truthWidth)), eye, crop.size());
+
+            for (int i = 0; i < std::max(iterations, 1); i++)
+            {
+                drishti::eye::EyeModel model;
+                const auto tic = HighResolutionClock::now();
+                estimator(crop, model);
+                elapsed.push_back(Milliseconds(HighResolutionClock::now() - tic).count());
+            }
+        }
+
+        std::nth_element(elapsed.begin(), elapsed.begin() + elapsed.size() / 2, elapsed.end());
+
+        Result result;
+        result.settings = settings;
+        result.latency = elapsed[elapsed.size() / 2];
+        result.score = score / std::max(double(images.size()), 1.0);
+        results.push_back(result);
+
+        print(std::cout, result);
+    }
+
+    std::cout << std::endl
+              << "Pareto frontier:" << std::endl;
+    printHeader(std::cout);
+    for (const auto& result : getParetoFrontier(results))
+    {
+        print(std::cout, result);
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception";
+    }
+
+    return 0;
+}
@@ -0,0 +1,332 @@
+/*! -*-c++-*-
+  @file   hci.cpp
+  @author David Hirvonen
+  @brief  End to end FaceFinder replay benchmark (offscreen OpenGL).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  A fixed sequence is replayed through FaceFinder in both pipeline modes (runFast and
+  runSimple) and one JSON report is written with the frame rate, the per stage latency
+  and GPU time percentiles (the TimerInfo histograms), the heap allocations per frame
+  and the resident memory of each run.  This is the baseline for performance changes.
+
+*/
+
+#include "drishti/core/drishti_stdlib_string.h" // android workaround
+#include "drishti/core/Logger.h"
+#include "drishti/core/Metrics.h"
+#include "drishti/core/ThreadPool.h"
+#include "drishti/core/TrainingReport.h" // resident memory
+#include "drishti/hci/FaceFinder.h"
+#include "drishti/face/FaceDetectorFactory.h"
+
+#include "aglet/GLContext.h"
+
+#include "cxxopts.hpp"
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// clang-format off
+#ifdef ANDROID
+#  define TEXTURE_FORMAT GL_RGBA
+#else
+#  define TEXTURE_FORMAT GL_BGRA
+#endif
+// clang-format on
+
+using HighResolutionClock = std::chrono::high_resolution_clock;
+
+// ### Heap allocation counts (all threads) ###
+//
+// Only operator new is counted, cv::Mat buffers use the OpenCV allocator.
+
+static std::atomic<std::uint64_t> sAllocations{ 0 };
+static std::atomic<std::uint64_t> sAllocatedBytes{ 0 };
+
+static void* allocate(std::size_t size)
+{
+    sAllocations++;
+    sAllocatedBytes += size;
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+// ### Replay ###
+
+struct BenchmarkOptions
+{
+    int frames = 300; // measured frames per pipeline
+    int warmup = 30;  // frames processed before the metrics are reset
+    int length = 60;  // frames in the (cyclic) sequence
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    int frames = 0;
+    double seconds = 0.0;
+    std::uint64_t allocations = 0;
+    std::uint64_t allocatedBytes = 0;
+    std::size_t resident = 0;
+    std::size_t peak = 0;
+    std::string metrics; // JSON
+};
+
+// A fixed, smooth and cyclic head motion (small rotation, zoom and translation) of one image:
+static std::vector<cv::Mat> createSequence(const cv::Mat& image, int length)
+{
+    std::vector<cv::Mat> frames(length);
+    const cv::Point2f center(image.cols * 0.5f, image.rows * 0.5f);
+    for (int i = 0; i < length; i++)
+    {
+        const double phase = 2.0 * M_PI * double(i) / length;
+        const double angle = 3.0 * std::sin(phase);
+        const double scale = 1.0 + 0.05 * std::sin(2.0 * phase);
+        cv::Mat M = cv::getRotationMatrix2D(center, angle, scale);
+        M.at<double>(0, 2) += 0.03 * image.cols * std::cos(phase);
+        M.at<double>(1, 2) += 0.02 * image.rows * std::sin(phase);
+        cv::warpAffine(image, frames[i], M, image.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+    }
+    return frames;
+}
+
+static BenchmarkResult benchmark(
+    std::shared_ptr<drishti::face::FaceDetectorFactory>& factory,
+    drishti::hci::FaceFinder::Settings settings,
+    const std::vector<cv::Mat>& frames,
+    const BenchmarkOptions& config)
+{
+    auto& metrics = drishti::core::Metrics::getInstance();
+
+    auto detector = drishti::hci::FaceFinder::create(factory, settings, nullptr);
+
+    const auto process = [&](int i) {
+        const cv::Mat& image = frames[i % frames.size()];
+        (*detector)({ { image.cols, image.rows }, const_cast<void*>(image.ptr<void>()), true, 0, TEXTURE_FORMAT });
+    };
+
+    for (int i = 0; i < config.warmup; i++)
+    {
+        process(i);
+    }
+    glFinish();
+
+    metrics.reset(); // exclude model loading, shader compilation and warmup
+    const std::uint64_t allocations = sAllocations, allocatedBytes = sAllocatedBytes;
+
+    const auto start = HighResolutionClock::now();
+    for (int i = 0; i < config.frames; i++)
+    {
+        process(config.warmup + i);
+    }
+    glFinish();
+    const auto stop = HighResolutionClock::now();
+
+    BenchmarkResult result;
+    result.name = settings.doOptimizedPipeline ? "fast" : "simple";
+    result.frames = config.frames;
+    result.seconds = std::chrono::duration<double>(stop - start).count();
+    result.allocations = sAllocations - allocations;
+    result.allocatedBytes = sAllocatedBytes - allocatedBytes;
+    result.resident = drishti::core::TrainingReport::getResidentMemory();
+    result.peak = drishti::core::TrainingReport::getPeakResidentMemory();
+
+    std::stringstream ss;
+    metrics.dump(ss);
+    result.metrics = ss.str();
+
+    return result;
+}
+
+static void write(std::ostream& os, const std::string& input, const cv::Size& size, const std::vector<BenchmarkResult>& results)
+{
+    os << "{\"input\":\"" << input << "\",\"width\":" << size.width << ",\"height\":" << size.height << ",\"runs\":{";
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        const auto& r = results[i];
+        const double frames = std::max(r.frames, 1);
+        os << (i ? "," : "") << "\"" << r.name << "\":{"
+           << "\"frames\":" << r.frames
+           << ",\"seconds\":" << r.seconds
+           << ",\"fps\":" << ((r.seconds > 0.0) ? (r.frames / r.seconds) : 0.0)
+           << ",\"allocations\":" << r.allocations
+           << ",\"allocations_per_frame\":" << (double(r.allocations) / frames)
+           << ",\"allocated_bytes_per_frame\":" << (double(r.allocatedBytes) / frames)
+           << ",\"memory\":{\"resident\":" << r.resident << ",\"peak\":" << r.peak << "}"
+           << ",\"metrics\":" << r.metrics << "}";
+    }
+    os << "}}" << std::endl;
+}
+
+int gauze_main(int argc, char** argv)
+{
+    auto logger = drishti::core::Logger::create("drishti-benchmark-hci");
+
+    auto factory = std::make_shared<drishti::face::FaceDetectorFactory>();
+
+    std::string sInput, sOutput;
+    BenchmarkOptions config;
+    bool doGpuTimers = true;
+    float minZ = 0.1f, maxZ = 2.f;
+
+    cxxopts::Options options("drishti-benchmark-hci", "FaceFinder replay benchmark");
+
+    // clang-format off
+    options.add_options()
+        ("i,input", "Face image (e.g., drishti_faces) for the replayed sequence", cxxopts::value<std::string>(sInput))
+        ("o,output", "Output JSON report (default: stdout)", cxxopts::value<std::string>(sOutput))
+        ("frames", "Measured frames per pipeline", cxxopts::value<int>(config.frames))
+        ("warmup", "Frames processed before the measurement", cxxopts::value<int>(config.warmup))
+        ("length", "Frames in the replayed sequence", cxxopts::value<int>(config.length))
+        ("gpu-timers", "Report GPU stage times", cxxopts::value<bool>(doGpuTimers))
+        ("min", "Closest object distance", cxxopts::value<float>(minZ))
+        ("max", "Farthest object distance", cxxopts::value<float>(maxZ))
+
+        // Bundled models (drishti_assets):
+        ("D,detector", "Face detector", cxxopts::value<std::string>(factory->sFaceDetector))
+        ("M,mean", "Face detector mean", cxxopts::value<std::string>(factory->sFaceDetectorMean))
+        ("R,regressor", "Face regressor", cxxopts::value<std::string>(factory->sFaceRegressor))
+        ("E,eye", "Eye regressor", cxxopts::value<std::string>(factory->sEyeRegressor))
+
+        ("h,help", "Print help message");
+    // clang-format on
+
+    options.parse(argc, argv);
+
+    if (options.count("help"))
+    {
+        std::cout << options.help({ "" }) << std::endl;
+        return 0;
+    }
+
+    if (factory->sFaceDetector.empty() || factory->sFaceDetectorMean.empty() || factory->sFaceRegressor.empty() || factory->sEyeRegressor.empty())
+    {
+        logger->error("Must specify the face detector, mean, regressor and eye models");
+        return 1;
+    }
+
+    cv::Mat image = cv::imread(sInput, cv::IMREAD_COLOR);
+    if (image.empty())
+    {
+        logger->error("Unable to read input image {}", sInput);
+        return 1;
+    }
+    cv::cvtColor(image, image, cv::COLOR_BGR2BGRA);
+
+    const auto frames = createSequence(image, std::max(config.length, 1));
+
+    auto opengl = aglet::GLContext::create(aglet::GLContext::kAuto, "", 640, 480);
+#if defined(_WIN32) || defined(_WIN64)
+    CV_Assert(!glewInit());
+#endif
+    (*opengl)(); // activate context
+
+    // Headless configuration (no rendering):
+    drishti::hci::FaceFinder::Settings settings;
+    settings.logger = drishti::core::Logger::create("drishti-benchmark-hci-finder");
+    settings.logger->set_level(spdlog::level::err);
+    settings.threads = drishti::core::Executor::getInstance();
+    settings.outputOrientation = 0;
+    settings.frameDelay = 2;
+    settings.doLandmarks = true;
+    settings.doFlow = false;
+    settings.doBlobs = false;
+    settings.doSingleFace = true;
+    settings.minDetectionDistance = minZ;
+    settings.maxDetectionDistance = maxZ;
+    settings.faceFinderInterval = 0.f;
+    settings.renderFaces = false;
+    settings.renderPupils = false;
+    settings.renderCorners = false;
+    settings.doGpuTimers = doGpuTimers;
+
+    { // Create a sensor specification
+        const cv::Point2f p(image.cols / 2, image.rows / 2);
+        drishti::sensor::SensorModel::Intrinsic params(p, float(image.cols), image.size());
+        settings.sensor = std::make_shared<drishti::sensor::SensorModel>(params);
+    }
+
+    // runFast (optimized pipeline) first, then runSimple:
+    std::vector<BenchmarkResult> results;
+    for (bool doOptimizedPipeline : { true, false })
+    {
+        settings.doOptimizedPipeline = doOptimizedPipeline;
+        results.push_back(benchmark(factory, settings, frames, config));
+
+        const auto& r = results.back();
+        logger->info("{}: {} frames in {:.3f}s = {:.1f} fps, {:.1f} allocations/frame", r.name, r.frames, r.seconds, (r.frames / r.seconds), double(r.allocations) / std::max(r.frames, 1));
+    }
+
+    if (sOutput.empty())
+    {
+        write(std::cout, sInput, image.size(), results);
+    }
+    else
+    {
+        std::ofstream os(sOutput);
+        if (!os)
+        {
+            logger->error("Unable to write {}", sOutput);
+            return 1;
+        }
+        write(os, sInput, image.size(), results);
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception";
+    }
+
+    return 0;
+}
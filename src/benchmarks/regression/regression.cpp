@@ -0,0 +1,360 @@
+/*! -*-c++-*-
+  @file   regression.cpp
+  @author David Hirvonen
+  @brief  Latency benchmarks for the shape regression hot paths.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Each benchmark runs a fixed input (fixed seed synthetic models or the bundled
+  drishti_assets models) and reports per call latency percentiles in microseconds.
+
+*/
+
+#include "drishti/core/drishti_stdlib_string.h" // android workaround
+#include "drishti/core/Logger.h"
+#include "drishti/ml/shape_predictor.h"
+#include "drishti/ml/RegressionTreeEnsembleShapeEstimator.h"
+#include "drishti/eye/EyeModelEstimator.h"
+#include "drishti/rcpr/CPR.h"
+
+#include "common/drishti_benchmark.h"
+
+#include "cxxopts.hpp"
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+#include <dlib/opencv/cv_image.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static volatile float sSink = 0.f; // keep benchmarked results alive
+
+struct SyntheticModel
+{
+    int parts = 68;
+    int cascades = 10;
+    int trees = 100;
+    int depth = 4;
+    int pixels = 400;
+    int components = 20; // PCA
+};
+
+// Fixed (deterministic) textured grayscale image:
+static cv::Mat createImage(const cv::Size& size)
+{
+    cv::RNG rng(0);
+    cv::Mat1b image(size);
+    rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+    cv::GaussianBlur(image, image, { 5, 5 }, 1.5);
+    return image;
+}
+
+static drishti::ml::fshape createShape(int parts, cv::RNG& rng)
+{
+    drishti::ml::fshape shape(parts * 2);
+    for (int i = 0; i < shape.size(); i++)
+    {
+        shape(i) = rng.uniform(0.2f, 0.8f);
+    }
+    return shape;
+}
+
+// Full random trees over the given number of feature pixels (fixed seed):
+static std::vector<std::vector<drishti::ml::impl::regression_tree>> createForests(const SyntheticModel& spec, int dim, bool npd, cv::RNG& rng)
+{
+    const float range = npd ? 0.25f : 32.f; // typical split threshold ranges
+    std::vector<std::vector<drishti::ml::impl::regression_tree>> forests(spec.cascades);
+    for (auto& forest : forests)
+    {
+        forest.resize(spec.trees);
+        for (auto& tree : forest)
+        {
+            for (int i = 0; i < ((1 << spec.depth) - 1); i++)
+            {
+                tree.splits.emplace_back(rng.uniform(0, spec.pixels), rng.uniform(0, spec.pixels), rng.uniform(-range, range));
+            }
+            tree.leaf_values.resize(1 << spec.depth);
+            for (auto& leaf : tree.leaf_values)
+            {
+                leaf.set_size(dim);
+                for (int k = 0; k < dim; k++)
+                {
+                    leaf(k) = rng.uniform(-0.002f, 0.002f);
+                }
+            }
+        }
+    }
+    return forests;
+}
+
+static std::shared_ptr<drishti::ml::shape_predictor> createShapePredictor(const SyntheticModel& spec, bool npd, bool pca)
+{
+    cv::RNG rng(1);
+
+    const drishti::ml::fshape initial_shape = createShape(spec.parts, rng);
+
+    drishti::ml::StandardizedPCAPtr standardizer;
+    int dim = int(initial_shape.size());
+    if (pca)
+    {
+        // Fit the PCA model to shapes jittered around the initial shape:
+        cv::Mat1f shapes(200, int(initial_shape.size()));
+        for (int i = 0; i < shapes.rows; i++)
+        {
+            for (int j = 0; j < shapes.cols; j++)
+            {
+                shapes(i, j) = initial_shape(j) + rng.gaussian(0.02);
+            }
+        }
+
+        cv::Mat projection;
+        standardizer = std::make_shared<drishti::ml::StandardizedPCA>();
+        standardizer->compute(shapes, projection, spec.components);
+        dim = spec.components;
+    }
+
+    std::vector<drishti::ml::PointVecf> pixel_coordinates(spec.cascades);
+    for (auto& coordinates : pixel_coordinates)
+    {
+        coordinates.resize(spec.pixels);
+        for (auto& p : coordinates)
+        {
+            p = drishti::ml::fpoint(rng.uniform(-0.1f, 1.1f), rng.uniform(-0.1f, 1.1f));
+        }
+    }
+
+    const auto forests = createForests(spec, dim, npd, rng);
+    auto sp = std::make_shared<drishti::ml::shape_predictor>(initial_shape, forests, pixel_coordinates, standardizer, npd);
+    sp->populate_f16(); // legacy fixed point leaves + packed layout
+    return sp;
+}
+
+static void benchmarkSynthetic(const SyntheticModel& spec, drishti::benchmark::Suite& benchmark)
+{
+    const cv::Mat gray = createImage({ 128, 128 });
+    const auto img = dlib::cv_image<uint8_t>(gray);
+    const dlib::rectangle roi(0, 0, gray.cols, gray.rows);
+
+#if DRISHTI_BUILD_REGRESSION_FIXED_POINT
+    const std::string precision = "fixed";
+#else
+    const std::string precision = "float";
+#endif
+
+    struct Variant
+    {
+        std::string name;
+        bool npd;
+        bool pca;
+    };
+
+    for (const auto& variant : std::vector<Variant>{ { "diff", false, false }, { "npd", true, false }, { "pca", false, true } })
+    {
+        const auto sp = createShapePredictor(spec, variant.npd, variant.pca);
+
+        // clang-format off
+        benchmark("shape_predictor::operator() " + precision + " " + variant.name, [&]()
+        {
+            const auto shape = (*sp)(img, roi, sp->initial_shape);
+            sSink = sSink + float(shape.part(0).x());
+        });
+        // clang-format on
+    }
+
+    // Kernel level benchmarks (first cascade of a non PCA model):
+    for (bool npd : { false, true })
+    {
+        const std::string features = npd ? "npd" : "diff";
+        const auto sp = createShapePredictor(spec, npd, false);
+        const auto& forest = sp->forests.front();
+        const auto& packed = sp->packed_forests.front();
+
+        std::vector<float> values;
+        drishti::ml::impl::extract_feature_pixel_values(img, roi, sp->initial_shape, sp->initial_shape, sp->anchor_idx.front(), sp->deltas.front(), values);
+
+        // clang-format off
+        benchmark("regression_tree::operator() " + features, [&]()
+        {
+            float sum = 0.f;
+            for (const auto& tree : forest)
+            {
+                sum += tree(values, npd)(0);
+            }
+            sSink = sSink + sum;
+        });
+
+        benchmark("packed_forest::accumulate float " + features, [&]()
+        {
+            std::vector<float> shape(packed.leaf_dim, 0.f);
+            packed.accumulate(values, npd, 0, packed.num_trees, shape.data());
+            sSink = sSink + shape[0];
+        });
+
+        if (packed.has_fixed_point())
+        {
+            benchmark("packed_forest::accumulate fixed " + features, [&]()
+            {
+                std::vector<int32_t> shape(packed.leaf_dim, 0);
+                packed.accumulate(values, npd, 0, packed.num_trees, shape.data());
+                sSink = sSink + float(shape[0]);
+            });
+        }
+
+        if (!npd)
+        {
+            benchmark("extract_feature_pixel_values", [&]()
+            {
+                drishti::ml::impl::extract_feature_pixel_values(img, roi, sp->initial_shape, sp->initial_shape, sp->anchor_idx.front(), sp->deltas.front(), values);
+                sSink = sSink + values.front();
+            });
+        }
+        // clang-format on
+    }
+}
+
+int gauze_main(int argc, char** argv)
+{
+    const auto argumentCount = argc;
+
+    auto logger = drishti::core::Logger::create("drishti-benchmark-regression");
+
+    std::string sFaceRegressor, sEyeRegressor, sIrisRegressor, sFaceImage, sEyeImage;
+    drishti::benchmark::Options opts;
+    SyntheticModel spec;
+
+    cxxopts::Options options("drishti-benchmark-regression", "Latency benchmarks for shape regression");
+
+    // clang-format off
+    options.add_options()
+        // Bundled models (drishti_assets) and fixed inputs (drishti_faces):
+        ("R,regressor", "Face landmark regressor", cxxopts::value<std::string>(sFaceRegressor))
+        ("E,eye", "Eye model regressor", cxxopts::value<std::string>(sEyeRegressor))
+        ("I,iris", "Iris CPR regressor", cxxopts::value<std::string>(sIrisRegressor))
+        ("face-image", "Face crop for the face regressor", cxxopts::value<std::string>(sFaceImage))
+        ("eye-image", "Eye crop for the eye model regressor", cxxopts::value<std::string>(sEyeImage))
+
+        // Synthetic model geometry:
+        ("parts", "Synthetic landmark count", cxxopts::value<int>(spec.parts))
+        ("cascades", "Synthetic cascade count", cxxopts::value<int>(spec.cascades))
+        ("trees", "Synthetic trees per cascade", cxxopts::value<int>(spec.trees))
+        ("depth", "Synthetic tree depth", cxxopts::value<int>(spec.depth))
+        ("pixels", "Synthetic feature pixels per cascade", cxxopts::value<int>(spec.pixels))
+        ("components", "Synthetic PCA components", cxxopts::value<int>(spec.components))
+
+        ("h,help", "Print help message");
+    // clang-format on
+
+    drishti::benchmark::addOptions(options, opts);
+
+    options.parse(argc, argv);
+
+    if (options.count("help"))
+    {
+        std::cout << options.help({ "", "benchmark" }) << std::endl;
+        return 0;
+    }
+
+    drishti::benchmark::Suite benchmark(opts, std::cout);
+
+    benchmarkSynthetic(spec, benchmark);
+
+    auto loadImage = [&](const std::string& filename, int flags, const cv::Size& size) {
+        cv::Mat image = filename.empty() ? cv::Mat() : cv::imread(filename, flags);
+        if (image.empty())
+        {
+            image = createImage(size);
+            if (flags == cv::IMREAD_COLOR)
+            {
+                cv::cvtColor(image, image, cv::COLOR_GRAY2BGR);
+            }
+        }
+        cv::resize(image, image, size, 0, 0, cv::INTER_AREA);
+        return image;
+    };
+
+    if (!sFaceRegressor.empty())
+    {
+        drishti::ml::RegressionTreeEnsembleShapeEstimator regressor(sFaceRegressor);
+        const cv::Mat crop = loadImage(sFaceImage, cv::IMREAD_GRAYSCALE, { 128, 128 });
+        const std::string name = std::string("RTEShapeEstimator::operator() face") + (regressor.isPCA() ? " pca" : "");
+
+        // clang-format off
+        benchmark(name, [&]()
+        {
+            std::vector<bool> mask;
+            std::vector<cv::Point2f> points;
+            regressor(crop, points, mask);
+            sSink = sSink + points.front().x;
+        });
+        // clang-format on
+    }
+
+    if (!sIrisRegressor.empty())
+    {
+        drishti::rcpr::CPR iris(sIrisRegressor);
+        const cv::Mat crop = loadImage(sEyeImage, cv::IMREAD_GRAYSCALE, { 128, 96 });
+        const cv::Mat mask(crop.size(), CV_8UC1, cv::Scalar::all(255));
+
+        // clang-format off
+        benchmark("CPR::cprApplyTree iris", [&]()
+        {
+            std::vector<bool> visible;
+            std::vector<cv::Point2f> points;
+            iris(crop, mask, points, visible);
+            sSink = sSink + (points.empty() ? 0.f : points.front().x);
+        });
+        // clang-format on
+    }
+
+    if (!sEyeRegressor.empty())
+    {
+        drishti::eye::EyeModelEstimator segmenter(sEyeRegressor);
+        if (!segmenter.good())
+        {
+            logger->error("Unable to load eye model {}", sEyeRegressor);
+            return 1;
+        }
+
+        const cv::Mat crop = loadImage(sEyeImage, cv::IMREAD_COLOR, { 128, 96 });
+
+        // clang-format off
+        benchmark("EyeModelEstimator::operator()", [&]()
+        {
+            drishti::eye::EyeModel eye;
+            segmenter(crop, eye);
+            sSink = sSink + eye.irisEllipse.center.x;
+        });
+        // clang-format on
+    }
+
+    if (argumentCount <= 1)
+    {
+        logger->info("Only synthetic models were benchmarked (see --help for model and image options)");
+    }
+
+    return benchmark.finish();
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception";
+    }
+
+    return 0;
+}
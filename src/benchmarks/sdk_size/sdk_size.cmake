@@ -0,0 +1,78 @@
+# Static size breakdown of the SDK by module.
+#
+# cmake
+#   -DSIZE_TOOL=<llvm-size|size>
+#   -DOBJECT_DIR=<object directory of drishti_world>
+#   -DSDK_OBJECT_DIR=<object directory of the public drishti library>
+#   -DLIBRARIES=<library files, separated by '|'>
+#   -DOUTPUT=<report.json>
+#   -P sdk_size.cmake
+#
+# The object files of drishti_world keep the source layout (Makefile and Ninja generators),
+# so each module is the sum of text, data and bss (Berkeley format) over <module>/*.o.
+# Without a size tool the object file sizes are reported instead.
+
+set(modules core geometry sensor graphics ml rcpr eye face hci)
+
+function(drishti_object_size result)
+  set(files ${ARGN})
+  list(LENGTH files count)
+  set(text 0)
+  set(data 0)
+  set(bss 0)
+  if(count GREATER 0)
+    if(SIZE_TOOL)
+      execute_process(
+        COMMAND "${SIZE_TOOL}" -B -t ${files}
+        OUTPUT_VARIABLE output
+        RESULT_VARIABLE status
+        ERROR_QUIET
+        )
+      if(NOT status EQUAL 0)
+        message(FATAL_ERROR "${SIZE_TOOL} failed (${status})")
+      endif()
+      # Last line: text data bss dec hex (TOTALS)
+      string(REGEX MATCH "([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+[0-9]+[ \t]+[0-9a-fA-F]+[ \t]+\\(TOTALS\\)" totals "${output}")
+      set(text ${CMAKE_MATCH_1})
+      set(data ${CMAKE_MATCH_2})
+      set(bss ${CMAKE_MATCH_3})
+    else()
+      foreach(file ${files})
+        file(SIZE "${file}" bytes)
+        math(EXPR text "${text} + ${bytes}")
+      endforeach()
+    endif()
+  endif()
+  set(${result} "{\"objects\":${count},\"text\":${text},\"data\":${data},\"bss\":${bss}}" PARENT_SCOPE)
+endfunction()
+
+set(entries "")
+foreach(module ${modules})
+  file(GLOB_RECURSE objects "${OBJECT_DIR}/${module}/*.o" "${OBJECT_DIR}/${module}/*.obj")
+  drishti_object_size(entry ${objects})
+  list(APPEND entries "\"${module}\":${entry}")
+endforeach()
+
+file(GLOB_RECURSE objects "${SDK_OBJECT_DIR}/*.o" "${SDK_OBJECT_DIR}/*.obj")
+drishti_object_size(entry ${objects})
+list(APPEND entries "\"sdk\":${entry}")
+string(REPLACE ";" "," entries "${entries}")
+
+set(libraries "")
+string(REPLACE "|" ";" files "${LIBRARIES}")
+foreach(library ${files})
+  if(EXISTS "${library}")
+    file(SIZE "${library}" bytes)
+    get_filename_component(name "${library}" NAME)
+    list(APPEND libraries "\"${name}\":${bytes}")
+  endif()
+endforeach()
+string(REPLACE ";" "," libraries "${libraries}")
+
+set(format "berkeley")
+if(NOT SIZE_TOOL)
+  set(format "file")
+endif()
+
+file(WRITE "${OUTPUT}" "{\"format\":\"${format}\",\"modules\":{${entries}},\"libraries\":{${libraries}}}\n")
+message(STATUS "Wrote ${OUTPUT}")
@@ -0,0 +1,248 @@
+/*! -*-c++-*-
+  @file   sdk_startup.cpp
+  @author David Hirvonen
+  @brief  Cold start benchmark for the public SDK (Context + FaceTracker with bundled models).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The first creation in the process is the cold start (page faults in the SDK code and
+  model parsing from disk), the remaining repetitions show the warm cost.  Each phase is
+  reported in milliseconds as one JSON object, together with the size of this (statically
+  linked) executable.  With an OpenGL context (DRISHTI_DO_GPU_TESTING) the first frame,
+  which completes the lazy FaceFinder initialization, is timed as well.
+
+*/
+
+#include "drishti/drishti/Context.hpp"
+#include "drishti/drishti/FaceTracker.hpp"
+#include "drishti/drishti/Sensor.hpp"
+#include "drishti/drishti/VideoFrame.hpp"
+
+// clang-format off
+#if defined(DRISHTI_DO_GPU_TESTING)
+#  include "aglet/GLContext.h"
+#endif
+// clang-format on
+
+#include "cxxopts.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// clang-format off
+#ifdef ANDROID
+#  define TEXTURE_FORMAT GL_RGBA
+#else
+#  define TEXTURE_FORMAT GL_BGRA
+#endif
+// clang-format on
+
+using HighResolutionClock = std::chrono::high_resolution_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+struct StartupTimes
+{
+    double open = 0.0;       // model streams
+    double context = 0.0;    // sdk::Context
+    double tracker = 0.0;    // sdk::FaceTracker (model parsing)
+    double firstFrame = 0.0; // lazy FaceFinder initialization (GL only)
+};
+
+struct Models
+{
+    std::string sFaceDetector, sFaceDetectorMean, sFaceRegressor, sEyeRegressor;
+};
+
+static std::size_t getFileSize(const std::string& filename)
+{
+    std::ifstream is(filename, std::ios::binary | std::ios::ate);
+    return is ? static_cast<std::size_t>(is.tellg()) : 0;
+}
+
+static StartupTimes createTracker(const Models& models, int width, int height, bool doFrame)
+{
+    StartupTimes times;
+
+    auto tic = HighResolutionClock::now();
+    const auto lap = [&tic]() {
+        const auto toc = HighResolutionClock::now();
+        const double elapsed = Milliseconds(toc - tic).count();
+        tic = toc;
+        return elapsed;
+    };
+
+    std::ifstream iFaceDetector(models.sFaceDetector, std::ios_base::binary);
+    std::ifstream iFaceDetectorMean(models.sFaceDetectorMean, std::ios_base::binary);
+    std::ifstream iFaceRegressor(models.sFaceRegressor, std::ios_base::binary);
+    std::ifstream iEyeRegressor(models.sEyeRegressor, std::ios_base::binary);
+    if (!iFaceDetector || !iFaceDetectorMean || !iFaceRegressor || !iEyeRegressor)
+    {
+        throw std::runtime_error("Unable to open the models");
+    }
+    times.open = lap();
+
+    const drishti::sdk::Vec2f p(width / 2, height / 2);
+    drishti::sdk::SensorModel::Intrinsic intrinsic(p, float(width), { width, height });
+    drishti::sdk::Matrix33f I = drishti::sdk::Matrix33f::eye();
+    drishti::sdk::SensorModel::Extrinsic extrinsic(I);
+    drishti::sdk::SensorModel sensor(intrinsic, extrinsic);
+    drishti::sdk::Context context(sensor);
+    times.context = lap();
+
+    drishti::sdk::FaceTracker::Resources resources;
+    resources.sFaceDetector = &iFaceDetector;
+    resources.sFaceRegressor = &iFaceRegressor;
+    resources.sEyeRegressor = &iEyeRegressor;
+    resources.sFaceModel = &iFaceDetectorMean;
+    drishti::sdk::FaceTracker tracker(&context, resources);
+    if (!tracker.good())
+    {
+        throw std::runtime_error("Unable to create FaceTracker");
+    }
+    times.tracker = lap();
+
+    if (doFrame)
+    {
+        std::vector<std::uint8_t> pixels(width * height * 4, 128);
+        drishti::sdk::VideoFrame frame({ width, height }, pixels.data(), true, 0, TEXTURE_FORMAT);
+        tracker(frame);
+        times.firstFrame = lap();
+    }
+
+    return times;
+}
+
+static double median(std::vector<double> values)
+{
+    if (values.empty())
+    {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+static void write(std::ostream& os, const StartupTimes& t)
+{
+    os << "{\"open\":" << t.open << ",\"context\":" << t.context << ",\"tracker\":" << t.tracker << ",\"first_frame\":" << t.firstFrame
+       << ",\"total\":" << (t.open + t.context + t.tracker + t.firstFrame) << "}";
+}
+
+int gauze_main(int argc, char** argv)
+{
+    Models models;
+    std::string sOutput;
+    int repeat = 5;
+    int width = 640, height = 480;
+
+    cxxopts::Options options("drishti-benchmark-sdk-startup", "SDK cold start benchmark");
+
+    // clang-format off
+    options.add_options()
+        ("D,detector", "Face detector", cxxopts::value<std::string>(models.sFaceDetector))
+        ("M,mean", "Face detector mean", cxxopts::value<std::string>(models.sFaceDetectorMean))
+        ("R,regressor", "Face regressor", cxxopts::value<std::string>(models.sFaceRegressor))
+        ("E,eye", "Eye regressor", cxxopts::value<std::string>(models.sEyeRegressor))
+        ("o,output", "Output JSON report (default: stdout)", cxxopts::value<std::string>(sOutput))
+        ("repeat", "Warm repetitions after the cold start", cxxopts::value<int>(repeat))
+        ("width", "Frame width", cxxopts::value<int>(width))
+        ("height", "Frame height", cxxopts::value<int>(height))
+        ("h,help", "Print help message");
+    // clang-format on
+
+    options.parse(argc, argv);
+
+    if (options.count("help"))
+    {
+        std::cout << options.help({ "" }) << std::endl;
+        return 0;
+    }
+
+    bool doFrame = false;
+#if defined(DRISHTI_DO_GPU_TESTING)
+    auto opengl = aglet::GLContext::create(aglet::GLContext::kAuto, "", 640, 480);
+#if defined(_WIN32) || defined(_WIN64)
+    if (glewInit())
+    {
+        std::cerr << "Unable to initialize glew" << std::endl;
+        return 1;
+    }
+#endif
+    (*opengl)(); // activate context
+    doFrame = true;
+#endif
+
+    const StartupTimes cold = createTracker(models, width, height, doFrame);
+
+    std::vector<StartupTimes> warm(std::max(repeat, 0));
+    for (auto& t : warm)
+    {
+        t = createTracker(models, width, height, doFrame);
+    }
+
+    const auto get = [&](double StartupTimes::*field) {
+        std::vector<double> values;
+        for (const auto& t : warm)
+        {
+            values.push_back(t.*field);
+        }
+        return median(values);
+    };
+
+    StartupTimes typical;
+    typical.open = get(&StartupTimes::open);
+    typical.context = get(&StartupTimes::context);
+    typical.tracker = get(&StartupTimes::tracker);
+    typical.firstFrame = get(&StartupTimes::firstFrame);
+
+    std::ofstream ofs;
+    if (!sOutput.empty())
+    {
+        ofs.open(sOutput);
+        if (!ofs)
+        {
+            std::cerr << "Unable to write " << sOutput << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& os = sOutput.empty() ? std::cout : ofs;
+
+    os << "{\"executable_bytes\":" << getFileSize(argv[0]) << ",\"models\":{"
+       << "\"detector\":" << getFileSize(models.sFaceDetector)
+       << ",\"mean\":" << getFileSize(models.sFaceDetectorMean)
+       << ",\"regressor\":" << getFileSize(models.sFaceRegressor)
+       << ",\"eye\":" << getFileSize(models.sEyeRegressor) << "},\"cold_ms\":";
+    write(os, cold);
+    os << ",\"warm_ms\":";
+    write(os, typical);
+    os << "}" << std::endl;
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception";
+    }
+
+    return 0;
+}
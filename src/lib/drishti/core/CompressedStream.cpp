@@ -0,0 +1,444 @@
+/*! -*-c++-*-
+  @file   CompressedStream.cpp
+  @author David Hirvonen
+  @brief  Implementation of a block compressed model container with a streaming decoder.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/CompressedStream.h"
+#include "drishti/core/ThrowAssert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+static const char kMagic[4] = { 'D', 'R', 'L', 'Z' };
+
+// ### LZ4 block format ###
+//
+// Sequences of { token, literal length+, literals, match offset (16 bit), match length+ },
+// see https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md.  The last 5 bytes are
+// literals and the last match starts at least 12 bytes before the end of the block.
+
+static const int kHashLog = 16;
+static const int kMinMatch = 4;
+static const std::size_t kLastLiterals = 5;
+static const std::size_t kMatchLimit = 12;
+static const std::size_t kMaxOffset = 65535;
+
+static std::size_t lz4Bound(std::size_t size)
+{
+    return size + (size / 255) + 16;
+}
+
+static std::uint32_t read32(const std::uint8_t* ptr)
+{
+    std::uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static std::uint8_t* writeLength(std::uint8_t* op, std::size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = static_cast<std::uint8_t>(length);
+    return op;
+}
+
+static std::uint8_t* writeSequence(std::uint8_t* op, const std::uint8_t* literals, std::size_t literalLength, std::size_t offset, std::size_t matchLength)
+{
+    std::uint8_t* token = op++;
+    *token = static_cast<std::uint8_t>(std::min(literalLength, std::size_t(15)) << 4);
+    if (literalLength >= 15)
+    {
+        op = writeLength(op, literalLength - 15);
+    }
+    std::memcpy(op, literals, literalLength);
+    op += literalLength;
+
+    if (offset)
+    {
+        *op++ = static_cast<std::uint8_t>(offset & 0xff);
+        *op++ = static_cast<std::uint8_t>(offset >> 8);
+
+        matchLength -= kMinMatch;
+        *token |= static_cast<std::uint8_t>(std::min(matchLength, std::size_t(15)));
+        if (matchLength >= 15)
+        {
+            op = writeLength(op, matchLength - 15);
+        }
+    }
+    return op;
+}
+
+// Greedy single probe compression (models are compressed offline, decoding speed is what counts):
+static std::size_t lz4Compress(const std::uint8_t* src, std::size_t size, std::uint8_t* dst, std::vector<std::uint32_t>& table)
+{
+    std::fill(table.begin(), table.end(), 0);
+
+    const std::uint8_t* end = src + size;
+    const std::uint8_t* anchor = src;
+    std::uint8_t* op = dst;
+
+    if (size > kMatchLimit)
+    {
+        const std::uint8_t* matchEnd = end - kLastLiterals;
+        for (const std::uint8_t* ip = src; ip < (end - kMatchLimit);)
+        {
+            const std::uint32_t sequence = read32(ip);
+            std::uint32_t& entry = table[(sequence * 2654435761U) >> (32 - kHashLog)];
+            const std::uint8_t* ref = src + entry;
+            entry = static_cast<std::uint32_t>(ip - src);
+
+            if ((ref < ip) && (std::size_t(ip - ref) <= kMaxOffset) && (read32(ref) == sequence))
+            {
+                const std::uint8_t* match = ip + kMinMatch;
+                while ((match < matchEnd) && (*match == ref[match - ip]))
+                {
+                    match++;
+                }
+
+                op = writeSequence(op, anchor, ip - anchor, ip - ref, match - ip);
+                anchor = ip = match;
+            }
+            else
+            {
+                ip++;
+            }
+        }
+    }
+
+    op = writeSequence(op, anchor, end - anchor, 0, 0);
+    return op - dst;
+}
+
+static bool readLength(const std::uint8_t*& ip, const std::uint8_t* end, std::size_t& length)
+{
+    for (std::uint8_t byte = 255; byte == 255; length += byte)
+    {
+        if (ip >= end)
+        {
+            return false;
+        }
+        byte = *ip++;
+    }
+    return true;
+}
+
+// Bounds checked decoding of exactly size bytes:
+static bool lz4Decompress(const std::uint8_t* src, std::size_t packed, std::uint8_t* dst, std::size_t size)
+{
+    const std::uint8_t* ip = src;
+    const std::uint8_t* end = src + packed;
+    std::uint8_t* op = dst;
+    std::uint8_t* outEnd = dst + size;
+
+    while (ip < end)
+    {
+        const std::uint8_t token = *ip++;
+
+        std::size_t literalLength = token >> 4;
+        if ((literalLength == 15) && !readLength(ip, end, literalLength))
+        {
+            return false;
+        }
+        if ((literalLength > std::size_t(end - ip)) || (literalLength > std::size_t(outEnd - op)))
+        {
+            return false;
+        }
+        std::memcpy(op, ip, literalLength);
+        op += literalLength;
+        ip += literalLength;
+
+        if (ip == end)
+        {
+            break; // the last sequence has no match
+        }
+
+        if ((end - ip) < 2)
+        {
+            return false;
+        }
+        const std::size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        std::size_t matchLength = token & 15;
+        if ((matchLength == 15) && !readLength(ip, end, matchLength))
+        {
+            return false;
+        }
+        matchLength += kMinMatch;
+
+        if (!offset || (offset > std::size_t(op - dst)) || (matchLength > std::size_t(outEnd - op)))
+        {
+            return false;
+        }
+
+        const std::uint8_t* match = op - offset;
+        if (offset >= matchLength)
+        {
+            std::memcpy(op, match, matchLength);
+            op += matchLength;
+        }
+        else
+        {
+            // Overlapping copy (i.e., runs):
+            for (std::size_t i = 0; i < matchLength; i++)
+            {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return op == outEnd;
+}
+
+static void write32(std::ostream& os, std::uint32_t value)
+{
+    const char bytes[4] = {
+        char(value & 0xff), char((value >> 8) & 0xff), char((value >> 16) & 0xff), char(value >> 24)
+    };
+    os.write(bytes, sizeof(bytes));
+}
+
+static std::uint32_t read32(std::istream& is)
+{
+    std::uint8_t bytes[4] = { 0 };
+    is.read(reinterpret_cast<char*>(bytes), sizeof(bytes));
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (std::uint32_t(bytes[3]) << 24);
+}
+
+// ### CompressedInputStream::Buffer ###
+
+class CompressedInputStream::Buffer : public std::streambuf
+{
+public:
+    Buffer(std::istream& is)
+        : m_is(is)
+    {
+        char magic[4] = { 0 };
+        m_is.read(magic, sizeof(magic));
+        drishti_throw_assert(m_is.good() && std::equal(kMagic, kMagic + 4, magic), "CompressedInputStream: invalid magic");
+
+        const std::uint32_t version = read32(m_is);
+        drishti_throw_assert(version == kVersion, "CompressedInputStream: unsupported version");
+
+        m_blockSize = read32(m_is);
+        drishti_throw_assert(m_is.good() && m_blockSize, "CompressedInputStream: invalid header");
+
+        m_origin = m_is.tellg();
+        m_next = std::async(std::launch::async, &Buffer::readBlock, this, std::vector<char>());
+    }
+
+    ~Buffer()
+    {
+        if (m_next.valid())
+        {
+            m_next.wait(); // the task reads m_is
+        }
+    }
+
+protected:
+    int_type underflow() override
+    {
+        if (gptr() < egptr())
+        {
+            return traits_type::to_int_type(*gptr());
+        }
+        return nextBlock() ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+    {
+        switch (dir)
+        {
+            case std::ios_base::beg:
+                return seekpos(pos_type(off), which);
+            case std::ios_base::cur:
+                return seekpos(pos_type(off_type(m_offset + (gptr() - eback())) + off), which);
+            default:
+                return pos_type(off_type(-1)); // the size is unknown
+        }
+    }
+
+    // Backward seeks restart the decoder from the first block:
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        const off_type target = off_type(pos);
+        if (!(which & std::ios_base::in) || (target < 0))
+        {
+            return pos_type(off_type(-1));
+        }
+
+        if (std::uint64_t(target) < m_offset)
+        {
+            rewind();
+        }
+        while (std::uint64_t(target) > (m_offset + m_block.size()))
+        {
+            if (!nextBlock())
+            {
+                return pos_type(off_type(-1));
+            }
+        }
+
+        char* base = m_block.data();
+        setg(base, base + (target - m_offset), base + m_block.size());
+        return pos;
+    }
+
+    bool nextBlock()
+    {
+        if (!m_next.valid())
+        {
+            return false; // end of container
+        }
+
+        std::vector<char> block = m_next.get(); // rethrow decoding errors
+        if (block.empty())
+        {
+            return false;
+        }
+
+        m_offset += m_block.size();
+        std::swap(m_block, block);
+
+        // Decode the next block while the caller consumes this one (recycle the storage):
+        m_next = std::async(std::launch::async, &Buffer::readBlock, this, std::move(block));
+
+        char* base = m_block.data();
+        setg(base, base, base + m_block.size());
+        return true;
+    }
+
+    void rewind()
+    {
+        std::vector<char> spare;
+        if (m_next.valid())
+        {
+            spare = m_next.get();
+        }
+
+        m_is.clear();
+        m_is.seekg(m_origin);
+        m_offset = 0;
+        m_block.clear();
+        setg(nullptr, nullptr, nullptr);
+        m_next = std::async(std::launch::async, &Buffer::readBlock, this, std::move(spare));
+    }
+
+    // Background task: returns an empty block at the end of the container.
+    std::vector<char> readBlock(std::vector<char> block)
+    {
+        const std::uint32_t rawSize = read32(m_is);
+        const std::uint32_t packedSize = read32(m_is);
+        drishti_throw_assert(m_is.good(), "CompressedInputStream: truncated stream");
+
+        block.resize(rawSize);
+        if (rawSize)
+        {
+            drishti_throw_assert((rawSize <= m_blockSize) && (packedSize <= lz4Bound(rawSize)), "CompressedInputStream: invalid block");
+            if (packedSize == rawSize)
+            {
+                m_is.read(block.data(), rawSize);
+                drishti_throw_assert(m_is.good(), "CompressedInputStream: truncated stream");
+            }
+            else
+            {
+                m_packed.resize(packedSize);
+                m_is.read(m_packed.data(), packedSize);
+                drishti_throw_assert(m_is.good(), "CompressedInputStream: truncated stream");
+
+                const auto* src = reinterpret_cast<const std::uint8_t*>(m_packed.data());
+                auto* dst = reinterpret_cast<std::uint8_t*>(block.data());
+                drishti_throw_assert(lz4Decompress(src, packedSize, dst, rawSize), "CompressedInputStream: corrupt block");
+            }
+        }
+        return block;
+    }
+
+    std::istream& m_is;
+    std::istream::pos_type m_origin; // first block
+    std::uint32_t m_blockSize = 0;
+
+    std::vector<char> m_block; // current block
+    std::uint64_t m_offset = 0; // uncompressed position of m_block
+
+    std::future<std::vector<char>> m_next; // next block (at most one task reads m_is)
+    std::vector<char> m_packed;            // task storage
+};
+
+// ### CompressedInputStream ###
+
+CompressedInputStream::CompressedInputStream(std::istream& is)
+    : std::istream(nullptr)
+    , m_buffer(new Buffer(is))
+{
+    rdbuf(m_buffer.get());
+}
+
+CompressedInputStream::~CompressedInputStream() = default;
+
+bool isCompressed(std::istream& is)
+{
+    char magic[4] = { 0 };
+    const auto position = is.tellg();
+    is.read(magic, sizeof(magic));
+    const bool good = is.good() && std::equal(kMagic, kMagic + 4, magic);
+    is.clear();
+    is.seekg(position);
+    return good;
+}
+
+bool isCompressed(const std::string& filename)
+{
+    std::ifstream is(filename, std::ios::binary);
+    return is.good() && isCompressed(is);
+}
+
+void compress(std::istream& is, std::ostream& os, std::size_t blockSize)
+{
+    drishti_throw_assert((blockSize > 0) && (blockSize <= 0xffffffffU), "compress: invalid block size");
+
+    os.write(kMagic, sizeof(kMagic));
+    write32(os, CompressedInputStream::kVersion);
+    write32(os, static_cast<std::uint32_t>(blockSize));
+
+    std::vector<char> raw(blockSize);
+    std::vector<std::uint8_t> packed(lz4Bound(blockSize));
+    std::vector<std::uint32_t> table(std::size_t(1) << kHashLog);
+    while (is.read(raw.data(), blockSize), is.gcount() > 0)
+    {
+        const std::size_t rawSize = static_cast<std::size_t>(is.gcount());
+        const std::size_t packedSize = lz4Compress(reinterpret_cast<const std::uint8_t*>(raw.data()), rawSize, packed.data(), table);
+
+        // Incompressible blocks are stored:
+        const bool doStore = (packedSize >= rawSize);
+        write32(os, static_cast<std::uint32_t>(rawSize));
+        write32(os, static_cast<std::uint32_t>(doStore ? rawSize : packedSize));
+        if (doStore)
+        {
+            os.write(raw.data(), rawSize);
+        }
+        else
+        {
+            os.write(reinterpret_cast<const char*>(packed.data()), packedSize);
+        }
+    }
+
+    write32(os, 0);
+    write32(os, 0);
+    drishti_throw_assert(os.good(), "compress: write failed");
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,61 @@
+/*! -*-c++-*-
+  @file   CompressedStream.h
+  @author David Hirvonen
+  @brief  Declaration of a block compressed model container with a streaming decoder.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_CompressedStream_h__
+#define __drishti_core_CompressedStream_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Layout (little endian):
+ *
+ *   Header  : magic "DRLZ", version, block size
+ *   Block[] : raw size, packed size, data (LZ4 block format, stored as is if packed size == raw size)
+ *   End     : raw size 0, packed size 0
+ *
+ * Blocks are compressed independently, so the reader decodes block i+1 on a background
+ * thread while the caller deserializes block i.  LZ4 decoding is much faster than the
+ * deserialization, so a compressed model loads as fast as the raw one (with less I/O).
+ * Any stream can be wrapped, i.e., cereal archives, FlatArchive or acf models.
+ */
+
+class CompressedInputStream : public std::istream
+{
+public:
+    static const std::uint32_t kVersion = 1;
+    static const std::size_t kBlockSize = 1 << 20;
+
+    // Decode the container at the current position of is (must outlive this stream):
+    explicit CompressedInputStream(std::istream& is);
+    ~CompressedInputStream();
+
+    class Buffer;
+
+protected:
+    std::unique_ptr<Buffer> m_buffer;
+};
+
+// Check the magic without consuming the stream:
+bool isCompressed(std::istream& is);
+bool isCompressed(const std::string& filename);
+
+// Compress the remainder of is (i.e., a serialized model) in blocks of blockSize bytes:
+void compress(std::istream& is, std::ostream& os, std::size_t blockSize = CompressedInputStream::kBlockSize);
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_CompressedStream_h__
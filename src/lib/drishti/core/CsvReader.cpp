@@ -0,0 +1,253 @@
+/*! -*-c++-*-
+  @file   CsvReader.cpp
+  @author David Hirvonen
+  @brief  Implementation of a zero copy CSV tokenizer for large memory mapped files.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/CsvReader.h"
+#include "drishti/core/FlatArchive.h"
+#include "drishti/core/ParallelFor.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+// ### CsvField ###
+
+std::string CsvField::str() const
+{
+    if (!quoted)
+    {
+        return std::string(data, size);
+    }
+
+    std::string value; // "" -> "
+    value.reserve(size);
+    for (std::uint32_t i = 0; i < size; i++)
+    {
+        value.push_back(data[i]);
+        i += (data[i] == '"');
+    }
+    return value;
+}
+
+// Fields aren't null terminated, numbers are copied to the stack first:
+template <typename T, typename Convert>
+static bool parseNumber(const CsvField& field, T& value, Convert&& convert)
+{
+    char text[64];
+    if ((field.size == 0) || (field.size >= sizeof(text)))
+    {
+        return false;
+    }
+    std::memcpy(text, field.data, field.size);
+    text[field.size] = 0;
+
+    char* end = nullptr;
+    errno = 0;
+    value = static_cast<T>(convert(text, &end));
+    return (end == (text + field.size)) && (errno == 0);
+}
+
+bool parse(const CsvField& field, int& value)
+{
+    long long result = 0;
+    const bool success = parse(field, result) && (result >= std::numeric_limits<int>::min()) && (result <= std::numeric_limits<int>::max());
+    value = static_cast<int>(result);
+    return success;
+}
+
+bool parse(const CsvField& field, long long& value)
+{
+    return parseNumber(field, value, [](const char* text, char** end) { return std::strtoll(text, end, 10); });
+}
+
+bool parse(const CsvField& field, float& value)
+{
+    return parseNumber(field, value, [](const char* text, char** end) { return std::strtof(text, end); });
+}
+
+bool parse(const CsvField& field, double& value)
+{
+    return parseNumber(field, value, [](const char* text, char** end) { return std::strtod(text, end); });
+}
+
+bool parse(const CsvField& field, std::string& value)
+{
+    value = field.str();
+    return true;
+}
+
+// ### CsvReader ###
+
+CsvReader::CsvReader(const std::string& filename, Executor* pool, char separator)
+    : m_separator(separator)
+{
+    std::size_t size = 0;
+    m_data = FlatArchive::mapFile(filename, size);
+    tokenize(static_cast<const char*>(m_data.get()), size, pool);
+}
+
+CsvReader::CsvReader(const char* data, std::size_t size, Executor* pool, char separator)
+    : m_separator(separator)
+{
+    tokenize(data, size, pool);
+}
+
+int CsvReader::getColumnIndex(const char* name) const
+{
+    for (std::size_t col = 0; rows() && (col < cols(0)); col++)
+    {
+        if ((*this)(0, col) == name)
+        {
+            return static_cast<int>(col);
+        }
+    }
+    return -1;
+}
+
+void CsvReader::tokenize(const char* data, std::size_t size, Executor* pool)
+{
+    const char* end = data + size;
+
+    // Chunks start after a newline outside of quotes, "" escapes don't change the parity:
+    std::vector<const char*> starts{ data };
+    const std::size_t count = std::max(size / kChunkSize, std::size_t(1));
+    for (std::size_t i = 1; i < count; i++)
+    {
+        const char* ptr = std::max(data + (size * i) / count, starts.back());
+        bool quoted = (std::count(starts.back(), ptr, '"') % 2) != 0;
+        for (; ptr < end; ptr++)
+        {
+            if (*ptr == '"')
+            {
+                quoted = !quoted;
+            }
+            else if ((*ptr == '\n') && !quoted)
+            {
+                break;
+            }
+        }
+        if (++ptr >= end)
+        {
+            break;
+        }
+        starts.push_back(ptr);
+    }
+    starts.push_back(end);
+
+    std::vector<Chunk> chunks(starts.size() - 1);
+    parallel_for(pool, static_cast<int>(chunks.size()), [&](int i) {
+        tokenize(starts[i], starts[i + 1], chunks[i]);
+    });
+
+    // Concatenate the chunks (row ends are made absolute):
+    std::size_t fields = 0, rows = 0;
+    for (const auto& chunk : chunks)
+    {
+        fields += chunk.fields.size();
+        rows += chunk.rowEnd.size();
+    }
+
+    m_fields.reserve(fields);
+    m_rowEnd.reserve(rows);
+    for (const auto& chunk : chunks)
+    {
+        const std::size_t offset = m_fields.size();
+        m_fields.insert(m_fields.end(), chunk.fields.begin(), chunk.fields.end());
+        for (auto rowEnd : chunk.rowEnd)
+        {
+            m_rowEnd.push_back(offset + rowEnd);
+        }
+    }
+}
+
+void CsvReader::tokenize(const char* begin, const char* end, Chunk& chunk) const
+{
+    if (begin == end)
+    {
+        return;
+    }
+
+    const auto isBlank = [](char c) { return (c == ' ') || (c == '\t') || (c == '\r'); };
+    const auto field = [](const char* first, const char* last, bool quoted) {
+        return CsvField{ first, static_cast<std::uint32_t>(last - first), quoted };
+    };
+
+    // Reserve from the first line length (typical manifests have constant width records):
+    const char* eol = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+    const std::size_t fieldsPerLine = std::count(begin, eol ? eol : end, m_separator) + 1;
+    const std::size_t lines = eol ? ((end - begin) / (eol - begin + 1)) : 1;
+    chunk.fields.reserve(fieldsPerLine * lines);
+    chunk.rowEnd.reserve(lines);
+
+    const char* ptr = begin;
+    while (ptr < end)
+    {
+        const std::size_t first = chunk.fields.size();
+        for (bool more = true; more;)
+        {
+            while ((ptr < end) && isBlank(*ptr))
+            {
+                ptr++;
+            }
+
+            if ((ptr < end) && (*ptr == '"'))
+            {
+                const char* start = ++ptr;
+                for (;; ptr += 2)
+                {
+                    ptr = static_cast<const char*>(std::memchr(ptr, '"', end - ptr));
+                    drishti_throw_assert(ptr, "CsvReader: unterminated quoted field");
+                    if ((ptr + 1 >= end) || (ptr[1] != '"'))
+                    {
+                        break;
+                    }
+                }
+                chunk.fields.push_back(field(start, ptr++, true));
+
+                // Anything after the closing quote (up to the separator) is ignored:
+                while ((ptr < end) && (*ptr != m_separator) && (*ptr != '\n'))
+                {
+                    ptr++;
+                }
+            }
+            else
+            {
+                const char* start = ptr;
+                while ((ptr < end) && (*ptr != m_separator) && (*ptr != '\n'))
+                {
+                    ptr++;
+                }
+                const char* last = ptr;
+                while ((last > start) && isBlank(last[-1]))
+                {
+                    last--;
+                }
+                chunk.fields.push_back(field(start, last, false));
+            }
+
+            more = (ptr < end) && (*ptr == m_separator);
+            ptr += (ptr < end); // separator or newline
+        }
+
+        // Skip empty lines (a single empty field):
+        if ((chunk.fields.size() == first + 1) && !chunk.fields.back().size && !chunk.fields.back().quoted)
+        {
+            chunk.fields.pop_back();
+        }
+        else
+        {
+            chunk.rowEnd.push_back(chunk.fields.size());
+        }
+    }
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,116 @@
+/*! -*-c++-*-
+  @file   CsvReader.h
+  @author David Hirvonen
+  @brief  Declaration of a zero copy CSV tokenizer for large memory mapped files.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_CsvReader_h__
+#define __drishti_core_CsvReader_h__
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/ThrowAssert.h"
+#include "drishti/core/drishti_stdlib_string.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class Executor;
+
+/*
+ * Fields are views into the buffer (a read only mapping of the file), nothing is copied until
+ * a value is converted.  Quoted fields may contain separators, newlines and "" escapes, the
+ * view excludes the quotes (use str() for the unescaped value).  Leading and trailing blanks
+ * and '\r' are trimmed, empty lines are skipped.
+ *
+ * Large buffers are tokenized in parallel chunks that start at record boundaries (newlines
+ * outside of quotes), the rows are in file order.  This replaces the CsvGrammar (Spirit) in
+ * drishti_csv.h for large files, which copies every field into a std::string.
+ */
+
+struct CsvField
+{
+    bool operator==(const char* text) const
+    {
+        return (std::strlen(text) == size) && !std::memcmp(text, data, size);
+    }
+
+    std::string str() const; // unescaped
+
+    const char* data;
+    std::uint32_t size;
+    bool quoted;
+};
+
+// Typed conversion of a whole field, true on success:
+bool parse(const CsvField& field, int& value);
+bool parse(const CsvField& field, long long& value);
+bool parse(const CsvField& field, float& value);
+bool parse(const CsvField& field, double& value);
+bool parse(const CsvField& field, std::string& value);
+
+class CsvReader
+{
+public:
+    static const std::size_t kChunkSize = 1 << 22; // bytes per parallel task
+
+    // Map the file (the reader keeps the mapping alive):
+    CsvReader(const std::string& filename, Executor* pool = nullptr, char separator = ',');
+
+    // Tokenize a caller supplied buffer (must outlive the reader):
+    CsvReader(const char* data, std::size_t size, Executor* pool = nullptr, char separator = ',');
+
+    std::size_t rows() const { return m_rowEnd.size(); }
+    std::size_t cols(std::size_t row) const { return m_rowEnd[row] - begin(row); }
+
+    const CsvField& operator()(std::size_t row, std::size_t col) const
+    {
+        drishti_throw_assert(col < cols(row), "CsvReader: column out of range");
+        return m_fields[begin(row) + col];
+    }
+
+    // Index of a column name in the first row (-1 if not found):
+    int getColumnIndex(const char* name) const;
+
+    // Convert one column of all rows starting at first (i.e., 1 to skip a header):
+    template <typename T>
+    std::vector<T> getColumn(std::size_t col, std::size_t first = 1) const
+    {
+        std::vector<T> values(rows() > first ? (rows() - first) : 0);
+        for (std::size_t row = first; row < rows(); row++)
+        {
+            drishti_throw_assert(parse((*this)(row, col), values[row - first]), "CsvReader: invalid value in row " + std::to_string(row));
+        }
+        return values;
+    }
+
+protected:
+    std::size_t begin(std::size_t row) const { return row ? m_rowEnd[row - 1] : 0; }
+
+    struct Chunk
+    {
+        std::vector<CsvField> fields;
+        std::vector<std::size_t> rowEnd; // relative to the chunk
+    };
+
+    void tokenize(const char* data, std::size_t size, Executor* pool);
+    void tokenize(const char* begin, const char* end, Chunk& chunk) const;
+
+    std::shared_ptr<const void> m_data; // mapping (optional)
+    char m_separator = ',';
+
+    std::vector<CsvField> m_fields;
+    std::vector<std::size_t> m_rowEnd; // exclusive end of each row in m_fields
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_CsvReader_h__
@@ -0,0 +1,230 @@
+/*! -*-c++-*-
+  @file   Executor.cpp
+  @author David Hirvonen
+  @brief  Implementation of a work stealing executor with priority lanes and core affinity.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/Executor.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+static long getMaxFrequency(int cpu)
+{
+    std::stringstream ss;
+    ss << "/sys/devices/system/cpu/cpu" << cpu << "/cpufreq/cpuinfo_max_freq";
+
+    long frequency = 0;
+    std::ifstream is(ss.str());
+    return (is >> frequency) ? frequency : 0;
+}
+
+static void setAffinity(const std::vector<int>& cores)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto& cpu : cores)
+    {
+        CPU_SET(cpu, &set);
+    }
+    sched_setaffinity(0, sizeof(set), &set); // best effort
+#else
+    (void)cores; // the OS scheduler decides (i.e., iOS, OS X and Windows)
+#endif
+}
+
+std::vector<int> Executor::getCores(CoreClass type)
+{
+    const int count = std::max(int(std::thread::hardware_concurrency()), 1);
+
+    std::vector<int> cores(count);
+    std::vector<long> frequencies(count);
+    for (int i = 0; i < count; i++)
+    {
+        cores[i] = i;
+        frequencies[i] = getMaxFrequency(i);
+    }
+
+    const auto range = std::minmax_element(frequencies.begin(), frequencies.end());
+    if ((type == kAnyCore) || (*range.first == 0) || (*range.first == *range.second))
+    {
+        return cores; // symmetric or unknown
+    }
+
+    std::vector<int> selection;
+    for (int i = 0; i < count; i++)
+    {
+        if ((frequencies[i] == *range.second) == (type == kBigCores))
+        {
+            selection.push_back(i);
+        }
+    }
+    return selection;
+}
+
+Executor::Executor()
+    : Executor(Options())
+{
+}
+
+Executor::Executor(const Options& options)
+{
+    const auto cores = getCores(options.affinity);
+    const int count = (options.threads > 0) ? options.threads : int(cores.size());
+    const auto pinned = (options.affinity == kAnyCore) ? std::vector<int>() : cores;
+
+    for (int i = 0; i < count; i++)
+    {
+        m_workers.emplace_back(new Worker);
+    }
+
+    // Workers wait for m_ids before they start:
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (int i = 0; i < count; i++)
+    {
+        m_threads.emplace_back([this, i, pinned]() { work(i, pinned); });
+        m_ids.push_back(m_threads.back().get_id());
+    }
+}
+
+Executor::~Executor()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_condition.notify_all();
+    }
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+int Executor::getWorkerIndex() const
+{
+    const auto id = std::this_thread::get_id();
+    const auto iter = std::find(m_ids.begin(), m_ids.end(), id);
+    return (iter == m_ids.end()) ? -1 : int(std::distance(m_ids.begin(), iter));
+}
+
+void Executor::post(Task task, Priority priority)
+{
+    // Workers keep their own tasks, other threads spread them out:
+    int index = getWorkerIndex();
+    if (index < 0)
+    {
+        index = int(m_next++ % m_workers.size());
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->tasks[priority].push_back(std::move(task));
+    }
+
+    // Increment after the push (and decrement after the pop), so a pending count implies a task:
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_pending++;
+    m_condition.notify_one();
+}
+
+bool Executor::steal(int index, int priority, Task& task)
+{
+    const int count = int(m_workers.size());
+    for (int i = 1; i < count; i++)
+    {
+        auto& victim = *m_workers[(index + i) % count];
+        std::unique_lock<std::mutex> lock(victim.mutex);
+        auto& tasks = victim.tasks[priority];
+        if (!tasks.empty())
+        {
+            task = std::move(tasks.front()); // oldest first
+            tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Executor::pop(int index, Task& task)
+{
+    auto& worker = *m_workers[index];
+    for (int priority = 0; priority < kPriorityCount; priority++)
+    {
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            auto& tasks = worker.tasks[priority];
+            if (!tasks.empty())
+            {
+                task = std::move(tasks.back()); // most recent first
+                tasks.pop_back();
+                m_pending--;
+                return true;
+            }
+        }
+
+        if (steal(index, priority, task))
+        {
+            m_pending--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Executor::work(int index, const std::vector<int>& cores)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+    }
+
+    if (!cores.empty())
+    {
+        setAffinity(cores);
+    }
+
+    Task task;
+    while (true)
+    {
+        if (pop(index, task))
+        {
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                // process() reports through the future, a posted task has nobody to report to
+            }
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [&]() { return (m_pending > 0) || m_stop; });
+        if (m_stop && (m_pending == 0))
+        {
+            break;
+        }
+    }
+}
+
+std::shared_ptr<Executor> Executor::getInstance()
+{
+    static std::shared_ptr<Executor> instance = std::make_shared<Executor>();
+    return instance;
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,120 @@
+/*! -*-c++-*-
+  @file   Executor.h
+  @author David Hirvonen
+  @brief  Declaration of a work stealing executor with priority lanes and core affinity.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_Executor_h__
+#define __drishti_core_Executor_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Each worker owns a deque per priority lane.  Tasks posted from a worker are pushed to the
+ * back of its own deque and popped from the back (the most recent, cache warm work first),
+ * while idle workers steal from the front of the other deques.  Latency critical (frame) work
+ * always runs before background work.  Workers can be restricted to the big or little cores
+ * of asymmetric (big.LITTLE) CPUs, which are identified by their maximum frequency.
+ *
+ * The process(), post() interface matches tp::ThreadPool<>, which this replaces.
+ */
+
+class Executor
+{
+public:
+    using Task = std::function<void()>;
+
+    enum Priority
+    {
+        kLatency,    // frame work: detection, regression, eye models
+        kBackground, // logging, callbacks, training
+        kPriorityCount
+    };
+
+    enum CoreClass
+    {
+        kAnyCore,
+        kBigCores,
+        kLittleCores
+    };
+
+    struct Options
+    {
+        int threads = 0; // 0 : one per core in the selected class
+        CoreClass affinity = kAnyCore;
+    };
+
+    Executor();
+    Executor(const Options& options);
+    ~Executor(); // runs the pending tasks
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    void post(Task task, Priority priority = kLatency);
+
+    template <typename Callable>
+    auto process(Callable&& function, Priority priority = kLatency) -> std::future<decltype(function())>
+    {
+        using Result = decltype(function());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Callable>(function));
+        auto result = task->get_future();
+        post([task]() { (*task)(); }, priority);
+        return result;
+    }
+
+    int size() const { return int(m_threads.size()); }
+
+    // Queued tasks not yet started (approximate, i.e., for telemetry):
+    int getPending() const { return m_pending.load(std::memory_order_relaxed); }
+
+    // Index of the calling worker thread (-1 for other threads):
+    int getWorkerIndex() const;
+
+    // The process wide executor (default options), shared by everything that doesn't specify one:
+    static std::shared_ptr<Executor> getInstance();
+
+    // Cores in the requested class (all cores if the CPU isn't asymmetric or can't be queried):
+    static std::vector<int> getCores(CoreClass type);
+
+protected:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks[kPriorityCount];
+    };
+
+    void work(int index, const std::vector<int>& cores);
+    bool pop(int index, Task& task);
+    bool steal(int index, int priority, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::vector<std::thread::id> m_ids;
+
+    std::mutex m_mutex; // parking
+    std::condition_variable m_condition;
+    std::atomic<int> m_pending{ 0 };
+    std::atomic<unsigned> m_next{ 0 }; // round robin for external posts
+    std::atomic<bool> m_stop{ false };
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_Executor_h__
@@ -0,0 +1,245 @@
+/*! -*-c++-*-
+  @file   FlatArchive.cpp
+  @author David Hirvonen
+  @brief  Implementation of a versioned flat binary container for arrays used in place.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/FlatArchive.h"
+#include "drishti/core/ThrowAssert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// clang-format off
+#if !(defined(_WIN32) || defined(_WIN64))
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define DRISHTI_FLAT_ARCHIVE_MMAP 1
+#endif
+// clang-format on
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+static const char kMagic[4] = { 'D', 'R', 'F', 'A' };
+static const std::uint32_t kByteOrder = 0x01020304;
+
+static std::size_t align(std::size_t offset)
+{
+    return (offset + FlatArchive::kAlignment - 1) & ~(FlatArchive::kAlignment - 1);
+}
+
+// ((((((((((((((( FlatArchive )))))))))))))))
+
+FlatArchive::FlatArchive(const void* data, std::size_t size, std::shared_ptr<const void> owner)
+    : m_data(static_cast<const std::uint8_t*>(data))
+    , m_size(size)
+    , m_owner(owner)
+{
+    drishti_throw_assert(m_data && (size >= sizeof(Header)), "FlatArchive: truncated header");
+    drishti_throw_assert((reinterpret_cast<std::uintptr_t>(m_data) % 16) == 0, "FlatArchive: buffer must be 16 byte aligned");
+
+    Header header;
+    std::memcpy(&header, m_data, sizeof(header));
+    drishti_throw_assert(std::equal(kMagic, kMagic + 4, header.magic), "FlatArchive: invalid magic");
+    drishti_throw_assert(header.byteOrder == kByteOrder, "FlatArchive: incompatible byte order");
+    drishti_throw_assert(header.version == kVersion, "FlatArchive: unsupported version");
+    drishti_throw_assert((sizeof(Header) + std::size_t(header.count) * sizeof(Entry)) <= size, "FlatArchive: truncated entry table");
+
+    m_count = header.count;
+    m_entries = reinterpret_cast<const Entry*>(m_data + sizeof(Header));
+    for (std::uint32_t i = 0; i < m_count; i++)
+    {
+        const Entry& entry = m_entries[i];
+        drishti_throw_assert(entry.name[sizeof(entry.name) - 1] == 0, "FlatArchive: invalid entry name");
+        drishti_throw_assert((entry.offset % kAlignment) == 0, "FlatArchive: misaligned entry");
+        drishti_throw_assert(entry.offset <= size && (entry.count * entry.elementSize) <= (size - entry.offset), "FlatArchive: truncated entry");
+    }
+}
+
+FlatArchive::~FlatArchive() = default;
+
+std::shared_ptr<FlatArchive> FlatArchive::map(const std::string& filename)
+{
+    std::size_t size = 0;
+    auto owner = mapFile(filename, size);
+    return std::make_shared<FlatArchive>(owner.get(), size, owner);
+}
+
+std::shared_ptr<const void> FlatArchive::mapFile(const std::string& filename, std::size_t& size)
+{
+#if DRISHTI_FLAT_ARCHIVE_MMAP
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    drishti_throw_assert(fd >= 0, "FlatArchive: unable to open " + filename);
+
+    struct stat info;
+    if ((::fstat(fd, &info) != 0) || (info.st_size <= 0))
+    {
+        ::close(fd);
+        drishti_throw_assert(false, "FlatArchive: unable to stat " + filename);
+    }
+
+    const std::size_t length = static_cast<std::size_t>(info.st_size);
+    void* data = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping holds its own reference
+    drishti_throw_assert(data != MAP_FAILED, "FlatArchive: unable to map " + filename);
+
+    size = length;
+    return std::shared_ptr<const void>(data, [length](const void* ptr) { ::munmap(const_cast<void*>(ptr), length); });
+#else
+    std::ifstream is(filename, std::ios::binary);
+    drishti_throw_assert(is.good(), "FlatArchive: unable to open " + filename);
+    const std::string content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+    auto buffer = std::make_shared<std::vector<std::uint8_t>>(content.size() + kAlignment);
+    auto* data = reinterpret_cast<std::uint8_t*>(align(reinterpret_cast<std::uintptr_t>(buffer->data())));
+    std::memcpy(data, content.data(), content.size());
+
+    size = content.size();
+    return std::shared_ptr<const void>(buffer, data); // aliasing constructor
+#endif
+}
+
+std::shared_ptr<FlatArchive> FlatArchive::read(std::istream& is)
+{
+    const std::string content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+    // Private copy with the array alignment (std::vector<> data is not over aligned):
+    auto buffer = std::make_shared<std::vector<std::uint8_t>>(content.size() + kAlignment);
+    auto* data = reinterpret_cast<std::uint8_t*>(align(reinterpret_cast<std::uintptr_t>(buffer->data())));
+    std::memcpy(data, content.data(), content.size());
+    return std::make_shared<FlatArchive>(data, content.size(), buffer);
+}
+
+bool FlatArchive::isFlat(std::istream& is)
+{
+    char magic[4] = { 0 };
+    const auto position = is.tellg();
+    is.read(magic, sizeof(magic));
+    const bool good = is.good() && std::equal(kMagic, kMagic + 4, magic);
+    is.clear();
+    is.seekg(position);
+    return good;
+}
+
+bool FlatArchive::isFlat(const std::string& filename)
+{
+    std::ifstream is(filename, std::ios::binary);
+    return is.good() && isFlat(is);
+}
+
+const FlatArchive::Entry* FlatArchive::find(const std::string& name) const
+{
+    for (std::uint32_t i = 0; i < m_count; i++)
+    {
+        if (name == m_entries[i].name)
+        {
+            return &m_entries[i];
+        }
+    }
+    return nullptr;
+}
+
+bool FlatArchive::has(const std::string& name) const
+{
+    return find(name) != nullptr;
+}
+
+std::vector<std::string> FlatArchive::getNames() const
+{
+    std::vector<std::string> names;
+    for (std::uint32_t i = 0; i < m_count; i++)
+    {
+        names.emplace_back(m_entries[i].name);
+    }
+    return names;
+}
+
+const void* FlatArchive::get(const std::string& name, std::size_t elementSize, std::size_t& count) const
+{
+    const Entry* entry = find(name);
+    drishti_throw_assert(entry, "FlatArchive: missing entry " + name);
+    drishti_throw_assert(entry->elementSize == elementSize, "FlatArchive: element size mismatch for " + name);
+
+    count = static_cast<std::size_t>(entry->count);
+    return m_data + entry->offset;
+}
+
+void FlatArchive::checkScalar(const std::string& name, std::size_t count) const
+{
+    drishti_throw_assert(count == 1, "FlatArchive: expected a scalar for " + name);
+}
+
+std::string FlatArchive::getString(const std::string& name) const
+{
+    std::size_t count = 0;
+    const char* data = get<char>(name, count);
+    return std::string(data, count);
+}
+
+// ((((((((((((((( FlatArchiveWriter )))))))))))))))
+
+void FlatArchiveWriter::add(const std::string& name, const void* data, std::size_t elementSize, std::size_t count)
+{
+    drishti_throw_assert(!name.empty() && (name.size() < sizeof(FlatArchive::Entry::name)), "FlatArchiveWriter: invalid name " + name);
+
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    m_arrays.push_back({ name, elementSize, count, std::vector<std::uint8_t>(bytes, bytes + (elementSize * count)) });
+}
+
+void FlatArchiveWriter::addString(const std::string& name, const std::string& value)
+{
+    add(name, value.data(), value.size());
+}
+
+void FlatArchiveWriter::save(std::ostream& os) const
+{
+    FlatArchive::Header header;
+    std::copy(kMagic, kMagic + 4, header.magic);
+    header.version = FlatArchive::kVersion;
+    header.byteOrder = kByteOrder;
+    header.count = static_cast<std::uint32_t>(m_arrays.size());
+
+    std::vector<FlatArchive::Entry> entries(m_arrays.size());
+    std::size_t offset = align(sizeof(header) + (entries.size() * sizeof(FlatArchive::Entry)));
+    for (std::size_t i = 0; i < m_arrays.size(); i++)
+    {
+        auto& entry = entries[i];
+        std::memset(&entry, 0, sizeof(entry));
+        std::copy(m_arrays[i].name.begin(), m_arrays[i].name.end(), entry.name);
+        entry.elementSize = static_cast<std::uint32_t>(m_arrays[i].elementSize);
+        entry.offset = offset;
+        entry.count = m_arrays[i].count;
+        offset = align(offset + m_arrays[i].data.size());
+    }
+
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(FlatArchive::Entry));
+
+    std::size_t position = sizeof(header) + (entries.size() * sizeof(FlatArchive::Entry));
+    const std::vector<char> padding(FlatArchive::kAlignment, 0);
+    for (std::size_t i = 0; i < m_arrays.size(); i++)
+    {
+        os.write(padding.data(), entries[i].offset - position);
+        os.write(reinterpret_cast<const char*>(m_arrays[i].data.data()), m_arrays[i].data.size());
+        position = entries[i].offset + m_arrays[i].data.size();
+    }
+    os.write(padding.data(), align(position) - position);
+}
+
+void FlatArchiveWriter::save(const std::string& filename) const
+{
+    std::ofstream os(filename, std::ios::binary);
+    drishti_throw_assert(os.good(), "FlatArchiveWriter: unable to open " + filename);
+    save(os);
+}
+
+DRISHTI_CORE_NAMESPACE_END
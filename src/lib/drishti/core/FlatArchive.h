@@ -0,0 +1,151 @@
+/*! -*-c++-*-
+  @file   FlatArchive.h
+  @author David Hirvonen
+  @brief  Declaration of a versioned flat binary container for arrays used in place.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_FlatArchive_h__
+#define __drishti_core_FlatArchive_h__
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/drishti_type_traits.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Layout (native byte order, checked on load):
+ *
+ *   Header  : magic "DRFA", version, byte order mark, entry count
+ *   Entry[] : name, element size, offset, element count
+ *   Data    : one array per entry, each aligned to FlatArchive::kAlignment bytes
+ *
+ * Arrays are returned as pointers into the underlying buffer, which is either a read only
+ * memory mapping of the file (pages are shared between processes), a caller supplied buffer
+ * (i.e., an embedded asset) or a private copy when loading from a std::istream.
+ */
+
+class FlatArchive
+{
+public:
+    static const std::uint32_t kVersion = 1;
+    static const std::size_t kAlignment = 64;
+
+    struct Header
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint32_t count;
+    };
+
+    struct Entry
+    {
+        char name[56];
+        std::uint32_t elementSize;
+        std::uint32_t reserved;
+        std::uint64_t offset;
+        std::uint64_t count;
+    };
+
+    // Use data in place, owner (optional) keeps the buffer alive:
+    FlatArchive(const void* data, std::size_t size, std::shared_ptr<const void> owner = nullptr);
+    ~FlatArchive();
+
+    static std::shared_ptr<FlatArchive> map(const std::string& filename);
+    static std::shared_ptr<FlatArchive> read(std::istream& is);
+
+    // Read only mapping of a whole file (an aligned private copy where mmap isn't available),
+    // i.e., for containers of several archives:
+    static std::shared_ptr<const void> mapFile(const std::string& filename, std::size_t& size);
+
+    // Check the magic without consuming the stream:
+    static bool isFlat(std::istream& is);
+    static bool isFlat(const std::string& filename);
+
+    bool has(const std::string& name) const;
+    std::vector<std::string> getNames() const;
+
+    template <typename T>
+    const T* get(const std::string& name, std::size_t& count) const
+    {
+        static_assert(is_trivially_copyable<T>::value, "FlatArchive: arrays must be trivially copyable");
+        return static_cast<const T*>(get(name, sizeof(T), count));
+    }
+
+    template <typename T>
+    T getScalar(const std::string& name) const
+    {
+        std::size_t count = 0;
+        const T* value = get<T>(name, count);
+        checkScalar(name, count);
+        return *value;
+    }
+
+    std::string getString(const std::string& name) const;
+
+protected:
+    const void* get(const std::string& name, std::size_t elementSize, std::size_t& count) const;
+    const Entry* find(const std::string& name) const;
+    void checkScalar(const std::string& name, std::size_t count) const;
+
+    const std::uint8_t* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::shared_ptr<const void> m_owner;
+    const Entry* m_entries = nullptr;
+    std::uint32_t m_count = 0;
+};
+
+class FlatArchiveWriter
+{
+public:
+    template <typename T>
+    void add(const std::string& name, const T* data, std::size_t count)
+    {
+        static_assert(is_trivially_copyable<T>::value, "FlatArchive: arrays must be trivially copyable");
+        add(name, data, sizeof(T), count);
+    }
+
+    template <typename T>
+    void add(const std::string& name, const std::vector<T>& values)
+    {
+        add(name, values.data(), values.size());
+    }
+
+    template <typename T>
+    void addScalar(const std::string& name, const T& value)
+    {
+        add(name, &value, 1);
+    }
+
+    void addString(const std::string& name, const std::string& value);
+
+    void save(std::ostream& os) const;
+    void save(const std::string& filename) const;
+
+protected:
+    void add(const std::string& name, const void* data, std::size_t elementSize, std::size_t count);
+
+    struct Array
+    {
+        std::string name;
+        std::size_t elementSize;
+        std::size_t count;
+        std::vector<std::uint8_t> data;
+    };
+    std::vector<Array> m_arrays;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_FlatArchive_h__
@@ -0,0 +1,83 @@
+/*! -*-c++-*-
+  @file   FrameArena.cpp
+  @author David Hirvonen
+  @brief  Implementation of a monotonic (per frame) arena allocator for pipeline temporaries.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/FrameArena.h"
+
+#include <algorithm>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+const std::size_t FrameArena::kAlignment;
+
+FrameArena::FrameArena(std::size_t capacity)
+{
+    m_blocks.reserve(8);
+    if (capacity)
+    {
+        grow(capacity);
+    }
+}
+
+FrameArena::~FrameArena() = default;
+
+std::size_t FrameArena::capacity() const
+{
+    return m_blocks.empty() ? 0 : m_blocks.back().size;
+}
+
+void FrameArena::grow(std::size_t bytes)
+{
+    Block block;
+    block.size = bytes;
+    block.data.reset(new std::uint8_t[bytes]);
+    m_blocks.push_back(std::move(block));
+    m_offset = 0;
+    m_heapAllocations++;
+}
+
+void* FrameArena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    // Operator new[] alignment is only guaranteed for the fundamental types, so align the address:
+    const auto align = [&](std::size_t offset) {
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(m_blocks.back().data.get()) + offset;
+        return offset + ((alignment - (address % alignment)) % alignment);
+    };
+
+    std::size_t offset = m_blocks.empty() ? 0 : align(m_offset);
+    if (m_blocks.empty() || ((offset + bytes) > m_blocks.back().size))
+    {
+        grow(std::max(bytes + alignment, capacity() * 2));
+        offset = align(0);
+    }
+
+    m_offset = offset + bytes;
+    m_used += bytes;
+    return m_blocks.back().data.get() + offset;
+}
+
+void FrameArena::reset()
+{
+    if (m_blocks.size() > 1)
+    {
+        // Coalesce, so that the next frame of the same size fits in one block:
+        std::size_t total = 0;
+        for (const auto& block : m_blocks)
+        {
+            total += block.size;
+        }
+        m_blocks.clear();
+        grow(total);
+    }
+
+    m_offset = 0;
+    m_used = 0;
+}
+
+DRISHTI_CORE_NAMESPACE_END
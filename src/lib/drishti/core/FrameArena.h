@@ -0,0 +1,118 @@
+/*! -*-c++-*-
+  @file   FrameArena.h
+  @author David Hirvonen
+  @brief  Declaration of a monotonic (per frame) arena allocator for pipeline temporaries.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_FrameArena_h__
+#define __drishti_core_FrameArena_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Bump allocator for buffers that live for one frame (crops, sample values, work lists).
+ * Allocation is a pointer increment, nothing is freed until reset().  When a frame overflows
+ * the current block, a new block is chained, and on the next reset() all blocks are coalesced
+ * into a single block that holds the whole frame.  After a few frames the arena stops touching
+ * the heap.  An arena is not thread safe, use one per thread (or per pipeline stage).
+ */
+
+class FrameArena
+{
+public:
+    static const std::size_t kAlignment = 16; // SIMD friendly default
+
+    FrameArena(std::size_t capacity = 0);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment = kAlignment);
+
+    template <typename T>
+    T* allocate(std::size_t count)
+    {
+        return static_cast<T*>(allocate(count * sizeof(T), (alignof(T) > kAlignment) ? alignof(T) : kAlignment));
+    }
+
+    // Start a new frame, invalidates all previous allocations:
+    void reset();
+
+    std::size_t size() const { return m_used; }  // bytes allocated since reset()
+    std::size_t capacity() const;                  // bytes available without touching the heap
+    std::size_t getHeapAllocations() const { return m_heapAllocations; } // blocks allocated so far
+
+protected:
+    struct Block
+    {
+        std::unique_ptr<std::uint8_t[]> data;
+        std::size_t size = 0;
+    };
+
+    void grow(std::size_t bytes);
+
+    std::vector<Block> m_blocks; // the last block is the current one
+    std::size_t m_offset = 0;    // in the current block
+    std::size_t m_used = 0;
+    std::size_t m_heapAllocations = 0;
+};
+
+// Standard allocator interface for containers of per frame temporaries, deallocate() is a no-op:
+template <typename T>
+struct ArenaAllocator
+{
+    using value_type = T;
+
+    ArenaAllocator(FrameArena& arena)
+        : arena(&arena)
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other)
+        : arena(other.arena)
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        return arena->allocate<T>(n);
+    }
+
+    void deallocate(T*, std::size_t)
+    {
+    }
+
+    FrameArena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena != b.arena;
+}
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_FrameArena_h__
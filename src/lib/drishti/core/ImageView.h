@@ -11,8 +11,16 @@
 #ifndef __drishti_core_ImageView_h__
 #define __drishti_core_ImageView_h__
 
+#include "drishti/core/drishti_core.h"
+
 #include <opencv2/core.hpp> // for cv::Mat4b
 
+#include <functional> // std::function<>
+#include <future>     // std::shared_future<>
+#include <memory>     // std::shared_ptr<>
+#include <mutex>      // std::mutex
+#include <thread>     // std::thread::id
+
 DRISHTI_CORE_NAMESPACE_BEGIN
 
 struct Texture
@@ -27,6 +35,79 @@ struct Texture
     std::uint32_t texId = 0; //! Identifier for the texture
 };
 
+/*
+ * Pixel transfer for a texture that is only performed if a consumer asks for it.
+ * The reader must run on the thread that owns the OpenGL context: get() runs it
+ * immediately when called from that thread, otherwise the transfer is queued and
+ * completed by the owner's next call to service().  If the texture is recycled
+ * first, cancel() releases waiting consumers with an empty image.
+ */
+
+class DeferredReadback
+{
+public:
+    using Reader = std::function<void(cv::Mat4b& image)>;
+
+    DeferredReadback(const Reader& reader)
+        : m_reader(reader)
+        , m_owner(std::this_thread::get_id())
+        , m_future(m_promise.get_future().share())
+    {
+    }
+
+    std::shared_future<cv::Mat4b> get()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requested = true;
+        if (std::this_thread::get_id() == m_owner)
+        {
+            read();
+        }
+        return m_future;
+    }
+
+    // Complete a pending transfer (owner thread only), return true when resolved:
+    bool service()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_requested)
+        {
+            read();
+        }
+        return m_done;
+    }
+
+    void cancel()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_done)
+        {
+            m_done = true;
+            m_promise.set_value({});
+        }
+    }
+
+protected:
+    void read()
+    {
+        if (!m_done)
+        {
+            cv::Mat4b image;
+            m_reader(image);
+            m_done = true;
+            m_promise.set_value(image);
+        }
+    }
+
+    std::mutex m_mutex;
+    Reader m_reader;
+    std::thread::id m_owner;
+    std::promise<cv::Mat4b> m_promise;
+    std::shared_future<cv::Mat4b> m_future;
+    bool m_requested = false;
+    bool m_done = false;
+};
+
 struct ImageView
 {
     ImageView() = default;
@@ -37,6 +118,7 @@ struct ImageView
     }
     Texture texture; //! Texture descriptor
     cv::Mat4b image; //! Image descriptor
+    std::shared_ptr<DeferredReadback> readback; //! Optional lazy image (see FaceMonitor::Request)
 };
 
 DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,352 @@
+/*! -*-c++-*-
+  @file   JsonStream.cpp
+  @author David Hirvonen
+  @brief  Implementation of a streaming JSON writer and a pull (SAX style) JSON reader.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/JsonStream.h"
+#include "drishti/core/ThrowAssert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+// ### JsonWriter ###
+
+void JsonWriter::separator()
+{
+    if (m_key)
+    {
+        m_key = false;
+    }
+    else if (m_depth > 0)
+    {
+        const std::uint64_t bit = std::uint64_t(1) << (m_depth - 1);
+        if (m_items & bit)
+        {
+            m_buffer.push_back(',');
+        }
+        m_items |= bit;
+    }
+}
+
+JsonWriter& JsonWriter::beginObject()
+{
+    drishti_throw_assert(m_depth < kMaxDepth, "JsonWriter: maximum depth exceeded");
+    separator();
+    m_buffer.push_back('{');
+    m_items &= ~(std::uint64_t(1) << m_depth++);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+    drishti_throw_assert(m_depth > 0 && !m_key, "JsonWriter: unbalanced object");
+    m_depth--;
+    m_buffer.push_back('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray()
+{
+    drishti_throw_assert(m_depth < kMaxDepth, "JsonWriter: maximum depth exceeded");
+    separator();
+    m_buffer.push_back('[');
+    m_items &= ~(std::uint64_t(1) << m_depth++);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+    drishti_throw_assert(m_depth > 0 && !m_key, "JsonWriter: unbalanced array");
+    m_depth--;
+    m_buffer.push_back(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* name)
+{
+    separator();
+    m_buffer.push_back('"');
+    m_buffer.append(name);
+    m_buffer.append("\":", 2);
+    m_key = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool value)
+{
+    separator();
+    if (value)
+    {
+        m_buffer.append("true", 4);
+    }
+    else
+    {
+        m_buffer.append("false", 5);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(int value)
+{
+    separator();
+
+    // Digits in reverse order, unsigned to handle INT_MIN:
+    char digits[16];
+    int count = 0;
+    unsigned int magnitude = (value < 0) ? (0u - static_cast<unsigned int>(value)) : static_cast<unsigned int>(value);
+    do
+    {
+        digits[count++] = char('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude);
+
+    if (value < 0)
+    {
+        m_buffer.push_back('-');
+    }
+    while (count)
+    {
+        m_buffer.push_back(digits[--count]);
+    }
+    return *this;
+}
+
+// Shortest "%g" format with enough digits for a round trip (9 for float, 17 for double):
+static void formatNumber(std::string& buffer, double value, int digits)
+{
+    if (!std::isfinite(value))
+    {
+        buffer.append("null", 4);
+    }
+    else
+    {
+        char text[32];
+        const int size = std::snprintf(text, sizeof(text), "%.*g", digits, value);
+        buffer.append(text, std::min(std::max(size, 0), int(sizeof(text)) - 1));
+    }
+}
+
+JsonWriter& JsonWriter::value(float value)
+{
+    separator();
+    formatNumber(m_buffer, value, std::numeric_limits<float>::max_digits10);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double value)
+{
+    separator();
+    formatNumber(m_buffer, value, std::numeric_limits<double>::max_digits10);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* value, std::size_t size)
+{
+    static const char kHex[] = "0123456789abcdef";
+
+    separator();
+    m_buffer.push_back('"');
+    for (std::size_t i = 0; i < size; i++)
+    {
+        const unsigned char c = static_cast<unsigned char>(value[i]);
+        switch (c)
+        {
+            case '"':
+                m_buffer.append("\\\"", 2);
+                break;
+            case '\\':
+                m_buffer.append("\\\\", 2);
+                break;
+            case '\n':
+                m_buffer.append("\\n", 2);
+                break;
+            case '\t':
+                m_buffer.append("\\t", 2);
+                break;
+            default:
+                if (c < 0x20)
+                {
+                    const char code[] = { '\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 15] };
+                    m_buffer.append(code, sizeof(code));
+                }
+                else
+                {
+                    m_buffer.push_back(char(c));
+                }
+        }
+    }
+    m_buffer.push_back('"');
+    return *this;
+}
+
+JsonWriter& JsonWriter::addVersion(const void* type, unsigned int number)
+{
+    const void** end = m_types + m_typeCount;
+    if (std::find(m_types, end, type) == end)
+    {
+        drishti_throw_assert(m_typeCount < kMaxTypes, "JsonWriter: too many versioned types");
+        m_types[m_typeCount++] = type;
+        key("cereal_class_version");
+        value(static_cast<int>(number));
+    }
+    return *this;
+}
+
+// ### JsonReader ###
+
+static bool isSeparator(char c)
+{
+    return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t') || (c == ',') || (c == ':');
+}
+
+static bool isSpace(char c)
+{
+    return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t');
+}
+
+JsonReader::Token JsonReader::next()
+{
+    if (m_token == kError)
+    {
+        return kError;
+    }
+
+    while ((m_ptr < m_end) && isSeparator(*m_ptr))
+    {
+        m_ptr++;
+    }
+
+    if (m_ptr == m_end)
+    {
+        return (m_token = kEnd);
+    }
+
+    const auto literal = [&](const char* text, std::size_t size, Token token) {
+        if ((std::size_t(m_end - m_ptr) < size) || std::memcmp(m_ptr, text, size))
+        {
+            return error();
+        }
+        m_ptr += size;
+        return (m_token = token);
+    };
+
+    switch (*m_ptr)
+    {
+        case '{':
+            m_ptr++;
+            return (m_token = kBeginObject);
+        case '}':
+            m_ptr++;
+            return (m_token = kEndObject);
+        case '[':
+            m_ptr++;
+            return (m_token = kBeginArray);
+        case ']':
+            m_ptr++;
+            return (m_token = kEndArray);
+        case 't':
+            return literal("true", 4, kTrue);
+        case 'f':
+            return literal("false", 5, kFalse);
+        case 'n':
+            m_number = std::numeric_limits<double>::quiet_NaN();
+            return literal("null", 4, kNull);
+        case '"':
+        {
+            const char* begin = ++m_ptr;
+            while ((m_ptr < m_end) && (*m_ptr != '"'))
+            {
+                m_ptr += (*m_ptr == '\\') ? 2 : 1;
+            }
+            if (m_ptr >= m_end)
+            {
+                return error();
+            }
+
+            m_text = begin;
+            m_size = m_ptr++ - begin;
+
+            // A string followed by ':' is a key:
+            const char* ptr = m_ptr;
+            while ((ptr < m_end) && isSpace(*ptr))
+            {
+                ptr++;
+            }
+            if ((ptr < m_end) && (*ptr == ':'))
+            {
+                m_ptr = ptr + 1;
+                return (m_token = kKey);
+            }
+            return (m_token = kString);
+        }
+        default:
+        {
+            // Copy the number for strtod() (the buffer needn't be null terminated):
+            char text[64];
+            std::size_t size = 0;
+            while ((m_ptr < m_end) && (size < sizeof(text) - 1) && std::strchr("+-.0123456789eE", *m_ptr) && *m_ptr)
+            {
+                text[size++] = *m_ptr++;
+            }
+            text[size] = 0;
+
+            char* end = nullptr;
+            m_number = std::strtod(text, &end);
+            if (!size || (end != (text + size)))
+            {
+                return error();
+            }
+            return (m_token = kNumber);
+        }
+    }
+}
+
+bool JsonReader::skip()
+{
+    int depth = 0;
+    for (Token token = m_token;; token = next())
+    {
+        switch (token)
+        {
+            case kBeginObject:
+            case kBeginArray:
+                depth++;
+                break;
+            case kEndObject:
+            case kEndArray:
+                if (--depth < 0)
+                {
+                    return false;
+                }
+                break;
+            case kKey:
+                if (depth == 0)
+                {
+                    return false;
+                }
+                break;
+            case kError:
+            case kEnd:
+                return false;
+            default:
+                break;
+        }
+
+        if (depth == 0)
+        {
+            return true;
+        }
+    }
+}
+
+DRISHTI_CORE_NAMESPACE_END
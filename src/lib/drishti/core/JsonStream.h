@@ -0,0 +1,205 @@
+/*! -*-c++-*-
+  @file   JsonStream.h
+  @author David Hirvonen
+  @brief  Declaration of a streaming JSON writer and a pull (SAX style) JSON reader.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_JsonStream_h__
+#define __drishti_core_JsonStream_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Lightweight JSON I/O for per frame results (no DOM, no temporary strings or streams):
+ *
+ *   JsonWriter : appends compact JSON to a caller supplied std::string (reuse the buffer
+ *                across calls and the writer doesn't allocate once it has grown)
+ *   JsonReader : returns the tokens of a buffer one at a time, keys and strings are views
+ *                into the buffer (escape sequences are not decoded)
+ *
+ * Both sides follow the cereal JSON conventions used by the model serialize() methods so
+ * the output can be read with cereal::JSONInputArchive and vice versa: unnamed members are
+ * "value0", "value1", ... and versioned types write "cereal_class_version" the first time
+ * they appear in a document (see JsonWriter::version()).
+ */
+
+class JsonWriter
+{
+public:
+    static const int kMaxDepth = 64;
+    static const int kMaxTypes = 32;
+
+    JsonWriter(std::string& buffer)
+        : m_buffer(buffer)
+    {
+    }
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    // Member name (not escaped, intended for string literals):
+    JsonWriter& key(const char* name);
+
+    JsonWriter& value(bool value);
+    JsonWriter& value(int value);
+    JsonWriter& value(float value);  // null for nan and inf
+    JsonWriter& value(double value); // null for nan and inf
+    JsonWriter& value(const char* value, std::size_t size);
+
+    // Write "cereal_class_version" the first time type T is written (call after beginObject()):
+    template <typename T>
+    JsonWriter& version(unsigned int number)
+    {
+        return addVersion(&Type<T>::id, number);
+    }
+
+    std::string& buffer() { return m_buffer; }
+
+protected:
+    template <typename T>
+    struct Type
+    {
+        static const char id;
+    };
+
+    JsonWriter& addVersion(const void* type, unsigned int number);
+    void separator();
+
+    std::string& m_buffer;
+
+    int m_depth = 0;
+    std::uint64_t m_items = 0; // bit i : container at depth i has members
+    bool m_key = false;        // a key is waiting for its value
+
+    const void* m_types[kMaxTypes];
+    int m_typeCount = 0;
+};
+
+template <typename T>
+const char JsonWriter::Type<T>::id = 0;
+
+class JsonReader
+{
+public:
+    enum Token
+    {
+        kError,
+        kEnd,
+        kBeginObject,
+        kEndObject,
+        kBeginArray,
+        kEndArray,
+        kKey,
+        kString,
+        kNumber,
+        kTrue,
+        kFalse,
+        kNull
+    };
+
+    JsonReader(const char* data, std::size_t size)
+        : m_ptr(data)
+        , m_end(data + size)
+    {
+    }
+
+    // View of a key or string in the buffer:
+    struct Key
+    {
+        bool operator==(const char* name) const
+        {
+            return (std::strlen(name) == size) && !std::memcmp(name, text, size);
+        }
+
+        const char* text;
+        std::size_t size;
+    };
+
+    // Advance to the next token (separators are consumed):
+    Token next();
+
+    // Skip the value that starts at the current token (i.e., after an unknown key):
+    bool skip();
+
+    Token token() const { return m_token; }
+    bool good() const { return m_token != kError; }
+
+    Key key() const { return { m_text, m_size }; }
+
+    // Current number (nan for null):
+    double number() const { return m_number; }
+
+protected:
+    Token error() { return (m_token = kError); }
+
+    const char* m_ptr = nullptr;
+    const char* m_end = nullptr;
+
+    Token m_token = kEnd;
+    const char* m_text = nullptr;
+    std::size_t m_size = 0;
+    double m_number = 0.0;
+};
+
+/*
+ * Readers parse the value that starts at the current token, i.e.:
+ *
+ *   JsonReader is(data, size);
+ *   is.next();
+ *   readObject(is, [&](const JsonReader::Key& key) { return (key == "x") ? read(is, x) : is.skip(); });
+ */
+
+inline bool read(JsonReader& is, bool& value)
+{
+    value = (is.token() == JsonReader::kTrue);
+    return value || (is.token() == JsonReader::kFalse);
+}
+
+inline bool read(JsonReader& is, int& value)
+{
+    value = (is.token() == JsonReader::kNumber) ? static_cast<int>(is.number()) : 0;
+    return (is.token() == JsonReader::kNumber);
+}
+
+inline bool read(JsonReader& is, float& value)
+{
+    value = static_cast<float>(is.number());
+    return (is.token() == JsonReader::kNumber) || (is.token() == JsonReader::kNull);
+}
+
+// Call member(key) with the current token at the start of each value, versions are skipped:
+template <typename Member>
+bool readObject(JsonReader& is, Member&& member)
+{
+    if (is.token() != JsonReader::kBeginObject)
+    {
+        return false;
+    }
+
+    while (is.next() == JsonReader::kKey)
+    {
+        const JsonReader::Key key = is.key();
+        is.next();
+        if (!((key == "cereal_class_version") ? is.skip() : member(key)))
+        {
+            return false;
+        }
+    }
+    return (is.token() == JsonReader::kEndObject);
+}
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_JsonStream_h__
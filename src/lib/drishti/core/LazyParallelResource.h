@@ -13,9 +13,15 @@
 
 #include "drishti/core/drishti_core.h"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <map>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
@@ -28,7 +34,8 @@ struct LazyParallelResource
     {
     }
     LazyParallelResource(LazyParallelResource&& other)
-        : m_alloc(std::move(other.m_alloc))
+        : m_map(std::move(other.m_map))
+        , m_alloc(std::move(other.m_alloc))
     {
         other.m_alloc = nullptr;
     }
@@ -52,6 +59,137 @@ struct LazyParallelResource
     std::function<Value()> m_alloc; // default allocator
 };
 
+// Per thread values of each ThreadLocalParallelResource (indexed by slot), tagged with the
+// id of the resource that cached them:
+struct ThreadLocalSlot
+{
+    std::uint64_t id = 0;
+    void* value = nullptr;
+};
+
+inline std::vector<ThreadLocalSlot>& getThreadLocalSlots()
+{
+    static thread_local std::vector<ThreadLocalSlot> slots;
+    return slots;
+}
+
+// Slots of destroyed resources are recycled, so the per thread vectors are bounded by the
+// number of live resources.  Ids are never reused, so a stale entry can't be mistaken for a
+// live one:
+class ThreadLocalSlots
+{
+public:
+    static ThreadLocalSlots& instance()
+    {
+        static ThreadLocalSlots slots;
+        return slots;
+    }
+
+    std::size_t allocate()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free.empty())
+        {
+            return m_size++;
+        }
+        const std::size_t slot = m_free.back();
+        m_free.pop_back();
+        return slot;
+    }
+
+    void release(std::size_t slot)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(slot);
+    }
+
+    std::uint64_t id()
+    {
+        return ++m_id;
+    }
+
+protected:
+    std::mutex m_mutex;
+    std::size_t m_size = 0;
+    std::vector<std::size_t> m_free;
+    std::atomic<std::uint64_t> m_id{ 0 };
+};
+
+/*
+ * A LazyParallelResource keyed by thread that caches each thread's value in a thread local
+ * slot.  The map (and mutex) are only touched the first time a thread accesses the resource,
+ * after that access is a pointer load, so workers no longer serialize on every frame.
+ * getMap() is unchanged for enumeration and teardown.  Entries must not be erased from the
+ * map while worker threads are still using the resource.
+ */
+
+template <typename Value>
+struct ThreadLocalParallelResource : public LazyParallelResource<std::thread::id, Value>
+{
+    using Base = LazyParallelResource<std::thread::id, Value>;
+
+    template <class Callable>
+    ThreadLocalParallelResource(Callable&& func)
+        : Base(std::forward<Callable>(func))
+        , m_slot(ThreadLocalSlots::instance().allocate())
+        , m_id(ThreadLocalSlots::instance().id())
+    {
+    }
+
+    // The map nodes (and the pointers cached to them) move with the slot, the source is
+    // left without one and falls back to the map:
+    ThreadLocalParallelResource(ThreadLocalParallelResource&& other)
+        : Base(static_cast<Base&&>(other))
+        , m_slot(other.m_slot)
+        , m_id(other.m_id)
+    {
+        other.m_slot = kNone;
+        other.m_id = 0;
+    }
+
+    ~ThreadLocalParallelResource()
+    {
+        if (m_slot != kNone)
+        {
+            ThreadLocalSlots::instance().release(m_slot);
+        }
+    }
+
+    // Value for the calling thread:
+    Value& get()
+    {
+        if (m_slot == kNone)
+        {
+            return Base::operator[](std::this_thread::get_id());
+        }
+
+        auto& slots = getThreadLocalSlots();
+        if ((m_slot < slots.size()) && (slots[m_slot].id == m_id))
+        {
+            return *static_cast<Value*>(slots[m_slot].value);
+        }
+
+        Value& value = Base::operator[](std::this_thread::get_id()); // std::map nodes are stable
+        if (m_slot >= slots.size())
+        {
+            slots.resize(m_slot + 1);
+        }
+        slots[m_slot].id = m_id;
+        slots[m_slot].value = &value;
+        return value;
+    }
+
+    virtual Value& operator[](const std::thread::id& key)
+    {
+        return (key == std::this_thread::get_id()) ? get() : Base::operator[](key);
+    }
+
+    static constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+
+    std::size_t m_slot;
+    std::uint64_t m_id; // 0 is never cached
+};
+
 DRISHTI_CORE_NAMESPACE_END
 
 #endif
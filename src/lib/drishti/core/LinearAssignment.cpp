@@ -0,0 +1,159 @@
+/*! -*-c++-*-
+  @file   LinearAssignment.cpp
+  @author David Hirvonen
+  @brief  Implementation of a shortest augmenting path solver for the linear assignment problem.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/LinearAssignment.h"
+
+#include <algorithm>
+#include <limits>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+static const int kLanes = 8;
+
+static int roundUp(int n, int m)
+{
+    return ((n + m - 1) / m) * m;
+}
+
+/*
+ * For each column j: minv[j] = min(minv[j], row[j] - offset - v[j]) (recording the predecessor
+ * column j0 in way[j]) and return the index of the smallest minv[j].  Visited columns (and the
+ * padding) have penalty[j] = inf, which keeps them at minv[j] = inf.  Lanes track their own
+ * minimum so that the loop body has no branches and no loop carried dependency.
+ */
+
+template <typename T>
+static int relax(const T* row, T offset, const T* v, const T* penalty, T* minv, int* way, int j0, int n, T& delta)
+{
+    T best[kLanes];
+    int index[kLanes];
+    std::fill(best, best + kLanes, std::numeric_limits<T>::infinity());
+    std::fill(index, index + kLanes, 0);
+
+    for (int j = 0; j < n; j += kLanes)
+    {
+        for (int k = 0; k < kLanes; k++)
+        {
+            const T cost = row[j + k] - offset - v[j + k] + penalty[j + k];
+            const bool better = cost < minv[j + k];
+            minv[j + k] = better ? cost : minv[j + k];
+            way[j + k] = better ? j0 : way[j + k];
+
+            const bool lower = minv[j + k] < best[k];
+            best[k] = lower ? minv[j + k] : best[k];
+            index[k] = lower ? (j + k) : index[k];
+        }
+    }
+
+    // Lowest index among the lanes with the smallest value (i.e., deterministic):
+    int lane = 0;
+    for (int k = 1; k < kLanes; k++)
+    {
+        if ((best[k] < best[lane]) || ((best[k] == best[lane]) && (index[k] < index[lane])))
+        {
+            lane = k;
+        }
+    }
+
+    delta = best[lane];
+    return index[lane];
+}
+
+template <typename T>
+static T minimize(const cv::Mat_<T>& cost, std::vector<int>& assignment)
+{
+    const T inf = std::numeric_limits<T>::infinity();
+    const int rows = cost.rows, cols = cost.cols;
+    const int n = std::max(rows, cols);
+
+    assignment.assign(rows, -1);
+    if (n == 0)
+    {
+        return T(0);
+    }
+
+    // Rows and columns are 1-based, column 0 is the virtual start of each augmenting path:
+    const int stride = roundUp(n + 1, kLanes);
+    std::vector<T> a((n + 1) * stride, T(0));
+    for (int y = 0; y < rows; y++)
+    {
+        std::copy(cost.template ptr<T>(y), cost.template ptr<T>(y) + cols, &a[(y + 1) * stride + 1]);
+    }
+
+    std::vector<T> u(n + 1, T(0)), v(stride, T(0)), minv(stride), penalty(stride);
+    std::vector<int> p(stride, 0), way(stride, 0), visited;
+    visited.reserve(n + 1);
+
+    for (int i = 1; i <= n; i++)
+    {
+        std::fill(minv.begin(), minv.end(), inf);
+        std::fill(penalty.begin(), penalty.end(), inf);
+        std::fill(penalty.begin() + 1, penalty.begin() + n + 1, T(0));
+        visited.clear();
+
+        // Grow a shortest path tree from row i until it reaches a free column:
+        p[0] = i;
+        int j0 = 0;
+        do
+        {
+            penalty[j0] = inf;
+            minv[j0] = inf;
+            visited.push_back(j0);
+
+            const int i0 = p[j0];
+            T delta;
+            const int j1 = relax(&a[i0 * stride], u[i0], v.data(), penalty.data(), minv.data(), way.data(), j0, stride, delta);
+
+            for (const auto& j : visited)
+            {
+                u[p[j]] += delta;
+                v[j] -= delta;
+            }
+            for (int j = 0; j < stride; j++)
+            {
+                minv[j] -= delta;
+            }
+
+            j0 = j1;
+        } while (p[j0] != 0);
+
+        // Augment along the path:
+        do
+        {
+            const int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0);
+    }
+
+    T total(0);
+    for (int j = 1; j <= n; j++)
+    {
+        const int row = p[j] - 1, col = j - 1;
+        if ((row < rows) && (col < cols))
+        {
+            assignment[row] = col;
+            total += cost(row, col);
+        }
+    }
+    return total;
+}
+
+float MinimizeLinearAssignment(const cv::Mat1f& cost, std::vector<int>& assignment)
+{
+    return minimize(cost, assignment);
+}
+
+double MinimizeLinearAssignment(const cv::Mat1d& cost, std::vector<int>& assignment)
+{
+    return minimize(cost, assignment);
+}
+
+DRISHTI_CORE_NAMESPACE_END
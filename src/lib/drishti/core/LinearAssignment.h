@@ -0,0 +1,39 @@
+/*! -*-c++-*-
+  @file   LinearAssignment.h
+  @author David Hirvonen
+  @brief  Declaration of a shortest augmenting path solver for the linear assignment problem.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_LinearAssignment_h__
+#define __drishti_core_LinearAssignment_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * O(n^3) Jonker-Volgenant style solver (shortest augmenting paths with dual potentials) over a
+ * contiguous cost matrix.  Rectangular matrices are padded to square with zero costs.  Each
+ * augmentation step relaxes one cost row against all columns and takes the minimum in a single
+ * branchless pass over fixed width lanes, which the compiler maps to SSE/AVX/NEON min and
+ * select instructions.  A 200x200 problem takes O(ms) (vs. O(n^4) Munkres).
+ *
+ * assignment[row] is the assigned column (-1 if rows > cols and the row is unassigned), the
+ * minimum total cost is returned.  Costs must be finite.  Use the float version for speed and
+ * the double version for costs spanning a large dynamic range (i.e., gated pairs).
+ */
+
+float MinimizeLinearAssignment(const cv::Mat1f& cost, std::vector<int>& assignment);
+double MinimizeLinearAssignment(const cv::Mat1d& cost, std::vector<int>& assignment);
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_LinearAssignment_h__
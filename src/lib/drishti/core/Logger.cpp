@@ -11,6 +11,7 @@
 
 #include "drishti/core/Logger.h"
 #include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
 
 // clang-format off
 #if defined(__ANDROID__)
@@ -21,21 +22,20 @@
 DRISHTI_CORE_NAMESPACE_BEGIN
 
 std::mutex Logger::m_mutex;
-int Logger::m_count = 0;
+std::atomic<int> Logger::m_count{ 0 };
+const std::size_t Logger::kQueueSize;
 
 int Logger::count()
 {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    return m_count;
+    return m_count.load();
 }
 
 int Logger::increment()
 {
-    std::unique_lock<std::mutex> lock(m_mutex);
     return m_count++;
 }
 
-std::shared_ptr<spdlog::logger> Logger::create(const char* name)
+std::shared_ptr<spdlog::logger> Logger::create(const char* name, bool async)
 {
     std::unique_lock<std::mutex> lock(m_mutex);
 
@@ -53,7 +53,18 @@ std::shared_ptr<spdlog::logger> Logger::create(const char* name)
 #if defined(__ANDROID__)
     sinks.push_back(std::make_shared<spdlog::sinks::android_sink>());
 #endif
-    auto logger = std::make_shared<spdlog::logger>(name, begin(sinks), end(sinks));
+
+    std::shared_ptr<spdlog::logger> logger;
+    if (async)
+    {
+        // Overflow drops messages rather than blocking the caller, the worker flushes once a second:
+        const auto policy = spdlog::async_overflow_policy::discard_log_msg;
+        logger = std::make_shared<spdlog::async_logger>(name, begin(sinks), end(sinks), kQueueSize, policy, nullptr, std::chrono::seconds(1));
+    }
+    else
+    {
+        logger = std::make_shared<spdlog::logger>(name, begin(sinks), end(sinks));
+    }
     spdlog::register_logger(logger);
     spdlog::set_pattern("[%H:%M:%S.%e | thread:%t | %n | %l]: %v");
     return logger;
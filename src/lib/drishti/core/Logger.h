@@ -15,7 +15,9 @@
 #include <spdlog/spdlog.h>
 
 #include "drishti/core/drishti_core.h"
+#include "drishti/core/Profiler.h"
 
+#include <atomic>
 #include <mutex>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
@@ -24,31 +26,58 @@ class Logger
 {
 public:
     using Pointer = std::shared_ptr<spdlog::logger>;
-    static Pointer create(const char* name);
+
+    // Messages are queued for a background thread when async is set (and dropped when the queue is full),
+    // so the calling (frame) thread never waits for the console:
+    static Pointer create(const char* name, bool async = true);
     static Pointer get(const char* name);
     static void drop(const char* name);
     static int count();
     static int increment();
 
+    static const std::size_t kQueueSize = 8192; // power of 2
+
 protected:
-    static std::mutex m_mutex;
-    static int m_count;
+    static std::mutex m_mutex; // create()
+    static std::atomic<int> m_count;
 };
 
-// Enable only one of these:
+/*
+ * Logging macros that check the (runtime) level of the logger before the arguments are evaluated,
+ * i.e., DRISHTI_LOG_INFO(logger, "faces={}", describe(faces)) costs a load and a compare when the
+ * info level is filtered, which the following doesn't: logger->info("faces={}", describe(faces)).
+ */
+
+// clang-format off
+#define DRISHTI_LOG_(ptr, LEVEL, METHOD, ...) do                                     \
+{                                                                                     \
+    const auto& drishti_log_ptr_ = (ptr);                                             \
+    if (drishti_log_ptr_ && drishti_log_ptr_->should_log(spdlog::level::LEVEL))      \
+    {                                                                                 \
+        drishti_log_ptr_->METHOD(__VA_ARGS__);                                        \
+    }                                                                                 \
+} while (0)
+// clang-format on
+
+#define DRISHTI_LOG_TRACE(ptr, ...) DRISHTI_LOG_(ptr, trace, trace, __VA_ARGS__)
+#define DRISHTI_LOG_DEBUG(ptr, ...) DRISHTI_LOG_(ptr, debug, debug, __VA_ARGS__)
+#define DRISHTI_LOG_INFO(ptr, ...) DRISHTI_LOG_(ptr, info, info, __VA_ARGS__)
+#define DRISHTI_LOG_WARN(ptr, ...) DRISHTI_LOG_(ptr, warn, warn, __VA_ARGS__)
+#define DRISHTI_LOG_ERROR(ptr, ...) DRISHTI_LOG_(ptr, err, error, __VA_ARGS__)
+
+// Enable only one of these (checkpoints are logged at the trace level, and are
+// profiler marks labelled with the source location when a back-end is enabled):
 #define DRISHTI_DO_VERBOSE_LOGGING 0
-#define DRISHTI_DO_COMPACT_LOGGING 0
-#define DRISHTI_DO_NO_LOGGING 1
+#define DRISHTI_DO_COMPACT_LOGGING 1
+#define DRISHTI_DO_NO_LOGGING 0
 
 #if DRISHTI_DO_VERBOSE_LOGGING
 // Verbose:
 // clang-format off
-#define DRISHTI_STREAM_LOG_FUNC(0,1,ptr) do                      \
-{                                                                \
-    if(ptr)                                                      \
-    {                                                            \
-        ptr->info("{} :: {}", __PRETTY_FUNCTION__, __func__);    \
-    }                                                            \
+#define DRISHTI_STREAM_LOG_FUNC(FILE_ID,CHECKPOINT,ptr) do \
+{                                                           \
+    DRISHTI_PROFILE_MARK_LOCATION();                        \
+    DRISHTI_LOG_TRACE(ptr, "{} :: {}", __PRETTY_FUNCTION__, __func__); \
 } while (0)
 // clang-format on
 #endif
@@ -56,15 +85,10 @@ protected:
 #if DRISHTI_DO_COMPACT_LOGGING
 // Minimal:
 // clang-format off
-#define DRISHTI_STREAM_LOG_FUNC(FILE_ID,CHECKPOINT,ptr) do   \
-{                                                            \
-   if(ptr)                                                   \
-   {                                                         \
-       if(drishti::core::Logger::count() < 999999)           \
-       {                                                     \
-           ptr->info("{} : {}", FILE_ID, CHECKPOINT);        \
-       }                                                     \
-   }                                                         \
+#define DRISHTI_STREAM_LOG_FUNC(FILE_ID,CHECKPOINT,ptr) do \
+{                                                           \
+    DRISHTI_PROFILE_MARK_LOCATION();                        \
+    DRISHTI_LOG_TRACE(ptr, "{} : {}", FILE_ID, CHECKPOINT); \
 } while (0)
 // clang-format on
 #endif
@@ -72,7 +96,7 @@ protected:
 #if DRISHTI_DO_NO_LOGGING
 // Disable:
 // clang-format off
-#define DRISHTI_STREAM_LOG_FUNC(FILE_ID,CHECKPOINT,ptr)
+#define DRISHTI_STREAM_LOG_FUNC(FILE_ID,CHECKPOINT,ptr) DRISHTI_PROFILE_MARK_LOCATION()
 // clang-format on
 #endif
 
@@ -116,11 +140,31 @@ inline std::string className(const std::string& prettyFunction)
 #endif
 // clang-format on
 
+// File name part of a path (a pointer into the same string), constexpr so it folds for string literals:
+constexpr const char* getBaseName(const char* path, const char* name = nullptr)
+{
+    return (*path == 0) ? (name ? name : path) : getBaseName(path + 1, ((*path == '/') || (*path == '\\')) ? (path + 1) : (name ? name : path));
+}
+
 // clang-format off
 #define DRISHTI_TO_STR_(x) #x
 #define DRISHTI_TO_STR(x) DRISHTI_TO_STR_(x)
 #define DRISHTI_LOCATION_FULL std::string(__PRETTY_FUNCTION__)
 #define DRISHTI_LOCATION_SIMPLE __CLASS_NAME__ + "::" + __METHOD_NAME__
+
+// Profiler zone for the enclosing function (DRISHTI_LOCATION_SIMPLE is a std::string):
+#define DRISHTI_LOCATION_ZONE DRISHTI_PROFILE_FUNCTION()
+
+// "file.cpp:123" as a const char* with static storage, for per frame log statements.  The
+// recursive getBaseName() is only guaranteed to fold in a constant expression, so assign it to
+// a constexpr local (i.e., constexpr const char* tag = DRISHTI_LOCATION_STATIC;):
+#define DRISHTI_LOCATION_STATIC drishti::core::getBaseName(__FILE__ ":" DRISHTI_TO_STR(__LINE__))
+#define DRISHTI_PROFILE_MARK_LOCATION() do                                       \
+{                                                                                \
+    constexpr const char* drishti_location = DRISHTI_LOCATION_STATIC;            \
+    DRISHTI_PROFILE_MARK(drishti_location);                                      \
+    (void)drishti_location;                                                      \
+} while (0)
 // clang-format on
 
 DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,81 @@
+/*! -*-c++-*-
+  @file   MemoryUsage.cpp
+  @author David Hirvonen
+  @brief  Implementation of a memory footprint breakdown for models and pipeline buffers.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/MemoryUsage.h"
+
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+#include <set>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+MemoryUsage& MemoryUsage::add(const std::string& name, std::size_t cpu, std::size_t gpu)
+{
+    items.push_back({ name, cpu, gpu });
+    return *this;
+}
+
+MemoryUsage& MemoryUsage::add(const std::string& prefix, const MemoryUsage& usage)
+{
+    for (const auto& item : usage.items)
+    {
+        items.push_back({ prefix + "/" + item.name, item.cpu, item.gpu });
+    }
+    return *this;
+}
+
+std::size_t MemoryUsage::cpu() const
+{
+    return std::accumulate(items.begin(), items.end(), std::size_t(0), [](std::size_t total, const Item& item) { return total + item.cpu; });
+}
+
+std::size_t MemoryUsage::gpu() const
+{
+    return std::accumulate(items.begin(), items.end(), std::size_t(0), [](std::size_t total, const Item& item) { return total + item.gpu; });
+}
+
+std::size_t getMemoryUsage(const std::vector<cv::Mat>& images)
+{
+    std::set<const cv::UMatData*> buffers;
+    std::size_t bytes = 0;
+    for (const auto& image : images)
+    {
+        if (image.u && buffers.insert(image.u).second)
+        {
+            bytes += getMemoryUsage(image);
+        }
+    }
+    return bytes;
+}
+
+std::ostream& operator<<(std::ostream& os, const MemoryUsage& usage)
+{
+    const auto kb = [](std::size_t bytes) { return double(bytes) / 1024.0; };
+
+    // clang-format off
+    os << std::left << std::setw(48) << "component"
+       << std::right << std::setw(14) << "cpu(KB)"
+       << std::setw(14) << "gpu(KB)" << std::endl;
+    for (const auto& item : usage.items)
+    {
+        os << std::left << std::setw(48) << item.name
+           << std::right << std::fixed << std::setprecision(1)
+           << std::setw(14) << kb(item.cpu)
+           << std::setw(14) << kb(item.gpu) << std::endl;
+    }
+    os << std::left << std::setw(48) << "total"
+       << std::right << std::setw(14) << kb(usage.cpu())
+       << std::setw(14) << kb(usage.gpu()) << std::endl;
+    // clang-format on
+    return os;
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,79 @@
+/*! -*-c++-*-
+  @file   MemoryUsage.h
+  @author David Hirvonen
+  @brief  Declaration of a memory footprint breakdown for models and pipeline buffers.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_MemoryUsage_h__
+#define __drishti_core_MemoryUsage_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Flat list of named components (e.g., "face/regressor/forests") with the CPU heap bytes
+ * owned by each one and an estimate of the GPU memory (textures and buffers).  The CPU
+ * numbers count container capacity and cv::Mat buffers (not allocator overhead), memory
+ * mapped model arrays are file backed and not counted.  GPU numbers are estimates from the
+ * texture geometry (RGBA8 unless noted).
+ */
+
+struct MemoryUsage
+{
+    struct Item
+    {
+        std::string name;
+        std::size_t cpu; // bytes
+        std::size_t gpu; // bytes (estimated)
+    };
+
+    MemoryUsage& add(const std::string& name, std::size_t cpu, std::size_t gpu = 0);
+
+    // Add all items of usage as "<prefix>/<name>":
+    MemoryUsage& add(const std::string& prefix, const MemoryUsage& usage);
+
+    std::size_t cpu() const;
+    std::size_t gpu() const;
+
+    std::vector<Item> items;
+};
+
+std::ostream& operator<<(std::ostream& os, const MemoryUsage& usage);
+
+// Bytes owned by the buffer of a cv::Mat (the whole buffer for ROIs, 0 for user data):
+inline std::size_t getMemoryUsage(const cv::Mat& image)
+{
+    return (image.u && image.u->size) ? image.u->size : 0;
+}
+
+// Buffers of a set of views, each shared buffer is counted once:
+std::size_t getMemoryUsage(const std::vector<cv::Mat>& images);
+
+template <typename T, typename Allocator>
+std::size_t getMemoryUsage(const std::vector<T, Allocator>& values)
+{
+    return values.capacity() * sizeof(T);
+}
+
+// RGBA8 texture (or buffer) estimate:
+inline std::size_t getTextureMemoryUsage(int width, int height, int count = 1)
+{
+    return std::size_t(std::max(width, 0)) * std::size_t(std::max(height, 0)) * 4 * std::size_t(std::max(count, 0));
+}
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_MemoryUsage_h__
@@ -0,0 +1,278 @@
+/*! -*-c++-*-
+  @file   Metrics.cpp
+  @author David Hirvonen
+  @brief  Implementation of a registry of named counters, gauges and latency histograms.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/Metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+const int Histogram::kSubBucketBits;
+const int Histogram::kMaxBits;
+const int Histogram::kBucketCount;
+
+static int getHighestBit(std::uint64_t value)
+{
+    int bit = 0;
+    while (value >>= 1)
+    {
+        bit++;
+    }
+    return bit;
+}
+
+static void writeName(std::ostream& os, const std::string& name)
+{
+    os << '"';
+    for (const auto& c : name)
+    {
+        if ((c == '"') || (c == '\\'))
+        {
+            os << '\\';
+        }
+        os << c;
+    }
+    os << '"';
+}
+
+// ::: Histogram :::
+
+Histogram::Histogram()
+{
+    reset();
+}
+
+int Histogram::getBucket(std::uint64_t nanoseconds)
+{
+    const std::uint64_t limit = (std::uint64_t(1) << kMaxBits) - 1;
+    nanoseconds = std::min(nanoseconds, limit);
+
+    const std::uint64_t subBuckets = std::uint64_t(1) << kSubBucketBits;
+    if (nanoseconds < subBuckets)
+    {
+        return int(nanoseconds);
+    }
+
+    const int shift = getHighestBit(nanoseconds) - kSubBucketBits;
+    const int mantissa = int((nanoseconds >> shift) & (subBuckets - 1));
+    return ((shift + 1) << kSubBucketBits) + mantissa;
+}
+
+double Histogram::getValue(int bucket)
+{
+    const int subBuckets = 1 << kSubBucketBits;
+    if (bucket < subBuckets)
+    {
+        return double(bucket);
+    }
+
+    const int shift = (bucket >> kSubBucketBits) - 1;
+    const int mantissa = bucket & (subBuckets - 1);
+    const double lower = std::ldexp(double(subBuckets + mantissa), shift);
+    return lower + std::ldexp(0.5, shift);
+}
+
+void Histogram::record(double seconds)
+{
+    const std::uint64_t nanoseconds = (seconds > 0.0) ? std::uint64_t(seconds * 1e9 + 0.5) : 0;
+
+    m_buckets[getBucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+
+    std::uint64_t current = m_min.load(std::memory_order_relaxed);
+    while ((nanoseconds < current) && !m_min.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+
+    current = m_max.load(std::memory_order_relaxed);
+    while ((nanoseconds > current) && !m_max.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+double Histogram::getPercentile(double q) const
+{
+    // Writers may be active, so the total is taken from the buckets that are read:
+    std::uint64_t counts[kBucketCount];
+    std::uint64_t total = 0;
+    for (int i = 0; i < kBucketCount; i++)
+    {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    if (total == 0)
+    {
+        return 0.0;
+    }
+
+    const std::uint64_t rank = std::max(std::uint64_t(std::ceil(std::min(std::max(q, 0.0), 1.0) * total)), std::uint64_t(1));
+    std::uint64_t cumulative = 0;
+    for (int i = 0; i < kBucketCount; i++)
+    {
+        cumulative += counts[i];
+        if (cumulative >= rank)
+        {
+            return getValue(i) * 1e-9;
+        }
+    }
+    return getValue(kBucketCount - 1) * 1e-9;
+}
+
+Histogram::Summary Histogram::getSummary() const
+{
+    Summary summary;
+    summary.count = m_count.load(std::memory_order_relaxed);
+    if (summary.count)
+    {
+        summary.mean = double(m_sum.load(std::memory_order_relaxed)) * 1e-9 / double(summary.count);
+        summary.min = double(m_min.load(std::memory_order_relaxed)) * 1e-9;
+        summary.max = double(m_max.load(std::memory_order_relaxed)) * 1e-9;
+        summary.p50 = getPercentile(0.50);
+        summary.p95 = getPercentile(0.95);
+        summary.p99 = getPercentile(0.99);
+    }
+    return summary;
+}
+
+void Histogram::reset()
+{
+    for (auto& bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+// ::: Metrics :::
+
+Metrics::Metrics() = default;
+Metrics::~Metrics() = default;
+
+template <typename T>
+static T& findOrCreate(std::map<std::string, std::unique_ptr<T>>& metrics, const std::string& name)
+{
+    auto& metric = metrics[name];
+    if (!metric)
+    {
+        metric.reset(new T);
+    }
+    return *metric;
+}
+
+Counter& Metrics::counter(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return findOrCreate(m_counters, name);
+}
+
+Gauge& Metrics::gauge(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return findOrCreate(m_gauges, name);
+}
+
+Histogram& Metrics::histogram(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return findOrCreate(m_histograms, name);
+}
+
+Metrics::Snapshot Metrics::getSnapshot() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Snapshot snapshot;
+    for (const auto& metric : m_counters)
+    {
+        snapshot.counters.emplace_back(metric.first, metric.second->get());
+    }
+    for (const auto& metric : m_gauges)
+    {
+        snapshot.gauges.emplace_back(metric.first, metric.second->get());
+    }
+    for (const auto& metric : m_histograms)
+    {
+        Snapshot::Latency latency;
+        static_cast<Histogram::Summary&>(latency) = metric.second->getSummary();
+        latency.name = metric.first;
+        snapshot.histograms.push_back(latency);
+    }
+    return snapshot;
+}
+
+void Metrics::dump(std::ostream& os) const
+{
+    const auto snapshot = getSnapshot();
+
+    os << "{\"counters\":{";
+    for (std::size_t i = 0; i < snapshot.counters.size(); i++)
+    {
+        os << (i ? "," : "");
+        writeName(os, snapshot.counters[i].first);
+        os << ":" << snapshot.counters[i].second;
+    }
+
+    os << "},\"gauges\":{";
+    for (std::size_t i = 0; i < snapshot.gauges.size(); i++)
+    {
+        os << (i ? "," : "");
+        writeName(os, snapshot.gauges[i].first);
+        os << ":" << snapshot.gauges[i].second;
+    }
+
+    os << "},\"histograms\":{";
+    for (std::size_t i = 0; i < snapshot.histograms.size(); i++)
+    {
+        const auto& h = snapshot.histograms[i];
+        os << (i ? "," : "");
+        writeName(os, h.name);
+        os << ":{\"count\":" << h.count
+           << ",\"mean\":" << h.mean
+           << ",\"min\":" << h.min
+           << ",\"max\":" << h.max
+           << ",\"p50\":" << h.p50
+           << ",\"p95\":" << h.p95
+           << ",\"p99\":" << h.p99 << "}";
+    }
+    os << "}}";
+}
+
+void Metrics::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& metric : m_counters)
+    {
+        metric.second->reset();
+    }
+    for (auto& metric : m_gauges)
+    {
+        metric.second->reset();
+    }
+    for (auto& metric : m_histograms)
+    {
+        metric.second->reset();
+    }
+}
+
+Metrics& Metrics::getInstance()
+{
+    static Metrics instance;
+    return instance;
+}
+
+DRISHTI_CORE_NAMESPACE_END
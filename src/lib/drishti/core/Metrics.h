@@ -0,0 +1,150 @@
+/*! -*-c++-*-
+  @file   Metrics.h
+  @author David Hirvonen
+  @brief  Declaration of a registry of named counters, gauges and latency histograms.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_Metrics_h__
+#define __drishti_core_Metrics_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Metrics are registered by name once (under a lock) and the returned references stay valid
+ * for the lifetime of the registry, so the update path is a relaxed atomic operation without
+ * locks or allocations.  Callers are expected to look a metric up once and keep the reference.
+ */
+
+class Counter
+{
+public:
+    void add(std::uint64_t count = 1) { m_value.fetch_add(count, std::memory_order_relaxed); }
+    std::uint64_t get() const { return m_value.load(std::memory_order_relaxed); }
+    void reset() { m_value.store(0, std::memory_order_relaxed); }
+
+protected:
+    std::atomic<std::uint64_t> m_value{ 0 };
+};
+
+class Gauge
+{
+public:
+    void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+    double get() const { return m_value.load(std::memory_order_relaxed); }
+    void reset() { set(0.0); }
+
+protected:
+    std::atomic<double> m_value{ 0.0 };
+};
+
+/*
+ * HDR style latency histogram: durations are recorded in nanoseconds in log-linear buckets,
+ * 32 linear sub-buckets per power of two, for a relative error below 3% between 1 ns and
+ * ~18 minutes.  Percentiles are reported at the bucket centers.
+ */
+
+class Histogram
+{
+public:
+    static const int kSubBucketBits = 5;
+    static const int kMaxBits = 40;
+    static const int kBucketCount = (kMaxBits - kSubBucketBits + 1) << kSubBucketBits;
+
+    struct Summary
+    {
+        std::uint64_t count = 0;
+        double mean = 0.0; // seconds
+        double min = 0.0;
+        double max = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+    };
+
+    Histogram();
+
+    void record(double seconds);
+
+    // Seconds below which the fraction q of the recorded durations fall:
+    double getPercentile(double q) const;
+
+    Summary getSummary() const;
+
+    std::uint64_t getCount() const { return m_count.load(std::memory_order_relaxed); }
+
+    void reset();
+
+    static int getBucket(std::uint64_t nanoseconds);
+    static double getValue(int bucket); // nanoseconds
+
+protected:
+    std::atomic<std::uint64_t> m_buckets[kBucketCount];
+    std::atomic<std::uint64_t> m_count{ 0 };
+    std::atomic<std::uint64_t> m_sum{ 0 }; // nanoseconds
+    std::atomic<std::uint64_t> m_min;
+    std::atomic<std::uint64_t> m_max{ 0 };
+};
+
+class Metrics
+{
+public:
+    struct Snapshot
+    {
+        struct Latency : public Histogram::Summary
+        {
+            std::string name;
+        };
+
+        std::vector<std::pair<std::string, std::uint64_t>> counters;
+        std::vector<std::pair<std::string, double>> gauges;
+        std::vector<Latency> histograms;
+    };
+
+    Metrics();
+    ~Metrics();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    // Find or register a metric:
+    Counter& counter(const std::string& name);
+    Gauge& gauge(const std::string& name);
+    Histogram& histogram(const std::string& name);
+
+    // Values at the time of the call, sorted by name:
+    Snapshot getSnapshot() const;
+
+    // Write the snapshot as a JSON object:
+    void dump(std::ostream& os) const;
+
+    // Zero all values, registered metrics (and references) remain valid:
+    void reset();
+
+    // The process wide registry, read by the SDK:
+    static Metrics& getInstance();
+
+protected:
+    mutable std::mutex m_mutex; // registration
+    std::map<std::string, std::unique_ptr<Counter>> m_counters;
+    std::map<std::string, std::unique_ptr<Gauge>> m_gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> m_histograms;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_Metrics_h__
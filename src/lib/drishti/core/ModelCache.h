@@ -0,0 +1,101 @@
+/*! -*-c++-*-
+  @file   ModelCache.h
+  @author David Hirvonen
+  @brief  Process wide cache of read only (deserialized) models.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_ModelCache_h__
+#define __drishti_core_ModelCache_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Models are shared by key (i.e., a file path or content hash) and held as weak references,
+ * so an entry is released with the last instance that uses it.  The lock is not held while
+ * loading, so distinct models can be loaded concurrently; if two threads race on the same
+ * key the first result to be inserted wins.
+ */
+
+template <typename T>
+class ModelCache
+{
+public:
+    using Pointer = std::shared_ptr<const T>;
+    using Loader = std::function<std::unique_ptr<T>()>;
+
+    static Pointer get(const std::string& key, const Loader& loader)
+    {
+        auto& cache = instance();
+        {
+            std::lock_guard<std::mutex> lock(cache.m_mutex);
+            if (auto model = cache.find(key))
+            {
+                return model;
+            }
+        }
+
+        Pointer model(loader());
+        if (model)
+        {
+            std::lock_guard<std::mutex> lock(cache.m_mutex);
+            if (auto other = cache.find(key))
+            {
+                return other;
+            }
+            cache.m_models[key] = model;
+        }
+        return model;
+    }
+
+    static std::size_t size()
+    {
+        auto& cache = instance();
+        std::lock_guard<std::mutex> lock(cache.m_mutex);
+        std::size_t count = 0;
+        for (const auto& entry : cache.m_models)
+        {
+            count += !entry.second.expired();
+        }
+        return count;
+    }
+
+protected:
+    static ModelCache& instance()
+    {
+        static ModelCache cache;
+        return cache;
+    }
+
+    Pointer find(const std::string& key)
+    {
+        auto iter = m_models.find(key);
+        if (iter != m_models.end())
+        {
+            if (auto model = iter->second.lock())
+            {
+                return model;
+            }
+            m_models.erase(iter);
+        }
+        return nullptr;
+    }
+
+    std::mutex m_mutex;
+    std::map<std::string, std::weak_ptr<const T>> m_models;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_ModelCache_h__
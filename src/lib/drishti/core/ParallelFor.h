@@ -0,0 +1,103 @@
+/*! -*-c++-*-
+  @file   ParallelFor.h
+  @author David Hirvonen
+  @brief  Declaration of a simple parallel_for for core::Executor
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_ParallelFor_h__
+#define __drishti_core_ParallelFor_h__ 1
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/Executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Run function(i) for i in [0,n) using the calling thread and up to maxWorkers
+ * helper tasks posted to the pool.  The calling thread always participates and
+ * we never block on a helper future, so this is safe to call from inside a task
+ * that is itself running on the same (possibly saturated) pool; helpers posted
+ * from a worker land on its own deque, where idle workers steal them.  The first
+ * exception thrown by function is rethrown on the calling thread.
+ */
+
+template <typename Callable>
+void parallel_for(Executor* pool, int n, Callable&& function, int maxWorkers = -1, Executor::Priority priority = Executor::kLatency)
+{
+    struct State
+    {
+        std::atomic<int> next{ 0 };
+        std::atomic<int> done{ 0 };
+        int n = 0;
+        std::function<void(int)> function;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+
+    if (n <= 0)
+    {
+        return;
+    }
+
+    auto state = std::make_shared<State>();
+    state->n = n;
+    state->function = std::forward<Callable>(function);
+
+    // Late helpers find no work and touch only the shared state:
+    auto work = [state]() {
+        int i = 0;
+        while ((i = state->next++) < state->n)
+        {
+            try
+            {
+                state->function(i);
+            }
+            catch (...)
+            {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                if (!state->error)
+                {
+                    state->error = std::current_exception();
+                }
+            }
+
+            if (++state->done == state->n)
+            {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->condition.notify_all();
+            }
+        }
+    };
+
+    const int helpers = pool ? std::min(n - 1, (maxWorkers < 0) ? (n - 1) : maxWorkers) : 0;
+    for (int i = 0; i < helpers; i++)
+    {
+        pool->post(work, priority);
+    }
+
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&]() { return state->done == state->n; });
+    if (state->error)
+    {
+        std::rethrow_exception(state->error);
+    }
+}
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_ParallelFor_h__
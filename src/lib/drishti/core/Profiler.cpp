@@ -0,0 +1,145 @@
+/*! -*-c++-*-
+  @file   Profiler.cpp
+  @author David Hirvonen
+  @brief  Implementation of zone markers for the platform profilers (ATrace, os_signpost, ITT).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/Profiler.h"
+
+#if DRISHTI_PROFILER
+
+// clang-format off
+#if defined(DRISHTI_PROFILER_ITT)
+#  include <ittnotify.h>
+#elif defined(__ANDROID__)
+#  include <android/api-level.h>
+#  if __ANDROID_API__ >= 23
+#    include <android/trace.h>
+#    define DRISHTI_PROFILER_ATRACE 1
+#  endif
+#elif defined(__APPLE__)
+#  include <os/signpost.h>
+#  define DRISHTI_PROFILER_SIGNPOST 1
+#endif
+// clang-format on
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+#if defined(DRISHTI_PROFILER_ITT)
+
+static __itt_domain* getDomain()
+{
+    static __itt_domain* domain = __itt_domain_create("drishti");
+    return domain;
+}
+
+std::uint64_t beginProfileZone(const char* name)
+{
+    __itt_task_begin(getDomain(), __itt_null, __itt_null, __itt_string_handle_create(name));
+    return 0;
+}
+
+void endProfileZone(const char* /* name */, std::uint64_t /* id */)
+{
+    __itt_task_end(getDomain());
+}
+
+void markProfileEvent(const char* name)
+{
+    __itt_marker(getDomain(), __itt_null, __itt_string_handle_create(name), __itt_scope_thread);
+}
+
+#elif defined(DRISHTI_PROFILER_ATRACE)
+
+// Sections nest per thread, so no id is needed:
+std::uint64_t beginProfileZone(const char* name)
+{
+    if (ATrace_isEnabled())
+    {
+        ATrace_beginSection(name);
+        return 1;
+    }
+    return 0;
+}
+
+void endProfileZone(const char* /* name */, std::uint64_t id)
+{
+    if (id)
+    {
+        ATrace_endSection();
+    }
+}
+
+void markProfileEvent(const char* name)
+{
+    if (ATrace_isEnabled())
+    {
+        ATrace_beginSection(name); // no instant events: an empty section
+        ATrace_endSection();
+    }
+}
+
+#elif defined(DRISHTI_PROFILER_SIGNPOST)
+
+static os_log_t getLog()
+{
+    static os_log_t log = os_log_create("com.elucideye.drishti", "stages");
+    return log;
+}
+
+// Signpost names must be literals, the zone name is the (public) message:
+std::uint64_t beginProfileZone(const char* name)
+{
+    if (__builtin_available(iOS 12.0, macOS 10.14, tvOS 12.0, *))
+    {
+        os_log_t log = getLog();
+        if (os_signpost_enabled(log))
+        {
+            const os_signpost_id_t id = os_signpost_id_generate(log);
+            os_signpost_interval_begin(log, id, "zone", "%{public}s", name);
+            return id;
+        }
+    }
+    return 0;
+}
+
+void endProfileZone(const char* name, std::uint64_t id)
+{
+    if (__builtin_available(iOS 12.0, macOS 10.14, tvOS 12.0, *))
+    {
+        if (id)
+        {
+            os_signpost_interval_end(getLog(), id, "zone", "%{public}s", name);
+        }
+    }
+}
+
+void markProfileEvent(const char* name)
+{
+    if (__builtin_available(iOS 12.0, macOS 10.14, tvOS 12.0, *))
+    {
+        os_signpost_event_emit(getLog(), OS_SIGNPOST_ID_EXCLUSIVE, "mark", "%{public}s", name);
+    }
+}
+
+#else
+
+// The back-end isn't available on this platform (or API level):
+std::uint64_t beginProfileZone(const char* /* name */)
+{
+    return 0;
+}
+
+void endProfileZone(const char* /* name */, std::uint64_t /* id */) {}
+
+void markProfileEvent(const char* /* name */) {}
+
+#endif
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // DRISHTI_PROFILER
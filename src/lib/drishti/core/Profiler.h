@@ -0,0 +1,87 @@
+/*! -*-c++-*-
+  @file   Profiler.h
+  @author David Hirvonen
+  @brief  Declaration of zone markers for the platform profilers (ATrace, os_signpost, ITT).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_Profiler_h__
+#define __drishti_core_Profiler_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <cstdint>
+
+// -DDRISHTI_PROFILER=(0|1) is set from the DRISHTI_PROFILER back-end (CMake):
+#if !defined(DRISHTI_PROFILER)
+#define DRISHTI_PROFILER 0
+#endif
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Zones are labelled intervals on the calling thread, marks are labelled instants.  Names
+ * must have static storage (literals, __func__, DRISHTI_LOCATION_STATIC).  The back-end is
+ * selected at configuration time:
+ *
+ *   native : ATrace sections (Android, API 23+) or os_signpost intervals (iOS 12, macOS 10.14)
+ *   itt    : Intel ITT tasks and markers (VTune)
+ *
+ * so drishti stages show up in systrace/Perfetto or Instruments next to the GPU and camera
+ * activity.  Without a back-end the markers compile to nothing.
+ */
+
+#if DRISHTI_PROFILER
+std::uint64_t beginProfileZone(const char* name); // returns the id for endProfileZone()
+void endProfileZone(const char* name, std::uint64_t id);
+void markProfileEvent(const char* name);
+#else
+inline std::uint64_t beginProfileZone(const char* /* name */)
+{
+    return 0;
+}
+inline void endProfileZone(const char* /* name */, std::uint64_t /* id */) {}
+inline void markProfileEvent(const char* /* name */) {}
+#endif
+
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name)
+        : m_name(name)
+        , m_id(beginProfileZone(name))
+    {
+    }
+
+    ~ProfileZone()
+    {
+        endProfileZone(m_name, m_id);
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    void operator=(const ProfileZone&) = delete;
+
+protected:
+    const char* m_name;
+    std::uint64_t m_id;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+// clang-format off
+#define DRISHTI_PROFILE_CAT_(a, b) a##b
+#define DRISHTI_PROFILE_CAT(a, b) DRISHTI_PROFILE_CAT_(a, b)
+#if DRISHTI_PROFILER
+#  define DRISHTI_PROFILE_ZONE(name) drishti::core::ProfileZone DRISHTI_PROFILE_CAT(drishti_profile_zone_, __LINE__)(name)
+#  define DRISHTI_PROFILE_MARK(name) drishti::core::markProfileEvent(name)
+#else
+#  define DRISHTI_PROFILE_ZONE(name)
+#  define DRISHTI_PROFILE_MARK(name)
+#endif
+#define DRISHTI_PROFILE_FUNCTION() DRISHTI_PROFILE_ZONE(__func__)
+// clang-format on
+
+#endif // __drishti_core_Profiler_h__
@@ -0,0 +1,157 @@
+/*! -*-c++-*-
+  @file   ResultsCache.h
+  @author David Hirvonen
+  @brief  Content hash keyed cache of per image results for batch tools.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_ResultsCache_h__
+#define __drishti_core_ResultsCache_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Batch runs see exact duplicates (re-uploads, repeated frames), so results are cached by a
+ * 64 bit content hash of the decoded image, seeded with a hash of the models and settings
+ * (a change of either is a different key).  The hash is fast (8 bytes per step, murmur3
+ * style mixing) but not cryptographic, and 0 is reserved for "no key".
+ */
+
+inline std::uint64_t hashFinalize(std::uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+inline std::uint64_t hashCombine(std::uint64_t seed, std::uint64_t value)
+{
+    const std::uint64_t k1 = 0x87c37b91114253d5ULL, k2 = 0x4cf5ad432745937fULL;
+    value *= k1;
+    value = (value << 31) | (value >> 33);
+    value *= k2;
+    seed ^= value;
+    seed = (seed << 27) | (seed >> 37);
+    return seed * 5 + 0x52dce729;
+}
+
+inline std::uint64_t hashBytes(const void* data, std::size_t size, std::uint64_t seed = 0)
+{
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    std::uint64_t h = hashCombine(seed, size);
+    for (; size >= 8; size -= 8, bytes += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes, 8);
+        h = hashCombine(h, word);
+    }
+    if (size)
+    {
+        std::uint64_t word = 0;
+        std::memcpy(&word, bytes, size);
+        h = hashCombine(h, word);
+    }
+    return h;
+}
+
+inline std::uint64_t hashString(const std::string& value, std::uint64_t seed = 0)
+{
+    return hashBytes(value.data(), value.size(), seed);
+}
+
+// File bytes (i.e., models), 0 if the file can't be read:
+inline std::uint64_t hashFile(const std::string& filename, std::uint64_t seed = 0)
+{
+    std::ifstream is(filename, std::ios::binary);
+    if (!is)
+    {
+        return 0;
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    return hashString(bytes, seed);
+}
+
+// Pixels (row by row for submatrices), size and type:
+inline std::uint64_t hashImage(const cv::Mat& image, std::uint64_t seed = 0)
+{
+    std::uint64_t h = hashCombine(hashCombine(hashCombine(seed, image.rows), image.cols), image.type());
+    const std::size_t bytes = image.cols * image.elemSize();
+    if (image.isContinuous())
+    {
+        h = hashBytes(image.data, bytes * image.rows, h);
+    }
+    else
+    {
+        for (int y = 0; y < image.rows; y++)
+        {
+            h = hashBytes(image.ptr(y), bytes, h);
+        }
+    }
+
+    const std::uint64_t key = hashFinalize(h);
+    return key ? key : 1;
+}
+
+template <typename T>
+class ResultsCache
+{
+public:
+    bool find(std::uint64_t key, T& value) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto iter = m_values.find(key);
+        if (iter != m_values.end())
+        {
+            value = iter->second;
+            m_hits++;
+            return true;
+        }
+        return false;
+    }
+
+    // The first value of a key is kept:
+    void insert(std::uint64_t key, const T& value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_values.emplace(key, value);
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_values.size();
+    }
+
+    std::size_t hits() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_hits;
+    }
+
+protected:
+    mutable std::mutex m_mutex;
+    mutable std::size_t m_hits = 0;
+    std::unordered_map<std::uint64_t, T> m_values;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_ResultsCache_h__
@@ -0,0 +1,314 @@
+/*! -*-c++-*-
+  @file   RingQueue.h
+  @author David Hirvonen
+  @brief  Bounded lock free ring queues for hand off between pipeline threads.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_RingQueue_h__
+#define __drishti_core_RingQueue_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#define DRISHTI_CACHE_LINE_SIZE 64
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Fixed capacity (rounded up to a power of 2) FIFO queues allocated once at construction.
+ * The producer and consumer indices live on separate cache lines, and tryPush()/tryPop()
+ * never block, lock or allocate.  Values are moved in and out of default constructed slots.
+ *
+ * SPSCQueue : one producer thread and one consumer thread (i.e., GL thread -> CPU worker).
+ * MPMCQueue : any number of threads on each side (D. Vyukov's bounded MPMC queue).
+ *
+ * The blocking push()/pop() wait with a spin, yield, sleep backoff instead of a condition
+ * variable, which keeps the hand off latency low when the queue is busy.
+ */
+
+class Backoff
+{
+public:
+    void operator()()
+    {
+        if (m_count < 64)
+        {
+            // spin
+        }
+        else if (m_count < 128)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        m_count++;
+    }
+
+    void reset() { m_count = 0; }
+
+protected:
+    int m_count = 0;
+};
+
+inline std::size_t getRingCapacity(std::size_t capacity)
+{
+    std::size_t size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    return size;
+}
+
+template <typename T>
+class SPSCQueue
+{
+public:
+    explicit SPSCQueue(std::size_t capacity)
+        : m_mask(getRingCapacity(capacity) - 1)
+        , m_slots(new T[m_mask + 1])
+    {
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    // Producer:
+    bool tryPush(T&& value)
+    {
+        const std::size_t tail = m_producer.tail.load(std::memory_order_relaxed);
+        if ((tail - m_producer.head) > m_mask)
+        {
+            m_producer.head = m_consumer.head.load(std::memory_order_acquire);
+            if ((tail - m_producer.head) > m_mask)
+            {
+                return false; // full
+            }
+        }
+
+        m_slots[tail & m_mask] = std::move(value);
+        m_producer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T& value)
+    {
+        T copy(value);
+        return tryPush(std::move(copy));
+    }
+
+    void push(T&& value)
+    {
+        Backoff backoff;
+        while (!tryPush(std::move(value)))
+        {
+            backoff();
+        }
+    }
+
+    // Consumer:
+    bool tryPop(T& value)
+    {
+        const std::size_t head = m_consumer.head.load(std::memory_order_relaxed);
+        if (head == m_consumer.tail)
+        {
+            m_consumer.tail = m_producer.tail.load(std::memory_order_acquire);
+            if (head == m_consumer.tail)
+            {
+                return false; // empty
+            }
+        }
+
+        value = std::move(m_slots[head & m_mask]);
+        m_consumer.head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    void pop(T& value)
+    {
+        Backoff backoff;
+        while (!tryPop(value))
+        {
+            backoff();
+        }
+    }
+
+    // Approximate when called during updates:
+    std::size_t size() const
+    {
+        return m_producer.tail.load(std::memory_order_acquire) - m_consumer.head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+protected:
+    struct alignas(DRISHTI_CACHE_LINE_SIZE) Producer
+    {
+        std::atomic<std::size_t> tail{ 0 };
+        std::size_t head = 0; // cached m_consumer.head
+    };
+
+    struct alignas(DRISHTI_CACHE_LINE_SIZE) Consumer
+    {
+        std::atomic<std::size_t> head{ 0 };
+        std::size_t tail = 0; // cached m_producer.tail
+    };
+
+    const std::size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+
+    Producer m_producer;
+    Consumer m_consumer;
+};
+
+template <typename T>
+class MPMCQueue
+{
+public:
+    explicit MPMCQueue(std::size_t capacity)
+        : m_mask(getRingCapacity(capacity) - 1)
+        , m_cells(new Cell[m_mask + 1])
+    {
+        for (std::size_t i = 0; i <= m_mask; i++)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    bool tryPush(T&& value)
+    {
+        Cell* cell = nullptr;
+        std::size_t position = m_tail.value.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &m_cells[position & m_mask];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const std::intptr_t difference = std::intptr_t(sequence) - std::intptr_t(position);
+            if (difference == 0)
+            {
+                if (m_tail.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                position = m_tail.value.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T& value)
+    {
+        T copy(value);
+        return tryPush(std::move(copy));
+    }
+
+    void push(T&& value)
+    {
+        Backoff backoff;
+        while (!tryPush(std::move(value)))
+        {
+            backoff();
+        }
+    }
+
+    bool tryPop(T& value)
+    {
+        Cell* cell = nullptr;
+        std::size_t position = m_head.value.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &m_cells[position & m_mask];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const std::intptr_t difference = std::intptr_t(sequence) - std::intptr_t(position + 1);
+            if (difference == 0)
+            {
+                if (m_head.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false; // empty
+            }
+            else
+            {
+                position = m_head.value.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(cell->value);
+        cell->sequence.store(position + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    void pop(T& value)
+    {
+        Backoff backoff;
+        while (!tryPop(value))
+        {
+            backoff();
+        }
+    }
+
+    // Approximate when called during updates:
+    std::size_t size() const
+    {
+        const std::size_t head = m_head.value.load(std::memory_order_acquire);
+        const std::size_t tail = m_tail.value.load(std::memory_order_acquire);
+        return (tail > head) ? (tail - head) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+protected:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence{ 0 };
+        T value;
+    };
+
+    struct alignas(DRISHTI_CACHE_LINE_SIZE) Index
+    {
+        std::atomic<std::size_t> value{ 0 };
+    };
+
+    const std::size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+
+    Index m_head;
+    Index m_tail;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_RingQueue_h__
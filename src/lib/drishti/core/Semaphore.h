@@ -12,7 +12,9 @@
 #define __drishti_core_Semaphore_h__ 1
 
 #include "drishti/core/drishti_core.h"
-#include "thread_pool/thread_pool.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
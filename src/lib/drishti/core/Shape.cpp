@@ -14,7 +14,10 @@
 
 #include <unsupported/Eigen/Splines>
 
+#include <array>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <string>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
@@ -120,8 +123,17 @@ static void upsample(const Eigen::Spline<double, 2>& spline, int extent, float k
 {
     const float arcSpan = k1 - k0;
 
+    // Per thread buffers for the dense arc (no per call allocations):
+    struct Workspace
+    {
+        std::vector<cv::Point2f> arc;
+        std::vector<float> arcLengthsAccum;
+    };
+    static thread_local Workspace workspace;
+
     // Denseley sample the spline to create an arc:
-    std::vector<cv::Point2f> arc(1000);
+    auto& arc = workspace.arc;
+    arc.resize(1000);
     {
         const float tic = arcSpan / float(arc.size());
         for (int j = 0; j < arc.size(); j++)
@@ -132,31 +144,29 @@ static void upsample(const Eigen::Spline<double, 2>& spline, int extent, float k
         }
 
         float arcLength = 0.f;
-        std::vector<float> arcLengths(arc.size() - 1);
-        std::vector<float> arcLengthsAccum(arcLengths.size());
-        for (int j = 0; j < arcLengths.size(); j++)
+        auto& arcLengthsAccum = workspace.arcLengthsAccum;
+        arcLengthsAccum.resize(arc.size() - 1);
+        for (int j = 0; j < arcLengthsAccum.size(); j++)
         {
-            const float segmentLength = cv::norm(arc[j + 1] - arc[j + 0]);
-            arcLength += segmentLength;
-            arcLengths[j] = segmentLength;
+            arcLength += cv::norm(arc[j + 1] - arc[j + 0]);
             arcLengthsAccum[j] = arcLength;
         }
 
         interpolatedPoints.push_back(arc[0]);
 
-        float spacing = arcLength / float(extent); // desired spacing
-        for (int j = 0; j < extent; j++)
+        // Targets are increasing, so the segment search resumes where the last one stopped:
+        const int size = int(arcLengthsAccum.size());
+        const float spacing = arcLength / float(extent); // desired spacing
+        for (int j = 0, k = 1; j < extent; j++)
         {
-            float arcLengthTarget = float(j) * spacing;
-            for (int k = 1; k < arcLengthsAccum.size(); k++)
+            const float arcLengthTarget = float(j) * spacing;
+            while ((k < size) && (arcLengthsAccum[k] <= arcLengthTarget))
+            {
+                k++;
+            }
+            if ((k < size) && (arcLengthsAccum[k - 1] <= arcLengthTarget))
             {
-                float v0 = arcLengthsAccum[k - 1];
-                float v1 = arcLengthsAccum[k + 0];
-                if (v0 <= arcLengthTarget && arcLengthTarget < v1)
-                {
-                    interpolatedPoints.push_back(arc[k]);
-                    break;
-                }
+                interpolatedPoints.push_back(arc[k]);
             }
         }
     }
@@ -203,6 +213,79 @@ void upsample(const PointVec& controlPoints, PointVec& interpolatedPoints, int f
     }
 }
 
+// ((((((((((((((( SplineBasis )))))))))))))))
+
+SplineBasis::SplineBasis(int points, int count, bool closed)
+    : m_basis(count, points, 0.f)
+    , m_closed(closed)
+{
+    using Spline1d = Eigen::Spline<double, 1>;
+
+    // The closed contour repeats the first point (see fitSpline()):
+    const int length = points + int(closed);
+    if (length < 2)
+    {
+        m_basis = 1.f;
+        return;
+    }
+
+    Spline1d::KnotVectorType knots(length);
+    for (int i = 0; i < length; i++)
+    {
+        knots(i) = double(i) / double(length - 1);
+    }
+
+    // Column j is the interpolated response to the j'th unit control point:
+    for (int j = 0; j < points; j++)
+    {
+        Spline1d::ControlPointVectorType values = Spline1d::ControlPointVectorType::Zero(1, length);
+        values(0, j) = 1.0;
+        if (closed && (j == 0))
+        {
+            values(0, points) = 1.0;
+        }
+
+        const Spline1d spline = Eigen::SplineFitting<Spline1d>::Interpolate(values, std::min(3, length - 1), knots);
+        for (int i = 0; i < count; i++)
+        {
+            m_basis(i, j) = static_cast<float>(spline(double(i) / double(count))(0));
+        }
+    }
+}
+
+void SplineBasis::operator()(const PointVec& controlPoints, PointVec& interpolatedPoints) const
+{
+    CV_Assert(int(controlPoints.size()) == m_basis.cols);
+
+    interpolatedPoints.resize(m_basis.rows);
+    for (int i = 0; i < m_basis.rows; i++)
+    {
+        const float* weights = m_basis[i];
+
+        cv::Point2f p(0.f, 0.f);
+        for (int j = 0; j < m_basis.cols; j++)
+        {
+            p += weights[j] * controlPoints[j];
+        }
+        interpolatedPoints[i] = p;
+    }
+}
+
+const SplineBasis& SplineBasis::get(int points, int count, bool closed)
+{
+    static std::mutex mutex;
+    static std::map<std::array<int, 3>, SplineBasis> bases; // stable references
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::array<int, 3> key{ { points, count, int(closed) } };
+    auto iter = bases.find(key);
+    if (iter == bases.end())
+    {
+        iter = bases.emplace(key, SplineBasis(points, count, closed)).first;
+    }
+    return iter->second;
+}
+
 // These OpenCV functions must be in global namespace
 void write(cv::FileStorage& fs, const std::string&, const drishti::core::Shape& x)
 {
@@ -28,6 +28,33 @@ void fitSpline(const PointVec& controlPoints, PointVec& interpolatedPoints, int
 
 void upsample(const PointVec& controlPoints, PointVec& interpolatedPoints, int factor, bool closed);
 
+/*
+ * Cubic spline interpolation for a fixed control point count with uniform knots, which is
+ * linear in the control points: the interpolated contour is a precomputed (count x points)
+ * basis matrix times the control points.  The closed variant matches fitSpline() layout.
+ */
+
+class SplineBasis
+{
+public:
+    SplineBasis() = default;
+    SplineBasis(int points, int count, bool closed);
+
+    // Interpolate into the reused buffer (controlPoints.size() must match getPoints()):
+    void operator()(const PointVec& controlPoints, PointVec& interpolatedPoints) const;
+
+    int getPoints() const { return m_basis.cols; }
+    int getCount() const { return m_basis.rows; }
+    bool isClosed() const { return m_closed; }
+
+    // Shared basis for the given geometry, created on first use (thread safe):
+    static const SplineBasis& get(int points, int count, bool closed);
+
+protected:
+    cv::Mat1f m_basis;
+    bool m_closed = false;
+};
+
 template <typename T>
 inline cv::Point_<T> centroid(const std::vector<cv::Point_<T>>& contour, int n = std::numeric_limits<int>::max())
 {
@@ -14,8 +14,7 @@ DRISHTI_CORE_NAMESPACE_BEGIN
 
 ThreadPoolSource::FixedThreadPool* ThreadPoolSource::getInstance()
 {
-    static FixedThreadPool instance;
-    return &instance;
+    return Executor::getInstance().get();
 }
 
 DRISHTI_CORE_NAMESPACE_END
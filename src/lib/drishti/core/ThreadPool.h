@@ -12,15 +12,17 @@
 #define __drishti_core_ThreadPool_h__ 1
 
 #include "drishti/core/drishti_core.h"
-#include "thread_pool/thread_pool.hpp"
+#include "drishti/core/Executor.h"
+
+#include <memory>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
 class ThreadPoolSource
 {
 public:
-    using FixedThreadPool = tp::ThreadPool<>;
-    static FixedThreadPool* getInstance();
+    using FixedThreadPool = Executor;
+    static FixedThreadPool* getInstance(); // i.e., Executor::getInstance()
 
 private:
     ThreadPoolSource() {}
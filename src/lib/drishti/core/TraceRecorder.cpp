@@ -0,0 +1,152 @@
+/*! -*-c++-*-
+  @file   TraceRecorder.cpp
+  @author David Hirvonen
+  @brief  Implementation of a fixed capacity ring buffer of timed scopes (Chrome trace export).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/TraceRecorder.h"
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+static thread_local uint64_t sFrameIndex = 0;
+
+std::atomic<TraceRecorder*> TraceRecorder::m_active{ nullptr };
+
+static uint32_t getThreadId()
+{
+    return static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+static void writeEscaped(std::ostream& os, const char* name)
+{
+    for (const char* c = (name ? name : "scope"); *c; c++)
+    {
+        if ((*c == '"') || (*c == '\\'))
+        {
+            os << '\\';
+        }
+        os << *c;
+    }
+}
+
+TraceRecorder::TraceRecorder(std::size_t capacity)
+    : m_slots(std::max(capacity, std::size_t(1)))
+    , m_epoch(HighResolutionClock::now())
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    TraceRecorder* self = this;
+    m_active.compare_exchange_strong(self, nullptr);
+}
+
+void TraceRecorder::record(const char* name, const TimePoint& begin, const TimePoint& end)
+{
+    // Each slot acts as a small seqlock so that readers can skip torn events, the fence keeps
+    // the payload stores from moving before the odd sequence:
+    const uint64_t index = m_next++;
+    auto& slot = m_slots[index % m_slots.size()];
+    slot.sequence.store((index * 2) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.frameIndex.store(sFrameIndex, std::memory_order_relaxed);
+    slot.threadId.store(getThreadId(), std::memory_order_relaxed);
+    slot.begin.store(begin.time_since_epoch().count(), std::memory_order_relaxed);
+    slot.end.store(end.time_since_epoch().count(), std::memory_order_relaxed);
+    slot.sequence.store((index * 2) + 2, std::memory_order_release);
+}
+
+std::vector<TraceRecorder::Event> TraceRecorder::getEvents() const
+{
+    const uint64_t next = m_next.load(std::memory_order_acquire);
+    const uint64_t count = std::min(next, static_cast<uint64_t>(m_slots.size()));
+
+    std::vector<Event> events;
+    events.reserve(count);
+    for (uint64_t index = next - count; index < next; index++)
+    {
+        const auto& slot = m_slots[index % m_slots.size()];
+        const uint64_t expected = (index * 2) + 2;
+        if (slot.sequence.load(std::memory_order_acquire) == expected)
+        {
+            Event event;
+            event.name = slot.name.load(std::memory_order_relaxed);
+            event.frameIndex = slot.frameIndex.load(std::memory_order_relaxed);
+            event.threadId = slot.threadId.load(std::memory_order_relaxed);
+            event.begin = TimePoint(TimePoint::duration(slot.begin.load(std::memory_order_relaxed)));
+            event.end = TimePoint(TimePoint::duration(slot.end.load(std::memory_order_relaxed)));
+
+            // The payload loads must complete before the sequence is checked again:
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == expected)
+            {
+                events.push_back(event);
+            }
+        }
+    }
+    return events;
+}
+
+void TraceRecorder::dump(std::ostream& os) const
+{
+    using Microseconds = std::chrono::duration<double, std::micro>;
+
+    const auto events = getEvents();
+
+    os << "{\"traceEvents\":[";
+    for (std::size_t i = 0; i < events.size(); i++)
+    {
+        const auto& e = events[i];
+        const double ts = Microseconds(e.begin - m_epoch).count();
+        const double dur = Microseconds(e.end - e.begin).count();
+
+        os << (i ? ",\n" : "\n") << "{\"name\":\"";
+        writeEscaped(os, e.name);
+        os << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.threadId
+           << ",\"ts\":" << ts
+           << ",\"dur\":" << dur
+           << ",\"args\":{\"frame\":" << e.frameIndex << "}}";
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void TraceRecorder::clear()
+{
+    m_next = 0;
+    for (auto& slot : m_slots)
+    {
+        slot.sequence = 0;
+    }
+}
+
+void TraceRecorder::setFrameIndex(uint64_t frameIndex)
+{
+    sFrameIndex = frameIndex;
+}
+
+uint64_t TraceRecorder::getFrameIndex()
+{
+    return sFrameIndex;
+}
+
+void TraceRecorder::setActive(TraceRecorder* recorder)
+{
+    m_active = recorder;
+}
+
+TraceRecorder* TraceRecorder::getActive()
+{
+    return m_active.load(std::memory_order_acquire);
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,92 @@
+/*! -*-c++-*-
+  @file   TraceRecorder.h
+  @author David Hirvonen
+  @brief  Declaration of a fixed capacity ring buffer of timed scopes (Chrome trace export).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_TraceRecorder_h__
+#define __drishti_core_TraceRecorder_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Records timed scopes (i.e., ScopeTimeLogger) into a ring buffer that is
+ * allocated once at construction. Writers only perform an atomic increment
+ * and a slot copy, so the recorder can be left enabled in production builds.
+ * The most recent events can be exported in the Chrome trace event format
+ * (chrome://tracing or https://ui.perfetto.dev).
+ */
+
+class TraceRecorder
+{
+public:
+    using HighResolutionClock = std::chrono::high_resolution_clock;
+    using TimePoint = HighResolutionClock::time_point;
+
+    struct Event
+    {
+        const char* name = nullptr; // static storage (string literal)
+        uint64_t frameIndex = 0;
+        uint32_t threadId = 0;
+        TimePoint begin;
+        TimePoint end;
+    };
+
+    TraceRecorder(std::size_t capacity = 4096);
+    ~TraceRecorder();
+
+    void record(const char* name, const TimePoint& begin, const TimePoint& end);
+
+    // Return the retained events in submission order:
+    std::vector<Event> getEvents() const;
+
+    // Write retained events as a Chrome trace JSON object:
+    void dump(std::ostream& os) const;
+
+    void clear();
+
+    std::size_t capacity() const { return m_slots.size(); }
+
+    // Frame index tag for events recorded on the calling thread:
+    static void setFrameIndex(uint64_t frameIndex);
+    static uint64_t getFrameIndex();
+
+    // A single process wide recorder is used by ScopeTimeLogger (may be null):
+    static void setActive(TraceRecorder* recorder);
+    static TraceRecorder* getActive();
+
+protected:
+    // The payload is stored in relaxed atomics, so torn reads are detected but never a data race:
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{ 0 }; // odd : write in progress
+        std::atomic<const char*> name{ nullptr };
+        std::atomic<uint64_t> frameIndex{ 0 };
+        std::atomic<uint32_t> threadId{ 0 };
+        std::atomic<TimePoint::rep> begin{ 0 };
+        std::atomic<TimePoint::rep> end{ 0 };
+    };
+
+    std::vector<Slot> m_slots;
+    std::atomic<uint64_t> m_next{ 0 };
+    TimePoint m_epoch;
+
+    static std::atomic<TraceRecorder*> m_active;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_TraceRecorder_h__
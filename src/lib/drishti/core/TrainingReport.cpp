@@ -0,0 +1,122 @@
+/*! -*-c++-*-
+  @file   TrainingReport.cpp
+  @author David Hirvonen
+  @brief  Implementation of per cascade phase timing and memory reports for the trainers.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/TrainingReport.h"
+
+// clang-format off
+#if defined(__APPLE__)
+#  include <mach/mach.h>
+#  include <sys/resource.h>
+#elif defined(__linux__) || defined(__ANDROID__)
+#  include <sys/resource.h>
+#  include <unistd.h>
+#endif
+// clang-format on
+
+#include <fstream>
+#include <sstream>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+static std::string quote(const std::string& name)
+{
+    std::string result = "\"";
+    for (const auto& c : name)
+    {
+        if ((c == '"') || (c == '\\'))
+        {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result + "\"";
+}
+
+TrainingReport::TrainingReport(const std::string& trainer, std::ostream* os)
+    : m_trainer(trainer)
+    , m_os(os)
+    , m_tic(HighResolutionClock::now())
+{
+}
+
+void TrainingReport::beginCascade(int cascade)
+{
+    m_cascade = cascade;
+    m_tic = HighResolutionClock::now();
+}
+
+void TrainingReport::endCascade()
+{
+    const double seconds = ScopeTimeLogger::timeDifference(HighResolutionClock::now(), m_tic);
+    const auto snapshot = m_metrics.getSnapshot();
+
+    if (m_os)
+    {
+        // Format the whole line first, so concurrent trainers sharing a stream don't interleave:
+        std::stringstream ss;
+        ss << "{\"trainer\":" << quote(m_trainer)
+           << ",\"cascade\":" << m_cascade
+           << ",\"seconds\":" << seconds
+           << ",\"memory\":{\"resident\":" << getResidentMemory() << ",\"peak\":" << getPeakResidentMemory() << "}"
+           << ",\"phases\":{";
+        for (std::size_t i = 0; i < snapshot.histograms.size(); i++)
+        {
+            const auto& h = snapshot.histograms[i];
+            ss << (i ? "," : "") << quote(h.name) << ":" << (h.mean * double(h.count));
+        }
+        ss << "},\"metrics\":";
+        m_metrics.dump(ss);
+        ss << "}\n";
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        (*m_os) << ss.str() << std::flush;
+    }
+
+    m_metrics.reset();
+}
+
+std::size_t TrainingReport::getResidentMemory()
+{
+#if defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+    {
+        return std::size_t(info.resident_size);
+    }
+#elif defined(__linux__) || defined(__ANDROID__)
+    // The second field of statm is the resident set size in pages:
+    std::ifstream is("/proc/self/statm");
+    std::size_t size = 0, resident = 0;
+    if (is >> size >> resident)
+    {
+        return resident * std::size_t(sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return 0;
+}
+
+std::size_t TrainingReport::getPeakResidentMemory()
+{
+#if defined(__APPLE__) || defined(__linux__) || defined(__ANDROID__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#if defined(__APPLE__)
+        return std::size_t(usage.ru_maxrss); // bytes
+#else
+        return std::size_t(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+    }
+#endif
+    return 0;
+}
+
+DRISHTI_CORE_NAMESPACE_END
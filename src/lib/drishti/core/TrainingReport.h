@@ -0,0 +1,72 @@
+/*! -*-c++-*-
+  @file   TrainingReport.h
+  @author David Hirvonen
+  @brief  Declaration of per cascade phase timing and memory reports for the trainers.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_TrainingReport_h__
+#define __drishti_core_TrainingReport_h__ 1
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/Metrics.h"
+#include "drishti/core/timing.h"
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Phases of a cascade (feature extraction, split search, I/O, ...) are timed into latency
+ * histograms of a Metrics registry, so nested and multithreaded phases are recorded without
+ * locks.  At the end of each cascade one JSON object is written per line:
+ *
+ * {"trainer":"cpr","cascade":3,"seconds":12.5,"memory":{"resident":...,"peak":...},
+ *  "phases":{"features":0.8,...},"metrics":{"counters":...,"gauges":...,"histograms":...}}
+ *
+ * where the phase values are the total seconds (the sum over all threads for phases timed
+ * from worker tasks) and the memory values are the current and high-water resident set
+ * sizes of the process in bytes (0 : unknown on this platform).  The metrics are reset for
+ * the next cascade, phases timed before the first cascade (i.e., setup) are reported with it.
+ */
+
+class TrainingReport
+{
+public:
+    using HighResolutionClock = std::chrono::high_resolution_clock;
+
+    TrainingReport(const std::string& trainer, std::ostream* os = nullptr);
+
+    void setOutput(std::ostream* os) { m_os = os; }
+
+    // Time the enclosing scope as (one instance of) a phase of the current cascade:
+    ScopeTimeLogger time(const char* phase) { return ScopeTimeLogger(phase, m_metrics.histogram(phase)); }
+
+    Metrics& getMetrics() { return m_metrics; }
+
+    void beginCascade(int cascade);
+    void endCascade();
+
+    static std::size_t getResidentMemory();
+    static std::size_t getPeakResidentMemory();
+
+protected:
+    std::string m_trainer;
+    std::ostream* m_os = nullptr;
+    std::mutex m_mutex; // output
+
+    Metrics m_metrics;
+    int m_cascade = 0;
+    HighResolutionClock::time_point m_tic;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_TrainingReport_h__
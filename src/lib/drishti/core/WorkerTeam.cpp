@@ -0,0 +1,121 @@
+/*! -*-c++-*-
+  @file   WorkerTeam.cpp
+  @author David Hirvonen
+  @brief  Implementation of a persistent fork/join worker team with a spin/park barrier.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/WorkerTeam.h"
+
+#include <algorithm>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+WorkerTeam::WorkerTeam(int size, int spin)
+    : m_spin(std::max(spin, 0))
+{
+    for (int i = 1; i < size; i++)
+    {
+        m_threads.emplace_back([this, i]() { work(i); });
+    }
+}
+
+WorkerTeam::~WorkerTeam()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+bool WorkerTeam::tryRun(const Task& task, const std::function<void()>& join)
+{
+    std::unique_lock<std::mutex> runLock(m_runMutex, std::try_to_lock);
+    if (!runLock.owns_lock())
+    {
+        return false;
+    }
+
+    if (m_threads.empty())
+    {
+        task(0);
+        if (join)
+        {
+            join();
+        }
+        return true;
+    }
+
+    m_task = &task;
+    m_pending.store(int(m_threads.size()), std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+    m_start.notify_all();
+
+    task(0);
+
+    // Spin briefly for the team, then park:
+    for (int i = 0; (i < m_spin) && m_pending.load(std::memory_order_acquire); i++)
+    {
+    }
+    if (m_pending.load(std::memory_order_acquire))
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_pending.load(std::memory_order_acquire) == 0; });
+    }
+
+    m_task = nullptr;
+    if (join)
+    {
+        join();
+    }
+    return true;
+}
+
+void WorkerTeam::work(int worker)
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        // Spin briefly for the next step, then park:
+        uint64_t generation = m_generation.load(std::memory_order_acquire);
+        for (int i = 0; (i < m_spin) && (generation == seen) && !m_stop; i++)
+        {
+            generation = m_generation.load(std::memory_order_acquire);
+        }
+
+        if (generation == seen)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&]() { return m_stop || (m_generation.load(std::memory_order_acquire) != seen); });
+            generation = m_generation.load(std::memory_order_acquire);
+        }
+
+        if (m_stop)
+        {
+            return;
+        }
+
+        seen = generation;
+        (*m_task)(worker);
+
+        if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done.notify_one();
+        }
+    }
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,71 @@
+/*! -*-c++-*-
+  @file   WorkerTeam.h
+  @author David Hirvonen
+  @brief  Declaration of a persistent fork/join worker team with a spin/park barrier.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_WorkerTeam_h__
+#define __drishti_core_WorkerTeam_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * A fixed team of threads for short, repeated fork/join steps (i.e., one
+ * step per cascade level in a regression) where dispatching to a general
+ * purpose thread pool costs more than the work itself.  The calling thread
+ * participates as worker 0.  Between steps the workers spin briefly before
+ * parking on a condition variable, and the caller does the same while
+ * waiting for the team to finish.
+ */
+
+class WorkerTeam
+{
+public:
+    using Task = std::function<void(int worker)>;
+
+    WorkerTeam(int size = int(std::thread::hardware_concurrency()), int spin = 4096);
+    ~WorkerTeam();
+
+    WorkerTeam(const WorkerTeam&) = delete;
+    WorkerTeam& operator=(const WorkerTeam&) = delete;
+
+    int size() const { return int(m_threads.size()) + 1; }
+
+    // Run task(i) for all i in [0, size()) followed by join() on the calling
+    // thread (before the team is released) and return true. If the team is
+    // already busy (concurrent or nested call) nothing is run: returns false.
+    bool tryRun(const Task& task, const std::function<void()>& join = {});
+
+protected:
+    void work(int worker);
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_runMutex; // one step at a time
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    std::atomic<uint64_t> m_generation{ 0 };
+    std::atomic<int> m_pending{ 0 };
+    std::atomic<bool> m_stop{ false };
+    const Task* m_task = nullptr;
+    int m_spin = 0;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_WorkerTeam_h__
@@ -11,13 +11,25 @@
 #include "drishti/core/arithmetic.h"
 #include "drishti/core/drishti_math.h"
 
+#include <algorithm>
+#include <cstring>
+
 // clang-format off
-#if defined(__arm__) || defined(__arm64__)
+#if defined(__arm__) || defined(__arm64__) || defined(__aarch64__)
 #  include <arm_neon.h>
 #  define DO_ARM_NEON 1
 #endif
 // clang-format on
 
+// Per function target attributes let us build the x86 variants without global -m flags:
+// clang-format off
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#  include <immintrin.h>
+#  define DO_X86_SIMD 1
+#  define DRISHTI_TARGET(X) __attribute__((target(X)))
+#endif
+// clang-format on
+
 DRISHTI_CORE_NAMESPACE_BEGIN
 
 template <>
@@ -31,8 +43,16 @@ double round(double x)
     return ::round(x);
 }
 
-// ################# ADD 32F ######################
-void add32f_c(const float* pa, const float* pb, float* pc, int n)
+// Round half away from zero and saturate (all variants must match this):
+static inline int16_t toFixed(float value)
+{
+    value += (value > 0.f) ? 0.5f : -0.5f;
+    return int16_t(std::min(std::max(value, -32768.f), 32767.f));
+}
+
+// ((((((((((((((((((((( C )))))))))))))))))))))
+
+static void add32f_c(const float* pa, const float* pb, float* pc, int n)
 {
     for (int i = 0; i < n; ++i)
     {
@@ -40,120 +60,137 @@ void add32f_c(const float* pa, const float* pb, float* pc, int n)
     }
 }
 
-#if DO_ARM_NEON
-void add32f_neon(const float* pa, const float* pb, float* pc, int n)
+static void add16sAnd32s_c(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
 {
-    int i = 0;
-    for (; i <= (n - 4); i += 4, pa += 4, pb += 4, pc += 4)
+    for (int i = 0; i < n; i++)
     {
-        vst1q_f32(pc, vaddq_f32(vld1q_f32(pa), vld1q_f32(pb)));
+        pc[i] = pa[i] + pb[i];
     }
-    for (; i < n; i++, pa++, pb++, pc++)
+}
+
+static void add16sAnd16s_c(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
+{
+    for (int i = 0; i < n; i++)
     {
-        pc[0] = pa[0] + pb[0];
+        pc[i] = pa[i] + pb[i];
     }
 }
-#endif
 
-void add32f(const float* pa, const float* pb, float* pc, int n)
+static void convertFixedPoint_c(const float* pa, int16_t* pb, int n, int fraction)
 {
-#if DO_ARM_NEON
-    add32f_neon(pa, pb, pc, n);
-#else
-    add32f_c(pa, pb, pc, n);
-#endif
+    const float scale = float(1 << fraction);
+    for (int i = 0; i < n; i++)
+    {
+        pb[i] = toFixed(pa[i] * scale);
+    }
 }
 
-// ################# ADD 16S AND 32S ######################
-
-void add16sAnd32s_c(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
+static void addScaled32f_c(const float* pa, float scale, float* pc, int n)
 {
     for (int i = 0; i < n; i++)
     {
-        pc[i] = pa[i] + pb[i];
+        pc[i] += pa[i] * scale;
     }
 }
 
-#if DO_ARM_NEON
-void add16sAnd32s_neon(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
+static void addScaled16sTo32f_c(const int16_t* pa, float scale, float* pc, int n)
 {
-    int i = 0;
-    for (; i <= (n - 4); i += 4, pa += 4, pb += 4, pc += 4)
+    for (int i = 0; i < n; i++)
     {
-        vst1q_s32(pc, vaddq_s32(vld1q_s32(pa), vmovl_s16(vld1_s16(pb))));
+        pc[i] += float(pa[i]) * scale;
     }
-    for (; i < n; i++, pa++, pb++, pc++)
+}
+
+static void addScaled8sTo32f_c(const int8_t* pa, float scale, float* pc, int n)
+{
+    for (int i = 0; i < n; i++)
     {
-        pc[0] = pa[0] + pb[0];
+        pc[i] += float(pa[i]) * scale;
     }
 }
-#endif
 
-void add16sAnd32s(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
+static void convert32sTo32f_c(const int32_t* pa, float* pb, int n, float scale)
 {
-#if DO_ARM_NEON
-    add16sAnd32s_neon(pa, pb, pc, n);
-#else
-    add16sAnd32s_c(pa, pb, pc, n);
-#endif
+    for (int i = 0; i < n; i++)
+    {
+        pb[i] = float(pa[i]) * scale;
+    }
 }
 
-// ################# ADD 32S AND 32S ######################
-
-void add16sAnd16s_c(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
+static float dot32f_c(const float* pa, const float* pb, int n)
 {
+    float sum = 0.f;
     for (int i = 0; i < n; i++)
     {
-        pc[i] = pa[i] + pb[i];
+        sum += pa[i] * pb[i];
     }
+    return sum;
 }
 
+static const ArithmeticKernels sKernelsC = {
+    "c",
+    add16sAnd16s_c,
+    add16sAnd32s_c,
+    add32f_c,
+    convertFixedPoint_c,
+    addScaled32f_c,
+    addScaled16sTo32f_c,
+    addScaled8sTo32f_c,
+    convert32sTo32f_c,
+    dot32f_c
+};
+
+// ((((((((((((((((((((( NEON )))))))))))))))))))))
+
 #if DO_ARM_NEON
-void add16sAnd16s_neon(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
+static void add32f_neon(const float* pa, const float* pb, float* pc, int n)
 {
     int i = 0;
-    for (; i <= (n - 8); i += 8, pa += 8, pb += 8, pc += 8)
-    {
-        vst1q_s16(pc, vaddq_s16(vld1q_s16(pa), vld1q_s16(pb)));
-    }
     for (; i <= (n - 4); i += 4, pa += 4, pb += 4, pc += 4)
     {
-        vst1_s16(pc, vadd_s16(vld1_s16(pa), vld1_s16(pb)));
+        vst1q_f32(pc, vaddq_f32(vld1q_f32(pa), vld1q_f32(pb)));
     }
-    for (; i < n; i++, pa++, pb++, pc++)
+    add32f_c(pa, pb, pc, n - i);
+}
+
+static void add16sAnd32s_neon(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pb += 4, pc += 4)
     {
-        pc[0] = pa[0] + pb[0];
+        vst1q_s32(pc, vaddq_s32(vld1q_s32(pa), vmovl_s16(vld1_s16(pb))));
     }
+    add16sAnd32s_c(pa, pb, pc, n - i);
 }
-#endif
 
-void add16sAnd16s(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
+static void add16sAnd16s_neon(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
 {
-#if DO_ARM_NEON
-    add16sAnd16s_neon(pa, pb, pc, n);
-#else
-    add16sAnd16s_c(pa, pb, pc, n);
-#endif
+    int i = 0;
+    for (; i <= (n - 8); i += 8, pa += 8, pb += 8, pc += 8)
+    {
+        vst1q_s16(pc, vaddq_s16(vld1q_s16(pa), vld1q_s16(pb)));
+    }
+    for (; i <= (n - 4); i += 4, pa += 4, pb += 4, pc += 4)
+    {
+        vst1_s16(pc, vadd_s16(vld1_s16(pa), vld1_s16(pb)));
+    }
+    add16sAnd16s_c(pa, pb, pc, n - i);
 }
 
 // See: http://stackoverflow.com/questions/17998257/arm-neon-assembly-and-floating-point-rounding
 // float32x4_t tmp1_ = { -0.75, -0.25, 0.25, 0.75 };
 // int16x4_t tmp1 = vqmovn_s32( vcvtq_s32_f32(vaddq_f32(tmp1_, vbslq_f32(vcgtq_f32(tmp1_, zero), phalf, nhalf ))));
 
-#if DO_ARM_NEON
 static const float32x4_t v32x4f_zero = { 0.f, 0.f, 0.f, 0.f };
 static const float32x4_t v32x4f_pos_half = { +0.5f, +0.5f, +0.5f, +0.5f };
 static const float32x4_t v32x4f_neg_half = { -0.5f, -0.5f, -0.5f, -0.5f };
-#endif
 
-void convertFixedPoint(const float* pa, int16_t* pb, int n, int fraction)
+static void convertFixedPoint_neon(const float* pa, int16_t* pb, int n, int fraction)
 {
-    float scale = float(1 << fraction);
+    const float scale = float(1 << fraction);
+    const float32x4_t step = vdupq_n_f32(scale);
 
     int i = 0;
-
-#if DO_ARM_NEON
-    float32x4_t step = vdupq_n_f32(scale);
     for (; i <= (n - 8); i += 8, pa += 8, pb += 8)
     {
         float32x4_t lowerf = vmulq_f32(vld1q_f32(&pa[0]), step);
@@ -162,16 +199,607 @@ void convertFixedPoint(const float* pa, int16_t* pb, int n, int fraction)
         int16x4_t upper = vqmovn_s32(vcvtq_s32_f32(vaddq_f32(upperf, vbslq_f32(vcgtq_f32(upperf, v32x4f_zero), v32x4f_pos_half, v32x4f_neg_half))));
         vst1q_s16(pb, vcombine_s16(lower, upper));
     }
+    convertFixedPoint_c(pa, pb, n - i, fraction);
+}
+
+static void addScaled32f_neon(const float* pa, float scale, float* pc, int n)
+{
+    const float32x4_t s = vdupq_n_f32(scale);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pc += 4)
+    {
+        vst1q_f32(pc, vaddq_f32(vld1q_f32(pc), vmulq_f32(vld1q_f32(pa), s)));
+    }
+    addScaled32f_c(pa, scale, pc, n - i);
+}
+
+static void addScaled16sTo32f_neon(const int16_t* pa, float scale, float* pc, int n)
+{
+    const float32x4_t s = vdupq_n_f32(scale);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pc += 4)
+    {
+        const float32x4_t a = vcvtq_f32_s32(vmovl_s16(vld1_s16(pa)));
+        vst1q_f32(pc, vaddq_f32(vld1q_f32(pc), vmulq_f32(a, s)));
+    }
+    addScaled16sTo32f_c(pa, scale, pc, n - i);
+}
+
+static void addScaled8sTo32f_neon(const int8_t* pa, float scale, float* pc, int n)
+{
+    const float32x4_t s = vdupq_n_f32(scale);
+
+    int i = 0;
+    for (; i <= (n - 8); i += 8, pa += 8, pc += 8)
+    {
+        const int16x8_t a = vmovl_s8(vld1_s8(pa));
+        const float32x4_t lower = vcvtq_f32_s32(vmovl_s16(vget_low_s16(a)));
+        const float32x4_t upper = vcvtq_f32_s32(vmovl_s16(vget_high_s16(a)));
+        vst1q_f32(pc + 0, vaddq_f32(vld1q_f32(pc + 0), vmulq_f32(lower, s)));
+        vst1q_f32(pc + 4, vaddq_f32(vld1q_f32(pc + 4), vmulq_f32(upper, s)));
+    }
+    addScaled8sTo32f_c(pa, scale, pc, n - i);
+}
+
+static void convert32sTo32f_neon(const int32_t* pa, float* pb, int n, float scale)
+{
+    const float32x4_t s = vdupq_n_f32(scale);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pb += 4)
+    {
+        vst1q_f32(pb, vmulq_f32(vcvtq_f32_s32(vld1q_s32(pa)), s));
+    }
+    convert32sTo32f_c(pa, pb, n - i, scale);
+}
+
+static float dot32f_neon(const float* pa, const float* pb, int n)
+{
+    float32x4_t sum = vdupq_n_f32(0.f);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pb += 4)
+    {
+        sum = vaddq_f32(sum, vmulq_f32(vld1q_f32(pa), vld1q_f32(pb)));
+    }
+
+    float lanes[4];
+    vst1q_f32(lanes, sum);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + dot32f_c(pa, pb, n - i);
+}
+
+static const ArithmeticKernels sKernelsNEON = {
+    "neon",
+    add16sAnd16s_neon,
+    add16sAnd32s_neon,
+    add32f_neon,
+    convertFixedPoint_neon,
+    addScaled32f_neon,
+    addScaled16sTo32f_neon,
+    addScaled8sTo32f_neon,
+    convert32sTo32f_neon,
+    dot32f_neon
+};
+#endif // DO_ARM_NEON
+
+// ((((((((((((((((((((( SSE4.1 )))))))))))))))))))))
+
+#if DO_X86_SIMD
+DRISHTI_TARGET("sse4.1")
+static void add32f_sse41(const float* pa, const float* pb, float* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pb += 4, pc += 4)
+    {
+        _mm_storeu_ps(pc, _mm_add_ps(_mm_loadu_ps(pa), _mm_loadu_ps(pb)));
+    }
+    add32f_c(pa, pb, pc, n - i);
+}
+
+DRISHTI_TARGET("sse4.1")
+static void add16sAnd32s_sse41(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pb += 4, pc += 4)
+    {
+        const __m128i b = _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pb)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pc), _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa)), b));
+    }
+    add16sAnd32s_c(pa, pb, pc, n - i);
+}
+
+DRISHTI_TARGET("sse4.1")
+static void add16sAnd16s_sse41(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 8); i += 8, pa += 8, pb += 8, pc += 8)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pa));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pc), _mm_add_epi16(a, b));
+    }
+    add16sAnd16s_c(pa, pb, pc, n - i);
+}
+
+// Round half away from zero, clamp (so truncation can't overflow) and truncate, as toFixed():
+DRISHTI_TARGET("sse4.1")
+static inline __m128i toFixed_sse41(__m128 value)
+{
+    const __m128 half = _mm_blendv_ps(_mm_set1_ps(-0.5f), _mm_set1_ps(0.5f), _mm_cmpgt_ps(value, _mm_setzero_ps()));
+    value = _mm_add_ps(value, half);
+    value = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-32768.f)), _mm_set1_ps(32767.f));
+    return _mm_cvttps_epi32(value);
+}
+
+DRISHTI_TARGET("sse4.1")
+static void convertFixedPoint_sse41(const float* pa, int16_t* pb, int n, int fraction)
+{
+    const float scale = float(1 << fraction);
+    const __m128 s = _mm_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 8); i += 8, pa += 8, pb += 8)
+    {
+        const __m128i lower = toFixed_sse41(_mm_mul_ps(_mm_loadu_ps(pa + 0), s));
+        const __m128i upper = toFixed_sse41(_mm_mul_ps(_mm_loadu_ps(pa + 4), s));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pb), _mm_packs_epi32(lower, upper));
+    }
+    convertFixedPoint_c(pa, pb, n - i, fraction);
+}
+
+DRISHTI_TARGET("sse4.1")
+static void addScaled32f_sse41(const float* pa, float scale, float* pc, int n)
+{
+    const __m128 s = _mm_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pc += 4)
+    {
+        _mm_storeu_ps(pc, _mm_add_ps(_mm_loadu_ps(pc), _mm_mul_ps(_mm_loadu_ps(pa), s)));
+    }
+    addScaled32f_c(pa, scale, pc, n - i);
+}
+
+DRISHTI_TARGET("sse4.1")
+static void addScaled16sTo32f_sse41(const int16_t* pa, float scale, float* pc, int n)
+{
+    const __m128 s = _mm_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pc += 4)
+    {
+        const __m128 a = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pa))));
+        _mm_storeu_ps(pc, _mm_add_ps(_mm_loadu_ps(pc), _mm_mul_ps(a, s)));
+    }
+    addScaled16sTo32f_c(pa, scale, pc, n - i);
+}
+
+DRISHTI_TARGET("sse4.1")
+static void addScaled8sTo32f_sse41(const int8_t* pa, float scale, float* pc, int n)
+{
+    const __m128 s = _mm_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pc += 4)
+    {
+        int32_t packed;
+        std::memcpy(&packed, pa, sizeof(packed));
+        const __m128 a = _mm_cvtepi32_ps(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(packed)));
+        _mm_storeu_ps(pc, _mm_add_ps(_mm_loadu_ps(pc), _mm_mul_ps(a, s)));
+    }
+    addScaled8sTo32f_c(pa, scale, pc, n - i);
+}
+
+DRISHTI_TARGET("sse4.1")
+static void convert32sTo32f_sse41(const int32_t* pa, float* pb, int n, float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pb += 4)
+    {
+        const __m128 a = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa)));
+        _mm_storeu_ps(pb, _mm_mul_ps(a, s));
+    }
+    convert32sTo32f_c(pa, pb, n - i, scale);
+}
+
+DRISHTI_TARGET("sse4.1")
+static float dot32f_sse41(const float* pa, const float* pb, int n)
+{
+    __m128 sum = _mm_setzero_ps();
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4, pa += 4, pb += 4)
+    {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pa), _mm_loadu_ps(pb)));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + dot32f_c(pa, pb, n - i);
+}
+
+static const ArithmeticKernels sKernelsSSE41 = {
+    "sse4.1",
+    add16sAnd16s_sse41,
+    add16sAnd32s_sse41,
+    add32f_sse41,
+    convertFixedPoint_sse41,
+    addScaled32f_sse41,
+    addScaled16sTo32f_sse41,
+    addScaled8sTo32f_sse41,
+    convert32sTo32f_sse41,
+    dot32f_sse41
+};
+
+// ((((((((((((((((((((( AVX2 )))))))))))))))))))))
+
+DRISHTI_TARGET("avx2")
+static void add32f_avx2(const float* pa, const float* pb, float* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 8); i += 8, pa += 8, pb += 8, pc += 8)
+    {
+        _mm256_storeu_ps(pc, _mm256_add_ps(_mm256_loadu_ps(pa), _mm256_loadu_ps(pb)));
+    }
+    add32f_sse41(pa, pb, pc, n - i);
+}
+
+DRISHTI_TARGET("avx2")
+static void add16sAnd32s_avx2(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 8); i += 8, pa += 8, pb += 8, pc += 8)
+    {
+        const __m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pb)));
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pa));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pc), _mm256_add_epi32(a, b));
+    }
+    add16sAnd32s_sse41(pa, pb, pc, n - i);
+}
+
+DRISHTI_TARGET("avx2")
+static void add16sAnd16s_avx2(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 16); i += 16, pa += 16, pb += 16, pc += 16)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pa));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pb));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pc), _mm256_add_epi16(a, b));
+    }
+    add16sAnd16s_sse41(pa, pb, pc, n - i);
+}
+
+DRISHTI_TARGET("avx2")
+static inline __m256i toFixed_avx2(__m256 value)
+{
+    const __m256 positive = _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GT_OQ);
+    const __m256 half = _mm256_blendv_ps(_mm256_set1_ps(-0.5f), _mm256_set1_ps(0.5f), positive);
+    value = _mm256_add_ps(value, half);
+    value = _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(-32768.f)), _mm256_set1_ps(32767.f));
+    return _mm256_cvttps_epi32(value);
+}
+
+DRISHTI_TARGET("avx2")
+static void convertFixedPoint_avx2(const float* pa, int16_t* pb, int n, int fraction)
+{
+    const float scale = float(1 << fraction);
+    const __m256 s = _mm256_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 16); i += 16, pa += 16, pb += 16)
+    {
+        const __m256i lower = toFixed_avx2(_mm256_mul_ps(_mm256_loadu_ps(pa + 0), s));
+        const __m256i upper = toFixed_avx2(_mm256_mul_ps(_mm256_loadu_ps(pa + 8), s));
+
+        // The pack is per 128 bit lane: (l0 u0 l1 u1) -> (l0 l1 u0 u1)
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lower, upper), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pb), packed);
+    }
+    convertFixedPoint_sse41(pa, pb, n - i, fraction);
+}
+
+DRISHTI_TARGET("avx2")
+static void addScaled32f_avx2(const float* pa, float scale, float* pc, int n)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 8); i += 8, pa += 8, pc += 8)
+    {
+        _mm256_storeu_ps(pc, _mm256_add_ps(_mm256_loadu_ps(pc), _mm256_mul_ps(_mm256_loadu_ps(pa), s)));
+    }
+    addScaled32f_sse41(pa, scale, pc, n - i);
+}
+
+DRISHTI_TARGET("avx2")
+static void addScaled16sTo32f_avx2(const int16_t* pa, float scale, float* pc, int n)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 8); i += 8, pa += 8, pc += 8)
+    {
+        const __m256 a = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa))));
+        _mm256_storeu_ps(pc, _mm256_add_ps(_mm256_loadu_ps(pc), _mm256_mul_ps(a, s)));
+    }
+    addScaled16sTo32f_sse41(pa, scale, pc, n - i);
+}
+
+DRISHTI_TARGET("avx2")
+static void addScaled8sTo32f_avx2(const int8_t* pa, float scale, float* pc, int n)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 8); i += 8, pa += 8, pc += 8)
+    {
+        const __m256 a = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pa))));
+        _mm256_storeu_ps(pc, _mm256_add_ps(_mm256_loadu_ps(pc), _mm256_mul_ps(a, s)));
+    }
+    addScaled8sTo32f_sse41(pa, scale, pc, n - i);
+}
+
+DRISHTI_TARGET("avx2")
+static void convert32sTo32f_avx2(const int32_t* pa, float* pb, int n, float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 8); i += 8, pa += 8, pb += 8)
+    {
+        const __m256 a = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pa)));
+        _mm256_storeu_ps(pb, _mm256_mul_ps(a, s));
+    }
+    convert32sTo32f_sse41(pa, pb, n - i, scale);
+}
+
+DRISHTI_TARGET("avx2")
+static float dot32f_avx2(const float* pa, const float* pb, int n)
+{
+    __m256 sum = _mm256_setzero_ps();
+
+    int i = 0;
+    for (; i <= (n - 8); i += 8, pa += 8, pb += 8)
+    {
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(pa), _mm256_loadu_ps(pb)));
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, sum);
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])) + dot32f_c(pa, pb, n - i);
+}
+
+static const ArithmeticKernels sKernelsAVX2 = {
+    "avx2",
+    add16sAnd16s_avx2,
+    add16sAnd32s_avx2,
+    add32f_avx2,
+    convertFixedPoint_avx2,
+    addScaled32f_avx2,
+    addScaled16sTo32f_avx2,
+    addScaled8sTo32f_avx2,
+    convert32sTo32f_avx2,
+    dot32f_avx2
+};
+
+// ((((((((((((((((((((( AVX-512 )))))))))))))))))))))
+
+// AVX-512F only: 16 bit adds (AVX-512BW) stay on the AVX2 kernel.
+
+DRISHTI_TARGET("avx512f")
+static void add32f_avx512(const float* pa, const float* pb, float* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 16); i += 16, pa += 16, pb += 16, pc += 16)
+    {
+        _mm512_storeu_ps(pc, _mm512_add_ps(_mm512_loadu_ps(pa), _mm512_loadu_ps(pb)));
+    }
+    add32f_avx2(pa, pb, pc, n - i);
+}
+
+DRISHTI_TARGET("avx512f")
+static void add16sAnd32s_avx512(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 16); i += 16, pa += 16, pb += 16, pc += 16)
+    {
+        const __m512i b = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pb)));
+        _mm512_storeu_si512(pc, _mm512_add_epi32(_mm512_loadu_si512(pa), b));
+    }
+    add16sAnd32s_avx2(pa, pb, pc, n - i);
+}
+
+DRISHTI_TARGET("avx512f")
+static void convertFixedPoint_avx512(const float* pa, int16_t* pb, int n, int fraction)
+{
+    const float scale = float(1 << fraction);
+    const __m512 s = _mm512_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 16); i += 16, pa += 16, pb += 16)
+    {
+        __m512 value = _mm512_mul_ps(_mm512_loadu_ps(pa), s);
+        const __mmask16 positive = _mm512_cmp_ps_mask(value, _mm512_setzero_ps(), _CMP_GT_OQ);
+        value = _mm512_add_ps(value, _mm512_mask_blend_ps(positive, _mm512_set1_ps(-0.5f), _mm512_set1_ps(0.5f)));
+        value = _mm512_min_ps(_mm512_max_ps(value, _mm512_set1_ps(-32768.f)), _mm512_set1_ps(32767.f));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pb), _mm512_cvtsepi32_epi16(_mm512_cvttps_epi32(value)));
+    }
+    convertFixedPoint_avx2(pa, pb, n - i, fraction);
+}
+
+DRISHTI_TARGET("avx512f")
+static void addScaled32f_avx512(const float* pa, float scale, float* pc, int n)
+{
+    const __m512 s = _mm512_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 16); i += 16, pa += 16, pc += 16)
+    {
+        _mm512_storeu_ps(pc, _mm512_add_ps(_mm512_loadu_ps(pc), _mm512_mul_ps(_mm512_loadu_ps(pa), s)));
+    }
+    addScaled32f_avx2(pa, scale, pc, n - i);
+}
+
+DRISHTI_TARGET("avx512f")
+static void addScaled16sTo32f_avx512(const int16_t* pa, float scale, float* pc, int n)
+{
+    const __m512 s = _mm512_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 16); i += 16, pa += 16, pc += 16)
+    {
+        const __m512 a = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pa))));
+        _mm512_storeu_ps(pc, _mm512_add_ps(_mm512_loadu_ps(pc), _mm512_mul_ps(a, s)));
+    }
+    addScaled16sTo32f_avx2(pa, scale, pc, n - i);
+}
+
+DRISHTI_TARGET("avx512f")
+static void addScaled8sTo32f_avx512(const int8_t* pa, float scale, float* pc, int n)
+{
+    const __m512 s = _mm512_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 16); i += 16, pa += 16, pc += 16)
+    {
+        const __m512 a = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa))));
+        _mm512_storeu_ps(pc, _mm512_add_ps(_mm512_loadu_ps(pc), _mm512_mul_ps(a, s)));
+    }
+    addScaled8sTo32f_avx2(pa, scale, pc, n - i);
+}
+
+DRISHTI_TARGET("avx512f")
+static void convert32sTo32f_avx512(const int32_t* pa, float* pb, int n, float scale)
+{
+    const __m512 s = _mm512_set1_ps(scale);
+
+    int i = 0;
+    for (; i <= (n - 16); i += 16, pa += 16, pb += 16)
+    {
+        _mm512_storeu_ps(pb, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_loadu_si512(pa)), s));
+    }
+    convert32sTo32f_avx2(pa, pb, n - i, scale);
+}
+
+DRISHTI_TARGET("avx512f")
+static float dot32f_avx512(const float* pa, const float* pb, int n)
+{
+    __m512 sum = _mm512_setzero_ps();
+
+    int i = 0;
+    for (; i <= (n - 16); i += 16, pa += 16, pb += 16)
+    {
+        sum = _mm512_add_ps(sum, _mm512_mul_ps(_mm512_loadu_ps(pa), _mm512_loadu_ps(pb)));
+    }
+
+    float lanes[16];
+    _mm512_storeu_ps(lanes, sum);
+
+    float total = 0.f;
+    for (int j = 0; j < 16; j++)
+    {
+        total += lanes[j];
+    }
+    return total + dot32f_c(pa, pb, n - i);
+}
+
+static const ArithmeticKernels sKernelsAVX512 = {
+    "avx512f",
+    add16sAnd16s_avx2,
+    add16sAnd32s_avx512,
+    add32f_avx512,
+    convertFixedPoint_avx512,
+    addScaled32f_avx512,
+    addScaled16sTo32f_avx512,
+    addScaled8sTo32f_avx512,
+    convert32sTo32f_avx512,
+    dot32f_avx512
+};
+#endif // DO_X86_SIMD
+
+// ((((((((((((((((((((( Dispatch )))))))))))))))))))))
+
+std::vector<const ArithmeticKernels*> getArithmeticKernelVariants()
+{
+    std::vector<const ArithmeticKernels*> variants{ &sKernelsC };
+
+#if DO_ARM_NEON
+    variants.push_back(&sKernelsNEON);
 #endif
-    // process % 8 pixels from SIMD branch or all pixels in case of C implementation
-    for (; i < n; i++, pa++, pb++)
+
+#if DO_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        variants.push_back(&sKernelsSSE41);
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        variants.push_back(&sKernelsAVX2);
+    }
+    if (__builtin_cpu_supports("avx512f"))
     {
-        pb[0] = int16_t(pa[0] * scale);
+        variants.push_back(&sKernelsAVX512);
     }
+#endif
+
+    return variants;
+}
+
+const ArithmeticKernels& getArithmeticKernels()
+{
+    static const ArithmeticKernels* kernels = getArithmeticKernelVariants().back(); // best
+    return *kernels;
+}
+
+void add32f(const float* pa, const float* pb, float* pc, int n)
+{
+    getArithmeticKernels().add32f(pa, pb, pc, n);
+}
+
+void add16sAnd32s(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
+{
+    getArithmeticKernels().add16sAnd32s(pa, pb, pc, n);
+}
+
+void add16sAnd16s(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
+{
+    getArithmeticKernels().add16sAnd16s(pa, pb, pc, n);
+}
+
+void convertFixedPoint(const float* pa, int16_t* pb, int n, int fraction)
+{
+    getArithmeticKernels().convertFixedPoint(pa, pb, n, fraction);
+}
+
+void addScaled32f(const float* pa, float scale, float* pc, int n)
+{
+    getArithmeticKernels().addScaled32f(pa, scale, pc, n);
+}
+
+void addScaled16sTo32f(const int16_t* pa, float scale, float* pc, int n)
+{
+    getArithmeticKernels().addScaled16sTo32f(pa, scale, pc, n);
+}
+
+void addScaled8sTo32f(const int8_t* pa, float scale, float* pc, int n)
+{
+    getArithmeticKernels().addScaled8sTo32f(pa, scale, pc, n);
+}
+
+void convert32sTo32f(const int32_t* pa, float* pb, int n, float scale)
+{
+    getArithmeticKernels().convert32sTo32f(pa, pb, n, scale);
 }
 
-void add16sAnd32s()
+float dot32f(const float* pa, const float* pb, int n)
 {
+    return getArithmeticKernels().dot32f(pa, pb, n);
 }
 
 DRISHTI_CORE_NAMESPACE_END
@@ -14,17 +14,54 @@
 #include "drishti/core/drishti_core.h"
 
 #include <cstdint>
+#include <vector>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
 template <typename T>
 T round(T x);
 
+// Kernels are dispatched to the best variant for the CPU (see getArithmeticKernels()).  Integer
+// results are exact across variants, float results may differ from the C reference in the last
+// bits (summation order, fused multiply-add).
+
 void add16sAnd16s(const int16_t* pa, const int16_t* pb, int16_t* pc, int n);
 void add16sAnd32s(const int32_t* pa, const int16_t* pb, int32_t* pc, int n);
 void add32f(const float* pa, const float* pb, float* pc, int n);
+
+// pb[i] = pa[i] * 2^fraction, rounded half away from zero and saturated to int16_t:
 void convertFixedPoint(const float* pa, int16_t* pb, int n, int fraction);
 
+// pc[i] += pa[i] * scale (i.e., quantized leaves):
+void addScaled32f(const float* pa, float scale, float* pc, int n);
+void addScaled16sTo32f(const int16_t* pa, float scale, float* pc, int n);
+void addScaled8sTo32f(const int8_t* pa, float scale, float* pc, int n);
+
+// pb[i] = float(pa[i]) * scale (i.e., fixed point accumulators):
+void convert32sTo32f(const int32_t* pa, float* pb, int n, float scale);
+
+float dot32f(const float* pa, const float* pb, int n);
+
+struct ArithmeticKernels
+{
+    const char* name;
+    void (*add16sAnd16s)(const int16_t* pa, const int16_t* pb, int16_t* pc, int n);
+    void (*add16sAnd32s)(const int32_t* pa, const int16_t* pb, int32_t* pc, int n);
+    void (*add32f)(const float* pa, const float* pb, float* pc, int n);
+    void (*convertFixedPoint)(const float* pa, int16_t* pb, int n, int fraction);
+    void (*addScaled32f)(const float* pa, float scale, float* pc, int n);
+    void (*addScaled16sTo32f)(const int16_t* pa, float scale, float* pc, int n);
+    void (*addScaled8sTo32f)(const int8_t* pa, float scale, float* pc, int n);
+    void (*convert32sTo32f)(const int32_t* pa, float* pb, int n, float scale);
+    float (*dot32f)(const float* pa, const float* pb, int n);
+};
+
+// Variant selected once by CPU features: SSE4.1, AVX2 or AVX-512 (x86, runtime) and NEON (ARM):
+const ArithmeticKernels& getArithmeticKernels();
+
+// All variants the CPU supports, the C reference first (for testing and benchmarking):
+std::vector<const ArithmeticKernels*> getArithmeticKernelVariants();
+
 DRISHTI_CORE_NAMESPACE_END
 
 #endif
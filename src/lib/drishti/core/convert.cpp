@@ -10,6 +10,8 @@
 
 #include "drishti/core/convert.h"
 
+#include <algorithm>
+
 // clang-format off
 #if defined (__arm__) || defined(__arm64__)
 #  include <arm_neon.h>
@@ -100,6 +102,53 @@ void convertU8ToF32(const cv::Mat4b& input, std::vector<PlaneInfo>& planes)
     }
 }
 
+void convertU8ToF32(const cv::Mat3b& input, std::vector<PlaneInfo>& planes)
+{
+    CV_Assert(!input.empty());
+    CV_Assert(planes.size() > 0);
+
+    const int stepA = 16;
+    std::vector<float*> ptrs(planes.size());
+    std::vector<float32x4_t> alphas(planes.size());
+    for (int i = 0; i < planes.size(); i++)
+    {
+        alphas[i] = vdupq_n_f32(planes[i].alpha);
+    }
+
+    for (int x = 0, y = 0; y < input.rows; y++)
+    {
+        const cv::Vec3b* ptrA = input.ptr<cv::Vec3b>(y);
+        for (int i = 0; i < planes.size(); i++)
+        {
+            ptrs[i] = planes[i].plane.ptr<float>(y);
+        }
+
+        for (x = 0; x <= input.cols - stepA; x += stepA, ptrA += stepA)
+        {
+            uint8x16x3_t a = vld3q_u8(reinterpret_cast<const uint8_t*>(ptrA));
+            for (int i = 0; i < planes.size(); ptrs[i] += stepA, i++)
+            {
+                const uint8x16_t& c = a.val[planes[i].channel];
+                const uint16x8_t b1 = vmovl_u8(vget_low_u8(c));
+                const uint16x8_t b2 = vmovl_u8(vget_high_u8(c));
+                vst1q_f32(ptrs[i] + 0, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(b1))), alphas[i]));
+                vst1q_f32(ptrs[i] + 4, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(b1))), alphas[i]));
+                vst1q_f32(ptrs[i] + 8, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(b2))), alphas[i]));
+                vst1q_f32(ptrs[i] + 12, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(b2))), alphas[i]));
+            }
+        }
+
+        for (; x < input.cols; x++, ptrA++)
+        {
+            const cv::Vec3b& pix = ptrA[0];
+            for (int i = 0; i < planes.size(); ptrs[i]++, i++)
+            {
+                ptrs[i][0] = static_cast<float>(pix[planes[i].channel]) * planes[i].alpha;
+            }
+        }
+    }
+}
+
 void unpack(const cv::Mat4b& input, std::vector<PlaneInfo>& planes)
 {
     std::vector<uint8_t*> ptrs(planes.size());
@@ -148,6 +197,16 @@ void convertU8ToF32(const cv::Mat4b& input, std::vector<PlaneInfo>& planes)
     }
 }
 
+void convertU8ToF32(const cv::Mat3b& input, std::vector<PlaneInfo>& planes)
+{
+    std::vector<cv::Mat> channels;
+    cv::split(input, channels);
+    for (auto& p : planes)
+    {
+        channels[p.channel].convertTo(p.plane, CV_32F, p.alpha);
+    }
+}
+
 void unpack(const cv::Mat4b& input, std::vector<PlaneInfo>& planes)
 {
     std::vector<cv::Mat> channels;
@@ -160,4 +219,289 @@ void unpack(const cv::Mat4b& input, std::vector<PlaneInfo>& planes)
 
 #endif
 
+// ((((((((((((((( YUV 4:2:0 )))))))))))))))
+
+YUV420 YUV420::nv12(const cv::Mat1b& y, const cv::Mat2b& uv, bool fullRange)
+{
+    YUV420 frame;
+    frame.format = kNV12;
+    frame.fullRange = fullRange;
+    frame.y = y;
+    frame.uv = uv;
+    return frame;
+}
+
+YUV420 YUV420::nv21(const cv::Mat1b& y, const cv::Mat2b& vu, bool fullRange)
+{
+    YUV420 frame = nv12(y, vu, fullRange);
+    frame.format = kNV21;
+    return frame;
+}
+
+YUV420 YUV420::i420(const cv::Mat1b& y, const cv::Mat1b& u, const cv::Mat1b& v, bool fullRange)
+{
+    YUV420 frame;
+    frame.format = kI420;
+    frame.fullRange = fullRange;
+    frame.y = y;
+    frame.u = u;
+    frame.v = v;
+    return frame;
+}
+
+// BT.601 in 8 bit fixed point, out = (y * (Y - offset) + u * (U - 128) + v * (V - 128) + 128) >> 8
+struct YUVCoefficients
+{
+    YUVCoefficients(bool fullRange)
+        : offset(fullRange ? 0 : 16)
+        , y(fullRange ? 256 : 298)
+        , rv(fullRange ? 359 : 409)
+        , gu(fullRange ? -88 : -100)
+        , gv(fullRange ? -183 : -208)
+        , bu(fullRange ? 454 : 516)
+    {
+    }
+    int16_t offset, y, rv, gu, gv, bu;
+};
+
+static inline uint8_t yuvToChannel(int c, int d, int e, int cy, int cd, int ce)
+{
+    return uint8_t(std::min(std::max((cy * c + cd * d + ce * e + 128) >> 8, 0), 255));
+}
+
+// Row pointers of a 4:2:0 frame, chroma samples are step bytes apart (2 for NV12/NV21):
+struct YUVRow
+{
+    const uint8_t* y;
+    const uint8_t* u;
+    const uint8_t* v;
+    int step;
+};
+
+static YUVRow getRow(const YUV420& input, int row)
+{
+    YUVRow result;
+    result.y = input.y.ptr<uint8_t>(row);
+    switch (input.format)
+    {
+        case YUV420::kNV12:
+            result.u = input.uv.ptr<uint8_t>(row / 2);
+            result.v = result.u + 1;
+            result.step = 2;
+            break;
+        case YUV420::kNV21:
+            result.v = input.uv.ptr<uint8_t>(row / 2);
+            result.u = result.v + 1;
+            result.step = 2;
+            break;
+        case YUV420::kI420:
+            result.u = input.u.ptr<uint8_t>(row / 2);
+            result.v = input.v.ptr<uint8_t>(row / 2);
+            result.step = 1;
+            break;
+    }
+    return result;
+}
+
+static void yuvToRows_c(const YUVRow& row, const YUVCoefficients& k, int begin, int end, uint8_t* out[4])
+{
+    for (int x = begin; x < end; x++)
+    {
+        const int c = int(row.y[x]) - k.offset;
+        const int d = int(row.u[(x / 2) * row.step]) - 128;
+        const int e = int(row.v[(x / 2) * row.step]) - 128;
+        if (out[YUV420::kRed])
+        {
+            out[YUV420::kRed][x] = yuvToChannel(c, d, e, k.y, 0, k.rv);
+        }
+        if (out[YUV420::kGreen])
+        {
+            out[YUV420::kGreen][x] = yuvToChannel(c, d, e, k.y, k.gu, k.gv);
+        }
+        if (out[YUV420::kBlue])
+        {
+            out[YUV420::kBlue][x] = yuvToChannel(c, d, e, k.y, k.bu, 0);
+        }
+        if (out[YUV420::kGray])
+        {
+            out[YUV420::kGray][x] = yuvToChannel(c, 0, 0, k.y, 0, 0);
+        }
+    }
+}
+
+#if USE_SIMD
+
+// Same arithmetic as yuvToChannel() for 8 pixels, the narrowing shifts saturate to [0,255]:
+static inline uint8x8_t yuvToChannel8(int16x8_t c, int16x8_t d, int16x8_t e, int16_t cy, int16_t cd, int16_t ce)
+{
+    int32x4_t lower = vmlal_n_s16(vdupq_n_s32(128), vget_low_s16(c), cy);
+    int32x4_t upper = vmlal_n_s16(vdupq_n_s32(128), vget_high_s16(c), cy);
+    if (cd)
+    {
+        lower = vmlal_n_s16(lower, vget_low_s16(d), cd);
+        upper = vmlal_n_s16(upper, vget_high_s16(d), cd);
+    }
+    if (ce)
+    {
+        lower = vmlal_n_s16(lower, vget_low_s16(e), ce);
+        upper = vmlal_n_s16(upper, vget_high_s16(e), ce);
+    }
+    return vqmovun_s16(vcombine_s16(vqshrn_n_s32(lower, 8), vqshrn_n_s32(upper, 8)));
+}
+
+static inline void yuvToChannel16(int16x8_t c0, int16x8_t c1, int16x8_t d0, int16x8_t d1, int16x8_t e0, int16x8_t e1, int16_t cy, int16_t cd, int16_t ce, uint8_t* out)
+{
+    vst1q_u8(out, vcombine_u8(yuvToChannel8(c0, d0, e0, cy, cd, ce), yuvToChannel8(c1, d1, e1, cy, cd, ce)));
+}
+
+static void yuvToRows(const YUVRow& row, const YUVCoefficients& k, int width, uint8_t* out[4])
+{
+    const int16x8_t offset = vdupq_n_s16(k.offset), bias = vdupq_n_s16(128);
+
+    int x = 0;
+    for (; x <= (width - 16); x += 16)
+    {
+        // 16 luma and 8 chroma samples:
+        const uint8x16_t y = vld1q_u8(row.y + x);
+        uint8x8_t u, v;
+        if (row.step == 2)
+        {
+            const uint8x8x2_t uv = vld2_u8(std::min(row.u, row.v) + x);
+            u = (row.u < row.v) ? uv.val[0] : uv.val[1];
+            v = (row.u < row.v) ? uv.val[1] : uv.val[0];
+        }
+        else
+        {
+            u = vld1_u8(row.u + (x / 2));
+            v = vld1_u8(row.v + (x / 2));
+        }
+
+        const int16x8_t c0 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(y))), offset);
+        const int16x8_t c1 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(y))), offset);
+
+        // Nearest neighbor chroma upsampling: (d0 d0 d1 d1 ...)
+        const int16x8x2_t d = vzipq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)), bias), vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)), bias));
+        const int16x8x2_t e = vzipq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)), bias), vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)), bias));
+
+        if (out[YUV420::kRed])
+        {
+            yuvToChannel16(c0, c1, d.val[0], d.val[1], e.val[0], e.val[1], k.y, 0, k.rv, out[YUV420::kRed] + x);
+        }
+        if (out[YUV420::kGreen])
+        {
+            yuvToChannel16(c0, c1, d.val[0], d.val[1], e.val[0], e.val[1], k.y, k.gu, k.gv, out[YUV420::kGreen] + x);
+        }
+        if (out[YUV420::kBlue])
+        {
+            yuvToChannel16(c0, c1, d.val[0], d.val[1], e.val[0], e.val[1], k.y, k.bu, 0, out[YUV420::kBlue] + x);
+        }
+        if (out[YUV420::kGray])
+        {
+            yuvToChannel16(c0, c1, d.val[0], d.val[1], e.val[0], e.val[1], k.y, 0, 0, out[YUV420::kGray] + x);
+        }
+    }
+
+    yuvToRows_c(row, k, x, width, out);
+}
+
+static void convertRowU8ToF32(const uint8_t* src, float* dst, int n, float alpha)
+{
+    const float32x4_t scale = vdupq_n_f32(alpha);
+
+    int x = 0;
+    for (; x <= (n - 8); x += 8)
+    {
+        const uint16x8_t a = vmovl_u8(vld1_u8(src + x));
+        vst1q_f32(dst + x + 0, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(a))), scale));
+        vst1q_f32(dst + x + 4, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(a))), scale));
+    }
+    for (; x < n; x++)
+    {
+        dst[x] = static_cast<float>(src[x]) * alpha;
+    }
+}
+
+#else
+
+static void yuvToRows(const YUVRow& row, const YUVCoefficients& k, int width, uint8_t* out[4])
+{
+    yuvToRows_c(row, k, 0, width, out);
+}
+
+static void convertRowU8ToF32(const uint8_t* src, float* dst, int n, float alpha)
+{
+    for (int x = 0; x < n; x++)
+    {
+        dst[x] = static_cast<float>(src[x]) * alpha;
+    }
+}
+
+#endif // USE_SIMD
+
+static void checkYUV420(const YUV420& input, const std::vector<PlaneInfo>& planes)
+{
+    const cv::Size chroma((input.y.cols + 1) / 2, (input.y.rows + 1) / 2);
+
+    CV_Assert(!input.y.empty());
+    CV_Assert(planes.size() > 0);
+    CV_Assert((input.format == YUV420::kI420) ? (input.u.size() == chroma && input.v.size() == chroma) : (input.uv.size() == chroma));
+    for (const auto& p : planes)
+    {
+        CV_Assert((p.channel >= YUV420::kRed) && (p.channel <= YUV420::kGray));
+        CV_Assert(p.plane.size() == input.y.size());
+    }
+}
+
+void unpack(const YUV420& input, std::vector<PlaneInfo>& planes)
+{
+    checkYUV420(input, planes);
+
+    // Convert straight to the first plane of each channel, repeated channels are copied:
+    const YUVCoefficients k(input.fullRange);
+    for (int y = 0; y < input.y.rows; y++)
+    {
+        uint8_t* out[4] = { nullptr, nullptr, nullptr, nullptr };
+        for (auto& p : planes)
+        {
+            if (!out[p.channel])
+            {
+                out[p.channel] = p.plane.ptr<uint8_t>(y);
+            }
+        }
+        yuvToRows(getRow(input, y), k, input.y.cols, out);
+
+        for (auto& p : planes)
+        {
+            uint8_t* dst = p.plane.ptr<uint8_t>(y);
+            if (dst != out[p.channel])
+            {
+                std::copy(out[p.channel], out[p.channel] + input.y.cols, dst);
+            }
+        }
+    }
+}
+
+void convertU8ToF32(const YUV420& input, std::vector<PlaneInfo>& planes)
+{
+    checkYUV420(input, planes);
+
+    // One row of each channel, so the frame is only read once in uint8_t:
+    cv::Mat1b rows(4, input.y.cols);
+    const YUVCoefficients k(input.fullRange);
+    for (int y = 0; y < input.y.rows; y++)
+    {
+        uint8_t* out[4] = { nullptr, nullptr, nullptr, nullptr };
+        for (const auto& p : planes)
+        {
+            out[p.channel] = rows.ptr<uint8_t>(p.channel);
+        }
+        yuvToRows(getRow(input, y), k, input.y.cols, out);
+
+        for (auto& p : planes)
+        {
+            convertRowU8ToF32(out[p.channel], p.plane.ptr<float>(y), input.y.cols, p.alpha);
+        }
+    }
+}
+
 DRISHTI_CORE_NAMESPACE_END
@@ -30,9 +30,52 @@ struct PlaneInfo
 };
 
 void convertU8ToF32(const cv::Mat4b& input, std::vector<PlaneInfo>& planes);
+void convertU8ToF32(const cv::Mat3b& input, std::vector<PlaneInfo>& planes);
 
 void unpack(const cv::Mat4b& input, std::vector<PlaneInfo>& planes);
 
+/*
+ * View of a 4:2:0 camera frame (i.e., Android NV21, iOS NV12 or I420), the rows of each
+ * plane can be padded.  Frames are converted with BT.601 coefficients in video range
+ * (Y in [16,235]) or full range (JPEG, Y in [0,255]).
+ */
+
+struct YUV420
+{
+    enum Format
+    {
+        kNV12, // Y + interleaved UV
+        kNV21, // Y + interleaved VU
+        kI420  // Y + U + V
+    };
+
+    // Output channels for PlaneInfo::channel:
+    enum Channel
+    {
+        kRed,
+        kGreen,
+        kBlue,
+        kGray // luminance, expanded to full range
+    };
+
+    static YUV420 nv12(const cv::Mat1b& y, const cv::Mat2b& uv, bool fullRange = false);
+    static YUV420 nv21(const cv::Mat1b& y, const cv::Mat2b& vu, bool fullRange = false);
+    static YUV420 i420(const cv::Mat1b& y, const cv::Mat1b& u, const cv::Mat1b& v, bool fullRange = false);
+
+    Format format = kNV12;
+    bool fullRange = false;
+    cv::Mat1b y;
+    cv::Mat2b uv; // kNV12, kNV21 : (w+1)/2 x (h+1)/2
+    cv::Mat1b u;  // kI420 : (w+1)/2 x (h+1)/2
+    cv::Mat1b v;
+};
+
+// Convert directly to the requested planes (a row at a time, no intermediate RGBA frame), the
+// planes must be allocated with the size of input.y (CV_8UC1 for unpack(), else CV_32FC1):
+void convertU8ToF32(const YUV420& input, std::vector<PlaneInfo>& planes);
+
+void unpack(const YUV420& input, std::vector<PlaneInfo>& planes);
+
 DRISHTI_CORE_NAMESPACE_END
 
 #endif // __drishti_core_convert_h__
@@ -9,6 +9,7 @@
 #define __drishti_core_drishti_cereal_pba_h__
 
 #include "drishti/core/drishti_core.h"
+#include "drishti/core/CompressedStream.h"
 #include "drishti/core/make_unique.h"
 
 // http://uscilab.github.io/cereal/serialization_archives.html
@@ -39,11 +40,21 @@ inline bool is_cpb(std::istream& is)
     return ok;
 }
 
+// Compressed archives (see core/CompressedStream.h) are decoded while they are read:
 template <typename T>
 void load_cpb(std::istream& is, T& object)
 {
-    cereal::PortableBinaryInputArchive ia(is);
-    ia >> object;
+    if (drishti::core::isCompressed(is))
+    {
+        drishti::core::CompressedInputStream cis(is);
+        cereal::PortableBinaryInputArchive ia(cis);
+        ia >> object;
+    }
+    else
+    {
+        cereal::PortableBinaryInputArchive ia(is);
+        ia >> object;
+    }
 }
 
 template <typename T>
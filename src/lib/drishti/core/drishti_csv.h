@@ -16,6 +16,8 @@
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
+// Note: see drishti/core/CsvReader.h for large files (memory mapped, zero copy, parallel).
+
 //#define BOOST_SPIRIT_DEBUG
 //
 // http://stackoverflow.com/questions/18365463/how-to-parse-csv-using-boostspirit
@@ -0,0 +1,166 @@
+/*! -*-c++-*-
+  @file   drishti_cv_json.h
+  @author David Hirvonen
+  @brief  Streaming JSON I/O of common opencv types (same schema as drishti_cv_cereal.h).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_drishti_cv_json_h__
+#define __drishti_core_drishti_cv_json_h__
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/JsonStream.h"
+#include "drishti/core/Field.h"
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+// The drishti_cv_cereal.h serialize() functions are versioned (version 0):
+
+inline void write(JsonWriter& os, const cv::Rect& rect)
+{
+    os.beginObject().version<cv::Rect>(0);
+    os.key("x").value(rect.x);
+    os.key("y").value(rect.y);
+    os.key("width").value(rect.width);
+    os.key("height").value(rect.height);
+    os.endObject();
+}
+
+inline void write(JsonWriter& os, const cv::Size2f& size)
+{
+    os.beginObject().version<cv::Size2f>(0);
+    os.key("width").value(size.width);
+    os.key("height").value(size.height);
+    os.endObject();
+}
+
+inline void write(JsonWriter& os, const cv::Point2f& p)
+{
+    os.beginObject().version<cv::Point2f>(0);
+    os.key("x").value(p.x);
+    os.key("y").value(p.y);
+    os.endObject();
+}
+
+inline void write(JsonWriter& os, const cv::RotatedRect& e)
+{
+    os.beginObject().version<cv::RotatedRect>(0);
+    os.key("center");
+    write(os, e.center);
+    os.key("size");
+    write(os, e.size);
+    os.key("angle").value(e.angle);
+    os.endObject();
+}
+
+template <typename T, typename Allocator>
+void write(JsonWriter& os, const std::vector<T, Allocator>& values)
+{
+    os.beginArray();
+    for (const auto& value : values)
+    {
+        write(os, value);
+    }
+    os.endArray();
+}
+
+// Field<T>::serialize() uses unnamed members:
+template <typename T>
+void write(JsonWriter& os, const Field<T>& field)
+{
+    os.beginObject().version<Field<T>>(0);
+    os.key("value0").value(field.has);
+    os.key("value1");
+    write(os, field.value);
+    os.endObject();
+}
+
+inline bool read(JsonReader& is, cv::Rect& rect)
+{
+    return readObject(is, [&](const JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "x") return read(is, rect.x);
+        if (key == "y") return read(is, rect.y);
+        if (key == "width") return read(is, rect.width);
+        if (key == "height") return read(is, rect.height);
+        // clang-format on
+        return is.skip();
+    });
+}
+
+inline bool read(JsonReader& is, cv::Size2f& size)
+{
+    return readObject(is, [&](const JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "width") return read(is, size.width);
+        if (key == "height") return read(is, size.height);
+        // clang-format on
+        return is.skip();
+    });
+}
+
+inline bool read(JsonReader& is, cv::Point2f& p)
+{
+    return readObject(is, [&](const JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "x") return read(is, p.x);
+        if (key == "y") return read(is, p.y);
+        // clang-format on
+        return is.skip();
+    });
+}
+
+inline bool read(JsonReader& is, cv::RotatedRect& e)
+{
+    return readObject(is, [&](const JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "center") return read(is, e.center);
+        if (key == "size") return read(is, e.size);
+        if (key == "angle") return read(is, e.angle);
+        // clang-format on
+        return is.skip();
+    });
+}
+
+template <typename T, typename Allocator>
+bool read(JsonReader& is, std::vector<T, Allocator>& values)
+{
+    if (is.token() != JsonReader::kBeginArray)
+    {
+        return false;
+    }
+
+    values.clear();
+    while (is.next() != JsonReader::kEndArray)
+    {
+        values.emplace_back();
+        if (!read(is, values.back()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+bool read(JsonReader& is, Field<T>& field)
+{
+    return readObject(is, [&](const JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "value0") return read(is, field.has);
+        if (key == "value1") return read(is, field.value);
+        // clang-format on
+        return is.skip();
+    });
+}
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_drishti_cv_json_h__
@@ -0,0 +1,35 @@
+/*! -*-c++-*-
+  @file   drishti_type_traits.h
+  @author David Hirvonen
+  @brief  Declaration of type traits missing from the Android NDK r10e (gcc 4.9) stdlib
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_drishti_type_traits_h__
+#define __drishti_core_drishti_type_traits_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <type_traits>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+// std::is_trivially_copyable is only available in libstdc++ >= 5:
+#if ANDROID || (defined(__GNUC__) && !defined(__clang__) && (__GNUC__ < 5))
+template <typename T>
+struct is_trivially_copyable : std::integral_constant<bool, __has_trivial_copy(T) && __has_trivial_destructor(T)>
+{
+};
+#else
+template <typename T>
+struct is_trivially_copyable : std::is_trivially_copyable<T>
+{
+};
+#endif
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_drishti_type_traits_h__
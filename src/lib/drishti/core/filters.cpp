@@ -0,0 +1,178 @@
+/*! -*-c++-*-
+  @file   filters.cpp
+  @author David Hirvonen
+  @brief  Implementation of CPU equivalents of the ogles_gpgpu binomial, saturation, Hessian and NMS shaders.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/filters.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+// The inner loops are unit stride over 16-bit sums (at most 16 * 255), so the compiler
+// vectorizes them for the target (NEON, SSE/AVX2) without intrinsics.
+void binomial3x3U8(const uint8_t* src, std::size_t srcStep, uint8_t* dst, std::size_t dstStep, int width, int height, int channels)
+{
+    const int n = width * channels;
+
+    // Original rows y - 1 and y (the destination may alias the source), and the vertical sums
+    // with one replicated pixel on each side:
+    std::vector<uint8_t> above(n), center(n);
+    std::vector<uint16_t> sums((width + 2) * channels);
+    uint16_t* v = sums.data() + channels;
+
+    std::memcpy(center.data(), src, n);
+    std::memcpy(above.data(), src, n);
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t* r0 = above.data();
+        const uint8_t* r1 = center.data();
+        const uint8_t* r2 = src + std::min(y + 1, height - 1) * srcStep;
+        for (int x = 0; x < n; x++)
+        {
+            v[x] = uint16_t(r0[x] + 2 * r1[x] + r2[x]);
+        }
+        for (int c = 0; c < channels; c++)
+        {
+            v[c - channels] = v[c];
+            v[n + c] = v[n - channels + c];
+        }
+
+        std::swap(above, center);
+        if (y + 1 < height)
+        {
+            std::memcpy(center.data(), r2, n); // before row y + 1 can be overwritten
+        }
+
+        uint8_t* out = dst + y * dstStep;
+        for (int x = 0; x < n; x++)
+        {
+            out[x] = uint8_t((v[x - channels] + 2 * v[x] + v[x + channels] + 8) >> 4);
+        }
+    }
+}
+
+void saturationU8C4(const uint8_t* src, std::size_t srcStep, uint8_t* dst, std::size_t dstStep, int width, int height, float gain)
+{
+    // d * 255 = gain * (255 - |255 - rgb| / sqrt(3))
+    const float scale = gain / std::sqrt(3.f);
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t* in = src + y * srcStep;
+        uint8_t* out = dst + y * dstStep;
+        for (int x = 0; x < width; x++)
+        {
+            const float r = 255.f - in[x * 4 + 0], g = 255.f - in[x * 4 + 1], b = 255.f - in[x * 4 + 2];
+            const float d = gain * 255.f - scale * std::sqrt(r * r + g * g + b * b);
+            const uint8_t value = uint8_t(std::min(std::max(d, 0.f), 255.f) + 0.5f);
+            out[x * 4 + 0] = out[x * 4 + 1] = out[x * 4 + 2] = value;
+            out[x * 4 + 3] = 255;
+        }
+    }
+}
+
+// Channel 0 of rows y - 1, y and y + 1 is filtered horizontally once per row ([1 -2 1], [1 2 1]
+// and [-1 0 1], 16-bit), and the vertical pass combines the three rows:
+//
+//   Ixx = dxx(y - 1) + 2 dxx(y) + dxx(y + 1)  : [1 -2 1] x [1 2 1]  (|Ixx| <= 8 * 255)
+//   Iyy = sum(y - 1) - 2 sum(y) + sum(y + 1)   : [1 2 1] x [1 -2 1]  (|Iyy| <= 8 * 255)
+//   Ixy = dx(y + 1) - dx(y - 1)                : [-1 0 1] x [-1 0 1] (|Ixy| <= 2 * 255)
+//
+// det = (Ixx * Iyy - 16 * Ixy^2) / (16 * 255)^2 fits in 23 bits, so the float scale is exact.
+void hessian3x3U8C4(const uint8_t* src, std::size_t srcStep, uint8_t* dst, std::size_t dstStep, int width, int height, float gain)
+{
+    struct Row
+    {
+        std::vector<int16_t> dxx, sum, dx;
+    };
+
+    std::vector<int16_t> padded(width + 2);
+    std::array<Row, 3> rows;
+    for (auto& row : rows)
+    {
+        row.dxx.resize(width);
+        row.sum.resize(width);
+        row.dx.resize(width);
+    }
+
+    const auto filter = [&](int y, Row& row) {
+        const uint8_t* in = src + std::min(std::max(y, 0), height - 1) * srcStep;
+        int16_t* p = padded.data() + 1;
+        for (int x = 0; x < width; x++)
+        {
+            p[x] = in[x * 4];
+        }
+        p[-1] = p[0];
+        p[width] = p[width - 1];
+
+        for (int x = 0; x < width; x++)
+        {
+            row.dxx[x] = int16_t(p[x - 1] - 2 * p[x] + p[x + 1]);
+            row.sum[x] = int16_t(p[x - 1] + 2 * p[x] + p[x + 1]);
+            row.dx[x] = int16_t(p[x + 1] - p[x - 1]);
+        }
+    };
+
+    // d * 255 = gain * 255 * det:
+    const float scale = gain / (256.f * 255.f);
+
+    std::array<Row*, 3> window{ { &rows[0], &rows[1], &rows[2] } };
+    filter(-1, *window[0]);
+    filter(0, *window[1]);
+    for (int y = 0; y < height; y++)
+    {
+        filter(y + 1, *window[2]);
+
+        const Row &r0 = *window[0], &r1 = *window[1], &r2 = *window[2];
+        uint8_t* out = dst + y * dstStep;
+        for (int x = 0; x < width; x++)
+        {
+            const int ixx = r0.dxx[x] + 2 * r1.dxx[x] + r2.dxx[x];
+            const int iyy = r0.sum[x] - 2 * r1.sum[x] + r2.sum[x];
+            const int ixy = r2.dx[x] - r0.dx[x];
+            const int det = ixx * iyy - 16 * ixy * ixy;
+            const bool keep = ((ixx + iyy) <= 0) && (det >= 0);
+            const uint8_t value = keep ? uint8_t(std::min(float(det) * scale, 255.f) + 0.5f) : 0;
+            out[x * 4 + 0] = out[x * 4 + 1] = out[x * 4 + 2] = value;
+            out[x * 4 + 3] = 255;
+        }
+
+        std::rotate(window.begin(), window.begin() + 1, window.end());
+    }
+}
+
+void nms3x3U8C4(const uint8_t* src, std::size_t srcStep, uint8_t* dst, std::size_t dstStep, int width, int height, int in, int out)
+{
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t* r0 = src + std::max(y - 1, 0) * srcStep;
+        const uint8_t* r1 = src + y * srcStep;
+        const uint8_t* r2 = src + std::min(y + 1, height - 1) * srcStep;
+        uint8_t* o = dst + y * dstStep;
+        for (int x = 0; x < width; x++)
+        {
+            const int l = std::max(x - 1, 0) * 4 + in, c = x * 4 + in, r = std::min(x + 1, width - 1) * 4 + in;
+            const uint8_t v = r1[c];
+
+            // clang-format off
+            const bool isPeak =
+                (v > r0[l]) && (v > r1[l]) && (v > r2[l]) && (v > r0[c]) &&
+                (v >= r0[r]) && (v >= r1[r]) && (v >= r2[r]) && (v >= r2[c]);
+            // clang-format on
+
+            std::memcpy(o + x * 4, r1 + x * 4, 4);
+            o[x * 4 + out] = isPeak ? v : 0;
+        }
+    }
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,50 @@
+/*! -*-c++-*-
+  @file   filters.h
+  @author David Hirvonen
+  @brief  Declaration of CPU equivalents of the ogles_gpgpu binomial, saturation, Hessian and NMS shaders.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_filters_h__
+#define __drishti_core_filters_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <cstddef>
+#include <cstdint>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+// CPU equivalent of ogles_gpgpu::BinomialProc: the separable [1 2 1]^T [1 2 1] / 16 kernel on
+// interleaved 8-bit pixels (channels per pixel) with replicated borders (GL_CLAMP_TO_EDGE).
+// Integer sums rounded half up match the shader (float sum, unorm8 rounding) bit for bit,
+// except for exact ties (a sum of 8 mod 16), which drivers may round either way.
+// The destination may alias the source.
+void binomial3x3U8(const uint8_t* src, std::size_t srcStep, uint8_t* dst, std::size_t dstStep, int width, int height, int channels);
+
+// CPU equivalent of ogles_gpgpu::SaturationProc on 4 channel pixels (RGBA or BGRA, since the
+// measure is symmetric in r, g and b): d = clamp(gain * (1 - |rgb - 1| / sqrt(3)), 0, 1) is
+// written as (d, d, d, 1).  Results may differ from mediump shaders in the last bit.
+void saturationU8C4(const uint8_t* src, std::size_t srcStep, uint8_t* dst, std::size_t dstStep, int width, int height, float gain);
+
+// CPU equivalent of ogles_gpgpu::HessianProc on 4 channel pixels: the determinant of the 3x3
+// Hessian of channel 0 (Ixx, Iyy = [1 -2 1] x [1 2 1] / 16, Ixy = [-1 0 1] x [-1 0 1] / 4 on
+// intensities in [0,1]) times gain is written as (d, d, d, 1), with d = 0 where the trace is
+// positive or the determinant is negative (only bright blobs respond).  Derivatives and the
+// determinant are exact in integer arithmetic, only the final scale is float, so results are
+// within one step of the shader.  Replicated borders, the destination must not alias the source.
+void hessian3x3U8C4(const uint8_t* src, std::size_t srcStep, uint8_t* dst, std::size_t dstStep, int width, int height, float gain);
+
+// CPU equivalent of ogles_gpgpu::NmsProc on 4 channel pixels: channel `in` of the source is
+// written to channel `out` if it is a 3x3 local maximum and 0 otherwise, the other channels are
+// copied.  Ties are broken as in the shader: the center must be greater than the left column and
+// the pixel above, and no less than the other neighbors, so a plateau keeps a single pixel.
+// Replicated borders, the destination must not alias the source.
+void nms3x3U8C4(const uint8_t* src, std::size_t srcStep, uint8_t* dst, std::size_t dstStep, int width, int height, int in, int out);
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_filters_h__
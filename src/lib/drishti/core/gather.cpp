@@ -0,0 +1,150 @@
+/*! -*-c++-*-
+  @file   gather.cpp
+  @author David Hirvonen
+  @brief  Implementation of optimized (SIMD) pixel gather routines for pose indexed features.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/gather.h"
+
+#include <algorithm>
+#include <cmath>
+
+// clang-format off
+#if defined (__arm__) || defined(__arm64__)
+#  include <arm_neon.h>
+#  define USE_SIMD 1
+#elif __APPLE__
+#  include "TargetConditionals.h"
+#  if !TARGET_IPHONE_SIMULATOR
+#    include "NEON_2_SSE.h"
+#    define USE_SIMD 1
+#  else
+#    define USE_SIMD 0
+#  endif
+#else
+#  if (defined(__SSE2__) || defined(__x86_64__) || defined(__AVX2__)) && DRISHTI_BUILD_REGRESSION_SIMD
+#    define USE_SIMD 1
+#    include "NEON_2_SSE.h"
+#  else
+#    define USE_SIMD 0
+#  endif
+#endif
+// clang-format on
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+// Round half up (i.e., dlib::point conversion) and check bounds:
+static inline float gather1(const uint8_t* data, std::size_t step, int width, int height, float x, float y, float background)
+{
+    const float xr = std::floor(x + 0.5f), yr = std::floor(y + 0.5f);
+    if ((xr >= 0.f) && (yr >= 0.f) && (xr < float(width)) && (yr < float(height)))
+    {
+        return float(data[std::size_t(yr) * step + std::size_t(xr)]);
+    }
+    return background;
+}
+
+#if USE_SIMD
+
+// Gather four pixels for the (x, y) lanes given in image coordinates:
+static inline float32x4_t gather4(const uint8_t* data, std::size_t step, float32x4_t x, float32x4_t y, float32x4_t w, float32x4_t h, float32x4_t background)
+{
+    const float32x4_t half = vdupq_n_f32(0.5f), zero = vdupq_n_f32(0.f);
+
+    // Shifted coordinates are non-negative for all valid lanes, so truncation == floor:
+    x = vaddq_f32(x, half);
+    y = vaddq_f32(y, half);
+
+    const uint32x4_t inside = vandq_u32(vandq_u32(vcgeq_f32(x, zero), vcgeq_f32(y, zero)), vandq_u32(vcltq_f32(x, w), vcltq_f32(y, h)));
+
+    // Clamp invalid lanes to the origin so that every lane can be fetched:
+    const uint32x4_t xi = vandq_u32(vcvtq_u32_f32(vmaxq_f32(x, zero)), inside);
+    const uint32x4_t yi = vandq_u32(vcvtq_u32_f32(vmaxq_f32(y, zero)), inside);
+
+    uint32_t xs[4], ys[4];
+    vst1q_u32(xs, xi);
+    vst1q_u32(ys, yi);
+
+    uint32_t pixels[4];
+    for (int k = 0; k < 4; k++)
+    {
+        pixels[k] = data[std::size_t(ys[k]) * step + xs[k]];
+    }
+
+    return vbslq_f32(inside, vcvtq_f32_u32(vld1q_u32(pixels)), background);
+}
+
+void gatherU8(const uint8_t* data, std::size_t step, int width, int height, const float* x, const float* y, float* values, int n, float background)
+{
+    if ((width <= 0) || (height <= 0))
+    {
+        std::fill(values, values + n, background); // every lane would be clamped to a missing origin
+        return;
+    }
+
+    const float32x4_t w = vdupq_n_f32(float(width)), h = vdupq_n_f32(float(height)), b = vdupq_n_f32(background);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4)
+    {
+        vst1q_f32(values + i, gather4(data, step, vld1q_f32(x + i), vld1q_f32(y + i), w, h, b));
+    }
+    for (; i < n; i++)
+    {
+        values[i] = gather1(data, step, width, height, x[i], y[i], background);
+    }
+}
+
+void gatherAffineU8(const uint8_t* data, std::size_t step, int width, int height, const float H[6], const float* x, const float* y, float* values, int n, float background)
+{
+    if ((width <= 0) || (height <= 0))
+    {
+        std::fill(values, values + n, background); // every lane would be clamped to a missing origin
+        return;
+    }
+
+    const float32x4_t w = vdupq_n_f32(float(width)), h = vdupq_n_f32(float(height)), b = vdupq_n_f32(background);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4)
+    {
+        const float32x4_t xs = vld1q_f32(x + i), ys = vld1q_f32(y + i);
+        const float32x4_t u = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(H[2]), xs, H[0]), ys, H[1]);
+        const float32x4_t v = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(H[5]), xs, H[3]), ys, H[4]);
+        vst1q_f32(values + i, gather4(data, step, u, v, w, h, b));
+    }
+    for (; i < n; i++)
+    {
+        const float u = H[0] * x[i] + H[1] * y[i] + H[2];
+        const float v = H[3] * x[i] + H[4] * y[i] + H[5];
+        values[i] = gather1(data, step, width, height, u, v, background);
+    }
+}
+
+#else
+
+void gatherU8(const uint8_t* data, std::size_t step, int width, int height, const float* x, const float* y, float* values, int n, float background)
+{
+    for (int i = 0; i < n; i++)
+    {
+        values[i] = gather1(data, step, width, height, x[i], y[i], background);
+    }
+}
+
+void gatherAffineU8(const uint8_t* data, std::size_t step, int width, int height, const float H[6], const float* x, const float* y, float* values, int n, float background)
+{
+    for (int i = 0; i < n; i++)
+    {
+        const float u = H[0] * x[i] + H[1] * y[i] + H[2];
+        const float v = H[3] * x[i] + H[4] * y[i] + H[5];
+        values[i] = gather1(data, step, width, height, u, v, background);
+    }
+}
+
+#endif // USE_SIMD
+
+DRISHTI_CORE_NAMESPACE_END
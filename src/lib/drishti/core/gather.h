@@ -0,0 +1,32 @@
+/*! -*-c++-*-
+  @file   gather.h
+  @author David Hirvonen
+  @brief  Declaration of optimized (SIMD) pixel gather routines for pose indexed features.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_gather_h__
+#define __drishti_core_gather_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <cstddef>
+#include <cstdint>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+// Gather n 8-bit pixels at the nearest integer locations (x[i], y[i]) of a
+// width x height image with a row stride of step bytes.  Samples outside the
+// image are set to background.
+void gatherU8(const uint8_t* data, std::size_t step, int width, int height, const float* x, const float* y, float* values, int n, float background = 0.f);
+
+// Map n points with the 2x3 affine transform H (row major) and gather the
+// 8-bit pixels at the nearest integer locations (as gatherU8):
+void gatherAffineU8(const uint8_t* data, std::size_t step, int width, int height, const float H[6], const float* x, const float* y, float* values, int n, float background = 0.f);
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_gather_h__
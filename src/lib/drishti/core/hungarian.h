@@ -21,20 +21,12 @@
   See the License for the specific language governing permissions and
   limitations under the License.
 
-  IMPORTANT NOTE: we advise using the code in
-  graph/linear_assignment.h whose complexity is
-  usually much smaller.
-  TODO(user): base this code on LinearSumAssignment.
-
-  An O(n^4) implementation of the Kuhn-Munkres algorithm (a.k.a. the
-  Hungarian algorithm) for solving the assignment problem.
-  The assignment problem takes a set of agents, a set of tasks and a
-  cost associated with assigning each agent to each task and produces
-  an optimal (i.e., least cost) assignment of agents to tasks.
-  The code also enables computing a maximum assignment by changing the
-  input matrix.
-
-  This code is based on (read: translated from) the Java version
+  The interface of the Kuhn-Munkres (Hungarian) assignment code, which is
+  now solved by the O(n^3) shortest augmenting path solver in
+  drishti/core/LinearAssignment.h.  Use that directly for contiguous
+  (float) cost matrices.
+
+  The original code was based on (read: translated from) the Java version
   (read: translated from) the Python version at
     http:www.clapper.org/software/python/munkres/
   which in turn is based on
@@ -56,12 +48,11 @@
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
-// See IMPORTANT NOTE at the top of the file.
+// cost[agent][task], agents that aren't assigned (more agents than tasks) are left out:
 void MinimizeLinearAssignment(const std::vector<std::vector<double>>& cost,
     std::unordered_map<int, int>& direct_assignment,
     std::unordered_map<int, int>& reverse_assignment);
 
-// See IMPORTANT NOTE at the top of the file.
 void MaximizeLinearAssignment(const std::vector<std::vector<double>>& cost,
     std::unordered_map<int, int>& direct_assignment,
     std::unordered_map<int, int>& reverse_assignment);
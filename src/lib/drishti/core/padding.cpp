@@ -8,39 +8,161 @@
 
 */
 
-#include "drishti/core/drishti_core.h"
+#include "drishti/core/padding.h"
 
 #include <opencv2/imgproc.hpp>
 #include <opencv2/videostab.hpp>
 
+#include <cstring>
 #include <iostream>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
-cv::Point padWithInpainting(const cv::Mat& image, cv::Mat& padded, int top, int bottom, int left, int right, bool inPaint)
+// Copy the edge pixels of roi outward: left and right of each row first, then the top and bottom rows.
+static void replicateBorder(cv::Mat& canvas, const cv::Rect& roi)
+{
+    const std::size_t size = canvas.elemSize();
+    for (int y = roi.y; y < roi.br().y; y++)
+    {
+        uint8_t* row = canvas.ptr<uint8_t>(y);
+        const uint8_t* first = row + roi.x * size;
+        const uint8_t* last = row + (roi.br().x - 1) * size;
+        for (int x = 0; x < roi.x; x++)
+        {
+            std::memcpy(row + x * size, first, size);
+        }
+        for (int x = roi.br().x; x < canvas.cols; x++)
+        {
+            std::memcpy(row + x * size, last, size);
+        }
+    }
+
+    const std::size_t width = canvas.cols * size;
+    for (int y = 0; y < roi.y; y++)
+    {
+        std::memcpy(canvas.ptr<uint8_t>(y), canvas.ptr<uint8_t>(roi.y), width);
+    }
+    for (int y = roi.br().y; y < canvas.rows; y++)
+    {
+        std::memcpy(canvas.ptr<uint8_t>(y), canvas.ptr<uint8_t>(roi.br().y - 1), width);
+    }
+}
+
+// Replicated pixels form streaks across the band, a box filter along the band (and a little across it)
+// smooths them out.  Only the band is written, the image pixels next to it are read for context.
+static void blurBand(cv::Mat& canvas, const cv::Rect& band, const cv::Size& kernel)
 {
+    if (band.area() <= 0)
+    {
+        return;
+    }
+
+    const cv::Rect bounds(0, 0, canvas.cols, canvas.rows);
+    const cv::Rect context = cv::Rect(band.x - kernel.width / 2, band.y - kernel.height / 2, band.width + kernel.width, band.height + kernel.height) & bounds;
+
+    cv::Mat blurred;
+    cv::blur(canvas(context), blurred, kernel, { -1, -1 }, cv::BORDER_REPLICATE);
+    blurred(band - context.tl()).copyTo(canvas(band));
+}
+
+static int getKernelSize(int thickness)
+{
+    return std::min(std::max(thickness, 3), 63) | 1;
+}
+
+void fillBorder(cv::Mat& canvas, const cv::Rect& roi, PaddingMode mode)
+{
+    CV_Assert((roi & cv::Rect(0, 0, canvas.cols, canvas.rows)) == roi && roi.area() > 0);
+
+    switch (mode)
+    {
+        case kPaddingConstant:
+        {
+            const cv::Scalar zero = cv::Scalar::all(0);
+            canvas.rowRange(0, roi.y).setTo(zero);
+            canvas.rowRange(roi.br().y, canvas.rows).setTo(zero);
+            canvas(cv::Rect(0, roi.y, roi.x, roi.height)).setTo(zero);
+            canvas(cv::Rect(roi.br().x, roi.y, canvas.cols - roi.br().x, roi.height)).setTo(zero);
+            break;
+        }
+
+        case kPaddingInpaint:
+        {
+            CV_Assert(canvas.type() == CV_8UC3);
+            cv::Mat mask = cv::Mat::zeros(canvas.size(), CV_8UC1);
+            mask(roi).setTo(255);
+
+            cv::videostab::ColorAverageInpainter inpainter;
+            //cv::videostab::ColorInpainter inpainter(cv::INPAINT_TELEA, std::min(image.cols, image.rows)/16.0);
+            inpainter.inpaint(0, canvas, mask);
+            break;
+        }
+
+        case kPaddingFast:
+        {
+            replicateBorder(canvas, roi);
+
+            const int top = roi.y, bottom = canvas.rows - roi.br().y;
+            const int left = roi.x, right = canvas.cols - roi.br().x;
+            blurBand(canvas, { 0, 0, canvas.cols, top }, { getKernelSize(top * 2), 3 });
+            blurBand(canvas, { 0, roi.br().y, canvas.cols, bottom }, { getKernelSize(bottom * 2), 3 });
+            blurBand(canvas, { 0, roi.y, left, roi.height }, { 3, getKernelSize(left * 2) });
+            blurBand(canvas, { roi.br().x, roi.y, right, roi.height }, { 3, getKernelSize(right * 2) });
+            break;
+        }
+    }
+}
+
+cv::Point pad(const cv::Mat& image, cv::Mat& padded, int top, int bottom, int left, int right, PaddingMode mode, bool inPlace)
+{
+    const cv::Point tl(left, top);
     if (top <= 0 && bottom <= 0 && left <= 0 && right <= 0)
     {
         padded = image;
         return cv::Point(0, 0);
     }
 
-    cv::Mat mask;
-    cv::copyMakeBorder(image, padded, std::max(top, 0), std::max(bottom, 0), std::max(left, 0), std::max(right, 0), cv::BORDER_CONSTANT);
-    mask = cv::Mat::zeros(padded.size(), CV_8UC1);
-    mask({ { std::max(left, 0), std::max(top, 0) }, image.size() }).setTo(255);
+    top = std::max(top, 0);
+    bottom = std::max(bottom, 0);
+    left = std::max(left, 0);
+    right = std::max(right, 0);
 
-    cv::videostab::ColorAverageInpainter inpainter;
-    //cv::videostab::ColorInpainter inpainter(cv::INPAINT_TELEA, std::min(image.cols, image.rows)/16.0);
-    inpainter.inpaint(0, padded, mask);
+    const cv::Rect roi(left, top, image.cols, image.rows);
 
-    return cv::Point(left, top);
+    cv::Size whole;
+    cv::Point offset;
+    image.locateROI(whole, offset);
+    if (inPlace && (offset.x >= left) && (offset.y >= top) && ((whole.width - offset.x - image.cols) >= right) && ((whole.height - offset.y - image.rows) >= bottom))
+    {
+        padded = image;
+        padded.adjustROI(top, bottom, left, right);
+    }
+    else
+    {
+        // Reuse the buffer of padded when it has the right size (the header keeps image alive if they alias):
+        const cv::Mat source = image;
+        padded.create(source.rows + top + bottom, source.cols + left + right, source.type());
+        source.copyTo(padded(roi));
+    }
+
+    fillBorder(padded, roi, mode);
+
+    return tl;
+}
+
+cv::Point padWithInpainting(const cv::Mat& image, cv::Mat& padded, int top, int bottom, int left, int right, bool inPaint)
+{
+    return pad(image, padded, top, bottom, left, right, inPaint ? kPaddingInpaint : kPaddingFast);
 }
 
 cv::Point padToAspectRatio(const cv::Mat& image, cv::Mat& padded, double aspectRatio, bool inPaint)
 {
     CV_Assert(image.channels() == 3);
+    return padToAspectRatio(image, padded, aspectRatio, inPaint ? kPaddingInpaint : kPaddingFast);
+}
 
+cv::Point padToAspectRatio(const cv::Mat& image, cv::Mat& padded, double aspectRatio, PaddingMode mode, bool inPlace)
+{
     int top = 0, left = 0, bottom = 0, right = 0;
     if (double(image.cols) / image.rows > aspectRatio)
     {
@@ -55,10 +177,15 @@ cv::Point padToAspectRatio(const cv::Mat& image, cv::Mat& padded, double aspectR
         right = padding - left;
     }
 
-    return padWithInpainting(image, padded, top, bottom, left, right, inPaint);
+    return pad(image, padded, top, bottom, left, right, mode, inPlace);
 }
 
 cv::Point padToWidthUsingAspectRatio(const cv::Mat& canvas, cv::Mat& padded, int width, double aspectRatio, bool inPaint)
+{
+    return padToWidthUsingAspectRatio(canvas, padded, width, aspectRatio, inPaint ? kPaddingInpaint : kPaddingFast);
+}
+
+cv::Point padToWidthUsingAspectRatio(const cv::Mat& canvas, cv::Mat& padded, int width, double aspectRatio, PaddingMode mode, bool inPlace)
 {
     int height = double(width) / aspectRatio;
     int top = 0, left = 0, bottom = 0, right = 0;
@@ -73,14 +200,14 @@ cv::Point padToWidthUsingAspectRatio(const cv::Mat& canvas, cv::Mat& padded, int
         int vPad = (height - canvas.rows);
         top = vPad / 2;
         bottom = vPad - top;
-        tl = padWithInpainting(canvas, padded, top, bottom, left, right, inPaint);
+        tl = pad(canvas, padded, top, bottom, left, right, mode, inPlace);
     }
     else
     {
         int vCrop = (canvas.rows - height);
         top = vCrop / 2;
         bottom = vCrop - top;
-        tl = padWithInpainting(canvas, padded, top, bottom, left, right, inPaint);
+        tl = pad(canvas, padded, top, bottom, left, right, mode, inPlace);
     }
 
     if (left < 0 || right < 0 || top < 0 || bottom < 0)
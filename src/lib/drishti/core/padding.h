@@ -16,6 +16,23 @@
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
+enum PaddingMode
+{
+    kPaddingConstant, // zero
+    kPaddingInpaint,  // ColorAverageInpainter over the whole padded image (slow)
+    kPaddingFast      // replicate the edges and blur along the border bands only
+};
+
+// Negative padding is ignored.  With inPlace, an image that is a view of a larger matrix (see cv::Mat::adjustROI())
+// with room for the border is padded without copying the image: the border of the parent matrix is overwritten.
+cv::Point pad(const cv::Mat& image, cv::Mat& padded, int top, int bottom, int left, int right, PaddingMode mode, bool inPlace = false);
+cv::Point padToAspectRatio(const cv::Mat& image, cv::Mat& padded, double aspectRatio, PaddingMode mode, bool inPlace = false);
+cv::Point padToWidthUsingAspectRatio(const cv::Mat& canvas, cv::Mat& padded, int width, double aspectRatio, PaddingMode mode, bool inPlace = false);
+
+// Fill canvas outside of roi, which holds the image:
+void fillBorder(cv::Mat& canvas, const cv::Rect& roi, PaddingMode mode);
+
+// inPaint : kPaddingInpaint, else kPaddingFast
 cv::Point padWithInpainting(const cv::Mat& image, cv::Mat& padded, int top, int bottom, int left, int right, bool inPaint = true);
 cv::Point padToAspectRatio(const cv::Mat& image, cv::Mat& padded, double aspectRatio, bool inPaint = true);
 cv::Point padToWidthUsingAspectRatio(const cv::Mat& canvas, cv::Mat& padded, int width, double aspectRatio, bool inPaint = true);
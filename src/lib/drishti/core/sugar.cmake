@@ -12,11 +12,27 @@ endif()
 include(sugar_files)
 
 sugar_files(DRISHTI_CORE_SRCS
+  CompressedStream.cpp
+  CsvReader.cpp
+  Executor.cpp
+  FlatArchive.cpp
+  FrameArena.cpp
+  JsonStream.cpp
+  LinearAssignment.cpp
   Logger.cpp
+  MemoryUsage.cpp
+  Metrics.cpp
+  Profiler.cpp
   Shape.cpp
+  ThreadPool.cpp
+  TraceRecorder.cpp
+  TrainingReport.cpp
+  WorkerTeam.cpp
   arithmetic.cpp
   convert.cpp
   drawing.cpp
+  filters.cpp
+  gather.cpp
   hungarian.cpp
   padding.cpp
   string_utils.cpp
@@ -24,17 +40,35 @@ sugar_files(DRISHTI_CORE_SRCS
 
 # For now make them all public
 sugar_files(DRISHTI_CORE_HDRS_PUBLIC
+  CompressedStream.h
+  CsvReader.h
+  Executor.h
   Field.h
   FixedField.h
+  FlatArchive.h
+  FrameArena.h
+  JsonStream.h
   ImageView.h
   IndentingOStreamBuffer.h
   LazyParallelResource.h
   Line.h
+  LinearAssignment.h
   Logger.h
+  MemoryUsage.h
+  Metrics.h
+  ModelCache.h
   Parallel.h
+  ParallelFor.h
+  Profiler.h
+  ResultsCache.h
+  RingQueue.h
   Semaphore.h
   Shape.h
+  ThreadPool.h
   ThrowAssert.h
+  TraceRecorder.h
+  TrainingReport.h
+  WorkerTeam.h
   arithmetic.h
   convert.h
   drawing.h
@@ -43,6 +77,7 @@ sugar_files(DRISHTI_CORE_HDRS_PUBLIC
   drishti_core.h
   drishti_csv.h
   drishti_cv_cereal.h    
+  drishti_cv_json.h
   drishti_cvmat_cereal.h  
   drishti_defs.hpp
   drishti_math.h
@@ -50,6 +85,9 @@ sugar_files(DRISHTI_CORE_HDRS_PUBLIC
   drishti_serialize.h
   drishti_stdlib_string.h
   drishti_string_hash.h
+  drishti_type_traits.h
+  filters.h
+  gather.h
   hungarian.h
   infix_iterator.h
   make_unique.h
@@ -59,11 +97,6 @@ sugar_files(DRISHTI_CORE_HDRS_PUBLIC
   timing.h
 )
 
-if(DRISHTI_USE_THREAD_POOL_CPP)
-  sugar_files(DRISHTI_CORE_HDRS_PUBLIC ThreadPool.h)
-  sugar_files(DRISHTI_CORE_SRCS ThreadPool.cpp)  
-endif()
-
 sugar_files(DRISHTI_CORE_UT
   ut/test-drishti-core.cpp
   )
\ No newline at end of file
@@ -12,9 +12,15 @@
 #define __drishti_core_timing_h__
 
 #include <chrono>
+#include <cstdint>
 #include <functional>
+#include <type_traits>
+#include <utility>
 
 #include "drishti/core/drishti_core.h"
+#include "drishti/core/Metrics.h"
+#include "drishti/core/Profiler.h"
+#include "drishti/core/TraceRecorder.h"
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
@@ -31,16 +37,77 @@ public:
         m_tic = HighResolutionClock::now();
     }
 
+    // Named scopes are reported by name to the active TraceRecorder (if any) and
+    // are profiler zones (see Profiler.h):
+    template <class Callable>
+    ScopeTimeLogger(const char* name, Callable&& logger)
+        : m_logger(std::forward<Callable>(logger))
+        , m_name(name)
+        , m_hasZone(true)
+        , m_zone(beginProfileZone(name))
+    {
+        m_tic = HighResolutionClock::now();
+    }
+
+    // Record into a histogram, this doesn't allocate (the callback is optional):
+    ScopeTimeLogger(const char* name, Histogram& histogram)
+        : m_histogram(&histogram)
+        , m_name(name)
+        , m_hasZone(true)
+        , m_zone(beginProfileZone(name))
+    {
+        m_tic = HighResolutionClock::now();
+    }
+
+    template <class Callable>
+    ScopeTimeLogger(const char* name, Histogram& histogram, Callable&& logger)
+        : m_logger(std::forward<Callable>(logger))
+        , m_histogram(&histogram)
+        , m_name(name)
+        , m_hasZone(true)
+        , m_zone(beginProfileZone(name))
+    {
+        m_tic = HighResolutionClock::now();
+    }
+
     ScopeTimeLogger(ScopeTimeLogger&& other)
         : m_logger(std::move(other.m_logger))
+        , m_histogram(other.m_histogram)
         , m_tic(std::move(other.m_tic))
+        , m_name(other.m_name)
+        , m_hasZone(other.m_hasZone)
+        , m_zone(other.m_zone)
     {
+        other.m_logger = nullptr;
+        other.m_histogram = nullptr;
+        other.m_hasZone = false;
     }
 
     ~ScopeTimeLogger()
     {
-        auto now = HighResolutionClock::now();
-        m_logger(timeDifference(now, m_tic));
+        if (m_hasZone)
+        {
+            endProfileZone(m_name, m_zone);
+        }
+
+        if (m_logger || m_histogram)
+        {
+            auto now = HighResolutionClock::now();
+            if (auto* recorder = TraceRecorder::getActive())
+            {
+                recorder->record(m_name, m_tic, now);
+            }
+
+            const double elapsed = timeDifference(now, m_tic);
+            if (m_histogram)
+            {
+                m_histogram->record(elapsed);
+            }
+            if (m_logger)
+            {
+                m_logger(elapsed);
+            }
+        }
     }
 
     ScopeTimeLogger(const ScopeTimeLogger&) = delete;
@@ -55,9 +122,140 @@ public:
 
 protected:
     std::function<void(double)> m_logger;
+    Histogram* m_histogram = nullptr;
     TimePoint m_tic;
+    const char* m_name = "scope";
+    bool m_hasZone = false;
+    std::uint64_t m_zone = 0;
+};
+
+/*
+ * Timing categories: -DDRISHTI_TIMING_CATEGORIES=<mask> (default: all) selects the ScopeTimer
+ * categories that are compiled in, the others are empty objects that never read the clock.
+ */
+
+// clang-format off
+#if !defined(DRISHTI_TIMING_CATEGORIES)
+#  define DRISHTI_TIMING_CATEGORIES 0xffffffffu
+#endif
+// clang-format on
+
+enum TimingCategory : std::uint32_t
+{
+    kTimingDetection = 1 << 0,  // object detection
+    kTimingRegression = 1 << 1, // face and eye regression
+    kTimingPipeline = 1 << 2,   // per frame stages (FaceFinder)
+    kTimingDisplay = 1 << 3     // rendering and annotations
+};
+
+template <std::uint32_t Category>
+struct TimingEnabled : std::integral_constant<bool, (DRISHTI_TIMING_CATEGORIES & Category) != 0>
+{
+};
+
+// Default ScopeTimer callback (histogram and trace only):
+struct NullTimeLogger
+{
+    void operator()(double) const {}
 };
 
+/*
+ * ScopeTimeLogger with the callback type as a template parameter: the callback is stored by
+ * value and inlined (no std::function), and the histogram slot is written directly.  Use
+ * makeScopeTimer<Category>() to deduce the callback type.
+ */
+
+template <std::uint32_t Category, class Callable = NullTimeLogger, bool Enabled = TimingEnabled<Category>::value>
+class ScopeTimer
+{
+    using HighResolutionClock = std::chrono::high_resolution_clock;
+    using TimePoint = HighResolutionClock::time_point;
+
+public:
+    ScopeTimer(const char* name, Histogram* histogram, Callable logger)
+        : m_logger(std::move(logger))
+        , m_histogram(histogram)
+        , m_name(name)
+        , m_zone(beginProfileZone(name))
+        , m_tic(HighResolutionClock::now())
+    {
+    }
+
+    ScopeTimer(ScopeTimer&& other)
+        : m_logger(std::move(other.m_logger))
+        , m_histogram(other.m_histogram)
+        , m_name(other.m_name)
+        , m_zone(other.m_zone)
+        , m_tic(other.m_tic)
+        , m_active(other.m_active)
+    {
+        other.m_active = false;
+    }
+
+    ~ScopeTimer()
+    {
+        if (m_active)
+        {
+            endProfileZone(m_name, m_zone);
+
+            const auto now = HighResolutionClock::now();
+            if (auto* recorder = TraceRecorder::getActive())
+            {
+                recorder->record(m_name, m_tic, now);
+            }
+
+            const double elapsed = ScopeTimeLogger::timeDifference(now, m_tic);
+            if (m_histogram)
+            {
+                m_histogram->record(elapsed);
+            }
+            m_logger(elapsed);
+        }
+    }
+
+    ScopeTimer(const ScopeTimer&) = delete;
+    void operator=(const ScopeTimer&) = delete;
+
+protected:
+    Callable m_logger;
+    Histogram* m_histogram = nullptr;
+    const char* m_name = "scope";
+    std::uint64_t m_zone = 0;
+    TimePoint m_tic;
+    bool m_active = true;
+};
+
+// Compiled out category: the callback is dropped and nothing is measured.
+template <std::uint32_t Category, class Callable>
+class ScopeTimer<Category, Callable, false>
+{
+public:
+    ScopeTimer(const char* /* name */, Histogram* /* histogram */, const Callable& /* logger */) {}
+    ScopeTimer(ScopeTimer&&) {}
+    ~ScopeTimer() {} // non-trivial: no unused variable warnings at the call sites
+
+    ScopeTimer(const ScopeTimer&) = delete;
+    void operator=(const ScopeTimer&) = delete;
+};
+
+template <std::uint32_t Category, class Callable>
+ScopeTimer<Category, typename std::decay<Callable>::type> makeScopeTimer(const char* name, Callable&& logger)
+{
+    return { name, nullptr, std::forward<Callable>(logger) };
+}
+
+template <std::uint32_t Category>
+ScopeTimer<Category> makeScopeTimer(const char* name, Histogram& histogram)
+{
+    return { name, &histogram, NullTimeLogger() };
+}
+
+template <std::uint32_t Category, class Callable>
+ScopeTimer<Category, typename std::decay<Callable>::type> makeScopeTimer(const char* name, Histogram& histogram, Callable&& logger)
+{
+    return { name, &histogram, std::forward<Callable>(logger) };
+}
+
 DRISHTI_CORE_NAMESPACE_END
 
 #endif // __drishti_core_timing_h__
@@ -10,8 +10,42 @@
 
 #include <gtest/gtest.h>
 
+#include "drishti/core/arithmetic.h"
+#include "drishti/core/CompressedStream.h"
 #include "drishti/core/convert.h"
+#include "drishti/core/CsvReader.h"
+#include "drishti/core/Executor.h"
+#include "drishti/core/filters.h"
+#include "drishti/core/FlatArchive.h"
+#include "drishti/core/FrameArena.h"
+#include "drishti/core/gather.h"
 #include "drishti/core/hungarian.h"
+#include "drishti/core/LazyParallelResource.h"
+#include "drishti/core/LinearAssignment.h"
+#include "drishti/core/ModelCache.h"
+#include "drishti/core/make_unique.h"
+#include "drishti/core/MemoryUsage.h"
+#include "drishti/core/Metrics.h"
+#include "drishti/core/padding.h"
+#include "drishti/core/ResultsCache.h"
+#include "drishti/core/ParallelFor.h"
+#include "drishti/core/RingQueue.h"
+#include "drishti/core/Shape.h"
+#include "drishti/core/drishti_cereal_pba.h"
+#include "drishti/core/TraceRecorder.h"
+#include "drishti/core/TrainingReport.h"
+#include "drishti/core/WorkerTeam.h"
+#include "drishti/core/timing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <vector>
 
 // clang-format off
@@ -56,6 +90,42 @@ TEST(HungarianAssignment, hungarian)
     }
 }
 
+TEST(HungarianAssignment, linear_assignment_matches_brute_force)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> uniform(0.f, 100.f);
+    for (int trial = 0; trial < 100; trial++)
+    {
+        const int rows = 1 + (trial % 6), cols = 1 + ((trial / 6) % 6);
+        cv::Mat1f cost(rows, cols);
+        for (auto& c : cost)
+        {
+            c = uniform(rng);
+        }
+
+        std::vector<int> assignment;
+        const float total = drishti::core::MinimizeLinearAssignment(cost, assignment);
+        ASSERT_EQ(assignment.size(), rows);
+
+        const int n = std::max(rows, cols);
+        std::vector<int> columns(n);
+        std::iota(columns.begin(), columns.end(), 0);
+        float best = std::numeric_limits<float>::max();
+        do
+        {
+            float sum = 0.f;
+            for (int i = 0; i < rows; i++)
+            {
+                sum += (columns[i] < cols) ? cost(i, columns[i]) : 0.f;
+            }
+            best = std::min(best, sum);
+        } while (std::next_permutation(columns.begin(), columns.end()));
+
+        ASSERT_NEAR(total, best, 1e-3f);
+        ASSERT_EQ(std::count(assignment.begin(), assignment.end(), -1), std::max(rows - cols, 0));
+    }
+}
+
 static const int rgba[] = { 2, 1, 0, 3 };
 
 static std::vector<cv::Mat> unpack_test(const cv::Size& size)
@@ -136,4 +206,772 @@ TEST(ChannelConversion, convert_rem_16)
     }
 }
 
+TEST(ChannelConversion, convert_bgr_to_planes)
+{
+    // Channels are reordered and scaled, including the tail of each row:
+    cv::Mat3b src(100, 161);
+    cv::randu(src, cv::Scalar::all(0), cv::Scalar::all(255));
+
+    std::vector<cv::Mat> channels;
+    cv::split(src, channels);
+
+    std::vector<cv::Mat> dst{ cv::Mat1f(src.size()), cv::Mat1f(src.size()), cv::Mat1f(src.size()) };
+    std::vector<drishti::core::PlaneInfo> table{ { dst[0], 2, 0.5f }, { dst[1], 1, 0.5f }, { dst[2], 0, 0.5f } };
+    drishti::core::convertU8ToF32(src, table);
+
+    for (int i = 0; i < 3; i++)
+    {
+        cv::Mat expected;
+        channels[2 - i].convertTo(expected, CV_32F, 0.5);
+        ASSERT_EQ(cv::countNonZero(dst[i] != expected), 0);
+    }
+}
+
+TEST(ChannelConversion, yuv420_to_planes)
+{
+    const cv::Size size(37, 9), half((size.width + 1) / 2, (size.height + 1) / 2); // odd sizes for SIMD tails
+
+    cv::Mat1b y(size), u(half), v(half);
+    cv::randu(y, 16, 236);
+    cv::randu(u, 16, 241);
+    cv::randu(v, 16, 241);
+    y(cv::Rect(0, 0, 2, 2)) = 81; // BT.601 red
+    u(cv::Rect(0, 0, 1, 1)) = 90;
+    v(cv::Rect(0, 0, 1, 1)) = 240;
+
+    cv::Mat2b uv, vu;
+    cv::merge(std::vector<cv::Mat>{ u, v }, uv);
+    cv::merge(std::vector<cv::Mat>{ v, u }, vu);
+
+    const std::vector<drishti::core::YUV420> frames{
+        drishti::core::YUV420::nv12(y, uv),
+        drishti::core::YUV420::nv21(y, vu),
+        drishti::core::YUV420::i420(y, u, v)
+    };
+
+    using Channel = drishti::core::YUV420::Channel;
+    std::vector<cv::Mat1b> reference;
+    for (const auto& frame : frames)
+    {
+        std::vector<cv::Mat1b> dst{ cv::Mat1b(size), cv::Mat1b(size), cv::Mat1b(size), cv::Mat1b(size) };
+        std::vector<drishti::core::PlaneInfo> table{
+            { dst[0], Channel::kRed }, { dst[1], Channel::kGreen }, { dst[2], Channel::kBlue }, { dst[3], Channel::kGray }
+        };
+        drishti::core::unpack(frame, table);
+
+        ASSERT_GE(dst[0](0, 0), 250);
+        ASSERT_LE(dst[1](0, 0), 5);
+        ASSERT_LE(dst[2](0, 0), 5);
+        ASSERT_EQ(dst[3](1, 1), uint8_t(std::round((81 - 16) * 255.0 / 219.0)));
+
+        if (reference.empty())
+        {
+            reference = dst;
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            ASSERT_EQ(cv::countNonZero(dst[i] != reference[i]), 0); // all layouts agree
+        }
+
+        cv::Mat1f gray(size);
+        std::vector<drishti::core::PlaneInfo> grayTable{ { gray, Channel::kGray, 1.f / 255.f } };
+        drishti::core::convertU8ToF32(frame, grayTable);
+
+        cv::Mat1f expected;
+        reference[3].convertTo(expected, CV_32F, 1.f / 255.f);
+        ASSERT_LE(cv::norm(gray, expected, cv::NORM_INF), 1e-6);
+    }
+}
+
+// Every variant supported by this CPU must match the C reference (exactly for integers):
+TEST(ArithmeticKernels, variants_match_reference)
+{
+    const auto variants = drishti::core::getArithmeticKernelVariants();
+    const auto& reference = *variants.front();
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> uniform(-2.f, 2.f);
+    const auto near = [](const std::vector<float>& a, const std::vector<float>& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), [](float x, float y) { return std::abs(x - y) <= 1e-5f * (1.f + std::abs(x)); });
+    };
+
+    for (const auto* kernels : variants)
+    {
+        for (int n : { 0, 1, 7, 8, 15, 16, 17, 33, 100 }) // all head and tail combinations
+        {
+            std::vector<float> a(n), b(n), c0(n), c1(n);
+            std::vector<int16_t> s(n), t(n), u0(n), u1(n);
+            std::vector<int32_t> w(n), w0(n), w1(n);
+            std::vector<int8_t> q(n);
+            for (int i = 0; i < n; i++)
+            {
+                a[i] = uniform(rng) * ((i % 5) ? 1.f : 1e4f); // exercise saturation
+                b[i] = uniform(rng);
+                s[i] = int16_t(rng());
+                t[i] = int16_t(rng());
+                w[i] = int32_t(rng() % 100000) - 50000;
+                q[i] = int8_t(rng());
+            }
+
+            reference.add32f(a.data(), b.data(), c0.data(), n);
+            kernels->add32f(a.data(), b.data(), c1.data(), n);
+            ASSERT_EQ(c0, c1) << kernels->name;
+
+            reference.add16sAnd16s(s.data(), t.data(), u0.data(), n);
+            kernels->add16sAnd16s(s.data(), t.data(), u1.data(), n);
+            ASSERT_EQ(u0, u1) << kernels->name;
+
+            reference.add16sAnd32s(w.data(), s.data(), w0.data(), n);
+            kernels->add16sAnd32s(w.data(), s.data(), w1.data(), n);
+            ASSERT_EQ(w0, w1) << kernels->name;
+
+            reference.convertFixedPoint(a.data(), u0.data(), n, 10);
+            kernels->convertFixedPoint(a.data(), u1.data(), n, 10);
+            ASSERT_EQ(u0, u1) << kernels->name;
+
+            reference.convert32sTo32f(w.data(), c0.data(), n, 1.f / 1024.f);
+            kernels->convert32sTo32f(w.data(), c1.data(), n, 1.f / 1024.f);
+            ASSERT_EQ(c0, c1) << kernels->name;
+
+            c0 = c1 = b;
+            reference.addScaled32f(a.data(), 0.3f, c0.data(), n);
+            kernels->addScaled32f(a.data(), 0.3f, c1.data(), n);
+            ASSERT_TRUE(near(c0, c1)) << kernels->name;
+
+            c0 = c1 = b;
+            reference.addScaled16sTo32f(s.data(), 0.3f, c0.data(), n);
+            kernels->addScaled16sTo32f(s.data(), 0.3f, c1.data(), n);
+            ASSERT_TRUE(near(c0, c1)) << kernels->name;
+
+            c0 = c1 = b;
+            reference.addScaled8sTo32f(q.data(), 0.3f, c0.data(), n);
+            kernels->addScaled8sTo32f(q.data(), 0.3f, c1.data(), n);
+            ASSERT_TRUE(near(c0, c1)) << kernels->name;
+
+            const float d0 = reference.dot32f(b.data(), b.data(), n);
+            const float d1 = kernels->dot32f(b.data(), b.data(), n);
+            ASSERT_NEAR(d0, d1, 1e-4f * (1.f + d0)) << kernels->name;
+        }
+    }
+}
+
+TEST(TraceRecorder, ring_buffer)
+{
+    drishti::core::TraceRecorder recorder(4);
+    drishti::core::TraceRecorder::setActive(&recorder);
+
+    for (int i = 0; i < 6; i++)
+    {
+        drishti::core::TraceRecorder::setFrameIndex(i);
+        drishti::core::ScopeTimeLogger logger("stage", [](double) {});
+    }
+    drishti::core::TraceRecorder::setActive(nullptr);
+
+    // Only the most recent events are retained:
+    const auto events = recorder.getEvents();
+    ASSERT_EQ(events.size(), 4);
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(events[i].frameIndex, i + 2);
+        ASSERT_LE(events[i].begin, events[i].end);
+    }
+
+    std::stringstream ss;
+    recorder.dump(ss);
+    ASSERT_NE(ss.str().find("\"traceEvents\""), std::string::npos);
+    ASSERT_NE(ss.str().find("\"name\":\"stage\""), std::string::npos);
+}
+
+TEST(PixelGather, gather_affine_u8)
+{
+    cv::Mat1b image(7, 9);
+    cv::randu(image, 0, 255);
+
+    // Include off image and half pixel (rounding) locations, with a tail beyond the SIMD width:
+    const std::vector<float> x = { 0.f, 1.5f, 2.49f, -0.4f, -0.6f, 8.4f, 8.6f, 3.f, 4.f, 5.f, 6.2f };
+    const std::vector<float> y = { 0.f, 0.5f, 3.5f, 1.f, 2.f, 6.4f, 2.f, 6.6f, -2.f, 1.f, 5.8f };
+    const float H[6] = { 1.f, 0.f, 0.f, 0.f, 1.f, 0.f };
+
+    std::vector<float> values(x.size()), expected(x.size());
+    for (int i = 0; i < x.size(); i++)
+    {
+        const int xi = int(std::floor(x[i] + 0.5f)), yi = int(std::floor(y[i] + 0.5f));
+        const bool inside = (xi >= 0) && (yi >= 0) && (xi < image.cols) && (yi < image.rows);
+        expected[i] = inside ? float(image(yi, xi)) : 0.f;
+    }
+
+    drishti::core::gatherU8(image.ptr(), image.step, image.cols, image.rows, x.data(), y.data(), values.data(), int(x.size()));
+    ASSERT_EQ(values, expected);
+
+    std::fill(values.begin(), values.end(), -1.f);
+    drishti::core::gatherAffineU8(image.ptr(), image.step, image.cols, image.rows, H, x.data(), y.data(), values.data(), int(x.size()));
+    ASSERT_EQ(values, expected);
+
+    // Off image samples take the background value (i.e., CPR reads the top left pixel):
+    const float background = image(0, 0);
+    drishti::core::gatherAffineU8(image.ptr(), image.step, image.cols, image.rows, H, x.data(), y.data(), values.data(), int(x.size()), background);
+    for (int i = 0; i < x.size(); i++)
+    {
+        const int xi = int(std::floor(x[i] + 0.5f)), yi = int(std::floor(y[i] + 0.5f));
+        const bool inside = (xi >= 0) && (yi >= 0) && (xi < image.cols) && (yi < image.rows);
+        EXPECT_EQ(values[i], inside ? expected[i] : background);
+    }
+}
+
+TEST(WorkerTeam, fork_join)
+{
+    drishti::core::WorkerTeam team(4);
+    ASSERT_EQ(team.size(), 4);
+
+    for (int step = 0; step < 100; step++)
+    {
+        std::vector<int> hits(team.size(), 0);
+        int total = 0;
+        auto task = [&](int worker) { hits[worker]++; };
+        auto join = [&]() { total = std::accumulate(hits.begin(), hits.end(), 0); };
+        ASSERT_TRUE(team.tryRun(task, join));
+        ASSERT_EQ(total, team.size());
+    }
+
+    // Nested steps are rejected (the caller runs the work itself):
+    bool nested = true;
+    team.tryRun([&](int worker) {
+        if (worker == 0)
+        {
+            nested = team.tryRun([](int) {});
+        }
+    });
+    ASSERT_FALSE(nested);
+}
+
+TEST(SplineBasis, interpolates_control_points)
+{
+    // Closed contour: sample i * factor lies on control point i (uniform knots):
+    const int points = 16, factor = 4;
+    drishti::core::PointVec contour(points), spline;
+    for (int i = 0; i < points; i++)
+    {
+        const float theta = float(i) * 2.f * float(M_PI) / float(points);
+        contour[i] = { 100.f + 40.f * std::cos(theta), 50.f + 20.f * std::sin(theta) };
+    }
+
+    const auto& basis = drishti::core::SplineBasis::get(points, points * factor, true);
+    ASSERT_EQ(&basis, &drishti::core::SplineBasis::get(points, points * factor, true));
+
+    basis(contour, spline);
+    ASSERT_EQ(spline.size(), points * factor);
+    for (int i = 0; i < points; i++)
+    {
+        EXPECT_LE(cv::norm(spline[i * factor] - contour[i]), 1e-3);
+    }
+}
+
+TEST(ModelCache, shares_until_released)
+{
+    struct Model
+    {
+        int value = 0;
+    };
+    using Cache = drishti::core::ModelCache<Model>;
+
+    int loads = 0;
+    auto loader = [&loads]() {
+        loads++;
+        return drishti::core::make_unique<Model>();
+    };
+
+    auto a = Cache::get("model", loader);
+    auto b = Cache::get("model", loader);
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(loads, 1);
+    ASSERT_EQ(Cache::size(), 1u);
+
+    a.reset();
+    b.reset();
+    ASSERT_EQ(Cache::size(), 0u);
+    Cache::get("model", loader);
+    ASSERT_EQ(loads, 2);
+}
+
+TEST(ResultsCache, content_keys)
+{
+    cv::Mat image(32, 40, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+
+    // Submatrices hash like continuous copies, settings and pixels change the key:
+    const cv::Mat roi = image(cv::Rect(3, 4, 20, 10));
+    EXPECT_EQ(drishti::core::hashImage(roi, 1), drishti::core::hashImage(roi.clone(), 1));
+    EXPECT_NE(drishti::core::hashImage(roi, 1), drishti::core::hashImage(roi, 2));
+    const std::uint64_t key = drishti::core::hashImage(image, 1);
+    image.at<cv::Vec3b>(31, 39)[2] ^= 1;
+    EXPECT_NE(key, drishti::core::hashImage(image, 1));
+
+    drishti::core::ResultsCache<std::string> cache;
+    std::string value;
+    EXPECT_FALSE(cache.find(key, value));
+    cache.insert(key, "faces");
+    cache.insert(key, "other");
+    ASSERT_TRUE(cache.find(key, value));
+    EXPECT_EQ(value, "faces");
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.hits(), 1u);
+}
+
+TEST(FlatArchive, round_trip)
+{
+    std::vector<float> leaves(1000);
+    std::iota(leaves.begin(), leaves.end(), 0.f);
+    const std::vector<int16_t> codes = { 1, -2, 3 };
+
+    drishti::core::FlatArchiveWriter writer;
+    writer.add("leaves", leaves);
+    writer.add("codes", codes);
+    writer.addScalar("bits", int32_t(16));
+    writer.addString("meta", "shape");
+
+    std::stringstream ss;
+    writer.save(ss);
+    ASSERT_TRUE(drishti::core::FlatArchive::isFlat(ss));
+
+    auto archive = drishti::core::FlatArchive::read(ss);
+    ASSERT_EQ(archive->getScalar<int32_t>("bits"), 16);
+    ASSERT_EQ(archive->getString("meta"), "shape");
+    ASSERT_FALSE(archive->has("missing"));
+
+    std::size_t count = 0;
+    const float* values = archive->get<float>("leaves", count);
+    ASSERT_EQ(count, leaves.size());
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(values) % drishti::core::FlatArchive::kAlignment, 0u);
+    ASSERT_TRUE(std::equal(leaves.begin(), leaves.end(), values));
+
+    const int16_t* packed = archive->get<int16_t>("codes", count);
+    ASSERT_TRUE(std::equal(codes.begin(), codes.end(), packed));
+    ASSERT_THROW(archive->get<int32_t>("codes", count), std::exception); // element size mismatch
+}
+
+TEST(CompressedStream, round_trip)
+{
+    // Several blocks of compressible model data:
+    std::vector<float> weights(3 * drishti::core::CompressedInputStream::kBlockSize / sizeof(float));
+    for (std::size_t i = 0; i < weights.size(); i++)
+    {
+        weights[i] = float(i % 1000) * 0.25f;
+    }
+
+    std::stringstream raw, packed;
+    save_cpb(raw, weights);
+    drishti::core::compress(raw, packed);
+    ASSERT_TRUE(drishti::core::isCompressed(packed));
+    ASSERT_FALSE(drishti::core::isCompressed(raw));
+    ASSERT_LT(packed.str().size(), raw.str().size() / 2);
+
+    std::vector<float> loaded;
+    load_cpb(packed, loaded); // decoded transparently
+    ASSERT_EQ(loaded, weights);
+
+    // Seeks within and across blocks (i.e., for readers that peek at a header):
+    packed.clear();
+    packed.seekg(0);
+    drishti::core::CompressedInputStream is(packed);
+    const std::string bytes = raw.str();
+    for (std::size_t position : { std::size_t(2000000), std::size_t(17), bytes.size() - 1 })
+    {
+        char c = 0;
+        is.seekg(position);
+        ASSERT_TRUE(is.get(c));
+        ASSERT_EQ(c, bytes[position]);
+    }
+}
+
+TEST(CsvReader, quoted_fields_and_chunks)
+{
+    const std::string text = "name, x ,y\r\nfoo,1,2.5\r\n\n\"a, \"\"b\"\"\nc\",3,4\n  bar ,-7,1e3\n";
+    const drishti::core::CsvReader reader(text.data(), text.size());
+    ASSERT_EQ(reader.rows(), 4u);
+    ASSERT_EQ(reader.getColumnIndex("x"), 1);
+    ASSERT_EQ(reader.getColumnIndex("z"), -1);
+    EXPECT_EQ(reader(2, 0).str(), "a, \"b\"\nc");
+    EXPECT_EQ(reader(3, 0).str(), "bar");
+    EXPECT_EQ(reader.getColumn<int>(1), std::vector<int>({ 1, 3, -7 }));
+    EXPECT_EQ(reader.getColumn<float>(2), std::vector<float>({ 2.5f, 4.f, 1000.f }));
+    EXPECT_THROW(reader.getColumn<int>(0), std::exception);
+
+    // Large enough for several parallel chunks, with newlines in quoted fields:
+    std::string big;
+    const int rows = 400000;
+    for (int i = 0; i < rows; i++)
+    {
+        big += "image_" + std::to_string(i) + ",\"tag,\n" + std::to_string(i) + "\"," + std::to_string(i / 2) + "\n";
+    }
+    ASSERT_GT(big.size(), 2 * drishti::core::CsvReader::kChunkSize);
+
+    drishti::core::Executor executor;
+    const drishti::core::CsvReader chunked(big.data(), big.size(), &executor);
+    ASSERT_EQ(chunked.rows(), std::size_t(rows));
+    const auto values = chunked.getColumn<int>(2, 0);
+    for (int i = 0; i < rows; i++)
+    {
+        ASSERT_EQ(values[i], i / 2);
+        ASSERT_EQ(chunked(i, 1).str(), "tag,\n" + std::to_string(i));
+    }
+}
+
+TEST(Executor, nested_parallel_for)
+{
+    drishti::core::Executor::Options options;
+    options.threads = 2;
+    drishti::core::Executor executor(options);
+    ASSERT_EQ(executor.size(), 2);
+
+    // Tasks that fork from inside the executor must not wait on their own helpers:
+    std::vector<int> values(64, 0);
+    auto outer = [&](int i) {
+        drishti::core::parallel_for(&executor, 8, [&](int j) { values[i * 8 + j] = i * 8 + j; });
+    };
+    auto result = executor.process([&]() {
+        drishti::core::parallel_for(&executor, 8, outer);
+        return executor.getWorkerIndex();
+    }, drishti::core::Executor::kBackground);
+
+    ASSERT_GE(result.get(), 0);
+    ASSERT_EQ(executor.getWorkerIndex(), -1);
+    for (int i = 0; i < int(values.size()); i++)
+    {
+        ASSERT_EQ(values[i], i);
+    }
+}
+
+TEST(ThreadLocalParallelResource, one_value_per_thread)
+{
+    std::atomic<int> count{ 0 };
+    drishti::core::ThreadLocalParallelResource<std::shared_ptr<int>> resource = [&]() {
+        return std::make_shared<int>(count++);
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&]() {
+            int* first = resource.get().get();
+            for (int j = 0; j < 100; j++)
+            {
+                ASSERT_EQ(resource.get().get(), first);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(&resource.get(), &resource[std::this_thread::get_id()]);
+    ASSERT_EQ(resource.getMap().size(), 5u);
+    ASSERT_EQ(count, 5);
+}
+
+TEST(ThreadLocalParallelResource, recycled_slots)
+{
+    using Resource = drishti::core::ThreadLocalParallelResource<int>;
+
+    // Slots of destroyed resources are reused, and their cached values are not:
+    const std::size_t slots = drishti::core::getThreadLocalSlots().size();
+    for (int i = 0; i < 100; i++)
+    {
+        Resource resource = [i]() { return i; };
+        ASSERT_EQ(resource.get(), i);
+    }
+    ASSERT_LE(drishti::core::getThreadLocalSlots().size(), slots + 1);
+
+    // The values cached by the source stay valid in the moved resource:
+    Resource source = []() { return 1; };
+    int* value = &source.get();
+    Resource target(std::move(source));
+    ASSERT_EQ(&target.get(), value);
+    ASSERT_EQ(target.getMap().size(), 1u);
+}
+
+TEST(FrameArena, steady_state_without_heap_allocations)
+{
+    drishti::core::FrameArena arena(64);
+
+    // A frame with a few vectors and crops that overflows the initial block:
+    auto frame = [&]() {
+        arena.reset();
+        drishti::core::ArenaVector<float> values(arena);
+        values.resize(1000, 1.f);
+        drishti::core::ArenaVector<int> indices(arena);
+        for (int i = 0; i < 100; i++)
+        {
+            indices.push_back(i);
+        }
+        auto* crop = arena.allocate<std::uint8_t>(64 * 64);
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(crop) % drishti::core::FrameArena::kAlignment, 0u);
+        ASSERT_EQ(indices.back(), 99);
+    };
+
+    frame();
+    frame(); // coalesced to one block
+    const std::size_t warm = arena.getHeapAllocations();
+    for (int i = 0; i < 10; i++)
+    {
+        frame();
+    }
+    ASSERT_EQ(arena.getHeapAllocations(), warm);
+    ASSERT_GE(arena.capacity(), arena.size());
+}
+
+TEST(Padding, fast_fill_in_place)
+{
+    cv::Mat3b canvas(64, 96, cv::Vec3b(0, 0, 0));
+    cv::Mat3b image = canvas(cv::Rect(16, 8, 64, 48));
+    image.setTo(cv::Vec3b(10, 20, 30));
+
+    // The image is a view with room for the border, so the parent is padded without a copy:
+    cv::Mat padded;
+    const cv::Point tl = drishti::core::pad(image, padded, 8, 8, 16, 16, drishti::core::kPaddingFast, true);
+    ASSERT_EQ(tl, cv::Point(16, 8));
+    ASSERT_EQ(padded.data, canvas.data);
+    ASSERT_EQ(padded.size(), canvas.size());
+
+    // A constant image extends to a constant border:
+    ASSERT_EQ(cv::countNonZero(cv::Mat(canvas != cv::Scalar(10, 20, 30)).reshape(1)), 0);
+
+    // Otherwise the image is copied once into a new buffer:
+    cv::Mat copy;
+    drishti::core::pad(image, copy, 8, 8, 16, 16, drishti::core::kPaddingConstant);
+    ASSERT_NE(copy.data, canvas.data);
+    ASSERT_EQ(copy.size(), cv::Size(96, 64));
+    ASSERT_EQ(copy.at<cv::Vec3b>(0, 0), cv::Vec3b(0, 0, 0));
+    ASSERT_EQ(copy.at<cv::Vec3b>(8, 16), cv::Vec3b(10, 20, 30));
+}
+
+TEST(Metrics, latency_percentiles)
+{
+    drishti::core::Metrics metrics;
+    auto& histogram = metrics.histogram("stage");
+    ASSERT_EQ(&histogram, &metrics.histogram("stage"));
+
+    // 1..1000 microseconds:
+    for (int i = 1; i <= 1000; i++)
+    {
+        histogram.record(double(i) * 1e-6);
+    }
+
+    {
+        drishti::core::ScopeTimeLogger logger("scope", metrics.histogram("scope"));
+    }
+    metrics.counter("frames").add(2);
+    metrics.gauge("fps").set(30.0);
+
+    const auto snapshot = metrics.getSnapshot();
+    ASSERT_EQ(snapshot.counters.size(), 1u);
+    ASSERT_EQ(snapshot.counters[0].second, 2u);
+    ASSERT_EQ(snapshot.gauges[0].second, 30.0);
+    ASSERT_EQ(snapshot.histograms.size(), 2u);
+    ASSERT_EQ(snapshot.histograms[0].name, "scope");
+    ASSERT_EQ(snapshot.histograms[0].count, 1u);
+
+    const auto& stage = snapshot.histograms[1];
+    ASSERT_EQ(stage.count, 1000u);
+    ASSERT_NEAR(stage.mean, 500.5e-6, 1e-9);
+    ASSERT_NEAR(stage.min, 1e-6, 1e-12);
+    ASSERT_NEAR(stage.max, 1e-3, 1e-12);
+    ASSERT_NEAR(stage.p50, 500e-6, 500e-6 * 0.03);
+    ASSERT_NEAR(stage.p95, 950e-6, 950e-6 * 0.03);
+    ASSERT_NEAR(stage.p99, 990e-6, 990e-6 * 0.03);
+
+    metrics.reset();
+    ASSERT_EQ(histogram.getCount(), 0u);
+}
+
+TEST(ScopeTimer, inlined_callback_and_histogram)
+{
+    using drishti::core::kTimingPipeline;
+
+    drishti::core::Metrics metrics;
+    auto& histogram = metrics.histogram("scope");
+
+    int calls = 0;
+    double elapsed = -1.0;
+    {
+        auto timer = drishti::core::makeScopeTimer<kTimingPipeline>("scope", histogram, [&](double t) {
+            calls++;
+            elapsed = t;
+        });
+        auto moved = std::move(timer); // reported once
+    }
+
+    if (drishti::core::TimingEnabled<kTimingPipeline>::value)
+    {
+        ASSERT_EQ(calls, 1);
+        ASSERT_GE(elapsed, 0.0);
+        ASSERT_EQ(histogram.getCount(), 1u);
+    }
+    else
+    {
+        ASSERT_EQ(calls, 0);
+        ASSERT_EQ(histogram.getCount(), 0u);
+    }
+}
+
+TEST(MemoryUsage, shared_buffers_are_counted_once)
+{
+    cv::Mat image(64, 64, CV_8UC1);
+    std::vector<cv::Mat> views = { image, image(cv::Rect(0, 0, 32, 32)), cv::Mat(16, 16, CV_32FC1) };
+    ASSERT_EQ(drishti::core::getMemoryUsage(views), std::size_t(64 * 64 + 16 * 16 * 4));
+
+    drishti::core::MemoryUsage detector;
+    detector.add("classifier", 1024);
+
+    drishti::core::MemoryUsage usage;
+    usage.add("detector", detector);
+    usage.add("fifo", 0, drishti::core::getTextureMemoryUsage(640, 480, 3));
+    ASSERT_EQ(usage.items.size(), 2u);
+    ASSERT_EQ(usage.items[0].name, "detector/classifier");
+    ASSERT_EQ(usage.cpu(), 1024u);
+    ASSERT_EQ(usage.gpu(), std::size_t(640 * 480 * 4 * 3));
+}
+
+TEST(TrainingReport, one_line_per_cascade)
+{
+    std::stringstream ss;
+    drishti::core::TrainingReport report("trainer", &ss);
+    for (int cascade = 0; cascade < 2; cascade++)
+    {
+        report.beginCascade(cascade);
+        {
+            auto timer = report.time("features");
+        }
+        report.getMetrics().counter("samples").add(10);
+        report.endCascade();
+    }
+
+    std::string line;
+    ASSERT_TRUE(std::getline(ss, line));
+    ASSERT_EQ(line.find("{\"trainer\":\"trainer\",\"cascade\":0,"), 0u);
+    ASSERT_NE(line.find("\"phases\":{\"features\":"), std::string::npos);
+    ASSERT_NE(line.find("\"samples\":10}"), std::string::npos);
+    ASSERT_TRUE(std::getline(ss, line));
+    ASSERT_NE(line.find("\"cascade\":1,"), std::string::npos);
+    ASSERT_NE(line.find("\"samples\":10}"), std::string::npos); // reset after each cascade
+    ASSERT_FALSE(std::getline(ss, line));
+}
+
+TEST(RingQueue, spsc_and_mpmc_preserve_values)
+{
+    static const int kCount = 100000;
+
+    {
+        drishti::core::SPSCQueue<int> queue(100);
+        ASSERT_EQ(queue.capacity(), 128u);
+
+        std::thread producer([&]() {
+            for (int i = 0; i < kCount; i++)
+            {
+                queue.push(int(i));
+            }
+        });
+
+        for (int i = 0; i < kCount; i++)
+        {
+            int value = -1;
+            queue.pop(value);
+            ASSERT_EQ(value, i); // FIFO
+        }
+        producer.join();
+        ASSERT_TRUE(queue.empty());
+    }
+
+    {
+        drishti::core::MPMCQueue<int> queue(64);
+        std::atomic<long long> sum{ 0 };
+        std::atomic<int> received{ 0 };
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; i++)
+        {
+            threads.emplace_back([&, i]() {
+                for (int j = i; j < kCount; j += 4)
+                {
+                    queue.push(int(j));
+                }
+            });
+            threads.emplace_back([&]() {
+                int value = 0;
+                while (received < kCount)
+                {
+                    if (queue.tryPop(value))
+                    {
+                        sum += value;
+                        received++;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        ASSERT_EQ(sum.load(), (static_cast<long long>(kCount) * (kCount - 1)) / 2);
+        ASSERT_TRUE(queue.empty());
+    }
+}
+
 END_EMPTY_NAMESPACE
+
+TEST(ShaderFilters, binomial_and_saturation)
+{
+    const int width = 37, height = 11, channels = 4;
+    std::mt19937 rng(1);
+    std::vector<uint8_t> image(width * height * channels);
+    for (auto& value : image)
+    {
+        value = static_cast<uint8_t>(rng() % 256);
+    }
+
+    // Reference: direct 3x3 convolution with clamped coordinates, rounded half up:
+    const auto at = [&](int x, int y, int c) {
+        x = std::min(std::max(x, 0), width - 1);
+        y = std::min(std::max(y, 0), height - 1);
+        return int(image[(y * width + x) * channels + c]);
+    };
+    const int w[3] = { 1, 2, 1 };
+    std::vector<uint8_t> expected(image.size());
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                int sum = 0;
+                for (int j = -1; j <= 1; j++)
+                {
+                    for (int i = -1; i <= 1; i++)
+                    {
+                        sum += w[i + 1] * w[j + 1] * at(x + i, y + j, c);
+                    }
+                }
+                expected[(y * width + x) * channels + c] = static_cast<uint8_t>((sum + 8) / 16);
+            }
+        }
+    }
+
+    std::vector<uint8_t> output(image.size());
+    drishti::core::binomial3x3U8(image.data(), width * channels, output.data(), width * channels, width, height, channels);
+    EXPECT_EQ(output, expected);
+
+    // In place:
+    auto copy = image;
+    drishti::core::binomial3x3U8(copy.data(), width * channels, copy.data(), width * channels, width, height, channels);
+    EXPECT_EQ(copy, expected);
+
+    // White is saturated (d = 1), black is not (d = 0):
+    const uint8_t pixels[8] = { 255, 255, 255, 7, 0, 0, 0, 9 };
+    uint8_t result[8];
+    drishti::core::saturationU8C4(pixels, 8, result, 8, 2, 1, 1.f);
+    EXPECT_EQ(result[0], 255);
+    EXPECT_EQ(result[3], 255);
+    EXPECT_EQ(result[4], 0);
+    EXPECT_EQ(result[7], 255);
+}
@@ -12,6 +12,9 @@
 #include "drishti/ContextImpl.h"
 #include "drishti/SensorImpl.h"
 
+#include <functional>
+#include <sstream>
+
 #define DRISHTI_LOGGER_NAME "drishti"
 
 _DRISHTI_SDK_BEGIN
@@ -19,8 +22,36 @@ _DRISHTI_SDK_BEGIN
 Context::Impl::Impl(drishti::sdk::SensorModel& sensor)
     : sensor(sensor.getImpl()->sensor)
     , logger(drishti::core::Logger::create(DRISHTI_LOGGER_NAME))
-    , threads(std::make_shared<tp::ThreadPool<>>()) // thread-pool
+    , threads(drishti::core::Executor::getInstance()) // thread-pool
+    , metrics(&drishti::core::Metrics::getInstance())
+    , gpuScheduler(std::make_shared<drishti::hci::GpuScheduler>())
+{
+}
+
+Context::Impl::FaceDetectorFactoryPtr
+Context::Impl::getModels(std::istream* iFaceDetector, std::istream* iFaceRegressor, std::istream* iEyeRegressor, std::istream* iFaceModel)
 {
+    using drishti::face::FaceDetectorFactoryShared;
+
+    const std::string faceDetector = FaceDetectorFactoryShared::read(iFaceDetector);
+    const std::string faceRegressor = FaceDetectorFactoryShared::read(iFaceRegressor);
+    const std::string eyeRegressor = FaceDetectorFactoryShared::read(iEyeRegressor);
+    const std::string faceModel = FaceDetectorFactoryShared::read(iFaceModel);
+
+    std::stringstream key;
+    for (const auto& content : { &faceDetector, &faceRegressor, &eyeRegressor, &faceModel })
+    {
+        key << std::hash<std::string>()(*content) << ':' << content->size() << ';';
+    }
+
+    // Trackers are typically created together, so hold the lock while loading rather than loading twice:
+    std::lock_guard<std::mutex> lock(modelMutex);
+    auto& factory = models[key.str()];
+    if (!factory)
+    {
+        factory = std::make_shared<FaceDetectorFactoryShared>(faceDetector, faceRegressor, eyeRegressor, faceModel, threads);
+    }
+    return factory;
 }
 
 Context::Context(drishti::sdk::SensorModel& sensor)
@@ -130,4 +161,153 @@ bool Context::getDoOptimizedPipeline() const
     return impl->doOptimizedPipeline;
 }
 
+void Context::setHistoryScale(float value)
+{
+    impl->historyScale = value;
+}
+
+float Context::getHistoryScale() const
+{
+    return impl->historyScale;
+}
+
+void Context::setMaxFaces(int value)
+{
+    impl->maxFaces = value;
+}
+
+int Context::getMaxFaces() const
+{
+    return impl->maxFaces;
+}
+
+void Context::setGovernor(float frameRate, PowerStateCallback callback, void* context)
+{
+    impl->governorFrameRate = frameRate;
+    impl->powerCallback = callback;
+    impl->powerContext = context;
+}
+
+float Context::getGovernorFrameRate() const
+{
+    return impl->governorFrameRate;
+}
+
+void Context::Impl::apply(const Tuning& value)
+{
+    tuning = value;
+    faceFinderInterval = value.faceFinderInterval;
+    minTrackHits = value.minTrackHits;
+    maxTrackMisses = value.maxTrackMisses;
+    doOptimizedPipeline = value.doOptimizedPipeline;
+}
+
+void Context::Impl::resolveProfile(drishti::face::FaceDetectorFactory& factory)
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+    if (tuning.profile != Context::kProfileAuto)
+    {
+        return;
+    }
+
+    // The eye model dominates the per frame CPU cost:
+    auto estimator = factory.getEyeEstimator();
+    const float cost = estimator ? benchmark(*estimator) : 0.f;
+
+    Tuning selected = getTuning(estimator ? selectProfile(cost) : Context::kProfileBalanced);
+    selected.cost = cost;
+    apply(selected);
+
+    if (!profileFile.empty() && !writeTuning(profileFile, selected))
+    {
+        logger->warn("Context: unable to write profile {}", profileFile);
+    }
+}
+
+void Context::setProfile(Profile profile, const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(impl->profileMutex);
+
+    Tuning tuning = getTuning(profile);
+    if ((profile == kProfileAuto) && !filename.empty())
+    {
+        readTuning(filename, tuning); // a previous selection, if any
+    }
+
+    impl->profileFile = filename;
+    impl->apply(tuning);
+}
+
+Context::Profile Context::getProfile() const
+{
+    std::lock_guard<std::mutex> lock(impl->profileMutex);
+    return impl->tuning.profile;
+}
+
+std::string Context::getMetrics() const
+{
+    std::stringstream ss;
+    impl->metrics->dump(ss);
+    return ss.str();
+}
+
+void Context::resetMetrics()
+{
+    impl->metrics->reset();
+}
+
+static Context::Latency getLatency(drishti::core::Metrics& metrics, const char* name)
+{
+    const auto summary = metrics.histogram(name).getSummary();
+
+    Context::Latency latency;
+    latency.count = summary.count;
+    latency.mean = float(summary.mean);
+    latency.p50 = float(summary.p50);
+    latency.p95 = float(summary.p95);
+    latency.p99 = float(summary.p99);
+    latency.max = float(summary.max);
+    return latency;
+}
+
+Context::Performance Context::getPerformance() const
+{
+    auto& metrics = *impl->metrics;
+
+    Performance performance;
+    performance.frame = getLatency(metrics, "frame");
+    performance.faceDetection = getLatency(metrics, "face_detection");
+    performance.faceRegression = getLatency(metrics, "face_regression");
+    performance.eyeRegression = getLatency(metrics, "eye_regression");
+    performance.acfProcessing = getLatency(metrics, "acf_processing");
+    performance.gpuReadback = getLatency(metrics, "gpu_readback");
+    performance.capture = getLatency(metrics, "capture_latency");
+
+    performance.frames = performance.frame.count;
+    performance.detections = metrics.counter("detections").get();
+    performance.detectionRate = performance.frames ? float(double(performance.detections) / double(performance.frames)) : 0.f;
+    performance.faces = int(metrics.gauge("faces").get());
+    performance.droppedFrames = metrics.counter("dropped_frames").get();
+    performance.queueDepth = impl->threads ? impl->threads->getPending() : 0;
+    performance.hiddenCopies = metrics.counter("hidden_copies").get();
+    performance.qualityLevel = int(metrics.gauge("quality_level").get());
+    return performance;
+}
+
+Context::MemoryUsage Context::getMemoryUsage() const
+{
+    auto& metrics = *impl->metrics;
+    const auto bytes = [&](const char* name) { return static_cast<std::size_t>(metrics.gauge(name).get()); };
+
+    MemoryUsage usage;
+    usage.detector = bytes("memory_detector");
+    usage.faceRegressor = bytes("memory_face_regressor");
+    usage.eyeModels = bytes("memory_eye_models");
+    usage.pipelineCpu = bytes("memory_pipeline_cpu");
+    usage.pipelineGpu = bytes("memory_pipeline_gpu");
+    usage.cpu = usage.detector + usage.faceRegressor + usage.eyeModels + usage.pipelineCpu;
+    usage.gpu = usage.pipelineGpu;
+    return usage;
+}
+
 _DRISHTI_SDK_END
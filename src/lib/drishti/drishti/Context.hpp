@@ -20,7 +20,10 @@
 #include "drishti/Image.hpp"
 #include "drishti/Sensor.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
 
 _DRISHTI_SDK_BEGIN
 
@@ -64,6 +67,106 @@ public:
     void setDoOptimizedPipeline(bool flag);
     bool getDoOptimizedPipeline() const;
 
+    // Resolution of the frames grabbed by the tracker callbacks relative to the input (0..1],
+    // i.e., the display size over the capture size.  Face models of the grabbed frames are
+    // reported in the reduced coordinates:
+    void setHistoryScale(float value);
+    float getHistoryScale() const;
+
+    // Faces reported per frame in the tracker callback results (at most 2, the result capacity),
+    // the result storage is allocated once when the callbacks are registered:
+    void setMaxFaces(int value);
+    int getMaxFaces() const;
+
+    // Named performance profiles, applied to all subsequently created trackers:
+    enum Profile
+    {
+        kProfileCustom,      // the individual settings above (default)
+        kProfileLowPower,    // sparse detection, shorter cascades, smaller regression images
+        kProfileBalanced,    // periodic detection with the full models
+        kProfileMaxAccuracy, // detection on every frame, optical flow
+        kProfileAuto         // benchmark the device once, then one of the above
+    };
+
+    // Apply a profile (this overwrites the individual settings).  The profile chosen by
+    // kProfileAuto, with its settings, is stored in filename (if not empty) and later
+    // runs load it from there instead of repeating the benchmark:
+    void setProfile(Profile profile, const std::string& filename = {});
+
+    // The applied profile (kProfileAuto until the first FaceTracker runs the benchmark):
+    Profile getProfile() const;
+
+    // Platform thermal and battery state (i.e., from the OS notifications), see setGovernor():
+    struct PowerState
+    {
+        float thermal = 0.f;    // 0 : nominal, 1 : critical
+        float battery = 1.f;    // remaining charge 0..1
+        bool isCharging = true; // battery is ignored while charging
+    };
+
+    typedef PowerState (*PowerStateCallback)(void* context);
+
+    // Trackers created after this call hold frameRate (frames per second, 0 : disabled) by stepping
+    // through reduced quality levels (detection interval, cascade stages, eye flow, blobs and eye
+    // models) with hysteresis.  The level follows the measured frame times and the callback state
+    // (optional, polled about once per second from the tracking thread):
+    void setGovernor(float frameRate, PowerStateCallback callback = nullptr, void* context = nullptr);
+    float getGovernorFrameRate() const;
+
+    // Pipeline counters, gauges and latency percentiles (seconds) as a JSON object:
+    std::string getMetrics() const;
+    void resetMetrics();
+
+    // Latency distribution of a pipeline stage (seconds):
+    struct Latency
+    {
+        std::uint64_t count = 0;
+        float mean = 0.f;
+        float p50 = 0.f;
+        float p95 = 0.f;
+        float p99 = 0.f;
+        float max = 0.f;
+    };
+
+    // Pipeline performance summary for telemetry (accumulated since the last resetMetrics()):
+    struct Performance
+    {
+        Latency frame; // complete FaceTracker call
+        Latency faceDetection;
+        Latency faceRegression;
+        Latency eyeRegression;
+        Latency acfProcessing;
+        Latency gpuReadback; // ACF channel readback
+        Latency capture;     // VideoFrame::timestamp to result callbacks
+
+        std::uint64_t frames = 0;
+        std::uint64_t detections = 0;    // frames with a detection pass
+        float detectionRate = 0.f;       // detections / frames
+        int faces = 0;                   // tracked faces in the latest frame
+        std::uint64_t droppedFrames = 0; // late results discarded and frames rejected by submit()
+        int queueDepth = 0;              // thread pool tasks waiting to run
+        std::uint64_t hiddenCopies = 0;  // same format copies of client frames (i.e., stride compaction)
+        int qualityLevel = 0;            // governor level of the latest tracker (0 : full quality)
+    };
+
+    Performance getPerformance() const;
+
+    // Memory footprint in bytes of the most recently updated FaceTracker (refreshed after its
+    // first frame and every 256 frames), use it to compare configurations on a device:
+    struct MemoryUsage
+    {
+        std::size_t detector = 0;      // face detector (CPU)
+        std::size_t faceRegressor = 0; // face landmark model (CPU)
+        std::size_t eyeModels = 0;     // eyelid, iris and pupil models (CPU)
+        std::size_t pipelineCpu = 0;   // scene history, pyramids and other pipeline buffers
+        std::size_t pipelineGpu = 0;   // textures and buffers (estimated)
+
+        std::size_t cpu = 0; // total CPU heap
+        std::size_t gpu = 0; // total GPU (estimated)
+    };
+
+    MemoryUsage getMemoryUsage() const;
+
 protected:
     std::unique_ptr<Impl> impl;
 };
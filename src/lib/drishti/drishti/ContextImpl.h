@@ -12,13 +12,20 @@
 #define __drishti_drishti_ContextImpl_h__ 1
 
 #include "drishti/Context.hpp"
+#include "drishti/Profile.h"
 
 #include "drishti/hci/FaceFinder.h"
+#include "drishti/face/FaceDetectorFactory.h"
 #include "drishti/core/make_unique.h"
 #include "drishti/core/Logger.h" // spdlog::logger
 #include "drishti/sensor/Sensor.h"
 
-#include "thread_pool/thread_pool.hpp"
+#include "drishti/core/Executor.h"
+#include "drishti/core/Metrics.h"
+
+#include <map>
+#include <mutex>
+#include <string>
 
 #define DRISHTI_LOGGER_NAME "drishti"
 
@@ -30,8 +37,19 @@ _DRISHTI_SDK_BEGIN
 
 struct Context::Impl
 {
+    using FaceDetectorFactoryPtr = std::shared_ptr<drishti::face::FaceDetectorFactory>;
+
     Impl(drishti::sdk::SensorModel& sensor);
 
+    // Model set for the streams (keyed on their content), deserialized once and shared by all trackers:
+    FaceDetectorFactoryPtr getModels(std::istream* iFaceDetector, std::istream* iFaceRegressor, std::istream* iEyeRegressor, std::istream* iFaceModel);
+
+    // Apply the settings of a profile:
+    void apply(const Tuning& tuning);
+
+    // Replace kProfileAuto with the profile selected by a benchmark of the models (once):
+    void resolveProfile(drishti::face::FaceDetectorFactory& factory);
+
     bool doSingleFace = true;
     float minDetectionDistance = DEFAULT_MIN_DETECTION_DISTANCE;
     float maxDetectionDistance = DEFAULT_MAX_DETECTION_DISTANCE;
@@ -42,11 +60,28 @@ struct Context::Impl
     int maxTrackMisses = 1;
     float minFaceSeparation = 0.125f;
     bool doOptimizedPipeline = false;
+    float historyScale = 1.f;
+    int maxFaces = 2;
+
+    float governorFrameRate = 0.f; // 0 : no governor
+    Context::PowerStateCallback powerCallback = nullptr;
+    void* powerContext = nullptr;
 
     std::shared_ptr<drishti::sensor::SensorModel> sensor;
     std::shared_ptr<spdlog::logger> logger;
-    std::shared_ptr<tp::ThreadPool<>> threads;
+    std::shared_ptr<drishti::core::Executor> threads;
+    drishti::core::Metrics* metrics = nullptr; // process wide registry, fed by the FaceFinder
     void* glContext = nullptr;
+
+    // Interleaves the GPU passes of all trackers created in this context (i.e., one per stream):
+    std::shared_ptr<drishti::hci::GpuScheduler> gpuScheduler;
+
+    std::mutex modelMutex;
+    std::map<std::string, FaceDetectorFactoryPtr> models;
+
+    std::mutex profileMutex;
+    Tuning tuning;           // settings of the current profile
+    std::string profileFile; // kProfileAuto cache
 };
 
 _DRISHTI_SDK_END
@@ -13,6 +13,7 @@
 #include "drishti/core/drishti_stdlib_string.h"
 #include "drishti/core/drishti_cv_cereal.h"
 #include "drishti/ArrayCereal.h"
+#include "drishti/core/JsonStream.h"
 
 // clang-format off
 #ifdef DRISHTI_CEREAL_XML_JSON
@@ -177,6 +178,183 @@ std::istream& operator>>(std::istream& is, EyeIStream& eye)
     return is;
 }
 
+// ### Streaming JSON (same members and versions as the serialize() functions above) ###
+
+static void write(core::JsonWriter& os, const Vec2f& v)
+{
+    os.beginObject().version<Vec2f>(0);
+    os.key("x").value(v[0]);
+    os.key("y").value(v[1]);
+    os.endObject();
+}
+
+static void write(core::JsonWriter& os, const Size2f& s)
+{
+    os.beginObject().version<Size2f>(0);
+    os.key("width").value(s.width);
+    os.key("height").value(s.height);
+    os.endObject();
+}
+
+static void write(core::JsonWriter& os, const Recti& r)
+{
+    os.beginObject().version<Recti>(0);
+    os.key("x").value(r.x);
+    os.key("y").value(r.y);
+    os.key("width").value(r.width);
+    os.key("height").value(r.height);
+    os.endObject();
+}
+
+static void write(core::JsonWriter& os, const Eye::Ellipse& e)
+{
+    os.beginObject().version<Eye::Ellipse>(0);
+    os.key("center");
+    write(os, e.center);
+    os.key("size");
+    write(os, e.size);
+    os.key("angle").value(e.angle);
+    os.endObject();
+}
+
+static void write(core::JsonWriter& os, const Eye::ArrayVec2f& points)
+{
+    os.beginArray();
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+        write(os, points[i]);
+    }
+    os.endArray();
+}
+
+static void write(core::JsonWriter& os, const Eye& eye)
+{
+    os.beginObject().version<Eye>(1);
+    os.key("roi");
+    write(os, eye.getRoi());
+    os.key("eyelids");
+    write(os, eye.getEyelids());
+    os.key("crease");
+    write(os, eye.getCrease());
+    os.key("iris");
+    write(os, eye.getIris());
+    os.key("pupil");
+    write(os, eye.getPupil());
+    os.key("inner");
+    write(os, eye.getInnerCorner());
+    os.key("outer");
+    write(os, eye.getOuterCorner());
+    os.endObject();
+}
+
+static bool read(core::JsonReader& is, Vec2f& v)
+{
+    return core::readObject(is, [&](const core::JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "x") return core::read(is, v[0]);
+        if (key == "y") return core::read(is, v[1]);
+        // clang-format on
+        return is.skip();
+    });
+}
+
+static bool read(core::JsonReader& is, Size2f& s)
+{
+    return core::readObject(is, [&](const core::JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "width") return core::read(is, s.width);
+        if (key == "height") return core::read(is, s.height);
+        // clang-format on
+        return is.skip();
+    });
+}
+
+static bool read(core::JsonReader& is, Recti& r)
+{
+    return core::readObject(is, [&](const core::JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "x") return core::read(is, r.x);
+        if (key == "y") return core::read(is, r.y);
+        if (key == "width") return core::read(is, r.width);
+        if (key == "height") return core::read(is, r.height);
+        // clang-format on
+        return is.skip();
+    });
+}
+
+static bool read(core::JsonReader& is, Eye::Ellipse& e)
+{
+    return core::readObject(is, [&](const core::JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "center") return read(is, e.center);
+        if (key == "size") return read(is, e.size);
+        if (key == "angle") return core::read(is, e.angle);
+        // clang-format on
+        return is.skip();
+    });
+}
+
+// Points beyond the fixed capacity of the array are parsed and dropped:
+static bool read(core::JsonReader& is, Eye::ArrayVec2f& points)
+{
+    if (is.token() != core::JsonReader::kBeginArray)
+    {
+        return false;
+    }
+
+    std::size_t count = 0;
+    points.resize(points.limit());
+    while (is.next() != core::JsonReader::kEndArray)
+    {
+        Vec2f point;
+        if (!read(is, point))
+        {
+            return false;
+        }
+        if (count < points.size())
+        {
+            points[count++] = point;
+        }
+    }
+    points.resize(count);
+    return true;
+}
+
+static bool read(core::JsonReader& is, Eye& eye)
+{
+    return core::readObject(is, [&](const core::JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "roi") return read(is, eye.getRoi());
+        if (key == "eyelids") return read(is, eye.getEyelids());
+        if (key == "crease") return read(is, eye.getCrease());
+        if (key == "iris") return read(is, eye.getIris());
+        if (key == "pupil") return read(is, eye.getPupil());
+        if (key == "inner") return read(is, eye.getInnerCorner());
+        if (key == "outer") return read(is, eye.getOuterCorner());
+        // clang-format on
+        return is.skip();
+    });
+}
+
+std::string& toJson(const Eye& eye, std::string& buffer)
+{
+    buffer.clear();
+    core::JsonWriter os(buffer);
+    os.beginObject().key("eye");
+    write(os, eye);
+    os.endObject();
+    return buffer;
+}
+
+bool fromJson(const char* data, std::size_t size, Eye& eye)
+{
+    core::JsonReader is(data, size);
+    is.next();
+    return core::readObject(is, [&](const core::JsonReader::Key& key) -> bool {
+        return (key == "eye") ? read(is, eye) : is.skip();
+    });
+}
+
 std::ostream& operator<<(std::ostream& os, const Eye& eye)
 {
     os << "pupil: {" << eye.getPupil() << "}\n";
@@ -23,6 +23,7 @@
 
 #include <vector>
 #include <iostream>
+#include <string>
 
 _DRISHTI_SDK_BEGIN
 
@@ -64,6 +65,11 @@ struct DRISHTI_EXPORT EyeIStream : public EyeStream
 DRISHTI_EXPORT std::ostream& operator<<(std::ostream& os, const EyeOStream& eye);
 DRISHTI_EXPORT std::istream& operator>>(std::istream& is, EyeIStream& eye);
 
+// Streaming JSON without cereal archives (same schema as EyeStream::JSON), the buffer is cleared
+// first and its capacity is reused:
+DRISHTI_EXPORT std::string& toJson(const Eye& eye, std::string& buffer);
+DRISHTI_EXPORT bool fromJson(const char* data, std::size_t size, Eye& eye);
+
 _DRISHTI_SDK_END
 
 #endif // __drishti_drishti_EyeIO_hpp__
@@ -81,6 +81,16 @@ int EyeSegmenter::operator()(const Image3b& image, Eye& eye, bool isRight)
     return status;
 }
 
+int EyeSegmenter::operator()(std::vector<ImageEye>& eyes)
+{
+    return (*this)(eyes.data(), eyes.size());
+}
+
+int EyeSegmenter::operator()(ImageEye* eyes, std::size_t count)
+{
+    return (*m_impl)(eyes, count);
+}
+
 Eye EyeSegmenter::getMeanEye(int width) const
 {
     return m_impl->getMeanEye(width);
@@ -121,6 +131,36 @@ void EyeSegmenter::setOptimizationLevel(int level)
     m_impl->setOptimizationLevel(level);
 }
 
+void EyeSegmenter::calibrate(const Image3b& image, int iterations)
+{
+    m_impl->calibrate(image, iterations);
+}
+
+void EyeSegmenter::calibrate(int iterations)
+{
+    m_impl->calibrate({}, iterations);
+}
+
+void EyeSegmenter::setLatencyBudget(float milliseconds)
+{
+    m_impl->setLatencyBudget(milliseconds);
+}
+
+float EyeSegmenter::getLatencyBudget() const
+{
+    return m_impl->getLatencyBudget();
+}
+
+EyeSegmenter::Configuration EyeSegmenter::getConfiguration() const
+{
+    return m_impl->getConfiguration();
+}
+
+std::vector<EyeSegmenter::Configuration> EyeSegmenter::getConfigurations() const
+{
+    return m_impl->getConfigurations();
+}
+
 // ### utility ###
 
 static bool isArchiveSupported(ArchiveKind kind)
@@ -172,4 +212,12 @@ int drishti_eye_segmenter_segment(
 {
     return segmenter ? (*segmenter)(image, eye, isRight) : -1;
 }
+
+int drishti_eye_segmenter_segment_batch(
+    drishti::sdk::EyeSegmenter* segmenter,
+    drishti::sdk::EyeSegmenter::ImageEye* eyes,
+    std::size_t count)
+{
+    return segmenter ? (*segmenter)(eyes, count) : -1;
+}
 DRISHTI_EXTERN_C_END
@@ -16,8 +16,9 @@
 #include "drishti/Image.hpp"
 #include "drishti/Eye.hpp"
 
-#include <memory> // unique_ptr, shared_ptr
-#include <vector> // for eyelid contour
+#include <cstddef> // size_t
+#include <memory>  // unique_ptr, shared_ptr
+#include <vector>  // for eyelid contour
 
 _DRISHTI_SDK_BEGIN
 
@@ -52,6 +53,27 @@ public:
     explicit operator bool() const;
 
     int operator()(const Image3b& image, Eye& eye, bool isRight);
+
+    /**
+     * An eye crop and its segmentation for batch processing.
+     */
+    struct ImageEye
+    {
+        Image3b image;       //!< input eye crop (shallow)
+        bool isRight = true; //!< input eye side
+        Eye eye;             //!< output eye model
+        int status = 0;      //!< output status (0 : success)
+    };
+
+    /**
+     * Segment many crops on an internal thread pool: each worker uses a lightweight
+     * copy of the estimator that shares the models of this segmenter.  This never throws,
+     * failures are reported in ImageEye::status.  Calls must not overlap.
+     * @return the number of items that failed
+     */
+    int operator()(std::vector<ImageEye>& eyes);
+    int operator()(ImageEye* eyes, std::size_t count);
+
     Eye getMeanEye(int width) const;
 
     void setEyelidInits(int count);
@@ -64,6 +86,42 @@ public:
 
     void setOptimizationLevel(int level);
 
+    /**
+     * Eye model settings, as selected for a latency budget (see setLatencyBudget())
+     */
+    struct Configuration
+    {
+        int eyelidStages = -1;    //!< eyelid cascade stages (-1 : all)
+        int irisStages = -1;      //!< iris cascade stages (-1 : all)
+        int eyelidInits = 1;      //!< eyelid initializations
+        int irisInits = 1;        //!< iris initializations
+        bool useHierarchy = true; //!< median of iris initializations
+        int targetWidth = 128;    //!< eyes are downsampled to this width
+        float cost = 0.f;         //!< measured cost per eye in milliseconds (0 : not calibrated)
+    };
+
+    /**
+     * Measure the per eye cost of each configuration on this device.
+     * @param image representative eye image (a synthetic image is used if empty)
+     * @param iterations number of timed runs per configuration
+     */
+    void calibrate(const Image3b& image, int iterations = 3);
+    void calibrate(int iterations = 3);
+
+    /**
+     * Select the most accurate configuration whose measured cost fits the budget (or the
+     * cheapest one), calibrating on first use.
+     * @param milliseconds target latency per eye (<= 0 : restore the default configuration)
+     */
+    void setLatencyBudget(float milliseconds);
+    float getLatencyBudget() const;
+
+    //! The configuration in use
+    Configuration getConfiguration() const;
+
+    //! All configurations in order of decreasing accuracy (and cost)
+    std::vector<Configuration> getConfigurations() const;
+
     // Aspect ratio as width/height
     float getRequiredAspectRatio() const;
 
@@ -95,6 +153,12 @@ drishti_eye_segmenter_segment(
     const drishti::sdk::Image3b& image,
     drishti::sdk::Eye& eye, bool isRight);
 
+DRISHTI_EXPORT int
+drishti_eye_segmenter_segment_batch(
+    drishti::sdk::EyeSegmenter* segmenter,
+    drishti::sdk::EyeSegmenter::ImageEye* eyes,
+    std::size_t count);
+
 DRISHTI_EXTERN_C_END
 
 #endif /* defined(__drishti_drishti_EyeSegmenter_hpp__) */
@@ -16,13 +16,18 @@
 #include "drishti/eye/EyeModelEstimator.h"
 #include "drishti/core/Logger.h"
 #include "drishti/core/make_unique.h"
+#include "drishti/core/ParallelFor.h"
 
 // OpenCV inlucdes must come before drishti_cv.hpp
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include "drishti/drishti_cv.hpp" // Must come after opencvx
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <string>
+#include <thread>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -35,6 +40,10 @@
 _DRISHTI_SDK_BEGIN
 
 static std::string kindToHint(ArchiveKind kind);
+static std::vector<EyeSegmenter::Configuration> createConfigurations();
+
+// Index of the default (fast) configuration in createConfigurations():
+#define DEFAULT_CONFIGURATION 2
 
 EyeSegmenter::Impl::Impl(bool doLoad)
 {
@@ -58,9 +67,11 @@ void EyeSegmenter::Impl::init(std::istream& is, ArchiveKind kind)
 
     m_eme->setDoPupil(false);
     m_eme->setDoVerbose(false);
-    m_eme->setTargetWidth(128);
-    m_eme->setEyelidInits(1); // fast configuration:
-    m_eme->setIrisInits(1);
+
+    m_threads = core::Executor::getInstance();
+
+    m_configurations = createConfigurations();
+    apply(m_configurations[DEFAULT_CONFIGURATION]); // fast configuration
 
     //m_streamLogger = core::Logger::create("SEGMENT");
     m_eme->setStreamLogger(m_streamLogger);
@@ -69,6 +80,38 @@ void EyeSegmenter::Impl::init(std::istream& is, ArchiveKind kind)
 EyeSegmenter::Impl::~Impl() {}
 
 int EyeSegmenter::Impl::operator()(const Image3b& image, Eye& eye, bool isRight)
+{
+    return segment(*m_eme, image, eye, isRight);
+}
+
+int EyeSegmenter::Impl::operator()(ImageEye* eyes, std::size_t count)
+{
+    if (!m_pool)
+    {
+        m_pool = core::make_unique<EyeEstimatorPool>([this]() { return m_eme->clone(); });
+    }
+
+    // The calling thread participates with m_eme, pool workers use their own copy:
+    const auto caller = std::this_thread::get_id();
+    auto job = [&](int i) {
+        const auto& eme = (std::this_thread::get_id() == caller) ? *m_eme : *m_pool->get();
+        eyes[i].status = segment(eme, eyes[i].image, eyes[i].eye, eyes[i].isRight);
+    };
+
+    try
+    {
+        core::parallel_for(m_threads.get(), int(count), job);
+    }
+    catch (...)
+    {
+        // segment() reports failures in the status (i.e., an allocation failure in a clone):
+        std::cerr << "exception: EyeSegmenter::Impl::operator()" << std::endl;
+    }
+
+    return int(std::count_if(eyes, eyes + count, [](const ImageEye& e) { return e.status != 0; }));
+}
+
+int EyeSegmenter::Impl::segment(const eye::EyeModelEstimator& eme, const Image3b& image, Eye& eye, bool isRight)
 {
     int status = 0;
 
@@ -84,27 +127,16 @@ int EyeSegmenter::Impl::operator()(const Image3b& image, Eye& eye, bool isRight)
     try
     {
         // Create shallow copy of input image
-        cv::Mat3b I = drishtiToCv<Vec3b, cv::Vec3b>(image), If;
+        cv::Mat3b I = drishtiToCv<Vec3b, cv::Vec3b>(image);
 
-        // If input is left eye, we flop and must allocate a new image:
-        if (!isRight)
-        {
-            cv::flip(I, If, 1);
-        }
-        else
-        {
-            If = I;
-        }
+        // Left eyes are mirrored at the downsampled pyramid level, the result is in crop coordinates:
+        const auto pyramid = eme.createPyramid(I, !isRight);
 
         DRISHTI_EYE::EyeModel model;
-        status = (*m_eme)(If, model);
+        status = eme(pyramid, model);
 
-        if (!isRight)
-        {
-            model.flop(If.cols);
-        }
         model.refine();
-        model.roi = cv::Rect({ 0, 0 }, If.size()); // default roi
+        model.roi = cv::Rect({ 0, 0 }, I.size()); // default roi
         eye = convert(model);
     }
     catch (...)
@@ -136,6 +168,7 @@ int EyeSegmenter::Impl::getIrisInits() const
 void EyeSegmenter::Impl::setIrisInits(int count)
 {
     m_eme->setIrisInits(count); // not reentrant when > 1
+    m_pool.reset();
 }
 
 int EyeSegmenter::Impl::getEyelidInits() const
@@ -146,11 +179,104 @@ int EyeSegmenter::Impl::getEyelidInits() const
 void EyeSegmenter::Impl::setEyelidInits(int count)
 {
     m_eme->setEyelidInits(count); // not reentrant when > 1
+    m_pool.reset();
 }
 
 void EyeSegmenter::Impl::setOptimizationLevel(int level)
 {
     m_eme->setOptimizationLevel(level);
+    m_pool.reset();
+}
+
+void EyeSegmenter::Impl::apply(const Configuration& configuration)
+{
+    const auto stages = [](int count) { return (count < 0) ? std::numeric_limits<int>::max() : count; };
+    m_eme->setEyelidStagesHint(stages(configuration.eyelidStages));
+    m_eme->setIrisStagesHint(stages(configuration.irisStages));
+    m_eme->setEyelidInits(configuration.eyelidInits);
+    m_eme->setIrisInits(configuration.irisInits);
+    m_eme->setUseHierarchy(configuration.useHierarchy);
+    m_eme->setTargetWidth(configuration.targetWidth);
+    m_configuration = configuration;
+    m_pool.reset();
+}
+
+void EyeSegmenter::Impl::calibrate(const Image3b& image, int iterations)
+{
+    cv::Mat3b I;
+    if (image.getCols() && image.getRows())
+    {
+        I = drishtiToCv<Vec3b, cv::Vec3b>(image);
+    }
+    else
+    {
+        // Cost is dominated by the fixed stage and init counts, so texture is enough:
+        I.create(192, 256);
+        cv::randu(I, cv::Scalar::all(0), cv::Scalar::all(255));
+        cv::GaussianBlur(I, I, { 5, 5 }, 1.0);
+    }
+
+    const Configuration current = m_configuration;
+    for (auto& configuration : m_configurations)
+    {
+        apply(configuration);
+
+        DRISHTI_EYE::EyeModel warmup;
+        (*m_eme)(I, warmup);
+
+        const auto tic = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < std::max(iterations, 1); i++)
+        {
+            DRISHTI_EYE::EyeModel model;
+            (*m_eme)(I, model);
+        }
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - tic;
+        configuration.cost = elapsed.count() / float(std::max(iterations, 1));
+    }
+    m_isCalibrated = true;
+
+    apply(current);
+    if (m_latencyBudget > 0.f)
+    {
+        setLatencyBudget(m_latencyBudget);
+    }
+}
+
+void EyeSegmenter::Impl::setLatencyBudget(float milliseconds)
+{
+    m_latencyBudget = milliseconds;
+    if (milliseconds <= 0.f)
+    {
+        apply(m_configurations[DEFAULT_CONFIGURATION]);
+        return;
+    }
+
+    if (!m_isCalibrated)
+    {
+        calibrate({}, 3); // reentrant: applies the budget
+        return;
+    }
+
+    // Configurations are ordered by accuracy, fall back to the cheapest:
+    auto iter = std::find_if(m_configurations.begin(), m_configurations.end(), [&](const Configuration& c) {
+        return c.cost <= milliseconds;
+    });
+    apply((iter != m_configurations.end()) ? *iter : m_configurations.back());
+}
+
+float EyeSegmenter::Impl::getLatencyBudget() const
+{
+    return m_latencyBudget;
+}
+
+EyeSegmenter::Configuration EyeSegmenter::Impl::getConfiguration() const
+{
+    return m_configuration;
+}
+
+std::vector<EyeSegmenter::Configuration> EyeSegmenter::Impl::getConfigurations() const
+{
+    return m_configurations;
 }
 
 // Static utility:
@@ -167,6 +293,36 @@ float EyeSegmenter::Impl::getRequiredAspectRatio()
 
 // ### utility ###
 
+// Candidate settings in order of decreasing accuracy, costs are measured by calibrate():
+static std::vector<EyeSegmenter::Configuration> createConfigurations()
+{
+    // clang-format off
+    const struct { int eyelidStages, irisStages, eyelidInits, irisInits; bool useHierarchy; int targetWidth; } table[] =
+    {
+        { -1, -1, 3, 5, true, 256 },
+        { -1, -1, 2, 3, true, 192 },
+        { -1, -1, 1, 1, true, 128 }, // DEFAULT_CONFIGURATION
+        {  8,  8, 1, 1, false, 128 },
+        {  6,  6, 1, 1, false, 96 },
+        {  4,  4, 1, 1, false, 64 }
+    };
+    // clang-format on
+
+    std::vector<EyeSegmenter::Configuration> configurations;
+    for (const auto& entry : table)
+    {
+        EyeSegmenter::Configuration configuration;
+        configuration.eyelidStages = entry.eyelidStages;
+        configuration.irisStages = entry.irisStages;
+        configuration.eyelidInits = entry.eyelidInits;
+        configuration.irisInits = entry.irisInits;
+        configuration.useHierarchy = entry.useHierarchy;
+        configuration.targetWidth = entry.targetWidth;
+        configurations.push_back(configuration);
+    }
+    return configurations;
+}
+
 static std::string kindToHint(ArchiveKind kind)
 {
     switch (kind)
@@ -16,6 +16,8 @@
 
 #include "drishti/EyeSegmenter.hpp"
 #include "drishti/core/Logger.h"
+#include "drishti/core/Executor.h"
+#include "drishti/core/LazyParallelResource.h"
 
 #include "drishti/eye/Eye.h"
 #include "drishti/drishti_cv.hpp"
@@ -34,6 +36,7 @@ public:
     Impl(std::istream& is, ArchiveKind kind);
     ~Impl();
     int operator()(const Image3b& image, Eye& eye, bool isRight);
+    int operator()(ImageEye* eyes, std::size_t count);
 
     Eye getMeanEye(int width) const;
 
@@ -49,11 +52,32 @@ public:
 
     void setOptimizationLevel(int level);
 
+    void calibrate(const Image3b& image, int iterations);
+    void setLatencyBudget(float milliseconds);
+    float getLatencyBudget() const;
+    Configuration getConfiguration() const;
+    std::vector<Configuration> getConfigurations() const;
+
 protected:
+    using EyeEstimatorPtr = std::unique_ptr<eye::EyeModelEstimator>;
+    using EyeEstimatorPool = core::ThreadLocalParallelResource<EyeEstimatorPtr>;
+
     void init(std::istream& is, ArchiveKind);
+    void apply(const Configuration& configuration);
+
+    static int segment(const eye::EyeModelEstimator& eme, const Image3b& image, Eye& eye, bool isRight);
 
     std::unique_ptr<eye::EyeModelEstimator> m_eme;
 
+    // Batch workers: copies of m_eme (created on demand, reset when the settings change):
+    std::shared_ptr<core::Executor> m_threads;
+    std::unique_ptr<EyeEstimatorPool> m_pool;
+
+    std::vector<Configuration> m_configurations; // decreasing accuracy
+    Configuration m_configuration;
+    float m_latencyBudget = 0.f;
+    bool m_isCalibrated = false;
+
     std::shared_ptr<spdlog::logger> m_streamLogger;
 };
 
@@ -0,0 +1,249 @@
+/**
+  @file   FaceDetector.cpp
+  @author David Hirvonen
+  @brief  Public API for face and eye model estimation in still images.
+
+  \copyright Copyright 2014-2016 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  This file contains the implementation of the FaceDetector public API class.
+*/
+
+#include "drishti/FaceDetector.hpp"
+#include "drishti/FaceImpl.h"
+
+#include "drishti/face/FaceDetector.h"
+#include "drishti/face/FaceDetectorFactory.h"
+#include "drishti/ml/ObjectDetectorACF.h"
+#include "drishti/core/Executor.h"
+#include "drishti/core/LazyParallelResource.h"
+#include "drishti/core/ParallelFor.h"
+#include "drishti/core/make_unique.h"
+
+#include <acf/ACF.h>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include "drishti/drishti_cv.hpp" // Must come after opencv
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+_DRISHTI_SDK_BEGIN
+
+class FaceDetector::Impl
+{
+public:
+    using FaceDetectorPtr = std::unique_ptr<drishti::face::FaceDetector>;
+    using FaceDetectorPool = drishti::core::ThreadLocalParallelResource<FaceDetectorPtr>;
+
+    Impl(Resources& resources, const Settings& settings)
+        : settings(settings)
+        , threads(drishti::core::Executor::getInstance())
+    {
+        using drishti::face::FaceDetectorFactoryShared;
+
+        // The streams are only read here, the workers share the deserialized regressors:
+        factory = std::make_shared<FaceDetectorFactoryShared>(
+            FaceDetectorFactoryShared::read(resources.sFaceDetector),
+            FaceDetectorFactoryShared::read(resources.sFaceRegressor),
+            FaceDetectorFactoryShared::read(resources.sEyeRegressor),
+            FaceDetectorFactoryShared::read(resources.sFaceModel),
+            threads);
+
+        detector = create();
+        if (!detector)
+        {
+            throw std::runtime_error("FaceDetector: invalid face detector");
+        }
+
+        // Batch workers: detectors created on demand with the same settings:
+        pool = drishti::core::make_unique<FaceDetectorPool>([this]() -> FaceDetectorPtr {
+            try
+            {
+                return create();
+            }
+            catch (...)
+            {
+                return FaceDetectorPtr(); // reported in the item status
+            }
+        });
+    }
+
+    int operator()(const Image3b& image, std::vector<Face>& faces)
+    {
+        return detect(*detector, image, faces);
+    }
+
+    int operator()(ImageFaces* images, std::size_t count)
+    {
+        // The calling thread participates with its own detector, pool workers use their own:
+        const auto caller = std::this_thread::get_id();
+        auto job = [&](int i) {
+            auto& worker = (std::this_thread::get_id() == caller) ? detector : pool->get();
+            images[i].status = worker ? detect(*worker, images[i].image, images[i].faces) : 1;
+        };
+
+        try
+        {
+            drishti::core::parallel_for(threads.get(), int(count), job);
+        }
+        catch (...)
+        {
+            // detect() reports failures in the status:
+            std::cerr << "exception: FaceDetector::Impl::operator()" << std::endl;
+        }
+
+        return int(std::count_if(images, images + count, [](const ImageFaces& f) { return f.status != 0; }));
+    }
+
+    FaceDetectorPtr create() const
+    {
+        using drishti::face::FaceSpecification;
+
+        auto faceDetector = drishti::core::make_unique<drishti::face::FaceDetector>(*factory);
+        faceDetector->setLandmarkFormat(FaceSpecification::kibug68);
+        faceDetector->setDoNMSGlobal(settings.doSingleFace); // single detection only
+        faceDetector->setDoNMS(true);
+        faceDetector->setDoEyeRefinement(settings.doEyes);
+        faceDetector->setFaceDetectorMean(factory->getMeanFace());
+
+        auto* acf = dynamic_cast<drishti::ml::ObjectDetectorACF*>(faceDetector->getDetector());
+        if (!acf || !acf->good())
+        {
+            return nullptr;
+        }
+
+        if (settings.acfCalibration != 0.f)
+        {
+            // Perform modification
+            acf::Detector::Modify dflt;
+            dflt.cascThr = { "cascThr", -1.0 };
+            dflt.cascCal = { "cascCal", settings.acfCalibration };
+            acf->getDetector()->acfModify(dflt);
+        }
+
+        return faceDetector;
+    }
+
+    // Scratch images are local to the call, so concurrent calls only share the (const) models:
+    int detect(drishti::face::FaceDetector& faceDetector, const Image3b& image, std::vector<Face>& faces) const
+    {
+        faces.clear();
+        if (!image.getRows() || !image.getCols())
+        {
+            return 1;
+        }
+
+        try
+        {
+            // Create shallow copy of input image
+            cv::Mat3b I = drishtiToCv<Vec3b, cv::Vec3b>(image);
+
+            // Detection runs on an image scaled so that minFaceWidth fills the detection window:
+            float Sfd = 1.f; // scale: full to detection
+            cv::Mat3b reduced = I;
+            if (settings.minFaceWidth > 0)
+            {
+                Sfd = static_cast<float>(faceDetector.getWindowSize().width) / static_cast<float>(settings.minFaceWidth);
+                const int interpolation = (Sfd < 1.f) ? cv::INTER_AREA : cv::INTER_LINEAR;
+                cv::resize(I, reduced, {}, Sfd, Sfd, interpolation);
+            }
+
+            // Landmark and eye regression run on the full resolution green channel:
+            cv::Mat green;
+            cv::extractChannel(I, green, 1);
+            const drishti::face::FaceDetector::PaddedImage padded(green, { { 0, 0 }, green.size() });
+
+            // The detector expects a transposed planar float image:
+            cv::Mat It = reduced.t(), Itf;
+            It.convertTo(Itf, CV_32FC3, 1.0f / 255.f);
+            const MatP planar(Itf);
+
+            const float Sdr = 1.f / Sfd; // scale: detection to regression (full)
+            const cv::Matx33f Hdr = cv::Matx33f::diag({ Sdr, Sdr, 1.f });
+
+            std::vector<drishti::face::FaceModel> models;
+            faceDetector(planar, padded, models, Hdr);
+
+            faces.reserve(models.size());
+            for (const auto& model : models)
+            {
+                faces.push_back(drishti::sdk::convert(model));
+            }
+        }
+        catch (...)
+        {
+            std::cerr << "exception: FaceDetector::Impl::detect()" << std::endl;
+            faces.clear();
+            return 1;
+        }
+
+        return 0;
+    }
+
+    Settings settings;
+    std::shared_ptr<drishti::core::Executor> threads;
+    std::shared_ptr<drishti::face::FaceDetectorFactoryShared> factory;
+    FaceDetectorPtr detector;               // calling thread
+    std::unique_ptr<FaceDetectorPool> pool; // batch workers
+};
+
+// ######### FaceDetector ############
+
+FaceDetector::FaceDetector(Resources& resources)
+    : FaceDetector(resources, Settings())
+{
+}
+
+FaceDetector::FaceDetector(Resources& resources, const Settings& settings)
+{
+    try
+    {
+        m_impl = drishti::core::make_unique<Impl>(resources, settings);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "exception: FaceDetector::FaceDetector() :" << e.what() << std::endl;
+    }
+    catch (...)
+    {
+        std::cerr << "exception: FaceDetector::FaceDetector()" << std::endl;
+    }
+}
+
+FaceDetector::~FaceDetector() = default;
+
+bool FaceDetector::good() const
+{
+    return static_cast<bool>(m_impl.get());
+}
+
+FaceDetector::operator bool() const
+{
+    return good();
+}
+
+int FaceDetector::operator()(const Image3b& image, std::vector<Face>& faces)
+{
+    return (*m_impl)(image, faces);
+}
+
+int FaceDetector::operator()(std::vector<ImageFaces>& images)
+{
+    return (*this)(images.data(), images.size());
+}
+
+int FaceDetector::operator()(ImageFaces* images, std::size_t count)
+{
+    return (*m_impl)(images, count);
+}
+
+const FaceDetector::Settings& FaceDetector::getSettings() const
+{
+    return m_impl->settings;
+}
+
+_DRISHTI_SDK_END
@@ -0,0 +1,108 @@
+/**
+  @file   FaceDetector.hpp
+  @author David Hirvonen
+  @brief  Public API for face and eye model estimation in still images.
+
+  \copyright Copyright 2014-2016 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  This file contains the FaceDetector public API class, which runs on the CPU only.
+*/
+
+#ifndef __drishti_drishti_FaceDetector_hpp__
+#define __drishti_drishti_FaceDetector_hpp__ 1
+
+#include "drishti/drishti_sdk.hpp"
+#include "drishti/Image.hpp"
+#include "drishti/Face.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+_DRISHTI_SDK_BEGIN
+
+/**
+    \class FaceDetector
+    \brief Face detection, landmark regression and eye models for still images (no OpenGL).
+
+    The models are loaded once and shared by the internal workers, the image buffers used by
+    a call are released when it returns.
+*/
+
+class DRISHTI_EXPORT FaceDetector
+{
+public:
+    // The referenced streams must stay in scope for the scope of the construction.
+    struct Resources
+    {
+        std::istream* sFaceDetector;
+        std::istream* sFaceRegressor;
+        std::istream* sEyeRegressor;
+        std::istream* sFaceModel;
+    };
+
+    struct Settings
+    {
+        int minFaceWidth = -1;      //!< smallest face width in input pixels (-1 : detection window)
+        bool doSingleFace = false;  //!< report the strongest face only
+        bool doEyes = true;         //!< eye model regression
+        float acfCalibration = 0.f; //!< detector cascade calibration (0 : model default)
+    };
+
+    class Impl;
+
+    /**
+     * Constructor
+     *
+     * @param resources Container of istream objects sufficient to allocate the detector and regressors
+     * @param settings Detection options (the defaults otherwise)
+     */
+    FaceDetector(Resources& resources);
+    FaceDetector(Resources& resources, const Settings& settings);
+    ~FaceDetector();
+
+    // FaceDetector cannot be copied:
+    FaceDetector(const FaceDetector&) = delete;
+    FaceDetector& operator=(const FaceDetector&) = delete;
+
+    bool good() const;
+    explicit operator bool() const;
+
+    /**
+     * Find the faces in an RGB image.
+     * @param image input image
+     * @param faces output face models (in image coordinates)
+     * @return status (0 : success)
+     */
+    int operator()(const Image3b& image, std::vector<Face>& faces);
+
+    /**
+     * An image and its faces for batch processing.
+     */
+    struct ImageFaces
+    {
+        Image3b image;           //!< input RGB image (shallow)
+        std::vector<Face> faces; //!< output face models
+        int status = 0;          //!< output status (0 : success)
+    };
+
+    /**
+     * Process many images on an internal thread pool: each worker uses its own detector
+     * that shares the regression models of this one.  This never throws, failures are
+     * reported in ImageFaces::status.  Calls must not overlap.
+     * @return the number of items that failed
+     */
+    int operator()(std::vector<ImageFaces>& images);
+    int operator()(ImageFaces* images, std::size_t count);
+
+    const Settings& getSettings() const;
+
+protected:
+    std::unique_ptr<Impl> m_impl;
+};
+
+_DRISHTI_SDK_END
+
+#endif // __drishti_drishti_FaceDetector_hpp__
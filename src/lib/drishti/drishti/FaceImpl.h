@@ -0,0 +1,73 @@
+/**
+  @file   drishti/FaceImpl.h
+  @author David Hirvonen
+  @brief  Private conversions between the internal and public face models.
+
+  \copyright Copyright 2014-2016 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_drishti_FaceImpl_h__
+#define __drishti_drishti_FaceImpl_h__ 1
+
+#include "drishti/drishti_sdk.hpp"
+#include "drishti/drishti_cv.hpp"
+#include "drishti/EyeSegmenterImpl.hpp"
+#include "drishti/Face.hpp"
+
+#include "drishti/face/Face.h"
+
+_DRISHTI_SDK_BEGIN
+
+// Maintain lightweight inline conversions in private header for internal use
+
+// Conversion into existing (i.e., preallocated) storage: every field is overwritten.
+inline void convert(const drishti::face::FaceModel& model, drishti::sdk::Face& f)
+{
+    f.roi = model.roi.has ? drishti::sdk::cvToDrishti(*model.roi) : drishti::sdk::Recti();
+
+    f.eyes.clear();
+    if (model.eyeFullR.has && model.eyeFullL.has)
+    {
+        f.eyes.resize(2);
+        f.eyes[0] = drishti::sdk::convert(*model.eyeFullR);
+        f.eyes[1] = drishti::sdk::convert(*model.eyeFullL);
+    }
+
+    // Element-wise, without an intermediate Array:
+    f.landmarks.clear();
+    if (model.points.has)
+    {
+        const auto& points = *model.points;
+        f.landmarks.resize(points.size());
+        for (std::size_t i = 0; i < f.landmarks.size(); i++)
+        {
+            f.landmarks[i] = drishti::sdk::cvToDrishti(points[i]);
+        }
+    }
+
+    f.position = drishti::sdk::Vec3f(0.f, 0.f, 0.f);
+}
+
+inline drishti::sdk::Face convert(const drishti::face::FaceModel& model)
+{
+    drishti::sdk::Face f;
+    convert(model, f);
+    return f;
+}
+
+inline drishti::face::FaceModel convert(const drishti::sdk::Face& model)
+{
+    drishti::face::FaceModel f;
+
+    f.eyeFullL = drishti::sdk::convert(model.eyes[0]);
+    f.eyeFullR = drishti::sdk::convert(model.eyes[1]);
+    f.points = drishti::sdk::drishtiToCv(model.landmarks);
+
+    return f;
+}
+
+_DRISHTI_SDK_END
+
+#endif // __drishti_drishti_FaceImpl_h__
@@ -13,43 +13,16 @@
 
 #include "drishti/drishti_sdk.hpp"
 #include "drishti/drishti_cv.hpp"
-#include "drishti/EyeSegmenterImpl.hpp"
+#include "drishti/FaceImpl.h"
+#include "drishti/FramePool.h"
 
 #include "drishti/face/Face.h"
 #include "drishti/hci/FaceFinder.h"
 
-_DRISHTI_SDK_BEGIN
-
-// Maintain lightweight inline conversions in private header for internal use
-inline drishti::sdk::Face convert(const drishti::face::FaceModel& model)
-{
-    drishti::sdk::Face f;
-
-    if (model.eyeFullR.has && model.eyeFullL.has)
-    {
-        f.eyes.resize(2);
-        f.eyes[0] = drishti::sdk::convert(*model.eyeFullR);
-        f.eyes[1] = drishti::sdk::convert(*model.eyeFullL);
-    }
-
-    if (model.points.has)
-    {
-        f.landmarks = drishti::sdk::cvToDrishti(*model.points);
-    }
-
-    return f;
-}
-
-inline drishti::face::FaceModel convert(const drishti::sdk::Face& model)
-{
-    drishti::face::FaceModel f;
+#include <array>
+#include <memory>
 
-    f.eyeFullL = drishti::sdk::convert(model.eyes[0]);
-    f.eyeFullR = drishti::sdk::convert(model.eyes[1]);
-    f.points = drishti::sdk::drishtiToCv(model.landmarks);
-
-    return f;
-}
+_DRISHTI_SDK_BEGIN
 
 /**
  * FaceMonitorAdapter
@@ -64,11 +37,19 @@ public:
     using TimePoint = HighResolutionClock::time_point; // <std::chrono::system_clock>;
     using Faces = std::vector<drishti::face::FaceModel>;
 
-    FaceMonitorAdapter(drishti_face_tracker_t& table, int n = std::numeric_limits<int>::max())
+    // Results are allocated once for at most maxFaces faces (clipped to the result capacity):
+    FaceMonitorAdapter(drishti_face_tracker_t& table, std::shared_ptr<FramePool> pool, std::size_t maxFaces = 2, int n = std::numeric_limits<int>::max())
         : m_start(HighResolutionClock::now())
         , m_table(table)
+        , m_pool(pool)
+        , m_result(new drishti_face_tracker_result_t)
         , m_n(n)
     {
+        for (auto& results : m_results)
+        {
+            results.reset(new drishti_face_tracker_results_t);
+        }
+        m_maxFaces = std::min(maxFaces, m_result->faceModels.limit());
     }
 
     ~FaceMonitorAdapter() = default;
@@ -77,34 +58,42 @@ public:
     {
         double elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(timeStamp - m_start).count();
 
-        drishti_face_tracker_result_t result;
-        convert(faces, result.faceModels);
+        drishti_face_tracker_result_t& result = *m_result;
+        result.time = elapsed;
+        result.latency = std::chrono::duration<double>(HighResolutionClock::now() - timeStamp).count();
+        convert(faces, result.faceModels, m_maxFaces);
 
         auto request = m_table.update(m_table.context, result, elapsed);
+        m_copy = request.getImage && request.getCopy;
 
         return Request{ request.n, request.getImage, request.getTexture };
     }
 
     virtual void grab(const std::vector<FaceImage>& frames, bool isInitialized)
     {
-        // Populate public API buffer using public SDK wrapper types w/ shallow copy:
-        drishti::sdk::Array<drishti_face_tracker_result_t, 64> results(frames.size());
+        // Populate public API buffer using public SDK wrapper types w/ shallow copy.  The
+        // buffers alternate, so the last results stay intact while the next ones are filled:
+        m_index = (m_index + 1) % m_results.size();
+        drishti_face_tracker_results_t& results = *m_results[m_index];
+        results.resize(frames.size());
 
+        const auto now = HighResolutionClock::now();
         for (size_t i = 0; i < frames.size(); i++)
         {
+            results[i].time = std::chrono::duration<double>(frames[i].time - m_start).count();
+            results[i].latency = std::chrono::duration<double>(now - frames[i].time).count();
+
             // Copy the full frame "face" image and metadata:
-            convert(frames[i].image, results[i].image);
-            convert(frames[i].faceModels, results[i].faceModels);
+            convert(frames[i].image, results[i].image, m_copy);
+            convert(frames[i].faceModels, results[i].faceModels, m_maxFaces);
 
             // Copy the eye images and metadata:
-            convert(frames[i].eyes, results[i].eyes);
+            convert(frames[i].eyes, results[i].eyes, m_copy);
             results[i].eyeModels.resize(2);
             for (int j = 0; j < 2; j++)
             {
-                if (frames[i].eyeModels[j].eyelids.size())
-                {
-                    results[i].eyeModels[j] = drishti::sdk::convert(frames[i].eyeModels[j]);
-                }
+                const bool hasEye = !frames[i].eyeModels[j].eyelids.empty();
+                results[i].eyeModels[j] = hasEye ? drishti::sdk::convert(frames[i].eyeModels[j]) : drishti::sdk::Eye();
             }
         }
 
@@ -112,12 +101,13 @@ public:
     }
 
 protected:
-    static void convert(const Faces& facesIn, drishti::sdk::Array<drishti::sdk::Face, 2>& facesOut)
+    // The faces are converted in place (the result storage is reused for every frame):
+    static void convert(const Faces& facesIn, drishti::sdk::Array<drishti::sdk::Face, 2>& facesOut, std::size_t maxFaces)
     {
-        facesOut.resize(std::min(facesOut.limit(), facesIn.size()));
+        facesOut.resize(std::min(maxFaces, facesIn.size()));
         for (std::size_t i = 0; i < facesOut.size(); i++)
         {
-            facesOut[i] = drishti::sdk::convert(facesIn[i]);
+            drishti::sdk::convert(facesIn[i], facesOut[i]);
         }
     }
 
@@ -126,18 +116,38 @@ protected:
         return { { texture.size.width, texture.size.height }, texture.texId };
     }
 
-    static void convert(const core::ImageView& src, drishti_image_tex_t& dst)
+    // Images are views of the internal buffers, or copies in pooled buffers (the user releases them):
+    void convert(const core::ImageView& src, drishti_image_tex_t& dst, bool copy)
     {
         dst.texture = convert(src.texture);
         if (!src.image.empty())
         {
-            dst.image = cvToDrishti<cv::Vec4b, drishti::sdk::Vec4b>(src.image);
+            cv::Mat4b image = src.image;
+            if (copy && m_pool)
+            {
+                image = m_pool->acquire(src.image.size());
+                src.image.copyTo(image);
+            }
+            dst.image = cvToDrishti<cv::Vec4b, drishti::sdk::Vec4b>(image);
+        }
+        else
+        {
+            dst.image = drishti::sdk::Image4b();
         }
     }
 
-    TimePoint m_start;              //! Timestmap for the start of tracking
-    drishti_face_tracker_t m_table; //! Table of callbacks for face tracker output
-    int m_n = 1;                    //! Number of frames to request for each callback
+    TimePoint m_start;                 //! Timestmap for the start of tracking
+    drishti_face_tracker_t m_table;    //! Table of callbacks for face tracker output
+    std::shared_ptr<FramePool> m_pool; //! Buffers for image copies
+    bool m_copy = false;               //! Copy images for the current request
+
+    // Preallocated (large) results, the grab() buffers alternate between callbacks:
+    std::unique_ptr<drishti_face_tracker_result_t> m_result;                 //! request() result
+    std::array<std::unique_ptr<drishti_face_tracker_results_t>, 2> m_results; //! grab() results
+    std::size_t m_index = 0;                                                  //! Last grab() buffer
+    std::size_t m_maxFaces = 2;                                               //! Faces per result
+
+    int m_n = 1; //! Number of frames to request for each callback
 };
 
 _DRISHTI_SDK_END
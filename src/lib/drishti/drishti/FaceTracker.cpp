@@ -11,25 +11,37 @@
 #include "drishti/FaceTracker.hpp"
 #include "drishti/ContextImpl.h"
 #include "drishti/FaceMonitorAdapter.h"
+#include "drishti/FramePool.h"
 #include "drishti/SensorImpl.h"
 
 #include "drishti/face/Face.h"
 #include "drishti/hci/FaceFinder.h"
+#include "drishti/hci/gpu/YuvToRgbProc.h"
 #include "drishti/core/make_unique.h"
 #include "drishti/core/Logger.h"
 
 #include "drishti/drishti_cv.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <memory>
+#include <thread>
+#include <vector>
 
 _DRISHTI_SDK_BEGIN
 
 static ogles_gpgpu::FrameInput convert(const VideoFrame& frame);
+static drishti::hci::FaceFinder::TimePoint getCaptureTime(const VideoFrame& frame);
+static std::shared_ptr<drishti::hci::PerformanceGovernor> createGovernor(const Context::Impl& context);
 
 /*
  * Impl
@@ -38,14 +50,52 @@ static ogles_gpgpu::FrameInput convert(const VideoFrame& frame);
 struct FaceTracker::Impl
 {
     using Settings = drishti::hci::FaceFinder::Settings;
+    using HighResolutionClock = std::chrono::high_resolution_clock;
+
+    // A submitted frame:
+    struct Job
+    {
+        VideoFrame frame;
+        void* userTag;
+        double timestamp;
+    };
+
+    // A completion callback handed to the user's executor:
+    struct Completion
+    {
+        static void run(void* arg)
+        {
+            std::unique_ptr<Completion> task(static_cast<Completion*>(arg));
+            task->complete(task->context, task->userTag, task->timestamp, task->status);
+        }
+
+        drishti_face_tracker_complete_t complete;
+        void* context;
+        void* userTag;
+        double timestamp;
+        int status;
+    };
 
     /*
      * WIP: We will need to provide some configurable options here
      */
 
     Impl(Context* manager, FaceTracker::Resources& resources)
+        : m_start(HighResolutionClock::now())
     {
-        Settings settings;
+        // Models are deserialized once per context and shared by all of its trackers:
+        m_factory = manager->get()->getModels(resources.sFaceDetector, resources.sFaceRegressor, resources.sEyeRegressor, resources.sFaceModel);
+
+        // An automatic profile is resolved (benchmarked) by the first tracker:
+        manager->get()->resolveProfile(*m_factory);
+
+        Tuning tuning;
+        {
+            std::lock_guard<std::mutex> lock(manager->get()->profileMutex);
+            tuning = manager->get()->tuning;
+        }
+
+        Settings& settings = m_settings;
         settings.sensor = manager->get()->sensor;
 
         if (resources.logger.empty())
@@ -58,12 +108,19 @@ struct FaceTracker::Impl
             settings.logger = drishti::core::Logger::create(resources.logger.c_str());
         }
 
-        settings.threads = std::make_shared<tp::ThreadPool<>>();
+        settings.threads = manager->get()->threads; // shared by all trackers
+        settings.gpuScheduler = manager->get()->gpuScheduler;
         settings.outputOrientation = 0;
         settings.frameDelay = 1;
         settings.doLandmarks = true;
-        settings.doFlow = false;
-        settings.doBlobs = false;
+        settings.doFlow = tuning.doFlow;
+        settings.doBlobs = tuning.doBlobs;
+        settings.history = tuning.history;
+        settings.historyScale = manager->getHistoryScale();
+        settings.landmarksWidth = tuning.landmarksWidth;
+        settings.faceStagesHint = tuning.faceStagesHint;
+        settings.eyelidStagesHint = tuning.eyelidStagesHint;
+        settings.irisStagesHint = tuning.irisStagesHint;
         settings.doSingleFace = manager->getDoSingleFace();
         settings.minDetectionDistance = manager->getMinDetectionDistance();
         settings.maxDetectionDistance = manager->getMaxDetectionDistance();
@@ -74,33 +131,278 @@ struct FaceTracker::Impl
         settings.maxTrackMisses = manager->getMaxTrackMisses();
         settings.minFaceSeparation = manager->getMinFaceSeparation();
         settings.doOptimizedPipeline = manager->getDoOptimizedPipeline();
+        settings.governor = createGovernor(*manager->get());
+        m_maxFaces = static_cast<std::size_t>(std::max(manager->getMaxFaces(), 0));
 
-        auto stream = std::make_shared<drishti::face::FaceDetectorFactoryStream>();
-        stream->iEyeRegressor = resources.sEyeRegressor;
-        stream->iFaceDetector = resources.sFaceDetector;
-        stream->iFaceRegressor = resources.sFaceRegressor;
-        stream->iFaceDetectorMean = resources.sFaceModel;
-
-        std::shared_ptr<drishti::face::FaceDetectorFactory> factory = stream;
+        m_glContext = manager->get()->glContext;
+        m_droppedCount = &manager->get()->metrics->counter("dropped_frames");
+        m_copyCount = &manager->get()->metrics->counter("hidden_copies");
+    }
 
-        m_faceFinder = drishti::hci::FaceFinder::create(factory, settings, manager->get()->glContext);
+    // The FaceFinder (i.e., its FBOs, VAOs and timer queries) is created on first use by the
+    // thread that tracks, so it belongs to the OpenGL context that is current there:
+    drishti::hci::FaceFinder& getFaceFinder()
+    {
+        if (!m_faceFinder)
+        {
+            auto finder = drishti::hci::FaceFinder::create(m_factory, m_settings, m_glContext);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& callback : m_callbacks)
+            {
+                finder->registerFaceMonitorCallback(callback.get());
+            }
+            m_faceFinder = std::move(finder);
+        }
+        return *m_faceFinder;
     }
 
     int operator()(const VideoFrame& frame)
     {
-        return (*m_faceFinder)(convert(frame));
+        auto& faceFinder = getFaceFinder();
+        if (frame.format != VideoFrame::kPacked)
+        {
+            return faceFinder(convertYuv(frame), getCaptureTime(frame));
+        }
+
+        const int rowBytes = frame.size[0] * 4;
+        if (!frame.pixelBuffer || !frame.stride || (frame.stride == rowBytes))
+        {
+            return faceFinder(convert(frame), getCaptureTime(frame));
+        }
+
+#if defined(GL_UNPACK_ROW_LENGTH)
+        // Padded rows are handled by the texture upload:
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, frame.stride / 4);
+        const int status = faceFinder(convert(frame), getCaptureTime(frame));
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        return status;
+#else
+        // OpenGL ES 2.0: remove the row padding before the upload
+        m_copyCount->add();
+        m_packed.resize(rowBytes * frame.size[1]);
+        for (int y = 0; y < frame.size[1]; y++)
+        {
+            std::memcpy(&m_packed[y * rowBytes], static_cast<const uint8_t*>(frame.pixelBuffer) + y * frame.stride, rowBytes);
+        }
+
+        VideoFrame packed(frame);
+        packed.pixelBuffer = m_packed.data();
+        packed.stride = 0;
+        return faceFinder(convert(packed), getCaptureTime(frame));
+#endif
     }
 
+    // YUV planes are uploaded as is and converted to RGBA in a shader, the result is the input texture:
+    ogles_gpgpu::FrameInput convertYuv(const VideoFrame& frame)
+    {
+        using Layout = ogles_gpgpu::YuvToRgbProc::Layout;
+
+        if (!m_yuvToRgb || (m_yuvToRgb->getInFrameW() != frame.size[0]) || (m_yuvToRgb->getInFrameH() != frame.size[1]))
+        {
+            m_yuvToRgb = drishti::core::make_unique<ogles_gpgpu::YuvToRgbProc>();
+            m_yuvToRgb->init(frame.size[0], frame.size[1], 0, false);
+            m_yuvToRgb->createFBOTex(false);
+        }
+
+        switch (frame.format)
+        {
+            case VideoFrame::kNV21:
+                m_yuvToRgb->setLayout(Layout::kNV21);
+                break;
+            case VideoFrame::kI420:
+                m_yuvToRgb->setLayout(Layout::kI420);
+                break;
+            default:
+                m_yuvToRgb->setLayout(Layout::kNV12);
+                break;
+        }
+        m_yuvToRgb->setFullRange(frame.fullRange);
+
+        ogles_gpgpu::YuvToRgbProc::Plane planes[3];
+        for (int i = 0; i < 3; i++)
+        {
+            planes[i].data = frame.planes[i].data;
+            planes[i].stride = frame.planes[i].stride;
+        }
+
+        const GLuint texture = (*m_yuvToRgb)(planes);
+
+        // clang-format off
+        ogles_gpgpu::FrameInput input
+        {
+            { frame.size[0], frame.size[1] },
+            nullptr,
+            false,
+            texture,
+            GL_RGBA
+        };
+        // clang-format on
+
+        return input;
+    }
+
+    ~Impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_one();
+
+        if (m_worker.joinable())
+        {
+            m_worker.join();
+        }
+    }
+
+    int start(const drishti_face_tracker_async_t& config)
+    {
+        if (m_worker.joinable() || m_faceFinder)
+        {
+            return -1; // already started, or the pipeline belongs to the synchronous caller
+        }
+
+        m_async = config;
+        m_async.maxInFlight = std::max(config.maxInFlight, 1);
+        m_worker = std::thread([this]() { run(); });
+        return 0;
+    }
+
+    // Never waits on tracking: the lock only guards the queue.
+    int submit(const VideoFrame& frame, void* userTag)
+    {
+        if (!m_worker.joinable())
+        {
+            return -1;
+        }
+
+        const double timestamp = std::chrono::duration<double>(HighResolutionClock::now() - m_start).count();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_inFlight >= m_async.maxInFlight)
+            {
+                m_droppedCount->add();
+                return 1; // backpressure: the caller drops or retries the frame
+            }
+            m_jobs.push_back({ frame, userTag, timestamp });
+            m_inFlight++;
+        }
+        m_condition.notify_one();
+        return 0;
+    }
+
+    // Tracking thread: frames are processed in order, queued frames are cancelled on shutdown.
+    void run()
+    {
+        if (m_async.attach)
+        {
+            m_async.attach(m_async.context);
+        }
+
+        while (true)
+        {
+            Job job;
+            bool cancel = false;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+                if (m_jobs.empty())
+                {
+                    break;
+                }
+                job = m_jobs.front();
+                m_jobs.pop_front();
+                cancel = m_stop;
+            }
+
+            int status = -1;
+            if (!cancel)
+            {
+                try
+                {
+                    status = (*this)(job.frame);
+                }
+                catch (const std::exception&)
+                {
+                    status = -1;
+                }
+            }
+            complete(job, status);
+        }
+
+        // Release the OpenGL objects while their context is still current:
+        std::unique_ptr<drishti::hci::FaceFinder> faceFinder;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            faceFinder = std::move(m_faceFinder);
+        }
+        faceFinder.reset();
+        m_yuvToRgb.reset();
+
+        if (m_async.detach)
+        {
+            m_async.detach(m_async.context);
+        }
+    }
+
+    void complete(const Job& job, int status)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_inFlight--; // before the callback, so that it can submit the next frame
+        }
+
+        if (m_async.complete)
+        {
+            if (m_async.dispatch)
+            {
+                auto* task = new Completion{ m_async.complete, m_async.context, job.userTag, job.timestamp, status };
+                m_async.dispatch(m_async.context, &Completion::run, task);
+            }
+            else
+            {
+                m_async.complete(m_async.context, job.userTag, job.timestamp, status);
+            }
+        }
+    }
+
+    // Callbacks added before the first frame are registered when the FaceFinder is created:
     void add(drishti_face_tracker_t& table)
     {
-        auto callback = std::make_shared<FaceMonitorAdapter>(table);
-        m_faceFinder->registerFaceMonitorCallback(callback.get());
+        auto callback = std::make_shared<FaceMonitorAdapter>(table, m_framePool, m_maxFaces);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_faceFinder)
+        {
+            m_faceFinder->registerFaceMonitorCallback(callback.get());
+        }
         m_callbacks.emplace_back(callback);
     }
 
     std::vector<std::shared_ptr<FaceMonitorAdapter>> m_callbacks;
-
-    std::unique_ptr<drishti::hci::FaceFinder> m_faceFinder;
+    std::shared_ptr<FramePool> m_framePool = std::make_shared<FramePool>(); // grab copies
+    std::size_t m_maxFaces = 2;                                              // faces per callback result
+
+    Settings m_settings;
+    drishti::hci::FaceFinder::FaceDetectorFactoryPtr m_factory;
+    void* m_glContext = nullptr;
+    std::unique_ptr<drishti::hci::FaceFinder> m_faceFinder; // created by getFaceFinder()
+
+    std::unique_ptr<ogles_gpgpu::YuvToRgbProc> m_yuvToRgb;
+    std::vector<uint8_t> m_packed;
+
+    // Asynchronous tracking:
+    HighResolutionClock::time_point m_start;
+    drishti_face_tracker_async_t m_async = {};
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<Job> m_jobs;
+    int m_inFlight = 0;
+    bool m_stop = false;
+    drishti::core::Counter* m_droppedCount = nullptr;
+    drishti::core::Counter* m_copyCount = nullptr; // same format copies of client pixels
 };
 
 /*
@@ -141,8 +443,69 @@ void FaceTracker::add(drishti_face_tracker_t& table)
     m_impl->add(table);
 }
 
+int FaceTracker::start(const drishti_face_tracker_async_t& config)
+{
+    return m_impl->start(config);
+}
+
+int FaceTracker::submit(const VideoFrame& image, void* userTag)
+{
+    return m_impl->submit(image, userTag);
+}
+
+int FaceTracker::release(const Image4b& image)
+{
+    return m_impl->m_framePool->release(image.ptr<uint8_t>()) ? 0 : -1;
+}
+
 // ### utility
 
+// Each tracker has its own governor (frame times are per stream), the platform state is shared:
+static std::shared_ptr<drishti::hci::PerformanceGovernor> createGovernor(const Context::Impl& context)
+{
+    using drishti::hci::PerformanceGovernor;
+
+    if (context.governorFrameRate <= 0.f)
+    {
+        return nullptr;
+    }
+
+    PerformanceGovernor::Settings settings;
+    settings.targetFrameRate = context.governorFrameRate;
+
+    PerformanceGovernor::PowerMonitor monitor;
+    if (auto* callback = context.powerCallback)
+    {
+        void* user = context.powerContext;
+        monitor = [callback, user]() {
+            const Context::PowerState state = callback(user);
+
+            PerformanceGovernor::PowerState power;
+            power.thermal = state.thermal;
+            power.battery = state.battery;
+            power.isCharging = state.isCharging;
+            return power;
+        };
+    }
+
+    return std::make_shared<PerformanceGovernor>(settings, monitor);
+}
+
+// Map the capture time (steady clock seconds) to the FaceFinder clock, frames without one are stamped on arrival:
+static drishti::hci::FaceFinder::TimePoint getCaptureTime(const VideoFrame& frame)
+{
+    using HighResolutionClock = drishti::hci::FaceFinder::HighResolutionClock;
+    const auto now = HighResolutionClock::now();
+    if (frame.timestamp <= 0.0)
+    {
+        return now;
+    }
+
+    const std::chrono::duration<double> steady = std::chrono::steady_clock::now().time_since_epoch();
+    const std::chrono::duration<double> age(std::max(steady.count() - frame.timestamp, 0.0));
+    return now - std::chrono::duration_cast<HighResolutionClock::duration>(age);
+}
+
 static ogles_gpgpu::FrameInput convert(const VideoFrame& frame)
 {
     // clang-format off
@@ -167,6 +530,12 @@ _DRISHTI_SDK_END
 
 DRISHTI_EXTERN_C_BEGIN
 
+DRISHTI_EXPORT int
+drishti_face_tracker_abi_version()
+{
+    return DRISHTI_FACE_TRACKER_ABI_VERSION;
+}
+
 DRISHTI_EXPORT drishti::sdk::FaceTracker*
 drishti_face_tracker_create_from_streams(drishti::sdk::Context* manager, drishti::sdk::FaceTracker::Resources& resources)
 {
@@ -202,4 +571,34 @@ drishti_face_tracker_track(drishti::sdk::FaceTracker* tracker, const drishti::sd
     return -1;
 }
 
+DRISHTI_EXPORT int
+drishti_face_tracker_start(drishti::sdk::FaceTracker* tracker, const drishti_face_tracker_async_t& config)
+{
+    if (tracker)
+    {
+        return tracker->start(config);
+    }
+    return -1;
+}
+
+DRISHTI_EXPORT int
+drishti_face_tracker_submit(drishti::sdk::FaceTracker* tracker, const drishti::sdk::VideoFrame& frame, void* userTag)
+{
+    if (tracker)
+    {
+        return tracker->submit(frame, userTag);
+    }
+    return -1;
+}
+
+DRISHTI_EXPORT int
+drishti_face_tracker_release(drishti::sdk::FaceTracker* tracker, const drishti::sdk::Image4b& image)
+{
+    if (tracker)
+    {
+        return tracker->release(image);
+    }
+    return -1;
+}
+
 DRISHTI_EXTERN_C_END
@@ -20,6 +20,15 @@
 
 #include <memory>
 
+/**
+ * Layout version of the structs shared with the callbacks (drishti_request_t,
+ * drishti_face_tracker_result_t, ...).  This is incremented whenever a field is added, so
+ * dlopen clients can compare it with drishti_face_tracker_abi_version() before use:
+ *
+ *   2 : drishti_request_t::getCopy, drishti_face_tracker_result_t::latency (SDK 0.9)
+ */
+#define DRISHTI_FACE_TRACKER_ABI_VERSION 2
+
 /**
  * @brief An image container with an OpenGL texture and/or memory buffer
  *
@@ -43,10 +52,16 @@ struct drishti_image_tex_t
 struct drishti_face_tracker_result_t
 {
     /**
-     * Acquisition time of the contained frame.
+     * Acquisition time of the contained frame (VideoFrame::timestamp, or arrival time),
+     * in seconds since the tracker was created.
      */
     double time; // TimePoint
 
+    /**
+     * Seconds from the acquisition of the frame to this callback (ABI version 2).
+     */
+    double latency;
+
     /**
      * The image description (memory and/or OpenGL texture)
      */
@@ -108,6 +123,8 @@ typedef struct drishti_image
 /**
  * @brief A "request" object specifying the # of frames to retrieve and
  * the desired format: (1) OpenGL texture or; (2) user memory.
+ *
+ * Note: <getCopy> was added in ABI version 2 (see DRISHTI_FACE_TRACKER_ABI_VERSION).
  */
 
 typedef struct drishti_request
@@ -127,6 +144,13 @@ typedef struct drishti_request
      */
     bool getTexture;
 
+    /**
+     * Get images as copies in SDK pooled buffers, which remain valid until they are returned
+     * with drishti_face_tracker_release().  Otherwise images are views of internal buffers
+     * that are only valid for the duration of the <callback>.
+     */
+    bool getCopy;
+
 } drishti_request_t;
 
 /**
@@ -143,6 +167,9 @@ typedef drishti::sdk::Array<drishti_face_tracker_result_t, 64> drishti_face_trac
  * @param context Allocated context with internal library state.
  * @param results A vector containing frames + associated face metadata for the past N frames
  * @return Error code (reserved).
+ *
+ * The results are owned by the tracker, which alternates between two preallocated buffers:
+ * they remain valid until the callback after the next one (Context::setMaxFaces() faces each).
  */
 typedef int (*drishti_face_tracker_callback_t)(void* context, drishti_face_tracker_results_t& results);
 
@@ -169,6 +196,9 @@ typedef drishti_request_t (*drishti_face_tracker_update_t)(void* context, const
  * This is a user provided function to perform image allocation in cases where images are requested.
  * The library does not return any allocated memory across the API boundary.
  *
+ * Note: This is not called for frame grabs, which are delivered as views or as copies in
+ * recyclable SDK buffers (see drishti_request_t::getCopy), and may be null.
+ *
  * @param context Allocated context with internal library state.
  * @param spec A specification describing how the image to be allocated.
  * @return Error code (reserved).
@@ -211,6 +241,72 @@ typedef struct drishti_face_tracker
     drishti_face_tracker_allocator_t allocator;
 } drishti_face_tracker_t;
 
+/**
+ * @brief Completion callback for a frame passed to FaceTracker::submit().
+ *
+ * The caller may recycle the frame's buffers (identified by userTag) once this is called.
+ *
+ * @param context The user context from drishti_face_tracker_async_t.
+ * @param userTag The tag passed to submit().
+ * @param timestamp Submission time of the frame (seconds since the tracker was created).
+ * @param status Result of tracking (0 on success, -1 if the frame was cancelled).
+ */
+typedef void (*drishti_face_tracker_complete_t)(void* context, void* userTag, double timestamp, int status);
+
+/**
+ * @brief A task run by a drishti_face_tracker_dispatch_t executor.
+ */
+typedef void (*drishti_face_tracker_task_t)(void* task);
+
+/**
+ * @brief Executor for completion callbacks: the implementation must call task(arg) exactly once.
+ */
+typedef void (*drishti_face_tracker_dispatch_t)(void* context, drishti_face_tracker_task_t task, void* arg);
+
+/**
+ * @brief Configuration for asynchronous tracking with FaceTracker::submit().
+ *
+ * Submitted frames are tracked in order on a thread owned by the FaceTracker.  The OpenGL
+ * context used for tracking must be made current on that thread (i.e., a context shared with
+ * the capture context) by the <attach> callback.  The tracking pipeline (FBOs, VAOs and
+ * queries, which are not shared between contexts) is created on the tracking thread after
+ * <attach> and destroyed before <detach>.  The drishti_face_tracker_t callbacks are called
+ * on the tracking thread, since they may read back OpenGL textures.
+ */
+
+typedef struct drishti_face_tracker_async
+{
+    /**
+     * A pointer to user state passed to each callback.
+     */
+    void* context;
+
+    /**
+     * Maximum number of submitted frames not yet completed, submit() fails fast beyond this.
+     */
+    int maxInFlight;
+
+    /**
+     * Called on the tracking thread before the first frame, e.g., to make a GL context current (optional).
+     */
+    int (*attach)(void* context);
+
+    /**
+     * Called on the tracking thread before it exits (optional).
+     */
+    int (*detach)(void* context);
+
+    /**
+     * Called once for each accepted frame (optional).
+     */
+    drishti_face_tracker_complete_t complete;
+
+    /**
+     * Executor for the <complete> callback, null to call it on the tracking thread (optional).
+     */
+    drishti_face_tracker_dispatch_t dispatch;
+} drishti_face_tracker_async_t;
+
 DRISHTI_EXTERN_C_END
 
 _DRISHTI_SDK_BEGIN
@@ -259,7 +355,8 @@ public:
     static void tryEnablePlatformOptimizations();
 
     /**
-     * Runs face tracking on a single input video frame.
+     * Runs face tracking on a single input video frame.  The first frame creates the tracking
+     * pipeline in the OpenGL context that is current on the calling thread.
      *
      * @param image The input video frame object.
      */
@@ -282,6 +379,38 @@ public:
      */
     void add(drishti_face_tracker_t& table);
 
+    /**
+     * Start asynchronous tracking (once) with the provided configuration.  This must be called
+     * before any frame is passed to the synchronous operator(), which creates the tracking
+     * pipeline on the calling thread.
+     *
+     * @param config Thread hooks, completion callback and in-flight limit.
+     * @return 0 on success, -1 if already started or frames were tracked synchronously.
+     */
+    int start(const drishti_face_tracker_async_t& config);
+
+    /**
+     * Queue a frame for tracking and return immediately, the frame is tracked on the tracking
+     * thread and completion is reported through the <complete> callback. The memory and/or
+     * textures referenced by the frame must remain valid until then.  Must not be mixed
+     * with the synchronous operator().
+     *
+     * @param image The input video frame object.
+     * @param userTag A user pointer returned with the completion callback.
+     * @return 0 if the frame was queued, 1 if the in-flight limit was reached (the frame is
+     * dropped), -1 if asynchronous tracking was not started.
+     */
+    int submit(const VideoFrame& image, void* userTag);
+
+    /**
+     * Return an image copy (drishti_request_t::getCopy) to the frame pool for reuse, the
+     * image must not be accessed after this call.  This can be called from any thread.
+     *
+     * @param image An image received by the <callback>.
+     * @return 0 on success, -1 if the image is not an outstanding pooled copy.
+     */
+    int release(const Image4b& image);
+
 protected:
     struct Impl;
     std::unique_ptr<Impl> m_impl;
@@ -295,6 +424,15 @@ _DRISHTI_SDK_END
 
 DRISHTI_EXTERN_C_BEGIN
 
+/**
+ * @brief Layout version of the shared structs.
+ *
+ * @return The DRISHTI_FACE_TRACKER_ABI_VERSION the library was built with.
+ */
+
+DRISHTI_EXPORT int
+drishti_face_tracker_abi_version();
+
 /**
  * @brief Stream based allocation of FaceTracker
  *
@@ -351,6 +489,46 @@ drishti_face_tracker_track(drishti::sdk::FaceTracker* tracker, const drishti::sd
 DRISHTI_EXPORT int
 drishti_face_tracker_callback(drishti::sdk::FaceTracker* tracker, drishti_face_tracker_t& table);
 
+/**
+ * @brief Start asynchronous tracking.
+ *
+ * @see drishti::sdk::FaceTracker::start
+ *
+ * @param tracker The FaceTracker object
+ * @param config Thread hooks, completion callback and in-flight limit.
+ * @param return Error code.
+ */
+
+DRISHTI_EXPORT int
+drishti_face_tracker_start(drishti::sdk::FaceTracker* tracker, const drishti_face_tracker_async_t& config);
+
+/**
+ * @brief Queue a single frame for asynchronous tracking without blocking.
+ *
+ * @see drishti::sdk::FaceTracker::submit
+ *
+ * @param tracker The FaceTracker object
+ * @param frame The video frame for face detection + tracking
+ * @param userTag A user pointer returned with the completion callback.
+ * @param return 0 if queued, 1 if dropped (in-flight limit), -1 on error.
+ */
+
+DRISHTI_EXPORT int
+drishti_face_tracker_submit(drishti::sdk::FaceTracker* tracker, const drishti::sdk::VideoFrame& frame, void* userTag);
+
+/**
+ * @brief Return an image copy to the frame pool.
+ *
+ * @see drishti::sdk::FaceTracker::release
+ *
+ * @param tracker The FaceTracker object
+ * @param image An image copy received by the <callback>.
+ * @param return Error code.
+ */
+
+DRISHTI_EXPORT int
+drishti_face_tracker_release(drishti::sdk::FaceTracker* tracker, const drishti::sdk::Image4b& image);
+
 DRISHTI_EXTERN_C_END
 
 #endif // __drishti_drishti_FaceTracker_hpp__
@@ -0,0 +1,79 @@
+/**
+  @file   FramePool.cpp
+  @author David Hirvonen
+  @brief  Private pool of recyclable frame buffers for face tracker grabs.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+ */
+
+#include "drishti/FramePool.h"
+
+#include <algorithm>
+
+_DRISHTI_SDK_BEGIN
+
+FramePool::FramePool(std::size_t maxFree)
+    : m_maxFree(maxFree)
+{
+}
+
+cv::Mat4b FramePool::acquire(const cv::Size& size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Most recently released first (cache warm):
+    auto iter = std::find_if(m_free.rbegin(), m_free.rend(), [&](const cv::Mat4b& buffer) {
+        return buffer.size() == size;
+    });
+
+    cv::Mat4b buffer;
+    if (iter != m_free.rend())
+    {
+        buffer = *iter;
+        m_free.erase(std::next(iter).base());
+    }
+    else
+    {
+        buffer.create(size);
+    }
+
+    m_outstanding[buffer.data] = buffer;
+    return buffer;
+}
+
+bool FramePool::release(const void* data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto iter = m_outstanding.find(data);
+    if (iter == m_outstanding.end())
+    {
+        return false;
+    }
+
+    m_free.push_back(iter->second);
+    m_outstanding.erase(iter);
+
+    // Drop the oldest buffers (i.e., sizes that are no longer requested):
+    if (m_free.size() > m_maxFree)
+    {
+        m_free.erase(m_free.begin(), m_free.begin() + (m_free.size() - m_maxFree));
+    }
+    return true;
+}
+
+std::size_t FramePool::getOutstanding() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_outstanding.size();
+}
+
+std::size_t FramePool::getFree() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_free.size();
+}
+
+_DRISHTI_SDK_END
@@ -0,0 +1,54 @@
+/**
+  @file   FramePool.h
+  @author David Hirvonen
+  @brief  Private pool of recyclable frame buffers for face tracker grabs.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+ */
+
+#ifndef __drishti_drishti_FramePool_h__
+#define __drishti_drishti_FramePool_h__ 1
+
+#include "drishti/drishti_sdk.hpp"
+
+#include <opencv2/core/core.hpp>
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+_DRISHTI_SDK_BEGIN
+
+/*
+ * Frame copies requested by the user are made into buffers from this pool, which the user
+ * returns with release() (from any thread).  Released buffers are reused for grabs of the
+ * same size, so periodic grabs settle into a steady state without any allocations.
+ */
+
+class FramePool
+{
+public:
+    FramePool(std::size_t maxFree = 16);
+
+    // A buffer of the requested size, owned by the user until release():
+    cv::Mat4b acquire(const cv::Size& size);
+
+    // Return a buffer by its data pointer, false if it isn't an outstanding buffer of this pool:
+    bool release(const void* data);
+
+    std::size_t getOutstanding() const;
+    std::size_t getFree() const;
+
+protected:
+    mutable std::mutex m_mutex;
+    std::map<const void*, cv::Mat4b> m_outstanding;
+    std::vector<cv::Mat4b> m_free; // in order of release
+    std::size_t m_maxFree = 16;
+};
+
+_DRISHTI_SDK_END
+
+#endif // __drishti_drishti_FramePool_h__
@@ -0,0 +1,177 @@
+/**
+  @file   Profile.cpp
+  @author David Hirvonen
+  @brief  Private tracker settings selected by the Context performance profiles.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+ */
+
+#include "drishti/Profile.h"
+#include "drishti/eye/EyeModelEstimator.h"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+// Cost per eye (milliseconds) below which the more accurate profiles keep up with the camera:
+#define DRISHTI_PROFILE_MAX_ACCURACY_COST 4.f
+#define DRISHTI_PROFILE_BALANCED_COST 12.f
+
+_DRISHTI_SDK_BEGIN
+
+Tuning getTuning(Context::Profile profile)
+{
+    Tuning tuning;
+    tuning.profile = profile;
+
+    switch (profile)
+    {
+        case Context::kProfileLowPower:
+            tuning.faceFinderInterval = 0.25f;
+            tuning.minTrackHits = 3;
+            tuning.maxTrackMisses = 3;
+            tuning.doOptimizedPipeline = true;
+            tuning.history = 2;
+            tuning.landmarksWidth = 512;
+            tuning.faceStagesHint = 8;
+            tuning.eyelidStagesHint = 6;
+            tuning.irisStagesHint = 6;
+            break;
+
+        case Context::kProfileBalanced:
+            tuning.faceFinderInterval = 0.1f;
+            tuning.minTrackHits = 3;
+            tuning.maxTrackMisses = 3;
+            tuning.doOptimizedPipeline = true;
+            break;
+
+        case Context::kProfileMaxAccuracy:
+            tuning.faceFinderInterval = 0.f; // detect on every frame
+            tuning.minTrackHits = 3;
+            tuning.maxTrackMisses = 3;
+            tuning.doOptimizedPipeline = true;
+            tuning.doFlow = true;
+            break;
+
+        default: // kProfileCustom, kProfileAuto (before the benchmark): Context defaults
+            break;
+    }
+
+    return tuning;
+}
+
+float benchmark(drishti::eye::EyeModelEstimator& estimator, int iterations)
+{
+    // Cost is dominated by the fixed stage and init counts, so texture is enough:
+    cv::Mat3b crop(192, 256);
+    cv::randu(crop, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::GaussianBlur(crop, crop, { 5, 5 }, 1.0);
+
+    drishti::eye::EyeModel warmup;
+    estimator(crop, warmup);
+
+    iterations = std::max(iterations, 1);
+    const auto tic = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        drishti::eye::EyeModel eye;
+        estimator(crop, eye);
+    }
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - tic;
+    return elapsed.count() / float(iterations);
+}
+
+Context::Profile selectProfile(float milliseconds)
+{
+    if (milliseconds < DRISHTI_PROFILE_MAX_ACCURACY_COST)
+    {
+        return Context::kProfileMaxAccuracy;
+    }
+    if (milliseconds < DRISHTI_PROFILE_BALANCED_COST)
+    {
+        return Context::kProfileBalanced;
+    }
+    return Context::kProfileLowPower;
+}
+
+bool readTuning(const std::string& filename, Tuning& tuning)
+{
+    std::ifstream is(filename);
+    if (!is)
+    {
+        return false;
+    }
+
+    Tuning result;
+    int profile = -1;
+
+    std::string line;
+    while (std::getline(is, line))
+    {
+        std::istringstream iss(line);
+        std::string key;
+        if (!(iss >> key))
+        {
+            continue;
+        }
+
+        // clang-format off
+        if (key == "profile") { iss >> profile; }
+        else if (key == "faceFinderInterval") { iss >> result.faceFinderInterval; }
+        else if (key == "minTrackHits") { iss >> result.minTrackHits; }
+        else if (key == "maxTrackMisses") { iss >> result.maxTrackMisses; }
+        else if (key == "doOptimizedPipeline") { iss >> result.doOptimizedPipeline; }
+        else if (key == "doFlow") { iss >> result.doFlow; }
+        else if (key == "doBlobs") { iss >> result.doBlobs; }
+        else if (key == "history") { iss >> result.history; }
+        else if (key == "landmarksWidth") { iss >> result.landmarksWidth; }
+        else if (key == "faceStagesHint") { iss >> result.faceStagesHint; }
+        else if (key == "eyelidStagesHint") { iss >> result.eyelidStagesHint; }
+        else if (key == "irisStagesHint") { iss >> result.irisStagesHint; }
+        else if (key == "cost") { iss >> result.cost; }
+        // clang-format on
+    }
+
+    // Only resolved profiles are stored:
+    if ((profile < Context::kProfileLowPower) || (profile > Context::kProfileMaxAccuracy))
+    {
+        return false;
+    }
+
+    result.profile = static_cast<Context::Profile>(profile);
+    tuning = result;
+    return true;
+}
+
+bool writeTuning(const std::string& filename, const Tuning& tuning)
+{
+    std::ofstream os(filename);
+    if (!os)
+    {
+        return false;
+    }
+
+    os << "profile " << int(tuning.profile) << "\n"
+       << "faceFinderInterval " << tuning.faceFinderInterval << "\n"
+       << "minTrackHits " << tuning.minTrackHits << "\n"
+       << "maxTrackMisses " << tuning.maxTrackMisses << "\n"
+       << "doOptimizedPipeline " << tuning.doOptimizedPipeline << "\n"
+       << "doFlow " << tuning.doFlow << "\n"
+       << "doBlobs " << tuning.doBlobs << "\n"
+       << "history " << tuning.history << "\n"
+       << "landmarksWidth " << tuning.landmarksWidth << "\n"
+       << "faceStagesHint " << tuning.faceStagesHint << "\n"
+       << "eyelidStagesHint " << tuning.eyelidStagesHint << "\n"
+       << "irisStagesHint " << tuning.irisStagesHint << "\n"
+       << "cost " << tuning.cost << "\n";
+
+    return bool(os);
+}
+
+_DRISHTI_SDK_END
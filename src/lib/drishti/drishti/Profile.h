@@ -0,0 +1,63 @@
+/**
+  @file   Profile.h
+  @author David Hirvonen
+  @brief  Private tracker settings selected by the Context performance profiles.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+ */
+
+#ifndef __drishti_drishti_Profile_h__
+#define __drishti_drishti_Profile_h__ 1
+
+#include "drishti/Context.hpp"
+
+#include <string>
+
+// clang-format off
+namespace drishti { namespace eye { class EyeModelEstimator; } };
+// clang-format on
+
+_DRISHTI_SDK_BEGIN
+
+/*
+ * The FaceFinder settings and estimator hints chosen by a profile.  The automatic profile
+ * benchmarks the eye model (the dominant per frame CPU cost) once, and the resulting tuning
+ * is stored as "key value" lines so that later runs skip the benchmark.
+ */
+
+struct Tuning
+{
+    Context::Profile profile = Context::kProfileCustom;
+
+    float faceFinderInterval = 0.f; // detection interval (seconds)
+    int minTrackHits = 0;
+    int maxTrackMisses = 1;
+    bool doOptimizedPipeline = false;
+
+    bool doFlow = false;
+    bool doBlobs = false;
+    int history = 3;           // frames retained for grabs
+    int landmarksWidth = 1024; // regression image width
+    int faceStagesHint = -1;   // -1 : model default
+    int eyelidStagesHint = -1;
+    int irisStagesHint = -1;
+
+    float cost = 0.f; // benchmark: milliseconds per eye (0 : not measured)
+};
+
+Tuning getTuning(Context::Profile profile);
+
+// Milliseconds per eye for a synthetic crop, with the model defaults:
+float benchmark(drishti::eye::EyeModelEstimator& estimator, int iterations = 8);
+
+// Most accurate profile the measured cost per eye allows at frame rate:
+Context::Profile selectProfile(float milliseconds);
+
+bool readTuning(const std::string& filename, Tuning& tuning);
+bool writeTuning(const std::string& filename, const Tuning& tuning);
+
+_DRISHTI_SDK_END
+
+#endif // __drishti_drishti_Profile_h__
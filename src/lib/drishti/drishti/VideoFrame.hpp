@@ -18,8 +18,36 @@
 
 _DRISHTI_SDK_BEGIN
 
+/*
+ * A frame is either a packed 4 channel buffer/texture (kPacked, in textureFormat) or a 4:2:0 YUV
+ * camera buffer (kNV12, kNV21, kI420) described by planes[] with per row strides.  YUV frames
+ * are uploaded plane by plane and converted to RGB on the GPU, so Android (NV21) and iOS (NV12)
+ * camera buffers can be passed without a CPU color conversion or repacking.
+ */
+
 struct DRISHTI_EXPORT VideoFrame
 {
+    enum PixelFormat
+    {
+        kPacked, // textureFormat (i.e., GL_BGRA, GL_RGBA) : pixelBuffer or inputTexture
+        kNV12,   // planes[0] = Y, planes[1] = interleaved UV
+        kNV21,   // planes[0] = Y, planes[1] = interleaved VU
+        kI420    // planes[0] = Y, planes[1] = U, planes[2] = V
+    };
+
+    struct Plane
+    {
+        Plane() {}
+        Plane(void* data, int stride)
+            : data(data)
+            , stride(stride)
+        {
+        }
+
+        void* data = nullptr;
+        int stride = 0; // bytes per row, 0 for tightly packed rows
+    };
+
     VideoFrame() {}
     VideoFrame(const Vec2i& size, void* pixelBuffer, bool useRawPixels, GLuint inputTexture, GLenum textureFormat)
         : size(size)
@@ -30,11 +58,41 @@ struct DRISHTI_EXPORT VideoFrame
     {
     }
 
+    // Y + interleaved chroma (kNV12, kNV21):
+    VideoFrame(const Vec2i& size, PixelFormat format, const Plane& y, const Plane& uv, bool fullRange = false)
+        : size(size)
+        , format(format)
+        , fullRange(fullRange)
+    {
+        planes[0] = y;
+        planes[1] = uv;
+    }
+
+    // Y + U + V (kI420):
+    VideoFrame(const Vec2i& size, const Plane& y, const Plane& u, const Plane& v, bool fullRange = false)
+        : size(size)
+        , format(kI420)
+        , fullRange(fullRange)
+    {
+        planes[0] = y;
+        planes[1] = u;
+        planes[2] = v;
+    }
+
     Vec2i size;
     void* pixelBuffer = nullptr;
     bool useRawPixels = false;
     GLuint inputTexture = 0;
     GLenum textureFormat = 0;
+
+    PixelFormat format = kPacked;
+    int stride = 0;         // kPacked : bytes per pixelBuffer row, 0 for size[0] * 4
+    bool fullRange = false; // YUV : full (0-255) or video (16-235) range
+    Plane planes[3];
+
+    // Capture time in seconds on the monotonic clock (std::chrono::steady_clock, i.e. CLOCK_MONOTONIC,
+    // CACurrentMediaTime()), 0 : the time of the FaceTracker call.  Used for capture to result latency.
+    double timestamp = 0.0;
 };
 
 _DRISHTI_SDK_END
@@ -23,6 +23,8 @@
 
 _DRISHTI_SDK_BEGIN
 
+// Images are wrapped as headers over the same memory (strides are preserved, nothing is copied):
+
 template <typename T1, typename T2>
 cv::Mat_<T2> drishtiToCv(const Image<T1>& src)
 {
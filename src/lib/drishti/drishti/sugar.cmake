@@ -46,15 +46,33 @@ if(DRISHTI_BUILD_ACF)
     )
 endif()
 
+# Still image face models (CPU only)
+if(DRISHTI_BUILD_ACF AND DRISHTI_BUILD_FACE)
+  sugar_files(DRISHTI_DRISHTI_SRCS
+    FaceDetector.cpp
+    )
+  sugar_files(DRISHTI_DRISHTI_HDRS_PUBLIC
+    Face.hpp
+    FaceDetector.hpp
+    )
+  sugar_files(DRISHTI_DRISHTI_HDRS_PRIVATE
+    FaceImpl.h
+    )
+  sugar_files(DRISHTI_DRISHTI_UT
+    ut/test-FaceDetector.cpp
+    )
+endif()
+
 if(DRISHTI_BUILD_HCI)
   sugar_files(DRISHTI_DRISHTI_SRCS
     Context.cpp
     FaceTracker.cpp
+    FramePool.cpp
+    Profile.cpp
     Sensor.cpp
     )
   sugar_files(DRISHTI_DRISHTI_HDRS_PUBLIC
     Context.hpp
-    Face.hpp
     FaceTracker.hpp
     Sensor.hpp
     VideoFrame.hpp
@@ -64,6 +82,8 @@ if(DRISHTI_BUILD_HCI)
   sugar_files(DRISHTI_DRISHTI_HDRS_PRIVATE
     ContextImpl.h 
     FaceMonitorAdapter.h
+    FramePool.h
+    Profile.h
     SensorImpl.h
     )
 
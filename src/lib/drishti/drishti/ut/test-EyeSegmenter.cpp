@@ -24,6 +24,7 @@
 #include "drishti/EyeSegmenterImpl.hpp"
 #include "drishti/core/drishti_cv_cereal.h"
 #include "drishti/core/drishti_serialize.h"
+#include "drishti/core/Metrics.h"
 
 // clang-format off
 #include <cereal/archives/json.hpp>
@@ -382,6 +383,98 @@ TEST_F(EyeSegmenterTest, ImageIsWhite)
     checkValid(eye, entry.storage.size());
 }
 
+TEST_F(EyeSegmenterTest, LatencyBudget)
+{
+    const auto configurations = m_eyeSegmenter->getConfigurations();
+    ASSERT_GT(configurations.size(), 1u);
+
+    m_eyeSegmenter->calibrate(1);
+
+    // A generous budget selects the most accurate configuration:
+    m_eyeSegmenter->setLatencyBudget(1e6f);
+    EXPECT_EQ(m_eyeSegmenter->getConfiguration().targetWidth, configurations.front().targetWidth);
+    EXPECT_GT(m_eyeSegmenter->getConfiguration().cost, 0.f);
+
+    // An impossible budget falls back to the cheapest one:
+    m_eyeSegmenter->setLatencyBudget(1e-6f);
+    EXPECT_EQ(m_eyeSegmenter->getConfiguration().targetWidth, configurations.back().targetWidth);
+
+    for (auto iter = getFirstValid(); iter != m_images.end(); iter++)
+    {
+        drishti::sdk::Eye eye;
+        EXPECT_EQ((*m_eyeSegmenter)(iter->second.image, eye, iter->second.isRight), 0);
+        checkValid(eye, iter->second.storage.size());
+    }
+
+    m_eyeSegmenter->setLatencyBudget(0.f);
+    EXPECT_EQ(m_eyeSegmenter->getLatencyBudget(), 0.f);
+}
+
+TEST_F(EyeSegmenterTest, ImageBatch)
+{
+    std::vector<drishti::sdk::EyeSegmenter::ImageEye> eyes;
+    for (auto iter = m_images.begin(); iter != m_images.end(); iter++)
+    {
+        drishti::sdk::EyeSegmenter::ImageEye item;
+        item.image = iter->second.image;
+        item.isRight = iter->second.isRight;
+        eyes.push_back(item);
+    }
+
+    const int failures = (*m_eyeSegmenter)(eyes);
+
+    // Per item results match the single eye call (crops below the minimum width fail):
+    int expected = 0;
+    for (const auto& item : eyes)
+    {
+        drishti::sdk::Eye eye;
+        const int code = (*m_eyeSegmenter)(item.image, eye, item.isRight);
+        EXPECT_EQ(item.status, code);
+        expected += (code != 0);
+
+        if (code == 0)
+        {
+            checkValid(item.eye, { item.image.getCols(), item.image.getRows() });
+            EXPECT_GT(detectionScore(item.eye, eye), 0.99);
+        }
+    }
+    EXPECT_EQ(failures, expected);
+}
+
+TEST_F(EyeSegmenterTest, StridedImageView)
+{
+    ASSERT_FALSE(m_images.empty());
+    const auto& entry = m_images.rbegin()->second;
+
+    // Client owned memory with padded rows and a non zero offset:
+    const cv::Size size = entry.storage.size();
+    cv::Mat3b client(size.height + 2, size.width + 7, cv::Vec3b(0, 0, 0));
+    cv::Mat3b roi = client({ 3, 1, size.width, size.height });
+    entry.storage.copyTo(roi);
+
+    const auto view = drishti::sdk::cvToDrishti<cv::Vec3b, drishti::sdk::Vec3b>(roi);
+    ASSERT_EQ(view.getStride(), client.step[0]);
+
+    // Round trip is a header over the client pixels:
+    const auto header = drishti::sdk::drishtiToCv<drishti::sdk::Vec3b, cv::Vec3b>(view);
+    ASSERT_EQ(header.data, roi.data);
+    ASSERT_EQ(header.step[0], client.step[0]);
+
+    auto& copies = drishti::core::Metrics::getInstance().counter("hidden_copies");
+    const auto before = copies.get();
+
+    drishti::sdk::Eye eyeStrided, eyePacked;
+    const int codeStrided = (*m_eyeSegmenter)(view, eyeStrided, entry.isRight);
+    const int codePacked = (*m_eyeSegmenter)(entry.image, eyePacked, entry.isRight);
+
+    EXPECT_EQ(copies.get(), before);
+    EXPECT_EQ(codeStrided, codePacked);
+    if (codeStrided == 0)
+    {
+        EXPECT_GT(detectionScore(eyeStrided, eyePacked), 0.99);
+    }
+}
+
 #if defined(DRISHTI_BUILD_C_INTERFACE)
 TEST_F(EyeSegmenterTest, ExternCInterface)
 {
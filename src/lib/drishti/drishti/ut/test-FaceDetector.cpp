@@ -0,0 +1,99 @@
+/*! -*-c++-*-
+  @file   test-FaceDetector.cpp
+  @author David Hirvonen
+  @brief  Google test for public drishti API FaceDetector interface.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+#include "drishti/drishti/FaceDetector.hpp"
+#include "drishti/drishti/drishti_cv.hpp"
+
+#include <fstream>
+#include <memory>
+
+extern const char* sFaceDetector;
+extern const char* sFaceDetectorMean;
+extern const char* sFaceRegressor;
+extern const char* sEyeRegressor;
+extern const char* sFaceImageFilename;
+
+// clang-format off
+#define BEGIN_EMPTY_NAMESPACE namespace {
+#define END_EMPTY_NAMESPACE }
+// clang-format on
+
+BEGIN_EMPTY_NAMESPACE
+
+static std::shared_ptr<drishti::sdk::FaceDetector> create()
+{
+    // The streams only need to be in scope for the construction:
+    std::ifstream iFaceDetector(sFaceDetector, std::ios_base::binary);
+    std::ifstream iFaceRegressor(sFaceRegressor, std::ios_base::binary);
+    std::ifstream iEyeRegressor(sEyeRegressor, std::ios_base::binary);
+    std::ifstream iFaceDetectorMean(sFaceDetectorMean, std::ios_base::binary);
+
+    drishti::sdk::FaceDetector::Resources resources;
+    resources.sFaceDetector = &iFaceDetector;
+    resources.sFaceRegressor = &iFaceRegressor;
+    resources.sEyeRegressor = &iEyeRegressor;
+    resources.sFaceModel = &iFaceDetectorMean;
+
+    drishti::sdk::FaceDetector::Settings settings;
+    settings.doSingleFace = true;
+
+    auto detector = std::make_shared<drishti::sdk::FaceDetector>(resources, settings);
+    return detector->good() ? detector : nullptr;
+}
+
+TEST(FaceDetector, BatchMatchesSingle)
+{
+    cv::Mat3b image = cv::imread(sFaceImageFilename, cv::IMREAD_COLOR);
+    ASSERT_FALSE(image.empty());
+    cv::cvtColor(image, image, cv::COLOR_BGR2RGB);
+
+    auto detector = create();
+    ASSERT_NE(detector.get(), nullptr);
+
+    const auto input = drishti::sdk::cvToDrishti<cv::Vec3b, drishti::sdk::Vec3b>(image);
+
+    std::vector<drishti::sdk::Face> faces;
+    ASSERT_EQ((*detector)(input, faces), 0);
+    ASSERT_EQ(faces.size(), 1u);
+
+    // Every worker must reproduce the result of the calling thread:
+    std::vector<drishti::sdk::FaceDetector::ImageFaces> batch(8);
+    for (auto& item : batch)
+    {
+        item.image = input;
+    }
+    EXPECT_EQ((*detector)(batch), 0);
+
+    for (const auto& item : batch)
+    {
+        EXPECT_EQ(item.status, 0);
+        ASSERT_EQ(item.faces.size(), faces.size());
+        ASSERT_EQ(item.faces[0].landmarks.size(), faces[0].landmarks.size());
+        for (std::size_t i = 0; i < faces[0].landmarks.size(); i++)
+        {
+            EXPECT_FLOAT_EQ(item.faces[0].landmarks[i][0], faces[0].landmarks[i][0]);
+            EXPECT_FLOAT_EQ(item.faces[0].landmarks[i][1], faces[0].landmarks[i][1]);
+        }
+    }
+
+    // Empty images fail without affecting the rest of the batch:
+    batch[0].image = drishti::sdk::Image3b();
+    EXPECT_EQ((*detector)(batch), 1);
+    EXPECT_NE(batch[0].status, 0);
+    EXPECT_EQ(batch[1].status, 0);
+}
+
+END_EMPTY_NAMESPACE
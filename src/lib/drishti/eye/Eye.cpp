@@ -80,6 +80,7 @@ void EyeModel::clear()
     iris = {};
     irisEllipse = {};
     pupilEllipse = {};
+    invalidate();
 }
 
 void EyeModel::upsample(int eyelidFactor, int creaseFactor)
@@ -105,9 +106,7 @@ void EyeModel::upsample(int eyelidFactor, int creaseFactor)
 // Check for numerical stability (errors at very low resolution, etc)
 static bool isValid(const PointVec& contour, const PointVec& spline, float tolerance)
 {
-    PointVec contourHull;
-    cv::convexHull(contour, contourHull);
-    const cv::Rect roi = cv::boundingRect(contourHull);
+    const cv::Rect roi = cv::boundingRect(contour); // same as the bounds of the convex hull
     const cv::Point2f tl = roi.tl(), br = roi.br(), center = (tl + br) * 0.5f, diag = br - center;
     const cv::Rect2f zone(center - diag * tolerance, center + diag * tolerance);
     for (const auto& p : spline)
@@ -120,36 +119,109 @@ static bool isValid(const PointVec& contour, const PointVec& spline, float toler
     return true;
 }
 
+// Precomputed basis for the (fixed) model point count, the spline buffers are reused:
+static void refineEyelids(const EyeModel& eye, int eyelidPoints)
+{
+    if (eye.eyelids.size() > 2)
+    {
+        SplineBasis::get(int(eye.eyelids.size()), eyelidPoints, true)(eye.eyelids, eye.eyelidsSpline);
+        if (!isValid(eye.eyelids, eye.eyelidsSpline, 1.25))
+        {
+            eye.eyelidsSpline = eye.eyelids;
+        }
+    }
+}
+
+static void refineCrease(const EyeModel& eye, int creasePoints)
+{
+    if (eye.crease.size() > 2)
+    {
+        SplineBasis::get(int(eye.crease.size()), creasePoints, false)(eye.crease, eye.creaseSpline);
+        if (!isValid(eye.crease, eye.creaseSpline, 1.25f))
+        {
+            eye.creaseSpline = eye.crease;
+        }
+    }
+}
+
+static void refineIrisLandmarks(const EyeModel& eye)
+{
+    if (eye.irisEllipse.size.width)
+    {
+        cv::Point2f irisCenter, irisInner, irisOuter;
+        eye.estimateIrisLandmarks(irisCenter, irisInner, irisOuter);
+        eye.irisCenter = irisCenter;
+        eye.irisInner = irisInner;
+        eye.irisOuter = irisOuter;
+    }
+}
+
 void EyeModel::refine(int eyelidPoints, int creasePoints)
 {
     roi = cv::boundingRect(eyelids);
+    refineEyelids(*this, eyelidPoints);
     if (eyelids.size() > 2)
     {
-        eyelidsSpline.clear();
-        fitSpline(eyelids, eyelidsSpline, eyelidPoints);
-        if (!isValid(eyelids, eyelidsSpline, 1.25))
-        {
-            eyelidsSpline = eyelids;
-        }
         cornerIndices[0] = 0;
         cornerIndices[1] = int(eyelids.size()) / 2;
     }
 
-    if (crease.size() > 2)
+    refineCrease(*this, creasePoints);
+    refineIrisLandmarks(*this);
+    pending = 0;
+}
+
+void EyeModel::invalidate(int outputs)
+{
+    if (outputs & kEyelidsSpline)
+    {
+        eyelidsSpline.clear();
+    }
+    if (outputs & kCreaseSpline)
     {
         creaseSpline.clear();
-        fitSpline(crease, creaseSpline, creasePoints, false);
-        if (!isValid(crease, creaseSpline, 1.25f))
+    }
+    if (outputs & kIrisLandmarks)
+    {
+        irisCenter.has = irisInner.has = irisOuter.has = false;
+        pending &= ~kMirrored;
+    }
+    pending |= (outputs & kOutputs);
+}
+
+void EyeModel::materialize(int outputs) const
+{
+    outputs &= pending;
+    if (outputs & kEyelidsSpline)
+    {
+        refineEyelids(*this, DRISHTI_EYE_CONTOUR_POINTS);
+    }
+    if (outputs & kCreaseSpline)
+    {
+        refineCrease(*this, DRISHTI_EYE_CREASE_POINTS);
+    }
+    if (outputs & kIrisLandmarks)
+    {
+        refineIrisLandmarks(*this);
+        if ((pending & kMirrored) && irisCenter.has)
         {
-            crease = creaseSpline;
+            std::swap(irisInner, irisOuter); // same labels as landmarks flopped after refine()
         }
+        outputs |= kMirrored;
     }
+    pending &= ~outputs;
+}
+
+const std::vector<cv::Point2f>& EyeModel::getEyelidsSpline() const
+{
+    materialize(kEyelidsSpline);
+    return eyelidsSpline.size() ? eyelidsSpline : eyelids;
+}
 
-    cv::Point2f irisCenter_, irisInner_, irisOuter_;
-    estimateIrisLandmarks(irisCenter_, irisInner_, irisOuter_);
-    irisCenter = irisCenter_;
-    irisInner = irisInner_;
-    irisOuter = irisOuter_;
+const std::vector<cv::Point2f>& EyeModel::getCreaseSpline() const
+{
+    materialize(kCreaseSpline);
+    return creaseSpline.size() ? creaseSpline : crease;
 }
 
 void EyeModel::normalizeEllipse(cv::RotatedRect& ellipse)
@@ -249,7 +321,7 @@ cv::Mat EyeModel::labels(const cv::Size& size) const
         return cv::Mat1b();
     }
 
-    const auto& curve = eyelidsSpline.size() ? eyelidsSpline : eyelids;
+    const auto& curve = getEyelidsSpline();
 
     // Eye mask:
     cv::Mat1b eyeMask = cv::Mat1b::zeros(size);
@@ -273,7 +345,7 @@ cv::Mat EyeModel::mask(const cv::Size& size, bool sclera, float irisScale) const
         return mask;
     }
 
-    const auto& curve = eyelidsSpline.size() ? eyelidsSpline : eyelids;
+    const auto& curve = getEyelidsSpline();
     if (curve.size())
     {
         mask = cv::Mat1b::zeros(size);
@@ -300,12 +372,19 @@ std::vector<std::vector<cv::Point2f>> EyeModel::getContours(bool doPupil) const
 {
     std::vector<std::vector<cv::Point2f>> contours;
 
-    contours.push_back(eyelidsSpline);
+    const auto& eyelidCurve = getEyelidsSpline();
+    const auto& creaseCurve = getCreaseSpline();
+    if (doPupil)
+    {
+        materialize(kIrisLandmarks);
+    }
+
+    contours.push_back(eyelidCurve);
     contours.back().push_back(eyelids.front()); // closed contour
 
     if (irisEllipse.size.width)
     {
-        auto segments = ellipseToContours(irisEllipse, eyelidsSpline);
+        auto segments = ellipseToContours(irisEllipse, eyelidCurve);
         for (auto& s : segments)
         {
             contours.push_back(s);
@@ -314,16 +393,16 @@ std::vector<std::vector<cv::Point2f>> EyeModel::getContours(bool doPupil) const
 
     if (pupilEllipse.size.width && doPupil)
     {
-        auto segments = ellipseToContours(pupilEllipse, eyelidsSpline);
+        auto segments = ellipseToContours(pupilEllipse, eyelidCurve);
         for (auto& s : segments)
         {
             contours.push_back(s);
         }
     }
 
-    if (creaseSpline.size())
+    if (creaseCurve.size())
     {
-        contours.push_back(creaseSpline);
+        contours.push_back(creaseCurve);
     }
 
     if (irisCenter.has && doPupil)
@@ -395,6 +474,10 @@ void EyeModel::flop(int width)
         flop(irisOuter->x, width);
         std::swap(irisInner, irisOuter);
     }
+    else if (pending & kIrisLandmarks)
+    {
+        pending ^= kMirrored;
+    }
 
     innerCorner = getInnerCorner();
     outerCorner = getOuterCorner();
@@ -426,17 +509,20 @@ void EyeModel::draw(cv::Mat& canvas, int level, bool doMask, const cv::Scalar& c
         cv::rectangle(canvas, roi, color, 1, 8);
     }
 
+    const auto& eyelidCurve = getEyelidsSpline();
+    const auto& creaseCurve = getCreaseSpline();
+
     std::vector<std::vector<cv::Point>> contours(2);
-    if (eyelidsSpline.size())
+    if (eyelidCurve.size())
     {
-        std::copy(eyelidsSpline.begin(), eyelidsSpline.end(), std::back_inserter(contours[0]));
+        std::copy(eyelidCurve.begin(), eyelidCurve.end(), std::back_inserter(contours[0]));
         contours[0].push_back(contours[0].front()); // closed contour
         cv::polylines(canvas, contours, true, color, width, 8);
     }
 
-    if (creaseSpline.size())
+    if (creaseCurve.size())
     {
-        std::copy(creaseSpline.begin(), creaseSpline.end(), std::back_inserter(contours[1]));
+        std::copy(creaseCurve.begin(), creaseCurve.end(), std::back_inserter(contours[1]));
         cv::polylines(canvas, contours, false, color, width, 8);
     }
 
@@ -651,9 +737,10 @@ static std::vector<PointVec> ellipseToContours(const cv::RotatedRect& ellipse, c
 {
     std::vector<std::vector<cv::Point2f>> contours;
 
-    // Convert ellipse to contour:
-    std::vector<cv::Point2f> contour;
-    drishti::geometry::ellipse2Poly(ellipse, 1.f, contour);
+    // Convert ellipse to contour (1 degree steps):
+    static const drishti::geometry::EllipseSampler sampler(360);
+    std::vector<cv::Point2f> contour(sampler.size());
+    sampler(ellipse, contour.data());
 
     bool doCopy = true;
     if (eyelids.size())
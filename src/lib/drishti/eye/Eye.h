@@ -82,6 +82,32 @@ struct EyeModel
     static void normalizeEllipse(cv::RotatedRect& e);
     void normalize();
     void refine(int eyelidPoints = DRISHTI_EYE_CONTOUR_POINTS, int creasePoints = DRISHTI_EYE_CREASE_POINTS);
+
+    // ### On demand outputs
+
+    /*
+     * The eyelid and crease splines and the 3-point iris landmarks are derived from the
+     * eyelids, crease and iris ellipse.  invalidate() drops them and they are built (see
+     * refine()) the first time they are accessed, so consumers of the iris ellipse and openness
+     * (i.e., gaze and blink) don't pay for them.  The first access is not reentrant.
+     */
+
+    enum Output
+    {
+        kEyelidsSpline = 1,
+        kCreaseSpline = 2,
+        kIrisLandmarks = 4,
+        kOutputs = 7,
+        kMirrored = 8 // pending iris landmarks were flopped, see flop()
+    };
+
+    void invalidate(int outputs = kOutputs);
+    void materialize(int outputs = kOutputs) const;
+
+    // The spline if present, else the control points:
+    const std::vector<cv::Point2f>& getEyelidsSpline() const;
+    const std::vector<cv::Point2f>& getCreaseSpline() const;
+
     void upsample(int eyelidFactor = 2, int creaseFactor = 2);
     void clear();
 
@@ -135,18 +161,20 @@ struct EyeModel
 
     int cornerIndices[2] = { 0, 8 }; // assuming 16 point contour
     std::vector<cv::Point2f> eyelids;
-    std::vector<cv::Point2f> eyelidsSpline;
+    mutable std::vector<cv::Point2f> eyelidsSpline;
 
     core::Field<cv::Point2f> innerCorner;
     core::Field<cv::Point2f> outerCorner;
 
     std::vector<cv::Point2f> crease;
-    std::vector<cv::Point2f> creaseSpline;
+    mutable std::vector<cv::Point2f> creaseSpline;
 
     // 3-point iris estimate:
-    core::Field<cv::Point2f> irisCenter;
-    core::Field<cv::Point2f> irisInner;
-    core::Field<cv::Point2f> irisOuter;
+    mutable core::Field<cv::Point2f> irisCenter;
+    mutable core::Field<cv::Point2f> irisInner;
+    mutable core::Field<cv::Point2f> irisOuter;
+
+    mutable int pending = 0; // Output bits to build on first access
 };
 
 inline std::vector<std::vector<cv::Point2f>*> getEyeModelContours(EyeModel& dst)
@@ -212,6 +240,8 @@ inline bool operator==(const core::Field<cv::Point2f>& a, const core::Field<cv::
 
 inline bool operator==(const EyeModel& a, const EyeModel& b)
 {
+    a.materialize();
+    b.materialize();
     return (a.eyelids == b.eyelids) &&                        // contours
         (a.eyelidsSpline == b.eyelidsSpline) &&
         (a.crease == b.crease) &&
@@ -181,6 +181,7 @@ static void copy(std::vector<cv::Point2f>& points, const cv::Range& range, const
 std::vector<cv::Point2f> eyeToShape(const EyeModel& eye, const EyeModelSpecification& spec)
 {
     std::vector<cv::Point2f> points;
+    eye.materialize(EyeModel::kIrisLandmarks);
     copy(points, spec.eyelids, eye.eyelids);
     copy(points, spec.crease, eye.crease);
     copy(points, spec.irisCenter, eye.irisCenter);
@@ -8,6 +8,8 @@ DRISHTI_EYE_NAMESPACE_BEGIN
 template <class Archive>
 void EyeModel::serialize(Archive& ar, const unsigned int version)
 {
+    materialize(kIrisLandmarks); // (loaded values replace it)
+
     ar& GENERIC_NVP("roi", roi);
 
     ar& GENERIC_NVP("eyelids", eyelids);
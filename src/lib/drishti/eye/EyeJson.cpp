@@ -0,0 +1,81 @@
+/*! -*-c++-*-
+  @file   EyeJson.cpp
+  @author David Hirvonen
+  @brief  Implementation of streaming JSON I/O for eye models (cereal JSON schema).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/eye/EyeJson.h"
+#include "drishti/core/drishti_cv_json.h"
+
+DRISHTI_EYE_NAMESPACE_BEGIN
+
+void write(core::JsonWriter& os, const EyeModel& eye)
+{
+    eye.materialize(EyeModel::kIrisLandmarks);
+    os.beginObject().version<EyeModel>(1); // CEREAL_CLASS_VERSION (EyeArchiveCereal.cpp)
+    os.key("roi");
+    write(os, eye.roi);
+    os.key("eyelids");
+    write(os, eye.eyelids);
+    os.key("crease");
+    write(os, eye.crease);
+    os.key("iris");
+    write(os, eye.irisEllipse);
+    os.key("pupil");
+    write(os, eye.pupilEllipse);
+    os.key("inner");
+    write(os, eye.innerCorner);
+    os.key("outer");
+    write(os, eye.outerCorner);
+    os.key("irisCenter");
+    write(os, eye.irisCenter);
+    os.key("irisInner");
+    write(os, eye.irisInner);
+    os.key("irisOuter");
+    write(os, eye.irisOuter);
+    os.endObject();
+}
+
+bool read(core::JsonReader& is, EyeModel& eye)
+{
+    return core::readObject(is, [&](const core::JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "roi") return read(is, eye.roi);
+        if (key == "eyelids") return read(is, eye.eyelids);
+        if (key == "crease") return read(is, eye.crease);
+        if (key == "iris") return read(is, eye.irisEllipse);
+        if (key == "pupil") return read(is, eye.pupilEllipse);
+        if (key == "inner") return read(is, eye.innerCorner);
+        if (key == "outer") return read(is, eye.outerCorner);
+        if (key == "irisCenter") return read(is, eye.irisCenter);
+        if (key == "irisInner") return read(is, eye.irisInner);
+        if (key == "irisOuter") return read(is, eye.irisOuter);
+        // clang-format on
+        return is.skip();
+    });
+}
+
+std::string& toJson(const EyeModel& eye, std::string& buffer)
+{
+    buffer.clear();
+    core::JsonWriter os(buffer);
+    os.beginObject().key("eye");
+    write(os, eye);
+    os.endObject();
+    return buffer;
+}
+
+bool fromJson(const char* data, std::size_t size, EyeModel& eye)
+{
+    core::JsonReader is(data, size);
+    is.next();
+    return core::readObject(is, [&](const core::JsonReader::Key& key) -> bool {
+        return (key == "eye") ? read(is, eye) : is.skip();
+    });
+}
+
+DRISHTI_EYE_NAMESPACE_END
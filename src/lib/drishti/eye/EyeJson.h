@@ -0,0 +1,33 @@
+/*! -*-c++-*-
+  @file   EyeJson.h
+  @author David Hirvonen
+  @brief  Declaration of streaming JSON I/O for eye models (cereal JSON schema).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_eye_EyeJson_h__
+#define __drishti_eye_EyeJson_h__ 1
+
+#include "drishti/eye/drishti_eye.h"
+#include "drishti/eye/Eye.h"
+#include "drishti/core/JsonStream.h"
+
+#include <string>
+
+DRISHTI_EYE_NAMESPACE_BEGIN
+
+// Same members and order as EyeModel::serialize() (see EyeImpl.h):
+void write(core::JsonWriter& os, const EyeModel& eye);
+bool read(core::JsonReader& is, EyeModel& eye);
+
+// Document with one "eye" member (i.e., cereal JSONOutputArchive << GENERIC_NVP("eye", eye)), the
+// buffer is cleared first and its capacity is reused:
+std::string& toJson(const EyeModel& eye, std::string& buffer);
+bool fromJson(const char* data, std::size_t size, EyeModel& eye);
+
+DRISHTI_EYE_NAMESPACE_END
+
+#endif // __drishti_eye_EyeJson_h__
@@ -22,15 +22,8 @@
 
 #include <fstream>
 
-#define DRISHTI_EYE_USE_DARK_CHANNEL 0
-
 DRISHTI_EYE_NAMESPACE_BEGIN
 
-#if DRISHTI_EYE_USE_DARK_CHANNEL
-static cv::Mat getDarkChannel(const cv::Mat& I);
-#endif
-static float resizeEye(const cv::Mat& src, cv::Mat& dst, float width);
-
 EyeModelEstimator::Impl::Impl()
 {
     init();
@@ -82,33 +75,67 @@ void EyeModelEstimator::Impl::setStreamLogger(std::shared_ptr<spdlog::logger>& l
 
 // Input: grayscale for contour regression
 // Red channel is closest to NIR for iris
-// TODO: Need a lazy image conversion type
 
-int EyeModelEstimator::Impl::operator()(const cv::Mat& crop, EyeModel& eye) const
+int EyeModelEstimator::Impl::operator()(const cv::Mat& crop, EyeModel& eye, const EyeModel* prior, bool mirror) const
 {
-    cv::Mat I;
-    float scale = resizeEye(crop, I, m_targetWidth), scaleInv = (1.0 / scale);
+    return (*this)(createPyramid(crop, mirror), eye, prior);
+}
+
+int EyeModelEstimator::Impl::operator()(const EyePyramid& pyramid, EyeModel& eye, const EyeModel* prior) const
+{
+    const int cols = pyramid.getCrop().cols;
+    const bool mirror = pyramid.isMirrored();
+    const float scale = pyramid.getScale(), scaleInv = (1.0 / scale);
+
+    // Mirrored eyes are estimated in the flipped coordinate system of the model:
+    EyeModel seed;
+    if (mirror)
+    {
+        eye.flop(cols);
+        if (prior)
+        {
+            seed = *prior;
+            seed.flop(cols);
+            prior = &seed;
+        }
+    }
+
+    const EyeModel input = eye;
+
+    bool isDone = false;
+    if (prior && prior->eyelids.size())
+    {
+        // Tracking: refine the prior, and fall back to the full search if it drifts:
+        const EyeModel track = (*prior) * scale;
+        estimate(pyramid, eye, &track);
+        isDone = isTracked(eye, track);
+    }
 
-    cv::Mat Ic[3]{ I }, dark, blue, red;
-    if (I.channels() == 3)
+    if (!isDone)
     {
-        cv::split(I, Ic);
-
-#if DRISHTI_EYE_USE_DARK_CHANNEL
-        // Dark channel:
-        dark = getDarkChannel(I);
-#endif
-        blue = Ic[0];
-        red = Ic[2];
+        eye = input;
+        estimate(pyramid, eye, nullptr);
     }
-    else
+
+    // Scale up the model
+    if (scaleInv != 1.0f)
+    {
+        eye = eye * scaleInv;
+    }
+
+    if (mirror)
     {
-        //dark = I;
-        blue = red = I;
+        eye.flop(cols);
     }
 
+    return 0;
+}
+
+void EyeModelEstimator::Impl::estimate(const EyePyramid& pyramid, EyeModel& eye, const EyeModel* prior) const
+{
     // ######## Find the eyelids #########
-    segmentEyelids(blue, eye);
+    segmentEyelids(pyramid.getBlue(), eye, prior);
+    eye.invalidate(EyeModel::kEyelidsSpline | EyeModel::kCreaseSpline); // built on first access
 
     if (m_doIndependentIrisAndPupil)
     {
@@ -118,16 +145,10 @@ int EyeModelEstimator::Impl::operator()(const cv::Mat& crop, EyeModel& eye) cons
             // ((((( Do iris estimate )))))
             if (m_irisEstimator)
             {
-                segmentIris(red, eye);
+                segmentIris(pyramid.getRed(), eye, prior);
 
-                {
-                    // If point-wise estimates match the iris regressor, then update our landmarks
-                    cv::Point2f irisCenter, innerLimbus, outerLimbus;
-                    eye.estimateIrisLandmarks(irisCenter, innerLimbus, outerLimbus);
-                    eye.irisCenter = irisCenter;
-                    eye.irisInner = innerLimbus;
-                    eye.irisOuter = outerLimbus;
-                }
+                // Landmarks of the regressor are replaced by the iris ellipse estimate (on first access):
+                eye.invalidate(EyeModel::kIrisLandmarks);
 
                 eye.iris = 0.f; // drop the circular initial estimate
                 eye.pupil = 0.f;
@@ -135,7 +156,7 @@ int EyeModelEstimator::Impl::operator()(const cv::Mat& crop, EyeModel& eye) cons
 
                 if (m_pupilEstimator && m_doPupil && eye.irisEllipse.size.area() > 0.f)
                 {
-                    segmentPupil(red, eye);
+                    segmentPupil(pyramid, eye);
                 }
             }
         }
@@ -146,14 +167,42 @@ int EyeModelEstimator::Impl::operator()(const cv::Mat& crop, EyeModel& eye) cons
             eye.pupilEllipse.center = eye.irisEllipse.center;
         }
     }
+}
 
-    // Scale up the model
-    if (scaleInv != 1.0f)
+// Confidence check for tracking: the mean eyelid point and the iris center must stay
+// within m_trackingTolerance (fraction of the eye width) of the prior:
+bool EyeModelEstimator::Impl::isTracked(const EyeModel& eye, const EyeModel& prior) const
+{
+    if (eye.eyelids.empty() || (eye.eyelids.size() != prior.eyelids.size()))
     {
-        eye = eye * scaleInv;
+        return false;
     }
 
-    return 0;
+    const float tolerance = m_trackingTolerance * static_cast<float>(cv::boundingRect(prior.eyelids).width);
+
+    float distance = 0.f;
+    for (int i = 0; i < eye.eyelids.size(); i++)
+    {
+        distance += cv::norm(eye.eyelids[i] - prior.eyelids[i]);
+    }
+    if ((distance / static_cast<float>(eye.eyelids.size())) > tolerance)
+    {
+        return false;
+    }
+
+    if ((eye.irisEllipse.size.area() > 0.f) && (prior.irisEllipse.size.area() > 0.f))
+    {
+        return (cv::norm(eye.irisEllipse.center - prior.irisEllipse.center) <= tolerance);
+    }
+
+    return true;
+}
+
+ml::ShapeEstimator::Context EyeModelEstimator::Impl::getTrackingContext(const ml::ShapeEstimator::Context& context) const
+{
+    auto tracking = context;
+    tracking.stages = std::min(context.stages, m_trackingStagesHint);
+    return tracking;
 }
 
 //====
@@ -179,6 +228,17 @@ EyeModelEstimator::EyeModelEstimator(const RegressorConfig& config)
 
 EyeModelEstimator::~EyeModelEstimator() {}
 
+std::unique_ptr<EyeModelEstimator> EyeModelEstimator::clone() const
+{
+    auto estimator = drishti::core::make_unique<EyeModelEstimator>();
+    if (m_impl)
+    {
+        estimator->m_impl = drishti::core::make_unique<EyeModelEstimator::Impl>(*m_impl);
+    }
+    estimator->m_streamLogger = m_streamLogger;
+    return estimator;
+}
+
 void EyeModelEstimator::setDoIndependentIrisAndPupil(bool flag)
 {
     m_impl->setDoIndependentIrisAndPupil(flag);
@@ -194,6 +254,16 @@ EyeModelEstimator::operator bool() const
     return good();
 }
 
+core::MemoryUsage EyeModelEstimator::memoryUsage() const
+{
+    return m_impl ? m_impl->memoryUsage() : core::MemoryUsage();
+}
+
+void EyeModelEstimator::setThreads(const ThreadPoolPtr& threads)
+{
+    m_impl->setThreads(threads);
+}
+
 void EyeModelEstimator::setStreamLogger(std::shared_ptr<spdlog::logger>& logger)
 {
     m_streamLogger = logger;
@@ -208,11 +278,37 @@ int EyeModelEstimator::operator()(const cv::Mat& crop, EyeModel& eye) const
     return (*m_impl)(crop, eye);
 }
 
+int EyeModelEstimator::operator()(const cv::Mat& crop, EyeModel& eye, const EyeModel& prior) const
+{
+    return (*m_impl)(crop, eye, &prior);
+}
+
+int EyeModelEstimator::operator()(const cv::Mat& crop, EyeModel& eye, const EyeModel* prior, bool mirror) const
+{
+    return (*m_impl)(crop, eye, prior, mirror);
+}
+
+EyePyramid EyeModelEstimator::createPyramid(const cv::Mat& crop, bool mirror) const
+{
+    return m_impl->createPyramid(crop, mirror);
+}
+
+int EyeModelEstimator::operator()(const EyePyramid& pyramid, EyeModel& eye, const EyeModel* prior) const
+{
+    return (*m_impl)(pyramid, eye, prior);
+}
+
 void EyeModelEstimator::normalize(const cv::Mat& crop, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, int padding) const
 {
     return m_impl->normalize(crop, eye, size, code, padding);
 }
 
+// The single ellipso-polar remap samples the full resolution (unmirrored) crop:
+void EyeModelEstimator::normalize(const EyePyramid& pyramid, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, int padding) const
+{
+    return m_impl->normalize(pyramid.getCrop(), eye, size, code, padding);
+}
+
 void EyeModelEstimator::setEyelidInits(int n)
 {
     m_impl->setEyelidInits(n);
@@ -233,6 +329,56 @@ int EyeModelEstimator::getIrisInits() const
     return m_impl->getIrisInits();
 }
 
+void EyeModelEstimator::setIrisConsensusInits(int n)
+{
+    m_impl->setIrisConsensusInits(n);
+}
+
+int EyeModelEstimator::getIrisConsensusInits() const
+{
+    return m_impl->getIrisConsensusInits();
+}
+
+void EyeModelEstimator::setIrisConsensusTolerance(float tolerance)
+{
+    m_impl->setIrisConsensusTolerance(tolerance);
+}
+
+float EyeModelEstimator::getIrisConsensusTolerance() const
+{
+    return m_impl->getIrisConsensusTolerance();
+}
+
+void EyeModelEstimator::setTrackingStagesHint(int stages)
+{
+    m_impl->setTrackingStagesHint(stages);
+}
+
+int EyeModelEstimator::getTrackingStagesHint() const
+{
+    return m_impl->getTrackingStagesHint();
+}
+
+void EyeModelEstimator::setTrackingTolerance(float tolerance)
+{
+    m_impl->setTrackingTolerance(tolerance);
+}
+
+float EyeModelEstimator::getTrackingTolerance() const
+{
+    return m_impl->getTrackingTolerance();
+}
+
+void EyeModelEstimator::setNormalizationCacheSize(std::size_t size)
+{
+    m_impl->setNormalizationCacheSize(size);
+}
+
+std::size_t EyeModelEstimator::getNormalizationCacheSize() const
+{
+    return m_impl->getNormalizationCacheSize();
+}
+
 void EyeModelEstimator::setOptimizationLevel(int level)
 {
     m_impl->setOptimizationLevel(level);
@@ -316,30 +462,22 @@ int EyeModelEstimator::getIrisStagesHint() const
     return m_impl->getIrisStagesHint();
 }
 
-static float resizeEye(const cv::Mat& src, cv::Mat& dst, float width)
+void EyeModelEstimator::setEyelidConvergenceThreshold(float threshold)
 {
-    float scale = 1.f;
-    if (src.cols < width)
-    {
-        dst = src;
-    }
-    else
-    {
-        scale = float(width) / float(src.cols);
-        cv::resize(src, dst, {}, scale, scale, cv::INTER_CUBIC);
-    }
-    return scale;
+    m_impl->setEyelidConvergenceThreshold(threshold);
+}
+float EyeModelEstimator::getEyelidConvergenceThreshold() const
+{
+    return m_impl->getEyelidConvergenceThreshold();
 }
 
-#if DRISHTI_EYE_USE_DARK_CHANNEL
-static cv::Mat getDarkChannel(const cv::Mat& I)
+void EyeModelEstimator::setIrisConvergenceThreshold(float threshold)
+{
+    m_impl->setIrisConvergenceThreshold(threshold);
+}
+float EyeModelEstimator::getIrisConvergenceThreshold() const
 {
-    cv::Mat dark;
-    cv::Mat Ic = I.isContinuous() ? I : I.clone();
-    cv::reduce(Ic.reshape(1, I.size().area()), dark, 1, CV_REDUCE_MIN);
-    dark = dark.reshape(1, I.rows);
-    return dark;
+    return m_impl->getIrisConvergenceThreshold();
 }
-#endif
 
 DRISHTI_EYE_NAMESPACE_END
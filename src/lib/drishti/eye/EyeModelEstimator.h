@@ -17,8 +17,12 @@
 #include "drishti/core/drishti_defs.hpp"
 #include "drishti/eye/drishti_eye.h"
 #include "drishti/eye/Eye.h"
+#include "drishti/eye/EyePyramid.h"
 #include "drishti/eye/NormalizedIris.h"
 #include "drishti/core/Logger.h"
+#include "drishti/core/MemoryUsage.h"
+
+#include "drishti/core/Executor.h"
 
 #include <memory>
 
@@ -40,19 +44,44 @@ public:
     EyeModelEstimator(const RegressorConfig& config);
     ~EyeModelEstimator();
 
+    //! Lightweight copy (i.e., one per thread) that shares the read only models of this instance:
+    std::unique_ptr<EyeModelEstimator> clone() const;
+
     bool good() const;
     operator bool() const;
 
+    // Heap footprint of the eyelid, iris and pupil models and the iris remap cache:
+    core::MemoryUsage memoryUsage() const;
+
     void setStreamLogger(std::shared_ptr<spdlog::logger>& logger);
 
+    // Evaluate pupil and iris candidates on a shared pool instead of the OpenCV pool (nested
+    // calls from tasks of the same pool are safe, i.e., one eye job per worker):
+    using ThreadPoolPtr = std::shared_ptr<drishti::core::Executor>;
+    void setThreads(const ThreadPoolPtr& threads);
+
     virtual int operator()(const cv::Mat& crop, EyeModel& eye) const;
 
+    // Tracking mode for video: start from prior (i.e., the previous result mapped to crop) with a
+    // single initialization and at most getTrackingStagesHint() stages per cascade, falling back
+    // to the full search if the result moves more than the tracking tolerance from the prior:
+    int operator()(const cv::Mat& crop, EyeModel& eye, const EyeModel& prior) const;
+
+    // Batch friendly variant: mirrored eyes (i.e., a left eye for a right eye model) are estimated
+    // without flipping the crop, eye and prior (optional) are in the crop coordinate system:
+    int operator()(const cv::Mat& crop, EyeModel& eye, const EyeModel* prior, bool mirror) const;
+
+    // Per call pyramid at the target width, built once and shared by all stages (and normalize()):
+    EyePyramid createPyramid(const cv::Mat& crop, bool mirror = false) const;
+    int operator()(const EyePyramid& pyramid, EyeModel& eye, const EyeModel* prior = nullptr) const;
+
     void setOpennessThreshold(float threshold);
     float getOpennessThreshold() const;
 
     static cv::RotatedRect estimateIrisFromLimbusPoints(const EyeModel& eye);
 
     void normalize(const cv::Mat& crop, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, int padding = 0) const;
+    void normalize(const EyePyramid& pyramid, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, int padding = 0) const;
 
     void setDoIndependentIrisAndPupil(bool flag);
 
@@ -66,12 +95,36 @@ public:
     void setIrisStagesHint(int stages);
     int getIrisStagesHint() const;
 
+    // Early cascade termination on small shape updates (0 : disabled):
+    void setEyelidConvergenceThreshold(float threshold);
+    float getEyelidConvergenceThreshold() const;
+
+    void setIrisConvergenceThreshold(float threshold);
+    float getIrisConvergenceThreshold() const;
+
     void setEyelidInits(int n);
     int getEyelidInits() const;
 
     void setIrisInits(int n);
     int getIrisInits() const;
 
+    // Skip the remaining iris inits when the first n agree within tolerance (0 : disabled):
+    void setIrisConsensusInits(int n);
+    int getIrisConsensusInits() const;
+
+    void setIrisConsensusTolerance(float tolerance); // fraction of the iris diameter
+    float getIrisConsensusTolerance() const;
+
+    void setTrackingStagesHint(int stages);
+    int getTrackingStagesHint() const;
+    void setTrackingTolerance(float tolerance); // fraction of the eye width
+    float getTrackingTolerance() const;
+
+    // Cache the ellipso-polar remap tables of the last size (quantized) pupil/iris pairs used
+    // by normalize(), i.e., for tracked eyes (0 : disabled):
+    void setNormalizationCacheSize(std::size_t size);
+    std::size_t getNormalizationCacheSize() const;
+
     cv::Mat drawMeanShape(const cv::Size& size) const;
 
     bool getDoMask() const;
@@ -15,7 +15,9 @@
 #include "drishti/eye/IrisNormalizer.h"
 #include "drishti/eye/EyeIO.h"
 #include "drishti/ml/ShapeEstimator.h"
+#include "drishti/rcpr/drishti_rcpr.h"
 #include "drishti/core/Parallel.h"
+#include "drishti/core/ParallelFor.h"
 #include "drishti/core/Shape.h"
 #include "drishti/core/timing.h"
 #include "drishti/core/Logger.h"
@@ -25,6 +27,12 @@
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
+#include <algorithm>
+
+DRISHTI_RCPR_NAMESPACE_BEGIN
+class CPR;
+DRISHTI_RCPR_NAMESPACE_END
+
 DRISHTI_EYE_NAMESPACE_BEGIN
 
 using EllipseVec = std::vector<cv::RotatedRect>;
@@ -42,27 +50,88 @@ public:
 
     Impl(const std::string& eyeRegressor, const std::string& irisRegressor = {}, const std::string& pupilRegressor = {});
 
+    // Copy the settings and share the (read only) estimators:
+    Impl(const Impl& src) = default;
+
     ~Impl();
 
     void init();
 
     void setStreamLogger(std::shared_ptr<spdlog::logger>& logger);
 
+    void setThreads(const ThreadPoolPtr& threads)
+    {
+        m_threads = threads;
+    }
+
+    core::MemoryUsage memoryUsage() const
+    {
+        core::MemoryUsage usage;
+
+        // The pupil and iris models can be the same instance:
+        std::vector<const ml::ShapeEstimator*> seen;
+        const auto add = [&](const char* name, const std::shared_ptr<ml::ShapeEstimator>& estimator) {
+            if (estimator && (std::find(seen.begin(), seen.end(), estimator.get()) == seen.end()))
+            {
+                seen.push_back(estimator.get());
+                usage.add(name, estimator->memoryUsage());
+            }
+        };
+        add("eyelids", m_eyeEstimator);
+        add("iris", m_irisEstimator);
+        add("pupil", m_pupilEstimator);
+
+        usage.add("normalizer", m_normalizer.getMemoryUsage());
+        return usage;
+    }
+
+    // Run function(i) for i in [0,n) on the shared pool, or the OpenCV pool by default:
+    template <typename Callable>
+    void parallel(int n, Callable&& function) const
+    {
+        if (m_threads)
+        {
+            core::parallel_for(m_threads.get(), n, std::forward<Callable>(function));
+        }
+        else
+        {
+            core::ParallelHomogeneousLambda harness = std::forward<Callable>(function);
+            cv::parallel_for_({ 0, n }, harness);
+        }
+    }
+
+    // Stage and convergence settings are stored per instance (see clone()) and passed to the shared estimators:
     void setEyelidStagesHint(int stages)
     {
-        m_eyeEstimator->setStagesHint(stages);
+        m_eyelidContext.stages = stages;
     }
     int getEyelidStagesHint() const
     {
-        return m_eyeEstimator->getStagesHint();
+        return m_eyelidContext.stages;
     }
     void setIrisStagesHint(int stages)
     {
-        m_irisEstimator->setStagesHint(stages);
+        m_irisContext.stages = stages;
     }
     int getIrisStagesHint() const
     {
-        return m_irisEstimator->getStagesHint();
+        return m_irisContext.stages;
+    }
+    void setEyelidConvergenceThreshold(float threshold)
+    {
+        m_eyelidContext.convergence = threshold;
+    }
+    float getEyelidConvergenceThreshold() const
+    {
+        return m_eyelidContext.convergence;
+    }
+    void setIrisConvergenceThreshold(float threshold)
+    {
+        m_irisContext.convergence = threshold;
+    }
+    float getIrisConvergenceThreshold() const
+    {
+        return m_irisContext.convergence;
     }
     void setEyelidInits(int n)
     {
@@ -82,11 +151,34 @@ public:
         return m_irisInits;
     }
 
+    void setIrisConsensusInits(int n)
+    {
+        m_irisConsensusInits = n;
+    }
+    int getIrisConsensusInits() const
+    {
+        return m_irisConsensusInits;
+    }
+
+    void setIrisConsensusTolerance(float tolerance)
+    {
+        m_irisConsensusTolerance = tolerance;
+    }
+    float getIrisConsensusTolerance() const
+    {
+        return m_irisConsensusTolerance;
+    }
+
     void setTargetWidth(int width)
     {
         m_targetWidth = width;
     }
 
+    EyePyramid createPyramid(const cv::Mat& crop, bool mirror = false) const
+    {
+        return EyePyramid(crop, m_targetWidth, mirror);
+    }
+
     void setDoPupil(bool flag)
     {
         m_doPupil = flag;
@@ -105,14 +197,41 @@ public:
         return m_opennessThrehsold;
     }
 
+    void setTrackingStagesHint(int stages)
+    {
+        m_trackingStagesHint = stages;
+    }
+    int getTrackingStagesHint() const
+    {
+        return m_trackingStagesHint;
+    }
+    void setTrackingTolerance(float tolerance)
+    {
+        m_trackingTolerance = tolerance;
+    }
+    float getTrackingTolerance() const
+    {
+        return m_trackingTolerance;
+    }
+
+    void setNormalizationCacheSize(std::size_t size)
+    {
+        m_normalizer.setCacheSize(size);
+    }
+    std::size_t getNormalizationCacheSize() const
+    {
+        return m_normalizer.getCacheSize();
+    }
+
     // Input: grayscale for contour regression
     // Red channel is closest to NIR for iris
-    // TODO: Need a lazy image conversion type
-    int operator()(const cv::Mat& crop, EyeModel& eye) const;
+    // The optional prior (crop coordinates) starts a single reduced cascade (see setTrackingStagesHint()):
+    int operator()(const cv::Mat& crop, EyeModel& eye, const EyeModel* prior = nullptr, bool mirror = false) const;
+    int operator()(const EyePyramid& pyramid, EyeModel& eye, const EyeModel* prior = nullptr) const;
 
     void normalize(const cv::Mat& crop, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, int padding = 0) const
     {
-        IrisNormalizer()(crop, eye, size, code, padding);
+        m_normalizer(crop, eye, size, code, padding);
     }
 
     cv::Mat drawMeanShape(const cv::Size& size) const
@@ -182,17 +301,43 @@ public:
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version)
     {
-        ar& m_eyeEstimator;
-        ar& m_irisEstimator;
-        ar& m_pupilEstimator;
+        serializeEstimator(ar, m_eyeEstimator);
+        serializeEstimator(ar, m_irisEstimator);
+        serializeEstimator(ar, m_pupilEstimator);
+    }
+
+    // Estimators are archived as std::unique_ptr<> (the original format) and shared after loading:
+    template <class Archive>
+    static void serializeEstimator(Archive& ar, std::shared_ptr<ml::ShapeEstimator>& estimator)
+    {
+        if (Archive::is_loading::value)
+        {
+            std::unique_ptr<ml::ShapeEstimator> ptr;
+            ar& ptr;
+            estimator = std::move(ptr);
+        }
+        else
+        {
+            struct NoDelete
+            {
+                void operator()(ml::ShapeEstimator*) const {}
+            };
+            std::unique_ptr<ml::ShapeEstimator, NoDelete> ptr(estimator.get());
+            ar& ptr;
+        }
     }
 
 private:
     cv::RotatedRect estimateCentralIris(const cv::Mat& I, const cv::Mat& M, const EllipseVec& irses) const;
+    void regressIrises(const drishti::rcpr::CPR& cpr, const cv::Mat& I, const cv::Mat& M, std::vector<PointVec>& points, int begin, int end) const;
+
+    void segmentPupil(const EyePyramid& pyramid, EyeModel& eye, int targetWidth = 128) const;
+    void estimate(const EyePyramid& pyramid, EyeModel& eye, const EyeModel* prior) const;
+    bool isTracked(const EyeModel& eye, const EyeModel& prior) const;
+    ml::ShapeEstimator::Context getTrackingContext(const ml::ShapeEstimator::Context& context) const;
 
-    void segmentPupil(const cv::Mat& I, EyeModel& eye, int targetWidth = 128) const;
-    void segmentIris(const cv::Mat& I, EyeModel& eye) const;
-    void segmentEyelids(const cv::Mat& I, EyeModel& eye) const;
+    void segmentIris(const cv::Mat& I, EyeModel& eye, const EyeModel* prior = nullptr) const;
+    void segmentEyelids(const cv::Mat& I, EyeModel& eye, const EyeModel* prior = nullptr) const;
     void segmentEyelids_(const cv::Mat& I, EyeModel& eye) const; // deprecated (shape based jitter)
     std::vector<std::vector<cv::Point2f>> createInitialEyelidPoses() const;
 
@@ -207,6 +352,12 @@ protected:
     bool m_doVerbose = false;
     int m_eyelidInits = 1;
     int m_irisInits = 1;
+    int m_irisConsensusInits = 0;          // 0 : always run all m_irisInits
+    float m_irisConsensusTolerance = 0.05f; // fraction of the iris diameter
+    int m_trackingStagesHint = std::numeric_limits<int>::max(); // cascade stages for tracking
+    float m_trackingTolerance = 0.1f;                           // fraction of the eye width
+
+    IrisNormalizer m_normalizer; // remap table cache is shared with clones
 
     float m_opennessThrehsold = EYE_OPENNESS_IRIS_THRESHOLD;
 
@@ -215,11 +366,17 @@ protected:
     bool m_doPupil = true;
     bool m_doIndependentIrisAndPupil = true;
 
-    std::unique_ptr<ml::ShapeEstimator> m_eyeEstimator;
-    std::unique_ptr<ml::ShapeEstimator> m_irisEstimator;
-    std::unique_ptr<ml::ShapeEstimator> m_pupilEstimator;
+    ml::ShapeEstimator::Context m_eyelidContext;
+    ml::ShapeEstimator::Context m_irisContext;
+
+    // Read only during inference, so they can be shared by clones in any number of threads:
+    std::shared_ptr<ml::ShapeEstimator> m_eyeEstimator;
+    std::shared_ptr<ml::ShapeEstimator> m_irisEstimator;
+    std::shared_ptr<ml::ShapeEstimator> m_pupilEstimator;
 
     std::shared_ptr<spdlog::logger> m_streamLogger;
+
+    ThreadPoolPtr m_threads; // optional (shared) pool for candidate evaluation
 };
 
 template <class Archive>
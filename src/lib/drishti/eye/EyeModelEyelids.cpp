@@ -38,8 +38,20 @@ static void drawEyes(const cv::Mat& I, const std::vector<EyeModel>& eyes, const
 static std::vector<EyeModel> shapesToEyes(const std::vector<PointVec>& shapes, const EyeModelSpecification& spec, const cv::Matx33f& S);
 #endif
 
-void EyeModelEstimator::Impl::segmentEyelids(const cv::Mat& I, EyeModel& eye) const
+void EyeModelEstimator::Impl::segmentEyelids(const cv::Mat& I, EyeModel& eye, const EyeModel* prior) const
 {
+    if (prior)
+    {
+        // Single initialization from the prior in the normalized coordinates of the mean shape:
+        const cv::Matx33f N = cv::Matx33f::diag({ 1.f / static_cast<float>(I.cols), 1.f / static_cast<float>(I.rows), 1.f });
+        PointVec pose = eyeToShape(N * (*prior), m_eyeSpec);
+
+        std::vector<bool> mask;
+        (*m_eyeEstimator)(I, pose, mask, getTrackingContext(m_eyelidContext));
+        eye = shapeToEye(pose, m_eyeSpec);
+        return;
+    }
+
     PointVec mu = m_eyeEstimator->getMeanShape();
 
     cv::Rect roi({ 0, 0 }, I.size());
@@ -55,7 +67,7 @@ void EyeModelEstimator::Impl::segmentEyelids(const cv::Mat& I, EyeModel& eye) co
     std::vector<bool> mask; // occlusion mask
     for (int i = 0; i < rois.size(); i++)
     {
-        (*m_eyeEstimator)(I(rois[i]), poses[i], mask);
+        (*m_eyeEstimator)(I(rois[i]), poses[i], mask, m_eyelidContext);
         cv::Point2f shift = rois[i].tl();
         for (auto& p : poses[i])
         {
@@ -97,7 +109,7 @@ void EyeModelEstimator::Impl::segmentEyelids_(const cv::Mat& I, EyeModel& eye) c
     std::vector<bool> mask; // occlusion mask
     for (int i = 0; i < poses.size(); i++)
     {
-        (*m_eyeEstimator)(I, poses[i], mask);
+        (*m_eyeEstimator)(I, poses[i], mask, m_eyelidContext);
     }
 
     // Get median of poses:
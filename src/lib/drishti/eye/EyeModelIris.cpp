@@ -15,6 +15,8 @@
 #include "drishti/rcpr/CPR.h"
 #include "drishti/core/drishti_stdlib_string.h" // FIRST
 
+#include <thread>
+
 DRISHTI_EYE_NAMESPACE_BEGIN
 
 #define DRISHTI_CPR_DEBUG_PHI_ESTIMATE 0
@@ -31,7 +33,7 @@ static void drawIrisEstimates(const cv::Mat& I, const EllipseVec& irises, const
 
 static void jitter(cv::RNG& rng, const EyeModel& eye, const geometry::UniformSimilarityParams& params, EllipseVec& irises, int n);
 
-void EyeModelEstimator::Impl::segmentIris(const cv::Mat& I, EyeModel& eye) const
+void EyeModelEstimator::Impl::segmentIris(const cv::Mat& I, EyeModel& eye, const EyeModel* prior) const
 {
     // Find transformation mapping mean iris to our image:
     auto cpr = dynamic_cast<drishti::rcpr::CPR*>(m_irisEstimator.get());
@@ -43,6 +45,17 @@ void EyeModelEstimator::Impl::segmentIris(const cv::Mat& I, EyeModel& eye) const
         M = eye.mask(I.size(), false);
     }
 
+    if (prior && (prior->irisEllipse.size.area() > 0.f))
+    {
+        // Single initialization from the prior:
+        std::vector<bool> mask;
+        std::vector<cv::Point2f> points = geometry::ellipseToPoints(prior->irisEllipse);
+        (*m_irisEstimator)(I, M, points, mask, getTrackingContext(m_irisContext));
+        eye.iris = 0;
+        eye.irisEllipse = geometry::pointsToEllipse(points);
+        return;
+    }
+
     // Initial iris estimates:
     EllipseVec irises{ { eye.irisEllipse.center, eye.irisEllipse.size, cpr->getPStar().angle } };
 
@@ -64,12 +77,55 @@ void EyeModelEstimator::Impl::segmentIris(const cv::Mat& I, EyeModel& eye) const
     {
         std::vector<bool> mask;
         std::vector<cv::Point2f> points = geometry::ellipseToPoints(irises[0]);
-        (*m_irisEstimator)(I, M, points, mask);
+        (*m_irisEstimator)(I, M, points, mask, m_irisContext);
         eye.iris = 0;
         eye.irisEllipse = geometry::pointsToEllipse(points);
     }
 }
 
+// Regress irises [begin,end) as parallel batches (one per thread) over the shared or OpenCV pool:
+void EyeModelEstimator::Impl::regressIrises(const drishti::rcpr::CPR& cpr, const cv::Mat& I, const cv::Mat& M, std::vector<PointVec>& points, int begin, int end) const
+{
+    const int n = end - begin;
+    const int threads = m_threads ? (m_threads->size() + 1) : cv::getNumThreads(); // helpers + caller
+    const int batches = std::max(1, std::min(n, threads));
+
+    parallel(batches, [&](int b) {
+        const auto first = points.begin() + begin + (n * b) / batches;
+        const auto last = points.begin() + begin + (n * (b + 1)) / batches;
+
+        std::vector<PointVec> batch(first, last);
+        cpr(I, M, batch, m_irisContext);
+        std::copy(batch.begin(), batch.end(), first);
+    });
+}
+
+// Do the (5 parameter) estimates agree with their median within a fraction of the iris size?
+static bool isConsensus(const std::vector<rcpr::Vector1d>& params, int n, float tolerance)
+{
+    std::vector<cv::RotatedRect> ellipses(n);
+    std::vector<float> x(n), y(n), width(n);
+    for (int i = 0; i < n; i++)
+    {
+        ellipses[i] = rcpr::phiToEllipse({ params[0][i], params[1][i], params[2][i], params[3][i], params[4][i] });
+        x[i] = ellipses[i].center.x;
+        y[i] = ellipses[i].center.y;
+        width[i] = std::max(ellipses[i].size.width, ellipses[i].size.height);
+    }
+
+    const cv::Point2f center(geometry::median(x), geometry::median(y));
+    const float size = geometry::median(width);
+    for (const auto& e : ellipses)
+    {
+        const float diameter = std::max(e.size.width, e.size.height);
+        if ((cv::norm(e.center - center) > (tolerance * size)) || (std::abs(diameter - size) > (tolerance * size)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 cv::RotatedRect
 EyeModelEstimator::Impl::estimateCentralIris(const cv::Mat& I, const cv::Mat& M, const EllipseVec& irises) const
 {
@@ -77,30 +133,47 @@ EyeModelEstimator::Impl::estimateCentralIris(const cv::Mat& I, const cv::Mat& M,
     EllipseVec estimates;
 #endif
 
-    std::vector<rcpr::Vector1d> params(5, rcpr::Vector1d(irises.size()));
+    auto cpr = dynamic_cast<drishti::rcpr::CPR*>(m_irisEstimator.get());
+    CV_Assert(cpr != nullptr);
 
-    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
-        // Find iris:
-        std::vector<bool> mask;
-        std::vector<cv::Point2f> points = geometry::ellipseToPoints(irises[i]);
-        (*m_irisEstimator)(I, M, points, mask);
+    std::vector<std::vector<cv::Point2f>> points(irises.size());
+    for (int i = 0; i < irises.size(); i++)
+    {
+        points[i] = geometry::ellipseToPoints(irises[i]);
+    }
 
-        rcpr::Vector1d phi = drishti::rcpr::ellipseToPhi(geometry::pointsToEllipse(points));
-        for (int j = 0; j < 5; j++)
+    m_irisEstimator->setDoPreview(true);
+
+    // Run the first m_irisConsensusInits initializations, and stop there if they already agree:
+    const int inits = int(irises.size());
+    const int first = (m_irisConsensusInits > 0) ? std::min(m_irisConsensusInits, inits) : inits;
+
+    std::vector<rcpr::Vector1d> params(5, rcpr::Vector1d(inits));
+    auto collect = [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
         {
-            params[j][i] = phi[j];
-        }
+            rcpr::Vector1d phi = drishti::rcpr::ellipseToPhi(geometry::pointsToEllipse(points[i]));
+            for (int j = 0; j < 5; j++)
+            {
+                params[j][i] = phi[j];
+            }
 
 #if DRISHTI_CPR_DEBUG_PHI_ESTIMATE
-        estimates.push_back(drishti::rcpr::phiToEllipse(phi));
+            estimates.push_back(drishti::rcpr::phiToEllipse(phi));
 #endif
+        }
     };
 
-    m_irisEstimator->setDoPreview(true);
+    regressIrises(*cpr, I, M, points, 0, first);
+    collect(0, first);
 
-    // XGBoost is not reentrant:
-    harness({ 0, int(irises.size()) });
-//cv::parallel_for_({0, int(irises.size())}, harness, 2);
+    int count = first;
+    if ((first < inits) && !isConsensus(params, first, m_irisConsensusTolerance))
+    {
+        regressIrises(*cpr, I, M, points, first, inits);
+        collect(first, inits);
+        count = inits;
+    }
 
 #if DRISHTI_CPR_DEBUG_PHI_ESTIMATE
     drawIrisEstimates(I, estimates, "iris-out");
@@ -110,6 +183,7 @@ EyeModelEstimator::Impl::estimateCentralIris(const cv::Mat& I, const cv::Mat& M,
     rcpr::Vector1d model(5);
     for (int i = 0; i < 5; i++)
     {
+        params[i].resize(count);
         model[i] = geometry::median(params[i]);
     }
     return rcpr::phiToEllipse(model);
@@ -19,14 +19,19 @@
 
 DRISHTI_EYE_NAMESPACE_BEGIN
 
-void EyeModelEstimator::Impl::segmentPupil(const cv::Mat& I, EyeModel& eye, int targetWidth) const
+void EyeModelEstimator::Impl::segmentPupil(const EyePyramid& pyramid, EyeModel& eye, int targetWidth) const
 {
     CV_Assert(eye.irisEllipse.size.width > 0);
 
+    // Crop from the coarsest level that still covers targetWidth, so the iris is resampled once:
+    float level = 1.f;
+    const float extent = std::max(eye.irisEllipse.size.width, eye.irisEllipse.size.height);
+    const cv::Mat& I = pyramid.getRed(float(targetWidth) / extent, level);
+
     // Create a tight crop on the iris
-    const float radius = std::max(eye.irisEllipse.size.width, eye.irisEllipse.size.height);
+    const float radius = extent * level;
     const cv::Point2f diag(radius * 0.5f, radius * 0.5f);
-    const cv::Point2f center = eye.irisEllipse.center;
+    const cv::Point2f center = eye.irisEllipse.center * level;
     const cv::Rect roi(center - (diag * 1.0f), center + (diag * 1.0f));
 
     cv::Mat crop;
@@ -65,7 +70,7 @@ void EyeModelEstimator::Impl::segmentPupil(const cv::Mat& I, EyeModel& eye, int
 
     std::vector<rcpr::Vector1d> params(5, rcpr::Vector1d(pupils.size()));
 
-    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+    auto harness = [&](int i) {
         // Find pupil:
         const auto& e = pupils[i];
 
@@ -83,10 +88,13 @@ void EyeModelEstimator::Impl::segmentPupil(const cv::Mat& I, EyeModel& eye, int
 
 #if DEBUG_PUPIL
     m_pupilEstimator->setDoPreview(true);
-    harness({ 0, int(pupils.size()) });
+    for (int i = 0; i < pupils.size(); i++)
+    {
+        harness(i);
+    }
 #else
     m_pupilEstimator->setDoPreview(false);
-    cv::parallel_for_({ 0, int(pupils.size()) }, harness);
+    parallel(int(pupils.size()), harness);
 #endif
 
     // Find Mean
@@ -112,6 +120,10 @@ void EyeModelEstimator::Impl::segmentPupil(const cv::Mat& I, EyeModel& eye, int
     eye.pupilEllipse.size *= (1.0f / scale);
     eye.pupilEllipse.center *= (1.0f / scale);
     eye.pupilEllipse.center += tl;
+
+    // Pyramid level to working level:
+    eye.pupilEllipse.size *= (1.0f / level);
+    eye.pupilEllipse.center *= (1.0f / level);
 }
 
 DRISHTI_EYE_NAMESPACE_END
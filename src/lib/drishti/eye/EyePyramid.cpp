@@ -0,0 +1,94 @@
+/*! -*-c++-*-
+  @file   EyePyramid.cpp
+  @author David Hirvonen
+  @brief  Implementation of a per call eye image pyramid shared by the eye model stages.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/eye/EyePyramid.h"
+
+#include <opencv2/imgproc.hpp>
+
+DRISHTI_EYE_NAMESPACE_BEGIN
+
+static cv::Mat getRedChannel(const cv::Mat& I)
+{
+    cv::Mat red;
+    if (I.channels() >= 3)
+    {
+        cv::extractChannel(I, red, 2);
+    }
+    else
+    {
+        red = I;
+    }
+    return red;
+}
+
+EyePyramid::EyePyramid(const cv::Mat& crop, int width, bool mirror)
+    : m_crop(crop)
+    , m_mirror(mirror)
+{
+    if (crop.cols < width)
+    {
+        if (mirror)
+        {
+            cv::flip(crop, m_image, 1);
+        }
+        else
+        {
+            m_image = crop;
+        }
+    }
+    else
+    {
+        m_scale = float(width) / float(crop.cols);
+        cv::resize(crop, m_image, {}, m_scale, m_scale, cv::INTER_CUBIC);
+        if (mirror)
+        {
+            cv::flip(m_image, m_image, 1); // in place on the downsampled eye
+        }
+    }
+
+    if (m_image.channels() == 3)
+    {
+        // The green channel is never used:
+        cv::extractChannel(m_image, m_blue, 0);
+        cv::extractChannel(m_image, m_red, 2);
+    }
+    else
+    {
+        m_blue = m_red = m_image;
+    }
+
+    if (m_scale == 1.f)
+    {
+        m_fullRed = m_red; // the working level is the crop
+    }
+}
+
+const cv::Mat& EyePyramid::getRed(float minScale, float& scale) const
+{
+    if ((minScale <= 1.f) || (m_scale >= 1.f))
+    {
+        scale = 1.f;
+        return m_red;
+    }
+
+    if (m_fullRed.empty())
+    {
+        m_fullRed = getRedChannel(m_crop);
+        if (m_mirror)
+        {
+            cv::flip(m_fullRed, m_fullRed, 1);
+        }
+    }
+
+    scale = 1.f / m_scale;
+    return m_fullRed;
+}
+
+DRISHTI_EYE_NAMESPACE_END
@@ -0,0 +1,59 @@
+/*! -*-c++-*-
+  @file   EyePyramid.h
+  @author David Hirvonen
+  @brief  Declaration of a per call eye image pyramid shared by the eye model stages.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_eye_EyePyramid_h__
+#define __drishti_eye_EyePyramid_h__
+
+#include "drishti/eye/drishti_eye.h"
+
+#include <opencv2/core/core.hpp>
+
+DRISHTI_EYE_NAMESPACE_BEGIN
+
+/*
+ * The eye crop (level 0) and a working level downsampled to the model width (mirrored for
+ * left eyes) with the regressor channels split once, so the eyelid, iris and pupil stages
+ * and the iris normalization never resample the same crop twice.  The full resolution
+ * channel is extracted on first use, so a pyramid should not be shared across threads.
+ */
+
+class EyePyramid
+{
+public:
+    EyePyramid() = default;
+    EyePyramid(const cv::Mat& crop, int width, bool mirror = false);
+
+    const cv::Mat& getCrop() const { return m_crop; }   // level 0, never mirrored
+    const cv::Mat& getImage() const { return m_image; } // working level
+    float getScale() const { return m_scale; }          // working level / crop
+    bool isMirrored() const { return m_mirror; }
+    bool empty() const { return m_image.empty(); }
+
+    // Working level channels: blue for eyelids and red (closest to NIR) for the iris:
+    const cv::Mat& getBlue() const { return m_blue; }
+    const cv::Mat& getRed() const { return m_red; }
+
+    // Red channel with at least minScale x the working level resolution (as available),
+    // scale is the level resolution relative to the working level:
+    const cv::Mat& getRed(float minScale, float& scale) const;
+
+protected:
+    cv::Mat m_crop;
+    cv::Mat m_image;
+    cv::Mat m_blue;
+    cv::Mat m_red;
+    mutable cv::Mat m_fullRed; // lazy, see getRed()
+    float m_scale = 1.f;
+    bool m_mirror = false;
+};
+
+DRISHTI_EYE_NAMESPACE_END
+
+#endif /* defined(__drishti_eye_EyePyramid_h__) */
@@ -0,0 +1,273 @@
+/*! -*-c++-*-
+  @file   IrisCode.cpp
+  @author David Hirvonen
+  @brief  Implementation of bit packed iris codes and masked Hamming distance matching.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/eye/IrisCode.h"
+#include "drishti/core/Parallel.h"
+#include "drishti/core/ThrowAssert.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+// clang-format off
+#if defined(__arm__) || defined(__arm64__) || defined(__aarch64__)
+#  include <arm_neon.h>
+#  define DO_ARM_NEON 1
+#endif
+#if defined(_MSC_VER) && defined(_M_X64)
+#  include <intrin.h>
+#endif
+// clang-format on
+
+DRISHTI_EYE_NAMESPACE_BEGIN
+
+using Word = IrisCode::Word;
+
+// Compiles to POPCNT when the target supports it (i.e., -mpopcnt or -march=native):
+static inline int popcount(Word x)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<int>(__popcnt64(x));
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Accumulate popcount((a ^ b) & ma & mb) and popcount(ma & mb) over n words:
+static void hamming(const Word* a, const Word* ma, const Word* b, const Word* mb, int n, int& bits, int& valid)
+{
+    int i = 0;
+
+#if DO_ARM_NEON
+    uint32x4_t sumBits = vdupq_n_u32(0), sumValid = vdupq_n_u32(0);
+    for (; (i + 2) <= n; i += 2)
+    {
+        const uint64x2_t m = vandq_u64(vld1q_u64(ma + i), vld1q_u64(mb + i));
+        const uint64x2_t d = vandq_u64(veorq_u64(vld1q_u64(a + i), vld1q_u64(b + i)), m);
+        sumBits = vpadalq_u16(sumBits, vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u64(d))));
+        sumValid = vpadalq_u16(sumValid, vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u64(m))));
+    }
+
+    const uint64x2_t totalBits = vpaddlq_u32(sumBits), totalValid = vpaddlq_u32(sumValid);
+    bits += static_cast<int>(vgetq_lane_u64(totalBits, 0) + vgetq_lane_u64(totalBits, 1));
+    valid += static_cast<int>(vgetq_lane_u64(totalValid, 0) + vgetq_lane_u64(totalValid, 1));
+#endif
+
+    for (; i < n; i++)
+    {
+        const Word m = ma[i] & mb[i];
+        bits += popcount((a[i] ^ b[i]) & m);
+        valid += popcount(m);
+    }
+}
+
+static void createGabor(double wavelength, cv::Mat1f& even, cv::Mat1f& odd)
+{
+    const int half = static_cast<int>(std::ceil(wavelength));
+    const cv::Size ksize(2 * half + 1, 2 * std::max(half / 2, 1) + 1);
+    const double sigma = wavelength * 0.5, gamma = 2.0;
+
+    even = cv::getGaborKernel(ksize, sigma, 0.0, wavelength, gamma, 0.0, CV_32F);
+    odd = cv::getGaborKernel(ksize, sigma, 0.0, wavelength, gamma, CV_PI * 0.5, CV_32F);
+
+    // Remove the DC response, so that the sign bits only depend on the texture:
+    even -= cv::mean(even)[0];
+    odd -= cv::mean(odd)[0];
+}
+
+IrisCode::IrisCode(const NormalizedIris& iris, const cv::Size& size, double wavelength)
+{
+    cv::Mat image = iris.getImage(), mask = iris.getMask();
+    drishti_throw_assert(!image.empty() && (image.size() == mask.size()), "IrisCode: invalid normalized iris");
+
+    if (image.channels() > 1)
+    {
+        cv::cvtColor(image, image, (image.channels() == 4) ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+    }
+    if (size.area() && (size != image.size()))
+    {
+        cv::resize(image, image, size, 0, 0, cv::INTER_AREA);
+        cv::resize(mask, mask, size, 0, 0, cv::INTER_NEAREST);
+    }
+
+    cv::Mat1f even, odd;
+    createGabor(wavelength, even, odd);
+
+    // The angular axis is periodic:
+    const int half = even.cols / 2;
+    cv::Mat wrapped;
+    cv::Mat1f re, im;
+    cv::copyMakeBorder(image, wrapped, 0, 0, half, half, cv::BORDER_WRAP);
+    cv::filter2D(wrapped, re, CV_32F, even, { -1, -1 }, 0, cv::BORDER_REPLICATE);
+    cv::filter2D(wrapped, im, CV_32F, odd, { -1, -1 }, 0, cv::BORDER_REPLICATE);
+
+    m_columns = image.cols;
+    m_rows = image.rows;
+    m_words = (2 * m_rows + 63) / 64;
+    m_code.assign(m_columns * m_words, 0);
+    m_mask.assign(m_columns * m_words, 0);
+
+    for (int y = 0; y < m_rows; y++)
+    {
+        const float* pRe = re.ptr<float>(y) + half;
+        const float* pIm = im.ptr<float>(y) + half;
+        const std::uint8_t* pMask = mask.ptr<std::uint8_t>(y);
+        for (int x = 0; x < m_columns; x++)
+        {
+            const int bit = (2 * y), offset = (x * m_words) + (bit / 64);
+            const Word one = 1;
+            if (pRe[x] > 0.f)
+            {
+                m_code[offset] |= (one << (bit % 64));
+            }
+            if (pIm[x] > 0.f)
+            {
+                m_code[offset] |= (one << ((bit + 1) % 64));
+            }
+            if (pMask[x])
+            {
+                m_mask[offset] |= (one << (bit % 64)) | (one << ((bit + 1) % 64));
+            }
+        }
+    }
+}
+
+// Column c of a is compared to column (c + shift) of b in two contiguous segments:
+static IrisMatch compare(const Word* a, const Word* ma, const Word* b, const Word* mb, int columns, int words, int shift)
+{
+    const int n = columns, o = ((shift % n) + n) % n;
+
+    IrisMatch result;
+    int bits = 0;
+    hamming(a, ma, b + o * words, mb + o * words, (n - o) * words, bits, result.bits);
+    hamming(a + (n - o) * words, ma + (n - o) * words, b, mb, o * words, bits, result.bits);
+    result.shift = shift;
+    result.distance = result.bits ? (float(bits) / float(result.bits)) : 1.f;
+    return result;
+}
+
+static void checkLayout(const IrisCode& a, const IrisCode& b)
+{
+    drishti_throw_assert(!a.empty() && (a.getColumns() == b.getColumns()) && (a.getWordsPerColumn() == b.getWordsPerColumn()), "IrisCode: incompatible codes");
+}
+
+IrisMatch IrisCode::distance(const IrisCode& a, const IrisCode& b, int shift)
+{
+    checkLayout(a, b);
+    return compare(a.m_code.data(), a.m_mask.data(), b.m_code.data(), b.m_mask.data(), a.m_columns, a.m_words, shift);
+}
+
+IrisMatch IrisCode::match(const IrisCode& a, const IrisCode& b, int maxShift)
+{
+    checkLayout(a, b);
+    return match(a.m_code.data(), a.m_mask.data(), b.m_code.data(), b.m_mask.data(), a.m_columns, a.m_words, maxShift);
+}
+
+IrisMatch IrisCode::match(const Word* a, const Word* ma, const Word* b, const Word* mb, int columns, int words, int maxShift)
+{
+    IrisMatch best;
+    for (int shift = -maxShift; shift <= maxShift; shift++)
+    {
+        const IrisMatch result = compare(a, ma, b, mb, columns, words, shift);
+        if ((shift == -maxShift) || (result.distance < best.distance))
+        {
+            best = result;
+        }
+    }
+    return best;
+}
+
+// ((((((((((((((( IrisCodeGallery )))))))))))))))
+
+std::size_t IrisCodeGallery::add(const IrisCode& code)
+{
+    drishti_throw_assert(!code.empty(), "IrisCodeGallery: empty code");
+    if (m_codes.empty())
+    {
+        m_columns = code.getColumns();
+        m_words = code.getWordsPerColumn();
+    }
+    drishti_throw_assert((code.getColumns() == m_columns) && (code.getWordsPerColumn() == m_words), "IrisCodeGallery: incompatible code");
+
+    m_codes.insert(m_codes.end(), code.getCode().begin(), code.getCode().end());
+    m_masks.insert(m_masks.end(), code.getMask().begin(), code.getMask().end());
+    return size() - 1;
+}
+
+void IrisCodeGallery::reserve(std::size_t size)
+{
+    if (m_columns * m_words)
+    {
+        m_codes.reserve(size * m_columns * m_words);
+        m_masks.reserve(size * m_columns * m_words);
+    }
+}
+
+void IrisCodeGallery::clear()
+{
+    m_codes.clear();
+    m_masks.clear();
+    m_columns = m_words = 0;
+}
+
+std::size_t IrisCodeGallery::size() const
+{
+    const std::size_t stride = m_columns * m_words;
+    return stride ? (m_codes.size() / stride) : 0;
+}
+
+void IrisCodeGallery::match(const IrisCode& probe, int maxShift, std::vector<IrisMatch>& matches) const
+{
+    matches.resize(size());
+    if (matches.empty())
+    {
+        return;
+    }
+
+    drishti_throw_assert((probe.getColumns() == m_columns) && (probe.getWordsPerColumn() == m_words), "IrisCodeGallery: incompatible probe");
+
+    const std::size_t stride = m_columns * m_words;
+    const Word* code = probe.getCode().data();
+    const Word* mask = probe.getMask().data();
+
+    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+        const Word* b = m_codes.data() + (i * stride);
+        const Word* mb = m_masks.data() + (i * stride);
+        matches[i] = IrisCode::match(code, mask, b, mb, m_columns, m_words, maxShift);
+    };
+
+    cv::parallel_for_({ 0, int(matches.size()) }, harness);
+}
+
+int IrisCodeGallery::search(const IrisCode& probe, int maxShift, IrisMatch& match) const
+{
+    std::vector<IrisMatch> matches;
+    this->match(probe, maxShift, matches);
+
+    auto iter = std::min_element(matches.begin(), matches.end(), [](const IrisMatch& a, const IrisMatch& b) {
+        return a.distance < b.distance;
+    });
+    if (iter == matches.end())
+    {
+        return -1;
+    }
+
+    match = *iter;
+    return int(std::distance(matches.begin(), iter));
+}
+
+DRISHTI_EYE_NAMESPACE_END
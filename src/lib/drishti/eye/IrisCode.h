@@ -0,0 +1,101 @@
+/*! -*-c++-*-
+  @file   IrisCode.h
+  @author David Hirvonen
+  @brief  Declaration of bit packed iris codes and masked Hamming distance matching.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_eye_IrisCode_h__
+#define __drishti_eye_IrisCode_h__
+
+#include "drishti/eye/drishti_eye.h"
+#include "drishti/eye/NormalizedIris.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <cstdint>
+#include <vector>
+
+DRISHTI_EYE_NAMESPACE_BEGIN
+
+struct IrisMatch
+{
+    float distance = 1.f; // fractional Hamming distance over the valid bits
+    int shift = 0;        // rotation (columns) of the gallery code
+    int bits = 0;         // number of valid (unmasked) bits
+};
+
+/*
+ * Phase quadrant code of an ellipso-polar normalized iris: two bits (sign of the even and
+ * odd Gabor response along the angular axis) per texel, packed column major so that a
+ * rotation corresponds to a whole number of 64 bit words.
+ */
+
+class IrisCode
+{
+public:
+    using Word = std::uint64_t;
+
+    IrisCode() = default;
+
+    // Encode the (unpadded) normalized iris, optionally resampled to size:
+    IrisCode(const NormalizedIris& iris, const cv::Size& size = {}, double wavelength = 8.0);
+
+    int getColumns() const { return m_columns; }
+    int getRows() const { return m_rows; }
+    int getWordsPerColumn() const { return m_words; }
+    bool empty() const { return m_code.empty(); }
+
+    const std::vector<Word>& getCode() const { return m_code; }
+    const std::vector<Word>& getMask() const { return m_mask; }
+
+    // Compare a with b rotated by shift columns:
+    static IrisMatch distance(const IrisCode& a, const IrisCode& b, int shift);
+
+    // Best match over the rotations [-maxShift, +maxShift]:
+    static IrisMatch match(const IrisCode& a, const IrisCode& b, int maxShift);
+
+    // Low level matching of contiguous codes with the same layout (columns x words):
+    static IrisMatch match(const Word* a, const Word* ma, const Word* b, const Word* mb, int columns, int words, int maxShift);
+
+protected:
+    int m_columns = 0;
+    int m_rows = 0;
+    int m_words = 0;
+    std::vector<Word> m_code;
+    std::vector<Word> m_mask;
+};
+
+/*
+ * 1:N search over codes stored in a single contiguous buffer.
+ */
+
+class IrisCodeGallery
+{
+public:
+    IrisCodeGallery() = default;
+
+    std::size_t add(const IrisCode& code); // returns the gallery index
+    void reserve(std::size_t size);
+    void clear();
+    std::size_t size() const;
+
+    // Best match (over rotations) for each gallery entry:
+    void match(const IrisCode& probe, int maxShift, std::vector<IrisMatch>& matches) const;
+
+    // Index of the closest entry (or -1 for an empty gallery):
+    int search(const IrisCode& probe, int maxShift, IrisMatch& match) const;
+
+protected:
+    int m_columns = 0;
+    int m_words = 0;
+    std::vector<IrisCode::Word> m_codes;
+    std::vector<IrisCode::Word> m_masks;
+};
+
+DRISHTI_EYE_NAMESPACE_END
+
+#endif /* defined(__drishti_eye_IrisCode_h__) */
@@ -9,43 +9,163 @@
 */
 
 #include "drishti/eye/IrisNormalizer.h"
+#include "drishti/core/MemoryUsage.h"
 #include "drishti/geometry/Ellipse.h"
-#include "drishti/geometry/intersectConicLine.h"
+#include "drishti/geometry/intersectConicRays.h"
 
 #include <opencv2/imgproc.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <iostream>
 
 DRISHTI_EYE_NAMESPACE_BEGIN
 
-IrisNormalizer::IrisNormalizer()
+static int quantize(float value, float quantum)
 {
+    return static_cast<int>(std::lround(value / quantum));
 }
 
-void IrisNormalizer::warpIris(const cv::Mat& crop, const cv::Mat1b& mask, const cv::Size& paddedSize, Rays& rayPixels, Rays& rayTexels, NormalizedIris& code, int padding) const
+static cv::RotatedRect quantize(const cv::RotatedRect& ellipse, float quantum, int* key)
 {
-    code.getRoi() = cv::Rect({ padding, 0 }, paddedSize - cv::Size(2 * padding, 0));
-    code.getPaddedMask().create(paddedSize, CV_8UC1);
-    code.getPaddedImage().create(paddedSize, crop.type());
-    code.getPaddedImage() = cv::Scalar::all(0);
+    key[0] = quantize(ellipse.center.x, quantum);
+    key[1] = quantize(ellipse.center.y, quantum);
+    key[2] = quantize(ellipse.size.width, quantum);
+    key[3] = quantize(ellipse.size.height, quantum);
+    key[4] = quantize(ellipse.angle, quantum);
 
-    cv::Mat1f mapX(paddedSize), mapY(paddedSize);
+    // Return the ellipse for the quantized key, so that a cached map doesn't depend on the first caller:
+    cv::RotatedRect result;
+    result.center = { key[0] * quantum, key[1] * quantum };
+    result.size = { key[2] * quantum, key[3] * quantum };
+    result.angle = key[4] * quantum;
+    return result;
+}
 
-    for (int x = 0; x < paddedSize.width; x++)
+IrisNormalizer::IrisNormalizer(std::size_t capacity, float quantum)
+{
+    setCacheSize(capacity, quantum);
+}
+
+void IrisNormalizer::setCacheSize(std::size_t capacity, float quantum)
+{
+    m_cache = (capacity > 0) ? std::make_shared<Cache>(capacity, quantum) : nullptr;
+}
+
+std::size_t IrisNormalizer::getCacheSize() const
+{
+    return m_cache ? m_cache->capacity : 0;
+}
+
+std::size_t IrisNormalizer::getMemoryUsage() const
+{
+    std::size_t bytes = 0;
+    if (m_cache)
     {
-        for (int y = 0; y < paddedSize.height; y++)
+        std::lock_guard<std::mutex> lock(m_cache->mutex);
+        for (const auto& entry : m_cache->entries)
+        {
+            bytes += core::getMemoryUsage(entry.second.x) + core::getMemoryUsage(entry.second.y);
+        }
+    }
+    return bytes;
+}
+
+void IrisNormalizer::createMap(const cv::Size& paddedSize, const Rays& rayPixels, Map& map) const
+{
+    map.x.create(paddedSize);
+    map.y.create(paddedSize);
+
+    // Interpolate from the pupil (alpha = 0) to the limbus (alpha = 1) row by row:
+    for (int y = 0; y < paddedSize.height; y++)
+    {
+        const float alpha = (y + 1) / float(paddedSize.height), beta = (1.0 - alpha);
+        float* px = map.x.ptr<float>(y);
+        float* py = map.y.ptr<float>(y);
+        for (int x = 0; x < paddedSize.width; x++)
         {
-            const float alpha = (y + 1) / float(paddedSize.height), beta = (1.0 - alpha);
             const auto& pi = rayPixels[x][0];
             const auto& pp = rayPixels[x][1];
-            const cv::Point2f u = (pi * alpha) + (pp * beta);
-            mapX(y, x + padding) = u.x;
-            mapY(y, x + padding) = u.y;
+            px[x] = (pi.x * alpha) + (pp.x * beta);
+            py[x] = (pi.y * alpha) + (pp.y * beta);
         }
     }
+}
 
-    cv::remap(crop, code.getPaddedImage(), mapX, mapY, cv::INTER_CUBIC);
-    cv::remap(mask, code.getPaddedMask(), mapX, mapY, cv::INTER_NEAREST);
+static float cross(const cv::Point2f& a, const cv::Point2f& b)
+{
+    return (a.x * b.y) - (a.y * b.x);
+}
+
+void IrisNormalizer::createMask(const EyeModel& eye, const cv::Size& size, cv::Mat1b& mask, int padding) const
+{
+    Rays rayPixels, rayTexels;
+    const cv::Size paddedSize = createRays(eye, size, rayPixels, rayTexels, padding);
+    mask.create(paddedSize);
+
+    const auto& contour = eye.getEyelidsSpline();
+    if (contour.size() < 3)
+    {
+        mask = 255; // no eyelids
+        return;
+    }
+
+    std::vector<float> crossings;
+    for (int x = 0; x < paddedSize.width; x++)
+    {
+        // Rows sample u(alpha) = r1 + alpha * (r0 - r1), see createMap():
+        const cv::Point2f r1 = rayPixels[x][1], d = rayPixels[x][0] - rayPixels[x][1];
+
+        // Parity of the eyelid crossings along the (infinite) ray line gives the inside intervals:
+        crossings.clear();
+        for (int i = 0; i < contour.size(); i++)
+        {
+            const cv::Point2f& a = contour[i];
+            const cv::Point2f e = contour[(i + 1) % contour.size()] - a, w = a - r1;
+            const float denom = cross(d, e);
+            if (std::abs(denom) > std::numeric_limits<float>::epsilon())
+            {
+                const float u = cross(w, d) / denom;
+                if ((u >= 0.f) && (u < 1.f))
+                {
+                    crossings.push_back(cross(w, e) / denom);
+                }
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        std::size_t count = 0;
+        for (int y = 0; y < paddedSize.height; y++)
+        {
+            const float alpha = (y + 1) / float(paddedSize.height);
+            while ((count < crossings.size()) && (crossings[count] < alpha))
+            {
+                count++;
+            }
+            mask(y, x) = (count % 2) ? 255 : 0;
+        }
+    }
+}
+
+void IrisNormalizer::warpIris(const cv::Mat& crop, const cv::Mat1b& mask, const cv::Size& paddedSize, Rays& rayPixels, Rays& rayTexels, NormalizedIris& code, int padding) const
+{
+    Map map;
+    createMap(paddedSize, rayPixels, map);
+    warpIris(crop, mask, map, code, padding);
+}
+
+void IrisNormalizer::warpIris(const cv::Mat& crop, const cv::Mat1b& mask, const Map& map, NormalizedIris& code, int padding) const
+{
+    const cv::Size paddedSize = map.x.size();
+    code.getRoi() = cv::Rect({ padding, 0 }, paddedSize - cv::Size(2 * padding, 0));
+    code.getPaddedMask().create(paddedSize, CV_8UC1);
+    code.getPaddedImage().create(paddedSize, crop.type());
+    code.getPaddedImage() = cv::Scalar::all(0);
+
+    cv::remap(crop, code.getPaddedImage(), map.x, map.y, cv::INTER_CUBIC);
+    cv::remap(mask, code.getPaddedMask(), map.x, map.y, cv::INTER_NEAREST);
 }
 
 cv::Size IrisNormalizer::createRays(const EyeModel& eye, const cv::Size& size, Rays& rayPixels, Rays& rayTexels, int padding) const
@@ -57,30 +177,33 @@ cv::Size IrisNormalizer::createRays(const EyeModel& eye, const cv::Size& size, R
     rayPixels.reserve(paddedSize.width);
     rayTexels.reserve(paddedSize.width);
 
-    /* int n = 0; */
-    cv::Vec3f P[2];
-    cv::Point2f p[2], pi, pp;
-    for (int x = -padding; x < (size.width + padding); x++)
+    // Fan of rays about the pupil center, intersected with both ellipses in one pass each:
+    const int count = paddedSize.width;
+    std::vector<float> buffer(count * 7);
+    float *ox = &buffer[0], *oy = ox + count, *dx = oy + count, *dy = dx + count;
+    float *tIris = dy + count, *tPupil = tIris + count, *tBack = tPupil + count;
+    std::vector<std::uint8_t> hits(count);
+    for (int i = 0; i < count; i++)
     {
+        const int x = i - padding;
         const float theta = float((x + size.width) % size.width) / size.width * float(2.0 * M_PI);
-        cv::Point3f v(std::cos(theta), std::sin(theta), 0);
-        cv::Point3f c(eye.pupilEllipse.center.x, eye.pupilEllipse.center.y, 1.f);
-        const cv::Point3f L = c.cross(c + v);
-
-        // TODO: should be able to avoid need for the dot product
-        /* n = */ drishti::geometry::intersectConicLine(iris, L, P);
-        p[0] = { P[0][0] / P[0][2], P[0][1] / P[0][2] };
-        p[1] = { P[1][0] / P[1][2], P[1][1] / P[1][2] };
-        pi = p[cv::Point2f(v.x, v.y).dot(p[0] - cv::Point2f(c.x, c.y)) > 0];
-
-        /* n = */ drishti::geometry::intersectConicLine(pupil, L, P);
-        p[0] = { P[0][0] / P[0][2], P[0][1] / P[0][2] };
-        p[1] = { P[1][0] / P[1][2], P[1][1] / P[1][2] };
-        pp = p[cv::Point2f(v.x, v.y).dot(p[0] - cv::Point2f(c.x, c.y)) > 0];
-        Ray rayPixel = { { pp, pi } };
+        ox[i] = eye.pupilEllipse.center.x;
+        oy[i] = eye.pupilEllipse.center.y;
+        dx[i] = std::cos(theta);
+        dy[i] = std::sin(theta);
+    }
+
+    // The forward intersection of a ray from inside an ellipse is the larger root:
+    drishti::geometry::intersectConicRays(iris, count, ox, oy, dx, dy, tIris, tBack, hits.data());
+    drishti::geometry::intersectConicRays(pupil, count, ox, oy, dx, dy, tPupil, tBack, hits.data());
+
+    for (int i = 0; i < count; i++)
+    {
+        const cv::Point2f c(ox[i], oy[i]), v(dx[i], dy[i]);
+        Ray rayPixel = { { c + v * tPupil[i], c + v * tIris[i] } };
 
         // Add corresponding ray in normalized coordinates:
-        cv::Point2f tp(float(x + padding) / paddedSize.width, 0.0);
+        cv::Point2f tp(float(i) / paddedSize.width, 0.0);
         cv::Point2f ti(tp.x, 1.0);
         Ray rayTexel = { { tp, ti } };
 
@@ -91,13 +214,56 @@ cv::Size IrisNormalizer::createRays(const EyeModel& eye, const cv::Size& size, R
     return paddedSize;
 }
 
+IrisNormalizer::Map IrisNormalizer::getMap(const EyeModel& eye, const cv::Size& size, int padding) const
+{
+    Map map;
+    Rays rayPixels, rayTexels;
+    if (!m_cache)
+    {
+        createMap(createRays(eye, size, rayPixels, rayTexels, padding), rayPixels, map);
+        return map;
+    }
+
+    Key key;
+    EyeModel model;
+    model.pupilEllipse = quantize(eye.pupilEllipse, m_cache->quantum, &key[0]);
+    model.irisEllipse = quantize(eye.irisEllipse, m_cache->quantum, &key[5]);
+    key[10] = size.width;
+    key[11] = size.height;
+    key[12] = padding;
+
+    {
+        std::lock_guard<std::mutex> lock(m_cache->mutex);
+        auto iter = m_cache->lookup.find(key);
+        if (iter != m_cache->lookup.end())
+        {
+            m_cache->entries.splice(m_cache->entries.begin(), m_cache->entries, iter->second);
+            return iter->second->second; // shallow copy, the tables are never modified
+        }
+    }
+
+    // Tables are created outside of the lock:
+    createMap(createRays(model, size, rayPixels, rayTexels, padding), rayPixels, map);
+
+    std::lock_guard<std::mutex> lock(m_cache->mutex);
+    if (m_cache->lookup.find(key) == m_cache->lookup.end())
+    {
+        m_cache->entries.emplace_front(key, map);
+        m_cache->lookup[key] = m_cache->entries.begin();
+        if (m_cache->entries.size() > m_cache->capacity)
+        {
+            m_cache->lookup.erase(m_cache->entries.back().first);
+            m_cache->entries.pop_back();
+        }
+    }
+
+    return map;
+}
+
 void IrisNormalizer::operator()(const cv::Mat& crop, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, int padding) const
 {
     cv::Mat mask = eye.irisMask(crop.size());
-
-    Rays rayPixels, rayTexels;
-    cv::Size paddedSize = createRays(eye, size, rayPixels, rayTexels, padding);
-    warpIris(crop, mask, paddedSize, rayPixels, rayTexels, code, padding);
+    warpIris(crop, mask, getMap(eye, size, padding), code, padding);
 }
 
 DRISHTI_EYE_NAMESPACE_END
@@ -18,6 +18,10 @@
 #include "drishti/eye/NormalizedIris.h"
 
 #include <array>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 
 DRISHTI_EYE_NAMESPACE_BEGIN
 
@@ -27,13 +31,57 @@ public:
     using Ray = std::array<cv::Point2f, 2>;
     using Rays = std::vector<Ray>;
 
-    IrisNormalizer();
+    // cv::remap() tables for the padded normalized iris:
+    struct Map
+    {
+        cv::Mat1f x;
+        cv::Mat1f y;
+    };
+
+    // An optional LRU cache of remap tables keyed on the pupil and iris ellipses quantized to
+    // quantum (pixels and degrees), i.e., for tracked eyes with nearly static geometry.
+    // Copies share the cache, a capacity of 0 disables it (exact per call geometry):
+    IrisNormalizer(std::size_t capacity = 0, float quantum = 0.125f);
+
+    void setCacheSize(std::size_t capacity, float quantum = 0.125f);
+    std::size_t getCacheSize() const;
+
+    // Heap bytes of the cached remap tables:
+    std::size_t getMemoryUsage() const;
 
     cv::Size createRays(const EyeModel& eye, const cv::Size& size, Rays& rayPixels, Rays& rayTexels, int padding = 0) const;
+    void createMap(const cv::Size& paddedSize, const Rays& rayPixels, Map& map) const;
+
+    // Eyelid occlusion mask for a normalized iris that was warped elsewhere (i.e., on the GPU),
+    // computed from ray/eyelid intersections without any pixel access:
+    void createMask(const EyeModel& eye, const cv::Size& size, cv::Mat1b& mask, int padding = 0) const;
     void warpIris(const cv::Mat& crop, const cv::Mat1b& mask, const cv::Size& paddedSize, Rays& rayPixels, Rays& rayTexels, NormalizedIris& code, int padding = 0) const;
+    void warpIris(const cv::Mat& crop, const cv::Mat1b& mask, const Map& map, NormalizedIris& code, int padding = 0) const;
     void operator()(const cv::Mat& crop, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, int padding = 0) const;
 
 protected:
+    using Key = std::array<int, 13>;
+
+    struct Cache
+    {
+        using Entry = std::pair<Key, Map>;
+
+        Cache(std::size_t capacity, float quantum)
+            : capacity(capacity)
+            , quantum(quantum)
+        {
+        }
+
+        std::size_t capacity;
+        float quantum;
+        std::list<Entry> entries; // most recently used first
+        std::map<Key, std::list<Entry>::iterator> lookup;
+        std::mutex mutex;
+    };
+
+    Map getMap(const EyeModel& eye, const cv::Size& size, int padding) const;
+
+    std::shared_ptr<Cache> m_cache;
 };
 
 DRISHTI_EYE_NAMESPACE_END
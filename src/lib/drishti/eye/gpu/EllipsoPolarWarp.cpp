@@ -12,9 +12,19 @@
 
 #include "drishti/eye/IrisNormalizer.h"
 
-#include "drishti/geometry/motion.h"
+#include "drishti/geometry/Ellipse.h"
 
 #include <array>
+#include <cmath>
+#include <vector>
+
+// clang-format off
+#if defined(GL_PIXEL_PACK_BUFFER) && defined(GL_MAP_READ_BIT)
+#  define DRISHTI_EYE_GPU_HAS_PBO 1
+#else
+#  define DRISHTI_EYE_GPU_HAS_PBO 0
+#endif
+// clang-format on
 
 BEGIN_OGLES_GPGPU
 
@@ -22,39 +32,179 @@ BEGIN_OGLES_GPGPU
  * Input eye models shall be in pixel coordinates associated with the input texture/FBO
  */
 
+/*
+ * Same rays as IrisNormalizer::createRays(): each vertex of the (static) strip holds the ray
+ * angle and its end (0: pupil, 1: iris), and the ray from the pupil center is intersected with
+ * the conic in the shader.  As on the CPU, the intersection on the far side of the center
+ * (i.e., the smaller root) is used.
+ */
+
+// clang-format off
+const char * EllipsoPolarWarp::vshaderEllipsoPolarSrc = OG_TO_STR(
+attribute vec4 aPos;
+attribute vec2 aTexCoord;
+uniform vec2 uCenter;
+uniform mat3 uPupil;
+uniform mat3 uIris;
+varying vec2 vTexCoord;
+vec2 intersect(mat3 C, vec3 c, vec3 v)
+{
+    float a = dot(v, C * v);
+    float b = dot(v, C * c);
+    float k = dot(c, C * c);
+    float s = (-b - sign(a) * sqrt(max(b * b - a * k, 0.0))) / a;
+    return c.xy + s * v.xy;
+}
+void main()
+{
+    vec3 c = vec3(uCenter, 1.0);
+    vec3 v = vec3(cos(aTexCoord.x), sin(aTexCoord.x), 0.0);
+    gl_Position = aPos;
+    vTexCoord = mix(intersect(uPupil, c, v), intersect(uIris, c, v), aTexCoord.y);
+});
+// clang-format on
+
 EllipsoPolarWarp::EllipsoPolarWarp()
 {
 }
 
-void EllipsoPolarWarp::renderIris(const DRISHTI_EYE::EyeModel& eye)
+EllipsoPolarWarp::~EllipsoPolarWarp()
 {
-    m_eye = m_eyeDelegate(); // get updated eye models:
+    releasePBO();
+    if (m_meshVbo)
+    {
+        glDeleteBuffers(1, &m_meshVbo);
+    }
+}
+
+void EllipsoPolarWarp::getUniforms()
+{
+    shParamUCenter = shader->getParam(UNIF, "uCenter");
+    shParamUPupil = shader->getParam(UNIF, "uPupil");
+    shParamUIris = shader->getParam(UNIF, "uIris");
+}
 
-    DRISHTI_EYE::IrisNormalizer::Rays rayPixels, rayTexels;
-    DRISHTI_EYE::IrisNormalizer normalizer;
+// One ray per output column, vertices are { clip x, clip y, theta, ray end }:
+void EllipsoPolarWarp::createMesh(int width)
+{
+    std::vector<GLfloat> vertices;
+    vertices.reserve(width * 2 * 4);
+    for (int x = 0; x < width; x++)
+    {
+        const GLfloat u = float(x) / width, theta = u * float(2.0 * M_PI);
+        for (int end = 0; end < 2; end++)
+        {
+            const GLfloat vertex[4] = { 2.f * u - 1.f, 2.f * end - 1.f, theta, float(end) };
+            vertices.insert(vertices.end(), vertex, vertex + 4);
+        }
+    }
 
-    // The ogles_gpgpu filter size is used to define the normalized iris dimensions:
-    ogles_gpgpu::Size2d size(getOutFrameW(), getOutFrameH());
+    if (!m_meshVbo)
+    {
+        glGenBuffers(1, &m_meshVbo);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_meshVbo);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(GLfloat)), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    Tools::checkGLErr(getProcName(), "createMesh()");
+
+    m_meshWidth = width;
+}
 
-    // We can use the provided rays as a GL_TRIANGLE_STRIP
-    normalizer.createRays(eye, { size.width, size.height }, rayPixels, rayTexels, 0);
+void EllipsoPolarWarp::setDoReadback(bool flag, bool usePBO)
+{
+    m_doReadback = flag;
+    m_usePBO = usePBO && DRISHTI_EYE_GPU_HAS_PBO;
+}
+
+void EllipsoPolarWarp::releasePBO()
+{
+#if DRISHTI_EYE_GPU_HAS_PBO
+    if (m_pbo[0])
+    {
+        glDeleteBuffers(2, m_pbo.data());
+        m_pbo = { { 0, 0 } };
+        m_pboPending = { { false, false } };
+    }
+#endif
+}
 
-    m_texels.resize(rayTexels.size() * 2);
-    m_pixels.resize(rayPixels.size() * 2);
+void EllipsoPolarWarp::store(const cv::Mat4b& image, const DRISHTI_EYE::EyeModel& eye)
+{
+    // The mask is computed analytically, the CPU never touches the eye pixels:
+    cv::Mat1b mask;
+    DRISHTI_EYE::IrisNormalizer().createMask(eye, image.size(), mask);
+    m_iris = DRISHTI_EYE::NormalizedIris(image, mask, { { 0, 0 }, image.size() });
+}
 
-    memcpy(&m_texels[0], &rayTexels[0], sizeof(rayTexels[0]) * rayTexels.size());
-    memcpy(&m_pixels[0], &rayPixels[0], sizeof(rayPixels[0]) * rayPixels.size());
+// Called while the FBO is bound:
+void EllipsoPolarWarp::readback()
+{
+    const cv::Size size(outFrameW, outFrameH);
 
+#if DRISHTI_EYE_GPU_HAS_PBO
+    if (m_usePBO)
     {
-        // Map destination points into clip space [(-1,-1)... (+1,+1)]
-        cv::Matx33f N = transformation::translate(-1.f, -1.f) * transformation::scale(2.0, 2.0);
-        for (int i = 0; i < m_texels.size(); i++)
+        if (m_pboSize != size)
         {
-            cv::Point3f q = N * m_texels[i];
-            m_texels[i] = { q.x, q.y };
+            releasePBO();
+            glGenBuffers(2, m_pbo.data());
+            for (auto& pbo : m_pbo)
+            {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+                glBufferData(GL_PIXEL_PACK_BUFFER, size.area() * 4, nullptr, GL_STREAM_READ);
+            }
+            m_pboSize = size;
         }
+
+        // Start the transfer for the current frame:
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[m_pboIndex]);
+        glReadPixels(0, 0, size.width, size.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        m_pboEyes[m_pboIndex] = m_eye.eye;
+        m_pboPending[m_pboIndex] = true;
+
+        // Complete the transfer from the previous frame:
+        m_pboIndex = 1 - m_pboIndex;
+        if (m_pboPending[m_pboIndex])
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[m_pboIndex]);
+            if (void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size.area() * 4, GL_MAP_READ_BIT))
+            {
+                store(cv::Mat4b(size, static_cast<cv::Vec4b*>(pixels)).clone(), m_pboEyes[m_pboIndex]);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            m_pboPending[m_pboIndex] = false;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        Tools::checkGLErr(getProcName(), "readback (pbo)");
+        return;
+    }
+#endif
+
+    cv::Mat4b image(size);
+    glReadPixels(0, 0, size.width, size.height, GL_RGBA, GL_UNSIGNED_BYTE, image.ptr());
+    Tools::checkGLErr(getProcName(), "readback");
+    store(image, m_eye.eye);
+}
+
+void EllipsoPolarWarp::renderIris(const DRISHTI_EYE::EyeModel& eye)
+{
+    m_eye = m_eyeDelegate(); // get updated eye models:
+
+    // The ogles_gpgpu filter size is used to define the normalized iris dimensions:
+    if (m_meshWidth != getOutFrameW())
+    {
+        createMesh(getOutFrameW());
     }
 
+    // Conics are symmetric, so the row major matrices can be passed as is:
+    const cv::Matx33f pupil = drishti::geometry::ConicSection_<float>(eye.pupilEllipse).getMatrix();
+    const cv::Matx33f iris = drishti::geometry::ConicSection_<float>(eye.irisEllipse).getMatrix();
+    glUniform2f(shParamUCenter, eye.pupilEllipse.center.x, eye.pupilEllipse.center.y);
+    glUniformMatrix3fv(shParamUPupil, 1, GL_FALSE, pupil.val);
+    glUniformMatrix3fv(shParamUIris, 1, GL_FALSE, iris.val);
+    Tools::checkGLErr(getProcName(), "glUniformMatrix3fv()");
+
     // ====================================
     // === virtual API rendering calls ====
     // ====================================
@@ -74,15 +224,24 @@ void EllipsoPolarWarp::renderIrises()
 // Override this to avoid multiple calls to fbo->bind()
 void EllipsoPolarWarp::filterRenderSetCoords()
 {
-    // set geometry
-    glEnableVertexAttribArray(shParamAPos);
+    const GLsizei stride = 4 * sizeof(GLfloat);
+    glBindBuffer(GL_ARRAY_BUFFER, m_meshVbo);
 
-    // Destination point in clip space:
-    glVertexAttribPointer(shParamAPos, 2, GL_FLOAT, GL_FALSE, 0, &m_texels[0]); // [(-1,-1)  (+1,+1)]
+    // Destination point in clip space: [(-1,-1)  (+1,+1)]
+    glEnableVertexAttribArray(shParamAPos);
+    glVertexAttribPointer(shParamAPos, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(0));
 
-    // Source point in texture space:
-    glVertexAttribPointer(shParamATexCoord, 2, GL_FLOAT, GL_FALSE, 0, &m_pixels[0]); // [(0,0)  (1,1)]
+    // Ray angle and end, mapped to texture space in the vertex shader:
     glEnableVertexAttribArray(shParamATexCoord);
+    glVertexAttribPointer(shParamATexCoord, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(2 * sizeof(GLfloat)));
+}
+
+void EllipsoPolarWarp::filterRenderDraw()
+{
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, static_cast<GLsizei>(m_meshWidth * 2));
+
+    // Other filters use client side vertex arrays:
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 int EllipsoPolarWarp::render(int position)
@@ -103,6 +262,11 @@ int EllipsoPolarWarp::render(int position)
 
     renderIrises();
 
+    if (m_doReadback)
+    {
+        readback();
+    }
+
     filterRenderCleanup();
     Tools::checkGLErr(getProcName(), "render cleanup");
 
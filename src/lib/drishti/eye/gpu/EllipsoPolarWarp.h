@@ -13,9 +13,12 @@
 
 #include "drishti/eye/gpu/TriangleStripWarp.h"
 #include "drishti/eye/gpu/EyeWarp.h"
+#include "drishti/eye/NormalizedIris.h"
 
 #include <opencv2/core.hpp>
 
+#include <array>
+
 BEGIN_OGLES_GPGPU
 
 class EllipsoPolarWarp : public TriangleStripWarp
@@ -24,24 +27,70 @@ public:
     using EyeDelegate = std::function<drishti::eye::EyeWarp(void)>;
 
     EllipsoPolarWarp();
+    ~EllipsoPolarWarp();
     virtual const char* getProcName()
     {
         return "EllipsoPolarWarp";
     }
+    virtual const char* getVertexShaderSource()
+    {
+        return vshaderEllipsoPolarSrc;
+    }
+
     virtual int render(int position = 0);
     virtual void filterRenderSetCoords();
+    virtual void filterRenderDraw();
 
     void addEyeDelegate(EyeDelegate delegate)
     {
         m_eyeDelegate = delegate;
     }
 
+    // Read the rendered iris back to the CPU after each render(), with usePBO the transfer is
+    // asynchronous (GL 3.0/ES 3.0) and the result lags by one frame:
+    void setDoReadback(bool flag, bool usePBO = false);
+    bool getDoReadback() const
+    {
+        return m_doReadback;
+    }
+
+    // Most recent readback (RGBA) with the eyelid mask of the eye it was rendered from:
+    const drishti::eye::NormalizedIris& getNormalizedIris() const
+    {
+        return m_iris;
+    }
+
 protected:
+    virtual void getUniforms();
+
     void renderIrises();
     void renderIris(const DRISHTI_EYE::EyeModel& eye);
+    void readback();
+    void store(const cv::Mat4b& image, const DRISHTI_EYE::EyeModel& eye);
+    void releasePBO();
+    void createMesh(int width);
+
+    static const char* vshaderEllipsoPolarSrc;
+
+    // Static mesh of normalized polar coordinates, the rays are computed in the vertex shader:
+    GLuint m_meshVbo = 0;
+    int m_meshWidth = 0;
+
+    GLint shParamUCenter;
+    GLint shParamUPupil;
+    GLint shParamUIris;
 
     EyeDelegate m_eyeDelegate;
     drishti::eye::EyeWarp m_eye;
+
+    bool m_doReadback = false;
+    bool m_usePBO = false;
+    cv::Size m_pboSize;
+    int m_pboIndex = 0;
+    std::array<GLuint, 2> m_pbo = { { 0, 0 } };
+    std::array<bool, 2> m_pboPending = { { false, false } };
+    std::array<DRISHTI_EYE::EyeModel, 2> m_pboEyes;
+    drishti::eye::NormalizedIris m_iris;
 };
 
 END_OGLES_GPGPU
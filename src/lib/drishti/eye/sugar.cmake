@@ -15,11 +15,14 @@ sugar_files(DRISHTI_EYE_SRCS
   Eye.cpp
   EyeArchiveCereal.cpp      
   EyeIO.cpp
+  EyeJson.cpp
   EyeModelEstimator.cpp
   EyeModelEstimatorArchiveCereal.cpp
   EyeModelEyelids.cpp
   EyeModelIris.cpp
   EyeModelPupil.cpp
+  EyePyramid.cpp
+  IrisCode.cpp
   IrisNormalizer.cpp
   NormalizedIris.cpp
   )
@@ -28,8 +31,11 @@ sugar_files(DRISHTI_EYE_HDRS_PUBLIC
   Eye.h
   EyeIO.h
   EyeImpl.h
+  EyeJson.h
   EyeModelEstimator.h
   EyeModelEstimatorImpl.h
+  EyePyramid.h
+  IrisCode.h
   IrisNormalizer.h
   NormalizedIris.h
   drishti_eye.h
@@ -9,9 +9,12 @@
 */
 
 #include "drishti/eye/EyeModelEstimator.h"
+#include "drishti/eye/IrisCode.h"
+#include "drishti/eye/IrisNormalizer.h"
 #include "drishti/core/drishti_stdlib_string.h"
 #include "drishti/core/drishti_cereal_pba.h"
 #include "drishti/core/drishti_cv_cereal.h"
+#include "drishti/testlib/drishti_alloc_counter.h"
 
 #include <cereal/archives/json.hpp>
 #include <cereal/archives/xml.hpp>
@@ -198,6 +201,74 @@ static bool isEqual(const drishti::eye::EyeModel& eyeA, const drishti::eye::EyeM
  * Basic class construction
  */
 
+TEST(IrisCode, RotationMatch)
+{
+    cv::Mat1b image(32, 128), mask(32, 128, 255);
+    cv::randu(image, 0, 255);
+    cv::GaussianBlur(image, image, { 5, 5 }, 1.0);
+
+    const drishti::eye::NormalizedIris iris(image, mask, { 0, 0, image.cols, image.rows });
+    const drishti::eye::IrisCode probe(iris);
+    ASSERT_EQ(probe.getWordsPerColumn(), 1);
+
+    drishti::eye::IrisCodeGallery gallery;
+    for (int i = 0; i < 4; i++)
+    {
+        cv::Mat1b other(image.size());
+        cv::randu(other, 0, 255);
+        cv::GaussianBlur(other, other, { 5, 5 }, 1.0);
+        gallery.add(drishti::eye::IrisCode({ other, mask, iris.getRoi() }));
+    }
+    gallery.add(drishti::eye::IrisCode(iris.rotate(3)));
+
+    drishti::eye::IrisMatch match;
+    EXPECT_EQ(gallery.search(probe, 8, match), 4);
+    EXPECT_EQ(match.distance, 0.f);
+    EXPECT_EQ(match.shift, 3);
+    EXPECT_EQ(match.bits, int(image.total() * 2));
+
+    // Independent textures are near 0.5:
+    std::vector<drishti::eye::IrisMatch> matches;
+    gallery.match(probe, 8, matches);
+    ASSERT_EQ(matches.size(), 5u);
+    EXPECT_GT(matches[0].distance, 0.3f);
+}
+
+TEST(EyeModel, LazyOutputs)
+{
+    drishti::eye::EyeModel eye;
+    for (int i = 0; i < 16; i++)
+    {
+        const float theta = float(i) * float(M_PI) / 8.f;
+        eye.eyelids.emplace_back(50.f - 40.f * std::cos(theta), 25.f + 15.f * std::sin(theta));
+    }
+    for (int i = 0; i < 9; i++)
+    {
+        eye.crease.emplace_back(10.f + 10.f * float(i), 5.f + 0.2f * float((i - 4) * (i - 4)));
+    }
+    eye.irisEllipse = cv::RotatedRect({ 45.f, 25.f }, { 24.f, 24.f }, 0.f);
+
+    drishti::eye::EyeModel lazy = eye;
+    eye.refine();
+    lazy.invalidate();
+    EXPECT_TRUE(lazy.eyelidsSpline.empty());
+    EXPECT_FALSE(lazy.irisCenter.has);
+
+    // Only the requested output is built:
+    EXPECT_TRUE(lazy.getEyelidsSpline() == eye.eyelidsSpline);
+    EXPECT_TRUE(lazy.creaseSpline.empty());
+    EXPECT_TRUE(lazy == eye);
+
+    // Pending landmarks of a mirrored eye have the labels of flopped landmarks:
+    lazy.invalidate();
+    eye.flop(100);
+    lazy.flop(100);
+    lazy.materialize();
+    ASSERT_TRUE(lazy.irisInner.has);
+    EXPECT_LT(cv::norm(*lazy.irisInner - *eye.irisInner), 1e-2);
+    EXPECT_LT(cv::norm(*lazy.irisOuter - *eye.irisOuter), 1e-2);
+}
+
 TEST(EyeModelEstimator, StringConstructor)
 {
     if (isArchiveSupported(sEyeModelPrivateFilename))
@@ -309,6 +380,145 @@ TEST_F(EyeModelEstimatorTest, IsRepeatable)
     }
 }
 
+TEST_F(EyeModelEstimatorTest, CloneSharesModels)
+{
+    if (!m_eye || !m_eyeSegmenter)
+    {
+        return;
+    }
+
+    auto clone = m_eyeSegmenter->clone();
+    ASSERT_TRUE(clone && clone->good());
+
+    // Stage hints are per instance:
+    clone->setEyelidStagesHint(1);
+    EXPECT_NE(m_eyeSegmenter->getEyelidStagesHint(), 1);
+    clone->setEyelidStagesHint(m_eyeSegmenter->getEyelidStagesHint());
+
+    for (auto iter = getFirstGreat(); iter != m_images.end(); iter++)
+    {
+        drishti::eye::EyeModel eyeA, eyeB;
+        EXPECT_EQ((*m_eyeSegmenter)(iter->second.image, eyeA), 0);
+        EXPECT_EQ((*clone)(iter->second.image, eyeB), 0);
+        eyeA.refine();
+        eyeB.refine();
+        EXPECT_EQ(isEqual(eyeA, eyeB), true);
+    }
+}
+
+TEST_F(EyeModelEstimatorTest, MirrorMatchesFlippedCrop)
+{
+    if (!m_eye || !m_eyeSegmenter)
+    {
+        return;
+    }
+
+    for (auto iter = getFirstGreat(); iter != m_images.end(); iter++)
+    {
+        const cv::Mat& image = iter->second.image;
+
+        cv::Mat flipped;
+        cv::flip(image, flipped, 1);
+
+        drishti::eye::EyeModel eyeA, eyeB;
+        EXPECT_EQ((*m_eyeSegmenter)(flipped, eyeA), 0);
+        EXPECT_EQ((*m_eyeSegmenter)(image, eyeB, nullptr, true), 0);
+        eyeA.flop(image.cols);
+
+        // Resampling order (flip vs. resize) may introduce small differences:
+        ASSERT_EQ(eyeA.eyelids.size(), eyeB.eyelids.size());
+        for (int i = 0; i < eyeA.eyelids.size(); i++)
+        {
+            EXPECT_LE(cv::norm(eyeA.eyelids[i] - eyeB.eyelids[i]), 0.02 * image.cols);
+        }
+    }
+}
+
+TEST_F(EyeModelEstimatorTest, PyramidMatchesCrop)
+{
+    if (!m_eye || !m_eyeSegmenter)
+    {
+        return;
+    }
+
+    for (auto iter = getFirstGreat(); iter != m_images.end(); iter++)
+    {
+        const cv::Mat& image = iter->second.image;
+
+        // The pyramid entry point is the same computation without the per call conversion:
+        const auto pyramid = m_eyeSegmenter->createPyramid(image);
+        EXPECT_EQ(pyramid.getRed().type(), CV_8UC1);
+
+        drishti::eye::EyeModel eyeA, eyeB;
+        EXPECT_EQ((*m_eyeSegmenter)(image, eyeA), 0);
+        EXPECT_EQ((*m_eyeSegmenter)(pyramid, eyeB), 0);
+        EXPECT_TRUE(isEqual(eyeA, eyeB));
+    }
+}
+
+TEST_F(EyeModelEstimatorTest, NormalizationCache)
+{
+    if (!m_eye || !m_eyeSegmenter)
+    {
+        return;
+    }
+
+    const cv::Size size(256, 64);
+    for (auto iter = getFirstGreat(); iter != m_images.end(); iter++)
+    {
+        const cv::Mat& image = iter->second.image;
+
+        drishti::eye::EyeModel eye;
+        EXPECT_EQ((*m_eyeSegmenter)(image, eye), 0);
+        if (eye.irisEllipse.size.area() == 0.f || eye.pupilEllipse.size.area() == 0.f)
+        {
+            continue;
+        }
+
+        drishti::eye::NormalizedIris exact, cached, repeat;
+        drishti::eye::IrisNormalizer()(image, eye, size, exact);
+
+        drishti::eye::IrisNormalizer normalizer(4);
+        normalizer(image, eye, size, cached);
+        normalizer(image, eye, size, repeat);
+
+        // Cache hits are identical, quantized geometry is close to the exact result:
+        EXPECT_EQ(cv::countNonZero(cached.getPaddedImage().reshape(1) != repeat.getPaddedImage().reshape(1)), 0);
+        EXPECT_LE(cv::norm(exact.getPaddedImage(), cached.getPaddedImage(), cv::NORM_L1) / exact.getPaddedImage().total(), 8.0);
+    }
+}
+
+TEST_F(EyeModelEstimatorTest, NormalizationMask)
+{
+    if (!m_eye || !m_eyeSegmenter)
+    {
+        return;
+    }
+
+    const cv::Size size(256, 64);
+    for (auto iter = getFirstGreat(); iter != m_images.end(); iter++)
+    {
+        const cv::Mat& image = iter->second.image;
+
+        drishti::eye::EyeModel eye;
+        EXPECT_EQ((*m_eyeSegmenter)(image, eye), 0);
+        if (eye.irisEllipse.size.area() == 0.f || eye.pupilEllipse.size.area() == 0.f)
+        {
+            continue;
+        }
+
+        // The analytic (ray/eyelid) mask should match the warped raster mask:
+        drishti::eye::NormalizedIris code;
+        cv::Mat1b mask;
+        drishti::eye::IrisNormalizer normalizer;
+        normalizer(image, eye, size, code);
+        normalizer.createMask(eye, size, mask);
+
+        const double agreement = double(cv::countNonZero(mask == code.getPaddedMask())) / mask.total();
+        EXPECT_GT(agreement, 0.95);
+    }
+}
+
 // Currently there is no internal quality check, but this is included for regression:
 TEST_F(EyeModelEstimatorTest, ImageIsBlack)
 {
@@ -338,6 +548,32 @@ TEST_F(EyeModelEstimatorTest, ImageIsWhite)
     checkValid(eye, entry.image.size());
 }
 
+// Once warm, the per frame heap allocations must stay within the budget:
+TEST_F(EyeModelEstimatorTest, SteadyStateAllocations)
+{
+    if (!m_eyeSegmenter)
+    {
+        return;
+    }
+
+    const int warmup = 4, frames = 16;
+    const std::uint64_t budget = 256; // allocations per frame (ratchet down as workspaces land)
+
+    const cv::Mat& image = m_images[m_targetWidth].image;
+    drishti::eye::EyeModel eye;
+    for (int i = 0; i < warmup; i++)
+    {
+        (*m_eyeSegmenter)(image, eye);
+    }
+
+    drishti::testlib::AllocationCounter counter;
+    for (int i = 0; i < frames; i++)
+    {
+        (*m_eyeSegmenter)(image, eye);
+    }
+    EXPECT_LE(counter.total().count, budget * frames) << counter;
+}
+
 // #######
 
 static cv::Mat scleraMask(const drishti::eye::EyeModel& eye, const cv::Size& size)
@@ -0,0 +1,181 @@
+/*! -*-c++-*-
+  @file   EyeCropper.cpp
+  @author David Hirvonen
+  @brief  Implementation of CPU eye crops with cached fixed point remap tables.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/EyeCropper.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+static int quantize(float value, float quantum)
+{
+    return static_cast<int>(std::lround(value / quantum));
+}
+
+EyeCropper::EyeCropper(std::size_t capacity, float angleQuantum, float scaleQuantum, float shiftQuantum)
+    : m_angleQuantum(angleQuantum)
+    , m_scaleQuantum(scaleQuantum)
+    , m_shiftQuantum(shiftQuantum)
+{
+    if (capacity > 0)
+    {
+        m_cache = std::make_shared<Cache>();
+        m_cache->capacity = capacity;
+    }
+}
+
+std::size_t EyeCropper::getCacheSize() const
+{
+    if (m_cache)
+    {
+        std::lock_guard<std::mutex> lock(m_cache->mutex);
+        return m_cache->entries.size();
+    }
+    return 0;
+}
+
+cv::Matx23f EyeCropper::quantize(const cv::Matx33f& H, Key& key, cv::Point& offset) const
+{
+    // Crop to image: [a -b; b a] + t
+    const cv::Matx33f Hinv = H.inv();
+    const float det = Hinv(0, 0) * Hinv(1, 1) - Hinv(0, 1) * Hinv(1, 0);
+    CV_Assert(det > 0.f); // no reflections
+
+    const float theta = std::atan2(Hinv(1, 0), Hinv(0, 0)) * 180.f / float(M_PI);
+    key[0] = face::quantize(theta, m_angleQuantum);
+    key[1] = face::quantize(0.5f * std::log2(det), m_scaleQuantum);
+
+    const float angle = key[0] * m_angleQuantum * float(M_PI) / 180.f;
+    const float scale = std::pow(2.f, key[1] * m_scaleQuantum);
+    const float a = scale * std::cos(angle), b = scale * std::sin(angle);
+
+    // Split the translation into the source offset and a subpixel bin:
+    const int steps = face::quantize(1.f, m_shiftQuantum);
+    const cv::Point2f t(Hinv(0, 2), Hinv(1, 2));
+    offset = { static_cast<int>(std::floor(t.x)), static_cast<int>(std::floor(t.y)) };
+    key[2] = face::quantize(t.x - offset.x, m_shiftQuantum);
+    key[3] = face::quantize(t.y - offset.y, m_shiftQuantum);
+    for (int i = 0; i < 2; i++)
+    {
+        if (key[2 + i] == steps)
+        {
+            key[2 + i] = 0;
+            (i ? offset.y : offset.x)++;
+        }
+    }
+
+    return cv::Matx23f(a, -b, key[2] * m_shiftQuantum, b, a, key[3] * m_shiftQuantum);
+}
+
+cv::Matx33f EyeCropper::quantize(const cv::Matx33f& H) const
+{
+    Key key;
+    cv::Point offset;
+    const cv::Matx23f Hinv = quantize(H, key, offset);
+    const cv::Matx33f G(Hinv(0, 0), Hinv(0, 1), Hinv(0, 2) + offset.x, Hinv(1, 0), Hinv(1, 1), Hinv(1, 2) + offset.y, 0.f, 0.f, 1.f);
+    return G.inv();
+}
+
+EyeCropper::Map EyeCropper::getMap(const Key& key, const cv::Matx23f& Hinv, const cv::Size& size) const
+{
+    if (m_cache)
+    {
+        std::lock_guard<std::mutex> lock(m_cache->mutex);
+        auto iter = m_cache->lookup.find(key);
+        if (iter != m_cache->lookup.end())
+        {
+            m_cache->entries.splice(m_cache->entries.begin(), m_cache->entries, iter->second);
+            return iter->second->second; // shallow copy, the tables are never modified
+        }
+    }
+
+    // Source region with the bilinear neighbors of the mapped crop corners:
+    cv::Point2f lower(std::numeric_limits<float>::max(), std::numeric_limits<float>::max()), upper = -lower;
+    for (const auto& c : { cv::Point2f(0, 0), cv::Point2f(size.width - 1, 0), cv::Point2f(0, size.height - 1), cv::Point2f(size.width - 1, size.height - 1) })
+    {
+        const cv::Point2f p(Hinv(0, 0) * c.x + Hinv(0, 1) * c.y + Hinv(0, 2), Hinv(1, 0) * c.x + Hinv(1, 1) * c.y + Hinv(1, 2));
+        lower = { std::min(lower.x, p.x), std::min(lower.y, p.y) };
+        upper = { std::max(upper.x, p.x), std::max(upper.y, p.y) };
+    }
+
+    Map map;
+    map.footprint = cv::Rect(cv::Point(int(std::floor(lower.x)), int(std::floor(lower.y))), cv::Point(int(std::floor(upper.x)) + 2, int(std::floor(upper.y)) + 2));
+
+    // Tables are created outside of the lock:
+    cv::Mat1f mapx(size), mapy(size);
+    const float x0 = Hinv(0, 2) - map.footprint.x, y0 = Hinv(1, 2) - map.footprint.y;
+    for (int y = 0; y < size.height; y++)
+    {
+        float* px = mapx.ptr<float>(y);
+        float* py = mapy.ptr<float>(y);
+        const float bx = Hinv(0, 1) * y + x0, by = Hinv(1, 1) * y + y0;
+        for (int x = 0; x < size.width; x++)
+        {
+            px[x] = bx + Hinv(0, 0) * x;
+            py[x] = by + Hinv(1, 0) * x;
+        }
+    }
+    cv::convertMaps(mapx, mapy, map.map1, map.map2, CV_16SC2);
+
+    if (m_cache)
+    {
+        std::lock_guard<std::mutex> lock(m_cache->mutex);
+        if (m_cache->lookup.find(key) == m_cache->lookup.end())
+        {
+            m_cache->entries.emplace_front(key, map);
+            m_cache->lookup[key] = m_cache->entries.begin();
+            if (m_cache->entries.size() > m_cache->capacity)
+            {
+                m_cache->lookup.erase(m_cache->entries.back().first);
+                m_cache->entries.pop_back();
+            }
+        }
+    }
+
+    return map;
+}
+
+cv::Matx33f EyeCropper::operator()(const cv::Mat& image, const cv::Matx33f& H, const cv::Size& size, cv::Mat& crop) const
+{
+    Key key;
+    cv::Point offset;
+    const cv::Matx23f Hinv = quantize(H, key, offset);
+    key[4] = size.width;
+    key[5] = size.height;
+
+    const Map map = getMap(key, Hinv, size);
+
+    // Remap from the footprint, zero padded at the image border:
+    const cv::Rect roi = map.footprint + offset;
+    const cv::Rect valid = roi & cv::Rect({ 0, 0 }, image.size());
+    cv::Mat src;
+    if (valid == roi)
+    {
+        src = image(roi);
+    }
+    else
+    {
+        src = cv::Mat(roi.size(), image.type(), cv::Scalar::all(0));
+        if (valid.area())
+        {
+            image(valid).copyTo(src(valid - roi.tl()));
+        }
+    }
+    cv::remap(src, crop, map.map1, map.map2, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+
+    const cv::Matx33f G(Hinv(0, 0), Hinv(0, 1), Hinv(0, 2) + offset.x, Hinv(1, 0), Hinv(1, 1), Hinv(1, 2) + offset.y, 0.f, 0.f, 1.f);
+    return G.inv();
+}
+
+DRISHTI_FACE_NAMESPACE_END
@@ -0,0 +1,81 @@
+/*! -*-c++-*-
+  @file   EyeCropper.h
+  @author David Hirvonen
+  @brief  Declaration of CPU eye crops with cached fixed point remap tables.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_face_EyeCropper_h__
+#define __drishti_face_EyeCropper_h__
+
+#include "drishti/face/drishti_face.h"
+
+#include <opencv2/core.hpp>
+
+#include <array>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+/*
+ * Warps images with similarity transformations (e.g., FaceStabilizer::stabilize()) for CPU
+ * only eye normalization.  The rotation (degrees), log2 scale and subpixel translation
+ * (pixels) of each transformation are quantized to bins, and the fixed point cv::remap()
+ * tables of a bin are cached (LRU), so tracked eyes, which stay in a few bins, are cropped
+ * with a single table lookup and an integer remap.  The integer part of the translation
+ * only selects the source region.  Copies share the cache.
+ */
+
+class EyeCropper
+{
+public:
+    EyeCropper(std::size_t capacity = 64, float angleQuantum = 0.25f, float scaleQuantum = 1.f / 256.f, float shiftQuantum = 1.f / 8.f);
+
+    // Returns the (quantized) transformation that was applied: crop = Hq * image
+    cv::Matx33f operator()(const cv::Mat& image, const cv::Matx33f& H, const cv::Size& size, cv::Mat& crop) const;
+
+    cv::Matx33f quantize(const cv::Matx33f& H) const;
+
+    std::size_t getCacheSize() const;
+
+protected:
+    using Key = std::array<int, 6>;
+
+    // Fixed point tables relative to the footprint origin in the source image:
+    struct Map
+    {
+        cv::Mat map1; // CV_16SC2
+        cv::Mat map2; // CV_16UC1
+        cv::Rect footprint;
+    };
+
+    struct Cache
+    {
+        using Entry = std::pair<Key, Map>;
+
+        std::size_t capacity;
+        std::list<Entry> entries; // most recently used first
+        std::map<Key, std::list<Entry>::iterator> lookup;
+        std::mutex mutex;
+    };
+
+    // Inverse (crop to image) transformation for the bin, with integer source offset:
+    cv::Matx23f quantize(const cv::Matx33f& H, Key& key, cv::Point& offset) const;
+    Map getMap(const Key& key, const cv::Matx23f& Hinv, const cv::Size& size) const;
+
+    float m_angleQuantum;
+    float m_scaleQuantum;
+    float m_shiftQuantum;
+
+    std::shared_ptr<Cache> m_cache;
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_EyeCropper_h__
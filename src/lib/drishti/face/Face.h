@@ -92,6 +92,9 @@ struct FaceModel
 
     core::Field<cv::Point3f> eyesCenter;
 
+    // Spread of the multi init landmark estimates (roi widths, see FaceDetector::setInits()), not serialized:
+    core::Field<float> disagreement;
+
     template <typename T>
     FaceModel& operator+=(const cv::Point_<T>& p)
     {
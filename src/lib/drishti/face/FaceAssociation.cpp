@@ -0,0 +1,334 @@
+/*! -*-c++-*-
+  @file   FaceAssociation.cpp
+  @author David Hirvonen
+  @brief  Implementation of a cross camera face track association.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FaceAssociation.h"
+#include "drishti/core/make_unique.h"
+#include "drishti/core/hungarian.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <unordered_map>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+static const double kGated = 1e6; // cost of pairs beyond the threshold (meters)
+static const std::size_t kNone = std::numeric_limits<std::size_t>::max();
+
+struct FaceAssociation::Impl
+{
+    struct Node
+    {
+        cv::Point3f position; // world frame
+        std::size_t identity = kNone;
+        std::size_t update = 0; // last update() reporting the track
+    };
+
+    struct Camera
+    {
+        sensor::SensorModel::Extrinsic extrinsic;
+        std::map<std::size_t, Node> tracks; // TrackInfo::identifier -> node
+    };
+
+    using IdentityMap = std::map<std::size_t, std::vector<Member>>;
+
+    Impl(float costThreshold)
+        : m_costThreshold(costThreshold)
+    {
+    }
+
+    void update(int camera, const FaceTrackVec& tracks)
+    {
+        Camera& cam = m_cameras[camera];
+
+        m_update++;
+        for (const auto& track : tracks)
+        {
+            Node& node = cam.tracks[track.second.identifier];
+            node.position = cam.extrinsic.toWorld(track.second.motion.position);
+            node.update = m_update;
+        }
+
+        // Tracks that are no longer reported, or that moved away from their identity:
+        for (auto iter = cam.tracks.begin(); iter != cam.tracks.end();)
+        {
+            Node& node = iter->second;
+            if (node.update != m_update)
+            {
+                detach(camera, iter->first, node);
+                iter = cam.tracks.erase(iter);
+                continue;
+            }
+
+            cv::Point3f center;
+            if ((node.identity != kNone) && getCenter(m_identities.at(node.identity), camera, center))
+            {
+                if (cv::norm(node.position - center) > m_costThreshold)
+                {
+                    detach(camera, iter->first, node);
+                }
+            }
+            iter++;
+        }
+
+        associate(camera);
+    }
+
+    /*
+     * Candidates are the camera tracks without an identity, or alone in their identity (which
+     * can then join one seen by the other cameras), and targets are the identities with no
+     * track from this camera.  As in FaceTracker, gated pairs are removed and the connected
+     * components of the remaining graph are solved independently.
+     */
+
+    void associate(int camera)
+    {
+        Camera& cam = m_cameras[camera];
+
+        std::vector<std::pair<std::size_t, Node*>> candidates;
+        for (auto& entry : cam.tracks)
+        {
+            const std::size_t identity = entry.second.identity;
+            if ((identity == kNone) || (m_identities.at(identity).size() == 1))
+            {
+                candidates.emplace_back(entry.first, &entry.second);
+            }
+        }
+
+        std::vector<std::pair<std::size_t, cv::Point3f>> targets;
+        for (const auto& entry : m_identities)
+        {
+            cv::Point3f center;
+            if (!hasCamera(entry.second, camera) && getCenter(entry.second, camera, center))
+            {
+                targets.emplace_back(entry.first, center);
+            }
+        }
+
+        std::vector<int> assignment; // candidate -> target (or -1)
+        assign(candidates, targets, assignment);
+
+        for (int i = 0; i < candidates.size(); i++)
+        {
+            Node& node = *candidates[i].second;
+            if (assignment[i] >= 0)
+            {
+                detach(camera, candidates[i].first, node);
+                node.identity = targets[assignment[i]].first;
+                m_identities[node.identity].emplace_back(camera, candidates[i].first);
+            }
+            else if (node.identity == kNone)
+            {
+                node.identity = m_id++;
+                m_identities[node.identity].emplace_back(camera, candidates[i].first);
+            }
+        }
+    }
+
+    void assign(const std::vector<std::pair<std::size_t, Node*>>& candidates,
+        const std::vector<std::pair<std::size_t, cv::Point3f>>& targets,
+        std::vector<int>& assignment)
+    {
+        const int rows = int(candidates.size()), cols = int(targets.size());
+        assignment.assign(rows, -1);
+
+        // Flat gated cost buffer and union-find over the [candidates, targets] nodes:
+        m_cost.resize(rows * cols);
+        m_parent.resize(rows + cols);
+        m_linked.assign(rows + cols, 0);
+        std::iota(m_parent.begin(), m_parent.end(), 0);
+        for (int i = 0; i < rows; i++)
+        {
+            for (int j = 0; j < cols; j++)
+            {
+                const double cost = cv::norm(candidates[i].second->position - targets[j].second);
+                m_cost[i * cols + j] = (cost <= m_costThreshold) ? cost : kGated;
+                if (cost <= m_costThreshold)
+                {
+                    m_parent[find(i)] = find(rows + j);
+                    m_linked[i] = m_linked[rows + j] = 1;
+                }
+            }
+        }
+
+        // Gather the components with at least one edge:
+        std::unordered_map<int, std::pair<std::vector<int>, std::vector<int>>> components;
+        for (int i = 0; i < rows; i++)
+        {
+            if (m_linked[i])
+            {
+                components[find(i)].first.push_back(i);
+            }
+        }
+        for (int j = 0; j < cols; j++)
+        {
+            if (m_linked[rows + j])
+            {
+                components[find(rows + j)].second.push_back(j);
+            }
+        }
+
+        for (const auto& entry : components)
+        {
+            const auto& rowIds = entry.second.first;
+            const auto& colIds = entry.second.second;
+            if ((rowIds.size() == 1) || (colIds.size() == 1))
+            {
+                // Trivial component: the cheapest pair is optimal
+                int bestRow = rowIds.front(), bestCol = colIds.front();
+                for (int i : rowIds)
+                {
+                    for (int j : colIds)
+                    {
+                        if (m_cost[i * cols + j] < m_cost[bestRow * cols + bestCol])
+                        {
+                            bestRow = i;
+                            bestCol = j;
+                        }
+                    }
+                }
+                assignment[bestRow] = bestCol;
+            }
+            else
+            {
+                std::vector<std::vector<double>> C(rowIds.size(), std::vector<double>(colIds.size()));
+                for (int i = 0; i < rowIds.size(); i++)
+                {
+                    for (int j = 0; j < colIds.size(); j++)
+                    {
+                        C[i][j] = m_cost[rowIds[i] * cols + colIds[j]];
+                    }
+                }
+
+                std::unordered_map<int, int> direct_assignment, reverse_assignment;
+                core::MinimizeLinearAssignment(C, direct_assignment, reverse_assignment);
+                for (const auto& m : direct_assignment)
+                {
+                    if (C[m.first][m.second] < kGated)
+                    {
+                        assignment[rowIds[m.first]] = colIds[m.second];
+                    }
+                }
+            }
+        }
+    }
+
+    // Remove a track from its identity (and empty identities):
+    void detach(int camera, std::size_t track, Node& node)
+    {
+        if (node.identity != kNone)
+        {
+            auto iter = m_identities.find(node.identity);
+            auto& members = iter->second;
+            members.erase(std::remove_if(members.begin(), members.end(), [&](const Member& m) {
+                return (m.camera == camera) && (m.track == track);
+            }),
+                members.end());
+            if (members.empty())
+            {
+                m_identities.erase(iter);
+            }
+            node.identity = kNone;
+        }
+    }
+
+    static bool hasCamera(const std::vector<Member>& members, int camera)
+    {
+        return std::any_of(members.begin(), members.end(), [&](const Member& m) { return m.camera == camera; });
+    }
+
+    // Mean position of the members from the other cameras:
+    bool getCenter(const std::vector<Member>& members, int camera, cv::Point3f& center) const
+    {
+        int count = 0;
+        center = {};
+        for (const auto& m : members)
+        {
+            if (m.camera != camera)
+            {
+                center += m_cameras[m.camera].tracks.at(m.track).position;
+                count++;
+            }
+        }
+        if (count)
+        {
+            center *= 1.f / float(count);
+        }
+        return (count > 0);
+    }
+
+    int find(int i)
+    {
+        while (m_parent[i] != i)
+        {
+            i = m_parent[i] = m_parent[m_parent[i]]; // path halving
+        }
+        return i;
+    }
+
+    float m_costThreshold = 0.25f; // meters
+
+    std::size_t m_id = 0;
+    std::size_t m_update = 0;
+
+    std::vector<Camera> m_cameras;
+    IdentityMap m_identities;
+
+    std::vector<double> m_cost; // gated candidate x target costs (see assign())
+    std::vector<int> m_parent;  // union-find forest for the components
+    std::vector<std::uint8_t> m_linked; // nodes with at least one gated pair
+};
+
+FaceAssociation::FaceAssociation(float costThreshold)
+{
+    m_impl = drishti::core::make_unique<Impl>(costThreshold);
+}
+
+FaceAssociation::~FaceAssociation() = default;
+
+int FaceAssociation::addCamera(const sensor::SensorModel& sensor)
+{
+    m_impl->m_cameras.emplace_back();
+    m_impl->m_cameras.back().extrinsic = sensor.extrinsic();
+    return int(m_impl->m_cameras.size()) - 1;
+}
+
+void FaceAssociation::update(int camera, const FaceTrackVec& tracks)
+{
+    m_impl->update(camera, tracks);
+}
+
+bool FaceAssociation::getIdentity(int camera, std::size_t track, std::size_t& identifier) const
+{
+    const auto& tracks = m_impl->m_cameras[camera].tracks;
+    const auto iter = tracks.find(track);
+    if ((iter != tracks.end()) && (iter->second.identity != kNone))
+    {
+        identifier = iter->second.identity;
+        return true;
+    }
+    return false;
+}
+
+void FaceAssociation::getIdentities(IdentityVec& identities) const
+{
+    identities.clear();
+    for (const auto& entry : m_impl->m_identities)
+    {
+        identities.emplace_back();
+        auto& identity = identities.back();
+        identity.identifier = entry.first;
+        identity.members = entry.second;
+        m_impl->getCenter(entry.second, -1, identity.position);
+    }
+}
+
+DRISHTI_FACE_NAMESPACE_END
@@ -0,0 +1,83 @@
+/*! -*-c++-*-
+  @file   FaceAssociation.h
+  @author David Hirvonen
+  @brief  Declaration of a cross camera face track association.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_face_FaceAssociation_h__
+#define __drishti_face_FaceAssociation_h__
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/face/FaceTracker.h"
+#include "drishti/sensor/Sensor.h"
+
+#include <memory>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+/*
+ * Associates the tracks of several FaceTracker instances (one per camera) with shared
+ * identities.  Track positions (TrackInfo::motion, camera coordinates) are mapped to a common
+ * frame with the sensor extrinsics, and an identity holds at most one track per camera.
+ *
+ * Each update() only (re)associates the tracks of the updated camera: tracks that stay within
+ * the cost threshold of the other members of their identity keep it, and the new (or
+ * detached) ones are assigned to the identities with no track from that camera, with the
+ * same gated sparse assignment as FaceTracker.
+ */
+
+class FaceAssociation
+{
+public:
+    using FaceTrackVec = FaceTracker::FaceTrackVec;
+
+    struct Member
+    {
+        Member() = default;
+        Member(int camera, std::size_t track)
+            : camera(camera)
+            , track(track)
+        {
+        }
+
+        int camera = 0;
+        std::size_t track = 0; // TrackInfo::identifier
+    };
+
+    struct Identity
+    {
+        std::size_t identifier = 0;
+        cv::Point3f position;        // mean member position (world frame, meters)
+        std::vector<Member> members; // at most one per camera
+    };
+
+    using IdentityVec = std::vector<Identity>;
+
+    struct Impl;
+
+    FaceAssociation(float costThreshold = 0.25f);
+    ~FaceAssociation();
+
+    // Register a camera and return its index, see sensor::SensorModel::Extrinsic::toWorld():
+    int addCamera(const sensor::SensorModel& sensor);
+
+    // Replace the track snapshot of a camera (i.e., FaceTracker output), tracks that are no
+    // longer reported leave their identity:
+    void update(int camera, const FaceTrackVec& tracks);
+
+    // Shared identity of a camera track:
+    bool getIdentity(int camera, std::size_t track, std::size_t& identifier) const;
+
+    void getIdentities(IdentityVec& identities) const;
+
+protected:
+    std::unique_ptr<Impl> m_impl;
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceAssociation_h__
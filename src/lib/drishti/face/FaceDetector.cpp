@@ -10,13 +10,17 @@
 
 #include "drishti/core/drishti_core.h"
 #include "drishti/core/make_unique.h"
+#include "drishti/core/FrameArena.h"
 #include "drishti/core/timing.h"
 #include "drishti/core/Parallel.h"
+#include "drishti/core/ParallelFor.h"
+#include "drishti/core/LazyParallelResource.h"
 #include "drishti/face/FaceDetector.h"
 #include "drishti/face/FaceIO.h"
 #include "drishti/geometry/Primitives.h"
 #include "drishti/ml/ShapeEstimator.h"
 #include "drishti/ml/ObjectDetector.h"
+#include "drishti/ml/NonMaximaSuppression.h"
 #include "drishti/ml/RegressionTreeEnsembleShapeEstimator.h"
 #include "drishti/face/Face.h"
 #include "drishti/eye/EyeModelEstimator.h"
@@ -25,7 +29,15 @@
 
 #include <acf/ACF.h> // ACF detection
 
+#include <opencv2/imgproc.hpp>
+
 #include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <thread>
 
 #define DRISHTI_FACE_DETECTOR_DO_SIMILARITY_MOTION 1
 
@@ -35,7 +47,6 @@ using drishti::geometry::operator*;
 
 // Map from normalized coordinate system to input ROI
 static cv::Matx33f denormalize(const cv::Rect& roi);
-static void chooseBest(std::vector<cv::Rect>& objects, std::vector<double>& scores);
 
 // ((((((((((((((( Impl )))))))))))))))
 class FaceDetector::Impl
@@ -44,6 +55,20 @@ public:
     typedef FaceDetector::MatLoggerType MatLoggerType;
     typedef FaceDetector::TimeLoggerType TimeLoggerType;
     typedef FaceDetector::EyeCropper EyeCropper;
+    typedef FaceDetector::EyeEstimatorAllocator EyeEstimatorAllocator;
+    typedef FaceDetector::ThreadPoolPtr ThreadPoolPtr;
+    typedef std::unique_ptr<DRISHTI_EYE::EyeModelEstimator> EyeEstimatorPtr;
+    typedef drishti::core::ThreadLocalParallelResource<EyeEstimatorPtr> EyeEstimatorPool;
+    typedef std::array<core::Field<DRISHTI_EYE::EyeModel>, 2> EyePriors;
+
+    // Per call scratch memory (padded crops, eye jobs), one set for each calling thread:
+    struct Scratch
+    {
+        core::FrameArena faceArena;
+        core::FrameArena eyeArena;
+        std::vector<cv::Mat> landmarkLevels; // coarse-to-fine regression (see ShapeEstimator::estimatePyramid())
+    };
+    typedef drishti::core::ThreadLocalParallelResource<std::unique_ptr<Scratch>> ScratchPool;
 
     Impl(FaceDetectorFactory& resources)
     {
@@ -56,16 +81,15 @@ public:
     {
         m_detector = resources.getFaceDetector();
         m_regressor = resources.getFaceEstimator();
-        m_eyeRegressor.resize(2);
-        for (int i = 0; i < 2; i++)
-        {
-            m_eyeRegressor[i] = resources.getEyeEstimator();
-        }
+        m_eyeRegressor = resources.getEyeEstimator(); // one model for both eyes
+        setLandmarkFormat(m_landmarkFormat);
     }
 
     void setLandmarkFormat(FaceSpecification::Format format)
     {
+        // Landmark subset regressors only estimate some of the points of the format:
         m_landmarkFormat = format;
+        m_landmarkMap = FaceLandmarkMap(format, m_regressor ? m_regressor->getLandmarks() : std::vector<int>());
     }
 
     /*
@@ -80,13 +104,13 @@ public:
     void detect(const ImageType& I, std::vector<dsdkc::Shape>& shapes)
     {
         // clang-format off
-        drishti::core::ScopeTimeLogger scopeTimeLogger = [this](double elapsed)
+        auto scopeTimeLogger = drishti::core::makeScopeTimer<drishti::core::kTimingDetection>("detection", [this](double elapsed)
         {
             if (m_detectionTimeLogger)
             {
                 m_detectionTimeLogger(elapsed);
             }
-        };
+        });
         // clang-format on
 
         // Detect objects:
@@ -96,7 +120,7 @@ public:
 
         if (m_doNMSGlobal)
         {
-            chooseBest(objects, scores);
+            drishti::ml::chooseBest(objects, scores);
         }
 
         for (int i = 0; i < objects.size(); i++)
@@ -106,6 +130,111 @@ public:
     }
 
     void refineFace(const PaddedImage& Ib, std::vector<FaceModel>& faces, const cv::Matx33f& H, bool isDetection)
+    {
+        // Tracking mode: keep the previous eyes (cleared by shapesToFaces()) to seed the eye models:
+        std::vector<EyePriors> eyePriors(faces.size());
+        if (m_doEyeTracking && !isDetection)
+        {
+            for (int i = 0; i < faces.size(); i++)
+            {
+                eyePriors[i] = { { faces[i].eyeFullR, faces[i].eyeFullL } };
+            }
+        }
+
+        if (isEyeOnlyFrame(faces, isDetection))
+        {
+            refineEyes(Ib, faces, H, eyePriors);
+        }
+        else
+        {
+            m_eyeOnlyFrames = 0;
+            refineFaceAndEyes(Ib, faces, H, isDetection, eyePriors);
+        }
+    }
+
+    // Tracked faces with both eyes skip the face landmark regression on all but every
+    // m_faceRegressionInterval frames (see refineEyes()):
+    bool isEyeOnlyFrame(const std::vector<FaceModel>& faces, bool isDetection)
+    {
+        if (isDetection || (m_faceRegressionInterval <= 1) || !m_eyeRegressor || !m_doEyeRefinement)
+        {
+            return false;
+        }
+        if (++m_eyeOnlyFrames >= m_faceRegressionInterval)
+        {
+            return false; // periodic full regression
+        }
+        return std::all_of(faces.begin(), faces.end(), [](const FaceModel& face) {
+            return face.eyeFullR.has && face.eyeFullR->eyelids.size() && face.eyeFullL.has && face.eyeFullL->eyelids.size();
+        });
+    }
+
+    // 1 at the predicted eye centers, 0 once an eye moves by a quarter of the inter-ocular distance:
+    static float getEyeConfidence(const FaceModel& face, const std::array<cv::Point2f, 2>& predicted)
+    {
+        if (!face.eyeFullR.has || !face.eyeFullL.has)
+        {
+            return 0.f;
+        }
+
+        const float iod = cv::norm(predicted[0] - predicted[1]);
+        const float driftR = cv::norm(core::centroid(face.eyeFullR->eyelids) - predicted[0]);
+        const float driftL = cv::norm(core::centroid(face.eyeFullL->eyelids) - predicted[1]);
+        return std::max(1.f - std::max(driftR, driftL) / std::max(iod * 0.25f, 1.f), 0.f);
+    }
+
+    // Eye only update: the eye regions are centered on the eyes of the track (i.e., already
+    // motion predicted by the tracker) and the face landmarks are kept as is.  Faces whose
+    // eyes are lost or drift below m_eyeConfidenceThreshold get a full regression instead:
+    void refineEyes(const PaddedImage& Ib, std::vector<FaceModel>& faces, const cv::Matx33f& H, const std::vector<EyePriors>& eyePriors)
+    {
+        std::vector<FaceModel> proxies(faces.size());
+        std::vector<std::array<cv::Point2f, 2>> predicted(faces.size());
+        for (int i = 0; i < faces.size(); i++)
+        {
+            predicted[i] = { { core::centroid(faces[i].eyeFullR->eyelids), core::centroid(faces[i].eyeFullL->eyelids) } };
+            proxies[i].eyeRightCenter = predicted[i][0];
+            proxies[i].eyeLeftCenter = predicted[i][1];
+        }
+
+        segmentEyes(Ib.Ib, proxies, eyePriors);
+
+        std::vector<int> lost;
+        for (int i = 0; i < faces.size(); i++)
+        {
+            if (getEyeConfidence(proxies[i], predicted[i]) >= m_eyeConfidenceThreshold)
+            {
+                faces[i].eyeFullR = proxies[i].eyeFullR;
+                faces[i].eyeFullL = proxies[i].eyeFullL;
+                faces[i].eyeRightCenter = proxies[i].eyeRightCenter;
+                faces[i].eyeLeftCenter = proxies[i].eyeLeftCenter;
+            }
+            else
+            {
+                lost.push_back(i);
+            }
+        }
+
+        if (lost.size())
+        {
+            std::vector<FaceModel> subset(lost.size());
+            std::vector<EyePriors> subsetPriors(lost.size());
+            for (int i = 0; i < lost.size(); i++)
+            {
+                subset[i] = faces[lost[i]];
+                subsetPriors[i] = eyePriors[lost[i]];
+            }
+
+            refineFaceAndEyes(Ib, subset, H, false, subsetPriors);
+
+            for (int i = 0; i < lost.size(); i++)
+            {
+                faces[lost[i]] = subset[i];
+            }
+        }
+    }
+
+    void refineFaceAndEyes(const PaddedImage& Ib, std::vector<FaceModel>& faces, const cv::Matx33f& H, bool isDetection, const std::vector<EyePriors>& eyePriors)
     {
         // Find the landmarks:
         if (m_regressor)
@@ -114,115 +243,240 @@ public:
             std::transform(faces.begin(), faces.end(), shapes.begin(), [](const FaceModel& face) {
                 return dsdkc::Shape(face.roi);
             });
-            findLandmarks(Ib, shapes, H, isDetection);
-            shapesToFaces(shapes, faces);
-        }
 
-        if (m_eyeRegressor.size() && m_eyeRegressor[0] && m_eyeRegressor[1] && m_doEyeRefinement && faces.size())
-        {
-            for (auto& f : faces)
+            // Tracking mode: start the cascade from the landmarks of the previous frame:
+            std::vector<Landmarks> priors;
+            if (m_doFaceTracking && !isDetection)
             {
-                DRISHTI_EYE::EyeModel eyeR, eyeL;
-                segmentEyes(Ib.Ib, f, eyeR, eyeL);
-                if (eyeR.eyelids.size())
-                {
-                    f.eyeFullR = eyeR;
-                    f.eyeRightCenter = core::centroid(eyeR.eyelids);
-                }
-                if (eyeL.eyelids.size())
+                priors.resize(faces.size());
+                for (int i = 0; i < faces.size(); i++)
                 {
-                    f.eyeFullL = eyeL;
-                    f.eyeLeftCenter = core::centroid(eyeL.eyelids);
+                    if (faces[i].points.has)
+                    {
+                        priors[i] = *faces[i].points;
+                    }
                 }
             }
+
+            std::vector<float> disagreement;
+            findLandmarks(Ib, shapes, H, isDetection, priors, disagreement);
+            shapesToFaces(shapes, faces);
+            for (int i = 0; i < faces.size(); i++)
+            {
+                faces[i].disagreement = disagreement[i];
+            }
+        }
+
+        if (m_eyeRegressor && m_doEyeRefinement && faces.size())
+        {
+            segmentEyes(Ib.Ib, faces, eyePriors);
+        }
+    }
+
+    // Jobs are only distributed when a pool was provided and there is more than one:
+    bool hasFanOut(std::size_t count) const
+    {
+        return m_threads && (count > 1);
+    }
+
+    // The calling thread uses the default regressor while it owns it, workers (and callers that
+    // overlap with another refine()) use a lazily allocated clone:
+    DRISHTI_EYE::EyeModelEstimator& getEyeRegressor(const std::thread::id& caller, bool isOwner)
+    {
+        if (!m_eyeRegressorPool || (isOwner && (std::this_thread::get_id() == caller)))
+        {
+            return *m_eyeRegressor;
+        }
+        return *m_eyeRegressorPool->get();
+    }
+
+    // Worker regressors are copies that share the models of the default regressor when possible:
+    EyeEstimatorPtr createEyeRegressor()
+    {
+        EyeEstimatorPtr regressor = m_eyeRegressor ? m_eyeRegressor->clone() : m_eyeAllocator();
+        configureEyeRegressor(*regressor);
+        return regressor;
+    }
+
+    // Propagate any stage hints set prior to the clone:
+    void configureEyeRegressor(DRISHTI_EYE::EyeModelEstimator& regressor) const
+    {
+        if (m_eyelidStagesHint >= 0)
+        {
+            regressor.setEyelidStagesHint(m_eyelidStagesHint);
+        }
+        if (m_irisStagesHint >= 0)
+        {
+            regressor.setIrisStagesHint(m_irisStagesHint);
+        }
+        if (m_eyelidConvergenceThreshold >= 0.f)
+        {
+            regressor.setEyelidConvergenceThreshold(m_eyelidConvergenceThreshold);
+        }
+        if (m_irisConvergenceThreshold >= 0.f)
+        {
+            regressor.setIrisConvergenceThreshold(m_irisConvergenceThreshold);
+        }
+        if (m_eyeTrackingStagesHint >= 0)
+        {
+            regressor.setTrackingStagesHint(m_eyeTrackingStagesHint);
+        }
+        regressor.setThreads(m_threads);
+    }
+
+    void setThreads(const ThreadPoolPtr& threads, const EyeEstimatorAllocator& allocator)
+    {
+        m_threads = threads;
+        m_eyeAllocator = allocator;
+        m_eyeRegressorPool.reset();
+        if (m_eyeRegressor)
+        {
+            m_eyeRegressor->setThreads(m_threads); // candidates share the face/eye pool
+        }
+        if (m_threads && m_eyeAllocator)
+        {
+            m_eyeRegressorPool = drishti::core::make_unique<EyeEstimatorPool>([this]() { return createEyeRegressor(); });
         }
     }
 
     using RectPair = std::array<cv::Rect, 2>;
     using MatPair = std::array<cv::Mat, 2>;
-    static void extractCrops(const cv::Mat& Ib, const RectPair& eyes, const cv::Rect& bounds, MatPair& crops)
+
+    // One eye of the batch, eye and prior are in the (unflipped) crop coordinate system:
+    struct EyeJob
+    {
+        int face = 0;
+        bool mirror = false;
+        cv::Mat crop;
+        cv::Rect roi;
+        core::Field<DRISHTI_EYE::EyeModel> prior;
+        DRISHTI_EYE::EyeModel eye;
+    };
+    void extractCrops(const cv::Mat& Ib, const RectPair& eyes, MatPair& crops, core::FrameArena& arena)
     {
         for (int i = 0; i < 2; i++)
         {
-            cv::Rect roi = eyes[i] & bounds;
-            if (roi == eyes[i])
-            {
-                crops[i] = Ib(roi); // shallow copy
-            }
-            else
-            {
-                // We use a crop preserving deep copy in rare case of clipping
-                crops[i].create(eyes[i].size(), CV_8UC1);
-                crops[i].setTo(0);
-                Ib(roi).copyTo(crops[i](roi - eyes[i].tl()));
-            }
+            crops[i] = geometryPreservingCrop(eyes[i], Ib, arena);
         }
     }
 
-    void segmentEyes(const cv::Mat1b& Ib, FaceModel& face, DRISHTI_EYE::EyeModel& eyeR, DRISHTI_EYE::EyeModel& eyeL)
+    // Both eyes of all faces are estimated as a single batch with one (shared model) regressor,
+    // the left eye is mirrored to the right eye model in the estimator instead of flipping the crop:
+    void segmentEyes(const cv::Mat1b& Ib, std::vector<FaceModel>& faces, const std::vector<EyePriors>& priors)
     {
-        cv::Rect2f roiR, roiL;
-        bool hasEyes = face.getEyeRegions(roiR, roiL, 0.666);
-        if (hasEyes && roiR.area() && roiL.area())
+        // clang-format off
+        auto scopeTimeLogger = drishti::core::makeScopeTimer<drishti::core::kTimingRegression>("eye_regression", [this](double elapsed)
         {
-            // clang-format off
-            drishti::core::ScopeTimeLogger scopeTimeLogger = [this](double elapsed)
+            if (m_eyeRegressionTimeLogger)
             {
-                if (m_eyeRegressionTimeLogger)
+                m_eyeRegressionTimeLogger(elapsed);
+            }
+        });
+        // clang-format on
+
+        auto& arena = m_scratch.get()->eyeArena;
+        arena.reset();
+        core::ArenaVector<EyeJob> jobs(arena);
+        jobs.reserve(faces.size() * 2);
+        for (int i = 0; i < faces.size(); i++)
+        {
+            cv::Rect2f roiR, roiL;
+            bool hasEyes = faces[i].getEyeRegions(roiR, roiL, 0.666);
+            if (hasEyes && roiR.area() && roiL.area())
+            {
+                MatPair crops;
+                RectPair eyes = { { roiR, roiL } };
+                extractCrops(Ib, eyes, crops, arena);
+
+                cv::Point2f v = geometry::centroid<float, float>(roiR) - geometry::centroid<float, float>(roiL);
+                float theta = std::atan2(v.y, v.x);
+
+                for (int j = 0; j < 2; j++)
                 {
-                    m_eyeRegressionTimeLogger(elapsed);
+                    EyeJob job;
+                    job.face = i;
+                    job.crop = crops[j];
+                    job.roi = eyes[j];
+                    job.mirror = (j == 1);
+                    job.eye.angle = job.mirror ? float(M_PI + theta) : theta; // i.e., (-theta) in the mirrored eye
+                    if (priors[i][j].has)
+                    {
+                        job.prior = (*priors[i][j]) - eyes[j].tl(); // map the previous eye to the crop
+                    }
+                    jobs.push_back(job);
                 }
-            };
-            // clang-format on
-
-            MatPair crops;
-            RectPair eyes = { { roiR, roiL } };
-            extractCrops(Ib, eyes, { { 0, 0 }, Ib.size() }, crops);
+            }
+        }
 
-            cv::Mat flipped;
-            cv::flip(crops[1], flipped, 1); // Flip left eye to right eye cs
-            crops[1] = flipped;
+        // Concurrent refine() calls (e.g., overlapping scene jobs) can't share the default regressor,
+        // without a pool we wait for it:
+        std::unique_lock<std::mutex> owner(m_eyeRegressorMutex, std::defer_lock);
+        if (m_eyeRegressorPool)
+        {
+            owner.try_lock();
+        }
+        else
+        {
+            owner.lock();
+        }
 
-            cv::Point2f v = geometry::centroid<float, float>(roiR) - geometry::centroid<float, float>(roiL);
-            float theta = std::atan2(v.y, v.x);
-            eyeR.angle = theta;
-            eyeL.angle = (-theta);
+        const auto caller = std::this_thread::get_id();
+        const bool isOwner = owner.owns_lock();
+        auto segment = [&](int k) {
+            auto& job = jobs[k];
+            auto& regressor = getEyeRegressor(caller, isOwner);
+            regressor.setDoIndependentIrisAndPupil(m_doIrisRefinement);
+            regressor.setEyelidInits(1);
+            regressor.setIrisInits(1);
+            regressor(job.crop, job.eye, job.prior.has ? &job.prior.value : nullptr, job.mirror);
+
+            job.eye += job.roi.tl(); // shift features to image coordinate system
+            job.eye.roi = job.roi;
+        };
 
-            std::array<DRISHTI_EYE::EyeModel*, 2> results{ { &eyeR, &eyeL } };
-            for (int i = 0; i < 2; i++)
+        if (hasFanOut(jobs.size()) && m_eyeRegressorPool)
+        {
+            drishti::core::parallel_for(m_threads.get(), int(jobs.size()), segment);
+        }
+        else
+        {
+            for (int k = 0; k < jobs.size(); k++)
             {
-                m_eyeRegressor[i]->setDoIndependentIrisAndPupil(m_doIrisRefinement);
-                m_eyeRegressor[i]->setEyelidInits(1);
-                m_eyeRegressor[i]->setIrisInits(1);
+                segment(k);
             }
+        }
 
-            drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
-                (*m_eyeRegressor[i])(crops[i], *results[i]);
-            };
-
-            //harness({0, 2});
-            cv::parallel_for_({ 0, 2 }, harness, 2);
-
-            eyeL.flop(crops[1].cols);
-            eyeL += eyes[1].tl(); // shift features to image coordinate system
-            eyeR += eyes[0].tl();
-            eyeR.roi = eyes[0];
-            eyeL.roi = eyes[1];
+        for (const auto& job : jobs)
+        {
+            if (job.eye.eyelids.size())
+            {
+                auto& face = faces[job.face];
+                if (job.mirror)
+                {
+                    face.eyeFullL = job.eye;
+                    face.eyeLeftCenter = core::centroid(job.eye.eyelids);
+                }
+                else
+                {
+                    face.eyeFullR = job.eye;
+                    face.eyeRightCenter = core::centroid(job.eye.eyelids);
+                }
+            }
         }
     }
 
-    void findLandmarks(const PaddedImage& Ib, std::vector<dsdkc::Shape>& shapes, const cv::Matx33f& Hdr_, bool isDetection)
+    void findLandmarks(const PaddedImage& Ib, std::vector<dsdkc::Shape>& shapes, const cv::Matx33f& Hdr_, bool isDetection, const std::vector<Landmarks>& priors, std::vector<float>& disagreement)
     {
         // Scope based eye segmentation timer:
 
         // clang-format off
-        drishti::core::ScopeTimeLogger scopeTimeLogger = [this](double elapsed)
+        auto scopeTimeLogger = drishti::core::makeScopeTimer<drishti::core::kTimingRegression>("regression", [this](double elapsed)
         {
             if (m_regressionTimeLogger)
             {
                 m_regressionTimeLogger(elapsed);
             }
-        };
+        });
         // clang-format on
 
         const cv::Mat gray = Ib.Ib;
@@ -231,7 +485,9 @@ public:
         const cv::Rect fullBounds({ 0, 0 }, Ib.Ib.size());
         const cv::Rect bounds = Ib.roi.area() ? Ib.roi : fullBounds;
 
-        for (int i = 0; i < shapes.size(); i++)
+        // The regressor is shared across threads: ShapeEstimator::operator() is const and
+        // RegressionTreeEnsembleShapeEstimator keeps all scratch data on the stack.
+        for (auto& shape : shapes)
         {
             // Detection rectangles may have a geometry (w.r.t. face features) that is incompatible with the
             // ROI geometry used for training the face landmark regressor.  In cases where we aim to refine
@@ -242,29 +498,243 @@ public:
             // must also be composed with the input Hdr_ homography that provides a transformation from the
             // detection image coordinate system to the landmark regression coordinate system, which is most
             // likely a scale and translation (detection typically happens at lower resolution).
-            const cv::Rect roi = isDetection ? mapDetectionToRegressor(shapes[i].roi, m_Hrd, Hdr_) : (Hdr_ * shapes[i].roi);
+            const cv::Rect roi = isDetection ? mapDetectionToRegressor(shape.roi, m_Hrd, Hdr_) : (Hdr_ * shape.roi);
 
             // Perform an addition (optional) scaling that can be tuned easily by the user as some detection
             // scales will perform better than the mean mapping used above (experimentally).
-            shapes[i].roi = scaleRoi(roi, m_scaling);
+            shape.roi = scaleRoi(roi, m_scaling);
+        }
 
-            // Crop the image such that the ROI to pixel geometry is preserved.  For most cases this is
-            // a simple shallow copy/view, but in cases where the border is clipped, then we will effectively
-            // perform border padding to achieve this goal.  This make our prediction ROI closest to the ROI
-            // used during training and ensures our cascaded pose regression has the best chance of success.
-            cv::Mat crop = geometryPreservingCrop(shapes[i].roi, gray);
+        if (m_inits > 1)
+        {
+            regressMultiInit(gray, shapes, Hdr_, priors, disagreement);
+        }
+        else
+        {
+            regressLandmarks(gray, shapes, Hdr_, priors);
+            disagreement.assign(shapes.size(), 0.f);
+        }
+    }
 
-            std::vector<bool> mask;
-            std::vector<cv::Point2f> points;
-            (*m_regressor)(crop, points, mask);
+    // Regress the landmarks of each shape from its (regressor) roi and optional prior landmarks
+    // (detection coordinates), batches are distributed over the global executor for doParallel:
+    void regressLandmarks(const cv::Mat& gray, std::vector<dsdkc::Shape>& shapes, const cv::Matx33f& Hdr_, const std::vector<Landmarks>& priors, bool doParallel = false)
+    {
+        // The ROI to pixel geometry must be preserved to match the ROI used during training, which gives
+        // our cascaded pose regression the best chance of success.  Regressors with a virtual border sample
+        // the image in place and read pixels outside the image as zero.  Otherwise we crop the image, which
+        // is a simple shallow copy/view for most cases, and in cases where the border is clipped we pad a
+        // frame arena buffer.  Crops are prepared up front, since the arena isn't thread safe.
+        const bool inPlace = m_regressor->hasVirtualBorder();
+
+        // Coarse-to-fine regressors read their early cascades from lower resolution levels, which are
+        // computed once for all faces (into recycled buffers):
+        const int levels = inPlace ? m_regressor->getPyramidLevels() : 1;
+        std::vector<cv::Mat> pyramid(1, gray);
+        auto& scratch = *m_scratch.get();
+        scratch.landmarkLevels.resize(std::max(levels - 1, 0));
+        for (auto& level : scratch.landmarkLevels)
+        {
+            cv::pyrDown(pyramid.back(), level);
+            pyramid.push_back(level);
+        }
+        std::vector<cv::Mat> crops(inPlace ? 0 : shapes.size());
+        scratch.faceArena.reset();
+        for (int i = 0; i < crops.size(); i++)
+        {
+            crops[i] = geometryPreservingCrop(shapes[i].roi, gray, scratch.faceArena);
+        }
+
+        // Map optional initial landmarks to the normalized coordinates of the regressor roi:
+        auto initialize = [&](int i, std::vector<cv::Point2f>& points) {
+            if ((i < priors.size()) && priors[i].size())
+            {
+                const cv::Rect& roi = shapes[i].roi;
+                points.clear();
+                for (const auto& p : priors[i])
+                {
+                    const cv::Point3f q = Hdr_ * cv::Point3f(p.x, p.y, 1.f);
+                    points.emplace_back(((q.x / q.z) - roi.x) / roi.width, ((q.y / q.z) - roi.y) / roi.height);
+                }
+            }
+        };
+
+        // In place estimates are in image coordinates, crop estimates are relative to the roi:
+        auto store = [&](int i, const std::vector<cv::Point2f>& points) {
+            const cv::Point2f shift = inPlace ? cv::Point2f() : cv::Point2f(shapes[i].roi.tl());
             for (const auto& p : points)
             {
-                const cv::Point q = p + cv::Point2f(shapes[i].roi.tl());
+                const cv::Point q = p + shift;
                 shapes[i].contour.emplace_back(q.x, q.y, 0);
             }
+        };
+
+        auto regress = [&](int i) {
+            std::vector<bool> mask;
+            std::vector<cv::Point2f> points;
+            initialize(i, points);
+            if (pyramid.size() > 1)
+            {
+                m_regressor->estimatePyramid(pyramid, shapes[i].roi, points, mask);
+            }
+            else if (inPlace)
+            {
+                (*m_regressor)(gray, shapes[i].roi, points, mask);
+            }
+            else
+            {
+                (*m_regressor)(crops[i], points, mask);
+            }
+            store(i, points);
+        };
+
+        if (hasFanOut(shapes.size()))
+        {
+            drishti::core::parallel_for(m_threads.get(), int(shapes.size()), regress);
+        }
+        else if (shapes.size() > 1)
+        {
+            // Run each cascade across all faces while its trees are in cache:
+            std::vector<std::vector<cv::Point2f>> points(shapes.size());
+            for (int i = 0; i < shapes.size(); i++)
+            {
+                initialize(i, points[i]);
+            }
+
+            std::vector<std::vector<bool>> masks;
+            if (inPlace)
+            {
+                std::vector<cv::Rect> rois;
+                for (const auto& shape : shapes)
+                {
+                    rois.push_back(shape.roi);
+                }
+                m_regressor->estimatePyramidBatch(pyramid, rois, points, masks, doParallel);
+            }
+            else
+            {
+                m_regressor->estimateBatch(crops, points, masks, doParallel);
+            }
+
+            for (int i = 0; i < shapes.size(); i++)
+            {
+                store(i, points[i]);
+            }
+        }
+        else
+        {
+            for (int i = 0; i < shapes.size(); i++)
+            {
+                regress(i);
+            }
         }
     }
 
+    // Each face is regressed from m_inits starting rois in one batch: the mapped roi, and copies shifted
+    // around it and scaled by m_initJitter of its width (priors follow their roi).  The landmarks are
+    // fused by their per coordinate median, which ignores an init that fell into a local minimum,
+    // and the rms distance of the estimates to the fused shape (in roi widths) is the disagreement.
+    void regressMultiInit(const cv::Mat& gray, std::vector<dsdkc::Shape>& shapes, const cv::Matx33f& Hdr_, const std::vector<Landmarks>& priors, std::vector<float>& disagreement)
+    {
+        const int inits = m_inits;
+        const cv::Matx33f Hrd_ = Hdr_.inv();
+
+        std::vector<dsdkc::Shape> expanded;
+        std::vector<Landmarks> expandedPriors(priors.empty() ? 0 : shapes.size() * inits);
+        for (int i = 0; i < shapes.size(); i++)
+        {
+            const cv::Rect& roi = shapes[i].roi;
+            for (int j = 0; j < inits; j++)
+            {
+                const cv::Matx33f Hj = getInitJitter(roi, j, inits);
+                expanded.emplace_back(Hj * roi);
+                if ((i < priors.size()) && priors[i].size())
+                {
+                    const cv::Matx33f Hdj = Hrd_ * Hj * Hdr_; // jitter in detection coordinates
+                    for (const auto& p : priors[i])
+                    {
+                        const cv::Point3f q = Hdj * cv::Point3f(p.x, p.y, 1.f);
+                        expandedPriors[i * inits + j].emplace_back(q.x / q.z, q.y / q.z);
+                    }
+                }
+            }
+        }
+
+        regressLandmarks(gray, expanded, Hdr_, expandedPriors, !m_threads);
+
+        disagreement.assign(shapes.size(), 0.f);
+        std::vector<float> xs(inits), ys(inits);
+        for (int i = 0; i < shapes.size(); i++)
+        {
+            const dsdkc::Shape* first = &expanded[i * inits];
+            const std::size_t count = first->contour.size();
+            if (std::any_of(first, first + inits, [&](const dsdkc::Shape& s) { return s.contour.size() != count; }))
+            {
+                shapes[i].contour = first->contour; // mismatched estimates: keep the one from the mapped roi
+                continue;
+            }
+
+            shapes[i].contour.resize(count);
+            for (int k = 0; k < count; k++)
+            {
+                for (int j = 0; j < inits; j++)
+                {
+                    xs[j] = first[j].contour[k].p.x;
+                    ys[j] = first[j].contour[k].p.y;
+                }
+                shapes[i].contour[k] = cv::Point2f(median(xs), median(ys));
+            }
+
+            double ssd = 0.0;
+            for (int j = 0; j < inits; j++)
+            {
+                for (int k = 0; k < count; k++)
+                {
+                    const cv::Point2f d = first[j].contour[k].p - shapes[i].contour[k].p;
+                    ssd += d.dot(d);
+                }
+            }
+
+            const float rms = count ? float(std::sqrt(ssd / double(inits * count))) : 0.f;
+            disagreement[i] = rms / float(std::max(shapes[i].roi.width, 1));
+        }
+    }
+
+    // Starting roi j of inits (j = 0 : identity), shifted on a circle around the roi and alternately
+    // scaled up/down about its center:
+    cv::Matx33f getInitJitter(const cv::Rect& roi, int j, int inits) const
+    {
+        if (j == 0)
+        {
+            return cv::Matx33f::eye();
+        }
+
+        const float theta = float(2.0 * M_PI) * float(j - 1) / float(inits - 1);
+        const float shift = m_initJitter * float(roi.width);
+        const float s = 1.f + ((j % 2) ? 0.5f : -0.5f) * m_initJitter;
+        const cv::Point2f c = cv::Point2f(roi.tl() + roi.br()) * 0.5f;
+        const cv::Point2f t = c + cv::Point2f(std::cos(theta), std::sin(theta)) * shift;
+
+        // clang-format off
+        return cv::Matx33f(s, 0, t.x - s * c.x,
+                           0, s, t.y - s * c.y,
+                           0, 0, 1);
+        // clang-format on
+    }
+
+    // Median of a small sample (reordered in place):
+    static float median(std::vector<float>& values)
+    {
+        const std::size_t n = values.size() / 2;
+        std::nth_element(values.begin(), values.begin() + n, values.end());
+        const float upper = values[n];
+        if (values.size() % 2)
+        {
+            return upper;
+        }
+        return (*std::max_element(values.begin(), values.begin() + n) + upper) * 0.5f;
+    }
+
     static cv::Rect scaleRoi(const cv::Rect& roi, float scale)
     {
         cv::Point2f tl(roi.tl()), br(roi.br()), center((tl + br) * 0.5f), diag(br - center);
@@ -272,20 +742,24 @@ public:
     }
 
     // Return requested light weight copy if roi is contained in frame bounds, else perform
-    // a deep copy that preseves the crop geometry via border padding.  This ensures that
-    // landmark regression has the best chance of success.
-    static cv::Mat geometryPreservingCrop(const cv::Rect& roi, const cv::Mat& gray)
+    // a deep copy to an arena buffer that preseves the crop geometry via border padding.
+    // The padded crop is valid until the next arena reset().
+    static cv::Mat geometryPreservingCrop(const cv::Rect& roi, const cv::Mat& gray, core::FrameArena& arena)
     {
         const cv::Rect bounds({ 0, 0 }, gray.size());
         const cv::Rect clipped = roi & bounds;
-        cv::Mat crop = gray(clipped);
-        if (clipped.size() != roi.size())
+        if (clipped == roi)
+        {
+            return gray(roi); // shallow copy
+        }
+
+        cv::Mat padded(roi.size(), gray.type(), arena.allocate(std::size_t(roi.area()) * gray.elemSize()));
+        padded.setTo(0);
+        if (clipped.area())
         {
-            cv::Mat padded(roi.size(), gray.type(), cv::Scalar::all(0));
-            crop.copyTo(padded(clipped - roi.tl()));
-            cv::swap(crop, padded);
+            gray(clipped).copyTo(padded(clipped - roi.tl()));
         }
-        return crop;
+        return padded;
     }
 
     // Notes on motion and coordinate systems:
@@ -310,13 +784,13 @@ public:
         }
     }
 
+    // The faces are reused, so steady state frames convert without allocations:
     void shapesToFaces(std::vector<dsdkc::Shape>& shapes, std::vector<FaceModel>& faces)
     {
-        faces.clear();
-        for (auto& s : shapes)
+        faces.resize(shapes.size());
+        for (int i = 0; i < shapes.size(); i++)
         {
-            FaceModel f;
-            faces.push_back(shapeToFace(s, m_landmarkFormat));
+            m_landmarkMap(shapes[i], faces[i]);
         }
     }
 
@@ -329,7 +803,8 @@ public:
             shape.contour.emplace_back(roi.x + p.x * roi.width, roi.y + p.y * roi.height, 0);
         }
 
-        DRISHTI_FACE::FaceModel face = shapeToFace(shape, m_landmarkFormat);
+        DRISHTI_FACE::FaceModel face;
+        FaceLandmarkMap(m_landmarkFormat)(shape, face);
 
         return face;
     }
@@ -382,6 +857,10 @@ public:
     {
         m_scaling = scale;
     }
+    float getScaling() const
+    {
+        return m_scaling;
+    }
     void setDoIrisRefinement(bool flag)
     {
         m_doIrisRefinement = flag;
@@ -445,16 +924,102 @@ public:
     }
     void setEyelidStagesHint(int stages)
     {
-        for (auto& regressor : m_eyeRegressor)
+        m_eyelidStagesHint = stages;
+        if (m_eyeRegressor)
         {
-            regressor->setEyelidStagesHint(stages);
+            m_eyeRegressor->setEyelidStagesHint(stages);
+        }
+        if (m_eyeRegressorPool)
+        {
+            for (auto& regressor : m_eyeRegressorPool->getMap())
+            {
+                configureEyeRegressor(*regressor.second);
+            }
         }
     }
     void setIrisStagesHint(int stages)
     {
-        for (auto& regressor : m_eyeRegressor)
+        m_irisStagesHint = stages;
+        if (m_eyeRegressor)
         {
-            regressor->setIrisStagesHint(stages);
+            m_eyeRegressor->setIrisStagesHint(stages);
+        }
+        if (m_eyeRegressorPool)
+        {
+            for (auto& regressor : m_eyeRegressorPool->getMap())
+            {
+                configureEyeRegressor(*regressor.second);
+            }
+        }
+    }
+
+    void setFaceConvergenceThreshold(float threshold)
+    {
+        if (m_regressor)
+        {
+            m_regressor->setConvergenceThreshold(threshold);
+        }
+    }
+    void setEyelidConvergenceThreshold(float threshold)
+    {
+        m_eyelidConvergenceThreshold = threshold;
+        if (m_eyeRegressor)
+        {
+            m_eyeRegressor->setEyelidConvergenceThreshold(threshold);
+        }
+        if (m_eyeRegressorPool)
+        {
+            for (auto& regressor : m_eyeRegressorPool->getMap())
+            {
+                configureEyeRegressor(*regressor.second);
+            }
+        }
+    }
+    void setIrisConvergenceThreshold(float threshold)
+    {
+        m_irisConvergenceThreshold = threshold;
+        if (m_eyeRegressor)
+        {
+            m_eyeRegressor->setIrisConvergenceThreshold(threshold);
+        }
+        if (m_eyeRegressorPool)
+        {
+            for (auto& regressor : m_eyeRegressorPool->getMap())
+            {
+                configureEyeRegressor(*regressor.second);
+            }
+        }
+    }
+    void setDoFaceTracking(bool flag)
+    {
+        m_doFaceTracking = flag;
+    }
+    void setDoEyeTracking(bool flag)
+    {
+        m_doEyeTracking = flag;
+    }
+    void setFaceRegressionInterval(int frames)
+    {
+        m_faceRegressionInterval = frames;
+        m_eyeOnlyFrames = 0;
+    }
+    void setEyeConfidenceThreshold(float threshold)
+    {
+        m_eyeConfidenceThreshold = threshold;
+    }
+    void setEyeTrackingStagesHint(int stages)
+    {
+        m_eyeTrackingStagesHint = stages;
+        if (m_eyeRegressor)
+        {
+            m_eyeRegressor->setTrackingStagesHint(stages);
+        }
+        if (m_eyeRegressorPool)
+        {
+            for (auto& regressor : m_eyeRegressorPool->getMap())
+            {
+                configureEyeRegressor(*regressor.second);
+            }
         }
     }
 
@@ -463,15 +1028,55 @@ public:
         return m_detector.get();
     }
 
+    core::MemoryUsage memoryUsage() const
+    {
+        // Per thread eye estimators are clones that share the eye models:
+        core::MemoryUsage usage;
+        if (m_detector)
+        {
+            usage.add("detector", m_detector->memoryUsage());
+        }
+        if (m_regressor)
+        {
+            usage.add("regressor", m_regressor->memoryUsage());
+        }
+        if (m_eyeRegressor)
+        {
+            usage.add("eye", m_eyeRegressor->memoryUsage());
+        }
+        std::size_t arenas = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_scratch.m_mutex);
+            for (const auto& scratch : m_scratch.getMap())
+            {
+                arenas += scratch.second->faceArena.capacity() + scratch.second->eyeArena.capacity();
+            }
+        }
+        usage.add("arena", arenas);
+        return usage;
+    }
+
 protected:
     FaceSpecification::Format m_landmarkFormat = FaceSpecification::kibug68;
+    FaceLandmarkMap m_landmarkMap; // see setLandmarkFormat()
 
     cv::Mat m_Ib;
-    bool m_doIrisRefinement = true;
-    bool m_doEyeRefinement = true;
+    std::atomic<bool> m_doIrisRefinement{ true }; // (may change during another refine())
+    std::atomic<bool> m_doEyeRefinement{ true };
     bool m_doNMSGlobal = false;
     int m_inits = 1;
+    float m_initJitter = 0.05f; // roi width fraction for the extra starting rois
     float m_scaling = 1.0;
+    int m_eyelidStagesHint = -1;
+    int m_irisStagesHint = -1;
+    float m_eyelidConvergenceThreshold = -1.f;
+    float m_irisConvergenceThreshold = -1.f;
+    bool m_doFaceTracking = false;
+    bool m_doEyeTracking = false;
+    int m_eyeTrackingStagesHint = -1;
+    int m_faceRegressionInterval = 1; // full face regression every N tracked frames
+    std::atomic<int> m_eyeOnlyFrames{ 0 }; // tracked frames since the last full regression
+    float m_eyeConfidenceThreshold = 0.5f;
 
     FaceModel m_faceDetectorMean;
     cv::Matx33f m_Hrd = cv::Matx33f::eye();
@@ -481,9 +1086,18 @@ protected:
     TimeLoggerType m_eyeRegressionTimeLogger;
     std::unique_ptr<drishti::ml::ObjectDetector> m_detector;
     std::unique_ptr<drishti::ml::ShapeEstimator> m_regressor;
-    std::vector<std::unique_ptr<DRISHTI_EYE::EyeModelEstimator>> m_eyeRegressor;
+    EyeEstimatorPtr m_eyeRegressor;
+
+    // Optional per face fan out:
+    ThreadPoolPtr m_threads;
+    EyeEstimatorAllocator m_eyeAllocator;
+    std::unique_ptr<EyeEstimatorPool> m_eyeRegressorPool;
+    std::mutex m_eyeRegressorMutex; // owner of the default eye regressor in segmentEyes()
 
     EyeCropper m_eyeCropper;
+
+    // refine() is reentrant (detection is not), so each calling thread has its own scratch:
+    mutable ScratchPool m_scratch{ []() { return drishti::core::make_unique<Scratch>(); } };
 };
 
 // ((((((((((((( API )))))))))))))
@@ -535,6 +1149,11 @@ drishti::ml::ObjectDetector* FaceDetector::getDetector()
     return m_impl->getDetector();
 }
 
+core::MemoryUsage FaceDetector::memoryUsage() const
+{
+    return m_impl->memoryUsage();
+}
+
 void FaceDetector::setLandmarkFormat(FaceSpecification::Format format)
 {
     m_impl->setLandmarkFormat(format);
@@ -609,6 +1228,14 @@ void FaceDetector::setScaling(float scale)
 {
     m_impl->setScaling(scale);
 }
+float FaceDetector::getScaling() const
+{
+    return m_impl->getScaling();
+}
+void FaceDetector::setThreads(const ThreadPoolPtr& threads, const EyeEstimatorAllocator& allocator)
+{
+    m_impl->setThreads(threads, allocator);
+}
 
 FaceModel FaceDetector::getMeanShape(const cv::Size2f& size) const
 {
@@ -634,6 +1261,44 @@ void FaceDetector::setEyelidStagesHint(int stages)
     m_impl->setEyelidStagesHint(stages);
 }
 
+void FaceDetector::setFaceConvergenceThreshold(float threshold)
+{
+    m_impl->setFaceConvergenceThreshold(threshold);
+}
+
+void FaceDetector::setEyelidConvergenceThreshold(float threshold)
+{
+    m_impl->setEyelidConvergenceThreshold(threshold);
+}
+
+void FaceDetector::setIrisConvergenceThreshold(float threshold)
+{
+    m_impl->setIrisConvergenceThreshold(threshold);
+}
+
+void FaceDetector::setDoFaceTracking(bool flag)
+{
+    m_impl->setDoFaceTracking(flag);
+}
+
+void FaceDetector::setDoEyeTracking(bool flag)
+{
+    m_impl->setDoEyeTracking(flag);
+}
+void FaceDetector::setFaceRegressionInterval(int frames)
+{
+    m_impl->setFaceRegressionInterval(frames);
+}
+void FaceDetector::setEyeConfidenceThreshold(float threshold)
+{
+    m_impl->setEyeConfidenceThreshold(threshold);
+}
+
+void FaceDetector::setEyeTrackingStagesHint(int stages)
+{
+    m_impl->setEyeTrackingStagesHint(stages);
+}
+
 // utility
 
 // Map from normalized coordinate system to input ROI
@@ -645,21 +1310,4 @@ static cv::Matx33f denormalize(const cv::Rect& roi)
     return (C2 * S * C1);
 }
 
-static void chooseBest(std::vector<cv::Rect>& objects, std::vector<double>& scores)
-{
-    if (objects.size() > 1)
-    {
-        int best = 0;
-        for (int i = 1; i < objects.size(); i++)
-        {
-            if (scores[i] > scores[best])
-            {
-                best = i;
-            }
-        }
-        objects = { objects[best] };
-        scores = { scores[best] };
-    }
-}
-
 DRISHTI_FACE_NAMESPACE_END
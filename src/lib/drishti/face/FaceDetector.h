@@ -19,6 +19,9 @@
 
 #include "acf/MatP.h"
 
+#include "drishti/core/Executor.h"
+#include "drishti/core/MemoryUsage.h"
+
 #include <opencv2/core/core.hpp>
 #include <opencv2/objdetect/objdetect.hpp>
 #include <opencv2/imgproc/imgproc_c.h>
@@ -69,6 +72,8 @@ public:
     typedef std::function<std::array<cv::Mat, 2>(const cv::Point2f& L, const cv::Point2f& R)> EyeCropper;
     typedef std::function<int(const cv::Mat&, const std::string& tag)> MatLoggerType;
     typedef std::function<void(double seconds)> TimeLoggerType;
+    typedef std::function<std::unique_ptr<drishti::eye::EyeModelEstimator>()> EyeEstimatorAllocator;
+    typedef std::shared_ptr<drishti::core::Executor> ThreadPoolPtr;
 
     class Impl;
     typedef std::vector<cv::Point2f> Landmarks;
@@ -89,12 +94,16 @@ public:
     // TODO: Add this for detector modification (cascThr, etc), but eventually make limited public API
     drishti::ml::ObjectDetector* getDetector();
 
+    // Heap footprint of the detector, face and eye models (by component):
+    core::MemoryUsage memoryUsage() const;
+
     virtual std::vector<cv::Point2f> getFeatures() const;
 
     FaceModel getMeanShape(const cv::Size2f& size) const;
     FaceModel getMeanShape(const cv::Rect2f& roi) const;
 
     void setScaling(float scale);
+    float getScaling() const;
     cv::Size getWindowSize() const;
 
     void setFaceStagesHint(int stages);
@@ -102,6 +111,24 @@ public:
     void setEyelidStagesHint(int stages);
     void setIrisStagesHint(int stages);
 
+    // Stop cascaded regression once the shape update of a stage falls below the threshold (0 : disabled):
+    void setFaceConvergenceThreshold(float threshold);
+    void setEyelidConvergenceThreshold(float threshold);
+    void setIrisConvergenceThreshold(float threshold);
+
+    // Start face landmark regression for tracked (non detection) faces from their previous landmarks:
+    void setDoFaceTracking(bool flag);
+
+    // Seed the eye models of tracked faces from their previous eyes with a reduced cascade (-1 : model default):
+    void setDoEyeTracking(bool flag);
+    void setEyeTrackingStagesHint(int stages);
+
+    // Eye only fast path for tracked faces: the face landmarks are regressed every <frames> calls
+    // (1 : always) and the eyes of the track define the eye regions in between.  A face whose eye
+    // confidence falls below the threshold (drift from the track, in [0,1]) is fully refined:
+    void setFaceRegressionInterval(int frames);
+    void setEyeConfidenceThreshold(float threshold);
+
     void setDoIrisRefinement(bool flag);
     void setDoEyeRefinement(bool flag);
     void setInits(int inits);
@@ -113,9 +140,16 @@ public:
     void setLogger(MatLoggerType logger);
     void setHrd(const cv::Matx33f& Hrd); // regression face => detection face
     void setEyeCropper(EyeCropper& cropper);
+
+    // Distribute per face landmark regression and eye segmentation across a thread pool.
+    // The allocator is used to create an eye estimator pair per worker thread.
+    void setThreads(const ThreadPoolPtr& threads, const EyeEstimatorAllocator& allocator);
     void paint(cv::Mat& frame);
 
     virtual void detect(const MatP& I, std::vector<FaceModel>& faces);
+
+    // refine() may be called concurrently (e.g., for different frames), detect() and the setters
+    // (other than setDoEyeRefinement() and setDoIrisRefinement()) must not overlap a refine():
     virtual void refine(const PaddedImage& Ib, std::vector<FaceModel>& faces, const cv::Matx33f& H, bool isDetection);
 
 protected:
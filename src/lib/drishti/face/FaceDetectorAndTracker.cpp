@@ -11,6 +11,9 @@
 #include "drishti/face/FaceDetectorAndTracker.h"
 #include "drishti/face/FaceDetectorAndTrackerImpl.h"
 #include "drishti/face/FaceDetectorAndTrackerNN.h"
+#include "drishti/core/Shape.h"
+
+#include <algorithm>
 
 DRISHTI_FACE_NAMESPACE_BEGIN
 
@@ -39,35 +42,101 @@ double FaceDetectorAndTracker::getMaxTrackAge() const
     return m_pImpl->getMaxTrackAge();
 }
 
-void FaceDetectorAndTracker::operator()(const MatP& I, const PaddedImage& Ib, std::vector<FaceModel>& faces, const cv::Matx33f& H)
+void FaceDetectorAndTracker::adoptTracks(FaceDetectorAndTracker& other)
+{
+    m_pImpl = other.m_pImpl;
+}
+
+void FaceDetectorAndTracker::setTrackConfidenceThreshold(float threshold)
+{
+    m_trackConfidenceThreshold = threshold;
+}
+float FaceDetectorAndTracker::getTrackConfidenceThreshold() const
+{
+    return m_trackConfidenceThreshold;
+}
+
+static bool normalize(const FaceModel& face, std::vector<cv::Point2f>& points, float& spread)
 {
-    if (!m_pImpl->hasTracks() || (m_pImpl->trackAge() > m_pImpl->getMaxTrackAge()))
+    if (!face.points.has || face.points->empty())
     {
-        FaceDetector::operator()(I, Ib, faces, H); // do detection + regression
-        if (faces.size())
-        {
-            m_pImpl->initialize(Ib.Ib, faces[0]); // initialize tracks
-        }
+        return false;
+    }
+
+    const cv::Point2f center = core::centroid(*face.points);
+    points.resize(face.points->size());
+    spread = 0.f;
+    for (int i = 0; i < points.size(); i++)
+    {
+        points[i] = (*face.points)[i] - center;
+        spread += cv::norm(points[i]);
     }
-    else
+    spread /= float(points.size());
+    return (spread > 0.f);
+}
+
+float FaceDetectorAndTracker::getTrackConfidence(const FaceModel& previous, const FaceModel& current)
+{
+    std::vector<cv::Point2f> a, b;
+    float spreadA = 0.f, spreadB = 0.f;
+    if (!normalize(previous, a, spreadA) || !normalize(current, b, spreadB) || (a.size() != b.size()))
+    {
+        return 0.f;
+    }
+
+    // A regression that has lost the face collapses or inflates the shape:
+    const float ratio = spreadB / spreadA;
+    if ((ratio < 0.75f) || (ratio > (1.f / 0.75f)))
+    {
+        return 0.f;
+    }
+
+    // Mean landmark residual in units of the landmark spread (0.15 is a lost shape):
+    float residual = 0.f;
+    for (int i = 0; i < a.size(); i++)
+    {
+        residual += cv::norm((a[i] * (1.f / spreadA)) - (b[i] * (1.f / spreadB)));
+    }
+    residual /= float(a.size());
+    return std::max(1.f - (residual / 0.15f), 0.f);
+}
+
+/*
+ * Tracking by regression: once a face is found the regression roi is derived from the
+ * landmarks of the previous frame (see TrackerNN::update()) and detection is skipped.  The
+ * detector only runs when the track is lost (low landmark confidence) or has reached the
+ * maximum track age.
+ */
+
+void FaceDetectorAndTracker::operator()(const MatP& I, const PaddedImage& Ib, std::vector<FaceModel>& faces, const cv::Matx33f& H)
+{
+    if (m_pImpl->hasTracks() && (m_pImpl->trackAge() <= m_pImpl->getMaxTrackAge()))
     {
-        bool okay = false;
         FaceModel face;
-        bool trackOkay = m_pImpl->update(Ib.Ib, face); // here we have the left+right eyes
-        if (trackOkay && face.roi->area())
-        {
-            okay = true;
-        }
-        else
+        if (m_pImpl->update(Ib.Ib, face) && face.roi->area())
         {
-            m_pImpl->reset();
-        }
+            // The track follows the (scaled) output roi, see FaceDetector::setScaling():
+            const float scale = 1.f / getScaling();
+            const cv::Point2f tl(face.roi->tl()), br(face.roi->br()), center((tl + br) * 0.5f), diag(br - center);
+            face.roi = cv::Rect(center - (diag * scale), center + (diag * scale));
 
-        if (okay)
-        {
             faces = { face };
             refine(Ib, faces, cv::Matx33f::eye(), false);
+            if (faces.size() && (getTrackConfidence(face, faces.front()) >= m_trackConfidenceThreshold))
+            {
+                m_pImpl->correct(faces.front());
+                return; // regression only
+            }
         }
+
+        m_pImpl->reset(); // track lost, detect in this frame
+    }
+
+    faces.clear();
+    FaceDetector::operator()(I, Ib, faces, H); // do detection + regression
+    if (faces.size())
+    {
+        m_pImpl->initialize(Ib.Ib, faces[0]); // initialize tracks
     }
 }
 
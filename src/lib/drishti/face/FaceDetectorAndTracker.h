@@ -23,11 +23,25 @@ public:
     virtual void operator()(const MatP& I, const PaddedImage& Ib, std::vector<FaceModel>& faces, const cv::Matx33f& H);
     virtual std::vector<cv::Point2f> getFeatures() const;
 
+    // Period (seconds) of the detection that runs while a face is tracked by regression:
     void setMaxTrackAge(double age);
     double getMaxTrackAge() const;
 
+    // Minimum landmark consistency (0 to 1) between consecutive frames to keep a track:
+    void setTrackConfidenceThreshold(float threshold);
+    float getTrackConfidenceThreshold() const;
+
+    // Consistency of the landmarks of the same face in two frames, after normalizing for
+    // translation and scale (1 for identical shapes, 0 for no landmarks or a large change):
+    static float getTrackConfidence(const FaceModel& previous, const FaceModel& current);
+
+    // Continue the tracks of another instance (e.g., after loading new models), the track
+    // state doesn't depend on the models:
+    void adoptTracks(FaceDetectorAndTracker& other);
+
 protected:
     std::shared_ptr<TrackImpl> m_pImpl; // make_unique fails
+    float m_trackConfidenceThreshold = 0.5f;
 };
 
 DRISHTI_FACE_NAMESPACE_END
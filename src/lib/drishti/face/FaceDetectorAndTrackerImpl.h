@@ -69,6 +69,12 @@ public:
         m_maxTrackAge = age;
     }
 
+    // Update the tracked face with the regression result (the track age is retained):
+    virtual void correct(const FaceModel& face)
+    {
+        m_face = face;
+    }
+
     void setFace(const FaceModel& face)
     {
         m_isInitialized = true;
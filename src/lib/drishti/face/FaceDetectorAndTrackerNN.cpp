@@ -9,6 +9,7 @@
 */
 
 #include "drishti/face/FaceDetectorAndTrackerNN.h"
+#include "drishti/core/Shape.h"
 
 DRISHTI_FACE_NAMESPACE_BEGIN
 
@@ -28,15 +29,55 @@ std::vector<cv::Point2f> TrackerNN::getFeatures() const
     return features;
 }
 
+static bool getSpread(const FaceModel& face, cv::Point2f& center, float& spread)
+{
+    if (!face.points.has || face.points->empty())
+    {
+        return false;
+    }
+
+    center = core::centroid(*face.points);
+    spread = 0.f;
+    for (const auto& p : *face.points)
+    {
+        spread += cv::norm(p - center);
+    }
+    spread /= float(face.points->size());
+    return (spread > 0.f);
+}
+
 void TrackerNN::initialize(const cv::Mat1b& image, const FaceModel& face)
 {
-    m_face = face;
+    cv::Point2f center;
+    float spread = 0.f;
+    if (!face.roi.has || !getSpread(face, center, spread))
+    {
+        reset();
+        return;
+    }
+
+    TrackImpl::initialize(image, face);
+
+    const cv::Rect& roi = *face.roi;
+    m_roiOffset = (cv::Point2f(roi.x + roi.width * 0.5f, roi.y + roi.height * 0.5f) - center) * (1.f / spread);
+    m_roiSize = { roi.width / spread, roi.height / spread };
 }
 
+// The regression roi follows the landmarks of the previous frame:
 bool TrackerNN::update(const cv::Mat1b& image, FaceModel& face)
 {
+    cv::Point2f center;
+    float spread = 0.f;
+    if (!getSpread(m_face, center, spread))
+    {
+        return false;
+    }
+
     face = m_face;
-    return true;
+    const cv::Point2f roiCenter = center + m_roiOffset * spread;
+    const cv::Size2f roiSize(m_roiSize.width * spread, m_roiSize.height * spread);
+    face.roi = cv::Rect(cv::Point2f(roiCenter.x - roiSize.width * 0.5f, roiCenter.y - roiSize.height * 0.5f), roiSize);
+    return (face.roi->area() > 0) && (cv::Rect({ 0, 0 }, image.size()) & *face.roi).area();
 }
 
 DRISHTI_FACE_NAMESPACE_END
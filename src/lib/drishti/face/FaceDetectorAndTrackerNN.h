@@ -26,7 +26,10 @@ public:
 
 protected:
     virtual void initializeWithRegions(const cv::Mat1b& image, const std::vector<cv::Rect>& regions) {}
-    DRISHTI_FACE::FaceModel m_face;
+
+    // Regression roi relative to the landmark centroid, in units of the landmark spread:
+    cv::Point2f m_roiOffset;
+    cv::Size2f m_roiSize;
 };
 
 DRISHTI_FACE_NAMESPACE_END
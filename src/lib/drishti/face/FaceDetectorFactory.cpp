@@ -6,18 +6,44 @@
 #include "drishti/eye/EyeModelEstimator.h"
 #include "drishti/core/drishti_core.h"
 #include "drishti/core/make_unique.h"
+#include "drishti/core/ModelCache.h"
 
 #include <acf/ACF.h> // ACF detection
 
 #include "drishti/core/infix_iterator.h"
 #include <iterator>
 #include <fstream>
+#include <sstream>
 
 DRISHTI_FACE_NAMESPACE_BEGIN
 
 drishti::face::FaceModel loadFaceModel(std::istream& is);
 drishti::face::FaceModel loadFaceModel(const std::string& filename);
 
+/*
+ * Deserialized regressors are shared (read only) by all factories through core::ModelCache<>
+ * and each detector receives a lightweight clone with its own settings.  The ACF detector is
+ * still loaded per instance, since it is tuned (thresholds, pyramid) by each owner.
+ */
+
+using ShapeEstimatorCache = core::ModelCache<ml::ShapeEstimator>;
+using EyeEstimatorCache = core::ModelCache<eye::EyeModelEstimator>;
+using FaceModelCache = core::ModelCache<face::FaceModel>;
+
+// Stream models are keyed on their content:
+static std::string readStream(std::istream& is, std::string& key)
+{
+    std::string content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    key = std::to_string(std::hash<std::string>()(content)) + ":" + std::to_string(content.size());
+    return content;
+}
+
+static std::unique_ptr<ml::ShapeEstimator> cloneFaceEstimator(const ShapeEstimatorCache::Pointer& cached, const std::function<std::unique_ptr<ml::ShapeEstimator>()>& loader)
+{
+    auto estimator = cached ? cached->clone() : nullptr;
+    return estimator ? std::move(estimator) : loader();
+}
+
 /*
  * FaceDetectorFactor (string)
  */
@@ -29,12 +55,20 @@ std::unique_ptr<ml::ObjectDetector> FaceDetectorFactory::getFaceDetector()
 
 std::unique_ptr<ml::ShapeEstimator> FaceDetectorFactory::getFaceEstimator()
 {
-    return core::make_unique<ml::RegressionTreeEnsembleShapeEstimator>(sFaceRegressor);
+    const std::string filename = sFaceRegressor;
+    auto loader = [filename]() -> std::unique_ptr<ml::ShapeEstimator> {
+        return core::make_unique<ml::RegressionTreeEnsembleShapeEstimator>(filename);
+    };
+    return cloneFaceEstimator(ShapeEstimatorCache::get(filename, loader), loader);
 }
 
 std::unique_ptr<eye::EyeModelEstimator> FaceDetectorFactory::getEyeEstimator()
 {
-    return core::make_unique<eye::EyeModelEstimator>(sEyeRegressor);
+    const std::string filename = sEyeRegressor;
+    auto cached = EyeEstimatorCache::get(filename, [filename]() {
+        return core::make_unique<eye::EyeModelEstimator>(filename);
+    });
+    return cached->clone();
 }
 
 face::FaceModel FaceDetectorFactory::getMeanFace()
@@ -42,7 +76,10 @@ face::FaceModel FaceDetectorFactory::getMeanFace()
     face::FaceModel faceDetectorMean;
     if (!sFaceDetectorMean.empty())
     {
-        faceDetectorMean = loadFaceModel(sFaceDetectorMean);
+        const std::string filename = sFaceDetectorMean;
+        faceDetectorMean = *FaceModelCache::get(filename, [filename]() {
+            return core::make_unique<face::FaceModel>(loadFaceModel(filename));
+        });
     }
     return faceDetectorMean;
 }
@@ -58,14 +95,27 @@ std::unique_ptr<ml::ObjectDetector> FaceDetectorFactoryStream::getFaceDetector()
 
 std::unique_ptr<ml::ShapeEstimator> FaceDetectorFactoryStream::getFaceEstimator()
 {
-    return core::make_unique<ml::RegressionTreeEnsembleShapeEstimator>(*iFaceRegressor);
+    std::string key;
+    auto content = std::make_shared<std::string>(readStream(*iFaceRegressor, key));
+    auto loader = [content]() -> std::unique_ptr<ml::ShapeEstimator> {
+        std::istringstream is(*content);
+        return core::make_unique<ml::RegressionTreeEnsembleShapeEstimator>(is);
+    };
+    return cloneFaceEstimator(ShapeEstimatorCache::get(key, loader), loader);
 }
 
 std::unique_ptr<eye::EyeModelEstimator> FaceDetectorFactoryStream::getEyeEstimator()
 {
     iEyeRegressor->clear();
     iEyeRegressor->seekg(0, std::ios::beg);
-    return core::make_unique<eye::EyeModelEstimator>(*iEyeRegressor, sEyeRegressor);
+
+    std::string key;
+    const std::string content = readStream(*iEyeRegressor, key), hint = sEyeRegressor;
+    auto cached = EyeEstimatorCache::get(key + ":" + hint, [&content, &hint]() {
+        std::istringstream is(content);
+        return core::make_unique<eye::EyeModelEstimator>(is, hint);
+    });
+    return cached->clone();
 }
 
 face::FaceModel FaceDetectorFactoryStream::getMeanFace()
@@ -73,11 +123,150 @@ face::FaceModel FaceDetectorFactoryStream::getMeanFace()
     face::FaceModel faceDetectorMean;
     if (iFaceDetectorMean && *iFaceDetectorMean)
     {
-        faceDetectorMean = loadFaceModel(*iFaceDetectorMean);
+        std::string key;
+        const std::string content = readStream(*iFaceDetectorMean, key);
+        faceDetectorMean = *FaceModelCache::get(key, [&content]() {
+            std::istringstream is(content);
+            return core::make_unique<face::FaceModel>(loadFaceModel(is));
+        });
     }
     return faceDetectorMean;
 }
 
+/*
+ * FaceDetectorFactoryAsync (std::future)
+ */
+
+template <typename Callable>
+static auto launch(const FaceDetectorFactoryAsync::ThreadPoolPtr& threads, Callable&& func) -> std::future<decltype(func())>
+{
+    return threads ? threads->process(std::forward<Callable>(func)) : std::async(std::launch::async, std::forward<Callable>(func));
+}
+
+FaceDetectorFactoryAsync::FaceDetectorFactoryAsync(const FaceDetectorFactoryPtr& factory, const ThreadPoolPtr& threads)
+    : FaceDetectorFactory(*factory)
+    , factory(factory)
+    , threads(threads)
+{
+    // Stream factories are safe to query concurrently, since each model has its own stream:
+    FaceDetectorFactory* source = factory.get();
+    fFaceDetector = launch(threads, [source]() { return source->getFaceDetector(); });
+    fFaceRegressor = launch(threads, [source]() { return source->getFaceEstimator(); });
+    fEyeRegressor = launch(threads, [source]() { return source->getEyeEstimator(); });
+    fFaceDetectorMean = launch(threads, [source]() { return source->getMeanFace(); });
+}
+
+FaceDetectorFactoryAsync::~FaceDetectorFactoryAsync()
+{
+    // The tasks reference the source factory, so pending loads must complete first:
+    wait();
+}
+
+template <typename T>
+T FaceDetectorFactoryAsync::get(std::future<T>& future, const std::function<T()>& fallback)
+{
+    return future.valid() ? future.get() : fallback();
+}
+
+void FaceDetectorFactoryAsync::wait()
+{
+    // clang-format off
+    if (fFaceDetector.valid()) { fFaceDetector.wait(); }
+    if (fFaceRegressor.valid()) { fFaceRegressor.wait(); }
+    if (fEyeRegressor.valid()) { fEyeRegressor.wait(); }
+    if (fFaceDetectorMean.valid()) { fFaceDetectorMean.wait(); }
+    // clang-format on
+}
+
+std::unique_ptr<ml::ObjectDetector> FaceDetectorFactoryAsync::getFaceDetector()
+{
+    return get<std::unique_ptr<ml::ObjectDetector>>(fFaceDetector, [this]() { return factory->getFaceDetector(); });
+}
+
+std::unique_ptr<ml::ShapeEstimator> FaceDetectorFactoryAsync::getFaceEstimator()
+{
+    return get<std::unique_ptr<ml::ShapeEstimator>>(fFaceRegressor, [this]() { return factory->getFaceEstimator(); });
+}
+
+std::unique_ptr<eye::EyeModelEstimator> FaceDetectorFactoryAsync::getEyeEstimator()
+{
+    return get<std::unique_ptr<eye::EyeModelEstimator>>(fEyeRegressor, [this]() { return factory->getEyeEstimator(); });
+}
+
+face::FaceModel FaceDetectorFactoryAsync::getMeanFace()
+{
+    return get<face::FaceModel>(fFaceDetectorMean, [this]() { return factory->getMeanFace(); });
+}
+
+/*
+ * FaceDetectorFactoryShared (in memory)
+ */
+
+std::string FaceDetectorFactoryShared::read(std::istream* is)
+{
+    std::string content;
+    if (is)
+    {
+        is->clear();
+        is->seekg(0, std::ios::beg);
+        is->clear(); // not seekable
+        content.assign((std::istreambuf_iterator<char>(*is)), std::istreambuf_iterator<char>());
+    }
+    return content;
+}
+
+FaceDetectorFactoryShared::FaceDetectorFactoryShared(
+    const std::string& faceDetector,
+    const std::string& faceRegressor,
+    const std::string& eyeRegressor,
+    const std::string& faceDetectorMean,
+    const ThreadPoolPtr& threads)
+    : m_faceDetector(faceDetector)
+    , m_faceRegressor(faceRegressor)
+{
+    std::istringstream iFaceRegressor(faceRegressor), iEyeRegressor(eyeRegressor), iFaceDetectorMean(faceDetectorMean);
+    FaceDetectorFactoryStream stream(nullptr, &iFaceRegressor, &iEyeRegressor, faceDetectorMean.empty() ? nullptr : &iFaceDetectorMean);
+
+    // Each model has its own stream, and the ACF detector is deserialized by getFaceDetector():
+    FaceDetectorFactoryStream* source = &stream;
+    auto fFaceRegressor = launch(threads, [source]() { return source->getFaceEstimator(); });
+    auto fEyeRegressor = launch(threads, [source]() { return source->getEyeEstimator(); });
+    auto fFaceDetectorMean = launch(threads, [source]() { return source->getMeanFace(); });
+
+    // The tasks reference the local streams, so all of them must complete before get() can throw:
+    fFaceRegressor.wait();
+    fEyeRegressor.wait();
+    fFaceDetectorMean.wait();
+
+    m_faceEstimator = fFaceRegressor.get();
+    m_eyeEstimator = fEyeRegressor.get();
+    m_faceDetectorMean = fFaceDetectorMean.get();
+}
+
+std::unique_ptr<ml::ObjectDetector> FaceDetectorFactoryShared::getFaceDetector()
+{
+    std::istringstream is(m_faceDetector);
+    return core::make_unique<ml::ObjectDetectorACF>(is);
+}
+
+std::unique_ptr<ml::ShapeEstimator> FaceDetectorFactoryShared::getFaceEstimator()
+{
+    return cloneFaceEstimator(m_faceEstimator, [this]() -> std::unique_ptr<ml::ShapeEstimator> {
+        std::istringstream is(m_faceRegressor);
+        return core::make_unique<ml::RegressionTreeEnsembleShapeEstimator>(is);
+    });
+}
+
+std::unique_ptr<eye::EyeModelEstimator> FaceDetectorFactoryShared::getEyeEstimator()
+{
+    return m_eyeEstimator->clone();
+}
+
+face::FaceModel FaceDetectorFactoryShared::getMeanFace()
+{
+    return m_faceDetectorMean;
+}
+
 /*
  * Utility
  */
@@ -14,6 +14,9 @@
 #include "drishti/face/drishti_face.h"
 #include "drishti/face/Face.h"
 
+#include "drishti/core/Executor.h"
+
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
@@ -89,6 +92,79 @@ public:
     std::istream* iFaceDetectorMean = nullptr;
 };
 
+/*
+ * Deserializes all models of a source factory concurrently (on the thread pool when provided)
+ * as soon as it is constructed.  The first request for each model waits on its future, later
+ * requests (i.e., per thread eye estimators) are forwarded to the source factory.
+ */
+
+class FaceDetectorFactoryAsync : public FaceDetectorFactory
+{
+public:
+    using FaceDetectorFactoryPtr = std::shared_ptr<FaceDetectorFactory>;
+    using ThreadPoolPtr = std::shared_ptr<drishti::core::Executor>;
+
+    FaceDetectorFactoryAsync(const FaceDetectorFactoryPtr& factory, const ThreadPoolPtr& threads = nullptr);
+    ~FaceDetectorFactoryAsync();
+
+    virtual std::unique_ptr<drishti::ml::ObjectDetector> getFaceDetector();
+    virtual std::unique_ptr<drishti::ml::ShapeEstimator> getFaceEstimator();
+    virtual std::unique_ptr<drishti::eye::EyeModelEstimator> getEyeEstimator();
+    virtual drishti::face::FaceModel getMeanFace();
+
+    // Block until all pending loads have completed (errors are reported by the getters):
+    void wait();
+
+protected:
+    template <typename T>
+    static T get(std::future<T>& future, const std::function<T()>& fallback);
+
+    FaceDetectorFactoryPtr factory;
+    ThreadPoolPtr threads;
+
+    std::future<std::unique_ptr<drishti::ml::ObjectDetector>> fFaceDetector;
+    std::future<std::unique_ptr<drishti::ml::ShapeEstimator>> fFaceRegressor;
+    std::future<std::unique_ptr<drishti::eye::EyeModelEstimator>> fEyeRegressor;
+    std::future<drishti::face::FaceModel> fFaceDetectorMean;
+};
+
+/*
+ * Immutable model set shared by several owners (i.e., one FaceFinder per camera).  The serialized
+ * models are held in memory, the regressors and the mean face are deserialized once (concurrently
+ * on the thread pool when provided) and each request returns a clone.  The ACF detector is
+ * deserialized per request from the in memory copy, since each owner tunes it.  Safe to query
+ * from multiple threads.
+ */
+
+class FaceDetectorFactoryShared : public FaceDetectorFactory
+{
+public:
+    using ThreadPoolPtr = std::shared_ptr<drishti::core::Executor>;
+
+    FaceDetectorFactoryShared(
+        const std::string& faceDetector,
+        const std::string& faceRegressor,
+        const std::string& eyeRegressor,
+        const std::string& faceDetectorMean,
+        const ThreadPoolPtr& threads = nullptr);
+
+    virtual std::unique_ptr<drishti::ml::ObjectDetector> getFaceDetector();
+    virtual std::unique_ptr<drishti::ml::ShapeEstimator> getFaceEstimator();
+    virtual std::unique_ptr<drishti::eye::EyeModelEstimator> getEyeEstimator();
+    virtual drishti::face::FaceModel getMeanFace();
+
+    // Read an entire stream (from the beginning when it is seekable):
+    static std::string read(std::istream* is);
+
+protected:
+    std::string m_faceDetector;
+    std::string m_faceRegressor;
+
+    std::shared_ptr<const drishti::ml::ShapeEstimator> m_faceEstimator;
+    std::shared_ptr<const drishti::eye::EyeModelEstimator> m_eyeEstimator;
+    drishti::face::FaceModel m_faceDetectorMean;
+};
+
 std::ostream& operator<<(std::ostream& os, const FaceDetectorFactory& factory);
 
 DRISHTI_FACE_NAMESPACE_END
@@ -13,6 +13,7 @@
 #include "drishti/core/Shape.h"
 #include "drishti/geometry/Primitives.h"
 
+#include <algorithm>
 #include <numeric>
 
 #include <opencv2/highgui.hpp>
@@ -36,16 +37,25 @@ static cv::Point2f maxPointX(std::vector<cv::Point2f>& points)
 
 static void fill(FaceModel& face)
 {
-    // Estimate centers for normalization:
-    face.eyeRightCenter = drishti::core::centroid(face.eyeRight);
-    face.eyeLeftCenter = drishti::core::centroid(face.eyeLeft);
-    face.noseTip = drishti::core::centroid(face.nose);
+    // Estimate centers for normalization (features may be empty for landmark subsets):
+    if (face.eyeRight.size())
+    {
+        face.eyeRightCenter = drishti::core::centroid(face.eyeRight);
+        face.eyeRightInner = maxPointX(face.eyeRight);
+        face.eyeRightOuter = minPointX(face.eyeRight);
+        face.eyeLeftOuter = maxPointX(face.eyeRight);
+    }
 
-    face.eyeRightInner = maxPointX(face.eyeRight);
-    face.eyeLeftInner = minPointX(face.eyeLeft);
+    if (face.eyeLeft.size())
+    {
+        face.eyeLeftCenter = drishti::core::centroid(face.eyeLeft);
+        face.eyeLeftInner = minPointX(face.eyeLeft);
+    }
 
-    face.eyeRightOuter = minPointX(face.eyeRight);
-    face.eyeLeftOuter = maxPointX(face.eyeRight);
+    if (face.nose.size())
+    {
+        face.noseTip = drishti::core::centroid(face.nose);
+    }
 
     if (face.mouthOuter.size())
     {
@@ -118,62 +128,110 @@ FaceSpecification FaceSpecification::create(Format format)
     return spec;
 }
 
-FaceModel shapeToFace(drishti::core::Shape& shape, const FaceSpecification& spec, bool relative = true)
+FaceSpecification FaceSpecification::select(const IntVec& landmarks) const
 {
-    auto points = shape.getPoints();
+    auto select = [&](const IntVec& indices) {
+        IntVec result;
+        for (auto i : indices)
+        {
+            const auto iter = std::find(landmarks.begin(), landmarks.end(), i);
+            if (iter != landmarks.end())
+            {
+                result.push_back(int(std::distance(landmarks.begin(), iter)));
+            }
+        }
+        return result;
+    };
 
-    FaceModel face;
-    face.roi = shape.roi;
-    face.points = points;
-
-    std::vector<std::pair<const std::vector<int>*, std::vector<cv::Point2f>*>> objects{
-        { &spec.eyeR, &face.eyeRight },
-        { &spec.eyeL, &face.eyeLeft },
-        { &spec.nose, &face.nose },
-        { &spec.browR, &face.eyebrowRight },
-        { &spec.browL, &face.eyebrowLeft },
-        { &spec.mouthOuter, &face.mouthOuter },
-        { &spec.mouthInner, &face.mouthInner },
-        { &spec.noseFull, &face.noseFull }
+    FaceSpecification spec;
+    spec.format = format;
+    for (const auto& member : { &FaceSpecification::eyeL, &FaceSpecification::eyeR, &FaceSpecification::nose, &FaceSpecification::brow, &FaceSpecification::mouthOuter, &FaceSpecification::mouthInner, &FaceSpecification::browL, &FaceSpecification::browR, &FaceSpecification::sideL, &FaceSpecification::sideR, &FaceSpecification::noseFull })
+    {
+        spec.*member = select(this->*member);
+    }
+    return spec;
+}
+
+// ((((((((((((((( FaceLandmarkMap )))))))))))))))
+
+FaceLandmarkMap::FaceLandmarkMap(FaceSpecification::Format format, const std::vector<int>& landmarks)
+    : FaceLandmarkMap(landmarks.empty() ? FaceSpecification::create(format) : FaceSpecification::create(format).select(landmarks))
+{
+    this->landmarks = landmarks;
+}
+
+FaceLandmarkMap::FaceLandmarkMap(const FaceSpecification& spec)
+    : format(spec.format)
+{
+    const FaceSpecification::IntVec* features[kFeatureCount] = {
+        &spec.eyeR, &spec.eyeL, &spec.nose, &spec.browR, &spec.browL, &spec.mouthOuter, &spec.mouthInner, &spec.noseFull
     };
 
-    //cv::Mat canvas(600, 600, CV_8UC3, cv::Scalar::all(0));
+    offsets[0] = 0;
+    for (int i = 0; i < kFeatureCount; i++)
+    {
+        indices.insert(indices.end(), features[i]->begin(), features[i]->end());
+        offsets[i + 1] = int(indices.size());
+    }
+}
+
+void FaceLandmarkMap::operator()(const drishti::core::Shape& shape, FaceModel& face) const
+{
+    const int count = int(shape.contour.size());
+
+    // Reset everything but the capacity of the contours:
+    std::vector<cv::Point2f>* contours[kFeatureCount] = {
+        &face.eyeRight, &face.eyeLeft, &face.nose, &face.eyebrowRight, &face.eyebrowLeft, &face.mouthOuter, &face.mouthInner, &face.noseFull
+    };
+    for (auto* contour : { &face.mouth, &face.sideLeft, &face.sideRight })
+    {
+        contour->clear();
+    }
+    for (auto* point : { &face.eyeLeftInner, &face.eyeLeftOuter, &face.eyeLeftCenter, &face.eyebrowLeftInner, &face.eyebrowLeftOuter, &face.eyeRightInner, &face.eyeRightOuter, &face.eyeRightCenter, &face.eyebrowRightInner, &face.eyebrowRightOuter, &face.noseTip, &face.noseNostrilLeft, &face.noseNostrilRight, &face.mouthCornerRight, &face.mouthCornerLeft })
+    {
+        point->has = false;
+    }
+    face.eyeFullL.has = face.eyeFullR.has = false;
+    face.eyesCenter.has = false;
+    face.disagreement.has = false;
+    face.rois.clear();
+
+    face.roi = shape.roi;
+    face.points.has = true;
+    face.points->resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        (*face.points)[i] = shape.contour[i].p;
+    }
 
-    int total = 0, start1;
-    for (auto& o : objects)
+    for (int i = 0; i < kFeatureCount; i++)
     {
-        if (o.first->size())
+        auto& contour = *contours[i];
+        contour.clear();
+        for (int j = offsets[i]; j < offsets[i + 1]; j++)
         {
-            start1 = o.first->front();
-            for (const auto& i : *o.first)
+            if (indices[j] < count)
             {
-                int index = relative ? (i - start1 + total) : i;
-                if (index < points.size())
-                {
-                    const auto& p = points[index];
-                    o.second->push_back(p);
-                }
+                contour.push_back(shape.contour[indices[j]].p);
             }
-            total += o.first->size();
         }
     }
 
     fill(face);
-
-    return face;
 }
 
 FaceModel shapeToFace(drishti::core::Shape& shape, FaceSpecification::Format kind)
 {
-    auto points = shape.getPoints();
-
     FaceModel face;
-    face.roi = shape.roi;
-    face.points = points;
+    FaceLandmarkMap(kind)(shape, face);
+    return face;
+}
 
-    // TODO: review relative
-    FaceSpecification spec = FaceSpecification::create(kind);
-    return shapeToFace(shape, spec, false); //(kind == FaceSpecification::kHELEN));
+FaceModel shapeToFace(drishti::core::Shape& shape, FaceSpecification::Format kind, const std::vector<int>& landmarks)
+{
+    FaceModel face;
+    FaceLandmarkMap(kind, landmarks)(shape, face);
+    return face;
 }
 
 DRISHTI_FACE_NAMESPACE_END
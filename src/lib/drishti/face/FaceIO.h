@@ -15,6 +15,8 @@
 #include "drishti/face/Face.h"
 #include "drishti/core/Shape.h"
 
+#include <array>
+
 DRISHTI_FACE_NAMESPACE_BEGIN
 
 using PointVec = std::vector<cv::Point2f>;
@@ -48,10 +50,51 @@ struct FaceSpecification
     IntVec noseFull;
 
     static FaceSpecification create(Format format);
+
+    // Indices for the points of a landmark subset (format indices of each point), the features
+    // keep the points of the subset:
+    FaceSpecification select(const IntVec& landmarks) const;
+};
+
+/*
+ * A format (or a landmark subset of it) compiled once into a flat index map: the shape points
+ * of the feature contours are stored contiguously, so a conversion is a single pass of indexed
+ * copies.  The output face keeps the capacity of its contours (i.e., faces reused frame to
+ * frame don't allocate), and all of its fields are reset.
+ */
+
+struct FaceLandmarkMap
+{
+    enum Feature
+    {
+        kEyeRight,
+        kEyeLeft,
+        kNose,
+        kBrowRight,
+        kBrowLeft,
+        kMouthOuter,
+        kMouthInner,
+        kNoseFull,
+        kFeatureCount
+    };
+
+    FaceLandmarkMap(FaceSpecification::Format format = FaceSpecification::kibug68, const std::vector<int>& landmarks = {});
+    FaceLandmarkMap(const FaceSpecification& spec);
+
+    void operator()(const drishti::core::Shape& shape, FaceModel& face) const;
+
+    FaceSpecification::Format format = FaceSpecification::kibug68;
+    std::vector<int> landmarks; // compiled subset (empty : all)
+
+    std::vector<int> indices;                   // shape point of each feature point
+    std::array<int, kFeatureCount + 1> offsets; // feature i : indices[offsets[i], offsets[i + 1])
 };
 
 FaceModel shapeToFace(drishti::core::Shape& shape, FaceSpecification::Format kind = FaceSpecification::kibug68);
 
+// Shapes with a subset of the landmarks (see ml::ShapeEstimator::getLandmarks(), empty : all):
+FaceModel shapeToFace(drishti::core::Shape& shape, FaceSpecification::Format kind, const std::vector<int>& landmarks);
+
 DRISHTI_FACE_NAMESPACE_END
 
 #endif // __drishti_face_FaceIO_h__
@@ -0,0 +1,109 @@
+/*! -*-c++-*-
+  @file   FaceJson.cpp
+  @author David Hirvonen
+  @brief  Implementation of streaming JSON I/O for face models (cereal JSON schema).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FaceJson.h"
+#include "drishti/eye/EyeJson.h"
+#include "drishti/core/drishti_cv_json.h"
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+void write(core::JsonWriter& os, const FaceModel& face)
+{
+    // clang-format off
+    os.beginObject().version<FaceModel>(2); // CEREAL_CLASS_VERSION (FaceArchiveCereal.cpp)
+    os.key("eye-full-left"); write(os, face.eyeFullL);
+    os.key("eye-full-right"); write(os, face.eyeFullR);
+    os.key("eye-left-inner"); write(os, face.eyeLeftInner);
+    os.key("eye-left-center"); write(os, face.eyeLeftCenter);
+    os.key("eye-left-outer"); write(os, face.eyeLeftOuter);
+    os.key("eyebrow-left-inner"); write(os, face.eyebrowLeftInner);
+    os.key("eyebrow-left-inner"); write(os, face.eyebrowLeftOuter); // sic (duplicate key)
+
+    os.key("eye-right-inner"); write(os, face.eyeRightInner);
+    os.key("eye-right-center"); write(os, face.eyeRightCenter);
+    os.key("eye-right-outer"); write(os, face.eyeRightOuter);
+    os.key("eyebrow-right-inner"); write(os, face.eyebrowRightInner);
+    os.key("eyebrow-right-inner"); write(os, face.eyebrowRightOuter); // sic (duplicate key)
+
+    os.key("nose-tip"); write(os, face.noseTip);
+    os.key("nose-nostril-left"); write(os, face.noseNostrilLeft);
+    os.key("nose-nostril-right"); write(os, face.noseNostrilRight);
+
+    os.key("mouth-corner-left"); write(os, face.mouthCornerLeft);
+    os.key("mouth-corner-right"); write(os, face.mouthCornerRight);
+
+    os.key("mouth"); write(os, face.mouth);
+    os.key("mouthOuter"); write(os, face.mouthOuter);
+    os.key("mouthInner"); write(os, face.mouthInner);
+
+    os.key("nose"); write(os, face.nose);
+    os.key("eye-left"); write(os, face.eyeLeft);
+    os.key("eyebrow-left"); write(os, face.eyebrowLeft);
+    os.key("eye-right"); write(os, face.eyeRight);
+    os.key("eyebrow-right"); write(os, face.eyebrowRight);
+    os.endObject();
+    // clang-format on
+}
+
+bool read(core::JsonReader& is, FaceModel& face)
+{
+    // The eyebrow outer points are stored under the inner point keys (second occurrence):
+    int eyebrowLeft = 0, eyebrowRight = 0;
+
+    return core::readObject(is, [&](const core::JsonReader::Key& key) -> bool {
+        // clang-format off
+        if (key == "eye-full-left") return read(is, face.eyeFullL);
+        if (key == "eye-full-right") return read(is, face.eyeFullR);
+        if (key == "eye-left-inner") return read(is, face.eyeLeftInner);
+        if (key == "eye-left-center") return read(is, face.eyeLeftCenter);
+        if (key == "eye-left-outer") return read(is, face.eyeLeftOuter);
+        if (key == "eyebrow-left-inner") return read(is, (eyebrowLeft++ ? face.eyebrowLeftOuter : face.eyebrowLeftInner));
+        if (key == "eye-right-inner") return read(is, face.eyeRightInner);
+        if (key == "eye-right-center") return read(is, face.eyeRightCenter);
+        if (key == "eye-right-outer") return read(is, face.eyeRightOuter);
+        if (key == "eyebrow-right-inner") return read(is, (eyebrowRight++ ? face.eyebrowRightOuter : face.eyebrowRightInner));
+        if (key == "nose-tip") return read(is, face.noseTip);
+        if (key == "nose-nostril-left") return read(is, face.noseNostrilLeft);
+        if (key == "nose-nostril-right") return read(is, face.noseNostrilRight);
+        if (key == "mouth-corner-left") return read(is, face.mouthCornerLeft);
+        if (key == "mouth-corner-right") return read(is, face.mouthCornerRight);
+        if (key == "mouth") return read(is, face.mouth);
+        if (key == "mouthOuter") return read(is, face.mouthOuter);
+        if (key == "mouthInner") return read(is, face.mouthInner);
+        if (key == "nose") return read(is, face.nose);
+        if (key == "eye-left") return read(is, face.eyeLeft);
+        if (key == "eyebrow-left") return read(is, face.eyebrowLeft);
+        if (key == "eye-right") return read(is, face.eyeRight);
+        if (key == "eyebrow-right") return read(is, face.eyebrowRight);
+        // clang-format on
+        return is.skip();
+    });
+}
+
+std::string& toJson(const std::vector<FaceModel>& faces, std::string& buffer)
+{
+    buffer.clear();
+    core::JsonWriter os(buffer);
+    os.beginObject().key("faces");
+    write(os, faces);
+    os.endObject();
+    return buffer;
+}
+
+bool fromJson(const char* data, std::size_t size, std::vector<FaceModel>& faces)
+{
+    core::JsonReader is(data, size);
+    is.next();
+    return core::readObject(is, [&](const core::JsonReader::Key& key) -> bool {
+        return (key == "faces") ? read(is, faces) : is.skip();
+    });
+}
+
+DRISHTI_FACE_NAMESPACE_END
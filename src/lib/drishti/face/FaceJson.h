@@ -0,0 +1,34 @@
+/*! -*-c++-*-
+  @file   FaceJson.h
+  @author David Hirvonen
+  @brief  Declaration of streaming JSON I/O for face models (cereal JSON schema).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_face_FaceJson_h__
+#define __drishti_face_FaceJson_h__
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/face/Face.h"
+#include "drishti/core/JsonStream.h"
+
+#include <string>
+#include <vector>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+// Same members and order as FaceModel::serialize() (see FaceImpl.h):
+void write(core::JsonWriter& os, const FaceModel& face);
+bool read(core::JsonReader& is, FaceModel& face);
+
+// Document with one "faces" array (i.e., cereal JSONOutputArchive << GENERIC_NVP("faces", faces)),
+// the buffer is cleared first and its capacity is reused:
+std::string& toJson(const std::vector<FaceModel>& faces, std::string& buffer);
+bool fromJson(const char* data, std::size_t size, std::vector<FaceModel>& faces);
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceJson_h__
@@ -12,13 +12,16 @@
 
 #include <opencv2/imgproc.hpp>
 
-#include <iostream>
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
 
 DRISHTI_FACE_NAMESPACE_BEGIN
 
-static cv::Mat getAffineLeastSquares(const cv::Vec6f& T1, const cv::Vec6f& T2);
-
 FaceMesh::FaceMesh()
 {
 }
@@ -34,47 +37,79 @@ void FaceMesh::operator()(const Landmarks& landmarks, Triangles& mesh)
     mesh = delaunay(landmarks, size);
 }
 
+// Closed form affine transformation mapping the vertices of triangle a to those of triangle b:
+static bool getAffine(const cv::Vec6f& a, const cv::Vec6f& b, cv::Matx23f& H)
+{
+    const cv::Matx33f A(a[0], a[2], a[4], a[1], a[3], a[5], 1.f, 1.f, 1.f);
+    if (std::abs(cv::determinant(A)) < 1e-6f)
+    {
+        return false; // degenerate
+    }
+    const cv::Matx23f B(b[0], b[2], b[4], b[1], b[3], b[5]);
+    H = B * A.inv();
+    return true;
+}
+
+// Span [x0, x1] of triangle t covered by the integer pixel centers of row y:
+static bool getSpan(const cv::Vec6f& t, float y, int width, int& x0, int& x1)
+{
+    float xl = std::numeric_limits<float>::max(), xr = -std::numeric_limits<float>::max();
+    for (int i = 0; i < 3; i++)
+    {
+        const cv::Point2f p(t[i * 2 + 0], t[i * 2 + 1]);
+        const cv::Point2f q(t[((i + 1) % 3) * 2 + 0], t[((i + 1) % 3) * 2 + 1]);
+        if ((p.y != q.y) && (std::min(p.y, q.y) <= y) && (y <= std::max(p.y, q.y)))
+        {
+            const float x = p.x + (y - p.y) * (q.x - p.x) / (q.y - p.y);
+            xl = std::min(xl, x);
+            xr = std::max(xr, x);
+        }
+    }
+
+    x0 = std::max(0, static_cast<int>(std::ceil(xl)));
+    x1 = std::min(width - 1, static_cast<int>(std::floor(xr)));
+    return (xl <= xr) && (x0 <= x1);
+}
+
 std::array<cv::Mat1f, 2> FaceMesh::transform(const Triangles& a, const Triangles& b, const cv::Size& size)
 {
     CV_Assert(a.size() == b.size());
 
-    const int n = a.size();
-    std::vector<cv::Matx33f> M(n, cv::Matx33f::eye());
+    // Uncovered pixels are sampled from the border (i.e., 0 for cv::BORDER_CONSTANT):
+    cv::Mat1f mapx(size, -1.f);
+    cv::Mat1f mapy(size, -1.f);
 
-    cv::Mat1b mask(size, 0);
-    for (int i = 0; i < n; i++)
+    // Scanline rasterization of each triangle in a, with one affine transformation per triangle:
+    for (int i = 0; i < static_cast<int>(a.size()); i++)
     {
-        const auto& tA = a[i];
-        std::vector<std::vector<cv::Point>> pointsA{ { cv::Point(tA[0], tA[1]),
-            cv::Point(tA[2], tA[3]),
-            cv::Point(tA[4], tA[5]) } };
-
-        const auto& tB = b[i];
-        std::vector<std::vector<cv::Point>> pointsB{ { cv::Point(tB[0], tB[1]),
-            cv::Point(tB[2], tB[3]),
-            cv::Point(tB[4], tB[5]) } };
-
-        int value = (i + 1);
-        cv::fillPoly(mask, pointsA, value, 4);
-
-        // Create affine transformations from a to b
-        cv::Mat H = getAffineLeastSquares(tA, tB);
-        H.convertTo(cv::Mat1f(M[i].rows, M[i].cols, (float*)&M[i](0, 0))(cv::Rect({ 0, 0 }, H.size())), CV_32F);
-    }
+        const auto& t = a[i];
 
-    // Mirror image and take mean:
-    cv::Mat1f mapx(size, 0.f);
-    cv::Mat1f mapy(size, 0.f);
-    for (int y = 0; y < size.height; y++)
-    {
-        for (int x = 0; x < size.width; x++)
+        cv::Matx23f H;
+        if (!getAffine(t, b[i], H))
         {
-            int index = mask(y, x);
-            if (index-- > 0)
+            continue;
+        }
+
+        const float top = std::min(t[1], std::min(t[3], t[5]));
+        const float bottom = std::max(t[1], std::max(t[3], t[5]));
+        const int y0 = std::max(0, static_cast<int>(std::ceil(top)));
+        const int y1 = std::min(size.height - 1, static_cast<int>(std::floor(bottom)));
+
+        for (int y = y0; y <= y1; y++)
+        {
+            int x0 = 0, x1 = 0;
+            if (getSpan(t, float(y), size.width, x0, x1))
             {
-                cv::Point3f p(x, y, 1.f), q = M[index] * p;
-                mapx(y, x) = q.x;
-                mapy(y, x) = q.y;
+                // Linear in x along the row:
+                const float bx = H(0, 1) * y + H(0, 2), by = H(1, 1) * y + H(1, 2);
+                const float ax = H(0, 0), ay = H(1, 0);
+                float* px = mapx.ptr<float>(y);
+                float* py = mapy.ptr<float>(y);
+                for (int x = x0; x <= x1; x++)
+                {
+                    px[x] = bx + ax * x;
+                    py[x] = by + ay * x;
+                }
             }
         }
     }
@@ -87,76 +122,106 @@ std::array<cv::Mat1f, 2> FaceMesh::transform(const Triangles& a, const Triangles
 std::array<cv::Mat1f, 2> FaceMesh::transform(const Landmarks& a, const Landmarks& b, const cv::Size& size)
 {
     CV_Assert(a.size() == b.size());
-    return transform(delaunay(a, size), delaunay(b, size), size);
+
+    // Both meshes share the same topology:
+    const auto topology = getTopology(a, size);
+    return transform(getTriangles(a, topology), getTriangles(b, topology), size);
 }
 
-FaceMesh::Triangles FaceMesh::delaunay(const Landmarks& landmarks, const cv::Size& size, bool doHalf)
+void FaceMesh::warp(const cv::Mat& src, const Landmarks& srcLandmarks, const Landmarks& dstLandmarks, const cv::Size& size, cv::Mat& dst)
+{
+    const auto maps = transform(dstLandmarks, srcLandmarks, size);
+    cv::remap(src, dst, maps[0], maps[1], cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+}
+
+std::vector<cv::Vec3i> FaceMesh::getTopology(const Landmarks& landmarks, const cv::Size& size)
 {
-    std::vector<cv::Vec6f> trianglesL, trianglesR;
+    bindTopology(landmarks, size);
 
-    if (m_indices.size())
+    // Same order as delaunay(): left side, then the mirrored triangles
+    std::vector<cv::Vec3i> topology(m_indices.size() * 2);
+    for (int i = 0; i < static_cast<int>(m_indices.size()); i++)
     {
-        // Create triangles from indices
-        trianglesL.resize(m_indices.size());
-        for (int i = 0; i < m_indices.size(); i++)
+        const auto& t = m_indices[i];
+        for (int j = 0; j < 2; j++)
         {
-            cv::Point2f p1 = landmarks[kMirrorMap[m_indices[i][0]][0]];
-            cv::Point2f p2 = landmarks[kMirrorMap[m_indices[i][1]][0]];
-            cv::Point2f p3 = landmarks[kMirrorMap[m_indices[i][2]][0]];
-            trianglesL[i] = cv::Vec6f(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y);
+            topology[i + j * m_indices.size()] = cv::Vec3i(kMirrorMap[t[0]][j], kMirrorMap[t[1]][j], kMirrorMap[t[2]][j]);
         }
     }
-    else
+    return topology;
+}
+
+FaceMesh::Triangles FaceMesh::getTriangles(const Landmarks& landmarks, const std::vector<cv::Vec3i>& topology)
+{
+    Triangles triangles(topology.size());
+    for (int i = 0; i < static_cast<int>(topology.size()); i++)
     {
-        // Perform the delaunay triangulation
+        const auto& p1 = landmarks[topology[i][0]];
+        const auto& p2 = landmarks[topology[i][1]];
+        const auto& p3 = landmarks[topology[i][2]];
+        triangles[i] = cv::Vec6f(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y);
+    }
+    return triangles;
+}
+
+const char* FaceMesh::kScheme = "ibug68";
+
+using TopologyKey = std::pair<std::size_t, std::string>;
+
+static std::mutex& getTopologyMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::map<TopologyKey, FaceMesh::Topology>& getTopologyCache()
+{
+    static std::map<TopologyKey, FaceMesh::Topology> cache;
+    return cache;
+}
 
-        // Use a delaunay subdivision and balance mirror triangles:
-        cv::Rect roi({ 0, 0 }, size);
-        cv::Subdiv2D subdiv;
-        subdiv.initDelaunay(roi);
-        for (int i = 0; i < kMirrorMap.size(); i++)
+void FaceMesh::clearTopologyCache()
+{
+    std::lock_guard<std::mutex> lock(getTopologyMutex());
+    getTopologyCache().clear();
+}
+
+void FaceMesh::bindTopology(const Landmarks& landmarks, const cv::Size& size)
+{
+    if (m_indices.empty() || (m_count && (m_count != landmarks.size())))
+    {
+        // Only the first mesh for a given landmark count and scheme runs the Subdiv2D triangulation:
+        std::lock_guard<std::mutex> lock(getTopologyMutex());
+        auto& cache = getTopologyCache();
+        auto iter = cache.find({ landmarks.size(), m_scheme });
+        if (iter == cache.end())
         {
-            auto p = landmarks[kMirrorMap[i][0]];
-            subdiv.insert(p);
+            iter = cache.emplace(TopologyKey(landmarks.size(), m_scheme), triangulate(landmarks, size)).first;
         }
-        std::vector<cv::Vec3i> indices;
-        subdiv.getTriangleList(trianglesL);
-
-        auto pruner = [&](const cv::Vec6f& triangle) {
-            cv::Point2f p1(triangle[0], triangle[1]);
-            cv::Point2f p2(triangle[2], triangle[3]);
-            cv::Point2f p3(triangle[4], triangle[5]);
-            return (!(roi.contains(p1) && roi.contains(p2) && roi.contains(p3)));
-        };
-        trianglesL.erase(std::remove_if(trianglesL.begin(), trianglesL.end(), pruner), trianglesL.end());
-        m_indices.resize(trianglesL.size());
-
-        for (int i = 0; i < trianglesL.size(); i++)
-        {
-            const auto& triangle = trianglesL[i];
-            cv::Point2f p1(triangle[0], triangle[1]);
-            cv::Point2f p2(triangle[2], triangle[3]);
-            cv::Point2f p3(triangle[4], triangle[5]);
+        m_indices = iter->second;
+        m_count = landmarks.size();
+    }
+    else if (!m_count)
+    {
+        // Bind (and share) a triangulation from readTriangulation():
+        m_count = landmarks.size();
+        std::lock_guard<std::mutex> lock(getTopologyMutex());
+        getTopologyCache()[{ m_count, m_scheme }] = m_indices;
+    }
+}
 
-            int k1 = 0, k2 = 0, k3 = 0;
-            for (k1 = 0; k1 < kMirrorMap.size(); k1++)
-            {
-                if (landmarks[kMirrorMap[k1][0]] == p1)
-                    break;
-            }
-            for (k2 = 0; k2 < kMirrorMap.size(); k2++)
-            {
-                if (landmarks[kMirrorMap[k2][0]] == p2)
-                    break;
-            }
-            for (k3 = 0; k3 < kMirrorMap.size(); k3++)
-            {
-                if (landmarks[kMirrorMap[k3][0]] == p3)
-                    break;
-            }
+FaceMesh::Triangles FaceMesh::delaunay(const Landmarks& landmarks, const cv::Size& size, bool doHalf)
+{
+    bindTopology(landmarks, size);
 
-            m_indices[i] = cv::Vec3i(k1, k2, k3);
-        }
+    // Create triangles from indices
+    std::vector<cv::Vec6f> trianglesL(m_indices.size()), trianglesR;
+    for (int i = 0; i < m_indices.size(); i++)
+    {
+        cv::Point2f p1 = landmarks[kMirrorMap[m_indices[i][0]][0]];
+        cv::Point2f p2 = landmarks[kMirrorMap[m_indices[i][1]][0]];
+        cv::Point2f p3 = landmarks[kMirrorMap[m_indices[i][2]][0]];
+        trianglesL[i] = cv::Vec6f(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y);
     }
 
     trianglesR = mirrorTriangulation(landmarks, kMirrorMap);
@@ -166,6 +231,60 @@ FaceMesh::Triangles FaceMesh::delaunay(const Landmarks& landmarks, const cv::Siz
     return trianglesL;
 }
 
+FaceMesh::Topology FaceMesh::triangulate(const Landmarks& landmarks, const cv::Size& size)
+{
+    std::vector<cv::Vec6f> trianglesL;
+
+    // Use a delaunay subdivision and balance mirror triangles:
+    cv::Rect roi({ 0, 0 }, size);
+    cv::Subdiv2D subdiv;
+    subdiv.initDelaunay(roi);
+    for (int i = 0; i < kMirrorMap.size(); i++)
+    {
+        auto p = landmarks[kMirrorMap[i][0]];
+        subdiv.insert(p);
+    }
+    subdiv.getTriangleList(trianglesL);
+
+    auto pruner = [&](const cv::Vec6f& triangle) {
+        cv::Point2f p1(triangle[0], triangle[1]);
+        cv::Point2f p2(triangle[2], triangle[3]);
+        cv::Point2f p3(triangle[4], triangle[5]);
+        return (!(roi.contains(p1) && roi.contains(p2) && roi.contains(p3)));
+    };
+    trianglesL.erase(std::remove_if(trianglesL.begin(), trianglesL.end(), pruner), trianglesL.end());
+
+    Topology indices(trianglesL.size());
+    for (int i = 0; i < trianglesL.size(); i++)
+    {
+        const auto& triangle = trianglesL[i];
+        cv::Point2f p1(triangle[0], triangle[1]);
+        cv::Point2f p2(triangle[2], triangle[3]);
+        cv::Point2f p3(triangle[4], triangle[5]);
+
+        int k1 = 0, k2 = 0, k3 = 0;
+        for (k1 = 0; k1 < kMirrorMap.size(); k1++)
+        {
+            if (landmarks[kMirrorMap[k1][0]] == p1)
+                break;
+        }
+        for (k2 = 0; k2 < kMirrorMap.size(); k2++)
+        {
+            if (landmarks[kMirrorMap[k2][0]] == p2)
+                break;
+        }
+        for (k3 = 0; k3 < kMirrorMap.size(); k3++)
+        {
+            if (landmarks[kMirrorMap[k3][0]] == p3)
+                break;
+        }
+
+        indices[i] = cv::Vec3i(k1, k2, k3);
+    }
+
+    return indices;
+}
+
 // Input:
 //  1) m_indices : for triangles on the left side
 //  2) mirrorMap : mapping from vertices of triangles on left side to corresponding vertices on right
@@ -187,6 +306,8 @@ std::vector<cv::Vec6f> FaceMesh::mirrorTriangulation(const Landmarks& landmarks,
 int FaceMesh::readTriangulation(const std::string& filename)
 {
     m_indices.clear();
+    m_count = 0;
+    m_scheme = filename;
 
     cv::FileStorage fs(filename, cv::FileStorage::READ);
     if (fs.isOpened())
@@ -314,11 +435,4 @@ const std::vector<std::array<int, 2>> FaceMesh::kMirrorMap{
     { { 66, 66 } }
 };
 
-static cv::Mat getAffineLeastSquares(const cv::Vec6f& T1, const cv::Vec6f& T2)
-{
-    std::vector<cv::Point2f> pt1{ { T1[0], T1[1] }, { T1[2], T1[3] }, { T1[4], T1[5] } };
-    std::vector<cv::Point2f> pt2{ { T2[0], T2[1] }, { T2[2], T2[3] }, { T2[4], T2[5] } };
-    return cv::getAffineTransform(pt1, pt2);
-}
-
 DRISHTI_FACE_NAMESPACE_END
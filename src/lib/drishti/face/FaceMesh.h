@@ -14,6 +14,8 @@
 #include "drishti/face/drishti_face.h"
 
 #include <array> // std::array<cv::Mat1f, 2>
+#include <string>
+#include <vector>
 
 #include <opencv2/core.hpp>
 
@@ -24,6 +26,7 @@ class FaceMesh
 public:
     using Landmarks = std::vector<cv::Point2f>;
     using Triangles = std::vector<cv::Vec6f>;
+    using Topology = std::vector<cv::Vec3i>;
 
     FaceMesh();
     FaceMesh(const std::string& filename);
@@ -34,21 +37,39 @@ public:
     int writeTriangulation(const std::string& filename) const;
     int readTriangulation(const std::string& filename);
 
+    // Landmark indices of the (left + mirrored) triangles, e.g., for ogles_gpgpu::MeshWarpProc:
+    std::vector<cv::Vec3i> getTopology(const Landmarks& landmarks, const cv::Size& size);
+    static Triangles getTriangles(const Landmarks& landmarks, const std::vector<cv::Vec3i>& topology);
+
+    // Maps from a (output) to b (input) for cv::remap(), uncovered pixels are mapped to -1:
     std::array<cv::Mat1f, 2> transform(const Landmarks& a, const Landmarks& b, const cv::Size& size);
     std::array<cv::Mat1f, 2> transform(const Triangles& a, const Triangles& b, const cv::Size& size);
 
+    // Piecewise affine warp of src (with srcLandmarks) to an image of the given size (with dstLandmarks):
+    void warp(const cv::Mat& src, const Landmarks& srcLandmarks, const Landmarks& dstLandmarks, const cv::Size& size, cv::Mat& dst);
+
+    // Triangulations are shared by all meshes with the same landmark count and scheme:
+    const std::string& getScheme() const { return m_scheme; }
+    static void clearTopologyCache();
+
     const cv::Rect& getRoi() const { return m_roi; }
     const cv::Mat1b& getLabels() const { return m_labels; }
 
     void draw(cv::Mat& canvas, const Landmarks& landmarks, const Triangles& triangles);
 
 protected:
+    void bindTopology(const Landmarks& landmarks, const cv::Size& size);
+    static Topology triangulate(const Landmarks& landmarks, const cv::Size& size);
     Triangles mirrorTriangulation(const Landmarks& landmarks, const std::vector<std::array<int, 2>>& mirrorMap);
 
     cv::Mat1b m_labels;
     cv::Rect m_roi;
 
-    std::vector<cv::Vec3i> m_indices;
+    std::vector<cv::Vec3i> m_indices; // left side, indices into kMirrorMap
+    std::size_t m_count = 0;          // landmark count of m_indices (0 : not yet bound)
+    std::string m_scheme = kScheme;
+
+    static const char* kScheme;
 
     static const std::vector<cv::Range> kContours;
     static const std::vector<cv::Range> kCurves;
@@ -37,6 +37,12 @@ public:
         , affine_from_ortho(affine)
     {}
 
+    FaceMeshContainerEOS(Mesh &&mesh, const RenderingParameters &params, const cv::Mat &affine)
+        : mesh(std::move(mesh))
+        , rendering_params(params)
+        , affine_from_ortho(affine)
+    {}
+
     ~FaceMeshContainerEOS() = default;
 
     virtual void getFaceMesh(drishti::graphics::MeshTex &mesh) const;
@@ -0,0 +1,172 @@
+/*! -*-c++-*-
+  @file   FaceMeshMapperEOSTracker.cpp
+  @author David Hirvonen (from original code by Patrik Huber)
+  @brief  Implementation of a warm started (video) FaceMeshMapper interface to the EOS library.
+
+  This is based on sample code provided with the EOS library.
+  See: https://github.com/patrikhuber/eos
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/drishti_stdlib_string.h"
+
+#include "drishti/face/FaceMeshMapperEOSTracker.h"
+#include "drishti/face/FaceMeshMapperEOS.h"
+#include "drishti/core/ModelCache.h"
+#include "drishti/core/make_unique.h"
+
+#include "eos/core/Landmark.hpp"
+#include "eos/core/LandmarkMapper.hpp"
+#include "eos/morphablemodel/MorphableModel.hpp"
+#include "eos/morphablemodel/Blendshape.hpp"
+#include "eos/fitting/fitting.hpp"
+#include "eos/fitting/nonlinear_camera_estimation.hpp"
+#include "eos/render/utils.hpp"
+
+#include "opencv2/core.hpp"
+
+#include <vector>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+// Read only model data, shared by all trackers created from the same assets:
+struct FaceMeshModelEOS
+{
+    FaceMeshModelEOS(const FaceMeshMapperEOSTracker::Assets& assets)
+    {
+        morphable_model = eos::morphablemodel::load_model(assets.model);
+        landmark_mapper = assets.mappings.empty() ? eos::core::LandmarkMapper() : eos::core::LandmarkMapper(assets.mappings);
+        blendshapes = eos::morphablemodel::load_blendshapes(assets.blendshapes);
+        model_contour = assets.contour.empty() ? eos::fitting::ModelContour() : eos::fitting::ModelContour::load(assets.contour);
+        ibug_contour = eos::fitting::ContourLandmarks::load(assets.mappings);
+        edge_topology = eos::morphablemodel::load_edge_topology(assets.edgetopology);
+    }
+
+    eos::morphablemodel::MorphableModel morphable_model;
+    eos::core::LandmarkMapper landmark_mapper;
+    std::vector<eos::morphablemodel::Blendshape> blendshapes;
+    eos::fitting::ModelContour model_contour;
+    eos::fitting::ContourLandmarks ibug_contour;
+    eos::morphablemodel::EdgeTopology edge_topology;
+};
+
+struct FaceMeshMapperEOSTracker::Impl
+{
+    using LandmarkSet = eos::core::LandmarkCollection<cv::Vec2f>;
+    using FaceMeshContainerPtr = std::shared_ptr<FaceMeshContainer>;
+
+    Impl(const Assets& assets)
+    {
+        const std::string key = assets.model + "|" + assets.mappings + "|" + assets.blendshapes + "|" + assets.contour + "|" + assets.edgetopology;
+        model = core::ModelCache<FaceMeshModelEOS>::get(key, [&]() {
+            return drishti::core::make_unique<FaceMeshModelEOS>(assets);
+        });
+    }
+
+    void reset()
+    {
+        rendering_params = boost::none;
+        pca_shape_coefficients.clear();
+        blendshape_coefficients.clear();
+    }
+
+    auto operator()(const LandmarkSet& landmarks, const cv::Mat& image) -> FaceMeshContainerPtr
+    {
+        if (image.size() != size)
+        {
+            reset(); // the pose is relative to the image
+            size = image.size();
+        }
+
+        // The coefficients are updated in place, they are used as the initial solution when not empty:
+        const int num_iterations = rendering_params ? iterations : initialIterations;
+        std::vector<cv::Vec2f> fitted_image_points;
+
+        eos::core::Mesh mesh;
+        eos::fitting::RenderingParameters fitted_params;
+        std::tie(mesh, fitted_params) = eos::fitting::fit_shape_and_pose(
+            model->morphable_model,
+            model->blendshapes,
+            landmarks,
+            model->landmark_mapper,
+            image.cols,
+            image.rows,
+            model->edge_topology,
+            model->ibug_contour,
+            model->model_contour,
+            num_iterations,
+            boost::none,
+            30.0f,
+            rendering_params,
+            pca_shape_coefficients,
+            blendshape_coefficients,
+            fitted_image_points);
+        rendering_params = fitted_params;
+
+        cv::Mat affine_from_ortho = eos::fitting::get_3x4_affine_camera_matrix(fitted_params, image.cols, image.rows);
+        return std::make_shared<FaceMeshContainerEOS>(std::move(mesh), fitted_params, affine_from_ortho);
+    }
+
+    auto operator()(const FaceModel& face, const cv::Mat& image) -> FaceMeshContainerPtr
+    {
+        return (*this)(extractLandmarks(face), image);
+    }
+
+    std::shared_ptr<const FaceMeshModelEOS> model;
+
+    int iterations = 3;
+    int initialIterations = 50;
+
+    // Previous solution:
+    cv::Size size;
+    boost::optional<eos::fitting::RenderingParameters> rendering_params;
+    std::vector<float> pca_shape_coefficients;
+    std::vector<float> blendshape_coefficients;
+};
+
+FaceMeshMapperEOSTracker::FaceMeshMapperEOSTracker(const Assets& assets)
+{
+    m_pImpl = drishti::core::make_unique<Impl>(assets);
+}
+
+FaceMeshMapperEOSTracker::~FaceMeshMapperEOSTracker() = default;
+
+auto FaceMeshMapperEOSTracker::operator()(const std::vector<cv::Point2f>& landmarks, const cv::Mat& image) -> FaceMeshContainerPtr
+{
+    return (*m_pImpl)(convertLandmarks(landmarks), image);
+}
+
+auto FaceMeshMapperEOSTracker::operator()(const FaceModel& face, const cv::Mat& image) -> FaceMeshContainerPtr
+{
+    return (*m_pImpl)(face, image);
+}
+
+void FaceMeshMapperEOSTracker::reset()
+{
+    m_pImpl->reset();
+}
+
+void FaceMeshMapperEOSTracker::setIterations(int iterations)
+{
+    m_pImpl->iterations = iterations;
+}
+
+int FaceMeshMapperEOSTracker::getIterations() const
+{
+    return m_pImpl->iterations;
+}
+
+void FaceMeshMapperEOSTracker::setInitialIterations(int iterations)
+{
+    m_pImpl->initialIterations = iterations;
+}
+
+int FaceMeshMapperEOSTracker::getInitialIterations() const
+{
+    return m_pImpl->initialIterations;
+}
+
+DRISHTI_FACE_NAMESPACE_END
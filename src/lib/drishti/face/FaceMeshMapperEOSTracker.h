@@ -0,0 +1,59 @@
+/*! -*-c++-*-
+  @file   FaceMeshMapperEOSTracker.h
+  @author David Hirvonen (from original code by Patrik Huber)
+  @brief  Declaration of a warm started (video) FaceMeshMapper interface to the EOS library.
+
+  This is based on sample code provided with the EOS library.
+  See: https://github.com/patrikhuber/eos
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_face_FaceMeshMapperEOSTracker_h__
+#define __drishti_face_FaceMeshMapperEOSTracker_h__ 1
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/face/Face.h"
+#include "drishti/face/FaceMeshMapper.h"
+#include "drishti/face/FaceMeshMapperEOSLandmarkContour.h"
+
+#include "opencv2/core/core.hpp"
+
+#include <memory>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+// Fit shape, expression and pose starting from the previous frame's solution, which converges in a
+// few iterations for video.  The mapper is stateful: use one instance per tracked face, and call
+// reset() when the track is lost.  Texture extraction is left to FaceMeshContainer::extractTexture().
+class FaceMeshMapperEOSTracker : public FaceMeshMapper
+{
+public:
+    using FaceMeshContainerPtr = std::shared_ptr<FaceMeshContainer>;
+    using Assets = FaceMeshMapperEOSLandmarkContour::Assets;
+
+    FaceMeshMapperEOSTracker(const Assets& assets);
+    ~FaceMeshMapperEOSTracker();
+
+    virtual FaceMeshContainerPtr operator()(const std::vector<cv::Point2f>& landmarks, const cv::Mat& image);
+    virtual FaceMeshContainerPtr operator()(const FaceModel& face, const cv::Mat& image);
+
+    // Forget the previous solution, the next frame is fit from the mean face:
+    void reset();
+
+    // Iterations for warm started frames and for the first (cold) frame:
+    void setIterations(int iterations);
+    int getIterations() const;
+    void setInitialIterations(int iterations);
+    int getInitialIterations() const;
+
+protected:
+    struct Impl;
+    std::unique_ptr<Impl> m_pImpl;
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceMeshMapperEOSTracker_h__
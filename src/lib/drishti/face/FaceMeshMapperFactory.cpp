@@ -11,6 +11,7 @@
 #include "drishti/face/FaceMeshMapperFactory.h"
 #include "drishti/face/FaceMeshMapperEOSLandmark.h"
 #include "drishti/face/FaceMeshMapperEOSLandmarkContour.h"
+#include "drishti/face/FaceMeshMapperEOSTracker.h"
 #include "drishti/core/make_unique.h"
 
 // Need std:: extensions for android targets
@@ -98,6 +99,8 @@ std::shared_ptr<drishti::face::FaceMeshMapper> FaceMeshMapperFactory::create(Ali
         return std::make_shared<FaceMeshMapperEOSLandmark>(impl->assets.model, impl->assets.mappings);
     case kLandmarksContours:
         return std::make_shared<FaceMeshMapperEOSLandmarkContour>(impl->assets);
+    case kLandmarksContoursTracking:
+        return std::make_shared<FaceMeshMapperEOSTracker>(impl->assets);
     }
 }
 
@@ -26,7 +26,8 @@ public:
     enum AlignmentStrategy
     {
         kLandmarks,
-        kLandmarksContours
+        kLandmarksContours,
+        kLandmarksContoursTracking // warm started from the previous frame (one mapper per face)
     };
     
     FaceMeshMapperFactory(const std::string &filename);
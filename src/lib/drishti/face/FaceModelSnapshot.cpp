@@ -0,0 +1,275 @@
+/*! -*-c++-*-
+  @file   FaceModelSnapshot.cpp
+  @author David Hirvonen
+  @brief  Implementation of a fixed size, trivially copyable face model for transport.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FaceModelSnapshot.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+using Snapshot = FaceModelSnapshot;
+using PointField = core::Field<cv::Point2f>;
+using Contour = std::vector<cv::Point2f>;
+
+// In order of FaceModelSnapshot::Feature:
+static const std::array<PointField FaceModel::*, Snapshot::kLandmarkCount> sLandmarks{ {
+    &FaceModel::eyeLeftInner,
+    &FaceModel::eyeLeftOuter,
+    &FaceModel::eyeLeftCenter,
+    &FaceModel::eyebrowLeftInner,
+    &FaceModel::eyebrowLeftOuter,
+    &FaceModel::eyeRightInner,
+    &FaceModel::eyeRightOuter,
+    &FaceModel::eyeRightCenter,
+    &FaceModel::eyebrowRightInner,
+    &FaceModel::eyebrowRightOuter,
+    &FaceModel::noseTip,
+    &FaceModel::noseNostrilLeft,
+    &FaceModel::noseNostrilRight,
+    &FaceModel::mouthCornerRight,
+    &FaceModel::mouthCornerLeft,
+} };
+
+// In order of FaceModelSnapshot::Contour (FaceModel::points is a Field and handled separately):
+static const std::array<Contour FaceModel::*, Snapshot::kLandmarks> sContours{ {
+    &FaceModel::eyeLeft,
+    &FaceModel::eyebrowLeft,
+    &FaceModel::eyeRight,
+    &FaceModel::eyebrowRight,
+    &FaceModel::nose,
+    &FaceModel::noseFull,
+    &FaceModel::mouthOuter,
+    &FaceModel::mouth,
+    &FaceModel::mouthInner,
+    &FaceModel::sideLeft,
+    &FaceModel::sideRight,
+} };
+
+static const std::array<Contour DRISHTI_EYE::EyeModel::*, Snapshot::Eye::kContourCount> sEyeContours{ {
+    &DRISHTI_EYE::EyeModel::eyelids,
+    &DRISHTI_EYE::EyeModel::eyelidsSpline,
+    &DRISHTI_EYE::EyeModel::crease,
+    &DRISHTI_EYE::EyeModel::creaseSpline,
+} };
+
+// In order of FaceModelSnapshot::Eye::Feature:
+static const std::array<PointField DRISHTI_EYE::EyeModel::*, Snapshot::Eye::kLandmarkCount> sEyeLandmarks{ {
+    &DRISHTI_EYE::EyeModel::innerCorner,
+    &DRISHTI_EYE::EyeModel::outerCorner,
+    &DRISHTI_EYE::EyeModel::irisCenter,
+    &DRISHTI_EYE::EyeModel::irisInner,
+    &DRISHTI_EYE::EyeModel::irisOuter,
+} };
+
+static void setBit(std::uint32_t& bits, int bit, bool value = true)
+{
+    bits |= (std::uint32_t(value) << bit);
+}
+
+static bool getBit(std::uint32_t bits, int bit)
+{
+    return (bits >> bit) & 1;
+}
+
+// Append a contour to the pool, returns false if it was truncated:
+static bool pack(const Contour& src, Snapshot::Point* pool, std::size_t capacity, std::size_t& size, Snapshot::Span& span)
+{
+    const std::size_t count = std::min(src.size(), capacity - size);
+    span.offset = static_cast<std::uint16_t>(size);
+    span.count = static_cast<std::uint16_t>(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        pool[size++] = { src[i].x, src[i].y };
+    }
+    return count == src.size();
+}
+
+static void unpack(const Snapshot::Point* pool, const Snapshot::Span& span, Contour& dst)
+{
+    dst.resize(span.count);
+    for (std::size_t i = 0; i < span.count; i++)
+    {
+        dst[i] = { pool[span.offset + i].x, pool[span.offset + i].y };
+    }
+}
+
+static void packRect(const cv::Rect& src, std::int32_t dst[4])
+{
+    dst[0] = src.x;
+    dst[1] = src.y;
+    dst[2] = src.width;
+    dst[3] = src.height;
+}
+
+static cv::Rect unpackRect(const std::int32_t src[4])
+{
+    return { src[0], src[1], src[2], src[3] };
+}
+
+static Snapshot::RotatedRect packEllipse(const cv::RotatedRect& src)
+{
+    return { src.center.x, src.center.y, src.size.width, src.size.height, src.angle };
+}
+
+static cv::RotatedRect unpackEllipse(const Snapshot::RotatedRect& src)
+{
+    return { { src.x, src.y }, { src.width, src.height }, src.angle };
+}
+
+static bool pack(const DRISHTI_EYE::EyeModel& src, Snapshot::Eye& dst)
+{
+    using Eye = Snapshot::Eye;
+
+    src.materialize(); // the snapshot holds the splines and iris landmarks
+
+    setBit(dst.present, Eye::kAngle, src.angle.has);
+    dst.angle = src.angle.value;
+    setBit(dst.present, Eye::kRoi, src.roi.has);
+    packRect(src.roi.value, dst.roi);
+    std::copy(src.pupil.val, src.pupil.val + 3, dst.pupil);
+    std::copy(src.iris.val, src.iris.val + 3, dst.iris);
+    dst.irisEllipse = packEllipse(src.irisEllipse);
+    dst.pupilEllipse = packEllipse(src.pupilEllipse);
+    std::copy(src.cornerIndices, src.cornerIndices + 2, dst.cornerIndices);
+
+    for (int i = 0; i < sEyeLandmarks.size(); i++)
+    {
+        const auto& field = src.*sEyeLandmarks[i];
+        setBit(dst.present, i, field.has);
+        dst.landmarks[i] = { field.value.x, field.value.y };
+    }
+
+    bool complete = true;
+    std::size_t size = 0;
+    for (int i = 0; i < Eye::kContourCount; i++)
+    {
+        complete &= pack(src.*sEyeContours[i], dst.points, Snapshot::kMaxEyePoints, size, dst.contours[i]);
+    }
+    return complete;
+}
+
+static void unpack(const Snapshot::Eye& src, DRISHTI_EYE::EyeModel& dst)
+{
+    using Eye = Snapshot::Eye;
+
+    dst.angle.set(getBit(src.present, Eye::kAngle), src.angle);
+    dst.roi.set(getBit(src.present, Eye::kRoi), unpackRect(src.roi));
+    dst.pupil = { src.pupil[0], src.pupil[1], src.pupil[2] };
+    dst.iris = { src.iris[0], src.iris[1], src.iris[2] };
+    dst.irisEllipse = unpackEllipse(src.irisEllipse);
+    dst.pupilEllipse = unpackEllipse(src.pupilEllipse);
+    std::copy(src.cornerIndices, src.cornerIndices + 2, dst.cornerIndices);
+
+    for (int i = 0; i < sEyeLandmarks.size(); i++)
+    {
+        (dst.*sEyeLandmarks[i]).set(getBit(src.present, i), { src.landmarks[i].x, src.landmarks[i].y });
+    }
+
+    for (int i = 0; i < Eye::kContourCount; i++)
+    {
+        unpack(src.points, src.contours[i], dst.*sEyeContours[i]);
+    }
+}
+
+FaceModelSnapshot::FaceModelSnapshot()
+{
+    std::memset(this, 0, sizeof(*this));
+    version = kVersion;
+}
+
+FaceModelSnapshot::FaceModelSnapshot(const FaceModel& face)
+    : FaceModelSnapshot()
+{
+    setBit(present, kRoi, face.roi.has);
+    packRect(face.roi.value, roi);
+
+    for (int i = 0; i < kLandmarkCount; i++)
+    {
+        const auto& field = face.*sLandmarks[i];
+        setBit(present, i, field.has);
+        landmarks[i] = { field.value.x, field.value.y };
+    }
+
+    setBit(present, kEyesCenter, face.eyesCenter.has);
+    eyesCenter[0] = face.eyesCenter.value.x;
+    eyesCenter[1] = face.eyesCenter.value.y;
+    eyesCenter[2] = face.eyesCenter.value.z;
+
+    bool complete = (face.rois.size() <= kMaxRois);
+    roiCount = static_cast<std::uint32_t>(std::min(face.rois.size(), std::size_t(kMaxRois)));
+    for (std::size_t i = 0; i < roiCount; i++)
+    {
+        const cv::Rect2d& r = face.rois[i];
+        rois[i][0] = r.x;
+        rois[i][1] = r.y;
+        rois[i][2] = r.width;
+        rois[i][3] = r.height;
+    }
+
+    std::size_t size = 0;
+    for (int i = 0; i < sContours.size(); i++)
+    {
+        complete &= pack(face.*sContours[i], points, kMaxPoints, size, contours[i]);
+    }
+
+    setBit(present, kPoints, face.points.has);
+    complete &= pack(face.points.value, points, kMaxPoints, size, contours[kLandmarks]);
+
+    setBit(present, kEyeFullR, face.eyeFullR.has);
+    setBit(present, kEyeFullL, face.eyeFullL.has);
+    complete &= !face.eyeFullR.has || pack(face.eyeFullR.value, eyes[0]);
+    complete &= !face.eyeFullL.has || pack(face.eyeFullL.value, eyes[1]);
+
+    setBit(present, kTruncated, !complete);
+}
+
+FaceModel FaceModelSnapshot::toFaceModel() const
+{
+    FaceModel face;
+    face.roi.set(has(kRoi), unpackRect(roi));
+
+    for (int i = 0; i < kLandmarkCount; i++)
+    {
+        (face.*sLandmarks[i]).set(has(Feature(i)), { landmarks[i].x, landmarks[i].y });
+    }
+
+    face.eyesCenter.set(has(kEyesCenter), { eyesCenter[0], eyesCenter[1], eyesCenter[2] });
+
+    face.rois.resize(std::min(roiCount, std::uint32_t(kMaxRois)));
+    for (std::size_t i = 0; i < face.rois.size(); i++)
+    {
+        face.rois[i] = { rois[i][0], rois[i][1], rois[i][2], rois[i][3] };
+    }
+
+    for (int i = 0; i < sContours.size(); i++)
+    {
+        unpack(points, contours[i], face.*sContours[i]);
+    }
+
+    face.points.has = has(kPoints);
+    unpack(points, contours[kLandmarks], face.points.value);
+
+    if (has(kEyeFullR))
+    {
+        face.eyeFullR.has = true;
+        unpack(eyes[0], face.eyeFullR.value);
+    }
+    if (has(kEyeFullL))
+    {
+        face.eyeFullL.has = true;
+        unpack(eyes[1], face.eyeFullL.value);
+    }
+
+    return face;
+}
+
+DRISHTI_FACE_NAMESPACE_END
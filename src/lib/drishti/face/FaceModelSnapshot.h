@@ -0,0 +1,169 @@
+/*! -*-c++-*-
+  @file   FaceModelSnapshot.h
+  @author David Hirvonen
+  @brief  Declaration of a fixed size, trivially copyable face model for transport.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_face_FaceModelSnapshot_h__
+#define __drishti_face_FaceModelSnapshot_h__
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/face/Face.h"
+#include "drishti/core/drishti_type_traits.h"
+
+#include <cstdint>
+#include <type_traits>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+/*
+ * A FaceModel with flat arrays in place of std::vector<> and explicit feature present bits
+ * in place of core::Field<>.  The snapshot can be copied with memcpy, which makes it suitable
+ * for lock free hand off between pipeline stages and for export through shared memory.
+ *
+ * Contours are stored as spans (offset, count) in a shared point pool.  A FaceModel that
+ * doesn't fit the pool is truncated and the kTruncated flag is set.  Values use the native
+ * byte order and the layout is identified by kVersion.
+ */
+
+struct FaceModelSnapshot
+{
+    static const std::uint32_t kVersion = 1;
+
+    enum
+    {
+        kMaxPoints = 512,    // face contours and landmarks
+        kMaxEyePoints = 256, // eyelid and crease contours (per eye)
+        kMaxRois = 4
+    };
+
+    // Bits of present, the landmarks come first (index of landmarks[]):
+    enum Feature
+    {
+        kEyeLeftInner,
+        kEyeLeftOuter,
+        kEyeLeftCenter,
+        kEyebrowLeftInner,
+        kEyebrowLeftOuter,
+        kEyeRightInner,
+        kEyeRightOuter,
+        kEyeRightCenter,
+        kEyebrowRightInner,
+        kEyebrowRightOuter,
+        kNoseTip,
+        kNoseNostrilLeft,
+        kNoseNostrilRight,
+        kMouthCornerRight,
+        kMouthCornerLeft,
+        kRoi,
+        kLandmarkCount = kRoi,
+        kPoints,
+        kEyeFullL,
+        kEyeFullR,
+        kEyesCenter,
+        kTruncated // i.e., the source didn't fit
+    };
+
+    // Index of contours[]:
+    enum Contour
+    {
+        kEyeLeft,
+        kEyebrowLeft,
+        kEyeRight,
+        kEyebrowRight,
+        kNose,
+        kNoseFull,
+        kMouthOuter,
+        kMouth,
+        kMouthInner,
+        kSideLeft,
+        kSideRight,
+        kLandmarks, // FaceModel::points
+        kContourCount
+    };
+
+    struct Point
+    {
+        float x, y;
+    };
+
+    struct RotatedRect
+    {
+        float x, y, width, height, angle;
+    };
+
+    struct Span
+    {
+        std::uint16_t offset, count;
+    };
+
+    struct Eye
+    {
+        // Bits of present, the landmarks come first (index of landmarks[]):
+        enum Feature
+        {
+            kInnerCorner,
+            kOuterCorner,
+            kIrisCenter,
+            kIrisInner,
+            kIrisOuter,
+            kAngle,
+            kLandmarkCount = kAngle,
+            kRoi
+        };
+
+        // Index of contours[]:
+        enum Contour
+        {
+            kEyelids,
+            kEyelidsSpline,
+            kCrease,
+            kCreaseSpline,
+            kContourCount
+        };
+
+        std::uint32_t present;
+        float angle;
+        std::int32_t roi[4];
+        float pupil[3];
+        float iris[3];
+        RotatedRect irisEllipse;
+        RotatedRect pupilEllipse;
+        std::int32_t cornerIndices[2];
+        Point landmarks[kLandmarkCount];
+        Span contours[kContourCount];
+        Point points[kMaxEyePoints];
+    };
+
+    FaceModelSnapshot(); // zero filled (deterministic padding bytes)
+    explicit FaceModelSnapshot(const FaceModel& face);
+
+    FaceModel toFaceModel() const;
+
+    bool has(Feature feature) const
+    {
+        return (present >> feature) & 1;
+    }
+
+    std::uint32_t version;
+    std::uint32_t present;
+    std::int32_t roi[4];
+    Point landmarks[kLandmarkCount];
+    float eyesCenter[3];
+    std::uint32_t roiCount;
+    double rois[kMaxRois][4];
+    Span contours[kContourCount];
+    Point points[kMaxPoints];
+    Eye eyes[2]; // right, left (eyeFullR, eyeFullL)
+};
+
+static_assert(drishti::core::is_trivially_copyable<FaceModelSnapshot>::value, "FaceModelSnapshot must be trivially copyable");
+static_assert(std::is_standard_layout<FaceModelSnapshot>::value, "FaceModelSnapshot must have a standard layout");
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceModelSnapshot_h__
@@ -0,0 +1,42 @@
+/*! -*-c++-*-
+  @file   FaceQuality.cpp
+  @author David Hirvonen
+  @brief  Implementation of a cheap detection quality filter that runs before face regression.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FaceQuality.h"
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+bool FaceQualityFilter::empty() const
+{
+    return (minScore == std::numeric_limits<float>::lowest()) && (minWidth == 0.f) && (maxDistance == 0.f) && (minSharpness == 0.f) && stumps.empty();
+}
+
+float FaceQualityFilter::getConfidence(const FaceQuality& quality) const
+{
+    float confidence = 0.f;
+    for (const auto& stump : stumps)
+    {
+        confidence += (quality[stump.feature] < stump.threshold) ? stump.below : stump.above;
+    }
+    return confidence;
+}
+
+bool FaceQualityFilter::operator()(const FaceQuality& quality) const
+{
+    // clang-format off
+    if (quality[FaceQuality::kScore] < minScore) return false;
+    if ((minWidth != 0.f) && (quality[FaceQuality::kWidth] < minWidth)) return false;
+    if ((maxDistance != 0.f) && (quality[FaceQuality::kDistance] > maxDistance)) return false;
+    if ((minSharpness != 0.f) && (quality[FaceQuality::kSharpness] < minSharpness)) return false;
+    // clang-format on
+
+    return stumps.empty() || (getConfidence(quality) >= stumpThreshold);
+}
+
+DRISHTI_FACE_NAMESPACE_END
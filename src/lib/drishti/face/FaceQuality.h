@@ -0,0 +1,75 @@
+/*! -*-c++-*-
+  @file   FaceQuality.h
+  @author David Hirvonen
+  @brief  Declaration of a cheap detection quality filter that runs before face regression.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_face_FaceQuality_h__
+#define __drishti_face_FaceQuality_h__
+
+#include "drishti/face/drishti_face.h"
+
+#include <limits>
+#include <vector>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+// Features that are available right after detection (before any regression):
+struct FaceQuality
+{
+    enum Feature
+    {
+        kScore,     // detector (ACF) score
+        kWidth,     // detection width in full resolution pixels
+        kDistance,  // distance estimated from the width (meters)
+        kSharpness, // mean ACF gradient magnitude in the detection (blur)
+        kFeatureCount
+    };
+
+    float operator[](int feature) const { return features[feature]; }
+    float& operator[](int feature) { return features[feature]; }
+
+    float features[kFeatureCount] = { 0.f, 0.f, 0.f, 0.f };
+};
+
+/*
+ * Detections that fail any of the thresholds (defaults : unused) are discarded, then the optional
+ * boosted stumps (i.e., trained offline on detections the application rejects) must sum to
+ * at least stumpThreshold.  Both stages do a few comparisons per detection, which is small
+ * next to the landmark and eye regression they skip.
+ */
+
+class FaceQualityFilter
+{
+public:
+    struct Stump
+    {
+        int feature;
+        float threshold;
+        float below; // weight for feature < threshold
+        float above; // weight for feature >= threshold
+    };
+
+    float minScore = std::numeric_limits<float>::lowest();
+    float minWidth = 0.f;
+    float maxDistance = 0.f;
+    float minSharpness = 0.f;
+
+    std::vector<Stump> stumps;
+    float stumpThreshold = 0.f;
+
+    bool empty() const;
+
+    // Weighted stump sum (0 without stumps):
+    float getConfidence(const FaceQuality& quality) const;
+
+    bool operator()(const FaceQuality& quality) const;
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceQuality_h__
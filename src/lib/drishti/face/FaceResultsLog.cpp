@@ -0,0 +1,342 @@
+/*! -*-c++-*-
+  @file   FaceResultsLog.cpp
+  @author David Hirvonen
+  @brief  Implementation of a chunked binary columnar log of per image face and eye results.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FaceResultsLog.h"
+#include "drishti/core/ThrowAssert.h"
+
+#include <algorithm>
+#include <cstring>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+static const char kMagic[4] = { 'D', 'R', 'F', 'R' };
+
+static FaceResultsLog::Ellipse toEllipse(const cv::RotatedRect& e)
+{
+    return { e.center.x, e.center.y, e.size.width, e.size.height, e.angle };
+}
+
+static cv::RotatedRect toRotatedRect(const FaceResultsLog::Ellipse& e)
+{
+    return cv::RotatedRect({ e.cx, e.cy }, { e.width, e.height }, e.angle);
+}
+
+static void append(std::vector<FaceResultsLog::Point>& dst, const std::vector<cv::Point2f>& src)
+{
+    for (const auto& p : src)
+    {
+        dst.push_back({ p.x, p.y });
+    }
+}
+
+// Elements [begin, end) of a column with exclusive end offsets:
+template <typename Offset>
+static void getRange(const Offset* ends, std::size_t i, std::size_t& begin, std::size_t& end)
+{
+    begin = (i > 0) ? static_cast<std::size_t>(ends[i - 1]) : 0;
+    end = static_cast<std::size_t>(ends[i]);
+}
+
+// ((((((((((((((( FaceResultsWriter )))))))))))))))
+
+void FaceResultsWriter::Chunk::clear()
+{
+    // clear() keeps the capacity, so steady state chunks don't allocate:
+    names.clear();
+    nameEnd.clear();
+    keys.clear();
+    faceEnd.clear();
+    flags.clear();
+    rois.clear();
+    points.clear();
+    pointEnd.clear();
+    irises.clear();
+    pupils.clear();
+    eyelids.clear();
+    eyelidEnd.clear();
+}
+
+FaceResultsWriter::FaceResultsWriter(const std::string& filename, std::size_t recordsPerChunk)
+    : m_os(filename, std::ios::binary)
+    , m_recordsPerChunk(std::max(recordsPerChunk, std::size_t(1)))
+{
+    drishti_throw_assert(m_os.good(), "FaceResultsWriter: unable to open " + filename);
+}
+
+FaceResultsWriter::~FaceResultsWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+    }
+}
+
+std::size_t FaceResultsWriter::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_records;
+}
+
+void FaceResultsWriter::operator()(const std::string& name, const std::vector<FaceModel>& faces, std::uint64_t key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    drishti_throw_assert(!m_closed, "FaceResultsWriter: the log is closed");
+
+    auto& c = m_chunk;
+    c.names.insert(c.names.end(), name.begin(), name.end());
+    c.nameEnd.push_back(c.names.size());
+    c.keys.push_back(key);
+
+    for (const auto& face : faces)
+    {
+        std::uint8_t flags = 0;
+
+        FaceResultsLog::Rect roi{ 0, 0, 0, 0 };
+        if (face.roi.has)
+        {
+            flags |= FaceResultsLog::kRoi;
+            roi = { face.roi->x, face.roi->y, face.roi->width, face.roi->height };
+        }
+        c.rois.push_back(roi);
+
+        if (face.points.has)
+        {
+            flags |= FaceResultsLog::kPoints;
+            append(c.points, *face.points);
+        }
+        c.pointEnd.push_back(static_cast<std::uint32_t>(c.points.size()));
+
+        const core::Field<eye::EyeModel>* eyes[2] = { &face.eyeFullR, &face.eyeFullL };
+        for (int i = 0; i < 2; i++)
+        {
+            if (eyes[i]->has)
+            {
+                flags |= (i == 0) ? FaceResultsLog::kEyeRight : FaceResultsLog::kEyeLeft;
+                c.irises.push_back(toEllipse((*eyes[i])->irisEllipse));
+                c.pupils.push_back(toEllipse((*eyes[i])->pupilEllipse));
+                append(c.eyelids, (*eyes[i])->eyelids);
+            }
+            else
+            {
+                c.irises.push_back({ 0.f, 0.f, 0.f, 0.f, 0.f });
+                c.pupils.push_back({ 0.f, 0.f, 0.f, 0.f, 0.f });
+            }
+            c.eyelidEnd.push_back(static_cast<std::uint32_t>(c.eyelids.size()));
+        }
+
+        c.flags.push_back(flags);
+    }
+    c.faceEnd.push_back(static_cast<std::uint32_t>(c.flags.size()));
+
+    m_records++;
+    if (c.nameEnd.size() >= m_recordsPerChunk)
+    {
+        flush();
+    }
+}
+
+void FaceResultsWriter::flush()
+{
+    if (m_chunk.nameEnd.empty())
+    {
+        return;
+    }
+
+    const auto& c = m_chunk;
+
+    core::FlatArchiveWriter archive;
+    archive.add("record.name", c.names);
+    archive.add("record.name_end", c.nameEnd);
+    archive.add("record.key", c.keys);
+    archive.add("record.face_end", c.faceEnd);
+    archive.add("face.flags", c.flags);
+    archive.add("face.roi", c.rois);
+    archive.add("face.points", c.points);
+    archive.add("face.point_end", c.pointEnd);
+    archive.add("eye.iris", c.irises);
+    archive.add("eye.pupil", c.pupils);
+    archive.add("eye.eyelids", c.eyelids);
+    archive.add("eye.eyelid_end", c.eyelidEnd);
+
+    const auto offset = static_cast<std::uint64_t>(m_os.tellp());
+    archive.save(m_os);
+    drishti_throw_assert(m_os.good(), "FaceResultsWriter: write failed");
+
+    m_chunkOffsets.push_back(offset);
+    m_chunkSizes.push_back(static_cast<std::uint64_t>(m_os.tellp()) - offset);
+    m_chunkFirst.push_back(m_records - c.nameEnd.size());
+    m_chunk.clear();
+}
+
+void FaceResultsWriter::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_closed)
+    {
+        return;
+    }
+    m_closed = true;
+
+    flush();
+
+    core::FlatArchiveWriter index;
+    index.addScalar("record.count", static_cast<std::uint64_t>(m_records));
+    index.add("chunk.offset", m_chunkOffsets);
+    index.add("chunk.size", m_chunkSizes);
+    index.add("chunk.first", m_chunkFirst);
+
+    FaceResultsLog::Trailer trailer;
+    std::memset(&trailer, 0, sizeof(trailer));
+    std::copy(kMagic, kMagic + 4, trailer.magic);
+    trailer.version = FaceResultsLog::kVersion;
+    trailer.indexOffset = static_cast<std::uint64_t>(m_os.tellp());
+    index.save(m_os);
+    trailer.indexSize = static_cast<std::uint64_t>(m_os.tellp()) - trailer.indexOffset;
+
+    m_os.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+    m_os.close();
+    drishti_throw_assert(!m_os.fail(), "FaceResultsWriter: write failed");
+}
+
+// ((((((((((((((( FaceResultsReader )))))))))))))))
+
+FaceResultsReader::FaceResultsReader(const std::string& filename)
+{
+    std::size_t size = 0;
+    m_data = core::FlatArchive::mapFile(filename, size);
+    const auto* data = static_cast<const std::uint8_t*>(m_data.get());
+
+    FaceResultsLog::Trailer trailer;
+    drishti_throw_assert(size >= sizeof(trailer), "FaceResultsReader: truncated file " + filename);
+    std::memcpy(&trailer, data + size - sizeof(trailer), sizeof(trailer));
+    drishti_throw_assert(std::equal(kMagic, kMagic + 4, trailer.magic), "FaceResultsReader: missing index (interrupted run?) " + filename);
+    drishti_throw_assert((trailer.version >= 1) && (trailer.version <= FaceResultsLog::kVersion), "FaceResultsReader: unsupported version");
+    drishti_throw_assert((trailer.indexOffset + trailer.indexSize) <= (size - sizeof(trailer)), "FaceResultsReader: truncated index");
+
+    const core::FlatArchive index(data + trailer.indexOffset, std::size_t(trailer.indexSize), m_data);
+    m_records = static_cast<std::size_t>(index.getScalar<std::uint64_t>("record.count"));
+
+    std::size_t count = 0, sizes = 0, firsts = 0;
+    const auto* offsets = index.get<std::uint64_t>("chunk.offset", count);
+    const auto* lengths = index.get<std::uint64_t>("chunk.size", sizes);
+    const auto* first = index.get<std::uint64_t>("chunk.first", firsts);
+    drishti_throw_assert((sizes == count) && (firsts == count), "FaceResultsReader: inconsistent index");
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        drishti_throw_assert((offsets[i] + lengths[i]) <= trailer.indexOffset, "FaceResultsReader: truncated chunk");
+        m_chunks.push_back(std::make_shared<core::FlatArchive>(data + offsets[i], std::size_t(lengths[i]), m_data));
+        m_chunkFirst.push_back(static_cast<std::size_t>(first[i]));
+    }
+}
+
+std::size_t FaceResultsReader::size() const
+{
+    return m_records;
+}
+
+std::size_t FaceResultsReader::find(std::size_t record, std::size_t& local) const
+{
+    drishti_throw_assert(record < m_records, "FaceResultsReader: record out of range");
+    const auto iter = std::upper_bound(m_chunkFirst.begin(), m_chunkFirst.end(), record);
+    const std::size_t chunk = std::size_t(iter - m_chunkFirst.begin()) - 1;
+    local = record - m_chunkFirst[chunk];
+    return chunk;
+}
+
+std::string FaceResultsReader::getName(std::size_t record) const
+{
+    std::size_t local = 0;
+    const auto& chunk = *m_chunks[find(record, local)];
+
+    std::size_t count = 0, begin = 0, end = 0;
+    const char* names = chunk.get<char>("record.name", count);
+    getRange(chunk.get<std::uint64_t>("record.name_end", count), local, begin, end);
+    return std::string(names + begin, names + end);
+}
+
+std::uint64_t FaceResultsReader::getKey(std::size_t record) const
+{
+    std::size_t local = 0;
+    const auto& chunk = *m_chunks[find(record, local)];
+    if (!chunk.has("record.key"))
+    {
+        return 0;
+    }
+
+    std::size_t count = 0;
+    return chunk.get<std::uint64_t>("record.key", count)[local];
+}
+
+std::vector<FaceModel> FaceResultsReader::getFaces(std::size_t record) const
+{
+    std::size_t local = 0;
+    const auto& chunk = *m_chunks[find(record, local)];
+
+    std::size_t count = 0;
+    const auto* flags = chunk.get<std::uint8_t>("face.flags", count);
+    const auto* rois = chunk.get<FaceResultsLog::Rect>("face.roi", count);
+    const auto* points = chunk.get<FaceResultsLog::Point>("face.points", count);
+    const auto* pointEnd = chunk.get<std::uint32_t>("face.point_end", count);
+    const auto* irises = chunk.get<FaceResultsLog::Ellipse>("eye.iris", count);
+    const auto* pupils = chunk.get<FaceResultsLog::Ellipse>("eye.pupil", count);
+    const auto* eyelids = chunk.get<FaceResultsLog::Point>("eye.eyelids", count);
+    const auto* eyelidEnd = chunk.get<std::uint32_t>("eye.eyelid_end", count);
+
+    std::size_t first = 0, last = 0;
+    getRange(chunk.get<std::uint32_t>("record.face_end", count), local, first, last);
+
+    std::vector<FaceModel> faces(last - first);
+    for (std::size_t f = first; f < last; f++)
+    {
+        auto& face = faces[f - first];
+        if (flags[f] & FaceResultsLog::kRoi)
+        {
+            face.roi = cv::Rect(rois[f].x, rois[f].y, rois[f].width, rois[f].height);
+        }
+
+        std::size_t begin = 0, end = 0;
+        if (flags[f] & FaceResultsLog::kPoints)
+        {
+            getRange(pointEnd, f, begin, end);
+            FaceModel::Contour contour;
+            for (std::size_t i = begin; i < end; i++)
+            {
+                contour.emplace_back(points[i].x, points[i].y);
+            }
+            face.points = contour;
+        }
+
+        core::Field<eye::EyeModel>* eyes[2] = { &face.eyeFullR, &face.eyeFullL };
+        const int eyeFlags[2] = { FaceResultsLog::kEyeRight, FaceResultsLog::kEyeLeft };
+        for (std::size_t i = 0; i < 2; i++)
+        {
+            if (flags[f] & eyeFlags[i])
+            {
+                const std::size_t e = f * 2 + i;
+                eye::EyeModel eye;
+                eye.irisEllipse = toRotatedRect(irises[e]);
+                eye.pupilEllipse = toRotatedRect(pupils[e]);
+                getRange(eyelidEnd, e, begin, end);
+                for (std::size_t j = begin; j < end; j++)
+                {
+                    eye.eyelids.emplace_back(eyelids[j].x, eyelids[j].y);
+                }
+                *eyes[i] = eye;
+            }
+        }
+    }
+    return faces;
+}
+
+DRISHTI_FACE_NAMESPACE_END
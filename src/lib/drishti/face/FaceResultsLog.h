@@ -0,0 +1,161 @@
+/*! -*-c++-*-
+  @file   FaceResultsLog.h
+  @author David Hirvonen
+  @brief  Declaration of a chunked binary columnar log of per image face and eye results.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_face_FaceResultsLog_h__
+#define __drishti_face_FaceResultsLog_h__
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/face/Face.h"
+#include "drishti/core/FlatArchive.h"
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+/*
+ * One file for a whole batch run (instead of one JSON file per image):
+ *
+ *   Chunk[] : core::FlatArchive with the columns of up to recordsPerChunk images
+ *   Index   : core::FlatArchive with the offset, size and first record of each chunk
+ *   Trailer : magic "DRFR", version, index offset and size (64 bytes)
+ *
+ * A record is an image name and its faces.  Variable length columns are stored as values plus
+ * exclusive end offsets ("<column>_end", one per parent), eyes are stored as 2 per face (right,
+ * left).  Chunks can be used in place from a memory mapping of the file:
+ *
+ *   record.name, record.name_end (char, uint64)  : image names
+ *   record.key (uint64)                           : content key, 0 if none (version 2)
+ *   record.face_end (uint32)                      : faces of each record
+ *   face.flags (uint8)                            : FaceResultsLog::Flags
+ *   face.roi (Rect)                               : detection
+ *   face.points, face.point_end (Point, uint32)   : landmarks
+ *   eye.iris, eye.pupil (Ellipse)                 : eye models
+ *   eye.eyelids, eye.eyelid_end (Point, uint32)   : eyelid contours
+ *
+ * The writer is safe to call from multiple threads (records are stored in call order), the
+ * index is written by close(), so the file of an interrupted run has no index.
+ */
+
+struct FaceResultsLog
+{
+    static const std::uint32_t kVersion = 2; // 2: record.key
+
+    enum Flags
+    {
+        kRoi = 1,
+        kPoints = 2,
+        kEyeRight = 4,
+        kEyeLeft = 8
+    };
+
+    struct Rect
+    {
+        std::int32_t x, y, width, height;
+    };
+
+    struct Point
+    {
+        float x, y;
+    };
+
+    struct Ellipse
+    {
+        float cx, cy, width, height, angle; // degrees (cv::RotatedRect)
+    };
+
+    struct Trailer
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t indexOffset;
+        std::uint64_t indexSize;
+        std::uint8_t reserved[40];
+    };
+};
+
+class FaceResultsWriter
+{
+public:
+    FaceResultsWriter(const std::string& filename, std::size_t recordsPerChunk = 4096);
+    ~FaceResultsWriter(); // close()
+
+    // The key identifies the content and settings of the record (see core::hashImage()):
+    void operator()(const std::string& name, const std::vector<FaceModel>& faces, std::uint64_t key = 0);
+
+    // Flush the last chunk and write the index (no further records can be added):
+    void close();
+
+    std::size_t size() const;
+
+protected:
+    struct Chunk
+    {
+        void clear();
+
+        std::vector<char> names;
+        std::vector<std::uint64_t> nameEnd;
+        std::vector<std::uint64_t> keys;
+        std::vector<std::uint32_t> faceEnd;
+
+        std::vector<std::uint8_t> flags;
+        std::vector<FaceResultsLog::Rect> rois;
+        std::vector<FaceResultsLog::Point> points;
+        std::vector<std::uint32_t> pointEnd;
+
+        std::vector<FaceResultsLog::Ellipse> irises, pupils;
+        std::vector<FaceResultsLog::Point> eyelids;
+        std::vector<std::uint32_t> eyelidEnd;
+    };
+
+    void flush();
+
+    mutable std::mutex m_mutex;
+    std::ofstream m_os;
+    std::size_t m_recordsPerChunk = 4096;
+    std::size_t m_records = 0;
+    bool m_closed = false;
+
+    Chunk m_chunk;
+    std::vector<std::uint64_t> m_chunkOffsets, m_chunkSizes, m_chunkFirst;
+};
+
+class FaceResultsReader
+{
+public:
+    FaceResultsReader(const std::string& filename);
+
+    std::size_t size() const; // records
+
+    std::string getName(std::size_t record) const;
+    std::uint64_t getKey(std::size_t record) const; // 0 for version 1 logs
+    std::vector<FaceModel> getFaces(std::size_t record) const;
+
+    // Columns of each chunk (see the layout above), i.e., for analytics:
+    std::size_t getChunkCount() const { return m_chunks.size(); }
+    const core::FlatArchive& getChunk(std::size_t i) const { return *m_chunks[i]; }
+    std::size_t getChunkFirst(std::size_t i) const { return m_chunkFirst[i]; }
+
+protected:
+    std::size_t find(std::size_t record, std::size_t& local) const;
+
+    std::shared_ptr<const void> m_data;
+    std::vector<std::shared_ptr<core::FlatArchive>> m_chunks;
+    std::vector<std::size_t> m_chunkFirst;
+    std::size_t m_records = 0;
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceResultsLog_h__
@@ -12,8 +12,13 @@
 #include "drishti/core/make_unique.h"
 #include "drishti/core/hungarian.h"
 
+#include <numeric>
+#include <unordered_map>
+
 DRISHTI_FACE_NAMESPACE_BEGIN
 
+static const double kGated = 1e6; // cost of pairs beyond the threshold (meters)
+
 struct FaceTracker::Impl
 {
     using FaceTrack = std::pair<drishti::face::FaceModel, FaceTracker::TrackInfo>;
@@ -34,41 +39,27 @@ struct FaceTracker::Impl
             // Initialize tracks:
             for (const auto& f : facesIn)
             {
-                m_tracks.emplace_back(f, TrackInfo(m_id++));
+                m_tracks.emplace_back(f, createTrackInfo(f));
             }
         }
         else
         {
-            std::unordered_map<int, int> direct_assignment;
-            std::unordered_map<int, int> reverse_assignment;
-            std::vector<std::vector<double>> C;
-
-            if (facesIn.size())
-            {
-                C = std::vector<std::vector<double>>(m_tracks.size(), std::vector<double>(facesIn.size()));
-                for (int i = 0; i < m_tracks.size(); i++)
-                {
-                    for (int j = 0; j < facesIn.size(); j++)
-                    {
-                        C[i][j] = cv::norm(*m_tracks[i].first.eyesCenter - *facesIn[j].eyesCenter);
-                    }
-                }
-                core::MinimizeLinearAssignment(C, direct_assignment, reverse_assignment);
-            }
+            std::vector<int> assignment; // face -> track (or -1)
+            assign(facesIn, assignment);
 
             std::vector<std::uint8_t> hits(m_tracks.size(), 0);
-            for (const auto& m : direct_assignment)
+            for (int j = 0; j < assignment.size(); j++)
             {
                 // Create a new track, or update an old track:
-                if (C[m.first][m.second] > m_costThreshold)
+                if (assignment[j] < 0)
                 {
-                    m_tracks.emplace_back(facesIn[m.second], TrackInfo(m_id++));
+                    m_tracks.emplace_back(facesIn[j], createTrackInfo(facesIn[j]));
                 }
                 else
                 {
-                    m_tracks[m.first].second.hit();
-                    m_tracks[m.first].first = facesIn[m.second];
-                    hits[m.first] = 1;
+                    m_tracks[assignment[j]].second.hit();
+                    correct(m_tracks[assignment[j]], facesIn[j]);
+                    hits[assignment[j]] = 1;
                 }
             }
 
@@ -77,6 +68,7 @@ struct FaceTracker::Impl
                 if (!hits[i])
                 {
                     m_tracks[i].second.miss();
+                    coast(m_tracks[i]);
                 }
             }
 
@@ -93,13 +85,177 @@ struct FaceTracker::Impl
         });
     }
 
+    /*
+     * Pairs beyond m_costThreshold can never be associated, so they are gated before the
+     * assignment.  The remaining (sparse) graph is decomposed into connected components,
+     * which are solved independently: single pairs and single track (or face) components
+     * directly, and the rest with the Hungarian solver on the (small) dense sub problem.
+     */
+
+    void assign(const FaceModelVec& faces, std::vector<int>& assignment)
+    {
+        const int rows = int(m_tracks.size()), cols = int(faces.size());
+        assignment.assign(cols, -1);
+
+        // Flat gated cost buffer and union-find over the [tracks, faces] nodes:
+        m_cost.resize(rows * cols);
+        m_parent.resize(rows + cols);
+        m_linked.assign(rows + cols, 0);
+        std::iota(m_parent.begin(), m_parent.end(), 0);
+        for (int i = 0; i < rows; i++)
+        {
+            const cv::Point3f track = predict(m_tracks[i]);
+            for (int j = 0; j < cols; j++)
+            {
+                const double cost = cv::norm(track - *faces[j].eyesCenter);
+                m_cost[i * cols + j] = (cost <= m_costThreshold) ? cost : kGated;
+                if (cost <= m_costThreshold)
+                {
+                    m_parent[find(i)] = find(rows + j);
+                    m_linked[i] = m_linked[rows + j] = 1;
+                }
+            }
+        }
+
+        // Gather the components with at least one edge:
+        std::unordered_map<int, std::pair<std::vector<int>, std::vector<int>>> components;
+        for (int i = 0; i < rows; i++)
+        {
+            if (m_linked[i])
+            {
+                components[find(i)].first.push_back(i);
+            }
+        }
+        for (int j = 0; j < cols; j++)
+        {
+            if (m_linked[rows + j])
+            {
+                components[find(rows + j)].second.push_back(j);
+            }
+        }
+
+        for (const auto& entry : components)
+        {
+            const auto& tracks = entry.second.first;
+            const auto& faceIds = entry.second.second;
+            if ((tracks.size() == 1) || (faceIds.size() == 1))
+            {
+                // Trivial component: the cheapest pair is optimal
+                int bestTrack = tracks.front(), bestFace = faceIds.front();
+                for (int i : tracks)
+                {
+                    for (int j : faceIds)
+                    {
+                        if (m_cost[i * cols + j] < m_cost[bestTrack * cols + bestFace])
+                        {
+                            bestTrack = i;
+                            bestFace = j;
+                        }
+                    }
+                }
+                assignment[bestFace] = bestTrack;
+            }
+            else
+            {
+                std::vector<std::vector<double>> C(tracks.size(), std::vector<double>(faceIds.size()));
+                for (int i = 0; i < tracks.size(); i++)
+                {
+                    for (int j = 0; j < faceIds.size(); j++)
+                    {
+                        C[i][j] = m_cost[tracks[i] * cols + faceIds[j]];
+                    }
+                }
+
+                std::unordered_map<int, int> direct_assignment, reverse_assignment;
+                core::MinimizeLinearAssignment(C, direct_assignment, reverse_assignment);
+                for (const auto& m : direct_assignment)
+                {
+                    if (C[m.first][m.second] < kGated)
+                    {
+                        assignment[faceIds[m.second]] = tracks[m.first];
+                    }
+                }
+            }
+        }
+    }
+
+    // ((( motion model )))
+
+    static cv::Point2f getAnchor(const FaceModel& face)
+    {
+        const cv::Rect& roi = face.roi.value;
+        return { roi.x + roi.width * 0.5f, roi.y + roi.height * 0.5f };
+    }
+
+    TrackInfo createTrackInfo(const FaceModel& face)
+    {
+        TrackInfo info(m_id++);
+        info.motion.position = *face.eyesCenter;
+        return info;
+    }
+
+    cv::Point3f predict(const FaceTrack& track) const
+    {
+        const auto& motion = track.second.motion;
+        return m_doPrediction ? (motion.position + cv::Point3f(motion.velocity)) : *track.first.eyesCenter;
+    }
+
+    // Alpha-beta update with a matched detection:
+    void correct(FaceTrack& track, const FaceModel& face)
+    {
+        auto& info = track.second;
+        const cv::Point3f residual = *face.eyesCenter - predict(track);
+        info.motion.position = predict(track) + residual * m_alpha;
+        info.motion.velocity += cv::Vec3f(residual * m_beta);
+
+        if (face.roi.has && track.first.roi.has)
+        {
+            const cv::Point2f predicted = getAnchor(track.first) + cv::Point2f(info.imageVelocity);
+            info.imageVelocity += cv::Vec2f(getAnchor(face) - predicted) * m_beta;
+        }
+
+        track.first = face;
+    }
+
+    // Move a missed track along its (decaying) velocity:
+    void coast(FaceTrack& track)
+    {
+        auto& info = track.second;
+        if (m_doPrediction)
+        {
+            info.motion.position = predict(track);
+            track.first += cv::Point2f(info.imageVelocity);
+            track.first.eyesCenter = info.motion.position;
+        }
+        info.motion.velocity *= m_damping;
+        info.imageVelocity *= m_damping;
+    }
+
+    int find(int i)
+    {
+        while (m_parent[i] != i)
+        {
+            i = m_parent[i] = m_parent[m_parent[i]]; // path halving
+        }
+        return i;
+    }
+
     float m_costThreshold = 0.15; // meters
     std::size_t m_minTrackHits = 3;
     std::size_t m_maxTrackMisses = 3;
 
     std::size_t m_id = 0;
 
+    bool m_doPrediction = true;
+    float m_alpha = 0.85f;
+    float m_beta = 0.5f;
+    float m_damping = 0.8f;
+
     FaceTrackVec m_tracks;
+
+    std::vector<double> m_cost; // gated track x face costs (see assign())
+    std::vector<int> m_parent;  // union-find forest for the components
+    std::vector<std::uint8_t> m_linked; // nodes with at least one gated pair
 };
 
 FaceTracker::FaceTracker(float costThreshold, std::size_t minTrackHits, std::size_t maxTrackMisses)
@@ -109,6 +265,18 @@ FaceTracker::FaceTracker(float costThreshold, std::size_t minTrackHits, std::siz
 
 FaceTracker::~FaceTracker() = default;
 
+void FaceTracker::setDoPrediction(bool flag)
+{
+    m_impl->m_doPrediction = flag;
+}
+
+void FaceTracker::setMotionGains(float alpha, float beta, float damping)
+{
+    m_impl->m_alpha = alpha;
+    m_impl->m_beta = beta;
+    m_impl->m_damping = damping;
+}
+
 void FaceTracker::operator()(const FaceModelVec& facesIn, FaceTrackVec& facesOut)
 {
     m_impl->update(facesIn, facesOut);
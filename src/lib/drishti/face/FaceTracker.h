@@ -13,6 +13,7 @@
 
 #include "drishti/face/drishti_face.h"
 #include "drishti/face/Face.h" // FaceModel.h
+#include "drishti/geometry/DynamicObject.h"
 
 #include <memory>
 
@@ -50,6 +51,10 @@ public:
         std::size_t age = 0;
         std::size_t hits = 0;   // consecutive hits
         std::size_t misses = 0; // consecutive misses
+
+        // Constant velocity motion model (per frame units), see FaceTracker::setDoPrediction():
+        geometry::DynamicObject3D motion; // eyes center (meters)
+        cv::Vec2f imageVelocity;          // roi center (pixels)
     };
 
     using FaceTrack = std::pair<drishti::face::FaceModel, TrackInfo>;
@@ -62,6 +67,14 @@ public:
     ~FaceTracker();
     void operator()(const FaceModelVec& facesIn, FaceTrackVec& facesOut);
 
+    // Associate detections with the predicted track positions and coast missed tracks along
+    // their velocity, so their (predicted) models can seed the next regression:
+    void setDoPrediction(bool flag);
+
+    // Alpha-beta filter gains for position and velocity updates, and the per frame velocity
+    // decay for missed tracks:
+    void setMotionGains(float alpha, float beta, float damping = 0.8f);
+
 protected:
     std::unique_ptr<Impl> m_impl;
 };
@@ -9,9 +9,11 @@
 */
 
 #include "drishti/face/gpu/EyeFilter.h"
+#include "drishti/face/gpu/TemporalMeanProc.h"
 #include "drishti/geometry/motion.h"
 #include "drishti/eye/IrisNormalizer.h"
 #include "drishti/core/make_unique.h"
+#include "drishti/core/MemoryUsage.h"
 #include "drishti/core/scope_guard.h"
 
 #include "ogles_gpgpu/common/proc/transform.h"
@@ -19,10 +21,9 @@
 #include "ogles_gpgpu/common/proc/highpass.h"
 #include "ogles_gpgpu/common/proc/diff.h"
 #include "ogles_gpgpu/common/proc/gauss_opt.h"
-#include "ogles_gpgpu/common/proc/fifo.h"
-#include "ogles_gpgpu/common/proc/fir3.h"
 #include "ogles_gpgpu/common/common_includes.h"
 
+#include <algorithm>
 #include <memory>
 
 BEGIN_OGLES_GPGPU
@@ -37,11 +38,11 @@ EyeFilter::EyeFilter(const Size2d& sizeOut, Mode mode, float cutoff, int history
 
     transformProc.setInterpolation(TransformProc::BICUBIC);
 
-    // Add a fifo proc for GPU sliding window:
-    fifoProc = drishti::core::make_unique<ogles_gpgpu::FifoProc>(history);
-    transformProc.add(fifoProc.get());
+    // The transform renders straight into a ring of history textures (GPU sliding window):
+    historyRing = drishti::core::make_unique<TextureRing>((mode == kMean3) ? std::max(history, 3) : history);
+    transformProc.setHistory(historyRing.get());
 
-    procPasses = { &transformProc, fifoProc.get() };
+    procPasses = { &transformProc };
 
     switch (mode)
     {
@@ -57,13 +58,13 @@ EyeFilter::EyeFilter(const Size2d& sizeOut, Mode mode, float cutoff, int history
 
         case kMean3:
         {
-            mean3Proc = drishti::core::make_unique<ogles_gpgpu::Fir3Proc>();
-            mean3Proc->setWeights({ 0.33f, 0.33f, 0.33f });
+            // Taps 1 and 2 are sampled from the ring in the same pass:
+            mean3Proc = drishti::core::make_unique<TemporalMeanProc>();
+            mean3Proc->setWeights(0.33f, 0.33f, 0.33f);
+            mean3Proc->setHistory(historyRing.get());
             procPasses.push_back(mean3Proc.get());
 
-            fifoProc->addWithDelay(mean3Proc.get(), 0, 0);
-            fifoProc->addWithDelay(mean3Proc.get(), 1, 1);
-            fifoProc->addWithDelay(mean3Proc.get(), 2, 2);
+            transformProc.add(mean3Proc.get());
 
             lastProc = mean3Proc.get();
         }
@@ -83,21 +84,32 @@ EyeFilter::~EyeFilter()
     procPasses.clear();
 }
 
+std::size_t EyeFilter::getTextureMemoryUsage() const
+{
+    std::size_t bytes = 0;
+    for (auto* proc : procPasses)
+    {
+        bytes += drishti::core::getTextureMemoryUsage(proc->getOutFrameW(), proc->getOutFrameH());
+    }
+    if (historyRing)
+    {
+        bytes += drishti::core::getTextureMemoryUsage(historyRing->getWidth(), historyRing->getHeight(), historyRing->getSize());
+    }
+    return bytes;
+}
+
 void EyeFilter::dump(std::vector<cv::Mat4b>& frames, std::vector<EyePair>& eyes, int n, bool getImage)
 {
-    // FifoProc::operator[] will preserve temporal ordering
-    auto length = fifoProc->getBufferCount();
-    n = std::min(n, static_cast<int>(length));
+    // Ring slots are addressed by delay, such that frames[0] is newest
+    n = std::min(n, std::min(historyRing->getCount(), static_cast<int>(m_eyeHistory.size())));
     frames.resize(n);
     eyes.resize(n);
     for (int i = 0; i < n; i++)
     {
         if (getImage)
         {
-            // Pull frames in reverse order such that frames[0] is newest
-            auto* filter = (*fifoProc)[length - i - 1];
-            frames[i].create(filter->getOutFrameH(), filter->getOutFrameW());
-            filter->getResultData(frames[i].ptr<uint8_t>());
+            frames[i].create(historyRing->getHeight(), historyRing->getWidth());
+            historyRing->read(i, frames[i].ptr<uint8_t>());
         }
 
         cv::Matx33f N = transformation::denormalize(frames[i].size());
@@ -150,13 +162,13 @@ int EyeFilter::render(int position)
             convert(m_eyes[i], region);
             transformProc.addCrop(region);
         }
-    }
 
-    // Maintain eye history queue of size == 3
-    m_eyeHistory.push_front(m_eyes);
-    if (m_eyeHistory.size() > m_history)
-    {
-        m_eyeHistory.pop_back();
+        // The ring only advances on frames with crops, keep the eye history in step with it:
+        m_eyeHistory.push_front(m_eyes);
+        if (m_eyeHistory.size() > historyRing->getSize())
+        {
+            m_eyeHistory.pop_back();
+        }
     }
 
     getInputFilter()->process(position);
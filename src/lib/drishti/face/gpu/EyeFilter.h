@@ -18,12 +18,12 @@ class GaussOptProc;
 class LowPassFilterProc;
 class LowPassFilterProc;
 class DiffProc;
-class FifoProc;
-class Fir3Proc;
+class TemporalMeanProc;
 END_OGLES_GPGPU
 
 #include "drishti/face/gpu/FaceStabilizer.h"
 #include "drishti/face/gpu/MultiTransformProc.h"
+#include "drishti/face/gpu/TextureRing.h"
 #include "drishti/face/Face.h"
 #include "drishti/eye/gpu/EyeWarp.h"
 
@@ -97,6 +97,9 @@ public:
 
     void renderIris();
 
+    // Estimated texture memory of the passes and the eye crop history:
+    std::size_t getTextureMemoryUsage() const;
+
 protected:
     int m_history = 3;
 
@@ -111,9 +114,9 @@ protected:
 
     MultiTransformProc transformProc;
 
-    std::unique_ptr<FifoProc> fifoProc; // maintain buffer
+    std::unique_ptr<TextureRing> historyRing; // eye crops are rendered in place, newest first
     std::unique_ptr<LowPassFilterProc> lowPassProc;
-    std::unique_ptr<Fir3Proc> mean3Proc;
+    std::unique_ptr<TemporalMeanProc> mean3Proc;
 
     ProcInterface* lastProc = nullptr;
     ProcInterface* firstProc = nullptr;
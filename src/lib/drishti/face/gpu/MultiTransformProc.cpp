@@ -14,38 +14,128 @@
 
 BEGIN_OGLES_GPGPU
 
-void MultiTransformProc::renderRegion(const Rect2d& dstRoiPix, const Mat44f& H)
+static const int kVertexSize = 6;
+
+/*
+ * Each crop used to be drawn as the full input frame warped by its own transform uniform and
+ * clipped by glScissor, i.e., one draw call (and a full frame of rasterized vertices) per crop.
+ * Here the destination roi itself is emitted as two triangles with the texture coordinates
+ * mapped back through the inverse warp, so all crops share one buffer and one draw call.  The
+ * warp maps input pixels (x, y, 0, 1) to clip space, so its (x, y, w) rows and columns form a
+ * 3x3 homography G.  A projective G is reproduced exactly by the GPU's perspective correct
+ * interpolation: texture coordinates are attached at the roi corners and each corner's w is
+ * set to the reciprocal of the G^-1 denominator.
+ */
+
+GLuint MultiTransformProc::getOutputTexId() const
+{
+    return (m_history && m_history->getCount()) ? (*m_history)[0] : TransformProc::getOutputTexId();
+}
+
+MultiTransformProc::~MultiTransformProc()
+{
+    if (m_vbo)
+    {
+        glDeleteBuffers(1, &m_vbo);
+    }
+}
+
+bool MultiTransformProc::addRegion(const Rect2d& dstRoiPix, const Mat44f& H)
 {
-    // Limit warping to desired eye crop region
-    glScissor(dstRoiPix.x, dstRoiPix.y, dstRoiPix.width, dstRoiPix.height);
+    // Column major: element (row, col) is data[col][row]
+    const auto& M = H.data;
+    const cv::Matx33f G(M[0][0], M[1][0], M[3][0], M[0][1], M[1][1], M[3][1], M[0][3], M[1][3], M[3][3]);
+
+    bool ok = false;
+    const cv::Matx33f Gi = G.inv(cv::DECOMP_LU, &ok);
+    if (!ok)
+    {
+        return false;
+    }
+
+    const float x0 = dstRoiPix.x, y0 = dstRoiPix.y;
+    const float x1 = x0 + dstRoiPix.width, y1 = y0 + dstRoiPix.height;
+    const cv::Point2f corners[4] = { { x0, y0 }, { x1, y0 }, { x0, y1 }, { x1, y1 } };
+
+    GLfloat quad[4][kVertexSize];
+    for (int i = 0; i < 4; i++)
+    {
+        // Output pixel -> normalized device coordinates -> input pixel:
+        const cv::Vec3f ndc(2.f * corners[i].x / float(outFrameW) - 1.f, 2.f * corners[i].y / float(outFrameH) - 1.f, 1.f);
+        const cv::Vec3f p = Gi * ndc;
+        if (p[2] <= 0.f)
+        {
+            return false; // roi corner maps behind the image plane
+        }
+
+        const float w = 1.f / p[2];
+        quad[i][0] = ndc[0] * w;
+        quad[i][1] = ndc[1] * w;
+        quad[i][2] = 0.f;
+        quad[i][3] = w;
+        quad[i][4] = (p[0] * w) / float(inFrameW);
+        quad[i][5] = (p[1] * w) / float(inFrameH);
+    }
 
-    glUniformMatrix4fv(shParamUTransform, 1, 0, (GLfloat*)&H.data[0]);
-    Tools::checkGLErr(getProcName(), "MultiTransformProc::renderEye() : glUniformMatrix4fv()");
+    for (const auto& i : { 0, 1, 2, 2, 1, 3 })
+    {
+        m_vertices.insert(m_vertices.end(), quad[i], quad[i] + kVertexSize);
+    }
 
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, OGLES_GPGPU_QUAD_VERTICES);
-    Tools::checkGLErr(getProcName(), "MultiTransformProc::renderEye() : glDrawArrays()");
+    return true;
 }
 
 void MultiTransformProc::filterRenderDraw()
 {
-    // TODO: override the main set coords method:
-    cv::Rect roi(0, 0, inFrameW, inFrameH);
-    cv::Point2f tl = roi.tl(), br = roi.br(), tr(br.x, tl.y), bl(tl.x, br.y);
-    std::vector<cv::Point2f> vertices{ tl, tr, bl, br };
+    m_vertices.clear();
+    for (const auto& crop : m_crops)
+    {
+        addRegion(crop.roi, crop.H);
+    }
+    m_crops.clear();
 
-    glEnableVertexAttribArray(shParamAPos);
-    glVertexAttribPointer(shParamAPos, 2, GL_FLOAT, GL_FALSE, 0, &vertices[0]);
-    Tools::checkGLErr(getProcName(), "FacePainter::renderFaces() : glVertexAttribPointer()");
+    if (m_vertices.empty())
+    {
+        return;
+    }
 
-    glEnable(GL_SCISSOR_TEST);
-    for (int i = 0; i < m_crops.size(); i++)
+    if (m_history)
     {
-        renderRegion(m_crops[i].roi, m_crops[i].H);
-        Tools::checkGLErr(getProcName(), "render draw");
+        // Frames without crops leave the history (and the output texture) unchanged:
+        m_history->allocate(outFrameW, outFrameH);
+        m_history->advance();
+        m_history->bind();
     }
-    glDisable(GL_SCISSOR_TEST);
 
-    m_crops.clear();
+    if (!m_vbo)
+    {
+        glGenBuffers(1, &m_vbo);
+    }
+
+    const GLsizeiptr size = static_cast<GLsizeiptr>(m_vertices.size() * sizeof(GLfloat));
+
+    // Orphan the previous frame's storage, so the upload doesn't wait for draws still reading it:
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, m_vertices.data());
+    Tools::checkGLErr(getProcName(), "MultiTransformProc::filterRenderDraw() : glBufferSubData()");
+
+    // Vertices are already in clip space:
+    static const GLfloat identity[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+    glUniformMatrix4fv(shParamUTransform, 1, 0, identity);
+
+    const GLsizei stride = kVertexSize * sizeof(GLfloat);
+    glEnableVertexAttribArray(shParamAPos);
+    glVertexAttribPointer(shParamAPos, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(0));
+    glEnableVertexAttribArray(shParamATexCoord);
+    glVertexAttribPointer(shParamATexCoord, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(4 * sizeof(GLfloat)));
+    Tools::checkGLErr(getProcName(), "MultiTransformProc::filterRenderDraw() : glVertexAttribPointer()");
+
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(m_vertices.size() / kVertexSize));
+    Tools::checkGLErr(getProcName(), "MultiTransformProc::filterRenderDraw() : glDrawArrays()");
+
+    // The other filters use client side vertex arrays:
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 END_OGLES_GPGPU
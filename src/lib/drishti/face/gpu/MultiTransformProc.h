@@ -11,6 +11,8 @@
 #ifndef __drishti_face_gpu_MultiTransformProc_h__
 #define __drishti_face_gpu_MultiTransformProc_h__
 
+#include "drishti/face/gpu/TextureRing.h"
+
 #include "ogles_gpgpu/common/proc/transform.h"
 
 BEGIN_OGLES_GPGPU
@@ -25,9 +27,9 @@ class MultiTransformProc : public ogles_gpgpu::TransformProc
 {
 public:
     MultiTransformProc() {}
-    virtual ~MultiTransformProc() {}
+    virtual ~MultiTransformProc();
 
-    void renderRegion(const Rect2d& dstRoiPix, const Mat44f& Heye);
+    // All crops are packed into one vertex buffer and drawn in a single call:
     virtual void filterRenderDraw();
 
     void addCrop(const MappedTextureRegion& crop)
@@ -35,8 +37,22 @@ public:
         m_crops.push_back(crop);
     }
 
+    // Render each frame with crops into the next slot of the ring (not owned) instead of the FBO:
+    void setHistory(TextureRing* history)
+    {
+        m_history = history;
+    }
+
+    virtual GLuint getOutputTexId() const;
+
 protected:
+    // Append the two triangles covering the crop's destination roi (returns false if degenerate):
+    bool addRegion(const Rect2d& dstRoiPix, const Mat44f& H);
+
     std::vector<MappedTextureRegion> m_crops;
+    std::vector<GLfloat> m_vertices; // { x, y, z, w, s, t } clip space position + texture coordinate
+    GLuint m_vbo = 0;
+    TextureRing* m_history = nullptr;
 };
 
 END_OGLES_GPGPU
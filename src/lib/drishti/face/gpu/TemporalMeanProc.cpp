@@ -0,0 +1,65 @@
+/*! -*-c++-*-
+  @file   face/gpu/TemporalMeanProc.cpp
+  @author David Hirvonen
+  @brief  Weighted mean of the three newest TextureRing slots in one shader pass.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/gpu/TemporalMeanProc.h"
+#include "drishti/face/gpu/TextureRing.h"
+
+BEGIN_OGLES_GPGPU
+
+static const GLuint kHistoryUnit1 = 2;
+static const GLuint kHistoryUnit2 = 3;
+
+// clang-format off
+const char * TemporalMeanProc::fshaderTemporalMeanSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision mediump float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ uniform sampler2D uHistory1;
+ uniform sampler2D uHistory2;
+ uniform vec3 uWeights;
+ void main()
+ {
+     vec4 value = texture2D(uInputTex, vTexCoord) * uWeights.x;
+     value += texture2D(uHistory1, vTexCoord) * uWeights.y;
+     value += texture2D(uHistory2, vTexCoord) * uWeights.z;
+     gl_FragColor = value;
+ });
+// clang-format on
+
+void TemporalMeanProc::getUniforms()
+{
+    shParamUHistory1 = shader->getParam(UNIF, "uHistory1");
+    shParamUHistory2 = shader->getParam(UNIF, "uHistory2");
+    shParamUWeights = shader->getParam(UNIF, "uWeights");
+}
+
+void TemporalMeanProc::setUniforms()
+{
+    // Without a history every tap samples the input:
+    const GLuint history1 = history ? (*history)[1] : texId;
+    const GLuint history2 = history ? (*history)[2] : texId;
+
+    glActiveTexture(GL_TEXTURE0 + kHistoryUnit1);
+    glBindTexture(GL_TEXTURE_2D, history1);
+    glUniform1i(shParamUHistory1, kHistoryUnit1);
+
+    glActiveTexture(GL_TEXTURE0 + kHistoryUnit2);
+    glBindTexture(GL_TEXTURE_2D, history2);
+    glUniform1i(shParamUHistory2, kHistoryUnit2);
+
+    glActiveTexture(GL_TEXTURE0 + texUnit);
+
+    glUniform3fv(shParamUWeights, 1, weights);
+}
+
+END_OGLES_GPGPU
@@ -0,0 +1,65 @@
+/*! -*-c++-*-
+  @file   face/gpu/TemporalMeanProc.h
+  @author David Hirvonen
+  @brief  Weighted mean of the three newest TextureRing slots in one shader pass.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_face_gpu_TemporalMeanProc_h__
+#define __drishti_face_gpu_TemporalMeanProc_h__
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+BEGIN_OGLES_GPGPU
+
+class TextureRing;
+
+/*
+ * The input texture is the newest frame, the two previous frames are sampled directly from
+ * the history ring, so the filter needs no FIFO copies of its taps.
+ */
+
+class TemporalMeanProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    TemporalMeanProc() = default;
+
+    virtual const char* getProcName()
+    {
+        return "TemporalMeanProc";
+    }
+
+    void setWeights(GLfloat w0, GLfloat w1, GLfloat w2)
+    {
+        weights[0] = w0;
+        weights[1] = w1;
+        weights[2] = w2;
+    }
+
+    // History is sampled at delays 1 and 2 at the time of render():
+    void setHistory(const TextureRing* value) { history = value; }
+
+private:
+    virtual const char* getFragmentShaderSource()
+    {
+        return fshaderTemporalMeanSrc;
+    }
+    virtual void getUniforms();
+    virtual void setUniforms();
+
+    static const char* fshaderTemporalMeanSrc; // fragment shader source
+
+    GLfloat weights[3] = { 1.f / 3.f, 1.f / 3.f, 1.f / 3.f }; // newest first
+    const TextureRing* history = nullptr;
+
+    GLint shParamUHistory1;
+    GLint shParamUHistory2;
+    GLint shParamUWeights;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_face_gpu_TemporalMeanProc_h__
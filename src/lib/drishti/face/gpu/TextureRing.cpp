@@ -0,0 +1,108 @@
+/*! -*-c++-*-
+  @file   face/gpu/TextureRing.cpp
+  @author David Hirvonen
+  @brief  Ring buffer of framebuffer texture attachments for temporal history.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/gpu/TextureRing.h"
+
+#include <algorithm>
+
+BEGIN_OGLES_GPGPU
+
+TextureRing::TextureRing(int size)
+    : m_textures(std::max(size, 1), 0)
+    , m_framebuffers(std::max(size, 1), 0)
+{
+}
+
+TextureRing::~TextureRing()
+{
+    release();
+}
+
+void TextureRing::release()
+{
+    if (m_framebuffers.front())
+    {
+        glDeleteFramebuffers(static_cast<GLsizei>(m_framebuffers.size()), m_framebuffers.data());
+        glDeleteTextures(static_cast<GLsizei>(m_textures.size()), m_textures.data());
+        std::fill(m_framebuffers.begin(), m_framebuffers.end(), 0);
+        std::fill(m_textures.begin(), m_textures.end(), 0);
+    }
+    m_count = 0;
+}
+
+void TextureRing::allocate(int width, int height)
+{
+    if (m_framebuffers.front() && (width == m_width) && (height == m_height))
+    {
+        return;
+    }
+
+    release();
+
+    m_width = width;
+    m_height = height;
+    m_index = 0;
+
+    // Allocation may happen inside a filter's render pass, so its texture binding is restored:
+    GLint binding = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &binding);
+
+    glGenTextures(static_cast<GLsizei>(m_textures.size()), m_textures.data());
+    glGenFramebuffers(static_cast<GLsizei>(m_framebuffers.size()), m_framebuffers.data());
+    for (std::size_t i = 0; i < m_textures.size(); i++)
+    {
+        glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_textures[i], 0);
+        Tools::checkGLErr("TextureRing", "allocate()");
+    }
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(binding));
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void TextureRing::advance()
+{
+    m_index = (m_index + 1) % getSize();
+    m_count = std::min(m_count + 1, getSize());
+}
+
+void TextureRing::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[m_index]);
+    glViewport(0, 0, m_width, m_height);
+}
+
+int TextureRing::slot(int delay) const
+{
+    delay = std::max(std::min(delay, m_count - 1), 0);
+    return (m_index + getSize() - delay) % getSize();
+}
+
+GLuint TextureRing::operator[](int delay) const
+{
+    return m_textures[slot(delay)];
+}
+
+void TextureRing::read(int delay, GLubyte* pixels) const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[slot(delay)]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    Tools::checkGLErr("TextureRing", "read()");
+}
+
+END_OGLES_GPGPU
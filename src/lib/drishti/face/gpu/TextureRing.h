@@ -0,0 +1,69 @@
+/*! -*-c++-*-
+  @file   face/gpu/TextureRing.h
+  @author David Hirvonen
+  @brief  Ring buffer of framebuffer texture attachments for temporal history.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_face_gpu_TextureRing_h__
+#define __drishti_face_gpu_TextureRing_h__
+
+#include "ogles_gpgpu/common/common_includes.h"
+
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+/*
+ * A producer renders each frame straight into the next slot and the history advances by
+ * index, so keeping the last N frames costs no texture copies.  Slots are addressed by delay:
+ * ring[0] is the newest frame and ring[n] the frame written n advances earlier.  Delays past
+ * the written history are clamped to the oldest slot.  All calls must be made from the GL thread.
+ */
+
+class TextureRing
+{
+public:
+    explicit TextureRing(int size);
+    ~TextureRing();
+
+    TextureRing(const TextureRing&) = delete;
+    TextureRing& operator=(const TextureRing&) = delete;
+
+    // (Re)allocate the RGBA slots, which drops the history if the size changes:
+    void allocate(int width, int height);
+
+    // Make the next slot the newest one (ring[0]), its contents are undefined until rendered:
+    void advance();
+
+    // Bind the newest slot as the render target:
+    void bind() const;
+
+    GLuint operator[](int delay) const;
+
+    // Read back a slot as RGBA pixels (width * height * 4 bytes):
+    void read(int delay, GLubyte* pixels) const;
+
+    int getSize() const { return static_cast<int>(m_textures.size()); }
+    int getCount() const { return m_count; }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+
+protected:
+    void release();
+    int slot(int delay) const;
+
+    std::vector<GLuint> m_textures;
+    std::vector<GLuint> m_framebuffers;
+    int m_width = 0;
+    int m_height = 0;
+    int m_index = 0; // newest slot
+    int m_count = 0; // written slots
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_face_gpu_TextureRing_h__
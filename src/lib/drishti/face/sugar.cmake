@@ -12,8 +12,10 @@ endif()
 include(sugar_files)
 
 sugar_files(DRISHTI_FACE_SRCS
+  EyeCropper.cpp
   Face.cpp
   FaceArchiveCereal.cpp  
+  FaceAssociation.cpp
   FaceDetector.cpp
   FaceDetectorAndTracker.cpp
   FaceDetectorAndTrackerImpl.cpp
@@ -22,14 +24,20 @@ sugar_files(DRISHTI_FACE_SRCS
   FaceDetectorFactoryCereal.cpp
   FaceDetectorFactoryJson.cpp  
   FaceIO.cpp
+  FaceJson.cpp
   FaceMesh.cpp  
   FaceModelEstimator.cpp
+  FaceModelSnapshot.cpp
+  FaceQuality.cpp
+  FaceResultsLog.cpp
   FaceTracker.cpp  
   face_util.cpp
   )
 
 sugar_files(DRISHTI_FACE_HDRS_PUBLIC
+  EyeCropper.h
   Face.h
+  FaceAssociation.h
   FaceDetector.h
   FaceDetectorAndTracker.h
   FaceDetectorAndTrackerImpl.h
@@ -38,8 +46,12 @@ sugar_files(DRISHTI_FACE_HDRS_PUBLIC
   FaceDetectorFactoryJson.h  
   FaceIO.h
   FaceImpl.h  
+  FaceJson.h
   FaceMesh.h
   FaceModelEstimator.h
+  FaceModelSnapshot.h
+  FaceQuality.h
+  FaceResultsLog.h
   FaceTracker.h
   drishti_face.h
   face_util.h
@@ -50,12 +62,16 @@ if(DRISHTI_BUILD_OGLES_GPGPU)
     gpu/EyeFilter.h
     gpu/FaceStabilizer.h
     gpu/MultiTransformProc.h
+    gpu/TemporalMeanProc.h
+    gpu/TextureRing.h
     )
 
   sugar_files(DRISHTI_FACE_SRCS  
     gpu/EyeFilter.cpp
     gpu/FaceStabilizer.cpp
     gpu/MultiTransformProc.cpp
+    gpu/TemporalMeanProc.cpp
+    gpu/TextureRing.cpp
     )
 endif()
 
@@ -64,6 +80,7 @@ if(DRISHTI_BUILD_EOS)
     FaceMeshMapperEOS.cpp
     FaceMeshMapperEOSLandmark.cpp
     FaceMeshMapperEOSLandmarkContour.cpp
+    FaceMeshMapperEOSTracker.cpp
     FaceMeshMapperFactory.cpp
     )
   sugar_files(DRISHTI_FACE_HDRS_PUBLIC
@@ -71,6 +88,7 @@ if(DRISHTI_BUILD_EOS)
     FaceMeshMapperEOS.h
     FaceMeshMapperEOSLandmark.h
     FaceMeshMapperEOSLandmarkContour.h
+    FaceMeshMapperEOSTracker.h
     FaceMeshMapperFactory.h
     )
 endif()
@@ -12,11 +12,31 @@
 
 */
 
+#include "drishti/face/EyeCropper.h"
+#include "drishti/face/FaceAssociation.h"
 #include "drishti/face/FaceDetectorAndTracker.h"
+#include "drishti/face/FaceTracker.h"
+#include "drishti/face/FaceIO.h"
+#include "drishti/face/FaceModelSnapshot.h"
+#include "drishti/face/FaceResultsLog.h"
+#include "drishti/face/FaceJson.h"
+#include "drishti/face/FaceMesh.h"
+#include "drishti/face/FaceQuality.h"
 #include "drishti/core/Logger.h"
+#include "drishti/core/drishti_cv_cereal.h"
+#include "drishti/geometry/motion.h"
+#include "drishti/testlib/drishti_alloc_counter.h"
 
 #include <gtest/gtest.h>
 
+#include <opencv2/imgproc.hpp>
+
+#include <cereal/archives/json.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
 // clang-format off
 #define BEGIN_EMPTY_NAMESPACE namespace {
 #define END_EMPTY_NAMESPACE }
@@ -27,6 +47,7 @@ extern const char* sFaceDetectorMean;
 extern const char* sFaceRegressor;
 extern const char* sEyeRegressor;
 extern const char* sFaceImageFilename;
+extern const char* sOutputDirectory;
 
 BEGIN_EMPTY_NAMESPACE
 
@@ -103,6 +124,27 @@ TEST_F(FaceDetectorTest, FaceDetector)
     ASSERT_EQ(faces.size(), 1);
 }
 
+// Once warm, the per frame heap allocations must stay within the budget:
+TEST_F(FaceDetectorTest, SteadyStateAllocations)
+{
+    const int warmup = 4, frames = 16;
+    const std::uint64_t budget = 2048; // allocations per frame (ratchet down as workspaces land)
+
+    std::vector<drishti::face::FaceModel> faces;
+    for (int i = 0; i < warmup; i++)
+    {
+        (*m_detector)(Ip, Ib, faces, cv::Matx33f::eye());
+    }
+
+    drishti::testlib::AllocationCounter counter;
+    for (int i = 0; i < frames; i++)
+    {
+        faces.clear();
+        (*m_detector)(Ip, Ib, faces, cv::Matx33f::eye());
+    }
+    EXPECT_LE(counter.total().count, budget * frames) << counter;
+}
+
 #if defined(DRISHTI_BUILD_EOS)
 TEST_F(FaceDetectorTest, FaceMeshMapper)
 {
@@ -114,4 +156,425 @@ TEST_F(FaceDetectorTest, FaceMeshMapper)
 }
 #endif
 
+static drishti::face::FaceModel createFace(const cv::Point3f& eyesCenter)
+{
+    drishti::face::FaceModel face;
+    face.eyesCenter = eyesCenter;
+    return face;
+}
+
+TEST(FaceTracker, GatedAssignment)
+{
+    drishti::face::FaceTracker tracker(0.15f, 0, 3);
+
+    drishti::face::FaceTracker::FaceTrackVec tracks;
+    tracker({ createFace({ 0.f, 0.f, 1.f }), createFace({ 1.f, 0.f, 1.f }) }, tracks);
+    ASSERT_EQ(tracks.size(), 2);
+
+    // Tracks follow nearby faces, a face beyond the threshold starts a new track:
+    tracks.clear();
+    tracker({ createFace({ 5.f, 0.f, 1.f }), createFace({ 1.02f, 0.f, 1.f }), createFace({ 0.05f, 0.f, 1.f }) }, tracks);
+    ASSERT_EQ(tracks.size(), 3);
+    for (const auto& track : tracks)
+    {
+        const float x = track.first.eyesCenter->x;
+        const std::size_t identifier = (x < 0.5f) ? 0 : ((x < 2.f) ? 1 : 2);
+        EXPECT_EQ(track.second.identifier, identifier);
+        EXPECT_EQ(track.second.hits, (identifier < 2) ? 2 : 1);
+    }
+}
+
+TEST(FaceTracker, MotionPrediction)
+{
+    // The face accelerates beyond the association threshold between frames:
+    const std::vector<float> positions = { 0.f, 0.1f, 0.26f, 0.46f };
+    for (bool doPrediction : { true, false })
+    {
+        drishti::face::FaceTracker tracker(0.15f, 0, 3);
+        tracker.setDoPrediction(doPrediction);
+
+        drishti::face::FaceTracker::FaceTrackVec tracks;
+        for (const auto& x : positions)
+        {
+            tracks.clear();
+            tracker({ createFace({ x, 0.f, 1.f }) }, tracks);
+        }
+
+        const auto iter = std::find_if(tracks.begin(), tracks.end(), [](const drishti::face::FaceTracker::FaceTrack& track) {
+            return track.second.misses == 0;
+        });
+        ASSERT_NE(iter, tracks.end());
+        EXPECT_EQ(iter->second.identifier == 0, doPrediction);
+    }
+}
+
+static drishti::face::FaceTracker::FaceTrack createTrack(std::size_t identifier, const cv::Point3f& position)
+{
+    drishti::face::FaceTracker::TrackInfo info(identifier);
+    info.motion.position = position;
+    return { createFace(position), info };
+}
+
+TEST(FaceAssociation, CrossCamera)
+{
+    // The second camera faces the first one from 2 meters:
+    const cv::Matx33f R(-1.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, -1.f);
+    drishti::sensor::SensorModel::Intrinsic intrinsic;
+    drishti::face::FaceAssociation association(0.25f);
+    const int camera0 = association.addCamera(drishti::sensor::SensorModel());
+    const int camera1 = association.addCamera({ intrinsic, { R, { 0.f, 0.f, 2.f } } });
+
+    association.update(camera0, { createTrack(0, { 0.f, 0.f, 1.f }), createTrack(1, { 0.5f, 0.f, 1.5f }) });
+    association.update(camera1, { createTrack(7, { 0.05f, 0.f, 1.f }), createTrack(8, { 3.f, 0.f, 1.f }) });
+
+    std::size_t id0 = 0, id1 = 0;
+    ASSERT_TRUE(association.getIdentity(camera0, 0, id0));
+    ASSERT_TRUE(association.getIdentity(camera1, 7, id1));
+    EXPECT_EQ(id0, id1);
+    ASSERT_TRUE(association.getIdentity(camera1, 8, id1));
+    EXPECT_NE(id0, id1);
+
+    drishti::face::FaceAssociation::IdentityVec identities;
+    association.getIdentities(identities);
+    EXPECT_EQ(identities.size(), 3);
+
+    // The shared face leaves the first camera's view, the identity stays with the second one:
+    association.update(camera0, { createTrack(1, { 0.5f, 0.f, 1.5f }) });
+    EXPECT_FALSE(association.getIdentity(camera0, 0, id1));
+    ASSERT_TRUE(association.getIdentity(camera1, 7, id1));
+    EXPECT_EQ(id0, id1);
+}
+
 END_EMPTY_NAMESPACE
+
+TEST(FaceModelSnapshot, round_trip)
+{
+    drishti::face::FaceModel face;
+    face.roi = cv::Rect(10, 20, 100, 120);
+    face.noseTip = cv::Point2f(60.5f, 80.25f);
+    face.eyeLeftCenter = cv::Point2f(40.f, 50.f);
+    face.points = std::vector<cv::Point2f>(68, cv::Point2f(1.f, 2.f));
+    face.mouthOuter = { { 1.f, 2.f }, { 3.f, 4.f }, { 5.f, 6.f } };
+    face.rois = { cv::Rect2d(1.0, 2.0, 3.0, 4.0) };
+
+    drishti::eye::EyeModel eye;
+    eye.eyelids = std::vector<cv::Point2f>(16, cv::Point2f(7.f, 8.f));
+    eye.pupil = { 1.f, 2.f, 3.f };
+    eye.irisCenter = cv::Point2f(4.f, 5.f);
+    eye.roi = cv::Rect(1, 2, 3, 4);
+    face.eyeFullR = eye;
+
+    // Transport by memcpy:
+    const drishti::face::FaceModelSnapshot snapshot(face);
+    std::vector<char> buffer(sizeof(snapshot));
+    std::memcpy(buffer.data(), &snapshot, sizeof(snapshot));
+    drishti::face::FaceModelSnapshot received;
+    std::memcpy(&received, buffer.data(), sizeof(received));
+    EXPECT_FALSE(received.has(drishti::face::FaceModelSnapshot::kTruncated));
+
+    const drishti::face::FaceModel copy = received.toFaceModel();
+    EXPECT_TRUE(copy.roi.has);
+    EXPECT_EQ(copy.roi.value, face.roi.value);
+    EXPECT_TRUE(copy.noseTip.has);
+    EXPECT_EQ(copy.noseTip.value, face.noseTip.value);
+    EXPECT_TRUE(copy.eyeLeftCenter.has);
+    EXPECT_FALSE(copy.eyeRightCenter.has);
+    EXPECT_TRUE(copy.points.has);
+    EXPECT_EQ(*copy.points, *face.points);
+    EXPECT_EQ(copy.mouthOuter, face.mouthOuter);
+    EXPECT_TRUE(copy.eyeRight.empty());
+    ASSERT_EQ(copy.rois.size(), 1);
+    EXPECT_EQ(copy.rois[0], face.rois[0]);
+
+    ASSERT_TRUE(copy.eyeFullR.has);
+    EXPECT_FALSE(copy.eyeFullL.has);
+    EXPECT_EQ(copy.eyeFullR->eyelids, eye.eyelids);
+    EXPECT_EQ(copy.eyeFullR->pupil, eye.pupil);
+    EXPECT_EQ(copy.eyeFullR->irisCenter.value, eye.irisCenter.value);
+    EXPECT_EQ(copy.eyeFullR->roi.value, eye.roi.value);
+    EXPECT_FALSE(copy.eyeFullR->angle.has);
+
+    // Oversized contours are truncated:
+    face.sideLeft.resize(drishti::face::FaceModelSnapshot::kMaxPoints);
+    EXPECT_TRUE(drishti::face::FaceModelSnapshot(face).has(drishti::face::FaceModelSnapshot::kTruncated));
+}
+
+TEST(FaceResultsLog, round_trip)
+{
+    drishti::face::FaceModel face;
+    face.roi = cv::Rect(10, 20, 100, 120);
+    face.points = std::vector<cv::Point2f>(68, cv::Point2f(1.f, 2.f));
+
+    drishti::eye::EyeModel eye;
+    eye.eyelids = std::vector<cv::Point2f>(16, cv::Point2f(7.f, 8.f));
+    eye.irisEllipse = cv::RotatedRect({ 4.f, 5.f }, { 6.f, 6.f }, 0.f);
+    eye.pupilEllipse = cv::RotatedRect({ 4.f, 5.f }, { 2.f, 2.f }, 0.f);
+    face.eyeFullL = eye;
+
+    // 3 records per chunk: chunks of 3, 3 and 1 records (and an empty record):
+    const std::string filename = std::string(sOutputDirectory) + "/results.drfr";
+    {
+        drishti::face::FaceResultsWriter writer(filename, 3);
+        for (int i = 0; i < 7; i++)
+        {
+            writer("image_" + std::to_string(i), std::vector<drishti::face::FaceModel>(i % 3, face), std::uint64_t(i * 7));
+        }
+    }
+
+    const drishti::face::FaceResultsReader reader(filename);
+    ASSERT_EQ(reader.size(), 7u);
+    ASSERT_EQ(reader.getChunkCount(), 3u);
+    for (int i = 0; i < 7; i++)
+    {
+        EXPECT_EQ(reader.getName(i), "image_" + std::to_string(i));
+        EXPECT_EQ(reader.getKey(i), std::uint64_t(i * 7));
+
+        const auto faces = reader.getFaces(i);
+        ASSERT_EQ(faces.size(), std::size_t(i % 3));
+        for (const auto& copy : faces)
+        {
+            ASSERT_TRUE(copy.roi.has && copy.points.has);
+            EXPECT_EQ(*copy.roi, *face.roi);
+            EXPECT_EQ(*copy.points, *face.points);
+            EXPECT_FALSE(copy.eyeFullR.has);
+            ASSERT_TRUE(copy.eyeFullL.has);
+            EXPECT_EQ(copy.eyeFullL->eyelids, eye.eyelids);
+            EXPECT_EQ(copy.eyeFullL->irisEllipse.center, eye.irisEllipse.center);
+            EXPECT_EQ(copy.eyeFullL->pupilEllipse.size, eye.pupilEllipse.size);
+        }
+    }
+
+    // Columns are available in place:
+    std::size_t count = 0;
+    reader.getChunk(1).get<drishti::face::FaceResultsLog::Rect>("face.roi", count);
+    EXPECT_EQ(count, 3u); // records 3, 4, 5 have 0, 1 and 2 faces
+}
+
+static void expectEqual(const drishti::face::FaceModel& a, const drishti::face::FaceModel& b)
+{
+    EXPECT_EQ(a.eyeLeftCenter.has, b.eyeLeftCenter.has);
+    EXPECT_EQ(*a.eyeLeftCenter, *b.eyeLeftCenter);
+    EXPECT_EQ(*a.eyebrowLeftInner, *b.eyebrowLeftInner);
+    EXPECT_EQ(*a.eyebrowLeftOuter, *b.eyebrowLeftOuter);
+    EXPECT_EQ(a.noseTip.has, b.noseTip.has);
+    EXPECT_EQ(a.eyeRight, b.eyeRight);
+    EXPECT_EQ(a.mouthOuter, b.mouthOuter);
+    EXPECT_EQ(a.eyeFullL.has, b.eyeFullL.has);
+    EXPECT_EQ(a.eyeFullR.has, b.eyeFullR.has);
+    EXPECT_EQ(a.eyeFullR->eyelids, b.eyeFullR->eyelids);
+    EXPECT_EQ(a.eyeFullR->roi.has, b.eyeFullR->roi.has);
+    EXPECT_EQ(*a.eyeFullR->roi, *b.eyeFullR->roi);
+    EXPECT_EQ(a.eyeFullR->irisEllipse.center, b.eyeFullR->irisEllipse.center);
+    EXPECT_EQ(a.eyeFullR->irisEllipse.size, b.eyeFullR->irisEllipse.size);
+    EXPECT_EQ(a.eyeFullR->irisEllipse.angle, b.eyeFullR->irisEllipse.angle);
+}
+
+// The streaming writer and reader must interoperate with the cereal JSON archives:
+TEST(FaceJson, cereal_compatibility)
+{
+    drishti::face::FaceModel face;
+    face.eyeLeftCenter = cv::Point2f(0.1f, -1e-7f);
+    face.eyebrowLeftInner = cv::Point2f(1.f, 2.f);
+    face.eyebrowLeftOuter = cv::Point2f(3.f, 4.f);
+    face.eyeRight = std::vector<cv::Point2f>(6, cv::Point2f(1.f / 3.f, 1e6f));
+
+    drishti::eye::EyeModel eye;
+    eye.roi = cv::Rect(1, 2, 3, 4);
+    eye.eyelids = std::vector<cv::Point2f>(16, cv::Point2f(7.5f, 8.25f));
+    eye.irisEllipse = cv::RotatedRect({ 4.f, 5.f }, { 6.f, 7.f }, 33.3f);
+    face.eyeFullR = eye;
+
+    const std::vector<drishti::face::FaceModel> faces{ face, drishti::face::FaceModel(), face };
+
+    std::string json;
+    drishti::face::toJson(faces, json);
+
+    // streaming -> streaming
+    std::vector<drishti::face::FaceModel> faces1;
+    ASSERT_TRUE(drishti::face::fromJson(json.data(), json.size(), faces1));
+    ASSERT_EQ(faces1.size(), faces.size());
+
+    // streaming -> cereal
+    std::vector<drishti::face::FaceModel> faces2;
+    {
+        std::istringstream is(json);
+        cereal::JSONInputArchive ia(is);
+        typedef decltype(ia) Archive;
+        ia(GENERIC_NVP("faces", faces2));
+    }
+    ASSERT_EQ(faces2.size(), faces.size());
+
+    // cereal -> streaming
+    std::stringstream ss;
+    {
+        cereal::JSONOutputArchive oa(ss);
+        typedef decltype(oa) Archive;
+        oa << GENERIC_NVP("faces", faces);
+    }
+    const std::string reference = ss.str();
+    std::vector<drishti::face::FaceModel> faces3;
+    ASSERT_TRUE(drishti::face::fromJson(reference.data(), reference.size(), faces3));
+    ASSERT_EQ(faces3.size(), faces.size());
+
+    for (std::size_t i = 0; i < faces.size(); i++)
+    {
+        expectEqual(faces1[i], faces[i]);
+        expectEqual(faces2[i], faces[i]);
+        expectEqual(faces3[i], faces[i]);
+    }
+
+    // Malformed input is rejected:
+    std::vector<drishti::face::FaceModel> faces4;
+    EXPECT_FALSE(drishti::face::fromJson(json.data(), json.size() / 2, faces4));
+}
+
+TEST(FaceLandmarkMap, indexed_copies)
+{
+    drishti::core::Shape shape;
+    for (int i = 0; i < 68; i++)
+    {
+        shape.contour.emplace_back(float(i), float(i % 7), false);
+    }
+
+    const drishti::face::FaceLandmarkMap map(drishti::face::FaceSpecification::kibug68);
+
+    // Reused faces are reset:
+    drishti::face::FaceModel face;
+    face.eyesCenter = cv::Point3f(0.f, 0.f, 1.f);
+    face.sideLeft.resize(4);
+    map(shape, face);
+    EXPECT_FALSE(face.eyesCenter.has);
+    EXPECT_TRUE(face.sideLeft.empty());
+    ASSERT_TRUE(face.points.has);
+    ASSERT_EQ(face.points->size(), 68);
+    ASSERT_EQ(face.eyeRight.size(), 6);
+    EXPECT_EQ(face.eyeRight.front(), shape.contour[36].p);
+    EXPECT_EQ(face.mouthInner.back(), shape.contour[67].p);
+    ASSERT_TRUE(face.noseTip.has);
+
+    const auto* data = face.eyeRight.data();
+    map(shape, face);
+    EXPECT_EQ(face.eyeRight.data(), data);
+
+    // Landmark subsets keep the points of each feature:
+    drishti::core::Shape subset;
+    for (int i : { 36, 39, 30 })
+    {
+        subset.contour.push_back(shape.contour[i]);
+    }
+    drishti::face::FaceLandmarkMap(drishti::face::FaceSpecification::kibug68, { 36, 39, 30 })(subset, face);
+    ASSERT_EQ(face.eyeRight.size(), 2);
+    EXPECT_EQ(face.eyeRight.back(), shape.contour[39].p);
+    EXPECT_TRUE(face.eyeLeft.empty());
+    EXPECT_FALSE(face.eyeLeftCenter.has);
+}
+
+TEST(FaceMesh, topology_cache)
+{
+    const cv::Size size(256, 256);
+
+    cv::RNG rng(1);
+    std::vector<cv::Point2f> landmarks(68);
+    for (auto& p : landmarks)
+    {
+        p = { rng.uniform(16.f, 240.f), rng.uniform(16.f, 240.f) };
+    }
+
+    drishti::face::FaceMesh::clearTopologyCache();
+    drishti::face::FaceMesh mesh1, mesh2;
+    const auto topology = mesh1.getTopology(landmarks, size);
+    ASSERT_FALSE(topology.empty());
+
+    // A second mesh with the same scheme reuses the triangulation for new vertex positions:
+    auto moved = landmarks;
+    for (auto& p : moved)
+    {
+        p += cv::Point2f(rng.uniform(-4.f, 4.f), rng.uniform(-4.f, 4.f));
+    }
+    EXPECT_EQ(mesh2.getTopology(moved, size), topology);
+    EXPECT_EQ(mesh2.delaunay(moved, size).size(), topology.size());
+
+    // The identity warp maps covered pixels to themselves:
+    const auto maps = mesh1.transform(landmarks, landmarks, size);
+    int covered = 0;
+    double error = 0.0;
+    for (int y = 0; y < size.height; y++)
+    {
+        for (int x = 0; x < size.width; x++)
+        {
+            if (maps[0](y, x) >= 0.f)
+            {
+                covered++;
+                error = std::max(error, cv::norm(cv::Point2f(maps[0](y, x), maps[1](y, x)) - cv::Point2f(x, y)));
+            }
+        }
+    }
+    EXPECT_GT(covered, 0);
+    EXPECT_LT(error, 1e-2);
+}
+
+TEST(FaceQualityFilter, thresholds_and_stumps)
+{
+    using drishti::face::FaceQuality;
+
+    FaceQuality quality;
+    quality[FaceQuality::kScore] = 10.f;
+    quality[FaceQuality::kWidth] = 100.f;
+    quality[FaceQuality::kDistance] = 0.5f;
+    quality[FaceQuality::kSharpness] = 0.2f;
+
+    drishti::face::FaceQualityFilter filter;
+    EXPECT_TRUE(filter.empty());
+    EXPECT_TRUE(filter(quality));
+
+    filter.maxDistance = 0.4f;
+    EXPECT_FALSE(filter(quality));
+    filter.maxDistance = 1.f;
+    EXPECT_TRUE(filter(quality));
+
+    // Blurry detections are rejected by the stump ensemble unless the score is high:
+    filter.stumps.push_back({ FaceQuality::kSharpness, 0.25f, -1.f, 1.f });
+    filter.stumps.push_back({ FaceQuality::kScore, 20.f, 0.f, 1.5f });
+    EXPECT_FLOAT_EQ(filter.getConfidence(quality), -1.f);
+    EXPECT_FALSE(filter(quality));
+
+    quality[FaceQuality::kScore] = 25.f;
+    EXPECT_FLOAT_EQ(filter.getConfidence(quality), 0.5f);
+    EXPECT_TRUE(filter(quality));
+}
+
+TEST(EyeCropper, matches_quantized_warp)
+{
+    cv::Mat1b image(240, 320);
+    cv::randu(image, 0, 255);
+    cv::GaussianBlur(image, image, { 5, 5 }, 2.0);
+
+    const cv::Size size(128, 64);
+    const drishti::face::EyeCropper cropper(8);
+
+    std::vector<cv::Matx33f> transforms;
+    for (const auto& t : { cv::Point2f(-100.3f, -80.6f), cv::Point2f(-100.31f, -80.61f), cv::Point2f(+30.f, +20.f) })
+    {
+        const cv::Matx33f R = transformation::rotate(0.2f), S = transformation::scale(1.5f);
+        transforms.push_back(transformation::translate(t) * S * R);
+    }
+
+    for (const auto& H : transforms)
+    {
+        cv::Mat crop, expected;
+        const cv::Matx33f Hq = cropper(image, H, size, crop);
+        EXPECT_LT(cv::norm(cv::Mat(Hq - cropper.quantize(H))), 1e-4);
+        EXPECT_LT(cv::norm(Hq.get_minor<2, 2>(0, 0) - H.get_minor<2, 2>(0, 0)), 2e-2); // rotation and scale bins
+
+        // The partially outside crop is zero padded like cv::warpAffine(BORDER_CONSTANT):
+        cv::warpAffine(image, expected, Hq.get_minor<2, 3>(0, 0), size, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+        cv::Mat1b difference;
+        cv::absdiff(crop, expected, difference);
+        double error = 0.0;
+        cv::minMaxLoc(difference(cv::Rect({ 1, 1 }, size - cv::Size(2, 2))), nullptr, &error);
+        EXPECT_LE(error, 2.0);
+    }
+
+    // The second transformation falls into the bin of the first:
+    EXPECT_EQ(cropper.getCacheSize(), 2);
+}
@@ -13,6 +13,8 @@
 #include "drishti/core/drishti_math.h"
 
 #include <opencv2/imgproc.hpp>
+
+#include <cmath>
 #include <iostream>
 
 DRISHTI_GEOMETRY_BEGIN
@@ -88,18 +90,17 @@ void ellipse(cv::Mat& image, const Ellipse& e, const cv::Scalar& color, int widt
 #endif
 }
 
-std::vector<float> ellipseToPhi(const cv::RotatedRect& e)
+static void ellipseToPhi(const cv::RotatedRect& e, float* phi)
 {
-    float cx = e.center.x;
-    float cy = e.center.y;
-    float angle = (e.angle) * M_PI / 180.0;
-    float scale = core::logN(e.size.width, 2.0f);
-    float aspectRatio = core::logN(e.size.height / e.size.width, 2.0f);
-    return std::vector<float>{ cx, cy, angle, scale, aspectRatio };
+    phi[0] = e.center.x;
+    phi[1] = e.center.y;
+    phi[2] = (e.angle) * M_PI / 180.0;
+    phi[3] = core::logN(e.size.width, 2.0f);
+    phi[4] = core::logN(e.size.height / e.size.width, 2.0f);
 }
 
 // Note: This is for ellipse drawn in transposed image
-cv::RotatedRect phiToEllipse(const std::vector<float>& phi)
+static cv::RotatedRect phiToEllipse(const float* phi)
 {
     double width = std::pow(2.0, phi[3]);
     cv::Size2f size(width, std::pow(2.0, phi[4]) * width);
@@ -108,6 +109,34 @@ cv::RotatedRect phiToEllipse(const std::vector<float>& phi)
     return ellipse;
 }
 
+std::vector<float> ellipseToPhi(const cv::RotatedRect& e)
+{
+    std::vector<float> phi(5);
+    ellipseToPhi(e, phi.data());
+    return phi;
+}
+
+cv::RotatedRect phiToEllipse(const std::vector<float>& phi)
+{
+    return phiToEllipse(phi.data());
+}
+
+void ellipseToPhi(const cv::RotatedRect* e, int count, float* phi)
+{
+    for (int i = 0; i < count; i++)
+    {
+        ellipseToPhi(e[i], phi + i * 5);
+    }
+}
+
+void phiToEllipse(const float* phi, int count, cv::RotatedRect* e)
+{
+    for (int i = 0; i < count; i++)
+    {
+        e[i] = phiToEllipse(phi + i * 5);
+    }
+}
+
 // ===== from opencv/imgproc/drawing.cpp:
 
 /*
@@ -121,6 +150,7 @@ void ellipse2Poly(const cv::RotatedRect& ellipse, float delta, std::vector<cv::P
     const float a = ellipse.size.width / 2.f;
     const float cos_theta = std::cos(theta);
     const float sin_theta = std::sin(theta);
+    points.reserve(points.size() + static_cast<std::size_t>(std::ceil(2.f * M_PI / delta)) + 1);
     for (float t = 0.0; t < 2.f * M_PI; t += delta)
     {
         const float cos_t = std::cos(t);
@@ -130,4 +160,63 @@ void ellipse2Poly(const cv::RotatedRect& ellipse, float delta, std::vector<cv::P
     }
 }
 
+// ((((((( EllipseSampler )))))))
+EllipseSampler::EllipseSampler(int count)
+    : m_cos(count)
+    , m_sin(count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const double t = 2.0 * M_PI * double(i) / double(count);
+        m_cos[i] = static_cast<float>(std::cos(t));
+        m_sin[i] = static_cast<float>(std::sin(t));
+    }
+}
+
+// p(t) = c + R(theta) * [a cos(t), b sin(t)], as in ellipse2Poly()
+void EllipseSampler::operator()(const cv::RotatedRect& e, float* x, float* y) const
+{
+    const float theta = e.angle * M_PI / 180.0f;
+    const float a = e.size.width / 2.f, b = e.size.height / 2.f;
+    const float ct = std::cos(theta), st = std::sin(theta);
+    const float ax = a * ct, bx = -b * st, cx = e.center.x;
+    const float ay = a * st, by = +b * ct, cy = e.center.y;
+
+    const float* c = m_cos.data();
+    const float* s = m_sin.data();
+    const int n = size();
+    for (int i = 0; i < n; i++)
+    {
+        x[i] = cx + ax * c[i] + bx * s[i];
+        y[i] = cy + ay * c[i] + by * s[i];
+    }
+}
+
+void EllipseSampler::operator()(const cv::RotatedRect& e, cv::Point2f* points) const
+{
+    const float theta = e.angle * M_PI / 180.0f;
+    const float a = e.size.width / 2.f, b = e.size.height / 2.f;
+    const float ct = std::cos(theta), st = std::sin(theta);
+    const float ax = a * ct, bx = -b * st, cx = e.center.x;
+    const float ay = a * st, by = +b * ct, cy = e.center.y;
+
+    const float* c = m_cos.data();
+    const float* s = m_sin.data();
+    float* p = &points[0].x;
+    const int n = size();
+    for (int i = 0; i < n; i++)
+    {
+        p[i * 2 + 0] = cx + ax * c[i] + bx * s[i];
+        p[i * 2 + 1] = cy + ay * c[i] + by * s[i];
+    }
+}
+
+void EllipseSampler::operator()(const cv::RotatedRect* e, int count, cv::Point2f* points) const
+{
+    for (int i = 0; i < count; i++)
+    {
+        (*this)(e[i], points + i * size());
+    }
+}
+
 DRISHTI_GEOMETRY_END
@@ -64,9 +64,31 @@ std::vector<float> pointsToPhi(const std::vector<cv::Point2f>& points);
 std::vector<float> ellipseToPhi(const cv::RotatedRect& e);
 cv::RotatedRect phiToEllipse(const std::vector<float>& phi);
 
+// Batch variants with 5 parameters per ellipse in caller provided buffers:
+void ellipseToPhi(const cv::RotatedRect* e, int count, float* phi);
+void phiToEllipse(const float* phi, int count, cv::RotatedRect* e);
+
 typedef std::vector<cv::Point2f> PointVec;
 void ellipse2Poly(const cv::RotatedRect& ellipse, float delta, std::vector<cv::Point2f>& points);
 
+// Samples a fixed number of points (at angles 2*pi*i/n) on each ellipse with precomputed
+// sin/cos tables, writing to caller provided buffers.  Construct once and reuse in loops.
+class EllipseSampler
+{
+public:
+    EllipseSampler(int count);
+
+    int size() const { return static_cast<int>(m_cos.size()); }
+
+    void operator()(const cv::RotatedRect& e, cv::Point2f* points) const;
+    void operator()(const cv::RotatedRect& e, float* x, float* y) const;
+    void operator()(const cv::RotatedRect* e, int count, cv::Point2f* points) const; // size() points per ellipse
+
+protected:
+    std::vector<float> m_cos;
+    std::vector<float> m_sin;
+};
+
 // see: http://research.microsoft.com/en-us/um/people/awf/ellipse/fitellipse.html
 template <typename T>
 cv::RotatedRect getEllipse(const ConicSection_<T>& C)
@@ -134,9 +156,20 @@ inline std::vector<float> ellipseToVector(const cv::RotatedRect& e)
     return std::vector<float>{ e.center.x, e.center.y, e.size.width, e.size.height, e.angle };
 }
 
+inline void ellipseToPoints(const cv::RotatedRect& e, cv::Point2f* p)
+{
+    p[0] = { e.center.x, 0.f };
+    p[1] = { e.center.y, 0.f };
+    p[2] = { e.size.width, 0.f };
+    p[3] = { e.size.height, 0.f };
+    p[4] = { e.angle, 0.f };
+}
+
 inline std::vector<cv::Point2f> ellipseToPoints(const cv::RotatedRect& e)
 {
-    return std::vector<cv::Point2f>{ { e.center.x, 0 }, { e.center.y, 0 }, { e.size.width, 0 }, { e.size.height }, { e.angle, 0 } };
+    std::vector<cv::Point2f> points(5);
+    ellipseToPoints(e, points.data());
+    return points;
 }
 
 inline cv::RotatedRect pointsToEllipse(const cv::Point2f* p)
@@ -149,14 +182,18 @@ inline cv::RotatedRect pointsToEllipse(const std::vector<cv::Point2f>& p)
     return cv::RotatedRect({ p[0].x, p[1].x }, { p[2].x, p[3].x }, p[4].x);
 }
 
-inline std::vector<cv::RotatedRect> pointsToEllipses(const std::vector<cv::Point2f>& p)
+inline void pointsToEllipses(const cv::Point2f* p, int count, cv::RotatedRect* e)
 {
-    std::vector<cv::RotatedRect> ellipses;
-    size_t n = p.size() / 5;
-    for (size_t i = 0; i < n; i++)
+    for (int i = 0; i < count; i++)
     {
-        ellipses.push_back(pointsToEllipse(&p[i * 5]));
+        e[i] = pointsToEllipse(p + i * 5);
     }
+}
+
+inline std::vector<cv::RotatedRect> pointsToEllipses(const std::vector<cv::Point2f>& p)
+{
+    std::vector<cv::RotatedRect> ellipses(p.size() / 5);
+    pointsToEllipses(p.data(), static_cast<int>(ellipses.size()), ellipses.data());
     return ellipses;
 }
 
@@ -21,25 +21,47 @@ cv::Point2f mean(const PointVec& points)
     return (mu * (1.f / float(points.size())));
 }
 
-cv::Matx33f procrustes(const PointVec& points)
+template <int kStride>
+static cv::Matx33f procrustes(int n, const float* x, const float* y)
 {
     // Estimate translation:
-    cv::Point2f mu = mean(points);
-    cv::Matx33f T(1, 0, -mu.x, 0, 1, -mu.y, 0, 0, 1);
+    float mx = 0.f, my = 0.f;
+    for (int i = 0; i < n; i++)
+    {
+        mx += x[i * kStride];
+        my += y[i * kStride];
+    }
+    mx /= float(n);
+    my /= float(n);
 
     // Estimate scale:
     float scale = 0.f;
-    for (const auto& p : points)
+    for (int i = 0; i < n; i++)
     {
-        scale += ((p - mu).dot(p - mu));
+        const float dx = x[i * kStride] - mx, dy = y[i * kStride] - my;
+        scale += (dx * dx + dy * dy);
     }
 
-    scale = std::sqrt(scale / float(points.size()));
-    cv::Matx33f S(cv::Matx33f::diag({ 1.f / scale, 1.f / scale, 1.f }));
+    const float s = 1.f / std::sqrt(scale / float(n));
+    return cv::Matx33f(s, 0.f, -mx * s, 0.f, s, -my * s, 0.f, 0.f, 1.f);
+}
+
+cv::Matx33f procrustes(const PointVec& points)
+{
+    return procrustes(int(points.size()), points.data());
+}
 
-    cv::Matx33f H = S * T;
+cv::Matx33f procrustes(int npoints, const cv::Point2f* points)
+{
+    return procrustes<2>(npoints, &points[0].x, &points[0].y);
+}
 
-    return H;
+void procrustes(int count, int npoints, const float* x, const float* y, cv::Matx33f* H)
+{
+    for (int i = 0, k = 0; i < count; i++, k += npoints)
+    {
+        H[i] = procrustes<1>(npoints, x + k, y + k);
+    }
 }
 
 // WRT ellipse center
@@ -22,6 +22,10 @@ typedef std::vector<cv::Point2f> PointVec;
 
 // Translation and scale:
 cv::Matx33f procrustes(const PointVec& points);
+cv::Matx33f procrustes(int npoints, const cv::Point2f* points);
+
+// Batch variant for count point sets stored as SoA arrays: x[i * npoints + j] is point j of set i.
+void procrustes(int count, int npoints, const float* x, const float* y, cv::Matx33f* H);
 
 template <typename T>
 T median(std::vector<T>& params)
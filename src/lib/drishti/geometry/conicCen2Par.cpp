@@ -54,4 +54,12 @@ cv::Vec6d conicCen2Par(const cv::RotatedRect& cen)
     return par;
 }
 
+void conicCen2Par(const cv::RotatedRect* cen, int count, cv::Vec6d* par)
+{
+    for (int i = 0; i < count; i++)
+    {
+        par[i] = conicCen2Par(cen[i]);
+    }
+}
+
 DRISHTI_GEOMETRY_END
@@ -69,4 +69,12 @@ cv::RotatedRect conicPar2Cen(const cv::Vec6d& par)
     return cv::RotatedRect(center, size, thetarad * 180.0 / M_PI);
 }
 
+void conicPar2Cen(const cv::Vec6d* par, int count, cv::RotatedRect* cen)
+{
+    for (int i = 0; i < count; i++)
+    {
+        cen[i] = conicPar2Cen(par[i]);
+    }
+}
+
 DRISHTI_GEOMETRY_END
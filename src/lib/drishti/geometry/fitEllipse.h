@@ -34,6 +34,10 @@ T pow2(const T& x)
 cv::RotatedRect conicPar2Cen(const cv::Vec6d& par);
 cv::Vec6d conicCen2Par(const cv::RotatedRect& cen);
 
+// Batch conversions to caller provided buffers:
+void conicPar2Cen(const cv::Vec6d* par, int count, cv::RotatedRect* cen);
+void conicCen2Par(const cv::RotatedRect* cen, int count, cv::Vec6d* par);
+
 DRISHTI_GEOMETRY_END
 
 #endif // __drishti_geometry_fitEllipse_h__ 1
@@ -0,0 +1,98 @@
+/*! -*-c++-*-
+  @file   intersectConicRays.h
+  @author David Hirvonen
+  @brief  Batch intersection of parametric rays with conic sections (SoA layout).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_geometry_intersectConicRays_h__
+#define __drishti_geometry_intersectConicRays_h__ 1
+
+#include "drishti/geometry/drishti_geometry.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+DRISHTI_GEOMETRY_BEGIN
+
+/*
+ * Rays p(t) = o + t * d are intersected with a conic C by solving the quadratic
+ *
+ *   a t^2 + 2 b t + c = 0,  a = d' C d,  b = d' C o,  c = o' C o
+ *
+ * (o and d are lifted to homogeneous points with w = 1 and w = 0).  Compared with
+ * intersectConicLine(), no line or basis points are formed, and the roots are returned as
+ * ray parameters so the intersection in the ray direction needs no dot product: for an
+ * ellipse (a > 0, see ConicSection_) t0 >= t1, and t0 > 0 is the forward intersection of a
+ * ray starting inside it.  The loops are branch free over structure of arrays inputs, so
+ * they vectorize; hits[i] is 0 (with t0 = t1 = 0) for rays that miss or are degenerate.
+ */
+
+template <typename T>
+struct ConicRayTerms
+{
+    ConicRayTerms(const cv::Matx<T, 3, 3>& C)
+        : xx(C(0, 0))
+        , xy(T(0.5) * (C(0, 1) + C(1, 0)))
+        , yy(C(1, 1))
+        , x(T(0.5) * (C(0, 2) + C(2, 0)))
+        , y(T(0.5) * (C(1, 2) + C(2, 1)))
+        , w(C(2, 2))
+    {
+    }
+
+    std::uint8_t solve(T ox, T oy, T dx, T dy, T& t0, T& t1) const
+    {
+        const T cdx = xx * dx + xy * dy, cdy = xy * dx + yy * dy, cdw = x * dx + y * dy;
+        const T a = cdx * dx + cdy * dy;
+        const T b = cdx * ox + cdy * oy + cdw;
+        const T c = (xx * ox + T(2) * xy * oy + T(2) * x) * ox + (yy * oy + T(2) * y) * oy + w;
+        const T delta = b * b - a * c;
+        const bool hit = (delta >= T(0)) && (a != T(0));
+        const T s = std::sqrt(std::max(delta, T(0)));
+        const T ia = hit ? (T(1) / a) : T(0);
+        t0 = (-b + s) * ia;
+        t1 = (-b - s) * ia;
+        return static_cast<std::uint8_t>(hit);
+    }
+
+    T xx, xy, yy, x, y, w; // symmetric part of C
+};
+
+// One conic, many rays (e.g., a fan of rays about a pupil center sampling the limbus):
+template <typename T>
+int intersectConicRays(const cv::Matx<T, 3, 3>& C, int count, const T* ox, const T* oy, const T* dx, const T* dy, T* t0, T* t1, std::uint8_t* hits)
+{
+    const ConicRayTerms<T> terms(C);
+
+    int total = 0;
+    for (int i = 0; i < count; i++)
+    {
+        hits[i] = terms.solve(ox[i], oy[i], dx[i], dy[i], t0[i], t1[i]);
+        total += hits[i];
+    }
+    return total;
+}
+
+// Many conics, one ray each (e.g., the same query for all faces in a frame):
+template <typename T>
+int intersectConicRays(int count, const cv::Matx<T, 3, 3>* C, const T* ox, const T* oy, const T* dx, const T* dy, T* t0, T* t1, std::uint8_t* hits)
+{
+    int total = 0;
+    for (int i = 0; i < count; i++)
+    {
+        hits[i] = ConicRayTerms<T>(C[i]).solve(ox[i], oy[i], dx[i], dy[i], t0[i], t1[i]);
+        total += hits[i];
+    }
+    return total;
+}
+
+DRISHTI_GEOMETRY_END
+
+#endif // __drishti_geometry_intersectConicRays_h__
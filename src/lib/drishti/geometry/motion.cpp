@@ -10,115 +10,171 @@
 
 #include "drishti/geometry/motion.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 //============================
 //== Utility =================
 //============================
 
 DRISHTI_TRANSFORMATION_NAMESPACE_BEGIN
 
-// OpenCV 3-Clause BSD
-// https://github.com/opencv/opencv/blob/21ee113af30a2efba8faac4811d55822ff878b0e/modules/videostab/src/global_motion.cpp#L85
-static cv::Mat normalizePoints(int npoints, cv::Point2f* points)
+// First and (centered) second moments of two corresponding point sets, with x[i * kStride]:
+struct Moments
+{
+    cv::Point2f mp, mq;       // means
+    float pxx, pxy, pyy;      // p covariance
+    float xu, yu, xv, yv;     // p, q = (u, v) cross covariance
+    float qq;                 // q variance (trace)
+};
+
+template <int kStride>
+static Moments getMoments(int n, const float* px, const float* py, const float* qx, const float* qy)
 {
-    float cx = 0.f, cy = 0.f;
-    for (int i = 0; i < npoints; ++i)
+    float mpx = 0.f, mpy = 0.f, mqx = 0.f, mqy = 0.f;
+    for (int i = 0; i < n; i++)
     {
-        cx += points[i].x;
-        cy += points[i].y;
+        mpx += px[i * kStride];
+        mpy += py[i * kStride];
+        mqx += qx[i * kStride];
+        mqy += qy[i * kStride];
     }
-    cx /= npoints;
-    cy /= npoints;
 
-    float d = 0.f;
-    for (int i = 0; i < npoints; ++i)
+    const float w = 1.f / float(n);
+    mpx *= w;
+    mpy *= w;
+    mqx *= w;
+    mqy *= w;
+
+    float pxx = 0.f, pxy = 0.f, pyy = 0.f, xu = 0.f, yu = 0.f, xv = 0.f, yv = 0.f, qq = 0.f;
+    for (int i = 0; i < n; i++)
     {
-        points[i].x -= cx;
-        points[i].y -= cy;
-        d += std::sqrt(points[i].x * points[i].x + points[i].y * points[i].y);
+        const float x = px[i * kStride] - mpx, y = py[i * kStride] - mpy;
+        const float u = qx[i * kStride] - mqx, v = qy[i * kStride] - mqy;
+        pxx += x * x;
+        pxy += x * y;
+        pyy += y * y;
+        xu += x * u;
+        yu += y * u;
+        xv += x * v;
+        yv += y * v;
+        qq += u * u + v * v;
     }
-    d /= npoints;
 
-    float s = std::sqrt(2.f) / d;
-    for (int i = 0; i < npoints; ++i)
+    return { { mpx, mpy }, { mqx, mqy }, pxx, pxy, pyy, xu, yu, xv, yv, qq };
+}
+
+static float getRMSE(float residual, int n)
+{
+    return std::sqrt(std::max(residual, 0.f) / float(n));
+}
+
+// q = [a b; -b a] p + t
+static cv::Matx33f getSimilarity(int n, const Moments& m, float* rmse)
+{
+    const float pp = m.pxx + m.pyy;
+    if (pp <= std::numeric_limits<float>::epsilon())
     {
-        points[i].x *= s;
-        points[i].y *= s;
+        if (rmse)
+        {
+            *rmse = getRMSE(m.qq, n);
+        }
+        return translate(m.mq - m.mp);
     }
 
-    cv::Mat_<float> T = cv::Mat::eye(3, 3, CV_32F);
-    T(0, 0) = T(1, 1) = s;
-    T(0, 2) = -cx * s;
-    T(1, 2) = -cy * s;
-    return T;
+    const float sa = m.xu + m.yv, sb = m.yu - m.xv;
+    const float a = sa / pp, b = sb / pp;
+    if (rmse)
+    {
+        *rmse = getRMSE(m.qq - (sa * sa + sb * sb) / pp, n);
+    }
+
+    const cv::Point2f t(m.mq.x - (a * m.mp.x + b * m.mp.y), m.mq.y - (-b * m.mp.x + a * m.mp.y));
+    return cv::Matx33f(a, b, t.x, -b, a, t.y, 0.f, 0.f, 1.f);
 }
 
-// OpenCV 3-Clause BSD
-// https://github.com/opencv/opencv/blob/21ee113af30a2efba8faac4811d55822ff878b0e/modules/videostab/src/global_motion.cpp#L280
-cv::Mat estimateGlobMotionLeastSquaresSimilarity(int npoints, cv::Point2f* points0, cv::Point2f* points1, float* rmse)
+// q = A p + t, with A = C * P^-1 for cross covariance C and covariance P
+static cv::Matx33f getAffine(int n, const Moments& m, float* rmse)
 {
-    cv::Mat_<float> T0 = normalizePoints(npoints, points0);
-    cv::Mat_<float> T1 = normalizePoints(npoints, points1);
+    const float det = m.pxx * m.pyy - m.pxy * m.pxy;
+    if (std::abs(det) <= std::numeric_limits<float>::epsilon() * (m.pxx + m.pyy) * (m.pxx + m.pyy))
+    {
+        return getSimilarity(n, m, rmse); // collinear
+    }
 
-    cv::Mat_<float> A(2 * npoints, 4), b(2 * npoints, 1);
-    float *a0, *a1;
-    cv::Point2f p0, p1;
+    const float i00 = m.pyy / det, i01 = -m.pxy / det, i11 = m.pxx / det;
+    const float a00 = m.xu * i00 + m.yu * i01, a01 = m.xu * i01 + m.yu * i11;
+    const float a10 = m.xv * i00 + m.yv * i01, a11 = m.xv * i01 + m.yv * i11;
+    if (rmse)
+    {
+        // |dq - A dp|^2 = qq - tr(C A^T) since A P = C
+        *rmse = getRMSE(m.qq - (m.xu * a00 + m.yu * a01 + m.xv * a10 + m.yv * a11), n);
+    }
 
-    for (int i = 0; i < npoints; ++i)
+    const cv::Point2f t(m.mq.x - (a00 * m.mp.x + a01 * m.mp.y), m.mq.y - (a10 * m.mp.x + a11 * m.mp.y));
+    return cv::Matx33f(a00, a01, t.x, a10, a11, t.y, 0.f, 0.f, 1.f);
+}
+
+cv::Matx33f estimateSimilarity(int npoints, const cv::Point2f* p, const cv::Point2f* q, float* rmse)
+{
+    return getSimilarity(npoints, getMoments<2>(npoints, &p[0].x, &p[0].y, &q[0].x, &q[0].y), rmse);
+}
+
+cv::Matx33f estimateAffine(int npoints, const cv::Point2f* p, const cv::Point2f* q, float* rmse)
+{
+    return getAffine(npoints, getMoments<2>(npoints, &p[0].x, &p[0].y, &q[0].x, &q[0].y), rmse);
+}
+
+void estimateSimilarity(int count, int npoints, const float* px, const float* py, const float* qx, const float* qy, cv::Matx33f* H, float* rmse)
+{
+    for (int i = 0, k = 0; i < count; i++, k += npoints)
+    {
+        H[i] = getSimilarity(npoints, getMoments<1>(npoints, px + k, py + k, qx + k, qy + k), rmse ? (rmse + i) : nullptr);
+    }
+}
+
+void estimateAffine(int count, int npoints, const float* px, const float* py, const float* qx, const float* qy, cv::Matx33f* H, float* rmse)
+{
+    for (int i = 0, k = 0; i < count; i++, k += npoints)
     {
-        a0 = A[2 * i];
-        a1 = A[2 * i + 1];
-        p0 = points0[i];
-        p1 = points1[i];
-        a0[0] = p0.x;
-        a0[1] = p0.y;
-        a0[2] = 1;
-        a0[3] = 0;
-        a1[0] = p0.y;
-        a1[1] = -p0.x;
-        a1[2] = 0;
-        a1[3] = 1;
-        b(2 * i, 0) = p1.x;
-        b(2 * i + 1, 0) = p1.y;
+        H[i] = getAffine(npoints, getMoments<1>(npoints, px + k, py + k, qx + k, qy + k), rmse ? (rmse + i) : nullptr);
     }
+}
 
-    cv::Mat_<float> sol;
-    cv::solve(A, b, sol, cv::DECOMP_NORMAL | cv::DECOMP_LU);
+// Same solution as the normalized least squares formulation in OpenCV videostab (3-Clause BSD):
+// https://github.com/opencv/opencv/blob/21ee113af30a2efba8faac4811d55822ff878b0e/modules/videostab/src/global_motion.cpp#L280
+cv::Mat estimateGlobMotionLeastSquaresSimilarity(int npoints, cv::Point2f* points0, cv::Point2f* points1, float* rmse)
+{
+    const cv::Matx33f H = estimateSimilarity(npoints, points0, points1, rmse);
 
     if (rmse)
     {
-        *rmse = static_cast<float>(norm(A * sol, b, cv::NORM_L2) / std::sqrt(static_cast<double>(npoints)));
+        // Report the error in the frame of the normalized points1 (mean distance sqrt(2)):
+        const Moments m = getMoments<2>(npoints, &points0[0].x, &points0[0].y, &points1[0].x, &points1[0].y);
+        float d = 0.f;
+        for (int i = 0; i < npoints; ++i)
+        {
+            d += cv::norm(points1[i] - m.mq);
+        }
+        *rmse *= (d > 0.f) ? (std::sqrt(2.f) * float(npoints) / d) : 1.f;
     }
 
-    cv::Mat_<float> M = cv::Mat::eye(3, 3, CV_32F);
-    M(0, 0) = M(1, 1) = sol(0, 0);
-    M(0, 1) = sol(1, 0);
-    M(1, 0) = -sol(1, 0);
-    M(0, 2) = sol(2, 0);
-    M(1, 2) = sol(3, 0);
-
-    return T1.inv() * M * T0;
+    return cv::Mat(H);
 }
 
+// Closed form: s * R = [a -b; b a] with a = v1.v2 / |v1|^2, b = (v1 x v2) / |v1|^2
 cv::Matx33f estimateSimilarity(const std::array<cv::Point2f, 2>& p, const std::array<cv::Point2f, 2>& q)
 {
     const cv::Point2f v1 = (p[0] - p[1]);
     const cv::Point2f v2 = (q[0] - q[1]);
     const cv::Point2f c1 = (p[0] + p[1]) * 0.5f;
     const cv::Point2f c2 = (q[0] + q[1]) * 0.5f;
-    const float d1 = cv::norm(v1);
-    const float d2 = cv::norm(v2);
-    const float s = d2 / d1;
-
-    // Signed angle between two normalized vectors
-    const float theta = std::atan2(v1.cross(v2), v1.dot(v2));
-
-    const cv::Matx33f R = rotate(theta);
-    const cv::Matx33f S = scale(s, s);
-    const cv::Matx33f T1 = translate(-c1.x, -c1.y);
-    const cv::Matx33f T2 = translate(+c2.x, +c2.y);
-    const cv::Matx33f H = T2 * S * R * T1;
+    const float d = 1.f / v1.dot(v1);
+    const float a = v1.dot(v2) * d;
+    const float b = v1.cross(v2) * d;
 
-    return H;
+    return cv::Matx33f(a, -b, c2.x - (a * c1.x - b * c1.y), b, a, c2.y - (b * c1.x + a * c1.y), 0.f, 0.f, 1.f);
 }
 
 // Map 3x3 homography to 4x4 matrix:
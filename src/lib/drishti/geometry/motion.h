@@ -37,6 +37,15 @@ cv::Point_<T> dehomogenize(const cv::Point3_<T>& p)
 
 cv::Matx33f estimateSimilarity(const std::array<cv::Point2f, 2>& p, const std::array<cv::Point2f, 2>& q);
 
+// Closed form least squares fits mapping p to q, rmse is in q units (pixels):
+cv::Matx33f estimateSimilarity(int npoints, const cv::Point2f* p, const cv::Point2f* q, float* rmse = nullptr);
+cv::Matx33f estimateAffine(int npoints, const cv::Point2f* p, const cv::Point2f* q, float* rmse = nullptr);
+
+// Batch fits for count point sets stored as SoA arrays: x[i * npoints + j] is point j of set i.
+void estimateSimilarity(int count, int npoints, const float* px, const float* py, const float* qx, const float* qy, cv::Matx33f* H, float* rmse = nullptr);
+void estimateAffine(int count, int npoints, const float* px, const float* py, const float* qx, const float* qy, cv::Matx33f* H, float* rmse = nullptr);
+
+// Note: points0 and points1 are not modified, rmse is measured in the normalized points1 frame.
 cv::Mat estimateGlobMotionLeastSquaresSimilarity(int npoints, cv::Point2f* points0, cv::Point2f* points1, float* rmse);
 
 inline cv::Matx33f translate(float x, float y)
@@ -36,6 +36,7 @@ sugar_files(DRISHTI_GEOMETRY_HDRS_PUBLIC
   fitEllipse.h
   getPointsOnLine.h
   intersectConicLine.h  
+  intersectConicRays.h
   motion.h
   )
 
@@ -12,6 +12,12 @@
 
 #include "drishti/geometry/Ellipse.h"
 #include "drishti/geometry/intersectConicLine.h"
+#include "drishti/geometry/intersectConicRays.h"
+#include "drishti/geometry/motion.h"
+#include "drishti/geometry/Primitives.h"
+
+#include <cstdint>
+#include <vector>
 
 TEST(Ellipse, EllipseLineIntersection2)
 {
@@ -35,3 +41,142 @@ TEST(Ellipse, EllipseLineIntersection2)
 
     // assertions on order, etc
 }
+
+TEST(motion, SimilarityAndAffineBatch)
+{
+    cv::RNG rng(1);
+    const int count = 4, npoints = 16;
+    const cv::Matx33f G = transformation::translate(5.f, -3.f) * transformation::rotate(0.3f) * transformation::scale(1.7f);
+    const cv::Matx33f A(1.2f, 0.3f, 4.f, -0.2f, 0.8f, 1.f, 0.f, 0.f, 1.f);
+
+    std::vector<cv::Point2f> p(npoints), q(npoints), r(npoints);
+    std::vector<float> px, py, qx, qy;
+    for (int i = 0; i < count * npoints; i++)
+    {
+        const cv::Point2f point(rng.uniform(0.f, 100.f), rng.uniform(0.f, 100.f));
+        const cv::Point3f mapped = G * cv::Point3f(point.x, point.y, 1.f);
+        px.push_back(point.x);
+        py.push_back(point.y);
+        qx.push_back(mapped.x);
+        qy.push_back(mapped.y);
+        if (i < npoints)
+        {
+            p[i] = point;
+            q[i] = { mapped.x, mapped.y };
+            const cv::Point3f affine = A * cv::Point3f(point.x, point.y, 1.f);
+            r[i] = { affine.x, affine.y };
+        }
+    }
+
+    float rmse = 1.f;
+    EXPECT_LT(cv::norm(transformation::estimateSimilarity(npoints, p.data(), q.data(), &rmse) - G), 1e-3);
+    EXPECT_LT(rmse, 1e-3f);
+    EXPECT_LT(cv::norm(transformation::estimateAffine(npoints, p.data(), r.data()) - A), 1e-3);
+
+    // Two point closed form:
+    const cv::Matx33f H2 = transformation::estimateSimilarity({ { p[0], p[1] } }, { { q[0], q[1] } });
+    EXPECT_LT(cv::norm(H2 - G), 1e-3);
+
+    std::vector<cv::Matx33f> H(count);
+    std::vector<float> errors(count);
+    transformation::estimateSimilarity(count, npoints, px.data(), py.data(), qx.data(), qy.data(), H.data(), errors.data());
+    std::vector<cv::Matx33f> P(count);
+    drishti::geometry::procrustes(count, npoints, px.data(), py.data(), P.data());
+    for (int i = 0; i < count; i++)
+    {
+        EXPECT_LT(cv::norm(H[i] - G), 1e-3);
+        EXPECT_LT(errors[i], 1e-3f);
+
+        std::vector<cv::Point2f> set(npoints);
+        for (int j = 0; j < npoints; j++)
+        {
+            set[j] = { px[i * npoints + j], py[i * npoints + j] };
+        }
+        EXPECT_LT(cv::norm(P[i] - drishti::geometry::procrustes(set)), 1e-5);
+    }
+}
+
+TEST(Ellipse, EllipseSamplerAndBatchConversions)
+{
+    const cv::RotatedRect e({ 10.f, 20.f }, { 8.f, 4.f }, 30.f);
+
+    // Same parameterization as ellipse2Poly():
+    std::vector<cv::Point2f> contour;
+    drishti::geometry::ellipse2Poly(e, 90.f, contour);
+    ASSERT_EQ(contour.size(), 4);
+
+    const drishti::geometry::EllipseSampler sampler(4);
+    std::vector<cv::Point2f> points(sampler.size() * 2);
+    const cv::RotatedRect ellipses[2] = { e, e };
+    sampler(ellipses, 2, points.data());
+    for (int i = 0; i < sampler.size(); i++)
+    {
+        EXPECT_LT(cv::norm(points[i] - contour[i]), 1e-4);
+        EXPECT_LT(cv::norm(points[i + sampler.size()] - contour[i]), 1e-4);
+    }
+
+    float phi[10];
+    cv::RotatedRect copies[2];
+    drishti::geometry::ellipseToPhi(ellipses, 2, phi);
+    drishti::geometry::phiToEllipse(phi, 2, copies);
+    cv::Vec6d par[2];
+    drishti::geometry::conicCen2Par(ellipses, 2, par);
+    for (int i = 0; i < 2; i++)
+    {
+        EXPECT_LT(cv::norm(copies[i].center - e.center), 1e-4);
+        EXPECT_NEAR(copies[i].size.width, e.size.width, 1e-4);
+        EXPECT_NEAR(copies[i].size.height, e.size.height, 1e-4);
+        EXPECT_NEAR(copies[i].angle, e.angle, 1e-4);
+        EXPECT_EQ(par[i], drishti::geometry::conicCen2Par(e));
+    }
+}
+
+TEST(Ellipse, EllipseRayIntersectionBatch)
+{
+    const cv::RotatedRect E({ 3.f, 2.f }, { 4.f, 2.f }, 30.f);
+    const cv::Matx33f C = drishti::geometry::ConicSection_<float>(E).getMatrix();
+    const cv::Point3f c(3.2f, 2.1f, 1.f);
+
+    // Fan of rays from a point inside the ellipse:
+    const int count = 4096;
+    std::vector<float> ox(count, c.x), oy(count, c.y), dx(count), dy(count), t0(count), t1(count);
+    std::vector<std::uint8_t> hits(count);
+    for (int i = 0; i < count; i++)
+    {
+        const float theta = float(i) / count * float(2.0 * M_PI);
+        dx[i] = std::cos(theta);
+        dy[i] = std::sin(theta);
+    }
+
+    const int total = drishti::geometry::intersectConicRays(C, count, ox.data(), oy.data(), dx.data(), dy.data(), t0.data(), t1.data(), hits.data());
+    ASSERT_EQ(total, count);
+
+    // Scalar path: line through the point, then choose the intersection in the ray direction:
+    cv::Vec3f P[2];
+    std::vector<cv::Point2f> forward(count);
+    for (int i = 0; i < count; i++)
+    {
+        const cv::Point3f v(dx[i], dy[i], 0.f);
+        drishti::geometry::intersectConicLine(C, c.cross(c + v), P);
+        const cv::Point2f p[2] = { { P[0][0] / P[0][2], P[0][1] / P[0][2] }, { P[1][0] / P[1][2], P[1][1] / P[1][2] } };
+        forward[i] = p[cv::Point2f(v.x, v.y).dot(p[0] - cv::Point2f(c.x, c.y)) > 0];
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        ASSERT_GT(t0[i], 0.f);
+        ASSERT_LE(t1[i], t0[i]);
+        const cv::Point2f q(c.x + dx[i] * t0[i], c.y + dy[i] * t0[i]);
+        ASSERT_LT(cv::norm(q - forward[i]), 1e-3);
+    }
+
+    // Each face has its own conic:
+    std::vector<cv::Matx33f> conics(count, C);
+    std::vector<float> s0(count), s1(count);
+    ASSERT_EQ(drishti::geometry::intersectConicRays(count, conics.data(), ox.data(), oy.data(), dx.data(), dy.data(), s0.data(), s1.data(), hits.data()), count);
+    for (int i = 0; i < count; i++)
+    {
+        ASSERT_FLOAT_EQ(s0[i], t0[i]);
+        ASSERT_FLOAT_EQ(s1[i], t1[i]);
+    }
+}
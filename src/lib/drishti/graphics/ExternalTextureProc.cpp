@@ -0,0 +1,119 @@
+/*! -*-c++-*-
+  @file   ExternalTextureProc.cpp
+  @author David Hirvonen
+  @brief  Implementation of ogles_gpgpu shader for importing external (OES) textures and EGLImages.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/ExternalTextureProc.h"
+
+#include <cstring>
+
+// clang-format off
+#if (defined(__ANDROID__) || defined(ANDROID)) && defined(GL_TEXTURE_EXTERNAL_OES)
+#  include <EGL/egl.h>
+#  define DRISHTI_EXTERNAL_TEXTURE_OES 1
+#endif
+// clang-format on
+
+BEGIN_OGLES_GPGPU
+
+// clang-format off
+const char * ExternalTextureProc::fshaderExternalSrc =
+#if defined(DRISHTI_EXTERNAL_TEXTURE_OES)
+"#extension GL_OES_EGL_image_external : require\n"
+OG_TO_STR(precision mediump float;)
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform samplerExternalOES uInputTex;
+ void main()
+ {
+     gl_FragColor = texture2D(uInputTex, vTexCoord);
+ });
+#else
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision mediump float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ void main()
+ {
+     gl_FragColor = texture2D(uInputTex, vTexCoord);
+ });
+#endif
+// clang-format on
+
+#if defined(DRISHTI_EXTERNAL_TEXTURE_OES)
+static const GLenum kExternalTarget = GL_TEXTURE_EXTERNAL_OES;
+static PFNGLEGLIMAGETARGETTEXTURE2DOESPROC imageTargetTexture2D = nullptr;
+#else
+static const GLenum kExternalTarget = GL_TEXTURE_2D;
+#endif
+
+ExternalTextureProc::ExternalTextureProc()
+{
+}
+
+ExternalTextureProc::~ExternalTextureProc()
+{
+    if (texture)
+    {
+        glDeleteTextures(1, &texture);
+    }
+}
+
+bool ExternalTextureProc::isSupported()
+{
+#if defined(DRISHTI_EXTERNAL_TEXTURE_OES)
+    const auto* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    return extensions && std::strstr(extensions, "GL_OES_EGL_image_external");
+#else
+    return false;
+#endif
+}
+
+GLuint ExternalTextureProc::importTexture(GLuint input)
+{
+    useTexture(input, 1, kExternalTarget);
+    render();
+    return getOutputTexId();
+}
+
+GLuint ExternalTextureProc::importImage(void* image)
+{
+#if defined(DRISHTI_EXTERNAL_TEXTURE_OES)
+    if (!imageTargetTexture2D)
+    {
+        imageTargetTexture2D = reinterpret_cast<PFNGLEGLIMAGETARGETTEXTURE2DOESPROC>(eglGetProcAddress("glEGLImageTargetTexture2DOES"));
+    }
+
+    if (!image || !imageTargetTexture2D)
+    {
+        return 0;
+    }
+
+    if (!texture)
+    {
+        glGenTextures(1, &texture);
+        glBindTexture(kExternalTarget, texture);
+        glTexParameteri(kExternalTarget, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(kExternalTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(kExternalTarget, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(kExternalTarget, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // The image is sampled in place, there is no copy:
+    glBindTexture(kExternalTarget, texture);
+    imageTargetTexture2D(kExternalTarget, static_cast<GLeglImageOES>(image));
+
+    return importTexture(texture);
+#else
+    return 0;
+#endif
+}
+
+END_OGLES_GPGPU
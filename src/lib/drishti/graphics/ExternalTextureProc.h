@@ -0,0 +1,62 @@
+/*! -*-c++-*-
+  @file   ExternalTextureProc.h
+  @author David Hirvonen
+  @brief  Declaration of ogles_gpgpu shader for importing external (OES) textures and EGLImages.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef OGLES_GPGPU_COMMON_GL_EXTERNAL_TEXTURE_PROC
+#define OGLES_GPGPU_COMMON_GL_EXTERNAL_TEXTURE_PROC
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+BEGIN_OGLES_GPGPU
+
+/*
+ * Camera and decoder frames on Android live in GL_TEXTURE_EXTERNAL_OES textures (i.e.,
+ * SurfaceTexture) or EGLImages, which the sampler2D shaders of the pipeline can't read.  This
+ * renders them once to a GL_TEXTURE_2D RGBA texture, which replaces the CPU mapping and the
+ * per frame glTexImage2D upload.  Use after init() + createFBOTex() at the frame size.  On
+ * platforms without GL_OES_EGL_image_external the input is a plain 2D texture and images
+ * can't be imported.  All calls must be made from the GL thread.
+ */
+
+class ExternalTextureProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    ExternalTextureProc();
+    ~ExternalTextureProc();
+
+    virtual const char* getProcName()
+    {
+        return "ExternalTextureProc";
+    }
+
+    // Requires GL_OES_EGL_image_external (current context):
+    static bool isSupported();
+
+    // Render an external texture, returns the RGBA texture:
+    GLuint importTexture(GLuint texture);
+
+    // Bind an EGLImage (EGLImageKHR) to the internal external texture and render it, 0 on failure:
+    GLuint importImage(void* image);
+
+private:
+    virtual const char* getFragmentShaderSource()
+    {
+        return fshaderExternalSrc;
+    }
+    virtual void getUniforms() {}
+    virtual void setUniforms() {}
+
+    static const char* fshaderExternalSrc; // fragment shader source
+
+    GLuint texture = 0; // target of imported images
+};
+
+END_OGLES_GPGPU
+
+#endif // OGLES_GPGPU_COMMON_GL_EXTERNAL_TEXTURE_PROC
@@ -0,0 +1,291 @@
+/*! -*-c++-*-
+  @file   GpuTimer.cpp
+  @author David Hirvonen
+  @brief  Implementation of asynchronous GPU timing via GL_TIME_ELAPSED queries.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/GpuTimer.h"
+
+#include <cstdio>
+#include <cstring>
+
+// clang-format off
+#if defined(OGLES_GPGPU_OPENGLES)
+#  if (defined(__ANDROID__) || defined(ANDROID)) && defined(GL_TIME_ELAPSED_EXT) && defined(GL_GPU_DISJOINT_EXT)
+#    include <EGL/egl.h>
+#    define DRISHTI_GPU_TIMER_EXT 1 // GL_EXT_disjoint_timer_query (entry points from EGL)
+#  endif
+#elif defined(GL_TIME_ELAPSED)
+#  define DRISHTI_GPU_TIMER_CORE 1 // OpenGL 3.3
+#endif
+// clang-format on
+
+BEGIN_OGLES_GPGPU
+
+#if defined(DRISHTI_GPU_TIMER_EXT)
+
+static PFNGLGENQUERIESEXTPROC genQueries = nullptr;
+static PFNGLDELETEQUERIESEXTPROC deleteQueries = nullptr;
+static PFNGLBEGINQUERYEXTPROC beginQuery = nullptr;
+static PFNGLENDQUERYEXTPROC endQuery = nullptr;
+static PFNGLGETQUERYOBJECTUIVEXTPROC getQueryObjectuiv = nullptr;
+static PFNGLGETQUERYOBJECTUI64VEXTPROC getQueryObjectui64v = nullptr;
+
+static const GLenum kTimeElapsed = GL_TIME_ELAPSED_EXT;
+static const GLenum kResultAvailable = GL_QUERY_RESULT_AVAILABLE_EXT;
+static const GLenum kResult = GL_QUERY_RESULT_EXT;
+
+static bool load()
+{
+    const auto* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    if (!extensions || !std::strstr(extensions, "GL_EXT_disjoint_timer_query"))
+    {
+        return false;
+    }
+
+    genQueries = reinterpret_cast<PFNGLGENQUERIESEXTPROC>(eglGetProcAddress("glGenQueriesEXT"));
+    deleteQueries = reinterpret_cast<PFNGLDELETEQUERIESEXTPROC>(eglGetProcAddress("glDeleteQueriesEXT"));
+    beginQuery = reinterpret_cast<PFNGLBEGINQUERYEXTPROC>(eglGetProcAddress("glBeginQueryEXT"));
+    endQuery = reinterpret_cast<PFNGLENDQUERYEXTPROC>(eglGetProcAddress("glEndQueryEXT"));
+    getQueryObjectuiv = reinterpret_cast<PFNGLGETQUERYOBJECTUIVEXTPROC>(eglGetProcAddress("glGetQueryObjectuivEXT"));
+    getQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(eglGetProcAddress("glGetQueryObjectui64vEXT"));
+    return genQueries && deleteQueries && beginQuery && endQuery && getQueryObjectuiv && getQueryObjectui64v;
+}
+
+static bool isDisjoint()
+{
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    return (disjoint != 0);
+}
+
+#elif defined(DRISHTI_GPU_TIMER_CORE)
+
+static void genQueries(GLsizei n, GLuint* ids)
+{
+    glGenQueries(n, ids);
+}
+static void deleteQueries(GLsizei n, const GLuint* ids)
+{
+    glDeleteQueries(n, ids);
+}
+static void beginQuery(GLenum target, GLuint id)
+{
+    glBeginQuery(target, id);
+}
+static void endQuery(GLenum target)
+{
+    glEndQuery(target);
+}
+static void getQueryObjectuiv(GLuint id, GLenum name, GLuint* value)
+{
+    glGetQueryObjectuiv(id, name, value);
+}
+static void getQueryObjectui64v(GLuint id, GLenum name, GLuint64* value)
+{
+    glGetQueryObjectui64v(id, name, value);
+}
+
+static const GLenum kTimeElapsed = GL_TIME_ELAPSED;
+static const GLenum kResultAvailable = GL_QUERY_RESULT_AVAILABLE;
+static const GLenum kResult = GL_QUERY_RESULT;
+
+static bool load()
+{
+    int major = 0, minor = 0;
+    const auto* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    return version && (std::sscanf(version, "%d.%d", &major, &minor) == 2) && ((major > 3) || ((major == 3) && (minor >= 3)));
+}
+
+static bool isDisjoint()
+{
+    return false;
+}
+
+#endif
+
+const char* GpuTimer::getProcName()
+{
+    return "GpuTimer";
+}
+
+bool GpuTimer::isSupported()
+{
+#if defined(DRISHTI_GPU_TIMER_EXT) || defined(DRISHTI_GPU_TIMER_CORE)
+    return load();
+#else
+    return false;
+#endif
+}
+
+// ### Scope ###
+
+GpuTimer::Scope::Scope(GpuTimer* timer, const Callback& callback)
+    : m_timer(timer)
+{
+    m_timer->begin(callback);
+}
+
+GpuTimer::Scope::Scope(Scope&& src)
+    : m_timer(src.m_timer)
+{
+    src.m_timer = nullptr;
+}
+
+GpuTimer::Scope& GpuTimer::Scope::operator=(Scope&& src)
+{
+    if (this != &src)
+    {
+        if (m_timer)
+        {
+            m_timer->end();
+        }
+        m_timer = src.m_timer;
+        src.m_timer = nullptr;
+    }
+    return *this;
+}
+
+GpuTimer::Scope::~Scope()
+{
+    if (m_timer)
+    {
+        m_timer->end();
+    }
+}
+
+// ### GpuTimer ###
+
+GpuTimer::GpuTimer(std::size_t capacity)
+    : m_capacity(capacity)
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+#if defined(DRISHTI_GPU_TIMER_EXT) || defined(DRISHTI_GPU_TIMER_CORE)
+    for (const auto& segment : m_segments)
+    {
+        m_queries.push_back(segment.query);
+    }
+    if (!m_queries.empty())
+    {
+        deleteQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+    }
+#endif
+}
+
+void GpuTimer::begin(const Callback& callback)
+{
+    if (!m_stack.empty())
+    {
+        stopSegment(); // suspend the enclosing section
+    }
+
+    m_sections.emplace_back();
+    m_sections.back().callback = callback;
+
+    const std::uint64_t id = m_first + m_sections.size() - 1;
+    m_stack.push_back(id);
+    startSegment(id);
+}
+
+void GpuTimer::end()
+{
+    stopSegment();
+    section(m_stack.back()).open = false;
+    m_stack.pop_back();
+
+    if (!m_stack.empty())
+    {
+        startSegment(m_stack.back()); // resume the enclosing section
+    }
+}
+
+void GpuTimer::startSegment(std::uint64_t id)
+{
+#if defined(DRISHTI_GPU_TIMER_EXT) || defined(DRISHTI_GPU_TIMER_CORE)
+    if (m_queries.empty() && (m_segments.size() < m_capacity))
+    {
+        m_queries.resize(m_capacity - m_segments.size());
+        genQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+    }
+
+    if (!m_queries.empty())
+    {
+        m_segments.push_back({ m_queries.back(), id });
+        m_queries.pop_back();
+        section(id).outstanding++;
+        beginQuery(kTimeElapsed, m_segments.back().query);
+        m_active = true;
+        return;
+    }
+#endif
+
+    section(id).valid = false; // out of queries
+}
+
+void GpuTimer::stopSegment()
+{
+#if defined(DRISHTI_GPU_TIMER_EXT) || defined(DRISHTI_GPU_TIMER_CORE)
+    if (m_active)
+    {
+        endQuery(kTimeElapsed);
+        m_active = false;
+    }
+#endif
+}
+
+void GpuTimer::collect()
+{
+#if defined(DRISHTI_GPU_TIMER_EXT) || defined(DRISHTI_GPU_TIMER_CORE)
+    // Results of all queries in flight are undefined after a disjoint event:
+    if (isDisjoint())
+    {
+        for (const auto& segment : m_segments)
+        {
+            section(segment.section).valid = false;
+        }
+    }
+
+    // Queries complete in order, the running one (if any) is never polled:
+    while (m_segments.size() > (m_active ? 1 : 0))
+    {
+        const auto& segment = m_segments.front();
+
+        GLuint available = 0;
+        getQueryObjectuiv(segment.query, kResultAvailable, &available);
+        if (!available)
+        {
+            break;
+        }
+
+        GLuint64 elapsed = 0;
+        getQueryObjectui64v(segment.query, kResult, &elapsed);
+
+        auto& owner = section(segment.section);
+        owner.elapsed += elapsed;
+        owner.outstanding--;
+
+        m_queries.push_back(segment.query);
+        m_segments.pop_front();
+    }
+#endif
+
+    while (!m_sections.empty() && !m_sections.front().open && !m_sections.front().outstanding)
+    {
+        const auto& front = m_sections.front();
+        if (front.valid && front.callback)
+        {
+            front.callback(double(front.elapsed) * 1e-9);
+        }
+        m_sections.pop_front();
+        m_first++;
+    }
+}
+
+END_OGLES_GPGPU
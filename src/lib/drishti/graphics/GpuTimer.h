@@ -0,0 +1,138 @@
+/*! -*-c++-*-
+  @file   GpuTimer.h
+  @author David Hirvonen
+  @brief  Declaration of asynchronous GPU timing via GL_TIME_ELAPSED queries.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_graphics_GpuTimer_h__
+#define __drishti_graphics_GpuTimer_h__
+
+#include "ogles_gpgpu/common/common_includes.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+/*
+ * Time GL work with GL_TIME_ELAPSED queries (OpenGL 3.3 or GL_EXT_disjoint_timer_query).
+ * A section runs from scope() until its Scope is destroyed.  Queries can't be nested, so an
+ * open section is suspended while a nested section runs, and each section reports its own
+ * (exclusive) GPU time.  Results are collected a few frames later by collect(), which never
+ * waits for the GPU, and are passed to the callback of the section in seconds.  Sections
+ * that overlap a disjoint event (e.g., a GPU frequency change) or that ran out of queries
+ * are not reported.  All calls must be made from the GL thread.
+ */
+
+class GpuTimer
+{
+public:
+    using Callback = std::function<void(double seconds)>;
+
+    class Scope
+    {
+    public:
+        Scope() = default;
+        Scope(GpuTimer* timer, const Callback& callback);
+        Scope(Scope&& src);
+        Scope& operator=(Scope&& src);
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope();
+
+    protected:
+        GpuTimer* m_timer = nullptr;
+    };
+
+    GpuTimer(std::size_t capacity = 64); // max queries in flight
+    ~GpuTimer();
+
+    static const char* getProcName();
+
+    // Requires a current context:
+    static bool isSupported();
+
+    Scope scope(const Callback& callback)
+    {
+        return Scope(this, callback);
+    }
+
+    // Report completed sections (once per frame, outside of any section):
+    void collect();
+
+    std::size_t getPendingCount() const { return m_sections.size(); }
+
+protected:
+    struct Section
+    {
+        Callback callback;
+        std::uint64_t elapsed = 0; // nanoseconds
+        int outstanding = 0; // queries not yet collected
+        bool open = true;
+        bool valid = true;
+    };
+
+    struct Segment
+    {
+        GLuint query;
+        std::uint64_t section;
+    };
+
+    void begin(const Callback& callback);
+    void end();
+
+    void startSegment(std::uint64_t section);
+    void stopSegment();
+
+    Section& section(std::uint64_t id) { return m_sections[id - m_first]; }
+
+    std::size_t m_capacity = 64;
+    std::vector<GLuint> m_queries; // free
+    std::deque<Segment> m_segments; // issued, in order
+    std::deque<Section> m_sections; // sections m_first, m_first + 1, ...
+    std::uint64_t m_first = 0;
+    std::vector<std::uint64_t> m_stack; // open sections, innermost last
+    bool m_active = false;              // the last segment is running
+};
+
+/*
+ * Report the GPU time of any proc (i.e., ogles_gpgpu procs rendered in a filter chain):
+ */
+
+template <typename Proc>
+class GpuTimedProc : public Proc
+{
+public:
+    template <typename... Args>
+    GpuTimedProc(Args&&... args)
+        : Proc(std::forward<Args>(args)...)
+    {
+    }
+
+    void setGpuTimer(GpuTimer* timer, const GpuTimer::Callback& callback)
+    {
+        m_timer = timer;
+        m_callback = callback;
+    }
+
+    virtual int render(int position = 0)
+    {
+        auto scope = m_timer ? m_timer->scope(m_callback) : GpuTimer::Scope();
+        return Proc::render(position);
+    }
+
+protected:
+    GpuTimer* m_timer = nullptr;
+    GpuTimer::Callback m_callback;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_GpuTimer_h__
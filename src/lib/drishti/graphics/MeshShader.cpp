@@ -54,11 +54,41 @@ MeshShader::MeshShader(const cv::Mat& iso, const VertexBuffer& vertices, const C
     : texture(iso.cols, iso.rows, TEXTURE_FORMAT, const_cast<void*>(iso.ptr<void>()))
     , texUnit(1)
     , texTarget(GL_TEXTURE_2D)
-    , vertices(vertices)
-    , coords(coords)
+    , vertexCount(static_cast<GLsizei>(vertices.size()))
 {
-    MVP = glm::mat4();
+    CV_Assert(vertices.size() == coords.size());
 
+    init(coords);
+    setVertices(vertices);
+}
+
+MeshShader::MeshShader(const cv::Mat& iso, const drishti::graphics::MeshTex& mesh)
+    : texture(iso.cols, iso.rows, TEXTURE_FORMAT, const_cast<void*>(iso.ptr<void>()))
+    , texUnit(1)
+    , texTarget(GL_TEXTURE_2D)
+    , vertexCount(static_cast<GLsizei>(mesh.vertices.size()))
+{
+    CV_Assert(mesh.vertices.size() == mesh.texcoords.size());
+    CV_Assert(mesh.vertices.size() <= 0x10000); // GLushort indices (OpenGL ES 2.0)
+
+    init(mesh.texcoords);
+    setTopology(mesh.tvi);
+    setVertices(mesh.vertices);
+}
+
+MeshShader::~MeshShader()
+{
+    for (auto buffer : { positionBuffer, coordBuffer, indexBuffer })
+    {
+        if (buffer)
+        {
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+}
+
+void MeshShader::init(const CoordBuffer& coords)
+{
     // Compile utility shader:
     shader = std::make_shared<Shader>();
     if (!shader->buildFromSrc(vshaderMeshSrc, fshaderMeshSrc))
@@ -70,6 +100,26 @@ MeshShader::MeshShader(const cv::Mat& iso, const VertexBuffer& vertices, const C
     shParamATexCoord = shader->getParam(ATTR, "aTexCoord");
     shParamUInputTex = shader->getParam(UNIF, "uInputTex");
     shParamUMVP = shader->getParam(UNIF, "transformMatrix");
+
+    instances.resize(1);
+
+    // Texture coordinates are fixed for the lifetime of the mesh:
+    glGenBuffers(1, &coordBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, coordBuffer);
+    glBufferData(GL_ARRAY_BUFFER, coords.size() * sizeof(glm::vec2), coords.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers(1, &positionBuffer);
+    allocateVertices();
+
+    Tools::checkGLErr(getProcName(), "init()");
+}
+
+void MeshShader::allocateVertices()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * instances.size() * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 const char* MeshShader::getProcName()
@@ -77,9 +127,77 @@ const char* MeshShader::getProcName()
     return "MeshShader";
 }
 
-void MeshShader::setModelViewProjection(const glm::mat4& mvp)
+// Note: positions of all instances must be set again after a change in the count
+void MeshShader::setInstanceCount(int count)
+{
+    CV_Assert(count > 0);
+    if (count != static_cast<int>(instances.size()))
+    {
+        instances.resize(count);
+        allocateVertices();
+    }
+}
+
+void MeshShader::setTopology(const Triangles& tvi)
+{
+    if (indexBuffer && (tvi == topology))
+    {
+        return;
+    }
+
+    std::vector<GLushort> indices;
+    indices.reserve(tvi.size() * 3);
+    for (const auto& t : tvi)
+    {
+        for (const auto& i : t)
+        {
+            CV_Assert((i >= 0) && (i < vertexCount));
+            indices.push_back(static_cast<GLushort>(i));
+        }
+    }
+
+    if (!indexBuffer)
+    {
+        glGenBuffers(1, &indexBuffer);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    topology = tvi;
+    indexCount = static_cast<GLsizei>(indices.size());
+}
+
+void MeshShader::setVertices(const VertexBuffer& vertices, int instance)
+{
+    CV_Assert((static_cast<GLsizei>(vertices.size()) == vertexCount) && (instance >= 0) && (instance < getInstanceCount()));
+
+    const std::size_t bytes = vertexCount * sizeof(glm::vec4);
+    glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, instance * bytes, bytes, vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshShader::setTexture(const cv::Mat& iso, int instance)
+{
+    auto& target = instances[instance];
+    if (target.texture && (target.size == iso.size()))
+    {
+        glBindTexture(GL_TEXTURE_2D, target.texture->texId);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, iso.cols, iso.rows, TEXTURE_FORMAT, GL_UNSIGNED_BYTE, iso.ptr());
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    else
+    {
+        target.texture = std::make_shared<GLTexture>(iso.cols, iso.rows, TEXTURE_FORMAT, const_cast<void*>(iso.ptr<void>()));
+        target.size = iso.size();
+    }
+}
+
+void MeshShader::setModelViewProjection(const glm::mat4& mvp, int instance)
 {
-    MVP = mvp;
+    instances[instance].MVP = mvp;
 }
 
 void MeshShader::draw(int outFrameW, int outFrameH)
@@ -92,14 +210,43 @@ void MeshShader::draw(int outFrameW, int outFrameH)
 
     // set input texture
     glActiveTexture(GL_TEXTURE0 + texUnit);
-    glBindTexture(texTarget, texture.texId); // bind input texture
     glUniform1i(shParamUInputTex, texUnit);
-    glUniformMatrix4fv(shParamUMVP, 1, 0, (GLfloat*)&MVP[0][0]);
-    glEnableVertexAttribArray(shParamAPos);
-    glVertexAttribPointer(shParamAPos, 4, GL_FLOAT, GL_FALSE, 0, &vertices.data()[0]);
+
+    // Bind the shared geometry once for all instances:
+    glBindBuffer(GL_ARRAY_BUFFER, coordBuffer);
     glEnableVertexAttribArray(shParamATexCoord);
-    glVertexAttribPointer(shParamATexCoord, 2, GL_FLOAT, GL_FALSE, 0, &coords.data()[0]);
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+    glVertexAttribPointer(shParamATexCoord, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+    glEnableVertexAttribArray(shParamAPos);
+    if (indexCount)
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    }
+
+    // No instanced draw calls in OpenGL ES 2.0, so only the per instance state changes:
+    for (std::size_t i = 0; i < instances.size(); i++)
+    {
+        const auto& instance = instances[i];
+        glBindTexture(texTarget, instance.texture ? instance.texture->texId : texture.texId);
+        glUniformMatrix4fv(shParamUMVP, 1, 0, (GLfloat*)&instance.MVP[0][0]);
+
+        const std::size_t offset = i * vertexCount * sizeof(glm::vec4);
+        glVertexAttribPointer(shParamAPos, 4, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<const GLvoid*>(offset));
+        if (indexCount)
+        {
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, nullptr);
+        }
+        else
+        {
+            glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+        }
+    }
+
+    // Restore client side arrays for the ogles_gpgpu filters:
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    Tools::checkGLErr(getProcName(), "draw()");
 }
 
 END_OGLES_GPGPU
@@ -12,30 +12,64 @@
 #define __drishti_graphics_MeshShader_h__
 
 #include "drishti/graphics/GLTexture.h"
+#include "drishti/graphics/meshtex.h"
 
 #include <ogles_gpgpu/common/proc/base/filterprocbase.h>
 #include <opencv2/core.hpp>
 #include <glm/glm.hpp>
 
+#include <array>
 #include <memory>
+#include <vector>
 
 BEGIN_OGLES_GPGPU
 
+/*
+ * Geometry lives in persistent buffer objects: texture coordinates and the triangle index
+ * buffer are uploaded once (the index buffer again only when the topology changes), and only
+ * vertex positions are updated per frame with setVertices().  Several faces that share the
+ * topology (e.g., EOS meshes) are drawn as instances with their own positions, model view
+ * projection and (optionally) texture, with all buffers bound once per draw().
+ */
+
 class MeshShader
 {
 public:
     using VertexBuffer = std::vector<glm::vec4>;
     using CoordBuffer = std::vector<glm::vec2>;
+    using Triangles = std::vector<std::array<int, 3>>;
 
+    // Flat triangle list (3 vertices per triangle):
     MeshShader(const cv::Mat& iso, const VertexBuffer& vertices, const CoordBuffer& coords);
 
+    // Indexed mesh:
+    MeshShader(const cv::Mat& iso, const drishti::graphics::MeshTex& mesh);
+
+    ~MeshShader();
+
     static const char* getProcName();
 
-    void setModelViewProjection(const glm::mat4& mvp);
+    void setInstanceCount(int count);
+    int getInstanceCount() const { return static_cast<int>(instances.size()); }
+
+    void setTopology(const Triangles& tvi);
+    void setVertices(const VertexBuffer& vertices, int instance = 0);
+    void setTexture(const cv::Mat& iso, int instance);
+    void setModelViewProjection(const glm::mat4& mvp, int instance = 0);
 
     void draw(int outFrameW, int outFrameH);
 
 protected:
+    struct Instance
+    {
+        glm::mat4 MVP;
+        std::shared_ptr<GLTexture> texture; // nullptr : shared texture
+        cv::Size size;
+    };
+
+    void init(const CoordBuffer& coords);
+    void allocateVertices();
+
     std::shared_ptr<Shader> shader;
 
     static const char* vshaderMeshSrc;
@@ -50,10 +84,15 @@ protected:
     GLint shParamUInputTex;
     GLint shParamUMVP;
 
-    VertexBuffer vertices;
-    CoordBuffer coords;
+    GLuint positionBuffer = 0; // vertexCount * instances
+    GLuint coordBuffer = 0;
+    GLuint indexBuffer = 0;
+
+    GLsizei vertexCount = 0;
+    GLsizei indexCount = 0; // 0 : flat triangle list
+    Triangles topology;
 
-    glm::mat4 MVP;
+    std::vector<Instance> instances;
 };
 
 END_OGLES_GPGPU
@@ -0,0 +1,91 @@
+/*! -*-c++-*-
+  @file   MeshWarpProc.cpp
+  @author David Hirvonen
+  @brief  Implementation of ogles_gpgpu piecewise affine (triangle mesh) warp.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/MeshWarpProc.h"
+
+BEGIN_OGLES_GPGPU
+
+// clang-format off
+const char * MeshWarpProc::fshaderMeshWarpSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision mediump float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ void main()
+ {
+     gl_FragColor = texture2D(uInputTex, vTexCoord);
+ });
+// clang-format on
+
+MeshWarpProc::MeshWarpProc() {}
+
+void MeshWarpProc::setTopology(const std::vector<cv::Vec3i>& triangles)
+{
+    // GLES 2.0 only supports 16 bit indices:
+    m_indices.resize(triangles.size() * 3);
+    for (std::size_t i = 0; i < triangles.size(); i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            CV_Assert((triangles[i][j] >= 0) && (triangles[i][j] <= 0xFFFF));
+            m_indices[i * 3 + j] = static_cast<GLushort>(triangles[i][j]);
+        }
+    }
+}
+
+void MeshWarpProc::setVertices(const PointSet2f& source, const cv::Size& inputSize, const PointSet2f& target, const cv::Size& outputSize)
+{
+    CV_Assert(source.size() == target.size());
+
+    const cv::Point2f ts(1.f / inputSize.width, 1.f / inputSize.height);
+    const cv::Point2f ps(2.f / outputSize.width, 2.f / outputSize.height);
+
+    m_texels.resize(source.size());
+    m_positions.resize(target.size());
+    for (std::size_t i = 0; i < source.size(); i++)
+    {
+        m_texels[i] = { source[i].x * ts.x, source[i].y * ts.y };
+        m_positions[i] = { target[i].x * ps.x - 1.f, target[i].y * ps.y - 1.f };
+    }
+}
+
+// We will override texture and vertex coords:
+void MeshWarpProc::filterRenderSetCoords()
+{
+    // render to FBO
+    if (fbo)
+    {
+        fbo->bind();
+    }
+
+    // The mesh doesn't cover the whole frame:
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Destination point in clip space:
+    glEnableVertexAttribArray(shParamAPos);
+    glVertexAttribPointer(shParamAPos, 2, GL_FLOAT, GL_FALSE, 0, m_positions.data());
+
+    // Source point in texture space:
+    glEnableVertexAttribArray(shParamATexCoord);
+    glVertexAttribPointer(shParamATexCoord, 2, GL_FLOAT, GL_FALSE, 0, m_texels.data());
+}
+
+void MeshWarpProc::filterRenderDraw()
+{
+    if (!m_indices.empty() && !m_positions.empty())
+    {
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indices.size()), GL_UNSIGNED_SHORT, m_indices.data());
+    }
+}
+
+END_OGLES_GPGPU
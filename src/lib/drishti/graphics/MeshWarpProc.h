@@ -0,0 +1,65 @@
+/*! -*-c++-*-
+  @file   MeshWarpProc.h
+  @author David Hirvonen
+  @brief  Declaration of ogles_gpgpu piecewise affine (triangle mesh) warp.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_graphics_MeshWarpProc_h__
+#define __drishti_graphics_MeshWarpProc_h__
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+/*
+ * Renders the input texture through a triangle mesh: each vertex samples the input at its
+ * source point and is drawn at its target point, so the rasterizer performs the per triangle
+ * affine interpolation.  The topology (indices into the vertex list, e.g. landmarks) is set
+ * once per landmark scheme and only the vertex positions are updated per frame.  Pixels that
+ * are not covered by the mesh are cleared to zero.
+ */
+
+class MeshWarpProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    using PointSet2f = std::vector<cv::Point2f>;
+
+    MeshWarpProc();
+
+    virtual const char* getProcName()
+    {
+        return "MeshWarpProc";
+    }
+
+    virtual const char* getFragmentShaderSource()
+    {
+        return fshaderMeshWarpSrc;
+    }
+
+    void setTopology(const std::vector<cv::Vec3i>& triangles);
+
+    // Source points in input pixels, target points in output pixels (same order as the topology indices):
+    void setVertices(const PointSet2f& source, const cv::Size& inputSize, const PointSet2f& target, const cv::Size& outputSize);
+
+    virtual void filterRenderSetCoords();
+    virtual void filterRenderDraw();
+
+protected:
+    std::vector<GLushort> m_indices;
+    PointSet2f m_texels;    // [(0,0) (1,1)]
+    PointSet2f m_positions; // [(-1,-1) (+1,+1)]
+
+    static const char* fshaderMeshWarpSrc;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_MeshWarpProc_h__
@@ -36,10 +36,44 @@ MeshProc::MeshProc(const drishti::graphics::MeshTex& mesh, const cv::Mat& iso, b
 
     if (!iso.empty())
     {
-        drishti::graphics::MeshTex::VertexBuffer vertices;
-        drishti::graphics::MeshTex::CoordBuffer coords;
-        mesh.getTriangleList(vertices, coords);
-        meshShader = std::make_shared<MeshShader>(iso, vertices, coords);
+        // Indexed geometry in persistent buffers:
+        meshShader = std::make_shared<MeshShader>(iso, mesh);
+    }
+}
+
+void MeshProc::setInstanceCount(int count)
+{
+    if (meshShader)
+    {
+        meshShader->setInstanceCount(count);
+    }
+}
+
+void MeshProc::setModelViewProjection(const glm::mat4& mvp, int instance)
+{
+    if (meshShader)
+    {
+        meshShader->setModelViewProjection(mvp, instance);
+    }
+    if (lineShader && (instance == 0))
+    {
+        lineShader->setModelViewProjection(mvp);
+    }
+}
+
+void MeshProc::setVertices(const drishti::graphics::MeshTex::VertexBuffer& vertices, int instance)
+{
+    if (meshShader)
+    {
+        meshShader->setVertices(vertices, instance);
+    }
+}
+
+void MeshProc::setTexture(const cv::Mat& iso, int instance)
+{
+    if (meshShader)
+    {
+        meshShader->setTexture(iso, instance);
     }
 }
 
@@ -38,6 +38,12 @@ public:
 
     void setModelViewProjection(const glm::mat4& mvp);
 
+    // Additional faces sharing the mesh topology (instance 0 is the constructor mesh):
+    void setInstanceCount(int count);
+    void setModelViewProjection(const glm::mat4& mvp, int instance);
+    void setVertices(const drishti::graphics::MeshTex::VertexBuffer& vertices, int instance = 0);
+    void setTexture(const cv::Mat& iso, int instance);
+
     void setBackground(const glm::vec4& rgba)
     {
         background = rgba;
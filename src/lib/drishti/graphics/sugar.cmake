@@ -23,8 +23,11 @@ sugar_files(
 if(DRISHTI_BUILD_OGLES_GPGPU)
   sugar_files(
     DRISHTI_GRAPHICS_SRCS
+    ExternalTextureProc.cpp
+    GpuTimer.cpp
     LineShader.cpp         
     MeshShader.cpp
+    MeshWarpProc.cpp
     binomial.cpp
     mesh.cpp 
     meshtex.cpp
@@ -32,9 +35,12 @@ if(DRISHTI_BUILD_OGLES_GPGPU)
     )
   sugar_files(
     DRISHTI_GRAPHICS_HDRS_PUBLIC
+    ExternalTextureProc.h
     GLTexture.h    
+    GpuTimer.h
     LineShader.h    
     MeshShader.h
+    MeshWarpProc.h
     binomial.h
     mesh.h
     meshtex.h
@@ -0,0 +1,136 @@
+/*! -*-c++-*-
+  @file   drishti/hci/ACFTiling.cpp
+  @author David Hirvonen
+  @brief  Overlapping tile layout and assembly for ACF pyramids computed per tile.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/ACFTiling.h"
+
+#include <algorithm>
+#include <cmath>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+// Upright input pixel -> bin of a level (the same rounding for the tiles and the full levels):
+static int toBin(int x, int bins, int size)
+{
+    return static_cast<int>(std::floor(static_cast<float>(x) * static_cast<float>(bins) / static_cast<float>(size) + 0.5f));
+}
+
+// Split [0, size) into n cores, each expanded by margin (clipped to the input):
+static std::vector<std::pair<cv::Range, cv::Range>> split(int size, int n, int margin)
+{
+    std::vector<std::pair<cv::Range, cv::Range>> ranges(n);
+    for (int i = 0; i < n; i++)
+    {
+        const int begin = (i * size + n / 2) / n, end = ((i + 1) * size + n / 2) / n;
+        ranges[i].first = cv::Range(begin, end);
+        ranges[i].second = cv::Range(std::max(begin - margin, 0), std::min(end + margin, size));
+    }
+    return ranges;
+}
+
+ACFTiling::ACFTiling(const cv::Size& inputSize, const std::vector<cv::Size>& levels, int maxSize, int overlap)
+    : m_inputSize(inputSize)
+    , m_levels(levels)
+{
+    // The smallest level always stays with the full frame:
+    const int maxBins = maxSize / kShrink;
+    int count = 0;
+    while ((count + 1 < static_cast<int>(levels.size())) && ((levels[count].width > maxBins) || (levels[count].height > maxBins)))
+    {
+        count++;
+    }
+
+    if (!count || (maxBins <= 0) || !inputSize.area())
+    {
+        return;
+    }
+
+    m_tiledLevels = count;
+
+    // The overlap (bins of the smallest tiled level) in input pixels and in bins of the largest level:
+    const cv::Size& top = levels.front();
+    const cv::Size& bottom = levels[count - 1];
+    const int marginX = static_cast<int>(std::ceil(static_cast<float>(overlap * inputSize.width) / static_cast<float>(bottom.width)));
+    const int marginY = static_cast<int>(std::ceil(static_cast<float>(overlap * inputSize.height) / static_cast<float>(bottom.height)));
+    const int coreX = std::max(maxBins - 2 * toBin(marginX, top.width, inputSize.width), 1);
+    const int coreY = std::max(maxBins - 2 * toBin(marginY, top.height, inputSize.height), 1);
+    const int nx = (top.width > maxBins) ? ((top.width + coreX - 1) / coreX) : 1;
+    const int ny = (top.height > maxBins) ? ((top.height + coreY - 1) / coreY) : 1;
+
+    const auto columns = split(inputSize.width, nx, marginX);
+    const auto rows = split(inputSize.height, ny, marginY);
+    for (const auto& y : rows)
+    {
+        for (const auto& x : columns)
+        {
+            Tile tile;
+            tile.core = cv::Rect(x.first.start, y.first.start, x.first.size(), y.first.size());
+            tile.roi = cv::Rect(x.second.start, y.second.start, x.second.size(), y.second.size());
+            tile.levels.resize(count);
+            for (int i = 0; i < count; i++)
+            {
+                const int width = toBin(tile.roi.br().x, levels[i].width, inputSize.width) - toBin(tile.roi.x, levels[i].width, inputSize.width);
+                const int height = toBin(tile.roi.br().y, levels[i].height, inputSize.height) - toBin(tile.roi.y, levels[i].height, inputSize.height);
+                tile.levels[i] = { std::max(width, 1), std::max(height, 1) };
+            }
+            m_tiles.push_back(tile);
+        }
+    }
+}
+
+ACFTiling::Pyramid ACFTiling::select(const Pyramid& P, int begin, int end)
+{
+    Pyramid Q = P;
+    Q.nScales = end - begin;
+    Q.data.assign(P.data.begin() + begin, P.data.begin() + end);
+    Q.scales.assign(P.scales.begin() + begin, P.scales.begin() + end);
+    Q.scaleshw.assign(P.scaleshw.begin() + begin, P.scaleshw.begin() + end);
+    return Q;
+}
+
+ACFTiling::Pyramid ACFTiling::getLayout(const Pyramid& layout, int tile) const
+{
+    Pyramid Q = select(layout, 0, m_tiledLevels);
+    for (int i = 0; i < m_tiledLevels; i++)
+    {
+        // Transposed (col-major) channels: rows ~ x, cols ~ y
+        const auto& bins = m_tiles[tile].levels[i];
+        const auto& planes = layout.data[i][0].get();
+        Q.data[i][0] = MatP(cv::Size(bins.height, bins.width), planes[0].type(), static_cast<int>(planes.size()));
+    }
+    return Q;
+}
+
+void ACFTiling::assemble(const Pyramid& tile, int index, Pyramid& P) const
+{
+    const Tile& t = m_tiles[index];
+    for (int i = 0; i < m_tiledLevels; i++)
+    {
+        // Owned bins of the full level and the origin of the tile bins (upright):
+        const cv::Size& bins = m_levels[i];
+        const cv::Point tl(toBin(t.core.x, bins.width, m_inputSize.width), toBin(t.core.y, bins.height, m_inputSize.height));
+        const cv::Point br(toBin(t.core.br().x, bins.width, m_inputSize.width), toBin(t.core.br().y, bins.height, m_inputSize.height));
+        const cv::Point origin(toBin(t.roi.x, bins.width, m_inputSize.width), toBin(t.roi.y, bins.height, m_inputSize.height));
+
+        const auto& src = tile.data[i][0].get();
+        auto& dst = P.data[i][0].get();
+        for (int c = 0; c < static_cast<int>(std::min(src.size(), dst.size())); c++)
+        {
+            // Transposed (col-major) channels: rows ~ x, cols ~ y
+            const cv::Rect owned = cv::Rect(tl.y, tl.x, br.y - tl.y, br.x - tl.x) & cv::Rect({ 0, 0 }, dst[c].size());
+            const cv::Rect crop = (owned - cv::Point(origin.y, origin.x)) & cv::Rect({ 0, 0 }, src[c].size());
+            if (crop.area())
+            {
+                src[c](crop).copyTo(dst[c](crop + cv::Point(origin.y, origin.x)));
+            }
+        }
+    }
+}
+
+DRISHTI_HCI_NAMESPACE_END
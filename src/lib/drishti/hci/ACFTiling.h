@@ -0,0 +1,81 @@
+/*! -*-c++-*-
+  @file   drishti/hci/ACFTiling.h
+  @author David Hirvonen
+  @brief  Overlapping tile layout and assembly for ACF pyramids computed per tile.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_hci_ACFTiling_h__
+#define __drishti_hci_ACFTiling_h__
+
+#include "drishti/hci/drishti_hci.h"
+
+#include <acf/ACF.h>
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+/*
+ * The largest levels of a pyramid (those with a level texture above maxSize pixels, i.e.,
+ * 4x the upright bins) are computed on a grid of overlapping tiles of the upright input, the
+ * remaining levels on the full frame.  The tile bins are aligned with the bins of the full
+ * levels, so assembly is a copy of the bins a tile owns (its core) and the overlap, which
+ * covers the gradient, normalization and smoothing support at the tile borders of the
+ * smallest tiled level, is discarded.
+ */
+
+class ACFTiling
+{
+public:
+    using Pyramid = acf::Detector::Pyramid;
+
+    static const int kShrink = 4; // level texture pixels per bin
+
+    struct Tile
+    {
+        cv::Rect roi;                 // upright input pixels (core + overlap)
+        cv::Rect core;                // upright input pixels owned by the tile
+        std::vector<cv::Size> levels; // upright bins of the tiled levels
+    };
+
+    ACFTiling() = default;
+
+    /**
+     * @param inputSize upright input size
+     * @param levels upright bins of each pyramid level (decreasing)
+     * @param maxSize largest level texture (pixels) for a tile
+     * @param overlap bins at the tile borders of the smallest tiled level
+     */
+    ACFTiling(const cv::Size& inputSize, const std::vector<cv::Size>& levels, int maxSize, int overlap = 4);
+
+    bool empty() const { return m_tiles.empty(); }
+
+    // Levels [0, getTiledLevels()) are tiled:
+    int getTiledLevels() const { return m_tiledLevels; }
+    const std::vector<Tile>& getTiles() const { return m_tiles; }
+
+    // Levels [begin, end) of a pyramid:
+    static Pyramid select(const Pyramid& P, int begin, int end);
+
+    // Tiled levels of a pyramid layout with the bins of a tile:
+    Pyramid getLayout(const Pyramid& layout, int tile) const;
+
+    // Copy the bins owned by tile (transposed planes) into the tiled levels of P (allocated):
+    void assemble(const Pyramid& tile, int index, Pyramid& P) const;
+
+protected:
+    cv::Size m_inputSize;
+    std::vector<cv::Size> m_levels;
+    std::vector<Tile> m_tiles;
+    int m_tiledLevels = 0;
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_ACFTiling_h__
@@ -0,0 +1,48 @@
+/*! -*-c++-*-
+  @file   drishti/hci/DetectionScheduler.cpp
+  @author David Hirvonen
+  @brief  Policies for deciding when FaceFinder runs the full frame detector.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/DetectionScheduler.h"
+
+#include <algorithm>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+bool IntervalDetectionScheduler::operator()(const State& state)
+{
+    return (state.elapsed > state.interval);
+}
+
+AdaptiveDetectionScheduler::AdaptiveDetectionScheduler(const Settings& settings)
+    : m_settings(settings)
+{
+}
+
+bool AdaptiveDetectionScheduler::operator()(const State& state)
+{
+    if (state.tracks == 0)
+    {
+        return (state.elapsed > state.interval); // search at the nominal rate
+    }
+
+    if (state.misses > 0)
+    {
+        return true; // a track is coasting on prediction alone: reacquire now
+    }
+
+    const bool isStable = (state.hits >= m_settings.stableHits) &&
+        (state.motion <= m_settings.maxMotion) &&
+        (state.score >= m_settings.minScore) &&
+        (state.disagreement <= m_settings.maxDisagreement);
+
+    const double interval = isStable ? std::max(state.interval, m_settings.stableInterval) : state.interval;
+    return (state.elapsed > interval);
+}
+
+DRISHTI_HCI_NAMESPACE_END
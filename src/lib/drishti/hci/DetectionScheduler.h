@@ -0,0 +1,74 @@
+/*! -*-c++-*-
+  @file   drishti/hci/DetectionScheduler.h
+  @author David Hirvonen
+  @brief  Policies for deciding when FaceFinder runs the full frame detector.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_hci_DetectionScheduler_h__
+#define __drishti_hci_DetectionScheduler_h__
+
+#include "drishti/hci/drishti_hci.h"
+
+#include <cstddef> // std::size_t
+#include <limits>  // std::numeric_limits<>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class DetectionScheduler
+{
+public:
+    //! Track and motion summary of the most recent frames:
+    struct State
+    {
+        double elapsed = 0.0;   // seconds since the last detection
+        double interval = 0.0;  // nominal detection interval (FaceFinder::Settings::faceFinderInterval)
+        std::size_t tracks = 0; // number of active face tracks
+        std::size_t hits = 0;   // minimum consecutive hits over active tracks
+        std::size_t misses = 0; // maximum consecutive misses over active tracks
+        float motion = 0.f;     // face motion between the last two frames (meters)
+        double score = std::numeric_limits<double>::lowest(); // best score from the last detection
+        float disagreement = 0.f; // maximum landmark init disagreement over tracked faces (roi widths)
+    };
+
+    virtual ~DetectionScheduler() = default;
+
+    //! Return true if detection must be performed for the current frame:
+    virtual bool operator()(const State& state) = 0;
+};
+
+//! Detect every State::interval seconds (legacy behavior):
+class IntervalDetectionScheduler : public DetectionScheduler
+{
+public:
+    bool operator()(const State& state) override;
+};
+
+//! Detect immediately when tracks fail and rarely when all tracks are stable:
+class AdaptiveDetectionScheduler : public DetectionScheduler
+{
+public:
+    struct Settings
+    {
+        std::size_t stableHits = 10; // consecutive hits for a track to be considered stable
+        float maxMotion = 0.01f;     // maximum motion (meters per frame) for a stable scene
+        double minScore = std::numeric_limits<double>::lowest(); // minimum detection score for a stable scene
+        float maxDisagreement = std::numeric_limits<float>::max(); // maximum landmark disagreement for a stable scene
+        double stableInterval = 1.0; // detection interval (seconds) for a stable scene
+    };
+
+    AdaptiveDetectionScheduler() = default;
+    AdaptiveDetectionScheduler(const Settings& settings);
+
+    bool operator()(const State& state) override;
+
+protected:
+    Settings m_settings;
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_DetectionScheduler_h__
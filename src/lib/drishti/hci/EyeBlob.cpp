@@ -10,58 +10,128 @@
 
 #include "drishti/hci/EyeBlob.h"
 #include "drishti/geometry/motion.h"
+#include "drishti/core/filters.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 
 DRISHTI_HCI_NAMESPACE_BEGIN
 
+// Alpha bytes of two BGRA pixels, independent of the byte order:
+static std::uint64_t getAlphaMask()
+{
+    const std::uint8_t bytes[8] = { 0, 0, 0, 0xFF, 0, 0, 0, 0xFF };
+    std::uint64_t mask;
+    std::memcpy(&mask, bytes, sizeof(mask));
+    return mask;
+}
+
 EyeBlobJob::EyeBlobJob(const cv::Size& size, const std::array<drishti::eye::EyeWarp, 2>& eyeWarps)
-    : filtered(size)
-    , alpha(size)
+    : size(size)
     , eyeWarps(eyeWarps)
 {
 }
 
 void EyeBlobJob::run()
 {
-    cv::extractChannel(filtered, alpha, 3);
-    FeaturePoints points;
-    extractPoints(alpha, points, 1.f);
-    for (int i = 0; i < 2; i++)
+    struct EyeTest
     {
-        eyePoints[i] = getValidEyePoints(points, eyeWarps[i], filtered.size());
-    }
-}
+        cv::Matx33f H; // filtered image to eye model coordinates
+        drishti::geometry::ConicSection_<float> C;
+        float margin; // eyelid pruning
+    };
 
-EyeBlobJob::FeaturePoints
-EyeBlobJob::getValidEyePoints(const FeaturePoints& points, const drishti::eye::EyeWarp& eyeWarp, const cv::Size& size)
-{
-    drishti::geometry::ConicSection_<float> C(eyeWarp.eye.irisEllipse);
+    const cv::Matx33f N = transformation::normalize(size);
+    const std::array<EyeTest, 2> tests{ { { eyeWarps[0].H.inv() * N, eyeWarps[0].eye.irisEllipse, eyeWarps[0].eye.irisEllipse.size.width * 0.125f },
+        { eyeWarps[1].H.inv() * N, eyeWarps[1].eye.irisEllipse, eyeWarps[1].eye.irisEllipse.size.width * 0.125f } } };
 
-    FeaturePoints pointsOnIris;
-    const cv::Matx33f H = eyeWarp.H.inv() * transformation::normalize(size);
-    for (const auto& f : points)
+    for (auto& points : eyePoints)
     {
-        const auto& p = f.point;
-        cv::Point3f q3 = H * cv::Point3f(p.x, p.y, 1.f);
+        points.clear();
+    }
 
-        FeaturePoint q;
-        q.point = { q3.x / q3.z, q3.y / q3.z };
-        q.radius = f.radius;
+    const auto accept = [&](float x, float y, std::uint8_t value) {
+        for (int i = 0; i < 2; i++)
+        {
+            const cv::Point3f q3 = tests[i].H * cv::Point3f(x, y, 1.f);
+            const cv::Point2f q(q3.x / q3.z, q3.y / q3.z);
+            if ((tests[i].C.algebraicDistance(q) < 0.f) && (cv::pointPolygonTest(eyeWarps[i].eye.eyelids, q, true) >= tests[i].margin))
+            {
+                eyePoints[i].emplace_back(q, static_cast<float>(value) / 255.f);
+            }
+        }
+    };
 
-        if (C.algebraicDistance(q.point) < 0.f)
+    if (!peaks.empty())
+    {
+        // Each texel holds the strongest peak of a tile: (r, g) = pixel position, a = response
+        for (int y = 0; y < peaks.rows; y++)
+        {
+            for (int x = 0; x < peaks.cols; x++)
+            {
+                const cv::Vec4b& peak = peaks(y, x);
+                if (peak[3] > threshold)
+                {
+                    accept(peak[0], peak[1], peak[3]);
+                }
+            }
+        }
+    }
+    else if (!filtered.empty())
+    {
+        // The NMS response is sparse, so empty runs of 4 pixels are skipped with two word tests:
+        const std::uint64_t mask = getAlphaMask();
+        for (int y = 0; y < filtered.rows; y++)
         {
-            pointsOnIris.emplace_back(q);
+            const std::uint8_t* row = filtered.ptr<std::uint8_t>(y);
+            int x = 0;
+            for (; (x + 4) <= filtered.cols; x += 4)
+            {
+                std::uint64_t a, b;
+                std::memcpy(&a, row + x * 4, sizeof(a));
+                std::memcpy(&b, row + x * 4 + 8, sizeof(b));
+                if (((a | b) & mask) == 0)
+                {
+                    continue;
+                }
+                for (int k = x; k < (x + 4); k++)
+                {
+                    if (row[k * 4 + 3] > threshold)
+                    {
+                        accept(float(k), float(y), row[k * 4 + 3]);
+                    }
+                }
+            }
+            for (; x < filtered.cols; x++)
+            {
+                if (row[x * 4 + 3] > threshold)
+                {
+                    accept(float(x), float(y), row[x * 4 + 3]);
+                }
+            }
         }
     }
 
-    // Additional eyelid pruning:
-    const float margin = eyeWarp.eye.irisEllipse.size.width * 0.125f;
-    pointsOnIris.erase(std::remove_if(pointsOnIris.begin(), pointsOnIris.end(), [&](const FeaturePoint& p) {
-        const float d = cv::pointPolygonTest(eyeWarp.eye.eyelids, p.point, true);
-        return d < margin;
-    }),
-        pointsOnIris.end());
+    for (auto& points : eyePoints)
+    {
+        std::sort(points.begin(), points.end(), [](const FeaturePoint& pa, const FeaturePoint& pb) {
+            return (pa.radius > pb.radius);
+        });
+    }
+}
+
+void EyeBlobFilterCPU::operator()(const cv::Mat4b& eyes, cv::Mat4b& response)
+{
+    smooth.create(eyes.size());
+    hessian.create(eyes.size());
+    response.create(eyes.size());
 
-    return pointsOnIris;
+    // Same chain as ogles_gpgpu::BlobFilter, NmsProc reads channel 1 and writes alpha (swizzle(1, 3)):
+    drishti::core::binomial3x3U8(eyes.data, eyes.step, smooth.data, smooth.step, eyes.cols, eyes.rows, 4);
+    drishti::core::saturationU8C4(smooth.data, smooth.step, smooth.data, smooth.step, eyes.cols, eyes.rows, saturation);
+    drishti::core::hessian3x3U8C4(smooth.data, smooth.step, hessian.data, hessian.step, eyes.cols, eyes.rows, gain);
+    drishti::core::nms3x3U8C4(hessian.data, hessian.step, response.data, response.step, eyes.cols, eyes.rows, 1, 3);
 }
 
 DRISHTI_HCI_NAMESPACE_END
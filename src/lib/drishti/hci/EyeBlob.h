@@ -16,18 +16,44 @@
 
 DRISHTI_HCI_NAMESPACE_BEGIN
 
+/*
+ * Specular reflection points on the iris of each eye, from either the GPU reduced per tile
+ * peaks or the full resolution NMS response.  The response is scanned in place (the alpha
+ * channel of the BGRA image, skipping empty runs a word at a time) and each peak is tested
+ * against both eye models as it is found, so no channel image or intermediate point list is
+ * created.  The job owns its inputs, so it can be run on a worker thread.
+ */
+
 struct EyeBlobJob
 {
     using FeaturePoints = std::vector<FeaturePoint>;
 
     EyeBlobJob(const cv::Size& size, const std::array<drishti::eye::EyeWarp, 2>& eyeWarps);
-    FeaturePoints getValidEyePoints(const FeaturePoints& points, const drishti::eye::EyeWarp& eyeWarp, const cv::Size& size);
     void run();
 
-    cv::Mat4b filtered;
-    cv::Mat1b alpha;
-    const std::array<drishti::eye::EyeWarp, 2>& eyeWarps;
-    std::array<FeaturePoints, 2> eyePoints;
+    cv::Size size;      // filtered eye image size
+    cv::Mat4b filtered; // full resolution NMS response (optional if peaks are given)
+    cv::Mat4b peaks;    // GPU reduced peaks (see ogles_gpgpu::BlobFilter::getPeaks())
+    int threshold = 0;  // minimum response (exclusive)
+    std::array<drishti::eye::EyeWarp, 2> eyeWarps;
+    std::array<FeaturePoints, 2> eyePoints; // strongest first
+};
+
+/*
+ * CPU equivalent of ogles_gpgpu::BlobFilter for devices without usable GL: a 3x3 binomial blur
+ * (close to the radius 1 GaussOptProc), saturation, the Hessian determinant and 3x3 NMS of the
+ * Hessian response into the alpha channel.  The output is an EyeBlobJob::filtered response,
+ * the intermediate images are reused across calls of the same size.
+ */
+
+struct EyeBlobFilterCPU
+{
+    void operator()(const cv::Mat4b& eyes, cv::Mat4b& response);
+
+    float saturation = 1.f; // ogles_gpgpu::SaturationProc gain
+    float gain = 2000.f;    // ogles_gpgpu::HessianProc edge strength
+
+    cv::Mat4b smooth, hessian;
 };
 
 DRISHTI_HCI_NAMESPACE_END
@@ -13,7 +13,9 @@
 
 #include "drishti/core/drishti_operators.h"      // cv::Size * float
 #include "drishti/core/make_unique.h"            // make_unique<>
-#include "drishti/core/timing.h"                 // ScopeTimeLogger
+#include "drishti/core/scope_guard.h"            // scope_guard
+#include "drishti/core/timing.h"                 // ScopeTimeLogger, ScopeTimer
+#include "drishti/core/Profiler.h"               // DRISHTI_PROFILE_FUNCTION
 #include "drishti/face/FaceDetectorAndTracker.h" // *
 #include "drishti/geometry/Primitives.h"         // operator
 #include "drishti/geometry/motion.h"             // transformation::
@@ -21,9 +23,17 @@
 #include "drishti/core/ImageView.h"
 #include "drishti/ml/ObjectDetector.h"
 #include "drishti/ml/ObjectDetectorACF.h"
+#include "drishti/ml/NonMaximaSuppression.h"
 
+#include <opencv2/video/tracking.hpp>
+
+#include <algorithm>
+#include <cmath>
 #include <functional>
+#include <limits>
+#include <numeric>
 #include <deque>
+#include <future>
 
 #include <spdlog/fmt/ostr.h>
 
@@ -38,6 +48,7 @@
 // clang-format on
 
 static const char* sBar = "#################################################################";
+static const float kFaceWidthMeters = 0.120f; // nominal face width for distance estimates
 
 // === utility ===
 
@@ -46,7 +57,6 @@ using drishti::core::operator*;
 
 DRISHTI_HCI_NAMESPACE_BEGIN
 
-static void chooseBest(std::vector<cv::Rect>& objects, std::vector<double>& scores);
 static int getDetectionImageWidth(float, float, float, float, float);
 
 #if DRISHTI_HCI_FACEFINDER_DEBUG_PYRAMIDS
@@ -62,6 +72,10 @@ static ogles_gpgpu::Size2d convert(const cv::Size& size)
 FaceFinder::FaceFinder(FaceDetectorFactoryPtr& factory, Settings& args, void* glContext)
 {
     impl = drishti::core::make_unique<Impl>(factory, args, glContext);
+    if (impl->trace)
+    {
+        drishti::core::TraceRecorder::setActive(impl->trace.get());
+    }
 }
 
 void FaceFinder::setBrightness(float value)
@@ -79,6 +93,139 @@ void FaceFinder::setImageLogger(const ImageLogger& logger)
     impl->imageLogger = logger;
 }
 
+bool FaceFinder::dumpTrace(std::ostream& os) const
+{
+    if (impl->trace)
+    {
+        impl->trace->dump(os);
+        return true;
+    }
+    return false;
+}
+
+// Scene and pyramid buffers (pyramid planes can share one allocation):
+static std::size_t getMemoryUsage(const acf::Detector::Pyramid& P)
+{
+    std::vector<cv::Mat> planes;
+    for (const auto& level : P.data)
+    {
+        for (const auto& channels : level)
+        {
+            planes.insert(planes.end(), channels.get().begin(), channels.get().end());
+        }
+    }
+    return core::getMemoryUsage(planes);
+}
+
+static std::size_t getTextureMemoryUsage(ogles_gpgpu::ProcInterface* proc, int count = 1)
+{
+    return proc ? core::getTextureMemoryUsage(proc->getOutFrameW(), proc->getOutFrameH(), count) : 0;
+}
+
+core::MemoryUsage FaceFinder::memoryUsage() const
+{
+    core::MemoryUsage usage;
+    if (impl->faceDetector)
+    {
+        usage.add("models", impl->faceDetector->memoryUsage());
+    }
+
+    // ::: CPU :::
+    std::size_t scenes = 0;
+    for (const auto& scene : impl->scenePrimitives)
+    {
+        scenes += core::getMemoryUsage(scene.m_image) + (scene.m_P ? getMemoryUsage(*scene.m_P) : 0);
+        scenes += core::getMemoryUsage(scene.m_flow) + core::getMemoryUsage(scene.m_corners) + core::getMemoryUsage(scene.m_faces);
+    }
+    usage.add("pipeline/scenes", scenes);
+    usage.add("pipeline/pyramid", getMemoryUsage(impl->P));
+    usage.add("pipeline/eye_flow", core::getMemoryUsage(impl->eyeFlowField));
+
+    // ::: GPU (estimated) :::
+    std::size_t fifo = 0, history = 0;
+    if (impl->fifo)
+    {
+        for (auto* pass : impl->fifo->getProcPasses())
+        {
+            fifo += getTextureMemoryUsage(pass);
+        }
+    }
+    if (impl->historyFifo)
+    {
+        for (auto* pass : impl->historyFifo->getProcPasses())
+        {
+            history += getTextureMemoryUsage(pass);
+        }
+        history += getTextureMemoryUsage(impl->historyResizer.get());
+    }
+    usage.add("pipeline/fifo", 0, fifo);
+    usage.add("pipeline/history", 0, history);
+
+    // ogles_gpgpu::ACF: about three RGBA passes at each level size, the packed output channels
+    // at 1/4 resolution (three RGBA textures for LUV+M+O) and a PBO of the same size:
+    std::size_t levels = 0, channels = 0;
+    for (const auto& size : impl->pyramidSizes)
+    {
+        levels += core::getTextureMemoryUsage(size.width, size.height, 3);
+        channels += core::getTextureMemoryUsage(size.width / 4, size.height / 4, 3);
+    }
+    const bool usePBO = (impl->glVersionMajor >= 3) && impl->usePBO;
+    usage.add("pipeline/acf", 0, (levels + channels * (usePBO ? 2 : 1)) * impl->acfRing.size());
+
+    std::size_t compute = 0;
+    for (const auto& acf : impl->acfComputeRing)
+    {
+        compute += acf ? (acf->getSize() * sizeof(float)) : 0;
+    }
+    usage.add("pipeline/acf_compute", 0, compute);
+
+    usage.add("pipeline/eye_filter", 0, impl->eyeFilter ? impl->eyeFilter->getTextureMemoryUsage() : 0);
+
+    std::size_t blobs = 0;
+    if (impl->blobFilter)
+    {
+        for (auto* pass : impl->blobFilter->getProcPasses())
+        {
+            blobs += getTextureMemoryUsage(pass);
+        }
+    }
+    usage.add("pipeline/blob_filter", 0, blobs);
+
+    std::size_t eyes = getTextureMemoryUsage(impl->eyeFlow.get()) + getTextureMemoryUsage(impl->eyeFlowBgra.get()) + getTextureMemoryUsage(impl->eyeFlowTiles.get());
+    for (const auto& warp : impl->ellipsoPolar)
+    {
+        eyes += getTextureMemoryUsage(warp.get());
+    }
+    usage.add("pipeline/eye_warps", 0, eyes);
+    usage.add("pipeline/transforms", 0, getTextureMemoryUsage(impl->warper.get()) + getTextureMemoryUsage(impl->rotater.get()));
+
+    return usage;
+}
+
+void FaceFinder::updateMemoryGauges()
+{
+    const auto usage = memoryUsage();
+
+    const auto sum = [&](const std::string& prefix) {
+        std::size_t bytes = 0;
+        for (const auto& item : usage.items)
+        {
+            bytes += (item.name.compare(0, prefix.size(), prefix) == 0) ? item.cpu : 0;
+        }
+        return double(bytes);
+    };
+
+    const double detector = sum("models/detector/");
+    const double regressor = sum("models/regressor/");
+    const double eyes = sum("models/eye/");
+
+    impl->memoryDetector->set(detector);
+    impl->memoryFaceRegressor->set(regressor);
+    impl->memoryEyeModels->set(eyes);
+    impl->memoryPipelineCpu->set(double(usage.cpu()) - (detector + regressor + eyes)); // includes the detector arenas
+    impl->memoryPipelineGpu->set(double(usage.gpu()));
+}
+
 void FaceFinder::tryEnablePlatformOptimizations()
 {
     ogles_gpgpu::ACF::tryEnablePlatformOptimizations();
@@ -96,30 +243,108 @@ FaceFinder::create(FaceDetectorFactoryPtr& factory, Settings& settings, void* gl
 void FaceFinder::initialize()
 {
     impl->hasInit = true;
-    init2(*impl->factory);
+
+    // Deserialize the detector, regressors and mean face concurrently:
+    drishti::face::FaceDetectorFactoryAsync resources(impl->factory, impl->threads);
+    init2(resources);
     init(impl->sensor->intrinsic().getSize());
 }
 
 FaceFinder::~FaceFinder()
 {
+    for (auto& loader : impl->modelLoaders)
+    {
+        loader.wait(); // the loaders access impl
+    }
+
+    for (auto& readback : impl->readbacks)
+    {
+        readback.first->cancel();
+    }
+
     try
     {
         if (impl->doOptimizedPipeline)
         {
-            // If this has already been retrieved it will throw
-            impl->scene.get(); // block on any abandoned calls
+            for (auto& scene : impl->scenes)
+            {
+                // If this has already been retrieved it will throw
+                scene.get(); // block on any abandoned calls
+            }
+            for (auto& scene : impl->droppedScenes)
+            {
+                scene.get(); // block on any discarded calls
+            }
         }
     }
     catch (...)
     {
         // Noop
     }
+
+    if (impl->gpuScheduler)
+    {
+        impl->gpuScheduler->detach(impl->gpuPipeline);
+    }
 }
 
 bool FaceFinder::needsDetection(const TimePoint& now) const
 {
-    double elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - impl->objects.first).count();
-    return (elapsed > impl->faceFinderInterval);
+    DetectionScheduler::State state;
+    {
+        std::lock_guard<std::mutex> lock(impl->trackMutex);
+        state = impl->trackState;
+    }
+
+    state.elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - impl->objects.first).count();
+    state.interval = std::max(impl->faceFinderInterval, impl->quality.minInterval);
+    state.motion = static_cast<float>(cv::norm(impl->faceMotion));
+
+    // Nothing moves and nothing is tracked: search at the low duty cycle
+    if (impl->sceneChange && (state.tracks == 0) && (impl->staticFrames >= impl->staticSceneFrames))
+    {
+        state.interval = std::max(state.interval, impl->staticSceneInterval);
+    }
+
+    return (*impl->detectionScheduler)(state);
+}
+
+int FaceFinder::getQualityLevel() const
+{
+    return impl->governor ? impl->governor->getLevel() : 0;
+}
+
+// The governor only changes the level between frames:
+void FaceFinder::updateGovernor(double frameTime, const TimePoint& now)
+{
+    if (impl->governor && impl->governor->update(frameTime, std::chrono::duration<double>(now - impl->start).count()))
+    {
+        impl->quality = impl->governor->getQuality();
+        impl->qualityLevel->set(double(impl->governor->getLevel()));
+        {
+            // The next frame applies the stage hints in its detection section (see detect()):
+            std::lock_guard<std::mutex> lock(impl->sceneMutex);
+            impl->sceneQuality = impl->quality;
+            impl->qualityChanged = true;
+        }
+
+        const auto& power = impl->governor->getPowerState();
+        impl->logger->info("FaceFinder: quality level {} (frame {}s, thermal {}, battery {})", impl->governor->getLevel(), impl->governor->getFrameTime(), power.thermal, power.battery);
+    }
+}
+
+// Stage hints of a quality level (bounded by the configured hints), the detector must not be regressing:
+void FaceFinder::applyQuality(drishti::face::FaceDetector& faceDetector, const PerformanceGovernor::Quality& quality)
+{
+    const auto hint = [](int configured, int bound) {
+        const int stages = (configured >= 0) ? configured : std::numeric_limits<int>::max();
+        return (bound >= 0) ? std::min(stages, bound) : stages;
+    };
+
+    faceDetector.setFaceStagesHint(hint(impl->faceStagesHint, quality.faceStagesHint));
+    faceDetector.setEyelidStagesHint(hint(impl->eyelidStagesHint, quality.eyelidStagesHint));
+    faceDetector.setIrisStagesHint(hint(impl->irisStagesHint, quality.irisStagesHint));
+    faceDetector.setDoEyeRefinement(quality.doEyeRefinement);
 }
 
 float FaceFinder::getMinDistance() const
@@ -152,6 +377,22 @@ double FaceFinder::getFaceFinderInterval() const
     return impl->faceFinderInterval;
 }
 
+void FaceFinder::setDetectionScheduler(const std::shared_ptr<DetectionScheduler>& scheduler)
+{
+    impl->detectionScheduler = scheduler ? scheduler : std::make_shared<IntervalDetectionScheduler>();
+}
+
+void FaceFinder::setBackpressurePolicy(BackpressurePolicy policy, double frameBudget)
+{
+    impl->backpressurePolicy = policy;
+    impl->frameBudget = std::max(frameBudget, 0.0);
+}
+
+FaceFinder::BackpressureCounters FaceFinder::getBackpressureCounters() const
+{
+    return impl->backpressureCounters;
+}
+
 void FaceFinder::registerFaceMonitorCallback(FaceMonitor* callback)
 {
     impl->faceMonitorCallback.push_back(callback);
@@ -169,16 +410,34 @@ void FaceFinder::dumpEyes(ImageViews& frames, EyeModelPairs& eyes, int n, bool g
     }
 }
 
-void FaceFinder::dumpFaces(ImageViews& frames, int n, bool getImage)
+// GPU ellipso-polar warps are read back only once requested (no CPU IrisNormalizer pass):
+void FaceFinder::dumpIrises(std::array<eye::NormalizedIris, 2>& irises)
+{
+    if (impl->doIris)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            auto& warp = impl->ellipsoPolar[i];
+            if (!warp->getDoReadback())
+            {
+                warp->setDoReadback(true, (impl->glVersionMajor >= 3) && impl->usePBO);
+            }
+            irises[i] = warp->getNormalizedIris();
+        }
+    }
+}
+
+void FaceFinder::dumpFaces(ImageViews& frames, int n, bool getImage, bool getLazyImage)
 {
-    if (impl->fifo->getBufferCount() == impl->fifo->getProcPasses().size())
+    const auto& fifo = impl->getHistory();
+    if (fifo->getBufferCount() == fifo->getProcPasses().size())
     {
-        auto length = impl->fifo->getBufferCount();
+        auto length = fifo->getBufferCount();
         frames.resize(std::min(static_cast<std::size_t>(n), static_cast<std::size_t>(length)));
         for (int i = 0; i < frames.size(); i++)
         {
             // Rerverse fifo for storage such that the largest timestamp comes first
-            auto* filter = (*impl->fifo)[length - i - 1];
+            auto* filter = (*fifo)[length - i - 1];
             const auto size = filter->getOutFrameSize();
 
             // Always assign texture (no cost)
@@ -189,21 +448,75 @@ void FaceFinder::dumpFaces(ImageViews& frames, int n, bool getImage)
                 frames[i].image.create(size.height, size.width);
                 filter->getResultData(frames[i].image.ptr<uint8_t>());
             }
+            else if (getLazyImage)
+            {
+                // The texture is recycled after (length - i) more FIFO updates:
+                const cv::Size imageSize(size.width, size.height);
+                frames[i].readback = std::make_shared<core::DeferredReadback>([filter, imageSize](cv::Mat4b& image) {
+                    image.create(imageSize.height, imageSize.width);
+                    filter->getResultData(image.ptr<uint8_t>());
+                });
+                impl->readbacks.emplace_back(frames[i].readback, impl->frameIndex + length - i);
+            }
         }
     }
 }
 
+// Perform requested lazy readbacks while their FIFO textures are still valid (GL thread):
+void FaceFinder::serviceReadbacks()
+{
+    auto& readbacks = impl->readbacks;
+    readbacks.erase(std::remove_if(readbacks.begin(), readbacks.end(), [&](const decltype(impl->readbacks)::value_type& r) {
+        if (r.first->service())
+        {
+            return true;
+        }
+        if (impl->frameIndex >= r.second)
+        {
+            r.first->cancel();
+            return true;
+        }
+        return false;
+    }), readbacks.end());
+}
+
 int FaceFinder::computeDetectionWidth(const cv::Size& inputSizeUp) const
 {
     CV_Assert(impl->detector);
     
-    // TODO: Add global constant and set limits on reasonable detection size
-    const float faceWidthMeters = 0.120;
+    // TODO: Set limits on reasonable detection size
+    const float faceWidthMeters = kFaceWidthMeters;
     const float fx = impl->sensor->intrinsic().m_fx;
     const float winSize = impl->detector->getWindowSize().width;
     return getDetectionImageWidth(faceWidthMeters, fx, impl->maxDistanceMeters, winSize, inputSizeUp.width);
 }
 
+// Faces closer than minDistanceMeters fill the detection window at scale (window / face width), so
+// smaller pyramid levels are never needed.  One level step is kept as a margin.  The result is
+// used as the acf minDs, which stops the pyramid (GPU and CPU) at that level ({} : unbounded).
+cv::Size FaceFinder::computePyramidMinSize(const cv::Size& detectionSize) const
+{
+    const float fx = impl->sensor->intrinsic().m_fx;
+    if ((impl->minDistanceMeters <= 0.f) || (fx <= 0.f))
+    {
+        return {};
+    }
+
+    const float winWidth = float(impl->detector->getWindowSize().width);
+    const float faceWidth = fx * kFaceWidthMeters / impl->minDistanceMeters / impl->ACFScale; // detection pixels
+    const int nPerOct = std::max(impl->detector->opts.pPyramid->nPerOct.get(), 1);
+    const float scale = (winWidth / faceWidth) * std::pow(2.f, -1.f / float(nPerOct));
+
+    const int minSide = std::min(detectionSize.width, detectionSize.height);
+    const int size = std::min(int(float(minSide) * scale), minSide);
+    return { size, size };
+}
+
+static cv::Size maxSize(const cv::Size& a, const cv::Size& b)
+{
+    return { std::max(a.width, b.width), std::max(a.height, b.height) };
+}
+
 // Side effect: set impl->pyramdSizes
 void FaceFinder::initACF(const cv::Size& inputSizeUp)
 {
@@ -214,24 +527,33 @@ void FaceFinder::initACF(const cv::Size& inputSizeUp)
 
     // ACF implementation uses reduce resolution transposed image:
     cv::Size detectionSize = inputSizeUp * (1.0f / impl->ACFScale);
-    cv::Mat I(detectionSize.width, detectionSize.height, CV_32FC3, cv::Scalar::all(0));
+    impl->detectionSize = detectionSize;
+
+    // Only the scales for the min/max detection distance are built and scanned:
+    auto& pPyramid = impl->detector->opts.pPyramid;
+    if (!impl->acfMinDs.area())
+    {
+        impl->acfMinDs = pPyramid->minDs.get();
+    }
+    impl->pyramidMinDs = computePyramidMinSize(detectionSize);
+    pPyramid->minDs = maxSize(impl->acfMinDs, impl->pyramidMinDs);
 
-    MatP Ip(I);
-    impl->detector->computePyramid(Ip, impl->P);
+    if (!impl->pyramidBuilder)
+    {
+        impl->pyramidBuilder = core::make_unique<ml::PyramidBuilderACF>(impl->detector);
+    }
+    const auto& plan = impl->pyramidBuilder->getPlan(detectionSize);
+    impl->P = plan.layout;
 
+    // The plan levels are upright (CPU processing works with transposed images
+    // for the col-major storage assumption):
     impl->pyramidSizes.resize(impl->P.nScales);
     std::vector<ogles_gpgpu::Size2d> sizes(impl->P.nScales);
     for (int i = 0; i < impl->P.nScales; i++)
     {
-        const auto size = impl->P.data[i][0][0].size();
+        const auto& size = plan.levels[i];
         sizes[i] = { size.width * 4, size.height * 4 }; // undo ACF binning x4
         impl->pyramidSizes[i] = { size.width * 4, size.height * 4 };
-
-        // CPU processing works with tranposed images for col-major storage assumption.
-        // Undo that here to map to row major representation.  Perform this step
-        // to make transpose operation explicit.
-        std::swap(sizes[i].width, sizes[i].height);
-        std::swap(impl->pyramidSizes[i].width, impl->pyramidSizes[i].height);
     }
 
     const int grayWidth = impl->doLandmarks ? std::min(inputSizeUp.width, impl->landmarksWidth) : 0;
@@ -239,13 +561,121 @@ void FaceFinder::initACF(const cv::Size& inputSizeUp)
     const auto featureKind = ogles_gpgpu::getFeatureKind(*pChns);
 
     CV_Assert(featureKind != ogles_gpgpu::ACF::kUnknown);
+    impl->acfFeatureKind = featureKind;
+
+    // The optimized pipeline can cycle through N ACF pipelines so that frame n-N is read back
+    // while frames n-N+1...n are still in flight; glReadPixels then never waits on the GPU.
+    const bool doRing = impl->doOptimizedPipeline && impl->threads;
+    impl->acfRing.resize(doRing ? impl->readbackBuffers : 1);
+
+    // Levels with a texture above acfTileSize are computed on tiles (see initACFTiles()):
+    impl->acfTiling = (impl->acfTileSize > 0) ? ACFTiling(inputSizeUp, plan.levels, impl->acfTileSize) : ACFTiling();
+    sizes.erase(sizes.begin(), sizes.begin() + impl->acfTiling.getTiledLevels());
 
     const ogles_gpgpu::Size2d size(inputSizeUp.width, inputSizeUp.height);
-    impl->acf = std::make_shared<ogles_gpgpu::ACF>(impl->glContext, size, sizes, featureKind, grayWidth, impl->debugACF);
-    impl->acf->setRotation(impl->outputOrientation);
-    impl->acf->setLogger(impl->logger);
+    for (auto& acf : impl->acfRing)
+    {
+        acf = std::make_shared<ogles_gpgpu::ACF>(impl->glContext, size, sizes, featureKind, grayWidth, impl->debugACF);
+        acf->setRotation(impl->outputOrientation);
+        acf->setLogger(impl->logger);
+        acf->setUsePBO((impl->glVersionMajor >= 3) && impl->usePBO);
+    }
+
+    impl->acf = impl->acfRing.front();
+    impl->acfGrayscaleScale = impl->acf->getGrayscaleScale();
+
+    initACFTiles(inputSizeUp, featureKind);
+
+    // Compute shader channels (one buffer per ACF pipeline) replace the channel readback:
+    impl->acfComputeRing.clear();
+    impl->acfCompute.reset();
+
+    int colorChannels = 0;
+    switch (featureKind)
+    {
+        case ogles_gpgpu::ACF::kLUVM012345:
+            colorChannels = 3;
+            break;
+        case ogles_gpgpu::ACF::kLM012345:
+            colorChannels = 1;
+            break;
+        default:
+            break;
+    }
+
+    if (impl->doComputeACF && !impl->acfTiling.empty())
+    {
+        impl->logger->warn("FaceFinder: compute shader ACF is not supported for tiled levels, using the ACF pipeline");
+    }
+    else if (impl->doComputeACF && colorChannels && ogles_gpgpu::ACFCompute::isSupported(impl->glVersionMajor, impl->glVersionMinor))
+    {
+        std::vector<ogles_gpgpu::ACFCompute::Level> levels(impl->P.nScales);
+        for (int i = 0; i < impl->P.nScales; i++)
+        {
+            const auto size = impl->P.data[i][0][0].size(); // transposed: rows ~ x, cols ~ y
+            levels[i] = { size.height, size.width };
+        }
+
+        impl->acfComputeRing.resize(impl->acfRing.size());
+        for (auto& acfCompute : impl->acfComputeRing)
+        {
+            acfCompute = std::make_shared<ogles_gpgpu::ACFCompute>(levels, colorChannels);
+        }
+        impl->acfCompute = impl->acfComputeRing.front();
+    }
+    else if (impl->doComputeACF)
+    {
+        impl->logger->warn("FaceFinder: compute shader ACF is not supported, using the ACF pipeline");
+    }
+}
+
+// One ACF pipeline per tile and acfRing entry, each fed by a crop of the upright frame:
+void FaceFinder::initACFTiles(const cv::Size& inputSizeUp, ogles_gpgpu::ACF::FeatureKind featureKind)
+{
+    impl->acfTiles.clear();
+    impl->acfTileCrops.clear();
+    impl->acfTileRing.assign(impl->acfTiling.empty() ? 0 : impl->acfRing.size(), {});
+
+    for (const auto& tile : impl->acfTiling.getTiles())
+    {
+        // Input pixels -> tile pixels in normalized device coordinates:
+        const cv::Matx33f S = transformation::denormalize(inputSizeUp);
+        const cv::Matx33f Sinv = transformation::denormalize(tile.roi.size()).inv();
+        const cv::Matx33f T = transformation::translate(-tile.roi.x, -tile.roi.y);
+
+        cv::Matx44f MVP;
+        transformation::R3x3To4x4(Sinv * T * S, MVP);
+
+        ogles_gpgpu::Mat44f MVPt;
+        cv::Mat(MVP.t()).copyTo(cv::Mat(4, 4, CV_32FC1, &MVPt.data[0][0]));
 
-    impl->acf->setUsePBO((impl->glVersionMajor >= 3) && impl->usePBO);
+        auto crop = drishti::core::make_unique<ogles_gpgpu::TransformProc>();
+        crop->setOutputSize(tile.roi.width, tile.roi.height);
+        crop->prepare(inputSizeUp.width, inputSizeUp.height, GL_RGBA);
+        crop->setTransformMatrix(MVPt);
+        impl->acfTileCrops.push_back(std::move(crop));
+
+        std::vector<ogles_gpgpu::Size2d> sizes(tile.levels.size());
+        for (int i = 0; i < int(tile.levels.size()); i++)
+        {
+            sizes[i] = { tile.levels[i].width * 4, tile.levels[i].height * 4 }; // undo ACF binning x4
+        }
+
+        // The crop is already upright and the grayscale image comes from the full frame:
+        const ogles_gpgpu::Size2d size(tile.roi.width, tile.roi.height);
+        for (auto& tiles : impl->acfTileRing)
+        {
+            auto acf = std::make_shared<ogles_gpgpu::ACF>(impl->glContext, size, sizes, featureKind, 0, impl->debugACF);
+            acf->setLogger(impl->logger);
+            acf->setUsePBO((impl->glVersionMajor >= 3) && impl->usePBO);
+            tiles.push_back(acf);
+        }
+    }
+
+    if (!impl->acfTileRing.empty())
+    {
+        impl->acfTiles = impl->acfTileRing.front();
+    }
 }
 
 // ### Fifo ###
@@ -256,11 +686,61 @@ void FaceFinder::initFIFO(const cv::Size& inputSize, std::size_t n)
     impl->fifo->createFBOTex(false);
 }
 
+void FaceFinder::initHistory(const cv::Size& inputSize, std::size_t n)
+{
+    const cv::Size size(
+        std::max(static_cast<int>(static_cast<float>(inputSize.width) * impl->historyScale + 0.5f), 1),
+        std::max(static_cast<int>(static_cast<float>(inputSize.height) * impl->historyScale + 0.5f), 1));
+
+    impl->historyResizer = drishti::core::make_unique<ogles_gpgpu::TransformProc>();
+    impl->historyResizer->setInterpolation(ogles_gpgpu::TransformProc::BILINEAR);
+    impl->historyResizer->setOutputSize(size.width, size.height);
+    impl->historyResizer->prepare(inputSize.width, inputSize.height, GL_RGBA);
+
+    impl->historyFifo = std::make_shared<ogles_gpgpu::FifoProc>(n);
+    impl->historyFifo->init(size.width, size.height, INT_MAX, false);
+    impl->historyFifo->createFBOTex(false);
+}
+
+// Add a reduced copy of the current frame to the history (after the full resolution FIFO):
+void FaceFinder::updateHistory(GLuint inputTexId)
+{
+    if (impl->historyFifo)
+    {
+        impl->historyResizer->process(inputTexId, 1, GL_TEXTURE_2D);
+        impl->historyFifo->useTexture(impl->historyResizer->getOutputTexId(), 1);
+        impl->historyFifo->render();
+    }
+}
+
+// ### Static scene ###
+void FaceFinder::initSceneChange(const cv::Size& inputSizeUp)
+{
+    impl->sceneChange = drishti::core::make_unique<ogles_gpgpu::SceneChangeFilter>();
+    impl->sceneChange->init(inputSizeUp.width, inputSizeUp.height, INT_MAX, false);
+    impl->sceneChange->createFBOTex(false);
+}
+
+// Read the change of the previous frame (long finished on the GPU), then submit the current one:
+void FaceFinder::updateSceneChange(GLuint inputTexId)
+{
+    if (impl->sceneChange)
+    {
+        const bool isStatic = (impl->sceneChange->getChange() < impl->staticSceneThreshold);
+        impl->staticFrames = isStatic ? (impl->staticFrames + 1) : 0;
+
+        impl->sceneChange->useTexture(inputTexId, 1);
+        impl->sceneChange->render();
+    }
+}
+
 void FaceFinder::initBlobFilter()
 {
     // ### Blobs ###
     assert(impl->eyeFilter.get());
-    impl->blobFilter = drishti::core::make_unique<ogles_gpgpu::BlobFilter>();
+    auto blobFilter = drishti::core::make_unique<ogles_gpgpu::GpuTimedProc<ogles_gpgpu::BlobFilter>>();
+    blobFilter->setGpuTimer(impl->gpuTimer.get(), [this](double t) { impl->timerInfo.blobFilterGpuTimeLogger(t); });
+    impl->blobFilter = std::move(blobFilter);
     impl->blobFilter->init(128, 64, INT_MAX, false);
     impl->blobFilter->createFBOTex(false);
 
@@ -273,7 +753,9 @@ void FaceFinder::initIris(const cv::Size& size)
     // ### Ellipsopolar warper ####
     for (int i = 0; i < 2; i++)
     {
-        impl->ellipsoPolar[i] = std::make_shared<ogles_gpgpu::EllipsoPolarWarp>();
+        auto warp = std::make_shared<ogles_gpgpu::GpuTimedProc<ogles_gpgpu::EllipsoPolarWarp>>();
+        warp->setGpuTimer(impl->gpuTimer.get(), [this](double t) { impl->timerInfo.irisGpuTimeLogger(t); });
+        impl->ellipsoPolar[i] = warp;
         impl->ellipsoPolar[i]->setOutputSize(size.width, size.height);
     }
 }
@@ -309,7 +791,9 @@ void FaceFinder::initEyeEnhancer(const cv::Size& inputSizeUp, const cv::Size& ey
 
     if (impl->doEyeFlow)
     { // optical flow for eyes:
-        impl->eyeFlow = drishti::core::make_unique<ogles_gpgpu::FlowOptPipeline>(0.004, 1.0, false);
+        auto eyeFlow = drishti::core::make_unique<ogles_gpgpu::GpuTimedProc<ogles_gpgpu::FlowOptPipeline>>(0.004, 1.0, false);
+        eyeFlow->setGpuTimer(impl->gpuTimer.get(), [this](double t) { impl->timerInfo.eyeFlowGpuTimeLogger(t); });
+        impl->eyeFlow = std::move(eyeFlow);
 #if TEXTURE_FORMAT_IS_RGBA
         impl->eyeFlowBgra = drishti::core::make_unique<ogles_gpgpu::SwizzleProc>();
         impl->eyeFlow->add(impl->eyeFlowBgra.get());
@@ -318,6 +802,13 @@ void FaceFinder::initEyeEnhancer(const cv::Size& inputSizeUp, const cv::Size& ey
         impl->eyeFlowBgraInterface = impl->eyeFlow.get();
 #endif
 
+        if (impl->flowTileSize > 0)
+        { // only the tile means are read back (the raw flow texture is reduced before the swizzle):
+            impl->eyeFlowTiles = drishti::core::make_unique<ogles_gpgpu::FlowTileProc>(impl->flowTileSize);
+            impl->eyeFlowTiles->setOutputSize(1.f / static_cast<float>(impl->eyeFlowTiles->getTileSize()));
+            impl->eyeFlow->add(impl->eyeFlowTiles.get());
+        }
+
         impl->eyeFilter->add(impl->eyeFlow.get());
     }
 
@@ -375,9 +866,38 @@ void FaceFinder::init(const cv::Size& inputSize)
 
     impl->faceEstimator = std::make_shared<drishti::face::FaceModelEstimator>(*impl->sensor);
 
+    // Timed procs are configured below, so the timer comes first:
+    if (impl->doGpuTimers)
+    {
+        if (ogles_gpgpu::GpuTimer::isSupported())
+        {
+            impl->gpuTimer = drishti::core::make_unique<ogles_gpgpu::GpuTimer>();
+        }
+        else
+        {
+            impl->logger->warn("FaceFinder: GPU timer queries are not supported");
+        }
+    }
+
     initColormap();
     initACF(inputSizeUp);                     // initialize ACF first (configure opengl platform extensions)
-    initFIFO(inputSizeUp, impl->history); // keep last N frames
+
+    // The pipeline reads back pipelineDepth + readbackDelay() + 1 frames, the history serves dumpFaces():
+    const int inFlight = impl->pipelineDepth + impl->readbackDelay() + 1;
+    if (impl->historyScale < 1.f)
+    {
+        initFIFO(inputSizeUp, inFlight);
+        initHistory(inputSizeUp, impl->history);
+    }
+    else
+    {
+        initFIFO(inputSizeUp, std::max(impl->history, inFlight)); // keep last N frames
+    }
+
+    if (impl->doStaticSceneDetection)
+    {
+        initSceneChange(inputSizeUp);
+    }
     initPainter(inputSizeUp);                 // {inputSizeUp.width/4, inputSizeUp.height/4}
     initFaceFilters(inputSizeUp);             // gpu "filter" (effects)
 
@@ -397,16 +917,17 @@ void FaceFinder::init(const cv::Size& inputSize)
     
     impl->doOptimizedPipeline &= static_cast<bool>(impl->threads);
     
-    impl->latency = impl->doOptimizedPipeline ? 2 : 0;
+    impl->latency = impl->doOptimizedPipeline ? (impl->pipelineDepth + impl->readbackDelay() + 1) : 0;
 
 }
 
-template <typename Container>
-void push_fifo(Container& container, const typename Container::value_type& value, int size)
+// Scenes that fall out of the stash are recycled:
+static void push_fifo(std::deque<ScenePrimitives>& container, ScenePrimitives&& value, int size, ScenePrimitivesPool& pool)
 {
-    container.push_front(value);
-    if (container.size() > size)
+    container.push_front(std::move(value));
+    while (container.size() > std::max(size, 1))
     {
+        pool.release(std::move(container.back()));
         container.pop_back();
     }
 }
@@ -417,25 +938,61 @@ void push_fifo(Container& container, const typename Container::value_type& value
 // VIDEO |       |
 //       +=======+======== FLOW ===>
 
-std::pair<GLuint, ScenePrimitives> FaceFinder::runFast(const FrameInput& frame2, bool doDetection)
+// Run section(lock) once the turn has reached the ticket, then pass the turn on (even if section() throws):
+template <typename Section>
+static void runInTurn(std::mutex& mutex, std::condition_variable& condition, uint64_t& turn, uint64_t ticket, Section&& section)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&]() { return turn == ticket; });
+
+    core::scope_guard advance = [&]() {
+        turn++;
+        condition.notify_all();
+    };
+    section(lock);
+}
+
+std::pair<GLuint, const ScenePrimitives*> FaceFinder::runFast(const FrameInput& frame2, bool doDetection)
 {
+    DRISHTI_PROFILE_FUNCTION();
+
     FrameInput frame1;
     frame1.size = frame2.size;
 
-    ScenePrimitives scene2(impl->frameIndex), scene1, scene0, *outputScene = &scene2;
+    // With a ring of ACF pipelines, the pipeline for the current frame was last used for frame n-N:
+    const int delay = impl->readbackDelay();
+    impl->acf = impl->acfRing[impl->frameIndex % impl->acfRing.size()];
+    if (!impl->acfTileRing.empty())
+    {
+        impl->acfTiles = impl->acfTileRing[impl->frameIndex % impl->acfTileRing.size()];
+    }
+    if (!impl->acfComputeRing.empty())
+    {
+        impl->acfCompute = impl->acfComputeRing[impl->frameIndex % impl->acfComputeRing.size()];
+    }
+
+    const bool hasReadback = (impl->fifo->getBufferCount() > delay);
+    const uint64_t frameIndex1 = (impl->frameIndex > uint64_t(delay)) ? (impl->frameIndex - delay - 1) : 0;
 
-    if (impl->fifo->getBufferCount() > 0)
+    // Scenes are move-only; scene1 reuses storage from a recycled scene:
+    ScenePrimitives scene2(impl->frameIndex), scene0, *outputScene = &scene2;
+    ScenePrimitives scene1 = hasReadback ? impl->scenePool.acquire(frameIndex1) : ScenePrimitives(frameIndex1);
+    scene2.m_captureTime = impl->getCaptureTime(impl->frameIndex);
+    scene1.m_captureTime = impl->getCaptureTime(frameIndex1);
+    if (hasReadback)
     {
-        core::ScopeTimeLogger preprocessTimeLogger = [this](double t) { impl->timerInfo.acfProcessingTime = t; };
+        // Other pipelines with frames to submit run first, so the GPU stays busy while we block:
+        auto pass = impl->scheduleGpu(GpuScheduler::kReadback);
+        auto preprocessTimeLogger = core::makeScopeTimer<core::kTimingPipeline>("acf_read", *impl->readbackTime, [this](double t) { impl->timerInfo.acfProcessingTime = t; });
 
-        // read GPU results for frame n-1
+        // read GPU results for frame n-1 (n-N)
 
         // Here we always trigger GPU pipeline reads
         // to ensure upright + redeuced grayscale images will
         // be available for regression, even if we won't be using ACF detection.
         impl->acf->getChannels();
 
-        if (impl->acf->getChannelStatus())
+        if (impl->getChannelStatus())
         {
             // If the ACF textures were loaded in the last call, then we know
             // that detections were requrested for the last frame, and we will
@@ -453,37 +1010,80 @@ std::pair<GLuint, ScenePrimitives> FaceFinder::runFast(const FrameInput& frame2,
 
     // Start GPU pipeline for the current frame, immediately after we have
     // retrieved results for the previous frame.
-    computeAcf(frame2, false, doDetection);
+    {
+        auto pass = impl->scheduleGpu(GpuScheduler::kSubmit);
+        computeAcf(frame2, false, doDetection);
+        if (impl->gpuScheduler)
+        {
+            glFlush(); // start the GPU before other pipelines block on their readbacks
+        }
+    }
     GLuint texture2 = impl->acf->first()->getOutputTexId(), texture0 = 0, outputTexture = texture2;
 
-    if (impl->fifo->getBufferCount() > 0)
+    if (hasReadback)
     {
-        if (impl->fifo->getBufferCount() > 1)
+        reapDroppedScenes();
+
+        bool doRegression = true;
+        const int depth = impl->pipelineDepth;
+        if ((impl->scenes.size() >= static_cast<std::size_t>(depth)) && (impl->fifo->getBufferCount() > (depth + delay)))
         {
-            // Retrieve CPU processing for frame n-2
-            scene0 = impl->scene.get();                     // scene n-2
-            texture0 = (*impl->fifo)[-2]->getOutputTexId(); // texture n-2
-            updateEyes(texture0, scene0);                   // update the eye texture
+            // Retrieve CPU processing for frame n-(depth+delay+1) (n-2 for the default depth == 1)
+            texture0 = (*impl->fifo)[-(depth + delay + 1)]->getOutputTexId(); // texture n-(depth+delay+1)
+            if (waitForScene(doRegression))
+            {
+                scene0 = impl->scenes.front().get(); // scene n-(depth+delay+1)
+
+                auto pass = impl->scheduleGpu(GpuScheduler::kSubmit);
+                updateEyes(texture0, scene0); // update the eye texture
+                outputTexture = paint(scene0, texture0);
+            }
+            else
+            {
+                // The late job stays alive in droppedScenes, since it owns the detection ticket:
+                impl->droppedScenes.push_back(std::move(impl->scenes.front()));
+                scene0 = ScenePrimitives((frameIndex1 > uint64_t(depth)) ? (frameIndex1 - depth) : 0);
+                scene0.m_captureTime = impl->getCaptureTime(scene0.m_frameIndex);
 
-            outputTexture = paint(scene0, texture0);
+                auto pass = impl->scheduleGpu(GpuScheduler::kSubmit);
+                outputTexture = paint(scene0, texture0); // unannotated frame
+            }
+            impl->scenes.pop_front();
             outputScene = &scene0;
         }
 
-        // Run CPU detection + regression for frame n-1
-        impl->scene = impl->threads->process([scene1, frame1, this]() {
-            ScenePrimitives sceneOut = scene1;
-            detect(frame1, sceneOut, scene1.m_P != nullptr);
+        // Run CPU detection + regression for frame n-1 (the job takes ownership of scene1)
+        const uint64_t ticket = impl->sceneTicket++;
+        const bool doEyeRefinement = (impl->degradedFrames == 0) && impl->quality.doEyeRefinement;
+        const auto scene = std::make_shared<ScenePrimitives>(std::move(scene1));
+        impl->scenes.emplace_back(impl->threads->process([scene, frame1, ticket, doRegression, doEyeRefinement, this]() {
+            drishti::core::TraceRecorder::setFrameIndex(scene->m_frameIndex);
+
+            ScenePrimitives& sceneOut = *scene;
+            if (doRegression)
+            {
+                detect(frame1, sceneOut, sceneOut.m_P != nullptr, ticket, doEyeRefinement);
+            }
+            else
+            {
+                // Later frames still wait for this ticket in both sections of detect():
+                const auto pass = [](std::unique_lock<std::mutex>&) {};
+                runInTurn(impl->sceneMutex, impl->sceneCondition, impl->sceneTurn, ticket, pass);
+                runInTurn(impl->sceneMutex, impl->sceneCondition, impl->trackTurn, ticket, pass);
+            }
+
             if (doAnnotations())
             {
                 // prepare line drawings for rendering while gpu is busy
                 sceneOut.draw(impl->renderFaces, impl->renderPupils, impl->renderCorners);
             }
-            return sceneOut;
-        });
+            return std::move(sceneOut);
+        }));
     }
 
     // Maintain a history for last N textures and scenes.
     // Note that with the current optimized pipeline (i.e., runFast) we introduce a latency of T=2
+    // (T=pipelineDepth+readbackBuffers in general)
     // so when we the texture for time T=2 to the OpenGL FIFO we wil push the most recent available
     // scene for T-2 (T=0) to our scene buffer.
     //
@@ -491,29 +1091,98 @@ std::pair<GLuint, ScenePrimitives> FaceFinder::runFast(const FrameInput& frame2,
     // SCENE : { __________, __________, scene[n-2], ... }
     
     // Add the current frame to FIFO
-    impl->fifo->useTexture(texture2, 1);
-    impl->fifo->render();
+    {
+        auto pass = impl->scheduleGpu(GpuScheduler::kSubmit);
+        impl->fifo->useTexture(texture2, 1);
+        impl->fifo->render();
+        updateHistory(texture2);
+        updateSceneChange(texture2);
+    }
 
     // Clear face motion estimate, update window
     impl->faceMotion = { 0.f, 0.f, 0.f };
-    push_fifo(impl->scenePrimitives, *outputScene, impl->history);
+    push_fifo(impl->scenePrimitives, std::move(*outputScene), impl->history, impl->scenePool);
 
-    return std::make_pair(outputTexture, *outputScene);
+    return std::make_pair(outputTexture, &impl->scenePrimitives.front());
 }
 
-std::pair<GLuint, ScenePrimitives> FaceFinder::runSimple(const FrameInput& frame1, bool doDetection)
+// Wait up to Settings::frameBudget for the oldest scene job, applying the backpressure
+// policy if it is late.  Returns false if the oldest result should be discarded.
+bool FaceFinder::waitForScene(bool& doRegression)
 {
-    // Run GPU based processing on current thread and package results as a task for CPU
+    auto& counters = impl->backpressureCounters;
+    auto& pending = impl->scenes.front();
+
+    const auto budget = std::chrono::duration<double>(impl->frameBudget);
+    if (pending.wait_for(budget) == std::future_status::ready)
+    {
+        counters.onTime++;
+        if (impl->degradedFrames > 0)
+        {
+            impl->degradedFrames--;
+        }
+        return true;
+    }
+
+    switch (impl->backpressurePolicy)
+    {
+        case kDropStale:
+        case kSkipRegression:
+            // Bound the number of abandoned jobs; beyond that we have to wait:
+            if (impl->droppedScenes.size() < static_cast<std::size_t>(impl->pipelineDepth))
+            {
+                counters.dropped++;
+                impl->droppedCount->add();
+                if (impl->backpressurePolicy == kSkipRegression)
+                {
+                    counters.skipped++;
+                    doRegression = false;
+                }
+                return false;
+            }
+            break;
+
+        case kDegrade:
+            counters.degraded++;
+            impl->degradedFrames = impl->history * (impl->pipelineDepth + 1);
+            break;
+
+        case kBlock:
+        default:
+            break;
+    }
+
+    counters.blocked++;
+    return true;
+}
+
+// Release discarded scene jobs that have completed:
+void FaceFinder::reapDroppedScenes()
+{
+    auto& dropped = impl->droppedScenes;
+    while (!dropped.empty() && (dropped.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+    {
+        impl->scenePool.release(dropped.front().get());
+        dropped.pop_front();
+    }
+}
+
+std::pair<GLuint, const ScenePrimitives*> FaceFinder::runSimple(const FrameInput& frame1, bool doDetection)
+{
+    DRISHTI_PROFILE_FUNCTION();
+
+    // Run GPU based processing on current thread and package results as a task for CPU
     // processing so that it will be available on the next frame.  This method will compute
     // ACF output using shaders on the GPU, and may optionally extract other GPU related
     // features.
-    ScenePrimitives scene1(impl->frameIndex), *outputScene = nullptr; // time: n+1 and n
+    ScenePrimitives scene1 = impl->scenePool.acquire(impl->frameIndex), *outputScene = nullptr; // time: n+1 and n
+    scene1.m_captureTime = impl->getCaptureTime(impl->frameIndex);
     preprocess(frame1, scene1, doDetection);
 
     // Initialize input texture with ACF upright texture:
     GLuint texture1 = impl->acf->first()->getOutputTexId(), outputTexture = 0;
 
-    detect(frame1, scene1, doDetection);
+    detect(frame1, scene1, doDetection, impl->sceneTicket++, impl->quality.doEyeRefinement);
 
     if (doAnnotations())
     {
@@ -533,25 +1202,44 @@ std::pair<GLuint, ScenePrimitives> FaceFinder::runSimple(const FrameInput& frame
     // Add the current frame to FIFO
     impl->fifo->useTexture(texture1, 1);
     impl->fifo->render();
+    updateHistory(texture1);
+    updateSceneChange(texture1);
 
     // Clear face motion estimate, update window:
     impl->faceMotion = { 0.f, 0.f, 0.f };
-    push_fifo(impl->scenePrimitives, *outputScene, impl->history);
+    push_fifo(impl->scenePrimitives, std::move(*outputScene), impl->history, impl->scenePool);
 
-    return std::make_pair(outputTexture, *outputScene);
+    return std::make_pair(outputTexture, &impl->scenePrimitives.front());
 }
 
 GLuint FaceFinder::operator()(const FrameInput& frame1)
 {
+    return (*this)(frame1, HighResolutionClock::now());
+}
+
+GLuint FaceFinder::operator()(const FrameInput& frame1, const TimePoint& captureTime)
+{
+    drishti::core::TraceRecorder::setFrameIndex(impl->frameIndex);
+    impl->captureTimes[impl->frameIndex % impl->captureTimes.size()] = captureTime;
+
+    // Activate models loaded by updateModels() (between frames):
+    swapModels();
+
+    // Complete lazy readbacks requested since the last frame before the FIFO is updated:
+    serviceReadbacks();
+
+    // Report the GPU time of earlier frames (never waits for the GPU):
+    if (impl->gpuTimer)
+    {
+        impl->gpuTimer->collect();
+    }
+
     // clang-format off
-    std::string methodName = DRISHTI_LOCATION_SIMPLE;
-    core::ScopeTimeLogger faceFinderTimeLogger = [this, methodName](double elapsed)
+    constexpr const char* location = DRISHTI_LOCATION_STATIC;
+    core::ScopeTimeLogger faceFinderTimeLogger("frame", *impl->frameTime, [this, location](double elapsed)
     {
-        if (impl->logger)
-        {
-            impl->logger->info("TIMING:{} : {} full={}", methodName, impl->timerInfo, elapsed);
-        }
-    };
+        DRISHTI_LOG_INFO(impl->logger, "TIMING:{} : {} full={}", location, impl->timerInfo, elapsed);
+    });
     // clang-format on
 
     // Get current timestamp
@@ -559,23 +1247,31 @@ GLuint FaceFinder::operator()(const FrameInput& frame1)
     const bool doDetection = needsDetection(now);
 
     GLuint outputTexture = 0;
-    ScenePrimitives outputScene;
+    const ScenePrimitives* outputScene = nullptr; // front of the scene stash
     if (impl->doOptimizedPipeline)
     {
         std::tie(outputTexture, outputScene) = runFast(frame1, doDetection);
     }
     else
     {
+        // The simple pipeline reads back each frame immediately after rendering it:
+        auto pass = impl->scheduleGpu(GpuScheduler::kReadback);
         std::tie(outputTexture, outputScene) = runSimple(frame1, doDetection);
     }
 
-    if (impl->imageLogger && outputScene.faces().size() && !outputScene.image().empty())
+    if (impl->imageLogger && outputScene->faces().size() && !outputScene->image().empty())
     {
-        (impl->imageLogger)(outputScene.image());
+        (impl->imageLogger)(outputScene->image());
     }
 
     impl->frameIndex++; // increment frame index
 
+    // After the first frame (all pipeline buffers exist) and periodically for the scene history:
+    if ((impl->frameIndex % kMemoryUsageInterval) == 1)
+    {
+        updateMemoryGauges();
+    }
+
     if (impl->scenePrimitives.size() >= 2)
     {
         if (impl->scenePrimitives[0].faces().size() && impl->scenePrimitives[1].faces().size())
@@ -587,9 +1283,18 @@ GLuint FaceFinder::operator()(const FrameInput& frame1)
         }
     }
 
+    // During the runFast startup the output is an empty placeholder scene for the current frame:
+    if (!impl->doOptimizedPipeline || ((outputScene->m_frameIndex + 1) < impl->frameIndex))
+    {
+        impl->captureLatency->record(std::chrono::duration<double>(HighResolutionClock::now() - outputScene->m_captureTime).count());
+    }
+
+    updateGovernor(std::chrono::duration<double>(HighResolutionClock::now() - now).count(), now);
+
     try
     {
-        notifyListeners(outputScene, now, impl->fifo->isFull());
+        // Callbacks receive the capture time of the reported scene (i.e., T - latency):
+        notifyListeners(*outputScene, outputScene->m_captureTime, impl->getHistory()->isFull());
     }
     catch (...)
     {
@@ -613,7 +1318,7 @@ GLuint FaceFinder::operator()(const FrameInput& frame1)
  * SCENE : { __________, __________, scene[n-2], ... }
  */
 
-void FaceFinder::notifyListeners(const ScenePrimitives& scene, const TimePoint& now, bool isInit)
+void FaceFinder::notifyListeners(const ScenePrimitives& scene, const TimePoint& time, bool isInit)
 {
     // Perform optional frame grabbing
     // NOTE: This must occur in the main OpenGL thread:
@@ -630,7 +1335,7 @@ void FaceFinder::notifyListeners(const ScenePrimitives& scene, const TimePoint&
         for (int i = 0; i < impl->faceMonitorCallback.size(); i++)
         {
             auto& callback = impl->faceMonitorCallback[i];
-            requests[i] = callback->request(scene.faces(), now);
+            requests[i] = callback->request(scene.faces(), time);
             request |= requests[i]; // accumulate requests
         }
 
@@ -638,17 +1343,28 @@ void FaceFinder::notifyListeners(const ScenePrimitives& scene, const TimePoint&
         {
             // ### collect face images ###
             std::vector<core::ImageView> faces;
-            dumpFaces(faces, request.n, request.getImage);
+            dumpFaces(faces, request.n, request.getImage, request.getLazyImage);
 
             if (faces.size())
             {
                 frames.resize(faces.size());
                 for (int i = 0; i < frames.size(); i++)
                 {
+                    // FIFO frames are ordered from the newest (frameIndex - 1) to the oldest:
+                    frames[i].time = impl->getCaptureTime(impl->frameIndex - 1 - std::min(uint64_t(i), impl->frameIndex - 1));
                     frames[i].image = faces[i];
                     if(i >= impl->latency)
                     {
                         frames[i].faceModels = impl->scenePrimitives[i - impl->latency].faces();
+                        if (impl->historyFifo)
+                        {
+                            // Face models in the coordinates of the reduced history frames:
+                            const float s = impl->historyScale;
+                            for (auto& face : frames[i].faceModels)
+                            {
+                                face = cv::Matx33f::diag({ s, s, 1.f }) * face;
+                            }
+                        }
                     }
                     //frames[i].faceModels = impl->scenePrimitives[ impl->scenePrimitives.size() - 1 - i ].faces();
                 }
@@ -662,6 +1378,12 @@ void FaceFinder::notifyListeners(const ScenePrimitives& scene, const TimePoint&
                     frames[i].eyes = eyes[i];
                     frames[i].eyeModels = eyePairs[i];
                 }
+
+                // ### collect normalized irises ###
+                if (request.getIrises)
+                {
+                    dumpIrises(frames.front().irises);
+                }
             }
         }
     }
@@ -678,6 +1400,8 @@ void FaceFinder::notifyListeners(const ScenePrimitives& scene, const TimePoint&
             impl->faceMonitorCallback[i]->grab({}, isInit);
         }
     }
+
+    serviceReadbacks(); // handles touched during grab() from another thread
 }
 
 GLuint FaceFinder::paint(const ScenePrimitives& scene, GLuint inputTexture)
@@ -702,15 +1426,46 @@ void FaceFinder::initColormap()
 
 void FaceFinder::computeAcf(const FrameInput& frame, bool doLuv, bool doDetection)
 {
+    DRISHTI_PROFILE_FUNCTION();
+
     glDisable(GL_BLEND);
     glDisable(GL_DEPTH_TEST);
     glDisable(GL_DITHER);
     glDepthMask(GL_FALSE);
 
+    // The compute path replaces the ACF channel transfer for GPU pyramids:
+    const bool doCompute = impl->acfCompute && doDetection && !doLuv;
+
     impl->acf->setDoLuvTransfer(doLuv);
-    impl->acf->setDoAcfTrasfer(doDetection);
+    impl->acf->setDoAcfTrasfer(doDetection && !doCompute);
 
+    auto gpuTime = impl->timeGpu([this](double t) { impl->timerInfo.acfGpuTimeLogger(t); });
     (*impl->acf)(frame);
+
+    if (doCompute)
+    {
+        (*impl->acfCompute)(impl->acf->first()->getOutputTexId());
+    }
+    else if (impl->acfCompute)
+    {
+        impl->acfCompute->reset();
+    }
+
+    // The tiled levels are only needed for detection (LUV output is a full frame):
+    if (!doLuv)
+    {
+        const GLuint inputTexId = impl->acf->first()->getOutputTexId();
+        for (int i = 0; i < int(impl->acfTiles.size()); i++)
+        {
+            const auto& roi = impl->acfTiling.getTiles()[i].roi;
+            impl->acfTileCrops[i]->process(inputTexId, 1, GL_TEXTURE_2D);
+
+            auto& acf = impl->acfTiles[i];
+            acf->setDoLuvTransfer(false);
+            acf->setDoAcfTrasfer(doDetection);
+            (*acf)(FrameInput({ roi.width, roi.height }, nullptr, false, impl->acfTileCrops[i]->getOutputTexId(), GL_RGBA));
+        }
+    }
 }
 
 /*
@@ -726,14 +1481,18 @@ std::shared_ptr<acf::Detector::Pyramid> FaceFinder::createAcfGpu(const FrameInpu
     // Here we always trigger channel processing
     // to ensure grayscale images will be available
     // for regression, even if we won't be using ACF detection.
-    cv::Mat acf = impl->acf->getChannels();
+    cv::Mat acf;
+    {
+        auto readbackTimeLogger = core::makeScopeTimer<core::kTimingPipeline>("acf_read", *impl->readbackTime);
+        acf = impl->acf->getChannels();
+    }
 
     if (doDetection)
     {
         assert(acf.type() == CV_8UC1);
         assert(acf.channels() == 1);
 
-        if (impl->acf->getChannelStatus())
+        if (impl->getChannelStatus())
         {
             P = std::make_shared<decltype(impl->P)>();
             fill(*P);
@@ -794,9 +1553,9 @@ std::shared_ptr<acf::Detector::Pyramid> FaceFinder::createAcfCpu(const FrameInpu
 
 void FaceFinder::preprocess(const FrameInput& frame, ScenePrimitives& scene, bool doDetection)
 {
-    const auto tag = DRISHTI_LOCATION_SIMPLE;
+    constexpr const char* tag = DRISHTI_LOCATION_STATIC;
     std::stringstream ss;
-    core::ScopeTimeLogger scopeTimeLogger = [&](double t) { impl->logger->info("TIMING:{}{}total={}", tag, ss.str(), t); };
+    core::ScopeTimeLogger scopeTimeLogger = [&](double t) { DRISHTI_LOG_INFO(impl->logger, "TIMING:{}{}total={}", tag, ss.str(), t); };
 
     if (impl->doCpuACF)
     {
@@ -818,7 +1577,57 @@ void FaceFinder::preprocess(const FrameInput& frame, ScenePrimitives& scene, boo
 
 void FaceFinder::fill(acf::Detector::Pyramid& P)
 {
-    impl->acf->fill(P, impl->P);
+    if (impl->acfCompute && impl->acfCompute->getStatus())
+    {
+        // The buffer is laid out like the (transposed) pyramid planes: one copy per plane.
+        P = impl->P;
+        if (const GLfloat* channels = impl->acfCompute->map())
+        {
+            const int n = impl->acfCompute->getChannels();
+            for (int i = 0; i < impl->P.nScales; i++)
+            {
+                const cv::Size size = impl->P.data[i][0][0].size();
+                const GLfloat* plane = channels + impl->acfCompute->getOffset(i);
+
+                P.data[i][0] = MatP(size, CV_32F, n);
+                for (auto& dst : P.data[i][0].get())
+                {
+                    cv::Mat1f(size, const_cast<GLfloat*>(plane)).copyTo(dst);
+                    plane += size.area();
+                }
+            }
+            impl->acfCompute->unmap();
+        }
+        return;
+    }
+
+    if (impl->acfTiles.empty())
+    {
+        impl->acf->fill(P, impl->P);
+        return;
+    }
+
+    // Coarse levels [n, nScales) come from the full frame:
+    const int n = impl->acfTiling.getTiledLevels();
+    acf::Detector::Pyramid Pc;
+    impl->acf->fill(Pc, ACFTiling::select(impl->P, n, impl->P.nScales));
+
+    P = impl->P;
+    for (int i = 0; i < n; i++)
+    {
+        const auto& planes = impl->P.data[i][0].get();
+        P.data[i][0] = MatP(planes[0].size(), planes[0].type(), int(planes.size()));
+    }
+    std::copy(Pc.data.begin(), Pc.data.end(), P.data.begin() + n);
+
+    // Tiled levels [0, n) are assembled from the bins owned by each tile:
+    for (int i = 0; i < int(impl->acfTiles.size()); i++)
+    {
+        acf::Detector::Pyramid Pt;
+        impl->acfTiles[i]->getChannels();
+        impl->acfTiles[i]->fill(Pt, impl->acfTiling.getLayout(impl->P, i));
+        impl->acfTiling.assemble(Pt, i, P);
+    }
 }
 
 int FaceFinder::detectOnly(ScenePrimitives& scene, bool doDetection)
@@ -827,14 +1636,24 @@ int FaceFinder::detectOnly(ScenePrimitives& scene, bool doDetection)
     // Check to see if detection was already computed
     if (doDetection)
     {
-        core::ScopeTimeLogger scopeTimeLogger = [this](double t) { impl->timerInfo.detectionTimeLogger(t); };
+        auto scopeTimeLogger = core::makeScopeTimer<core::kTimingDetection>("acf_detection", [this](double t) { impl->timerInfo.detectionTimeLogger(t); });
         std::vector<double> scores;
-        (*impl->detector)(*scene.m_P, scene.objects(), &scores);
+        if (!detectRoi(*scene.m_P, scene.objects(), scores))
+        {
+            (*impl->detector)(*scene.m_P, scene.objects(), &scores);
+            impl->faceDetector->getDetector()->suppress(scene.objects(), scores); // raw acf::Detector output
+        }
+        filterDetections(*scene.m_P, scene.objects(), scores);
         if (impl->doSingleFace)
         {
-            chooseBest(scene.objects(), scores);
+            ml::chooseBest(scene.objects(), scores);
         }
         impl->objects = std::make_pair(HighResolutionClock::now(), scene.objects());
+
+        {
+            std::lock_guard<std::mutex> lock(impl->trackMutex);
+            impl->trackState.score = scores.empty() ? std::numeric_limits<double>::lowest() : *std::max_element(scores.begin(), scores.end());
+        }
     }
     else
     {
@@ -844,9 +1663,150 @@ int FaceFinder::detectOnly(ScenePrimitives& scene, bool doDetection)
     return scene.objects().size();
 }
 
+// Evaluate the detector only near the last detections at the pyramid levels matching
+// their size.  Each level is cropped to a small pyramid and evaluated separately, so
+// results are shifted back to the upright ACF image and suppressed across levels.
+// Returns false when a full frame scan is required instead.
+bool FaceFinder::detectRoi(const acf::Detector::Pyramid& P, std::vector<cv::Rect>& objects, std::vector<double>& scores)
+{
+    const auto& tracks = impl->objects.second;
+    if (!impl->doRoiDetection || tracks.empty() || (impl->roiDetections >= impl->roiFullScanInterval))
+    {
+        impl->roiDetections = 0;
+        return false;
+    }
+
+    const cv::Size winSize = impl->detector->getWindowSize();
+    const cv::Rect bounds({ 0, 0 }, impl->detectionSize);
+
+    objects.clear();
+    scores.clear();
+    for (const auto& track : tracks)
+    {
+        // Rank pyramid levels by log distance to the scale at which the object fills the window:
+        const float target = float(winSize.width) / float(std::max(track.width, 1));
+        std::vector<int> levels(P.nScales);
+        std::iota(levels.begin(), levels.end(), 0);
+        std::sort(levels.begin(), levels.end(), [&](int a, int b) {
+            return std::abs(std::log(P.scales[a] / target)) < std::abs(std::log(P.scales[b] / target));
+        });
+        levels.resize(std::min(static_cast<int>(levels.size()), impl->roiLevels));
+
+        const cv::Point2f pad(track.width * impl->roiMargin, track.height * impl->roiMargin);
+        const cv::Rect roi = cv::Rect(cv::Point2f(track.tl()) - pad, cv::Point2f(track.br()) + pad) & bounds;
+
+        for (auto level : levels)
+        {
+            // Channels are stored transposed (col-major): rows ~ x, cols ~ y
+            const auto& channels = P.data[level][0].get();
+            const float sx = float(channels[0].rows) / float(bounds.width);
+            const float sy = float(channels[0].cols) / float(bounds.height);
+            const cv::Rect crop = cv::Rect(int(roi.y * sy), int(roi.x * sx), int(roi.height * sy + 0.5f), int(roi.width * sx + 0.5f)) & cv::Rect({ 0, 0 }, channels[0].size());
+            if ((crop.width * 4 <= winSize.height) || (crop.height * 4 <= winSize.width))
+            {
+                continue; // crop is smaller than the detection window
+            }
+
+            std::vector<cv::Mat> cropped(channels.size());
+            for (int i = 0; i < channels.size(); i++)
+            {
+                cropped[i] = channels[i](crop);
+            }
+            cv::Mat interleaved;
+            cv::merge(cropped, interleaved);
+
+            acf::Detector::Pyramid Pi = P;
+            Pi.nScales = 1;
+            Pi.data = { { MatP(interleaved) } };
+            Pi.scales = { P.scales[level] };
+            Pi.scaleshw = { P.scaleshw[level] };
+
+            std::vector<cv::Rect> objectsi;
+            std::vector<double> scoresi;
+            (*impl->detector)(Pi, objectsi, &scoresi);
+
+            const cv::Point offset(int(crop.y / sx + 0.5f), int(crop.x / sy + 0.5f));
+            for (int i = 0; i < objectsi.size(); i++)
+            {
+                objects.push_back(objectsi[i] + offset);
+                scores.push_back(scoresi[i]);
+            }
+        }
+    }
+
+    // Greedy non-maxima suppression for detections merged from multiple pyramid levels:
+    ml::NonMaximaSuppression suppress(0.5f, ml::NonMaximaSuppression::kMin);
+    suppress(objects, scores);
+
+    // Lost everything: reacquire with a full scan on the next detection
+    impl->roiDetections = objects.empty() ? impl->roiFullScanInterval : (impl->roiDetections + 1);
+
+    return true;
+}
+
+// Mean gradient magnitude of the object at the pyramid level where it fills the detection window:
+static float getSharpness(const acf::Detector::Pyramid& P, const cv::Rect& object, int magnitude, const cv::Size& winSize, const cv::Size& detectionSize)
+{
+    const float target = float(winSize.width) / float(std::max(object.width, 1));
+    int best = 0;
+    for (int i = 1; i < P.nScales; i++)
+    {
+        if (std::abs(std::log(P.scales[i] / target)) < std::abs(std::log(P.scales[best] / target)))
+        {
+            best = i;
+        }
+    }
+
+    // Channels are stored transposed (col-major): rows ~ x, cols ~ y
+    const auto& channels = P.data[best][0].get();
+    if (magnitude >= channels.size())
+    {
+        return 0.f;
+    }
+
+    const float sx = float(channels[0].rows) / float(detectionSize.width);
+    const float sy = float(channels[0].cols) / float(detectionSize.height);
+    const cv::Rect crop = cv::Rect(int(object.y * sy), int(object.x * sx), int(object.height * sy + 0.5f), int(object.width * sx + 0.5f)) & cv::Rect({ 0, 0 }, channels[0].size());
+    return crop.area() ? float(cv::mean(channels[magnitude](crop))[0]) : 0.f;
+}
+
+// Drop poor detections with features that are already available (score, size, ACF channels),
+// so they never reach the face and eye regression:
+void FaceFinder::filterDetections(const acf::Detector::Pyramid& P, std::vector<cv::Rect>& objects, std::vector<double>& scores)
+{
+    const auto& filter = impl->qualityFilter;
+    if (filter.empty() || objects.empty())
+    {
+        return;
+    }
+
+    const int magnitude = (impl->acfFeatureKind == ogles_gpgpu::ACF::kLM012345) ? 1 : 3; // (L)M or (LUV)M
+    const cv::Size winSize = impl->detector->getWindowSize();
+    const float fx = impl->sensor->intrinsic().m_fx;
+
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < objects.size(); i++)
+    {
+        face::FaceQuality quality;
+        quality[face::FaceQuality::kScore] = static_cast<float>(scores[i]);
+        quality[face::FaceQuality::kWidth] = static_cast<float>(objects[i].width) * impl->ACFScale;
+        quality[face::FaceQuality::kDistance] = fx * kFaceWidthMeters / std::max(quality[face::FaceQuality::kWidth], 1.f);
+        quality[face::FaceQuality::kSharpness] = getSharpness(P, objects[i], magnitude, winSize, impl->detectionSize);
+        if (filter(quality))
+        {
+            objects[count] = objects[i];
+            scores[count++] = scores[i];
+        }
+    }
+
+    impl->qualityRejectCount->add(objects.size() - count);
+    objects.resize(count);
+    scores.resize(count);
+}
+
 void FaceFinder::scaleToFullResolution(std::vector<drishti::face::FaceModel>& faces)
 {
-    const float Srf = 1.0f / impl->acf->getGrayscaleScale();
+    const float Srf = 1.0f / impl->acfGrayscaleScale;
     const cv::Matx33f Hrf = transformation::scale(Srf);
     for (auto& f : faces)
     {
@@ -863,97 +1823,308 @@ void FaceFinder::scaleToFullResolution(std::vector<drishti::face::FaceModel>& fa
     }
 }
 
-int FaceFinder::detect(const FrameInput& frame, ScenePrimitives& scene, bool doDetection)
+// The faces of a frame between the sections of detect():
+struct FaceFinder::DetectionPass
+{
+    DetectionPass(const cv::Mat& image)
+        : Ib(image, { { 0, 0 }, image.size() })
+    {
+    }
+
+    drishti::face::FaceDetector::PaddedImage Ib;
+    std::shared_ptr<drishti::face::FaceDetector> faceDetector; // models of this frame (see swapModels())
+    std::vector<drishti::face::FaceModel> faces;               // detections, then missed tracks (regression image)
+    std::vector<drishti::face::FaceModel> propagated;          // by keypoint tracking
+    bool isRegressed = false;                                  // missed tracks already regressed by trackFaces()
+};
+
+// Detection and track association update the detector and tracker state, so they run in two
+// sections that frames pass in ticket order (sceneTurn, trackTurn).  The landmark and eye
+// regression of the detections and of the missed tracks runs outside of the sections, so the
+// regression of consecutive frames can overlap (see Settings::pipelineDepth).
+int FaceFinder::detect(const FrameInput& frame, ScenePrimitives& scene, bool doDetection, uint64_t ticket, bool doEyeRefinement)
 {
     //impl->logger->set_level(spdlog::level::off);
-    core::ScopeTimeLogger scopeTimeLogger = [this](double t) {
-        impl->logger->info("FULL_CPU_PATH: {}", t);
+    auto scopeTimeLogger = core::makeScopeTimer<core::kTimingDetection>("detect", [this](double t) {
+        DRISHTI_LOG_INFO(impl->logger, "FULL_CPU_PATH: {}", t);
+    });
+
+    DetectionPass pass(scene.image());
+    bool isRegressing = false, isTracked = false;
+    core::scope_guard finish = [&]() {
+        if (!isTracked)
+        {
+            // A failed regression still passes its tracking turn:
+            runInTurn(impl->sceneMutex, impl->sceneCondition, impl->trackTurn, ticket, [](std::unique_lock<std::mutex>&) {});
+        }
+        if (isRegressing)
+        {
+            std::lock_guard<std::mutex> lock(impl->sceneMutex);
+            impl->regressions--;
+            impl->sceneCondition.notify_all();
+        }
     };
 
-    // Start with empty face detections:
-    std::vector<drishti::face::FaceModel> faces;
-    drishti::face::FaceDetector::PaddedImage Ib(scene.image(), { { 0, 0 }, scene.image().size() });
+    runInTurn(impl->sceneMutex, impl->sceneCondition, impl->sceneTurn, ticket, [&](std::unique_lock<std::mutex>& lock) {
+        if (impl->qualityChanged)
+        {
+            // Stage hints reconfigure the shared regressors, so earlier frames must finish regressing:
+            impl->sceneCondition.wait(lock, [&]() { return impl->regressions == 0; });
+            applyQuality(*impl->faceDetector, impl->sceneQuality);
+            impl->qualityChanged = false;
+        }
+
+        pass.faceDetector = impl->faceDetector;
+        pass.faceDetector->setDoEyeRefinement(doEyeRefinement);
+        detectFaces(scene, doDetection, pass);
+        impl->regressions++;
+        isRegressing = true;
+    });
 
+    regressDetections(pass);
+
+    runInTurn(impl->sceneMutex, impl->sceneCondition, impl->trackTurn, ticket, [&](std::unique_lock<std::mutex>&) {
+        isTracked = true;
+        trackFaces(scene, pass);
+    });
+
+    regressTracks(scene, pass);
+
+    return 0;
+}
+
+// Detection section: (ROI) detection and the faces to regress (the caller holds sceneMutex):
+void FaceFinder::detectFaces(ScenePrimitives& scene, bool doDetection, DetectionPass& pass)
+{
     if (impl->detector && (!doDetection || scene.m_P))
     {
         if (!scene.objects().size())
         {
             detectOnly(scene, doDetection);
         }
+        if (doDetection)
+        {
+            impl->detectionCount->add();
+        }
         if (impl->doLandmarks && scene.objects().size())
         {
             const auto& objects = scene.objects();
-            faces.resize(objects.size());
-            for (int i = 0; i < faces.size(); i++)
+            pass.faces.resize(objects.size());
+            for (int i = 0; i < pass.faces.size(); i++)
             {
-                faces[i].roi = objects[i];
+                pass.faces[i].roi = objects[i];
             }
+        }
+    }
+}
 
-            //impl->imageLogger(gray);
-            const bool isDetection = true;
-            const float Sdr = impl->ACFScale /* acf->full */ * impl->acf->getGrayscaleScale() /* full->gray */;
-            const cv::Matx33f Hdr = transformation::scale(Sdr);
-            impl->faceDetector->setDoIrisRefinement(true);
-            impl->faceDetector->refine(Ib, faces, Hdr, isDetection);
+void FaceFinder::regressDetections(DetectionPass& pass)
+{
+    if (pass.faces.size())
+    {
+        //impl->imageLogger(gray);
+        const bool isDetection = true;
+        const float Sdr = impl->ACFScale /* acf->full */ * impl->acfGrayscaleScale /* full->gray */;
+        const cv::Matx33f Hdr = transformation::scale(Sdr);
+        pass.faceDetector->setDoIrisRefinement(true);
+        pass.faceDetector->refine(pass.Ib, pass.faces, Hdr, isDetection);
+
+        // Scale faces from regression to level 0.
+        // The configuration sizes used in the ACF stacked channel image
+        // are all upright, but the output texture used for the display
+        // is still in the native (potentially rotated) coordinate system,
+        // so we need to perform scaling wrt that.
+
+        scaleToFullResolution(pass.faces);
+    }
+}
 
-            // Scale faces from regression to level 0.
-            // The configuration sizes used in the ACF stacked channel image
-            // are all upright, but the output texture used for the display
-            // is still in the native (potentially rotated) coordinate system,
-            // so we need to perform scaling wrt that.
+// Tracking section: track association of the regressed detections (the caller holds sceneMutex)
+void FaceFinder::trackFaces(ScenePrimitives& scene, DetectionPass& pass)
+{
+    // Perform simple prediction on every frame.  This occurs on full resolution
+    // FaceModel objects, for which approximate location is known.  In some cases
+    // we may need to update landmarks for a track prediction which had no corresponding
+    // detection assignment for this frame, in which case we must:
+    //   1) map to regression image resolution
+    //   2) refine the face model (see regressTracks())
+    //   3) map back to the full resolution image
+
+    const float Sfr = impl->acfGrayscaleScale; // full->regression
+    const cv::Matx33f Hfr = transformation::scale(Sfr);
+    drishti::face::FaceTracker::FaceTrackVec tracksOut;
+    (*impl->faceTracker)(pass.faces, tracksOut);
+    impl->faceCount->set(double(tracksOut.size()));
 
-            scaleToFullResolution(faces);
+    {
+        // Summarize track state for the detection scheduler:
+        std::lock_guard<std::mutex> lock(impl->trackMutex);
+        impl->trackState.tracks = tracksOut.size();
+        impl->trackState.hits = tracksOut.empty() ? 0 : std::numeric_limits<std::size_t>::max();
+        impl->trackState.misses = 0;
+        for (const auto& t : tracksOut)
+        {
+            impl->trackState.hits = std::min(impl->trackState.hits, t.second.hits);
+            impl->trackState.misses = std::max(impl->trackState.misses, t.second.misses);
         }
     }
 
+    auto& faces = pass.faces;
+    faces.clear();
+    std::vector<std::size_t> identifiers; // of the faces to regress
+    for (auto& f : tracksOut)
     {
-        // Perform simple prediction on every frame.  This occurs on full resolution
-        // FaceModel objects, for which approximate location is known.  In some cases
-        // we may need to update landmarks for a track prediction which had no corresponding
-        // detection assignment for this frame, in which case we must:
-        //   1) map to regression image resolution
-        //   2) refine the face model
-        //   3) map back to the full resolution image
+        const std::size_t identifier = f.second.identifier;
 
-        const float Sfr = impl->acf->getGrayscaleScale(); // full->regression
-        const cv::Matx33f Hfr = transformation::scale(Sfr);
-        drishti::face::FaceTracker::FaceTrackVec tracksOut;
-        (*impl->faceTracker)(faces, tracksOut);
-
-        faces.clear();
-        for (auto& f : tracksOut)
+        // For any missed face we need to update the landmarks from the
+        if (f.second.misses > 0)
         {
-            // For any missed face we need to update the landmarks from the
-            if (f.second.misses > 0)
+            drishti::face::FaceModel face;
+            if (impl->doKeypointTracking && propagateKeypoints(pass.Ib.Ib, identifier, face))
             {
-                faces.push_back(Hfr * f.first); // prepare for regression
+                pass.propagated.push_back(face);
             }
             else
             {
-                scene.faces().emplace_back(f.first); // store output
+                faces.push_back(Hfr * f.first); // prepare for regression
+                identifiers.push_back(identifier);
+            }
+        }
+        else
+        {
+            scene.faces().emplace_back(f.first); // store output
+            if (impl->doKeypointTracking)
+            {
+                updateKeypoints(identifier, Hfr * f.first);
             }
         }
+    }
 
-        // Faces have been mapped to
-        impl->faceDetector->refine(Ib, faces, cv::Matx33f::eye(), false);
-        scaleToFullResolution(faces);
-        for (auto& f : faces)
+    if (impl->doKeypointTracking)
+    {
+        // The keypoints of the next frame start from these landmarks, so the missed tracks are regressed in order:
+        pass.faceDetector->refine(pass.Ib, faces, cv::Matx33f::eye(), false);
+        pass.isRegressed = true;
+        for (int i = 0; i < faces.size(); i++)
         {
-            scene.faces().emplace_back(f);
+            updateKeypoints(identifiers[i], faces[i]);
         }
 
-        // Sort near to far:
-        std::sort(scene.faces().begin(), scene.faces().end(), [](const face::FaceModel& a, const face::FaceModel& b) {
-            return (a.eyesCenter->z < b.eyesCenter->z);
-        });
+        // Drop the keypoints of lost tracks, and keep this frame for the next flow:
+        auto& tracks = impl->keypointTracks;
+        for (auto iter = tracks.begin(); iter != tracks.end();)
+        {
+            const auto isTracked = std::any_of(tracksOut.begin(), tracksOut.end(), [&](const drishti::face::FaceTracker::FaceTrack& f) {
+                return f.second.identifier == iter->first;
+            });
+            iter = isTracked ? std::next(iter) : tracks.erase(iter);
+        }
+        pass.Ib.Ib.copyTo(impl->keypointGray);
     }
+}
 
-    return 0;
+void FaceFinder::regressTracks(ScenePrimitives& scene, DetectionPass& pass)
+{
+    // The missed tracks are in regression image coordinates:
+    auto& faces = pass.faces;
+    if (!pass.isRegressed)
+    {
+        pass.faceDetector->refine(pass.Ib, faces, cv::Matx33f::eye(), false);
+    }
+    faces.insert(faces.end(), pass.propagated.begin(), pass.propagated.end());
+    scaleToFullResolution(faces);
+    for (auto& f : faces)
+    {
+        scene.faces().emplace_back(f);
+    }
+
+    {
+        // Unreliable landmarks (the regression inits disagree) keep the detector at its nominal rate,
+        // frames can finish out of order, so only the most recent one is kept:
+        std::lock_guard<std::mutex> lock(impl->trackMutex);
+        if (scene.m_frameIndex >= impl->disagreementFrame)
+        {
+            impl->disagreementFrame = scene.m_frameIndex;
+            impl->trackState.disagreement = 0.f;
+            for (const auto& f : scene.faces())
+            {
+                impl->trackState.disagreement = std::max(impl->trackState.disagreement, f.disagreement.has ? *f.disagreement : 0.f);
+            }
+        }
+    }
+
+    // Sort near to far:
+    std::sort(scene.faces().begin(), scene.faces().end(), [](const face::FaceModel& a, const face::FaceModel& b) {
+        return (a.eyesCenter->z < b.eyesCenter->z);
+    });
+}
+
+// Move the face of a track by the sparse optical flow of its landmarks from the previous frame.
+// Returns false when the track must be regressed instead: no keypoints, the regression interval
+// has elapsed, or the similarity doesn't explain the flow.
+bool FaceFinder::propagateKeypoints(const cv::Mat& gray, std::size_t identifier, drishti::face::FaceModel& face)
+{
+    auto iter = impl->keypointTracks.find(identifier);
+    if ((iter == impl->keypointTracks.end()) || (impl->keypointGray.size() != gray.size()))
+    {
+        return false;
+    }
+
+    auto& track = iter->second;
+    if ((++track.frames >= impl->keypointInterval) || (track.points.size() < 4))
+    {
+        return false;
+    }
+
+    std::vector<cv::Point2f> points;
+    std::vector<uchar> status;
+    std::vector<float> error;
+    cv::calcOpticalFlowPyrLK(impl->keypointGray, gray, track.points, points, status, error, { 15, 15 }, 2);
+
+    std::vector<cv::Point2f> p, q;
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+        if (status[i])
+        {
+            p.push_back(track.points[i]);
+            q.push_back(points[i]);
+        }
+    }
+
+    // Most landmarks must be tracked, and the fit must stay within the residual:
+    float rmse = std::numeric_limits<float>::max();
+    if ((p.size() * 2) < track.points.size())
+    {
+        return false;
+    }
+    const cv::Matx33f H = transformation::estimateSimilarity(int(p.size()), p.data(), q.data(), &rmse);
+    if (rmse > impl->keypointResidual)
+    {
+        return false;
+    }
+
+    for (auto& point : track.points)
+    {
+        const cv::Point3f r = H * cv::Point3f(point.x, point.y, 1.f);
+        point = { r.x, r.y };
+    }
+    track.face = H * track.face;
+    face = track.face;
+    return true;
+}
+
+// The keypoints of a (regressed) face in regression image coordinates:
+void FaceFinder::updateKeypoints(std::size_t identifier, const drishti::face::FaceModel& face)
+{
+    auto& track = impl->keypointTracks[identifier];
+    track.face = face;
+    track.points = face.points.has ? face.points.get() : std::vector<cv::Point2f>();
+    track.frames = 0;
 }
 
 void FaceFinder::updateEyes(GLuint inputTexId, const ScenePrimitives& scene)
 {
-    core::ScopeTimeLogger updateEyesLoge = [this](double t) { impl->logger->info("FaceFinder::updateEyes={}", t); };
+    auto updateEyesLoge = core::makeScopeTimer<core::kTimingPipeline>("update_eyes", [this](double t) { DRISHTI_LOG_INFO(impl->logger, "FaceFinder::updateEyes={}", t); });
 
     if (scene.faces().size())
     {
@@ -962,13 +2133,43 @@ void FaceFinder::updateEyes(GLuint inputTexId, const ScenePrimitives& scene)
             impl->eyeFilter->addFace(f);
         }
 
-        // Trigger eye enhancer, triggers flash filter:
-        impl->eyeFilter->process(inputTexId, 1, GL_TEXTURE_2D);
+        // Trigger eye enhancer, triggers flash filter (the timed procs in the chain report their own time):
+        {
+            auto gpuTime = impl->timeGpu([this](double t) { impl->timerInfo.eyeFilterGpuTimeLogger(t); });
+            impl->eyeFilter->process(inputTexId, 1, GL_TEXTURE_2D);
+        }
 
         // Limit to points on iris:
         const auto& eyeWarps = impl->eyeFilter->getEyeWarps();
 
-        if (impl->doEyeFlow)
+        std::shared_ptr<EyeBlobJob> blob;
+        std::future<void> blobDone;
+        if (impl->blobFilter && impl->quality.doBlobs)
+        { // Grab reflection points for eye tracking etc:
+            const cv::Size filteredEyeSize(impl->blobFilter->getOutFrameW(), impl->blobFilter->getOutFrameH());
+            blob = std::make_shared<EyeBlobJob>(filteredEyeSize, eyeWarps);
+
+            // Only the per tile maxima are read back, the NMS response stays on the GPU:
+            auto* peaks = impl->blobFilter->getPeaks();
+            blob->peaks.create(peaks->getOutFrameH(), peaks->getOutFrameW());
+            peaks->getResultData(blob->peaks.ptr());
+
+            // The point extraction overlaps the eye flow readback below (the job owns its inputs):
+            if (impl->threads)
+            {
+                blobDone = impl->threads->process([blob]() { blob->run(); });
+            }
+            else
+            {
+                blob->run();
+            }
+        }
+
+        if (impl->eyeFlowTiles && impl->quality.doFlow)
+        { // Grab the tile means of the optical flow:
+            updateEyeFlowTiles();
+        }
+        else if (impl->doEyeFlow && impl->quality.doFlow)
         { // Grab optical flow results:
             const auto flowSize = impl->eyeFlowBgraInterface->getOutFrameSize();
             cv::Mat4b ayxb(flowSize.height, flowSize.width);
@@ -1005,21 +2206,73 @@ void FaceFinder::updateEyes(GLuint inputTexId, const ScenePrimitives& scene)
             }
         }
 
-        if (impl->blobFilter)
-        { // Grab reflection points for eye tracking etc:
-            core::ScopeTimeLogger scopeTimeLogger = [this](double t) { this->impl->timerInfo.blobExtractionTimeLogger(t); };
-
-            const cv::Size filteredEyeSize(impl->blobFilter->getOutFrameW(), impl->blobFilter->getOutFrameH());
-            EyeBlobJob single(filteredEyeSize, eyeWarps);
-            impl->blobFilter->getHessianPeaks()->getResultData(single.filtered.ptr());
-            single.run();
-            impl->eyePoints = single.eyePoints;
+        if (blob)
+        { // Only the time spent waiting for the points is on the critical path:
+            auto scopeTimeLogger = core::makeScopeTimer<core::kTimingPipeline>("blob", [this](double t) { this->impl->timerInfo.blobExtractionTimeLogger(t); });
+            if (blobDone.valid())
+            {
+                blobDone.get();
+            }
+            impl->eyePoints = blob->eyePoints;
 
             computeGazePoints();
         }
     }
 }
 
+void FaceFinder::updateEyeFlowTiles()
+{
+#if TEXTURE_FORMAT_IS_RGBA
+    const int kX = 0, kY = 1, kStrength = 2; // RGBA
+#else
+    const int kX = 2, kY = 1, kStrength = 0; // BGRA
+#endif
+
+    const auto tilesSize = impl->eyeFlowTiles->getOutFrameSize();
+    cv::Mat4b tiles(tilesSize.height, tilesSize.width);
+    impl->eyeFlowTiles->getResultData(tiles.ptr());
+
+    // Tile centers in the flow image (i.e., the stacked eye pair):
+    const auto flowSize = impl->eyeFlow->getOutFrameSize();
+    const cv::Size size(flowSize.width, flowSize.height);
+    const float tile = static_cast<float>(impl->eyeFlowTiles->getTileSize());
+
+    const auto& eyeWarps = impl->eyeFilter->getEyeWarps();
+    const cv::Matx33f Heye[2] = {
+        eyeWarps[0].H.inv() * transformation::normalize(size),
+        eyeWarps[1].H.inv() * transformation::normalize(size)
+    };
+
+    impl->eyeFlowField.clear();
+
+    std::vector<cv::Point2f> flow;
+    for (int y = 0; y < tiles.rows; y++)
+    {
+        for (int x = 0; x < tiles.cols; x++)
+        {
+            // Skip tiles without corners, their mean flow is undefined (written as zero):
+            const cv::Vec4b& pixel = tiles(y, x);
+            if (pixel[kStrength] == 0)
+            {
+                continue;
+            }
+
+            const cv::Point2f p(pixel[kX], pixel[kY]);
+            const cv::Point2f d = (p * (2.0f / 255.0f)) - cv::Point2f(1.0f, 1.0f);
+            flow.push_back(d);
+
+            const cv::Point2f c((static_cast<float>(x) + 0.5f) * tile, (static_cast<float>(y) + 0.5f) * tile);
+            const cv::Point3f q3 = Heye[c.x > size.width / 2] * cv::Point3f(c.x, c.y, 1.f);
+            impl->eyeFlowField.emplace_back(q3.x / q3.z, q3.y / q3.z, d.x * 100.f, d.y * 100.f);
+        }
+    }
+
+    if (flow.size())
+    {
+        impl->eyeMotion = -drishti::geometry::pointMedian(flow);
+    }
+}
+
 void FaceFinder::computeGazePoints()
 {
     // Convert points to polar coordinates:
@@ -1061,41 +2314,77 @@ void FaceFinder::computeGazePoints()
 void FaceFinder::initTimeLoggers()
 {
     // clang-format off
-    impl->timerInfo.init();
+    impl->timerInfo.init(impl->metrics);
     // clang-format on
 }
 
 // #### init2 ####
 
+// Weak ref to the underlying ACF detector:
+static acf::Detector* getAcfDetector(drishti::face::FaceDetector& faceDetector)
+{
+    auto* detector = dynamic_cast<ml::ObjectDetectorACF*>(faceDetector.getDetector());
+    return detector ? dynamic_cast<acf::Detector*>(detector->getDetector()) : nullptr;
+}
+
 void FaceFinder::init2(drishti::face::FaceDetectorFactory& resources)
 {
-    using drishti::face::FaceSpecification;
-    
     impl->logger->info("FaceFinder::init2() {}", sBar);
     impl->logger->info("{}", resources);
 
     initTimeLoggers();
 
+    impl->faceDetector = createFaceDetector(resources, impl->factory);
+    impl->detector = getAcfDetector(*impl->faceDetector);
+
+    impl->faceTracker = core::make_unique<face::FaceTracker>(
+        impl->minFaceSeparation,
+        impl->minTrackHits,
+        impl->maxTrackMisses);
+}
+
+// Configure a face detector for the pipeline settings (the factory provides per thread eye estimators):
+std::unique_ptr<drishti::face::FaceDetector>
+FaceFinder::createFaceDetector(drishti::face::FaceDetectorFactory& resources, const FaceDetectorFactoryPtr& factory)
+{
+    using drishti::face::FaceSpecification;
+
+    std::unique_ptr<drishti::face::FaceDetector> faceDetector;
 #if DRISHTI_HCI_FACEFINDER_DO_TRACKING
     // Insntiate a face detector w/ a tracking component:
     auto faceDetectorAndTracker = drishti::core::make_unique<drishti::face::FaceDetectorAndTracker>(resources);
     faceDetectorAndTracker->setMaxTrackAge(2.0);
-    impl->faceDetector = std::move(faceDetectorAndTracker);
+    faceDetector = std::move(faceDetectorAndTracker);
 #else
-    impl->faceDetector = drishti::core::make_unique<drishti::face::FaceDetector>(resources);
+    faceDetector = drishti::core::make_unique<drishti::face::FaceDetector>(resources);
 #endif
     
-    impl->faceDetector->setLandmarkFormat( impl->factory->inner ? FaceSpecification::kibug68_inner : FaceSpecification::kibug68);    
-    impl->faceDetector->setDoNMSGlobal(impl->doSingleFace); // single detection only
-    impl->faceDetector->setDoNMS(true);
-    impl->faceDetector->setInits(1);
-
-    // Get weak ref to underlying ACF detector
-    auto *detector = dynamic_cast<ml::ObjectDetectorACF *>(impl->faceDetector->getDetector());
-    impl->detector = dynamic_cast<acf::Detector*>(detector->getDetector());
-    
+    faceDetector->setLandmarkFormat( resources.inner ? FaceSpecification::kibug68_inner : FaceSpecification::kibug68);    
+    faceDetector->setDoNMSGlobal(impl->doSingleFace); // single detection only
+    faceDetector->setDoNMS(true);
+    faceDetector->setInits(impl->regressionInits);
+
+    if (impl->faceStagesHint >= 0)
+    {
+        faceDetector->setFaceStagesHint(impl->faceStagesHint);
+    }
+    if (impl->eyelidStagesHint >= 0)
+    {
+        faceDetector->setEyelidStagesHint(impl->eyelidStagesHint);
+    }
+    if (impl->irisStagesHint >= 0)
+    {
+        faceDetector->setIrisStagesHint(impl->irisStagesHint);
+    }
+
+    if (impl->doParallelFaces && impl->threads)
+    {
+        // Each worker thread receives its own eye estimator pair on first use:
+        faceDetector->setThreads(impl->threads, [factory]() { return factory->getEyeEstimator(); });
+    }
 
-    if (impl->detector)
+    acf::Detector* detector = getAcfDetector(*faceDetector);
+    if (detector)
     {
         if (impl->acfCalibration != 0.f)
         {
@@ -1103,17 +2392,17 @@ void FaceFinder::init2(drishti::face::FaceDetectorFactory& resources)
             acf::Detector::Modify dflt;
             dflt.cascThr = { "cascThr", -1.0 };
             dflt.cascCal = { "cascCal", impl->acfCalibration };
-            impl->detector->acfModify(dflt);
+            detector->acfModify(dflt);
         }
     }
 
-    impl->faceDetector->setDetectionTimeLogger(impl->timerInfo.detectionTimeLogger);
-    impl->faceDetector->setRegressionTimeLogger(impl->timerInfo.regressionTimeLogger);
-    impl->faceDetector->setEyeRegressionTimeLogger(impl->timerInfo.eyeRegressionTimeLogger);
+    faceDetector->setDetectionTimeLogger(impl->timerInfo.detectionTimeLogger);
+    faceDetector->setRegressionTimeLogger(impl->timerInfo.regressionTimeLogger);
+    faceDetector->setEyeRegressionTimeLogger(impl->timerInfo.eyeRegressionTimeLogger);
 
     {
         // FaceDetection mean:
-        drishti::face::FaceModel faceDetectorMean = impl->factory->getMeanFace();
+        drishti::face::FaceModel faceDetectorMean = resources.getMeanFace();
 
         // We can change the regressor crop padding by doing a centered scaling of face features:
         if (impl->regressorCropScale > 0.f)
@@ -1134,13 +2423,121 @@ void FaceFinder::init2(drishti::face::FaceDetectorFactory& resources)
             faceDetectorMean = H * faceDetectorMean;
         }
 
-        impl->faceDetector->setFaceDetectorMean(faceDetectorMean);
+        faceDetector->setFaceDetectorMean(faceDetectorMean);
     }
 
-    impl->faceTracker = core::make_unique<face::FaceTracker>(
-        impl->minFaceSeparation,
-        impl->minTrackHits,
-        impl->maxTrackMisses);
+    return faceDetector;
+}
+
+// #### updateModels ####
+
+std::future<bool> FaceFinder::updateModels(const FaceDetectorFactoryPtr& factory)
+{
+    CV_Assert(impl->hasInit);
+
+    auto swapped = std::make_shared<std::promise<bool>>();
+    auto result = swapped->get_future();
+
+    // Release completed loads:
+    auto& loaders = impl->modelLoaders;
+    loaders.erase(std::remove_if(loaders.begin(), loaders.end(), [](const std::future<void>& loader) {
+        return loader.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), loaders.end());
+
+    // The GL thread keeps running frames with the current models during the load:
+    const cv::Size winSize = impl->detector->getWindowSize();
+    loaders.emplace_back(std::async(std::launch::async, [this, factory, swapped, winSize]() {
+        try
+        {
+            // Load on dedicated threads (the executor is busy with scene jobs):
+            drishti::face::FaceDetectorFactoryAsync resources(factory);
+
+            auto update = core::make_unique<Impl::ModelUpdate>();
+            update->factory = factory;
+            update->swapped = swapped;
+            update->faceDetector = createFaceDetector(resources, factory);
+            acf::Detector* detector = getAcfDetector(*update->faceDetector);
+
+            // The GPU pipeline is configured for the detector geometry and channels:
+            bool isCompatible = detector && (detector->getWindowSize() == winSize);
+            if (isCompatible)
+            {
+                isCompatible = (ogles_gpgpu::getFeatureKind(*detector->opts.pPyramid->pChns) == impl->acfFeatureKind);
+            }
+            if (isCompatible)
+            {
+                // Same distance bound as the current detector (see initACF()):
+                auto& pPyramid = detector->opts.pPyramid;
+                update->acfMinDs = pPyramid->minDs.get();
+                pPyramid->minDs = maxSize(update->acfMinDs, impl->pyramidMinDs);
+
+                update->pyramidBuilder = core::make_unique<ml::PyramidBuilderACF>(detector);
+                const auto& plan = update->pyramidBuilder->getPlan(impl->detectionSize);
+                isCompatible = (plan.levels.size() == impl->pyramidSizes.size());
+                for (std::size_t i = 0; isCompatible && (i < plan.levels.size()); i++)
+                {
+                    isCompatible = ((plan.levels[i] * 4) == impl->pyramidSizes[i]);
+                }
+            }
+
+            if (!isCompatible)
+            {
+                impl->logger->warn("FaceFinder::updateModels(): the detector requires a new pipeline");
+                swapped->set_value(false);
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(impl->modelMutex);
+            if (impl->modelUpdate)
+            {
+                impl->modelUpdate->swapped->set_value(false); // superseded
+            }
+            impl->modelUpdate = std::move(update);
+        }
+        catch (...)
+        {
+            swapped->set_exception(std::current_exception());
+        }
+    }));
+
+    return result;
+}
+
+void FaceFinder::swapModels()
+{
+    std::unique_ptr<Impl::ModelUpdate> update;
+    {
+        std::lock_guard<std::mutex> lock(impl->modelMutex);
+        update = std::move(impl->modelUpdate);
+    }
+
+    if (update)
+    {
+        // The new models aren't in use yet (scene jobs that are still regressing keep the previous ones):
+        applyQuality(*update->faceDetector, impl->quality);
+        {
+            // Scene jobs only take the detector in the detection section of detect():
+            std::lock_guard<std::mutex> lock(impl->sceneMutex);
+
+#if DRISHTI_HCI_FACEFINDER_DO_TRACKING
+            auto* tracker = dynamic_cast<drishti::face::FaceDetectorAndTracker*>(update->faceDetector.get());
+            auto* previous = dynamic_cast<drishti::face::FaceDetectorAndTracker*>(impl->faceDetector.get());
+            if (tracker && previous)
+            {
+                tracker->adoptTracks(*previous);
+            }
+#endif
+
+            std::swap(impl->faceDetector, update->faceDetector);
+            std::swap(impl->pyramidBuilder, update->pyramidBuilder);
+            std::swap(impl->acfMinDs, update->acfMinDs);
+            std::swap(impl->factory, update->factory);
+            impl->detector = getAcfDetector(*impl->faceDetector);
+        }
+
+        update->swapped->set_value(true);
+        impl->logger->info("FaceFinder: updated models at frame {}", impl->frameIndex);
+    } // release the previous models
 }
 
 static void smooth(double& t0, double t1, double alpha = 0.95)
@@ -1148,35 +2545,59 @@ static void smooth(double& t0, double t1, double alpha = 0.95)
     t0 = (t0 != 0.0) ? t1 : ((t0 * alpha) + (t1 * (1.0 - alpha)));
 }
 
-void FaceFinder::TimerInfo::init()
+void FaceFinder::TimerInfo::init(drishti::core::Metrics* metrics)
 {
+    // Histogram references remain valid for the lifetime of the registry:
+    const auto histogram = [&](const char* name) { return metrics ? &metrics->histogram(name) : nullptr; };
+    const auto record = [](drishti::core::Histogram* histogram, double seconds) {
+        if (histogram)
+        {
+            histogram->record(seconds);
+        }
+    };
+
+    auto* detection = histogram("face_detection");
+    auto* regression = histogram("face_regression");
+    auto* eyeRegression = histogram("eye_regression");
+    auto* acfProcessing = histogram("acf_processing");
+    auto* blobExtraction = histogram("blob_extraction");
+    auto* renderScene = histogram("render_scene");
+    auto* acfGpu = histogram("gpu_acf");
+    auto* eyeFilterGpu = histogram("gpu_eye_filter");
+    auto* blobFilterGpu = histogram("gpu_blob_filter");
+    auto* irisGpu = histogram("gpu_iris");
+    auto* eyeFlowGpu = histogram("gpu_eye_flow");
+    auto* paintGpu = histogram("gpu_paint");
+
+    // The regression of overlapping scene jobs reports concurrently (see FaceFinder::detect()):
+    const auto regressing = std::make_shared<std::mutex>();
+
     // clang-format off
-    detectionTimeLogger = [this](double seconds) { smooth(detectionTime, seconds); };
-    regressionTimeLogger = [this](double seconds) { smooth(regressionTime, seconds); };
-    eyeRegressionTimeLogger = [this](double seconds) { smooth(eyeRegressionTime, seconds); };
-    acfProcessingTimeLogger = [this](double seconds) { smooth(acfProcessingTime, seconds); };
-    blobExtractionTimeLogger = [this](double seconds) { smooth(blobExtractionTime, seconds); };
-    renderSceneTimeLogger = [this](double seconds) { smooth(renderSceneTime, seconds); };
+    detectionTimeLogger = [=](double seconds) { smooth(detectionTime, seconds); record(detection, seconds); };
+    regressionTimeLogger = [=](double seconds) { std::lock_guard<std::mutex> lock(*regressing); smooth(regressionTime, seconds); record(regression, seconds); };
+    eyeRegressionTimeLogger = [=](double seconds) { std::lock_guard<std::mutex> lock(*regressing); smooth(eyeRegressionTime, seconds); record(eyeRegression, seconds); };
+    acfProcessingTimeLogger = [=](double seconds) { smooth(acfProcessingTime, seconds); record(acfProcessing, seconds); };
+    blobExtractionTimeLogger = [=](double seconds) { smooth(blobExtractionTime, seconds); record(blobExtraction, seconds); };
+    renderSceneTimeLogger = [=](double seconds) { smooth(renderSceneTime, seconds); record(renderScene, seconds); };
+    acfGpuTimeLogger = [=](double seconds) { smooth(acfGpuTime, seconds); record(acfGpu, seconds); };
+    eyeFilterGpuTimeLogger = [=](double seconds) { smooth(eyeFilterGpuTime, seconds); record(eyeFilterGpu, seconds); };
+    blobFilterGpuTimeLogger = [=](double seconds) { smooth(blobFilterGpuTime, seconds); record(blobFilterGpu, seconds); };
+    irisGpuTimeLogger = [=](double seconds) { smooth(irisGpuTime, seconds); record(irisGpu, seconds); };
+    eyeFlowGpuTimeLogger = [=](double seconds) { smooth(eyeFlowGpuTime, seconds); record(eyeFlowGpu, seconds); };
+    paintGpuTimeLogger = [=](double seconds) { smooth(paintGpuTime, seconds); record(paintGpu, seconds); };
     // clang-format on
 }
 
 // #### utilty: ####
 
-static void chooseBest(std::vector<cv::Rect>& objects, std::vector<double>& scores)
+std::ostream& operator<<(std::ostream& os, const FaceFinder::BackpressureCounters& counters)
 {
-    if (objects.size() > 1)
-    {
-        int best = 0;
-        for (int i = 1; i < objects.size(); i++)
-        {
-            if (scores[i] > scores[best])
-            {
-                best = i;
-            }
-        }
-        objects = { objects[best] };
-        scores = { scores[best] };
-    }
+    os << " on_time=" << counters.onTime
+       << " blocked=" << counters.blocked
+       << " dropped=" << counters.dropped
+       << " skipped=" << counters.skipped
+       << " degraded=" << counters.degraded;
+    return os;
 }
 
 std::ostream& operator<<(std::ostream& os, const FaceFinder::TimerInfo& info)
@@ -1189,6 +2610,18 @@ std::ostream& operator<<(std::ostream& os, const FaceFinder::TimerInfo& info)
        << " blob=" << info.blobExtractionTime
        << " gl=" << info.renderSceneTime
        << " total=" << total;
+
+    const double gpu = info.acfGpuTime + info.eyeFilterGpuTime + info.blobFilterGpuTime + info.irisGpuTime + info.eyeFlowGpuTime + info.paintGpuTime;
+    if (gpu > 0.0)
+    {
+        os << " gpu_acf=" << info.acfGpuTime
+           << " gpu_eyes=" << info.eyeFilterGpuTime
+           << " gpu_blob=" << info.blobFilterGpuTime
+           << " gpu_iris=" << info.irisGpuTime
+           << " gpu_flow=" << info.eyeFlowGpuTime
+           << " gpu_paint=" << info.paintGpuTime
+           << " gpu_total=" << gpu;
+    }
     return os;
 }
 
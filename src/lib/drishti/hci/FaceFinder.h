@@ -12,17 +12,24 @@
 #define __drishti_hci_FaceFinder_h__
 
 #include "drishti/hci/drishti_hci.h"
+#include "drishti/hci/DetectionScheduler.h"
+#include "drishti/hci/PerformanceGovernor.h"
+#include "drishti/hci/GpuScheduler.h"
 #include "drishti/hci/Scene.hpp"
 #include "drishti/hci/FaceMonitor.h"
 #include "drishti/face/Face.h"
 #include "drishti/face/FaceDetectorFactory.h"
+#include "drishti/face/FaceQuality.h"
 #include "drishti/sensor/Sensor.h"
 
 #include <acf/GPUACF.h>
 #include <acf/ACF.h> // needed for pyramid
 
-#include "thread_pool/thread_pool.hpp"
+#include "drishti/core/Executor.h"
+#include "drishti/core/MemoryUsage.h"
+#include "drishti/core/Metrics.h"
 
+#include <future>
 #include <memory>
 
 #define DRISHTI_HCI_FACEFINDER_MIN_DISTANCE 0.1
@@ -33,6 +40,8 @@
 #define DRISHTI_HCI_FACEFINDER_INTERVAL 0.1f
 #define DRISHTI_HCI_FACEFINDER_DO_ELLIPSO_POLAR 0
 #define DRISHTI_HCI_FACEFINDER_HISTORY 3
+#define DRISHTI_HCI_FACEFINDER_LANDMARKS_WIDTH 1024
+#define DRISHTI_HCI_FACEFINDER_PIPELINE_DEPTH 1
 
 DRISHTI_HCI_NAMESPACE_BEGIN
 
@@ -54,38 +63,115 @@ public:
         double acfProcessingTime = 0.0;
         double blobExtractionTime = 0.0;
         double renderSceneTime = 0.0;
+
+        // GPU time (GL_TIME_ELAPSED), reported a few frames late (see Settings::doGpuTimers):
+        double acfGpuTime = 0.0;
+        double eyeFilterGpuTime = 0.0;
+        double blobFilterGpuTime = 0.0;
+        double irisGpuTime = 0.0;
+        double eyeFlowGpuTime = 0.0;
+        double paintGpuTime = 0.0;
+
         std::function<void(double second)> detectionTimeLogger;
         std::function<void(double second)> regressionTimeLogger;
         std::function<void(double second)> eyeRegressionTimeLogger;
         std::function<void(double second)> acfProcessingTimeLogger;
         std::function<void(double second)> blobExtractionTimeLogger;
         std::function<void(double second)> renderSceneTimeLogger;
+        std::function<void(double second)> acfGpuTimeLogger;
+        std::function<void(double second)> eyeFilterGpuTimeLogger;
+        std::function<void(double second)> blobFilterGpuTimeLogger;
+        std::function<void(double second)> irisGpuTimeLogger;
+        std::function<void(double second)> eyeFlowGpuTimeLogger;
+        std::function<void(double second)> paintGpuTimeLogger;
 
-        void init();
+        // The loggers also record to latency histograms in metrics (if any):
+        void init(drishti::core::Metrics* metrics = nullptr);
 
         friend std::ostream& operator<<(std::ostream& stream, const TimerInfo& info);
     };
 
+    // Action taken by runFast when the CPU result for the oldest frame misses Settings::frameBudget:
+    enum BackpressurePolicy
+    {
+        kBlock,          // wait for the result (legacy behavior)
+        kDropStale,      // render the oldest frame without annotations and discard its late result
+        kSkipRegression, // as kDropStale, and skip detection + regression for the newest frame
+        kDegrade         // wait for the result, then disable eye refinement until workers catch up
+    };
+
+    struct BackpressureCounters
+    {
+        std::size_t onTime = 0;   // results available within the frame budget
+        std::size_t blocked = 0;  // late results the render thread waited for
+        std::size_t dropped = 0;  // late results that were discarded
+        std::size_t skipped = 0;  // frames submitted without detection + regression
+        std::size_t degraded = 0; // late results that triggered reduced quality regression
+
+        friend std::ostream& operator<<(std::ostream& stream, const BackpressureCounters& counters);
+    };
+
     struct Settings
     {
         std::shared_ptr<drishti::sensor::SensorModel> sensor;
         std::shared_ptr<spdlog::logger> logger;
-        std::shared_ptr<tp::ThreadPool<>> threads;
+        std::shared_ptr<drishti::core::Executor> threads;
         ImageLogger imageLogger;
         int outputOrientation = 0;
         int frameDelay = 1;
         bool doLandmarks = true;
         bool doFlow = true;
+        int flowTileSize = 0; // >0: eye flow (doFlow) is read back as tile means (see ogles_gpgpu::FlowTileProc)
         bool doBlobs = false;
+        bool doParallelFaces = false; // distribute per face regression across threads
 
         // Detection parameters:
         bool doSingleFace = false;
         float minDetectionDistance = DRISHTI_HCI_FACEFINDER_MIN_DISTANCE;
         float maxDetectionDistance = DRISHTI_HCI_FACEFINDER_MAX_DISTANCE;
         float faceFinderInterval = DRISHTI_HCI_FACEFINDER_INTERVAL;
+        std::shared_ptr<DetectionScheduler> detectionScheduler; // default: IntervalDetectionScheduler
+        std::shared_ptr<PerformanceGovernor> governor;          // (optional) hold a frame rate by quality levels
+
+        // Idle fixed camera scenes: without tracks, detection runs every staticSceneInterval seconds
+        // once the mean frame difference (0..1, see ogles_gpgpu::SceneChangeFilter) has stayed below
+        // staticSceneThreshold for staticSceneFrames frames:
+        bool doStaticSceneDetection = false;
+        float staticSceneThreshold = 0.01f;
+        int staticSceneFrames = 8;
+        double staticSceneInterval = 2.0;
+
+        // Restrict detection to the last detections (+margin) at matching pyramid levels,
+        // with a full frame scan every roiFullScanInterval detections:
+        bool doRoiDetection = false;
+        float roiMargin = 0.5f; // fraction of the object size added on each side
+        int roiLevels = 2;      // number of pyramid levels evaluated per object
+        int roiFullScanInterval = 10;
+
+        // Detections that fail the quality filter are dropped before regression (default: none):
+        face::FaceQualityFilter qualityFilter;
+
         float acfCalibration = 0.f;
         float regressorCropScale = 0.f;
 
+        // Regression (grayscale image width and cascade stage hints, -1 : model default):
+        int landmarksWidth = DRISHTI_HCI_FACEFINDER_LANDMARKS_WIDTH;
+        int faceStagesHint = -1;
+        int eyelidStagesHint = -1;
+        int irisStagesHint = -1;
+
+        // Landmark starting shapes per face (>1 : jittered rois fused by their median, see
+        // FaceDetector::setInits()), their disagreement feeds the detection scheduler:
+        int regressionInits = 1;
+
+        // Propagate the landmarks of tracked faces between regressions by a similarity fit to their
+        // sparse optical flow (pyramidal LK on the regression image).  The cascade regression runs
+        // every keypointInterval frames, or as soon as the fit rmse exceeds keypointResidual
+        // (regression image pixels):
+        bool doKeypointTracking = false;
+        int keypointInterval = 4;
+        float keypointResidual = 1.5f;
+
         // Detection tracks:
         std::size_t minTrackHits = DRISHTI_HCI_FACEFINDER_MIN_TRACK_HITS;
         std::size_t maxTrackMisses = DRISHTI_HCI_FACEFINDER_MAX_TRACK_MISSES;
@@ -93,10 +179,17 @@ public:
 
         // OpengL parameters:
         int glVersionMajor = 2;
-        int glVersionMinor = 0; // future use
+        int glVersionMinor = 0;
         bool usePBO = false;
+        bool doComputeACF = false; // compute shader ACF channels (OpenGL ES 3.1, see ogles_gpgpu::ACFCompute)
+        bool doGpuTimers = false;  // GPU time of the GL stages in TimerInfo (see ogles_gpgpu::GpuTimer)
+        int readbackBuffers = 1; // ACF pipelines cycled by runFast (>1 : defer readback by N-1 frames)
+        int acfTileSize = 0;     // largest ACF level texture computed on the full frame (0 : untiled, see ACFTiling)
         bool doOptimizedPipeline = true;
 
+        // Shared by the pipelines (streams) of one GL context or share group (nullptr : unscheduled):
+        std::shared_ptr<GpuScheduler> gpuScheduler;
+
         // Display parameters:
         bool renderFaces = true;
         bool renderPupils = true;
@@ -104,6 +197,24 @@ public:
         float renderEyesWidthRatio = 0.25f;
 
         int history = DRISHTI_HCI_FACEFINDER_HISTORY;
+
+        // Resolution of the frame history delivered to the FaceMonitor callbacks relative to the
+        // input (i.e., 0.25 for 4K capture with a 1080p display).  Below 1 only the frames the
+        // pipeline still reads (pipelineDepth + readbackBuffers) are kept at full resolution,
+        // and the face models that come with the grabbed frames are scaled to match.
+        float historyScale = 1.f;
+
+        // Number of outstanding CPU scene jobs in the optimized pipeline (runFast).  Jobs pass
+        // detection and track association in frame order, their landmark and eye regression
+        // runs concurrently.  Total latency is pipelineDepth + 1 frames.
+        int pipelineDepth = DRISHTI_HCI_FACEFINDER_PIPELINE_DEPTH;
+
+        // Seconds runFast waits for the oldest CPU result before applying backpressurePolicy:
+        BackpressurePolicy backpressurePolicy = kBlock;
+        double frameBudget = 0.0;
+
+        // Number of ScopeTimeLogger events retained for Chrome trace export (0 : disabled):
+        std::size_t traceCapacity = 0;
     };
 
     FaceFinder(FaceDetectorFactoryPtr& factory, Settings& config, void* glContext = nullptr);
@@ -118,6 +229,10 @@ public:
 
     virtual GLuint operator()(const FrameInput& frame);
 
+    // Process a frame captured at captureTime (i.e., from the camera timestamp), which is reported
+    // to the FaceMonitor callbacks of the frame and used for the "capture_latency" histogram:
+    GLuint operator()(const FrameInput& frame, const TimePoint& captureTime);
+
     float getMaxDistance() const;
     float getMinDistance() const;
 
@@ -127,6 +242,14 @@ public:
     void setFaceFinderInterval(double interval);
     double getFaceFinderInterval() const;
 
+    void setDetectionScheduler(const std::shared_ptr<DetectionScheduler>& scheduler);
+
+    // Current level of the PerformanceGovernor (0 : as configured, or no governor):
+    int getQualityLevel() const;
+
+    void setBackpressurePolicy(BackpressurePolicy policy, double frameBudget);
+    BackpressureCounters getBackpressureCounters() const;
+
     void setBrightness(float value);
 
     void registerFaceMonitorCallback(FaceMonitor* callback);
@@ -135,20 +258,42 @@ public:
 
     void setImageLogger(const ImageLogger& logger);
 
+    // Write recorded stage timings as Chrome trace JSON (requires Settings::traceCapacity > 0):
+    bool dumpTrace(std::ostream& os) const;
+
+    // Model heap ("models/...") and pipeline buffers ("pipeline/...", CPU heap and estimated
+    // GPU memory): call from the processing (OpenGL) thread.  The totals are also published
+    // as memory_* gauges in the metrics registry every kMemoryUsageInterval frames.
+    core::MemoryUsage memoryUsage() const;
+    static const int kMemoryUsageInterval = 256;
+
+    // Load the models of factory on a background thread and swap them in at the start of a later
+    // frame without recreating the GPU pipeline (tracks are retained).  The result is true once
+    // the new models are active, or false if the detector needs a different pipeline (window size,
+    // channel type or pyramid levels), which requires a new FaceFinder.  Call after initialize().
+    std::future<bool> updateModels(const FaceDetectorFactoryPtr& factory);
+
 protected:
     using ImageViews = std::vector<core::ImageView>;
     using EyeModelPair = std::array<eye::EyeModel, 2>;
     using EyeModelPairs = std::vector<EyeModelPair>;
 
-    std::pair<GLuint, ScenePrimitives> runFast(const FrameInput& frame, bool doDetection);
-    std::pair<GLuint, ScenePrimitives> runSimple(const FrameInput& frame, bool doDetection);
+    // The returned scene is owned by the scene stash and is valid until the next frame:
+    std::pair<GLuint, const ScenePrimitives*> runFast(const FrameInput& frame, bool doDetection);
+    std::pair<GLuint, const ScenePrimitives*> runSimple(const FrameInput& frame, bool doDetection);
+
+    bool waitForScene(bool& doRegression);
+    void reapDroppedScenes();
 
     bool needsDetection(const TimePoint& ts) const;
 
     void computeGazePoints();
     void updateEyes(GLuint inputTexId, const ScenePrimitives& scene);
+    void updateEyeFlowTiles();
 
     void scaleToFullResolution(std::vector<drishti::face::FaceModel>& faces);
+    bool propagateKeypoints(const cv::Mat& gray, std::size_t identifier, drishti::face::FaceModel& face);
+    void updateKeypoints(std::size_t identifier, const drishti::face::FaceModel& face);
 
     void notifyListeners(const ScenePrimitives& scene, const TimePoint& time, bool isFull);
 
@@ -156,23 +301,48 @@ protected:
     virtual void initPainter(const cv::Size& inputSizeUp);
     void initFaceFilters(const cv::Size& inputSizeUp);
     void initACF(const cv::Size& inputSizeUp);
+    void initACFTiles(const cv::Size& inputSizeUp, ogles_gpgpu::ACF::FeatureKind featureKind);
     void initFIFO(const cv::Size& inputSize, std::size_t n);
+    void initHistory(const cv::Size& inputSize, std::size_t n);
+    void updateHistory(GLuint inputTexId);
     void initBlobFilter();
+    void updateGovernor(double frameTime, const TimePoint& now);
+    void applyQuality(drishti::face::FaceDetector& faceDetector, const PerformanceGovernor::Quality& quality);
+    void initSceneChange(const cv::Size& inputSizeUp);
+    void updateSceneChange(GLuint inputTexId);
     void initColormap(); // [0..359];
     void initEyeEnhancer(const cv::Size& inputSizeUp, const cv::Size& eyesSize);
     void initIris(const cv::Size& size);
     void initTimeLoggers();
+    void updateMemoryGauges();
     void init2(drishti::face::FaceDetectorFactory& resources);
 
+    std::unique_ptr<drishti::face::FaceDetector>
+    createFaceDetector(drishti::face::FaceDetectorFactory& resources, const FaceDetectorFactoryPtr& factory);
+    void swapModels();
+
     void dumpEyes(ImageViews& frames, EyeModelPairs& eyes, int n = 1, bool getImage = false);
-    void dumpFaces(ImageViews& frames, int n = 1, bool getImage = false);
+    void dumpFaces(ImageViews& frames, int n = 1, bool getImage = false, bool getLazyImage = false);
+    void dumpIrises(std::array<eye::NormalizedIris, 2>& irises);
+    void serviceReadbacks();
     int detectOnly(ScenePrimitives& scene, bool doDetection);
-    virtual int detect(const FrameInput& frame, ScenePrimitives& scene, bool doDetection);
+    bool detectRoi(const acf::Detector::Pyramid& P, std::vector<cv::Rect>& objects, std::vector<double>& scores);
+    void filterDetections(const acf::Detector::Pyramid& P, std::vector<cv::Rect>& objects, std::vector<double>& scores);
+
+    // Sections of detect(), frames pass the detection and tracking sections in ticket order:
+    struct DetectionPass;
+    void detectFaces(ScenePrimitives& scene, bool doDetection, DetectionPass& pass);
+    void regressDetections(DetectionPass& pass);
+    void trackFaces(ScenePrimitives& scene, DetectionPass& pass);
+    void regressTracks(ScenePrimitives& scene, DetectionPass& pass);
+    virtual int detect(const FrameInput& frame, ScenePrimitives& scene, bool doDetection, uint64_t ticket, bool doEyeRefinement);
+
     virtual GLuint paint(const ScenePrimitives& scene, GLuint inputTexture);
     virtual void preprocess(const FrameInput& frame, ScenePrimitives& scene, bool needsDetection); // compute acf
 
     GLuint stabilize(GLuint inputTexId, const cv::Size& inputSizeUp, const drishti::face::FaceModel& face);
     int computeDetectionWidth(const cv::Size& inputSizeUp) const;
+    cv::Size computePyramidMinSize(const cv::Size& detectionSize) const;
     void computeAcf(const FrameInput& frame, bool doLuv, bool doDetection);
     std::shared_ptr<acf::Detector::Pyramid> createAcfGpu(const FrameInput& frame, bool doDetection);
     std::shared_ptr<acf::Detector::Pyramid> createAcfCpu(const FrameInput& frame, bool doDetection);
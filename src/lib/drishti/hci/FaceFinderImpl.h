@@ -14,6 +14,9 @@
 #include "drishti/hci/drishti_hci.h"
 
 #include "drishti/core/Logger.h"              // spdlog::logger
+#include "drishti/core/Metrics.h"             // drishti::core::Metrics
+#include "drishti/core/TraceRecorder.h"       // drishti::core::TraceRecorder
+#include "drishti/core/make_unique.h"         // drishti::core::make_unique
 #include "drishti/eye/gpu/EllipsoPolarWarp.h" // ogles_gpgpu::EllipsoPolarWarp
 #include "drishti/eye/gpu/EyeWarp.h"
 #include "drishti/face/gpu/EyeFilter.h"       // ogles_gpgpu::EyeFilter
@@ -21,9 +24,15 @@
 #include "drishti/face/FaceDetectorFactory.h" // drishti::face::FaceDetectorFactory
 #include "drishti/face/FaceModelEstimator.h"  // drishti::face::FaceModelEstimator
 #include "drishti/face/FaceTracker.h"         // drishti::face::FaceTracker
+#include "drishti/graphics/GpuTimer.h"        // ogles_gpgpu::GpuTimer
+#include "drishti/hci/ACFTiling.h"            // drishti::hci::ACFTiling
 #include "drishti/hci/FaceMonitor.h"          // FaceMonitor*
 #include "drishti/hci/Scene.hpp"              // ScenePrimitives
+#include "drishti/hci/gpu/ACFCompute.h"       // ogles_gpgpu::ACFCompute
 #include "drishti/hci/gpu/BlobFilter.h"       // ogles_gpgpu::BlobFilter
+#include "drishti/hci/gpu/FlowTileProc.h"     // ogles_gpgpu::FlowTileProc
+#include "drishti/hci/gpu/SceneChangeFilter.h" // ogles_gpgpu::SceneChangeFilter
+#include "drishti/ml/PyramidBuilderACF.h"     // drishti::ml::PyramidBuilderACF
 #include "drishti/sensor/Sensor.h"            // drishti::sensor::SensorModel
 
 #include <acf/ACF.h>                          // drishti::acf::Detector+Pyramid
@@ -33,14 +42,19 @@
 #include "ogles_gpgpu/common/proc/flow.h"      // ogles_gpgpu::FlowOptPipeline
 #include "ogles_gpgpu/common/proc/fifo.h"      // ogles_gpgpu::FifoProc
 #include "ogles_gpgpu/common/proc/transform.h" // ogles_gpgpu::TransformProc
-#include "thread_pool/thread_pool.hpp"         // tp::ThreadPool<>
+#include "drishti/core/Executor.h"
+
+#include <algorithm>          // std::max
+#include <array>              // std::array
+#include <chrono>             // std::chrono::high_resolution_clock::time_point
+#include <condition_variable> // std::condition_variable
+#include <deque>              // std::deque
+#include <future>             // future
+#include <map>                // std::map
+#include <memory>             // std::shared_ptr
+#include <mutex>              // std::mutex
+#include <vector>             // vector
 
-#include <chrono> // std::chrono::high_resolution_clock::time_point
-#include <future> // future
-#include <memory> // std::shared_ptr
-#include <vector> // vector
-
-#define DRISHTI_HCI_FACEFINDER_LANDMARKS_WIDTH 1024
 #define DRISHTI_HCI_FACEFINDER_DO_CORNER_PLOT 1 // *** display ***
 #define DRISHTI_HCI_FACEFINDER_DO_TRACKING 1
 #define DRISHTI_HCI_FACEFINDER_DO_DIFFERENCE_EYES 1
@@ -67,20 +81,42 @@ struct FaceFinder::Impl
         , acfCalibration(args.acfCalibration)
         , doSingleFace(args.doSingleFace)
         , faceFinderInterval(args.faceFinderInterval)
+        , detectionScheduler(args.detectionScheduler)
+        , governor(args.governor)
+        , doStaticSceneDetection(args.doStaticSceneDetection)
+        , staticSceneThreshold(args.staticSceneThreshold)
+        , staticSceneFrames(std::max(args.staticSceneFrames, 1))
+        , staticSceneInterval(args.staticSceneInterval)
+        , gpuScheduler(args.gpuScheduler)
         , minDistanceMeters(args.minDetectionDistance)
         , maxDistanceMeters(args.maxDetectionDistance)
         , minTrackHits(args.minTrackHits)
         , maxTrackMisses(args.maxTrackMisses)
         , minFaceSeparation(args.minFaceSeparation)
+        , doRoiDetection(args.doRoiDetection)
+        , roiMargin(args.roiMargin)
+        , roiLevels(std::max(args.roiLevels, 1))
+        , roiFullScanInterval(args.roiFullScanInterval)
+        , qualityFilter(args.qualityFilter)
 
         // Face landmarks:
         , doLandmarks(args.doLandmarks)
-        , landmarksWidth(DRISHTI_HCI_FACEFINDER_LANDMARKS_WIDTH)
+        , landmarksWidth(args.landmarksWidth)
+        , faceStagesHint(args.faceStagesHint)
+        , eyelidStagesHint(args.eyelidStagesHint)
+        , irisStagesHint(args.irisStagesHint)
+        , regressionInits(std::max(args.regressionInits, 1))
+        , doKeypointTracking(args.doKeypointTracking)
+        , keypointInterval(std::max(args.keypointInterval, 1))
+        , keypointResidual(args.keypointResidual)
         , regressorCropScale(args.regressorCropScale)
+        , doParallelFaces(args.doParallelFaces)
 
         // Eye parameters:
         , doBlobs(args.doBlobs)
         , doIris(DRISHTI_HCI_FACEFINDER_DO_ELLIPSO_POLAR)
+        , doEyeFlow(args.doFlow && (args.flowTileSize > 0))
+        , flowTileSize(std::min(args.flowTileSize, int(ogles_gpgpu::FlowTileProc::kMaxTile)))
 
         // Annotations:
         , renderFaces(args.renderFaces)
@@ -91,9 +127,45 @@ struct FaceFinder::Impl
         , glVersionMajor(args.glVersionMajor)
         , glVersionMinor(args.glVersionMinor)
         , usePBO(args.usePBO)
+        , doComputeACF(args.doComputeACF)
+        , doGpuTimers(args.doGpuTimers)
+        , readbackBuffers(std::max(args.readbackBuffers, 1))
+        , acfTileSize(std::max(args.acfTileSize, 0))
         , doOptimizedPipeline(args.doOptimizedPipeline)
         , history(args.history)
+        , historyScale((args.historyScale > 0.f) ? std::min(args.historyScale, 1.f) : 1.f)
+        , pipelineDepth(std::max(args.pipelineDepth, 1))
+        , backpressurePolicy(args.backpressurePolicy)
+        , frameBudget(std::max(args.frameBudget, 0.0))
     {
+        if (!detectionScheduler)
+        {
+            detectionScheduler = std::make_shared<IntervalDetectionScheduler>();
+        }
+
+        if (gpuScheduler)
+        {
+            gpuPipeline = gpuScheduler->attach();
+        }
+
+        if (args.traceCapacity > 0)
+        {
+            trace = drishti::core::make_unique<drishti::core::TraceRecorder>(args.traceCapacity);
+        }
+
+        frameTime = &metrics->histogram("frame");
+        readbackTime = &metrics->histogram("gpu_readback");
+        captureLatency = &metrics->histogram("capture_latency");
+        detectionCount = &metrics->counter("detections");
+        droppedCount = &metrics->counter("dropped_frames");
+        qualityRejectCount = &metrics->counter("quality_rejections");
+        faceCount = &metrics->gauge("faces");
+        qualityLevel = &metrics->gauge("quality_level");
+        memoryDetector = &metrics->gauge("memory_detector");
+        memoryFaceRegressor = &metrics->gauge("memory_face_regressor");
+        memoryEyeModels = &metrics->gauge("memory_eye_models");
+        memoryPipelineCpu = &metrics->gauge("memory_pipeline_cpu");
+        memoryPipelineGpu = &metrics->gauge("memory_pipeline_gpu");
     }
 
     using time_point = std::chrono::high_resolution_clock::time_point;
@@ -105,11 +177,26 @@ struct FaceFinder::Impl
     std::shared_ptr<drishti::face::FaceDetectorFactory> factory;
     std::shared_ptr<drishti::sensor::SensorModel> sensor;
     std::shared_ptr<spdlog::logger> logger;
-    std::shared_ptr<tp::ThreadPool<>> threads;
+    std::shared_ptr<drishti::core::Executor> threads;
     std::vector<FaceMonitor*> faceMonitorCallback;
     ImageLogger imageLogger;
     TimePoint start;
     TimerInfo timerInfo;
+    std::unique_ptr<drishti::core::TraceRecorder> trace; // (optional)
+    drishti::core::Metrics* metrics = &drishti::core::Metrics::getInstance();
+    drishti::core::Histogram* frameTime = nullptr;
+    drishti::core::Histogram* readbackTime = nullptr;
+    drishti::core::Histogram* captureLatency = nullptr; // capture to result (callback) time
+    drishti::core::Counter* detectionCount = nullptr; // frames with a detection pass
+    drishti::core::Counter* droppedCount = nullptr;   // late results discarded by backpressure
+    drishti::core::Counter* qualityRejectCount = nullptr; // detections dropped by the quality filter
+    drishti::core::Gauge* faceCount = nullptr;        // tracked faces in the latest frame
+    drishti::core::Gauge* qualityLevel = nullptr;     // PerformanceGovernor level
+    drishti::core::Gauge* memoryDetector = nullptr;      // bytes (see FaceFinder::memoryUsage())
+    drishti::core::Gauge* memoryFaceRegressor = nullptr; // bytes
+    drishti::core::Gauge* memoryEyeModels = nullptr;     // bytes
+    drishti::core::Gauge* memoryPipelineCpu = nullptr;   // bytes
+    drishti::core::Gauge* memoryPipelineGpu = nullptr;   // bytes (estimated)
 
     bool doAnnotations = true;
     bool hasInit = false;
@@ -117,6 +204,10 @@ struct FaceFinder::Impl
     uint64_t frameIndex = 0;
     cv::Mat3f colors32FC3; // map angles to colors
 
+    // Capture times of the most recent frames (by frame index), which covers the FIFO and the pipeline latency:
+    std::array<TimePoint, 64> captureTimes;
+    const TimePoint& getCaptureTime(uint64_t index) const { return captureTimes[index % captureTimes.size()]; }
+
     // :::::::::::::::::::::::::::::::::::::::
     // ::: Input frame related parameters: :::
     // :::::::::::::::::::::::::::::::::::::::
@@ -125,6 +216,14 @@ struct FaceFinder::Impl
     float brightness = 1.f;
     std::shared_ptr<ogles_gpgpu::FifoProc> fifo; // store last N faces
 
+    // Reduced resolution frame history for dumpFaces() (historyScale < 1):
+    std::unique_ptr<ogles_gpgpu::TransformProc> historyResizer;
+    std::shared_ptr<ogles_gpgpu::FifoProc> historyFifo;
+    const std::shared_ptr<ogles_gpgpu::FifoProc>& getHistory() const { return historyFifo ? historyFifo : fifo; }
+
+    // Outstanding lazy FIFO readbacks and the frame index at which their texture is recycled:
+    std::vector<std::pair<std::shared_ptr<core::DeferredReadback>, uint64_t>> readbacks;
+
     // :::::::::::::::::::::::::::::::::::::::
     // ::: ACF and detection parameters:   :::
     // :::::::::::::::::::::::::::::::::::::::
@@ -134,32 +233,118 @@ struct FaceFinder::Impl
     bool doCpuACF = false;
     float ACFScale = 2.0f;
     std::vector<cv::Size> pyramidSizes;
+    cv::Size detectionSize; // upright ACF input image size
     acf::Detector::Pyramid P;
-    std::shared_ptr<ogles_gpgpu::ACF> acf;
+    std::shared_ptr<ogles_gpgpu::ACF> acf;                  // ACF pipeline for the current frame
+    std::vector<std::shared_ptr<ogles_gpgpu::ACF>> acfRing; // cycled by runFast
+    std::shared_ptr<ogles_gpgpu::ACFCompute> acfCompute;                  // compute shader channels (optional)
+    std::vector<std::shared_ptr<ogles_gpgpu::ACFCompute>> acfComputeRing; // parallel to acfRing
+    ACFTiling acfTiling;                                                    // tiled levels [0, n) for large inputs
+    std::vector<std::unique_ptr<ogles_gpgpu::TransformProc>> acfTileCrops;  // upright input of each tile
+    std::vector<std::shared_ptr<ogles_gpgpu::ACF>> acfTiles;                // tile pipelines for the current frame
+    std::vector<std::vector<std::shared_ptr<ogles_gpgpu::ACF>>> acfTileRing; // parallel to acfRing
+    float acfGrayscaleScale = 1.f;                          // full->regression (shared by all pipelines)
     float acfCalibration = 0.f;
 
     // Detection:
     bool doSingleFace = false;
     double faceFinderInterval = DRISHTI_HCI_FACEFINDER_INTERVAL;
+    std::shared_ptr<DetectionScheduler> detectionScheduler;
+    std::shared_ptr<PerformanceGovernor> governor; // (optional)
+    PerformanceGovernor::Quality quality;          // of the current governor level
+    DetectionScheduler::State trackState; // written by detect(), read by needsDetection()
+    uint64_t disagreementFrame = 0;       // frame of trackState.disagreement
+    std::mutex trackMutex;
+
+    bool doStaticSceneDetection = false;
+    float staticSceneThreshold = 0.01f;
+    int staticSceneFrames = 8;
+    double staticSceneInterval = 2.0;
+    std::unique_ptr<ogles_gpgpu::SceneChangeFilter> sceneChange; // (optional)
+    int staticFrames = 0; // consecutive frames without change
+
+    // ROI detection:
+    bool doRoiDetection = false;
+    float roiMargin = 0.5f;
+    int roiLevels = 2;
+    int roiFullScanInterval = 10;
+
+    face::FaceQualityFilter qualityFilter;
+
+    // Keypoint tracking between regressions (regression image coordinates), by track identifier:
+    struct KeypointTrack
+    {
+        drishti::face::FaceModel face;
+        std::vector<cv::Point2f> points;
+        int frames = 0; // propagated frames since the last regression
+    };
+    bool doKeypointTracking = false;
+    int keypointInterval = 4;
+    float keypointResidual = 1.5f;
+    std::map<std::size_t, KeypointTrack> keypointTracks;
+    cv::Mat keypointGray; // previous regression image
+
+    int roiDetections = 0; // ROI detections since the last full scan
     float minDistanceMeters = 0.f;
     float maxDistanceMeters = 10.0f;
     std::size_t minTrackHits = 3;
     std::size_t maxTrackMisses = 3;
     float minFaceSeparation = 0.15;
-    std::unique_ptr<drishti::face::FaceDetector> faceDetector;
+    std::shared_ptr<drishti::face::FaceDetector> faceDetector; // shared with regressing scene jobs
     std::unique_ptr<drishti::face::FaceTracker> faceTracker;
 
     acf::Detector* detector = nullptr; // weak ref
+    std::unique_ptr<ml::PyramidBuilderACF> pyramidBuilder; // pyramid layout per detection size
+    ogles_gpgpu::ACF::FeatureKind acfFeatureKind = ogles_gpgpu::ACF::kUnknown; // GPU channels
+    cv::Size acfMinDs;     // detector pyramid minDs (without the distance bound)
+    cv::Size pyramidMinDs; // smallest level for faces at minDistanceMeters (see initACF())
+
+    // Models loaded by updateModels(), swapped in by the GL thread at the start of a frame:
+    struct ModelUpdate
+    {
+        std::shared_ptr<drishti::face::FaceDetectorFactory> factory;
+        std::shared_ptr<drishti::face::FaceDetector> faceDetector;
+        std::unique_ptr<ml::PyramidBuilderACF> pyramidBuilder;
+        cv::Size acfMinDs;
+        std::shared_ptr<std::promise<bool>> swapped;
+    };
+    std::mutex modelMutex;
+    std::unique_ptr<ModelUpdate> modelUpdate;   // latest loaded update (modelMutex)
+    std::deque<std::future<void>> modelLoaders; // background loads (caller thread)
     std::pair<time_point, std::vector<cv::Rect>> objects;
-    std::future<ScenePrimitives> scene;
-    std::deque<ScenePrimitives> scenePrimitives; // stash
+    std::deque<std::future<ScenePrimitives>> scenes; // outstanding CPU jobs (oldest first)
+    std::deque<ScenePrimitives> scenePrimitives;      // stash
+    ScenePrimitivesPool scenePool;                    // recycled scene storage
+
+    // Detection and tracking are stateful, so outstanding scene jobs pass the detection and
+    // tracking sections of detect() in the order they were submitted, and regress in between:
+    std::mutex sceneMutex;
+    std::condition_variable sceneCondition;
+    uint64_t sceneTicket = 0; // next ticket to hand out (GL thread)
+    uint64_t sceneTurn = 0;   // ticket allowed in the detection section
+    uint64_t trackTurn = 0;   // ticket allowed in the tracking section
+    int regressions = 0;      // jobs regressing outside of the sections
+    PerformanceGovernor::Quality sceneQuality; // stage hints for the next detection section
+    bool qualityChanged = false;
+
+    // Backpressure handling for late scene jobs (GL thread):
+    BackpressurePolicy backpressurePolicy = FaceFinder::kBlock;
+    double frameBudget = 0.0;
+    BackpressureCounters backpressureCounters;
+    std::deque<std::future<ScenePrimitives>> droppedScenes; // discarded jobs that are still running
+    int degradedFrames = 0;                                 // on time frames remaining in degraded mode
 
     // ::::::::::::::::::::::::::::::::::::::::
     // ::: Face landmark parameters 2d->3d: :::
     // ::::::::::::::::::::::::::::::::::::::::
     bool doLandmarks = false;
     int landmarksWidth = 256;
+    int faceStagesHint = -1;
+    int eyelidStagesHint = -1;
+    int irisStagesHint = -1;
+    int regressionInits = 1;
     float regressorCropScale = 0.f;
+    bool doParallelFaces = false;
 
     // Camera model, etc:
     cv::Point3f faceMotion;
@@ -172,6 +357,7 @@ struct FaceFinder::Impl
     bool doBlobs = false;
     bool doIris = false;
     bool doEyeFlow = false;
+    int flowTileSize = 0;
     cv::Size eyesSize = { 480, 240 };
 
     std::unique_ptr<ogles_gpgpu::BlobFilter> blobFilter;
@@ -179,6 +365,7 @@ struct FaceFinder::Impl
     std::shared_ptr<ogles_gpgpu::EllipsoPolarWarp> ellipsoPolar[2];
     std::unique_ptr<ogles_gpgpu::FlowOptPipeline> eyeFlow;
     std::unique_ptr<ogles_gpgpu::SwizzleProc> eyeFlowBgra; // (optional)
+    std::unique_ptr<ogles_gpgpu::FlowTileProc> eyeFlowTiles; // (optional)
     ogles_gpgpu::ProcInterface* eyeFlowBgraInterface = nullptr;
 
     FeaturePoints gazePoints;
@@ -198,9 +385,41 @@ struct FaceFinder::Impl
     int glVersionMajor = 2;
     int glVersionMinor = 0;
     bool usePBO = false;
+    bool doComputeACF = false;
+    bool doGpuTimers = false;
+    int readbackBuffers = 1;
+    int acfTileSize = 0;
     bool doOptimizedPipeline = true;
     int history = 3; // frame history
+    float historyScale = 1.f;
+    int pipelineDepth = 1;
     int latency = 2;
+
+    // Channels were rendered for the last frame of the current ACF pipeline (see FaceFinder::fill()):
+    bool getChannelStatus() const
+    {
+        return (acfCompute && acfCompute->getStatus()) || acf->getChannelStatus();
+    }
+
+    // Frames between rendering and reading back an ACF pipeline in runFast (beyond the first):
+    int readbackDelay() const { return static_cast<int>(acfRing.size()) - 1; }
+
+    // GL work is issued in passes when the context is shared with other pipelines:
+    std::shared_ptr<GpuScheduler> gpuScheduler;
+    std::size_t gpuPipeline = 0;
+
+    GpuScheduler::Pass scheduleGpu(GpuScheduler::Phase phase)
+    {
+        return gpuScheduler ? gpuScheduler->acquire(gpuPipeline, phase) : GpuScheduler::Pass();
+    }
+
+    // GPU time of the GL stages (optional), collected once per frame:
+    std::unique_ptr<ogles_gpgpu::GpuTimer> gpuTimer;
+
+    ogles_gpgpu::GpuTimer::Scope timeGpu(const ogles_gpgpu::GpuTimer::Callback& callback)
+    {
+        return gpuTimer ? gpuTimer->scope(callback) : ogles_gpgpu::GpuTimer::Scope();
+    }
     
     // :::::::::::::::::::::::
     // ::: Filters/Effects :::
@@ -35,11 +35,11 @@ using drishti::core::operator*;
 
 struct MethodLog
 {
-    MethodLog(const std::string& name)
+    MethodLog(const char* name)
         : name(name)
     {
     }
-    std::string name;
+    const char* name;
     std::stringstream ss;
 };
 
@@ -139,6 +139,16 @@ bool FaceFinderPainter::getShowDetectionScales() const
     return m_painter->getShowDetectionScales();
 }
 
+void FaceFinderPainter::setOverlayScale(float value)
+{
+    m_painter->setOverlayScale(value);
+}
+
+float FaceFinderPainter::getOverlayScale() const
+{
+    return m_painter->getOverlayScale();
+}
+
 // Get output pixels via callback (zero copy where possible):
 void FaceFinderPainter::getOutputPixels(FrameDelegate& callback)
 {
@@ -227,10 +237,11 @@ void cat(const Container& a, const Container& b, Container& c)
 GLuint FaceFinderPainter::filter(const ScenePrimitives& scene, GLuint inputTexture)
 {
     // clang-format on
-    MethodLog timeSummary(DRISHTI_LOCATION_SIMPLE);
-    core::ScopeTimeLogger paintLogger = [&](double ts) {
-        impl->logger->info("TIMING:{}={};{}", timeSummary.name, ts, timeSummary.ss.str());
-    };
+    constexpr const char* location = DRISHTI_LOCATION_STATIC;
+    MethodLog timeSummary(location);
+    auto paintLogger = core::makeScopeTimer<core::kTimingDisplay>("paint", [&](double ts) {
+        DRISHTI_LOG_INFO(impl->logger, "TIMING:{}={};{}", timeSummary.name, ts, timeSummary.ss.str());
+    });
 // clang-format off
     
 #if DRISHTI_HCI_FACE_FINDER_PAINTER_SHOW_CIRCLE
@@ -248,6 +259,7 @@ GLuint FaceFinderPainter::filter(const ScenePrimitives& scene, GLuint inputTextu
     
     // Convert objects to line drawings
     m_painter->getLineDrawings().clear();
+    m_painter->setFrameIndex(scene.m_frameIndex); // the overlay layer is cached per scene
     
     // Always set motion axes:
     if (m_pImpl->m_showMotionAxes)
@@ -325,6 +337,8 @@ GLuint FaceFinderPainter::paint(const ScenePrimitives& scene, GLuint inputTextur
 {
     m_painter->setBrightness(impl->brightness);
 
+    auto gpuTime = impl->timeGpu([this](double t) { impl->timerInfo.paintGpuTimeLogger(t); });
+
     // Here we can choose one of several display layouts or effects:
     switch(m_effect)
     {
@@ -56,6 +56,10 @@ public:
     void setShowDetectionScales(bool value);
     bool getShowDetectionScales() const;
 
+    // Resolution of the cached annotation layer wrt the output (0 : full resolution, uncached):
+    void setOverlayScale(float value);
+    float getOverlayScale() const;
+
     void setEffectKind(EffectKind kind);
     EffectKind getEffectKind() const;
 
@@ -14,6 +14,7 @@
 #include "drishti/hci/drishti_hci.h"
 #include "drishti/face/Face.h"
 #include "drishti/eye/Eye.h"
+#include "drishti/eye/NormalizedIris.h"
 #include "drishti/core/ImageView.h" // Image and/or Texture
 
 #include <opencv2/core/core.hpp>
@@ -63,6 +64,9 @@ public:
 
         //! Additional image data (reserved).
         core::ImageView filtered;
+
+        //! GPU normalized irises (RGBA) with eyelid masks, most recent frame only (see Request::getIrises)
+        std::array<drishti::eye::NormalizedIris, 2> irises;
     };
 
     struct Request
@@ -75,15 +79,19 @@ public:
         {
         }
 
-        int n = 0;               //! Number of frames requested (last n)
-        bool getImage = false;   //! Request an image (typically incurs some overhead)
-        bool getTexture = false; //! Request a texture (typically no overhead)
+        int n = 0;                   //! Number of frames requested (last n)
+        bool getImage = false;       //! Request an image (typically incurs some overhead)
+        bool getTexture = false;     //! Request a texture (typically no overhead)
+        bool getLazyImage = false;   //! Request a deferred readback handle (overhead only if used)
+        bool getIrises = false;      //! Request GPU normalized irises (enables readback, one frame latency)
 
         Request& operator|=(const Request& src)
         {
             n = std::max(n, src.n);
             getTexture |= src.getTexture;
             getImage |= src.getImage;
+            getLazyImage |= src.getLazyImage;
+            getIrises |= src.getIrises;
             return (*this);
         }
     };
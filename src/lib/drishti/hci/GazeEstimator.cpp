@@ -9,69 +9,213 @@
 */
 
 #include "drishti/hci/GazeEstimator.h"
+#include "drishti/hci/Scene.hpp"
 #include "drishti/face/FaceIO.h"
 #include "drishti/face/face_util.h"
-#include "drishti/ml/XGBooster.h"
 #include "drishti/geometry/Primitives.h"
 #include "drishti/geometry/motion.h"
 
 #include <opencv2/core/core.hpp>
-#include <opencv2/video/video.hpp>
-#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
 
-#include <fstream>
+#include <cmath>
+#include <mutex>
 
 DRISHTI_HCI_NAMESPACE_BEGIN
 
+// Regularization of the uncalibrated model (initial RLS covariance):
+static const double kPrior = 1e3;
+
+// Iris center in a frame with the eye corners at (-1,0) and (+1,0), +x is image right for both eyes:
+static bool getEyeFeature(const eye::EyeModel& eye, bool isRight, cv::Point2f& feature, float& openness)
+{
+    if (eye.eyelids.empty() || (eye.irisEllipse.size.width <= 0.f))
+    {
+        return false;
+    }
+
+    const cv::Point2f& a = isRight ? eye.getOuterCorner() : eye.getInnerCorner();
+    const cv::Point2f& b = isRight ? eye.getInnerCorner() : eye.getOuterCorner();
+    const cv::Point2f d = (b - a) * 0.5f, u = eye.irisEllipse.center - (a + b) * 0.5f;
+    const float d2 = d.dot(d);
+    if (d2 <= 0.f)
+    {
+        return false;
+    }
+    feature = { u.dot(d) / d2, d.cross(u) / d2 };
+
+    // Same as EyeModel::openness() with closed form eigenvalues of the 2x2 covariance:
+    const cv::Moments mom = cv::moments(eye.eyelids);
+    if (mom.m00 > 0.0)
+    {
+        const double a20 = mom.mu20 / mom.m00, a11 = mom.mu11 / mom.m00, a02 = mom.mu02 / mom.m00;
+        const double m = (a20 + a02) * 0.5, r = std::sqrt((a20 - a02) * (a20 - a02) * 0.25 + a11 * a11);
+        openness = static_cast<float>((m - r) / (m + r + 1e-6));
+    }
+    else
+    {
+        openness = 0.f;
+    }
+    return true;
+}
+
+static bool getFaceFeature(const face::FaceModel& face, cv::Vec3d& phi, float& openness)
+{
+    cv::Point2f sum, feature;
+    float opennessSum = 0.f, value = 0.f;
+    int count = 0;
+    if (face.eyeFullR.has && getEyeFeature(face.eyeFullR.value, true, feature, value))
+    {
+        sum += feature;
+        opennessSum += value;
+        count++;
+    }
+    if (face.eyeFullL.has && getEyeFeature(face.eyeFullL.value, false, feature, value))
+    {
+        sum += feature;
+        opennessSum += value;
+        count++;
+    }
+    if (count == 0)
+    {
+        return false;
+    }
+
+    phi = { sum.x / count, sum.y / count, 1.0 };
+    openness = opennessSum / count;
+    return true;
+}
+
 class GazeEstimator::Impl
 {
 public:
     using PointPair = GazeEstimator::GazeEstimate;
+    using Model = cv::Matx<double, 3, 2>;
 
-    struct GazeMeasurement
-    {
-    };
-
-    Impl()
+    Impl(float forgetting)
+        : m_forgetting(forgetting)
     {
+        CV_Assert((forgetting > 0.f) && (forgetting <= 1.f));
+        reset();
     }
+
     void begin()
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_session = true;
+        m_residual = {};
+        m_count = 0;
     }
 
     PointPair end()
     {
-        return PointPair();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_session = false;
+        if (m_count == 0)
+        {
+            return PointPair();
+        }
+        return PointPair({ float(std::sqrt(m_residual[0] / m_count)), float(std::sqrt(m_residual[1] / m_count)) });
     }
 
     void reset()
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_theta = Model(1.0, 0.0, 0.0, 1.0, 0.0, 0.0); // identity on the iris offset
+        m_P = cv::Matx33d::eye() * kPrior;
+        m_residual = {};
+        m_count = 0;
+    }
+
+    bool update(const face::FaceModel& face, const cv::Point2f& target)
+    {
+        cv::Vec3d phi;
+        float openness = 0.f;
+        if (!getFaceFeature(face, phi, openness))
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Standard RLS step, shared by both outputs since they have the same regressors:
+        const cv::Vec3d Pphi = m_P * phi;
+        const cv::Vec3d k = Pphi * (1.0 / (m_forgetting + phi.dot(Pphi)));
+        const cv::Vec2d y(target.x, target.y);
+        const cv::Vec2d e = y - m_theta.t() * phi;
+        m_theta += cv::Matx<double, 3, 1>(k.val) * cv::Matx<double, 1, 2>(e.val);
+        m_P = (m_P - cv::Matx<double, 3, 1>(k.val) * cv::Matx<double, 1, 3>(Pphi.val)) * (1.0 / m_forgetting);
+
+        if (m_session)
+        {
+            const cv::Vec2d r = y - m_theta.t() * phi;
+            m_residual += r.mul(r);
+            m_count++;
+        }
+        return true;
     }
 
-    std::pair<face::FaceModel, cv::Matx33f> getNormalizedFace(const face::FaceModel& faceIn) const
+    PointPair operator()(const face::FaceModel& faceIn) const
     {
-        // Do similarity normalization on iris centers::
-        std::array<cv::Point2f, 2> ptsA{ { faceIn.eyeFullR->irisEllipse.center, faceIn.eyeFullL->irisEllipse.center } };
-        std::array<cv::Point2f, 2> ptsB{ { { 0.25, 0.25 }, { 0.75, 0.25 } } };
-        cv::Matx33f H = transformation::estimateSimilarity(ptsA, ptsB);
-        DRISHTI_FACE::FaceModel face = H * faceIn;
-        return std::make_pair(face, H);
+        cv::Vec3d phi;
+        float openness = 0.f;
+        if (!getFaceFeature(faceIn, phi, openness))
+        {
+            return PointPair({}, -1.f);
+        }
+
+        Model theta;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            theta = m_theta;
+        }
+        const cv::Vec2d q = theta.t() * phi;
+        return PointPair({ float(q[0]), float(q[1]) }, openness);
     }
 
-    PointPair operator()(const face::FaceModel& faceIn)
+    void operator()(const ScenePrimitives& scene, std::vector<PointPair>& gaze) const
     {
-        PointPair gaze;
-        return gaze;
+        Model theta;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            theta = m_theta;
+        }
+
+        const auto& faces = scene.faces();
+        gaze.resize(faces.size());
+        for (std::size_t i = 0; i < faces.size(); i++)
+        {
+            cv::Vec3d phi;
+            float openness = 0.f;
+            if (getFaceFeature(faces[i], phi, openness))
+            {
+                const cv::Vec2d q = theta.t() * phi;
+                gaze[i] = PointPair({ float(q[0]), float(q[1]) }, openness);
+            }
+            else
+            {
+                gaze[i] = PointPair({}, -1.f);
+            }
+        }
     }
 
 protected:
+    mutable std::mutex m_mutex;
+
+    double m_forgetting = 1.0;
+    Model m_theta;
+    cv::Matx33d m_P;
+
+    bool m_session = false;
+    cv::Vec2d m_residual;
+    int m_count = 0;
 };
 
 // ### gaze ###
 
-GazeEstimator::GazeEstimator()
+GazeEstimator::GazeEstimator(float forgetting)
 {
-    m_pImpl = std::make_shared<Impl>();
+    m_pImpl = std::make_shared<Impl>(forgetting);
 }
 
 void GazeEstimator::reset()
@@ -84,6 +228,11 @@ void GazeEstimator::begin()
     m_pImpl->begin();
 }
 
+bool GazeEstimator::update(const face::FaceModel& face, const cv::Point2f& target)
+{
+    return m_pImpl->update(face, target);
+}
+
 GazeEstimator::GazeEstimate GazeEstimator::end()
 {
     return m_pImpl->end();
@@ -94,4 +243,21 @@ GazeEstimator::GazeEstimate GazeEstimator::operator()(const face::FaceModel& fac
     return (*m_pImpl)(face);
 }
 
+void GazeEstimator::operator()(const ScenePrimitives& scene, std::vector<GazeEstimate>& gaze) const
+{
+    (*m_pImpl)(scene, gaze);
+}
+
+void GazeEstimator::getGazePoints(const std::vector<GazeEstimate>& gaze, std::vector<FeaturePoint>& points)
+{
+    points.clear();
+    for (const auto& g : gaze)
+    {
+        if (g.openness >= 0.f)
+        {
+            points.emplace_back(g.relative);
+        }
+    }
+}
+
 DRISHTI_HCI_NAMESPACE_END
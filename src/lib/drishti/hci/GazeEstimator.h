@@ -16,13 +16,26 @@
 #include "drishti/sensor/Sensor.h"
 
 #include <memory>
+#include <vector>
 
 DRISHTI_HCI_NAMESPACE_BEGIN
 
+struct FeaturePoint;
+struct ScenePrimitives;
+
 #define GAZE_NOSE 1
 #define GAZE_BROW 1
 #define GAZE_CREASE 1
 
+/*
+ * The gaze feature of a face is the mean iris center of the available eyes, expressed in a
+ * frame where the eye corners lie at (-1,0) and (+1,0).  An affine map from the feature to the
+ * normalized screen point (the FacePainter convention: [-0.5, +0.5] about the screen center)
+ * is calibrated by recursive least squares, so each calibration sample is an O(1) update of a
+ * 3x3 covariance and no matrices are allocated per call.  Until calibrated, the estimate is
+ * the raw feature.
+ */
+
 class GazeEstimator
 {
 public:
@@ -38,17 +51,29 @@ public:
         }
 
         cv::Point2f relative;
-        float openness = 0.f;
+        float openness = 0.f; // < 0 : no eyes were available for this face
     };
 
-    GazeEstimator();
+    // forgetting : RLS forgetting factor in (0,1], 1 : all calibration samples are weighted equally
+    GazeEstimator(float forgetting = 1.f);
+
+    void reset(); // restore the uncalibrated model
+    void begin(); // start a new calibration session
 
-    void reset();
-    void begin();
+    // Add one calibration sample (the face looking at the normalized screen point target):
+    bool update(const face::FaceModel& face, const cv::Point2f& target);
+
+    // End the session, the relative field of the result holds the RMS calibration residual per axis:
     GazeEstimate end();
 
     GazeEstimate operator()(const face::FaceModel& face) const;
 
+    // Estimate all faces in the scene, gaze retains its capacity across frames:
+    void operator()(const ScenePrimitives& scene, std::vector<GazeEstimate>& gaze) const;
+
+    // Valid estimates in the form expected by FacePainter::setGazePoint():
+    static void getGazePoints(const std::vector<GazeEstimate>& gaze, std::vector<FeaturePoint>& points);
+
 protected:
     std::shared_ptr<Impl> m_pImpl;
 };
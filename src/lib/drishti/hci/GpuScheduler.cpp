@@ -0,0 +1,152 @@
+/*! -*-c++-*-
+  @file   drishti/hci/GpuScheduler.cpp
+  @author David Hirvonen
+  @brief  Interleave the GPU passes of several FaceFinder pipelines sharing one GL context.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/GpuScheduler.h"
+
+#include <algorithm>
+#include <limits>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+GpuScheduler::Pass::Pass(GpuScheduler* scheduler, std::size_t pipeline, Phase phase)
+    : m_scheduler(scheduler)
+{
+    m_scheduler->begin(pipeline, phase);
+}
+
+GpuScheduler::Pass::Pass(Pass&& src)
+    : m_scheduler(src.m_scheduler)
+{
+    src.m_scheduler = nullptr;
+}
+
+GpuScheduler::Pass& GpuScheduler::Pass::operator=(Pass&& src)
+{
+    if (this != &src)
+    {
+        release();
+        std::swap(m_scheduler, src.m_scheduler);
+    }
+    return *this;
+}
+
+GpuScheduler::Pass::~Pass()
+{
+    release();
+}
+
+void GpuScheduler::Pass::release()
+{
+    if (m_scheduler)
+    {
+        m_scheduler->end();
+        m_scheduler = nullptr;
+    }
+}
+
+std::size_t GpuScheduler::attach()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pipelines++;
+    return m_nextId++;
+}
+
+void GpuScheduler::detach(std::size_t pipeline)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pipelines = (m_pipelines > 0) ? (m_pipelines - 1) : 0;
+    }
+    m_condition.notify_all(); // the readback deferral limit may have changed
+}
+
+std::size_t GpuScheduler::getPipelineCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pipelines;
+}
+
+std::size_t GpuScheduler::getPassCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_passes;
+}
+
+std::size_t GpuScheduler::getWaitingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_waiting.size();
+}
+
+std::uint64_t GpuScheduler::select() const
+{
+    const Waiter* submit = nullptr;
+    const Waiter* readback = nullptr;
+    for (const auto& waiter : m_waiting)
+    {
+        if (waiter.phase == kSubmit)
+        {
+            // Round robin: the first pipeline after the last one served (unsigned wrap around):
+            const std::size_t distance = waiter.pipeline - m_last - 1;
+            if (!submit || (distance < submit->pipeline - m_last - 1) || ((waiter.pipeline == submit->pipeline) && (waiter.ticket < submit->ticket)))
+            {
+                submit = &waiter;
+            }
+        }
+        else if (!readback || (waiter.ticket < readback->ticket))
+        {
+            readback = &waiter;
+        }
+    }
+
+    if (submit && (!readback || (m_deferred < std::max(m_pipelines, std::size_t(1)))))
+    {
+        return submit->ticket;
+    }
+    return readback ? readback->ticket : std::numeric_limits<std::uint64_t>::max();
+}
+
+void GpuScheduler::begin(std::size_t pipeline, Phase phase)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    const std::uint64_t ticket = m_tickets++;
+    m_waiting.push_back({ pipeline, phase, ticket });
+    m_condition.wait(lock, [&]() { return !m_busy && (select() == ticket); });
+
+    const bool hasReadback = std::any_of(m_waiting.begin(), m_waiting.end(), [&](const Waiter& waiter) {
+        return (waiter.phase == kReadback) && (waiter.ticket != ticket);
+    });
+
+    m_waiting.erase(std::find_if(m_waiting.begin(), m_waiting.end(), [&](const Waiter& waiter) { return waiter.ticket == ticket; }));
+    m_busy = true;
+
+    if (phase == kSubmit)
+    {
+        m_last = pipeline;
+        m_deferred = hasReadback ? (m_deferred + 1) : 0;
+    }
+    else
+    {
+        m_deferred = 0;
+    }
+}
+
+void GpuScheduler::end()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busy = false;
+        m_passes++;
+    }
+    m_condition.notify_all();
+}
+
+DRISHTI_HCI_NAMESPACE_END
@@ -0,0 +1,107 @@
+/*! -*-c++-*-
+  @file   drishti/hci/GpuScheduler.h
+  @author David Hirvonen
+  @brief  Interleave the GPU passes of several FaceFinder pipelines sharing one GL context.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_hci_GpuScheduler_h__
+#define __drishti_hci_GpuScheduler_h__
+
+#include "drishti/hci/drishti_hci.h"
+
+#include <condition_variable>
+#include <cstddef> // std::size_t
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+/*
+ * One instance is shared by all pipelines (i.e., one FaceFinder per camera stream) that issue
+ * GL commands in the same context or share group.  Each pipeline runs its GL work in passes
+ * and only one pass runs at a time, so pipelines on different threads never interleave GL
+ * calls within a pass.  Waiting submit passes (render new frames) are run before waiting
+ * readback passes (glReadPixels), which keeps the GPU busy with the other streams while
+ * one stream blocks on its readback.  Submit passes are ordered round robin across pipelines
+ * and a readback pass is deferred for at most one submit pass per attached pipeline.
+ * Passes are not reentrant: a thread must release its pass before acquiring another one.
+ */
+
+class GpuScheduler
+{
+public:
+    enum Phase
+    {
+        kSubmit,  // render passes feeding the GPU
+        kReadback // passes that block on GPU results
+    };
+
+    //! Exclusive turn of a pipeline, released on destruction:
+    class Pass
+    {
+    public:
+        Pass() = default;
+        Pass(GpuScheduler* scheduler, std::size_t pipeline, Phase phase);
+        Pass(Pass&& src);
+        Pass& operator=(Pass&& src);
+        Pass(const Pass&) = delete;
+        Pass& operator=(const Pass&) = delete;
+        ~Pass();
+
+        void release();
+
+    protected:
+        GpuScheduler* m_scheduler = nullptr;
+    };
+
+    GpuScheduler() = default;
+    GpuScheduler(const GpuScheduler&) = delete;
+    GpuScheduler& operator=(const GpuScheduler&) = delete;
+
+    //! Register a pipeline, the returned id identifies its passes:
+    std::size_t attach();
+    void detach(std::size_t pipeline);
+
+    Pass acquire(std::size_t pipeline, Phase phase)
+    {
+        return Pass(this, pipeline, phase);
+    }
+
+    std::size_t getPipelineCount() const;
+    std::size_t getPassCount() const;
+    std::size_t getWaitingCount() const;
+
+protected:
+    struct Waiter
+    {
+        std::size_t pipeline;
+        Phase phase;
+        std::uint64_t ticket;
+    };
+
+    void begin(std::size_t pipeline, Phase phase);
+    void end();
+
+    // Ticket of the waiter that runs next (requires m_mutex):
+    std::uint64_t select() const;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<Waiter> m_waiting;
+    bool m_busy = false;
+    std::size_t m_pipelines = 0;           // attached pipelines
+    std::size_t m_nextId = 0;              // id of the next attached pipeline
+    std::size_t m_last = std::size_t(-1);  // pipeline of the last submit pass
+    std::size_t m_deferred = 0;            // submit passes run ahead of the oldest readback
+    std::uint64_t m_tickets = 0;           // arrival order
+    std::size_t m_passes = 0;              // completed passes
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_GpuScheduler_h__
@@ -0,0 +1,112 @@
+/*! -*-c++-*-
+  @file   drishti/hci/PerformanceGovernor.cpp
+  @author David Hirvonen
+  @brief  Thermal, battery and frame time aware selection of the FaceFinder quality level.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/PerformanceGovernor.h"
+
+#include <algorithm>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+// Frame time smoothing (exponential moving average):
+static const double kFrameTimeAlpha = 0.9;
+
+PerformanceGovernor::PerformanceGovernor()
+    : PerformanceGovernor(Settings())
+{
+}
+
+PerformanceGovernor::PerformanceGovernor(const Settings& settings, const PowerMonitor& monitor)
+    : m_settings(settings)
+    , m_monitor(monitor)
+{
+    if (m_settings.levels.empty())
+    {
+        m_settings.levels = getDefaultLevels();
+    }
+}
+
+std::vector<PerformanceGovernor::Quality> PerformanceGovernor::getDefaultLevels()
+{
+    std::vector<Quality> levels(3);
+
+    levels[0].minInterval = 0.1;
+    levels[0].doFlow = false;
+
+    levels[1] = levels[0];
+    levels[1].minInterval = 0.25;
+    levels[1].faceStagesHint = 8; // Context::kProfileLowPower
+    levels[1].eyelidStagesHint = 6;
+    levels[1].irisStagesHint = 6;
+    levels[1].doBlobs = false;
+
+    levels[2] = levels[1];
+    levels[2].minInterval = 0.5;
+    levels[2].doEyeRefinement = false;
+
+    return levels;
+}
+
+const PerformanceGovernor::Quality& PerformanceGovernor::getQuality() const
+{
+    return (m_level > 0) ? m_settings.levels[m_level - 1] : m_nominal;
+}
+
+bool PerformanceGovernor::update(double frameTime, double now)
+{
+    // The cost changes with the level, so the average restarts after each change:
+    m_frameTime = (m_frames++ == 0) ? frameTime : ((kFrameTimeAlpha * m_frameTime) + ((1.0 - kFrameTimeAlpha) * frameTime));
+
+    if (m_monitor && (!m_hasPoll || ((now - m_lastPoll) >= m_settings.pollInterval)))
+    {
+        m_power = m_monitor();
+        m_lastPoll = now;
+        m_hasPoll = true;
+    }
+
+    const double target = 1.0 / std::max(m_settings.targetFrameRate, 1e-3f);
+    const bool isSlow = (m_frameTime > (target * m_settings.upperMargin));
+    const bool isFast = (m_frameTime < (target * m_settings.lowerMargin));
+    const bool isHot = (m_power.thermal >= m_settings.thermalHigh);
+    const bool isCool = (m_power.thermal < m_settings.thermalLow);
+    const bool isLowBattery = !m_power.isCharging && (m_power.battery < m_settings.batteryLow);
+
+    const int last = getLevelCount() - 1;
+    int level = m_level;
+    if (m_power.thermal >= m_settings.thermalCritical)
+    {
+        level = last;
+    }
+    else if (isSlow || isHot || isLowBattery)
+    {
+        m_up = 0;
+        level += (++m_down >= m_settings.downFrames);
+    }
+    else if (isFast && isCool)
+    {
+        m_down = 0;
+        level -= (++m_up >= m_settings.upFrames);
+    }
+    else
+    {
+        m_up = m_down = 0; // within the hysteresis band
+    }
+
+    level = std::max(std::min(level, last), 0);
+    if (level == m_level)
+    {
+        return false;
+    }
+
+    m_level = level;
+    m_frames = m_up = m_down = 0;
+    return true;
+}
+
+DRISHTI_HCI_NAMESPACE_END
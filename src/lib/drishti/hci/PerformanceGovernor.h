@@ -0,0 +1,105 @@
+/*! -*-c++-*-
+  @file   drishti/hci/PerformanceGovernor.h
+  @author David Hirvonen
+  @brief  Thermal, battery and frame time aware selection of the FaceFinder quality level.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_hci_PerformanceGovernor_h__
+#define __drishti_hci_PerformanceGovernor_h__
+
+#include "drishti/hci/drishti_hci.h"
+
+#include <cstddef> // std::size_t
+#include <functional>
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+/*
+ * Level 0 runs the FaceFinder as configured, each further level reduces the work per frame.
+ * The smoothed frame time must stay above (below) the target for downFrames (upFrames)
+ * consecutive frames before the governor steps down (up) one level, and it only steps up
+ * when the device is cool and not on a low battery, so the quality doesn't oscillate at
+ * the edges of a profile.  A critical thermal state selects the last level immediately.
+ */
+
+class PerformanceGovernor
+{
+public:
+    //! Platform signals (i.e., from the OS thermal and battery notifications):
+    struct PowerState
+    {
+        float thermal = 0.f;    // 0 : nominal, 1 : critical (normalized thermal state)
+        float battery = 1.f;    // remaining charge 0..1
+        bool isCharging = true; // battery is ignored while charging
+    };
+
+    using PowerMonitor = std::function<PowerState()>;
+
+    //! Work reductions of a level (the defaults leave the configured FaceFinder settings as is):
+    struct Quality
+    {
+        double minInterval = 0.0; // lower bound of the detection interval (seconds)
+        int faceStagesHint = -1;  // upper bound for the cascade stage hints (-1 : configured)
+        int eyelidStagesHint = -1;
+        int irisStagesHint = -1;
+        bool doEyeRefinement = true;
+        bool doFlow = true;  // eye flow readback (if enabled)
+        bool doBlobs = true; // eye reflection readback, extraction and gaze points (if enabled)
+    };
+
+    struct Settings
+    {
+        float targetFrameRate = 30.f; // frames per second to hold
+        float upperMargin = 1.1f;     // step down above upperMargin / targetFrameRate seconds per frame
+        float lowerMargin = 0.7f;     // step up below lowerMargin / targetFrameRate seconds per frame
+        std::size_t downFrames = 15;
+        std::size_t upFrames = 120;
+
+        float thermalHigh = 0.6f;     // step down at or above
+        float thermalLow = 0.4f;      // step up only below
+        float thermalCritical = 0.9f; // last level
+        float batteryLow = 0.2f;      // step down below (when not charging)
+        double pollInterval = 1.0;    // seconds between PowerMonitor queries
+
+        std::vector<Quality> levels; // levels 1..N (empty : getDefaultLevels())
+    };
+
+    PerformanceGovernor();
+    PerformanceGovernor(const Settings& settings, const PowerMonitor& monitor = {});
+
+    //! Reduced detection, then shorter cascades without optical flow, blobs and eye models:
+    static std::vector<Quality> getDefaultLevels();
+
+    //! Add the duration of a frame (seconds) at time now (seconds), return true if the level changed:
+    bool update(double frameTime, double now);
+
+    int getLevel() const { return m_level; }
+    int getLevelCount() const { return static_cast<int>(m_settings.levels.size()) + 1; }
+    const Quality& getQuality() const;
+
+    const PowerState& getPowerState() const { return m_power; }
+    double getFrameTime() const { return m_frameTime; }
+
+protected:
+    Settings m_settings;
+    PowerMonitor m_monitor;
+
+    PowerState m_power;
+    Quality m_nominal; // level 0
+    double m_frameTime = 0.0;
+    double m_lastPoll = 0.0;
+    bool m_hasPoll = false;
+    std::size_t m_frames = 0; // since the last level change
+    std::size_t m_down = 0;   // consecutive frames above the target
+    std::size_t m_up = 0;     // consecutive frames below the target
+    int m_level = 0;
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_PerformanceGovernor_h__
@@ -33,6 +33,45 @@ void ScenePrimitives::draw(bool doFaces, bool doPupils, bool doCorners)
     }
 }
 
+void ScenePrimitives::recycle(uint64_t frameIndex)
+{
+    clear();
+    colors.clear();
+    m_drawings.clear();
+    m_eyeDrawings[0].clear();
+    m_eyeDrawings[1].clear();
+    m_image.release();
+    m_P.reset();
+    m_frameIndex = frameIndex;
+    m_captureTime = {};
+}
+
+ScenePrimitives ScenePrimitivesPool::acquire(uint64_t frameIndex)
+{
+    ScenePrimitives scene(frameIndex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_scenes.empty())
+        {
+            scene = std::move(m_scenes.back());
+            m_scenes.pop_back();
+        }
+    }
+    scene.m_frameIndex = frameIndex;
+    return scene;
+}
+
+void ScenePrimitivesPool::release(ScenePrimitives&& scene)
+{
+    scene.recycle(0); // drop image and pyramid references now
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_scenes.size() < m_capacity)
+    {
+        m_scenes.push_back(std::move(scene));
+    }
+}
+
 static float getAngle(const cv::Point2f& p)
 {
     return (std::atan2(p.y, p.x) + M_PI) * 180.0 / M_PI;
@@ -209,4 +248,26 @@ void extractPoints(const cv::Mat1b& input, std::vector<drishti::hci::FeaturePoin
     });
 }
 
+// Each texel holds the strongest peak of a tile: (r, g) = pixel position, a = response
+void extractPeaks(const cv::Mat4b& peaks, std::vector<drishti::hci::FeaturePoint>& features, float scale)
+{
+    features.reserve(peaks.total());
+    for (int y = 0; y < peaks.rows; y++)
+    {
+        for (int x = 0; x < peaks.cols; x++)
+        {
+            const cv::Vec4b& peak = peaks(y, x);
+            if (peak[3])
+            {
+                const float radius = static_cast<float>(peak[3]) / 255.f;
+                features.emplace_back(cv::Point2f(scale * peak[0], scale * peak[1]), radius);
+            }
+        }
+    }
+
+    std::sort(features.begin(), features.end(), [](const FeaturePoint& pa, const FeaturePoint& pb) {
+        return (pa.radius > pb.radius);
+    });
+}
+
 DRISHTI_HCI_NAMESPACE_END
@@ -19,6 +19,8 @@
 
 #include <opencv2/core/core.hpp>
 
+#include <chrono>
+#include <mutex>
 #include <vector>
 
 DRISHTI_HCI_NAMESPACE_BEGIN
@@ -53,6 +55,12 @@ struct ScenePrimitives
     {
     }
 
+    // Scenes are handed off between pipeline stages by move:
+    ScenePrimitives(ScenePrimitives&&) = default;
+    ScenePrimitives& operator=(ScenePrimitives&&) = default;
+    ScenePrimitives(const ScenePrimitives&) = delete;
+    ScenePrimitives& operator=(const ScenePrimitives&) = delete;
+
     const std::vector<drishti::face::FaceModel>& faces() const
     {
         return m_faces;
@@ -128,7 +136,11 @@ struct ScenePrimitives
 
     void draw(bool doFaces = true, bool doPupils = true, bool doCorners = true);
 
+    // Clear all content for a new frame, retaining container capacity:
+    void recycle(uint64_t frameIndex);
+
     uint64_t m_frameIndex = 0;
+    std::chrono::high_resolution_clock::time_point m_captureTime; // capture (or arrival) time of the frame
     cv::Mat m_image;
 
     std::vector<cv::Vec4f> m_flow; // Temporary
@@ -142,7 +154,26 @@ struct ScenePrimitives
     std::vector<std::vector<cv::Point2f>> m_eyeDrawings[2];
 };
 
+// Thread safe free list of scenes so that per frame containers keep their capacity:
+class ScenePrimitivesPool
+{
+public:
+    ScenePrimitivesPool(std::size_t capacity = 8)
+        : m_capacity(capacity)
+    {
+    }
+
+    ScenePrimitives acquire(uint64_t frameIndex);
+    void release(ScenePrimitives&& scene);
+
+protected:
+    std::mutex m_mutex;
+    std::size_t m_capacity = 8;
+    std::vector<ScenePrimitives> m_scenes;
+};
+
 void extractPoints(const cv::Mat1b& input, std::vector<FeaturePoint>& points, float flowScale);
+void extractPeaks(const cv::Mat4b& peaks, std::vector<FeaturePoint>& points, float scale); // see PeakReductionProc
 void pointsToCircles(const std::vector<FeaturePoint>& points, LineDrawingVec& circles, float width = 8.f);
 void pointsToCrosses(const std::vector<cv::Point2f>& points, LineDrawingVec& crosses, float width = 8.f);
 void pointsToCrosses(const std::vector<FeaturePoint>& points, LineDrawingVec& crosses, float width = 8.f);
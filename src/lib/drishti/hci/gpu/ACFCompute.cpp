@@ -0,0 +1,380 @@
+/*! -*-c++-*-
+  @file   ACFCompute.cpp
+  @author David Hirvonen
+  @brief  Implementation of an OpenGL ES 3.1 compute shader path for ACF pyramid channels.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/gpu/ACFCompute.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+BEGIN_OGLES_GPGPU
+
+static const GLuint kLocalSize = 8;
+
+enum
+{
+    kLevels,
+    kPixels,
+    kGradients,
+    kBins,
+    kChannels
+};
+
+const char* ACFCompute::getProcName()
+{
+    return "ACFCompute";
+}
+
+bool ACFCompute::isSupported(int glVersionMajor, int glVersionMinor)
+{
+#if DRISHTI_HCI_GPU_HAS_COMPUTE
+#  if defined(OGLES_GPGPU_OPENGLES)
+    return (glVersionMajor > 3) || ((glVersionMajor == 3) && (glVersionMinor >= 1));
+#  else
+    return (glVersionMajor > 4) || ((glVersionMajor == 4) && (glVersionMinor >= 3));
+#  endif
+#else
+    return false;
+#endif
+}
+
+#if DRISHTI_HCI_GPU_HAS_COMPUTE
+
+// Level records: (bins x, bins y, pixel offset, channel offset), pixels are kShrink x kShrink per bin:
+
+// clang-format off
+#if defined(OGLES_GPGPU_OPENGLES)
+#define DRISHTI_ACF_COMPUTE_HEADER "#version 310 es\nprecision highp float;\nprecision highp int;\nprecision highp sampler2D;\n"
+#else
+#define DRISHTI_ACF_COMPUTE_HEADER "#version 430\n"
+#endif
+// clang-format on
+
+// clang-format off
+const char * ACFCompute::cshaderLuvSrc = DRISHTI_ACF_COMPUTE_HEADER
+OG_TO_STR(
+ layout(local_size_x = 8, local_size_y = 8) in;
+ layout(std430, binding = 0) readonly buffer Levels { ivec4 levels[]; };
+ layout(std430, binding = 1) writeonly buffer Pixels { vec4 pixels[]; };
+ uniform sampler2D uInputTex;
+ void main()
+ {
+     ivec4 level = levels[gl_GlobalInvocationID.z];
+     ivec2 size = level.xy * 4;
+     ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+     if (any(greaterThanEqual(p, size)))
+     {
+         return;
+     }
+
+     vec3 rgb = textureLod(uInputTex, (vec2(p) + 0.5) / vec2(size), 0.0).rgb;
+     vec3 xyz = mat3(0.430574, 0.222015, 0.020183, 0.341550, 0.706655, 0.129553, 0.178325, 0.071330, 0.939180) * rgb;
+     float l = ((xyz.y > 0.00885645) ? (116.0 * pow(xyz.y, 1.0 / 3.0) - 16.0) : (xyz.y * 903.296296)) / 270.0;
+     float z = 1.0 / (xyz.x + 15.0 * xyz.y + 3.0 * xyz.z + 1e-10);
+     float u = l * (52.0 * xyz.x * z - 13.0 * 0.197833) + (88.0 / 270.0);
+     float v = l * (117.0 * xyz.y * z - 13.0 * 0.468331) + (134.0 / 270.0);
+     pixels[level.z + p.y * size.x + p.x] = vec4(l, u, v, 0.0);
+ });
+// clang-format on
+
+// clang-format off
+const char * ACFCompute::cshaderGradientSrc = DRISHTI_ACF_COMPUTE_HEADER
+OG_TO_STR(
+ layout(local_size_x = 8, local_size_y = 8) in;
+ layout(std430, binding = 0) readonly buffer Levels { ivec4 levels[]; };
+ layout(std430, binding = 1) readonly buffer Pixels { vec4 pixels[]; };
+ layout(std430, binding = 2) writeonly buffer Gradients { vec2 gradients[]; };
+ float luminance(ivec4 level, ivec2 size, ivec2 p)
+ {
+     p = clamp(p, ivec2(0), size - 1);
+     return pixels[level.z + p.y * size.x + p.x].x;
+ }
+ void main()
+ {
+     ivec4 level = levels[gl_GlobalInvocationID.z];
+     ivec2 size = level.xy * 4;
+     ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+     if (any(greaterThanEqual(p, size)))
+     {
+         return;
+     }
+
+     float gx = (luminance(level, size, p + ivec2(1, 0)) - luminance(level, size, p - ivec2(1, 0))) * 0.5;
+     float gy = (luminance(level, size, p + ivec2(0, 1)) - luminance(level, size, p - ivec2(0, 1))) * 0.5;
+     float m = sqrt(gx * gx + gy * gy);
+     float o = (m > 0.0) ? atan(gy, gx) : 0.0;
+     gradients[level.z + p.y * size.x + p.x] = vec2(m, (o < 0.0) ? (o + 3.14159265) : o);
+ });
+// clang-format on
+
+// clang-format off
+const char * ACFCompute::cshaderBinSrc = DRISHTI_ACF_COMPUTE_HEADER
+OG_TO_STR(
+ layout(local_size_x = 8, local_size_y = 8) in;
+ layout(std430, binding = 0) readonly buffer Levels { ivec4 levels[]; };
+ layout(std430, binding = 1) readonly buffer Pixels { vec4 pixels[]; };
+ layout(std430, binding = 2) readonly buffer Gradients { vec2 gradients[]; };
+ layout(std430, binding = 3) writeonly buffer Bins { float bins[]; };
+ uniform int uColorChannels;
+ void main()
+ {
+     ivec4 level = levels[gl_GlobalInvocationID.z];
+     ivec2 size = level.xy * 4;
+     ivec2 b = ivec2(gl_GlobalInvocationID.xy);
+     if (any(greaterThanEqual(b, level.xy)))
+     {
+         return;
+     }
+
+     ivec2 lo = max((b - 1) * 4, ivec2(0));
+     ivec2 hi = min((b + 2) * 4, size);
+     float s = 0.0;
+     for (int y = lo.y; y < hi.y; y++)
+     {
+         for (int x = lo.x; x < hi.x; x++)
+         {
+             s += gradients[level.z + y * size.x + x].x;
+         }
+     }
+     s = 1.0 / (s / float((hi.x - lo.x) * (hi.y - lo.y)) + 0.005);
+
+     vec3 luv = vec3(0.0);
+     float m = 0.0;
+     float h[6];
+     for (int k = 0; k < 6; k++)
+     {
+         h[k] = 0.0;
+     }
+     for (int y = b.y * 4; y < (b.y * 4 + 4); y++)
+     {
+         for (int x = b.x * 4; x < (b.x * 4 + 4); x++)
+         {
+             int i = level.z + y * size.x + x;
+             vec2 g = gradients[i];
+             float gm = g.x * s;
+             luv += pixels[i].xyz;
+             m += gm;
+             h[int(floor(g.y * (6.0 / 3.14159265) + 0.5)) % 6] += gm;
+         }
+     }
+
+     int plane = level.x * level.y;
+     int i = level.w + b.x * level.y + b.y;
+     for (int c = 0; c < uColorChannels; c++)
+     {
+         bins[i + c * plane] = luv[c] / 16.0;
+     }
+     bins[i + uColorChannels * plane] = m / 16.0;
+     for (int k = 0; k < 6; k++)
+     {
+         bins[i + (uColorChannels + 1 + k) * plane] = h[k] / 16.0;
+     }
+ });
+// clang-format on
+
+// clang-format off
+const char * ACFCompute::cshaderSmoothSrc = DRISHTI_ACF_COMPUTE_HEADER
+OG_TO_STR(
+ layout(local_size_x = 8, local_size_y = 8) in;
+ layout(std430, binding = 0) readonly buffer Levels { ivec4 levels[]; };
+ layout(std430, binding = 3) readonly buffer Bins { float bins[]; };
+ layout(std430, binding = 4) writeonly buffer Channels { float channels[]; };
+ uniform int uChannels;
+ float bin(ivec4 level, int c, ivec2 b)
+ {
+     b = clamp(b, ivec2(0), level.xy - 1);
+     return bins[level.w + c * level.x * level.y + b.x * level.y + b.y];
+ }
+ void main()
+ {
+     ivec4 level = levels[gl_GlobalInvocationID.z];
+     ivec2 b = ivec2(gl_GlobalInvocationID.xy);
+     if (any(greaterThanEqual(b, level.xy)))
+     {
+         return;
+     }
+
+     for (int c = 0; c < uChannels; c++)
+     {
+         float sum = 0.0;
+         for (int dy = -1; dy <= 1; dy++)
+         {
+             for (int dx = -1; dx <= 1; dx++)
+             {
+                 sum += float((2 - abs(dx)) * (2 - abs(dy))) * bin(level, c, b + ivec2(dx, dy));
+             }
+         }
+         channels[level.w + c * level.x * level.y + b.x * level.y + b.y] = sum / 16.0;
+     }
+ });
+// clang-format on
+
+static GLuint buildProgram(const char* src)
+{
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 1, &src, nullptr);
+    glCompileShader(shader);
+
+    GLint status = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status)
+    {
+        GLchar log[1024] = { 0 };
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        glDeleteShader(shader);
+        throw std::runtime_error(std::string("ACFCompute: shader error: ") + log);
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDeleteShader(shader);
+
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status)
+    {
+        glDeleteProgram(program);
+        throw std::runtime_error("ACFCompute: link error");
+    }
+    return program;
+}
+
+ACFCompute::ACFCompute(const std::vector<Level>& levels, int colorChannels)
+    : levels(levels)
+    , colorChannels(colorChannels)
+{
+    std::vector<GLint> records;
+    std::size_t pixels = 0;
+    offsets.push_back(0);
+    for (const auto& level : levels)
+    {
+        const std::size_t bins = level.width * level.height;
+        records.insert(records.end(), { level.width, level.height, GLint(pixels), GLint(offsets.back()) });
+        pixels += bins * kShrink * kShrink;
+        offsets.push_back(offsets.back() + bins * getChannels());
+    }
+
+    const char* sources[4] = { cshaderLuvSrc, cshaderGradientSrc, cshaderBinSrc, cshaderSmoothSrc };
+    for (int i = 0; i < 4; i++)
+    {
+        programs[i] = buildProgram(sources[i]);
+    }
+
+    const GLsizeiptr sizes[5] = {
+        GLsizeiptr(records.size() * sizeof(GLint)),
+        GLsizeiptr(pixels * 4 * sizeof(GLfloat)),
+        GLsizeiptr(pixels * 2 * sizeof(GLfloat)),
+        GLsizeiptr(getSize() * sizeof(GLfloat)),
+        GLsizeiptr(getSize() * sizeof(GLfloat))
+    };
+    const GLenum usage[5] = { GL_STATIC_DRAW, GL_DYNAMIC_COPY, GL_DYNAMIC_COPY, GL_DYNAMIC_COPY, GL_DYNAMIC_READ };
+
+    glGenBuffers(5, buffers);
+    for (int i = 0; i < 5; i++)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[i]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizes[i], (i == kLevels) ? records.data() : nullptr, usage[i]);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    Tools::checkGLErr(getProcName(), "ACFCompute()");
+}
+
+ACFCompute::~ACFCompute()
+{
+    glDeleteBuffers(5, buffers);
+    for (const auto& program : programs)
+    {
+        glDeleteProgram(program);
+    }
+}
+
+void ACFCompute::dispatch(GLuint program, int width, int height)
+{
+    glUseProgram(program);
+    glDispatchCompute((width + kLocalSize - 1) / kLocalSize, (height + kLocalSize - 1) / kLocalSize, GLuint(levels.size()));
+}
+
+void ACFCompute::operator()(GLuint texture)
+{
+    int width = 0, height = 0;
+    for (const auto& level : levels)
+    {
+        width = std::max(width, level.width);
+        height = std::max(height, level.height);
+    }
+
+    for (GLuint i = 0; i < 5; i++)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, buffers[i]);
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // Each pass reads the buffer written by the previous one:
+    glUseProgram(programs[0]);
+    glUniform1i(glGetUniformLocation(programs[0], "uInputTex"), 0);
+    dispatch(programs[0], width * kShrink, height * kShrink);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    dispatch(programs[1], width * kShrink, height * kShrink);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUseProgram(programs[2]);
+    glUniform1i(glGetUniformLocation(programs[2], "uColorChannels"), colorChannels);
+    dispatch(programs[2], width, height);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUseProgram(programs[3]);
+    glUniform1i(glGetUniformLocation(programs[3], "uChannels"), getChannels());
+    dispatch(programs[3], width, height);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT); // for map()
+
+    glUseProgram(0);
+    status = true;
+
+    Tools::checkGLErr(getProcName(), "operator()");
+}
+
+const GLfloat* ACFCompute::map()
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[kChannels]);
+    return static_cast<const GLfloat*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, GLsizeiptr(getSize() * sizeof(GLfloat)), GL_MAP_READ_BIT));
+}
+
+void ACFCompute::unmap()
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[kChannels]);
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+#else // DRISHTI_HCI_GPU_HAS_COMPUTE
+
+ACFCompute::ACFCompute(const std::vector<Level>& levels, int colorChannels)
+{
+    throw std::runtime_error("ACFCompute: compute shaders are not supported");
+}
+
+ACFCompute::~ACFCompute() = default;
+
+void ACFCompute::operator()(GLuint texture) {}
+
+const GLfloat* ACFCompute::map()
+{
+    return nullptr;
+}
+
+void ACFCompute::unmap() {}
+
+#endif // DRISHTI_HCI_GPU_HAS_COMPUTE
+
+END_OGLES_GPGPU
@@ -0,0 +1,99 @@
+/*! -*-c++-*-
+  @file   ACFCompute.h
+  @author David Hirvonen
+  @brief  Declaration of an OpenGL ES 3.1 compute shader path for ACF pyramid channels.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_hci_gpu_ACFCompute_h__
+#define __drishti_hci_gpu_ACFCompute_h__
+
+#include "ogles_gpgpu/common/common_includes.h"
+
+// OpenGL ES 3.0 headers don't declare the compute entry points:
+#if defined(DRISHTI_OPENGL_ES3) && (defined(__ANDROID__) || defined(ANDROID))
+#  include <GLES3/gl31.h>
+#endif
+
+#if defined(GL_COMPUTE_SHADER) && defined(GL_SHADER_STORAGE_BUFFER)
+#  define DRISHTI_HCI_GPU_HAS_COMPUTE 1
+#else
+#  define DRISHTI_HCI_GPU_HAS_COMPUTE 0
+#endif
+
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+/*
+ * Compute the ACF channels (LUV or L, normalized gradient magnitude and 6 orientation
+ * histograms) of all pyramid levels from the upright RGBA texture in 4 dispatches:
+ *
+ * 1) resample each level (bilinear) and convert to LUV
+ * 2) gradient magnitude and orientation of L
+ * 3) 4x4 bin averages, magnitudes are normalized by the mean magnitude of the 3x3 bin
+ *    neighborhood (the CPU uses a triangle filter of radius 5 at full resolution)
+ * 4) [1 2 1] smoothing of the bins (pSmooth = 1)
+ *
+ * Levels are the upright bin sizes of acf::Detector::Pyramid, the result is one float buffer
+ * with the planes of level i at getOffset(i) in the transposed (column major) layout of the
+ * channels: plane c, upright bin (x, y) at getOffset(i) + (c * width + x) * height + y.  This
+ * is the memory of the pyramid planes, so map() can be copied plane by plane (no unpacking).
+ * All calls must be made from the GL thread of an OpenGL ES 3.1 (or OpenGL 4.3) context.
+ */
+
+class ACFCompute
+{
+public:
+    struct Level
+    {
+        int width;  // upright bins
+        int height; // upright bins
+    };
+
+    static const int kShrink = 4;
+    static const int kOrientations = 6;
+
+    ACFCompute(const std::vector<Level>& levels, int colorChannels);
+    ~ACFCompute();
+
+    static const char* getProcName();
+
+    static bool isSupported(int glVersionMajor, int glVersionMinor);
+
+    int getChannels() const { return colorChannels + 1 + kOrientations; }
+    std::size_t getOffset(int level) const { return offsets[level]; }
+    std::size_t getSize() const { return offsets.back(); } // floats
+
+    // Dispatch all levels for the texture, getStatus() is true until the next reset():
+    void operator()(GLuint texture);
+    void reset() { status = false; }
+    bool getStatus() const { return status; }
+
+    // Map the channels of the last dispatch for reading (blocks on the GPU):
+    const GLfloat* map();
+    void unmap();
+
+protected:
+    void dispatch(GLuint program, int width, int height);
+
+    std::vector<Level> levels;
+    std::vector<std::size_t> offsets; // floats, per level (+ total)
+    int colorChannels = 3;
+    bool status = false;
+
+    GLuint programs[4] = { 0, 0, 0, 0 };
+    GLuint buffers[5] = { 0, 0, 0, 0, 0 }; // levels, pixels, gradients, bins, channels
+
+    static const char* cshaderLuvSrc;
+    static const char* cshaderGradientSrc;
+    static const char* cshaderBinSrc;
+    static const char* cshaderSmoothSrc;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_hci_gpu_ACFCompute_h__
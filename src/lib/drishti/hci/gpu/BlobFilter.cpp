@@ -11,6 +11,7 @@
 #define FLASH_FILTER_USE_NEW_NMS 0
 
 #include "drishti/hci/gpu/BlobFilter.h"
+#include "drishti/hci/gpu/PeakReductionProc.h"
 #include "drishti/graphics/binomial.h"
 #include "drishti/graphics/saturation.h"
 
@@ -31,10 +32,14 @@
 
 #include <opencv2/core.hpp>
 
+#include <array>
 #include <limits>
 
 BEGIN_OGLES_GPGPU
 
+// NMS peaks are reduced to the strongest peak of each 8x8 tile (i.e., 3 log steps):
+static const int kPeakReductionLevels = 3;
+
 class BlobFilter::Impl
 {
 public:
@@ -48,12 +53,23 @@ public:
         smoothProc1.add(&saturationProc);
         saturationProc.add(&hessianProc1);
         hessianProc1.add(&nmsProc1);
+
+        peakProcs.front().setEncode(true);
+
+        ProcInterface* parent = &nmsProc1;
+        for (auto& proc : peakProcs)
+        {
+            proc.setOutputSize(0.5f);
+            parent->add(&proc);
+            parent = &proc;
+        }
     }
 
     ogles_gpgpu::GaussOptProc smoothProc1;
     ogles_gpgpu::HessianProc hessianProc1;
     ogles_gpgpu::NmsProc nmsProc1;
     ogles_gpgpu::SaturationProc saturationProc;
+    std::array<ogles_gpgpu::PeakReductionProc, kPeakReductionLevels> peakProcs;
 };
 
 BlobFilter::BlobFilter()
@@ -65,6 +81,10 @@ BlobFilter::BlobFilter()
     procPasses.push_back(&m_impl->hessianProc1);
     procPasses.push_back(&m_impl->nmsProc1);
     procPasses.push_back(&m_impl->saturationProc);
+    for (auto& proc : m_impl->peakProcs)
+    {
+        procPasses.push_back(&proc);
+    }
 }
 
 BlobFilter::~BlobFilter()
@@ -87,6 +107,11 @@ ProcInterface* BlobFilter::getHessianPeaks() const
     return &m_impl->nmsProc1;
 }
 
+ProcInterface* BlobFilter::getPeaks() const
+{
+    return &m_impl->peakProcs.back();
+}
+
 ProcInterface* BlobFilter::getOutputFilter() const
 {
     return &m_impl->nmsProc1;
@@ -34,6 +34,9 @@ public:
     ProcInterface* getHessian() const;
     ProcInterface* getHessianPeaks() const;
 
+    // Strongest peak of each tile, see PeakReductionProc (r, g: position in pixels, a: response):
+    ProcInterface* getPeaks() const;
+
     /**
      * Return the processor's name.
      */
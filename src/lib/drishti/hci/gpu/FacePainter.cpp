@@ -12,6 +12,7 @@
 #include "drishti/hci/Scene.hpp"
 #include "drishti/hci/gpu/GLPrinter.h" // import font
 #include "drishti/face/gpu/FaceStabilizer.h"
+#include "drishti/face/gpu/TextureRing.h"
 #include "drishti/geometry/motion.h"
 #include "drishti/geometry/ConicSection.h"
 #include "drishti/geometry/Cylinder.h"
@@ -21,6 +22,8 @@
 
 #include <opencv2/imgproc.hpp>
 
+#include <algorithm>
+
 #define DRISHIT_HCI_FACEPAINTER_DO_COLOR 1
 #define DRISHTI_HCI_FACEPAINTER_COLOR_TINTING 1
 #define DRISHTI_HCI_FACEPAINTER_SHOW_FLASH_INPUT 0
@@ -119,8 +122,41 @@ OG_TO_STR(
  });
 // clang-format on
 
+// ===== overlay layer shader ======
+
+// clang-format off
+const char * FacePainter::vshaderOverlaySrc = OG_TO_STR
+(
+ attribute vec4 aPos;
+ attribute vec2 aTexCoord;
+ varying vec2 vTexCoord;
+ void main()
+ {
+     vTexCoord = aTexCoord;
+     gl_Position = aPos;
+ });
+// clang-format on
+
+// clang-format off
+const char * FacePainter::fshaderOverlaySrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision mediump float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ void main()
+ {
+     gl_FragColor = texture2D(uInputTex, vTexCoord);
+ });
+// clang-format on
+
 FacePainter::~FacePainter()
 {
+    if (m_lineVbo)
+    {
+        glDeleteBuffers(1, &m_lineVbo);
+    }
 }
 
 void FacePainter::getUniforms()
@@ -165,6 +201,13 @@ FacePainter::FacePainter(int outputOrientation)
     m_drawShParamAPosition = m_draw->getParam(ATTR, "position");
     m_drawShParamUMVP = m_draw->getParam(UNIF, "modelViewProjMatrix");
 
+    m_blend = std::make_shared<Shader>();
+    compiled = m_blend->buildFromSrc(vshaderOverlaySrc, fshaderOverlaySrc);
+    assert(compiled);
+    m_blendShParamAPos = m_blend->getParam(ATTR, "aPos");
+    m_blendShParamATexCoord = m_blend->getParam(ATTR, "aTexCoord");
+    m_blendShParamUInputTex = m_blend->getParam(UNIF, "uInputTex");
+
     m_eyeAttributes = { &m_eyePoints, 8.f /*override*/, { 1.0, 0.0, 1.0 } };
     m_eyeAttributes.flow = &m_eyeFlow;
 }
@@ -211,11 +254,32 @@ static void addCross(DrawingSpec& lines, const cv::Point2f& point, const cv::Vec
     lines.colors.push_back(color);
 }
 
-void FacePainter::renderDrawings()
+static const int kLineVertexSize = 7; // x, y, z, w, r, g, b
+
+static DrawingSpec getEyeLines(const drishti::eye::EyeWarp& eyeWarp, const FacePainter::EyeAttributes& attributes);
+
+FacePainter::LineBatch FacePainter::addLines(const std::vector<cv::Point2f>& points, const std::vector<cv::Vec3f>& colors, const cv::Matx33f& H)
 {
-    //const std::string tag = DRISHTI_LOCATION_SIMPLE;
-    //drishti::core::ScopeTimeLogger renderLogger = [&](double ts) { m_logger->info("TIMING: {} = {}", tag, ts) };
+    LineBatch batch;
+    batch.first = static_cast<GLint>(m_lineVertices.size() / kLineVertexSize);
+    batch.count = static_cast<GLsizei>(points.size());
+
+    // Same homogeneous mapping as an MVP built with R3x3To4x4(H), so batches with different H share a draw call:
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+        const cv::Point3f p = H * cv::Point3f(points[i].x, points[i].y, 1.f);
+        const cv::Vec3f& c = colors[i];
+        m_lineVertices.insert(m_lineVertices.end(), { p.x, p.y, 0.f, p.z, c[0], c[1], c[2] });
+    }
+    return batch;
+}
+
+void FacePainter::prepareLines()
+{
+    m_lineVertices.clear();
+    m_drawingLines = m_axesLines = m_eyeLines = {};
 
+    // ### Line drawings (prepared with the scene on the worker thread) ###
     DrawingSpec lines(GL_LINES);
 
     if (m_showDetectionScales)
@@ -223,7 +287,6 @@ void FacePainter::renderDrawings()
         std::copy(m_permanentDrawings.begin(), m_permanentDrawings.end(), std::back_inserter(m_drawings));
     }
 
-    glLineWidth(4.0);
     for (const auto& e : m_drawings)
     {
         if (e.strip == true)
@@ -262,6 +325,103 @@ void FacePainter::renderDrawings()
         lines.colors.emplace_back(1.f, 0.f, 1.f);
     }
 
+    if (m_faces.size() && m_gazePoints.size())
+    {
+        const cv::Point2f origin(outFrameW / 2, outFrameH / 2);
+        addCross(lines, origin, { 1.f, 1.f, 0.f }, 1000.f);
+        for (const auto& f : m_gazePoints)
+        { // Project normalized gaze point to screen:
+            const float radius = (outFrameW / 2);
+            const float gain = radius * 2.f;
+            const cv::Point2f gaze = (f.point * gain) + origin;
+            addCross(lines, gaze, { 1.f, 1.f, 0.5f }, 200.f * f.radius);
+        }
+    }
+
+    m_drawingLines = addLines(lines.points, lines.colors, cv::Matx33f::eye());
+
+    // ### Axes (world coordinates) ###
+    if (m_motion.dot(m_motion) > 0.f)
+    {
+        cv::Point3f motion(-m_motion.x, m_motion.y, m_motion.z);
+        m_axes = drishti::geometry::drawAxes(motion, 0.05f, 32, 0.125f);
+
+        m_axesLines.first = static_cast<GLint>(m_lineVertices.size() / kLineVertexSize);
+        for (int i = m_axes.size() - 1; i >= 0; i--)
+        {
+            const cv::Vec3f color(float(i == 0), float(i == 1), float(i == 2));
+            for (const auto& p : m_axes[i])
+            {
+                m_lineVertices.insert(m_lineVertices.end(), { p.x, p.y, p.z, 1.f, color[0], color[1], color[2] });
+            }
+            m_axesLines.count += static_cast<GLsizei>(m_axes[i].size());
+        }
+    }
+
+    // ### Eye annotations (both eyes in one batch) ###
+    if (m_eyes.m_eyesInfo.texId >= 0)
+    {
+        m_eyeLines.first = static_cast<GLint>(m_lineVertices.size() / kLineVertexSize);
+        for (const auto& eye : m_eyes.m_eyes)
+        {
+            const DrawingSpec eyeLines = getEyeLines(eye, m_eyeAttributes);
+            m_eyeLines.count += addLines(eyeLines.points, eyeLines.colors, eye.H).count;
+        }
+    }
+}
+
+void FacePainter::uploadLines()
+{
+    if (m_lineVertices.empty())
+    {
+        return;
+    }
+
+    if (!m_lineVbo)
+    {
+        glGenBuffers(1, &m_lineVbo);
+    }
+
+    const GLsizeiptr size = static_cast<GLsizeiptr>(m_lineVertices.size() * sizeof(GLfloat));
+
+    // Orphan the previous frame's storage, so the upload doesn't wait for draws still reading it:
+    glBindBuffer(GL_ARRAY_BUFFER, m_lineVbo);
+    glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, m_lineVertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    Tools::checkGLErr(getProcName(), "FacePainter::uploadLines()");
+}
+
+void FacePainter::drawLines(const LineBatch& batch)
+{
+    if (batch.count == 0)
+    {
+        return;
+    }
+
+    const GLsizei stride = kLineVertexSize * sizeof(GLfloat);
+    glBindBuffer(GL_ARRAY_BUFFER, m_lineVbo);
+
+    glEnableVertexAttribArray(m_drawShParamAPosition);
+    glVertexAttribPointer(m_drawShParamAPosition, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(0));
+    Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
+
+    glEnableVertexAttribArray(m_drawShParamAColor);
+    glVertexAttribPointer(m_drawShParamAColor, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(4 * sizeof(GLfloat)));
+    Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
+
+    glDrawArrays(GL_LINES, batch.first, batch.count);
+    Tools::checkGLErr(getProcName(), "glDrawArrays()");
+
+    // The other passes use client side vertex arrays:
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void FacePainter::renderDrawings()
+{
+    //const std::string tag = DRISHTI_LOCATION_SIMPLE;
+    //drishti::core::ScopeTimeLogger renderLogger = [&](double ts) { m_logger->info("TIMING: {} = {}", tag, ts) };
+
     if (m_faces.size())
     { // Show position of nearest face
         const auto& position = (*m_faces.front().eyesCenter);
@@ -274,19 +434,6 @@ void FacePainter::renderDrawings()
         const float sy = scale / static_cast<float>(outFrameH);
         m_printer->printAt(wss.str(), 0.0f, 0.5f, sx, sy);
         m_printer->end();
-
-        if (m_gazePoints.size())
-        {
-            const cv::Point2f origin(outFrameW / 2, outFrameH / 2);
-            addCross(lines, origin, { 1.f, 1.f, 0.f }, 1000.f);
-            for (const auto& f : m_gazePoints)
-            { // Project normalized gaze point to screen:
-                const float radius = (outFrameW / 2);
-                const float gain = radius * 2.f;
-                const cv::Point2f gaze = (f.point * gain) + origin;
-                addCross(lines, gaze, { 1.f, 1.f, 0.5f }, 200.f * f.radius);
-            }
-        }
     }
 
     m_draw->use();
@@ -299,17 +446,12 @@ void FacePainter::renderDrawings()
     glUniformMatrix4fv(m_drawShParamUMVP, 1, 0, (GLfloat*)&MVPt(0, 0));
     Tools::checkGLErr(getProcName(), "render drawings");
 
-    glViewport(0, 0, outFrameW, outFrameH);
+    const cv::Size target = (m_targetScale != 1.f) ? getOverlaySize() : cv::Size(outFrameW, outFrameH);
+    glViewport(0, 0, target.width, target.height);
     Tools::checkGLErr(getProcName(), "glViewport()");
 
-    glVertexAttribPointer(m_drawShParamAColor, 3, GL_FLOAT, 0, 0, &lines.colors[0]);
-    Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
-
-    glVertexAttribPointer(m_drawShParamAPosition, 2, GL_FLOAT, 0, 0, &lines.points[0]);
-    Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
-
-    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(lines.points.size()));
-    Tools::checkGLErr(getProcName(), "glDrawArrays()");
+    glLineWidth(std::max(4.f * m_targetScale, 1.f));
+    drawLines(m_drawingLines);
 }
 
 void FacePainter::setAxes(const cv::Point3f& axes)
@@ -326,17 +468,7 @@ void FacePainter::setAxes(const cv::Point3f& axes)
 
 void FacePainter::renderAxes()
 {
-    cv::Point3f motion(-m_motion.x, m_motion.y, m_motion.z);
-    m_axes = drishti::geometry::drawAxes(motion, 0.05f, 32, 0.125f);
-    m_axesColors = m_axes;
-    for (int i = 0; i < m_axesColors.size(); i++)
-    {
-        cv::Point3f color(float(i == 0), float(i == 1), float(i == 2));
-        auto& axis = m_axesColors[i];
-        std::fill(axis.begin(), axis.end(), color);
-    }
-
-    if (m_axes.size())
+    if (m_axesLines.count)
     {
         const float aspectRatio = static_cast<float>(outFrameW) / static_cast<float>(outFrameH);
         cv::Matx44f K = transformation::glPerspective(1000.f, aspectRatio, 0.f, 100.f);
@@ -367,20 +499,11 @@ void FacePainter::renderAxes()
         glUniformMatrix4fv(m_drawShParamUMVP, 1, 0, (GLfloat*)&MVPt(0, 0));
         Tools::checkGLErr(getProcName(), "render drawings");
 
-        glViewport(0, 0, outFrameW, outFrameH);
+        const cv::Size target = (m_targetScale != 1.f) ? getOverlaySize() : cv::Size(outFrameW, outFrameH);
+        glViewport(0, 0, target.width, target.height);
         Tools::checkGLErr(getProcName(), "glViewport()");
 
-        for (int i = m_axes.size() - 1; i >= 0; i--)
-        {
-            glVertexAttribPointer(m_drawShParamAColor, 3, GL_FLOAT, 0, 0, &m_axesColors[i].front().x);
-            Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
-
-            glVertexAttribPointer(m_drawShParamAPosition, 3, GL_FLOAT, 0, 0, &m_axes[i].front().x);
-            Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
-
-            glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(m_axes[i].size()));
-            Tools::checkGLErr(getProcName(), "glDrawArrays()");
-        }
+        drawLines(m_axesLines);
     }
 }
 
@@ -395,11 +518,23 @@ void FacePainter::FacePainter::setUniforms()
 
 int FacePainter::FacePainter::render(int position)
 {
-    const std::string tag = DRISHTI_LOCATION_SIMPLE;
-    drishti::core::ScopeTimeLogger renderLogger = [&](double ts) { m_logger->info("TIMING:{}={}", tag, ts); };
+    constexpr const char* tag = DRISHTI_LOCATION_STATIC;
+    auto renderLogger = drishti::core::makeScopeTimer<drishti::core::kTimingDisplay>("face_painter", [&](double ts) { DRISHTI_LOG_INFO(m_logger, "TIMING:{}={}", tag, ts); });
 
     OG_LOGINF(getProcName(), "input tex %d, target %d, framebuffer of size %dx%d", texId, texTarget, outFrameW, outFrameH);
 
+    // One upload for all overlay lines in the frame (the cached layer keeps them for the scene):
+    const bool doOverlay = (m_overlayScale > 0.f);
+    if (!doOverlay || !isOverlayCurrent())
+    {
+        prepareLines();
+        uploadLines();
+        if (doOverlay)
+        {
+            renderOverlay();
+        }
+    }
+
     { // ... main render routine ...
         filterRenderPrepare();
         Tools::checkGLErr(getProcName(), "render prepare");
@@ -422,11 +557,14 @@ int FacePainter::FacePainter::render(int position)
 
         // Draw the frame, line drawings and normalized face/eyes
         filterRenderDraw();
-        renderDrawings(); // 2d
-
-        if (m_motion.dot(m_motion) > 0.f)
+        if (!doOverlay)
         {
-            renderAxes(); // render w/ glPerspective (world coordinates)
+            renderDrawings(); // 2d
+
+            if (m_motion.dot(m_motion) > 0.f)
+            {
+                renderAxes(); // render w/ glPerspective (world coordinates)
+            }
         }
 
         Tools::checkGLErr(getProcName(), "render draw");
@@ -459,6 +597,11 @@ int FacePainter::FacePainter::render(int position)
         }
     }
 
+    if (doOverlay && !m_overlayEmpty)
+    {
+        compositeOverlay(); // last, so annotations stay over the eye texture
+    }
+
     clear();
 
     return 0;
@@ -518,17 +661,9 @@ drawFlow(const FacePainter::FlowField& flow, const cv::Vec3f& color, DrawingSpec
     }
 }
 
-/*
- * dstRoiPix : destination roi for texture in image coordinates
- * eye : eye model in full frame coordinates
- * Heye : transformation from full frame to
- */
-
-void FacePainter::annotateEye(const drishti::eye::EyeWarp& eyeWarp, const cv::Size& size, const EyeAttributes& attributes)
+// Eye contours, points and flow in full frame coordinates (eyeWarp.H maps them to the eye texture):
+static DrawingSpec getEyeLines(const drishti::eye::EyeWarp& eyeWarp, const FacePainter::EyeAttributes& attributes)
 {
-    //const std::string tag = DRISHTI_LOCATION_SIMPLE;
-    //drishti::core::ScopeTimeLogger paintLogger = [&](double ts) { m_logger->info("TIMING: {} = {}", tag, ts); }
-
     auto contours = eyeWarp.getContours(false); //!m_eyePoints.size());
 
     DrawingSpec lines(0);
@@ -554,21 +689,7 @@ void FacePainter::annotateEye(const drishti::eye::EyeWarp& eyeWarp, const cv::Si
         drawFlow(*attributes.flow, attributes.color, lines, 100.f);
     }
 
-    glLineWidth(2.0);
-    cv::Matx44f MVPt;
-    transformation::R3x3To4x4(eyeWarp.H.t(), MVPt);
-
-    glUniformMatrix4fv(m_drawShParamUMVP, 1, 0, (GLfloat*)&MVPt(0, 0));
-    Tools::checkGLErr(getProcName(), "FacePainter::renderEye() : glUniformMatrix4fv()");
-
-    glVertexAttribPointer(m_drawShParamAColor, 3, GL_FLOAT, 0, 0, &lines.colors[0]);
-    Tools::checkGLErr(getProcName(), "FacePainter::annotateEye() : glVertexAttribPointer()");
-
-    glVertexAttribPointer(m_drawShParamAPosition, 2, GL_FLOAT, 0, 0, &lines.points[0]);
-    Tools::checkGLErr(getProcName(), "FacePainter::annotateEye() : glVertexAttribPointer()");
-
-    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(lines.points.size()));
-    Tools::checkGLErr(getProcName(), "FacePainter::annotateEye() : glDrawArrays()");
+    return lines;
 }
 
 // roi: eye roi in output frame
@@ -606,7 +727,7 @@ std::array<drishti::eye::EyeWarp, 2> FacePainter::renderEyes(const drishti::face
         renderEye(cropInfo[i].roi, cropInfo[i].H, (i == 0) ? *face.eyeFullL : *face.eyeFullR);
     }
 
-    annotateEyes(m_eyes, m_eyeAttributes);
+    annotateEyes();
 
     return cropInfo;
 }
@@ -634,19 +755,28 @@ void FacePainter::renderFaces()
 // === Eyes ============
 // =====================
 
-void FacePainter::annotateEyes(const EyePairInfo& eyes, const EyeAttributes& attributes)
+void FacePainter::annotateEyes()
 {
     m_draw->use();
     Tools::checkGLErr(getProcName(), "m_draw->use()");
 
+    // Lines are in eye texture clip coordinates:
+    const auto& eyesRoi = m_eyes.m_eyesInfo.roi;
+    const auto scale = [&](int value) { return static_cast<int>(static_cast<float>(value) * m_targetScale + 0.5f); };
+    const cv::Rect roi(scale(eyesRoi.x), scale(eyesRoi.y), scale(eyesRoi.width), scale(eyesRoi.height));
+    glViewport(roi.x, roi.y, roi.width, roi.height);
+
     glEnable(GL_SCISSOR_TEST);
-    const auto& roi = eyes.m_eyesInfo.roi;
     glScissor(roi.x, roi.y, roi.width, roi.height);
 
-    for (const auto& eye : eyes.m_eyes)
-    {
-        annotateEye(eye, { eyes.m_eyesInfo.size.width, eyes.m_eyesInfo.size.height }, attributes);
-    }
+    // The per eye transformations are applied in prepareLines():
+    const cv::Matx44f I = cv::Matx44f::eye();
+    glUniformMatrix4fv(m_drawShParamUMVP, 1, 0, I.val);
+    Tools::checkGLErr(getProcName(), "FacePainter::annotateEyes() : glUniformMatrix4fv()");
+
+    glLineWidth(std::max(2.f * m_targetScale, 1.f));
+    drawLines(m_eyeLines);
+
     glDisable(GL_SCISSOR_TEST);
 }
 
@@ -769,5 +899,95 @@ void FacePainter::setEyeTexture(GLint texIdx, const ogles_gpgpu::Size2d& size, c
     
     m_eyes.m_eyes = eyes;
     m_eyes.m_eyesInfo = { texIdx, size, eyesRoi };
-    m_eyes.m_eyesInfo.m_delegate = [&]() { annotateEyes(m_eyes, m_eyeAttributes); };
+    m_eyes.m_eyesInfo.m_delegate = [&]() {
+        if (m_overlayScale <= 0.f)
+        {
+            annotateEyes(); // else in the overlay layer
+        }
+    };
+}
+
+//===========================
+//========= OVERLAY =========
+//===========================
+
+cv::Size FacePainter::getOverlaySize() const
+{
+    const int width = std::max(static_cast<int>(static_cast<float>(outFrameW) * m_overlayScale + 0.5f), 1);
+    const int height = std::max(static_cast<int>(static_cast<float>(outFrameH) * m_overlayScale + 0.5f), 1);
+    return { width, height };
+}
+
+bool FacePainter::isOverlayCurrent() const
+{
+    const cv::Size size = getOverlaySize();
+    return m_overlayValid && (m_overlayFrameIndex == m_frameIndex) && (m_overlay->getWidth() == size.width) && (m_overlay->getHeight() == size.height);
+}
+
+// Lines, axes, text and eye annotations, over transparent black:
+void FacePainter::renderOverlay()
+{
+    const cv::Size size = getOverlaySize();
+    if (!m_overlay)
+    {
+        m_overlay = drishti::core::make_unique<TextureRing>(1);
+    }
+    m_overlay->allocate(size.width, size.height);
+    m_overlay->bind();
+
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    m_targetScale = m_overlayScale;
+    renderDrawings();
+    if (m_motion.dot(m_motion) > 0.f)
+    {
+        renderAxes();
+    }
+    if (m_eyes.m_eyesInfo.texId >= 0)
+    {
+        annotateEyes();
+    }
+    m_targetScale = 1.f;
+
+    glDisable(GL_BLEND); // enabled by the text pass
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    Tools::checkGLErr(getProcName(), "FacePainter::renderOverlay()");
+
+    m_overlayEmpty = m_lineVertices.empty() && m_faces.empty();
+    m_overlayFrameIndex = m_frameIndex;
+    m_overlayValid = true;
+}
+
+void FacePainter::compositeOverlay()
+{
+    if (fbo)
+    {
+        fbo->bind();
+    }
+    glViewport(0, 0, outFrameW, outFrameH);
+
+    // Lines are opaque and the layer is cleared to zero, so it blends as premultiplied alpha:
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    m_blend->use();
+    glActiveTexture(GL_TEXTURE0 + texUnit);
+    glBindTexture(GL_TEXTURE_2D, (*m_overlay)[0]);
+    glUniform1i(m_blendShParamUInputTex, texUnit);
+
+    glEnableVertexAttribArray(m_blendShParamAPos);
+    glVertexAttribPointer(m_blendShParamAPos, OGLES_GPGPU_QUAD_COORDS_PER_VERTEX, GL_FLOAT, GL_FALSE, 0, &ProcBase::quadVertices[0]);
+    glEnableVertexAttribArray(m_blendShParamATexCoord);
+    glVertexAttribPointer(m_blendShParamATexCoord, OGLES_GPGPU_QUAD_TEXCOORDS_PER_VERTEX, GL_FLOAT, GL_FALSE, 0, &ProcBase::quadTexCoordsStd[0]);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, OGLES_GPGPU_QUAD_VERTICES);
+    Tools::checkGLErr(getProcName(), "FacePainter::compositeOverlay()");
+
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (fbo)
+    {
+        fbo->unbind();
+    }
 }
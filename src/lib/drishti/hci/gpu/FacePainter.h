@@ -36,6 +36,7 @@ namespace spdlog { class logger; }
 BEGIN_OGLES_GPGPU
 
 class GLPrinterShader;
+class TextureRing;
 
 class FacePainter : public ogles_gpgpu::TransformProc
 {
@@ -216,6 +217,7 @@ public:
     void setShowDetectionScales(bool value)
     {
         m_showDetectionScales = value;
+        m_overlayValid = false;
     }
 
     bool getShowDetectionScales()
@@ -259,8 +261,28 @@ public:
         m_logger = logger;
     }
 
+    // Line drawings, axes, text and eye annotations are rendered into a cached RGBA layer at
+    // this fraction of the output resolution (0 : draw them at full resolution each frame).
+    // The layer is only re-rendered when the frame index changes, otherwise the frame costs
+    // one blend of the layer over the video and eye/iris textures.
+    void setOverlayScale(float value)
+    {
+        m_overlayScale = value;
+        m_overlayValid = false;
+    }
+
+    float getOverlayScale() const
+    {
+        return m_overlayScale;
+    }
+
+    // Index of the scene for the next render(), see ScenePrimitives::m_frameIndex:
+    void setFrameIndex(uint64_t index)
+    {
+        m_frameIndex = index;
+    }
+
     void copyEyeTex();
-    void annotateEyes(const EyePairInfo& eyes, const EyeAttributes& attributes);
 
     // Implement all utilty texture drawing in terms of these:
     void renderTex(DisplayTexture& texInfo);
@@ -270,10 +292,29 @@ public:
 private:
     cv::Matx33f uprightImageToTexture();
 
+    // Range of GL_LINES vertices in m_lineVbo:
+    struct LineBatch
+    {
+        GLint first = 0;
+        GLsizei count = 0;
+    };
+
     void renderFaces();
     EyeWarpPair renderEyes(const drishti::face::FaceModel& face);
     void renderEye(const cv::Rect& roi, const cv::Matx33f& H, const DRISHTI_EYE::EyeModel& eye);
-    void annotateEye(const drishti::eye::EyeWarp& eyeWarp, const cv::Size& size, const EyeAttributes& attributes);
+    void annotateEyes();
+
+    // Cached overlay layer (see setOverlayScale()):
+    cv::Size getOverlaySize() const;
+    bool isOverlayCurrent() const;
+    void renderOverlay();
+    void compositeOverlay();
+
+    // Overlay geometry for the frame is collected and uploaded once (drawings, axes and eye annotations):
+    void prepareLines();
+    LineBatch addLines(const std::vector<cv::Point2f>& points, const std::vector<cv::Vec3f>& colors, const cv::Matx33f& H);
+    void uploadLines();
+    void drawLines(const LineBatch& batch);
 
     virtual void renderDrawings();
     virtual void renderAxes();
@@ -293,6 +334,9 @@ private:
 
     static const char* fshaderLetterBoxSrc;
 
+    static const char* vshaderOverlaySrc;
+    static const char* fshaderOverlaySrc;
+
     FeaturePoints m_gazePoints;
 
     float m_brightness = 1.f;
@@ -301,7 +345,6 @@ private:
     cv::Point3f m_motion;
 
     Axes3D m_axes;
-    Axes3D m_axesColors;
 
     drishti::core::Field<Object3D> m_object;
 
@@ -329,6 +372,25 @@ private:
 
     std::unique_ptr<GLPrinterShader> m_printer;
 
+    // #### Overlay vertices: position (x, y, z, w) + color (r, g, b), in a buffer orphaned each frame ####
+    GLuint m_lineVbo = 0;
+    std::vector<GLfloat> m_lineVertices;
+    LineBatch m_drawingLines;
+    LineBatch m_axesLines;
+    LineBatch m_eyeLines;
+
+    // #### Overlay layer: premultiplied RGBA, blended over the frame ####
+    float m_overlayScale = 0.5f;
+    float m_targetScale = 1.f; // render target resolution wrt the output (m_overlayScale in renderOverlay())
+    bool m_overlayValid = false;
+    bool m_overlayEmpty = true;
+    uint64_t m_overlayFrameIndex = 0;
+    std::unique_ptr<TextureRing> m_overlay;
+    std::shared_ptr<Shader> m_blend;
+    GLint m_blendShParamAPos;
+    GLint m_blendShParamATexCoord;
+    GLint m_blendShParamUInputTex;
+
     // #### Draw shader ####
     std::shared_ptr<Shader> m_draw;
     GLint m_drawShParamAColor;
@@ -0,0 +1,186 @@
+/*! -*-c++-*-
+  @file   FeatureSampler.cpp
+  @author David Hirvonen
+  @brief  Implementation of a GPU gather of pose indexed feature pixels for shape regression.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/gpu/FeatureSampler.h"
+
+#include <stdexcept>
+
+BEGIN_OGLES_GPGPU
+
+static const GLuint kInputUnit = 1;
+
+// Image locations are rounded in the vertex shader (highp) and only the texel centre is fetched,
+// so the result doesn't depend on the filtering mode of the input texture:
+
+// clang-format off
+const char * FeatureSampler::vshaderFeatureSamplerSrc = OG_TO_STR
+(
+ attribute vec4 position;
+ uniform vec2 uSize;
+ varying vec2 vTexCoord;
+ varying float vInside;
+
+ void main()
+ {
+     vec2 p = floor(position.zw + 0.5);
+     vInside = (all(greaterThanEqual(p, vec2(0.0))) && all(lessThan(p, uSize))) ? 1.0 : 0.0;
+     vTexCoord = (p + 0.5) / uSize;
+     gl_PointSize = 1.0;
+     gl_Position = vec4(position.xy, 0.0, 1.0);
+ });
+// clang-format on
+
+// clang-format off
+const char * FeatureSampler::fshaderFeatureSamplerSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ varying float vInside;
+ uniform sampler2D uInputTex;
+ uniform vec4 uChannels;
+ void main()
+ {
+     float value = dot(texture2D(uInputTex, vTexCoord), uChannels) * vInside;
+     gl_FragColor = vec4(value, value, value, 1.0);
+ });
+// clang-format on
+
+FeatureSampler::FeatureSampler()
+{
+    shader = std::make_shared<Shader>();
+    if (!shader->buildFromSrc(vshaderFeatureSamplerSrc, fshaderFeatureSamplerSrc))
+    {
+        throw std::runtime_error("FeatureSampler: shader error");
+    }
+    shParamAPosition = shader->getParam(ATTR, "position");
+    shParamUInputTex = shader->getParam(UNIF, "uInputTex");
+    shParamUSize = shader->getParam(UNIF, "uSize");
+    shParamUChannels = shader->getParam(UNIF, "uChannels");
+}
+
+FeatureSampler::~FeatureSampler()
+{
+    if (framebuffer)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &texture);
+    }
+    if (vbo)
+    {
+        glDeleteBuffers(1, &vbo);
+    }
+}
+
+const char* FeatureSampler::getProcName()
+{
+    return "FeatureSampler";
+}
+
+void FeatureSampler::setChannelWeights(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+    channels[0] = r;
+    channels[1] = g;
+    channels[2] = b;
+    channels[3] = a;
+}
+
+void FeatureSampler::allocate(int count)
+{
+    if (framebuffer && (count <= rows))
+    {
+        return;
+    }
+
+    if (!framebuffer)
+    {
+        glGenTextures(1, &texture);
+        glGenFramebuffers(1, &framebuffer);
+    }
+
+    rows = count;
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, kWidth, rows, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    Tools::checkGLErr(getProcName(), "allocate()");
+}
+
+void FeatureSampler::operator()(GLuint input, int width, int height, const float* x, const float* y, float* values, int n)
+{
+    if (n <= 0)
+    {
+        return;
+    }
+
+    // One slot per sample, filled row by row (only the used rows are drawn and read back):
+    const int used = (n + kWidth - 1) / kWidth;
+    allocate(used);
+
+    vertices.resize(n * 4);
+    for (int i = 0; i < n; i++)
+    {
+        GLfloat* v = &vertices[i * 4];
+        v[0] = (GLfloat((i % kWidth) * 2 + 1) / GLfloat(kWidth)) - 1.f;
+        v[1] = (GLfloat((i / kWidth) * 2 + 1) / GLfloat(used)) - 1.f;
+        v[2] = x[i];
+        v[3] = y[i];
+    }
+
+    if (!vbo)
+    {
+        glGenBuffers(1, &vbo);
+    }
+
+    // Orphan the previous store, the points are rewritten on every call:
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(vertices.size() * sizeof(GLfloat));
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, vertices.data());
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, kWidth, used);
+    glDisable(GL_BLEND);
+
+    shader->use();
+
+    glActiveTexture(GL_TEXTURE0 + kInputUnit);
+    glBindTexture(GL_TEXTURE_2D, input);
+    glUniform1i(shParamUInputTex, kInputUnit);
+    glUniform2f(shParamUSize, GLfloat(width), GLfloat(height));
+    glUniform4fv(shParamUChannels, 1, channels);
+
+    glEnableVertexAttribArray(shParamAPosition);
+    glVertexAttribPointer(shParamAPosition, 4, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glDrawArrays(GL_POINTS, 0, n);
+    glDisableVertexAttribArray(shParamAPosition);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    pixels.resize(kWidth * used * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, kWidth, used, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    for (int i = 0; i < n; i++)
+    {
+        values[i] = float(pixels[i * 4]);
+    }
+
+    Tools::checkGLErr(getProcName(), "operator()");
+}
+
+END_OGLES_GPGPU
@@ -0,0 +1,75 @@
+/*! -*-c++-*-
+  @file   FeatureSampler.h
+  @author David Hirvonen
+  @brief  Declaration of a GPU gather of pose indexed feature pixels for shape regression.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_hci_gpu_FeatureSampler_h__
+#define __drishti_hci_gpu_FeatureSampler_h__
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+#include <memory>
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+/*
+ * Read n pixels of a texture at the nearest integer image locations (x[i], y[i]), which is the
+ * pose indexed feature gather of the regression cascades (see drishti::core::gatherU8).  Each
+ * sample is drawn as one point into its own slot of a small framebuffer (kWidth columns) and the
+ * slots are read back in a single glReadPixels() call.  Samples outside the image read as zero.
+ * Values are the dot product of the texel and the channel weights in [0,255], the default reads
+ * the red channel of a grayscale (or luminance) texture.  All calls must be made from the GL
+ * thread, e.g.:
+ *
+ *   estimator.setFeatureSampler([&](const float* x, const float* y, float* values, int n) {
+ *       sampler(texture, width, height, x, y, values, n);
+ *   });
+ */
+
+class FeatureSampler
+{
+public:
+    static const int kWidth = 64;
+
+    FeatureSampler();
+    ~FeatureSampler();
+
+    static const char* getProcName();
+
+    void setChannelWeights(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+
+    void operator()(GLuint texture, int width, int height, const float* x, const float* y, float* values, int n);
+
+protected:
+    void allocate(int rows);
+
+    std::shared_ptr<Shader> shader;
+
+    static const char* vshaderFeatureSamplerSrc;
+    static const char* fshaderFeatureSamplerSrc;
+
+    GLint shParamAPosition;
+    GLint shParamUInputTex;
+    GLint shParamUSize;
+    GLint shParamUChannels;
+
+    GLfloat channels[4] = { 1.f, 0.f, 0.f, 0.f };
+
+    GLuint vbo = 0;
+    GLuint texture = 0;
+    GLuint framebuffer = 0;
+    int rows = 0; // allocated slot rows
+
+    std::vector<GLfloat> vertices; // { slot x, slot y, image x, image y }
+    std::vector<GLubyte> pixels;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_hci_gpu_FeatureSampler_h__
@@ -0,0 +1,73 @@
+/*! -*-c++-*-
+  @file   FlowTileProc.cpp
+  @author David Hirvonen
+  @brief  Implementation of ogles_gpgpu shader for confidence weighted mean flow per tile.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/gpu/FlowTileProc.h"
+
+#include <algorithm>
+
+BEGIN_OGLES_GPGPU
+
+// Loops need constant bounds in GLSL ES 1.0, the tile size is applied with a break (kMaxTile):
+
+// clang-format off
+const char * FlowTileProc::fshaderFlowTileSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ uniform vec2 uTexelStep;
+ uniform float uTile;
+ void main()
+ {
+     vec2 origin = vTexCoord + (0.5 - 0.5 * uTile) * uTexelStep;
+     vec3 sum = vec3(0.0);
+     float peak = 0.0;
+     for (int y = 0; y < 16; y++)
+     {
+         if (float(y) >= uTile)
+         {
+             break;
+         }
+         for (int x = 0; x < 16; x++)
+         {
+             if (float(x) >= uTile)
+             {
+                 break;
+             }
+             vec3 flow = texture2D(uInputTex, origin + vec2(float(x), float(y)) * uTexelStep).rgb;
+             sum += vec3(flow.rg * flow.b, flow.b);
+             peak = max(peak, flow.b);
+         }
+     }
+     vec2 mean = (sum.z > 0.0) ? (sum.xy / sum.z) : vec2(0.5);
+     gl_FragColor = vec4(mean, peak, 1.0);
+ });
+// clang-format on
+
+FlowTileProc::FlowTileProc(int tile)
+    : tile(std::max(std::min(tile, kMaxTile), 1))
+{
+}
+
+void FlowTileProc::getUniforms()
+{
+    shParamUTexelStep = shader->getParam(UNIF, "uTexelStep");
+    shParamUTile = shader->getParam(UNIF, "uTile");
+}
+
+void FlowTileProc::setUniforms()
+{
+    glUniform2f(shParamUTexelStep, 1.f / static_cast<float>(inFrameW), 1.f / static_cast<float>(inFrameH));
+    glUniform1f(shParamUTile, static_cast<float>(tile));
+}
+
+END_OGLES_GPGPU
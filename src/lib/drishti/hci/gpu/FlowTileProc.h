@@ -0,0 +1,58 @@
+/*! -*-c++-*-
+  @file   FlowTileProc.h
+  @author David Hirvonen
+  @brief  Declaration of ogles_gpgpu shader for confidence weighted mean flow per tile.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef OGLES_GPGPU_COMMON_GL_FLOW_TILE_PROC
+#define OGLES_GPGPU_COMMON_GL_FLOW_TILE_PROC
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+BEGIN_OGLES_GPGPU
+
+/*
+ * Reduce the output of FlowOptPipeline (flow x, y in (r, g) encoded as (d + 1) / 2, corner
+ * strength in b) to one texel per tile x tile block, so only a small grid has to be read back.
+ * The mean flow of each tile is weighted by the corner strength and written to (r, g) with the
+ * same encoding, b holds the peak strength (confidence, 0 for tiles without corners) and alpha
+ * is 1.  Use with setOutputSize(1.f / tile).
+ */
+
+class FlowTileProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    static const int kMaxTile = 16;
+
+    FlowTileProc(int tile = 8);
+
+    virtual const char* getProcName()
+    {
+        return "FlowTileProc";
+    }
+
+    int getTileSize() const { return tile; }
+
+private:
+    virtual const char* getFragmentShaderSource()
+    {
+        return fshaderFlowTileSrc;
+    }
+    virtual void getUniforms();
+    virtual void setUniforms();
+
+    static const char* fshaderFlowTileSrc; // fragment shader source
+
+    int tile = 8;
+
+    GLint shParamUTexelStep;
+    GLint shParamUTile;
+};
+
+END_OGLES_GPGPU
+
+#endif // OGLES_GPGPU_COMMON_GL_FLOW_TILE_PROC
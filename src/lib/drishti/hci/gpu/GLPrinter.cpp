@@ -72,6 +72,11 @@ GLPrinterShader::GLPrinterShader()
     glBindTexture(GL_TEXTURE_2D, 0);
     Tools::checkGLErr(getProcName(), "texture init");
 
+    for (int j = 0; j < font.glyphs_count; ++j)
+    {
+        m_glyphs.emplace(font.glyphs[j].codepoint, j); // first match, as in the linear search
+    }
+
     m_shader = drishti::core::make_unique<ogles_gpgpu::Shader>();
     m_shader->buildFromSrc(vshaderPrinterSrc, fshaderPrinterSrc);
     m_shParamAPos = m_shader->getParam(ATTR, "position");
@@ -87,16 +92,7 @@ GLPrinterShader::~GLPrinterShader()
 
 void GLPrinterShader::begin()
 {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_texId);
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-
-    m_shader->use();
-    glUniform1i(m_shParamUInputTex, 0); // set texture unit
+    m_vertices.clear();
 }
 
 void GLPrinterShader::printAt(const std::wstring& str, float x, float y, float sx, float sy)
@@ -106,19 +102,12 @@ void GLPrinterShader::printAt(const std::wstring& str, float x, float y, float s
     for (int i = 0; i < str.size(); i++)
     {
         //Find the glyph for the character we are looking for
-        texture_glyph_t* glyph = 0;
-        for (int j = 0; j < font.glyphs_count; ++j)
-        {
-            if (font.glyphs[j].codepoint == str[i])
-            {
-                glyph = &font.glyphs[j];
-                break;
-            }
-        }
-        if (!glyph)
+        const auto iter = m_glyphs.find(static_cast<uint32_t>(str[i]));
+        if (iter == m_glyphs.end())
         {
             continue;
         }
+        const texture_glyph_t* glyph = &font.glyphs[iter->second];
 
         // vertex coordinates: x, y
         float x0 = (float)+(x + glyph->offset_x * sx);
@@ -132,26 +121,14 @@ void GLPrinterShader::printAt(const std::wstring& str, float x, float y, float s
         float s1 = glyph->s1;
         float t1 = glyph->t1;
 
-        struct
-        {
-            float x, y, s, t;
-        } data[6] = {
-            { x0, y0, s0, t0 },
-            { x0, y1, s0, t1 },
-            { x1, y1, s1, t1 },
-            { x0, y0, s0, t0 },
-            { x1, y1, s1, t1 },
-            { x1, y0, s1, t0 }
-        };
-
-        glEnableVertexAttribArray(m_shParamAPos);
-        Tools::checkGLErr(getProcName(), "glEnableVertexAttribArray()");
-
-        glVertexAttribPointer(m_shParamAPos, 4, GL_FLOAT, GL_FALSE, 0, &data[0].x);
-        Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
-
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        Tools::checkGLErr(getProcName(), "glDrawArrays()");
+        m_vertices.insert(m_vertices.end(), {
+            x0, y0, s0, t0,
+            x0, y1, s0, t1,
+            x1, y1, s1, t1,
+            x0, y0, s0, t0,
+            x1, y1, s1, t1,
+            x1, y0, s1, t0
+        });
 
         x += (glyph->advance_x * sx);
         y += (glyph->advance_y * sy);
@@ -160,6 +137,38 @@ void GLPrinterShader::printAt(const std::wstring& str, float x, float y, float s
 
 void GLPrinterShader::end()
 {
+    if (m_vertices.empty())
+    {
+        return;
+    }
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_texId);
+
+    m_shader->use();
+    glUniform1i(m_shParamUInputTex, 0); // set texture unit
+
+    // Orphan the previous frame's storage, so the upload doesn't wait for the last draw:
+    const GLsizeiptr size = static_cast<GLsizeiptr>(m_vertices.size() * sizeof(GLfloat));
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, m_vertices.data());
+    Tools::checkGLErr(getProcName(), "glBufferSubData()");
+
+    glEnableVertexAttribArray(m_shParamAPos);
+    Tools::checkGLErr(getProcName(), "glEnableVertexAttribArray()");
+
+    glVertexAttribPointer(m_shParamAPos, 4, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<const GLvoid*>(0));
+    Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
+
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(m_vertices.size() / 4));
+    Tools::checkGLErr(getProcName(), "glDrawArrays()");
+
+    m_vertices.clear();
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindTexture(GL_TEXTURE_2D, 0);
     glUseProgram(0);
@@ -13,11 +13,19 @@
 
 #include "ogles_gpgpu/common/proc/base/filterprocbase.h"
 
+#include <map>
 #include <string>
 #include <memory>
+#include <vector>
 
 BEGIN_OGLES_GPGPU
 
+/*
+ * Strings printed between begin() and end() are accumulated as glyph quads (x, y, s, t) and
+ * drawn from one streamed vertex buffer with a single glDrawArrays() call in end(), so a HUD
+ * with many labels costs one upload and one draw per frame.
+ */
+
 class GLPrinterShader
 {
 public:
@@ -27,12 +35,15 @@ public:
     static const char* getProcName() { return "GLPrinterShader"; }
 
     void begin();
-    void end();
+    void end(); // draw all strings queued since begin()
     void printAt(const std::wstring& str, float x, float y, float sx, float sy);
 
     GLuint m_texId;
     GLuint m_vbo, m_vao;
 
+    std::map<uint32_t, int> m_glyphs; // codepoint -> glyph index in the font atlas
+    std::vector<GLfloat> m_vertices;  // queued triangles
+
     // #### Draw shader ####
     std::shared_ptr<Shader> m_shader;
     GLuint m_shParamAPos;
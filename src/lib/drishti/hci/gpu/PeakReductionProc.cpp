@@ -0,0 +1,59 @@
+/*! -*-c++-*-
+  @file   PeakReductionProc.cpp
+  @author David Hirvonen
+  @brief  Implementation of ogles_gpgpu shader for a 2x2 max reduction of peak responses and positions.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/gpu/PeakReductionProc.h"
+
+BEGIN_OGLES_GPGPU
+
+// clang-format off
+const char * PeakReductionProc::fshaderPeakReductionSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ uniform vec2 uTexelStep;
+ uniform float uEncode;
+ vec4 fetch(vec2 uv)
+ {
+     vec4 value = texture2D(uInputTex, uv);
+     vec2 position = floor(uv / uTexelStep) / 255.0;
+     return vec4(mix(value.rg, position, uEncode), value.ba);
+ }
+ void main()
+ {
+     // The output texel center lies on the corner shared by its 2x2 input texels:
+     vec2 d = 0.5 * uTexelStep;
+     vec4 a = fetch(vTexCoord + vec2(-d.x, -d.y));
+     vec4 b = fetch(vTexCoord + vec2(d.x, -d.y));
+     vec4 c = fetch(vTexCoord + vec2(-d.x, d.y));
+     vec4 e = fetch(vTexCoord + vec2(d.x, d.y));
+     vec4 best = a;
+     best = (b.a > best.a) ? b : best;
+     best = (c.a > best.a) ? c : best;
+     best = (e.a > best.a) ? e : best;
+     gl_FragColor = best;
+ });
+// clang-format on
+
+void PeakReductionProc::getUniforms()
+{
+    shParamUTexelStep = shader->getParam(UNIF, "uTexelStep");
+    shParamUEncode = shader->getParam(UNIF, "uEncode");
+}
+
+void PeakReductionProc::setUniforms()
+{
+    glUniform2f(shParamUTexelStep, 1.f / static_cast<float>(inFrameW), 1.f / static_cast<float>(inFrameH));
+    glUniform1f(shParamUEncode, encode ? 1.f : 0.f);
+}
+
+END_OGLES_GPGPU
@@ -0,0 +1,58 @@
+/*! -*-c++-*-
+  @file   PeakReductionProc.h
+  @author David Hirvonen
+  @brief  Declaration of ogles_gpgpu shader for a 2x2 max reduction of peak responses and positions.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef OGLES_GPGPU_COMMON_GL_PEAK_REDUCTION_PROC
+#define OGLES_GPGPU_COMMON_GL_PEAK_REDUCTION_PROC
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+BEGIN_OGLES_GPGPU
+
+/*
+ * Each pass (with setOutputSize(0.5f)) halves the image and keeps the strongest of every 2x2 block, so a chain of n
+ * passes leaves the strongest peak of each 2^n x 2^n tile.  The response is in alpha, the
+ * first pass (setEncode(true)) writes the integer pixel position of each texel to (r, g)
+ * and later passes carry it along.  Positions are stored in 8 bits, i.e., the input may be
+ * at most 256x256.  Texels are sampled at their centers, so the input filtering mode doesn't
+ * change the result.
+ */
+
+class PeakReductionProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    PeakReductionProc() = default;
+
+    virtual const char* getProcName()
+    {
+        return "PeakReductionProc";
+    }
+
+    // The first pass of a chain encodes the texel positions:
+    void setEncode(bool value) { encode = value; }
+
+private:
+    virtual const char* getFragmentShaderSource()
+    {
+        return fshaderPeakReductionSrc;
+    }
+    virtual void getUniforms();
+    virtual void setUniforms();
+
+    static const char* fshaderPeakReductionSrc; // fragment shader source
+
+    bool encode = false;
+
+    GLint shParamUTexelStep;
+    GLint shParamUEncode;
+};
+
+END_OGLES_GPGPU
+
+#endif // OGLES_GPGPU_COMMON_GL_PEAK_REDUCTION_PROC
@@ -0,0 +1,168 @@
+/*! -*-c++-*-
+  @file   gpu/SceneChangeFilter.cpp
+  @author David Hirvonen
+  @brief  Implementation of a GPU frame difference statistic for static scene detection.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/gpu/SceneChangeFilter.h"
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+#include "ogles_gpgpu/common/proc/grayscale.h"
+#include "ogles_gpgpu/common/proc/diff.h"
+#include "ogles_gpgpu/common/proc/fifo.h"
+
+#include <opencv2/core.hpp>
+
+#include <limits>
+
+BEGIN_OGLES_GPGPU
+
+// Mean of |2 * r - 1| over a kSize x kSize input (DiffProc output encoded as (d + 1) / 2), use
+// with setOutputSize(1.f / kSize):
+class DiffMeanProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    virtual const char* getProcName()
+    {
+        return "DiffMeanProc";
+    }
+
+private:
+    virtual const char* getFragmentShaderSource()
+    {
+        return fshaderDiffMeanSrc;
+    }
+    virtual void getUniforms()
+    {
+        shParamUTexelStep = shader->getParam(UNIF, "uTexelStep");
+    }
+    virtual void setUniforms()
+    {
+        glUniform2f(shParamUTexelStep, 1.f / static_cast<float>(inFrameW), 1.f / static_cast<float>(inFrameH));
+    }
+
+    static const char* fshaderDiffMeanSrc; // fragment shader source
+
+    GLint shParamUTexelStep;
+};
+
+// clang-format off
+const char * DiffMeanProc::fshaderDiffMeanSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ uniform vec2 uTexelStep;
+ void main()
+ {
+     vec2 origin = vTexCoord + (0.5 - 0.5 * 16.0) * uTexelStep;
+     float sum = 0.0;
+     for (int y = 0; y < 16; y++)
+     {
+         for (int x = 0; x < 16; x++)
+         {
+             float d = texture2D(uInputTex, origin + vec2(float(x), float(y)) * uTexelStep).r;
+             sum += abs(2.0 * d - 1.0);
+         }
+     }
+     float mean = sum / 256.0;
+     gl_FragColor = vec4(mean, mean, mean, 1.0);
+ });
+// clang-format on
+
+class SceneChangeFilter::Impl
+{
+public:
+    Impl()
+        : diffProc(0.5f, 0.5f) // signed difference in (d + 1) / 2
+        , fifoProc(1)
+    {
+        grayProc.setOutputSize(kSize, kSize);
+        meanProc.setOutputSize(1.f / static_cast<float>(kSize));
+
+        grayProc.add(&diffProc);
+        diffProc.add(&meanProc);
+    }
+
+    ogles_gpgpu::GrayscaleProc grayProc;
+    ogles_gpgpu::DiffProc diffProc;
+    ogles_gpgpu::FifoProc fifoProc; // previous gray frame
+    DiffMeanProc meanProc;
+    bool hasChange = false; // meanProc holds a result
+};
+
+SceneChangeFilter::SceneChangeFilter()
+{
+    m_impl = std::make_shared<Impl>();
+
+    // Add filters to procPasses for state management
+    procPasses.push_back(&m_impl->grayProc);
+    procPasses.push_back(&m_impl->diffProc);
+    procPasses.push_back(&m_impl->fifoProc);
+    procPasses.push_back(&m_impl->meanProc);
+}
+
+SceneChangeFilter::~SceneChangeFilter()
+{
+    procPasses.clear();
+}
+
+ProcInterface* SceneChangeFilter::getInputFilter() const
+{
+    return &m_impl->grayProc;
+}
+
+ProcInterface* SceneChangeFilter::getOutputFilter() const
+{
+    return &m_impl->meanProc;
+}
+
+int SceneChangeFilter::render(int position)
+{
+    // The first frame is compared with itself:
+    const GLuint gray = m_impl->grayProc.getOutputTexId();
+    const bool hasPrevious = (m_impl->fifoProc.getBufferCount() > 0);
+    const GLuint previous = hasPrevious ? m_impl->fifoProc.getProcPasses().front()->getOutputTexId() : gray;
+    m_impl->diffProc.useTexture(previous, 2, GL_TEXTURE_2D, 1); // second input
+
+    // Execute internal filter chain (gray -> diff -> mean), then keep this frame:
+    getInputFilter()->process(position);
+    m_impl->fifoProc.useTexture(gray, 1);
+    m_impl->fifoProc.render();
+
+    m_impl->hasChange = hasPrevious;
+    return 0;
+}
+
+int SceneChangeFilter::init(int inW, int inH, unsigned int order, bool prepareForExternalInput)
+{
+    getInputFilter()->prepare(inW, inH, 0, std::numeric_limits<int>::max(), 0);
+    m_impl->fifoProc.init(kSize, kSize, std::numeric_limits<int>::max(), false);
+    m_impl->fifoProc.createFBOTex(false);
+    return 0;
+}
+
+int SceneChangeFilter::reinit(int inW, int inH, bool prepareForExternalInput)
+{
+    return init(inW, inH, 0, prepareForExternalInput);
+}
+
+float SceneChangeFilter::getChange()
+{
+    if (!m_impl->hasChange)
+    {
+        return 0.f;
+    }
+
+    cv::Mat4b texel(1, 1);
+    m_impl->meanProc.getResultData(texel.ptr());
+    return static_cast<float>(texel(0, 0)[0]) / 255.f;
+}
+
+END_OGLES_GPGPU
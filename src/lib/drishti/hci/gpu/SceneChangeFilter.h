@@ -0,0 +1,58 @@
+/*! -*-c++-*-
+  @file   gpu/SceneChangeFilter.h
+  @author David Hirvonen
+  @brief  Declaration of a GPU frame difference statistic for static scene detection.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_hci_gpu_SceneChangeFilter_h__
+#define __drishti_hci_gpu_SceneChangeFilter_h__
+
+#include "ogles_gpgpu/common/proc/base/multipassproc.h"
+
+#include <memory>
+
+BEGIN_OGLES_GPGPU
+
+/*
+ * Each frame is reduced to a kSize x kSize grayscale image, differenced (DiffProc) against
+ * the previous one (held by a FifoProc) and the mean absolute difference is reduced to a
+ * single texel.  Only that texel is read back by getChange(), which returns the value of the
+ * last render() (0 for the first frame).  Read it before the next render(), i.e., at the
+ * start of the next frame, so the readback never waits for the GPU.
+ */
+
+class SceneChangeFilter : public MultiPassProc
+{
+public:
+    static const int kSize = 16;
+
+    class Impl;
+
+    SceneChangeFilter();
+    ~SceneChangeFilter();
+
+    virtual ProcInterface* getInputFilter() const;
+    virtual ProcInterface* getOutputFilter() const;
+
+    /**
+     * Return the processor's name.
+     */
+    virtual const char* getProcName() { return "SceneChangeFilter"; }
+
+    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+    virtual int reinit(int inW, int inH, bool prepareForExternalInput = false);
+    virtual int render(int position = 0);
+
+    // Mean absolute intensity difference to the previous frame (0..1):
+    float getChange();
+
+    std::shared_ptr<Impl> m_impl;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_hci_gpu_SceneChangeFilter_h__
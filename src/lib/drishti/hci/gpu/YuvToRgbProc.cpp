@@ -0,0 +1,168 @@
+/*! -*-c++-*-
+  @file   YuvToRgbProc.cpp
+  @author David Hirvonen
+  @brief  Implementation of ogles_gpgpu shader for uploading and converting 4:2:0 YUV frames to RGBA.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/gpu/YuvToRgbProc.h"
+
+BEGIN_OGLES_GPGPU
+
+static const GLuint kLumaUnit = 1;
+static const GLuint kChromaUnitU = 2;
+static const GLuint kChromaUnitV = 3;
+
+// clang-format off
+const char * YuvToRgbProc::fshaderYuvToRgbSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision mediump float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ uniform sampler2D uChromaU;
+ uniform sampler2D uChromaV;
+ uniform vec4 uSelectU;
+ uniform vec4 uSelectV;
+ uniform vec3 uOffset;
+ uniform mat3 uConversion;
+ void main()
+ {
+     vec3 yuv;
+     yuv.x = texture2D(uInputTex, vTexCoord).r;
+     yuv.y = dot(texture2D(uChromaU, vTexCoord), uSelectU);
+     yuv.z = dot(texture2D(uChromaV, vTexCoord), uSelectV);
+     gl_FragColor = vec4(clamp(uConversion * (yuv - uOffset), 0.0, 1.0), 1.0);
+ });
+// clang-format on
+
+// BT.601 (see drishti::core::YUV420), column major (Y, U, V) -> (R, G, B):
+static const GLfloat kVideoRange[9] = { 1.164f, 1.164f, 1.164f, 0.0f, -0.391f, 2.018f, 1.596f, -0.813f, 0.0f };
+static const GLfloat kFullRange[9] = { 1.0f, 1.0f, 1.0f, 0.0f, -0.344f, 1.772f, 1.402f, -0.714f, 0.0f };
+
+static const GLfloat kVideoOffset[3] = { 16.f / 255.f, 128.f / 255.f, 128.f / 255.f };
+static const GLfloat kFullOffset[3] = { 0.f, 128.f / 255.f, 128.f / 255.f };
+
+// GL_LUMINANCE is read from .r, GL_LUMINANCE_ALPHA from .r and .a:
+static const GLfloat kSelectR[4] = { 1.f, 0.f, 0.f, 0.f };
+static const GLfloat kSelectA[4] = { 0.f, 0.f, 0.f, 1.f };
+
+YuvToRgbProc::YuvToRgbProc(Layout layout, bool fullRange)
+    : layout(layout)
+    , fullRange(fullRange)
+{
+}
+
+YuvToRgbProc::~YuvToRgbProc()
+{
+    if (textures[0])
+    {
+        glDeleteTextures(3, textures);
+    }
+}
+
+GLuint YuvToRgbProc::operator()(const Plane* planes)
+{
+    if (!textures[0])
+    {
+        glGenTextures(3, textures);
+        for (const auto& texture : textures)
+        {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+    }
+
+    const int width = getInFrameW(), height = getInFrameH();
+    const int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+
+    upload(0, planes[0], width, height, GL_LUMINANCE, 1);
+    if (layout == kI420)
+    {
+        upload(1, planes[1], chromaWidth, chromaHeight, GL_LUMINANCE, 1);
+        upload(2, planes[2], chromaWidth, chromaHeight, GL_LUMINANCE, 1);
+    }
+    else
+    {
+        upload(1, planes[1], chromaWidth, chromaHeight, GL_LUMINANCE_ALPHA, 2);
+    }
+
+    useTexture(textures[0], kLumaUnit);
+    render();
+
+    return getOutputTexId();
+}
+
+void YuvToRgbProc::upload(int index, const Plane& plane, int width, int height, GLenum format, int bytesPerPixel)
+{
+    const int rowBytes = width * bytesPerPixel;
+    const int stride = plane.stride ? plane.stride : rowBytes;
+
+    glBindTexture(GL_TEXTURE_2D, textures[index]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (stride == rowBytes)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, plane.data);
+    }
+#if defined(GL_UNPACK_ROW_LENGTH)
+    else if ((stride % bytesPerPixel) == 0)
+    {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / bytesPerPixel);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, plane.data);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+#endif
+    else
+    {
+        // OpenGL ES 2.0 has no GL_UNPACK_ROW_LENGTH, so padded rows are uploaded one at a time:
+        const auto* data = static_cast<const GLubyte*>(plane.data);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        for (int y = 0; y < height; y++)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, 1, format, GL_UNSIGNED_BYTE, data + y * stride);
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void YuvToRgbProc::getUniforms()
+{
+    shParamUChromaU = shader->getParam(UNIF, "uChromaU");
+    shParamUChromaV = shader->getParam(UNIF, "uChromaV");
+    shParamUSelectU = shader->getParam(UNIF, "uSelectU");
+    shParamUSelectV = shader->getParam(UNIF, "uSelectV");
+    shParamUOffset = shader->getParam(UNIF, "uOffset");
+    shParamUConversion = shader->getParam(UNIF, "uConversion");
+}
+
+void YuvToRgbProc::setUniforms()
+{
+    // Interleaved chroma is bound to both samplers and the channel is picked by the select vector:
+    const GLuint chromaV = (layout == kI420) ? textures[2] : textures[1];
+
+    glActiveTexture(GL_TEXTURE0 + kChromaUnitU);
+    glBindTexture(GL_TEXTURE_2D, textures[1]);
+    glUniform1i(shParamUChromaU, kChromaUnitU);
+
+    glActiveTexture(GL_TEXTURE0 + kChromaUnitV);
+    glBindTexture(GL_TEXTURE_2D, chromaV);
+    glUniform1i(shParamUChromaV, kChromaUnitV);
+
+    glActiveTexture(GL_TEXTURE0 + kLumaUnit);
+
+    glUniform4fv(shParamUSelectU, 1, (layout == kNV21) ? kSelectA : kSelectR);
+    glUniform4fv(shParamUSelectV, 1, (layout == kNV12) ? kSelectA : kSelectR);
+    glUniform3fv(shParamUOffset, 1, fullRange ? kFullOffset : kVideoOffset);
+    glUniformMatrix3fv(shParamUConversion, 1, GL_FALSE, fullRange ? kFullRange : kVideoRange);
+}
+
+END_OGLES_GPGPU
@@ -0,0 +1,83 @@
+/*! -*-c++-*-
+  @file   YuvToRgbProc.h
+  @author David Hirvonen
+  @brief  Declaration of ogles_gpgpu shader for uploading and converting 4:2:0 YUV frames to RGBA.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef OGLES_GPGPU_COMMON_GL_YUV_TO_RGB_PROC
+#define OGLES_GPGPU_COMMON_GL_YUV_TO_RGB_PROC
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+BEGIN_OGLES_GPGPU
+
+/*
+ * Camera frames are uploaded as native planes (Y as GL_LUMINANCE, interleaved chroma as
+ * GL_LUMINANCE_ALPHA, planar chroma as two GL_LUMINANCE textures) and converted to RGBA
+ * (BT.601) in the fragment shader, which avoids a full resolution CPU conversion and halves
+ * the upload size.  Rows may be padded (stride >= width), the output is the texture passed
+ * to the ACF pipeline.  All calls must be made from the GL thread.
+ */
+
+class YuvToRgbProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    enum Layout
+    {
+        kNV12, // Y + interleaved UV
+        kNV21, // Y + interleaved VU
+        kI420  // Y + U + V
+    };
+
+    struct Plane
+    {
+        const void* data = nullptr;
+        int stride = 0; // bytes per row, 0 for tightly packed rows
+    };
+
+    YuvToRgbProc(Layout layout = kNV12, bool fullRange = false);
+    ~YuvToRgbProc();
+
+    virtual const char* getProcName()
+    {
+        return "YuvToRgbProc";
+    }
+
+    void setLayout(Layout value) { layout = value; }
+    void setFullRange(bool value) { fullRange = value; }
+
+    // Upload planes (Y, UV or Y, U, V) at the size passed to init() and render, returns the RGBA texture:
+    GLuint operator()(const Plane* planes);
+
+private:
+    virtual const char* getFragmentShaderSource()
+    {
+        return fshaderYuvToRgbSrc;
+    }
+    virtual void getUniforms();
+    virtual void setUniforms();
+
+    void upload(int index, const Plane& plane, int width, int height, GLenum format, int bytesPerPixel);
+
+    static const char* fshaderYuvToRgbSrc; // fragment shader source
+
+    Layout layout = kNV12;
+    bool fullRange = false;
+
+    GLuint textures[3] = { 0, 0, 0 }; // Y, U (or UV), V
+
+    GLint shParamUChromaU;
+    GLint shParamUChromaV;
+    GLint shParamUSelectU;
+    GLint shParamUSelectV;
+    GLint shParamUOffset;
+    GLint shParamUConversion;
+};
+
+END_OGLES_GPGPU
+
+#endif // OGLES_GPGPU_COMMON_GL_YUV_TO_RGB_PROC
@@ -12,31 +12,51 @@ endif()
 include(sugar_files)
 
 sugar_files(DRISHTI_HCI_SRCS
+  ACFTiling.cpp
+  DetectionScheduler.cpp
   EyeBlob.cpp
   FaceFinder.cpp
   FaceFinderPainter.cpp
   GazeEstimator.cpp
+  GpuScheduler.cpp
+  PerformanceGovernor.cpp
   Scene.cpp
+  gpu/ACFCompute.cpp
   gpu/BlobFilter.cpp
   gpu/FacePainter.cpp
+  gpu/FeatureSampler.cpp
+  gpu/FlowTileProc.cpp
   gpu/GLCircle.cpp  
   gpu/GLPrinter.cpp
   gpu/LineDrawing.cpp
+  gpu/PeakReductionProc.cpp
+  gpu/SceneChangeFilter.cpp
+  gpu/YuvToRgbProc.cpp
   )
 
 sugar_files(DRISHTI_HCI_HDRS_PUBLIC
+  ACFTiling.h
+  DetectionScheduler.h
   EyeBlob.h
   FaceFinder.h
   FaceFinderImpl.h
   FaceFinderPainter.h
   FaceMonitor.h
   GazeEstimator.h
+  GpuScheduler.h
+  PerformanceGovernor.h
   Scene.hpp
+  gpu/ACFCompute.h
   gpu/BlobFilter.h
   gpu/FacePainter.h
+  gpu/FeatureSampler.h
+  gpu/FlowTileProc.h
   gpu/GLCircle.h
   gpu/GLPrinter.h
   gpu/LineDrawing.hpp
+  gpu/PeakReductionProc.h
+  gpu/SceneChangeFilter.h
+  gpu/YuvToRgbProc.h
   )
 
 sugar_files(DRISHTI_HCI_UT
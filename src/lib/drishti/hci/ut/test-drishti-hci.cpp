@@ -22,6 +22,8 @@ extern const char* sFaceImageFilename; // sImageFilename);
 // clang-format off
 #if defined(DRISHTI_DO_GPU_TESTING)
 #  include "aglet/GLContext.h"
+#  include "ogles_gpgpu/common/proc/hessian.h"
+#  include "ogles_gpgpu/common/proc/video.h"
 #endif
 // clang-format on
 
@@ -29,10 +31,16 @@ extern const char* sFaceImageFilename; // sImageFilename);
 #include <cereal/archives/portable_binary.hpp>
 #include <cereal/types/vector.hpp>
 
+#include "drishti/hci/ACFTiling.h"
+#include "drishti/hci/EyeBlob.h"
 #include "drishti/hci/FaceFinder.h"
+#include "drishti/hci/GazeEstimator.h"
+#include "drishti/hci/Scene.hpp"
 #include "drishti/sensor/Sensor.h"
 #include "drishti/core/ThreadPool.h"
+#include "drishti/core/filters.h"
 #include "drishti/core/Logger.h"
+#include "drishti/testlib/drishti_alloc_counter.h"
 
 #include "FaceMonitorHCITest.h"
 #include "test-hessian-cpu.h"
@@ -46,6 +54,8 @@ extern const char* sFaceImageFilename; // sImageFilename);
 #include <fstream>
 #include <memory>
 #include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #ifdef ANDROID
 #define DFLT_TEXTURE_FORMAT GL_RGBA
@@ -148,7 +158,7 @@ protected:
     {
         if (doThreads)
         {
-            m_settings.threads = std::make_shared<tp::ThreadPool<>>();
+            m_settings.threads = drishti::core::Executor::getInstance();
         }
         else
         {
@@ -293,6 +303,446 @@ TEST_F(HCITest, RunTestGPUAsync)
     static const bool doAsync = true;
     runTest(doCpu, doAsync);
 }
+
+TEST_F(HCITest, RunTestGPUAsyncPipelineDepth)
+{
+    static const bool doCpu = false;
+    static const bool doAsync = true;
+    m_settings.pipelineDepth = 3;
+    runTest(doCpu, doAsync);
+}
+
+TEST_F(HCITest, RunTestGPUAsyncReadbackBuffers)
+{
+    static const bool doCpu = false;
+    static const bool doAsync = true;
+    m_settings.readbackBuffers = 2;
+    runTest(doCpu, doAsync);
+}
+
+// Once warm (shaders, readback buffers, lazy initialization), the per frame heap
+// allocations on all threads must stay within the budget:
+TEST_F(HCITest, SteadyStateAllocations)
+{
+    const int warmup = 8, frames = 16;
+    const std::uint64_t budget = 4096; // allocations per frame (ratchet down as workspaces land)
+
+    auto detector = create(image.size(), 0, true);
+    const auto process = [&]() {
+        ogles_gpgpu::FrameInput frame({ image.cols, image.rows }, image.ptr(), true, 0, DFLT_TEXTURE_FORMAT);
+        (*detector)(frame);
+    };
+
+    for (int i = 0; i < warmup; i++)
+    {
+        process();
+    }
+    glFinish();
+
+    drishti::testlib::AllocationCounter counter;
+    for (int i = 0; i < frames; i++)
+    {
+        process();
+    }
+    glFinish();
+    EXPECT_LE(counter.total().count, budget * frames) << counter;
+}
+#endif // defined(DRISHTI_DO_GPU_TESTING)
+
+TEST(DetectionScheduler, AdaptiveDetectionScheduler)
+{
+    drishti::hci::AdaptiveDetectionScheduler scheduler;
+
+    drishti::hci::DetectionScheduler::State state;
+    state.interval = 0.1;
+    state.elapsed = 0.5;
+
+    // No tracks: search at the nominal interval
+    ASSERT_TRUE(scheduler(state));
+
+    // Stable track: skip detection until the stable interval expires
+    state.tracks = 1;
+    state.hits = 100;
+    ASSERT_FALSE(scheduler(state));
+    state.elapsed = 2.0;
+    ASSERT_TRUE(scheduler(state));
+
+    // Failing track: detect immediately
+    state.elapsed = 0.0;
+    state.hits = 0;
+    state.misses = 1;
+    ASSERT_TRUE(scheduler(state));
+
+    // Unreliable landmarks: a stable track with disagreeing regression inits is not stable
+    drishti::hci::AdaptiveDetectionScheduler::Settings settings;
+    settings.maxDisagreement = 0.05f;
+    drishti::hci::AdaptiveDetectionScheduler strict(settings);
+    state.elapsed = 0.5;
+    state.hits = 100;
+    state.misses = 0;
+    ASSERT_FALSE(strict(state));
+    state.disagreement = 0.1f;
+    ASSERT_TRUE(strict(state));
+}
+
+TEST(PerformanceGovernor, Hysteresis)
+{
+    using drishti::hci::PerformanceGovernor;
+
+    PerformanceGovernor::PowerState power;
+    PerformanceGovernor::Settings settings;
+    settings.targetFrameRate = 30.f;
+    PerformanceGovernor governor(settings, [&]() { return power; });
+
+    // Slow frames: one level after downFrames frames
+    double now = 0.0;
+    for (std::size_t i = 0; i < settings.downFrames; i++)
+    {
+        ASSERT_EQ(governor.getLevel(), 0);
+        governor.update(0.05, now += 0.05);
+    }
+    ASSERT_EQ(governor.getLevel(), 1);
+
+    // Frames within the hysteresis band keep the level
+    for (std::size_t i = 0; i < 2 * settings.upFrames; i++)
+    {
+        governor.update(0.03, now += 0.03);
+    }
+    ASSERT_EQ(governor.getLevel(), 1);
+
+    // Fast frames restore the configured quality once the average has been fast for upFrames frames
+    std::size_t frames = 0;
+    for (; (frames < 2 * settings.upFrames) && governor.getLevel(); frames++)
+    {
+        governor.update(0.01, now += 0.01);
+    }
+    ASSERT_EQ(governor.getLevel(), 0);
+    ASSERT_GE(frames, settings.upFrames);
+
+    // Critical thermal state: the last level on the next poll, despite fast frames
+    power.thermal = 1.f;
+    now += settings.pollInterval;
+    ASSERT_TRUE(governor.update(0.01, now));
+    ASSERT_EQ(governor.getLevel(), governor.getLevelCount() - 1);
+    ASSERT_FALSE(governor.getQuality().doEyeRefinement);
+}
+
+TEST(ACFTiling, AssembleMatchesFullLevels)
+{
+    using drishti::hci::ACFTiling;
+
+    // Upright bins of a 4K pyramid (the level textures are 4x larger):
+    const cv::Size inputSize(3840, 2160);
+    std::vector<cv::Size> levels;
+    for (float scale = 1.f; scale > 0.1f; scale *= 0.7f)
+    {
+        levels.emplace_back(int(inputSize.width * scale / 4.f + 0.5f), int(inputSize.height * scale / 4.f + 0.5f));
+    }
+
+    const int maxSize = 2048;
+    ACFTiling tiling(inputSize, levels, maxSize);
+    ASSERT_FALSE(tiling.empty());
+    ASSERT_GT(tiling.getTiledLevels(), 0);
+    ASSERT_LT(tiling.getTiledLevels(), int(levels.size()));
+
+    // Each input pixel is owned by one tile:
+    cv::Mat1b owners(inputSize, 0);
+    for (const auto& tile : tiling.getTiles())
+    {
+        cv::Mat1b core = owners(tile.core);
+        core += 1;
+        ASSERT_EQ(tile.roi & tile.core, tile.core);
+        for (const auto& bins : tile.levels)
+        {
+            ASSERT_LE(bins.width * ACFTiling::kShrink, maxSize);
+            ASSERT_LE(bins.height * ACFTiling::kShrink, maxSize);
+        }
+    }
+    ASSERT_EQ(cv::countNonZero(owners != 1), 0);
+
+    // Transposed planes with a unique value per bin:
+    ACFTiling::Pyramid P;
+    P.nScales = tiling.getTiledLevels();
+    P.scales.resize(P.nScales);
+    P.scaleshw.resize(P.nScales);
+    P.data.resize(P.nScales);
+    for (int i = 0; i < P.nScales; i++)
+    {
+        P.data[i] = { MatP(cv::Size(levels[i].height, levels[i].width), CV_32F, 2) };
+        for (int c = 0; c < 2; c++)
+        {
+            cv::Mat1f plane = P.data[i][0].get()[c];
+            for (int j = 0; j < int(plane.total()); j++)
+            {
+                plane(j) = float(j * (c + 1));
+            }
+        }
+    }
+
+    ACFTiling::Pyramid Q = P;
+    for (int i = 0; i < Q.nScales; i++)
+    {
+        Q.data[i][0] = MatP(P.data[i][0].get()[0].size(), CV_32F, 2);
+        for (auto& plane : Q.data[i][0].get())
+        {
+            plane.setTo(-1.f);
+        }
+    }
+
+    // Tile pyramids cut from the full levels at the tile bins reassemble the full levels:
+    for (int t = 0; t < int(tiling.getTiles().size()); t++)
+    {
+        const auto& tile = tiling.getTiles()[t];
+        ACFTiling::Pyramid Pt = tiling.getLayout(P, t);
+        for (int i = 0; i < Pt.nScales; i++)
+        {
+            const float sx = float(levels[i].width) / float(inputSize.width);
+            const float sy = float(levels[i].height) / float(inputSize.height);
+            const cv::Point origin(int(std::floor(tile.roi.x * sx + 0.5f)), int(std::floor(tile.roi.y * sy + 0.5f)));
+            for (int c = 0; c < 2; c++)
+            {
+                auto& dst = Pt.data[i][0].get()[c];
+                const cv::Rect crop = cv::Rect(origin.y, origin.x, dst.cols, dst.rows) & cv::Rect({ 0, 0 }, P.data[i][0].get()[c].size());
+                dst.setTo(-2.f);
+                P.data[i][0].get()[c](crop).copyTo(dst(crop - crop.tl()));
+            }
+        }
+        tiling.assemble(Pt, t, Q);
+    }
+
+    for (int i = 0; i < P.nScales; i++)
+    {
+        for (int c = 0; c < 2; c++)
+        {
+            ASSERT_EQ(cv::norm(P.data[i][0].get()[c], Q.data[i][0].get()[c], cv::NORM_INF), 0.0);
+        }
+    }
+}
+
+TEST(GpuScheduler, SubmitBeforeReadback)
+{
+    using drishti::hci::GpuScheduler;
+
+    GpuScheduler scheduler;
+    const std::size_t pipeline0 = scheduler.attach();
+    const std::size_t pipeline1 = scheduler.attach();
+
+    std::mutex mutex;
+    std::vector<GpuScheduler::Phase> order;
+    auto run = [&](std::size_t pipeline, GpuScheduler::Phase phase) {
+        auto pass = scheduler.acquire(pipeline, phase);
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(phase);
+    };
+
+    std::thread readback, submit;
+    {
+        // Both passes arrive while pipeline0 is busy, the late submit pass must run first:
+        auto pass = scheduler.acquire(pipeline0, GpuScheduler::kSubmit);
+        readback = std::thread(run, pipeline0, GpuScheduler::kReadback);
+        while (scheduler.getWaitingCount() < 1)
+        {
+            std::this_thread::yield();
+        }
+        submit = std::thread(run, pipeline1, GpuScheduler::kSubmit);
+        while (scheduler.getWaitingCount() < 2)
+        {
+            std::this_thread::yield();
+        }
+    }
+    readback.join();
+    submit.join();
+
+    ASSERT_EQ(order.size(), 2u);
+    ASSERT_EQ(order[0], GpuScheduler::kSubmit);
+    ASSERT_EQ(order[1], GpuScheduler::kReadback);
+    ASSERT_EQ(scheduler.getPassCount(), 3u);
+
+    scheduler.detach(pipeline1);
+    scheduler.detach(pipeline0);
+}
+
+TEST(EyeBlob, ExtractPeaks)
+{
+    // Reduced peaks: (r, g) = position, a = response, empty tiles have a == 0
+    cv::Mat4b peaks(2, 4, cv::Vec4b(0, 0, 0, 0));
+    peaks(0, 1) = cv::Vec4b(13, 2, 0, 64);
+    peaks(1, 3) = cv::Vec4b(120, 60, 0, 255);
+
+    std::vector<drishti::hci::FeaturePoint> points;
+    drishti::hci::extractPeaks(peaks, points, 1.f);
+
+    ASSERT_EQ(points.size(), 2u);
+    ASSERT_EQ(points[0].point, cv::Point2f(120.f, 60.f)); // strongest first
+    ASSERT_FLOAT_EQ(points[0].radius, 1.f);
+    ASSERT_EQ(points[1].point, cv::Point2f(13.f, 2.f));
+}
+
+// Smooth gray test pattern (BGRA) with bright blobs of a few sizes on a ramp:
+static cv::Mat4b makeBlobImage(const cv::Size& size)
+{
+    cv::Mat1b gray(size);
+    for (int y = 0; y < size.height; y++)
+    {
+        for (int x = 0; x < size.width; x++)
+        {
+            float value = 32.f + 64.f * float(x) / float(size.width);
+            for (int i = 0; i < 4; i++)
+            {
+                const cv::Point2f center((i + 0.5f) * size.width / 4.f, size.height * (0.3f + 0.15f * i));
+                const float sigma = 1.f + i;
+                const float d2 = (x - center.x) * (x - center.x) + (y - center.y) * (y - center.y);
+                value += 150.f * std::exp(-d2 / (2.f * sigma * sigma));
+            }
+            gray(y, x) = cv::saturate_cast<uint8_t>(value);
+        }
+    }
+
+    cv::Mat4b image;
+    cv::cvtColor(gray, image, cv::COLOR_GRAY2BGRA);
+    return image;
+}
+
+// Fraction of pixels of channel 0 within tolerance (borders excluded, the reference reflects):
+static float getAgreement(const cv::Mat4b& a, const cv::Mat4b& b, int tolerance)
+{
+    int count = 0, total = 0;
+    for (int y = 1; y < (a.rows - 1); y++)
+    {
+        for (int x = 1; x < (a.cols - 1); x++)
+        {
+            count += (std::abs(int(a(y, x)[0]) - int(b(y, x)[0])) <= tolerance);
+            total++;
+        }
+    }
+    return float(count) / float(std::max(total, 1));
+}
+
+TEST(EyeBlob, FixedPointHessianMatchesReference)
+{
+    const float gain = 100.f;
+    const cv::Mat4b image = makeBlobImage({ 128, 64 });
+
+    cv::Mat4b expected, hessian(image.size());
+    hessian3x3(image, expected, gain);
+    drishti::core::hessian3x3U8C4(image.data, image.step, hessian.data, hessian.step, image.cols, image.rows, gain);
+    EXPECT_EQ(getAgreement(hessian, expected, 1), 1.f);
+
+    // One NMS peak per blob at the blob center, the BlobFilter gain saturates the small blobs:
+    drishti::hci::EyeBlobFilterCPU filter;
+    cv::Mat4b response;
+    filter(image, response);
+
+    std::vector<cv::Point> peaks;
+    for (int y = 0; y < response.rows; y++)
+    {
+        for (int x = 0; x < response.cols; x++)
+        {
+            if (response(y, x)[3] > 16)
+            {
+                peaks.emplace_back(x, y);
+            }
+        }
+    }
+    ASSERT_EQ(peaks.size(), 4u);
+    for (const auto& peak : peaks)
+    {
+        const int i = peak.x * 4 / image.cols;
+        EXPECT_NEAR(peak.x, (i + 0.5f) * image.cols / 4.f, 1.f);
+        EXPECT_NEAR(peak.y, image.rows * (0.3f + 0.15f * i), 1.f);
+    }
+}
+
+#if defined(DRISHTI_DO_GPU_TESTING)
+TEST(EyeBlob, FixedPointHessianMatchesShader)
+{
+    auto context = aglet::GLContext::create(aglet::GLContext::kAuto);
+    if (!context)
+    {
+        return;
+    }
+
+    // Same configuration as ogles_gpgpu::BlobFilter:
+    const float gain = 2000.f;
+    const cv::Mat4b image = makeBlobImage({ 128, 64 });
+
+    glActiveTexture(GL_TEXTURE0);
+    ogles_gpgpu::VideoSource video;
+    ogles_gpgpu::HessianProc shader(gain, false);
+    video.set(&shader);
+    video({ { image.cols, image.rows }, const_cast<uint8_t*>(image.data), true, 0, DFLT_TEXTURE_FORMAT });
+
+    cv::Mat4b expected(shader.getOutFrameH(), shader.getOutFrameW());
+    shader.getResultData(expected.data);
+    ASSERT_EQ(expected.size(), image.size());
+
+    cv::Mat4b hessian(image.size());
+    drishti::core::hessian3x3U8C4(image.data, image.step, hessian.data, hessian.step, image.cols, image.rows, gain);
+
+    // mediump drivers differ in the last bits of the determinant:
+    EXPECT_GE(getAgreement(hessian, expected, 2), 0.99f);
+}
 #endif // defined(DRISHTI_DO_GPU_TESTING)
 
+// Synthetic eye: 4 point eyelid contour about the given center, the iris is shifted by gaze (in half widths):
+static drishti::eye::EyeModel makeEye(const cv::Point2f& center, const cv::Point2f& gaze, bool isRight)
+{
+    drishti::eye::EyeModel eye;
+    eye.eyelids = { center + cv::Point2f(-20.f, 0.f), center + cv::Point2f(0.f, -8.f), center + cv::Point2f(20.f, 0.f), center + cv::Point2f(0.f, 8.f) };
+    eye.cornerIndices[0] = isRight ? 0 : 2; // outer corners point away from the nose
+    eye.cornerIndices[1] = isRight ? 2 : 0;
+    eye.irisEllipse = cv::RotatedRect(center + gaze * 20.f, { 12.f, 12.f }, 0.f);
+    return eye;
+}
+
+TEST(GazeEstimator, RecursiveCalibration)
+{
+    // Screen point as an affine function of the iris offset:
+    const cv::Matx23f A(0.8f, 0.1f, 0.05f, -0.05f, 1.2f, -0.02f);
+
+    std::vector<drishti::face::FaceModel> faces;
+    std::vector<cv::Point2f> targets;
+    for (int y = -2; y <= 2; y++)
+    {
+        for (int x = -2; x <= 2; x++)
+        {
+            const cv::Point2f g(x * 0.1f, y * 0.05f);
+            drishti::face::FaceModel face;
+            face.eyeFullR = makeEye({ 100.f, 100.f }, g, true);
+            face.eyeFullL = makeEye({ 180.f, 100.f }, g, false);
+            faces.push_back(face);
+            targets.push_back(A * cv::Vec3f(g.x, g.y, 1.f));
+        }
+    }
+
+    drishti::hci::GazeEstimator estimator;
+    estimator.begin();
+    for (std::size_t i = 0; i < faces.size(); i++)
+    {
+        ASSERT_TRUE(estimator.update(faces[i], targets[i]));
+    }
+    const auto residual = estimator.end();
+    ASSERT_LT(residual.relative.x, 1e-2f);
+    ASSERT_LT(residual.relative.y, 1e-2f);
+
+    drishti::hci::ScenePrimitives scene;
+    scene.faces() = faces;
+    scene.faces().emplace_back(); // no eyes
+
+    std::vector<drishti::hci::GazeEstimator::GazeEstimate> gaze;
+    estimator(scene, gaze);
+    ASSERT_EQ(gaze.size(), faces.size() + 1);
+    for (std::size_t i = 0; i < faces.size(); i++)
+    {
+        ASSERT_GE(gaze[i].openness, 0.f);
+        ASSERT_LT(cv::norm(gaze[i].relative - targets[i]), 1e-2);
+        ASSERT_LT(cv::norm(estimator(faces[i]).relative - gaze[i].relative), 1e-6);
+    }
+    ASSERT_LT(gaze.back().openness, 0.f);
+
+    std::vector<drishti::hci::FeaturePoint> points;
+    drishti::hci::GazeEstimator::getGazePoints(gaze, points);
+    ASSERT_EQ(points.size(), faces.size());
+}
+
 END_EMPTY_NAMESPACE
@@ -14,6 +14,7 @@
 // implementations in ctypes
 #define _CRT_SECURE_NO_WARNINGS
 #define _CRT_SECURE_NO_DEPRECATE
+#include <cstdint>
 #include <cstdio>
 #include <vector>
 #include <string>
@@ -143,6 +144,54 @@ DMatrixSimpleFromMat(const MatrixType<float>& data, bst_ulong nrow, bst_ulong nc
     return p_mat;
 }
 
+// Contiguous feature rows (with a pitch of stride floats) and an optional mask with the same
+// layout (0 : missing).  NaN values are missing, as for the NAN missing value above.  The row
+// sizes are counted first, so the entries are written in place (in parallel) with a single
+// allocation instead of one push_back() per entry (threads <= 0 : OpenMP default).
+inline std::shared_ptr<DMatrixSimple>
+DMatrixSimpleFromRows(const float* data, bst_ulong nrow, bst_ulong ncol, bst_ulong stride, const std::uint8_t* mask, int threads)
+{
+    std::shared_ptr<DMatrixSimple> p_mat = std::make_shared<DMatrixSimple>();
+    DMatrixSimple& mat = *p_mat;
+    mat.info.info.num_row = nrow;
+    mat.info.info.num_col = ncol;
+
+    const auto keep = [&](bst_ulong k) { return (!mask || mask[k]) && !utils::CheckNAN(data[k]); };
+    const int nthread = (threads > 0) ? threads : omp_get_max_threads();
+    const bst_omp_uint n = static_cast<bst_omp_uint>(nrow);
+
+    std::vector<bst_ulong> counts(nrow, 0);
+#pragma omp parallel for schedule(static) num_threads(nthread)
+    for (bst_omp_uint i = 0; i < n; ++i)
+    {
+        for (bst_ulong j = 0, k = i * stride; j < ncol; ++j, ++k)
+        {
+            counts[i] += keep(k) ? 1 : 0;
+        }
+    }
+
+    mat.row_ptr_.resize(nrow + 1); // row_ptr_[0] == 0
+    for (bst_ulong i = 0; i < nrow; ++i)
+    {
+        mat.row_ptr_[i + 1] = mat.row_ptr_[i] + counts[i];
+    }
+    mat.row_data_.resize(mat.row_ptr_[nrow]);
+
+#pragma omp parallel for schedule(static) num_threads(nthread)
+    for (bst_omp_uint i = 0; i < n; ++i)
+    {
+        RowBatch::Entry* entry = mat.row_data_.data() + mat.row_ptr_[i];
+        for (bst_ulong j = 0, k = i * stride; j < ncol; ++j, ++k)
+        {
+            if (keep(k))
+            {
+                *entry++ = RowBatch::Entry(bst_uint(j), data[k]);
+            }
+        }
+    }
+    return p_mat;
+}
+
 DRISHTI_BEGIN_NAMESPACE(wrapper)
 
 // booster wrapper class
@@ -261,6 +310,20 @@ public:
         m_streamLogger = logger;
     }
 
+    // Model access for conversion to drishti::ml::TreeEnsemble:
+    const gbm::IGradBooster* GetGradBooster() const
+    {
+        return gbm_;
+    }
+    float GetBaseScore() const
+    {
+        return mparam.base_score;
+    }
+    const std::string& GetObjective() const
+    {
+        return name_obj_;
+    }
+
     // temporal data to save model dump
     std::string model_str;
 
@@ -270,6 +333,15 @@ private:
     std::shared_ptr<spdlog::logger> m_streamLogger;
 };
 
+// Read only access to the (protected) trees of a gbtree model:
+struct GBTreeAccess : public gbm::GBTree
+{
+    static const std::vector<tree::RegTree*>& GetTrees(const gbm::GBTree& gbtree)
+    {
+        return gbtree.*(&GBTreeAccess::trees);
+    }
+};
+
 DRISHTI_END_NAMESPACE(wrapper)
 DRISHTI_END_NAMESPACE(xgboost)
 
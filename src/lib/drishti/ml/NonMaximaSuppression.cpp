@@ -0,0 +1,132 @@
+/*! -*-c++-*-
+  @file   NonMaximaSuppression.cpp
+  @author David Hirvonen
+  @brief  Implementation of greedy non-maxima suppression for scored detections.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/ml/NonMaximaSuppression.h"
+
+#include <algorithm>
+#include <numeric>
+
+// clang-format off
+#if defined(__arm__) || defined(__arm64__) || defined(__aarch64__)
+#  include <arm_neon.h>
+#  define DO_ARM_NEON 1
+#endif
+// clang-format on
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+struct Boxes
+{
+    const float *x0, *y0, *x1, *y1, *area;
+};
+
+// Set bit j of the mask for each box j in [begin, end) that box i overlaps by more than maxOverlap.
+// Boxes are processed one mask word at a time, the overlap test is branch free and vectorizes:
+static void suppress(const Boxes& boxes, int i, int begin, int end, float maxOverlap, bool useMin, std::uint64_t* mask)
+{
+    const float ax0 = boxes.x0[i], ay0 = boxes.y0[i], ax1 = boxes.x1[i], ay1 = boxes.y1[i], aa = boxes.area[i];
+
+    for (int base = begin & ~63; base < end; base += 64)
+    {
+        const int lo = std::max(base, begin), hi = std::min(base + 64, end);
+
+        std::uint8_t flags[64];
+        int j = lo;
+
+#if DO_ARM_NEON
+        const float32x4_t vx0 = vdupq_n_f32(ax0), vy0 = vdupq_n_f32(ay0), vx1 = vdupq_n_f32(ax1), vy1 = vdupq_n_f32(ay1);
+        const float32x4_t va = vdupq_n_f32(aa), vt = vdupq_n_f32(maxOverlap), zero = vdupq_n_f32(0.f);
+        for (; (j + 4) <= hi; j += 4)
+        {
+            const float32x4_t w = vmaxq_f32(zero, vsubq_f32(vminq_f32(vx1, vld1q_f32(boxes.x1 + j)), vmaxq_f32(vx0, vld1q_f32(boxes.x0 + j))));
+            const float32x4_t h = vmaxq_f32(zero, vsubq_f32(vminq_f32(vy1, vld1q_f32(boxes.y1 + j)), vmaxq_f32(vy0, vld1q_f32(boxes.y0 + j))));
+            const float32x4_t inter = vmulq_f32(w, h), b = vld1q_f32(boxes.area + j);
+            const float32x4_t denom = useMin ? vminq_f32(va, b) : vsubq_f32(vaddq_f32(va, b), inter);
+
+            std::uint32_t lanes[4];
+            vst1q_u32(lanes, vandq_u32(vcgtq_f32(inter, vmulq_f32(vt, denom)), vdupq_n_u32(1)));
+            for (int k = 0; k < 4; k++)
+            {
+                flags[j - base + k] = std::uint8_t(lanes[k]);
+            }
+        }
+#endif
+
+        for (; j < hi; j++)
+        {
+            const float w = std::max(0.f, std::min(ax1, boxes.x1[j]) - std::max(ax0, boxes.x0[j]));
+            const float h = std::max(0.f, std::min(ay1, boxes.y1[j]) - std::max(ay0, boxes.y0[j]));
+            const float inter = w * h;
+            const float denom = useMin ? std::min(aa, boxes.area[j]) : (aa + boxes.area[j] - inter);
+            flags[j - base] = std::uint8_t(inter > (maxOverlap * denom));
+        }
+
+        std::uint64_t bits = 0;
+        for (j = lo; j < hi; j++)
+        {
+            bits |= std::uint64_t(flags[j - base]) << (j - base);
+        }
+        mask[base / 64] |= bits;
+    }
+}
+
+void NonMaximaSuppression::operator()(std::vector<cv::Rect>& objects, std::vector<double>& scores, std::size_t maxCount)
+{
+    CV_Assert(objects.size() == scores.size());
+
+    const int n = int(objects.size());
+    m_order.resize(n);
+    std::iota(m_order.begin(), m_order.end(), 0);
+    std::stable_sort(m_order.begin(), m_order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+
+    for (auto* array : { &m_x0, &m_y0, &m_x1, &m_y1, &m_area })
+    {
+        array->resize(n);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        const cv::Rect& roi = objects[m_order[i]];
+        m_x0[i] = float(roi.x);
+        m_y0[i] = float(roi.y);
+        m_x1[i] = float(roi.x + roi.width);
+        m_y1[i] = float(roi.y + roi.height);
+        m_area[i] = float(roi.area());
+    }
+    m_suppressed.assign((n + 63) / 64, 0);
+
+    const Boxes boxes = { m_x0.data(), m_y0.data(), m_x1.data(), m_y1.data(), m_area.data() };
+
+    std::vector<cv::Rect> objectsOut;
+    std::vector<double> scoresOut;
+    for (int i = 0; (i < n) && (objectsOut.size() < maxCount); i++)
+    {
+        if (!((m_suppressed[i / 64] >> (i % 64)) & 1))
+        {
+            objectsOut.push_back(objects[m_order[i]]);
+            scoresOut.push_back(scores[m_order[i]]);
+            suppress(boxes, i, i + 1, n, m_maxOverlap, (m_type == kMin), m_suppressed.data());
+        }
+    }
+
+    objects.swap(objectsOut);
+    scores.swap(scoresOut);
+}
+
+void chooseBest(std::vector<cv::Rect>& objects, std::vector<double>& scores)
+{
+    if (objects.size() > 1)
+    {
+        const auto best = std::distance(scores.begin(), std::max_element(scores.begin(), scores.end()));
+        objects = { objects[best] };
+        scores = { scores[best] };
+    }
+}
+
+DRISHTI_ML_NAMESPACE_END
@@ -0,0 +1,70 @@
+/*! -*-c++-*-
+  @file   NonMaximaSuppression.h
+  @author David Hirvonen
+  @brief  Declaration of greedy non-maxima suppression for scored detections.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_ml_NonMaximaSuppression_h__
+#define __drishti_ml_NonMaximaSuppression_h__
+
+#include "drishti/ml/drishti_ml.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+/*
+ * Detections are stored as a structure of arrays (corners, areas and scores) sorted by
+ * decreasing score, so that the overlap of one box with all lower scoring boxes is a
+ * contiguous vectorized loop.  Suppressed boxes are tracked in a bit mask.
+ */
+
+class NonMaximaSuppression
+{
+public:
+    // Denominator of the overlap ratio:
+    enum OverlapType
+    {
+        kUnion, // intersection over union
+        kMin    // intersection over the smaller area (i.e., nested detections)
+    };
+
+    NonMaximaSuppression(float maxOverlap = 0.65f, OverlapType type = kMin)
+        : m_maxOverlap(maxOverlap)
+        , m_type(type)
+    {
+    }
+
+    // Keep (at most maxCount) local maxima, objects and scores are returned in order of decreasing score:
+    void operator()(std::vector<cv::Rect>& objects, std::vector<double>& scores, std::size_t maxCount = std::numeric_limits<std::size_t>::max());
+
+    void setMaxOverlap(float value) { m_maxOverlap = value; }
+    float getMaxOverlap() const { return m_maxOverlap; }
+
+    void setOverlapType(OverlapType type) { m_type = type; }
+    OverlapType getOverlapType() const { return m_type; }
+
+protected:
+    float m_maxOverlap = 0.65f;
+    OverlapType m_type = kMin;
+
+    // Scratch (reused across calls):
+    std::vector<int> m_order;
+    std::vector<float> m_x0, m_y0, m_x1, m_y1, m_area;
+    std::vector<std::uint64_t> m_suppressed;
+};
+
+// Reduce detections to the single highest scoring detection:
+void chooseBest(std::vector<cv::Rect>& objects, std::vector<double>& scores);
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // __drishti_ml_NonMaximaSuppression_h__
@@ -13,7 +13,10 @@
 #include "drishti/ml/drishti_ml.h"
 #include "drishti/ml/ObjectDetector.h"
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
+#include <tuple>
 
 DRISHTI_ML_NAMESPACE_BEGIN
 
@@ -37,6 +40,71 @@ void ObjectDetector::setDetectionScorePruneRatio(double ratio)
     m_detectionScorePruneRatio = ratio;
 }
 
+void ObjectDetector::suppress(std::vector<cv::Rect>& objects, std::vector<double>& scores)
+{
+    if (m_doNms)
+    {
+        m_nms(objects, scores);
+    }
+}
+
+int ObjectDetector::detectRegions(const cv::Mat& image, const std::vector<cv::Rect>& rois, std::vector<cv::Rect>& objects, std::vector<double>* scores)
+{
+    std::vector<Detections> results(rois.size());
+    for (std::size_t i = 0; i < rois.size(); i++)
+    {
+        const cv::Rect roi = rois[i] & cv::Rect({ 0, 0 }, image.size());
+        if (roi.area())
+        {
+            auto& result = results[i];
+            (*this)(image(roi), result.objects, &result.scores);
+            for (auto& object : result.objects)
+            {
+                object += roi.tl();
+            }
+        }
+    }
+    return merge(results, objects, scores);
+}
+
+int ObjectDetector::merge(std::vector<Detections>& results, std::vector<cv::Rect>& objects, std::vector<double>* scores)
+{
+    std::vector<cv::Rect> merged;
+    std::vector<double> mergedScores;
+    for (const auto& result : results)
+    {
+        merged.insert(merged.end(), result.objects.begin(), result.objects.end());
+        mergedScores.insert(mergedScores.end(), result.scores.begin(), result.scores.end());
+    }
+
+    std::vector<int> order(merged.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const auto& ra = merged[a];
+        const auto& rb = merged[b];
+        return std::make_tuple(-mergedScores[a], ra.x, ra.y, ra.width, ra.height) < std::make_tuple(-mergedScores[b], rb.x, rb.y, rb.width, rb.height);
+    });
+
+    objects.resize(order.size());
+    std::vector<double> scoresOut(order.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        objects[i] = merged[order[i]];
+        scoresOut[i] = mergedScores[order[i]];
+    }
+
+    // The same object found in two overlapping regions:
+    NonMaximaSuppression overlaps(0.9f, NonMaximaSuppression::kUnion);
+    overlaps(objects, scoresOut);
+
+    suppress(objects, scoresOut);
+    if (scores)
+    {
+        scores->swap(scoresOut);
+    }
+    return int(objects.size());
+}
+
 void ObjectDetector::prune(std::vector<cv::Rect>& objects, std::vector<double>& scores)
 {
     CV_Assert(objects.size() == scores.size());
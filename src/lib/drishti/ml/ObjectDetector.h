@@ -11,8 +11,9 @@
 #ifndef __drishti_ml_ObjectDetector_h__
 #define __drishti_ml_ObjectDetector_h__
 
-#include "drishti/ml/ObjectDetector.h"
 #include "drishti/ml/drishti_ml.h"
+#include "drishti/ml/NonMaximaSuppression.h"
+#include "drishti/core/MemoryUsage.h"
 
 #include <acf/MatP.h>
 
@@ -28,6 +29,11 @@ class ObjectDetector
 public:
     virtual int operator()(const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = 0) = 0;
     virtual int operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = 0) = 0;
+
+    // Detect in a batch of regions (e.g., candidates from tracking), which are clipped to the
+    // image.  The detections are merged in image coordinates, sorted by decreasing score (then
+    // position) and suppressed (see suppress()).  The default runs operator() on each region:
+    virtual int detectRegions(const cv::Mat& image, const std::vector<cv::Rect>& rois, std::vector<cv::Rect>& objects, std::vector<double>* scores = 0);
     virtual void setMaxDetectionCount(size_t maxCount);
     virtual void setDetectionScorePruneRatio(double ratio);
     virtual void prune(std::vector<cv::Rect>& objects, std::vector<double>& scores);
@@ -35,7 +41,27 @@ public:
     virtual bool getDoNonMaximaSuppression() const;
     virtual cv::Size getWindowSize() const = 0;
 
+    // Heap footprint of the model by component (empty if unsupported):
+    virtual core::MemoryUsage memoryUsage() const
+    {
+        return {};
+    }
+
+    // Apply non-maxima suppression (if enabled), the detections are sorted by decreasing score:
+    void suppress(std::vector<cv::Rect>& objects, std::vector<double>& scores);
+    NonMaximaSuppression& getNonMaximaSuppression() { return m_nms; }
+
 protected:
+    struct Detections
+    {
+        std::vector<cv::Rect> objects;
+        std::vector<double> scores;
+    };
+
+    // Deterministic merge of per region detections (see detectRegions()):
+    int merge(std::vector<Detections>& results, std::vector<cv::Rect>& objects, std::vector<double>* scores);
+
+    NonMaximaSuppression m_nms;
     bool m_doNms = false;
     double m_detectionScorePruneRatio = 0.0;
     size_t m_maxDetectionCount = 10;
@@ -9,54 +9,124 @@
 */
 
 #include "drishti/ml/ObjectDetectorACF.h"
+#include "drishti/core/CompressedStream.h"
+#include "drishti/core/convert.h"
 #include "drishti/core/make_unique.h"
 
 #include <acf/ACF.h>
 
+#include <algorithm>
+#include <fstream>
+
 DRISHTI_ML_NAMESPACE_BEGIN
 
 ObjectDetectorACF::ObjectDetectorACF() = default;
 
 ObjectDetectorACF::ObjectDetectorACF(const std::string& filename)
 {
+    if (drishti::core::isCompressed(filename))
+    {
+        std::ifstream is(filename, std::ios::binary);
+        load(is, {});
+        return;
+    }
+
     m_impl = drishti::core::make_unique<acf::Detector>(filename);
+    m_impl->setDoNonMaximaSuppression(false); // see ObjectDetector::suppress()
+
+    std::ifstream is(filename, std::ios::binary | std::ios::ate);
+    m_modelBytes = is ? std::size_t(std::max(std::streamoff(is.tellg()), std::streamoff(0))) : 0;
 }
 
 ObjectDetectorACF::ObjectDetectorACF(std::istream& is, const std::string& hint)
 {
+    load(is, hint);
+}
+
+void ObjectDetectorACF::load(std::istream& is, const std::string& hint)
+{
+    if (drishti::core::isCompressed(is))
+    {
+        drishti::core::CompressedInputStream cis(is);
+        load(cis, hint); // the model size is reported uncompressed
+        return;
+    }
+
+    const auto begin = is.tellg();
     m_impl = drishti::core::make_unique<acf::Detector>(is, hint);
+    m_impl->setDoNonMaximaSuppression(false);
+
+    const auto end = is.tellg(); // -1 for streams that can't report a position
+    if ((begin >= 0) && (end > begin))
+    {
+        m_modelBytes = std::size_t(end - begin);
+    }
 }
 
 ObjectDetectorACF::~ObjectDetectorACF() = default;
 
 int ObjectDetectorACF::operator()(const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>* scores)
 {
-    return (*m_impl)(image, objects, scores);
+    std::vector<double> scoresOut;
+    int result = (*m_impl)(image, objects, &scoresOut);
+    return finish(objects, scoresOut, scores, result);
 }
 
 int ObjectDetectorACF::operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores)
 {
-    return (*m_impl)(image, objects, scores);
+    std::vector<double> scoresOut;
+    int result = (*m_impl)(image, objects, &scoresOut);
+    return finish(objects, scoresOut, scores, result);
 }
 
-bool ObjectDetectorACF::good() const
+int ObjectDetectorACF::finish(std::vector<cv::Rect>& objects, std::vector<double>& scoresOut, std::vector<double>* scores, int result)
 {
-    return m_impl->good();
+    suppress(objects, scoresOut);
+    if (scores)
+    {
+        scores->swap(scoresOut);
+    }
+    return result;
 }
 
-ObjectDetectorACF::operator bool() const
+void ObjectDetectorACF::getPlanar(const cv::Mat& image, MatP& planar, bool isBGR, cv::Mat* transposed)
 {
-    return m_impl->operator bool();
+    CV_Assert((image.type() == CV_8UC3) || (image.type() == CV_8UC4));
+
+    cv::Mat buffer;
+    cv::Mat& It = transposed ? *transposed : buffer;
+    cv::transpose(image, It);
+
+    const cv::Size size = It.size();
+    if ((planar.get().size() != 3) || (planar[0].size() != size) || (planar[0].type() != CV_32FC1))
+    {
+        planar = MatP(size, CV_32F, 3);
+    }
+
+    std::vector<core::PlaneInfo> planes;
+    for (int i = 0; i < 3; i++)
+    {
+        planes.emplace_back(planar[i], isBGR ? (2 - i) : i, 1.f / 255.f);
+    }
+
+    if (It.channels() == 3)
+    {
+        core::convertU8ToF32(cv::Mat3b(It), planes);
+    }
+    else
+    {
+        core::convertU8ToF32(cv::Mat4b(It), planes);
+    }
 }
 
-void ObjectDetectorACF::setDoNonMaximaSuppression(bool flag)
+bool ObjectDetectorACF::good() const
 {
-    m_impl->setDoNonMaximaSuppression(flag);
+    return m_impl->good();
 }
 
-bool ObjectDetectorACF::getDoNonMaximaSuppression() const
+ObjectDetectorACF::operator bool() const
 {
-    return m_impl->getDoNonMaximaSuppression();
+    return m_impl->operator bool();
 }
 
 cv::Size ObjectDetectorACF::getWindowSize() const
@@ -64,4 +134,11 @@ cv::Size ObjectDetectorACF::getWindowSize() const
     return m_impl->getWindowSize();
 }
 
+core::MemoryUsage ObjectDetectorACF::memoryUsage() const
+{
+    core::MemoryUsage usage;
+    usage.add("classifier", m_modelBytes);
+    return usage;
+}
+
 DRISHTI_ML_NAMESPACE_END
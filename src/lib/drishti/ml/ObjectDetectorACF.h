@@ -34,14 +34,27 @@ public:
     virtual int operator()(const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = 0);
     virtual int operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = 0);
     virtual cv::Size getWindowSize() const;
-    virtual void setDoNonMaximaSuppression(bool flag);
-    virtual bool getDoNonMaximaSuppression() const;
+
+    // The classifier arrays are estimated by the serialized model size:
+    virtual core::MemoryUsage memoryUsage() const;
     
     acf::Detector* getDetector() const { return m_impl.get(); }
 
+    // CPU input (transposed planar float RGB in [0,1]) from an upright CV_8UC3 or CV_8UC4 image:
+    // the transposition stays in uint8 and the planes are unpacked and scaled in one pass.
+    // Planes are reused when the size doesn't change, as is the (optional) transposed buffer.
+    static void getPlanar(const cv::Mat& image, MatP& planar, bool isBGR = false, cv::Mat* transposed = nullptr);
+
 protected:
-    
+
+    // Deserialize from a raw or compressed (core/CompressedStream.h) stream:
+    void load(std::istream& is, const std::string& hint);
+
+    // Suppress and return the scores (if requested):
+    int finish(std::vector<cv::Rect>& objects, std::vector<double>& scoresOut, std::vector<double>* scores, int result);
+
     std::unique_ptr<acf::Detector> m_impl;
+    std::size_t m_modelBytes = 0; // serialized model size
 
 };
 
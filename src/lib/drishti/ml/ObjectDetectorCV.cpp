@@ -9,39 +9,147 @@
 */
 
 #include "drishti/core/make_unique.h"
+#include "drishti/core/LazyParallelResource.h"
+#include "drishti/core/ParallelFor.h"
 
 //#include "drishti/ml/ObjectDetectorCV.h"
 
 #include "ObjectDetectorCV.h"
 
+#include <opencv2/imgproc.hpp>
 #include <opencv2/objdetect.hpp>
 
 DRISHTI_ML_NAMESPACE_BEGIN
 
-ObjectDetectorCV::ObjectDetectorCV(const std::string& filename)
+using ClassifierPtr = std::shared_ptr<cv::CascadeClassifier>;
+
+struct ObjectDetectorCV::Impl
+{
+    Impl(const std::string& filename, ExecutorPtr executor)
+        : filename(filename)
+        , executor(executor)
+        , classifiers([this]() { return std::make_shared<cv::CascadeClassifier>(this->filename); })
+    {
+    }
+
+    std::string filename; // one classifier per thread is loaded on demand
+    ExecutorPtr executor;
+    core::ThreadLocalParallelResource<ClassifierPtr> classifiers;
+};
+
+ObjectDetectorCV::ObjectDetectorCV(const std::string& filename, ExecutorPtr executor)
 {
     m_classifier = drishti::core::make_unique<cv::CascadeClassifier>(filename);
+    m_parallel = drishti::core::make_unique<Impl>(filename, executor);
 }
 
 ObjectDetectorCV::~ObjectDetectorCV()
 {
 }
 
+void ObjectDetectorCV::detect(cv::CascadeClassifier& classifier, const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>& scores, bool doScores) const
+{
+    if (!doScores)
+    {
+        classifier.detectMultiScale(image, objects, m_scaleStep, m_minNeighbors, 0, m_minSize, m_maxSize);
+        return;
+    }
+
+    // The cascade confidence (level weights) serves as the detection score:
+    std::vector<int> levels;
+    classifier.detectMultiScale(image, objects, levels, scores, m_scaleStep, m_minNeighbors, 0, m_minSize, m_maxSize, true);
+}
+
 int ObjectDetectorCV::operator()(const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>* scores)
 {
-    m_classifier->detectMultiScale(image, objects, m_scaleStep, m_minNeighbors, 0, m_minSize, m_maxSize);
+    const cv::Rect bounds({ 0, 0 }, image.size());
+    const cv::Rect roi = m_roi.area() ? (m_roi & bounds) : bounds;
+
+    objects.clear();
+    std::vector<double> weights;
+    const bool doScores = (m_doNms || scores);
+    if (roi.area())
+    {
+        detect(*m_classifier, (roi == bounds) ? image : image(roi), objects, weights, doScores);
+        for (auto& object : objects)
+        {
+            object += roi.tl();
+        }
+    }
+
+    if (doScores)
+    {
+        suppress(objects, weights);
+        if (scores)
+        {
+            scores->swap(weights);
+        }
+    }
     return 0;
 }
 
+// Adapter for the transposed planar input of the ACF detectors (RGB or gray in [0,1] or 8-bit):
 int ObjectDetectorCV::operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores)
 {
-    assert(false);
-    return 0;
+    const auto& planes = image.get();
+    CV_Assert(!planes.empty());
+
+    cv::Mat upright, gray;
+    if (planes.size() >= 3)
+    {
+        std::vector<cv::Mat> channels{ planes[0].t(), planes[1].t(), planes[2].t() };
+        cv::merge(channels, upright);
+        cv::cvtColor(upright, upright, cv::COLOR_RGB2GRAY);
+    }
+    else
+    {
+        upright = planes[0].t();
+    }
+    upright.convertTo(gray, CV_8U, (upright.depth() == CV_8U) ? 1.0 : 255.0);
+
+    return (*this)(gray, objects, scores);
+}
+
+// Regions are detected in parallel with the classifier of each worker, and merged in order:
+int ObjectDetectorCV::detectRegions(const cv::Mat& image, const std::vector<cv::Rect>& rois, std::vector<cv::Rect>& objects, std::vector<double>* scores)
+{
+    const cv::Size winSize = getWindowSize();
+    std::vector<Detections> results(rois.size());
+    core::parallel_for(m_parallel->executor.get(), int(rois.size()), [&](int i) {
+        const cv::Rect roi = rois[i] & cv::Rect({ 0, 0 }, image.size());
+        if ((roi.width < winSize.width) || (roi.height < winSize.height) || !roi.area())
+        {
+            return; // smaller than the detection window
+        }
+
+        auto& result = results[i];
+        detect(*m_parallel->classifiers.get(), image(roi), result.objects, result.scores, true);
+        for (auto& object : result.objects)
+        {
+            object += roi.tl();
+        }
+    });
+
+    return merge(results, objects, scores);
 }
 
 cv::Size ObjectDetectorCV::getWindowSize() const
 {
-    return cv::Size();
+    return m_classifier->getOriginalWindowSize();
+}
+
+void ObjectDetectorCV::setDistanceRange(float fx, float objectWidth, float minDistance, float maxDistance)
+{
+    const cv::Size winSize = getWindowSize();
+    const float aspect = winSize.width ? (float(winSize.height) / float(winSize.width)) : 1.f;
+    auto getSize = [&](float distance) {
+        const float width = fx * objectWidth / distance;
+        return cv::Size(int(width + 0.5f), int(width * aspect + 0.5f));
+    };
+
+    // Near objects are the largest:
+    m_maxSize = (minDistance > 0.f) ? getSize(minDistance) : cv::Size();
+    m_minSize = (maxDistance > 0.f) ? getSize(maxDistance) : cv::Size();
 }
 
 DRISHTI_ML_NAMESPACE_END
@@ -12,9 +12,12 @@
 #define __drishti_ml_ObjectDetectorCV_h__
 
 #include "drishti/ml/ObjectDetector.h"
+#include "drishti/core/Executor.h"
 
 #include <opencv2/core.hpp>
 
+#include <memory>
+#include <string>
 #include <vector>
 
 // clang-format off
@@ -23,14 +26,24 @@ namespace cv { class CascadeClassifier; }
 
 DRISHTI_ML_NAMESPACE_BEGIN
 
+/*
+ * cv::CascadeClassifier detector (8-bit grayscale or BGR input).  Detection can be restricted
+ * to a region of the image and to the object sizes of a distance range, and a batch of regions
+ * (e.g., candidates from tracking) is distributed over an Executor.  cv::CascadeClassifier isn't
+ * reentrant: every worker thread loads its own copy of the model.
+ */
+
 class ObjectDetectorCV : public ObjectDetector
 {
 public:
-    ObjectDetectorCV(const std::string& filename);
+    using ExecutorPtr = std::shared_ptr<core::Executor>;
+
+    ObjectDetectorCV(const std::string& filename, ExecutorPtr executor = core::Executor::getInstance());
     ~ObjectDetectorCV();
 
     virtual int operator()(const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = 0);
     virtual int operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = 0);
+    virtual int detectRegions(const cv::Mat& image, const std::vector<cv::Rect>& rois, std::vector<cv::Rect>& objects, std::vector<double>* scores = 0);
     virtual cv::Size getWindowSize() const;
 
     void setMinNeighbors(int value) { m_minNeighbors = value; }
@@ -38,13 +51,29 @@ public:
     void setMinSize(const cv::Size& size) { m_minSize = size; }
     void setMaxSize(const cv::Size& size) { m_maxSize = size; }
 
+    // Restrict operator() to a region of the image (empty : full image):
+    void setDetectionRegion(const cv::Rect& roi) { m_roi = roi; }
+    const cv::Rect& getDetectionRegion() const { return m_roi; }
+
+    // Bound the object sizes (see setMinSize() and setMaxSize()) to objects of the given width
+    // (meters) between minDistance and maxDistance (meters, <= 0 : unbounded) for a camera with
+    // focal length fx (pixels), with the aspect ratio of the detection window:
+    void setDistanceRange(float fx, float objectWidth, float minDistance, float maxDistance);
+
 protected:
+    struct Impl;
+
+    // Run a classifier with the scale options, the cascade confidences are only computed for doScores:
+    void detect(cv::CascadeClassifier& classifier, const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>& scores, bool doScores) const;
+
     std::unique_ptr<cv::CascadeClassifier> m_classifier;
+    std::unique_ptr<Impl> m_parallel;
 
     int m_minNeighbors = 1;
     float m_scaleStep = 1.1f;
     cv::Size m_minSize; // default to min template
     cv::Size m_maxSize; // default to full image
+    cv::Rect m_roi;     // default to full image
 };
 
 DRISHTI_ML_NAMESPACE_END
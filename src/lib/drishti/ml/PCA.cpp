@@ -13,6 +13,9 @@
 
 #include <Eigen/Dense>
 
+#include <algorithm>
+#include <cmath>
+
 DRISHTI_ML_NAMESPACE_BEGIN
 
 // ########## Scaling params ############
@@ -43,7 +46,26 @@ void StandardizedPCA::Standardizer::compute(const cv::Mat& src, const cv::Mat &c
         pSigma[0] = sigma[0];
     }
     
-    if(!columnWeights.empty())
+    divide(sigma, columnWeights);
+}
+
+void StandardizedPCA::Standardizer::compute(const Accumulator& moments, const cv::Mat& columnWeights)
+{
+    CV_Assert(moments.count > 0);
+    create(moments.mu.cols, CV_32FC1);
+    float *pMu = mu.ptr<float>(), *pSigma = sigma.ptr<float>();
+    for (int i = 0; i < moments.mu.cols; i++)
+    {
+        pMu[i] = float(moments.mu(i));
+        pSigma[i] = float(std::sqrt(moments.m2(i, i) / moments.count)); // population, as cv::meanStdDev()
+    }
+
+    divide(sigma, columnWeights);
+}
+
+void StandardizedPCA::Standardizer::divide(cv::Mat& sigma, const cv::Mat& columnWeights)
+{
+    if (!columnWeights.empty())
     {
         CV_Assert(columnWeights.size().area() == sigma.size().area());
         cv::divide(sigma, (sigma.cols == columnWeights.cols) ? columnWeights : columnWeights.t(), sigma);
@@ -98,6 +120,16 @@ size_t StandardizedPCA::getNumComponents() const
     return m_transform.mu.cols;
 }
 
+std::size_t StandardizedPCA::getMemoryUsage() const
+{
+    std::size_t bytes = core::getMemoryUsage(m_transform.mu) + core::getMemoryUsage(m_transform.sigma) + core::getMemoryUsage(m_eT);
+    if (m_pca)
+    {
+        bytes += core::getMemoryUsage(m_pca->eigenvectors) + core::getMemoryUsage(m_pca->eigenvalues) + core::getMemoryUsage(m_pca->mean);
+    }
+    return bytes;
+}
+
 void StandardizedPCA::compute(const cv::Mat& data, cv::Mat& projection, float retainedVariance, const cv::Mat &columnWeights)
 {
     cv::Mat mu;
@@ -120,6 +152,168 @@ void StandardizedPCA::compute(const cv::Mat& data, cv::Mat& projection, int maxC
     init();
 }
 
+// ########### Streaming moments #############
+
+void StandardizedPCA::Accumulator::add(const cv::Mat& chunk)
+{
+    if (chunk.empty())
+    {
+        return;
+    }
+
+    cv::Mat1d x;
+    chunk.reshape(1, chunk.rows).convertTo(x, CV_64F);
+
+    // Moments of the chunk, then the pairwise update (Chan et al.) for a stable merge:
+    cv::Mat1d muB, m2B;
+    cv::reduce(x, muB, 0, CV_REDUCE_AVG);
+    x -= cv::repeat(muB, x.rows, 1);
+    cv::mulTransposed(x, m2B, true); // x' * x
+
+    if (count == 0)
+    {
+        mu = muB;
+        m2 = m2B;
+        count = x.rows;
+        return;
+    }
+
+    CV_Assert(mu.cols == x.cols);
+    const double nA = count, nB = x.rows, n = nA + nB;
+    const cv::Mat1d delta = muB - mu;
+    m2 += m2B + (delta.t() * delta) * (nA * nB / n);
+    mu += delta * (nB / n);
+    count += x.rows;
+}
+
+void StandardizedPCA::compute(const Accumulator& moments, float retainedVariance, const cv::Mat& columnWeights)
+{
+    computeFromMoments(moments, retainedVariance, 0, columnWeights);
+}
+
+void StandardizedPCA::compute(const Accumulator& moments, int maxComponents, const cv::Mat& columnWeights)
+{
+    computeFromMoments(moments, 0.f, maxComponents, columnWeights);
+}
+
+void StandardizedPCA::computeFromMoments(const Accumulator& moments, float retainedVariance, int maxComponents, const cv::Mat& columnWeights)
+{
+    m_transform.compute(moments, columnWeights);
+
+    // The covariance of the standardized data is D * (m2 / count) * D with D = diag(1 / sigma):
+    const int dim = moments.mu.cols;
+    const float* pSigma = m_transform.sigma.ptr<float>();
+    Eigen::MatrixXd covariance(dim, dim);
+    for (int i = 0; i < dim; i++)
+    {
+        for (int j = 0; j < dim; j++)
+        {
+            covariance(i, j) = moments.m2(i, j) / (double(moments.count) * pSigma[i] * pSigma[j]);
+        }
+    }
+
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(covariance); // ascending eigenvalues
+    const Eigen::VectorXd values = solver.eigenvalues().reverse().cwiseMax(0.0);
+
+    int components = (maxComponents > 0) ? std::min(maxComponents, dim) : dim;
+    if (retainedVariance > 0.f)
+    {
+        // Same selection as cv::PCA:
+        const double total = values.sum();
+        double energy = 0.0;
+        for (components = 0; components < dim; components++)
+        {
+            energy += values[components];
+            if ((energy / total) >= retainedVariance)
+            {
+                break;
+            }
+        }
+        components = std::min(std::max(2, components), dim);
+    }
+
+    m_pca = drishti::core::make_unique<cv::PCA>();
+    m_pca->mean = cv::Mat::zeros(1, dim, CV_32F); // standardized data is centered
+    m_pca->eigenvalues.create(components, 1, CV_32F);
+    m_pca->eigenvectors.create(components, dim, CV_32F);
+    for (int k = 0; k < components; k++)
+    {
+        m_pca->eigenvalues.at<float>(k) = float(values[k]);
+        for (int j = 0; j < dim; j++)
+        {
+            m_pca->eigenvectors.at<float>(k, j) = float(solver.eigenvectors()(j, dim - 1 - k));
+        }
+    }
+
+    init();
+}
+
+// ########### Randomized truncated SVD #############
+
+using MatrixRowMajorf = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+static Eigen::MatrixXf orthonormalize(const Eigen::MatrixXf& A)
+{
+    Eigen::HouseholderQR<Eigen::MatrixXf> qr(A);
+    return qr.householderQ() * Eigen::MatrixXf::Identity(A.rows(), A.cols());
+}
+
+void StandardizedPCA::computeRandomized(const cv::Mat& data, cv::Mat& projection, int maxComponents, const RandomizedOptions& options, const cv::Mat& columnWeights)
+{
+    m_transform.compute(data, columnWeights);
+    cv::Mat data_ = m_transform.standardize(data);
+    CV_Assert(data_.type() == CV_32F && data_.isContinuous());
+
+    const int n = data_.rows, dim = data_.cols;
+    const int components = std::min(std::max(maxComponents, 1), std::min(n, dim));
+    const int l = std::min(components + std::max(options.oversampling, 0), std::min(n, dim));
+
+    // The data is centered implicitly (Xc = X - 1 * mean) to avoid a copy:
+    const Eigen::Map<const MatrixRowMajorf> X(data_.ptr<float>(), n, dim);
+    const Eigen::RowVectorXf mean = X.colwise().mean();
+    const auto times = [&](const Eigen::MatrixXf& M) -> Eigen::MatrixXf { // Xc * M
+        return (X * M).rowwise() - (mean * M);
+    };
+    const auto transposeTimes = [&](const Eigen::MatrixXf& M) -> Eigen::MatrixXf { // Xc' * M
+        return (X.transpose() * M) - (mean.transpose() * M.colwise().sum());
+    };
+
+    cv::Mat1f omega(dim, l);
+    cv::RNG rng(options.seed);
+    rng.fill(omega, cv::RNG::NORMAL, 0.f, 1.f);
+    const Eigen::Map<const MatrixRowMajorf> Omega(omega.ptr<float>(), dim, l);
+
+    // Range finder with (re-orthonormalized) power iterations:
+    Eigen::MatrixXf Q = orthonormalize(times(Omega));
+    for (int i = 0; i < options.iterations; i++)
+    {
+        Q = orthonormalize(times(orthonormalize(transposeTimes(Q))));
+    }
+
+    // Small SVD of B = Q' * Xc (l x dim), the right singular vectors are the eigenvectors:
+    const Eigen::MatrixXd Bt = transposeTimes(Q).cast<double>();
+    Eigen::JacobiSVD<Eigen::MatrixXd> svd(Bt, Eigen::ComputeThinU);
+
+    m_pca = drishti::core::make_unique<cv::PCA>();
+    m_pca->mean.create(1, dim, CV_32F);
+    std::copy(mean.data(), mean.data() + dim, m_pca->mean.ptr<float>());
+    m_pca->eigenvalues.create(components, 1, CV_32F);
+    m_pca->eigenvectors.create(components, dim, CV_32F);
+    for (int k = 0; k < components; k++)
+    {
+        const double s = svd.singularValues()[k];
+        m_pca->eigenvalues.at<float>(k) = float(s * s / n); // cv::PCA scales the covariance by 1/n
+        for (int j = 0; j < dim; j++)
+        {
+            m_pca->eigenvectors.at<float>(k, j) = float(svd.matrixU()(j, k));
+        }
+    }
+
+    m_pca->project(data_, projection);
+
+    init();
+}
+
 void StandardizedPCA::init()
 {
     // Cache transposed vectors for faster multiplication:
@@ -237,4 +431,36 @@ cv::Mat StandardizedPCA::backProject(const cv::Mat& projection) const
     return result;
 }
 
+StandardizedPCA::BackProjection StandardizedPCA::getBackProjection() const
+{
+    // backProject() is affine in the coefficients, so it can be sampled at the origin and
+    // at each basis vector:
+    auto sample = [&](const cv::Mat1f& y) {
+        cv::Mat1f x;
+        backProject(y).reshape(1, 1).convertTo(x, CV_32F);
+        return x;
+    };
+
+    BackProjection result;
+    result.components = m_pca->eigenvectors.rows;
+
+    const cv::Mat1f origin = sample(cv::Mat1f::zeros(1, result.components));
+    result.dim = origin.cols;
+    result.offset_full.assign(origin.begin(), origin.end());
+
+    const cv::Mat1f truncated = sample(cv::Mat1f::zeros(1, 1));
+    result.offset.assign(truncated.begin(), truncated.end());
+
+    result.rows.resize(result.components * result.dim);
+    for (int i = 0; i < result.components; i++)
+    {
+        cv::Mat1f y = cv::Mat1f::zeros(1, result.components);
+        y(i) = 1.f;
+        const cv::Mat1f row = sample(y) - origin;
+        std::copy(row.begin(), row.end(), result.rows.begin() + (i * result.dim));
+    }
+
+    return result;
+}
+
 DRISHTI_ML_NAMESPACE_END
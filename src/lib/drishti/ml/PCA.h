@@ -13,16 +13,31 @@
 
 #include "drishti/core/drishti_core.h"
 #include "drishti/ml/drishti_ml.h"
+#include "drishti/core/MemoryUsage.h"
 
 #include <opencv2/core/core.hpp>
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 DRISHTI_ML_NAMESPACE_BEGIN
 
 class StandardizedPCA
 {
 public:
+    // Streaming moments for PCA over data that doesn't fit in memory: chunks of rows are merged
+    // into the mean and the centered cross products (in double precision), so memory is
+    // O(dim^2) regardless of the sample count:
+    struct Accumulator
+    {
+        void add(const cv::Mat& chunk);
+
+        int count = 0;
+        cv::Mat1d mu; // 1 x dim
+        cv::Mat1d m2; // dim x dim
+    };
+
     struct Standardizer
     {
         Standardizer();
@@ -30,8 +45,10 @@ public:
         ~Standardizer();
         void create(int size, int type);
         void compute(const cv::Mat& src, const cv::Mat &columnWeights={});
+        void compute(const Accumulator& moments, const cv::Mat& columnWeights = {});
         cv::Mat standardize(const cv::Mat& src) const;
         cv::Mat unstandardize(const cv::Mat& src) const;
+        static void divide(cv::Mat& sigma, const cv::Mat& columnWeights);
 
         cv::Mat mu, sigma;
 
@@ -39,16 +56,45 @@ public:
         void serialize(Archive& ar, const unsigned int version);
     };
 
+    // Truncated SVD via a randomized range finder (Halko et al.), for maxComponents << dim:
+    struct RandomizedOptions
+    {
+        int oversampling = 10; // extra random directions
+        int iterations = 2;    // power iterations (sharpen slowly decaying spectra)
+        std::uint64_t seed = 0;
+    };
+
     StandardizedPCA(); // null constructor for file loading
     ~StandardizedPCA();
     void compute(const cv::Mat& data, cv::Mat& projection, float retainedVariance, const cv::Mat &columnWeights={});
     void compute(const cv::Mat& data, cv::Mat& projection, int maxComponents, const cv::Mat &columnWeights={});
+    void compute(const Accumulator& moments, float retainedVariance, const cv::Mat& columnWeights = {});
+    void compute(const Accumulator& moments, int maxComponents, const cv::Mat& columnWeights = {});
+    void computeRandomized(const cv::Mat& data, cv::Mat& projection, int maxComponents, const RandomizedOptions& options = {}, const cv::Mat& columnWeights = {});
     void init();
 
     size_t getNumComponents() const;
 
+    // Heap bytes of the standardization, the basis and the transposed basis:
+    std::size_t getMemoryUsage() const;
+
     cv::Mat project(const cv::Mat& data, int n = 0) const;
     cv::Mat backProject(const cv::Mat& projection) const;
+
+    // Affine form of backProject() with the standardization folded in, such that the back
+    // projection of the leading n coefficients y is getOffset(n) + sum_i y[i] * getRow(i):
+    struct BackProjection
+    {
+        int components = 0;
+        int dim = 0;
+        std::vector<float> rows;        // components x dim (row major)
+        std::vector<float> offset;      // truncated (n < components)
+        std::vector<float> offset_full; // all components (includes the PCA mean)
+
+        const float* getRow(int i) const { return &rows[i * dim]; }
+        const float* getOffset(int n) const { return (n < components) ? offset.data() : offset_full.data(); }
+    };
+    BackProjection getBackProjection() const;
     const cv::Mat& getTransposedEigenvectors() const
     {
         return m_eT;
@@ -60,6 +106,8 @@ public:
     static void gemm_transpose(const cv::Mat& A, const cv::Mat& Bt, cv::Mat& result);
 
 protected:
+    void computeFromMoments(const Accumulator& moments, float retainedVariance, int maxComponents, const cv::Mat& columnWeights);
+
     Standardizer m_transform;
     std::unique_ptr<cv::PCA> m_pca;
 
@@ -0,0 +1,269 @@
+/*! -*-c++-*-
+  @file   ParallelObjectDetectorACF.cpp
+  @author David Hirvonen
+  @brief  Internal data parallel (scale band + tile) ACF object detector implementation.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/ml/ParallelObjectDetectorACF.h"
+#include "drishti/core/LazyParallelResource.h"
+#include "drishti/core/ParallelFor.h"
+#include "drishti/core/make_unique.h"
+
+#include <acf/ACF.h>
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+using DetectorPtr = std::shared_ptr<acf::Detector>;
+
+struct ParallelObjectDetectorACF::Impl
+{
+    Impl(const std::string& model, const std::string& hint, ExecutorPtr executor)
+        : model(model)
+        , hint(hint)
+        , executor(executor)
+        , detectors([this]() { return create(); })
+    {
+    }
+
+    DetectorPtr create() const
+    {
+        std::istringstream is(model);
+        auto detector = std::make_shared<acf::Detector>(is, hint);
+        detector->setDoNonMaximaSuppression(false); // merged and suppressed at the end
+        return detector;
+    }
+
+    std::string model; // serialized model (one copy per thread is deserialized on demand)
+    std::string hint;
+    ExecutorPtr executor;
+    core::ThreadLocalParallelResource<DetectorPtr> detectors;
+};
+
+// One octave of the pyramid computed from a downsampled image:
+struct Band
+{
+    MatP image;                // transposed planar input at the band resolution
+    cv::Size size;             // upright band size
+    cv::Point2f scale;         // band -> input (upright)
+    bool isFirst = false;      // includes the upsampled octaves (nOctUp)
+    bool isLast = false;       // all remaining octaves (original minDs)
+    acf::Detector::Pyramid P;
+};
+
+// One level crop (in channel units, upright) of one band:
+struct Tile
+{
+    int band;
+    int level;
+    cv::Rect roi;
+};
+
+static std::string readModel(std::istream& is)
+{
+    std::stringstream ss;
+    ss << is.rdbuf();
+    return ss.str();
+}
+
+ParallelObjectDetectorACF::ParallelObjectDetectorACF(const std::string& filename, ExecutorPtr executor)
+{
+    std::ifstream is(filename, std::ios::binary);
+    CV_Assert(is.good());
+    init(readModel(is), filename, executor); // the filename is the format hint
+}
+
+ParallelObjectDetectorACF::ParallelObjectDetectorACF(std::istream& is, const std::string& hint, ExecutorPtr executor)
+{
+    init(readModel(is), hint, executor);
+}
+
+ParallelObjectDetectorACF::~ParallelObjectDetectorACF() = default;
+
+void ParallelObjectDetectorACF::init(const std::string& model, const std::string& hint, ExecutorPtr executor)
+{
+    m_parallel = core::make_unique<Impl>(model, hint, executor);
+
+    // The main detector provides the options and window size (and ObjectDetectorACF access):
+    std::istringstream is(model);
+    m_impl = core::make_unique<acf::Detector>(is, hint);
+    m_impl->setDoNonMaximaSuppression(false);
+    m_modelBytes = model.size();
+}
+
+core::MemoryUsage ParallelObjectDetectorACF::memoryUsage() const
+{
+    const std::size_t modelBytes = m_parallel->model.size();
+    const std::size_t workers = m_parallel->detectors.getMap().size();
+
+    core::MemoryUsage usage;
+    usage.add("classifier", modelBytes);
+    usage.add("model", modelBytes);
+    usage.add("workers", modelBytes * workers);
+    return usage;
+}
+
+acf::Detector& ParallelObjectDetectorACF::getWorkerDetector()
+{
+    return *m_parallel->detectors.get();
+}
+
+int ParallelObjectDetectorACF::operator()(const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>* scores)
+{
+    // Same input format as the MatP path of the FaceDetector: transposed planar RGB in [0,1]
+    CV_Assert(image.type() == CV_8UC3);
+    MatP planar;
+    getPlanar(image, planar);
+    return (*this)(planar, objects, scores);
+}
+
+int ParallelObjectDetectorACF::operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores)
+{
+    core::Executor* executor = m_parallel->executor.get();
+
+    const auto& pPyramid = m_impl->opts.pPyramid;
+    const cv::Size minDs = pPyramid->minDs.get();
+    const int nOctUp = pPyramid->nOctUp.get();
+    const cv::Size winSize = m_impl->getWindowSize();
+
+    // ### Scale bands (one octave each, the last one takes all remaining octaves) ###
+    const auto& planes = image.get();
+    const cv::Size size(planes[0].rows, planes[0].cols); // upright
+    const int minSize = std::min(size.width, size.height);
+    const int octaves = int(std::floor(std::log2(float(minSize) / float(std::max(std::max(minDs.width, minDs.height), 1)))));
+    const int bandCount = std::max(1, std::min(m_maxBands, octaves));
+
+    std::vector<Band> bands(bandCount);
+    core::parallel_for(executor, bandCount, [&](int i) {
+        auto& band = bands[i];
+        band.isFirst = (i == 0);
+        band.isLast = (i == (bandCount - 1));
+
+        const float s = std::ldexp(1.f, -i);
+        band.size = cv::Size(std::max(int(size.width * s + 0.5f), 1), std::max(int(size.height * s + 0.5f), 1));
+        band.scale = { float(size.width) / band.size.width, float(size.height) / band.size.height };
+
+        if (i == 0)
+        {
+            band.image = image;
+        }
+        else
+        {
+            band.image = MatP(cv::Size(band.size.height, band.size.width), planes[0].depth(), int(planes.size()));
+            auto& resized = band.image.get();
+            for (int j = 0; j < planes.size(); j++)
+            {
+                cv::resize(planes[j], resized[j], resized[j].size(), 0, 0, cv::INTER_AREA);
+            }
+        }
+
+        acf::Detector& detector = getWorkerDetector();
+        auto& options = detector.opts.pPyramid;
+        options->nOctUp = band.isFirst ? nOctUp : 0;
+        if (band.isLast)
+        {
+            options->minDs = minDs;
+        }
+        else
+        {
+            // Stop just before the next octave, which the next band computes at its own resolution:
+            const int m = std::min(band.size.width, band.size.height) / 2 + 1;
+            options->minDs = cv::Size(std::max(m, minDs.width), std::max(m, minDs.height));
+        }
+        detector.computePyramid(band.image, band.P);
+    });
+
+    // ### Tiles (overlapping by one window, so each window position is inside a tile) ###
+    const cv::Size win((winSize.width + 3) / 4, (winSize.height + 3) / 4); // channel units
+    const cv::Size tileSize(std::max(m_tileSize.width, win.width * 2), std::max(m_tileSize.height, win.height * 2));
+    const cv::Point step(tileSize.width - win.width, tileSize.height - win.height);
+
+    std::vector<Tile> tiles;
+    for (int i = 0; i < bandCount; i++)
+    {
+        const auto& P = bands[i].P;
+        for (int j = 0; j < P.nScales; j++)
+        {
+            const cv::Mat& channel = P.data[j][0][0];
+            const cv::Size levelSize(channel.rows, channel.cols); // upright
+            if ((levelSize.width < win.width) || (levelSize.height < win.height))
+            {
+                continue;
+            }
+
+            for (int y = 0; y < levelSize.height; y += step.y)
+            {
+                for (int x = 0; x < levelSize.width; x += step.x)
+                {
+                    const cv::Rect roi = cv::Rect({ x, y }, tileSize) & cv::Rect({ 0, 0 }, levelSize);
+                    if ((roi.width >= win.width) && (roi.height >= win.height))
+                    {
+                        tiles.push_back({ i, j, roi });
+                    }
+                    if ((x + tileSize.width) >= levelSize.width)
+                    {
+                        break;
+                    }
+                }
+                if ((y + tileSize.height) >= levelSize.height)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<Detections> results(tiles.size());
+    core::parallel_for(executor, int(tiles.size()), [&](int i) {
+        const auto& tile = tiles[i];
+        const auto& band = bands[tile.band];
+        const auto& P = band.P;
+
+        // Transposed (col-major) channels: rows ~ x, cols ~ y
+        const auto& channels = P.data[tile.level][0].get();
+        const cv::Rect crop(tile.roi.y, tile.roi.x, tile.roi.height, tile.roi.width);
+
+        std::vector<cv::Mat> cropped(channels.size());
+        for (int j = 0; j < channels.size(); j++)
+        {
+            cropped[j] = channels[j](crop);
+        }
+        cv::Mat interleaved;
+        cv::merge(cropped, interleaved);
+
+        acf::Detector::Pyramid Pi = P;
+        Pi.nScales = 1;
+        Pi.data = { { MatP(interleaved) } };
+        Pi.scales = { P.scales[tile.level] };
+        Pi.scaleshw = { P.scaleshw[tile.level] };
+
+        auto& result = results[i];
+        getWorkerDetector()(Pi, result.objects, &result.scores);
+
+        // Tile -> band -> input coordinates:
+        const float sx = float(channels[0].rows) / float(band.size.width);
+        const float sy = float(channels[0].cols) / float(band.size.height);
+        const cv::Point2f offset(tile.roi.x / sx, tile.roi.y / sy);
+        for (auto& object : result.objects)
+        {
+            const cv::Point2f tl = (cv::Point2f(object.tl()) + offset), br = (cv::Point2f(object.br()) + offset);
+            object = cv::Rect(cv::Point(int(tl.x * band.scale.x + 0.5f), int(tl.y * band.scale.y + 0.5f)),
+                cv::Point(int(br.x * band.scale.x + 0.5f), int(br.y * band.scale.y + 0.5f)));
+        }
+    });
+
+    // ### Deterministic merge: task order, then (score, rect) ###
+    return merge(results, objects, scores);
+}
+
+DRISHTI_ML_NAMESPACE_END
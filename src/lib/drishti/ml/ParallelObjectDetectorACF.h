@@ -0,0 +1,76 @@
+/*! -*-c++-*-
+  @file   ParallelObjectDetectorACF.h
+  @author David Hirvonen
+  @brief  Internal data parallel (scale band + tile) ACF object detector declaration.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_ml_ParallelObjectDetectorACF_h__
+#define __drishti_ml_ParallelObjectDetectorACF_h__
+
+#include "drishti/ml/ObjectDetectorACF.h"
+#include "drishti/core/Executor.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+/*
+ * Single image CPU detection split into tasks on an Executor, for large still images
+ * (e.g., server side photo ingestion) where latency should scale with the core count:
+ *
+ * 1) Pyramid construction: one task per octave (scale band).  Each band downsamples the
+ *    input and computes only its own octave of the pyramid (the band's minDs stops the
+ *    pyramid after one octave), so the real + approximated levels match the full pyramid.
+ * 2) Window scanning: each level of each band is cut into overlapping tiles (the overlap
+ *    is one detection window) and every tile is one task.
+ * 3) The detections are merged in task order, sorted by (score, rect), de-duplicated and
+ *    suppressed (see ObjectDetector::suppress), so the result doesn't depend on scheduling.
+ *
+ * acf::Detector isn't reentrant: every thread deserializes its own copy of the model.
+ * Input conventions are the same as ObjectDetectorACF (MatP: transposed planar channels).
+ */
+
+class ParallelObjectDetectorACF : public ObjectDetectorACF
+{
+public:
+    using ExecutorPtr = std::shared_ptr<core::Executor>;
+
+    ParallelObjectDetectorACF(const std::string& filename, ExecutorPtr executor = core::Executor::getInstance());
+    ParallelObjectDetectorACF(std::istream& is, const std::string& hint = {}, ExecutorPtr executor = core::Executor::getInstance());
+    virtual ~ParallelObjectDetectorACF();
+
+    virtual int operator()(const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = 0);
+    virtual int operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = 0);
+
+    // Includes the serialized model and the per thread detectors created so far:
+    virtual core::MemoryUsage memoryUsage() const;
+
+    // Tile size (upright width x height) in channel units (i.e., pixels / 4) at each level:
+    void setTileSize(const cv::Size& size) { m_tileSize = size; }
+    const cv::Size& getTileSize() const { return m_tileSize; }
+
+    // Upper bound on the scale bands (the smallest octaves are always one band):
+    void setMaxBands(int bands) { m_maxBands = bands; }
+    int getMaxBands() const { return m_maxBands; }
+
+protected:
+    struct Impl;
+
+    void init(const std::string& model, const std::string& hint, ExecutorPtr executor);
+    acf::Detector& getWorkerDetector();
+
+    std::unique_ptr<Impl> m_parallel;
+
+    cv::Size m_tileSize = { 64, 64 };
+    int m_maxBands = 8;
+};
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // __drishti_ml_ParallelObjectDetectorACF_h__
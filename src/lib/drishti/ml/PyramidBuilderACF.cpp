@@ -0,0 +1,136 @@
+/*! -*-c++-*-
+  @file   PyramidBuilderACF.cpp
+  @author David Hirvonen
+  @brief  Internal batch ACF pyramid builder with per size plans and reusable buffers.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/ml/PyramidBuilderACF.h"
+#include "drishti/ml/ObjectDetectorACF.h"
+#include "drishti/core/make_unique.h"
+
+#include <future>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+PyramidBuilderACF::PyramidBuilderACF(acf::Detector* detector, ExecutorPtr executor)
+    : m_detector(detector)
+    , m_executor(executor)
+{
+    CV_Assert(m_detector);
+}
+
+const PyramidBuilderACF::Plan& PyramidBuilderACF::getPlan(const cv::Size& size)
+{
+    auto& plan = m_plans[{ size.width, size.height }];
+    if (!plan)
+    {
+        plan = core::make_unique<Plan>();
+        plan->size = size;
+
+        // ACF implementation uses transposed images (rows ~ x):
+        cv::Mat I(size.width, size.height, CV_32FC3, cv::Scalar::all(0));
+        m_detector->computePyramid(MatP(I), plan->layout);
+
+        plan->levels.resize(plan->layout.nScales);
+        for (int i = 0; i < plan->layout.nScales; i++)
+        {
+            const cv::Mat& channel = plan->layout.data[i][0][0];
+            plan->levels[i] = { channel.rows, channel.cols };
+        }
+    }
+    return *plan;
+}
+
+// Same format as the face tool Resizer: transposed planar float RGB in [0,1]
+void PyramidBuilderACF::convert(const cv::Mat& image, Slot& slot)
+{
+    CV_Assert((image.type() == CV_8UC3) || (image.type() == CV_32FC3));
+
+    // All outputs keep their buffers when the size doesn't change:
+    if (image.depth() == CV_8U)
+    {
+        ObjectDetectorACF::getPlanar(image, slot.planar, false, &slot.transposed);
+        return;
+    }
+
+    cv::transpose(image, slot.transposed);
+    cv::split(slot.transposed, slot.channels);
+
+    const cv::Size size = slot.transposed.size();
+    if (slot.planar.get().size() != 3 || (slot.planar[0].size() != size))
+    {
+        slot.planar = MatP(size, CV_32F, 3);
+    }
+
+    auto& planes = slot.planar.get();
+    for (int i = 0; i < 3; i++)
+    {
+        slot.channels[i].copyTo(planes[i]);
+    }
+}
+
+void PyramidBuilderACF::operator()(const cv::Mat& image, Pyramid& P)
+{
+    getPlan(image.size());
+    convert(image, m_slots[0]);
+    m_detector->computePyramid(m_slots[0].planar, P);
+}
+
+void PyramidBuilderACF::operator()(const std::vector<cv::Mat>& images, std::vector<Pyramid>& pyramids)
+{
+    pyramids.resize(images.size());
+    if (images.empty())
+    {
+        return;
+    }
+
+    const cv::Size size = images.front().size();
+    for (const auto& image : images)
+    {
+        CV_Assert(image.size() == size);
+    }
+    getPlan(size);
+
+    // Two stage pipeline: convert(i + 1) || computePyramid(i)
+    convert(images[0], m_slots[0]);
+    for (std::size_t i = 0; i < images.size(); i++)
+    {
+        const bool hasNext = ((i + 1) < images.size());
+        Slot& current = m_slots[i % 2];
+        Slot& next = m_slots[(i + 1) % 2];
+
+        std::future<void> converted;
+        if (hasNext && m_executor)
+        {
+            converted = m_executor->process([&]() { convert(images[i + 1], next); });
+        }
+
+        try
+        {
+            m_detector->computePyramid(current.planar, pyramids[i]);
+        }
+        catch (...)
+        {
+            if (converted.valid())
+            {
+                converted.wait(); // the task references next
+            }
+            throw;
+        }
+
+        if (converted.valid())
+        {
+            converted.get();
+        }
+        else if (hasNext)
+        {
+            convert(images[i + 1], next);
+        }
+    }
+}
+
+DRISHTI_ML_NAMESPACE_END
@@ -0,0 +1,87 @@
+/*! -*-c++-*-
+  @file   PyramidBuilderACF.h
+  @author David Hirvonen
+  @brief  Internal batch ACF pyramid builder with per size plans and reusable buffers.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_ml_PyramidBuilderACF_h__
+#define __drishti_ml_PyramidBuilderACF_h__
+
+#include "drishti/ml/drishti_ml.h"
+#include "drishti/core/Executor.h"
+
+#include <acf/ACF.h>
+
+#include <opencv2/core.hpp>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+/*
+ * Builds acf::Detector pyramids for batches of same size images (e.g., video frames or
+ * photo collections in the batch tools):
+ *
+ * - The pyramid layout (scales, level sizes) is learned once per input size (the plan),
+ *   instead of running computePyramid() on a dummy image whenever the geometry is needed.
+ * - The input conversion (upright RGB -> transposed planar float, see Resizer) goes through
+ *   two persistent slots, so a batch allocates no new input planes after the first image.
+ * - With an executor, the conversion of image i+1 overlaps the pyramid of image i, and the
+ *   output pyramids are reused across calls with the same batch size.
+ *
+ * The detector is a weak reference and isn't reentrant: one builder per detector.
+ */
+
+class PyramidBuilderACF
+{
+public:
+    using Pyramid = acf::Detector::Pyramid;
+    using ExecutorPtr = std::shared_ptr<core::Executor>;
+
+    struct Plan
+    {
+        cv::Size size;                // upright input size
+        Pyramid layout;               // pyramid of a black image (scales, scaleshw, level sizes)
+        std::vector<cv::Size> levels; // upright channel size of each level
+    };
+
+    PyramidBuilderACF(acf::Detector* detector, ExecutorPtr executor = {});
+
+    // Layout for an upright input size (computed on the first request):
+    const Plan& getPlan(const cv::Size& size);
+
+    // Upright RGB (CV_8UC3 in [0,255] or CV_32FC3 in [0,1]):
+    void operator()(const cv::Mat& image, Pyramid& P);
+
+    // Batch of same size images, pyramids[i] is the pyramid of images[i]:
+    void operator()(const std::vector<cv::Mat>& images, std::vector<Pyramid>& pyramids);
+
+    std::size_t getPlanCount() const { return m_plans.size(); }
+
+protected:
+    struct Slot
+    {
+        cv::Mat transposed;
+        std::vector<cv::Mat> channels;
+        MatP planar;
+    };
+
+    void convert(const cv::Mat& image, Slot& slot);
+
+    acf::Detector* m_detector = nullptr;
+    ExecutorPtr m_executor;
+
+    std::map<std::pair<int, int>, std::unique_ptr<Plan>> m_plans;
+    std::array<Slot, 2> m_slots;
+};
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // __drishti_ml_PyramidBuilderACF_h__
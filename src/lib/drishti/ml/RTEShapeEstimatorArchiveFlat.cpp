@@ -0,0 +1,145 @@
+/*! -*-c++-*-
+  @file   RTEShapeEstimatorArchiveFlat.cpp
+  @author David Hirvonen
+  @brief  Flat (memory mappable) archive format for the regression tree ensemble.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The packed forests (splits and leaves) are stored as flat arrays and used in place, the
+  remaining members (initial shape, pose indexing, PCA, ...) are small and are stored as a
+  single portable binary cereal blob.  The cereal formats remain the export source.
+
+*/
+
+#include "drishti/ml/drishti_ml.h"
+#include "drishti/core/drishti_stdlib_string.h"
+#include "drishti/ml/RTEShapeEstimatorImpl.h"
+#include "drishti/core/drishti_cvmat_cereal.h"
+#include "drishti/core/drishti_pca_cereal.h"
+#include "drishti/core/drishti_cereal_pba.h"
+#include "drishti/core/FlatArchive.h"
+#include "drishti/core/ThrowAssert.h"
+
+#include <sstream>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+static std::string getName(std::size_t forest, const char* array)
+{
+    return "forest/" + std::to_string(forest) + "/" + array;
+}
+
+template <typename T>
+static void addArray(drishti::core::FlatArchiveWriter& archive, const std::string& name, const T* data, std::size_t count)
+{
+    if (data)
+    {
+        archive.add(name, data, count);
+    }
+}
+
+template <typename T>
+static const T* getArray(const drishti::core::FlatArchive& archive, const std::string& name, std::size_t expected)
+{
+    std::size_t count = 0;
+    const T* data = archive.has(name) ? archive.get<T>(name, count) : nullptr;
+    drishti_throw_assert(!data || (count == expected), "Incorrect array size for " << name);
+    return data;
+}
+
+void save_flat(const shape_predictor& sp, drishti::core::FlatArchiveWriter& archive)
+{
+    drishti_throw_assert(sp.packed_forests.size() == sp.forests.size(), "Flat export requires packed forests (see shape_predictor::pack())");
+
+    // Everything but the leaves, using the quantized (packed forest) layout of the cereal format:
+    shape_predictor meta;
+    meta.initial_shape = sp.initial_shape;
+    meta.m_leaf_bits = 16;
+    meta.anchor_idx = sp.anchor_idx;
+    meta.deltas = sp.deltas;
+    meta.pose_tables = sp.pose_tables;
+    meta.m_pca = sp.m_pca;
+    meta.m_npd = sp.m_npd;
+    meta.m_do_affine = sp.m_do_affine;
+    meta.m_ellipse_count = sp.m_ellipse_count;
+    meta.interpolated_features = sp.interpolated_features;
+    meta.cascade_levels = sp.cascade_levels;
+    meta.m_landmarks = sp.m_landmarks;
+    meta.m_landmark_outputs = sp.m_landmark_outputs;
+
+    for (std::size_t i = 0; i < sp.packed_forests.size(); i++)
+    {
+        const auto& forest = sp.packed_forests[i];
+        drishti_throw_assert(!forest.empty(), "Flat export doesn't support ragged forests");
+
+        impl::packed_forest header;
+        header.num_trees = forest.num_trees;
+        header.num_splits = forest.num_splits;
+        header.num_leaves = forest.num_leaves;
+        header.leaf_dim = forest.leaf_dim;
+        header.leaf_stride = forest.leaf_stride;
+        header.leaf_stride_16 = forest.leaf_stride_16;
+        header.fraction_bits = forest.fraction_bits;
+        meta.packed_forests.push_back(header);
+
+        const std::size_t leaves = forest.num_trees * forest.num_leaves;
+        addArray(archive, getName(i, "splits"), forest.get_splits(), forest.num_trees * forest.num_splits);
+        addArray(archive, getName(i, "leaves"), forest.get_leaves(), leaves * forest.leaf_stride);
+        addArray(archive, getName(i, "leaves_16"), forest.get_leaves_16(), leaves * forest.leaf_stride_16);
+        addArray(archive, getName(i, "leaves_8"), forest.get_leaves_8(), leaves * forest.leaf_stride_16);
+        addArray(archive, getName(i, "tree_scales"), forest.get_tree_scales(), forest.num_trees);
+    }
+
+    std::stringstream ss;
+    save_cpb(ss, meta);
+    archive.addString("shape_predictor", ss.str());
+    archive.addScalar("leaf_bits", std::int32_t(sp.m_leaf_bits));
+}
+
+void load_flat(shape_predictor& sp, const std::shared_ptr<const drishti::core::FlatArchive>& archive)
+{
+    std::istringstream is(archive->getString("shape_predictor"));
+    load_cpb(is, sp);
+    sp.m_leaf_bits = archive->getScalar<std::int32_t>("leaf_bits");
+
+    for (std::size_t i = 0; i < sp.packed_forests.size(); i++)
+    {
+        auto& forest = sp.packed_forests[i];
+        const std::size_t leaves = forest.num_trees * forest.num_leaves;
+
+        auto& mapped = forest.mapped;
+        mapped.storage = archive;
+        mapped.splits = getArray<impl::split_feature>(*archive, getName(i, "splits"), forest.num_trees * forest.num_splits);
+        mapped.leaves = getArray<float>(*archive, getName(i, "leaves"), leaves * forest.leaf_stride);
+        mapped.leaves_16 = getArray<int16_t>(*archive, getName(i, "leaves_16"), leaves * forest.leaf_stride_16);
+        mapped.leaves_8 = getArray<int8_t>(*archive, getName(i, "leaves_8"), leaves * forest.leaf_stride_16);
+        mapped.tree_scales = getArray<float>(*archive, getName(i, "tree_scales"), forest.num_trees);
+
+        drishti_throw_assert(mapped.splits || !forest.num_splits, "Missing splits for forest " << i);
+        drishti_throw_assert(mapped.leaves || mapped.leaves_16 || mapped.leaves_8, "Missing leaves for forest " << i);
+        drishti_throw_assert(!mapped.leaves_8 || mapped.tree_scales, "Missing tree scales for forest " << i);
+    }
+
+    sp.pack(); // back projection and workers, mapped forests are used as is
+}
+
+// ############################
+// ### RTEShapeEstimator IO ###
+// ############################
+
+void RTEShapeEstimator::saveFlat(std::ostream& os) const
+{
+    drishti::core::FlatArchiveWriter archive;
+    save_flat(*m_impl->m_predictor, archive);
+    archive.save(os);
+}
+
+void RTEShapeEstimator::saveFlat(const std::string& filename) const
+{
+    drishti::core::FlatArchiveWriter archive;
+    save_flat(*m_impl->m_predictor, archive);
+    archive.save(filename);
+}
+
+DRISHTI_ML_NAMESPACE_END
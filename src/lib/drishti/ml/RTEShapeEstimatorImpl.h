@@ -25,8 +25,12 @@ public:
     Impl();
     Impl(const std::string& filename);
     Impl(std::istream& is, const std::string& hint = {});
+    Impl(const std::shared_ptr<const drishti::core::FlatArchive>& archive);
+    Impl(const Impl&) = default; // shares the predictor, see RegressionTreeEnsembleShapeEstimator::clone()
     ~Impl();
 
+    void load(std::istream& is); // raw, flat or compressed
+
     void packPointsInShape(const std::vector<cv::Point2f>& points, int ellipseCount, float* shape) const
     {
         // Copy initial chunk of 2d points
@@ -41,10 +45,81 @@ public:
         }
     }
 
-    int operator()(const cv::Mat& crop, std::vector<cv::Point2f>& points, std::vector<bool>& mask) const
+    ShapeEstimator::Context getContext() const
+    {
+        ShapeEstimator::Context context;
+        context.stages = m_stagesHint;
+        context.convergence = m_convergenceThreshold;
+        context.sampler = m_sampler;
+        return context;
+    }
+
+    int operator()(const cv::Mat& crop, std::vector<cv::Point2f>& points, std::vector<bool>& mask, const ShapeEstimator::Context& context) const
+    {
+        return (*this)(crop, { { 0, 0 }, crop.size() }, points, mask, context);
+    }
+
+    // The roi may extend beyond the image: pixel samples outside the image read as zero, which
+    // is a virtual border equivalent to a zero padded crop.  Points are in image coordinates.
+    int operator()(const cv::Mat& image, const cv::Rect& roi, std::vector<cv::Point2f>& points, std::vector<bool>& mask, const ShapeEstimator::Context& context) const
+    {
+        if (context.sampler)
+        {
+            return estimate(impl::sampled_image{ &context.sampler }, roi, points, mask, context);
+        }
+
+        CV_Assert(image.type() == CV_8UC1);
+
+        // Zero copy cv::Mat wrapper:
+        return estimate(dlib::cv_image<uint8_t>(image), roi, points, mask, context);
+    }
+
+    // Coarse-to-fine estimates read the pyramid levels recorded in the model, an external sampler
+    // or a full resolution model only reads the image:
+    int estimatePyramid(const std::vector<cv::Mat>& pyramid, const cv::Rect& roi, std::vector<cv::Point2f>& points, std::vector<bool>& mask, const ShapeEstimator::Context& context) const
     {
-        CV_Assert(crop.type() == CV_8UC1);
+        if (context.sampler || (pyramid.size() < 2) || (m_predictor->num_levels() < 2))
+        {
+            return (*this)(pyramid.front(), roi, points, mask, context);
+        }
+        return estimate(wrap(pyramid), roi, points, mask, context);
+    }
 
+    int estimatePyramidBatch(const std::vector<cv::Mat>& pyramid, const std::vector<cv::Rect>& regions, std::vector<std::vector<cv::Point2f>>& points, std::vector<std::vector<bool>>& masks, bool doParallel) const
+    {
+        if (m_sampler || (pyramid.size() < 2) || (m_predictor->num_levels() < 2))
+        {
+            return estimateBatch(pyramid.front(), regions, points, masks, doParallel);
+        }
+
+        std::vector<dlib::rectangle> rois;
+        rois.reserve(regions.size());
+        for (const auto& roi : regions)
+        {
+            rois.push_back(dlib_rect(roi));
+        }
+
+        // All regions share one zero copy wrapper of the pyramid:
+        std::vector<impl::image_pyramid<dlib::cv_image<uint8_t>>> images(regions.size(), wrap(pyramid));
+        return estimateBatch(images, rois, points, masks, doParallel);
+    }
+
+    // Zero copy wrapper of the pyramid levels:
+    static impl::image_pyramid<dlib::cv_image<uint8_t>> wrap(const std::vector<cv::Mat>& pyramid)
+    {
+        impl::image_pyramid<dlib::cv_image<uint8_t>> result;
+        result.levels.reserve(pyramid.size());
+        for (const auto& level : pyramid)
+        {
+            CV_Assert(level.type() == CV_8UC1);
+            result.levels.emplace_back(level);
+        }
+        return result;
+    }
+
+    template <typename image_type>
+    int estimate(const image_type& img, const cv::Rect& roi, std::vector<cv::Point2f>& points, std::vector<bool>& mask, const ShapeEstimator::Context& context) const
+    {
         auto& sp = *m_predictor;
 
         fshape initial_shape = sp.initial_shape;
@@ -55,10 +130,7 @@ public:
             packPointsInShape(points, m_predictor->m_ellipse_count, &initial_shape(0, 0));
         }
 
-        // Zero copy cv::Mat wrapper:
-        auto img = dlib::cv_image<uint8_t>(crop);
-        dlib::rectangle roi(0, 0, crop.cols, crop.rows);
-        dlib::full_object_detection shape = (*m_predictor)(img, roi, initial_shape, m_stagesHint);
+        dlib::full_object_detection shape = sp(img, dlib_rect(roi), initial_shape, context.stages, context.convergence);
 
         points.clear();
         points.reserve(initial_shape.size() / 2);
@@ -71,6 +143,85 @@ public:
         return int(points.size());
     }
 
+    int estimateBatch(const std::vector<cv::Mat>& crops, std::vector<std::vector<cv::Point2f>>& points, std::vector<std::vector<bool>>& masks, bool doParallel) const
+    {
+        std::vector<dlib::cv_image<uint8_t>> images;
+        std::vector<dlib::rectangle> rois;
+        images.reserve(crops.size());
+        rois.reserve(crops.size());
+        for (const auto& crop : crops)
+        {
+            CV_Assert(crop.type() == CV_8UC1);
+
+            // Zero copy cv::Mat wrapper:
+            images.emplace_back(crop);
+            rois.push_back(dlib_rect({ { 0, 0 }, crop.size() }));
+        }
+        return estimateBatch(images, rois, points, masks, doParallel);
+    }
+
+    int estimateBatch(const cv::Mat& image, const std::vector<cv::Rect>& regions, std::vector<std::vector<cv::Point2f>>& points, std::vector<std::vector<bool>>& masks, bool doParallel) const
+    {
+        std::vector<dlib::rectangle> rois;
+        rois.reserve(regions.size());
+        for (const auto& roi : regions)
+        {
+            rois.push_back(dlib_rect(roi));
+        }
+
+        if (m_sampler)
+        {
+            std::vector<impl::sampled_image> images(regions.size(), impl::sampled_image{ &m_sampler });
+            return estimateBatch(images, rois, points, masks, doParallel);
+        }
+
+        CV_Assert(image.type() == CV_8UC1);
+
+        // All regions share one zero copy wrapper of the full image:
+        std::vector<dlib::cv_image<uint8_t>> images(regions.size(), dlib::cv_image<uint8_t>(image));
+        return estimateBatch(images, rois, points, masks, doParallel);
+    }
+
+    template <typename image_type>
+    int estimateBatch(const std::vector<image_type>& images, const std::vector<dlib::rectangle>& rois, std::vector<std::vector<cv::Point2f>>& points, std::vector<std::vector<bool>>& masks, bool doParallel) const
+    {
+        auto& sp = *m_predictor;
+
+        points.resize(images.size());
+        masks.resize(images.size());
+
+        std::vector<fshape> initial_shapes(images.size(), sp.initial_shape);
+        for (std::size_t i = 0; i < images.size(); i++)
+        {
+            int paramCount = (points[i].size() * 2) - (m_predictor->m_ellipse_count * 5);
+            if (paramCount == initial_shapes[i].size())
+            {
+                packPointsInShape(points[i], m_predictor->m_ellipse_count, &initial_shapes[i](0, 0));
+            }
+        }
+
+        const auto shapes = sp(images, rois, initial_shapes, m_stagesHint, doParallel, m_convergenceThreshold);
+        for (std::size_t i = 0; i < shapes.size(); i++)
+        {
+            points[i].clear();
+            points[i].reserve(shapes[i].num_parts());
+            masks[i].clear();
+            for (int j = 0; j < shapes[i].num_parts(); j++)
+            {
+                points[i].push_back(cv_point(shapes[i].part(j)));
+                masks[i].push_back(true);
+            }
+        }
+
+        return int(shapes.size());
+    }
+
+    // Same (exclusive) right and bottom convention as the crop based estimates:
+    static dlib::rectangle dlib_rect(const cv::Rect& roi)
+    {
+        return dlib::rectangle(roi.x, roi.y, roi.x + roi.width, roi.y + roi.height);
+    }
+
     void setStagesHint(int stages)
     {
         m_stagesHint = stages;
@@ -81,6 +232,16 @@ public:
         return m_stagesHint;
     }
 
+    void setConvergenceThreshold(float threshold)
+    {
+        m_convergenceThreshold = threshold;
+    }
+
+    float getConvergenceThreshold() const
+    {
+        return m_convergenceThreshold;
+    }
+
     // {{p[0].x, p[0].y}, ..., {p[n].x,p[n.y}, {phi0[0],0}, {phi0[1],0} {phi0[2],0}, {phi0[3],0}, {phi0[4],0}}...
     std::vector<cv::Point2f> getMeanShape() const
     {
@@ -106,15 +267,31 @@ public:
         }
     }
 
+    // The predictor is archived as std::unique_ptr<> (the original format) and shared after loading:
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version)
     {
-        ar& m_predictor;
-
         if (Archive::is_loading::value)
         {
-            m_predictor->populate_f16();
+            std::unique_ptr<_SHAPE_PREDICTOR> ptr;
+            ar& ptr;
+            ptr->populate_f16();
+            m_predictor = std::move(ptr);
         }
+        else
+        {
+            struct NoDelete
+            {
+                void operator()(_SHAPE_PREDICTOR*) const {}
+            };
+            std::unique_ptr<_SHAPE_PREDICTOR, NoDelete> ptr(m_predictor.get());
+            ar& ptr;
+        }
+    }
+
+    core::MemoryUsage memoryUsage() const
+    {
+        return m_predictor ? m_predictor->memory_usage() : core::MemoryUsage();
     }
 
     bool isPCA() const
@@ -124,8 +301,10 @@ public:
 
     int m_inits = 1;
     int m_stagesHint = std::numeric_limits<int>::max();
+    float m_convergenceThreshold = 0.f;
+    ShapeEstimator::Sampler m_sampler; // see ShapeEstimator::setFeatureSampler()
 
-    std::unique_ptr<_SHAPE_PREDICTOR> m_predictor;
+    std::shared_ptr<_SHAPE_PREDICTOR> m_predictor; // read only, shared by clones
 
     std::shared_ptr<spdlog::logger> m_streamLogger;
 };
@@ -28,12 +28,50 @@ RTEShapeEstimator::Impl::~Impl() = default;
 
 RTEShapeEstimator::Impl::Impl(const std::string& filename)
 {
-    m_predictor = make_unique_cpb<_SHAPE_PREDICTOR>(filename);
+    if (drishti::core::isCompressed(filename))
+    {
+        std::ifstream is(filename, std::ios::binary);
+        load(is);
+    }
+    else if (drishti::core::FlatArchive::isFlat(filename))
+    {
+        m_predictor = std::make_shared<_SHAPE_PREDICTOR>();
+        load_flat(*m_predictor, drishti::core::FlatArchive::map(filename));
+    }
+    else
+    {
+        m_predictor = make_unique_cpb<_SHAPE_PREDICTOR>(filename);
+    }
 }
 
 RTEShapeEstimator::Impl::Impl(std::istream& is, const std::string& /*hint*/)
 {
-    m_predictor = make_unique_cpb<_SHAPE_PREDICTOR>(is);
+    load(is);
+}
+
+// Flat archives are copied from the stream (use an uncompressed file to map them in place):
+void RTEShapeEstimator::Impl::load(std::istream& is)
+{
+    if (drishti::core::isCompressed(is))
+    {
+        drishti::core::CompressedInputStream cis(is);
+        load(cis);
+    }
+    else if (drishti::core::FlatArchive::isFlat(is))
+    {
+        m_predictor = std::make_shared<_SHAPE_PREDICTOR>();
+        load_flat(*m_predictor, drishti::core::FlatArchive::read(is));
+    }
+    else
+    {
+        m_predictor = make_unique_cpb<_SHAPE_PREDICTOR>(is);
+    }
+}
+
+RTEShapeEstimator::Impl::Impl(const std::shared_ptr<const drishti::core::FlatArchive>& archive)
+{
+    m_predictor = std::make_shared<_SHAPE_PREDICTOR>();
+    load_flat(*m_predictor, archive);
 }
 
 // ############################################
@@ -53,6 +91,22 @@ RTEShapeEstimator::RegressionTreeEnsembleShapeEstimator(std::istream& is, const
     m_impl = drishti::core::make_unique<Impl>(is, hint);
 }
 
+RTEShapeEstimator::RegressionTreeEnsembleShapeEstimator(const std::shared_ptr<const drishti::core::FlatArchive>& archive)
+{
+    m_impl = drishti::core::make_unique<Impl>(archive);
+}
+
+std::unique_ptr<ShapeEstimator> RTEShapeEstimator::clone() const
+{
+    auto estimator = drishti::core::make_unique<RTEShapeEstimator>();
+    if (m_impl)
+    {
+        estimator->m_impl = drishti::core::make_unique<Impl>(*m_impl);
+    }
+    estimator->m_streamLogger = m_streamLogger;
+    return std::move(estimator);
+}
+
 void RTEShapeEstimator::setStreamLogger(std::shared_ptr<spdlog::logger>& logger)
 {
     m_streamLogger = logger;
@@ -72,9 +126,74 @@ int RTEShapeEstimator::getStagesHint() const
     return m_impl->getStagesHint();
 }
 
+void RTEShapeEstimator::setConvergenceThreshold(float threshold)
+{
+    m_impl->setConvergenceThreshold(threshold);
+}
+
+float RTEShapeEstimator::getConvergenceThreshold() const
+{
+    return m_impl->getConvergenceThreshold();
+}
+
+void RTEShapeEstimator::setFeatureSampler(const Sampler& sampler)
+{
+    m_impl->m_sampler = sampler;
+}
+
 int RTEShapeEstimator::operator()(const cv::Mat& gray, std::vector<cv::Point2f>& points, std::vector<bool>& mask) const
 {
-    return (*m_impl)(gray, points, mask);
+    return (*m_impl)(gray, points, mask, m_impl->getContext());
+}
+
+int RTEShapeEstimator::operator()(const cv::Mat& gray, Point2fVec& points, BoolVec& mask, const Context& context) const
+{
+    return (*m_impl)(gray, points, mask, context);
+}
+
+int RTEShapeEstimator::estimateBatch(const std::vector<cv::Mat>& crops, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel) const
+{
+    return m_impl->estimateBatch(crops, points, masks, doParallel);
+}
+
+int RTEShapeEstimator::operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const
+{
+    return (*m_impl)(image, roi, points, mask, m_impl->getContext());
+}
+
+int RTEShapeEstimator::operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask, const Context& context) const
+{
+    return (*m_impl)(image, roi, points, mask, context);
+}
+
+int RTEShapeEstimator::estimateBatch(const cv::Mat& image, const std::vector<cv::Rect>& rois, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel) const
+{
+    return m_impl->estimateBatch(image, rois, points, masks, doParallel);
+}
+
+int RTEShapeEstimator::getPyramidLevels() const
+{
+    return m_impl->m_predictor->num_levels();
+}
+
+int RTEShapeEstimator::estimatePyramid(const std::vector<cv::Mat>& pyramid, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const
+{
+    return m_impl->estimatePyramid(pyramid, roi, points, mask, m_impl->getContext());
+}
+
+int RTEShapeEstimator::estimatePyramidBatch(const std::vector<cv::Mat>& pyramid, const std::vector<cv::Rect>& rois, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel) const
+{
+    return m_impl->estimatePyramidBatch(pyramid, rois, points, masks, doParallel);
+}
+
+void RTEShapeEstimator::setCascadeLevels(const std::vector<int>& levels)
+{
+    m_impl->m_predictor->cascade_levels = levels;
+}
+
+const std::vector<int>& RTEShapeEstimator::getCascadeLevels() const
+{
+    return m_impl->m_predictor->cascade_levels;
 }
 
 int RTEShapeEstimator::operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask) const
@@ -93,11 +212,21 @@ std::vector<cv::Point2f> RTEShapeEstimator::getMeanShape() const
     return m_impl->getMeanShape();
 }
 
+std::vector<int> RTEShapeEstimator::getLandmarks() const
+{
+    return m_impl->m_predictor->output_landmarks();
+}
+
 void RTEShapeEstimator::dump(std::vector<float>& values, bool pca)
 {
     return m_impl->dump(values, pca);
 }
 
+core::MemoryUsage RTEShapeEstimator::memoryUsage() const
+{
+    return m_impl->memoryUsage();
+}
+
 DRISHTI_ML_NAMESPACE_END
 
 // clang-format off
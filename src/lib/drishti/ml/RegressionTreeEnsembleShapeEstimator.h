@@ -16,9 +16,15 @@
 
 #include <opencv2/core/core.hpp>
 
+#include <iosfwd>
 #include <memory>
+#include <string>
 #include <vector>
 
+// clang-format off
+namespace drishti { namespace core { class FlatArchive; } };
+// clang-format on
+
 DRISHTI_ML_NAMESPACE_BEGIN
 
 // Consider occlusion estimation
@@ -30,20 +36,48 @@ public:
     RegressionTreeEnsembleShapeEstimator();
     RegressionTreeEnsembleShapeEstimator(const std::string& filename);
     RegressionTreeEnsembleShapeEstimator(std::istream& is, const std::string& hint = {});
+    RegressionTreeEnsembleShapeEstimator(const std::shared_ptr<const drishti::core::FlatArchive>& archive);
     ~RegressionTreeEnsembleShapeEstimator();
 
+    virtual std::unique_ptr<ShapeEstimator> clone() const;
     virtual void setStreamLogger(std::shared_ptr<spdlog::logger>& logger);
     virtual int operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask) const;
     virtual int operator()(const cv::Mat& I, Point2fVec& points, BoolVec& mask) const;
+    virtual int operator()(const cv::Mat& I, Point2fVec& points, BoolVec& mask, const Context& context) const;
+    virtual int estimateBatch(const std::vector<cv::Mat>& crops, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel = false) const;
+    virtual int operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const;
+    virtual int operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask, const Context& context) const;
+    virtual int estimateBatch(const cv::Mat& image, const std::vector<cv::Rect>& rois, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel = false) const;
+    virtual bool hasVirtualBorder() const
+    {
+        return true;
+    }
+    virtual int getPyramidLevels() const;
+    virtual int estimatePyramid(const std::vector<cv::Mat>& pyramid, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const;
+    virtual int estimatePyramidBatch(const std::vector<cv::Mat>& pyramid, const std::vector<cv::Rect>& rois, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel = false) const;
     virtual std::vector<cv::Point2f> getMeanShape() const;
+    virtual std::vector<int> getLandmarks() const;
     virtual void setDoPreview(bool flag) {}
     virtual bool isPCA() const;
 
     virtual void setStagesHint(int stages);
     virtual int getStagesHint() const;
+    virtual void setConvergenceThreshold(float threshold);
+    virtual float getConvergenceThreshold() const;
+    virtual void setFeatureSampler(const Sampler& sampler);
 
     void dump(std::vector<float>& values, bool pca);
 
+    // Pyramid level per cascade (0 : full resolution), a property of the (shared) model:
+    void setCascadeLevels(const std::vector<int>& levels);
+    const std::vector<int>& getCascadeLevels() const;
+
+    virtual core::MemoryUsage memoryUsage() const;
+
+    // Export to the flat (memory mappable) format, which the constructors detect:
+    void saveFlat(std::ostream& os) const;
+    void saveFlat(const std::string& filename) const;
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version);
 
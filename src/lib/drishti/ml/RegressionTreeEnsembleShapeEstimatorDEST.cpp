@@ -10,6 +10,8 @@
 
 #include "drishti/ml/RegressionTreeEnsembleShapeEstimatorDEST.h"
 #include "drishti/core/make_unique.h"
+#include "drishti/core/Executor.h"
+#include "drishti/core/ParallelFor.h"
 
 #include <dest/dest.h>
 
@@ -34,9 +36,13 @@ public:
 
     Impl(const std::string& filename)
     {
-        m_tracker.load(filename);
+        auto tracker = std::make_shared<dest::core::Tracker>();
+        tracker->load(filename);
+        m_tracker = tracker;
     }
 
+    Impl(const Impl&) = default; // shares the trees, see RegressionTreeEnsembleShapeEstimatorDEST::clone()
+
     ~Impl()
     {
     }
@@ -46,14 +52,20 @@ public:
         // TODO:
     }
 
-    std::vector<cv::Point2f> operator()(const cv::Mat& gray)
+    Landmarks operator()(const cv::Mat& gray) const
+    {
+        return (*this)(gray, { { 0, 0 }, gray.size() });
+    }
+
+    // The roi must be inside the image, landmarks are in image coordinates:
+    Landmarks operator()(const cv::Mat& gray, const cv::Rect& roi) const
     {
         dest::core::Rect r, ur = dest::core::unitRectangle();
-        toDest(cv::Rect({ 0, 0 }, gray.size()), r);
+        toDest(roi, r);
         dest::core::ShapeTransform shapeToImage;
         shapeToImage = dest::core::estimateSimilarityTransform(ur, r);
         dest::core::MappedImage mappedGray = toDestHeaderOnly(gray);
-        dest::core::Shape s = m_tracker.predict(mappedGray, shapeToImage);
+        dest::core::Shape s = m_tracker->predict(mappedGray, shapeToImage);
 
         std::vector<cv::Point2f> landmarks(s.cols());
         for (int i = 0; i < s.cols(); i++)
@@ -64,23 +76,60 @@ public:
         return landmarks;
     }
 
+    // Regions inside the image are mapped in place, clipped regions use a zero padded crop:
+    Landmarks estimate(const cv::Mat& gray, const cv::Rect& roi) const
+    {
+        const cv::Rect validRoi = roi & cv::Rect({ 0, 0 }, gray.size());
+        if (validRoi == roi)
+        {
+            return (*this)(gray, roi);
+        }
+
+        cv::Mat1b padded(roi.size(), 0);
+        gray(validRoi).copyTo(padded(validRoi - roi.tl()));
+
+        Landmarks landmarks = (*this)(padded);
+        for (auto& p : landmarks)
+        {
+            p += cv::Point2f(roi.tl());
+        }
+        return landmarks;
+    }
+
+    // Each ROI is an independent prediction on the shared trees:
+    template <typename Function>
+    int estimateBatch(int n, std::vector<Landmarks>& points, std::vector<std::vector<bool>>& masks, bool doParallel, Function&& function) const
+    {
+        points.resize(n);
+        masks.resize(n);
+
+        auto harness = [&](int i) {
+            points[i] = function(i);
+            masks[i].assign(points[i].size(), true);
+        };
+
+        auto* executor = (doParallel && (n > 1)) ? drishti::core::Executor::getInstance().get() : nullptr;
+        drishti::core::parallel_for(executor, n, harness);
+        return n;
+    }
+
 protected:
     // Convert OpenCV image to DEST reusing memory.
-    inline dest::core::MappedImage toDestHeaderOnly(const cv::Mat& src)
+    static dest::core::MappedImage toDestHeaderOnly(const cv::Mat& src)
     {
         eigen_assert(src.channels() == 1);
         eigen_assert(src.type() == CV_8UC1);
         const int outerStride = static_cast<int>(src.step[0] / sizeof(unsigned char));
-        return dest::core::MappedImage(src.ptr<unsigned char>(), src.rows, src.cols, Eigen::OuterStride<Eigen::Dynamic>(outerStride));
+        return dest::core::MappedImage(const_cast<unsigned char*>(src.ptr<unsigned char>()), src.rows, src.cols, Eigen::OuterStride<Eigen::Dynamic>(outerStride));
     }
 
     //Convert OpenCV rectangle to DEST.
-    inline void toDest(const cv::Rect& src, dest::core::Rect& dst)
+    static void toDest(const cv::Rect& src, dest::core::Rect& dst)
     {
         dst = dest::core::createRectangle(Eigen::Vector2f(src.tl().x, src.tl().y), Eigen::Vector2f(src.br().x, src.br().y));
     }
 
-    dest::core::Tracker m_tracker;
+    std::shared_ptr<const dest::core::Tracker> m_tracker; // read only, shared by clones
 };
 
 /*
@@ -123,6 +172,34 @@ int RegressionTreeEnsembleShapeEstimatorDEST::operator()(const cv::Mat& gray, st
     return 0;
 }
 
+std::unique_ptr<ShapeEstimator> RegressionTreeEnsembleShapeEstimatorDEST::clone() const
+{
+    auto estimator = drishti::core::make_unique<RegressionTreeEnsembleShapeEstimatorDEST>();
+    if (m_impl)
+    {
+        estimator->m_impl = drishti::core::make_unique<Impl>(*m_impl);
+    }
+    estimator->m_streamLogger = m_streamLogger;
+    return std::move(estimator);
+}
+
+int RegressionTreeEnsembleShapeEstimatorDEST::operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const
+{
+    points = m_impl->estimate(image, roi);
+    mask.assign(points.size(), true);
+    return int(points.size());
+}
+
+int RegressionTreeEnsembleShapeEstimatorDEST::estimateBatch(const std::vector<cv::Mat>& crops, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel) const
+{
+    return m_impl->estimateBatch(int(crops.size()), points, masks, doParallel, [&](int i) { return (*m_impl)(crops[i]); });
+}
+
+int RegressionTreeEnsembleShapeEstimatorDEST::estimateBatch(const cv::Mat& image, const std::vector<cv::Rect>& rois, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel) const
+{
+    return m_impl->estimateBatch(int(rois.size()), points, masks, doParallel, [&](int i) { return m_impl->estimate(image, rois[i]); });
+}
+
 int RegressionTreeEnsembleShapeEstimatorDEST::operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask) const
 {
     CV_Assert(false);
@@ -32,8 +32,16 @@ public:
     RegressionTreeEnsembleShapeEstimatorDEST(const std::string& filename);
     RegressionTreeEnsembleShapeEstimatorDEST(std::istream& is, const std::string& hint = {});
 
+    // Clones share the read only trees (DEST prediction is const and reentrant):
+    virtual std::unique_ptr<ShapeEstimator> clone() const;
+
     virtual int operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask) const;
     virtual int operator()(const cv::Mat& I, Point2fVec& points, BoolVec& mask) const;
+
+    // Regions inside the image are mapped in place (no crop), clipped regions are padded:
+    virtual int operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const;
+    virtual int estimateBatch(const std::vector<cv::Mat>& crops, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel = false) const;
+    virtual int estimateBatch(const cv::Mat& image, const std::vector<cv::Rect>& rois, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel = false) const;
     virtual std::vector<cv::Point2f> getMeanShape() const;
     virtual void setDoPreview(bool flag) {}
     virtual bool isPCA() const;
@@ -29,9 +29,10 @@ void ShapeEstimator::setDoPreview(bool flag)
 {
 }
 
-int ShapeEstimator::operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const
+// Crop with the roi geometry, clipped regions are padded with zeros (deep copy):
+static cv::Mat paddedCrop(const cv::Mat& image, const cv::Rect& roi)
 {
-    cv::Rect validRoi = roi & cv::Rect({ 0, 0 }, image.size());
+    const cv::Rect validRoi = roi & cv::Rect({ 0, 0 }, image.size());
     cv::Mat crop = image(validRoi);
     if (validRoi != roi)
     {
@@ -39,14 +40,77 @@ int ShapeEstimator::operator()(const cv::Mat& image, const cv::Rect& roi, Point2
         crop.copyTo(padded(validRoi - roi.tl()));
         cv::swap(crop, padded);
     }
+    return crop;
+}
 
-    int n = (*this)(image(validRoi), points, mask);
+static void translate(ShapeEstimator::Point2fVec& points, const cv::Point& offset)
+{
     for (auto& p : points)
     {
-        p.x += validRoi.x;
-        p.y += validRoi.y;
+        p.x += offset.x;
+        p.y += offset.y;
     }
+}
+
+int ShapeEstimator::operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const
+{
+    int n = (*this)(paddedCrop(image, roi), points, mask);
+    translate(points, roi.tl());
     return n;
 }
 
+int ShapeEstimator::operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask, const Context& context) const
+{
+    int n = (*this)(paddedCrop(image, roi), points, mask, context);
+    translate(points, roi.tl());
+    return n;
+}
+
+int ShapeEstimator::operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask, const Context& context) const
+{
+    return (*this)(I, M, points, mask);
+}
+
+int ShapeEstimator::operator()(const cv::Mat& crop, Point2fVec& points, BoolVec& mask, const Context& context) const
+{
+    return (*this)(crop, points, mask);
+}
+
+int ShapeEstimator::estimateBatch(const std::vector<cv::Mat>& crops, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel) const
+{
+    points.resize(crops.size());
+    masks.resize(crops.size());
+    for (std::size_t i = 0; i < crops.size(); i++)
+    {
+        (*this)(crops[i], points[i], masks[i]);
+    }
+    return int(crops.size());
+}
+
+int ShapeEstimator::estimateBatch(const cv::Mat& image, const std::vector<cv::Rect>& rois, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel) const
+{
+    std::vector<cv::Mat> crops(rois.size());
+    for (std::size_t i = 0; i < rois.size(); i++)
+    {
+        crops[i] = paddedCrop(image, rois[i]);
+    }
+
+    int n = estimateBatch(crops, points, masks, doParallel);
+    for (std::size_t i = 0; i < rois.size(); i++)
+    {
+        translate(points[i], rois[i].tl());
+    }
+    return n;
+}
+
+int ShapeEstimator::estimatePyramid(const std::vector<cv::Mat>& pyramid, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const
+{
+    return (*this)(pyramid.front(), roi, points, mask);
+}
+
+int ShapeEstimator::estimatePyramidBatch(const std::vector<cv::Mat>& pyramid, const std::vector<cv::Rect>& rois, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel) const
+{
+    return estimateBatch(pyramid.front(), rois, points, masks, doParallel);
+}
+
 DRISHTI_ML_NAMESPACE_END
@@ -16,9 +16,12 @@
 
 #include "drishti/ml/drishti_ml.h"
 #include "drishti/core/Logger.h"
+#include "drishti/core/MemoryUsage.h"
 
 #include <opencv2/core.hpp>
 
+#include <functional>
+#include <limits>
 #include <memory>
 #include <vector>
 
@@ -30,8 +33,26 @@ public:
     typedef std::vector<bool> BoolVec;
     typedef std::vector<cv::Point2f> Point2fVec;
 
+    // Reads the pixels at image coordinates (x[i], y[i]), samples outside the image read as zero:
+    using Sampler = std::function<void(const float* x, const float* y, float* values, int n)>;
+
+    // Inference is const and reentrant, so a single estimator (the read only model) can be
+    // shared by any number of threads.  Per caller settings are passed in a Context:
+    struct Context
+    {
+        int stages = std::numeric_limits<int>::max(); // see setStagesHint()
+        float convergence = 0.f;                      // see setConvergenceThreshold()
+        Sampler sampler;                              // see setFeatureSampler()
+    };
+
     virtual ~ShapeEstimator();
 
+    // Copy with independent settings that shares the read only model (nullptr if unsupported):
+    virtual std::unique_ptr<ShapeEstimator> clone() const
+    {
+        return nullptr;
+    }
+
     virtual void setStreamLogger(std::shared_ptr<spdlog::logger>& logger)
     {
         m_streamLogger = logger;
@@ -40,10 +61,47 @@ public:
     virtual int operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask) const = 0;
     virtual int operator()(const cv::Mat& crop, Point2fVec& points, BoolVec& mask) const = 0;
     virtual int operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const;
+
+    // Estimate with the settings in context (the default implementations ignore the context):
+    virtual int operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask, const Context& context) const;
+    virtual int operator()(const cv::Mat& crop, Point2fVec& points, BoolVec& mask, const Context& context) const;
+
+    // Estimate shapes for a batch of crops (i.e., multiple faces or initializations), where
+    // points[i] may contain an initial shape for crops[i].  Returns the number of shapes:
+    virtual int estimateBatch(const std::vector<cv::Mat>& crops, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel = false) const;
+
+    // Estimate shapes in image regions that may extend beyond the image, with output points in
+    // image coordinates.  Pixels outside the image are treated as zero padding: estimators with
+    // a virtual border (hasVirtualBorder()) sample the image in place, the default implementation
+    // makes a padded copy of each clipped crop.
+    virtual int operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask, const Context& context) const;
+    virtual int estimateBatch(const cv::Mat& image, const std::vector<cv::Rect>& rois, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel = false) const;
+    virtual bool hasVirtualBorder() const
+    {
+        return false;
+    }
+
+    // Coarse-to-fine estimates on an octave pyramid (pyramid[0] : full resolution image, pyramid[l] :
+    // cv::pyrDown() of pyramid[l-1]), each cascade reads the level its model was trained on.  The
+    // rois and the output points are in full resolution coordinates.  The default implementations
+    // only read pyramid[0], see getPyramidLevels() for the number of levels used:
+    virtual int getPyramidLevels() const
+    {
+        return 1;
+    }
+    virtual int estimatePyramid(const std::vector<cv::Mat>& pyramid, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const;
+    virtual int estimatePyramidBatch(const std::vector<cv::Mat>& pyramid, const std::vector<cv::Rect>& rois, std::vector<Point2fVec>& points, std::vector<BoolVec>& masks, bool doParallel = false) const;
+
     virtual std::vector<cv::Point2f> getMeanShape() const
     {
         return std::vector<cv::Point2f>();
     }
+
+    // Index in the mean shape of each estimated point (empty : all points are estimated):
+    virtual std::vector<int> getLandmarks() const
+    {
+        return std::vector<int>();
+    }
     virtual void setDoPreview(bool flag);
     virtual bool isPCA() const
     {
@@ -55,8 +113,25 @@ public:
         return 0;
     }
 
+    // Stop the cascade once the shape update of a stage falls below this threshold (0 : disabled):
+    virtual void setConvergenceThreshold(float threshold) {}
+    virtual float getConvergenceThreshold() const
+    {
+        return 0.f;
+    }
+
+    // Experimental: in place estimates (see hasVirtualBorder()) read their pose indexed features
+    // through the sampler (e.g., a GPU pass), the image then only defines the geometry:
+    virtual void setFeatureSampler(const Sampler& sampler) {}
+
     virtual void dump(std::vector<float>& params, bool pca = false) {}
 
+    // Heap footprint of the model by component (empty if unsupported):
+    virtual core::MemoryUsage memoryUsage() const
+    {
+        return {};
+    }
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version) {}
 
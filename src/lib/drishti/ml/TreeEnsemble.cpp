@@ -0,0 +1,115 @@
+/*! -*-c++-*-
+  @file   TreeEnsemble.cpp
+  @author David Hirvonen
+  @brief  Immutable flat array representation of a boosted regression tree ensemble.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/ml/TreeEnsemble.h"
+#include "drishti/core/ThrowAssert.h"
+
+#include <algorithm>
+#include <cmath>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+TreeEnsemble::TreeEnsemble(std::vector<Node> nodes, std::vector<int32_t> roots, float bias, Transform transform)
+    : m_nodes(std::move(nodes))
+    , m_roots(std::move(roots))
+    , m_bias(bias)
+    , m_transform(transform)
+{
+    const auto size = static_cast<int32_t>(m_nodes.size());
+    for (const auto& root : m_roots)
+    {
+        drishti_throw_assert((root >= 0) && (root < size), "TreeEnsemble: invalid root node");
+    }
+
+    for (const auto& node : m_nodes)
+    {
+        if (!node.isLeaf())
+        {
+            drishti_throw_assert((node.yes >= 0) && (node.yes < size), "TreeEnsemble: invalid child node");
+            drishti_throw_assert((node.no >= 0) && (node.no < size), "TreeEnsemble: invalid child node");
+            drishti_throw_assert((node.missing >= 0) && (node.missing < size), "TreeEnsemble: invalid child node");
+            m_features = std::max(m_features, node.feature + 1);
+        }
+    }
+}
+
+TreeEnsemble::TreeEnsemble(Function function, int features)
+    : m_features(features)
+    , m_function(function)
+{
+    drishti_throw_assert(function != nullptr, "TreeEnsemble: invalid function");
+}
+
+float TreeEnsemble::operator()(const float* features) const
+{
+    if (m_function)
+    {
+        return m_function(features);
+    }
+
+    // Trees are summed before the bias is added to match XGBoost results exactly:
+    float sum = 0.f;
+    for (const auto& root : m_roots)
+    {
+        const Node* node = &m_nodes[root];
+        while (!node->isLeaf())
+        {
+            const float f = features[node->feature];
+            node = &m_nodes[std::isnan(f) ? node->missing : ((f < node->value) ? node->yes : node->no)];
+        }
+        sum += node->value;
+    }
+    sum += m_bias;
+
+    return transform(sum);
+}
+
+void TreeEnsemble::predict(const float* rows, int nRows, int stride, float* out) const
+{
+    if (m_function)
+    {
+        for (int i = 0; i < nRows; i++, rows += stride)
+        {
+            out[i] = m_function(rows);
+        }
+        return;
+    }
+
+    std::fill(out, out + nRows, 0.f);
+
+    // Each tree is applied to all rows while its nodes are in cache (per row sums
+    // are accumulated in the same order as operator()):
+    for (const auto& root : m_roots)
+    {
+        const float* features = rows;
+        for (int i = 0; i < nRows; i++, features += stride)
+        {
+            const Node* node = &m_nodes[root];
+            while (!node->isLeaf())
+            {
+                const float f = features[node->feature];
+                node = &m_nodes[std::isnan(f) ? node->missing : ((f < node->value) ? node->yes : node->no)];
+            }
+            out[i] += node->value;
+        }
+    }
+
+    for (int i = 0; i < nRows; i++)
+    {
+        out[i] = transform(out[i] + m_bias);
+    }
+}
+
+float TreeEnsemble::transform(float value) const
+{
+    return (m_transform == kLogistic) ? (1.f / (1.f + std::exp(-value))) : value;
+}
+
+DRISHTI_ML_NAMESPACE_END
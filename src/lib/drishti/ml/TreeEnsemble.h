@@ -0,0 +1,101 @@
+/*! -*-c++-*-
+  @file   TreeEnsemble.h
+  @author David Hirvonen
+  @brief  Immutable flat array representation of a boosted regression tree ensemble.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_ml_TreeEnsemble_h__
+#define __drishti_ml_TreeEnsemble_h__
+
+#include "drishti/ml/drishti_ml.h"
+
+#include <cstdint>
+#include <vector>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+// The ensemble is created once (i.e., at model load time) and is read only
+// after that, so a single instance can be evaluated from any number of threads
+// without locks or allocations.
+
+class TreeEnsemble
+{
+public:
+    enum Transform
+    {
+        kIdentity, // reg:linear
+        kLogistic  // binary:logistic
+    };
+
+    struct Node
+    {
+        Node() = default;
+        Node(float value)
+            : value(value)
+        {
+        }
+        Node(int32_t feature, float value, int32_t yes, int32_t no, int32_t missing)
+            : feature(feature)
+            , value(value)
+            , yes(yes)
+            , no(no)
+            , missing(missing)
+        {
+        }
+
+        bool isLeaf() const { return feature < 0; }
+
+        int32_t feature = -1; // split feature index (< 0 for leaves)
+        float value = 0.f;    // split threshold or leaf value
+        int32_t yes = 0;      // child node for (feature < value)
+        int32_t no = 0;       // child node for (feature >= value)
+        int32_t missing = 0;  // child node for missing (NaN) features
+    };
+
+    //! Generated evaluator for a fixed ensemble (see drishti_cpr_codegen):
+    using Function = float (*)(const float* features);
+
+    TreeEnsemble() = default;
+
+    // Child indices are absolute within nodes, trees begin at roots:
+    TreeEnsemble(std::vector<Node> nodes, std::vector<int32_t> roots, float bias, Transform transform = kIdentity);
+
+    // The function returns the final (transformed) value for a feature row:
+    TreeEnsemble(Function function, int features);
+
+    bool empty() const { return m_roots.empty() && !m_function; }
+    std::size_t size() const { return m_roots.size(); }
+
+    const std::vector<Node>& getNodes() const { return m_nodes; }
+    const std::vector<int32_t>& getRoots() const { return m_roots; }
+    float getBias() const { return m_bias; }
+    Transform getTransform() const { return m_transform; }
+
+    //! Minimum length of a feature row (largest split feature index + 1):
+    int getFeatureDim() const { return m_features; }
+
+    //! Evaluate a feature row with getFeatureDim() values, NaN marks missing features:
+    float operator()(const float* features) const;
+
+    //! Evaluate nRows feature rows (stride floats apart) in one pass over the trees:
+    void predict(const float* rows, int nRows, int stride, float* out) const;
+
+protected:
+    float transform(float value) const;
+
+    std::vector<Node> m_nodes; // breadth first nodes for each tree
+    std::vector<int32_t> m_roots;
+    float m_bias = 0.f;
+    Transform m_transform = kIdentity;
+    int m_features = 0;
+
+    Function m_function = nullptr;
+};
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // __drishti_ml_TreeEnsemble_h__
@@ -25,6 +25,11 @@ XGBooster::XGBooster(const Recipe& recipe)
     m_impl = drishti::core::make_unique<XGBooster::Impl>(recipe);
 }
 
+XGBooster::XGBooster(const TreeEnsemble& forest)
+{
+    m_impl = drishti::core::make_unique<XGBooster::Impl>(forest);
+}
+
 XGBooster::~XGBooster() = default;
 
 void XGBooster::setStreamLogger(std::shared_ptr<spdlog::logger>& logger)
@@ -36,11 +41,26 @@ void XGBooster::setStreamLogger(std::shared_ptr<spdlog::logger>& logger)
     }
 }
 
-float XGBooster::operator()(const std::vector<float>& features)
+float XGBooster::operator()(const std::vector<float>& features) const
+{
+    return (*m_impl)(features);
+}
+
+float XGBooster::operator()(const float* features) const
 {
     return (*m_impl)(features);
 }
 
+void XGBooster::predict(const float* rows, int nRows, int stride, float* out) const
+{
+    m_impl->predict(rows, nRows, stride, out);
+}
+
+const TreeEnsemble& XGBooster::getTreeEnsemble() const
+{
+    return m_impl->getTreeEnsemble();
+}
+
 void XGBooster::train(const MatrixType<float>& features, const std::vector<float>& values, const MatrixType<uint8_t>& mask)
 {
 #if DRISHTI_BUILD_MIN_SIZE
@@ -50,6 +70,15 @@ void XGBooster::train(const MatrixType<float>& features, const std::vector<float
 #endif
 }
 
+void XGBooster::train(const float* features, int nRows, int nCols, int stride, const std::vector<float>& values, const std::uint8_t* mask, int threads)
+{
+#if DRISHTI_BUILD_MIN_SIZE
+    assert(false);
+#else
+    m_impl->train(features, nRows, nCols, stride, values, mask, threads);
+#endif
+}
+
 void XGBooster::read(const std::string& filename)
 {
 #if DRISHTI_BUILD_MIN_SIZE
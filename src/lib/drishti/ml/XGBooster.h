@@ -12,10 +12,12 @@
 #define __drishti_ml_XGBooster_h__
 
 #include "drishti/ml/drishti_ml.h"
+#include "drishti/ml/TreeEnsemble.h"
 #include "drishti/core/Logger.h"
 
 #include <opencv2/core.hpp>
 
+#include <cstdint>
 #include <memory>
 
 template <typename T>
@@ -42,10 +44,27 @@ public:
     class Impl;
     XGBooster();
     XGBooster(const Recipe& recipe);
+
+    //! Evaluation only booster for a fixed (e.g., generated) ensemble:
+    XGBooster(const TreeEnsemble& forest);
     ~XGBooster();
-    float operator()(const std::vector<float>& features);
+    float operator()(const std::vector<float>& features) const;
+
+    //! Allocation free and reentrant evaluation of a feature row (NaN for missing values):
+    float operator()(const float* features) const;
+
+    //! Evaluate nRows feature rows with a pitch of stride floats:
+    void predict(const float* rows, int nRows, int stride, float* out) const;
+
+    //! Native representation of the current model (empty for non gbtree models):
+    const TreeEnsemble& getTreeEnsemble() const;
+
     void train(const MatrixType<float>& features, const std::vector<float>& values, const MatrixType<uint8_t>& mask = {});
 
+    //! Train on nRows contiguous feature rows with a pitch of stride floats and an optional mask with
+    //! the same layout (0 : missing), with a budget of threads xgboost threads (0 : the default):
+    void train(const float* features, int nRows, int nCols, int stride, const std::vector<float>& values, const std::uint8_t* mask = nullptr, int threads = 0);
+
     void read(const std::string& filename);
     void write(const std::string& filename) const;
 
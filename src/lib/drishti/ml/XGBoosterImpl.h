@@ -15,6 +15,9 @@
 #include "drishti/core/make_unique.h"
 #include "drishti/core/ThrowAssert.h"
 #include "drishti/ml/Booster.h"
+#include "drishti/ml/TreeEnsemble.h"
+
+#include <queue>
 
 DRISHTI_ML_NAMESPACE_BEGIN
 
@@ -46,6 +49,11 @@ public:
     {
         init();
     }
+    Impl(const TreeEnsemble& forest)
+        : m_forest(forest)
+    {
+        init();
+    }
 
     ~Impl();
 
@@ -77,33 +85,155 @@ public:
         }
     }
 
-    float operator()(const std::vector<float>& features)
+    float operator()(const std::vector<float>& features) const
     {
+        if (!m_forest.empty() && (int(features.size()) >= m_forest.getFeatureDim()))
+        {
+            return m_forest(features.data());
+        }
+
         std::shared_ptr<DMatrixSimple> dTest = xgboost::DMatrixSimpleFromMat(&features[0], 1, features.size(), NAN);
         std::vector<float> predictions(1, 0.f);
         m_booster->Predict(*dTest, false, &predictions);
         return predictions.front();
     }
 
+    float operator()(const float* features) const
+    {
+        drishti_throw_assert(!m_forest.empty(), "XGBooster: native evaluation requires a gbtree model");
+        return m_forest(features);
+    }
+
+    void predict(const float* rows, int nRows, int stride, float* out) const
+    {
+        if (!m_forest.empty())
+        {
+            m_forest.predict(rows, nRows, stride, out);
+            return;
+        }
+
+        // The xgboost path treats each row as stride features:
+        std::shared_ptr<DMatrixSimple> dTest = xgboost::DMatrixSimpleFromMat(rows, nRows, stride, NAN);
+        std::vector<float> predictions(nRows, 0.f);
+        m_booster->Predict(*dTest, false, &predictions);
+        std::copy(predictions.begin(), predictions.end(), out);
+    }
+
+    const TreeEnsemble& getTreeEnsemble() const
+    {
+        return m_forest;
+    }
+
+    // Convert the current gbtree model to a TreeEnsemble (xgboost node traversal
+    // and summation order are preserved), other boosters keep the xgboost path:
+    void compile()
+    {
+        m_forest = {};
+
+        const auto* gbtree = m_booster ? dynamic_cast<const xgboost::gbm::GBTree*>(m_booster->GetGradBooster()) : nullptr;
+        if (!gbtree)
+        {
+            return;
+        }
+
+        TreeEnsemble::Transform transform;
+        if (m_booster->GetObjective() == "reg:linear")
+        {
+            transform = TreeEnsemble::kIdentity;
+        }
+        else if (m_booster->GetObjective() == "binary:logistic")
+        {
+            transform = TreeEnsemble::kLogistic;
+        }
+        else
+        {
+            return;
+        }
+
+        std::vector<TreeEnsemble::Node> nodes;
+        std::vector<int32_t> roots;
+        for (const auto* tree : xgboost::wrapper::GBTreeAccess::GetTrees(*gbtree))
+        {
+            if (tree->param.num_roots != 1)
+            {
+                return;
+            }
+
+            // Renumber the reachable nodes (skipping deleted ones) in breadth first order:
+            const auto root = static_cast<int32_t>(nodes.size());
+            roots.push_back(root);
+            nodes.emplace_back();
+
+            std::queue<std::pair<int, int32_t>> queue; // { xgboost node, TreeEnsemble node }
+            queue.emplace(0, root);
+            while (!queue.empty())
+            {
+                const auto& src = (*tree)[queue.front().first];
+                const auto dst = queue.front().second;
+                queue.pop();
+
+                if (src.is_leaf())
+                {
+                    nodes[dst] = TreeEnsemble::Node(src.leaf_value());
+                }
+                else
+                {
+                    const auto yes = static_cast<int32_t>(nodes.size()), no = yes + 1;
+                    const auto missing = (src.cdefault() == src.cleft()) ? yes : no;
+                    nodes[dst] = TreeEnsemble::Node(int32_t(src.split_index()), src.split_cond(), yes, no, missing);
+                    nodes.resize(nodes.size() + 2);
+                    queue.emplace(src.cleft(), yes);
+                    queue.emplace(src.cright(), no);
+                }
+            }
+        }
+
+        m_forest = TreeEnsemble(std::move(nodes), std::move(roots), m_booster->GetBaseScore(), transform);
+    }
+
     void train(const MatrixType<float>& features, const std::vector<float>& values, const MatrixType<uint8_t>& mask = {})
     {
 #if DRISHTI_BUILD_MIN_SIZE
         assert(false);
 #else
         std::shared_ptr<DMatrixSimple> dTrain = xgboost::DMatrixSimpleFromMat(features, features.size(), features[0].size(), mask);
-        dTrain->info.labels = values;
+        train(*dTrain, values);
+#endif
+    }
+
+    void train(const float* features, int nRows, int nCols, int stride, const std::vector<float>& values, const std::uint8_t* mask, int threads)
+    {
+#if DRISHTI_BUILD_MIN_SIZE
+        assert(false);
+#else
+        if (threads > 0)
+        {
+            m_booster->SetParam("nthread", xtos(threads).c_str());
+        }
 
-        std::vector<xgboost::learner::DMatrix*> dmats{ dTrain.get() };
+        std::shared_ptr<DMatrixSimple> dTrain = xgboost::DMatrixSimpleFromRows(features, nRows, nCols, stride, mask, threads);
+        train(*dTrain, values);
+#endif
+    }
+
+#if !DRISHTI_BUILD_MIN_SIZE
+    void train(DMatrixSimple& dTrain, const std::vector<float>& values)
+    {
+        dTrain.info.labels = values;
+
+        std::vector<xgboost::learner::DMatrix*> dmats{ &dTrain };
         m_booster->SetCacheData(dmats);
         m_booster->CheckInitModel();
-        m_booster->CheckInit(dTrain.get());
+        m_booster->CheckInit(&dTrain);
 
         for (int t = 0; t < m_recipe.numberOfTrees; t++)
         {
-            m_booster->UpdateOneIter(t, *dTrain);
+            m_booster->UpdateOneIter(t, dTrain);
         }
-#endif
+
+        compile();
     }
+#endif
 
     void read(const std::string& name)
     {
@@ -112,6 +242,7 @@ public:
 #else
         // normal XGBoost logging not needed with boost serialization
         m_booster->LoadModel(name.c_str());
+        compile();
 #endif
     }
 
@@ -129,6 +260,11 @@ public:
     {
         ar& m_recipe;
         ar& m_booster;
+
+        if (Archive::is_loading::value)
+        {
+            compile();
+        }
     }
 
     void setStreamLogger(std::shared_ptr<spdlog::logger>& logger)
@@ -143,6 +279,7 @@ public:
 protected:
     Recipe m_recipe;
     std::unique_ptr<xgboost::wrapper::Booster> m_booster;
+    TreeEnsemble m_forest; // native (reentrant) evaluation of m_booster
 
     std::shared_ptr<spdlog::logger> m_streamLogger;
 };
@@ -36,6 +36,7 @@
 #include "drishti/ml/PCA.h"
 #include "drishti/geometry/Ellipse.h"
 #include "drishti/core/Logger.h"
+#include "drishti/core/FlatArchive.h"
 
 // Check input preprocessor definitions for SIMD and FIXED_POINT behavior:
 //
@@ -65,12 +66,22 @@
 // clang-format on
 
 #include "drishti/core/arithmetic.h"
+#include "drishti/core/gather.h"
+#include "drishti/core/Executor.h"
+#include "drishti/core/ParallelFor.h"
+#include "drishti/core/WorkerTeam.h"
 
 // OpenCV
 #include <opencv2/core/core.hpp>
 
 // STL
+#include <algorithm>
+#include <cmath>
 #include <deque>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <type_traits>
 
 DRISHTI_ML_NAMESPACE_BEGIN
 
@@ -295,6 +306,61 @@ inline unsigned long right_child(unsigned long idx)
         - returns the index of the left child of the binary tree node idx
 !*/
 
+// ------------------------------------------------------------------------------------
+
+template <bool do_npd>
+inline float split_value(float a, float b)
+{
+    return do_npd ? compute_npd(a, b) : (a - b);
+}
+
+// Branchless descent: the comparison selects the left (2i+1) or right (2i+2) child arithmetically,
+// so the only branch left is the (well predicted) loop over tree levels.  Returns the leaf index.
+template <bool do_npd>
+inline int traverse_tree(const split_feature* nodes, int count, const float* feature_pixel_values)
+{
+    int i = 0;
+    while (i < count)
+    {
+        const auto& node = nodes[i];
+        i = (2 * i) + 2 - int(split_value<do_npd>(feature_pixel_values[node.idx1], feature_pixel_values[node.idx2]) > node.thresh);
+    }
+    return i - count;
+}
+
+// Same as above for full trees with a compile time depth (count == 2^depth - 1), which unrolls:
+template <int depth, bool do_npd>
+inline int traverse_tree(const split_feature* nodes, int count, const float* feature_pixel_values)
+{
+    int i = 0;
+    for (int level = 0; level < depth; level++)
+    {
+        const auto& node = nodes[i];
+        i = (2 * i) + 2 - int(split_value<do_npd>(feature_pixel_values[node.idx1], feature_pixel_values[node.idx2]) > node.thresh);
+    }
+    return i - ((1 << depth) - 1);
+}
+
+typedef int (*tree_traversal)(const split_feature* nodes, int count, const float* feature_pixel_values);
+
+// Choose the traversal kernel for a forest of full trees with the given depth (0 : unknown):
+template <bool do_npd>
+inline tree_traversal select_tree_traversal(int depth)
+{
+    switch (depth)
+    {
+        case 1: return &traverse_tree<1, do_npd>;
+        case 2: return &traverse_tree<2, do_npd>;
+        case 3: return &traverse_tree<3, do_npd>;
+        case 4: return &traverse_tree<4, do_npd>;
+        case 5: return &traverse_tree<5, do_npd>;
+        case 6: return &traverse_tree<6, do_npd>;
+        case 7: return &traverse_tree<7, do_npd>;
+        case 8: return &traverse_tree<8, do_npd>;
+        default: return &traverse_tree<do_npd>;
+    }
+}
+
 struct Fixed
 {
 };
@@ -319,40 +385,7 @@ struct regression_tree
      - runs through the tree and returns the vector at the leaf we end up in.
      !*/
     {
-        if (do_npd)
-        {
-            unsigned long i = 0;
-            while (i < splits.size())
-            {
-                auto& node = splits[i];
-                if (compute_npd(feature_pixel_values[node.idx1], feature_pixel_values[node.idx2]) > node.thresh)
-                {
-                    i = left_child(i);
-                }
-                else
-                {
-                    i = right_child(i);
-                }
-            }
-            return leaf_values_16[i - splits.size()];
-        }
-        else
-        {
-            unsigned long i = 0;
-            while (i < splits.size())
-            {
-                auto& node = splits[i];
-                if (feature_pixel_values[node.idx1] - feature_pixel_values[node.idx2] > node.thresh)
-                {
-                    i = left_child(i);
-                }
-                else
-                {
-                    i = right_child(i);
-                }
-            }
-            return leaf_values_16[i - splits.size()];
-        }
+        return leaf_values_16[leaf_index(feature_pixel_values, do_npd)];
     }
 
     inline const fshape& operator()(
@@ -369,55 +402,360 @@ struct regression_tree
             - runs through the tree and returns the vector at the leaf we end up in.
     !*/
     {
-        if (do_npd)
+        return leaf_values[leaf_index(feature_pixel_values, do_npd)];
+    }
+
+    inline int leaf_index(const std::vector<float>& feature_pixel_values, bool do_npd) const
+    {
+        const int count = int(splits.size());
+        const float* values = feature_pixel_values.data();
+        return do_npd ? traverse_tree<true>(splits.data(), count, values) : traverse_tree<false>(splits.data(), count, values);
+    }
+
+    friend void serialize(const regression_tree& item, std::ostream& out)
+    {
+#if !DRISHTI_BUILD_MIN_SIZE
+        dlib::serialize(item.splits, out);
+        dlib::serialize(item.leaf_values, out);
+#endif // !DRISHTI_BUILD_MIN_SIZE
+    }
+    friend void deserialize(regression_tree& item, std::istream& in)
+    {
+#if !DRISHTI_BUILD_MIN_SIZE
+        dlib::deserialize(item.splits, in);
+        dlib::deserialize(item.leaf_values, in);
+#endif // !DRISHTI_BUILD_MIN_SIZE
+    }
+};
+
+// A compiled copy of one cascade of regression_tree objects for evaluation.
+// The splits for all trees are stored in one contiguous array, and the leaves
+// (float and fixed point) are stored in contiguous 16 byte aligned arrays with
+// each leaf padded to a 16 byte boundary.  This avoids a heap allocation per
+// leaf in the regression_tree representation, which dominates cache misses
+// when walking the forest.
+//
+// The fixed point leaves use a scale chosen for each cascade such that every
+// leaf fits in int16_t and the sum over all trees fits in an int32_t
+// accumulator, so both PCA and full shape models can use them.  The expected
+// quantization error of a cascade and the round trip of each leaf are checked
+// against the float leaves when the forest is packed, and fixed point is
+// disabled for the cascade if either is out of bounds.
+struct packed_forest
+{
+    int num_trees = 0;
+    int num_splits = 0; // per tree
+    int num_leaves = 0; // per tree (num_splits + 1)
+    int leaf_dim = 0;
+    int leaf_stride = 0;    // floats per leaf (padded)
+    int leaf_stride_16 = 0; // int16_t (or int8_t) per leaf (padded)
+    int fraction_bits = 0;  // fixed point scale for leaves_16: 2^fraction_bits
+    int depth = 0;          // tree depth when num_leaves is a power of 2 (else 0)
+
+    tree_traversal traversal[2] = { nullptr, nullptr }; // { difference, npd } kernels for depth
+
+    std::vector<split_feature> splits;
+    std::vector<float, Eigen::aligned_allocator<float>> leaves;
+    std::vector<int16_t, Eigen::aligned_allocator<int16_t>> leaves_16;
+    std::vector<int8_t, Eigen::aligned_allocator<int8_t>> leaves_8; // see quantize()
+    std::vector<float> tree_scales;                                  // per tree scale for leaves_8
+
+    // Arrays used in place from a flat (i.e., memory mapped) model instead of the vectors above:
+    struct mapped_arrays
+    {
+        std::shared_ptr<const void> storage; // keeps the mapping alive
+        const split_feature* splits = nullptr;
+        const float* leaves = nullptr;
+        const int16_t* leaves_16 = nullptr;
+        const int8_t* leaves_8 = nullptr;
+        const float* tree_scales = nullptr;
+    } mapped;
+
+    template <typename T, typename Allocator>
+    static const T* data_or_null(const std::vector<T, Allocator>& values)
+    {
+        return values.empty() ? nullptr : values.data();
+    }
+
+    bool is_mapped() const { return static_cast<bool>(mapped.storage); }
+    const split_feature* get_splits() const { return is_mapped() ? mapped.splits : data_or_null(splits); }
+    const float* get_leaves() const { return is_mapped() ? mapped.leaves : data_or_null(leaves); }
+    const int16_t* get_leaves_16() const { return is_mapped() ? mapped.leaves_16 : data_or_null(leaves_16); }
+    const int8_t* get_leaves_8() const { return is_mapped() ? mapped.leaves_8 : data_or_null(leaves_8); }
+    const float* get_tree_scales() const { return is_mapped() ? mapped.tree_scales : data_or_null(tree_scales); }
+
+    bool empty() const { return (num_trees == 0); }
+    bool has_fixed_point() const { return get_leaves_16() != nullptr; }
+    bool is_quantized() const { return !empty() && !get_leaves(); } // no float leaves
+    float fixed_point_scale() const { return std::ldexp(1.f, -fraction_bits); }
+
+    // Returns false (and remains empty) for ragged forests, which are evaluated from the trees:
+    bool pack(const std::vector<regression_tree>& forest)
+    {
+        *this = packed_forest();
+
+        if (forest.empty() || forest.front().leaf_values.empty())
+        {
+            return false;
+        }
+
+        const int trees = int(forest.size());
+        const int nodes = int(forest.front().splits.size());
+        const int dim = int(forest.front().leaf_values.front().size());
+
+        for (const auto& tree : forest)
         {
-            unsigned long i = 0;
-            while (i < splits.size())
+            if ((int(tree.splits.size()) != nodes) || (int(tree.leaf_values.size()) != (nodes + 1)))
             {
-                auto& node = splits[i];
-                if (compute_npd(feature_pixel_values[node.idx1], feature_pixel_values[node.idx2]) > node.thresh)
+                return false;
+            }
+            for (const auto& leaf : tree.leaf_values)
+            {
+                if (int(leaf.size()) != dim)
                 {
-                    i = left_child(i);
+                    return false;
                 }
-                else
+            }
+        }
+
+        num_trees = trees;
+        num_splits = nodes;
+        num_leaves = nodes + 1;
+        leaf_dim = dim;
+        leaf_stride = (dim + 3) & ~3;
+        leaf_stride_16 = (dim + 7) & ~7;
+
+        select_traversal();
+
+        splits.reserve(num_trees * num_splits);
+        leaves.assign(num_trees * num_leaves * leaf_stride, 0.f);
+
+        for (int t = 0; t < num_trees; t++)
+        {
+            const auto& tree = forest[t];
+            splits.insert(splits.end(), tree.splits.begin(), tree.splits.end());
+            for (int l = 0; l < num_leaves; l++)
+            {
+                const int offset = (t * num_leaves) + l;
+                std::copy(tree.leaf_values[l].begin(), tree.leaf_values[l].end(), &leaves[offset * leaf_stride]);
+            }
+        }
+
+        pack_fixed_point();
+
+        return true;
+    }
+
+    // Select the traversal kernels once per forest (i.e., after packing or loading):
+    void select_traversal()
+    {
+        depth = 0;
+        while ((depth < 30) && ((1 << depth) < num_leaves))
+        {
+            depth++;
+        }
+        if ((1 << depth) != num_leaves)
+        {
+            depth = 0;
+        }
+        traversal[0] = select_tree_traversal<false>(depth);
+        traversal[1] = select_tree_traversal<true>(depth);
+    }
+
+    // Offline quantization for compact models: keep only the 16 bit fixed point leaves (see
+    // pack_fixed_point()) or 8 bit leaves with a per tree scale, and release the float leaves.
+    // Returns false (and leaves the forest unchanged) if the requested format can't be used.
+    bool quantize(int bits)
+    {
+        if (empty() || leaves.empty())
+        {
+            return false;
+        }
+
+        if (bits == 16)
+        {
+            if (!has_fixed_point())
+            {
+                return false;
+            }
+        }
+        else if (bits == 8)
+        {
+            leaves_8.assign(num_trees * num_leaves * leaf_stride_16, 0);
+            tree_scales.assign(num_trees, 1.f);
+            for (int t = 0; t < num_trees; t++)
+            {
+                const float* tree = &leaves[t * num_leaves * leaf_stride];
+
+                float max_leaf = 0.f;
+                for (int l = 0; l < num_leaves * leaf_stride; l++)
                 {
-                    i = right_child(i);
+                    max_leaf = std::max(max_leaf, std::abs(tree[l]));
+                }
+
+                const float scale = (max_leaf > 0.f) ? (max_leaf / 127.f) : 1.f;
+                tree_scales[t] = scale;
+                for (int l = 0; l < num_leaves; l++)
+                {
+                    int8_t* leaf = &leaves_8[((t * num_leaves) + l) * leaf_stride_16];
+                    for (int k = 0; k < leaf_dim; k++)
+                    {
+                        const long q = std::lround(tree[(l * leaf_stride) + k] / scale);
+                        leaf[k] = int8_t(std::max(-127L, std::min(127L, q)));
+                    }
                 }
             }
-            return leaf_values[i - splits.size()];
+
+            std::vector<int16_t, Eigen::aligned_allocator<int16_t>>().swap(leaves_16);
+            fraction_bits = 0;
         }
         else
         {
-            unsigned long i = 0;
-            while (i < splits.size())
+            return false;
+        }
+
+        std::vector<float, Eigen::aligned_allocator<float>>().swap(leaves);
+        return true;
+    }
+
+    // Quantize the float leaves with the finest scale that can't overflow; returns false (no
+    // fixed point leaves) if the RMS quantization error of the cascade would exceed max_error:
+    bool pack_fixed_point(float max_error = 1e-3f)
+    {
+        leaves_16.clear();
+        fraction_bits = 0;
+
+        // Largest leaf magnitude and the bound on the sum over all trees:
+        double max_leaf = 0.0, max_sum = 0.0;
+        for (int t = 0; t < num_trees; t++)
+        {
+            double max_tree = 0.0;
+            for (int l = 0; l < num_leaves * leaf_stride; l++)
             {
-                auto& node = splits[i];
-                if (feature_pixel_values[node.idx1] - feature_pixel_values[node.idx2] > node.thresh)
-                {
-                    i = left_child(i);
-                }
-                else
+                max_tree = std::max(max_tree, double(std::abs(leaves[(t * num_leaves * leaf_stride) + l])));
+            }
+            max_leaf = std::max(max_leaf, max_tree);
+            max_sum += max_tree;
+        }
+
+        int bits = 30;
+        while ((bits >= 0) && ((std::ldexp(max_leaf, bits) > 32766.0) || (std::ldexp(max_sum, bits) > 2147483647.0)))
+        {
+            bits--;
+        }
+
+        // Rounding errors are uniform in +/- half a step and independent across trees:
+        if ((bits < 0) || ((std::sqrt(double(num_trees) / 12.0) * std::ldexp(1.0, -bits)) > max_error))
+        {
+            return false;
+        }
+
+        fraction_bits = bits;
+        leaves_16.assign(num_trees * num_leaves * leaf_stride_16, 0);
+        for (int i = 0; i < num_trees * num_leaves; i++)
+        {
+            for (int k = 0; k < leaf_dim; k++)
+            {
+                leaves_16[(i * leaf_stride_16) + k] = int16_t(std::lround(std::ldexp(leaves[(i * leaf_stride) + k], fraction_bits)));
+            }
+        }
+
+        // Validate the round trip against the float leaves:
+        const float scale = fixed_point_scale();
+        for (int i = 0; i < num_trees * num_leaves; i++)
+        {
+            for (int k = 0; k < leaf_dim; k++)
+            {
+                const float error = std::abs((float(leaves_16[(i * leaf_stride_16) + k]) * scale) - leaves[(i * leaf_stride) + k]);
+                if (error > (0.5f * scale * 1.001f))
                 {
-                    i = right_child(i);
+                    leaves_16.clear();
+                    fraction_bits = 0;
+                    return false;
                 }
             }
-            return leaf_values[i - splits.size()];
         }
+
+        return true;
     }
 
-    friend void serialize(const regression_tree& item, std::ostream& out)
+    // Index of the leaf (relative to the forest) reached by tree t:
+    inline int leaf_offset(int t, const std::vector<float>& feature_pixel_values, bool do_npd) const
     {
-#if !DRISHTI_BUILD_MIN_SIZE
-        dlib::serialize(item.splits, out);
-        dlib::serialize(item.leaf_values, out);
-#endif // !DRISHTI_BUILD_MIN_SIZE
+        const split_feature* nodes = get_splits() + (t * num_splits);
+        return (t * num_leaves) + traversal[do_npd](nodes, num_splits, feature_pixel_values.data());
     }
-    friend void deserialize(regression_tree& item, std::istream& in)
+
+    // Add the leaves reached by trees [begin, end) to shape (leaf_dim elements):
+    void accumulate(const std::vector<float>& feature_pixel_values, bool do_npd, int begin, int end, float* shape) const
     {
-#if !DRISHTI_BUILD_MIN_SIZE
-        dlib::deserialize(item.splits, in);
-        dlib::deserialize(item.leaf_values, in);
-#endif // !DRISHTI_BUILD_MIN_SIZE
+        if (const float* leaves = get_leaves())
+        {
+            for (int t = begin; t < end; t++)
+            {
+                const float* leaf = &leaves[leaf_offset(t, feature_pixel_values, do_npd) * leaf_stride];
+#if DRISHTI_BUILD_REGRESSION_SIMD
+                drishti::core::add32f(shape, leaf, shape, leaf_dim);
+#else
+                for (int k = 0; k < leaf_dim; k++)
+                {
+                    shape[k] += leaf[k];
+                }
+#endif
+            }
+        }
+        else if (const int8_t* leaves_8 = get_leaves_8())
+        {
+            const float* tree_scales = get_tree_scales();
+            for (int t = begin; t < end; t++)
+            {
+                const int8_t* leaf = &leaves_8[leaf_offset(t, feature_pixel_values, do_npd) * leaf_stride_16];
+#if DRISHTI_BUILD_REGRESSION_SIMD
+                drishti::core::addScaled8sTo32f(leaf, tree_scales[t], shape, leaf_dim);
+#else
+                const float scale = tree_scales[t];
+                for (int k = 0; k < leaf_dim; k++)
+                {
+                    shape[k] += float(leaf[k]) * scale;
+                }
+#endif
+            }
+        }
+        else
+        {
+            const int16_t* leaves_16 = get_leaves_16();
+            const float scale = fixed_point_scale();
+            for (int t = begin; t < end; t++)
+            {
+                const int16_t* leaf = &leaves_16[leaf_offset(t, feature_pixel_values, do_npd) * leaf_stride_16];
+#if DRISHTI_BUILD_REGRESSION_SIMD
+                drishti::core::addScaled16sTo32f(leaf, scale, shape, leaf_dim);
+#else
+                for (int k = 0; k < leaf_dim; k++)
+                {
+                    shape[k] += float(leaf[k]) * scale;
+                }
+#endif
+            }
+        }
+    }
+
+    // Add the leaves reached by trees [begin, end) to an int32_t shape with fixed_point_scale():
+    void accumulate(const std::vector<float>& feature_pixel_values, bool do_npd, int begin, int end, int32_t* shape) const
+    {
+        const int16_t* leaves_16 = get_leaves_16();
+        for (int t = begin; t < end; t++)
+        {
+            const int16_t* leaf = &leaves_16[leaf_offset(t, feature_pixel_values, do_npd) * leaf_stride_16];
+#if DRISHTI_BUILD_REGRESSION_SIMD
+            drishti::core::add16sAnd32s(shape, leaf, shape, leaf_dim);
+#else
+            for (int k = 0; k < leaf_dim; k++)
+            {
+                shape[k] += leaf[k];
+            }
+#endif
+        }
     }
 };
 
@@ -489,6 +827,75 @@ inline void create_shape_relative_encoding(
     }
 }
 
+/*
+ * Pose indexing table for the shape relative features of one cascade: the shape element of the
+ * anchor x coordinate (2 * anchor index) and the deltas in Q3.12 fixed point, stored as aligned
+ * structure of arrays for vectorized sample point generation.  The table is the single encoding
+ * used by the trainer and the runtime (and it is stored as is in the model), so the feature
+ * points seen in training and inference are bit exact.  The normalized shape space spans the
+ * unit square, so deltas are well within the +/-8 range at a resolution of 1/4096.
+ */
+struct pose_index_table
+{
+    using Index = std::vector<int32_t, Eigen::aligned_allocator<int32_t>>;
+    using Delta = std::vector<int16_t, Eigen::aligned_allocator<int16_t>>;
+
+    static const int kFractionBits = 12;
+
+    static int16_t encode(float value)
+    {
+        const float scaled = std::round(value * float(1 << kFractionBits));
+        return int16_t(std::min(std::max(scaled, -32768.f), 32767.f));
+    }
+
+    static float decode(int16_t value)
+    {
+        return float(value) * (1.f / float(1 << kFractionBits));
+    }
+
+    std::size_t size() const { return anchor.size(); }
+
+    void compile(const std::vector<unsigned short>& anchor_idx, const PointVecf& deltas)
+    {
+        anchor.resize(anchor_idx.size());
+        dx.resize(anchor_idx.size());
+        dy.resize(anchor_idx.size());
+        for (std::size_t i = 0; i < anchor_idx.size(); i++)
+        {
+            anchor[i] = int32_t(anchor_idx[i]) * 2;
+            dx[i] = encode(deltas[i].x());
+            dy[i] = encode(deltas[i].y());
+        }
+    }
+
+    // The represented (rounded) encoding:
+    void get(std::vector<unsigned short>& anchor_idx, PointVecf& deltas) const
+    {
+        anchor_idx.resize(size());
+        deltas.resize(size());
+        for (std::size_t i = 0; i < size(); i++)
+        {
+            anchor_idx[i] = static_cast<unsigned short>(anchor[i] / 2);
+            deltas[i] = fpoint(decode(dx[i]), decode(dy[i]));
+        }
+    }
+
+    Index anchor;
+    Delta dx, dy;
+};
+
+inline void create_shape_relative_encoding(
+    const fshape& shape,
+    const PointVecf& pixel_coordinates,
+    pose_index_table& table,
+    int ellipse_count = 0)
+{
+    std::vector<unsigned short> anchor_idx;
+    PointVecf deltas;
+    create_shape_relative_encoding(shape, pixel_coordinates, anchor_idx, deltas, ellipse_count);
+    table.compile(anchor_idx, deltas);
+}
+
 // ------------------------------------------------------------------------------------
 
 inline dlib::point_transform_affine find_tform_between_shapes(
@@ -518,6 +925,88 @@ inline dlib::point_transform_affine find_tform_between_shapes(
 
 // ------------------------------------------------------------------------------------
 
+/*
+ * Shape moments for landmark subset models (see shape_predictor::compile_landmarks()).  The
+ * least squares similarity (or affine) transform from the reference shape r to a shape p only
+ * depends on p through the moments M = 1/N * sum_i p_i * (r_i - mean(r))^T, which are linear
+ * in p.  The moments of the full shape are therefore appended to the compiled leaves and back
+ * projection rows and accumulated with the retained landmarks, which gives the transform of
+ * find_tform_between_shapes() without the dropped landmarks.
+ */
+struct shape_moments
+{
+    static const int kDim = 4; // M(0,0), M(0,1), M(1,0), M(1,1)
+
+    shape_moments() = default;
+    shape_moments(const fshape& reference, int points)
+    {
+        double mx = 0.0, my = 0.0;
+        for (int i = 0; i < points; i++)
+        {
+            mx += reference(i * 2 + 0), my += reference(i * 2 + 1);
+        }
+        mx /= double(points), my /= double(points);
+
+        dlib::matrix<double, 2, 2> sigma = dlib::zeros_matrix<double>(2, 2);
+        weights.resize(points * 2);
+        for (int i = 0; i < points; i++)
+        {
+            const double dx = reference(i * 2 + 0) - mx, dy = reference(i * 2 + 1) - my;
+            weights[i * 2 + 0] = float(dx / double(points));
+            weights[i * 2 + 1] = float(dy / double(points));
+            sigma(0, 0) += dx * dx, sigma(0, 1) += dx * dy, sigma(1, 1) += dy * dy;
+        }
+        sigma(1, 0) = sigma(0, 1);
+        sigma /= double(points);
+
+        const double trace = sigma(0, 0) + sigma(1, 1), det = dlib::det(sigma);
+        scale = (trace > 0.0) ? (1.0 / trace) : 0.0;
+        inverse = (det != 0.0) ? dlib::inv(sigma) : dlib::zeros_matrix<double>(2, 2);
+    }
+
+    bool empty() const { return weights.empty(); }
+
+    // Moments of a full shape vector (x0, y0, x1, y1, ...):
+    void operator()(const float* shape, float* moments) const
+    {
+        double m[kDim] = { 0.0, 0.0, 0.0, 0.0 };
+        for (std::size_t i = 0; i < weights.size(); i += 2)
+        {
+            m[0] += double(shape[i + 0]) * weights[i + 0];
+            m[1] += double(shape[i + 0]) * weights[i + 1];
+            m[2] += double(shape[i + 1]) * weights[i + 0];
+            m[3] += double(shape[i + 1]) * weights[i + 1];
+        }
+        std::copy(m, m + kDim, moments);
+    }
+
+    // Linear part of the transform from the reference shape to a shape with the given moments:
+    dlib::matrix<float, 2, 2> tform(const float* moments, bool do_affine) const
+    {
+        dlib::matrix<double, 2, 2> M;
+        M = moments[0], moments[1], moments[2], moments[3];
+        if (do_affine)
+        {
+            return dlib::matrix_cast<float>(M * inverse); // M * Sigma^-1
+        }
+
+        // Scaled rotation [a -b; b a], the closed form of the 2D Umeyama solution:
+        dlib::matrix<float, 2, 2> R = dlib::identity_matrix<float>(2);
+        if (scale > 0.0)
+        {
+            const double a = (M(0, 0) + M(1, 1)) * scale, b = (M(1, 0) - M(0, 1)) * scale;
+            R = float(a), float(-b), float(b), float(a);
+        }
+        return R;
+    }
+
+    std::vector<float> weights;         // (r_i - mean(r)) / N
+    double scale = 0.0;                 // 1 / trace(Sigma), similarity
+    dlib::matrix<double, 2, 2> inverse; // Sigma^-1, affine
+};
+
+// ------------------------------------------------------------------------------------
+
 inline dlib::point_transform_affine normalizing_tform(
     const dlib::rectangle& rect)
 /*!
@@ -548,6 +1037,116 @@ inline dlib::point_transform_affine unnormalizing_tform(
 
 // ------------------------------------------------------------------------------------
 
+// Per thread scratch space for normalized sample coordinates:
+struct feature_sample_buffer
+{
+    std::vector<float> x, y;
+
+    static feature_sample_buffer& get(std::size_t n)
+    {
+        static thread_local feature_sample_buffer buffer;
+        buffer.x.resize(n);
+        buffer.y.resize(n);
+        return buffer;
+    }
+};
+
+// Map normalized sample coordinates to the image and read the nearest pixels (8-bit images):
+template <typename image_type>
+void gather_feature_pixel_values(
+    const image_type& img_,
+    const dlib::point_transform_affine& tform_to_img,
+    const feature_sample_buffer& samples,
+    std::vector<float>& feature_pixel_values,
+    std::true_type)
+{
+    const auto& m = tform_to_img.get_m();
+    const auto& b = tform_to_img.get_b();
+    const float H[6] = { float(m(0, 0)), float(m(0, 1)), float(b(0)), float(m(1, 0)), float(m(1, 1)), float(b(1)) };
+
+    const auto* data = static_cast<const uint8_t*>(dlib::image_data(img_));
+    const auto step = static_cast<std::size_t>(dlib::width_step(img_));
+    const int width = int(dlib::num_columns(img_)), height = int(dlib::num_rows(img_));
+    drishti::core::gatherAffineU8(data, step, width, height, H, samples.x.data(), samples.y.data(), feature_pixel_values.data(), int(feature_pixel_values.size()));
+}
+
+// ... and for all other pixel types:
+template <typename image_type>
+void gather_feature_pixel_values(
+    const image_type& img_,
+    const dlib::point_transform_affine& tform_to_img,
+    const feature_sample_buffer& samples,
+    std::vector<float>& feature_pixel_values,
+    std::false_type)
+{
+    const dlib::rectangle area = get_rect(img_);
+    dlib::const_image_view<image_type> img(img_);
+    for (unsigned long i = 0; i < feature_pixel_values.size(); ++i)
+    {
+        dlib::point q = tform_to_img(fpoint(samples.x[i], samples.y[i]));
+        feature_pixel_values[i] = area.contains(q) ? dlib::get_pixel_intensity(img[q.y()][q.x()]) : 0;
+    }
+}
+
+// Image proxy for the pose indexed feature reads: each cascade maps its samples to image
+// coordinates and passes them to an external sampler (e.g., a GPU pass), the cascade never
+// touches pixel memory.  Samples outside the image shall read as zero.
+struct sampled_image
+{
+    using sampler_type = std::function<void(const float* x, const float* y, float* values, int n)>;
+
+    const sampler_type* sampler = nullptr;
+};
+
+inline void gather_feature_pixel_values(
+    const sampled_image& img_,
+    const dlib::point_transform_affine& tform_to_img,
+    const feature_sample_buffer& samples,
+    std::vector<float>& feature_pixel_values)
+{
+    const auto& m = tform_to_img.get_m();
+    const auto& b = tform_to_img.get_b();
+    const float H[6] = { float(m(0, 0)), float(m(0, 1)), float(b(0)), float(m(1, 0)), float(m(1, 1)), float(b(1)) };
+
+    static thread_local feature_sample_buffer pixels;
+    pixels.x.resize(samples.x.size());
+    pixels.y.resize(samples.y.size());
+    for (std::size_t i = 0; i < samples.x.size(); i++)
+    {
+        pixels.x[i] = H[0] * samples.x[i] + H[1] * samples.y[i] + H[2];
+        pixels.y[i] = H[3] * samples.x[i] + H[4] * samples.y[i] + H[5];
+    }
+
+    (*img_.sampler)(pixels.x.data(), pixels.y.data(), feature_pixel_values.data(), int(feature_pixel_values.size()));
+}
+
+// Octave pyramid of an image (level l has 1/2^l of the resolution, i.e., cv::pyrDown), cascade i of
+// a coarse-to-fine model reads its pose indexed features from level shape_predictor::cascade_levels[i]:
+template <typename image_type>
+struct image_pyramid
+{
+    std::vector<image_type> levels;
+};
+
+// The ROI at a pyramid level (pixel i of a level is centered on pixel 2i of the level above it):
+inline dlib::rectangle scale_rect(const dlib::rectangle& rect, int level)
+{
+    const double s = 1.0 / double(1 << level);
+    return dlib::rectangle(std::lround(rect.left() * s), std::lround(rect.top() * s), std::lround(rect.right() * s), std::lround(rect.bottom() * s));
+}
+
+template <typename image_type>
+void gather_feature_pixel_values(
+    const image_type& img_,
+    const dlib::point_transform_affine& tform_to_img,
+    const feature_sample_buffer& samples,
+    std::vector<float>& feature_pixel_values)
+{
+    using pixel_type = typename dlib::image_traits<image_type>::pixel_type;
+    using is_u8 = std::integral_constant<bool, std::is_same<pixel_type, unsigned char>::value>;
+    gather_feature_pixel_values(img_, tform_to_img, samples, feature_pixel_values, is_u8());
+}
+
 template <typename image_type>
 void extract_feature_pixel_values(
     const image_type& img_,
@@ -557,22 +1156,18 @@ void extract_feature_pixel_values(
     std::vector<float>& feature_pixel_values)
 {
     const dlib::point_transform_affine tform_to_img = unnormalizing_tform(rect);
-    const dlib::rectangle area = get_rect(img_);
-    dlib::const_image_view<image_type> img(img_);
     feature_pixel_values.resize(interpolated_features.size());
+
+    // Compute all sample points in the normalized shape space, then map + gather in batches:
+    auto& samples = feature_sample_buffer::get(feature_pixel_values.size());
     for (unsigned long i = 0; i < feature_pixel_values.size(); ++i)
     {
-        auto p = interpolate_feature_point(interpolated_features[i], current_shape);
-        dlib::point q = tform_to_img(p);
-        if (area.contains(q))
-        {
-            feature_pixel_values[i] = dlib::get_pixel_intensity(img[q.y()][q.x()]);
-        }
-        else
-        {
-            feature_pixel_values[i] = 0;
-        }
+        const auto p = interpolate_feature_point(interpolated_features[i], current_shape);
+        samples.x[i] = p.x();
+        samples.y[i] = p.y();
     }
+
+    gather_feature_pixel_values(img_, tform_to_img, samples, feature_pixel_values);
 }
 
 template <typename image_type>
@@ -606,38 +1201,34 @@ void extract_feature_pixel_values(
     const dlib::matrix<float, 2, 2> tform = dlib::matrix_cast<float>(find_tform_between_shapes(reference_shape, current_shape, ellipse_count, do_affine).get_m());
     const dlib::point_transform_affine tform_to_img = unnormalizing_tform(rect);
 
-    const dlib::rectangle area = get_rect(img_);
-
-    dlib::const_image_view<image_type> img(img_);
     feature_pixel_values.resize(reference_pixel_deltas.size());
 
+    // Compute the point in the current shape corresponding to the i-th pixel,
+    // then map all points from the normalized shape space into pixel space and
+    // gather them in batches:
+    //
+    // point p = tform_to_img(tform*reference_pixel_deltas[i] + location(current_shape, reference_pixel_anchor_idx[i]));
+    auto& samples = feature_sample_buffer::get(feature_pixel_values.size());
+    const float t00 = tform(0, 0), t01 = tform(0, 1), t10 = tform(1, 0), t11 = tform(1, 1);
+    for (unsigned long i = 0; i < feature_pixel_values.size(); ++i)
+    {
+        const unsigned long j = reference_pixel_anchor_idx[i] * 2;
+        const auto& d = reference_pixel_deltas[i];
+        samples.x[i] = current_shape(j + 0) + (t00 * d.x()) + (t01 * d.y());
+        samples.y[i] = current_shape(j + 1) + (t10 * d.x()) + (t11 * d.y());
+    }
+
+    gather_feature_pixel_values(img_, tform_to_img, samples, feature_pixel_values);
+
 #if DRISHTI_DLIB_DO_VISUALIZE_FEATURE_POINTS
     cv::Mat canvas;
     cv::cvtColor(dlib::toMat(const_cast<image_type&>(img_)), canvas, cv::COLOR_GRAY2BGR);
-//cv::Mat canvas(area.height(), area.width(), CV_8UC3, cv::Scalar::all(0));
-#endif
-
     for (unsigned long i = 0; i < feature_pixel_values.size(); ++i)
     {
-        // Compute the point in the current shape corresponding to the i-th pixel and
-        // then map it from the normalized shape space into pixel space.
-        // point p = tform_to_img(tform*reference_pixel_deltas[i] + location(current_shape, reference_pixel_anchor_idx[i]));
-
-        auto p0 = location(current_shape, reference_pixel_anchor_idx[i]);
-        auto p1 = tform * reference_pixel_deltas[i];
-        dlib::point p = tform_to_img(p0 + p1);
-        if (area.contains(p))
-        {
-            feature_pixel_values[i] = dlib::get_pixel_intensity(img[p.y()][p.x()]);
-#if DRISHTI_DLIB_DO_VISUALIZE_FEATURE_POINTS
-            cv::circle(canvas, cv::Point(p.x(), p.y()), 2, { 0, 255, 255 }, -1, 8);
-#endif
-        }
-        else
-        {
-            feature_pixel_values[i] = 0; // original behaviour (fastest)
-        }
+        dlib::point p = tform_to_img(fpoint(samples.x[i], samples.y[i]));
+        cv::circle(canvas, cv::Point(p.x(), p.y()), 2, { 0, 255, 255 }, -1, 8);
     }
+#endif
 
 #if DRISHTI_DLIB_DO_VISUALIZE_FEATURE_POINTS
     for (int i = 0; i < current_shape.size() / 2; i++)
@@ -649,6 +1240,56 @@ void extract_feature_pixel_values(
 #endif
 }
 
+// Pose indexed features with the linear part of the transform from the reference shape to current_shape:
+template <typename image_type>
+void extract_feature_pixel_values(
+    const image_type& img_,
+    const dlib::rectangle& rect,
+    const fshape& current_shape,
+    const dlib::matrix<float, 2, 2>& shape_tform,
+    const pose_index_table& table,
+    std::vector<float>& feature_pixel_values)
+{
+    // The fixed point scale (a power of 2) is folded into the shape transform, which is exact:
+    const float scale = pose_index_table::decode(1);
+    const dlib::matrix<float, 2, 2> tform = shape_tform * scale;
+    const dlib::point_transform_affine tform_to_img = unnormalizing_tform(rect);
+
+    feature_pixel_values.resize(table.size());
+
+    auto& samples = feature_sample_buffer::get(feature_pixel_values.size());
+    const float t00 = tform(0, 0), t01 = tform(0, 1), t10 = tform(1, 0), t11 = tform(1, 1);
+    const float* shape = &current_shape(0);
+    const int32_t* anchor = table.anchor.data();
+    const int16_t* dx = table.dx.data();
+    const int16_t* dy = table.dy.data();
+    float* x = samples.x.data();
+    float* y = samples.y.data();
+    for (std::size_t i = 0; i < table.size(); ++i)
+    {
+        const float u = float(dx[i]), v = float(dy[i]);
+        x[i] = shape[anchor[i] + 0] + (t00 * u) + (t01 * v);
+        y[i] = shape[anchor[i] + 1] + (t10 * u) + (t11 * v);
+    }
+
+    gather_feature_pixel_values(img_, tform_to_img, samples, feature_pixel_values);
+}
+
+template <typename image_type>
+void extract_feature_pixel_values(
+    const image_type& img_,
+    const dlib::rectangle& rect,
+    const fshape& current_shape,
+    const fshape& reference_shape,
+    const pose_index_table& table,
+    std::vector<float>& feature_pixel_values,
+    int ellipse_count = 0,
+    bool do_affine = false)
+{
+    const dlib::matrix<float, 2, 2> tform = dlib::matrix_cast<float>(find_tform_between_shapes(reference_shape, current_shape, ellipse_count, do_affine).get_m());
+    extract_feature_pixel_values(img_, rect, current_shape, tform, table, feature_pixel_values);
+}
+
 DRISHTI_END_NAMESPACE(impl) // end namespace impl
 
 // ----------------------------------------------------------------------------------------
@@ -749,68 +1390,338 @@ public:
                 }
             }
         }
-    }
+    }
+
+    void populate_f16()
+    {
+        for (auto& f : forests)
+        {
+            for (auto& g : f)
+            {
+                g.leaf_values_16.resize(g.leaf_values.size());
+                for (int i = 0; i < g.leaf_values.size(); i++)
+                {
+                    auto& leaf = g.leaf_values[i];
+                    auto& leaf16 = g.leaf_values_16[i];
+                    leaf16.set_size(leaf.size());
+                    drishti::core::convertFixedPoint(&leaf(0, 0), &leaf16(0, 0), int(leaf.size()), FIXED_PRECISION);
+                }
+            }
+        }
+
+        pack();
+    }
+
+    // Fixed point pose indexing tables (see impl::pose_index_table), the float encoding is then
+    // replaced by the represented values, so both views of the model are the same:
+    void compile_pose_tables()
+    {
+        if (pose_tables.size() != anchor_idx.size())
+        {
+            pose_tables.resize(anchor_idx.size());
+            for (std::size_t i = 0; i < anchor_idx.size(); i++)
+            {
+                pose_tables[i].compile(anchor_idx[i], deltas[i]);
+            }
+        }
+        for (std::size_t i = 0; i < pose_tables.size(); i++)
+        {
+            pose_tables[i].get(anchor_idx[i], deltas[i]);
+        }
+    }
+
+    // Compile the contiguous evaluation layout (call after deserialization or leaf updates):
+    void pack()
+    {
+        compile_pose_tables();
+
+        packed_forests.resize(forests.size());
+        for (std::size_t i = 0; i < forests.size(); i++)
+        {
+            if (!packed_forests[i].is_quantized() && !packed_forests[i].is_mapped()) // neither has trees to pack
+            {
+                packed_forests[i].pack(forests[i]);
+            }
+        }
+
+        // Pose indexing transform of landmark subset models (see compile_landmarks()):
+        m_moments = m_landmarks.empty() ? impl::shape_moments() : impl::shape_moments(initial_shape, int(num_parts()));
+
+        // Fused back projection for PCA space regression (see back_project()):
+        m_back_projection = m_pca ? std::make_shared<const drishti::ml::StandardizedPCA::BackProjection>(compile_back_projection(m_pca->getBackProjection())) : nullptr;
+
+#if DRISHTI_BUILD_REGRESSION_FIXED_POINT && DRISHTI_BUILD_PARALLEL_BOOSTING
+        // Fixed point boosting is distributed over a persistent team sized from the core count:
+        m_num_workers = std::max(1U, std::thread::hardware_concurrency());
+        if (!m_team || (m_team->size() != int(m_num_workers)))
+        {
+            m_team = (m_num_workers > 1) ? std::make_shared<drishti::core::WorkerTeam>(int(m_num_workers)) : nullptr;
+        }
+        m_worker_sums.resize(m_num_workers);
+#endif
+    }
+
+    // Offline leaf quantization (bits = 16 or 8, see impl::packed_forest::quantize()) prior to
+    // serialization.  The float leaves are released and the cascades are evaluated from the
+    // packed forests only.  Returns false (and leaves the model unchanged) on failure.
+    bool quantize(int bits)
+    {
+        pack();
+
+        std::vector<impl::packed_forest> quantized = packed_forests;
+        for (auto& forest : quantized)
+        {
+            if (!forest.quantize(bits))
+            {
+                return false;
+            }
+        }
+
+        packed_forests = quantized;
+        for (auto& forest : forests)
+        {
+            std::fill(forest.begin(), forest.end(), impl::regression_tree()); // retain the tree count
+        }
+        m_leaf_bits = bits;
+        return true;
+    }
+
+    shape_predictor(
+        const fshape& initial_shape_,
+        const std::vector<std::vector<impl::regression_tree>>& forests_,
+        const std::vector<PointVecf>& pixel_coordinates,
+        StandardizedPCAPtr& pca,
+        bool npd = false,
+        bool do_affine = false,
+        int ellipse_count = 0)
+        : initial_shape(initial_shape_)
+        , forests(forests_)
+        , m_pca(pca)
+        , m_ellipse_count(ellipse_count)
+        , m_npd(npd)
+        , m_do_affine(do_affine)
+    /*!
+        requires
+            - initial_shape.size()%2 == 0
+            - forests.size() == pixel_coordinates.size() == the number of cascades
+            - for all valid i:
+                - all the index values in forests[i] are less than pixel_coordinates[i].size()
+            - for all valid i and j:
+                - forests[i][j].leaf_values.size() is a power of 2.
+                  (i.e. we require a tree with all the levels fully filled out.
+                - forests[i][j].leaf_values.size() == forests[i][j].splits.size()+1
+                  (i.e. there need to be the right number of leaves given the number of splits in the tree)
+        !*/
+    {
+        anchor_idx.resize(pixel_coordinates.size());
+        deltas.resize(pixel_coordinates.size());
+        // Each cascade uses a different set of pixels for its features.  We compute
+        // their representations relative to the initial shape now and save it.
+        for (unsigned long i = 0; i < pixel_coordinates.size(); ++i)
+        {
+            impl::create_shape_relative_encoding(initial_shape, pixel_coordinates[i], anchor_idx[i], deltas[i], ellipse_count);
+        }
+        compile_pose_tables();
+
+        m_num_workers = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    unsigned long num_parts() const
+    {
+        return initial_shape.size() / 2;
+    }
+
+    // Original index of each estimated landmark (empty : all of them, see compile_landmarks()):
+    std::vector<int> output_landmarks() const
+    {
+        return std::vector<int>(m_landmarks.begin(), m_landmarks.begin() + m_landmark_outputs);
+    }
+
+    // Restrict the model to a subset of the landmarks (original indices), which are then the
+    // only estimated points, in the given order.  The landmarks anchoring the pose indexed
+    // features are retained internally, or with reanchor the features of dropped landmarks are
+    // moved to the nearest retained landmark of the mean shape (an approximation, since the
+    // offset is then transformed with the pose rather than following the dropped landmark).
+    // Full shape models store, accumulate and convert the compiled leaves (the retained
+    // coordinates and the shape moments, see impl::shape_moments) and PCA models back project
+    // onto the compiled coordinates only.  Requires float leaves for full shape models, models
+    // with ellipses aren't supported.  Returns false (and leaves the model unchanged) on failure.
+    bool compile_landmarks(const std::vector<int>& landmarks, bool reanchor = false)
+    {
+        const int points = int(num_parts());
+        const bool has_leaves = !forests.empty() && !forests.front().empty() && !forests.front().front().leaf_values.empty();
+        if (landmarks.empty() || !m_landmarks.empty() || m_ellipse_count || (points < 2) || (!m_pca && !has_leaves))
+        {
+            return false;
+        }
+
+        std::vector<int> index(points, -1), keep;
+        auto add = [&](int i) {
+            if (index[i] < 0)
+            {
+                index[i] = int(keep.size());
+                keep.push_back(i);
+            }
+        };
+
+        for (auto i : landmarks)
+        {
+            if ((i < 0) || (i >= points))
+            {
+                return false;
+            }
+            add(i);
+        }
+        const int outputs = int(keep.size());
+
+        // Landmarks read by the pose indexed features:
+        auto features = anchor_idx;
+        auto offsets = deltas;
+        for (std::size_t c = 0; c < features.size(); c++)
+        {
+            for (std::size_t j = 0; j < features[c].size(); j++)
+            {
+                const int i = features[c][j];
+                if (reanchor && (index[i] < 0))
+                {
+                    const fpoint p = impl::location(initial_shape, i);
+                    int nearest = keep.front();
+                    for (int k = 0; k < outputs; k++)
+                    {
+                        if ((p - impl::location(initial_shape, keep[k])).length_squared() < (p - impl::location(initial_shape, nearest)).length_squared())
+                        {
+                            nearest = keep[k];
+                        }
+                    }
+                    offsets[c][j] += p - impl::location(initial_shape, nearest);
+                    features[c][j] = static_cast<unsigned short>(nearest);
+                }
+                add(features[c][j]);
+            }
+        }
+
+        auto interpolated = interpolated_features;
+        for (auto& cascade : interpolated)
+        {
+            for (auto& f : cascade)
+            {
+                add(f.f1);
+                add(f.f2);
+                add(f.f3);
+            }
+        }
+
+        // Remap the features to the compiled shape:
+        for (auto& cascade : features)
+        {
+            for (auto& i : cascade)
+            {
+                i = static_cast<unsigned short>(index[i]);
+            }
+        }
+        for (auto& cascade : interpolated)
+        {
+            for (auto& f : cascade)
+            {
+                f.f1 = static_cast<uint16_t>(index[f.f1]);
+                f.f2 = static_cast<uint16_t>(index[f.f2]);
+                f.f3 = static_cast<uint16_t>(index[f.f3]);
+            }
+        }
 
-    void populate_f16()
-    {
-        for (auto& f : forests)
+        anchor_idx = features;
+        deltas = offsets;
+        interpolated_features = interpolated;
+        pose_tables.clear();
+
+        m_landmarks = keep;
+        m_landmark_outputs = outputs;
+        m_moments = impl::shape_moments(initial_shape, points);
+
+        // PCA leaves are coefficients, which are back projected onto the compiled shape (see pack()):
+        if (m_pca)
         {
-            for (auto& g : f)
+            pack();
+            return true;
+        }
+
+        bool has_16 = false;
+        for (auto& forest : forests)
+        {
+            for (auto& tree : forest)
             {
-                g.leaf_values_16.resize(g.leaf_values.size());
-                for (int i = 0; i < g.leaf_values.size(); i++)
+                for (auto& leaf : tree.leaf_values)
                 {
-                    auto& leaf = g.leaf_values[i];
-                    auto& leaf16 = g.leaf_values_16[i];
-                    leaf16.set_size(leaf.size());
-                    drishti::core::convertFixedPoint(&leaf(0, 0), &leaf16(0, 0), int(leaf.size()), FIXED_PRECISION);
+                    leaf = compile_shape(leaf);
                 }
+                has_16 |= !tree.leaf_values_16.empty();
             }
         }
+
+        packed_forests.clear();
+        if (has_16)
+        {
+            populate_f16(); // and pack()
+        }
+        else
+        {
+            pack();
+        }
+        return true;
     }
 
-    shape_predictor(
-        const fshape& initial_shape_,
-        const std::vector<std::vector<impl::regression_tree>>& forests_,
-        const std::vector<PointVecf>& pixel_coordinates,
-        StandardizedPCAPtr& pca,
-        bool npd = false,
-        bool do_affine = false,
-        int ellipse_count = 0)
-        : initial_shape(initial_shape_)
-        , forests(forests_)
-        , m_pca(pca)
-        , m_ellipse_count(ellipse_count)
-        , m_npd(npd)
-        , m_do_affine(do_affine)
-    /*!
-        requires
-            - initial_shape.size()%2 == 0
-            - forests.size() == pixel_coordinates.size() == the number of cascades
-            - for all valid i:
-                - all the index values in forests[i] are less than pixel_coordinates[i].size()
-            - for all valid i and j:
-                - forests[i][j].leaf_values.size() is a power of 2.
-                  (i.e. we require a tree with all the levels fully filled out.
-                - forests[i][j].leaf_values.size() == forests[i][j].splits.size()+1
-                  (i.e. there need to be the right number of leaves given the number of splits in the tree)
-        !*/
+    // Compiled layout of a full shape vector: the retained landmarks followed by the moments
+    // (result is reused, so that steady state regression doesn't allocate):
+    void compile_shape(const fshape& shape, fshape& result) const
     {
-        anchor_idx.resize(pixel_coordinates.size());
-        deltas.resize(pixel_coordinates.size());
-        // Each cascade uses a different set of pixels for its features.  We compute
-        // their representations relative to the initial shape now and save it.
-        for (unsigned long i = 0; i < pixel_coordinates.size(); ++i)
+        if (m_landmarks.empty())
+        {
+            result = shape;
+            return;
+        }
+
+        result.set_size(int(m_landmarks.size() * 2) + impl::shape_moments::kDim);
+        for (std::size_t k = 0; k < m_landmarks.size(); k++)
         {
-            impl::create_shape_relative_encoding(initial_shape, pixel_coordinates[i], anchor_idx[i], deltas[i]);
+            result(k * 2 + 0) = shape(m_landmarks[k] * 2 + 0);
+            result(k * 2 + 1) = shape(m_landmarks[k] * 2 + 1);
         }
+        m_moments(&shape(0), &result(m_landmarks.size() * 2));
+    }
 
-        m_num_workers = 4; //cv::getNumberOfCPUs();
+    fshape compile_shape(const fshape& shape) const
+    {
+        fshape result;
+        compile_shape(shape, result);
+        return result;
     }
 
-    unsigned long num_parts() const
+    // ... and of the back projection rows and offsets (the moments are linear):
+    drishti::ml::StandardizedPCA::BackProjection compile_back_projection(const drishti::ml::StandardizedPCA::BackProjection& bp) const
     {
-        return initial_shape.size() / 2;
+        if (m_landmarks.empty())
+        {
+            return bp;
+        }
+
+        auto compile = [&](const float* src, float* dst) {
+            const fshape shape = compile_shape(fshape(dlib::mat(src, bp.dim)));
+            std::copy(&shape(0), &shape(0) + shape.size(), dst);
+        };
+
+        drishti::ml::StandardizedPCA::BackProjection result;
+        result.components = bp.components;
+        result.dim = int(m_landmarks.size() * 2) + impl::shape_moments::kDim;
+        result.rows.resize(result.components * result.dim);
+        result.offset.resize(result.dim);
+        result.offset_full.resize(result.dim);
+        for (int i = 0; i < bp.components; i++)
+        {
+            compile(bp.getRow(i), &result.rows[i * result.dim]);
+        }
+        compile(bp.offset.data(), result.offset.data());
+        compile(bp.offset_full.data(), result.offset_full.data());
+        return result;
     }
 
     static void project(drishti::ml::StandardizedPCA& pca, fshape& src, fshape& dst)
@@ -826,117 +1737,303 @@ public:
         memcpy(&dst(0), back_projection.ptr<float>(), sizeof(float) * back_projection.cols);
     }
 
-    template <typename image_type>
-    dlib::full_object_detection operator()(
-        const image_type& img,
-        const dlib::rectangle& rect,
-        fshape starter_shape,
-        int stages = std::numeric_limits<int>::max()) const // early temrination
+    // Pyramid level read by cascade iter (0 : full resolution), clamped to the available levels:
+    int cascade_level(std::size_t iter, int levels = std::numeric_limits<int>::max()) const
     {
-        using namespace impl;
+        const int level = (iter < cascade_levels.size()) ? cascade_levels[iter] : 0;
+        return std::max(std::min(level, levels - 1), 0);
+    }
 
-        bool do_pca = m_pca ? true : false;
+    // Number of pyramid levels read by the cascades (1 : full resolution only):
+    int num_levels() const
+    {
+        return cascade_levels.empty() ? 1 : (*std::max_element(cascade_levels.begin(), cascade_levels.end()) + 1);
+    }
 
-        cv::Mat1f cs;
-        fshape current_shape = starter_shape, current_shape_full_; // for PCA mode
+    // Dimension of the shape updates for cascade iter (i.e., the number of PCA coefficients):
+    int cascade_dim(std::size_t iter) const
+    {
+        const bool has_packed = (iter < packed_forests.size()) && !packed_forests[iter].empty();
+        return has_packed ? packed_forests[iter].leaf_dim : int(forests[iter][0].leaf_values[0].size());
+    }
 
-        if (do_pca)
+    // Back project the leading n PCA coefficients of src into dst as a single GEMV with the
+    // precomputed (truncated) eigenvector block, without cv::Mat temporaries:
+    void back_project(int n, const fshape& src, fshape& dst) const
+    {
+        if (!m_back_projection)
         {
-            project(*m_pca, starter_shape, current_shape_full_);
+            fshape shape(m_pca->getTransposedEigenvectors().rows);
+            back_project(*m_pca, n, const_cast<fshape&>(src), shape);
+            dst = compile_shape(shape);
+            return;
         }
 
-        std::vector<float> feature_pixel_values;
-        size_t forestCount = std::min(int(forests.size()), stages);
-        for (unsigned long iter = 0; iter < forestCount; ++iter)
+        using RowMajorMatrix = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+        const auto& bp = *m_back_projection;
+        dst.set_size(bp.dim);
+
+        Eigen::Map<const RowMajorMatrix> rows(bp.rows.data(), n, bp.dim);
+        Eigen::Map<const Eigen::VectorXf> y(&src(0), n), offset(bp.getOffset(n), bp.dim);
+        Eigen::Map<Eigen::VectorXf> x(&dst(0), bp.dim);
+        x.noalias() = rows.transpose() * y;
+        x += offset;
+    }
+
+    // Split trees [0, count) into one block per worker and sum the fixed point accumulators
+    // for each block into shape.  Blocks run on the persistent worker team, or on the calling
+    // thread if the team is busy (i.e., concurrent or nested regression).
+    template <typename Accumulate>
+    void accumulate_blocks(int count, int dim, Accumulate&& accumulate_block, DVec32s& shape) const
+    {
+        shape = dlib::zeros_matrix<int32_t>(dim, 1);
+
+#if DRISHTI_BUILD_PARALLEL_BOOSTING
+        if (m_team)
         {
-            auto& cs_ = current_shape;
-            auto& is_ = initial_shape; // this is used to map pose indexed features to current shape
+            const int workers = m_team->size();
+            const int block_size = std::max(1, (count + workers - 1) / workers);
 
-            // Previously had for loop
-            if (do_pca)
+            // clang-format off
+            auto task = [&](int block)
             {
-                // Get euclidean model for current shape space estimate:
-                int current_pca_dim = int(forests[iter][0].leaf_values[0].size());
-                back_project(*m_pca, current_pca_dim, current_shape_full_, cs_);
-            }
+                auto& sum = m_worker_sums[block]; // reused, exclusive while the team runs
+                sum = dlib::zeros_matrix<int32_t>(dim, 1);
+
+                const int block_begin = block * block_size;
+                const int block_end = std::min(count, block_begin + block_size);
+                if (block_begin < block_end)
+                {
+                    accumulate_block(block_begin, block_end, sum);
+                }
+            };
+            auto join = [&]()
+            {
+                for (int i = 0; i < workers; i++)
+                {
+                    shape += m_worker_sums[i];
+                }
+            };
+            // clang-format on
 
-            if (interpolated_features.size())
+            if (m_team->tryRun(task, join))
             {
-                extract_feature_pixel_values(img, rect, cs_, interpolated_features[iter], feature_pixel_values);
+                return;
             }
-            else
+        }
+#endif
+
+        accumulate_block(0, count, shape);
+    }
+
+    // Add the float leaves of a packed cascade to shape (or initialize it if empty):
+    void accumulate_float(const impl::packed_forest& forest, const std::vector<float>& feature_pixel_values, fshape& shape) const
+    {
+        if (!shape.size())
+        {
+            shape = dlib::zeros_matrix<float>(forest.leaf_dim, 1); // else update current_shape in place
+        }
+        forest.accumulate(feature_pixel_values, m_npd, 0, forest.num_trees, &shape(0));
+    }
+
+    // Per ROI state for cascaded regression (see begin_regression(), apply_cascade() and end_regression()):
+    struct regression_state
+    {
+        fshape current_shape;
+        fshape current_shape_full_; // for PCA mode
+        fshape previous_shape;      // for full shape mode
+        std::vector<float> feature_pixel_values;
+    };
+
+    // Per thread regression states, reused across calls, so that steady state tracking doesn't
+    // allocate.  Batches fanned out to other threads use the states of the calling thread.
+    struct regression_workspace
+    {
+        std::vector<regression_state> states;
+        std::vector<int> active;
+        std::vector<float> updates;
+
+        static regression_workspace& get(std::size_t n)
+        {
+            static thread_local regression_workspace workspace;
+            if (workspace.states.size() < n)
             {
-                extract_feature_pixel_values(img, rect, cs_, is_, anchor_idx[iter], deltas[iter], feature_pixel_values, m_ellipse_count, m_do_affine);
+                workspace.states.resize(n);
             }
+            return workspace;
+        }
+    };
+
+    // The starter shape has all the landmarks (see num_parts()), also for compiled models:
+    void begin_regression(regression_state& state, fshape starter_shape) const
+    {
+        compile_shape(starter_shape, state.current_shape);
+        if (m_pca)
+        {
+            project(*m_pca, starter_shape, state.current_shape_full_);
+        }
+    }
+
+    // Apply the regression trees of cascade iter to a single ROI and return the root mean square
+    // of the shape update in regression space (normalized ROI coordinates or PCA coefficients):
+    template <typename image_type>
+    float apply_cascade(unsigned long iter, const image_type& img, const dlib::rectangle& rect, regression_state& state) const
+    {
+        using namespace impl;
+
+        const bool do_pca = m_pca ? true : false;
+        auto& current_shape = state.current_shape;
+        auto& current_shape_full_ = state.current_shape_full_;
+        auto& feature_pixel_values = state.feature_pixel_values;
+
+        auto& cs_ = current_shape;
+        auto& is_ = initial_shape; // this is used to map pose indexed features to current shape
+
+        // Previously had for loop
+        if (do_pca)
+        {
+            // Get euclidean model for current shape space estimate:
+            int current_pca_dim = cascade_dim(iter);
+            back_project(current_pca_dim, current_shape_full_, cs_);
+        }
 
-            fshape current_shape_;
-            auto& active_shape = do_pca ? current_shape_ : current_shape;
+        if (interpolated_features.size())
+        {
+            extract_feature_pixel_values(img, rect, cs_, interpolated_features[iter], feature_pixel_values);
+        }
+        else if (!m_landmarks.empty())
+        {
+            const auto tform = m_moments.tform(&cs_(m_landmarks.size() * 2), m_do_affine);
+            extract_feature_pixel_values(img, rect, cs_, tform, pose_tables[iter], feature_pixel_values);
+        }
+        else
+        {
+            extract_feature_pixel_values(img, rect, cs_, is_, pose_tables[iter], feature_pixel_values, m_ellipse_count, m_do_affine);
+        }
+
+        fshape current_shape_; // PCA updates (empty in full shape mode)
+        auto& active_shape = do_pca ? current_shape_ : current_shape;
+        if (!do_pca)
+        {
+            state.previous_shape = current_shape; // same size every cascade (no allocation)
+        }
+
+        const bool has_packed = (iter < packed_forests.size()) && !packed_forests[iter].empty();
 
 #if DRISHTI_BUILD_REGRESSION_FIXED_POINT
-            // Fixed point is currently only working for PCA in most cases (check numerical overflow)
-            DVec16s shape_accumulator;
-#if DRISHTI_BUILD_PARALLEL_BOOSTING
-            {
-                const unsigned long num = forests[iter].size();
-                const unsigned long block_size = std::max(1UL, (num + m_num_workers - 1) / m_num_workers);
-                std::vector<fshape> block_sums(m_num_workers);
-                std::vector<DVec16s> shape_accumulators(m_num_workers);
-                drishti::core::ParallelHomogeneousLambda harness = [&](int block) {
-                    const unsigned long block_begin = block * block_size;
-                    const unsigned long block_end = std::min(num, block_begin + block_size);
-                    for (unsigned long i = block_begin; i < block_end; ++i)
-                    {
-                        auto& f = forests[iter][i];
-                        add16sAnd16s(shape_accumulators[block], f(feature_pixel_values, Fixed(), m_npd), shape_accumulators[block]);
-                    }
-                };
+        if (has_packed && packed_forests[iter].has_fixed_point())
+        {
+            // Overflow safe per cascade scale (PCA and full shape models):
+            const auto& forest = packed_forests[iter];
+            auto block = [&](int begin, int end, DVec32s& sum) {
+                forest.accumulate(feature_pixel_values, m_npd, begin, end, &sum(0));
+            };
 
-                //harness({0,static_cast<int>(num_workers)});
-                cv::parallel_for_({ 0, static_cast<int>(m_num_workers) }, harness);
+            DVec32s shape_accumulator;
+            accumulate_blocks(forest.num_trees, forest.leaf_dim, block, shape_accumulator);
 
-                for (auto& s : shape_accumulators)
-                {
-                    add16sAnd16s(shape_accumulator, s, shape_accumulator);
-                }
+            // fixed -> float
+            const float scale = forest.fixed_point_scale();
+            if (!active_shape.size())
+            {
+                active_shape = dlib::zeros_matrix<float>(forest.leaf_dim, 1); // else update current_shape in place
             }
-#else
-            for (auto& f : forests[iter])
+            for (int i = 0; i < shape_accumulator.size(); i++)
             {
-                add16sAnd16s(shape_accumulator, f(feature_pixel_values, Fixed(), m_npd), shape_accumulator);
+                active_shape(i) += float(shape_accumulator(i)) * scale;
             }
-#endif
+        }
+        else if (has_packed)
+        {
+            accumulate_float(packed_forests[iter], feature_pixel_values, active_shape);
+        }
+        else
+        {
+            // Fixed point is currently only working for PCA in most cases (check numerical overflow)
+            const auto& forest = forests[iter];
+            auto block = [&](int begin, int end, DVec32s& sum) {
+                for (int i = begin; i < end; ++i)
+                {
+                    add16sAnd32s(sum, forest[i](feature_pixel_values, Fixed(), m_npd), sum);
+                }
+            };
 
-            // fixed -> float
+            DVec32s shape_accumulator;
+            accumulate_blocks(int(forest.size()), int(forest.front().leaf_values_16.front().size()), block, shape_accumulator);
+
+            // fixed -> float (exact, the scale is a power of two)
             active_shape.set_size(shape_accumulator.size());
-            for (int i = 0; i < shape_accumulator.size(); i++)
+            if (shape_accumulator.size())
             {
-                active_shape(i) = float(shape_accumulator(i)) / float(1 << FIXED_PRECISION);
+                drishti::core::convert32sTo32f(&shape_accumulator(0), &active_shape(0), int(shape_accumulator.size()), 1.f / float(1 << FIXED_PRECISION));
             }
+        }
 
 #else  /* else don't DRISHTI_BUILD_REGRESSION_FIXED_POINT */
+        if (has_packed)
+        {
+            accumulate_float(packed_forests[iter], feature_pixel_values, active_shape);
+        }
+        else
+        {
             for (auto& f : forests[iter])
             {
                 add32F(active_shape, f(feature_pixel_values, m_npd), active_shape);
             }
+        }
 #endif /* DRISHTI_BUILD_REGRESSION_FIXED_POINT */
 
-            if (do_pca)
-            {
-                dlib::set_rowm(current_shape_full_, dlib::range(0, current_shape_.size() - 1)) += current_shape_;
-            }
+        if (do_pca)
+        {
+            dlib::set_rowm(current_shape_full_, dlib::range(0, current_shape_.size() - 1)) += current_shape_;
+        }
+
+        // Lazy dlib expressions, no temporaries (the landmarks of compiled models exclude the moments):
+        const long n = do_pca ? current_shape_.size() : (m_landmarks.empty() ? current_shape.size() : long(m_landmarks.size() * 2));
+        if (!n)
+        {
+            return 0.f;
         }
+        const float energy = do_pca ? dlib::sum(dlib::squared(current_shape_)) : dlib::sum(dlib::squared(dlib::rowm(current_shape - state.previous_shape, dlib::range(0, n - 1))));
+        return std::sqrt(energy / float(n));
+    }
+
+    // Coarse-to-fine: each cascade reads the level recorded in the model (see cascade_levels), the
+    // shape is normalized to the ROI and doesn't depend on the level:
+    template <typename image_type>
+    float apply_cascade(unsigned long iter, const impl::image_pyramid<image_type>& pyramid, const dlib::rectangle& rect, regression_state& state) const
+    {
+        const int level = cascade_level(iter, int(pyramid.levels.size()));
+        return apply_cascade(iter, pyramid.levels[level], impl::scale_rect(rect, level), state);
+    }
+
+    template <typename image_type>
+    dlib::full_object_detection end_regression(const impl::image_pyramid<image_type>& pyramid, const dlib::rectangle& rect, regression_state& state) const
+    {
+        return end_regression(pyramid.levels.front(), rect, state);
+    }
+
+    template <typename image_type>
+    dlib::full_object_detection end_regression(const image_type& img, const dlib::rectangle& rect, regression_state& state) const
+    {
+        using namespace impl;
+
+        const bool do_pca = m_pca ? true : false;
+        auto& current_shape = state.current_shape;
+        auto& current_shape_full_ = state.current_shape_full_;
 
         if (do_pca)
         {
             // Convert the final model back to euclidean
-            int current_pca_dim = int(forests.back()[0].leaf_values[0].size());
-            back_project(*m_pca, current_pca_dim, current_shape_full_, current_shape);
+            int current_pca_dim = cascade_dim(forests.size() - 1);
+            back_project(current_pca_dim, current_shape_full_, current_shape);
         }
 
         // convert the current_shape into a full_object_detection
         const dlib::point_transform_affine tform_to_img = unnormalizing_tform(rect);
 
-        int point_length = int((current_shape.size() - (m_ellipse_count * 5)) / 2);
+        int point_length = m_landmarks.empty() ? int((current_shape.size() - (m_ellipse_count * 5)) / 2) : m_landmark_outputs;
         std::vector<dlib::point> parts(point_length + (m_ellipse_count * 5));
         for (unsigned long i = 0; i < point_length; ++i)
         {
@@ -993,6 +2090,88 @@ public:
         return dlib::full_object_detection(rect, parts);
     }
 
+    template <typename image_type>
+    dlib::full_object_detection operator()(
+        const image_type& img,
+        const dlib::rectangle& rect,
+        fshape starter_shape,
+        int stages = std::numeric_limits<int>::max(), // early temrination
+        float convergence = 0.f) const                // stop when the update falls below this (0 : off)
+    {
+        auto& state = regression_workspace::get(1).states.front();
+        begin_regression(state, starter_shape);
+
+        const unsigned long forestCount = std::min(int(forests.size()), stages);
+        for (unsigned long iter = 0; iter < forestCount; ++iter)
+        {
+            if (apply_cascade(iter, img, rect, state) < convergence)
+            {
+                break;
+            }
+        }
+
+        return end_regression(img, rect, state);
+    }
+
+    // Batch regression for multiple ROIs (i.e., faces or initializations).  Each cascade is
+    // applied to all ROIs before moving on to the next one, so that the forest for the
+    // current cascade remains in cache.  ROIs can optionally be distributed across the shared
+    // core::Executor, which is safe when the caller is itself a task on the executor.
+    // ROIs whose shape update falls below the convergence threshold skip the remaining cascades.
+    template <typename image_type>
+    std::vector<dlib::full_object_detection> operator()(
+        const std::vector<image_type>& images,
+        const std::vector<dlib::rectangle>& rects,
+        const std::vector<fshape>& starter_shapes,
+        int stages = std::numeric_limits<int>::max(),
+        bool do_parallel = false,
+        float convergence = 0.f) const
+    /*!
+        requires
+            - images.size() == rects.size() == starter_shapes.size()
+    !*/
+    {
+        DLIB_ASSERT((images.size() == rects.size()) && (images.size() == starter_shapes.size()));
+
+        const int count = int(images.size());
+        auto& workspace = regression_workspace::get(count);
+        auto& states = workspace.states;
+        for (int i = 0; i < count; i++)
+        {
+            begin_regression(states[i], starter_shapes[i]);
+        }
+
+        // Indices of the ROIs that are still being refined:
+        auto& active = workspace.active;
+        active.resize(count);
+        std::iota(active.begin(), active.end(), 0);
+
+        auto& updates = workspace.updates;
+        updates.assign(count, 0.f);
+
+        const unsigned long forestCount = std::min(int(forests.size()), stages);
+        for (unsigned long iter = 0; (iter < forestCount) && active.size(); ++iter)
+        {
+            auto harness = [&](int j) {
+                const int i = active[j];
+                updates[i] = apply_cascade(iter, images[i], rects[i], states[i]);
+            };
+
+            auto* executor = (do_parallel && (active.size() > 1)) ? drishti::core::Executor::getInstance().get() : nullptr;
+            drishti::core::parallel_for(executor, int(active.size()), harness);
+
+            active.erase(std::remove_if(active.begin(), active.end(), [&](int i) { return updates[i] < convergence; }), active.end());
+        }
+
+        std::vector<dlib::full_object_detection> results;
+        results.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+            results.push_back(end_regression(images[i], rects[i], states[i]));
+        }
+        return results;
+    }
+
     template <typename image_type>
     dlib::full_object_detection operator()(
         const image_type& img,
@@ -1026,6 +2205,8 @@ public:
         dlib::deserialize(item.forests, in);
         dlib::deserialize(item.anchor_idx, in);
         dlib::deserialize(item.deltas, in);
+        item.pose_tables.clear();
+        item.pack();
 #endif // !DRISHTI_BUILD_MIN_SIZE
     }
 
@@ -1034,19 +2215,95 @@ public:
         m_streamLogger = logger;
     }
 
+    // Heap footprint by component (memory mapped packed arrays are not counted):
+    drishti::core::MemoryUsage memory_usage() const
+    {
+        using drishti::core::getMemoryUsage;
+
+        std::size_t trees = 0, leaves = 0, leaves_16 = 0;
+        for (const auto& forest : forests)
+        {
+            trees += getMemoryUsage(forest);
+            for (const auto& tree : forest)
+            {
+                trees += getMemoryUsage(tree.splits);
+                leaves += getMemoryUsage(tree.leaf_values) + getMemoryUsage(tree.leaf_values_16);
+                for (const auto& leaf : tree.leaf_values)
+                {
+                    leaves += leaf.size() * sizeof(float);
+                }
+                for (const auto& leaf : tree.leaf_values_16)
+                {
+                    leaves_16 += leaf.size() * sizeof(int16_t);
+                }
+            }
+        }
+
+        std::size_t packed = 0;
+        for (const auto& forest : packed_forests)
+        {
+            packed += getMemoryUsage(forest.splits) + getMemoryUsage(forest.leaves) + getMemoryUsage(forest.leaves_16);
+            packed += getMemoryUsage(forest.leaves_8) + getMemoryUsage(forest.tree_scales);
+        }
+
+        std::size_t features = 0;
+        for (std::size_t i = 0; i < anchor_idx.size(); i++)
+        {
+            features += getMemoryUsage(anchor_idx[i]);
+        }
+        for (const auto& delta : deltas)
+        {
+            features += getMemoryUsage(delta);
+        }
+        for (const auto& table : pose_tables)
+        {
+            features += getMemoryUsage(table.anchor) + getMemoryUsage(table.dx) + getMemoryUsage(table.dy);
+        }
+        for (const auto& interpolated : interpolated_features)
+        {
+            features += getMemoryUsage(interpolated);
+        }
+
+        std::size_t pca = m_pca ? m_pca->getMemoryUsage() : 0;
+        if (m_back_projection)
+        {
+            pca += getMemoryUsage(m_back_projection->rows) + getMemoryUsage(m_back_projection->offset) + getMemoryUsage(m_back_projection->offset_full);
+        }
+
+        drishti::core::MemoryUsage usage;
+        usage.add("forests", trees + leaves);
+        usage.add("leaf_values_16", leaves_16);
+        usage.add("packed_forests", packed);
+        usage.add("features", features);
+        usage.add("pca", pca);
+        return usage;
+    }
+
     fshape initial_shape;
     std::vector<std::vector<impl::regression_tree>> forests;
+    std::vector<impl::packed_forest> packed_forests; // evaluation layout for forests (see pack())
+    int m_leaf_bits = 32;                            // 32 : float leaves, 16 or 8 : quantize()
+    std::vector<int> cascade_levels;                 // pyramid level per cascade (empty : full resolution)
 
-    // Pose indexing relative to nearest landmark points:
+    // Pose indexing relative to nearest landmark points (the float view of pose_tables):
     std::vector<std::vector<unsigned short>> anchor_idx;
     std::vector<PointVecf> deltas;
+    std::vector<impl::pose_index_table> pose_tables; // see compile_pose_tables()
 
     // PCA reduction:
     std::shared_ptr<drishti::ml::StandardizedPCA> m_pca; // global pca
+    std::shared_ptr<const drishti::ml::StandardizedPCA::BackProjection> m_back_projection; // see pack()
+
+    // Landmark subset (see compile_landmarks()):
+    std::vector<int> m_landmarks; // original index of each compiled landmark (empty : all)
+    int m_landmark_outputs = 0;   // the leading estimated landmarks
+    impl::shape_moments m_moments; // see pack()
     int m_ellipse_count = 0;
     bool m_npd = false;
     bool m_do_affine = false;
     unsigned long m_num_workers = 1;
+    std::shared_ptr<drishti::core::WorkerTeam> m_team; // see pack()
+    mutable std::vector<DVec32s> m_worker_sums;       // per worker fixed point accumulators
 
     // Use interpolated "line indexed" features (stead of the relative encoding above):
     std::vector<std::vector<InterpolatedFeature>> interpolated_features;
@@ -1059,6 +2316,10 @@ public:
 void serialize(const drishti::ml::shape_predictor& item, std::ostream& out);
 void deserialize(drishti::ml::shape_predictor& item, std::istream& in);
 
+// Flat (memory mappable) format, see RTEShapeEstimatorArchiveFlat.cpp:
+void save_flat(const drishti::ml::shape_predictor& item, drishti::core::FlatArchiveWriter& archive);
+void load_flat(drishti::ml::shape_predictor& item, const std::shared_ptr<const drishti::core::FlatArchive>& archive);
+
 DRISHTI_ML_NAMESPACE_END
 
 typedef drishti::ml::impl::regression_tree RTType;
@@ -119,18 +119,40 @@ void serialize(Archive& ar, drishti::ml::impl::regression_tree& g, const unsigne
 }
 
 template <class Archive>
-void serialize(Archive& ar, drishti::ml::shape_predictor& sp, const unsigned int version)
+void serialize(Archive& ar, drishti::ml::impl::pose_index_table& g, const unsigned int version)
 {
-    drishti_throw_assert(version == 4, "Incorrect shape_predictor archive format, please update models");
+    ar& g.anchor;
+    ar& g.dx;
+    ar& g.dy;
+}
 
-    drishti::ml::fshape& initial_shape = sp.initial_shape;
-    std::vector<std::vector<RTType>>& forests = sp.forests;
-    std::vector<std::vector<unsigned short>>& anchor_idx = sp.anchor_idx;
-    std::vector<std::vector<Vec2Type>>& deltas = sp.deltas;
+// Quantized leaf storage (see shape_predictor::quantize()), the float leaves are never stored:
+template <class Archive>
+void serialize(Archive& ar, drishti::ml::impl::packed_forest& g, const unsigned int version)
+{
+    ar& g.num_trees;
+    ar& g.num_splits;
+    ar& g.num_leaves;
+    ar& g.leaf_dim;
+    ar& g.leaf_stride;
+    ar& g.leaf_stride_16;
+    ar& g.fraction_bits;
+    ar& g.splits;
+    ar& g.leaves_16;
+    ar& g.leaves_8;
+    ar& g.tree_scales;
 
-    // Without forests a 2.3 MB compressed archive drops to 48K//
-    ar& initial_shape;
-    ar& forests;
+    if (Archive::is_loading::value)
+    {
+        g.leaves.clear();
+        g.select_traversal();
+    }
+}
+
+// Float pose indexing (versions 4 and 5):
+template <class Archive>
+void serialize_pose_encoding(Archive& ar, std::vector<std::vector<unsigned short>>& anchor_idx, std::vector<std::vector<Vec2Type>>& deltas)
+{
     ar& anchor_idx;
 
 #if DRISHTI_DLIB_DO_HALF
@@ -148,17 +170,110 @@ void serialize(Archive& ar, drishti::ml::shape_predictor& sp, const unsigned int
 #else
     ar& deltas;
 #endif
+}
+
+template <class Archive>
+void serialize(Archive& ar, drishti::ml::shape_predictor& sp, const unsigned int version)
+{
+    drishti_throw_assert((version >= 4) && (version <= 8), "Incorrect shape_predictor archive format, please update models");
+
+    drishti::ml::fshape& initial_shape = sp.initial_shape;
+    std::vector<std::vector<RTType>>& forests = sp.forests;
+    std::vector<std::vector<unsigned short>>& anchor_idx = sp.anchor_idx;
+    std::vector<std::vector<Vec2Type>>& deltas = sp.deltas;
+
+    // Without forests a 2.3 MB compressed archive drops to 48K//
+    ar& initial_shape;
+
+    // Version 5: leaves are stored as float trees (32) or quantized packed forests (16 or 8):
+    if (version >= 5)
+    {
+        ar& sp.m_leaf_bits;
+    }
+    else
+    {
+        sp.m_leaf_bits = 32;
+    }
+
+    if (sp.m_leaf_bits == 32)
+    {
+        ar& forests;
+    }
+    else
+    {
+        ar& sp.packed_forests;
+        if (Archive::is_loading::value)
+        {
+            // Retain the cascade and tree counts without allocating any leaves:
+            forests.resize(sp.packed_forests.size());
+            for (std::size_t i = 0; i < forests.size(); i++)
+            {
+                forests[i].assign(sp.packed_forests[i].num_trees, RTType());
+            }
+        }
+    }
+
+    // Version 6: the fixed point pose indexing tables used in training are stored as is:
+    if (version >= 6)
+    {
+        if (!Archive::is_loading::value)
+        {
+            sp.compile_pose_tables();
+        }
+        ar& sp.pose_tables;
+        if (Archive::is_loading::value)
+        {
+            anchor_idx.resize(sp.pose_tables.size());
+            deltas.resize(sp.pose_tables.size());
+            sp.compile_pose_tables(); // float view
+        }
+    }
+    else
+    {
+        serialize_pose_encoding(ar, anchor_idx, deltas);
+        if (Archive::is_loading::value)
+        {
+            sp.pose_tables.clear();
+            sp.compile_pose_tables();
+        }
+    }
 
     ar& sp.m_pca;
     ar& sp.m_npd;
     ar& sp.m_do_affine;
     ar& sp.m_ellipse_count;
     ar& sp.interpolated_features;
+
+    // Version 7: coarse-to-fine pyramid level per cascade:
+    if (version >= 7)
+    {
+        ar& sp.cascade_levels;
+    }
+    else
+    {
+        sp.cascade_levels.clear();
+    }
+
+    // Version 8: landmark subset models (see shape_predictor::compile_landmarks()):
+    if (version >= 8)
+    {
+        ar& sp.m_landmarks;
+        ar& sp.m_landmark_outputs;
+        if (Archive::is_loading::value)
+        {
+            sp.m_moments = sp.m_landmarks.empty() ? drishti::ml::impl::shape_moments() : drishti::ml::impl::shape_moments(sp.initial_shape, int(sp.num_parts()));
+        }
+    }
+    else
+    {
+        sp.m_landmarks.clear();
+        sp.m_landmark_outputs = 0;
+    }
 }
 
 DRISHTI_END_NAMESPACE(cereal)
 
 #include <cereal/cereal.hpp>
-CEREAL_CLASS_VERSION(drishti::ml::shape_predictor, 4);
+CEREAL_CLASS_VERSION(drishti::ml::shape_predictor, 8);
 
 #endif /* shape_predictor_archive_h */
@@ -0,0 +1,257 @@
+/*! -*-c++-*-
+  @file   shape_predictor_pruning.h
+  @author David Hirvonen
+  @brief  Greedy tree and cascade pruning with leaf refitting for trained shape_predictor models.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_ml_shape_predictor_pruning_h__
+#define __drishti_ml_shape_predictor_pruning_h__
+
+#include "drishti/ml/shape_predictor.h"
+#include "drishti/ml/shape_predictor_trainer.h" // test_shape_predictor()
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#if !DRISHTI_BUILD_MIN_SIZE
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+/*
+ * Offline reduction of a trained shape_predictor.  Gradient boosting adds the trees of a
+ * cascade in decreasing order of importance, so the model is reduced by keeping a prefix of
+ * the trees of each cascade and by dropping trailing cascades.  Trees are removed greedily,
+ * the step with the smallest error increase per removed tree first, while the validation
+ * error stays within a budget.  The leaves of the last tree kept in each cascade can then be
+ * refit to the output of the removed trees (distillation), which recovers most of their
+ * contribution at no runtime cost.
+ *
+ * Only float leaf models are supported (see shape_predictor::quantize(), which can be applied
+ * to the result).
+ */
+
+struct shape_predictor_pruning_options
+{
+    double budget = 0.02; // allowed relative increase of the validation error
+    double step = 0.1;    // fraction of the trees of a cascade removed by a greedy step
+    bool refit = true;    // refit the last kept leaves to the removed trees
+};
+
+struct shape_predictor_pruning_result
+{
+    double error_full = 0.0;    // validation error of the input model
+    double error = 0.0;         // validation error of the reduced model
+    std::vector<int> trees;     // kept trees per kept cascade
+    std::size_t trees_full = 0; // trees of the input model
+};
+
+// Keep the first trees[i] trees of cascade i, cascades with 0 trees must be trailing:
+inline void truncate_shape_predictor(shape_predictor& sp, const std::vector<int>& trees)
+{
+    std::size_t cascades = 0;
+    while ((cascades < std::min(trees.size(), sp.forests.size())) && (trees[cascades] > 0))
+    {
+        cascades++;
+    }
+
+    sp.forests.resize(cascades);
+    for (std::size_t i = 0; i < cascades; i++)
+    {
+        auto& forest = sp.forests[i];
+        forest.resize(std::min(forest.size(), std::size_t(trees[i])));
+    }
+
+    // Per cascade features:
+    auto clip = [&](std::size_t size) { return std::min(size, cascades); };
+    sp.anchor_idx.resize(clip(sp.anchor_idx.size()));
+    sp.deltas.resize(clip(sp.deltas.size()));
+    sp.pose_tables.resize(clip(sp.pose_tables.size()));
+    sp.interpolated_features.resize(clip(sp.interpolated_features.size()));
+    sp.cascade_levels.resize(clip(sp.cascade_levels.size()));
+
+    sp.packed_forests.clear();
+    sp.pack();
+}
+
+// Refit the leaves of the last kept tree of each truncated cascade to the mean output of the
+// trees removed from that cascade (of the full model), over the samples reaching each leaf:
+template <typename image_array>
+void refit_shape_predictor(
+    shape_predictor& sp,
+    const shape_predictor& full,
+    const image_array& images,
+    const std::vector<std::vector<dlib::full_object_detection>>& objects)
+{
+    using regression_state = shape_predictor::regression_state;
+
+    struct Sample
+    {
+        std::size_t image;
+        dlib::rectangle rect;
+        regression_state state;
+    };
+
+    std::vector<Sample> samples;
+    for (std::size_t i = 0; i < objects.size(); i++)
+    {
+        for (const auto& object : objects[i])
+        {
+            samples.push_back({ i, object.get_rect(), regression_state() });
+            sp.begin_regression(samples.back().state, sp.initial_shape);
+        }
+    }
+
+    for (std::size_t c = 0; c < sp.forests.size(); c++)
+    {
+        auto& forest = sp.forests[c];
+        const auto& removed = full.forests[c];
+        if (forest.size() < removed.size())
+        {
+            auto& last = forest.back();
+
+            std::vector<fshape> sums(last.leaf_values.size());
+            std::vector<int> counts(last.leaf_values.size(), 0);
+            for (auto& sample : samples)
+            {
+                // The features of cascade c are extracted before its update:
+                auto state = sample.state;
+                sp.apply_cascade(c, images[sample.image], sample.rect, state);
+
+                const int leaf = last.leaf_index(state.feature_pixel_values, sp.m_npd);
+                fshape sum = dlib::zeros_matrix<float>(last.leaf_values[leaf].size(), 1);
+                for (std::size_t t = forest.size(); t < removed.size(); t++)
+                {
+                    sum += removed[t](state.feature_pixel_values, full.m_npd);
+                }
+
+                sums[leaf] = counts[leaf] ? fshape(sums[leaf] + sum) : sum;
+                counts[leaf]++;
+            }
+
+            for (std::size_t j = 0; j < sums.size(); j++)
+            {
+                if (counts[j])
+                {
+                    last.leaf_values[j] += sums[j] / float(counts[j]);
+                }
+            }
+
+            sp.packed_forests.clear();
+            sp.pack();
+        }
+
+        for (auto& sample : samples)
+        {
+            sp.apply_cascade(c, images[sample.image], sample.rect, sample.state);
+        }
+    }
+}
+
+template <typename image_array>
+shape_predictor_pruning_result prune_shape_predictor(
+    shape_predictor& sp,
+    const image_array& images,
+    const std::vector<std::vector<dlib::full_object_detection>>& objects,
+    const std::vector<std::vector<double>>& scales,
+    const shape_predictor_pruning_options& options,
+    const std::function<void(const shape_predictor_pruning_result&)>& progress = {})
+{
+    shape_predictor_pruning_result result;
+
+    const shape_predictor full = sp;
+    const auto evaluate = [&](const std::vector<int>& trees) {
+        shape_predictor candidate = full;
+        truncate_shape_predictor(candidate, trees);
+        return test_shape_predictor(candidate, images, objects, scales);
+    };
+
+    std::vector<int> trees;
+    for (const auto& forest : full.forests)
+    {
+        trees.push_back(int(forest.size()));
+        result.trees_full += forest.size();
+    }
+
+    result.error_full = result.error = test_shape_predictor(full, images, objects, scales);
+    const double limit = result.error_full * (1.0 + options.budget);
+
+    while (true)
+    {
+        int cascades = 0;
+        while ((cascades < int(trees.size())) && trees[cascades])
+        {
+            cascades++;
+        }
+
+        // Candidates: a step in each cascade and dropping the last one (at least one remains):
+        double best_cost = std::numeric_limits<double>::max(), best_error = 0.0;
+        std::vector<int> best;
+        for (int c = 0; c < cascades; c++)
+        {
+            const int step = std::max(1, int(std::ceil(double(trees[c]) * options.step)));
+            std::vector<int> candidate = trees;
+            candidate[c] = std::max(trees[c] - step, 1);
+            if ((c == cascades - 1) && (cascades > 1) && (trees[c] <= step))
+            {
+                candidate[c] = 0;
+            }
+
+            const int count = trees[c] - candidate[c];
+            if (count > 0)
+            {
+                const double error = evaluate(candidate);
+                const double cost = (error - result.error) / double(count);
+                if ((error <= limit) && (cost < best_cost))
+                {
+                    best_cost = cost;
+                    best_error = error;
+                    best = candidate;
+                }
+            }
+        }
+
+        if (best.empty())
+        {
+            break;
+        }
+
+        trees = best;
+        result.error = best_error;
+        result.trees.assign(trees.begin(), std::find(trees.begin(), trees.end(), 0));
+        if (progress)
+        {
+            progress(result);
+        }
+    }
+
+    truncate_shape_predictor(sp, trees);
+    result.trees.assign(trees.begin(), std::find(trees.begin(), trees.end(), 0));
+
+    if (options.refit)
+    {
+        shape_predictor refit = sp;
+        refit_shape_predictor(refit, full, images, objects);
+
+        const double error = test_shape_predictor(refit, images, objects, scales);
+        if (error < result.error)
+        {
+            sp = refit;
+            result.error = error;
+        }
+    }
+
+    return result;
+}
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // !DRISHTI_BUILD_MIN_SIZE
+
+#endif // __drishti_ml_shape_predictor_pruning_h__
@@ -5,15 +5,22 @@
 #define __drishti_ml_shape_predictor_trainer_h__
 
 #include "drishti/ml/shape_predictor.h"
+#include "drishti/core/TrainingReport.h"
 
 // clang-format off
 #if !DRISHTI_BUILD_MIN_SIZE
 #  include <dlib/serialize.h>
 #  include <dlib/console_progress_indicator.h>
-#  include <dlib/threads.h>
 #endif
 // clang-format on
 
+#include <opencv2/imgproc.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
+
 #if !DRISHTI_BUILD_MIN_SIZE
 
 DRISHTI_ML_NAMESPACE_BEGIN
@@ -172,6 +179,23 @@ public:
         _num_test_splits = num;
     }
 
+    // Choose the threshold of each test split from a histogram of its feature differences
+    // (or NPD values) with this many bins (0 : exact evaluation of one random threshold):
+    unsigned long get_num_histogram_bins() const
+    {
+        return _num_histogram_bins;
+    }
+    void set_num_histogram_bins(
+        unsigned long num)
+    {
+        DLIB_CASSERT(num != 1 && num <= 65536,
+            "\t void shape_predictor_trainer::set_num_histogram_bins()"
+                << "\n\t Invalid inputs were given to this function. "
+                << "\n\t num: " << num);
+
+        _num_histogram_bins = num;
+    }
+
     double get_feature_pool_region_padding() const
     {
         return _feature_pool_region_padding;
@@ -220,6 +244,30 @@ public:
     void set_roi(const dlib::drectangle& roi) { _roi = roi; }
     const dlib::drectangle& get_roi() const { return _roi; }
 
+    // Store the feature pool as 8-bit values for 8-bit images (exact for nearest pixel reads):
+    void set_do_quantized_features(bool do_quantized_features) { _do_quantized_features = do_quantized_features; }
+    bool get_do_quantized_features() const { return _do_quantized_features; }
+
+    // Resumable training: the state after each cascade level (the forests, the sample shapes and
+    // the random number generator) is written to the checkpoint file, and train() continues from
+    // the resume file if one is given.  The setup (initial shapes, feature pools and PCA) follows
+    // from the seed and is simply recomputed, so a resumed run with the same data and leading
+    // cascade parameters matches an uninterrupted one, e.g., parameter sweeps can fork from a
+    // shared checkpoint of the early cascades.
+    void set_checkpoint(const std::string& filename) { _checkpoint = filename; }
+    const std::string& get_checkpoint() const { return _checkpoint; }
+
+    void set_resume(const std::string& filename) { _resume = filename; }
+    const std::string& get_resume() const { return _resume; }
+
+    // Coarse-to-fine: cascade i reads its features from the octave pyramid level levels[i] of the
+    // (8-bit) training images, 0 : full resolution (see shape_predictor::cascade_levels):
+    void set_cascade_levels(const std::vector<int>& levels) { _cascade_levels = levels; }
+    const std::vector<int>& get_cascade_levels() const { return _cascade_levels; }
+
+    // Per cascade phase timing and memory reports (see core::TrainingReport), not owned:
+    void set_report(drishti::core::TrainingReport* report) { _report = report; }
+
     static void copyShape(const float* ptr, int n, fshape& shape, fshape& shape_full)
     {
         shape_full.set_size(n, 1);
@@ -269,7 +317,11 @@ public:
 
         rnd.set_seed(get_random_seed());
 
-        dlib::thread_pool tp(_num_threads > 1 ? _num_threads : 0);
+        // Training runs on the shared executor (as background work) with at most _num_threads threads:
+        auto* executor = (_num_threads > 1) ? drishti::core::Executor::getInstance().get() : nullptr;
+
+        drishti::core::TrainingReport unreported("shape_predictor");
+        auto& report = _report ? *_report : unreported;
 
         DLIB_CASSERT(!(_ellipse_count % 2), "\t currently limited to ellipse pairs"); // point representation limitations
 
@@ -279,6 +331,11 @@ public:
         std::vector<training_sample> samples;
         const fshape initial_shape = populate_training_sample_shapes(objects, samples, _ellipse_count);
 
+        using image_type = typename std::decay<decltype(images[0])>::type;
+        using pixel_type = typename dlib::image_traits<image_type>::pixel_type;
+        const bool do_quantize = _do_quantized_features && std::is_same<pixel_type, unsigned char>::value;
+        feature_matrix features;
+
         std::vector<PointVecf> pixel_coordinates;
         std::vector<std::vector<InterpolatedFeature>> interpolated_features;
 
@@ -297,32 +354,69 @@ public:
         StandardizedPCAPtr pca;
         if (do_pca)
         {
+            auto timer = report.time("pca");
             pca = compute_pca(samples, num_dim, _dimensions, weights);
         }
 
-        unsigned long trees_fit_so_far = 0;
+        // Octave pyramids of the training images for the coarse-to-fine cascades (level 0 is a view):
+        std::vector<std::vector<cv::Mat>> pyramids;
+        const int num_levels = _cascade_levels.empty() ? 1 : (*std::max_element(_cascade_levels.begin(), _cascade_levels.end()) + 1);
+        if (num_levels > 1)
+        {
+            DLIB_CASSERT((std::is_same<pixel_type, unsigned char>::value), "\t coarse-to-fine training requires 8-bit images");
+
+            auto timer = report.time("pyramids");
+            pyramids.resize(images.size());
+            parallelize(executor, images.size(), [&](unsigned long i) {
+                auto& pyramid = pyramids[i];
+                pyramid.push_back(dlib::toMat(const_cast<image_type&>(images[i])));
+                for (int level = 1; level < num_levels; level++)
+                {
+                    cv::Mat half;
+                    cv::pyrDown(pyramid.back(), half);
+                    pyramid.push_back(half);
+                }
+            });
+        }
+
+        std::vector<std::vector<impl::regression_tree>> forests(get_cascade_depth());
+
+        unsigned long first_cascade = 0;
+        if (!_resume.empty())
+        {
+            auto timer = report.time("checkpoint");
+            first_cascade = load_checkpoint(_resume, forests, samples, images.size());
+            if (_verbose)
+            {
+                std::cout << "Resuming after cascade " << first_cascade << " from " << _resume << std::endl;
+            }
+        }
+
+        unsigned long trees_fit_so_far = first_cascade * get_num_trees_per_cascade_level();
         dlib::console_progress_indicator pbar(get_cascade_depth() * get_num_trees_per_cascade_level());
         if (_verbose)
         {
             std::cout << "Fitting trees..." << std::endl;
         }
 
-        std::vector<std::vector<impl::regression_tree>> forests(get_cascade_depth());
         // Now start doing the actual training by filling in the forests
-        for (unsigned long cascade = 0; cascade < get_cascade_depth(); ++cascade)
+        for (unsigned long cascade = first_cascade; cascade < get_cascade_depth(); ++cascade)
         {
+            report.beginCascade(int(cascade));
+
             int current_pca_dim = do_pca ? _dimensions[cascade] : num_dim;
 
             // We proceed to fit models coarse-to-fine in shape space, increasing dimensionality at each cascade:
             if (do_pca)
             {
+                auto timer = report.time("shape_space");
                 initialize_shape_space_models(samples, current_pca_dim, pca);
             }
 
             // Each cascade uses a different set of pixels for its features.  We compute
-            // their representations relative to the initial shape first.
-            std::vector<unsigned short> anchor_idx;
-            PointVecf deltas;
+            // their representations relative to the initial shape first (the same fixed
+            // point table as the model, see shape_predictor::compile_pose_tables()).
+            impl::pose_index_table pose_table;
 
             // For line indexed features we don't need the delta
             if (is_ellipse_only)
@@ -332,38 +426,50 @@ public:
             }
             else if (!_do_line_indexed)
             {
-                create_shape_relative_encoding(initial_shape, pixel_coordinates[cascade], anchor_idx, deltas, _ellipse_count);
+                create_shape_relative_encoding(initial_shape, pixel_coordinates[cascade], pose_table, _ellipse_count);
             }
 
             // First compute the feature_pixel_values for each training sample at this
-            // level of the cascade.
+            // level of the cascade.  The rows follow the current sample order.
 
-            parallel_for(tp, 0, samples.size(), [&](unsigned long i) {
-                auto& s = samples[i];
-                auto& is = initial_shape;
-                const auto& cs = s.current_shape;
-                const auto& image = images[s.image_idx];
+            {
+                auto timer = report.time("features");
+                features.resize(get_feature_pool_size(), samples.size(), do_quantize);
+                report.getMetrics().gauge("features.bytes").set(double(features.values.size() * sizeof(float) + features.values_u8.size()));
+                report.getMetrics().counter("samples").add(samples.size());
+                parallelize(executor, samples.size(), [&](unsigned long i) {
+                    auto& s = samples[i];
+                    auto& is = initial_shape;
+                    const auto& cs = s.current_shape;
+                    const int level = (cascade < _cascade_levels.size()) ? _cascade_levels[cascade] : 0;
+
+                    static thread_local std::vector<float> feature_pixel_values;
+                    s.feature_row = i;
+
+                    if (is_ellipse_only)
+                    {
+                        // TODO: Just use homography corresponding to first ellipse:
+                        assert(false);
+                    }
+                    else if (level > 0)
+                    {
+                        const dlib::cv_image<unsigned char> image(pyramids[s.image_idx][level]);
+                        extract_features(image, impl::scale_rect(s.rect, level), cs, is, interpolated_features, cascade, pose_table, feature_pixel_values);
+                    }
+                    else
+                    {
+                        extract_features(images[s.image_idx], s.rect, cs, is, interpolated_features, cascade, pose_table, feature_pixel_values);
+                    }
 
-                if (is_ellipse_only)
-                {
-                    // TODO: Just use homography corresponding to first ellipse:
-                    assert(false);
-                }
-                else if (_do_line_indexed)
-                {
-                    extract_feature_pixel_values(image, s.rect, cs, interpolated_features[cascade], s.feature_pixel_values);
-                }
-                else
-                {
-                    extract_feature_pixel_values(image, s.rect, cs, is, anchor_idx, deltas, s.feature_pixel_values, _ellipse_count, _do_affine);
-                }
-            },
-                1);
+                    features.set(i, feature_pixel_values);
+                });
+            }
 
             // Now start building the trees at this cascade level.
             for (unsigned long i = 0; i < get_num_trees_per_cascade_level(); ++i)
             {
-                forests[cascade].push_back(make_regression_tree(tp, samples, pixel_coordinates[cascade], _do_npd, do_pca));
+                auto timer = report.time("tree");
+                forests[cascade].push_back(make_regression_tree(executor, report, samples, features, pixel_coordinates[cascade], _do_npd, do_pca));
                 if (_verbose)
                 {
                     ++trees_fit_so_far;
@@ -373,8 +479,17 @@ public:
 
             if (do_pca)
             {
+                auto timer = report.time("shape_space");
                 update_shape_space_models(samples, current_pca_dim);
             }
+
+            if (!_checkpoint.empty())
+            {
+                auto timer = report.time("checkpoint");
+                save_checkpoint(_checkpoint, cascade + 1, forests, samples);
+            }
+
+            report.endCascade();
         }
 
         if (_verbose)
@@ -382,17 +497,37 @@ public:
             std::cout << "Training complete                          " << std::endl;
         }
 
-        if (interpolated_features.size())
+        shape_predictor sp = interpolated_features.size()
+            ? shape_predictor(initial_shape, forests, interpolated_features, pca, _do_npd, _do_affine, _ellipse_count)
+            : shape_predictor(initial_shape, forests, pixel_coordinates, pca, _do_npd, _do_affine, _ellipse_count);
+        sp.cascade_levels = _cascade_levels;
+        return sp;
+    }
+
+private:
+    template <typename image_type>
+    void extract_features(
+        const image_type& image,
+        const dlib::rectangle& rect,
+        const fshape& cs,
+        const fshape& is,
+        const std::vector<std::vector<InterpolatedFeature>>& interpolated_features,
+        unsigned long cascade,
+        const impl::pose_index_table& pose_table,
+        std::vector<float>& feature_pixel_values) const
+    {
+        using namespace impl;
+
+        if (_do_line_indexed)
         {
-            return shape_predictor(initial_shape, forests, interpolated_features, pca, _do_npd, _do_affine, _ellipse_count);
+            extract_feature_pixel_values(image, rect, cs, interpolated_features[cascade], feature_pixel_values);
         }
         else
         {
-            return shape_predictor(initial_shape, forests, pixel_coordinates, pca, _do_npd, _do_affine, _ellipse_count);
+            extract_feature_pixel_values(image, rect, cs, is, pose_table, feature_pixel_values, _ellipse_count, _do_affine);
         }
     }
 
-private:
     static fshape object_to_shape(
         const dlib::full_object_detection& obj,
         int ellipse_count = 0)
@@ -437,9 +572,9 @@ private:
         /*!
 
         CONVENTION
-            - feature_pixel_values.size() == get_feature_pool_size()
-            - feature_pixel_values[j] == the value of the j-th feature pool
-              pixel when you look it up relative to the shape in current_shape.
+            - feature_row == the row of the sample in the feature_matrix of the current
+              cascade level, i.e., features(j, feature_row) == the value of the j-th
+              feature pool pixel when you look it up relative to the shape in current_shape.
 
             - target_shape == The truth shape.  Stays constant during the whole
               training process.
@@ -458,7 +593,7 @@ private:
         fshape target_shape, target_shape_, target_shape_full_;
         fshape current_shape, current_shape_, current_shape_full_;
         fshape diff_shape;
-        std::vector<float> feature_pixel_values;
+        unsigned long feature_row = 0;
 
         void swap(training_sample& item)
         {
@@ -466,7 +601,7 @@ private:
             std::swap(rect, item.rect);
             target_shape.swap(item.target_shape);
             current_shape.swap(item.current_shape);
-            feature_pixel_values.swap(item.feature_pixel_values);
+            std::swap(feature_row, item.feature_row);
 
             target_shape_.swap(item.target_shape_);
             current_shape_.swap(item.current_shape_);
@@ -478,6 +613,159 @@ private:
         }
     };
 
+    /*
+     * The feature pool values of all samples for one cascade level, stored column-major: one
+     * contiguous column of sample values per pool feature (rows == training_sample::feature_row).
+     * A candidate split then scans two columns instead of one small heap vector per sample.
+     * Nearest pixel reads from 8-bit images are integers in [0,255], which are stored as
+     * uint8_t when quantized (4x less memory for the same values).
+     */
+    struct feature_matrix
+    {
+        void resize(unsigned long features, unsigned long num_rows, bool do_quantize)
+        {
+            rows = num_rows;
+            quantized = do_quantize;
+            values.clear();
+            values_u8.clear();
+            if (quantized)
+            {
+                values_u8.resize(features * rows);
+            }
+            else
+            {
+                values.resize(features * rows);
+            }
+        }
+
+        void set(unsigned long row, const std::vector<float>& pixels)
+        {
+            if (quantized)
+            {
+                for (unsigned long i = 0; i < pixels.size(); ++i)
+                {
+                    values_u8[i * rows + row] = static_cast<uint8_t>(std::min(std::max(pixels[i] + 0.5f, 0.f), 255.f));
+                }
+            }
+            else
+            {
+                for (unsigned long i = 0; i < pixels.size(); ++i)
+                {
+                    values[i * rows + row] = pixels[i];
+                }
+            }
+        }
+
+        float operator()(unsigned long feature, unsigned long row) const
+        {
+            return quantized ? float(values_u8[feature * rows + row]) : values[feature * rows + row];
+        }
+
+        const float* column_f32(unsigned long feature) const { return &values[feature * rows]; }
+        const uint8_t* column_u8(unsigned long feature) const { return &values_u8[feature * rows]; }
+
+        unsigned long rows = 0;
+        bool quantized = false;
+        std::vector<float> values;
+        std::vector<uint8_t> values_u8;
+    };
+
+    static const int kCheckpointVersion = 1;
+
+    void save_checkpoint(
+        const std::string& filename,
+        unsigned long cascades,
+        const std::vector<std::vector<impl::regression_tree>>& forests,
+        const std::vector<training_sample>& samples) const
+    {
+        // Write to a temporary file and rename, so an interrupted run never leaves a partial checkpoint:
+        const std::string tmp = filename + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            if (!out)
+            {
+                throw dlib::serialization_error("Unable to write checkpoint " + tmp);
+            }
+
+            const int version = kCheckpointVersion;
+            dlib::serialize(version, out);
+            dlib::serialize(cascades, out);
+            dlib::serialize(static_cast<unsigned long>(samples.size()), out);
+            for (const auto& s : samples)
+            {
+                dlib::serialize(s.image_idx, out);
+                dlib::serialize(s.rect, out);
+                dlib::serialize(s.target_shape, out);
+                dlib::serialize(s.target_shape_, out);
+                dlib::serialize(s.target_shape_full_, out);
+                dlib::serialize(s.current_shape, out);
+                dlib::serialize(s.current_shape_, out);
+                dlib::serialize(s.current_shape_full_, out);
+            }
+            dlib::serialize(std::vector<std::vector<impl::regression_tree>>(forests.begin(), forests.begin() + cascades), out);
+            dlib::serialize(rnd, out);
+
+            if (!out)
+            {
+                throw dlib::serialization_error("Failed to write checkpoint " + tmp);
+            }
+        }
+
+        if (std::rename(tmp.c_str(), filename.c_str()) != 0)
+        {
+            throw dlib::serialization_error("Unable to rename checkpoint " + tmp);
+        }
+    }
+
+    // Restore the state written by save_checkpoint(), returns the number of completed cascades:
+    unsigned long load_checkpoint(
+        const std::string& filename,
+        std::vector<std::vector<impl::regression_tree>>& forests,
+        std::vector<training_sample>& samples,
+        unsigned long num_images) const
+    {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in)
+        {
+            throw dlib::serialization_error("Unable to read checkpoint " + filename);
+        }
+
+        int version = 0;
+        unsigned long cascades = 0, num_samples = 0;
+        dlib::deserialize(version, in);
+        dlib::deserialize(cascades, in);
+        dlib::deserialize(num_samples, in);
+        if ((version != kCheckpointVersion) || (cascades > get_cascade_depth()) || (num_samples != samples.size()))
+        {
+            throw dlib::serialization_error("Checkpoint " + filename + " doesn't match the training set or the cascade depth");
+        }
+
+        const long dim = samples.front().target_shape.size();
+        for (auto& s : samples)
+        {
+            dlib::deserialize(s.image_idx, in);
+            dlib::deserialize(s.rect, in);
+            dlib::deserialize(s.target_shape, in);
+            dlib::deserialize(s.target_shape_, in);
+            dlib::deserialize(s.target_shape_full_, in);
+            dlib::deserialize(s.current_shape, in);
+            dlib::deserialize(s.current_shape_, in);
+            dlib::deserialize(s.current_shape_full_, in);
+            if ((s.image_idx >= num_images) || (s.target_shape.size() != dim) || (s.current_shape.size() != dim))
+            {
+                throw dlib::serialization_error("Checkpoint " + filename + " doesn't match the training set");
+            }
+        }
+
+        std::vector<std::vector<impl::regression_tree>> completed;
+        dlib::deserialize(completed, in);
+        DLIB_CASSERT(completed.size() == cascades, "\t shape_predictor_trainer: corrupt checkpoint " << filename);
+        std::move(completed.begin(), completed.end(), forests.begin());
+
+        dlib::deserialize(rnd, in);
+        return cascades;
+    }
+
     void update_shape_space_models(std::vector<training_sample>& samples, int current_pca_dim) const
     {
         auto current_range = dlib::range(0, current_pca_dim - 1);
@@ -590,8 +878,10 @@ private:
     }
 
     impl::regression_tree make_regression_tree(
-        dlib::thread_pool& tp,
+        drishti::core::Executor* executor,
+        drishti::core::TrainingReport& report,
         std::vector<training_sample>& samples,
+        const feature_matrix& features,
         const PointVecf& pixel_coordinates,
         bool do_npd = false,
         bool do_pca = false) const
@@ -606,46 +896,16 @@ private:
         const unsigned long num_split_nodes = static_cast<unsigned long>(std::pow(2.0, (double)get_tree_depth()) - 1);
         std::vector<fshape> sums(num_split_nodes * 2 + 1);
 
-        if (tp.num_threads_in_pool() > 1)
-        {
-            // Here we need to calculate shape differences and store sum of differences into sums[0]
-            // to make it. I am splitting samples into blocks, each block will be processed by
-            // separate thread, and the sum of differences of each block is stored into separate
-            // place in block_sums
-
-            const unsigned long num_workers = std::max(1UL, tp.num_threads_in_pool());
-            const unsigned long num = samples.size();
-            const unsigned long block_size = std::max(1UL, (num + num_workers - 1) / num_workers);
-            std::vector<dlib::matrix<float, 0, 1>> block_sums(num_workers);
-
-            parallel_for(tp, 0, num_workers, [&](unsigned long block) {
-                const unsigned long block_begin = block * block_size;
-                const unsigned long block_end = std::min(num, block_begin + block_size);
-                for (unsigned long i = block_begin; i < block_end; ++i)
-                {
-                    if (do_pca) // #if DO_PCA_INTERNAL
-                    {
-                        samples[i].diff_shape = samples[i].target_shape_ - samples[i].current_shape_;
-                    }
-                    else
-                    {
-                        samples[i].diff_shape = samples[i].target_shape - samples[i].current_shape;
-                    }
-                    block_sums[block] += samples[i].diff_shape;
-                }
-            },
-                1);
+        // Calculate the shape differences and store their sum in sums[0].  The samples are
+        // processed in fixed size chunks with one partial sum each, so the result doesn't
+        // depend on the number of threads.
+        const unsigned long num = samples.size();
+        const unsigned long num_chunks = (num + kSampleChunk - 1) / kSampleChunk;
+        std::vector<dlib::matrix<float, 0, 1>> chunk_sums(num_chunks);
 
-            // now calculate the total result from separate blocks
-            for (unsigned long i = 0; i < block_sums.size(); ++i)
-            {
-                sums[0] += block_sums[i];
-            }
-        }
-        else
-        {
-            // synchronous:
-            for (unsigned long i = 0; i < samples.size(); ++i)
+        parallelize(executor, num_chunks, [&](unsigned long chunk) {
+            const unsigned long chunk_end = std::min(num, (chunk + 1) * kSampleChunk);
+            for (unsigned long i = chunk * kSampleChunk; i < chunk_end; ++i)
             {
                 if (do_pca) // #if DO_PCA_INTERNAL
                 {
@@ -655,8 +915,14 @@ private:
                 {
                     samples[i].diff_shape = samples[i].target_shape - samples[i].current_shape;
                 }
-                sums[0] += samples[i].diff_shape;
+                chunk_sums[chunk] += samples[i].diff_shape;
             }
+        });
+
+        // now calculate the total result from separate chunks
+        for (unsigned long i = 0; i < chunk_sums.size(); ++i)
+        {
+            sums[0] += chunk_sums[i];
         }
 
         for (unsigned long i = 0; i < num_split_nodes; ++i)
@@ -666,14 +932,25 @@ private:
 
             auto& sumsL = sums[left_child(i)];
             auto& sumsR = sums[right_child(i)];
-            impl::split_feature split = generate_split(tp, samples, range.first, range.second, pixel_coordinates, sums[i], sumsL, sumsR, do_npd, do_pca);
+            impl::split_feature split;
+            {
+                auto timer = report.time("tree.split");
+                split = generate_split(executor, samples, features, range.first, range.second, pixel_coordinates, sums[i], sumsL, sumsR, do_npd, do_pca);
+            }
             tree.splits.push_back(split);
-            const unsigned long mid = partition_samples(split, samples, range.first, range.second, do_npd);
+
+            unsigned long mid;
+            {
+                auto timer = report.time("tree.partition");
+                mid = partition_samples(split, samples, features, range.first, range.second, do_npd);
+            }
 
             parts.push_back(std::make_pair(range.first, mid));
             parts.push_back(std::make_pair(mid, range.second));
         }
 
+        auto timer = report.time("tree.leaf");
+
         // Now all the parts contain the ranges for the leaves so we can use them to
         // compute the average leaf values.
         tree.leaf_values.resize(parts.size());
@@ -694,20 +971,29 @@ private:
                     tree.leaf_values[i] = zeros_matrix(samples[0].target_shape);
                 }
             }
+        }
 
-            // now adjust the current shape based on these predictions
-            parallel_for(tp, parts[i].first, parts[i].second, [&](unsigned long j) {
+        // now adjust the current shape based on these predictions (one pass over all leaves)
+        std::vector<unsigned long> leaf_of(num);
+        for (unsigned long i = 0; i < parts.size(); ++i)
+        {
+            std::fill(leaf_of.begin() + parts[i].first, leaf_of.begin() + parts[i].second, i);
+        }
+
+        parallelize(executor, num_chunks, [&](unsigned long chunk) {
+            const unsigned long chunk_end = std::min(num, (chunk + 1) * kSampleChunk);
+            for (unsigned long j = chunk * kSampleChunk; j < chunk_end; ++j)
+            {
                 if (do_pca)
                 {
-                    samples[j].current_shape_ += tree.leaf_values[i];
+                    samples[j].current_shape_ += tree.leaf_values[leaf_of[j]];
                 }
                 else
                 {
-                    samples[j].current_shape += tree.leaf_values[i];
+                    samples[j].current_shape += tree.leaf_values[leaf_of[j]];
                 }
-            },
-                1);
-        }
+            }
+        });
 
         return tree;
     }
@@ -740,8 +1026,9 @@ private:
     }
 
     impl::split_feature generate_split(
-        dlib::thread_pool& tp,
+        drishti::core::Executor* executor,
         const std::vector<training_sample>& samples,
+        const feature_matrix& features,
         unsigned long begin,
         unsigned long end,
         const PointVecf& pixel_coordinates,
@@ -753,6 +1040,11 @@ private:
 
         ) const
     {
+        if (get_num_histogram_bins() > 1)
+        {
+            return generate_split_histogram(executor, samples, features, begin, end, pixel_coordinates, sum, left_sum, right_sum, do_npd);
+        }
+
         // generate a bunch of random splits and test them and return the best one.
 
         const unsigned long num_test_splits = get_num_test_splits();
@@ -768,40 +1060,35 @@ private:
         std::vector<fshape> left_sums(num_test_splits);
         std::vector<unsigned long> left_cnt(num_test_splits);
 
-        const unsigned long num_workers = std::max(1UL, tp.num_threads_in_pool());
-        const unsigned long block_size = std::max(1UL, (num_test_splits + num_workers - 1) / num_workers);
+        // the matrix rows of the samples in this node:
+        std::vector<unsigned long> rows(end - begin);
+        for (unsigned long j = begin; j < end; ++j)
+        {
+            rows[j - begin] = samples[j].feature_row;
+        }
 
-        // now compute the sums of vectors that go left for each feature
-        parallel_for(tp, 0, num_workers, [&](unsigned long block) {
-            const unsigned long block_begin = block * block_size;
-            const unsigned long block_end = std::min(block_begin + block_size, num_test_splits);
+        // now compute the sums of vectors that go left for each feature (one task per feature)
+        parallelize(executor, num_test_splits, [&](unsigned long i) {
+            static thread_local std::vector<uint8_t> goes_left;
+            goes_left.resize(rows.size());
+            if (features.quantized)
+            {
+                test_split(features.column_u8(feats[i].idx1), features.column_u8(feats[i].idx2), rows, feats[i].thresh, do_npd, goes_left);
+            }
+            else
+            {
+                test_split(features.column_f32(feats[i].idx1), features.column_f32(feats[i].idx2), rows, feats[i].thresh, do_npd, goes_left);
+            }
 
-            for (unsigned long j = begin; j < end; ++j)
+            for (unsigned long j = 0; j < rows.size(); ++j)
             {
-                for (unsigned long i = block_begin; i < block_end; ++i)
+                if (goes_left[j])
                 {
-                    const auto& values1 = samples[j].feature_pixel_values[feats[i].idx1];
-                    const auto& values2 = samples[j].feature_pixel_values[feats[i].idx2];
-                    if (do_npd)
-                    {
-                        if (compute_npd(values1, values2) > feats[i].thresh)
-                        {
-                            left_sums[i] += samples[j].diff_shape;
-                            ++left_cnt[i];
-                        }
-                    }
-                    else
-                    {
-                        if ((static_cast<float>(values1) - static_cast<float>(values2)) > feats[i].thresh)
-                        {
-                            left_sums[i] += samples[j].diff_shape;
-                            ++left_cnt[i];
-                        }
-                    }
+                    left_sums[i] += samples[begin + j].diff_shape;
+                    ++left_cnt[i];
                 }
             }
-        },
-            1);
+        });
 
         // now figure out which feature is the best
         double best_score = -1;
@@ -837,9 +1124,202 @@ private:
         return feats[best_feat];
     }
 
+    /*
+     * Histogram split search: the feature differences of each random pixel pair are binned over
+     * the threshold range ([-128,128] for differences, [-1,1] for NPD) and the shape differences
+     * are summed per bin, so a single pass over the samples scores every bin edge as a threshold
+     * (instead of one random threshold per pass).  Values outside the range fall into the first
+     * and last bins.  Bin b holds the values in (edge[b], edge[b + 1]], so the samples in bins
+     * >= b are exactly those that partition_samples() sends left with thresh == edge[b].
+     */
+    impl::split_feature generate_split_histogram(
+        drishti::core::Executor* executor,
+        const std::vector<training_sample>& samples,
+        const feature_matrix& features,
+        unsigned long begin,
+        unsigned long end,
+        const PointVecf& pixel_coordinates,
+        const fshape& sum,
+        fshape& left_sum,
+        fshape& right_sum,
+        bool do_npd) const
+    {
+        const unsigned long num_test_splits = get_num_test_splits();
+        const int num_bins = int(get_num_histogram_bins());
+        const float lo = do_npd ? -1.f : -128.f;
+        const float width = (-2.f * lo) / num_bins;
+
+        std::vector<float> edges(num_bins);
+        for (int b = 0; b < num_bins; ++b)
+        {
+            edges[b] = lo + float(b) * width;
+        }
+
+        std::vector<impl::split_feature> feats;
+        feats.reserve(num_test_splits);
+        for (unsigned long i = 0; i < num_test_splits; ++i)
+        {
+            feats.push_back(randomly_generate_split_feature(pixel_coordinates, do_npd));
+        }
+
+        std::vector<unsigned long> rows(end - begin);
+        for (unsigned long j = begin; j < end; ++j)
+        {
+            rows[j - begin] = samples[j].feature_row;
+        }
+
+        std::vector<fshape> left_sums(num_test_splits);
+        std::vector<double> scores(num_test_splits, -1.0);
+
+        // one task per feature:
+        parallelize(executor, num_test_splits, [&](unsigned long i) {
+            static thread_local std::vector<float> values;
+            values.resize(rows.size());
+            std::vector<fshape> bin_sums(num_bins);
+            std::vector<unsigned long> bin_cnt(num_bins);
+            fshape left, right;
+
+            if (features.quantized)
+            {
+                compute_split_values(features.column_u8(feats[i].idx1), features.column_u8(feats[i].idx2), rows, do_npd, values);
+            }
+            else
+            {
+                compute_split_values(features.column_f32(feats[i].idx1), features.column_f32(feats[i].idx2), rows, do_npd, values);
+            }
+
+            for (int b = 0; b < num_bins; ++b)
+            {
+                bin_sums[b] = dlib::zeros_matrix(sum);
+                bin_cnt[b] = 0;
+            }
+
+            for (unsigned long j = 0; j < rows.size(); ++j)
+            {
+                const float v = values[j];
+                int b = std::min(std::max(int(std::ceil((v - lo) / width)) - 1, 0), num_bins - 1);
+
+                // make the bin consistent with the (rounded) edges used as thresholds:
+                if ((b > 0) && !(v > edges[b]))
+                {
+                    --b;
+                }
+                else if ((b + 1 < num_bins) && (v > edges[b + 1]))
+                {
+                    ++b;
+                }
+
+                bin_sums[b] += samples[begin + j].diff_shape;
+                ++bin_cnt[b];
+            }
+
+            // scan the thresholds from the top, the left side is everything above the edge:
+            left = dlib::zeros_matrix(sum);
+            unsigned long left_cnt = 0;
+            for (int b = num_bins - 1; b > 0; --b)
+            {
+                left += bin_sums[b];
+                left_cnt += bin_cnt[b];
+
+                const unsigned long right_cnt = rows.size() - left_cnt;
+                if (left_cnt != 0 && right_cnt != 0)
+                {
+                    right = sum - left;
+                    const double score = dot(left, left) / left_cnt + dot(right, right) / right_cnt;
+                    if (score > scores[i])
+                    {
+                        scores[i] = score;
+                        feats[i].thresh = edges[b];
+                        left_sums[i] = left;
+                    }
+                }
+            }
+        });
+
+        const unsigned long best_feat = std::max_element(scores.begin(), scores.end()) - scores.begin();
+        if (scores[best_feat] < 0.0)
+        {
+            // no pair separates the samples: send everything right
+            feats[best_feat].thresh = std::numeric_limits<float>::max();
+            left_sum = dlib::zeros_matrix(sum);
+            right_sum = sum;
+        }
+        else
+        {
+            left_sums[best_feat].swap(left_sum);
+            right_sum = sum - left_sum;
+        }
+        return feats[best_feat];
+    }
+
+    // Samples per task for the per sample passes (shape differences and leaf updates):
+    static constexpr unsigned long kSampleChunk = 256;
+
+    // Run function(i) for i in [0,n) on the executor (serially if it is null) using at most _num_threads
+    // threads, including the caller.  Items are claimed one at a time, so small tasks balance across the
+    // workers, and nested calls from a task run on the same (work stealing) pool:
+    template <typename Function>
+    void parallelize(drishti::core::Executor* executor, unsigned long n, Function&& function) const
+    {
+        const int max_workers = static_cast<int>(std::max(_num_threads, 1UL)) - 1;
+        drishti::core::parallel_for(executor, static_cast<int>(n), [&](int i) { function(static_cast<unsigned long>(i)); }, max_workers, drishti::core::Executor::kBackground);
+    }
+
+    // The feature differences (or NPD values) tested by a split for the samples in rows:
+    template <typename T>
+    static void compute_split_values(
+        const T* values1,
+        const T* values2,
+        const std::vector<unsigned long>& rows,
+        bool do_npd,
+        std::vector<float>& values)
+    {
+        if (do_npd)
+        {
+            for (unsigned long j = 0; j < rows.size(); ++j)
+            {
+                values[j] = compute_npd(float(values1[rows[j]]), float(values2[rows[j]]));
+            }
+        }
+        else
+        {
+            for (unsigned long j = 0; j < rows.size(); ++j)
+            {
+                values[j] = float(values1[rows[j]]) - float(values2[rows[j]]);
+            }
+        }
+    }
+
+    // Flag the samples with a feature difference (or NPD) above the split threshold:
+    template <typename T>
+    static void test_split(
+        const T* values1,
+        const T* values2,
+        const std::vector<unsigned long>& rows,
+        float thresh,
+        bool do_npd,
+        std::vector<uint8_t>& goes_left)
+    {
+        if (do_npd)
+        {
+            for (unsigned long j = 0; j < rows.size(); ++j)
+            {
+                goes_left[j] = compute_npd(float(values1[rows[j]]), float(values2[rows[j]])) > thresh;
+            }
+        }
+        else
+        {
+            for (unsigned long j = 0; j < rows.size(); ++j)
+            {
+                goes_left[j] = (float(values1[rows[j]]) - float(values2[rows[j]])) > thresh;
+            }
+        }
+    }
+
     unsigned long partition_samples(
         const impl::split_feature& split,
         std::vector<training_sample>& samples,
+        const feature_matrix& features,
         unsigned long begin,
         unsigned long end,
         bool do_npd = false) const
@@ -854,7 +1334,7 @@ private:
         {
             for (unsigned long j = begin; j < end; ++j)
             {
-                if (compute_npd(samples[j].feature_pixel_values[split.idx1], samples[j].feature_pixel_values[split.idx2]) > split.thresh)
+                if (compute_npd(features(split.idx1, samples[j].feature_row), features(split.idx2, samples[j].feature_row)) > split.thresh)
                 {
                     samples[i].swap(samples[j]);
                     ++i;
@@ -865,7 +1345,7 @@ private:
         {
             for (unsigned long j = begin; j < end; ++j)
             {
-                if (samples[j].feature_pixel_values[split.idx1] - samples[j].feature_pixel_values[split.idx2] > split.thresh)
+                if (features(split.idx1, samples[j].feature_row) - features(split.idx2, samples[j].feature_row) > split.thresh)
                 {
                     samples[i].swap(samples[j]);
                     ++i;
@@ -1061,6 +1541,7 @@ private:
     unsigned long _feature_pool_size;
     double _lambda;
     unsigned long _num_test_splits;
+    unsigned long _num_histogram_bins = 0;
     double _feature_pool_region_padding;
     bool _verbose;
     unsigned long _num_threads;
@@ -1072,6 +1553,11 @@ private:
     bool _do_affine = false;
     bool _do_line_indexed = false;
     dlib::drectangle _roi = { 0.f, 0.f, 0.f, 0.f };
+    bool _do_quantized_features = true;
+    std::vector<int> _cascade_levels;
+    std::string _checkpoint;
+    std::string _resume;
+    drishti::core::TrainingReport* _report = nullptr;
 
     // experimental
     std::map<int, impl::recipe> _recipe_for_cascade_level;
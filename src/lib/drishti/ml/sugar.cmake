@@ -12,13 +12,18 @@ endif()
 include(sugar_files)
 
 sugar_files(DRISHTI_ML_SRCS
+  NonMaximaSuppression.cpp
   ObjectDetector.cpp
   ObjectDetectorACF.cpp  
   PCA.cpp
   PCAArchiveCereal.cpp
+  ParallelObjectDetectorACF.cpp
+  PyramidBuilderACF.cpp
   RTEShapeEstimatorArchiveCereal.cpp  
+  RTEShapeEstimatorArchiveFlat.cpp
   RegressionTreeEnsembleShapeEstimator.cpp
   ShapeEstimator.cpp
+  TreeEnsemble.cpp
   XGBooster.cpp
   XGBoosterIOArchiveCereal.cpp
   )
@@ -26,13 +31,17 @@ sugar_files(DRISHTI_ML_SRCS
 sugar_files(DRISHTI_ML_HDRS_PUBLIC
   Booster.h
   BoundingBox.h
+  NonMaximaSuppression.h
   ObjectDetector.h
   ObjectDetectorACF.h
   PCA.h
   PCAImpl.h
+  ParallelObjectDetectorACF.h
+  PyramidBuilderACF.h
   RTEShapeEstimatorImpl.h
   RegressionTreeEnsembleShapeEstimator.h
   ShapeEstimator.h
+  TreeEnsemble.h
   XGBooster.h
   XGBoosterImpl.h  
   drishti_ml.h
@@ -45,7 +54,7 @@ sugar_files(DRISHTI_ML_UT
   )
 
 if(NOT DRISHTI_BUILD_MIN_SIZE)
-  sugar_files(DRISHTI_ML_HDRS_PUBLIC shape_predictor_trainer.h)
+  sugar_files(DRISHTI_ML_HDRS_PUBLIC shape_predictor_pruning.h shape_predictor_trainer.h)
 endif()
 
 if(DRISHTI_BUILD_DEST)
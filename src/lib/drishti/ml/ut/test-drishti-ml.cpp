@@ -10,14 +10,29 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <numeric>
+
 #include "drishti/ml/RegressionTreeEnsembleShapeEstimator.h"
+#include "drishti/ml/TreeEnsemble.h"
 #include "drishti/ml/XGBooster.h"
 #include "drishti/ml/PCA.h"
+#include "drishti/ml/NonMaximaSuppression.h"
+#include "drishti/ml/ObjectDetectorACF.h"
+#include "drishti/ml/ParallelObjectDetectorACF.h"
+#include "drishti/ml/PyramidBuilderACF.h"
+#include "drishti/ml/shape_predictor.h"
 
 #include "drishti/core/drishti_stdlib_string.h"
 #include "drishti/core/drishti_cereal_pba.h"
 #include "drishti/core/drishti_cv_cereal.h"
 
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+extern const char* sFaceDetector;
+extern const char* sFaceImageFilename;
+
 TEST(XGBooster, XGBoosterInit)
 {
     // Run simple function fit w/ full (non-lean) builds:
@@ -25,6 +40,113 @@ TEST(XGBooster, XGBoosterInit)
     ASSERT_EQ(true, true);
 }
 
+#if !DRISHTI_BUILD_MIN_SIZE
+TEST(XGBooster, native_evaluation)
+{
+    // Fit a step function in x0 (x1 is noise):
+    cv::RNG rng(0);
+    MatrixType<float> features(256, std::vector<float>(2));
+    std::vector<float> values(features.size());
+    for (int i = 0; i < features.size(); i++)
+    {
+        features[i] = { rng.uniform(-1.f, 1.f), rng.uniform(-1.f, 1.f) };
+        values[i] = (features[i][0] < 0.f) ? -1.f : 1.f;
+    }
+
+    drishti::ml::XGBooster::Recipe recipe;
+    recipe.numberOfTrees = 64;
+    recipe.maxDepth = 2;
+    recipe.dataSubsample = 1.0;
+    recipe.featureSubsample = 1.0;
+    recipe.learningRate = 0.3;
+
+    drishti::ml::XGBooster booster(recipe);
+    booster.train(features, values);
+
+    for (int i = 0; i < features.size(); i++)
+    {
+        EXPECT_FLOAT_EQ(booster(features[i]), booster(features[i].data()));
+        EXPECT_NEAR(booster(features[i].data()), values[i], 0.1f);
+    }
+}
+#endif
+
+TEST(TreeEnsemble, evaluate)
+{
+    using Node = drishti::ml::TreeEnsemble::Node;
+
+    // tree 0: (x0 < 0.5) ? 1 : ((x1 < 0) ? 2 : 3), missing x0 -> no, missing x1 -> yes
+    // tree 1: 0.25
+    std::vector<Node> nodes{
+        { 0, 0.5f, 1, 2, 2 },
+        { 1.f },
+        { 1, 0.f, 3, 4, 3 },
+        { 2.f },
+        { 3.f },
+        { 0.25f }
+    };
+
+    const drishti::ml::TreeEnsemble forest(nodes, { 0, 5 }, 0.5f);
+    ASSERT_EQ(forest.size(), 2);
+    ASSERT_EQ(forest.getFeatureDim(), 2);
+
+    const std::vector<std::pair<std::vector<float>, float>> tests{
+        { { 0.f, 0.f }, 1.75f },
+        { { 0.5f, -1.f }, 2.75f },
+        { { 1.f, 1.f }, 3.75f },
+        { { NAN, 1.f }, 3.75f },
+        { { 1.f, NAN }, 2.75f }
+    };
+
+    // Batch evaluation of padded rows:
+    static const int stride = 3;
+    std::vector<float> rows(tests.size() * stride, 0.f), scores(tests.size());
+    for (int i = 0; i < tests.size(); i++)
+    {
+        std::copy(tests[i].first.begin(), tests[i].first.end(), rows.begin() + i * stride);
+    }
+    forest.predict(rows.data(), int(tests.size()), stride, scores.data());
+
+    for (int i = 0; i < tests.size(); i++)
+    {
+        EXPECT_FLOAT_EQ(forest(tests[i].first.data()), tests[i].second);
+        EXPECT_FLOAT_EQ(scores[i], tests[i].second);
+    }
+
+    const drishti::ml::TreeEnsemble logistic(nodes, { 0, 5 }, 0.5f, drishti::ml::TreeEnsemble::kLogistic);
+    EXPECT_FLOAT_EQ(logistic(tests.front().first.data()), 1.f / (1.f + std::exp(-1.75f)));
+
+    nodes.front().yes = int(nodes.size());
+    EXPECT_ANY_THROW(drishti::ml::TreeEnsemble(nodes, { 0 }, 0.f));
+}
+
+// The forest from TreeEnsemble.evaluate as emitted by drishti_cpr_codegen:
+static float compiledForest(const float* f)
+{
+    float sum = 0.f;
+    sum += ((f[0] < 0.5f) ? 1.0f : (!(f[1] >= 0.0f) ? 2.0f : 3.0f));
+    sum += 0.25f;
+    sum += 0.5f;
+    return sum;
+}
+
+TEST(TreeEnsemble, function)
+{
+    const drishti::ml::TreeEnsemble forest(&compiledForest, 2);
+    ASSERT_FALSE(forest.empty());
+    ASSERT_EQ(forest.getFeatureDim(), 2);
+
+    const std::vector<float> rows{ 0.f, 0.f, 1.f, NAN, NAN, 1.f };
+    std::vector<float> scores(3);
+    forest.predict(rows.data(), 3, 2, scores.data());
+    EXPECT_FLOAT_EQ(scores[0], 1.75f);
+    EXPECT_FLOAT_EQ(scores[1], 2.75f);
+    EXPECT_FLOAT_EQ(scores[2], 3.75f);
+
+    const drishti::ml::XGBooster booster(forest);
+    EXPECT_FLOAT_EQ(booster(rows.data()), 1.75f);
+}
+
 TEST(StandardizedPCA, gemm_transpose_continuous)
 {
     cv::Mat A, Bt, C;
@@ -79,3 +201,591 @@ TEST(StandardizedPCA, gemm_transpose_non_continuous)
         }
     }
 }
+
+TEST(StandardizedPCA, back_projection)
+{
+    static const int samples = 64, dim = 12, components = 6;
+
+    cv::RNG rng(0);
+    cv::Mat1f data(samples, dim), projection;
+    rng.fill(data, cv::RNG::UNIFORM, -1.f, 1.f);
+
+    drishti::ml::StandardizedPCA pca;
+    pca.compute(data, projection, components);
+
+    // The fused (affine) form must match backProject() for truncated and full coefficients:
+    const auto bp = pca.getBackProjection();
+    ASSERT_EQ(bp.components, components);
+    ASSERT_EQ(bp.dim, dim);
+
+    for (int n = 1; n <= components; n++)
+    {
+        const cv::Mat1f y = projection.row(0).colRange(0, n).clone();
+        const cv::Mat1f expected = pca.backProject(y);
+
+        for (int j = 0; j < dim; j++)
+        {
+            float x = bp.getOffset(n)[j];
+            for (int i = 0; i < n; i++)
+            {
+                x += y(i) * bp.getRow(i)[j];
+            }
+            EXPECT_NEAR(x, expected(j), 1e-4f);
+        }
+    }
+}
+
+TEST(StandardizedPCA, randomized_and_streaming)
+{
+    static const int samples = 256, dim = 24, rank = 4, chunk = 50;
+
+    // Low rank data (plus noise), so the leading subspace is well defined:
+    cv::RNG rng(0);
+    cv::Mat1f latent(samples, rank), mixing(rank, dim), noise(samples, dim), projection;
+    rng.fill(latent, cv::RNG::NORMAL, 0.f, 4.f);
+    rng.fill(mixing, cv::RNG::UNIFORM, -1.f, 1.f);
+    rng.fill(noise, cv::RNG::NORMAL, 0.f, 0.01f);
+    const cv::Mat1f data = latent * mixing + noise;
+
+    drishti::ml::StandardizedPCA reference, randomized, streaming;
+    reference.compute(data, projection, rank);
+    randomized.computeRandomized(data, projection, rank);
+
+    drishti::ml::StandardizedPCA::Accumulator moments;
+    for (int i = 0; i < samples; i += chunk)
+    {
+        moments.add(data.rowRange(i, std::min(i + chunk, samples)));
+    }
+    streaming.compute(moments, rank);
+
+    // The eigenvector signs are arbitrary, so compare the reconstructions:
+    const cv::Mat1f expected = reference.backProject(reference.project(data));
+    EXPECT_LT(cv::norm(randomized.backProject(randomized.project(data)), expected, cv::NORM_INF), 1e-3);
+    EXPECT_LT(cv::norm(streaming.backProject(streaming.project(data)), expected, cv::NORM_INF), 1e-3);
+}
+
+TEST(shape_predictor, packed_forest)
+{
+    using drishti::ml::impl::regression_tree;
+    using drishti::ml::impl::split_feature;
+
+    static const int depth = 3, dim = 6, features = 32;
+
+    cv::RNG rng(0);
+    std::vector<float> values(features);
+    for (auto& v : values)
+    {
+        v = rng.uniform(0.f, 1.f);
+    }
+
+    std::vector<regression_tree> forest(16);
+    for (auto& tree : forest)
+    {
+        for (int i = 0; i < ((1 << depth) - 1); i++)
+        {
+            tree.splits.emplace_back(rng.uniform(0, features), rng.uniform(0, features), rng.uniform(-0.5f, 0.5f));
+        }
+        tree.leaf_values.resize(1 << depth);
+        for (auto& leaf : tree.leaf_values)
+        {
+            leaf.set_size(dim);
+            for (int k = 0; k < dim; k++)
+            {
+                leaf(k) = rng.uniform(-1.f, 1.f);
+            }
+        }
+    }
+
+    drishti::ml::impl::packed_forest packed;
+    ASSERT_TRUE(packed.pack(forest));
+    ASSERT_TRUE(packed.has_fixed_point());
+
+    for (bool npd : { false, true })
+    {
+        std::vector<float> expected(dim, 0.f), result(dim, 0.f);
+        for (const auto& tree : forest)
+        {
+            const auto& leaf = tree(values, npd);
+            for (int k = 0; k < dim; k++)
+            {
+                expected[k] += leaf(k);
+            }
+        }
+
+        packed.accumulate(values, npd, 0, packed.num_trees, result.data());
+        for (int k = 0; k < dim; k++)
+        {
+            EXPECT_FLOAT_EQ(result[k], expected[k]);
+        }
+
+        // Fixed point (int32_t accumulation) is within the worst case rounding error:
+        std::vector<int32_t> result32(dim, 0);
+        packed.accumulate(values, npd, 0, packed.num_trees, result32.data());
+        for (int k = 0; k < dim; k++)
+        {
+            EXPECT_NEAR(float(result32[k]) * packed.fixed_point_scale(), expected[k], packed.num_trees * packed.fixed_point_scale());
+        }
+    }
+
+    // Leaves that can't be represented within the error budget stay in float:
+    forest.front().leaf_values.front()(0) = 1e6f;
+    ASSERT_TRUE(packed.pack(forest));
+    ASSERT_FALSE(packed.has_fixed_point());
+
+    // Ragged forests are rejected (and evaluated from the trees):
+    forest.back().splits.pop_back();
+    ASSERT_FALSE(packed.pack(forest));
+    ASSERT_TRUE(packed.empty());
+}
+
+TEST(shape_predictor, tree_traversal)
+{
+    using drishti::ml::impl::split_feature;
+
+    static const int features = 32;
+
+    cv::RNG rng(1);
+    std::vector<float> values(features);
+    for (auto& v : values)
+    {
+        v = rng.uniform(0.f, 1.f);
+    }
+
+    // Depth specialized kernels (and the generic fallback) must match a plain tree walk:
+    for (int depth = 0; depth <= 10; depth++)
+    {
+        for (int trial = 0; trial < 16; trial++)
+        {
+            std::vector<split_feature> splits;
+            for (int i = 0; i < ((1 << depth) - 1); i++)
+            {
+                splits.emplace_back(rng.uniform(0, features), rng.uniform(0, features), rng.uniform(-0.5f, 0.5f));
+            }
+
+            for (bool npd : { false, true })
+            {
+                std::size_t i = 0;
+                while (i < splits.size())
+                {
+                    const auto& node = splits[i];
+                    const float a = values[node.idx1], b = values[node.idx2];
+                    const float f = npd ? drishti::ml::compute_npd(a, b) : (a - b);
+                    i = (f > node.thresh) ? drishti::ml::impl::left_child(i) : drishti::ml::impl::right_child(i);
+                }
+
+                auto traversal = npd ? drishti::ml::impl::select_tree_traversal<true>(depth) : drishti::ml::impl::select_tree_traversal<false>(depth);
+                EXPECT_EQ(traversal(splits.data(), int(splits.size()), values.data()), int(i - splits.size()));
+            }
+        }
+    }
+}
+
+TEST(shape_predictor, sampled_image)
+{
+    using drishti::ml::impl::feature_sample_buffer;
+
+    cv::RNG rng(2);
+    cv::Mat1b image(48, 64);
+    rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+
+    // Samples partly outside the image (these read as zero):
+    feature_sample_buffer samples;
+    for (int i = 0; i < 256; i++)
+    {
+        samples.x.push_back(rng.uniform(-0.5f, 1.5f));
+        samples.y.push_back(rng.uniform(-0.5f, 1.5f));
+    }
+
+    const auto tform_to_img = drishti::ml::impl::unnormalizing_tform(dlib::rectangle(8, 4, 47, 35));
+
+    std::vector<float> expected(samples.x.size()), result(samples.x.size());
+    drishti::ml::impl::gather_feature_pixel_values(dlib::cv_image<uint8_t>(image), tform_to_img, samples, expected);
+
+    // An external sampler reading the same pixels must produce the same features:
+    const drishti::ml::impl::sampled_image::sampler_type sampler = [&](const float* x, const float* y, float* values, int n) {
+        drishti::core::gatherU8(image.ptr<uint8_t>(), image.step, image.cols, image.rows, x, y, values, n, 0.f);
+    };
+    drishti::ml::impl::gather_feature_pixel_values(drishti::ml::impl::sampled_image{ &sampler }, tform_to_img, samples, result);
+
+    EXPECT_EQ(result, expected);
+}
+
+TEST(shape_predictor, image_pyramid)
+{
+    using drishti::ml::impl::feature_sample_buffer;
+
+    // A linear ramp is preserved by cv::pyrDown() (away from the border):
+    cv::Mat1b image(96, 128);
+    for (int y = 0; y < image.rows; y++)
+    {
+        for (int x = 0; x < image.cols; x++)
+        {
+            image(y, x) = uint8_t(x + y);
+        }
+    }
+    cv::Mat half;
+    cv::pyrDown(image, half);
+
+    cv::RNG rng(3);
+    feature_sample_buffer samples;
+    for (int i = 0; i < 256; i++)
+    {
+        samples.x.push_back(rng.uniform(0.1f, 0.9f));
+        samples.y.push_back(rng.uniform(0.1f, 0.9f));
+    }
+
+    // The normalized samples read the same image content at either level (up to pixel rounding):
+    const dlib::rectangle rect(8, 4, 104, 76);
+    std::vector<float> expected(samples.x.size()), result(samples.x.size());
+    drishti::ml::impl::gather_feature_pixel_values(dlib::cv_image<uint8_t>(image), drishti::ml::impl::unnormalizing_tform(rect), samples, expected);
+    drishti::ml::impl::gather_feature_pixel_values(dlib::cv_image<uint8_t>(half), drishti::ml::impl::unnormalizing_tform(drishti::ml::impl::scale_rect(rect, 1)), samples, result);
+    for (std::size_t i = 0; i < result.size(); i++)
+    {
+        EXPECT_NEAR(result[i], expected[i], 6.f);
+    }
+
+    // Cascade levels are clamped to the available levels:
+    drishti::ml::shape_predictor sp;
+    EXPECT_EQ(sp.num_levels(), 1);
+    sp.cascade_levels = { 2, 1, 0 };
+    EXPECT_EQ(sp.num_levels(), 3);
+    EXPECT_EQ(sp.cascade_level(0), 2);
+    EXPECT_EQ(sp.cascade_level(0, 2), 1);
+    EXPECT_EQ(sp.cascade_level(3), 0);
+}
+
+TEST(shape_predictor, pose_index_table)
+{
+    using namespace drishti::ml;
+
+    cv::RNG rng(3);
+    fshape reference(16), current(16);
+    for (int i = 0; i < 16; i++)
+    {
+        reference(i) = rng.uniform(0.2f, 0.8f);
+        current(i) = reference(i) + rng.uniform(-0.05f, 0.05f);
+    }
+
+    PointVecf pixels(100);
+    for (auto& p : pixels)
+    {
+        p = fpoint(rng.uniform(-0.2f, 1.2f), rng.uniform(-0.2f, 1.2f));
+    }
+
+    impl::pose_index_table table;
+    impl::create_shape_relative_encoding(reference, pixels, table);
+    ASSERT_EQ(table.size(), pixels.size());
+
+    // The represented deltas are within half a fixed point step of the float encoding:
+    std::vector<unsigned short> anchor_idx, anchors;
+    PointVecf deltas, rounded;
+    impl::create_shape_relative_encoding(reference, pixels, anchor_idx, deltas);
+    table.get(anchors, rounded);
+    ASSERT_EQ(anchors, anchor_idx);
+    const float step = impl::pose_index_table::decode(1);
+    for (std::size_t i = 0; i < deltas.size(); i++)
+    {
+        EXPECT_LE(std::abs(rounded[i].x() - deltas[i].x()), 0.5f * step);
+        EXPECT_LE(std::abs(rounded[i].y() - deltas[i].y()), 0.5f * step);
+    }
+
+    // ... and the fixed point table reads exactly the same pixels as the represented encoding:
+    cv::Mat1b image(96, 128);
+    rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+    const dlib::cv_image<uint8_t> img(image);
+    const dlib::rectangle roi(16, 8, 111, 87);
+
+    std::vector<float> expected, result;
+    impl::extract_feature_pixel_values(img, roi, current, reference, anchors, rounded, expected);
+    impl::extract_feature_pixel_values(img, roi, current, reference, table, result);
+    EXPECT_EQ(result, expected);
+}
+
+TEST(shape_predictor, quantized_forest)
+{
+    using drishti::ml::impl::regression_tree;
+
+    static const int depth = 4, dim = 10, features = 32;
+
+    cv::RNG rng(2);
+    std::vector<float> values(features);
+    for (auto& v : values)
+    {
+        v = rng.uniform(0.f, 1.f);
+    }
+
+    std::vector<regression_tree> forest(32);
+    for (auto& tree : forest)
+    {
+        for (int i = 0; i < ((1 << depth) - 1); i++)
+        {
+            tree.splits.emplace_back(rng.uniform(0, features), rng.uniform(0, features), rng.uniform(-0.5f, 0.5f));
+        }
+        tree.leaf_values.resize(1 << depth);
+        for (auto& leaf : tree.leaf_values)
+        {
+            leaf.set_size(dim);
+            for (int k = 0; k < dim; k++)
+            {
+                leaf(k) = rng.uniform(-0.1f, 0.1f);
+            }
+        }
+    }
+
+    drishti::ml::impl::packed_forest packed;
+    ASSERT_TRUE(packed.pack(forest));
+
+    std::vector<float> expected(dim, 0.f);
+    packed.accumulate(values, false, 0, packed.num_trees, expected.data());
+
+    for (int bits : { 16, 8 })
+    {
+        auto quantized = packed;
+        ASSERT_TRUE(quantized.quantize(bits));
+        ASSERT_TRUE(quantized.is_quantized());
+        ASSERT_TRUE(quantized.leaves.empty());
+
+        // Each leaf is within half a quantization step (8 bit scale <= 0.1/127):
+        const float step = (bits == 16) ? quantized.fixed_point_scale() : (0.1f / 127.f);
+        std::vector<float> result(dim, 0.f);
+        quantized.accumulate(values, false, 0, quantized.num_trees, result.data());
+        for (int k = 0; k < dim; k++)
+        {
+            EXPECT_NEAR(result[k], expected[k], 0.5f * step * quantized.num_trees);
+        }
+
+        // Quantized forests can't be quantized again:
+        EXPECT_FALSE(quantized.quantize(bits));
+    }
+
+    EXPECT_FALSE(packed.quantize(4));
+}
+
+TEST(shape_predictor, landmark_subset)
+{
+    using namespace drishti::ml;
+    using drishti::ml::impl::regression_tree;
+
+    static const int points = 12, depth = 3, features = 64, cascades = 3;
+
+    cv::RNG rng(4);
+    fshape initial_shape(points * 2), current(points * 2);
+    for (int i = 0; i < points * 2; i++)
+    {
+        initial_shape(i) = rng.uniform(0.2f, 0.8f);
+        current(i) = initial_shape(i) * 1.1f + rng.uniform(-0.05f, 0.05f);
+    }
+
+    // The moments give the transform of the full shapes:
+    const impl::shape_moments moments(initial_shape, points);
+    float m[impl::shape_moments::kDim];
+    moments(&current(0), m);
+    for (bool affine : { false, true })
+    {
+        const auto expected = impl::find_tform_between_shapes(initial_shape, current, 0, affine).get_m();
+        const auto result = moments.tform(m, affine);
+        for (int i = 0; i < 4; i++)
+        {
+            EXPECT_NEAR(result(i / 2, i % 2), expected(i / 2, i % 2), 1e-4);
+        }
+    }
+
+    std::vector<std::vector<regression_tree>> forests(cascades, std::vector<regression_tree>(8));
+    std::vector<PointVecf> pixels(cascades, PointVecf(features));
+    for (int c = 0; c < cascades; c++)
+    {
+        for (auto& p : pixels[c])
+        {
+            p = fpoint(rng.uniform(0.f, 1.f), rng.uniform(0.f, 1.f));
+        }
+        for (auto& tree : forests[c])
+        {
+            for (int i = 0; i < ((1 << depth) - 1); i++)
+            {
+                tree.splits.emplace_back(rng.uniform(0, features), rng.uniform(0, features), rng.uniform(-32.f, 32.f));
+            }
+            tree.leaf_values.resize(1 << depth);
+            for (auto& leaf : tree.leaf_values)
+            {
+                leaf.set_size(points * 2);
+                for (int k = 0; k < points * 2; k++)
+                {
+                    leaf(k) = rng.uniform(-0.01f, 0.01f);
+                }
+            }
+        }
+    }
+
+    StandardizedPCAPtr pca;
+    shape_predictor full(initial_shape, forests, pixels, pca);
+    full.pack();
+
+    cv::Mat1b image(128, 128);
+    rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+    cv::GaussianBlur(image, image, { 9, 9 }, 2.0);
+    const dlib::cv_image<uint8_t> img(image);
+    const dlib::rectangle roi(16, 16, 111, 111);
+
+    const std::vector<int> landmarks = { 7, 0, 4 };
+    for (bool reanchor : { false, true })
+    {
+        shape_predictor subset = full;
+        ASSERT_TRUE(subset.compile_landmarks(landmarks, reanchor));
+        EXPECT_EQ(subset.output_landmarks(), landmarks);
+        EXPECT_FALSE(subset.compile_landmarks(landmarks)); // already compiled
+        if (reanchor)
+        {
+            // Only the requested landmarks are stored, accumulated and converted:
+            EXPECT_EQ(subset.cascade_dim(0), int(landmarks.size() * 2) + impl::shape_moments::kDim);
+        }
+        else
+        {
+            // ... or also the anchors, and then the features and the estimates are the same:
+            const auto expected = full(img, roi);
+            const auto result = subset(img, roi);
+            ASSERT_EQ(result.num_parts(), landmarks.size());
+            for (std::size_t i = 0; i < landmarks.size(); i++)
+            {
+                EXPECT_LE((result.part(i) - expected.part(landmarks[i])).length(), 1.0);
+            }
+        }
+    }
+
+    // Out of range landmarks are rejected:
+    shape_predictor invalid = full;
+    EXPECT_FALSE(invalid.compile_landmarks({ points }));
+    EXPECT_TRUE(invalid.output_landmarks().empty());
+}
+
+TEST(NonMaximaSuppression, matches_greedy_reference)
+{
+    // Dense overlapping windows spanning several mask words:
+    cv::RNG rng(0);
+    std::vector<cv::Rect> objects;
+    std::vector<double> scores;
+    for (int i = 0; i < 500; i++)
+    {
+        const int size = rng.uniform(16, 64);
+        objects.emplace_back(rng.uniform(0, 256), rng.uniform(0, 256), size, size);
+        scores.push_back(rng.uniform(0.0, 1.0));
+    }
+
+    for (auto type : { drishti::ml::NonMaximaSuppression::kUnion, drishti::ml::NonMaximaSuppression::kMin })
+    {
+        const float maxOverlap = 0.5f;
+
+        std::vector<int> order(objects.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+
+        std::vector<cv::Rect> expected;
+        for (auto i : order)
+        {
+            const bool isMax = std::none_of(expected.begin(), expected.end(), [&](const cv::Rect& kept) {
+                const float inter = float((objects[i] & kept).area());
+                const float denom = (type == drishti::ml::NonMaximaSuppression::kMin) ? float(std::min(objects[i].area(), kept.area())) : float(objects[i].area() + kept.area()) - inter;
+                return (inter / denom) > maxOverlap;
+            });
+            if (isMax)
+            {
+                expected.push_back(objects[i]);
+            }
+        }
+
+        std::vector<cv::Rect> objectsOut = objects;
+        std::vector<double> scoresOut = scores;
+        drishti::ml::NonMaximaSuppression nms(maxOverlap, type);
+        nms(objectsOut, scoresOut);
+
+        ASSERT_EQ(objectsOut.size(), scoresOut.size());
+        EXPECT_EQ(objectsOut, expected);
+        EXPECT_TRUE(std::is_sorted(scoresOut.rbegin(), scoresOut.rend()));
+    }
+}
+
+TEST(ParallelObjectDetectorACF, matches_serial_detector)
+{
+    cv::Mat image = cv::imread(sFaceImageFilename, cv::IMREAD_COLOR);
+    ASSERT_FALSE(image.empty());
+    cv::cvtColor(image, image, cv::COLOR_BGR2RGB);
+
+    cv::Mat It = image.t(), Itf;
+    It.convertTo(Itf, CV_32FC3, 1.0 / 255.0);
+    const MatP Ip(Itf);
+
+    drishti::ml::ObjectDetectorACF serial(sFaceDetector);
+    ASSERT_TRUE(serial.good());
+    serial.setDoNonMaximaSuppression(true);
+
+    std::vector<cv::Rect> expected;
+    std::vector<double> expectedScores;
+    serial(Ip, expected, &expectedScores);
+    ASSERT_FALSE(expected.empty());
+
+    drishti::ml::ParallelObjectDetectorACF parallel(sFaceDetector);
+    ASSERT_TRUE(parallel.good());
+    parallel.setDoNonMaximaSuppression(true);
+    parallel.setTileSize({ 32, 32 }); // several tiles per level
+
+    std::vector<cv::Rect> objects, objects2;
+    std::vector<double> scores, scores2;
+    parallel(Ip, objects, &scores);
+    ASSERT_FALSE(objects.empty());
+
+    // The band pyramids are resampled independently, so compare the best detections by overlap:
+    const cv::Rect &a = expected.front(), &b = objects.front();
+    const double iou = double((a & b).area()) / double((a | b).area());
+    EXPECT_GT(iou, 0.5);
+
+    // Scheduling must not change the result:
+    parallel(Ip, objects2, &scores2);
+    EXPECT_EQ(objects, objects2);
+    EXPECT_EQ(scores, scores2);
+}
+
+TEST(PyramidBuilderACF, batch_matches_single_image)
+{
+    cv::Mat image = cv::imread(sFaceImageFilename, cv::IMREAD_COLOR);
+    ASSERT_FALSE(image.empty());
+    cv::cvtColor(image, image, cv::COLOR_BGR2RGB);
+    cv::resize(image, image, {}, 0.5, 0.5, cv::INTER_AREA);
+
+    std::vector<cv::Mat> images(3);
+    cv::flip(image, images[0], 1);
+    images[1] = image;
+    cv::flip(image, images[2], 0);
+
+    drishti::ml::ObjectDetectorACF detector(sFaceDetector);
+    ASSERT_TRUE(detector.good());
+
+    drishti::ml::PyramidBuilderACF builder(detector.getDetector(), drishti::core::Executor::getInstance());
+    std::vector<drishti::ml::PyramidBuilderACF::Pyramid> pyramids;
+    builder(images, pyramids);
+    builder(images, pyramids); // reuse the slots and pyramids
+    ASSERT_EQ(pyramids.size(), images.size());
+    EXPECT_EQ(builder.getPlanCount(), 1);
+
+    const auto& plan = builder.getPlan(image.size());
+    for (std::size_t i = 0; i < images.size(); i++)
+    {
+        // Reference: the per image conversion of the face tool
+        cv::Mat It = images[i].t(), Itf;
+        It.convertTo(Itf, CV_32FC3, 1.0 / 255.0);
+        drishti::ml::PyramidBuilderACF::Pyramid expected;
+        detector.getDetector()->computePyramid(MatP(Itf), expected);
+
+        ASSERT_EQ(pyramids[i].nScales, expected.nScales);
+        ASSERT_EQ(pyramids[i].nScales, plan.layout.nScales);
+        for (int j = 0; j < expected.nScales; j++)
+        {
+            const auto& a = pyramids[i].data[j][0].get();
+            const auto& b = expected.data[j][0].get();
+            ASSERT_EQ(a.size(), b.size());
+            EXPECT_EQ(cv::Size(a[0].rows, a[0].cols), plan.levels[j]);
+            for (std::size_t k = 0; k < a.size(); k++)
+            {
+                EXPECT_EQ(cv::norm(a[k], b[k], cv::NORM_INF), 0.0);
+            }
+        }
+    }
+}
@@ -70,6 +70,31 @@ std::vector<cv::Point2f> CPR::getMeanShape() const
     return std::vector<cv::Point2f>{ { e.center.x, 0 }, { e.center.y, 0 }, { e.size.width, 0 }, { e.size.height }, { e.angle, 0 } };
 }
 
+core::MemoryUsage CPR::memoryUsage() const
+{
+    std::size_t features = 0, trees = 0;
+    if (regModel.has && regModel->regs.has)
+    {
+        for (const auto& reg : *(regModel->regs))
+        {
+            if (reg->ftrData.has)
+            {
+                features += core::getMemoryUsage(reg->ftrData->xs.get()) + core::getMemoryUsage(reg->ftrData->pids.get());
+            }
+            for (const auto& booster : reg->xgbdt)
+            {
+                const auto& forest = booster.second->getTreeEnsemble();
+                trees += core::getMemoryUsage(forest.getNodes()) + core::getMemoryUsage(forest.getRoots());
+            }
+        }
+    }
+
+    core::MemoryUsage usage;
+    usage.add("features", features);
+    usage.add("forests", trees);
+    return usage;
+}
+
 cv::RotatedRect CPR::getPStar() const
 {
     Vector1d mu = regModel->pStar_;
@@ -97,7 +122,27 @@ static Vector1d pointsToPhi(const std::vector<cv::Point2f>& points)
     return ellipseToPhi(pointsToEllipse(points));
 }
 
+static void resultToPoints(const CPR::CPRResult& result, std::vector<cv::Point2f>& points)
+{
+    if (result.p.size() == 5)
+    {
+        cv::RotatedRect ellipse = phiToEllipse(result.p);
+        points = {
+            { ellipse.center.x, 0.f }, // tranpose center
+            { ellipse.center.y, 0.f },
+            { ellipse.size.width, 0.f }, // flip width and height
+            { ellipse.size.height, 0.f },
+            { ellipse.angle, 0.f }
+        };
+    }
+}
+
 int CPR::operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask) const
+{
+    return (*this)(I, M, points, mask, getContext());
+}
+
+int CPR::operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask, const Context& context) const
 {
     CPRResult result;
 
@@ -120,20 +165,34 @@ int CPR::operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, Bool
     {
         ImageMaskPair Is{ I, M };
         Vector1d pStar = (points.size() == 5) ? pointsToPhi(points) : (*regModel->pStar);
-        cprApplyTree(Is, *regModel, pStar, result, m_doPreview);
+        cprApplyTree(Is, *regModel, pStar, result, context, m_doPreview);
     }
 
-    if (result.p.size() == 5)
+    resultToPoints(result, points);
+
+    return 0;
+}
+
+int CPR::operator()(const cv::Mat& I, const cv::Mat& M, std::vector<Point2fVec>& points) const
+{
+    return (*this)(I, M, points, getContext());
+}
+
+int CPR::operator()(const cv::Mat& I, const cv::Mat& M, std::vector<Point2fVec>& points, const Context& context) const
+{
+    CV_Assert(!m_isMat);
+
+    std::vector<Vector1d> pInit(points.size());
+    for (int i = 0; i < points.size(); i++)
     {
-        points.resize(5);
-        cv::RotatedRect ellipse = phiToEllipse(result.p);
-        points = {
-            { ellipse.center.x, 0.f }, // tranpose center
-            { ellipse.center.y, 0.f },
-            { ellipse.size.width, 0.f }, // flip width and height
-            { ellipse.size.height, 0.f },
-            { ellipse.angle, 0.f }
-        };
+        pInit[i] = (points[i].size() == 5) ? pointsToPhi(points[i]) : (*regModel->pStar);
+    }
+
+    std::vector<CPRResult> results;
+    cprApplyTree(ImageMaskPair{ I, M }, *regModel, pInit, results, context);
+    for (int i = 0; i < points.size(); i++)
+    {
+        resultToPoints(results[i], points[i]);
     }
 
     return 0;
@@ -144,4 +203,9 @@ int CPR::operator()(const cv::Mat& I, std::vector<cv::Point2f>& points, std::vec
     return (*this)(I, {}, points, mask);
 }
 
+int CPR::operator()(const cv::Mat& I, std::vector<cv::Point2f>& points, std::vector<bool>& mask, const Context& context) const
+{
+    return (*this)(I, {}, points, mask, context);
+}
+
 DRISHTI_RCPR_NAMESPACE_END
@@ -34,6 +34,7 @@
 
 #include "drishti/core/Logger.h"
 #include "drishti/core/Field.h"
+#include "drishti/core/TrainingReport.h"
 #include "drishti/rcpr/ImageMaskPair.h"
 #include "drishti/rcpr/Vector1d.h"
 #include "drishti/rcpr/Recipe.h"
@@ -80,8 +81,35 @@ public:
         m_viewer = viewer;
     }
 
+    // Training memory budget in bytes for the feature matrix and per regressor copies (0 : unlimited):
+    void setTrainingMemoryLimit(std::size_t bytes)
+    {
+        m_trainingMemoryLimit = bytes;
+    }
+
+    // Write the training state after each stage to a checkpoint file, and resume cprTrain() from
+    // one (same data and leading recipes), e.g., to fork parameter sweeps from shared stages:
+    void setCheckpoint(const std::string& filename)
+    {
+        m_checkpoint = filename;
+    }
+
+    void setResume(const std::string& filename)
+    {
+        m_resume = filename;
+    }
+
+    // Per stage phase timing and memory reports (see core::TrainingReport), not owned:
+    void setReport(core::TrainingReport* report)
+    {
+        m_report = report;
+    }
+
     virtual std::vector<cv::Point2f> getMeanShape() const;
 
+    // Heap footprint of the cascade (feature locations and the native tree ensembles):
+    virtual core::MemoryUsage memoryUsage() const;
+
     cv::RotatedRect getPStar() const; // get mean normalized ellipse
 
     struct Ellipse
@@ -111,6 +139,25 @@ public:
         return stagesHint;
     };
 
+    virtual void setConvergenceThreshold(float threshold)
+    {
+        convergenceThreshold = threshold;
+    };
+
+    virtual float getConvergenceThreshold() const
+    {
+        return convergenceThreshold;
+    };
+
+    //! Settings from setStagesHint() and setConvergenceThreshold():
+    Context getContext() const
+    {
+        Context context;
+        context.stages = stagesHint;
+        context.convergence = convergenceThreshold;
+        return context;
+    }
+
     struct Model // Currently used in both CprPrm and RegModel ???
     {
         struct Parts
@@ -214,6 +261,21 @@ public:
     };
     core::Field<RegModel> regModel;
 
+    // The training state after a stage (see setCheckpoint()):
+    struct Checkpoint
+    {
+        int stage = 0;   // completed stages
+        EllipseVec pCur; // current estimates of the (augmented) training samples
+        std::vector<core::Field<RegModel::Regs>> regs;
+        std::vector<double> losses;
+
+        template <class Archive>
+        void serialize(Archive& ar, const unsigned int version);
+    };
+
+    static bool saveCheckpoint(const std::string& filename, const Checkpoint& checkpoint);
+    static bool loadCheckpoint(const std::string& filename, Checkpoint& checkpoint);
+
     bool usesMask() const;
 
     struct CPROpts
@@ -233,11 +295,30 @@ public:
 
     virtual int operator()(const cv::Mat& I, const cv::Mat& M, PointVec& points, std::vector<bool>& mask) const;
     virtual int operator()(const cv::Mat& I, PointVec& points, std::vector<bool>& mask) const;
+    virtual int operator()(const cv::Mat& I, const cv::Mat& M, PointVec& points, std::vector<bool>& mask, const Context& context) const;
+    virtual int operator()(const cv::Mat& I, PointVec& points, std::vector<bool>& mask, const Context& context) const;
+
+    //! Regress several (5 parameter) initializations together, see operator():
+    int operator()(const cv::Mat& I, const cv::Mat& M, std::vector<PointVec>& points) const;
+    int operator()(const cv::Mat& I, const cv::Mat& M, std::vector<PointVec>& points, const Context& context) const;
 
     struct FeaturesResult
     {
         Vector1d ftrs;
         std::vector<uint8_t> ftrMask;
+        std::vector<float> x, y, values; // planar feature samples (scratch)
+    };
+
+    // Per thread scratch space, reused across stages and calls (see cprApplyTree()):
+    struct Workspace
+    {
+        FeaturesResult ftrResult;
+        cv::Mat1f features; // one row per initialization
+        std::vector<float> scores;
+        std::vector<Vector1d> pDel;
+        Vector1d pPrev;
+
+        static Workspace& get();
     };
 
     struct FernResult
@@ -249,6 +330,11 @@ public:
     int cprTrain(const ImageMaskPairVec& images, const EllipseVec& ellipses, const HVec& H, const CprPrm& cprPrm, bool doJitter = false);
     int cprApplyTree(const cv::Mat& Is, const RegModel& regModel, const Vector1d& p, CPRResult& result, bool preview = false) const;
     int cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const Vector1d& p, CPRResult& result, bool preview = false) const;
+    int cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const std::vector<Vector1d>& p, std::vector<CPRResult>& results) const;
+
+    // Apply the cascade with the stage limit and convergence threshold in context:
+    int cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const Vector1d& p, CPRResult& result, const Context& context, bool preview = false) const;
+    int cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const std::vector<Vector1d>& p, std::vector<CPRResult>& results, const Context& context) const;
 
     virtual void setDoPreview(bool flag);
 
@@ -279,8 +365,16 @@ protected:
 #endif
 
     int stagesHint = std::numeric_limits<int>::max();
+    float convergenceThreshold = 0.f; // weighted pose update (see dist()) for early termination
 
     ViewFunc m_viewer;
+
+    std::size_t m_trainingMemoryLimit = 0;
+
+    std::string m_checkpoint;
+    std::string m_resume;
+
+    core::TrainingReport* m_report = nullptr;
 };
 
 // Alias:
@@ -288,6 +382,7 @@ using FtrData = CPR::RegModel::Regs::FtrData;
 
 int createModel(int type, CPR::Model& model);
 int featuresComp(const CPR::Model& model, const Vector1d& p, const ImageMaskPair& I, const FtrData& ftrData, CPR::FeaturesResult& result, bool useNPD = false);
+int featuresComp(const CPR::Model& model, const Vector1d& p, const ImageMaskPair& I, const FtrData& ftrData, float* ftrs, CPR::FeaturesResult& result, bool useNPD = false);
 int ftrsGen(const CPR::Model& model, const CPR::CprPrm::FtrPrm& ftrPrmIn, FtrData& ftrData, float lambda = 0.1f);
 Vector1d identity(const CPR::Model& model);
 Vector1d compose(const CPR::Model& mnodel, const Vector1d& phis0, const Vector1d& phis1);
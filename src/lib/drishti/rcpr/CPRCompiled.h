@@ -0,0 +1,35 @@
+/*! -*-c++-*-
+  @file   CPRCompiled.h
+  @author David Hirvonen
+  @brief  Declaration of factories for CPR models compiled into the library.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The definitions are generated from serialized (.cpb) CPR models by the
+  drishti_cpr_codegen tool and are only available when the SDK is built with
+  DRISHTI_BUILD_CPR_COMPILED=ON and DRISHTI_CPR_COMPILED_SOURCE=<generated.cpp>.
+
+*/
+
+#ifndef __drishti_rcpr_CPRCompiled_h__
+#define __drishti_rcpr_CPRCompiled_h__
+
+#include "drishti/rcpr/drishti_rcpr.h"
+#include "drishti/rcpr/CPR.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+DRISHTI_RCPR_NAMESPACE_BEGIN
+
+//! Names of the compiled models (see drishti_cpr_codegen --name):
+std::vector<std::string> getCompiledCPRNames();
+
+//! Create a compiled model by name (nullptr for unknown names), no deserialization is required:
+std::unique_ptr<CPR> createCompiledCPR(const std::string& name);
+
+DRISHTI_RCPR_NAMESPACE_END
+
+#endif // __drishti_rcpr_CPRCompiled_h__
@@ -109,6 +109,15 @@ void CPR::RegModel::Regs::serialize(Archive& ar, const unsigned int version)
     ar& xgbdt;
 }
 
+template <class Archive>
+void CPR::Checkpoint::serialize(Archive& ar, const unsigned int version)
+{
+    ar& stage;
+    ar& pCur;
+    ar& regs;
+    ar& losses;
+}
+
 template <class Archive>
 void CPR::RegModel::serialize(Archive& ar, const unsigned int version)
 {
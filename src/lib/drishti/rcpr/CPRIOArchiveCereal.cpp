@@ -25,6 +25,9 @@
 
 #include <opencv2/core.hpp>
 
+#include <cstdio>
+#include <fstream>
+
 CEREAL_SPECIALIZE_FOR_ALL_ARCHIVES(drishti::core::Field<cv::Mat>, cereal::specialization::member_serialize);
 CEREAL_SPECIALIZE_FOR_ALL_ARCHIVES(drishti::rcpr::CPR, cereal::specialization::member_serialize);
 CEREAL_CLASS_VERSION(drishti::rcpr::CPR, 1);
@@ -43,6 +46,7 @@ template void CPR::CprPrm::serialize<OArchive>(OArchive& ar, const unsigned int)
 template void CPR::RegModel::Regs::FtrData::serialize<OArchive>(OArchive& ar, const unsigned int);
 template void CPR::RegModel::Regs::serialize<OArchive>(OArchive& ar, const unsigned int);
 template void CPR::RegModel::serialize<OArchive>(OArchive& ar, const unsigned int);
+template void CPR::Checkpoint::serialize<OArchive>(OArchive& ar, const unsigned int);
 template void CPR::serialize<OArchive>(OArchive& ar, const unsigned int);
 template void Recipe::serialize<OArchive>(OArchive& ar, const unsigned int);
 
@@ -54,7 +58,53 @@ template void CPR::CprPrm::serialize<IArchive>(IArchive& ar, const unsigned int)
 template void CPR::RegModel::Regs::FtrData::serialize<IArchive>(IArchive& ar, const unsigned int);
 template void CPR::RegModel::Regs::serialize<IArchive>(IArchive& ar, const unsigned int);
 template void CPR::RegModel::serialize<IArchive>(IArchive& ar, const unsigned int);
+template void CPR::Checkpoint::serialize<IArchive>(IArchive& ar, const unsigned int);
 template void CPR::serialize<IArchive>(IArchive& ar, const unsigned int);
 template void Recipe::serialize<IArchive>(IArchive& ar, const unsigned int);
 
+// ##################################################################
+// #################### training checkpoints ########################
+// ##################################################################
+
+bool CPR::saveCheckpoint(const std::string& filename, const Checkpoint& checkpoint)
+{
+    // Write to a temporary file and rename, so an interrupted run never leaves a partial checkpoint:
+    const std::string tmp = filename + ".tmp";
+    {
+        std::ofstream os(tmp, std::ios::binary);
+        if (!os)
+        {
+            return false;
+        }
+
+        OArchive oa(os);
+        oa << checkpoint;
+        if (!os)
+        {
+            return false;
+        }
+    }
+    return (std::rename(tmp.c_str(), filename.c_str()) == 0);
+}
+
+bool CPR::loadCheckpoint(const std::string& filename, Checkpoint& checkpoint)
+{
+    std::ifstream is(filename, std::ios::binary);
+    if (!is)
+    {
+        return false;
+    }
+
+    try
+    {
+        IArchive ia(is);
+        ia >> checkpoint;
+    }
+    catch (const cereal::Exception&)
+    {
+        return false;
+    }
+    return true;
+}
+
 DRISHTI_RCPR_NAMESPACE_END
@@ -55,6 +55,15 @@ public:
     // Evaluate:
     virtual float operator()(const RealVector& features) = 0;
 
+    // Evaluate nRows feature rows with a pitch of stride floats:
+    virtual void predict(const float* rows, int nRows, int stride, float* out)
+    {
+        for (int i = 0; i < nRows; i++, rows += stride)
+        {
+            out[i] = (*this)(RealVector(rows, rows + stride));
+        }
+    }
+
     // Train:
     virtual void train(const MatrixType<float>& values, const RealVector& labels, const MatrixType<uint8_t>& mask = {}) = 0;
 };
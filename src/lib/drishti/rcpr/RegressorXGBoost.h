@@ -38,6 +38,11 @@ public:
         return (*m_regressor)(features);
     }
 
+    virtual void predict(const float* rows, int nRows, int stride, float* out)
+    {
+        m_regressor->predict(rows, nRows, stride, out);
+    }
+
     // Train:
     virtual void train(const MatrixType<float>& values, const RealVector& labels, const MatrixType<uint8_t>& mask = {})
     {
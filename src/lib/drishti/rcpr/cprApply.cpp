@@ -15,6 +15,9 @@
 
 #include "drishti/geometry/Ellipse.h"
 
+#include <algorithm>
+#include <cmath>
+
 #define DRISHTI_CPR_DO_DEBUG 0
 
 // clang-format off
@@ -39,15 +42,30 @@ std::ostream& operator<<(std::ostream& os, const cv::RotatedRect& e)
     return os;
 }
 
+CPR::Workspace& CPR::Workspace::get()
+{
+    static thread_local Workspace workspace;
+    return workspace;
+}
+
 int CPR::cprApplyTree(const cv::Mat& I, const RegModel& regModel, const Vector1d& pIn, CPRResult& result, bool doPreview) const
 {
-    cv::Mat1b mask = cv::Mat1b::ones(I.size());
-    return cprApplyTree(ImageMaskPair(I, mask), regModel, pIn, result, doPreview);
+    // An empty mask skips the per feature occlusion test (there is nothing to mask):
+    return cprApplyTree(ImageMaskPair(I), regModel, pIn, result, doPreview);
+}
+
+int CPR::cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const Vector1d& pIn, CPRResult& result, bool doPreview) const
+{
+    return cprApplyTree(Is, regModel, pIn, result, getContext(), doPreview);
 }
 
-int CPR::cprApplyTree(const ImageMaskPair& IsIn, const RegModel& regModel, const Vector1d& pIn, CPRResult& result, bool doPreview) const
+int CPR::cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const std::vector<Vector1d>& pIn, std::vector<CPRResult>& results) const
+{
+    return cprApplyTree(Is, regModel, pIn, results, getContext());
+}
+
+int CPR::cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const Vector1d& pIn, CPRResult& result, const Context& context, bool doPreview) const
 {
-    ImageMaskPair Is = IsIn;
     auto& p = result.p;
     p = pIn;
 
@@ -56,43 +74,35 @@ int CPR::cprApplyTree(const ImageMaskPair& IsIn, const RegModel& regModel, const
     auto T = *(regModel.T);
     result.pAll.resize(T); // store result at end of each stage
 
-    // repeat the whole thing 2x
-    std::vector<int> stage;
+    const int stages = std::min(context.stages, int(T));
 
-    // Create a recipe for executing the stages:
-    for (int i = 0; i < std::min(stagesHint, int(T)); i++)
-    {
-        stage.push_back(i);
-    }
+    auto& workspace = Workspace::get();
+    auto& ftrResult = workspace.ftrResult;
+    auto& pDel = workspace.pDel;
+    auto& pPrev = workspace.pPrev;
+    pDel.resize(1);
 
-    for (const auto& t : stage)
+    for (int t = 0; t < stages; t++)
     {
         auto& reg = *(*(regModel.regs))[t];
 
-        FeaturesResult ftrResult;
-        featuresComp(model, p, Is, *(reg.ftrData), ftrResult);
-
-        auto pDel = identity(model);
+        auto& features = workspace.features;
+        features.create(1, int(reg.ftrData->xs->size() / 2));
+        featuresComp(model, p, Is, *(reg.ftrData), features.ptr<float>(0), ftrResult);
 
-        cv::Mat features;
-        cv::Mat(ftrResult.ftrs).reshape(1, 1).copyTo(features);
-        features.convertTo(features, CV_32F);
+        pDel[0].assign(p.size(), RealType(0.0)); // identity(model)
 
         {
-            // XGBOOST
-            std::vector<std::vector<float>> data(features.rows);
-            for (int i = 0; i < features.rows; i++)
-            {
-                data[i] = features.row(i);
-            }
-
+            // XGBOOST (native tree evaluation is reentrant and allocation free):
+            const float* row = features.ptr<float>(0);
             for (auto& t : reg.xgbdt)
             {
-                pDel[t.first] = (*t.second)(data[0]);
+                pDel[0][t.first] = (*t.second)(row);
             }
         }
 
-        p = compose(model, p, pDel);
+        pPrev.assign(p.begin(), p.end());
+        p = compose(model, p, pDel[0]);
         result.pAll[t] = p; // store result for this stage
 
 #if DRISHTI_CPR_DO_DEBUG && !HAS_XGBOOST
@@ -100,7 +110,7 @@ int CPR::cprApplyTree(const ImageMaskPair& IsIn, const RegModel& regModel, const
         if (doPreview)
         {
             cv::Mat canvas;
-            cv::cvtColor(I, canvas, cv::COLOR_GRAY2BGR);
+            cv::cvtColor(Is.getImage(), canvas, cv::COLOR_GRAY2BGR);
 
             const auto e = phiToEllipse(p), eIn = phiToEllipse(pIn);
             cv::ellipse(canvas, eIn, { 255, 0, 0 }, 1, 8);
@@ -112,8 +122,87 @@ int CPR::cprApplyTree(const ImageMaskPair& IsIn, const RegModel& regModel, const
             cv::waitKey(0);
         }
 #endif
+
+        // Stop early once the (weighted) pose update is negligible:
+        if ((context.convergence > 0.f) && (std::sqrt(dist(model, pPrev, p)) < context.convergence))
+        {
+            std::fill(result.pAll.begin() + t + 1, result.pAll.begin() + stages, p);
+            break;
+        }
     }
     return 0;
 }
 
+int CPR::cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const std::vector<Vector1d>& pIn, std::vector<CPRResult>& results, const Context& context) const
+{
+    auto& model = *(regModel.model);
+    const int T = int(*(regModel.T));
+    const int stages = std::min(context.stages, T);
+
+    results.resize(pIn.size());
+    std::vector<int> active; // initializations that haven't converged
+    for (int i = 0; i < pIn.size(); i++)
+    {
+        results[i].p = pIn[i];
+        results[i].pAll.resize(T);
+        active.push_back(i);
+    }
+
+    auto& workspace = Workspace::get();
+    auto& ftrResult = workspace.ftrResult;
+    auto& features = workspace.features;
+    auto& scores = workspace.scores;
+    auto& pDel = workspace.pDel;
+
+    for (int t = 0; (t < stages) && !active.empty(); t++)
+    {
+        auto& reg = *(*(regModel.regs))[t];
+
+        // Features for all active initializations (one row each):
+        features.create(int(active.size()), int(reg.ftrData->xs->size() / 2));
+        for (int r = 0; r < active.size(); r++)
+        {
+            featuresComp(model, results[active[r]].p, Is, *(reg.ftrData), features.ptr<float>(r), ftrResult);
+        }
+
+        // Each pose parameter regressor scores all rows in one pass over its trees:
+        pDel.resize(active.size());
+        for (auto& d : pDel)
+        {
+            d.assign(results[active.front()].p.size(), RealType(0.0)); // identity(model)
+        }
+        scores.resize(active.size());
+        for (auto& x : reg.xgbdt)
+        {
+            x.second->predict(features.ptr<float>(), features.rows, int(features.step1()), scores.data());
+            for (int r = 0; r < active.size(); r++)
+            {
+                pDel[r][x.first] = scores[r];
+            }
+        }
+
+        std::vector<int> remaining;
+        for (int r = 0; r < active.size(); r++)
+        {
+            auto& result = results[active[r]];
+            workspace.pPrev.assign(result.p.begin(), result.p.end());
+            result.p = compose(model, result.p, pDel[r]);
+            result.pAll[t] = result.p;
+
+            // Stop early once the (weighted) pose update is negligible:
+            if ((context.convergence > 0.f) && (std::sqrt(dist(model, workspace.pPrev, result.p)) < context.convergence))
+            {
+                std::fill(result.pAll.begin() + t + 1, result.pAll.begin() + stages, result.p);
+            }
+            else
+            {
+                remaining.push_back(active[r]);
+            }
+        }
+        active.swap(remaining);
+    }
+
+    return 0;
+}
+
 DRISHTI_RCPR_NAMESPACE_END
@@ -18,6 +18,8 @@
 #include "drishti/ml/PCA.h"
 #include "drishti/geometry/Ellipse.h"
 #include "drishti/core/Parallel.h"
+#include "drishti/core/ParallelFor.h"
+#include "drishti/core/ThreadPool.h"
 #include "drishti/core/timing.h"
 
 typedef std::vector<float> T_VECTOR;
@@ -31,8 +33,10 @@ typedef std::vector<T_VECTOR> T_MATRIX;
 // clang-format on
 
 #include <algorithm>
+#include <cstdlib>
 #include <numeric>
 #include <mutex>
+#include <thread>
 
 DRISHTI_RCPR_NAMESPACE_BEGIN
 
@@ -43,6 +47,8 @@ using BoostVec = std::vector<std::shared_ptr<ml::XGBooster>>;
 
 using IntVec = std::vector<int>;
 
+static const int kTrainingChunk = 64; // samples per feature extraction task
+
 #if DRISHTI_CPR_DO_FEATURE_DEBUG
 static cv::Mat draw(BoostVec& gbdt, const EllipseVec& pCur, const ImageMaskPairVec& Is, const IntVec& imgIds, const PointVec& xs);
 #endif
@@ -188,48 +194,97 @@ int CPR::cprTrain(const ImageMaskPairVec& Is, const EllipseVec& pGtIn, const HVe
 
     CV_Assert(T == cprPrm.cascadeRecipes.size());
 
+    // Stages depend on the previous pose estimates, so parallelism is within a stage:
+    // samples (in chunks) for feature extraction, then regressors (pose dimensions)
+    // and candidate parameter sets.  Tasks are scheduled on the shared thread pool
+    // and the calling thread always participates.
+    auto* pool = core::ThreadPoolSource::getInstance();
+
+    core::TrainingReport unreported("cpr");
+    auto& report = m_report ? *m_report : unreported;
+
+    // Continue from the stages (and current estimates) of a previous run:
+    int first = 0;
+    if (!m_resume.empty())
+    {
+        Checkpoint checkpoint;
+        if (!loadCheckpoint(m_resume, checkpoint) || (checkpoint.stage > T) || (checkpoint.pCur.size() != pCur.size()) || (int(checkpoint.regs.size()) != checkpoint.stage))
+        {
+            m_streamLogger->error("checkpoint {} doesn't match the training set or the recipe", m_resume);
+            return 1;
+        }
+
+        first = checkpoint.stage;
+        pCur = checkpoint.pCur;
+        regs = checkpoint.regs;
+        for (const auto& loss : checkpoint.losses)
+        {
+            trainingLog.resize(trainingLog.size() + 1);
+            trainingLog.back().loss = loss;
+        }
+        m_streamLogger->info("resuming after stage {} from {}", first, m_resume);
+    }
+
     // Loop and gradually improve pCur
-    for (int t = 0; t < T; t++)
+    for (int t = first; t < T; t++)
     {
         const auto& recipe = cprPrm.cascadeRecipes[t];
+        report.beginCascade(t);
+
+        // Seed the (rand() based) feature sampling per stage, so a resumed stage draws the same features:
+        std::srand(unsigned(t + 1));
 
         ftrPrm.radius = double(recipe.featureRadius);
         ftrPrm.F = double(recipe.featurePoolSize); // TODO revisit
 
-        MatrixType<uint8_t> mask(pCur.size());
-        cv::Mat features(int(pCur.size()), ftrPrm.F, CV_64F);
-        cv::Mat values(int(pCur.size()), R, CV_64F);
-
         // Generate shared features 1x per stage
         CPR::RegModel::Regs::FtrData ftrData;
         ftrsGen({}, ftrPrm, ftrData, cprPrm.cascadeRecipes[t].lambda);
 
-        // For each model:
-        for (int i = 0; i < pCur.size(); i++)
-        {
-            //% get target value for pose
-            Vector1d tar;
-            tar = inverse({}, pCur[i]); // pCur starts as pStar (mean model)
-            tar = compose({}, tar, pGt[i]);
+        const int F = int(ftrData.xs->size() / 2);
+        const int chunks = (int(pCur.size()) + kTrainingChunk - 1) / kTrainingChunk;
 
-            //% generate and compute pose indexed features
-            CPR::FeaturesResult ftrResult;
-            featuresComp({}, pCur[i], Is[imgIds[i]], ftrData, ftrResult, recipe.useNPD);
+        // One contiguous row per sample, passed to xgboost without a per row copy:
+        std::vector<float> features_(pCur.size() * F);
+        std::vector<uint8_t> mask(recipe.doMask ? pCur.size() * F : 0);
+        MatrixType<float> targets(R, std::vector<float>(pCur.size()));
 
-            // TODO: make decision about format, might be better to stick w/ std::vector<std::vector<T>>
-            mask[i] = ftrResult.ftrMask;
-            cv::Mat(ftrResult.ftrs).reshape(1, 1).copyTo(features.row(i));
-            cv::Mat(tar).reshape(1, 1).copyTo(values.row(i));
-        }
+        report.getMetrics().gauge("features.bytes").set(double(features_.size() * sizeof(float) + mask.size()));
+        report.getMetrics().counter("samples").add(pCur.size());
 
-        features.convertTo(features, CV_32F);
-        values.convertTo(values, CV_32F);
-        T_MATRIX features_(features.rows);
-        for (int i = 0; i < features.rows; i++)
+        // Pose indexed features and regression targets for each chunk of samples:
+        std::function<void(int)> computeFeatures = [&](int c) {
+            CPR::FeaturesResult ftrResult;
+            for (int i = c * kTrainingChunk; i < std::min((c + 1) * kTrainingChunk, int(pCur.size())); i++)
+            {
+                //% get target value for pose
+                Vector1d tar;
+                tar = inverse({}, pCur[i]); // pCur starts as pStar (mean model)
+                tar = compose({}, tar, pGt[i]);
+
+                //% generate and compute pose indexed features
+                featuresComp({}, pCur[i], Is[imgIds[i]], ftrData, &features_[i * F], ftrResult, recipe.useNPD);
+                if (recipe.doMask)
+                {
+                    auto* row = &mask[i * F];
+                    if (ftrResult.ftrMask.size() == F)
+                    {
+                        std::copy(ftrResult.ftrMask.begin(), ftrResult.ftrMask.end(), row);
+                    }
+                    else
+                    {
+                        std::fill(row, row + F, uint8_t(1));
+                    }
+                }
+                for (int k = 0; k < R; k++)
+                {
+                    targets[k][i] = float(tar[k]);
+                }
+            }
+        };
         {
-            // Fill in the feature matrix
-            T_VECTOR row = features.row(i);
-            features_[i] = row;
+            auto timer = report.time("features");
+            core::parallel_for(pool, chunks, computeFeatures);
         }
 
         const size_t N = pCur.size();
@@ -258,13 +313,11 @@ int CPR::cprTrain(const ImageMaskPairVec& Is, const EllipseVec& pGtIn, const HVe
 
         {
             // Estimate regressors
-            std::mutex mutex;
+            int innerThreads = 0; // xgboost threads per booster (set below)
             std::function<void(int)> trainRegressor = [&](int i) {
-                cv::Mat tmp = values.col(regressorToPhiIndex[i]);
-                tmp = tmp.t();
+                auto timer = report.time("regression.booster");
 
-                std::vector<std::vector<float>> data = features_;
-                std::vector<float> target = tmp;
+                const auto& target = targets[regressorToPhiIndex[i]];
 
                 ml::XGBooster::Recipe params;
                 params.learningRate = recipe.learningRate;
@@ -273,20 +326,39 @@ int CPR::cprTrain(const ImageMaskPairVec& Is, const EllipseVec& pGtIn, const HVe
                 params.featureSubsample = float(recipe.featureSampleSize) / recipe.featurePoolSize;
 
                 xgbdt[i] = std::make_shared<ml::XGBooster>(params);
-                xgbdt[i]->train(data, target, recipe.doMask ? mask : MatrixType<uint8_t>());
+                xgbdt[i]->train(features_.data(), int(N), F, F, target, recipe.doMask ? mask.data() : nullptr, innerThreads);
 
-                predictions[i].resize(data.size());
-                for (int j = 0; j < data.size(); j++)
+                predictions[i].resize(N);
+                for (int j = 0; j < N; j++)
                 {
-                    predictions[i][j] = (*xgbdt[i])(data[j]);
+                    predictions[i][j] = (*xgbdt[i])(&features_[j * F]);
                 }
 
                 // Now we compose the models, and find parameter producing lowest error
                 m_streamLogger->info("done training stage {} param {}", t, i);
             };
 
-            core::ParallelHomogeneousLambda harness(trainRegressor);
-            cv::parallel_for_({ 0, int(regressorToPhiIndex.size()) }, harness);
+            // Each booster builds its own (xgboost) copy of the feature matrix:
+            const std::size_t bytes = features_.size() * sizeof(float);
+            int boosters = int(regressorToPhiIndex.size());
+            if (m_trainingMemoryLimit > 0)
+            {
+                const int budget = int(m_trainingMemoryLimit / std::max(bytes, std::size_t(1))) - 1;
+                if (budget < 1)
+                {
+                    m_streamLogger->warn("stage {}: feature matrix ({} bytes) exceeds the training memory limit", t, bytes);
+                }
+                boosters = std::max(1, std::min(boosters, budget));
+            }
+
+            // Split the cores between the concurrent boosters and their xgboost threads, so the two
+            // levels of parallelism don't oversubscribe the machine:
+            const int cores = std::max(1, int(std::thread::hardware_concurrency()));
+            const int concurrent = std::max(1, std::min(boosters, int(regressorToPhiIndex.size())));
+            innerThreads = std::max(1, cores / concurrent);
+
+            auto timer = report.time("regression");
+            core::parallel_for(pool, int(regressorToPhiIndex.size()), trainRegressor, boosters - 1);
         }
 
 #if DRISHTI_CPR_DO_FEATURE_DEBUG
@@ -321,8 +393,8 @@ int CPR::cprTrain(const ImageMaskPairVec& Is, const EllipseVec& pGtIn, const HVe
                 }
                 losses[i] = (loss / double(N));
             };
-            core::ParallelHomogeneousLambda harness(computeLoss);
-            cv::parallel_for_({ 0, int(phiSets.size()) }, harness);
+            auto timer = report.time("loss");
+            core::parallel_for(pool, int(phiSets.size()), computeLoss);
         }
 
         for (int j = 0; j < losses.size(); j++)
@@ -362,6 +434,27 @@ int CPR::cprTrain(const ImageMaskPairVec& Is, const EllipseVec& pGtIn, const HVe
         }
 
         regs.emplace_back(reg);
+
+        if (!m_checkpoint.empty())
+        {
+            auto timer = report.time("checkpoint");
+
+            Checkpoint checkpoint;
+            checkpoint.stage = t + 1;
+            checkpoint.pCur = pCur;
+            checkpoint.regs = regs;
+            for (const auto& log : trainingLog)
+            {
+                checkpoint.losses.push_back(log.loss);
+            }
+
+            if (!saveCheckpoint(m_checkpoint, checkpoint))
+            {
+                m_streamLogger->warn("unable to write checkpoint {}", m_checkpoint);
+            }
+        }
+
+        report.endCascade();
     }
 
     this->regModel->model = model;
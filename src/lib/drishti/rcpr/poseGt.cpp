@@ -11,6 +11,7 @@
 
 #include "drishti/core/drishti_core.h"
 #include "drishti/core/drishti_math.h"
+#include "drishti/core/gather.h"
 #include "drishti/rcpr/CPR.h"
 
 #include <opencv2/imgproc.hpp>
@@ -22,7 +23,6 @@
 DRISHTI_RCPR_NAMESPACE_BEGIN
 
 static Matx33Real getPose(const Vector1d& phi);
-static std::vector<cv::Point2f> xsToPoints(const Matx33Real& HS, const PointVec& xs);
 
 // function part = createPart( parent, wts )
 // % Create single part for model (parent==0 implies root).
@@ -109,67 +109,87 @@ int createModel(int type, CPR::Model& model)
 using FtrData = CPR::RegModel::Regs::FtrData;
 using FtrResult = CPR::FeaturesResult;
 int featuresComp(const CPR::Model& model, const Vector1d& phi, const ImageMaskPair& Im, const FtrData& ftrData, FtrResult& result, bool useNPD)
+{
+    std::vector<float> ftrs(ftrData.xs->size() / 2);
+    featuresComp(model, phi, Im, ftrData, ftrs.data(), result, useNPD);
+    result.ftrs.assign(ftrs.begin(), ftrs.end());
+    return 0;
+}
+
+// All feature locations are mapped by one affine transform and gathered in bulk,
+// features are then computed over contiguous (planar) buffers:
+int featuresComp(const CPR::Model& model, const Vector1d& phi, const ImageMaskPair& Im, const FtrData& ftrData, float* ftrs, FtrResult& result, bool useNPD)
 {
     const auto& I = Im.getImage();
     CV_Assert(I.channels() == 1);
 
     // compute image coordinates from xs adjusted for pose
     Matx33Real HS = getPose(phi); // just single component model for now (don't need multiple parts)
-    const auto& xs = *(ftrData.xs);
-    auto points = xsToPoints(HS, xs);
+    const float H[6] = { float(HS(0, 0)), float(HS(0, 1)), float(HS(0, 2)), float(HS(1, 0)), float(HS(1, 1)), float(HS(1, 2)) };
 
-    // Make sure we avoid out of bounds pixels, somewhat arbitrarily
-    // we can just set these to the top left corner.
-    for (auto& p : points)
+    const auto& xs = *(ftrData.xs);
+    CV_Assert(!(xs.size() % 2));
+    const int n = int(xs.size() / 2);
+
+    // Store the first point of each feature in [0,n) and the second in [n,2n):
+    auto &x = result.x, &y = result.y, &values = result.values;
+    x.resize(2 * n);
+    y.resize(2 * n);
+    values.resize(2 * n);
+    for (int j = 0; j < n; j++)
     {
-        if (!cv::Rect({ 0, 0 }, I.size()).contains(p))
-        {
-            p = { 0.f, 0.f };
-        }
+        x[j] = xs[j * 2 + 0].x;
+        y[j] = xs[j * 2 + 0].y;
+        x[j + n] = xs[j * 2 + 1].x;
+        y[j + n] = xs[j * 2 + 1].y;
     }
 
-    // Compute features:
-    CV_Assert(!(points.size() % 2));
-    auto& ftrs = result.ftrs;
+    // Make sure we avoid out of bounds pixels, somewhat arbitrarily
+    // we can just use the top left corner.
+    const float background = I.empty() ? 0.f : float(I.at<std::uint8_t>(0, 0));
+    core::gatherAffineU8(I.ptr<std::uint8_t>(), I.step[0], I.cols, I.rows, H, x.data(), y.data(), values.data(), 2 * n, background);
 
-    ftrs.resize(points.size() / 2);
-    for (int j = 0, i = 0; i < points.size(); j++, i += 2)
+    // Compute features:
+    const float *f1 = values.data(), *f2 = values.data() + n;
+    const float scale = 1.f / 255.f;
+    if (useNPD)
     {
-        double f1 = static_cast<double>(I.at<std::uint8_t>(points[i + 0])) / 255.0;
-        double f2 = static_cast<double>(I.at<std::uint8_t>(points[i + 1])) / 255.0;
-
-        double d;
-        if (useNPD) // possibly use functor (opt)
+        for (int j = 0; j < n; j++)
         {
-            double denom = (f1 + f2);
-            //d = (denom > 0.0) ? ((f1 - f2) / denom) : 0.0; // NPD
-            d = (f1 - f2) / (denom + 1e-6f); // NPD
+            const float a = f1[j] * scale, b = f2[j] * scale;
+            ftrs[j] = (a - b) / (a + b + 1e-6f); // NPD
         }
-        else
+    }
+    else
+    {
+        for (int j = 0; j < n; j++)
         {
-            d = (f1 - f2);
+            ftrs[j] = (f1[j] - f2[j]) * scale;
         }
+    }
 
-        ftrs[j] = d;
+    result.ftrMask.clear();
 
 #if DRISHTI_CPR_DO_FEATURE_MASK
-        // Store occlusion estimate
-        auto& M = Im.getMask();
+    // Store occlusion estimate
+    const auto& M = Im.getMask();
+    if (!M.empty())
+    {
+        const float outside = float(M.at<std::uint8_t>(0, 0));
+        core::gatherAffineU8(M.ptr<std::uint8_t>(), M.step[0], M.cols, M.rows, H, x.data(), y.data(), values.data(), 2 * n, outside);
+
         auto& mask = result.ftrMask;
-        if (!M.empty())
+        mask.resize(n);
+        for (int j = 0; j < n; j++)
         {
-            uint8_t m1 = M.at<std::uint8_t>(points[i + 0]);
-            uint8_t m2 = M.at<std::uint8_t>(points[i + 1]);
-            uint8_t valid = m1 & m2;
-            mask.push_back(valid);
-
-            if (!valid)
+            mask[j] = std::uint8_t(f1[j]) & std::uint8_t(f2[j]);
+            if (!mask[j])
             {
                 ftrs[j] = NAN; // xgboost special value
             }
         }
-#endif
     }
+#endif
 
     return 0;
 }
@@ -334,17 +354,6 @@ static Matx33Real getPose(const Vector1d& phi)
     return HS;
 }
 
-static std::vector<cv::Point2f> xsToPoints(const Matx33Real& HS, const PointVec& xs)
-{
-    std::vector<cv::Point2f> points(xs.size());
-    for (int i = 0; i < points.size(); i++)
-    {
-        const auto q = HS * cv::Point3f(xs[i].x, xs[i].y, 1.f);
-        points[i] = { q.x, q.y }; // pure affine (i.e., no /z)
-    }
-    return points;
-}
-
 Vector1d identity(const CPR::Model& model)
 {
     return Vector1d(5, 0.0);
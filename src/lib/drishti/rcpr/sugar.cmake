@@ -24,6 +24,7 @@ endif()
 
 sugar_files(DRISHTI_RCPR_HDRS_PUBLIC
   CPR.h
+  CPRCompiled.h
   CPRIO.h
   CPRIOArchive.h
   ImageMaskPair.h
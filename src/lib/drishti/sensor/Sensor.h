@@ -49,15 +49,23 @@ public:
         core::Field<float> m_pixelSize; // = 0.0;
     };
 
-    // ### Extrinsic camera parameters:
+    // ### Extrinsic camera parameters (camera to world: X = R * x + T):
     struct Extrinsic
     {
         Extrinsic() {}
-        Extrinsic(const cv::Matx33f& R)
+        Extrinsic(const cv::Matx33f& R, const cv::Vec3f& T = {})
             : R(R)
+            , T(T)
         {
         }
-        cv::Matx33f R;
+
+        cv::Point3f toWorld(const cv::Point3f& x) const
+        {
+            return cv::Point3f(R * cv::Vec3f(x) + T);
+        }
+
+        cv::Matx33f R = cv::Matx33f::eye();
+        cv::Vec3f T;
     };
 
     SensorModel() {} // init with defaults
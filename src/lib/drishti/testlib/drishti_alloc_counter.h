@@ -0,0 +1,360 @@
+/*! -*-c++-*-
+  @file   drishti_alloc_counter.h
+  @author David Hirvonen
+  @brief  Heap allocation counters for steady state (per frame) allocation budgets.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The replacement global operator new/delete can only be defined once per executable, so
+  they are provided as a macro, DRISHTI_TESTLIB_DEFINE_ALLOCATION_HOOKS, which is expanded
+  in the test main.  cv::Mat buffers are allocated by OpenCV with malloc (cv::fastMalloc),
+  they are counted through a cv::MatAllocator that is installed by each AllocationCounter.
+
+  Usage:
+
+    process(frame); // warm up: lazy initialization, workspace growth
+    drishti::testlib::AllocationCounter counter;
+    for (int i = 0; i < frames; i++)
+    {
+        process(frame);
+    }
+    ASSERT_LE(counter.total().count, budget * frames) << counter;
+
+*/
+
+#ifndef __drishti_testlib_drishti_alloc_counter_h__
+#define __drishti_testlib_drishti_alloc_counter_h__
+
+#include "drishti/testlib/drishti_testlib.h"
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <vector>
+
+// Call site capture (hot spots) in debug builds only:
+// clang-format off
+#if !defined(NDEBUG) && (defined(__GLIBC__) || defined(__APPLE__))
+#  define DRISHTI_TESTLIB_ALLOCATION_SITES 1
+#  include <execinfo.h>
+#else
+#  define DRISHTI_TESTLIB_ALLOCATION_SITES 0
+#endif
+// clang-format on
+
+DRISHTI_TESTLIB_NAMESPACE_BEGIN
+
+struct AllocationStats
+{
+    std::uint64_t count;
+    std::uint64_t bytes;
+};
+
+// Defined by DRISHTI_TESTLIB_DEFINE_ALLOCATION_HOOKS (link error if the hooks are missing):
+bool hasAllocationHooks();
+
+namespace detail
+{
+struct AllocationSite
+{
+    static const int kDepth = 16;
+
+    std::array<void*, kDepth> frames;
+    int depth;
+    std::uint64_t count;
+    std::uint64_t bytes;
+};
+
+struct AllocationState
+{
+    static const std::size_t kSites = 1024; // fixed table: no allocations while recording
+
+    std::atomic<std::uint64_t> count{ 0 };
+    std::atomic<std::uint64_t> bytes{ 0 };
+    std::atomic<int> recorders{ 0 }; // live counters recording call sites
+
+    std::mutex mutex;
+    std::array<AllocationSite, kSites> sites;
+    std::size_t used = 0;
+    std::uint64_t dropped = 0; // allocations from sites that didn't fit in the table
+
+    void insert(const AllocationSite& site, std::size_t size)
+    {
+        std::size_t hash = 0;
+        for (int i = 0; i < site.depth; i++)
+        {
+            hash = (hash * 31) ^ reinterpret_cast<std::uintptr_t>(site.frames[i]);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t i = 0, j = hash % kSites; i < kSites; i++, j = (j + 1) % kSites)
+        {
+            auto& entry = sites[j];
+            if (entry.count == 0)
+            {
+                entry = site;
+                entry.count = 1;
+                entry.bytes = size;
+                used++;
+                return;
+            }
+            if ((entry.depth == site.depth) && std::equal(site.frames.begin(), site.frames.begin() + site.depth, entry.frames.begin()))
+            {
+                entry.count++;
+                entry.bytes += size;
+                return;
+            }
+        }
+        dropped++;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& entry : sites)
+        {
+            entry.count = 0;
+        }
+        used = 0;
+        dropped = 0;
+    }
+};
+
+inline AllocationState& getAllocationState()
+{
+    static AllocationState state;
+    return state;
+}
+
+inline AllocationStats& getThreadAllocations()
+{
+    thread_local AllocationStats stats{ 0, 0 };
+    return stats;
+}
+
+inline bool& isRecordingSite()
+{
+    thread_local bool busy = false;
+    return busy;
+}
+
+inline void recordAllocation(std::size_t size)
+{
+    auto& state = getAllocationState();
+    state.count.fetch_add(1, std::memory_order_relaxed);
+    state.bytes.fetch_add(size, std::memory_order_relaxed);
+
+    auto& local = getThreadAllocations();
+    local.count++;
+    local.bytes += size;
+
+#if DRISHTI_TESTLIB_ALLOCATION_SITES
+    bool& busy = isRecordingSite(); // backtrace() may allocate the first time
+    if (state.recorders.load(std::memory_order_relaxed) && !busy)
+    {
+        busy = true;
+        AllocationSite site;
+        site.depth = ::backtrace(site.frames.data(), AllocationSite::kDepth);
+        site.count = site.bytes = 0;
+        state.insert(site, size);
+        busy = false;
+    }
+#endif
+}
+
+inline void* allocate(std::size_t size)
+{
+    recordAllocation(size);
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// Forwards to the previous allocator and counts new buffers (not user data wrappers):
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+    CountingMatAllocator(cv::MatAllocator* allocator)
+        : allocator(allocator)
+    {
+    }
+
+#if CV_VERSION_MAJOR >= 4
+    using AccessFlags = cv::AccessFlag;
+#else
+    using AccessFlags = int;
+#endif
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, AccessFlags flags, cv::UMatUsageFlags usageFlags) const override
+    {
+        cv::UMatData* u = allocator->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        if (u && !data)
+        {
+            recordAllocation(u->size);
+        }
+        return u;
+    }
+
+    bool allocate(cv::UMatData* data, AccessFlags accessflags, cv::UMatUsageFlags usageFlags) const override
+    {
+        return allocator->allocate(data, accessflags, usageFlags);
+    }
+
+    void deallocate(cv::UMatData* data) const override
+    {
+        allocator->deallocate(data);
+    }
+
+    cv::MatAllocator* allocator;
+};
+} // namespace detail
+
+/*
+ * Counts heap allocations from construction (or the last reset()) on all threads (total)
+ * and on the constructing thread (thread), e.g., to separate the Executor workers from the
+ * caller.  In debug builds, allocations are also grouped by call stack while a counter is
+ * alive, and the heaviest sites are printed by report() (or operator<< for gtest messages).
+ */
+
+class AllocationCounter
+{
+public:
+    AllocationCounter(bool doSites = true)
+        : m_matAllocator(cv::Mat::getDefaultAllocator())
+        , m_doSites(doSites && DRISHTI_TESTLIB_ALLOCATION_SITES)
+    {
+        cv::Mat::setDefaultAllocator(&m_matAllocator);
+        if (m_doSites)
+        {
+            detail::getAllocationState().recorders++;
+        }
+        reset();
+    }
+
+    ~AllocationCounter()
+    {
+        if (m_doSites)
+        {
+            detail::getAllocationState().recorders--;
+        }
+        cv::Mat::setDefaultAllocator(m_matAllocator.allocator);
+    }
+
+    AllocationCounter(const AllocationCounter&) = delete;
+    AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+    void reset()
+    {
+        auto& state = detail::getAllocationState();
+        if (m_doSites)
+        {
+            state.clear();
+        }
+        m_total = { state.count.load(), state.bytes.load() };
+        m_thread = detail::getThreadAllocations();
+    }
+
+    AllocationStats total() const
+    {
+        const auto& state = detail::getAllocationState();
+        return { state.count.load() - m_total.count, state.bytes.load() - m_total.bytes };
+    }
+
+    AllocationStats thread() const
+    {
+        const auto& stats = detail::getThreadAllocations();
+        return { stats.count - m_thread.count, stats.bytes - m_thread.bytes };
+    }
+
+    static bool hasSites()
+    {
+        return DRISHTI_TESTLIB_ALLOCATION_SITES;
+    }
+
+    void report(std::ostream& os, int top = 8) const
+    {
+        const auto stats = total();
+        os << "allocations: " << stats.count << " (" << stats.bytes << " bytes)" << std::endl;
+        if (!m_doSites)
+        {
+            return;
+        }
+
+#if DRISHTI_TESTLIB_ALLOCATION_SITES
+        bool& busy = detail::isRecordingSite(); // don't record the report itself
+        busy = true;
+
+        auto& state = detail::getAllocationState();
+        std::vector<detail::AllocationSite> sites;
+        std::uint64_t dropped = 0;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            std::copy_if(state.sites.begin(), state.sites.end(), std::back_inserter(sites), [](const detail::AllocationSite& site) { return site.count > 0; });
+            dropped = state.dropped;
+        }
+
+        const auto byCount = [](const detail::AllocationSite& a, const detail::AllocationSite& b) { return a.count > b.count; };
+        std::sort(sites.begin(), sites.end(), byCount);
+        sites.resize(std::min(sites.size(), std::size_t(std::max(top, 0))));
+
+        for (const auto& site : sites)
+        {
+            os << site.count << " allocations (" << site.bytes << " bytes):" << std::endl;
+
+            // Skip recordAllocation() and the allocate() hook:
+            const int skip = std::min(site.depth, 2);
+            if (char** symbols = ::backtrace_symbols(site.frames.data() + skip, site.depth - skip))
+            {
+                for (int i = 0; i < site.depth - skip; i++)
+                {
+                    os << "  " << symbols[i] << std::endl;
+                }
+                std::free(symbols);
+            }
+        }
+        if (dropped)
+        {
+            os << dropped << " allocations from untracked sites" << std::endl;
+        }
+
+        busy = false;
+#endif
+    }
+
+protected:
+    detail::CountingMatAllocator m_matAllocator;
+    bool m_doSites = false;
+
+    AllocationStats m_total;
+    AllocationStats m_thread;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const AllocationCounter& counter)
+{
+    counter.report(os);
+    return os;
+}
+
+DRISHTI_TESTLIB_NAMESPACE_END
+
+// clang-format off
+#define DRISHTI_TESTLIB_DEFINE_ALLOCATION_HOOKS                                             \
+    bool drishti::testlib::hasAllocationHooks() { return true; }                            \
+    void* operator new(std::size_t size) { return drishti::testlib::detail::allocate(size); }   \
+    void* operator new[](std::size_t size) { return drishti::testlib::detail::allocate(size); } \
+    void operator delete(void* ptr) noexcept { std::free(ptr); }                            \
+    void operator delete[](void* ptr) noexcept { std::free(ptr); }
+// clang-format on
+
+#endif // __drishti_testlib_drishti_alloc_counter_h__
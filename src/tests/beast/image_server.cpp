@@ -17,18 +17,179 @@
 #endif // DRISHTI_USE_IMSHOW
 // clang-format on
 
+#include "drishti/core/Executor.h"
+#include "drishti/core/LazyParallelResource.h"
+#include "drishti/core/make_unique.h"
+#include "drishti/face/FaceDetector.h"
+#include "drishti/face/FaceDetectorFactoryJson.h"
+
+#include <opencv2/imgproc.hpp>
+
 #include "cxxopts.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
 
-/// Block until SIGINT or SIGTERM is received.
-void sig_wait()
+using FaceDetectorPtr = std::unique_ptr<drishti::face::FaceDetector>;
+using ReplyHandler = websocket::async_server::reply_handler;
+
+struct Request
 {
-    boost::asio::io_service ios;
-    boost::asio::signal_set signals(ios, SIGINT, SIGTERM);
-    signals.async_wait([&](boost::system::error_code const&, int) {});
-    ios.run();
+    cv::Mat image;
+    ReplyHandler reply;
+};
+
+/*
+ * Requests from all connections are collected for up to one batching window (or until the
+ * batch is full), and each batch is split into contiguous chunks across the worker pool, so
+ * the workers run back to back on their (thread local) detectors instead of once per message.
+ * The regressors are shared by all detectors (see FaceDetectorFactory).
+ */
+
+class Batcher
+{
+public:
+    using Runner = std::function<void(std::vector<Request>& batch)>;
+
+    Batcher(std::size_t size, std::chrono::microseconds window, const Runner& runner)
+        : m_size(std::max(size, std::size_t(1)))
+        , m_window(window)
+        , m_runner(runner)
+    {
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    ~Batcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+    }
+
+    void push(Request&& request)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.push_back(std::move(request));
+        }
+        m_condition.notify_all();
+    }
+
+protected:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_condition.wait(lock, [&]() { return m_stop || !m_pending.empty(); });
+            if (m_pending.empty())
+            {
+                break; // stopped
+            }
+
+            // The window starts with the first request of the batch:
+            const auto deadline = std::chrono::steady_clock::now() + m_window;
+            m_condition.wait_until(lock, deadline, [&]() { return m_stop || (m_pending.size() >= m_size); });
+
+            const std::size_t n = std::min(m_pending.size(), m_size);
+            std::vector<Request> batch(std::make_move_iterator(m_pending.begin()), std::make_move_iterator(m_pending.begin() + n));
+            m_pending.erase(m_pending.begin(), m_pending.begin() + n);
+
+            lock.unlock();
+            m_runner(batch);
+            lock.lock();
+        }
+    }
+
+    std::size_t m_size = 8;
+    std::chrono::microseconds m_window;
+    Runner m_runner;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<Request> m_pending;
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+// Decode in place when the message is one contiguous buffer (the usual case), else gather once:
+static cv::Mat decode(const beast::streambuf& db)
+{
+    const auto buffers = db.data();
+    const std::size_t size = boost::asio::buffer_size(buffers);
+    if (size == 0)
+    {
+        return {};
+    }
+
+    const auto first = buffers.begin();
+    if (boost::asio::buffer_size(*first) == size)
+    {
+        auto* data = const_cast<unsigned char*>(boost::asio::buffer_cast<const unsigned char*>(*first));
+        return cv::imdecode(cv::Mat(1, static_cast<int>(size), CV_8UC1, data), cv::IMREAD_COLOR);
+    }
+
+    std::vector<unsigned char> buffer(size);
+    boost::asio::buffer_copy(boost::asio::buffer(buffer), buffers);
+    return cv::imdecode(buffer, cv::IMREAD_COLOR);
+}
+
+static void save(const beast::streambuf& db, const std::string& filename)
+{
+    std::ofstream os(filename, std::ios::binary);
+    for (const auto& b : db.data())
+    {
+        os.write(boost::asio::buffer_cast<const char*>(b), boost::asio::buffer_size(b));
+    }
+}
+
+// Compact reply: {"faces":[{"roi":[x,y,w,h],"eyes":[lx,ly,rx,ry]},...]}
+static std::string toJson(const std::vector<drishti::face::FaceModel>& faces)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1) << "{\"faces\":[";
+    for (std::size_t i = 0; i < faces.size(); i++)
+    {
+        const auto& roi = faces[i].roi.value;
+        const auto eyeL = faces[i].getEyeLeftCenter();
+        const auto eyeR = faces[i].getEyeRightCenter();
+
+        ss << (i ? "," : "") << "{\"roi\":[" << roi.x << "," << roi.y << "," << roi.width << "," << roi.height << "]";
+        ss << ",\"eyes\":[" << eyeL.x << "," << eyeL.y << "," << eyeR.x << "," << eyeR.y << "]}";
+    }
+    ss << "]}";
+    return ss.str();
+}
+
+static std::string detect(drishti::face::FaceDetector& detector, const cv::Mat& image)
+{
+    if (image.empty())
+    {
+        return "{\"error\":\"decode\"}";
+    }
+
+    cv::Mat rgb, green, Itf;
+    cv::cvtColor(image, rgb, cv::COLOR_BGR2RGB);
+    cv::extractChannel(rgb, green, 1);
+    cv::Mat(rgb.t()).convertTo(Itf, CV_32FC3, 1.0f / 255.f);
+
+    const MatP planar(Itf);
+    const drishti::face::FaceDetector::PaddedImage padded(green, { { 0, 0 }, green.size() });
+
+    std::vector<drishti::face::FaceModel> faces;
+    detector(planar, padded, faces);
+    return toJson(faces);
 }
 
 int gauze_main(int argc, char** argv)
@@ -40,13 +201,33 @@ int gauze_main(int argc, char** argv)
     std::uint16_t port = 6000;
     bool doWindow = false;
 
+    // Inference:
+    int threads = 0;
+    int ioThreads = 1;
+    int batchSize = 8;
+    int batchWindow = 5; // ms
+    std::string sFactory;
+    auto factory = std::make_shared<drishti::face::FaceDetectorFactory>();
+
     // clang-format off
-    cxxopts::Options options("test-image-server", "Minimal image logging websocket server (beast)");
+    cxxopts::Options options("test-image-server", "Minimal image logging and face inference websocket server (beast)");
     options.add_options()
         ("a,address", "Address", cxxopts::value<std::string>(sAddress))
         ("p,port", "Port", cxxopts::value<std::uint16_t>(port))
-        ("o,output", "Output directory", cxxopts::value<std::string>(sOutput))
+        ("o,output", "Output directory (log received images)", cxxopts::value<std::string>(sOutput))
         ("w,window", "Display images in window", cxxopts::value<bool>(doWindow))
+
+        // Clasifier and regressor models (inference is enabled with a detector):
+        ("D,detector", "Face detector model", cxxopts::value<std::string>(factory->sFaceDetector))
+        ("M,mean", "Face detector mean", cxxopts::value<std::string>(factory->sFaceDetectorMean))
+        ("R,regressor", "Face regressor", cxxopts::value<std::string>(factory->sFaceRegressor))
+        ("E,eye", "Eye model", cxxopts::value<std::string>(factory->sEyeRegressor))
+        ("F,factory", "Factory (json model zoo)", cxxopts::value<std::string>(sFactory))
+
+        ("t,threads", "Inference workers (0 : one per core)", cxxopts::value<int>(threads))
+        ("io-threads", "Network (and decode) threads", cxxopts::value<int>(ioThreads))
+        ("b,batch", "Maximum batch size", cxxopts::value<int>(batchSize))
+        ("batch-window", "Batching window in milliseconds", cxxopts::value<int>(batchWindow))
         ("h,help", "Print help message");
     // clang-format on
 
@@ -58,9 +239,15 @@ int gauze_main(int argc, char** argv)
         return 0;
     }
 
-    if (sOutput.empty())
+    if (!sFactory.empty())
     {
-        std::cerr << "Must specify a valid output directory" << std::endl;
+        factory = std::make_shared<drishti::face::FaceDetectorFactoryJson>(sFactory);
+    }
+
+    const bool doInference = !factory->sFaceDetector.empty();
+    if (sOutput.empty() && !doInference)
+    {
+        std::cerr << "Must specify a valid output directory or a face detector" << std::endl;
         return -1;
     }
 
@@ -75,57 +262,128 @@ int gauze_main(int argc, char** argv)
     pmd.server_enable = true;
     pmd.compLevel = 3;
 
-    websocket::async_server s1{ &std::cout, 1 };
+    websocket::async_server s1{ &std::cout, static_cast<std::size_t>(std::max(ioThreads, 1)) };
     s1.set_option(read_message_max{ 64 * 1024 * 1024 });
     s1.set_option(auto_fragment{ false });
     s1.set_option(pmd);
 
     boost::asio::io_service ios;
 
-    int counter = 0;
-    
-    // clang-format off
-    websocket::async_server::streambuf_handler handler = [&](beast::streambuf& db)
-    {
-        std::stringstream ss;
-        ss << sOutput << "/frame_" << std::setw(4) << std::setfill('0') << counter++ << ".png";
-
-        std::ofstream os(ss.str(), std::ios::binary);
-        if (os)
+    std::atomic<int> counter{ 0 };
+    auto log = [&](beast::streambuf& db) {
+        if (!sOutput.empty())
         {
-            std::size_t count = 0;
-            std::vector<char> buffer(db.size());
-            for (const auto& b : db.data())
-            {
-                std::size_t s2 = boost::asio::buffer_size(b);
-                const char* p2 = boost::asio::buffer_cast<const char*>(b);
-
-                memcpy(buffer.data() + count, p2, s2);
-                count += s2;
-            }
-            os.write(buffer.data(), buffer.size()); // write buffer asyncrhonously
+            std::stringstream ss;
+            ss << sOutput << "/frame_" << std::setw(4) << std::setfill('0') << counter++ << ".png";
+            save(db, ss.str());
+        }
+    };
 
-// push buffer to single threaded display queue
+    auto display = [&](const cv::Mat& image) {
+// push image to single threaded display queue
 #if defined(DRISHTI_USE_IMSHOW)
-            cv::Mat image = cv::imdecode(buffer, CV_LOAD_IMAGE_COLOR);
+        if (doWindow && !image.empty())
+        {
             ios.post([=]() {
                 glfw::imshow("image_server", image);
                 glfw::waitKey(1);
             });
+        }
 #endif
+    };
+
+    // One detector per worker thread, created on first use:
+    drishti::core::ThreadLocalParallelResource<FaceDetectorPtr> detectors = [&]() {
+        auto detector = drishti::core::make_unique<drishti::face::FaceDetector>(*factory);
+        detector->setDoNMS(true);
+        detector->setDoNMSGlobal(true);
+        return detector;
+    };
+
+    drishti::core::Executor::Options pool;
+    pool.threads = threads;
+    auto executor = drishti::core::make_unique<drishti::core::Executor>(pool);
+
+    // clang-format off
+    Batcher::Runner runner = [&](std::vector<Request>& requests)
+    {
+        auto batch = std::make_shared<std::vector<Request>>(std::move(requests));
+        const std::size_t workers = std::max(std::min(std::size_t(executor->size()), batch->size()), std::size_t(1));
+        const std::size_t chunk = (batch->size() + workers - 1) / workers;
+        for (std::size_t begin = 0; begin < batch->size(); begin += chunk)
+        {
+            const std::size_t end = std::min(begin + chunk, batch->size());
+            executor->post([&, batch, begin, end]()
+            {
+                auto& detector = detectors.get();
+                for (std::size_t i = begin; i < end; i++)
+                {
+                    (*batch)[i].reply(detect(*detector, (*batch)[i].image));
+                }
+            });
         }
+    };
+    // clang-format on
+
+    std::mutex shutdown;
+    bool stopping = false;
+
+    std::unique_ptr<Batcher> batcher;
+    if (doInference)
+    {
+        batcher = drishti::core::make_unique<Batcher>(batchSize, std::chrono::milliseconds(batchWindow), runner);
+
+        // clang-format off
+        websocket::async_server::message_handler handler = [&](beast::streambuf& db, ReplyHandler reply)
+        {
+            log(db);
+
+            // The streambuf is released (reused for the next read) once the reply is sent:
+            Request request{ decode(db), reply };
+            display(request.image);
+
+            std::lock_guard<std::mutex> lock(shutdown);
+            if (stopping)
+            {
+                reply("{\"error\":\"shutdown\"}");
+                return;
+            }
+            batcher->push(std::move(request));
+        };
         // clang-format on
 
-        return 0;
-    };
+        s1.add(handler);
+    }
+    else
+    {
+        // clang-format off
+        websocket::async_server::streambuf_handler handler = [&](beast::streambuf& db)
+        {
+            log(db);
+#if defined(DRISHTI_USE_IMSHOW)
+            display(decode(db));
+#endif
+            return 0;
+        };
+        // clang-format on
+
+        s1.add(handler);
+    }
 
-    s1.add(handler);
     s1.open(endpoint_type{ address_type::from_string(sAddress), port }, ec);
 
     boost::asio::signal_set signals(ios, SIGINT, SIGTERM);
     signals.async_wait([&](boost::system::error_code const&, int) {});
     ios.run();
 
+    // Stop accepting work and answer the queued requests while the connections are still open:
+    {
+        std::lock_guard<std::mutex> lock(shutdown);
+        stopping = true;
+    }
+    batcher.reset();
+    executor.reset();
+
     return 0;
 }
 
@@ -12,12 +12,17 @@
 
 */
 
+#include "drishti/testlib/drishti_alloc_counter.h"
+
 #include <gtest/gtest.h>
 
 #include <cxxopts.hpp>
 
 #include <fstream>
 
+// Heap allocation counting for the steady state (per frame) allocation budget tests:
+DRISHTI_TESTLIB_DEFINE_ALLOCATION_HOOKS
+
 const char* sFaceDetector;
 const char* sFaceDetectorMean;
 const char* sFaceRegressor;
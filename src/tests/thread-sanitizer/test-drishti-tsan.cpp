@@ -0,0 +1,277 @@
+/*! -*-c++-*-
+  @file   test-drishti-tsan.cpp
+  @author David Hirvonen
+  @brief  Multi-threaded stress test for models shared by concurrent callers.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Many threads evaluate the face detector, the face landmark regressor and the eye model
+  estimator (eyelids + CPR iris) against one shared model instance, and every result must
+  match a serial reference run bit for bit.  The test is meant to be run under a thread
+  sanitizer build (i.e., the polly sanitize-thread toolchain), which turns any data race in
+  the shared models, the reentrant evaluators or the executor into a failure.
+
+*/
+
+#include "drishti/face/FaceDetector.h"
+#include "drishti/face/FaceDetectorFactory.h"
+#include "drishti/eye/EyeModelEstimator.h"
+#include "drishti/ml/ShapeEstimator.h"
+#include "drishti/core/Executor.h"
+#include "drishti/core/make_unique.h"
+
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// clang-format off
+#define BEGIN_EMPTY_NAMESPACE namespace {
+#define END_EMPTY_NAMESPACE }
+// clang-format on
+
+const char* sFaceDetector;
+const char* sFaceDetectorMean;
+const char* sFaceRegressor;
+const char* sEyeRegressor;
+const char* sFaceImageFilename;
+const char* sEyeImageFilename;
+
+BEGIN_EMPTY_NAMESPACE
+
+// Threads and calls per thread (the sanitizer slows execution down by 5-15x):
+const int kThreads = 8;
+const int kIterations = 4;
+
+static std::string read(const char* filename)
+{
+    std::ifstream is(filename, std::ios_base::binary);
+    return drishti::face::FaceDetectorFactoryShared::read(&is);
+}
+
+static bool isIdentical(const std::vector<cv::Point2f>& a, const std::vector<cv::Point2f>& b)
+{
+    return (a.size() == b.size()) && (a.empty() || !std::memcmp(a.data(), b.data(), a.size() * sizeof(cv::Point2f)));
+}
+
+static bool isIdentical(const cv::RotatedRect& a, const cv::RotatedRect& b)
+{
+    return !std::memcmp(&a, &b, sizeof(cv::RotatedRect));
+}
+
+static bool isIdentical(const drishti::eye::EyeModel& a, const drishti::eye::EyeModel& b)
+{
+    return isIdentical(a.eyelids, b.eyelids) && isIdentical(a.irisEllipse, b.irisEllipse) && isIdentical(a.pupilEllipse, b.pupilEllipse);
+}
+
+static bool isIdentical(const drishti::face::FaceModel& a, const drishti::face::FaceModel& b)
+{
+    bool same = (a.roi.has == b.roi.has) && (!a.roi.has || (*a.roi == *b.roi));
+    same &= (a.points.has == b.points.has) && (!a.points.has || isIdentical(*a.points, *b.points));
+    same &= (a.eyeFullL.has == b.eyeFullL.has) && (!a.eyeFullL.has || isIdentical(*a.eyeFullL, *b.eyeFullL));
+    same &= (a.eyeFullR.has == b.eyeFullR.has) && (!a.eyeFullR.has || isIdentical(*a.eyeFullR, *b.eyeFullR));
+    return same;
+}
+
+// Run func(thread) on kThreads threads released at the same time, return the mismatch count:
+static int hammer(const std::function<int(int)>& func)
+{
+    std::atomic<int> ready{ 0 }, mismatches{ 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; i++)
+    {
+        threads.emplace_back([&, i]() {
+            ready++;
+            while (ready.load() < kThreads)
+            {
+                std::this_thread::yield();
+            }
+            mismatches += func(i);
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return mismatches.load();
+}
+
+class SharedModelTest : public ::testing::Test
+{
+protected:
+    SharedModelTest()
+    {
+        m_threads = std::make_shared<drishti::core::Executor>();
+        m_factory = std::make_shared<drishti::face::FaceDetectorFactoryShared>(
+            read(sFaceDetector),
+            read(sFaceRegressor),
+            read(sEyeRegressor),
+            read(sFaceDetectorMean),
+            m_threads);
+
+        // Same format as the face ut: transposed planar float RGB and the green channel
+        cv::Mat image = cv::imread(sFaceImageFilename, cv::IMREAD_COLOR);
+        assert(!image.empty());
+
+        cv::Mat Irgb, Itf;
+        cv::cvtColor(image, Irgb, cv::COLOR_BGR2RGB);
+        cv::Mat(Irgb.t()).convertTo(Itf, CV_32FC3, 1.0f / 255.f);
+        m_planar = MatP(Itf);
+
+        cv::extractChannel(image, m_gray, 1);
+        m_padded = drishti::face::FaceDetector::PaddedImage(m_gray, { { 0, 0 }, m_gray.size() });
+
+        m_eye = cv::imread(sEyeImageFilename, cv::IMREAD_COLOR);
+        assert(!m_eye.empty());
+    }
+
+    std::unique_ptr<drishti::face::FaceDetector> createDetector()
+    {
+        auto factory = m_factory;
+        auto detector = drishti::core::make_unique<drishti::face::FaceDetector>(*m_factory);
+        detector->setScaling(1.f);
+        detector->setDoNMS(true);
+        detector->setDoNMSGlobal(true);
+        detector->setThreads(m_threads, [factory]() { return factory->getEyeEstimator(); });
+        return detector;
+    }
+
+    std::shared_ptr<drishti::core::Executor> m_threads;
+    std::shared_ptr<drishti::face::FaceDetectorFactoryShared> m_factory;
+
+    MatP m_planar;
+    cv::Mat m_gray;
+    drishti::face::FaceDetector::PaddedImage m_padded;
+    cv::Mat m_eye;
+};
+
+// One detector per thread (the detector is stateful), all of them share the regressors and
+// the executor of the factory:
+TEST_F(SharedModelTest, FaceDetector)
+{
+    std::vector<drishti::face::FaceModel> truth;
+    (*createDetector())(m_planar, m_padded, truth);
+    ASSERT_FALSE(truth.empty());
+
+    const int mismatches = hammer([&](int) {
+        auto detector = createDetector();
+
+        int errors = 0;
+        for (int i = 0; i < kIterations; i++)
+        {
+            std::vector<drishti::face::FaceModel> faces;
+            (*detector)(m_planar, m_padded, faces);
+            errors += (faces.size() != truth.size());
+            for (std::size_t j = 0; j < std::min(faces.size(), truth.size()); j++)
+            {
+                errors += !isIdentical(faces[j], truth[j]);
+            }
+        }
+        return errors;
+    });
+    EXPECT_EQ(mismatches, 0);
+}
+
+// One regressor instance evaluated concurrently (const, reentrant):
+TEST_F(SharedModelTest, FaceRegressor)
+{
+    std::vector<drishti::face::FaceModel> faces;
+    (*createDetector())(m_planar, m_padded, faces);
+    ASSERT_FALSE(faces.empty());
+    ASSERT_TRUE(faces.front().roi.has);
+
+    const cv::Rect roi = *faces.front().roi & cv::Rect({ 0, 0 }, m_gray.size());
+    const std::shared_ptr<const drishti::ml::ShapeEstimator> regressor = m_factory->getFaceEstimator();
+
+    std::vector<cv::Point2f> truth;
+    std::vector<bool> mask;
+    ASSERT_EQ((*regressor)(m_gray, roi, truth, mask), 0);
+
+    const int mismatches = hammer([&](int) {
+        int errors = 0;
+        for (int i = 0; i < kIterations; i++)
+        {
+            std::vector<cv::Point2f> points;
+            std::vector<bool> mask;
+            (*regressor)(m_gray, roi, points, mask);
+            errors += !isIdentical(points, truth);
+        }
+        return errors;
+    });
+    EXPECT_EQ(mismatches, 0);
+}
+
+// One eye model estimator (eyelid regressor and CPR iris and pupil models) shared by all
+// threads, with and without the pooled candidate evaluation:
+TEST_F(SharedModelTest, EyeModelEstimator)
+{
+    const std::shared_ptr<drishti::eye::EyeModelEstimator> estimator = m_factory->getEyeEstimator();
+    ASSERT_TRUE(estimator && estimator->good());
+
+    for (auto threads : { std::shared_ptr<drishti::core::Executor>(), m_threads })
+    {
+        estimator->setThreads(threads);
+
+        drishti::eye::EyeModel truth;
+        ASSERT_EQ((*estimator)(m_eye, truth), 0);
+
+        const int mismatches = hammer([&](int thread) {
+            int errors = 0;
+            for (int i = 0; i < kIterations; i++)
+            {
+                drishti::eye::EyeModel eye;
+                if (thread % 2)
+                {
+                    (*estimator)(m_eye, eye);
+                }
+                else
+                {
+                    (*estimator)(estimator->createPyramid(m_eye), eye);
+                }
+                errors += !isIdentical(eye, truth);
+            }
+            return errors;
+        });
+        EXPECT_EQ(mismatches, 0);
+    }
+}
+
+END_EMPTY_NAMESPACE
+
+static bool hasFile(const std::string& filename)
+{
+    std::ifstream ifs(filename);
+    return ifs.good();
+}
+
+int gauze_main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    assert(argc == 7);
+
+    sFaceDetector = argv[1];
+    sFaceDetectorMean = argv[2];
+    sFaceRegressor = argv[3];
+    sEyeRegressor = argv[4];
+    sFaceImageFilename = argv[5];
+    sEyeImageFilename = argv[6];
+
+    assert(hasFile(sFaceDetector));
+    assert(hasFile(sFaceDetectorMean));
+    assert(hasFile(sFaceRegressor));
+    assert(hasFile(sEyeRegressor));
+    assert(hasFile(sFaceImageFilename));
+    assert(hasFile(sEyeImageFilename));
+
+    return RUN_ALL_TESTS();
+}